@@ -104,13 +104,34 @@ typedef struct list_lnk
 }
 list_lnk_t;
 
+/* STM32IPL
+ * Pool of list nodes with the same data size, allocated in slabs of nodes: the lists that use a pool take their
+ * nodes from it and give them back to it, without any heap call (except one per slab), and list_free() gives all
+ * the nodes of a list back in constant time. The slabs are released only by list_pool_release().
+ */
+typedef struct list_pool
+{
+    void *slabs;                // Allocated slabs, chained through their first word.
+    list_lnk_t *free_ptr;       // Free nodes, chained through next_ptr.
+    size_t data_len, slab_len;  // Data size and number of nodes per slab.
+}
+list_pool_t;
+
 typedef struct list
 {
     list_lnk_t *head_ptr, *tail_ptr;
     size_t size, data_len;
+    list_pool_t *pool; // STM32IPL: pool of the nodes; null for nodes allocated from the heap.
 }
 list_t;
 
+void list_pool_init(list_pool_t *pool, size_t data_len, size_t slab_len); // STM32IPL
+void list_pool_release(list_pool_t *pool); // STM32IPL
+void list_pool_begin(list_pool_t *pool); // STM32IPL
+void list_pool_end(void); // STM32IPL
+void list_init_pool(list_t *ptr, size_t data_len, list_pool_t *pool); // STM32IPL
+size_t list_to_buffer(list_t *ptr, void *buf, size_t count); // STM32IPL
+
 void list_init(list_t *ptr, size_t data_len);
 void list_copy(list_t *dst, list_t *src);
 void list_free(list_t *ptr);
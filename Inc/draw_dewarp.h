@@ -19,9 +19,16 @@
 #ifndef DRAW_DEWARP_H
 #define DRAW_DEWARP_H
 
+#include <stdint.h>
+
 typedef void (*draw_dewarp_pel)(void *ctx, int x, int y, float u_s, float v_s);
+/* Draws the pixels x0..x1 of the row y; u_s and v_s of pixel x0 and their x steps are 16.16 fixed point values. */
+typedef void (*draw_dewarp_span)(void *ctx, int x0, int x1, int y, int32_t u_q16, int32_t v_q16, int32_t du_q16,
+								 int32_t dv_q16);
 
 void draw_dewarp_triangle_fill(int x0, int y0, float u0_s, float v0_s, int x1, int y1, float u1_s, float v1_s,
 							   int x2, int y2, float u2_s, float v2_s, draw_dewarp_pel dpel, void *ctx);
+void draw_dewarp_triangle_fill_span(int x0, int y0, float u0_s, float v0_s, int x1, int y1, float u1_s, float v1_s,
+									int x2, int y2, float u2_s, float v2_s, draw_dewarp_span dspan, void *ctx);
 
 #endif
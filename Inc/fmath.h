@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <float.h>
+#include <math.h>  /* STM32IPL added */
 #include "common.h" /* STM32IPL added */
 
 /* STM32IPL removed as the definitions of such functions has been added below.
@@ -32,11 +33,23 @@ float fast_log(float x);
 float fast_log2(float x);
 float fast_powf(float a, float b);
 void fast_get_min_max(float *data, size_t data_len, float *p_min, float *p_max);
+/* STM32IPL array versions of the functions above, r[i] = f(x[i]) for i in [0, n); r may be the same as an operand.
+ * They are meant for the kernels that can process a row at a time, and use MVE when available (see mve_fmath.c). */
+void fast_sqrtf_vec(const float *x, float *r, size_t n);
+void fast_atan2f_vec(const float *y, const float *x, float *r, size_t n);
+void fast_expf_vec(const float *x, float *r, size_t n);
+void fast_log2_vec(const float *x, float *r, size_t n);
+void fast_powf_vec(const float *a, float b, float *r, size_t n);
 extern const float cos_table[360];
 extern const float sin_table[360];
+extern const int16_t cos_table_q14[360]; // STM32IPL
+extern const int16_t sin_table_q14[360]; // STM32IPL
 
 
 /* STM32IPL following functions have been added to allow their "visibility" as they are inline. */
+/* STM32IPL when no ARM FPU is available (e.g. host builds), portable C versions are used;
+ * they produce the same results of the FPU instructions (truncation for floor/ceil, round to nearest for round). */
+#if defined ( __CC_ARM ) || defined ( __ARM_FP )
 float OMV_ATTR_ALWAYS_INLINE fast_sqrtf(float x)
 {
 #if defined ( __CC_ARM )
@@ -124,5 +137,33 @@ float OMV_ATTR_ALWAYS_INLINE fast_fabsf(float x)
     return x;
 }
 
+#else /* STM32IPL portable fallbacks. */
+
+float OMV_ATTR_ALWAYS_INLINE fast_sqrtf(float x)
+{
+    return sqrtf(x);
+}
+
+int OMV_ATTR_ALWAYS_INLINE fast_floorf(float x)
+{
+    return (int)x;
+}
+
+int OMV_ATTR_ALWAYS_INLINE fast_ceilf(float x)
+{
+    return (int)(x + 0.9999f);
+}
+
+int OMV_ATTR_ALWAYS_INLINE fast_roundf(float x)
+{
+    return (int)lrintf(x);
+}
+
+float OMV_ATTR_ALWAYS_INLINE fast_fabsf(float x)
+{
+    return fabsf(x);
+}
+
+#endif /* __CC_ARM || __ARM_FP */
 
 #endif // __FMATH_H__
@@ -18,7 +18,11 @@
 // STM32IPL #define IMLIB_ENABLE_IMAGE_FILE_IO
 
 // Enable LAB LUT
+// STM32IPL: define IMLIB_DISABLE_LAB_LUT (-DIMLIB_DISABLE_LAB_LUT) to remove the 96 KB LAB table from the flash;
+// the LAB values of RGB565 pixels are then computed.
+#ifndef IMLIB_DISABLE_LAB_LUT
 #define IMLIB_ENABLE_LAB_LUT
+#endif
 
 // Enable YUV LUT
 //#define IMLIB_ENABLE_YUV_LUT
@@ -36,7 +40,7 @@
 #define IMLIB_ENABLE_MATH_OPS
 
 // Enable flood_fill()
-//#define IMLIB_ENABLE_FLOOD_FILL
+#define IMLIB_ENABLE_FLOOD_FILL
 
 // Enable mean()
 #define IMLIB_ENABLE_MEAN
@@ -18,19 +18,19 @@
 
 #include "stm32ipl_conf.h"
 
-#ifdef STM32IPL_ENABLE_JPEG
+#if defined(STM32IPL_ENABLE_IMAGE_IO) && defined(STM32IPL_ENABLE_JPEG)
 
 /* Includes ------------------------------------------------------------------*/
-#include "ff.h"
+#include "stm32ipl_image_io_stream.h"
 #include "stm32ipl_mem_alloc.h"
 
 /* Private typedef -----------------------------------------------------------*/  
 /* Private define ------------------------------------------------------------*/
-#define JFILE     FIL
+#define JFILE     ipl_stream_t
 #define JMALLOC   xalloc
 #define JFREE     xfree
 
-#else /* STM32IPL_ENABLE_JPEG */
+#else /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdint.h>
@@ -42,7 +42,7 @@
 #define JMALLOC   malloc
 #define JFREE     free
 
-#endif /* STM32IPL_ENABLE_JPEG */
+#endif /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 
 #define JFREAD(file, buf, sizeofbuf)  \
    read_file(file, buf, sizeofbuf)
@@ -631,4 +631,97 @@ void matd_utriangle_solve(matd_t *u, const float *b, float *x);
 
 float matd_max(matd_t *m);
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////// "matf.h" // STM32IPL
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Defines a single-precision matrix backed by CMSIS-DSP (arm_mat_*_f32), with
+ * data in row-major order. Unlike matd_t, a matf_t does not own its data: the
+ * storage is provided by the caller, typically on the stack (see MATF_DECLARE),
+ * so none of the matf_*() functions allocates memory.
+ */
+typedef arm_matrix_instance_f32 matf_t;
+
+/**
+ * The maximum number of rows (and columns) of a matrix that can be inverted or
+ * decomposed, or that can be both the source and the destination of the same
+ * operation; in these cases a temporary copy is made on the stack.
+ */
+#define MATF_MAX_DIM 9
+
+/**
+ * Declares a rows x cols matrix named 'name' whose storage is an (uninitialized)
+ * local array.
+ */
+#define MATF_DECLARE(name, rows, cols) float name ## _data[(rows) * (cols)]; matf_t name = { (rows), (cols), name ## _data }
+
+/**
+ * A macro to reference a specific matf_t data element given its zero-based
+ * row and column indexes. Suitable for both retrieval and assignment.
+ */
+#define MATF_EL(m, row, col) (m)->pData[((row) * (m)->numCols + (col))]
+
+/**
+ * Binds the matrix m to the caller provided storage 'data' (rows*cols elements).
+ */
+static inline void matf_init(matf_t *m, int rows, int cols, float *data)
+{
+	m->numRows = rows;
+	m->numCols = cols;
+	m->pData = data;
+}
+
+/**
+ * Wraps the data of the matd_t matrix 'a' without copying it.
+ */
+static inline void matf_from_matd(matf_t *m, matd_t *a)
+{
+	matf_init(m, a->nrows, a->ncols, a->data);
+}
+
+/**
+ * Sets m to the identity matrix (ones on the main diagonal, zero elsewhere).
+ */
+void matf_identity(matf_t *m);
+
+/**
+ * Computes c = a * b. c must be a->numRows x b->numCols; it may be the same as
+ * a or b, provided it has no more than MATF_MAX_DIM^2 elements.
+ */
+arm_status matf_multiply(const matf_t *a, const matf_t *b, matf_t *c);
+
+/**
+ * Computes c = a'. c must be a->numCols x a->numRows; it may be the same as a,
+ * provided it has no more than MATF_MAX_DIM^2 elements.
+ */
+arm_status matf_transpose(const matf_t *a, matf_t *c);
+
+/**
+ * Computes c = inv(a), where a is a square matrix up to MATF_MAX_DIM x MATF_MAX_DIM
+ * that is left untouched; c may be the same as a. Returns ARM_MATH_SINGULAR if
+ * a is (exactly) singular.
+ */
+arm_status matf_inverse(const matf_t *a, matf_t *c);
+
+/**
+ * Computes the lower triangular Cholesky factor l of a (a = l * l'), where a is
+ * a symmetric, positive definite matrix up to MATF_MAX_DIM x MATF_MAX_DIM; l may
+ * be the same as a. Returns ARM_MATH_DECOMPOSITION_FAILURE if a is not positive
+ * definite.
+ */
+arm_status matf_chol(const matf_t *a, matf_t *l);
+
+/**
+ * Solves a * x = b, given the Cholesky factor l of a computed by matf_chol().
+ * b and x are vectors with l->numRows elements; x may be the same as b.
+ */
+void matf_chol_solve(const matf_t *l, const float *b, float *x);
+
+/**
+ * Solves a * x = b, where a is a square matrix up to MATF_MAX_DIM x MATF_MAX_DIM.
+ * b and x are vectors with a->numRows elements; x may be the same as b.
+ */
+arm_status matf_solve(const matf_t *a, const float *b, float *x);
+
 #endif /* __MATD_H_ */
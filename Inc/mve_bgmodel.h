@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    mve_bgmodel.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library background model functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_BGMODEL__
+#define __MVE_BGMODEL__
+
+#include "imlib.h"
+
+void mve_bgmodel_span(const uint8_t *src, int16_t *model, uint16_t *fg, int n, int method, int rate, int threshold,
+                      bool update, bool selective);
+void mve_bgmodel_block_sums(const uint8_t *src, int n, uint32_t *sums);
+
+#endif /* __MVE_BGMODEL__ */
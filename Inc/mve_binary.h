@@ -24,9 +24,14 @@
 
 void mve_imlib_binary_binary(image_t *out, image_t *img, color_thresholds_list_lnk_data_t *thresholds, bool invert, bool zero, image_t *mask);
 void mve_imlib_binary_grayscale(image_t *out, image_t *img, color_thresholds_list_lnk_data_t *thresholds, bool invert, bool zero, image_t *mask);
+#ifdef IMLIB_ENABLE_LAB_LUT
 void mve_imlib_binary_rgb565(image_t *out, image_t *img, color_thresholds_list_lnk_data_t *thresholds, bool invert, bool zero, image_t *mask);
 void mve_imlib_binary_rgb888(image_t *out, image_t *img, color_thresholds_list_lnk_data_t *thresholds, bool invert, bool zero, image_t *mask);
+#endif /* IMLIB_ENABLE_LAB_LUT */
 
 int mve_imlib_erode_dilate_grayscale(image_t *img, int ksize, int threshold, int e_or_d, image_t *mask);
+void mve_imlib_binary_shift_op(uint32_t *in, int words, int shift, int e_or_d, uint32_t *out);
+void mve_imlib_binary_vhgw_strip(uint32_t *strip, int len, int n, int e_or_d, uint32_t *g, uint32_t *h);
+void mve_imlib_b_op(uint8_t *data, const uint8_t *other, size_t n, imlib_b_op_t op);
 
 #endif /* __MVE_BINARY__ */
@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    mve_convert.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library color conversion functions with
+  *          8-bits inputs/outputs
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_CONVERT__
+#define __MVE_CONVERT__
+
+#include "arm_math.h"
+
+/*!
+ * @brief Color conversion of n packed pixels; the pixels are processed by groups of 8,
+ *        from the first to the last group or, when reverse is true, from the last to the first one
+ *
+ * @param [IN]  src: Pointer on input pixels
+ * @param [OUT] dst: Pointer on output pixels
+ * @param [IN]  n: number of pixels
+ * @param [IN]  reverse: processing order
+ *
+ * @retval None
+ */
+void mve_convert_y8_to_rgb565(const uint8_t *src, uint16_t *dst, uint32_t n, bool reverse);
+void mve_convert_y8_to_rgb888(const uint8_t *src, uint8_t *dst, uint32_t n, bool reverse);
+void mve_convert_rgb565_to_y8(const uint16_t *src, uint8_t *dst, uint32_t n, bool reverse);
+void mve_convert_rgb565_to_rgb888(const uint16_t *src, uint8_t *dst, uint32_t n, bool reverse);
+void mve_convert_rgb888_to_y8(const uint8_t *src, uint8_t *dst, uint32_t n, bool reverse);
+void mve_convert_rgb888_to_rgb565(const uint8_t *src, uint16_t *dst, uint32_t n, bool reverse);
+
+/*!
+ * @brief Fixed point LAB conversion of n packed pixels, by groups of 4 pixels; the
+ *        results are the ones of imlib_rgb565_to_lab_row() and imlib_rgb888_to_lab_row()
+ *
+ * @param [IN]  src: Pointer on input pixels
+ * @param [IN]  n: number of pixels
+ * @param [OUT] l: Pointer on output L values
+ * @param [OUT] a: Pointer on output A values
+ * @param [OUT] b: Pointer on output B values
+ *
+ * @retval None
+ */
+void mve_convert_rgb565_to_lab(const uint16_t *src, uint32_t n, int8_t *l, int8_t *a, int8_t *b);
+void mve_convert_rgb888_to_lab(const uint8_t *src, uint32_t n, int8_t *l, int8_t *a, int8_t *b);
+
+#endif /* __MVE_CONVERT__ */
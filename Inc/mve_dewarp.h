@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    mve_dewarp.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library dewarping functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_DEWARP__
+#define __MVE_DEWARP__
+
+#include "imlib.h"
+
+void mve_dewarp_dense_float_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_float_bilinear_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_bilinear_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+
+void mve_dewarp_dense_float_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_float_bilinear_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_bilinear_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+
+void mve_dewarp_dense_float_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_float_bilinear_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+void mve_dewarp_dense_fp_12_4_bilinear_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy);
+
+void mve_dewarp_span_nearest_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                       int32_t dv);
+void mve_dewarp_span_bilinear_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                        int32_t dv);
+void mve_dewarp_span_nearest_rgb565(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                    int32_t dv);
+void mve_dewarp_span_bilinear_rgb565(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                     int32_t dv);
+void mve_dewarp_span_nearest_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                    int32_t dv);
+void mve_dewarp_span_bilinear_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                     int32_t dv);
+
+#endif /* __MVE_DEWARP__ */
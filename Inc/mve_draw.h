@@ -31,4 +31,7 @@ void point_fill_mve_grayscale(image_t *img, int cx, int cy, int r0, int r1, int
 void point_fill_mve_rgb888(image_t *img, int cx, int cy, int r0, int r1, int c);
 void point_fill_mve_rgb565(image_t *img, int cx, int cy, int r0, int r1, int c);
 
+void span_fill_mve_rgb565(uint16_t *dst, int n, int c);
+void span_fill_mve_rgb888(uint8_t *dst, int n, int c);
+
 #endif /* __MVE_DRAW__ */
@@ -0,0 +1,27 @@
+/**
+  ******************************************************************************
+  * @file    mve_features.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library feature extraction functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_FEATURES__
+#define __MVE_FEATURES__
+
+#include "imlib.h"
+
+void mve_lbp_u8(const uint8_t **rows, int x0, int x1, const uint8_t *map, uint8_t *code);
+
+#endif /* __MVE_FEATURES__ */
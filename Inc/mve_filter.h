@@ -26,5 +26,17 @@
 
 int mve_imlib_median_filter_grayscale(image_t *img, const int ksize, float percentile, bool threshold, int offset, bool invert, image_t *mask);
 int mve_imlib_morph_u8(image_t *img, const int ksize, const uint8_t *krn, const float m, const int b, bool threshold, int offset, bool invert, image_t *mask);
+void mve_imlib_mean_update_columns(image_t *img, const uint8_t *out_row, const uint8_t *in_row, uint16_t *col_sum);
+void mve_imlib_gaussian_vertical(image_t *img, int y, int radius, const uint16_t *weights, uint16_t *out, int plane_len);
+void mve_imlib_gaussian_horizontal(const uint16_t *in, int n, int step, int radius, const uint16_t *weights, uint32_t bias, int shift, uint8_t *out);
+int mve_imlib_edge_u8(image_t *img, const int ksize, const int *krn_a, const int *krn_b, const float m);
+void mve_imlib_gradient_u8(const uint8_t **rows, int x0, int x1, int ksize, const int32_t *coef, uint16_t *mag, uint8_t *dir);
+int mve_imlib_hist_mode_u16(const uint16_t *bins, int len);
+void mve_imlib_midpoint_vertical(int bpp, uint8_t **rows, int n, int len, uint8_t *v_min, uint8_t *v_max);
+void mve_imlib_midpoint_horizontal(int bpp, const uint8_t *v_min, const uint8_t *v_max, int len, int step, int taps, uint8_t *h_min, uint8_t *h_max);
+void mve_imlib_clahe_row(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *lut_u, const uint8_t *lut_b, const uint16_t *off_l, const uint16_t *off_r, const uint16_t *wx, uint16_t wy);
+void mve_imlib_lut_u8(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *lut);
+void mve_imlib_lut_rgb565(const uint16_t *src, uint16_t *dst, uint32_t n, const uint8_t *r_lut, const uint8_t *g_lut, const uint8_t *b_lut);
+void mve_imlib_lut_rgb888(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *luts);
 
 #endif /* __MVE_FILTER__ */
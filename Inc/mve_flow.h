@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    mve_flow.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library optical flow functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_FLOW__
+#define __MVE_FLOW__
+
+#include "imlib.h"
+
+void mve_lk_gradient_matrix(const int16_t *ix, const int16_t *iy, int n, int64_t *gxx, int64_t *gxy, int64_t *gyy);
+void mve_lk_mismatch(const int16_t *i, const int16_t *j, const int16_t *ix, const int16_t *iy, int n, int64_t *bx,
+                     int64_t *by);
+
+#endif /* __MVE_FLOW__ */
@@ -0,0 +1,31 @@
+/**
+  ******************************************************************************
+  * @file    mve_fmath.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library fast math array functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_FMATH__
+#define __MVE_FMATH__
+
+#include "imlib.h"
+
+void mve_fmath_sqrtf_vec(const float *x, float *r, size_t n);
+void mve_fmath_atan2f_vec(const float *y, const float *x, float *r, size_t n);
+void mve_fmath_expf_vec(const float *x, float *r, size_t n);
+void mve_fmath_log2_vec(const float *x, float *r, size_t n);
+void mve_fmath_powf_vec(const float *a, float b, float *r, size_t n);
+
+#endif /* __MVE_FMATH__ */
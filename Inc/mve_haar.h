@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    mve_haar.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library Haar cascade functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_HAAR__
+#define __MVE_HAAR__
+
+#include "imlib.h"
+
+#define MVE_HAAR_WINDOWS 4
+
+mve_pred16_t mve_haar_run_cascade(cascade_t *cascade, int x, int step, const int32_t *std, mve_pred16_t active);
+
+#endif /* __MVE_HAAR__ */
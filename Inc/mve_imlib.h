@@ -25,4 +25,6 @@
 
 mve_pred16_t mve_image_get_mask_pixel(image_t *ptr, int x, int y);
 
+extern const uint32_t mve_imlib_reciprocal_u32[256];
+
 #endif /* __MVE_IMLIB_H__ */
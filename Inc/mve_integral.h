@@ -0,0 +1,30 @@
+/**
+  ******************************************************************************
+  * @file    mve_integral.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library integral image functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_INTEGRAL__
+#define __MVE_INTEGRAL__
+
+#include "imlib.h"
+
+void mve_integral_row(const uint8_t *src, int x_ratio, const uint32_t *above, uint32_t *sum, int n);
+void mve_integral_row_sq(const uint8_t *src, int x_ratio, const uint32_t *above, uint32_t *ssq, int n);
+void mve_integral_row_ss(const uint8_t *src, int x_ratio, const uint32_t *sum_above, const uint32_t *ssq_above,
+                         uint32_t *sum, uint32_t *ssq, int n);
+
+#endif /* __MVE_INTEGRAL__ */
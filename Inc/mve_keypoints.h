@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file    mve_keypoints.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library keypoint functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_KEYPOINTS__
+#define __MVE_KEYPOINTS__
+
+#include "imlib.h"
+
+void mve_fast_row(const uint8_t *src, const int32_t *ring, int n, uint8_t threshold, uint8_t *corner);
+uint32_t mve_hamming_distance(const uint8_t *a, const uint8_t *b, int n);
+
+#endif /* __MVE_KEYPOINTS__ */
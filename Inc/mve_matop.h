@@ -25,80 +25,328 @@
 
 #include "mve_imlib.h"
 
-static inline void mve_imlib_difference_line_op_grayscale(image_t *img, int line, void *other, image_t *mask)
-{
-  uint8_t *p_data_0 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-  uint8_t *p_data_1 = (uint8_t *)other;
-  if (NULL == mask) {
-    for (int i = 0; i < img->w; i+=16) {
-      mve_pred16_t p = vctp8q(img->w-i);
-      uint8x16_t u8x16_data_0 = vldrbq_z_u8(p_data_0, p);
-      uint8x16_t u8x16_data_1 = vldrbq_z_u8(p_data_1, p);
-      uint8x16_t u8x16_data_out = vabdq_u8(u8x16_data_0, u8x16_data_1);
-      vstrbq_p_u8(p_data_0, u8x16_data_out, p);
-      p_data_0 += 16;
-      p_data_1 += 16;
-    }
+/* Lane-wise operations shared by the arithmetic line operators. */
+typedef enum {
+  MVE_MATOP_ADD,
+  MVE_MATOP_SUB,
+  MVE_MATOP_RSUB,
+  MVE_MATOP_MIN,
+  MVE_MATOP_MAX,
+  MVE_MATOP_DIFF
+} mve_matop_t;
+
+static inline uint8x16_t mve_matop_u8x16(mve_matop_t op, uint8x16_t u8x16_data, uint8x16_t u8x16_other)
+{
+  switch (op) {
+    case MVE_MATOP_ADD:
+      return vqaddq_u8(u8x16_data, u8x16_other);
+    case MVE_MATOP_SUB:
+      return vqsubq_u8(u8x16_data, u8x16_other);
+    case MVE_MATOP_RSUB:
+      return vqsubq_u8(u8x16_other, u8x16_data);
+    case MVE_MATOP_MIN:
+      return vminq_u8(u8x16_data, u8x16_other);
+    case MVE_MATOP_MAX:
+      return vmaxq_u8(u8x16_data, u8x16_other);
+    default:
+      return vabdq_u8(u8x16_data, u8x16_other);
+  }
+}
+
+static inline uint16x8_t mve_matop_u16x8(mve_matop_t op, uint16x8_t u16x8_data, uint16x8_t u16x8_other)
+{
+  switch (op) {
+    case MVE_MATOP_ADD:
+      return vqaddq_u16(u16x8_data, u16x8_other);
+    case MVE_MATOP_SUB:
+      return vqsubq_u16(u16x8_data, u16x8_other);
+    case MVE_MATOP_RSUB:
+      return vqsubq_u16(u16x8_other, u16x8_data);
+    case MVE_MATOP_MIN:
+      return vminq_u16(u16x8_data, u16x8_other);
+    case MVE_MATOP_MAX:
+      return vmaxq_u16(u16x8_data, u16x8_other);
+    default:
+      return vabdq_u16(u16x8_data, u16x8_other);
+  }
+}
+
+/* Grayscale and RGB888 lines: every byte is an independent 8-bit channel. */
+static inline void mve_matop_u8(mve_matop_t op, uint8_t *p_data, const uint8_t *p_other, int n)
+{
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    uint8x16_t u8x16_data = vldrbq_z_u8(p_data + i, p);
+    uint8x16_t u8x16_other = vldrbq_z_u8(p_other + i, p);
+    vstrbq_p_u8(p_data + i, mve_matop_u8x16(op, u8x16_data, u8x16_other), p);
   }
-  else
-  {
-    for (int i = 0; i < img->w; i+=16) {
-      mve_pred16_t p_mask = mve_image_get_mask_pixel(mask, i, line);
-      uint8x16_t u8x16_data_0 = vldrbq_z_u8(p_data_0, p_mask);
-      uint8x16_t u8x16_data_1 = vldrbq_z_u8(p_data_1, p_mask);
-      uint8x16_t u8x16_data_out = vabdq_u8(u8x16_data_0, u8x16_data_1);
-      vstrbq_p_u8(p_data_0, u8x16_data_out, p_mask);
-      p_data_0 += 16;
-      p_data_1 += 16;
+}
+
+/* RGB565 lines: each channel is moved to the top bits of the lane, so the saturating 16-bit arithmetic
+   clamps it exactly like the scalar code does on the 5/6/5-bit value. */
+static inline void mve_matop_rgb565(mve_matop_t op, uint16_t *p_data, const uint16_t *p_other, int n)
+{
+  for (int i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_data = vldrhq_z_u16(p_data + i, p);
+    uint16x8_t u16x8_other = vldrhq_z_u16(p_other + i, p);
+    uint16x8_t u16x8_r, u16x8_g, u16x8_b;
+    u16x8_r = mve_matop_u16x8(op, vandq_u16(u16x8_data, vdupq_n_u16(0xF800)),
+                              vandq_u16(u16x8_other, vdupq_n_u16(0xF800)));
+    u16x8_g = mve_matop_u16x8(op, vandq_u16(vshlq_n_u16(u16x8_data, 5), vdupq_n_u16(0xFC00)),
+                              vandq_u16(vshlq_n_u16(u16x8_other, 5), vdupq_n_u16(0xFC00)));
+    u16x8_b = mve_matop_u16x8(op, vshlq_n_u16(u16x8_data, 11), vshlq_n_u16(u16x8_other, 11));
+    u16x8_r = vandq_u16(u16x8_r, vdupq_n_u16(0xF800));
+    u16x8_g = vandq_u16(vshrq_n_u16(u16x8_g, 5), vdupq_n_u16(0x07E0));
+    u16x8_b = vshrq_n_u16(u16x8_b, 11);
+    vstrhq_p_u16(p_data + i, vorrq_u16(vorrq_u16(u16x8_r, u16x8_g), u16x8_b), p);
+  }
+}
+
+/* floor(t / 255) = (t * 0x8081) >> 23 for every 16-bit t. */
+static inline uint16x8_t mve_matop_div255_u16x8(uint16x8_t u16x8_t)
+{
+  return vshrq_n_u16(vmulhq_u16(u16x8_t, vdupq_n_u16(0x8081)), 7);
+}
+
+/* d * o / 255, or 255 - (255 - d) * (255 - o) / 255 when inverted, truncated like the scalar code. */
+static inline void mve_matop_mul_u8(uint8_t *p_data, const uint8_t *p_other, int n, bool invert)
+{
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    uint8x16_t u8x16_data = vldrbq_z_u8(p_data + i, p);
+    uint8x16_t u8x16_other = vldrbq_z_u8(p_other + i, p);
+    if (invert) {
+      u8x16_data = vmvnq_u8(u8x16_data);
+      u8x16_other = vmvnq_u8(u8x16_other);
+    }
+    uint16x8_t u16x8_even = vmullbq_int_u8(u8x16_data, u8x16_other);
+    uint16x8_t u16x8_odd = vmulltq_int_u8(u8x16_data, u8x16_other);
+    if (invert) { /* Round the product up, so that its complement is truncated. */
+      u16x8_even = vaddq_n_u16(u16x8_even, 254);
+      u16x8_odd = vaddq_n_u16(u16x8_odd, 254);
     }
+    uint8x16_t u8x16_out = vmovnbq_u16(u8x16_data, mve_matop_div255_u16x8(u16x8_even));
+    u8x16_out = vmovntq_u16(u8x16_out, mve_matop_div255_u16x8(u16x8_odd));
+    if (invert) {
+      u8x16_out = vmvnq_u8(u8x16_out);
+    }
+    vstrbq_p_u8(p_data + i, u8x16_out, p);
   }
 }
 
-static inline void mve_imlib_difference_line_op_rgb888(image_t *img, int line, void *other, image_t *mask)
-{
-  rgb888_t *ptr_rgb888_0 = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-  rgb888_t *ptr_rgb888_1 = (rgb888_t *)other;
-  uint8x16_t u8x16_incr = vidupq_n_u8(0, 1) * 3;
-  if (NULL == mask) {
-    for (int i = 0; i < img->w; i+=16) {
-      mve_pred16_t pred = vctp8q(img->w-i);
-      uint8x16_t u8x16_r_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->r), u8x16_incr, pred);
-      uint8x16_t u8x16_g_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->g), u8x16_incr, pred);
-      uint8x16_t u8x16_b_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->b), u8x16_incr, pred);
-      uint8x16_t u8x16_r_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->r), u8x16_incr, pred);
-      uint8x16_t u8x16_g_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->g), u8x16_incr, pred);
-      uint8x16_t u8x16_b_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->b), u8x16_incr, pred);
-      uint8x16_t u8x16_data_out;
-      u8x16_data_out = vabdq_u8(u8x16_r_0, u8x16_r_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->r), u8x16_incr, u8x16_data_out, pred);
-      u8x16_data_out = vabdq_u8(u8x16_g_0, u8x16_g_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->g), u8x16_incr, u8x16_data_out, pred);
-      u8x16_data_out = vabdq_u8(u8x16_b_0, u8x16_b_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->b), u8x16_incr, u8x16_data_out, pred);
-      ptr_rgb888_0 += 16;
-      ptr_rgb888_1 += 16;
+static inline void mve_matop_mul_rgb565(uint16_t *p_data, const uint16_t *p_other, int n, bool invert)
+{
+  for (int i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_data = vldrhq_z_u16(p_data + i, p);
+    uint16x8_t u16x8_other = vldrhq_z_u16(p_other + i, p);
+    uint16x8_t u16x8_dr = vshrq_n_u16(u16x8_data, 11);
+    uint16x8_t u16x8_dg = vandq_u16(vshrq_n_u16(u16x8_data, 5), vdupq_n_u16(0x3F));
+    uint16x8_t u16x8_db = vandq_u16(u16x8_data, vdupq_n_u16(0x1F));
+    uint16x8_t u16x8_or = vshrq_n_u16(u16x8_other, 11);
+    uint16x8_t u16x8_og = vandq_u16(vshrq_n_u16(u16x8_other, 5), vdupq_n_u16(0x3F));
+    uint16x8_t u16x8_ob = vandq_u16(u16x8_other, vdupq_n_u16(0x1F));
+    if (invert) {
+      u16x8_dr = vsubq_u16(vdupq_n_u16(31), u16x8_dr);
+      u16x8_dg = vsubq_u16(vdupq_n_u16(63), u16x8_dg);
+      u16x8_db = vsubq_u16(vdupq_n_u16(31), u16x8_db);
+      u16x8_or = vsubq_u16(vdupq_n_u16(31), u16x8_or);
+      u16x8_og = vsubq_u16(vdupq_n_u16(63), u16x8_og);
+      u16x8_ob = vsubq_u16(vdupq_n_u16(31), u16x8_ob);
+    }
+    uint16x8_t u16x8_r = vmulq_u16(u16x8_dr, u16x8_or);
+    uint16x8_t u16x8_g = vmulq_u16(u16x8_dg, u16x8_og);
+    uint16x8_t u16x8_b = vmulq_u16(u16x8_db, u16x8_ob);
+    if (invert) { /* Round the products up, so that their complements are truncated. */
+      u16x8_r = vaddq_n_u16(u16x8_r, 30);
+      u16x8_g = vaddq_n_u16(u16x8_g, 62);
+      u16x8_b = vaddq_n_u16(u16x8_b, 30);
     }
+    /* floor(t / 31) = (t * 2115) >> 16 for t <= 991, floor(t / 63) = (t * 4162) >> 18 for t <= 4031. */
+    u16x8_r = vmulhq_u16(u16x8_r, vdupq_n_u16(2115));
+    u16x8_g = vshrq_n_u16(vmulhq_u16(u16x8_g, vdupq_n_u16(4162)), 2);
+    u16x8_b = vmulhq_u16(u16x8_b, vdupq_n_u16(2115));
+    if (invert) {
+      u16x8_r = vsubq_u16(vdupq_n_u16(31), u16x8_r);
+      u16x8_g = vsubq_u16(vdupq_n_u16(63), u16x8_g);
+      u16x8_b = vsubq_u16(vdupq_n_u16(31), u16x8_b);
+    }
+    u16x8_data = vorrq_u16(vshlq_n_u16(u16x8_r, 11), vshlq_n_u16(u16x8_g, 5));
+    vstrhq_p_u16(p_data + i, vorrq_u16(u16x8_data, u16x8_b), p);
   }
-  else
-  {
-    for (int i = 0; i < img->w; i+=16) {
-      mve_pred16_t pred = mve_image_get_mask_pixel(mask, i, line);
-      uint8x16_t u8x16_r_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->r), u8x16_incr, pred);
-      uint8x16_t u8x16_g_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->g), u8x16_incr, pred);
-      uint8x16_t u8x16_b_0 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_0->b), u8x16_incr, pred);
-      uint8x16_t u8x16_r_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->r), u8x16_incr, pred);
-      uint8x16_t u8x16_g_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->g), u8x16_incr, pred);
-      uint8x16_t u8x16_b_1 = vldrbq_gather_offset_z_u8(&(ptr_rgb888_1->b), u8x16_incr, pred);
-      uint8x16_t u8x16_data_out;
-      u8x16_data_out = vabdq_u8(u8x16_r_0, u8x16_r_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->r), u8x16_incr, u8x16_data_out, pred);
-      u8x16_data_out = vabdq_u8(u8x16_g_0, u8x16_g_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->g), u8x16_incr, u8x16_data_out, pred);
-      u8x16_data_out = vabdq_u8(u8x16_b_0, u8x16_b_1);
-      vstrbq_scatter_offset_p_u8(&(ptr_rgb888_0->b), u8x16_incr, u8x16_data_out, pred);
-      ptr_rgb888_0 += 16;
-      ptr_rgb888_1 += 16;
+}
+
+/* IM_DIV(num * scale, den) clamped to scale, or IM_MOD(num * scale, den): the quotient is
+   (num * scale * ceil(2^32 / den)) >> 32, exact because num * scale < 2^16. */
+static inline uint32x4_t mve_matop_div_u32x4(uint32x4_t u32x4_num, uint32x4_t u32x4_den, uint32_t scale, bool mod)
+{
+  u32x4_num = vmulq_n_u32(u32x4_num, scale);
+  uint32x4_t u32x4_rcp = vldrwq_gather_shifted_offset_u32(mve_imlib_reciprocal_u32, u32x4_den);
+  uint32x4_t u32x4_q = vmulhq_u32(u32x4_num, u32x4_rcp);
+  /* ceil(2^32 / 1) does not fit: take the numerator as is. The zero entry already yields 0 for den == 0. */
+  u32x4_q = vpselq_u32(u32x4_num, u32x4_q, vcmpeqq_n_u32(u32x4_den, 1));
+  if (mod) {
+    u32x4_q = vsubq_u32(u32x4_num, vmulq_u32(u32x4_q, u32x4_den));
+    return vpselq_u32(vdupq_n_u32(0), u32x4_q, vcmpeqq_n_u32(u32x4_den, 0));
+  }
+  return vminq_u32(u32x4_q, vdupq_n_u32(scale));
+}
+
+static inline void mve_matop_div_u8(uint8_t *p_data, const uint8_t *p_other, int n, bool invert, bool mod)
+{
+  for (int i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_data = vldrbq_z_u32(p_data + i, p);
+    uint32x4_t u32x4_other = vldrbq_z_u32(p_other + i, p);
+    uint32x4_t u32x4_out = invert ? mve_matop_div_u32x4(u32x4_other, u32x4_data, 255, mod)
+                                  : mve_matop_div_u32x4(u32x4_data, u32x4_other, 255, mod);
+    vstrbq_p_u32(p_data + i, u32x4_out, p);
+  }
+}
+
+static inline void mve_matop_div_rgb565(uint16_t *p_data, const uint16_t *p_other, int n, bool invert, bool mod)
+{
+  for (int i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_data = vldrhq_z_u32(p_data + i, p);
+    uint32x4_t u32x4_other = vldrhq_z_u32(p_other + i, p);
+    if (invert) {
+      uint32x4_t u32x4_tmp = u32x4_data;
+      u32x4_data = u32x4_other;
+      u32x4_other = u32x4_tmp;
     }
+    uint32x4_t u32x4_r = mve_matop_div_u32x4(vshrq_n_u32(u32x4_data, 11),
+                                             vshrq_n_u32(u32x4_other, 11), 31, mod);
+    uint32x4_t u32x4_g = mve_matop_div_u32x4(vandq_u32(vshrq_n_u32(u32x4_data, 5), vdupq_n_u32(0x3F)),
+                                             vandq_u32(vshrq_n_u32(u32x4_other, 5), vdupq_n_u32(0x3F)), 63, mod);
+    uint32x4_t u32x4_b = mve_matop_div_u32x4(vandq_u32(u32x4_data, vdupq_n_u32(0x1F)),
+                                             vandq_u32(u32x4_other, vdupq_n_u32(0x1F)), 31, mod);
+    uint32x4_t u32x4_out = vorrq_u32(vshlq_n_u32(u32x4_r, 11), vshlq_n_u32(u32x4_g, 5));
+    vstrhq_p_u32(p_data + i, vorrq_u32(u32x4_out, u32x4_b), p);
   }
 }
+
+/* IPL_BLEND(a, b, alpha) = (b * alpha + a * (255 - alpha) + 127) / 255 on 8-bit channels. */
+static inline uint16x8_t mve_matop_blend_u16x8(uint16x8_t u16x8_a, uint16x8_t u16x8_b, uint8_t alpha)
+{
+  uint16x8_t u16x8_t = vmulq_n_u16(u16x8_b, alpha);
+  u16x8_t = vmlaq_n_u16(u16x8_t, u16x8_a, 255 - alpha);
+  return mve_matop_div255_u16x8(vaddq_n_u16(u16x8_t, 127));
+}
+
+static inline void mve_matop_blend_u8(uint8_t *p_a, const uint8_t *p_b, int n, uint8_t alpha)
+{
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    uint8x16_t u8x16_a = vldrbq_z_u8(p_a + i, p);
+    uint8x16_t u8x16_b = vldrbq_z_u8(p_b + i, p);
+    uint16x8_t u16x8_even = mve_matop_blend_u16x8(vmovlbq_u8(u8x16_a), vmovlbq_u8(u8x16_b), alpha);
+    uint16x8_t u16x8_odd = mve_matop_blend_u16x8(vmovltq_u8(u8x16_a), vmovltq_u8(u8x16_b), alpha);
+    u8x16_a = vmovnbq_u16(u8x16_a, u16x8_even);
+    u8x16_a = vmovntq_u16(u8x16_a, u16x8_odd);
+    vstrbq_p_u8(p_a + i, u8x16_a, p);
+  }
+}
+
+static inline void mve_matop_blend_rgb565(uint16_t *p_a, const uint16_t *p_b, int n, uint8_t alpha)
+{
+  for (int i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_a = vldrhq_z_u16(p_a + i, p);
+    uint16x8_t u16x8_b = vldrhq_z_u16(p_b + i, p);
+    uint16x8_t u16x8_ch_a, u16x8_ch_b, u16x8_r, u16x8_g, u16x8_bl;
+    /* COLOR_RGB565_TO_R8/G8/B8 */
+    u16x8_ch_a = vandq_u16(vshrq_n_u16(u16x8_a, 8), vdupq_n_u16(0xF8));
+    u16x8_ch_b = vandq_u16(vshrq_n_u16(u16x8_b, 8), vdupq_n_u16(0xF8));
+    u16x8_r = mve_matop_blend_u16x8(vorrq_u16(u16x8_ch_a, vshrq_n_u16(u16x8_ch_a, 5)),
+                                    vorrq_u16(u16x8_ch_b, vshrq_n_u16(u16x8_ch_b, 5)), alpha);
+    u16x8_ch_a = vandq_u16(vshrq_n_u16(u16x8_a, 3), vdupq_n_u16(0xFC));
+    u16x8_ch_b = vandq_u16(vshrq_n_u16(u16x8_b, 3), vdupq_n_u16(0xFC));
+    u16x8_g = mve_matop_blend_u16x8(vorrq_u16(u16x8_ch_a, vshrq_n_u16(u16x8_ch_a, 6)),
+                                    vorrq_u16(u16x8_ch_b, vshrq_n_u16(u16x8_ch_b, 6)), alpha);
+    u16x8_ch_a = vandq_u16(vshlq_n_u16(u16x8_a, 3), vdupq_n_u16(0xF8));
+    u16x8_ch_b = vandq_u16(vshlq_n_u16(u16x8_b, 3), vdupq_n_u16(0xF8));
+    u16x8_bl = mve_matop_blend_u16x8(vorrq_u16(u16x8_ch_a, vshrq_n_u16(u16x8_ch_a, 5)),
+                                     vorrq_u16(u16x8_ch_b, vshrq_n_u16(u16x8_ch_b, 5)), alpha);
+    /* COLOR_R8_G8_B8_TO_RGB565 */
+    u16x8_a = vorrq_u16(vshlq_n_u16(vandq_u16(u16x8_r, vdupq_n_u16(0xF8)), 8),
+                        vshlq_n_u16(vandq_u16(u16x8_g, vdupq_n_u16(0xFC)), 3));
+    vstrhq_p_u16(p_a + i, vorrq_u16(u16x8_a, vshrq_n_u16(u16x8_bl, 3)), p);
+  }
+}
+
+/* Line operators: the kernels run on each span of pixels selected by the mask. */
+static inline void mve_imlib_arith_line_op_grayscale(image_t *img, int line, void *other, image_t *mask, mve_matop_t op)
+{
+  uint8_t *p_data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_u8(op, p_data + sx, (uint8_t *)other + sx, sn);
+  }
+}
+
+static inline void mve_imlib_arith_line_op_rgb565(image_t *img, int line, void *other, image_t *mask, mve_matop_t op)
+{
+  uint16_t *p_data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_rgb565(op, p_data + sx, (uint16_t *)other + sx, sn);
+  }
+}
+
+static inline void mve_imlib_arith_line_op_rgb888(image_t *img, int line, void *other, image_t *mask, mve_matop_t op)
+{
+  uint8_t *p_data = (uint8_t *)IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_u8(op, p_data + sx * 3, (uint8_t *)other + sx * 3, sn * 3);
+  }
+}
+
+static inline void mve_imlib_mul_line_op_grayscale(image_t *img, int line, void *other, image_t *mask, bool invert)
+{
+  uint8_t *p_data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_mul_u8(p_data + sx, (uint8_t *)other + sx, sn, invert);
+  }
+}
+
+static inline void mve_imlib_mul_line_op_rgb565(image_t *img, int line, void *other, image_t *mask, bool invert)
+{
+  uint16_t *p_data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_mul_rgb565(p_data + sx, (uint16_t *)other + sx, sn, invert);
+  }
+}
+
+static inline void mve_imlib_mul_line_op_rgb888(image_t *img, int line, void *other, image_t *mask, bool invert)
+{
+  uint8_t *p_data = (uint8_t *)IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_mul_u8(p_data + sx * 3, (uint8_t *)other + sx * 3, sn * 3, invert);
+  }
+}
+
+static inline void mve_imlib_div_line_op_grayscale(image_t *img, int line, void *other, image_t *mask, bool invert, bool mod)
+{
+  uint8_t *p_data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_div_u8(p_data + sx, (uint8_t *)other + sx, sn, invert, mod);
+  }
+}
+
+static inline void mve_imlib_div_line_op_rgb565(image_t *img, int line, void *other, image_t *mask, bool invert, bool mod)
+{
+  uint16_t *p_data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_div_rgb565(p_data + sx, (uint16_t *)other + sx, sn, invert, mod);
+  }
+}
+
+static inline void mve_imlib_div_line_op_rgb888(image_t *img, int line, void *other, image_t *mask, bool invert, bool mod)
+{
+  uint8_t *p_data = (uint8_t *)IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
+  for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+    mve_matop_div_u8(p_data + sx * 3, (uint8_t *)other + sx * 3, sn * 3, invert, mod);
+  }
+}
+
 #endif /* __MVE_MATOP_H__ */
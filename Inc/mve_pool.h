@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    mve_pool.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library pooling functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_POOL__
+#define __MVE_POOL__
+
+#include "arm_math.h"
+#include "imlib.h"
+
+int mve_imlib_mean_pool(image_t *img_i, image_t *img_o, int x_div, int y_div);
+int mve_imlib_midpoint_pool(image_t *img_i, image_t *img_o, int x_div, int y_div, int bias);
+
+#endif /* __MVE_POOL__ */
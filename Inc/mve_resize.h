@@ -41,8 +41,9 @@
  * @param [IN]  pScratch: scratch buffer to hold indexes (i.e. integer part for left and right neighbor used)
  *              and weights (i.e. decimal part) for each output uint8_t width:
  *              width_out * 2 * sizeof(uint16_t) + idth_out * * sizeof(float16_t)
+ * @param [IN]  table_ready: when true, the index table already in pScratch, computed by a previous call with
+ *              the same input and output widths, is reused
 
- *
  * @retval None
  */
 void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
@@ -54,7 +55,8 @@ void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
                                              const size_t width_out,
                                              const size_t height_out,
                                              const size_t n_channels,
-                                             const void* pScratch);
+                                             const void* pScratch,
+                                             const bool table_ready);
 
 /*!
  * @brief Nearest resize from image (uint8) specifying strides
@@ -71,6 +73,8 @@ void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
  * @param [IN]  pScratch: scratch buffer to hold indexes split in 2: offset for each of the 16 elements on 8-bits
  *              and indexes to jump to next 16 element group: for each output element:
  *              width_out * n_ch *sizeof(uint8_t) + (width_out * n_ch + 15) / 16 * sizeof(uint16_t)
+ * @param [IN]  table_ready: when true, the index table already in pScratch, computed by a previous call with
+ *              the same input and output widths, is reused
  *
  * @retval None
  */
@@ -83,7 +87,72 @@ void mve_resize_nearest_iu8ou8_with_strides(const uint8_t *in_data,
                                             const size_t width_out,
                                             const size_t height_out,
                                             const size_t n_channels,
-                                            const void *scratch);
+                                            const void *scratch,
+                                            const bool table_ready);
+
 
+/*!
+ * @brief Bilinear resize from RGB565 image specifying strides: the channels are unpacked,
+ *        interpolated and repacked in-register
+ *
+ * @param [IN]  in_data: Pointer on input data
+ * @param [OUT] out_ata: Pointer on output data
+ * @param [IN]  stride_in: input stride (bytes) for next line
+ * @param [IN]  stride_out: output stride (bytes) for next line
+ * @param [IN]  width_in: input width
+ * @param [IN]  height_in: input height
+ * @param [IN]  width_out: output width
+ * @param [IN]  height_out: output height
+ * @param [IN]  pScratch: scratch buffer to hold indexes (i.e. integer part for left and right neighbor used)
+ *              and weights (i.e. decimal part) for each output pixel:
+ *              width_out * 2 * sizeof(uint16_t) + width_out * sizeof(float16_t)
+ * @param [IN]  table_ready: when true, the index table already in pScratch, computed by a previous call with
+ *              the same input and output widths, is reused
+ *
+ * @retval None
+ */
+void mve_resize_bilinear_rgb565_with_strides(const uint16_t *in_data,
+                                             uint16_t *out_data,
+                                             const size_t stride_in,
+                                             const size_t stride_out,
+                                             const size_t width_in,
+                                             const size_t height_in,
+                                             const size_t width_out,
+                                             const size_t height_out,
+                                             const void *pScratch,
+                                             const bool table_ready);
+
+/*!
+ * @brief Area (box averaging) downscale from image (uint8) specifying strides, with
+ *        integer ratios equal to 2, 4 or 8
+ *
+ * @param [IN]  in_data: Pointer on input data
+ * @param [OUT] out_ata: Pointer on output data
+ * @param [IN]  stride_in: input stride for next line
+ * @param [IN]  stride_out: output stride for next line
+ * @param [IN]  width_out: output width
+ * @param [IN]  height_out: output height
+ * @param [IN]  ratio_x: horizontal ratio between input and output width (2, 4 or 8)
+ * @param [IN]  ratio_y: vertical ratio between input and output height (2, 4 or 8)
+ * @param [IN]  n_channels: number of channels
+ * @param [IN]  pScratch: scratch buffer to hold the vertical sums of an input line and
+ *              the offsets of the blocks of each output element:
+ *              width_out * (ratio_x + 1) * n_channels * sizeof(uint16_t)
+ * @param [IN]  table_ready: when true, the offsets already in pScratch, computed by a previous call with
+ *              the same output width, horizontal ratio and number of channels, are reused
+ *
+ * @retval None
+ */
+void mve_resize_area_iu8ou8_with_strides(const uint8_t *in_data,
+                                         uint8_t *out_data,
+                                         const size_t stride_in,
+                                         const size_t stride_out,
+                                         const size_t width_out,
+                                         const size_t height_out,
+                                         const size_t ratio_x,
+                                         const size_t ratio_y,
+                                         const size_t n_channels,
+                                         const void *pScratch,
+                                         const bool table_ready);
 
 #endif /* __MVE_RESIZE__ */
@@ -0,0 +1,33 @@
+/**
+  ******************************************************************************
+  * @file    mve_rotation.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library flip, mirror and rotation functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_ROTATION__
+#define __MVE_ROTATION__
+
+#include "imlib.h"
+
+void mve_rotation_column_u8(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n);
+void mve_rotation_column_u16(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n);
+void mve_rotation_column_rgb888(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n);
+
+void mve_rotation_reverse_u8(const uint8_t *src, uint8_t *dst, int n);
+void mve_rotation_reverse_u16(const uint8_t *src, uint8_t *dst, int n);
+void mve_rotation_reverse_rgb888(const uint8_t *src, uint8_t *dst, int n);
+
+#endif /* __MVE_ROTATION__ */
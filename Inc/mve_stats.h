@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file    mve_stats.h
+  * @author  AIS Team
+  * @brief   MVE Image processing library statistics functions
+
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __MVE_STATS__
+#define __MVE_STATS__
+
+#include "imlib.h"
+
+void mve_imlib_similarity_line(const uint8_t *x_row, const uint8_t *y_row, int w, int *sum_x, int *sum_y,
+                               int *sum2_x, int *sum2_y, int *sum_xy);
+uint32_t mve_imlib_count_nonzero_u8(const uint8_t *data, int n);
+int mve_imlib_find_nonzero_u8(const uint8_t *data, int n);
+void mve_imlib_min_max_u8(const uint8_t *data, int n, uint8_t *min, uint8_t *max);
+int mve_imlib_find_u8(const uint8_t *data, int n, uint8_t value);
+uint32_t mve_imlib_sad_u8(const uint8_t *a, const uint8_t *b, int n);
+uint32_t mve_imlib_sad_rgb565(const uint16_t *a, const uint16_t *b, int n);
+
+#endif /* __MVE_STATS__ */
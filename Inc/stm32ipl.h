@@ -71,6 +71,7 @@ extern "C" {
 #define STM32IPL_IF_NOT_RGB          (stm32ipl_if_binary | stm32ipl_if_grayscale)
 #define STM32IPL_IF_NOT_RGB88        (stm32ipl_if_binary | stm32ipl_if_grayscale | stm32ipl_if_rgb565)
 #define STM32IPL_IF_GRAY_ONLY        (stm32ipl_if_grayscale)
+#define STM32IPL_IF_SENSOR           (stm32ipl_if_yuv422 | stm32ipl_if_nv12 | stm32ipl_if_bayer)
 
 #define STM32IPL_CHECK_VALID_IMAGE(img) \
 	if (!img || !img->data) \
@@ -95,6 +96,14 @@ if (!STM32Ipl_ImageFormatSupported((img), (formats))) \
 #define STM32IPL_CHECK_VALID_PTR_ARG(ptr) \
 	if (!ptr) return stm32ipl_err_InvalidParameter; \
 
+#define STM32IPL_CHECK_NOT_VIEW(img) \
+	if (img->stride) \
+		return stm32ipl_err_NotAllowed; \
+
+#define STM32IPL_CHECK_WORKSPACE(ws, wsSize, size) \
+	if ((size) && (!(ws) || ((wsSize) < (size)))) \
+		return stm32ipl_err_WrongSize; \
+
 #define STM32IPL_CHECK_VALID_ROI(img, roi) \
 { \
 	rectangle_t _fullRoi; \
@@ -110,6 +119,32 @@ if (!STM32Ipl_ImageFormatSupported((img), (formats))) \
 	} else \
 		STM32Ipl_RectInit(realRoi, 0, 0, img->w, img->h); \
 
+#if defined(STM32IPL_ENABLE_TRACE) || defined(STM32IPL_ENABLE_PERF_COUNTERS)
+#ifndef STM32IPL_TRACE_BEGIN
+#define STM32IPL_TRACE_BEGIN(id) \
+	STM32Ipl_TraceBegin(stm32ipl_trace_##id);
+
+#define STM32IPL_TRACE_END(id) \
+	STM32Ipl_TraceEnd(stm32ipl_trace_##id);
+#endif /* STM32IPL_TRACE_BEGIN */
+#else
+#undef STM32IPL_TRACE_BEGIN
+#undef STM32IPL_TRACE_END
+#define STM32IPL_TRACE_BEGIN(id)
+#define STM32IPL_TRACE_END(id)
+#endif /* STM32IPL_ENABLE_TRACE || STM32IPL_ENABLE_PERF_COUNTERS */
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+#define STM32IPL_PERF_MVE() \
+	STM32Ipl_PerfPath(true, stm32ipl_perf_None);
+
+#define STM32IPL_PERF_SCALAR(reason) \
+	STM32Ipl_PerfPath(false, stm32ipl_perf_##reason);
+#else
+#define STM32IPL_PERF_MVE()
+#define STM32IPL_PERF_SCALAR(reason)
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
 /**
  * @brief STM32IPL color type. It has 0xRRGGBB format.
  * STM32IPL_COLOR_xxx colors follow such format.
@@ -146,6 +181,7 @@ typedef enum _stm32ipl_err_t
 	stm32ipl_err_NotInPlaceFunction = -22,	/**< Function does not work in place. */
 	stm32ipl_err_OpeningSource      = -23,	/**< Error opening source. */
 	stm32ipl_err_WrongROI           = -24,	/**< ROI is wrong. */
+	stm32ipl_err_Partial            = -25,	/**< Deadline passed: the results are partial (see STM32Ipl_SetDeadline()). */
 } stm32ipl_err_t;
 
 /**
@@ -157,6 +193,9 @@ typedef enum _stm32ipl_if_t
 	stm32ipl_if_grayscale = 2,
 	stm32ipl_if_rgb565 = 4,
 	stm32ipl_if_rgb888 = 8,
+	stm32ipl_if_yuv422 = 16,
+	stm32ipl_if_nv12 = 32,
+	stm32ipl_if_bayer = 64,		/**< Any Bayer pattern (BGGR, GBRG, GRBG, RGGB). */
 } stm32ipl_if_t;
 
 /**
@@ -173,12 +212,331 @@ typedef struct _ellipse_t
 	int16_t rotation; /**< Rotation angle (degrees). */
 } ellipse_t;
 
+/**
+ * @brief Rectangle with a score, item of stm32ipl_rect_vec_t.
+ */
+typedef struct _stm32ipl_scored_rect_t
+{
+	rectangle_t rect;	/**< Rectangle. */
+	float score;		/**< Score (e.g. confidence of a detection, or number of grouped detections). */
+} stm32ipl_scored_rect_t;
+
+/**
+ * @brief Contiguous vector of scored rectangles, initialized by STM32Ipl_RectVecInit(): its items are stored in a
+ * buffer given by the caller, or in the heap, where the storage grows geometrically.
+ */
+typedef struct _stm32ipl_rect_vec_t
+{
+	stm32ipl_scored_rect_t *item;	/**< Items. */
+	uint32_t count;					/**< Number of items. */
+	uint32_t capacity;				/**< Number of items that fit the storage. */
+	bool fixed;						/**< true if the storage is the buffer given by the caller. */
+} stm32ipl_rect_vec_t;
+
+#ifndef STM32IPL_PIPELINE_MAX_STAGES
+#define STM32IPL_PIPELINE_MAX_STAGES	8	/**< Max number of stages of a pipeline. */
+#endif /* STM32IPL_PIPELINE_MAX_STAGES */
+
+#ifndef STM32IPL_PIPELINE_MAX_KSIZE
+#define STM32IPL_PIPELINE_MAX_KSIZE		4	/**< Max kernel size of a pipeline stage. */
+#endif /* STM32IPL_PIPELINE_MAX_KSIZE */
+
+/**
+ * @brief Operations that can be executed by a stage of STM32Ipl_Pipeline().
+ */
+typedef enum _stm32ipl_stage_type_t
+{
+	stm32ipl_stage_gaussian = 0,	/**< Gaussian filter, same as STM32Ipl_Gaussian() without mask. */
+	stm32ipl_stage_binary,			/**< Binarization, same as STM32Ipl_Binary() with one grayscale threshold. */
+	stm32ipl_stage_erode,			/**< Erosion, same as STM32Ipl_Erode() without mask. */
+	stm32ipl_stage_dilate,			/**< Dilation, same as STM32Ipl_Dilate() without mask. */
+} stm32ipl_stage_type_t;
+
+/**
+ * @brief Gradient direction computed by STM32Ipl_Gradient(), quantized to four sectors of 45 degrees; the angles
+ * are measured from the x axis towards the y axis (that is clockwise, as the y axis points down).
+ */
+typedef enum _stm32ipl_gradient_dir_t
+{
+	stm32ipl_gradient_dir_0 = 0,	/**< Horizontal gradient (vertical edge), angle in (-22.5, 22.5] degrees. */
+	stm32ipl_gradient_dir_45,		/**< Diagonal gradient, angle in (22.5, 67.5) degrees. */
+	stm32ipl_gradient_dir_90,		/**< Vertical gradient (horizontal edge), angle in [67.5, 112.5] degrees. */
+	stm32ipl_gradient_dir_135		/**< Anti-diagonal gradient, angle in (112.5, 157.5) degrees. */
+} stm32ipl_gradient_dir_t;
+
+/**
+ * @brief Stage of STM32Ipl_Pipeline(); each stage processes the grayscale lines produced by the previous one.
+ */
+typedef struct _stm32ipl_stage_t
+{
+	stm32ipl_stage_type_t type;	/**< Operation. */
+	uint8_t kSize;				/**< Kernel size (gaussian, erode, dilate); the kernel has (2 * kSize + 1)^2 pixels. */
+	int32_t threshold;			/**< Erode/dilate threshold, as in STM32Ipl_Erode() and STM32Ipl_Dilate(). */
+	uint8_t lMin;				/**< Binary: min value of the pixels to be set. */
+	uint8_t lMax;				/**< Binary: max value of the pixels to be set. */
+	bool invert;				/**< Binary: when true, the selection is inverted. */
+} stm32ipl_stage_t;
+
+/**
+ * @brief Operation executed by STM32Ipl_Tiled() on each tile.
+ * @param tile	Tile to be processed in place.
+ * @param arg	Argument given to STM32Ipl_Tiled().
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+typedef stm32ipl_err_t (*stm32ipl_tile_op_t)(image_t *tile, void *arg);
+
+/**
+ * @brief Function called by STM32Ipl_DirtyTilesForEach() on each tile that changed.
+ * @param tile	View of the tile in the image (see STM32Ipl_InitView()).
+ * @param index	Index of the tile, by rows.
+ * @param arg	Argument given to STM32Ipl_DirtyTilesForEach().
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+typedef stm32ipl_err_t (*stm32ipl_tile_visit_t)(const image_t *tile, uint32_t index, void *arg);
+
+#ifdef STM32IPL_ENABLE_DUAL_CORE
+#ifndef STM32IPL_DUAL_CORE_MAX_THRESHOLDS
+#define STM32IPL_DUAL_CORE_MAX_THRESHOLDS	4	/**< Max number of thresholds of a dual-core binarization. */
+#endif /* STM32IPL_DUAL_CORE_MAX_THRESHOLDS */
+
+/**
+ * @brief Operations that can be split between the two cores by STM32Ipl_DualCoreRun().
+ */
+typedef enum _stm32ipl_dual_op_t
+{
+	stm32ipl_dual_op_convert = 0,	/**< Conversion src -> dst, same as STM32Ipl_Convert(). */
+	stm32ipl_dual_op_binary,		/**< Binarization src -> dst, same as STM32Ipl_Binary() without mask. */
+	stm32ipl_dual_op_add,			/**< src += other (or scalar), same as STM32Ipl_Add() without mask. */
+	stm32ipl_dual_op_sub,			/**< src -= other (or scalar), same as STM32Ipl_Sub() without mask. */
+	stm32ipl_dual_op_diff,			/**< src = |src - other| (or scalar), same as STM32Ipl_Diff() without mask. */
+	stm32ipl_dual_op_min,			/**< src = min(src, other) (or scalar), same as STM32Ipl_Min() without mask. */
+	stm32ipl_dual_op_max,			/**< src = max(src, other) (or scalar), same as STM32Ipl_Max() without mask. */
+	stm32ipl_dual_op_gaussian,		/**< Gaussian filter of src, same as STM32Ipl_Gaussian() without threshold and mask. */
+	stm32ipl_dual_op_mean,			/**< Mean filter of src, same as STM32Ipl_MeanFilter() without threshold and mask. */
+	stm32ipl_dual_op_median,		/**< Median filter of src, same as STM32Ipl_MedianFilter() without threshold and mask. */
+	stm32ipl_dual_op_erode,			/**< Erosion of src, same as STM32Ipl_Erode() without mask. */
+	stm32ipl_dual_op_dilate			/**< Dilation of src, same as STM32Ipl_Dilate() without mask. */
+} stm32ipl_dual_op_t;
+
+/**
+ * @brief Operation executed by STM32Ipl_DualCoreRun(). It is copied to the memory shared by the two cores,
+ * so it contains the values of the arguments instead of pointers to them.
+ */
+typedef struct _stm32ipl_dual_job_t
+{
+	stm32ipl_dual_op_t op;	/**< Operation. */
+	image_t src;			/**< Source image; it is processed in place by the math operations and the filters. */
+	image_t other;			/**< Second operand of the math operations; when its data is null, scalar is used. */
+	image_t dst;			/**< Destination image of the conversion and of the binarization. */
+	stm32ipl_color_t scalar;	/**< Math operations: value used when other is not given. */
+	uint8_t kSize;			/**< Filters: kernel size; the kernel has (2 * kSize + 1)^2 pixels. */
+	uint8_t threshold;		/**< Erode/dilate threshold, as in STM32Ipl_Erode() and STM32Ipl_Dilate(). */
+	float percentile;		/**< Median filter percentile, as in STM32Ipl_MedianFilter(). */
+	bool unsharp;			/**< Gaussian filter: when true, unsharp masking is applied. */
+	bool invert;			/**< Binarization: when true, the selection is inverted; subtraction: other - src. */
+	bool zero;				/**< Binarization: when true, the selected pixels are set to zero. */
+	uint8_t nThresholds;	/**< Binarization: number of thresholds. */
+	color_thresholds_list_lnk_data_t thresholds[STM32IPL_DUAL_CORE_MAX_THRESHOLDS];	/**< Binarization thresholds. */
+} stm32ipl_dual_job_t;
+#endif /* STM32IPL_ENABLE_DUAL_CORE */
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+#ifndef STM32IPL_MEM_STATS_MAX_SITES
+#define STM32IPL_MEM_STATS_MAX_SITES	32	/**< Max number of call sites tracked by the memory statistics. */
+#endif /* STM32IPL_MEM_STATS_MAX_SITES */
+
+/**
+ * @brief Memory allocated by a single call site, i.e. the code that called the allocator.
+ */
+typedef struct _stm32ipl_mem_site_t
+{
+	const void *caller;	/**< Address of the code that called the allocator. */
+	uint32_t count;		/**< Number of allocations. */
+	uint32_t bytes;		/**< Total number of bytes requested. */
+	uint32_t maxBytes;	/**< Biggest single request (bytes). */
+} stm32ipl_mem_site_t;
+
+/**
+ * @brief Memory usage statistics, collected since the last call to STM32Ipl_ResetMemStats().
+ */
+typedef struct _stm32ipl_mem_stats_t
+{
+	uint32_t heapSize;			/**< Size of the heap reserved by STM32Ipl_InitLib() (bytes). */
+	uint32_t heapUsed;			/**< Heap currently in use (bytes). */
+	uint32_t heapPeak;			/**< Peak heap usage (bytes). */
+	uint32_t heapMaxFreeBlock;	/**< Biggest free heap fragment (bytes). */
+	uint32_t heapLiveBlocks;	/**< Number of heap buffers currently allocated. */
+	uint32_t fbUsed;			/**< Memory currently allocated from the fb stack (bytes). */
+	uint32_t fbPeak;			/**< Peak memory allocated from the fb stack (bytes). */
+	uint32_t fbIntPeak;			/**< Peak usage of the internal fb region (bytes). */
+	uint32_t fbExtPeak;			/**< Peak usage of the external fb region (bytes). */
+	uint32_t fbLiveEntries;		/**< Number of fb stack buffers currently allocated. */
+	uint32_t fbPeakEntries;		/**< Peak number of fb stack buffers. */
+	uint32_t allocCount;		/**< Number of allocations (heap and fb stack). */
+	uint32_t failCount;			/**< Number of failed allocations. */
+	uint32_t siteCount;			/**< Number of valid entries in sites. */
+	stm32ipl_mem_site_t sites[STM32IPL_MEM_STATS_MAX_SITES]; /**< Allocations per call site. */
+} stm32ipl_mem_stats_t;
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
+/* Library functions that call the STM32IPL_TRACE_BEGIN/STM32IPL_TRACE_END hooks. */
+#define STM32IPL_TRACE_IDS(X) \
+	X(CopyData) X(Clone) X(Binary) X(FindBlobs) X(ConvertRev) X(Dewarp) X(DrawScreen_DMA2D) X(Zero) \
+	X(Fill) X(DrawCross) X(DrawLine) X(DrawPolygon) X(DrawRectangle) X(DrawCircle) X(DrawEllipse) \
+	X(EdgeSimple) X(EdgeCanny) X(GammaCorr) X(HistEq) X(HistEqClahe) X(MeanFilter) X(MedianFilter) \
+	X(ModeFilter) X(MidpointFilter) X(BilateralFilter) X(Morph) X(Gaussian) X(Laplacian) X(Sobel) \
+	X(Scharr) X(MidpointPool) X(MeanPool) X(FindMinMaxLoc) X(FindNonZeroLoc) X(FindLines) \
+	X(FindCircles) X(II) X(IIScaled) X(IISq) X(ImageMaskRectangle) X(ImageMaskCircle) \
+	X(ImageMaskEllipse) X(Invert) X(And) X(Nand) X(Or) X(Nor) X(Xor) X(Xnor) X(Add) X(Sub) X(Mul) \
+	X(Div) X(Diff) X(Min) X(Max) X(Dilate) X(Erode) X(Open) X(Close) X(TopHat) X(BlackHat) \
+	X(DetectObject) X(Crop) X(Resize_Roi) X(Downscale) X(Rotation) X(Replace) X(LensCorr) \
+	X(GetHistogram) X(GetSimilarity) X(GetStatistics) X(GetRegressionImage) X(GetMean) X(GetStdDev) \
+	X(CountNonZero) X(FindTemplate) X(WarpAffine) X(Pipeline) X(Tiled) X(ResizeConvert) \
+	X(PrepareTensor) X(Blend) X(PyramidBuild) X(DetectObjectPyramid) X(FindTemplatePyramid) \
+	X(ResizeRoiBatch) X(Gradient) X(BilateralFilterFast) X(GetHistogramStatistics) \
+	X(GetRoiStatsBatch) X(AdaptiveThreshold) X(ClaheApply) X(ApplyLut) X(FindBlobsRle) X(BlobStreamPushRows) \
+	X(FindLinesEdgeMap) X(FindCirclesGradient) X(DetectObjectTrack) X(FindAprilTags) \
+	X(LabelComponents) X(WarpPerspective) X(FillPolygon) X(DrawList) X(DrawScreenAsync) \
+	X(JpegStreamPushRows) X(DetectObjectVec) X(IISumSq) X(IISumSq64) X(DualCoreRun) \
+	X(BgModelUpdate) X(BgModelGetForeground) X(FindDisplacement) X(FindKeypoints) X(MatchKeypoints) \
+	X(HogCompute) X(LbpCompute) X(OpticalFlowLK) X(BinaryLut) X(FindBlobsLut) X(FindBlobsRleLut) X(TiledRoi) \
+	X(FloodFill) X(FloodFillMask) X(DirtyTilesUpdate) X(DirtyTiled) X(DirtyTilesForEach)
+
+/**
+ * @brief Identifiers of the library functions traced when STM32IPL_ENABLE_TRACE is defined;
+ * the identifier of STM32Ipl_xxx() is stm32ipl_trace_xxx.
+ */
+typedef enum _stm32ipl_trace_id_t
+{
+#define STM32IPL_TRACE_ID(name)	stm32ipl_trace_##name,
+	STM32IPL_TRACE_IDS(STM32IPL_TRACE_ID)
+#undef STM32IPL_TRACE_ID
+	stm32ipl_trace_Count	/**< Number of identifiers. */
+} stm32ipl_trace_id_t;
+
+#ifdef STM32IPL_ENABLE_TRACE
+#ifndef STM32IPL_TRACE_BACKEND
+#define STM32IPL_TRACE_BACKEND		STM32IPL_TRACE_RING	/**< Default trace backend. */
+#endif /* STM32IPL_TRACE_BACKEND */
+
+#if STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING
+#ifndef STM32IPL_TRACE_RING_SIZE
+#define STM32IPL_TRACE_RING_SIZE	256	/**< Number of events kept by the trace ring buffer (power of 2). */
+#endif /* STM32IPL_TRACE_RING_SIZE */
+
+/**
+ * @brief Event recorded by the trace ring buffer.
+ */
+typedef struct _stm32ipl_trace_event_t
+{
+	uint32_t cycles;	/**< Value of STM32Ipl_CycleCounterGet() when the event occurred. */
+	uint16_t id;		/**< Identifier of the function (stm32ipl_trace_id_t). */
+	uint16_t end;		/**< 0 when the function starts, 1 when it ends. */
+} stm32ipl_trace_event_t;
+#endif /* STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING */
+#endif /* STM32IPL_ENABLE_TRACE */
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+#ifndef STM32IPL_PERF_MAX_DEPTH
+#define STM32IPL_PERF_MAX_DEPTH		8	/**< Max nesting of the library functions tracked by the performance counters. */
+#endif /* STM32IPL_PERF_MAX_DEPTH */
+
+/**
+ * @brief Reasons why a library function ran its scalar implementation instead of the MVE one.
+ */
+typedef enum _stm32ipl_perf_reason_t
+{
+	stm32ipl_perf_None = 0,		/**< No fallback: the MVE implementation ran. */
+	stm32ipl_perf_NotBuilt,		/**< The MVE implementation is not part of this build (or does not exist). */
+	stm32ipl_perf_Disabled,		/**< The MVE implementations are not selected (STM32Ipl_SetMve()). */
+	stm32ipl_perf_Format,		/**< The image format is not supported by the MVE implementation. */
+	stm32ipl_perf_Mask,			/**< The MVE implementation does not support the mask. */
+	stm32ipl_perf_Parameter,	/**< A parameter (kernel, method, ROI) is not supported by the MVE implementation. */
+	stm32ipl_perf_Memory,		/**< The buffers needed by the MVE implementation could not be allocated. */
+	stm32ipl_perf_Count			/**< Number of reasons. */
+} stm32ipl_perf_reason_t;
+
+/**
+ * @brief Performance counters of a library function, collected since the last call to
+ * STM32Ipl_ResetPerfCounters().
+ */
+typedef struct _stm32ipl_perf_counter_t
+{
+	uint32_t calls;			/**< Number of calls. */
+	uint64_t cycles;		/**< Total execution time (cycles), including the library functions it calls. */
+	uint32_t allocBytes;	/**< Bytes allocated (heap and fb stack) by the function itself. */
+	uint32_t mvePaths;		/**< Number of times the MVE implementation ran. */
+	uint32_t scalarPaths;	/**< Number of times the scalar implementation ran. */
+	uint32_t fallbacks[stm32ipl_perf_Count];	/**< Scalar executions per reason (stm32ipl_perf_reason_t). */
+} stm32ipl_perf_counter_t;
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
+/**
+ * @brief Library context: heap, temporary buffer stack, list pool and memory statistics used by the library
+ * functions called while it is the current one (see STM32Ipl_SetCtx()). Its content is private.
+ */
+typedef struct _stm32ipl_ctx_t stm32ipl_ctx_t;
+
 /** @defgroup initLibrary Library initialization
  * Functions necessary to initialize and de-initialize the library
  *  @{
  */
 void STM32Ipl_InitLib(void *memAddr, uint32_t memSize);
 void STM32Ipl_DeInitLib(void);
+void STM32Ipl_InitFbStack(void *intMemAddr, uint32_t intMemSize, void *extMemAddr, uint32_t extMemSize);
+stm32ipl_ctx_t* STM32Ipl_InitCtx(void *memAddr, uint32_t memSize);
+void STM32Ipl_DeInitCtx(stm32ipl_ctx_t *ctx);
+stm32ipl_ctx_t* STM32Ipl_SetCtx(stm32ipl_ctx_t *ctx);
+stm32ipl_ctx_t* STM32Ipl_GetCtx(void);
+void STM32Ipl_SetDeadline(uint32_t cycles);
+bool STM32Ipl_MveAvailable(void);
+stm32ipl_err_t STM32Ipl_SetMve(bool enable);
+bool STM32Ipl_IsMveEnabled(void);
+/** @} */
+
+/** @defgroup benchmark Benchmark
+ * Functions to measure the execution time of the library functions
+ *  @{
+ */
+void STM32Ipl_CycleCounterInit(void);
+uint32_t STM32Ipl_CycleCounterGet(void);
+#ifdef STM32IPL_ENABLE_BENCHMARK
+stm32ipl_err_t STM32Ipl_Benchmark(void *intMemAddr, uint32_t intMemSize, void *extMemAddr, uint32_t extMemSize,
+		void (*out)(const char *line));
+#endif /* STM32IPL_ENABLE_BENCHMARK */
+/** @} */
+
+/** @defgroup trace Tracing
+ * Functions to trace the execution of the library functions
+ *  @{
+ */
+#if defined(STM32IPL_ENABLE_TRACE) || defined(STM32IPL_ENABLE_PERF_COUNTERS)
+void STM32Ipl_TraceBegin(stm32ipl_trace_id_t id);
+void STM32Ipl_TraceEnd(stm32ipl_trace_id_t id);
+const char* STM32Ipl_TraceName(stm32ipl_trace_id_t id);
+#endif /* STM32IPL_ENABLE_TRACE || STM32IPL_ENABLE_PERF_COUNTERS */
+#ifdef STM32IPL_ENABLE_TRACE
+void STM32Ipl_TraceReset(void);
+#if STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING
+uint32_t STM32Ipl_TraceRead(stm32ipl_trace_event_t *events, uint32_t maxEvents);
+#endif /* STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING */
+#endif /* STM32IPL_ENABLE_TRACE */
+/** @} */
+
+/** @defgroup perf Performance counters
+ * Functions to count the calls, the execution time, the allocated memory and the executed paths of the library
+ * functions
+ *  @{
+ */
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+void STM32Ipl_PerfBegin(stm32ipl_trace_id_t id);
+void STM32Ipl_PerfEnd(stm32ipl_trace_id_t id);
+void STM32Ipl_PerfPath(bool mve, stm32ipl_perf_reason_t reason);
+void STM32Ipl_PerfAlloc(uint32_t size);
+stm32ipl_err_t STM32Ipl_GetPerfCounters(stm32ipl_trace_id_t id, stm32ipl_perf_counter_t *counter);
+void STM32Ipl_ResetPerfCounters(void);
+const char* STM32Ipl_PerfReasonName(stm32ipl_perf_reason_t reason);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
 /** @} */
 
 /**
@@ -187,11 +545,14 @@ void STM32Ipl_DeInitLib(void);
  *  @{
  */
 void STM32Ipl_Init(image_t *img, uint32_t width, uint32_t height, image_bpp_t format, void *data);
+stm32ipl_err_t STM32Ipl_InitView(const image_t *parent, const rectangle_t *roi, image_t *view);
+stm32ipl_err_t STM32Ipl_InitLumaView(const image_t *src, image_t *view);
 stm32ipl_err_t STM32Ipl_AllocData(image_t *img, uint32_t width, uint32_t height, image_bpp_t format);
 stm32ipl_err_t STM32Ipl_AllocDataRef(const image_t *src, image_t *dst);
 void STM32Ipl_ReleaseData(image_t *img);
 uint32_t STM32Ipl_DataSize(uint32_t width, uint32_t height, image_bpp_t format);
 uint32_t STM32Ipl_ImageDataSize(const image_t *img);
+uint32_t STM32Ipl_ImageStride(const image_t *img);
 bool STM32Ipl_ImageFormatSupported(const image_t *img, uint32_t formats);
 stm32ipl_err_t STM32Ipl_Copy(const image_t *src, image_t *dst);
 stm32ipl_err_t STM32Ipl_CopyData(const image_t *src, image_t *dst);
@@ -208,6 +569,10 @@ void* STM32Ipl_Alloc(uint32_t size);
 void* STM32Ipl_Alloc0(uint32_t size);
 void STM32Ipl_Free(void *mem);
 void* STM32Ipl_Realloc(void *mem, uint32_t size);
+#ifdef STM32IPL_ENABLE_MEM_STATS
+stm32ipl_err_t STM32Ipl_GetMemStats(stm32ipl_mem_stats_t *stats);
+void STM32Ipl_ResetMemStats(void);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
 /** @} */
 
 /**
@@ -215,8 +580,25 @@ void* STM32Ipl_Realloc(void *mem, uint32_t size);
  *
  *  @{
  */
+/**
+ * @brief Color thresholds compiled by STM32Ipl_ColorLutInit(): membership bitmaps with one bit per RGB565 value, so
+ * that an RGB565 pixel is thresholded with a lookup instead of a LAB conversion and a comparison with each threshold.
+ * They take (number of thresholds + 1) * 8 KB; they are built once and kept until the thresholds change.
+ */
+typedef struct _stm32ipl_color_lut_t
+{
+	list_t thresholds;	/**< Copy of the list of color_thresholds_list_lnk_data_t objects, used with the other formats. */
+	bool invert;		/**< When true, the thresholds are inverted. */
+	uint32_t *bits;		/**< Bitmap of the values selected by the thresholds (invert applied), followed by the bitmap
+							of the values inside each threshold (invert not applied). */
+} stm32ipl_color_lut_t;
+
 stm32ipl_err_t STM32Ipl_Binary(const image_t *src, image_t *dst, const list_t *thresholds, bool invert, bool zero,
 		const image_t *mask);
+stm32ipl_err_t STM32Ipl_ColorLutInit(stm32ipl_color_lut_t *lut, const list_t *thresholds, bool invert);
+void STM32Ipl_ColorLutRelease(stm32ipl_color_lut_t *lut);
+stm32ipl_err_t STM32Ipl_BinaryLut(const image_t *src, image_t *dst, const stm32ipl_color_lut_t *lut, bool zero,
+		const image_t *mask);
 /** @} */
 
 /**
@@ -224,9 +606,84 @@ stm32ipl_err_t STM32Ipl_Binary(const image_t *src, image_t *dst, const list_t *t
  *
  *  @{
  */
+/**
+ * @brief Context of the streaming blob detection (STM32Ipl_BlobStreamBegin(), STM32Ipl_BlobStreamPushRows(),
+ * STM32Ipl_BlobStreamEnd()): it keeps the runs of the last row received and the statistics of the blobs that
+ * are still open, i.e. that have pixels on that row.
+ */
+typedef struct _stm32ipl_blob_stream_t
+{
+	uint32_t width;			/**< Width of the frames. */
+	uint32_t height;		/**< Height of the frames. */
+	image_bpp_t bpp;		/**< Format of the frames. */
+	uint32_t y;				/**< Index of the next row expected. */
+	bool invert;			/**< When true, the thresholds are inverted. */
+	uint8_t nThresholds;	/**< Number of thresholds. */
+	uint16_t areaThreshold;	/**< Minimum bounding box area of the blobs reported. */
+	uint16_t pixelsThreshold;	/**< Minimum number of pixels of the blobs reported. */
+	uint32_t maxBlobs;		/**< Number of blobs that can still be reported. */
+	list_t *out;			/**< List of find_blobs_list_lnk_data_t objects the blobs are reported to. */
+	color_thresholds_list_lnk_data_t *thresholds;	/**< Copy of the thresholds. */
+	uint8_t *codes;			/**< Threshold codes of the previous and of the current row (2 * width). */
+	int8_t *lab;			/**< LAB components of a row (3 * width), with the color formats. */
+	void *runs;				/**< Runs of the previous and of the current row. */
+	uint32_t nRuns;			/**< Number of runs of the previous row. */
+	void *blobs;			/**< Pool of the open blobs. */
+	uint32_t blobsSize;		/**< Number of entries of the pool. */
+	uint32_t freeBlob;		/**< First free entry of the pool. */
+} stm32ipl_blob_stream_t;
+
 stm32ipl_err_t STM32Ipl_FindBlobs(const image_t *img, list_t *out, const rectangle_t *roi, const list_t *thresholds,
 		uint8_t x_stride, uint8_t y_stride, uint16_t area_threshold, uint16_t pixels_threshold, bool merge,
 		uint8_t margin, bool invert, uint32_t maxBlobs);
+stm32ipl_err_t STM32Ipl_FindBlobsRle(const image_t *img, list_t *out, const rectangle_t *roi, const list_t *thresholds,
+		uint8_t x_stride, uint8_t y_stride, uint16_t area_threshold, uint16_t pixels_threshold, bool merge,
+		uint8_t margin, bool invert, uint32_t maxBlobs);
+stm32ipl_err_t STM32Ipl_FindBlobsLut(const image_t *img, list_t *out, const rectangle_t *roi,
+		const stm32ipl_color_lut_t *lut, uint8_t xStride, uint8_t yStride, uint16_t areaThreshold,
+		uint16_t pixelsThreshold, bool merge, uint8_t margin, uint32_t maxBlobs);
+stm32ipl_err_t STM32Ipl_FindBlobsRleLut(const image_t *img, list_t *out, const rectangle_t *roi,
+		const stm32ipl_color_lut_t *lut, uint8_t xStride, uint8_t yStride, uint16_t areaThreshold,
+		uint16_t pixelsThreshold, bool merge, uint8_t margin, uint32_t maxBlobs);
+stm32ipl_err_t STM32Ipl_BlobStreamBegin(stm32ipl_blob_stream_t *ctx, uint32_t width, uint32_t height,
+		image_bpp_t format, list_t *out, const list_t *thresholds, uint16_t areaThreshold, uint16_t pixelsThreshold,
+		bool invert, uint32_t maxBlobs);
+stm32ipl_err_t STM32Ipl_BlobStreamPushRows(stm32ipl_blob_stream_t *ctx, const uint8_t *data, uint32_t rows,
+		uint32_t stride);
+stm32ipl_err_t STM32Ipl_BlobStreamEnd(stm32ipl_blob_stream_t *ctx);
+/** @} */
+
+/**
+ * @defgroup labeling Connected components labeling
+ *
+ *  @{
+ */
+/**
+ * @brief Label image: a 16-bit label per pixel, 0 for the background and 1..count for the connected components.
+ */
+typedef struct _stm32ipl_labels_t
+{
+	uint32_t w;			/**< Width. */
+	uint32_t h;			/**< Height. */
+	uint16_t *data;		/**< Labels. */
+	uint32_t count;		/**< Number of connected components found by STM32Ipl_LabelComponents(). */
+} stm32ipl_labels_t;
+
+/**
+ * @brief Statistics of a connected component.
+ */
+typedef struct _stm32ipl_label_stats_t
+{
+	uint32_t area;		/**< Number of pixels. */
+	rectangle_t bbox;	/**< Bounding box. */
+	float cx;			/**< X coordinate of the centroid. */
+	float cy;			/**< Y coordinate of the centroid. */
+} stm32ipl_label_stats_t;
+
+stm32ipl_err_t STM32Ipl_LabelsAllocData(stm32ipl_labels_t *labels, uint32_t width, uint32_t height);
+void STM32Ipl_LabelsReleaseData(stm32ipl_labels_t *labels);
+stm32ipl_err_t STM32Ipl_LabelComponents(const image_t *src, stm32ipl_labels_t *labels, uint8_t connectivity,
+		stm32ipl_label_stats_t *stats, uint32_t nStats);
 /** @} */
 
 /**
@@ -254,21 +711,62 @@ rgb888_t STM32Ipl_YUVToRGB888(uint8_t y, int8_t u, int8_t v);
  *
  *  @{
  */
+/**
+ * @brief Type of a primitive drawn by STM32Ipl_DrawList().
+ */
+typedef enum _stm32ipl_draw_type_t
+{
+	stm32ipl_draw_rectangle = 0,	/**< Rectangle with corners (x0, y0) and (x1, y1), included. */
+	stm32ipl_draw_cross,			/**< Cross centered in (x0, y0); x1 is the size (as in STM32Ipl_DrawCross()). */
+	stm32ipl_draw_line				/**< Line from (x0, y0) to (x1, y1). */
+} stm32ipl_draw_type_t;
+
+/**
+ * @brief Primitive drawn by STM32Ipl_DrawList().
+ */
+typedef struct _stm32ipl_draw_item_t
+{
+	stm32ipl_draw_type_t type;	/**< Type of primitive. */
+	int16_t x0;					/**< First X coordinate (see stm32ipl_draw_type_t). */
+	int16_t y0;					/**< First Y coordinate (see stm32ipl_draw_type_t). */
+	int16_t x1;					/**< Second X coordinate or size (see stm32ipl_draw_type_t). */
+	int16_t y1;					/**< Second Y coordinate (see stm32ipl_draw_type_t). */
+	stm32ipl_color_t color;		/**< Color value with 0xRRGGBB format. */
+	uint16_t thickness;			/**< Thickness of the lines (pixels). */
+	bool fill;					/**< Rectangle only: when true, the rectangle is filled. */
+} stm32ipl_draw_item_t;
+
+/**
+ * @brief Function called at the end of a drawing started by STM32Ipl_DrawScreenAsync(), with the drawn image, which
+ * can then be modified again. It can be called by the DMA2D interrupt.
+ */
+typedef void (*stm32ipl_screen_callback_t)(const image_t *img);
+
 stm32ipl_err_t STM32Ipl_Zero(image_t *img, bool invert, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Fill(image_t *img, const rectangle_t *roi, uint32_t value);
 stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *image, uint16_t x, uint16_t y);
+stm32ipl_err_t STM32Ipl_DrawScreenAsync(const image_t *img, uint16_t x, uint16_t y,
+		stm32ipl_screen_callback_t callback);
+stm32ipl_err_t STM32Ipl_DrawScreenWait(void);
+void STM32Ipl_DrawScreenIRQHandler(void);
 stm32ipl_err_t STM32Ipl_DrawPixel(image_t *img, uint16_t x, uint16_t y, stm32ipl_color_t color);
 stm32ipl_err_t STM32Ipl_DrawCross(image_t *img, uint16_t x, uint16_t y, uint16_t size, stm32ipl_color_t color,
 		uint16_t thickness);
 stm32ipl_err_t STM32Ipl_DrawLine(image_t *img, const point_t *p0, const point_t *p1, stm32ipl_color_t color, uint16_t thickness);
 stm32ipl_err_t STM32Ipl_DrawPolygon(image_t *img, const point_t *point, uint32_t nPoints, stm32ipl_color_t color,
 		uint16_t thickness);
+stm32ipl_err_t STM32Ipl_FillPolygon(image_t *img, const point_t *point, uint32_t nPoints, stm32ipl_color_t color);
+stm32ipl_err_t STM32Ipl_DrawList(image_t *img, const stm32ipl_draw_item_t *items, uint32_t nItems);
 stm32ipl_err_t STM32Ipl_DrawRectangle(image_t *img, uint16_t x, uint16_t y, uint16_t width, uint16_t height,
 		stm32ipl_color_t color, uint16_t thickness, bool fill);
 stm32ipl_err_t STM32Ipl_DrawCircle(image_t *img, uint16_t cx, uint16_t cy, uint16_t radius, stm32ipl_color_t color,
 		uint16_t thickness, bool fill);
 stm32ipl_err_t STM32Ipl_DrawEllipse(image_t *img, const ellipse_t *ellipse, stm32ipl_color_t color, uint16_t thickness,
 		bool fill);
+stm32ipl_err_t STM32Ipl_FloodFill(image_t *img, const point_t *seed, float seedThreshold, float floatingThreshold,
+		stm32ipl_color_t color, bool invert, bool clearBackground, const image_t *mask);
+stm32ipl_err_t STM32Ipl_FloodFillMask(const image_t *img, const point_t *seed, float seedThreshold,
+		float floatingThreshold, const image_t *mask, image_t *out);
 /** @} */
 
 /**
@@ -285,9 +783,60 @@ stm32ipl_err_t STM32Ipl_EdgeCanny(image_t *img, const rectangle_t *roi, int32_t
  *
  *  @{
  */
+#define STM32IPL_CLAHE_MAX_TILES	16	/**< Maximum number of tiles along each direction of STM32Ipl_ClaheApply(). */
+
+/**
+ * @brief Context of STM32Ipl_ClaheApply(), initialized by STM32Ipl_ClaheInit(): it keeps the tile histograms,
+ * the tile look-up tables and the interpolation tables allocated across the frames of a video stream.
+ */
+typedef struct _stm32ipl_clahe_t
+{
+	uint32_t width;			/**< Width of the images to be processed. */
+	uint32_t height;		/**< Height of the images to be processed. */
+	uint8_t tilesX;			/**< Number of tiles along the horizontal direction. */
+	uint8_t tilesY;			/**< Number of tiles along the vertical direction. */
+	uint8_t smoothing;		/**< Weight (out of 256) of the previous look-up tables when blending them with the new
+							ones; 0 disables the temporal smoothing. */
+	bool hasLuts;			/**< True when the look-up tables hold the mapping of a previous frame. */
+	float clipLimit;		/**< Clip limit, as a multiple of the mean count of the histogram bins of a tile;
+							values less than or equal to 0 disable the clipping. */
+	uint8_t *luts;			/**< Look-up tables of the tiles (tilesY * tilesX * 256 entries). */
+	uint32_t *hist;			/**< Histograms of a row of tiles (tilesX * 256 bins). */
+	uint16_t *offL;			/**< For each column, offset of the look-up table of the left tile. */
+	uint16_t *offR;			/**< For each column, offset of the look-up table of the right tile. */
+	uint16_t *weightX;		/**< For each column, weight (Q7) of the right tile. */
+	uint8_t *line;			/**< Line buffer (2 * width bytes). */
+} stm32ipl_clahe_t;
+
+/**
+ * @brief Look-up table built once by STM32Ipl_LutFromGamma() or STM32Ipl_LutFromHistEq() and applied to any number
+ * of images of its format by STM32Ipl_ApplyLut().
+ */
+typedef struct _stm32ipl_lut_t
+{
+	image_bpp_t bpp;		/**< Format of the images the look-up table applies to. */
+	bool luminance;			/**< True when the first table maps the luminance of color images, whose chrominance
+							is kept; false when each channel of color images is mapped by its own table. */
+	uint8_t table[3][256];	/**< Tables: the first one maps Binary and Grayscale pixels, or the luminance; otherwise
+							red, green and blue, indexed by the channel value in the image format (i.e. 0 to 31 for the
+							red channel of RGB565). */
+} stm32ipl_lut_t;
+
 stm32ipl_err_t STM32Ipl_GammaCorr(image_t *img, float gamma_val, float contrast, float brightness);
+stm32ipl_err_t STM32Ipl_GammaCorr_GetWorkspaceSize(const image_t *img, uint32_t *size);
+stm32ipl_err_t STM32Ipl_GammaCorr_WithWorkspace(image_t *img, float gamma_val, float contrast, float brightness,
+		void *workspace, uint32_t workspaceSize);
 stm32ipl_err_t STM32Ipl_HistEq(image_t *img, const image_t *mask);
 stm32ipl_err_t STM32Ipl_HistEqClahe(image_t *img, float clipLimit, const image_t *mask);
+stm32ipl_err_t STM32Ipl_ClaheInit(stm32ipl_clahe_t *ctx, uint32_t width, uint32_t height, uint8_t tilesX,
+		uint8_t tilesY, float clipLimit, uint8_t smoothing);
+stm32ipl_err_t STM32Ipl_ClaheApply(stm32ipl_clahe_t *ctx, image_t *img, const image_t *mask);
+void STM32Ipl_ClaheReset(stm32ipl_clahe_t *ctx);
+void STM32Ipl_ClaheRelease(stm32ipl_clahe_t *ctx);
+stm32ipl_err_t STM32Ipl_LutFromGamma(stm32ipl_lut_t *lut, image_bpp_t format, float gamma, float contrast,
+		float brightness);
+stm32ipl_err_t STM32Ipl_LutFromHistEq(stm32ipl_lut_t *lut, const image_t *img);
+stm32ipl_err_t STM32Ipl_ApplyLut(image_t *img, const stm32ipl_lut_t *lut, const image_t *mask);
 /** @} */
 
 /**
@@ -299,18 +848,53 @@ stm32ipl_err_t STM32Ipl_MeanFilter(image_t *img, uint8_t kSize, bool threshold,
 		const image_t *mask);
 stm32ipl_err_t STM32Ipl_MedianFilter(image_t *img, uint8_t kSize, float percentile, bool threshold, int32_t offset,
 bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_MeanFilter_GetWorkspaceSize(const image_t *img, uint8_t kSize, uint32_t *size);
+stm32ipl_err_t STM32Ipl_MeanFilter_WithWorkspace(image_t *img, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask, void *workspace, uint32_t workspaceSize);
+stm32ipl_err_t STM32Ipl_MedianFilter_GetWorkspaceSize(const image_t *img, uint8_t kSize, uint32_t *size);
+stm32ipl_err_t STM32Ipl_MedianFilter_WithWorkspace(image_t *img, uint8_t kSize, float percentile, bool threshold,
+		int32_t offset, bool invert, const image_t *mask, void *workspace, uint32_t workspaceSize);
 stm32ipl_err_t STM32Ipl_ModeFilter(image_t *img, uint8_t kSize, bool threshold, int32_t offset, bool invert,
 		const image_t *mask);
 stm32ipl_err_t STM32Ipl_MidpointFilter(image_t *img, uint8_t kSize, float bias, bool threshold, int32_t offset,
 bool invert, const image_t *mask);
 stm32ipl_err_t STM32Ipl_BilateralFilter(image_t *img, uint8_t kSize, float colorSigma, float spaceSigma, bool threshold,
 		int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_BilateralFilterFast(image_t *img, uint8_t kSize, float colorSigma, float spaceSigma,
+		bool separable, bool threshold, int32_t offset, bool invert, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Morph(image_t *img, uint8_t kSize, const int32_t *krn, float mul, int32_t add, bool threshold,
 		int32_t offset, bool invert, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Gaussian(image_t *img, uint8_t kSize, bool threshold, bool unsharp, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Laplacian(image_t *img, uint8_t kSize, bool sharpen, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Sobel(image_t *img, uint8_t kSize, bool sharpen, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Scharr(image_t *img, uint8_t kSize, bool sharpen, const image_t *mask);
+stm32ipl_err_t STM32Ipl_MeanFilterEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_MedianFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float percentile,
+		bool threshold, int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_ModeFilterEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_MidpointFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float bias, bool threshold,
+		int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_BilateralFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float colorSigma,
+		float spaceSigma, bool threshold, int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_BilateralFilterFastEx(const image_t *src, image_t *dst, uint8_t kSize, float colorSigma,
+		float spaceSigma, bool separable, bool threshold, int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_MorphEx(const image_t *src, image_t *dst, uint8_t kSize, const int32_t *krn, float mul,
+		int32_t add, bool threshold, int32_t offset, bool invert, const image_t *mask);
+stm32ipl_err_t STM32Ipl_GaussianEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, bool unsharp,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_LaplacianEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_SobelEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen, const image_t *mask);
+stm32ipl_err_t STM32Ipl_ScharrEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen, const image_t *mask);
+stm32ipl_err_t STM32Ipl_GaussianRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, bool threshold,
+		bool unsharp);
+stm32ipl_err_t STM32Ipl_MedianFilterRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, float percentile,
+		bool threshold, int32_t offset, bool invert);
+stm32ipl_err_t STM32Ipl_MorphRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, const int32_t *krn, float mul,
+		int32_t add, bool threshold, int32_t offset, bool invert);
+stm32ipl_err_t STM32Ipl_Gradient(const image_t *src, uint8_t kSize, uint16_t *mag, uint8_t *dir);
 stm32ipl_err_t STM32Ipl_MidpointPool(const image_t *src, image_t *dst, uint16_t xDiv, uint16_t yDiv, uint16_t bias);
 stm32ipl_err_t STM32Ipl_MeanPool(const image_t *src, image_t *dst, uint16_t xDiv, uint16_t yDiv);
 /** @} */
@@ -322,6 +906,8 @@ stm32ipl_err_t STM32Ipl_MeanPool(const image_t *src, image_t *dst, uint16_t xDiv
  */
 stm32ipl_err_t STM32Ipl_GetPixel(const image_t *img, uint16_t x, uint16_t y, stm32ipl_color_t *p);
 stm32ipl_err_t STM32Ipl_FindMinMaxLoc(const image_t *img, list_t *outMin, list_t *outMax, const rectangle_t *roi);
+stm32ipl_err_t STM32Ipl_FindMinMaxLocEx(const image_t *img, uint32_t *min, uint32_t *max, point_t *minLoc,
+		uint32_t *minCount, point_t *maxLoc, uint32_t *maxCount, uint32_t size, const rectangle_t *roi);
 stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const rectangle_t *roi);
 /** @} */
 
@@ -345,9 +931,39 @@ stm32ipl_err_t STM32Ipl_FitEllipse(const point_t *points, uint16_t nPoints, elli
  */
 stm32ipl_err_t STM32Ipl_FindLines(const image_t *img, list_t *out, const rectangle_t *roi, uint8_t xStride,
 		uint8_t yStride, uint32_t threshold, uint8_t thetaMargin, uint8_t rhoMargin);
+stm32ipl_err_t STM32Ipl_FindLinesEdgeMap(const image_t *edges, list_t *out, const rectangle_t *roi,
+		uint32_t threshold, uint8_t voteMargin, uint8_t thetaMargin, uint8_t rhoMargin);
 stm32ipl_err_t STM32Ipl_FindCircles(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t xStride,
 		uint32_t yStride, uint32_t threshold, uint32_t xMargin, uint32_t yMargin, uint32_t rMargin, uint32_t rMin,
 		uint32_t rMax, uint32_t rStep);
+stm32ipl_err_t STM32Ipl_FindCirclesGradient(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t xStride,
+		uint32_t yStride, uint32_t edgeThreshold, uint32_t threshold, uint32_t xMargin, uint32_t yMargin, uint32_t rMargin,
+		uint32_t rMin, uint32_t rMax, uint32_t rStep);
+/** @} */
+
+/**
+ * @defgroup apriltag AprilTag detection
+ *
+ *  @{
+ */
+#ifdef IMLIB_ENABLE_APRILTAGS
+/**
+ * @brief Options of STM32Ipl_FindAprilTags(); a zero field selects the default value.
+ */
+typedef struct _stm32ipl_apriltag_opts_t
+{
+	uint8_t decimate;		/**< Decimation factor of the image where the quads are searched (default 1, no decimation). */
+	uint32_t maxMemory;		/**< Maximum working memory (bytes) taken from the library memory (default: as needed, half of the free memory for the cluster hash table). */
+	uint32_t maxDetections;	/**< Maximum number of returned detections (default: no limit). */
+	float fx;				/**< X focal length of the camera (pixels); default (2.8 / 3.984) * 656. */
+	float fy;				/**< Y focal length of the camera (pixels); default (2.8 / 2.952) * 488. */
+	float cx;				/**< X center of the image (pixels); default half of the ROI width. */
+	float cy;				/**< Y center of the image (pixels); default half of the ROI height. */
+} stm32ipl_apriltag_opts_t;
+
+stm32ipl_err_t STM32Ipl_FindAprilTags(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t families,
+		const stm32ipl_apriltag_opts_t *opts);
+#endif /* IMLIB_ENABLE_APRILTAGS */
 /** @} */
 
 /**
@@ -355,8 +971,63 @@ stm32ipl_err_t STM32Ipl_FindCircles(const image_t *img, list_t *out, const recta
  *
  *  @{
  */
+/**
+ * @brief Image file format, used by STM32Ipl_EncodeToBuffer().
+ */
+typedef enum _stm32ipl_file_format_t
+{
+	stm32ipl_file_format_bmp = 0,	/**< BMP. */
+	stm32ipl_file_format_ppm,		/**< Raw PPM (P6). */
+	stm32ipl_file_format_pgm,		/**< Raw PGM (P5). */
+	stm32ipl_file_format_jpg,		/**< JPEG (requires STM32IPL_ENABLE_JPEG). */
+	stm32ipl_file_format_ipr,		/**< IPR (raw image data, with a 16 bytes header). */
+	stm32ipl_file_format_ipq		/**< IPQ (image data losslessly compressed, with a 16 bytes header). */
+} stm32ipl_file_format_t;
+
 stm32ipl_err_t STM32Ipl_ReadImage(image_t *img, const char *filename);
+stm32ipl_err_t STM32Ipl_ReadImageScaled(image_t *img, const char *filename, uint32_t maxW, uint32_t maxH,
+		image_bpp_t format);
 stm32ipl_err_t STM32Ipl_WriteImage(const image_t *img, const char *filename);
+stm32ipl_err_t STM32Ipl_DecodeFromBuffer(const uint8_t *buf, uint32_t len, image_t *img);
+stm32ipl_err_t STM32Ipl_BindImage(const uint8_t *buf, uint32_t len, image_t *img);
+stm32ipl_err_t STM32Ipl_EncodeToBuffer(const image_t *img, stm32ipl_file_format_t format, uint8_t *buf, uint32_t cap,
+		uint32_t *len);
+#ifdef STM32IPL_ENABLE_HW_JPEG_CODEC
+void STM32Ipl_JpegIRQHandler(void);
+#endif /* STM32IPL_ENABLE_HW_JPEG_CODEC */
+
+/**
+ * @brief Function that receives the compressed data produced by the streaming JPEG encoder
+ * (see STM32Ipl_JpegStreamBegin()); it returns false to stop the encoding.
+ */
+typedef bool (*stm32ipl_jpeg_output_t)(const uint8_t *data, uint32_t size, void *arg);
+
+/**
+ * @brief Context of the streaming JPEG encoder (STM32Ipl_JpegStreamBegin(), STM32Ipl_JpegStreamPushRows(),
+ * STM32Ipl_JpegStreamEnd()).
+ */
+typedef struct _stm32ipl_jpeg_stream_t
+{
+	uint32_t width;			/**< Width of the frame. */
+	uint32_t height;		/**< Height of the frame. */
+	image_bpp_t bpp;		/**< Format of the frame. */
+	uint32_t y;				/**< Index of the next row expected. */
+	uint8_t *buffer;		/**< Output buffer, made of two halves filled in turn. */
+	uint32_t halfSize;		/**< Size of each half of the output buffer (bytes). */
+	uint8_t half;			/**< Index of the half being filled. */
+	bool failed;			/**< true when the output function has failed. */
+	stm32ipl_jpeg_output_t output;	/**< Function that receives the compressed data. */
+	void *arg;				/**< Argument given to the output function. */
+	void *codec;			/**< Encoder state. */
+} stm32ipl_jpeg_stream_t;
+
+#if defined(STM32IPL_ENABLE_IMAGE_IO) && defined(STM32IPL_ENABLE_JPEG) && !defined(STM32IPL_ENABLE_HW_JPEG_CODEC)
+stm32ipl_err_t STM32Ipl_JpegStreamBegin(stm32ipl_jpeg_stream_t *ctx, uint32_t width, uint32_t height,
+		image_bpp_t format, uint8_t quality, uint8_t *buffer, uint32_t size, stm32ipl_jpeg_output_t output, void *arg);
+stm32ipl_err_t STM32Ipl_JpegStreamPushRows(stm32ipl_jpeg_stream_t *ctx, const uint8_t *data, uint32_t rows,
+		uint32_t stride);
+stm32ipl_err_t STM32Ipl_JpegStreamEnd(stm32ipl_jpeg_stream_t *ctx);
+#endif /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG && !STM32IPL_ENABLE_HW_JPEG_CODEC */
 /** @} */
 
 /**
@@ -364,12 +1035,29 @@ stm32ipl_err_t STM32Ipl_WriteImage(const image_t *img, const char *filename);
  *
  *  @{
  */
+/**
+ * @brief Local threshold computed by STM32Ipl_AdaptiveThreshold() from the mean and the standard deviation
+ * of the window around each pixel.
+ */
+typedef enum _stm32ipl_adaptive_thresh_t
+{
+	stm32ipl_adaptive_thresh_bradley = 0,	/**< Bradley: mean * (1 - k). */
+	stm32ipl_adaptive_thresh_sauvola		/**< Sauvola: mean * (1 + k * ((stddev / 128) - 1)). */
+} stm32ipl_adaptive_thresh_t;
+
 stm32ipl_err_t STM32Ipl_IIAllocData(i_image_t *iimg, uint32_t width, uint32_t height);
 void STM32Ipl_IIReleaseData(i_image_t *iimg);
 stm32ipl_err_t STM32Ipl_II(const image_t *src, i_image_t *dst);
 stm32ipl_err_t STM32Ipl_IIScaled(const image_t *src, i_image_t *dst);
 stm32ipl_err_t STM32Ipl_IISq(const image_t *src, i_image_t *dst);
 uint32_t STM32Ipl_IILookup(const i_image_t *iimg, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+stm32ipl_err_t STM32Ipl_IISumSq(const image_t *src, i_image_t *sum, i_image_t *sumSq);
+stm32ipl_err_t STM32Ipl_II64AllocData(i64_image_t *iimg, uint32_t width, uint32_t height);
+void STM32Ipl_II64ReleaseData(i64_image_t *iimg);
+stm32ipl_err_t STM32Ipl_IISumSq64(const image_t *src, i_image_t *sum, i64_image_t *sumSq);
+uint64_t STM32Ipl_IILookup64(const i64_image_t *iimg, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+stm32ipl_err_t STM32Ipl_AdaptiveThreshold(const image_t *src, image_t *dst, uint8_t kSize, float k,
+		stm32ipl_adaptive_thresh_t method, bool invert);
 /** @} */
 
 /**
@@ -405,6 +1093,19 @@ stm32ipl_err_t STM32Ipl_Div(image_t *img, const image_t *other, stm32ipl_color_t
 stm32ipl_err_t STM32Ipl_Diff(image_t *img, const image_t *other, stm32ipl_color_t scalar, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Min(image_t *img, const image_t *other, stm32ipl_color_t scalar, const image_t *mask);
 stm32ipl_err_t STM32Ipl_Max(image_t *img, const image_t *other, stm32ipl_color_t scalar, const image_t *mask);
+stm32ipl_err_t STM32Ipl_Blend(image_t *imgA, const image_t *imgB, uint8_t alpha, const image_t *mask);
+/** @} */
+
+/**
+ * @defgroup hwOps Hardware accelerated operations
+ *
+ *  @{
+ */
+stm32ipl_err_t STM32Ipl_ConvertStart(const image_t *src, image_t *dst);
+stm32ipl_err_t STM32Ipl_FillStart(image_t *img, const rectangle_t *roi, stm32ipl_color_t color);
+stm32ipl_err_t STM32Ipl_CopyDataStart(const image_t *src, image_t *dst);
+stm32ipl_err_t STM32Ipl_BlendStart(image_t *imgA, const image_t *imgB, uint8_t alpha);
+stm32ipl_err_t STM32Ipl_HwWait(void);
 /** @} */
 
 /**
@@ -418,6 +1119,215 @@ stm32ipl_err_t STM32Ipl_Open(image_t *img, uint8_t kSize, uint8_t threshold, con
 stm32ipl_err_t STM32Ipl_Close(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask);
 stm32ipl_err_t STM32Ipl_TopHat(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask);
 stm32ipl_err_t STM32Ipl_BlackHat(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask);
+stm32ipl_err_t STM32Ipl_DilateEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_ErodeEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_OpenEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_CloseEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_TopHatEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_BlackHatEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask);
+stm32ipl_err_t STM32Ipl_DilateRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, uint8_t threshold);
+stm32ipl_err_t STM32Ipl_ErodeRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, uint8_t threshold);
+/** @} */
+
+/**
+ * @defgroup bgModel Background model
+ *
+ *  @{
+ */
+#define STM32IPL_BG_BLOCK_SIZE	16	/**< Size (pixels) of the square blocks that can be skipped by STM32Ipl_BgModelUpdate(). */
+
+/**
+ * @brief Background model method.
+ */
+typedef enum _stm32ipl_bg_method_t
+{
+	stm32ipl_bg_running_avg = 0,	/**< Running average: the background moves by a fraction of its difference from the frame. */
+	stm32ipl_bg_approx_median		/**< Approximate median: the background moves by a fixed step towards the frame. */
+} stm32ipl_bg_method_t;
+
+/**
+ * @brief Background model created by STM32Ipl_BgModelInit(): the background luminance of each pixel is kept in
+ * fixed point (7 fractional bits). Its fields must not be modified by the application.
+ */
+typedef struct _stm32ipl_bg_model_t
+{
+	uint32_t w;						/**< Width of the frames. */
+	uint32_t h;						/**< Height of the frames. */
+	stm32ipl_bg_method_t method;	/**< Update method. */
+	uint8_t rate;					/**< Adaptation speed, as a right shift (0 = fastest). */
+	uint8_t threshold;				/**< Minimum difference from the background of a foreground pixel. */
+	uint8_t skipThreshold;			/**< Maximum mean change of a skipped block; 0 if the blocks are never skipped. */
+	bool selective;					/**< If true, the foreground pixels do not update the background. */
+	int16_t *model;					/**< Background (private layout). */
+	uint16_t *blockSum;				/**< Sum of the pixels of each block in the last frame. */
+	uint8_t *blockFg;				/**< Non-zero for the blocks that had foreground pixels in the last frame. */
+} stm32ipl_bg_model_t;
+
+stm32ipl_err_t STM32Ipl_BgModelInit(stm32ipl_bg_model_t *model, const image_t *first, stm32ipl_bg_method_t method,
+		uint8_t rate, uint8_t threshold, uint8_t skipThreshold, bool selective);
+stm32ipl_err_t STM32Ipl_BgModelUpdate(stm32ipl_bg_model_t *model, const image_t *img, image_t *mask);
+stm32ipl_err_t STM32Ipl_BgModelGetForeground(const stm32ipl_bg_model_t *model, const image_t *img, image_t *mask);
+void STM32Ipl_BgModelRelease(stm32ipl_bg_model_t *model);
+/** @} */
+
+/**
+ * @defgroup displacement Displacement estimation
+ *
+ *  @{
+ */
+
+/**
+ * @brief State of the phase correlation created by STM32Ipl_DisplacementInit(): it holds the FFT instances of
+ * the correlation window and the spectrum of the last frame. Its fields must not be modified by the application.
+ */
+typedef struct _stm32ipl_displacement_t
+{
+	uint16_t w;							/**< Width of the correlation window (power of two). */
+	uint16_t h;							/**< Height of the correlation window (power of two). */
+	bool logPolar;						/**< If true, the rotation and the scale are estimated. */
+	bool hasPrev;						/**< True when the spectrum of the last frame is cached. */
+	float *winX;						/**< Window function along x. */
+	float *winY;						/**< Window function along y (cartesian mode only). */
+	float *rho;							/**< Radius of each log-polar column (log-polar mode only). */
+	float *spectrum;					/**< Spectrum of the last frame (private layout). */
+	arm_rfft_fast_instance_f32 rowFft;	/**< Real FFT of the rows of the window. */
+	arm_cfft_instance_f32 colFft;		/**< Complex FFT of the columns of the spectrum. */
+} stm32ipl_displacement_t;
+
+stm32ipl_err_t STM32Ipl_DisplacementInit(stm32ipl_displacement_t *disp, uint16_t w, uint16_t h, bool logPolar);
+stm32ipl_err_t STM32Ipl_FindDisplacement(stm32ipl_displacement_t *disp, const image_t *img, const image_t *prev,
+		const rectangle_t *roi, float *dx, float *dy, float *response);
+void STM32Ipl_DisplacementRelease(stm32ipl_displacement_t *disp);
+/** @} */
+
+/**
+ * @defgroup pipeline Pipeline
+ *
+ *  @{
+ */
+stm32ipl_err_t STM32Ipl_Pipeline(const image_t *src, image_t *dst, const stm32ipl_stage_t *stages, uint32_t nStages);
+uint32_t STM32Ipl_Pipeline_GetBufferSize(uint32_t width, const stm32ipl_stage_t *stages, uint32_t nStages);
+/** @} */
+
+/**
+ * @defgroup tiled Tiled execution
+ *
+ *  @{
+ */
+stm32ipl_err_t STM32Ipl_Tiled(const image_t *src, image_t *dst, uint16_t tileW, uint16_t tileH, uint8_t halo,
+		stm32ipl_tile_op_t op, void *arg);
+uint32_t STM32Ipl_Tiled_GetBufferSize(const image_t *img, uint16_t tileW, uint16_t tileH, uint8_t halo);
+stm32ipl_err_t STM32Ipl_TiledRoi(const image_t *src, image_t *dst, const rectangle_t *roi, uint8_t halo,
+		stm32ipl_tile_op_t op, void *arg);
+
+/**
+ * @brief Metric used by STM32Ipl_DirtyTilesUpdate() to tell the tiles that changed from the reference frame.
+ */
+typedef enum _stm32ipl_dirty_metric_t
+{
+	stm32ipl_dirty_sad = 0,	/**< Mean absolute difference of the pixel values (of each channel, in the range [0, 255]). */
+	stm32ipl_dirty_ssim		/**< Minimum SSIM of the 8x8 blocks of the tile (see STM32Ipl_GetSimilarityEx()). */
+} stm32ipl_dirty_metric_t;
+
+/**
+ * @brief Dirty tile tracker created by STM32Ipl_DirtyTilesInit(): it keeps a reference frame and tells which
+ * square tiles of each new frame changed from it. Its fields must not be modified by the application.
+ */
+typedef struct _stm32ipl_dirty_tiles_t
+{
+	image_t ref;					/**< Reference frame: each tile as it was the last time it changed. */
+	uint8_t *dirty;					/**< For each tile (by rows), non-zero if it changed in the last frame. */
+	uint16_t tileSize;				/**< Size (pixels) of the tiles. */
+	uint16_t tilesX;				/**< Number of tiles along the horizontal direction. */
+	uint16_t tilesY;				/**< Number of tiles along the vertical direction. */
+	stm32ipl_dirty_metric_t metric;	/**< Metric of the change. */
+	float threshold;				/**< Minimum mean difference (SAD) or maximum SSIM of a changed tile. */
+	uint32_t count;					/**< Number of tiles that changed in the last frame. */
+	bool valid;						/**< False until the first frame, or after STM32Ipl_DirtyTilesReset(). */
+} stm32ipl_dirty_tiles_t;
+
+stm32ipl_err_t STM32Ipl_DirtyTilesInit(stm32ipl_dirty_tiles_t *tracker, uint32_t width, uint32_t height,
+		image_bpp_t format, uint16_t tileSize, stm32ipl_dirty_metric_t metric, float threshold);
+stm32ipl_err_t STM32Ipl_DirtyTilesUpdate(stm32ipl_dirty_tiles_t *tracker, const image_t *img, uint32_t *count);
+void STM32Ipl_DirtyTilesReset(stm32ipl_dirty_tiles_t *tracker);
+stm32ipl_err_t STM32Ipl_DirtyTiled(const stm32ipl_dirty_tiles_t *tracker, const image_t *src, image_t *dst,
+		uint8_t halo, stm32ipl_tile_op_t op, void *arg);
+stm32ipl_err_t STM32Ipl_DirtyTilesForEach(const stm32ipl_dirty_tiles_t *tracker, const image_t *img,
+		stm32ipl_tile_visit_t visit, void *arg);
+void STM32Ipl_DirtyTilesRelease(stm32ipl_dirty_tiles_t *tracker);
+void STM32Ipl_BlockCopyStart(uint8_t *dst, uint32_t dstStride, const uint8_t *src, uint32_t srcStride,
+		uint32_t lineSize, uint32_t lines);
+void STM32Ipl_BlockCopyWait(void);
+/** @} */
+
+/**
+ * @defgroup dualCore Dual-core execution
+ *
+ *  @{
+ */
+#ifdef STM32IPL_ENABLE_DUAL_CORE
+stm32ipl_err_t STM32Ipl_DualCoreInit(void);
+stm32ipl_err_t STM32Ipl_DualCoreRun(const stm32ipl_dual_job_t *job);
+bool STM32Ipl_DualCorePoll(void);
+#endif /* STM32IPL_ENABLE_DUAL_CORE */
+/** @} */
+
+/**
+ * @defgroup frameRing Camera frame ring
+ *
+ *  @{
+ */
+#define STM32IPL_FRAME_RING_MAX_FRAMES	4	/**< Max number of buffers of a frame ring. */
+
+/**
+ * @brief Owner of a buffer of a frame ring.
+ */
+typedef enum _stm32ipl_frame_owner_t
+{
+	stm32ipl_frame_free = 0,	/**< Available to the capture. */
+	stm32ipl_frame_capture,		/**< Being written by the capture DMA. */
+	stm32ipl_frame_ready,		/**< Captured, waiting to be acquired. */
+	stm32ipl_frame_cpu,			/**< Acquired by the application, processed by the CPU. */
+	stm32ipl_frame_display		/**< Being read by the display. */
+} stm32ipl_frame_owner_t;
+
+/**
+ * @brief Ring of camera frame buffers shared by the capture DMA, the library and the display
+ * (STM32Ipl_FrameRingInit()); the rows are in the ranges [xxxBegin, xxxEnd).
+ */
+typedef struct _stm32ipl_frame_ring_t
+{
+	uint32_t width;			/**< Width of the frames. */
+	uint32_t height;		/**< Height of the frames. */
+	image_bpp_t format;		/**< Format of the frames. */
+	uint32_t count;			/**< Number of buffers. */
+	uint32_t frameSize;		/**< Size of a frame (bytes). */
+	uint32_t rowSize;		/**< Size of a row (bytes); 0 when the rows are not tracked. */
+	uint32_t lastSequence;	/**< Sequence number of the last frame captured. */
+	uint8_t *data[STM32IPL_FRAME_RING_MAX_FRAMES];		/**< Buffers. */
+	volatile stm32ipl_frame_owner_t owner[STM32IPL_FRAME_RING_MAX_FRAMES];	/**< Owners of the buffers. */
+	uint32_t sequence[STM32IPL_FRAME_RING_MAX_FRAMES];	/**< Sequence numbers of the captured frames. */
+	uint32_t validBegin[STM32IPL_FRAME_RING_MAX_FRAMES];	/**< Rows invalidated since the acquisition. */
+	uint32_t validEnd[STM32IPL_FRAME_RING_MAX_FRAMES];
+	uint32_t dirtyBegin[STM32IPL_FRAME_RING_MAX_FRAMES];	/**< Rows written by the CPU since the acquisition. */
+	uint32_t dirtyEnd[STM32IPL_FRAME_RING_MAX_FRAMES];
+} stm32ipl_frame_ring_t;
+
+stm32ipl_err_t STM32Ipl_FrameRingInit(stm32ipl_frame_ring_t *ring, uint8_t *const buffers[], uint32_t count,
+		uint32_t width, uint32_t height, image_bpp_t format);
+uint8_t* STM32Ipl_FrameRingCaptureStart(stm32ipl_frame_ring_t *ring);
+uint8_t* STM32Ipl_FrameRingCaptureDone(stm32ipl_frame_ring_t *ring, const uint8_t *data);
+stm32ipl_err_t STM32Ipl_FrameRingAcquire(stm32ipl_frame_ring_t *ring, image_t *img, const rectangle_t *roi);
+stm32ipl_err_t STM32Ipl_FrameRingAccess(stm32ipl_frame_ring_t *ring, const image_t *img, const rectangle_t *roi,
+		bool write);
+stm32ipl_err_t STM32Ipl_FrameRingRelease(stm32ipl_frame_ring_t *ring, const image_t *img, bool display);
+stm32ipl_err_t STM32Ipl_FrameRingDisplayDone(stm32ipl_frame_ring_t *ring, const uint8_t *data);
 /** @} */
 
 /**
@@ -425,7 +1335,41 @@ stm32ipl_err_t STM32Ipl_BlackHat(image_t *img, uint8_t kSize, uint8_t threshold,
  *
  *  @{
  */
+/**
+ * @brief Lens distortion model of a camera calibration (OpenCV conventions).
+ */
+typedef enum _stm32ipl_calib_model_t
+{
+	stm32ipl_calib_model_pinhole = 0,	/**< Radial and tangential distortion, coefficients k1, k2, p1, p2, k3 (OpenCV calib3d). */
+	stm32ipl_calib_model_fisheye		/**< Equidistant fisheye distortion, coefficients k1, k2, k3, k4 (OpenCV fisheye). */
+} stm32ipl_calib_model_t;
+
+/**
+ * @brief Camera calibration used by STM32Ipl_DewarpMapFromCalib(): OpenCV camera matrix and distortion coefficients.
+ */
+typedef struct _stm32ipl_camera_calib_t
+{
+	stm32ipl_calib_model_t model;	/**< Distortion model. */
+	float fx;						/**< X focal length of the camera (pixels). */
+	float fy;						/**< Y focal length of the camera (pixels). */
+	float cx;						/**< X principal point of the camera (pixels). */
+	float cy;						/**< Y principal point of the camera (pixels). */
+	float dist[5];					/**< Distortion coefficients: k1, k2, p1, p2, k3 (pinhole) or k1, k2, k3, k4 (fisheye). */
+	float newFx;					/**< X focal length of the undistorted image (pixels); 0 to use fx. */
+	float newFy;					/**< Y focal length of the undistorted image (pixels); 0 to use fy. */
+	float newCx;					/**< X principal point of the undistorted image (pixels); 0 to use cx. */
+	float newCy;					/**< Y principal point of the undistorted image (pixels); 0 to use cy. */
+} stm32ipl_camera_calib_t;
+
 stm32ipl_err_t STM32Ipl_Dewarp(const image_t *src, image_t *dst, const mapxy_t *mapxy, dewarping_algo_t algo);
+stm32ipl_err_t STM32Ipl_DewarpCompileMap(const mapxy_t *mapxy, uint32_t width, uint32_t height, image_bpp_t srcFmt,
+		dewarping_algo_t algo, mapxy_compiled_t *compiled);
+stm32ipl_err_t STM32Ipl_DewarpCompileMapTiled(const mapxy_t *mapxy, uint32_t width, uint32_t height,
+		image_bpp_t srcFmt, dewarping_algo_t algo, uint16_t blockW, uint16_t blockH, mapxy_compiled_t *compiled);
+void STM32Ipl_DewarpReleaseMap(mapxy_compiled_t *compiled);
+stm32ipl_err_t STM32Ipl_DewarpMapFromCalib(const stm32ipl_camera_calib_t *calib, uint32_t width, uint32_t height,
+		uint16_t gridStep, mapxy_t *mapxy);
+void STM32Ipl_DewarpReleaseCalibMap(mapxy_t *mapxy);
 /** @} */
 
 /**
@@ -434,14 +1378,39 @@ stm32ipl_err_t STM32Ipl_Dewarp(const image_t *src, image_t *dst, const mapxy_t *
  *  @{
  */
 #ifdef STM32IPL_ENABLE_OBJECT_DETECTION
+#define STM32IPL_DETECT_TRACK_MAX_OBJECTS	8	/**< Maximum number of objects tracked by STM32Ipl_DetectObjectTrack(). */
+
+/**
+ * @brief Context of STM32Ipl_DetectObjectTrack(), initialized by STM32Ipl_DetectTrackInit(): it keeps the objects
+ * detected in the previous frame, that are searched only around their position until the next full scan.
+ */
+typedef struct _stm32ipl_detect_track_t
+{
+	rectangle_t object[STM32IPL_DETECT_TRACK_MAX_OBJECTS];	/**< Objects detected in the previous frame. */
+	uint32_t count;		/**< Number of objects. */
+	uint32_t period;	/**< Number of frames between two full scans. */
+	uint32_t frames;	/**< Number of frames since the last full scan. */
+	float margin;		/**< Expansion of the search region on each side of an object, relative to its size. */
+} stm32ipl_detect_track_t;
+
 #ifdef STM32IPL_ENABLE_FRONTAL_FACE_CASCADE
 stm32ipl_err_t STM32Ipl_LoadFaceCascade(cascade_t *cascade);
 #endif /* STM32IPL_ENABLE_FRONTAL_FACE_CASCADE */
 #ifdef STM32IPL_ENABLE_EYE_CASCADE
 stm32ipl_err_t STM32Ipl_LoadEyeCascade(cascade_t *cascade);
 #endif /* STM32IPL_ENABLE_EYE_CASCADE */
+stm32ipl_err_t STM32Ipl_BindCascade(cascade_t *cascade, const void *data, uint32_t size);
 stm32ipl_err_t STM32Ipl_DetectObject(const image_t *img, array_t **out, const rectangle_t *roi, cascade_t *cascade,
 		float scaleFactor, float threshold);
+stm32ipl_err_t STM32Ipl_DetectObjectVec(const image_t *img, stm32ipl_rect_vec_t *out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold, float iouThreshold, uint32_t minNeighbors);
+stm32ipl_err_t STM32Ipl_DetectObject_GetWorkspaceSize(const image_t *img, const rectangle_t *roi,
+		const cascade_t *cascade, uint32_t *size);
+stm32ipl_err_t STM32Ipl_DetectObject_WithWorkspace(const image_t *img, array_t **out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold, void *workspace, uint32_t workspaceSize);
+stm32ipl_err_t STM32Ipl_DetectTrackInit(stm32ipl_detect_track_t *ctx, uint32_t period, float margin);
+stm32ipl_err_t STM32Ipl_DetectObjectTrack(stm32ipl_detect_track_t *ctx, const image_t *img, array_t **out,
+		const rectangle_t *roi, cascade_t *cascade, float scaleFactor, float threshold);
 #endif /* STM32IPL_ENABLE_OBJECT_DETECTION */
 /** @} */
 
@@ -480,6 +1449,12 @@ stm32ipl_err_t STM32Ipl_RectExpand(rectangle_t *r, uint16_t x, uint16_t y);
 bool STM32Ipl_RectSubImage(const image_t *img, const rectangle_t *src, rectangle_t *dst);
 stm32ipl_err_t STM32Ipl_RectToPoints(const rectangle_t *r, point_t *points);
 stm32ipl_err_t STM32Ipl_RectMerge(array_t **rects);
+stm32ipl_err_t STM32Ipl_RectVecInit(stm32ipl_rect_vec_t *vec, stm32ipl_scored_rect_t *buffer, uint32_t capacity);
+void STM32Ipl_RectVecRelease(stm32ipl_rect_vec_t *vec);
+stm32ipl_err_t STM32Ipl_RectVecPush(stm32ipl_rect_vec_t *vec, const rectangle_t *r, float score);
+stm32ipl_err_t STM32Ipl_RectVecFromArray(stm32ipl_rect_vec_t *vec, const array_t *rects, float score);
+stm32ipl_err_t STM32Ipl_RectVecNMS(stm32ipl_rect_vec_t *vec, float threshold);
+stm32ipl_err_t STM32Ipl_RectVecGroup(stm32ipl_rect_vec_t *vec, float threshold, uint32_t minNeighbors);
 /** @} */
 
 /**
@@ -489,14 +1464,208 @@ stm32ipl_err_t STM32Ipl_RectMerge(array_t **rects);
  */
 typedef enum {
 	RESIZE_NEAREST = 0,
-	RESIZE_BILINEAR
+	RESIZE_BILINEAR,
+	RESIZE_AREA
 }resize_algo_t;
 stm32ipl_err_t STM32Ipl_Crop(const image_t *src, image_t *dst, uint32_t x, uint32_t y);
 stm32ipl_err_t STM32Ipl_Resize(const image_t *src, image_t *dst, const resize_algo_t algo);
 stm32ipl_err_t STM32Ipl_Resize_Roi(const image_t *src, const rectangle_t *src_roi, image_t *dst, const rectangle_t *dst_roi, const resize_algo_t algo);
+stm32ipl_err_t STM32Ipl_Resize_Roi_GetWorkspaceSize(const image_t *src, const rectangle_t *src_roi, const image_t *dst,
+		const rectangle_t *dst_roi, const resize_algo_t algo, uint32_t *size);
+stm32ipl_err_t STM32Ipl_Resize_Roi_WithWorkspace(const image_t *src, const rectangle_t *src_roi, image_t *dst,
+		const rectangle_t *dst_roi, const resize_algo_t algo, void *workspace, uint32_t workspaceSize);
+stm32ipl_err_t STM32Ipl_ResizeRoiBatch(const image_t *src, const rectangle_t *rois, uint32_t n, image_t *dsts,
+		const resize_algo_t algo);
+stm32ipl_err_t STM32Ipl_ResizeConvert(const image_t *src, const rectangle_t *srcRoi, image_t *dst, const resize_algo_t algo);
 stm32ipl_err_t STM32Ipl_Downscale(const image_t *src, image_t *dst, bool reversed);
 /** @} */
 
+/**
+ * @defgroup pyramid Image pyramid
+ *
+ *  @{
+ */
+#define STM32IPL_PYRAMID_MAX_LEVELS	8	/**< Maximum number of levels of an image pyramid. */
+
+/**
+ * @brief Image pyramid built by STM32Ipl_PyramidBuild(): the first level is the source image (not owned by the
+ * pyramid), each of the others is downscaled by the scale factor from the previous one.
+ */
+typedef struct _stm32ipl_pyramid_t
+{
+	image_t level[STM32IPL_PYRAMID_MAX_LEVELS];	/**< Levels, from the finest to the coarsest. */
+	float scale[STM32IPL_PYRAMID_MAX_LEVELS];	/**< Downscale factor of each level with respect to the first one. */
+	uint8_t levels;								/**< Number of levels. */
+	resize_algo_t algo;							/**< Method used to downscale the levels. */
+} stm32ipl_pyramid_t;
+
+stm32ipl_err_t STM32Ipl_PyramidBuild(const image_t *src, uint8_t levels, float scale, resize_algo_t algo,
+		stm32ipl_pyramid_t *pyramid);
+void STM32Ipl_PyramidRelease(stm32ipl_pyramid_t *pyramid);
+int32_t STM32Ipl_PyramidGetLevel(const stm32ipl_pyramid_t *pyramid, float factor);
+#ifdef STM32IPL_ENABLE_OBJECT_DETECTION
+stm32ipl_err_t STM32Ipl_DetectObjectPyramid(const stm32ipl_pyramid_t *pyramid, array_t **out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold);
+#endif /* STM32IPL_ENABLE_OBJECT_DETECTION */
+/** @} */
+
+/**
+ * @defgroup keypoints Keypoints
+ *
+ *  @{
+ */
+#define STM32IPL_ORB_DESC_SIZE	32	/**< Size (bytes) of an ORB descriptor: 256 binary tests. */
+
+/**
+ * @brief Keypoint found by STM32Ipl_FindKeypoints().
+ */
+typedef struct _stm32ipl_keypoint_t
+{
+	float x;								/**< X coordinate, in the first level of the pyramid. */
+	float y;								/**< Y coordinate, in the first level of the pyramid. */
+	float angle;							/**< Orientation (radians); zero if there is no descriptor. */
+	uint16_t score;							/**< FAST score. */
+	uint8_t level;							/**< Level of the pyramid where the keypoint was found. */
+	uint8_t desc[STM32IPL_ORB_DESC_SIZE];	/**< ORB descriptor; zero if it was not computed. */
+} stm32ipl_keypoint_t;
+
+/**
+ * @brief Match between two keypoints found by STM32Ipl_MatchKeypoints().
+ */
+typedef struct _stm32ipl_kp_match_t
+{
+	uint16_t query;		/**< Index of the query keypoint. */
+	uint16_t train;		/**< Index of the matching train keypoint. */
+	uint16_t distance;	/**< Hamming distance between the two descriptors. */
+} stm32ipl_kp_match_t;
+
+stm32ipl_err_t STM32Ipl_FindKeypoints(const stm32ipl_pyramid_t *pyramid, const rectangle_t *roi, uint8_t threshold,
+		bool describe, stm32ipl_keypoint_t *kps, uint32_t maxKps, uint32_t *nKps);
+uint32_t STM32Ipl_HammingDistance(const uint8_t *desc1, const uint8_t *desc2, uint32_t size);
+stm32ipl_err_t STM32Ipl_MatchKeypoints(const stm32ipl_keypoint_t *query, uint32_t nQuery,
+		const stm32ipl_keypoint_t *train, uint32_t nTrain, uint16_t maxDistance, float ratio,
+		stm32ipl_kp_match_t *matches, uint32_t *nMatches);
+/** @} */
+
+/**
+ * @defgroup features Feature extraction
+ *
+ *  @{
+ */
+#define STM32IPL_HOG_BINS		4							/**< Orientation bins of a HOG cell (gradient sectors). */
+#define STM32IPL_HOG_BLOCK_SIZE	(4 * STM32IPL_HOG_BINS)		/**< Size (bytes) of a normalized 2x2 cells block. */
+#define STM32IPL_LBP_BINS		59							/**< Bins of a uniform LBP cell histogram. */
+
+/**
+ * @brief HOG features of a frame created with STM32Ipl_HogInit() and computed by STM32Ipl_HogCompute(): the
+ * normalized 2x2 cells blocks of the cell grid, overlapping by one cell, stored row by row. Its fields must not
+ * be modified by the application.
+ */
+typedef struct _stm32ipl_hog_t
+{
+	uint16_t w;			/**< Width of the frames. */
+	uint16_t h;			/**< Height of the frames. */
+	uint16_t cellSize;	/**< Side of the square cells (pixels). */
+	uint16_t cellsX;	/**< Number of cells per row. */
+	uint16_t cellsY;	/**< Number of cells per column. */
+	uint8_t *blocks;	/**< (cellsX - 1) * (cellsY - 1) blocks of STM32IPL_HOG_BLOCK_SIZE bytes. */
+} stm32ipl_hog_t;
+
+/**
+ * @brief LBP features of a frame created with STM32Ipl_LbpInit() and computed by STM32Ipl_LbpCompute(): the
+ * normalized uniform LBP histograms of the cell grid, stored row by row. Its fields must not be modified by the
+ * application.
+ */
+typedef struct _stm32ipl_lbp_t
+{
+	uint16_t w;			/**< Width of the frames. */
+	uint16_t h;			/**< Height of the frames. */
+	uint16_t cellSize;	/**< Side of the square cells (pixels). */
+	uint16_t cellsX;	/**< Number of cells per row. */
+	uint16_t cellsY;	/**< Number of cells per column. */
+	uint8_t *cells;		/**< cellsX * cellsY histograms of STM32IPL_LBP_BINS bytes. */
+} stm32ipl_lbp_t;
+
+stm32ipl_err_t STM32Ipl_HogInit(stm32ipl_hog_t *hog, uint16_t w, uint16_t h, uint16_t cellSize);
+stm32ipl_err_t STM32Ipl_HogCompute(stm32ipl_hog_t *hog, const image_t *src, const uint16_t *mag, const uint8_t *dir);
+stm32ipl_err_t STM32Ipl_HogWindow(const stm32ipl_hog_t *hog, uint16_t cellX, uint16_t cellY, uint16_t cellsW,
+		uint16_t cellsH, uint8_t *desc);
+void STM32Ipl_HogRelease(stm32ipl_hog_t *hog);
+stm32ipl_err_t STM32Ipl_LbpInit(stm32ipl_lbp_t *lbp, uint16_t w, uint16_t h, uint16_t cellSize);
+stm32ipl_err_t STM32Ipl_LbpCompute(stm32ipl_lbp_t *lbp, const image_t *src);
+stm32ipl_err_t STM32Ipl_LbpWindow(const stm32ipl_lbp_t *lbp, uint16_t cellX, uint16_t cellY, uint16_t cellsW,
+		uint16_t cellsH, uint8_t *desc);
+void STM32Ipl_LbpRelease(stm32ipl_lbp_t *lbp);
+/** @} */
+
+/**
+ * @defgroup opticalFlow Optical flow
+ *
+ *  @{
+ */
+/**
+ * @brief Point with sub-pixel coordinates tracked by STM32Ipl_OpticalFlowLK().
+ */
+typedef struct _stm32ipl_point2f_t
+{
+	float x;	/**< X coordinate. */
+	float y;	/**< Y coordinate. */
+} stm32ipl_point2f_t;
+
+stm32ipl_err_t STM32Ipl_OpticalFlowLK(const stm32ipl_pyramid_t *prevPyr, const stm32ipl_pyramid_t *currPyr,
+		const stm32ipl_point2f_t *pts, uint32_t n, stm32ipl_point2f_t *outPts, uint8_t *status);
+/** @} */
+
+/**
+ * @defgroup tensor Neural network input
+ *
+ *  @{
+ */
+/**
+ * @brief Type of the elements of the tensor produced by STM32Ipl_PrepareTensor().
+ */
+typedef enum _stm32ipl_tensor_type_t
+{
+	stm32ipl_tensor_uint8 = 0,	/**< Quantized, 8-bit unsigned integer. */
+	stm32ipl_tensor_int8,		/**< Quantized, 8-bit signed integer. */
+	stm32ipl_tensor_float32		/**< 32-bit floating point. */
+} stm32ipl_tensor_type_t;
+
+/**
+ * @brief Layout of the tensor produced by STM32Ipl_PrepareTensor().
+ */
+typedef enum _stm32ipl_tensor_layout_t
+{
+	stm32ipl_tensor_hwc = 0,	/**< Interleaved channels: height, width, channels. */
+	stm32ipl_tensor_chw			/**< Planar channels: channels, height, width. */
+} stm32ipl_tensor_layout_t;
+
+/**
+ * @brief Description of the tensor produced by STM32Ipl_PrepareTensor(). Each pixel channel value v is
+ * normalized to (v - mean) * scale; for the quantized types, the normalized value n is then quantized to
+ * round(n / qScale) + qZeroPoint, saturated to the range of the type.
+ */
+typedef struct _stm32ipl_tensor_t
+{
+	uint16_t w;						/**< Width of the tensor. */
+	uint16_t h;						/**< Height of the tensor. */
+	uint8_t channels;				/**< Number of channels: 1 (luminance) or 3 (R, G, B). */
+	stm32ipl_tensor_type_t type;	/**< Type of the elements. */
+	stm32ipl_tensor_layout_t layout;/**< Layout. */
+	bool swapRB;					/**< When true, the channels are in B, G, R order. */
+	float mean[3];					/**< Mean of each channel, in the tensor channel order. */
+	float scale[3];					/**< Scale of each channel, in the tensor channel order. */
+	float qScale;					/**< Quantization scale (quantized types only); it must be positive. */
+	int32_t qZeroPoint;				/**< Quantization zero point (quantized types only). */
+	resize_algo_t algo;				/**< Resize method. */
+	bool letterbox;					/**< When true, the aspect ratio is kept and the borders are padded. */
+	uint8_t padValue;				/**< Channel value of the padding pixels (before normalization). */
+} stm32ipl_tensor_t;
+
+stm32ipl_err_t STM32Ipl_PrepareTensor(const image_t *src, const rectangle_t *roi, const stm32ipl_tensor_t *tensor,
+		void *out);
+/** @} */
+
 /**
  * @defgroup rotationTransform Rotation and transformation
  *
@@ -504,6 +1673,9 @@ stm32ipl_err_t STM32Ipl_Downscale(const image_t *src, image_t *dst, bool reverse
  */
 stm32ipl_err_t STM32Ipl_Rotation(image_t *img, float rotationX, float rotationY, float rotationZ, float translationX,
 		float translationY, float zoom, float fov, const float *corners);
+stm32ipl_err_t STM32Ipl_RotationCompileMap(uint32_t width, uint32_t height, image_bpp_t format, float rotationX,
+		float rotationY, float rotationZ, float translationX, float translationY, float zoom, float fov,
+		const float *corners, dewarping_algo_t algo, mapxy_compiled_t *compiled);
 stm32ipl_err_t STM32Ipl_Replace(const image_t *src, image_t *dst, bool mirror, bool flip, bool transpose,
 		const image_t *mask);
 stm32ipl_err_t STM32Ipl_Flip(const image_t *src, image_t *dst);
@@ -513,6 +1685,8 @@ stm32ipl_err_t STM32Ipl_Rotation90(const image_t *src, image_t *dst);
 stm32ipl_err_t STM32Ipl_Rotation180(const image_t *src, image_t *dst);
 stm32ipl_err_t STM32Ipl_Rotation270(const image_t *src, image_t *dst);
 stm32ipl_err_t STM32Ipl_LensCorr(image_t *img, float strength, float zoom, float xCorr, float yCorr);
+stm32ipl_err_t STM32Ipl_LensCorrCompileMap(uint32_t width, uint32_t height, image_bpp_t format, float strength,
+		float zoom, float xCorr, float yCorr, dewarping_algo_t algo, mapxy_compiled_t *compiled);
 /** @} */
 
 /**
@@ -520,15 +1694,31 @@ stm32ipl_err_t STM32Ipl_LensCorr(image_t *img, float strength, float zoom, float
  *
  *  @{
  */
+/**
+ * @brief Statistics of a region of interest of a Grayscale image.
+ */
+typedef struct _stm32ipl_roi_stats_t
+{
+	uint32_t sum;	/**< Sum of the pixel values. */
+	float mean;		/**< Mean of the pixel values. */
+	float variance;	/**< Variance of the pixel values. */
+} stm32ipl_roi_stats_t;
+
 stm32ipl_err_t STM32Ipl_HistInit(histogram_t *hist);
 stm32ipl_err_t STM32Ipl_HistAllocData(histogram_t *hist, uint32_t lCount, uint32_t aCount, uint32_t bCount);
 void STM32Ipl_HistReleaseData(histogram_t *hist);
 stm32ipl_err_t STM32Ipl_GetSimilarity(const image_t *img, const image_t *other, stm32ipl_color_t scalar, float *avg,
 		float *std, float *min, float *max);
+stm32ipl_err_t STM32Ipl_GetSimilarityEx(const image_t *img, const image_t *other, stm32ipl_color_t color, float *avg,
+		float *std, float *min, float *max, float *map);
 stm32ipl_err_t STM32Ipl_GetPercentile(const histogram_t *ptr, image_bpp_t bpp, percentile_t *out, float percentile);
 stm32ipl_err_t STM32Ipl_GetThreshold(const histogram_t *ptr, image_bpp_t bpp, threshold_t *out);
 stm32ipl_err_t STM32Ipl_GetHistogram(const image_t *img, histogram_t *out, const rectangle_t *roi);
 stm32ipl_err_t STM32Ipl_GetStatistics(const image_t *img, statistics_t *out, const rectangle_t *roi);
+stm32ipl_err_t STM32Ipl_GetHistogramStatistics(const image_t *img, histogram_t *hist, statistics_t *stats,
+		threshold_t *threshold, const rectangle_t *roi);
+stm32ipl_err_t STM32Ipl_GetRoiStatsBatch(const image_t *img, const rectangle_t *rois, uint32_t n,
+		stm32ipl_roi_stats_t *out);
 stm32ipl_err_t STM32Ipl_GetRegressionImage(const image_t *img, find_lines_list_lnk_data_t *out, const rectangle_t *roi,
 		uint8_t xStride, uint8_t yStride, const list_t *thresholds, bool invert, uint32_t areaThreshold,
 		uint32_t pixelsThreshold, bool robust);
@@ -546,6 +1736,8 @@ stm32ipl_err_t STM32Ipl_CountNonZero(const image_t *img, uint32_t *out, const re
  */
 stm32ipl_err_t STM32Ipl_FindTemplate(const image_t *img, const image_t *template, const rectangle_t *roi,
 		float threshold, uint32_t step, template_match_t searchType, rectangle_t *templateRect, float *correlation);
+stm32ipl_err_t STM32Ipl_FindTemplatePyramid(const stm32ipl_pyramid_t *pyramid, const image_t *template,
+		const rectangle_t *roi, float threshold, uint32_t step, rectangle_t *templateRect, float *correlation);
 /** @} */
 
 /**
@@ -556,8 +1748,49 @@ stm32ipl_err_t STM32Ipl_FindTemplate(const image_t *img, const image_t *template
 stm32ipl_err_t STM32Ipl_GetAffineTransform(const point_t *src, const point_t *dst, float *affine);
 stm32ipl_err_t STM32Ipl_WarpAffine(image_t *img, const float *affine);
 stm32ipl_err_t STM32Ipl_WarpAffinePoints(point_t *points, uint32_t nPoints, const float *affine);
+stm32ipl_err_t STM32Ipl_GetPerspectiveTransform(const point_t *src, const point_t *dst, float *homography);
+stm32ipl_err_t STM32Ipl_WarpPerspective(const image_t *src, image_t *dst, const float *homography,
+		dewarping_algo_t algo);
 /** @} */
 
+///@cond
+/* Line processing functions.
+ * They are for library internals only.
+ * Do not use at application side!
+ */
+typedef struct _ipl_resize_sink_t
+{
+	uint8_t *line;	/* Buffer of one resized line, in the source format. */
+	int format;		/* Format of the source image. */
+	void (*put)(const struct _ipl_resize_sink_t *sink, int y);	/* Processes the resized line y, once computed. */
+	void *arg;		/* Argument of the put function. */
+} ipl_resize_sink_t;
+
+void ipl_convert_line(const uint8_t *src, uint8_t *dst, uint32_t width, int srcFormat, int dstFormat);
+void ipl_gradient_line(const uint8_t **rows, int w, int x0, int x1, int ksize, const int32_t *coef, uint16_t *mag,
+		uint8_t *dir);
+stm32ipl_err_t ipl_resize_lines(const image_t *src, const rectangle_t *roi, uint16_t width, uint16_t height,
+		int algo, const ipl_resize_sink_t *sink);
+void ipl_fit_size(uint32_t srcW, uint32_t srcH, uint32_t maxW, uint32_t maxH, uint32_t *width, uint32_t *height);
+
+/* Source location (1/16 pixel units) of the destination pixel (x, y) of a generated dewarping map; returns false if the
+ * destination pixel has no source location. */
+typedef bool (*ipl_dewarp_map_fct)(void *arg, int x, int y, int32_t *xq, int32_t *yq);
+
+stm32ipl_err_t ipl_dewarp_compile_generated(ipl_dewarp_map_fct fct, void *arg, uint32_t width, uint32_t height,
+		image_bpp_t srcFmt, dewarping_algo_t algo, mapxy_compiled_t *compiled);
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+/* Hardware (DMA2D) pixel operations; they return stm32ipl_err_NotImplemented when the
+ * hardware cannot execute the operation, so that the caller falls back to the software one.
+ */
+stm32ipl_err_t ipl_hw_convert(const image_t *src, image_t *dst, bool wait);
+stm32ipl_err_t ipl_hw_fill(image_t *img, const rectangle_t *roi, uint32_t value, bool wait);
+stm32ipl_err_t ipl_hw_copy(const image_t *src, const rectangle_t *roi, image_t *dst, bool wait);
+stm32ipl_err_t ipl_hw_blend(image_t *imgA, const image_t *imgB, uint8_t alpha, bool wait);
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+///@endcond
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,11 +42,18 @@
 #define STM32IPL_EXT_BUFFER_SIZE			(1024 * 2000)	/* Size of the external memory buffer reserved to STM32IPL. */
 #define STM32IPL_INT_BUFFER_SIZE			(1024 * 470)	/* Size of the internal memory buffer reserved to STM32IPL. */
 #define STM32IPL_ENABLE_HW_SCREEN_DRAWING 	/* Enable hardware accelerated image drawing; comment to disable. */
+#define STM32IPL_ENABLE_HW_PIXEL_OPS		/* Enable the DMA2D offload of conversions, fills, copies and blending; comment to disable. */
+//#define STM32IPL_ENABLE_HW_JPEG_CODEC		/* Use the JPEG codec peripheral (with MDMA) instead of LibJPEG to read/write JPEG files; uncomment to enable. */
+//#define STM32IPL_ENABLE_DUAL_CORE			/* Split the rows of some operations between the Cortex-M7 and the Cortex-M4 (STM32Ipl_DualCoreRun()); uncomment to enable on both cores. */
+//#define STM32IPL_DUAL_CORE_SHARED_ADDR	0x38000000	/* Address of the job descriptor shared by the two cores (SRAM4, not used by the applications). */
+//#define STM32IPL_DUAL_CORE_HSEM_ID		10			/* Hardware semaphore used to notify the jobs to the Cortex-M4. */
+//#define STM32IPL_DUAL_CORE_M4_SHARE		33			/* Percentage of the rows processed by the Cortex-M4. */
 #endif /* USE_STM32H747I_DISCO */
 
 /* General settings. */
 #define STM32IPL_JPEG_QUALITY				90	/* The quality used to encode JPEG images. */
 #define STM32IPL_JPEG_SUBSAMPLING			STM32IPL_JPEG_422_SUBSAMPLING	/* The chroma subsampling used to encode JPEG images. */
+#define STM32IPL_FILE_BUFFER_SIZE			4096	/* Size (bytes) of the buffer used to read/write BMP and PNM files in chunks of lines. */
 
 /* Library modules enablers. */
 #define STM32IPL_ENABLE_IMAGE_IO				/* Enable image IO functions; comment to disable. */
@@ -54,5 +61,15 @@
 #define STM32IPL_ENABLE_OBJECT_DETECTION		/* Enable object detection; comment to disable. */
 #define STM32IPL_ENABLE_FRONTAL_FACE_CASCADE	/* Use frontal face cascade; comment to do not use. */
 #define STM32IPL_ENABLE_EYE_CASCADE				/* Use eye cascade; comment to do not use. */
+//#define STM32IPL_ENABLE_MEM_STATS				/* Enable memory usage statistics (debug only, it slows down allocations); uncomment to enable. */
+//#define STM32IPL_ENABLE_BENCHMARK				/* Enable the benchmark of the library functions (STM32Ipl_Benchmark()); uncomment to enable. */
+//#define STM32IPL_ENABLE_TRACE					/* Enable the tracing hooks around the library functions; uncomment to enable. */
+//#define STM32IPL_TRACE_BACKEND			STM32IPL_TRACE_RING	/* Trace backend: STM32IPL_TRACE_RING, STM32IPL_TRACE_ITM or STM32IPL_TRACE_SYSVIEW. */
+//#define STM32IPL_TRACE_RING_SIZE			256	/* Number of events kept by the trace ring buffer (power of 2). */
+//#define STM32IPL_TRACE_ITM_PORT			1	/* ITM stimulus port used by the ITM trace backend. */
+//#define STM32IPL_ENABLE_PERF_COUNTERS		/* Enable the performance counters of the library functions (calls, cycles, allocations, MVE/scalar paths); uncomment to enable. */
+//#define STM32IPL_CTX_THREAD_LOCAL		_Thread_local	/* Keep the current library context per thread (STM32Ipl_SetCtx()); uncomment if the toolchain and the RTOS support thread-local storage. */
+//#define STM32IPL_ENABLE_ROW_PREFETCH			/* Enable the prefetch of the source lines through STM32Ipl_BlockCopyStart() (DMA-backed); uncomment to enable. */
+//#define STM32IPL_ENABLE_MVE_DETECTION		/* Select the MVE implementations dispatched at run time only if the core supports MVE (MVFR1 register); uncomment to enable. */
 
 #endif /* __STM32IPL_CONF_H_ */
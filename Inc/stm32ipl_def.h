@@ -23,4 +23,8 @@
 #define STM32IPL_JPEG_420_SUBSAMPLING	1   /* 4:2:0 chroma subsampling. */
 #define STM32IPL_JPEG_422_SUBSAMPLING	2   /* 4:2:2 chroma subsampling. */
 
+#define STM32IPL_TRACE_RING				1	/* Trace events are stored in a ring buffer with cycle timestamps. */
+#define STM32IPL_TRACE_ITM				2	/* Trace events are written to an ITM stimulus port. */
+#define STM32IPL_TRACE_SYSVIEW			3	/* Trace events are sent to SEGGER SystemView. */
+
 #endif /* __STM32IPL_DEF_H_ */
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_image_io_jpg_hw.h
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - JPEG HW codec header file
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __STM32IPL_IMAGE_IO_JPG_HW_H_
+#define __STM32IPL_IMAGE_IO_JPG_HW_H_
+
+///@cond
+
+#include "stm32ipl.h"
+
+#ifdef STM32IPL_ENABLE_IMAGE_IO
+#ifdef STM32IPL_ENABLE_JPEG
+#ifdef STM32IPL_ENABLE_HW_JPEG_CODEC
+
+#include "stm32ipl_image_io_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+stm32ipl_err_t readJPEGHW(image_t *img, ipl_stream_t *stream);
+stm32ipl_err_t saveJPEGHW(const image_t *img, ipl_stream_t *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_HW_JPEG_CODEC */
+#endif /* STM32IPL_ENABLE_JPEG */
+#endif /* STM32IPL_ENABLE_IMAGE_IO */
+
+///@endcond
+
+#endif /* __STM32IPL_IMAGE_IO_JPG_HW_H_ */
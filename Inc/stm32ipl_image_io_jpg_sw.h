@@ -27,14 +27,15 @@
 #ifdef STM32IPL_ENABLE_JPEG
 #ifndef STM32IPL_ENABLE_HW_JPEG_CODEC
 
-#include "ff.h"
+#include "stm32ipl_image_io_stream.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-stm32ipl_err_t readJPEGSW(image_t *img, FIL *fp);
-stm32ipl_err_t saveJPEGSW(const image_t *img, const char *filename);
+stm32ipl_err_t readJPEGSW(image_t *img, ipl_stream_t *stream);
+stm32ipl_err_t readJPEGSWScaled(image_t *img, ipl_stream_t *stream, uint32_t maxW, uint32_t maxH, image_bpp_t format);
+stm32ipl_err_t saveJPEGSW(const image_t *img, ipl_stream_t *stream);
 
 #ifdef __cplusplus
 }
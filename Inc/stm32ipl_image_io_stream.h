@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_image_io_stream.h
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - image read/write stream header file
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __STM32IPL_IMAGE_IO_STREAM_H_
+#define __STM32IPL_IMAGE_IO_STREAM_H_
+
+///@cond
+
+#include "stm32ipl.h"
+
+#ifdef STM32IPL_ENABLE_IMAGE_IO
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Source or destination of the image readers and writers; a stream is either a FatFs file or a memory buffer. */
+typedef struct _ipl_stream_t ipl_stream_t;
+
+struct _ipl_stream_t
+{
+	bool (*read)(ipl_stream_t *stream, void *data, uint32_t size, uint32_t *count);	/* Reads up to size bytes. */
+	bool (*write)(ipl_stream_t *stream, const void *data, uint32_t size, uint32_t *count);	/* Writes size bytes. */
+	bool (*seek)(ipl_stream_t *stream, uint32_t offset);	/* Moves to the given absolute position. */
+	FIL *fp;			/* File (file stream). */
+	uint8_t *data;		/* Memory (memory stream). */
+	uint32_t size;		/* Number of valid bytes (memory stream); when writing, it may exceed the capacity. */
+	uint32_t capacity;	/* Size of the memory (memory stream). */
+	uint32_t pos;		/* Current position (memory stream). */
+};
+
+void ipl_stream_init_file(ipl_stream_t *stream, FIL *fp);
+void ipl_stream_init_memory(ipl_stream_t *stream, uint8_t *data, uint32_t size, uint32_t capacity);
+
+/* Reads up to size bytes from the stream; count is the number of bytes actually read. */
+static inline bool ipl_stream_read(ipl_stream_t *stream, void *data, uint32_t size, uint32_t *count)
+{
+	return stream->read(stream, data, size, count);
+}
+
+/* Writes size bytes to the stream; count is the number of bytes actually written. */
+static inline bool ipl_stream_write(ipl_stream_t *stream, const void *data, uint32_t size, uint32_t *count)
+{
+	return stream->write(stream, data, size, count);
+}
+
+/* Moves the current position of the stream to the given offset. */
+static inline bool ipl_stream_seek(ipl_stream_t *stream, uint32_t offset)
+{
+	return stream->seek(stream, offset);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_IMAGE_IO */
+
+///@endcond
+
+#endif /* __STM32IPL_IMAGE_IO_STREAM_H_ */
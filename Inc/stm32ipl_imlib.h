@@ -76,6 +76,18 @@
 #define IPL_MATOP_DISABLE_MVE
 #define IPL_FILTER_DISABLE_MVE
 #define IPL_DRAW_DISABLE_MVE
+#define IPL_CONVERT_DISABLE_MVE
+#define IPL_STATS_DISABLE_MVE
+#define IPL_HAAR_DISABLE_MVE
+#define IPL_DEWARP_DISABLE_MVE
+#define IPL_ROTATION_DISABLE_MVE
+#define IPL_FMATH_DISABLE_MVE
+#define IPL_INTEGRAL_DISABLE_MVE
+#define IPL_BGMODEL_DISABLE_MVE
+#define IPL_KEYPOINTS_DISABLE_MVE
+#define IPL_FEATURES_DISABLE_MVE
+#define IPL_FLOW_DISABLE_MVE
+#define IPL_POOL_DISABLE_MVE
 #endif
 
 #ifdef ARM_MATH_MVE_FLOAT16
@@ -99,8 +111,47 @@
 	#ifndef IPL_DRAW_DISABLE_MVE
 	#define IPL_DRAW_HAS_MVE
 	#endif
+	#ifndef IPL_CONVERT_DISABLE_MVE
+	#define IPL_CONVERT_HAS_MVE
+	#endif
+	#ifndef IPL_STATS_DISABLE_MVE
+	#define IPL_STATS_HAS_MVE
+	#endif
+	#ifndef IPL_HAAR_DISABLE_MVE
+	#define IPL_HAAR_HAS_MVE
+	#endif
+	#ifndef IPL_ROTATION_DISABLE_MVE
+	#define IPL_ROTATION_HAS_MVE
+	#endif
+	#ifndef IPL_INTEGRAL_DISABLE_MVE
+	#define IPL_INTEGRAL_HAS_MVE
+	#endif
+	#ifndef IPL_BGMODEL_DISABLE_MVE
+	#define IPL_BGMODEL_HAS_MVE
+	#endif
+	#ifndef IPL_KEYPOINTS_DISABLE_MVE
+	#define IPL_KEYPOINTS_HAS_MVE
+	#endif
+	#ifndef IPL_FEATURES_DISABLE_MVE
+	#define IPL_FEATURES_HAS_MVE
+	#endif
+	#ifndef IPL_FLOW_DISABLE_MVE
+	#define IPL_FLOW_HAS_MVE
+	#endif
+	#ifndef IPL_POOL_DISABLE_MVE
+	#define IPL_POOL_HAS_MVE
+	#endif
 #endif /* ARM_MATH_MVEI */
 
+#ifdef ARM_MATH_MVEF
+	#ifndef IPL_DEWARP_DISABLE_MVE
+	#define IPL_DEWARP_HAS_MVE
+	#endif
+	#ifndef IPL_FMATH_DISABLE_MVE
+	#define IPL_FMATH_HAS_MVE
+	#endif
+#endif /* ARM_MATH_MVEF */
+
 // STM32IPL
 /**
  * @brief Structure used to access single channels of RGB888 images.
@@ -208,6 +259,23 @@ typedef struct color_thresholds_list_lnk_data
     ((threshold)->BMin <= _b) && (_b <= (threshold)->BMax)) ^ invert; \
 })
 
+// STM32IPL: thresholds the L, A, B values of a pixel.
+#define COLOR_THRESHOLD_LAB(l, a, b, threshold, invert) \
+({ \
+    (((threshold)->LMin <= (l)) && ((l) <= (threshold)->LMax) && \
+    ((threshold)->AMin <= (a)) && ((a) <= (threshold)->AMax) && \
+    ((threshold)->BMin <= (b)) && ((b) <= (threshold)->BMax)) ^ invert; \
+})
+
+// STM32IPL: compiled thresholds (stm32ipl_color_lut_t), made of membership bitmaps indexed by the RGB565 value;
+// tests the bit of the pixel in the bitmap.
+#define COLOR_LUT_WORDS (65536 / UINT32_T_BITS)
+
+#define COLOR_THRESHOLD_LUT(pixel, bits) \
+({ \
+    (((bits)[(pixel) >> UINT32_T_SHIFT] >> ((pixel) & UINT32_T_MASK)) & 1); \
+})
+
 #define COLOR_BOUND_BINARY(pixel0, pixel1, threshold) \
 ({ \
     (abs(pixel0 - pixel1) <= (threshold)); \
@@ -337,6 +405,21 @@ typedef struct color_thresholds_list_lnk_data
 
 extern const int8_t lab_table[196608 / 2];
 
+// STM32IPL: tables and weights (Q15) of the fixed point LAB conversion used by the row conversion functions;
+// the weights of each row of the RGB to XYZ matrix are normalized by the white point.
+extern const uint16_t xyz_lin_table[256];
+extern const uint16_t lab_f_table[1026];
+
+#define IMLIB_LAB_W_XR 14218
+#define IMLIB_LAB_W_XG 12328
+#define IMLIB_LAB_W_XB 6223
+#define IMLIB_LAB_W_YR 6966
+#define IMLIB_LAB_W_YG 23436
+#define IMLIB_LAB_W_YB 2366
+#define IMLIB_LAB_W_ZR 581
+#define IMLIB_LAB_W_ZG 3587
+#define IMLIB_LAB_W_ZB 28605
+
 #ifdef IMLIB_ENABLE_LAB_LUT
 #define COLOR_RGB565_TO_L(pixel) lab_table[((pixel>>1) * 3) + 0]
 #define COLOR_RGB565_TO_A(pixel) lab_table[((pixel>>1) * 3) + 1]
@@ -431,11 +514,19 @@ typedef enum image_bpp
 	IMAGE_BPP_BINARY,       /* BPP = 0 */			/**< Binary image. Each pixel can assume 0-1 values. Image lines are padded with zeros and aligned to 32 bits. */
 	IMAGE_BPP_GRAYSCALE,    /* BPP = 1 */			/**< Grayscale image. Each pixel can assume values in the range [0, 255]. */
 	IMAGE_BPP_RGB565,       /* BPP = 2 */			/**< Color image. Each pixel is represented with 16 bits; R and B channels are described with 5 bits, G with 6 bits. */
-	IMAGE_BPP_BAYER,        /* BPP = 3 */			/**< Not used by STM32IPL. */
+	IMAGE_BPP_BAYER,        /* BPP = 3 */			/**< Raw Bayer image with BGGR pattern (first line B G B G..., second line G R G R...). Each pixel is represented with 8 bits. */
 	IMAGE_BPP_RGB888,       /* BPP = 4 STM32IPL */	/**< Color image. Each pixel is represented with 24 bits, 8 bits for each EGB channel. */
-	IMAGE_BPP_JPEG          /* BPP > 4 */			/**< Not used by STM32IPL. */
+	IMAGE_BPP_JPEG,         /* BPP = 5 */			/**< Not used by STM32IPL. */
+	IMAGE_BPP_YUV422,       /* STM32IPL */			/**< Color image in YUYV order. Each couple of pixels is represented with 32 bits: Y0, U, Y1, V (8 bits each); U and V are shared by the two pixels. */
+	IMAGE_BPP_NV12,         /* STM32IPL */			/**< Color image with two planes: the Y plane (8 bits per pixel) followed by the interleaved U, V plane, subsampled by 2 in both directions. */
+	IMAGE_BPP_BAYER_GBRG,   /* STM32IPL */			/**< Raw Bayer image with GBRG pattern (first line G B G B..., second line R G R G...). Each pixel is represented with 8 bits. */
+	IMAGE_BPP_BAYER_GRBG,   /* STM32IPL */			/**< Raw Bayer image with GRBG pattern (first line G R G R..., second line B G B G...). Each pixel is represented with 8 bits. */
+	IMAGE_BPP_BAYER_RGGB,   /* STM32IPL */			/**< Raw Bayer image with RGGB pattern (first line R G R G..., second line G B G B...). Each pixel is represented with 8 bits. */
 } image_bpp_t;
 
+// STM32IPL
+#define IMAGE_BPP_BAYER_BGGR IMAGE_BPP_BAYER
+
 /**
  * @brief Represents the image in terms of its width, height, format, pointer to the pixels data.
  */
@@ -449,6 +540,7 @@ typedef struct image
 		uint8_t *pixels;	/**< Pointer to the pixels data. */
 		uint8_t *data;		/**< Pointer to the pixels data. */
 	};
+	int stride;	/**< Distance between the beginning of two consecutive lines (bytes); 0 means lines are tightly packed. */
 } image_t;
 
 ///@cond
@@ -465,84 +557,101 @@ typedef struct image
 #define IMAGE_RGB888_LINE_LEN(image) ((image)->w)
 #define IMAGE_RGB888_LINE_LEN_BYTES(image) (IMAGE_RGB888_LINE_LEN(image) * sizeof(rgb888_t))
 
+// STM32IPL: distance (bytes) between two consecutive lines; it differs from the line length for views.
+#define IMAGE_BINARY_LINE_STRIDE_BYTES(image) \
+    ((image)->stride ? (size_t)(image)->stride : IMAGE_BINARY_LINE_LEN_BYTES(image))
+
+#define IMAGE_GRAYSCALE_LINE_STRIDE_BYTES(image) \
+    ((image)->stride ? (size_t)(image)->stride : IMAGE_GRAYSCALE_LINE_LEN_BYTES(image))
+
+#define IMAGE_RGB565_LINE_STRIDE_BYTES(image) \
+    ((image)->stride ? (size_t)(image)->stride : IMAGE_RGB565_LINE_LEN_BYTES(image))
+
+#define IMAGE_RGB888_LINE_STRIDE_BYTES(image) \
+    ((image)->stride ? (size_t)(image)->stride : IMAGE_RGB888_LINE_LEN_BYTES(image))
+
+// STM32IPL: true when the lines of the image are not tightly packed (i.e. the image is a view).
+#define IMAGE_IS_STRIDED(image) \
+    ((image)->stride != 0)
+
 #define IMAGE_GET_BINARY_PIXEL_ADDR(image, x, y) \
 ({ \
-    (((uint32_t *)(image)->data) + ((((image)->w + (uint32_t)UINT32_T_MASK) >> (uint32_t)UINT32_T_SHIFT) * (y) + ((x) >> (uint32_t)UINT32_T_SHIFT))); \
+    (IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y) + ((x) >> (uint32_t)UINT32_T_SHIFT)); \
 })
 
 #define IMAGE_GET_BINARY_PIXEL(image, x, y) \
 ({ \
-    (((uint32_t *)(image)->data)[((((image)->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * (y)) + ((x) >> UINT32_T_SHIFT)] >> ((x) & UINT32_T_MASK)) & 1; \
+    (IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y)[(x) >> UINT32_T_SHIFT] >> ((x) & UINT32_T_MASK)) & 1; \
 })
 
 #define IMAGE_PUT_BINARY_PIXEL(image, x, y, v) \
 ({ \
-    size_t _i = ((((image)->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * (y)) + ((x) >> UINT32_T_SHIFT); \
+    uint32_t *_p = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y) + ((x) >> UINT32_T_SHIFT); \
     size_t _j = (x) & UINT32_T_MASK; \
-    ((uint32_t *)(image)->data)[_i] = (((uint32_t *)(image)->data)[_i] & (~(1 << _j))) | (((v) & 1) << _j); \
+    *_p = (*_p & (~(1 << _j))) | (((v) & 1) << _j); \
 })
 
 #define IMAGE_CLEAR_BINARY_PIXEL(image, x, y) \
 ({ \
-    ((uint32_t *)(image)->data)[((((image)->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * (y)) + ((x) >> UINT32_T_SHIFT)] &= ~(1 << ((x) & UINT32_T_MASK)); \
+    IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y)[(x) >> UINT32_T_SHIFT] &= ~(1 << ((x) & UINT32_T_MASK)); \
 })
 
 #define IMAGE_SET_BINARY_PIXEL(image, x, y) \
 ({ \
-    ((uint32_t *)(image)->data)[((((image)->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * (y)) + ((x) >> UINT32_T_SHIFT)] |= 1 << ((x) & UINT32_T_MASK); \
+    IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y)[(x) >> UINT32_T_SHIFT] |= 1 << ((x) & UINT32_T_MASK); \
 })
 
 #define IMAGE_GET_GRAYSCALE_PIXEL_ADDR(image, x, y) \
 ({ \
-    (((uint8_t *)(image)->data) + ((image)->w * (y) + (x))); \
+    (IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(image, y) + (x)); \
 })
 
 #define IMAGE_GET_GRAYSCALE_PIXEL(image, x, y) \
 ({ \
-    ((uint8_t *)(image)->data)[((image)->w * (y)) + (x)]; \
+    IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(image, y)[(x)]; \
 })
 
 #define IMAGE_PUT_GRAYSCALE_PIXEL(image, x, y, v) \
 ({ \
-    ((uint8_t *)(image)->data)[((image)->w * (y)) + (x)] = (v); \
+    IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(image, y)[(x)] = (v); \
 })
 
 #define IMAGE_GET_RGB565_PIXEL_ADDR(image, x, y) \
 ({ \
-    (((uint16_t *)(image)->data) + ((image)->w * (y) + (x))); \
+    (IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(image, y) + (x)); \
 })
 
 #define IMAGE_GET_RGB565_PIXEL(image, x, y) \
 ({ \
-    ((uint16_t *)(image)->data)[((image)->w * (y)) + (x)]; \
+    IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(image, y)[(x)]; \
 })
 
 #define IMAGE_PUT_RGB565_PIXEL(image, x, y, v) \
 ({ \
-    ((uint16_t *)(image)->data)[((image)->w * (y)) + (x)] = (v); \
+    IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(image, y)[(x)] = (v); \
 })
 
 // STM32IPL
 #define IMAGE_PUT_RGB888_PIXEL(image, x, y, v) \
 ({ \
-    ((rgb888_t *)(image)->data)[((image)->w * (y)) + (x)] = (v); \
+    IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(image, y)[(x)] = (v); \
 })
 
 // STM32IPL
 #define IMAGE_GET_RGB888_PIXEL_ADDR(image, x, y) \
 ({ \
-	(((rgb888_t *)(image)->data) + ((image)->w * (y) + (x))); \
+	(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(image, y) + (x)); \
 })
 
 #define IMAGE_GET_RGB888_PIXEL(image, x, y) \
 ({ \
-	((rgb888_t *)(image)->data)[((image)->w * (y)) + (x)]; \
+	IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(image, y)[(x)]; \
 })
 
 // Fast Stuff //
 #define IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(image, y) \
 ({ \
-   ((uint32_t*)((image)->data)) + ((((image)->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * (y)); \
+   (uint32_t *)(((uint8_t *)(image)->data) + (IMAGE_BINARY_LINE_STRIDE_BYTES(image) * (y))); \
 })
 
 #define IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x) \
@@ -569,7 +678,7 @@ typedef struct image
 
 #define IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(image, y) \
 ({ \
-    ((uint8_t *)(image)->data) + ((image)->w * (y)); \
+    ((uint8_t *)(image)->data) + (IMAGE_GRAYSCALE_LINE_STRIDE_BYTES(image) * (y)); \
 })
 
 #define IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x) \
@@ -584,7 +693,7 @@ typedef struct image
 
 #define IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(image, y) \
 ({ \
-    ((uint16_t *)(image)->data) + ((image)->w * (y)); \
+    (uint16_t *)(((uint8_t *)(image)->data) + (IMAGE_RGB565_LINE_STRIDE_BYTES(image) * (y))); \
 })
 
 #define IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x) \
@@ -600,7 +709,7 @@ typedef struct image
 // STM32IPL
 #define IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(image, y) \
 ({ \
-    ((rgb888_t*)((image)->data)) + ((image)->w * (y)); \
+    (rgb888_t *)(((uint8_t *)(image)->data) + (IMAGE_RGB888_LINE_STRIDE_BYTES(image) * (y))); \
 })
 
 // STM32IPL
@@ -618,13 +727,13 @@ typedef struct image
 // Old Image Macros - Will be refactor and removed. But, only after making sure through testing new macros work.
 
 #define IM_RGB5652L(p) \
-    ({lab_table[(((p) >> 1) * 3) + 0];})
+    ({COLOR_RGB565_TO_L(p);}) // STM32IPL
 
 #define IM_RGB5652A(p) \
-    ({lab_table[(((p) >> 1) * 3) + 1];})
+    ({COLOR_RGB565_TO_A(p);}) // STM32IPL
 
 #define IM_RGB5652B(p) \
-    ({lab_table[(((p) >> 1) * 3) + 2];})
+    ({COLOR_RGB565_TO_B(p);}) // STM32IPL
 
 // Grayscale maxes
 #define IM_MAX_GS (255)
@@ -658,8 +767,9 @@ typedef struct image
 #define IM_IS_BAYER(img) \
     ({img->bpp == IMAGE_BPP_BAYER;})
 
+// STM32IPL: the formats following IMAGE_BPP_JPEG are not JPEG.
 #define IM_IS_JPEG(img) \
-    ({img->bpp >= IMAGE_BPP_JPEG;})
+    ({img->bpp == IMAGE_BPP_JPEG;})
 
 #define IM_IS_MUTABLE(img) \
     ({(img->bpp == IMAGE_BPP_GRAYSCALE || img->bpp == IMAGE_BPP_RGB565);})
@@ -671,43 +781,43 @@ typedef struct image
     ({(0 <= (y)) && ((y) < img->h);})
 
 #define IM_GET_GS_PIXEL(img, x, y) \
-    ({((uint8_t*)img->pixels)[((y) * img->w) + (x)];})
+    ({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y)[(x)];})
 
 #define IM_GET_RAW_PIXEL(img, x, y) \
-    ({((uint8_t*)img->pixels)[((y) * img->w) + (x)];})
+    ({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y)[(x)];})
 
 #define IM_GET_RAW_PIXEL_CHECK_BOUNDS_X(img, x, y) \
-    ({((uint8_t*)img->pixels)[((y) * img->w) + (((x) < 0) ? 0 : ((x) >= img->w) ? (img->w - 1) : (x))];})
+    ({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y)[(((x) < 0) ? 0 : ((x) >= img->w) ? (img->w - 1) : (x))];})
 
 #define IM_GET_RAW_PIXEL_CHECK_BOUNDS_Y(img, x, y) \
-    ({((uint8_t*)img->pixels)[((((y) < 0) ? 0 : ((y) >= img->h) ? (img->h - 1) : (y)) * img->w) + (x)];})
+    ({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (((y) < 0) ? 0 : ((y) >= img->h) ? (img->h - 1) : (y)))[(x)];})
 
 #define IM_GET_RAW_PIXEL_CHECK_BOUNDS_XY(img, x, y)	\
-	({((uint8_t*)img->pixels)[(((y) < 0) ? 0 : (((y) >= img->h) ? (img->h - 1) : ((y) * img->w))) + \
-							  (((x) < 0) ? 0 : (((x) >= img->w) ? (img->w - 1) : (x)))];})
+	({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (((y) < 0) ? 0 : (((y) >= img->h) ? (img->h - 1) : (y)))) \
+							  [(((x) < 0) ? 0 : (((x) >= img->w) ? (img->w - 1) : (x)))];})
 
 #define IM_GET_RGB565_PIXEL(img, x, y) \
-    ({((uint16_t*)img->pixels)[((y) * img->w) + (x)];})
+    ({IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y)[(x)];})
 
 #define IM_GET_RGB888_PIXEL(img, x, y) \
-    ({((rgb888_t*)img->pixels)[((y) * img->w) + (x)];})
+    ({IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y)[(x)];})
 
 #define IM_SET_GS_PIXEL(img, x, y, p) \
-    ({((uint8_t*)img->pixels)[((y) * img->w) + (x)] = (p);})
+    ({IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y)[(x)] = (p);})
 
 #define IM_SET_RGB565_PIXEL(img, x, y, p) \
-    ({((uint16_t*)img->pixels)[((y) * img->w) + (x)] = (p);})
+    ({IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y)[(x)] = (p);})
 
 #define IM_SET_RGB888_PIXEL(img, x, y, p) \
-    ({((rgb888_t*)img->pixels)[((y) * img->w) + (x)] = (p);})
+    ({IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y)[(x)] = (p);})
 
 #define IM_EQUAL(img0, img1) \
     ({(img0->w==img1->w)&&(img0->h==img1->h)&&(img0->bpp==img1->bpp);})
 
 #define IM_TO_GS_PIXEL(img, x, y)    \
-    ( img->bpp == IMAGE_BPP_GRAYSCALE ? img->pixels[((y)*img->w)+(x)] : \
-    img->bpp == IMAGE_BPP_RGB565 ? COLOR_RGB565_TO_Y(((uint16_t*)img->pixels)[((y)*img->w)+(x)]) : \
-    COLOR_RGB888_TO_Y( ((uint8_t*)img->pixels)[(3 * ((y) * img->w + x)) + 2], ((uint8_t*)img->pixels)[ (3 * ((y) * img->w + x)) + 1], ((uint8_t*)img->pixels)[ (3 * ((y) * img->w + x))]))
+    ( img->bpp == IMAGE_BPP_GRAYSCALE ? IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y)[(x)] : \
+    img->bpp == IMAGE_BPP_RGB565 ? COLOR_RGB565_TO_Y(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y)[(x)]) : \
+    COLOR_RGB888_TO_Y(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y)[(x)].r, IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y)[(x)].g, IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y)[(x)].b))
 ///@endcond
 
 /**
@@ -720,6 +830,17 @@ typedef struct integral_image
 	uint32_t *data;	/**< Data.*/
 } i_image_t;
 
+/**
+ * @brief Structure describing an integral image with 64-bit values, used for the squared integral image
+ * of large images.
+ */
+typedef struct integral_image64
+{
+	int w;			/**< Width.*/
+	int h;			/**< Height*/
+	uint64_t *data;	/**< Data.*/
+} i64_image_t;
+
 /**
  * @brief Structure describing an integral image using a moving window.
  */
@@ -776,6 +897,7 @@ typedef enum template_match
 {
 	SEARCH_EX, /**< Exhaustive search. */
 	SEARCH_DS, /**< Diamond search. */
+	SEARCH_PYR, /**< Coarse-to-fine pyramid search. */ // STM32IPL
 } template_match_t;
 
 /**
@@ -904,6 +1026,40 @@ typedef struct find_circles_list_lnk_data
 	uint16_t magnitude;	/**< Sum of all Sobel filter magnitudes of pixels that make up that circle. */
 } find_circles_list_lnk_data_t;
 
+/**
+ * @brief AprilTag families (they can be combined with the OR operator).
+ */
+typedef enum apriltag_families
+{
+	TAG16H5 = 1,	/**< TAG16H5 family. */
+	TAG25H7 = 2,	/**< TAG25H7 family. */
+	TAG25H9 = 4,	/**< TAG25H9 family. */
+	TAG36H10 = 8,	/**< TAG36H10 family. */
+	TAG36H11 = 16,	/**< TAG36H11 family. */
+	ARTOOLKIT = 32	/**< ARTOOLKIT family. */
+} apriltag_families_t;
+
+/**
+ * @brief AprilTag representation.
+ */
+typedef struct find_apriltags_list_lnk_data
+{
+	point_t corners[4];		/**< Corners of the tag (top-left, top-right, bottom-right, bottom-left). */
+	rectangle_t rect;		/**< Bounding box of the tag. */
+	uint16_t id;			/**< Numeric identifier of the tag within its family. */
+	uint8_t family;			/**< Family of the tag (apriltag_families_t). */
+	uint8_t hamming;		/**< Number of error bits corrected while decoding the tag. */
+	point_t centroid;		/**< Center of the tag. */
+	float goodness;			/**< Quality of the tag image, in [0, 1] (always 0, pose refinement is not enabled). */
+	float decision_margin;	/**< Quality of the color match, in [0, 1]; the higher the better. */
+	float x_translation;	/**< X translation of the tag from the camera (unit depends on the camera parameters). */
+	float y_translation;	/**< Y translation of the tag from the camera (unit depends on the camera parameters). */
+	float z_translation;	/**< Z translation of the tag from the camera (unit depends on the camera parameters). */
+	float x_rotation;		/**< Rotation of the tag around the X axis (radians). */
+	float y_rotation;		/**< Rotation of the tag around the Y axis (radians). */
+	float z_rotation;		/**< Rotation of the tag around the Z axis (radians). */
+} find_apriltags_list_lnk_data_t;
+
 /**
  * @brief Dewarping interpolation algorithm
  */
@@ -921,8 +1077,28 @@ typedef enum
 	MAPXY_DENSE_FLOAT,				/**< mapxy dense float array. */
 	MAPXY_DENSE_FIXED_POINT_12_4,	/**< mapxy dense 12.4 fixed point array. */
 	MAPXY_SPARSE_FLOAT,				/**< mapxy sparse format. */
+	MAPXY_COMPILED,					/**< mapxy precompiled with STM32Ipl_DewarpCompileMap(). */
 } mapxy_type_t;
 
+/**
+ * @brief Dewarping compiled mapxy (see STM32Ipl_DewarpCompileMap())
+ */
+typedef struct
+{
+	uint16_t w;						/**< Width of the images. */
+	uint16_t h;						/**< Height of the images. */
+	image_bpp_t bpp;				/**< Format of the source image. */
+	dewarping_algo_t algo;			/**< Interpolation algorithm. */
+	uint32_t *offset;				/**< An array of h * w byte offsets of the source pixels (top-left pixel of the 2x2 neighborhood with DEWARP_BILINEAR); MAPXY_COMPILED_SKIP for the pixels not covered by a sparse map. */
+	uint8_t *weight;				/**< An array of h * w bilinear weights: x fraction in the low nibble, y fraction in the high nibble (1/16 units). NULL with DEWARP_NEAREST. */
+	uint16_t blockW;				/**< Width of the destination blocks (see STM32Ipl_DewarpCompileMapTiled()); 0 if the map is not tiled. */
+	uint16_t blockH;				/**< Height of the destination blocks; 0 if the map is not tiled. */
+	rectangle_t *blockSrc;			/**< An array of source boxes, one per block in raster order; the offsets of each block are relative to its box (stride is the box width). NULL if the map is not tiled. */
+	uint32_t blockSize;				/**< Size (bytes) of the largest source box. */
+} mapxy_compiled_t;
+
+#define MAPXY_COMPILED_SKIP	UINT32_MAX	/**< Offset of the pixels left unchanged. */
+
 /**
  * @brief Dewarping mapxy information
  */
@@ -937,6 +1113,7 @@ typedef struct
 			const float *uv;		/**<  An array of vertices (u, v values) float values */
 			const int *tri_idx;		/**<  An array of triangle vertice index (a, b,c corner index amoung vertices). Use sentinel value (-1, -1, -1) as end of array */
 		} sparse_float;				/**< Used when type has value MAPXY_SPARSE_FLOAT. */
+		const mapxy_compiled_t *compiled; /**< A compiled map. Used when type has value MAPXY_COMPILED. */
 	};
 } mapxy_t;
 
@@ -952,6 +1129,9 @@ rgb888_t imlib_lab_to_rgb888(uint8_t l, int8_t a, int8_t b); // STM32IPL
 uint16_t imlib_lab_to_rgb(uint8_t l, int8_t a, int8_t b);
 uint16_t imlib_yuv_to_rgb(uint8_t y, int8_t u, int8_t v);
 rgb888_t imlib_yuv_to_rgb888(uint8_t y, int8_t u, int8_t v); // STM32IPL
+void imlib_rgb565_to_lab_row(const uint16_t *src, int n, int8_t *l, int8_t *a, int8_t *b); // STM32IPL
+void imlib_rgb888_to_lab_row(const rgb888_t *src, int n, int8_t *l, int8_t *a, int8_t *b); // STM32IPL
+void imlib_image_to_lab_row(image_t *img, int x, int y, int n, uint16_t *tmp, int8_t *l, int8_t *a, int8_t *b); // STM32IPL
 ///@endcond
 
 #endif //__STM32IPL_IMLIB_EXT_H__
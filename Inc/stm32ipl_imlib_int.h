@@ -65,7 +65,22 @@ extern const uint16_t ironbow_table[256];
 void image_init(image_t *ptr, int w, int h, int bpp, void *data);
 void image_copy(image_t *dst, image_t *src);
 size_t image_size(image_t *ptr);
+size_t image_line_size(image_t *ptr); // STM32IPL
+size_t image_line_stride(image_t *ptr); // STM32IPL
+void image_copy_data(image_t *dst, image_t *src); // STM32IPL
 bool image_get_mask_pixel(image_t *ptr, int x, int y);
+uint32_t image_get_mask_word(image_t *ptr, int x, int y); // STM32IPL
+int image_mask_span(image_t *ptr, int *x, int y, int w, bool invert); // STM32IPL
+
+// STM32IPL: same as image_get_mask_pixel(), for loops that visit every pixel of a row from x = 0 up: the mask is read a
+// packed word at a time into word, so its format is decoded once every 32 pixels.
+#define IMAGE_GET_MASK_PIXEL_SCAN(mask, word, x, y) \
+({ \
+    if (!((x) & UINT32_T_MASK)) { \
+        (word) = image_get_mask_word((mask), (x), (y)); \
+    } \
+    ((word) >> ((x) & UINT32_T_MASK)) & 1; \
+})
 
 // Old Image Macros - Will be refactor and removed. But, only after making sure through testing new macros work.
 
@@ -139,7 +154,10 @@ void imlib_integral_image_free(struct integral_image *sum);
 void imlib_integral_image(struct image *src, struct integral_image *sum);
 void imlib_integral_image_sq(struct image *src, struct integral_image *sum);
 void imlib_integral_image_scaled(struct image *src, struct integral_image *sum);
+void imlib_integral_image_ss(struct image *src, struct integral_image *sum, struct integral_image *ssq); // STM32IPL
+void imlib_integral_image_ss64(struct image *src, struct integral_image *sum, struct integral_image64 *ssq); // STM32IPL
 uint32_t imlib_integral_lookup(struct integral_image *src, int x, int y, int w, int h);
+uint64_t imlib_integral_lookup64(struct integral_image64 *src, int x, int y, int w, int h); // STM32IPL
 
 // Integral moving window
 void imlib_integral_mw_alloc(mw_image_t *sum, int w, int h);
@@ -156,6 +174,11 @@ long imlib_integral_mw_lookup(mw_image_t *sum, int x, int y, int w, int h);
 /* Haar/VJ */
 int imlib_load_cascade(struct cascade *cascade, const char *path);
 array_t* imlib_detect_objects(struct image *image, struct cascade *cascade, struct rectangle *roi);
+array_t* imlib_detect_objects_pyramid(struct image *levels, const float *scales, int n_levels, struct cascade *cascade,
+		struct rectangle *roi);
+array_t* imlib_detect_objects_range(struct image *levels, const float *scales, int n_levels, struct cascade *cascade,
+		struct rectangle *roi, int step_w, int first_scale, int last_scale);
+array_t* imlib_detect_objects_raw(struct image *image, struct cascade *cascade, struct rectangle *roi);
 
 // Edge detection
 void imlib_edge_simple(image_t *src, rectangle_t *roi, int low_thresh, int high_thresh);
@@ -166,26 +189,42 @@ void imlib_zero(image_t *img, image_t *mask, bool invert);
 
 // Drawing Functions
 void imlib_set_pixel(image_t *img, int x, int y, int p);
+void imlib_draw_hspan(image_t *img, int x0, int x1, int y, int c); // STM32IPL
+void imlib_draw_vspan(image_t *img, int x, int y0, int y1, int c); // STM32IPL
+void imlib_draw_rect_fill(image_t *img, int x0, int y0, int x1, int y1, int c); // STM32IPL
+void imlib_fill_polygon(image_t *img, const point_t *points, int n, int c); // STM32IPL
 void imlib_draw_line(image_t *img, int x0, int y0, int x1, int y1, int c, int thickness);
 void imlib_draw_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int thickness, bool fill);
 void imlib_draw_circle(image_t *img, int cx, int cy, int r, int c, int thickness, bool fill);
 void imlib_draw_ellipse(image_t *img, int cx, int cy, int rx, int ry, int rotation, int c, int thickness, bool fill);
+void imlib_flood_fill(image_t *img, int x, int y, float seed_threshold, float floating_threshold, int c,
+		bool invert, bool clear_background, image_t *mask);
+uint32_t imlib_flood_fill_space(image_t *img); // STM32IPL
+int imlib_flood_fill_threshold(image_t *img, float threshold); // STM32IPL
+void imlib_flood_fill_int(image_t *out, image_t *img, int x, int y, int seed_threshold, int floating_threshold,
+		image_t *mask); // STM32IPL: the mask parameter replaces the span callback.
+uint32_t imlib_flood_fill_int_space(image_t *img); // STM32IPL
 
 // Binary Functions
-void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, bool zero, image_t *mask);
+void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, bool zero, image_t *mask,
+		const uint32_t *lut); // STM32IPL: lut parameter added.
 void imlib_invert(image_t *img);
+// STM32IPL: logical operation applied by the imlib_b_*() functions (NAND is a & ~b, NOR is a | ~b).
+typedef enum imlib_b_op {
+    IMLIB_B_AND, IMLIB_B_NAND, IMLIB_B_OR, IMLIB_B_NOR, IMLIB_B_XOR, IMLIB_B_XNOR
+} imlib_b_op_t;
 void imlib_b_and(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
 void imlib_b_nand(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
 void imlib_b_or(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
 void imlib_b_nor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
 void imlib_b_xor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
 void imlib_b_xnor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask);
-void imlib_erode(image_t *img, int ksize, int threshold, image_t *mask);
-void imlib_dilate(image_t *img, int ksize, int threshold, image_t *mask);
-void imlib_open(image_t *img, int ksize, int threshold, image_t *mask);
-void imlib_close(image_t *img, int ksize, int threshold, image_t *mask);
-void imlib_top_hat(image_t *img, int ksize, int threshold, image_t *mask);
-void imlib_black_hat(image_t *img, int ksize, int threshold, image_t *mask);
+void imlib_erode(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
+void imlib_dilate(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
+void imlib_open(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
+void imlib_close(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
+void imlib_top_hat(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
+void imlib_black_hat(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask); // STM32IPL: dst
 
 // Math Functions
 void imlib_gamma_corr(image_t *img, float gamma, float scale, float offset);
@@ -202,29 +241,47 @@ void imlib_difference(image_t *img, const char *path, image_t *other, int scalar
 // Filtering Functions
 void imlib_histeq(image_t *img, image_t *mask);
 void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask);
-void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset, bool invert, image_t *mask);
-void imlib_median_filter(image_t *img, const int ksize, float percentile, bool threshold, int offset, bool invert,
-		image_t *mask);
-void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset, bool invert, image_t *mask);
-void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool threshold, int offset, bool invert,
-		image_t *mask);
+void imlib_mean_filter(image_t *img, image_t *dst, const int ksize, bool threshold, int offset, bool invert,
+		image_t *mask); // STM32IPL: dst
+uint32_t imlib_mean_filter_sum_space(image_t *img, const int ksize); // STM32IPL
+void imlib_median_filter(image_t *img, image_t *dst, const int ksize, float percentile, bool threshold, int offset,
+		bool invert, image_t *mask); // STM32IPL: dst
+uint32_t imlib_median_filter_hist_space(image_t *img, const int ksize); // STM32IPL
+void imlib_mode_filter(image_t *img, image_t *dst, const int ksize, bool threshold, int offset, bool invert,
+		image_t *mask); // STM32IPL: dst
+void imlib_midpoint_filter(image_t *img, image_t *dst, const int ksize, float bias, bool threshold, int offset,
+		bool invert, image_t *mask); // STM32IPL: dst
 void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, const int b, bool threshold, int offset,
 		bool invert, image_t *mask);
+void imlib_gaussian_filter(image_t *img, image_t *dst, const int ksize, bool threshold, bool unsharp,
+		image_t *mask); // STM32IPL
+uint32_t imlib_gaussian_filter_space(image_t *img, const int ksize); // STM32IPL
 void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, float space_sigma, bool threshold,
 		int offset, bool invert, image_t *mask);
+uint32_t imlib_bilateral_filter_fast_space(image_t *img, const int ksize, bool separable); // STM32IPL
+void imlib_bilateral_filter_fast(image_t *img, image_t *dst, const int ksize, float color_sigma, float space_sigma,
+		bool separable, bool threshold, int offset, bool invert, image_t *mask); // STM32IPL
 
 // Lens/Rotation Correction
 void imlib_lens_corr(image_t *img, float strength, float zoom, float x_corr, float y_corr);
 void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float z_rotation, float x_translation,
 		float y_translation, float zoom, float fov, float *corners);
+bool imlib_rotation_corr_transform(int w, int h, float x_rotation, float y_rotation, float z_rotation,
+		float x_translation, float y_translation, float zoom, float fov, float *corners, float *transform); // STM32IPL
 // Statistics
 void imlib_get_similarity(image_t *img, const char *path, image_t *other, int scalar, float *avg, float *std,
-		float *min, float *max);
+		float *min, float *max, float *map);
 void imlib_get_histogram(histogram_t *out, image_t *ptr, rectangle_t *roi, list_t *thresholds, bool invert,
 		image_t *other);
 void imlib_get_percentile(percentile_t *out, image_bpp_t bpp, histogram_t *ptr, float percentile);
 void imlib_get_threshold(threshold_t *out, image_bpp_t bpp, histogram_t *ptr);
 void imlib_get_statistics(statistics_t *out, image_bpp_t bpp, histogram_t *ptr);
+uint32_t imlib_binary_roi_ones(image_t *ptr, rectangle_t *roi); // STM32IPL
+uint32_t imlib_grayscale_roi_nonzero(image_t *ptr, rectangle_t *roi); // STM32IPL
+int imlib_binary_find_nonzero(const uint32_t *row_ptr, int x, int xx); // STM32IPL
+int imlib_grayscale_find_nonzero(const uint8_t *row_ptr, int x, int xx); // STM32IPL
+void imlib_grayscale_row_min_max(const uint8_t *row_ptr, int n, uint8_t *min, uint8_t *max); // STM32IPL
+int imlib_grayscale_find_value(const uint8_t *row_ptr, int x, int xx, uint8_t value); // STM32IPL
 bool imlib_get_regression(find_lines_list_lnk_data_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride,
 		unsigned int y_stride, list_t *thresholds, bool invert, unsigned int area_threshold,
 		unsigned int pixels_threshold, bool robust);
@@ -234,14 +291,34 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
 		bool merge, int margin,
 		bool (*threshold_cb)(void*, find_blobs_list_lnk_data_t*), void *threshold_cb_arg,
 		bool (*merge_cb)(void*, find_blobs_list_lnk_data_t*, find_blobs_list_lnk_data_t*), void *merge_cb_arg,
-		unsigned int x_hist_bins_max, unsigned int y_hist_bins_max, uint32_t max_blobs); // STM32IPL: max_blobs parameter added.
+		unsigned int x_hist_bins_max, unsigned int y_hist_bins_max, uint32_t max_blobs,
+		const uint32_t *lut); // STM32IPL: max_blobs and lut parameters added.
+bool imlib_find_blobs_rle(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
+		list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
+		bool merge, int margin, unsigned int x_hist_bins_max, unsigned int y_hist_bins_max,
+		uint32_t max_blobs, const uint32_t *lut); // STM32IPL
+bool imlib_find_blobs_code_row(image_t *ptr, rectangle_t *roi, int y, color_thresholds_list_lnk_data_t *thr, int n,
+		bool invert, const uint32_t *lut, int8_t *l_row, uint8_t *codes); // STM32IPL
+int imlib_find_blobs_border(const uint8_t *codes, int l, int r, int code); // STM32IPL
+void imlib_find_blobs_fill(find_blobs_list_lnk_data_t *lnk_blob, const point_t *corners, int code, int blob_pixels,
+		int blob_perimeter, int blob_cx, int blob_cy, long long blob_a, long long blob_b, long long blob_c); // STM32IPL
 
 // Shape Detection
 void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
 		uint32_t threshold, unsigned int theta_margin, unsigned int rho_margin);
+bool imlib_find_lines_edges(list_t *out, image_t *ptr, rectangle_t *roi, uint32_t threshold,
+		unsigned int vote_margin, unsigned int theta_margin, unsigned int rho_margin); // STM32IPL
 void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
 		uint32_t threshold, unsigned int x_margin, unsigned int y_margin, unsigned int r_margin, unsigned int r_min,
 		unsigned int r_max, unsigned int r_step);
+bool imlib_find_circles_gradient(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride,
+		unsigned int y_stride, unsigned int edge_threshold, uint32_t threshold, unsigned int x_margin,
+		unsigned int y_margin, unsigned int r_margin, unsigned int r_min, unsigned int r_max, unsigned int r_step); // STM32IPL
+
+// AprilTags
+bool imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
+		float fx, float fy, float cx, float cy, int decimate, uint32_t max_memory,
+		uint32_t max_detections); // STM32IPL: decimate, max_memory, max_detections parameters added.
 
 // Statistics
 bool stm32ipl_get_regression_points(const point_t *points, uint16_t nPoints, find_lines_list_lnk_data_t *out,
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_kernels.h
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - format-specialized row kernels header file
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __STM32IPL_KERNELS_H_
+#define __STM32IPL_KERNELS_H_
+
+///@cond
+
+#include "imlib.h"
+
+/* Format-specialized row kernels.
+ * Each operation has a table of kernels indexed by the image format (and by the variant of the operation), holding
+ * the C implementation and, when part of the build, the MVE one, selected at run time by ipl_mve_enabled. The caller
+ * resolves the kernel once per call and runs it on every row, so that no inner loop tests the image format.
+ * They are for library internals only. Do not use at application side!
+ */
+
+/* True when the MVE implementations dispatched at run time are selected (STM32Ipl_SetMve()). */
+extern bool ipl_mve_enabled;
+
+/* Pixel traits, used to generate the bodies of the kernels for each format: the row type and the luma (0..255) of
+ * the pixel x of a row (row must be a plain pointer variable). */
+#define IPL_KERNEL_BINARY_T				uint32_t
+#define IPL_KERNEL_BINARY_Y(row, x)		COLOR_BINARY_TO_GRAYSCALE(IMAGE_GET_BINARY_PIXEL_FAST(row, (x)))
+
+#define IPL_KERNEL_GRAYSCALE_T			uint8_t
+#define IPL_KERNEL_GRAYSCALE_Y(row, x)	((row)[(x)])
+
+#define IPL_KERNEL_RGB565_T				uint16_t
+#define IPL_KERNEL_RGB565_Y(row, x)		COLOR_RGB565_TO_Y((row)[(x)])
+
+#define IPL_KERNEL_RGB888_T				rgb888_t
+#define IPL_KERNEL_RGB888_Y(row, x)		({ rgb888_t _p = (row)[(x)]; COLOR_RGB888_TO_Y(_p.r, _p.g, _p.b); })
+
+/* Integral row: accumulates the luma (or the squared luma) of the n pixels x0 + ((x * xRatio) >> 16) of row into sum,
+ * adding the row above when it is not NULL. */
+typedef void (*ipl_kernel_integral_t)(const void *row, int x0, int xRatio, const uint32_t *above, uint32_t *sum,
+		int n);
+
+/* Integral row computing both the sum and the sum of squares in a single pass. */
+typedef void (*ipl_kernel_integral_ss_t)(const void *row, int x0, int xRatio, const uint32_t *sumAbove,
+		const uint32_t *ssqAbove, uint32_t *sum, uint32_t *ssq, int n);
+
+/* Row copy: copies the first n pixels of src to dst; when mask is not NULL, only the pixels set in its row y. */
+typedef void (*ipl_kernel_copy_t)(const void *src, void *dst, int n, image_t *mask, int y);
+
+/* Kernel resolvers; they return NULL when the format is not supported. */
+ipl_kernel_integral_t ipl_kernel_integral(int bpp, bool square);
+ipl_kernel_integral_ss_t ipl_kernel_integral_ss(int bpp);
+ipl_kernel_copy_t ipl_kernel_copy(int bpp, bool masked);
+
+///@endcond
+
+#endif /* __STM32IPL_KERNELS_H_ */
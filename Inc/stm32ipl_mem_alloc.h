@@ -24,17 +24,42 @@
 #ifdef STM32IPL
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "umm_malloc.h"
 
 #define FB_ALLOC_NO_HINT		0
 #define FB_ALLOC_PREFER_SPEED	1
 #define FB_ALLOC_PREFER_SIZE	2
 
+#define FB_ALLOC_ALIGNMENT		32	/* Alignment (bytes) of the buffers allocated from the fb regions. */
+
+/* Space (bytes) taken by a buffer of the given size pushed on the fb stack. */
+#define FB_ALLOC_SPACE(size)	((((uint32_t)(size)) + (FB_ALLOC_ALIGNMENT - 1)) & ~(uint32_t)(FB_ALLOC_ALIGNMENT - 1))
+
+/* Extra space (bytes) needed by a workspace whose address is not aligned. */
+#define FB_WORKSPACE_OVERHEAD	(FB_ALLOC_ALIGNMENT - 1)
+
+/* Row prefetcher: while a source line is processed, the following one is copied to a buffer in the internal memory
+ * through STM32Ipl_BlockCopyStart() (active only when STM32IPL_ENABLE_ROW_PREFETCH is defined). */
+typedef struct _ipl_prefetch_t
+{
+	const uint8_t *base;	/* Address of the first line of the source. */
+	uint32_t stride;		/* Distance (bytes) between two consecutive source lines. */
+	uint32_t lineSize;		/* Number of bytes copied for each line. */
+	uint8_t *buf[2];		/* Line buffers; null when the prefetch is not active. */
+	int line[2];			/* Index of the line held by each buffer, -1 when none. */
+	uint32_t cur;			/* Index of the buffer returned last. */
+} ipl_prefetch_t;
+
+/* True when the given prefetcher copies the lines to the internal memory. */
+#define IPL_PREFETCH_ACTIVE(pf)	((pf)->buf[0] != NULL)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void umm_alloc_fail(void);
+void mem_stats_init(void);
 
 /* General purpose allocation functions.
  * They are for library internals only.
@@ -60,6 +85,27 @@ void* fb_alloc_all(uint32_t *size, int hints);
 void* fb_alloc0_all(uint32_t *size, int hints);
 void fb_free(void);
 void fb_free_all(void);
+bool fb_workspace_begin(void *ws, uint32_t size);
+void fb_workspace_end(void);
+
+/* Context functions.
+ * They are for library internals only.
+ * Do not use at application side!
+ */
+void* ctx_list_pool_get(void);
+void ctx_list_pool_set(void *pool);
+bool ctx_deadline_active(void);
+bool ctx_deadline_expired(void);
+void ctx_deadline_begin(void);
+bool ctx_deadline_end(void);
+
+/* Row prefetch functions.
+ * They are for library internals only.
+ * Do not use at application side!
+ */
+void ipl_prefetch_init(ipl_prefetch_t *pf, const uint8_t *base, uint32_t stride, uint32_t lineSize, int first);
+const uint8_t* ipl_prefetch_line(ipl_prefetch_t *pf, int line, int next);
+void ipl_prefetch_deinit(ipl_prefetch_t *pf);
 
 #ifdef __cplusplus
 }
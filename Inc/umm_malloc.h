@@ -9,6 +9,9 @@
 #define UMM_MALLOC_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+#include "umm_malloc_cfg.h"  /* STM32IPL: umm_heap_t */
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +29,8 @@ extern void  umm_uninit( void );
 extern size_t umm_free_heap_size( void );
 extern size_t umm_max_free_block_size( void );
 
+extern umm_heap_t *umm_select( umm_heap_t *heap ); /* STM32IPL */
+
 /* ------------------------------------------------------------------------ */
 
 #ifdef __cplusplus
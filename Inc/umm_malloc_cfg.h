@@ -184,8 +184,6 @@ UMM_BLOCK_BODY_SIZE 	UMM_MAX_ADDRESABLE_MEMORY
   }
   UMM_HEAP_INFO;
 
-  extern UMM_HEAP_INFO ummHeapInfo;
-
   extern void *umm_info( void *ptr, bool force );
   extern size_t umm_free_heap_size( void );
   extern size_t umm_max_free_block_size( void );
@@ -199,6 +197,34 @@ UMM_BLOCK_BODY_SIZE 	UMM_MAX_ADDRESABLE_MEMORY
   #define umm_in_use_metric() (0)
 #endif
 
+/* -------------------------------------------------------------------------- */
+
+/*
+ * STM32IPL: the state of the allocator is kept in a heap instance, so that
+ * several independent heaps can be managed (one for each STM32IPL context).
+ * All the umm_xxx() functions work on the heap selected with umm_select();
+ * the selection is kept per thread when UMM_THREAD_LOCAL is set to the
+ * thread-local storage class of the compiler (i.e. _Thread_local).
+ */
+
+#include "stm32ipl_conf.h"
+
+#ifndef UMM_THREAD_LOCAL
+  #ifdef STM32IPL_CTX_THREAD_LOCAL
+    #define UMM_THREAD_LOCAL STM32IPL_CTX_THREAD_LOCAL
+  #else
+    #define UMM_THREAD_LOCAL
+  #endif
+#endif
+
+typedef struct umm_heap_t {
+  void *blocks;
+  uint16_t numblocks;
+#ifdef UMM_INFO
+  UMM_HEAP_INFO info;
+#endif
+} umm_heap_t;
+
 /*
  * A couple of macros to make it easier to protect the memory allocator
  * in a multitasking system. You should set these macros up to use whatever
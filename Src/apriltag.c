@@ -133,7 +133,6 @@ static inline zarray_t *zarray_create(size_t el_sz)
     return za;
 }
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 /**
  * Creates and returns a variable array structure capable of holding elements of
  * the specified size. It is the caller's responsibility to call zarray_destroy()
@@ -147,7 +146,6 @@ static inline zarray_t *zarray_create_fail_ok(size_t el_sz)
     if (za) za->el_sz = el_sz;
     return za;
 }
-#endif // STM32IPL
 
 /**
  * Frees all resources associated with the variable array structure which was
@@ -164,7 +162,6 @@ static inline void zarray_destroy(zarray_t *za)
     free(za);
 }
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 /** Allocate a new zarray that contains a copy of the data in the argument. **/
 static inline zarray_t *zarray_copy(const zarray_t *za)
 {
@@ -208,7 +205,6 @@ static inline zarray_t *zarray_copy_subset(const zarray_t *za,
     memcpy(out->data,  za->data +(start_idx*out->el_sz), out->size*out->el_sz);
     return out;
 }
-#endif // STM32IPL
 
 /**
  * Retrieves the number of elements currently being contained by the passed
@@ -275,7 +271,6 @@ static inline void zarray_add(zarray_t *za, const void *p)
     za->size++;
 }
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 /**
  * Adds a new element to the end of the supplied array, and sets its value
  * (by copying) from the data pointed to by the supplied pointer 'p'.
@@ -324,7 +319,6 @@ static inline void zarray_get(const zarray_t *za, int idx, void *p)
 
     memcpy(p, &za->data[idx*za->el_sz], za->el_sz);
 }
-#endif // STM32IPL
 
 /**
  * Similar to zarray_get(), but returns a "live" pointer to the internal
@@ -343,7 +337,6 @@ inline static void zarray_get_volatile(const zarray_t *za, int idx, void *p)
     *((void**) p) = &za->data[idx*za->el_sz];
 }
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 inline static void zarray_truncate(zarray_t *za, int sz)
 {
    assert(za != NULL);
@@ -487,7 +480,6 @@ static inline void zarray_map(zarray_t *za, void (*f)(void*))
     for (int idx = 0; idx < za->size; idx++)
         f(&za->data[idx*za->el_sz]);
 }
-#endif // STM32IPL
 
 /**
  * Calls the supplied function for every element in the array in index order.
@@ -501,7 +493,6 @@ static inline void zarray_map(zarray_t *za, void (*f)(void*))
  */
     void zarray_vmap(zarray_t *za, void (*f)());
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 /**
  * Removes all elements from the array and sets its size to zero. Pointers to
  * any data elements obtained i.e. by zarray_get_volatile() will no longer be
@@ -557,7 +548,6 @@ static inline void zarray_sort(zarray_t *za, int (*compar)(const void*, const vo
 
     qsort(za->data, za->size, za->el_sz, compar);
 }
-#endif // STM32IPL
 
 /**
  * A comparison function for comparing strings which can be used by zarray_sort()
@@ -735,7 +725,6 @@ void zarray_vmap(zarray_t *za, void (*f)())
 
 matd_t *homography_compute(zarray_t *correspondences, int flags);
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 //void homography_project(const matd_t *H, float x, float y, float *ox, float *oy);
 static inline void homography_project(const matd_t *H, float x, float y, float *ox, float *oy)
 {
@@ -746,7 +735,6 @@ static inline void homography_project(const matd_t *H, float x, float y, float *
     *ox = xx / zz;
     *oy = yy / zz;
 }
-#endif // STM32IPL
 
 // assuming that the projection matrix is:
 // [ fx 0  cx 0 ]
@@ -983,19 +971,25 @@ matd_t *homography_compute(zarray_t *correspondences, int flags)
 
     }
 
-    matd_t *Tx = matd_identity(3);
-    MATD_EL(Tx,0,2) = -x_cx;
-    MATD_EL(Tx,1,2) = -x_cy;
+    // STM32IPL: the denormalization is done on the stack, in place of matd_op("M*M*M", Ty, H, Tx).
+    MATF_DECLARE(Tx, 3, 3);
+    matf_identity(&Tx);
+    MATF_EL(&Tx,0,2) = -x_cx;
+    MATF_EL(&Tx,1,2) = -x_cy;
 
-    matd_t *Ty = matd_identity(3);
-    MATD_EL(Ty,0,2) = y_cx;
-    MATD_EL(Ty,1,2) = y_cy;
+    MATF_DECLARE(Ty, 3, 3);
+    matf_identity(&Ty);
+    MATF_EL(&Ty,0,2) = y_cx;
+    MATF_EL(&Ty,1,2) = y_cy;
 
-    matd_t *H2 = matd_op("M*M*M", Ty, H, Tx);
+    matd_t *H2 = matd_create(3,3);
+    matf_t HF, H2F;
+    matf_from_matd(&HF, H);
+    matf_from_matd(&H2F, H2);
+    matf_multiply(&Ty, &HF, &H2F);
+    matf_multiply(&H2F, &Tx, &H2F);
 
     matd_destroy(A);
-    matd_destroy(Tx);
-    matd_destroy(Ty);
     matd_destroy(H);
 
     return H2;
@@ -1235,7 +1229,6 @@ void quat_to_matrix(const float q[4], matd_t *M)
     MATD_EL(M, 2, 2) = w*w - x*x - y*y + z*z;
 }
 
-#ifndef STM32IPL
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////// "g2d.h"
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2415,6 +2408,16 @@ struct apriltag_detector
     ///////////////////////////////////////////////////////////////
     // User-configurable parameters.
 
+    // detection of quads can be done on a lower-resolution image,
+    // improving speed at a cost of pose accuracy and a slight
+    // decrease in detection rate. Decoding the binary payload is
+    // still done at full resolution.
+    int quad_decimate; // STM32IPL: restored (integer factors only).
+
+    // STM32IPL: maximum size (bytes) of the cluster hash table used by
+    // apriltag_quad_thresh(); 0 means half of the available memory.
+    uint32_t max_clustermap_size;
+
     // When non-zero, the edges of the each quad are adjusted to "snap
     // to" strong gradients nearby. This is useful when decimation is
     // employed, as it can increase the quality of the initial quad
@@ -2511,7 +2514,6 @@ apriltag_detector_t *apriltag_detector_create(void); // STM32IPL: void added.
 // a single instance should only be provided to one apriltag detector instance.
 void apriltag_detector_add_family_bits(apriltag_detector_t *td, apriltag_family_t *fam, int bits_corrected);
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 // Tunable, but really, 2 is a good choice. Values of >=3
 // consume prohibitively large amounts of memory, and otherwise
 // you want the largest value possible.
@@ -2519,7 +2521,6 @@ static inline void apriltag_detector_add_family(apriltag_detector_t *td, aprilta
 {
     apriltag_detector_add_family_bits(td, fam, 2);
 }
-#endif // STM32IPL
 
 // does not deallocate the family.
 void apriltag_detector_remove_family(apriltag_detector_t *td, apriltag_family_t *fam);
@@ -6428,7 +6429,6 @@ static inline uint32_t unionfind_get_representative(unionfind_t *uf, uint32_t id
     return root;
 }
 
-#ifndef STM32IPL // Unused; commented to prevent warnings.
 static inline uint32_t unionfind_connect(unionfind_t *uf, uint32_t aid, uint32_t bid)
 {
     uint32_t aroot = unionfind_get_representative(uf, aid);
@@ -6439,7 +6439,6 @@ static inline uint32_t unionfind_connect(unionfind_t *uf, uint32_t aid, uint32_t
 
     return aroot;
 }
-#endif // STM32IPL
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////// "union_find.c"
@@ -6856,8 +6855,13 @@ int quad_segment_maxima(apriltag_detector_t *td, zarray_t *cluster, struct line_
     }
 
     // if we didn't get at least 4 maxima, we can't fit a quad.
-    if (nmaxima < 4)
+    if (nmaxima < 4) {
+        // STM32IPL: buffers released (they were leaked).
+        fb_free(); // maxima_errs
+        fb_free(); // maxima
+        fb_free(); // errs
         return 0;
+    }
 
     // select only the best maxima if we have too many
     int max_nmaxima = td->qtp.max_nmaxima;
@@ -6881,10 +6885,6 @@ int quad_segment_maxima(apriltag_detector_t *td, zarray_t *cluster, struct line_
         fb_free(); // maxima_errs_copy
     }
 
-    fb_free(); // maxima_errs
-    fb_free(); // maxima
-    fb_free(); // errs
-
     int best_indices[4];
     float best_error = HUGE_VALF;
 
@@ -6941,6 +6941,11 @@ int quad_segment_maxima(apriltag_detector_t *td, zarray_t *cluster, struct line_
         }
     }
 
+    // STM32IPL: buffers released after their last use (a released fb buffer can be reused by the heap).
+    fb_free(); // maxima_errs
+    fb_free(); // maxima
+    fb_free(); // errs
+
     if (best_error == HUGE_VALF)
         return 0;
 
@@ -7844,10 +7849,14 @@ zarray_t *apriltag_quad_thresh(apriltag_detector_t *td, image_u8_t *im, bool ove
         do_unionfind_line(uf, threshim, h, w, ts, y);
     }
 
-    uint32_t nclustermap;
-    struct uint32_zarray_entry **clustermap = fb_alloc0_all(&nclustermap, FB_ALLOC_PREFER_SPEED);
-    nclustermap /= sizeof(struct uint32_zarray_entry*);
+    // STM32IPL: the hash table is bounded (fb_alloc0_all() left no memory for the clusters): 0.2 entries
+    // per pixel (as in later AprilTag releases), within the detector limit or half of the free memory.
+    uint32_t nclustermap = fb_avail();
+    nclustermap = td->max_clustermap_size ? IM_MIN(nclustermap, td->max_clustermap_size) : (nclustermap / 2);
+    nclustermap = IM_MIN(nclustermap / sizeof(struct uint32_zarray_entry*), (w * h) / 5);
     if (!nclustermap) fb_alloc_fail();
+    struct uint32_zarray_entry **clustermap = fb_alloc0(nclustermap * sizeof(struct uint32_zarray_entry*),
+            FB_ALLOC_PREFER_SPEED);
 
     for (int y = 1; y < h-1; y++) {
         for (int x = 1; x < w-1; x++) {
@@ -8344,6 +8353,9 @@ apriltag_detector_t *apriltag_detector_create()
 {
     apriltag_detector_t *td = (apriltag_detector_t*) calloc(1, sizeof(apriltag_detector_t));
 
+    td->quad_decimate = 1; // STM32IPL
+    td->max_clustermap_size = 0; // STM32IPL
+
     td->qtp.max_nmaxima = 10;
     td->qtp.min_cluster_pixels = 5;
 
@@ -8824,7 +8836,7 @@ static void refine_edges(apriltag_detector_t *td, image_u8_t *im_orig, struct qu
             // search on another pixel in the first place. Likewise,
             // for very small tags, we don't want the range to be too
             // big.
-            float range = 1.0 + 1;
+            float range = td->quad_decimate + 1; // STM32IPL: quad_decimate restored.
 
             // XXX tunable step size.
             for (float n = -range; n <= range; n +=  0.25f) {	// STM32IPL: added f to the constant.
@@ -8945,6 +8957,39 @@ int prefer_smaller(int pref, float q0, float q1)
     return 0;
 }
 
+// STM32IPL: box filtered decimation by an integer factor; the result is allocated in the fb stack.
+static image_u8_t *image_u8_decimate(image_u8_t *im, int factor)
+{
+    int swidth = im->width / factor, sheight = im->height / factor;
+    int area = factor * factor;
+
+    image_u8_t *decim = fb_alloc(sizeof(image_u8_t), FB_ALLOC_NO_HINT);
+    decim->width = swidth;
+    decim->height = sheight;
+    decim->stride = swidth;
+    decim->buf = fb_alloc(swidth * sheight, FB_ALLOC_NO_HINT);
+
+    for (int sy = 0; sy < sheight; sy++) {
+        const uint8_t *row = im->buf + (sy * factor * im->stride);
+        uint8_t *out = decim->buf + (sy * decim->stride);
+
+        for (int sx = 0; sx < swidth; sx++) {
+            const uint8_t *p = row + (sx * factor);
+            int acc = 0;
+
+            for (int y = 0; y < factor; y++, p += im->stride) {
+                for (int x = 0; x < factor; x++) {
+                    acc += p[x];
+                }
+            }
+
+            out[sx] = (acc + (area / 2)) / area;
+        }
+    }
+
+    return decim;
+}
+
 zarray_t *apriltag_detector_detect(apriltag_detector_t *td, image_u8_t *im_orig)
 {
     if (zarray_size(td->tag_families) == 0) {
@@ -8958,7 +9003,29 @@ zarray_t *apriltag_detector_detect(apriltag_detector_t *td, image_u8_t *im_orig)
     // and blurring parameters.
 
 //    zarray_t *quads = apriltag_quad_gradient(td, im_orig);
-    zarray_t *quads = apriltag_quad_thresh(td, im_orig, false);
+    // STM32IPL: quad_decimate restored.
+    zarray_t *quads;
+
+    if (td->quad_decimate > 1) {
+        image_u8_t *quad_im = image_u8_decimate(im_orig, td->quad_decimate);
+        quads = apriltag_quad_thresh(td, quad_im, false);
+        fb_free(); // quad_im->buf
+        fb_free(); // quad_im
+
+        // the quad corners are in pixel corner coordinates (pixel x spans [x, x + 1]) and a decimated
+        // pixel is the average of a quad_decimate x quad_decimate block.
+        for (int i = 0; i < zarray_size(quads); i++) {
+            struct quad *q;
+            zarray_get_volatile(quads, i, &q);
+
+            for (int j = 0; j < 4; j++) {
+                q->p[j][0] *= td->quad_decimate;
+                q->p[j][1] *= td->quad_decimate;
+            }
+        }
+    } else {
+        quads = apriltag_quad_thresh(td, im_orig, false);
+    }
 
     zarray_t *detections = zarray_create(sizeof(apriltag_detection_t*));
 
@@ -9035,28 +9102,34 @@ zarray_t *apriltag_detector_detect(apriltag_detector_t *td, image_u8_t *im_orig)
                     float c = cos(theta), s = sin(theta);
 
                     // Fix the rotation of our homography to properly orient the tag
-                    matd_t *R = matd_create(3,3);
-                    MATD_EL(R, 0, 0) = c;
-                    MATD_EL(R, 0, 1) = -s;
-                    MATD_EL(R, 1, 0) = s;
-                    MATD_EL(R, 1, 1) = c;
-                    MATD_EL(R, 2, 2) = 1;
-
-                    matd_t *RHMirror = matd_create(3,3);
-                    MATD_EL(RHMirror, 0, 0) = entry.hmirror ? -1 : 1;
-                    MATD_EL(RHMirror, 1, 1) = 1;
-                    MATD_EL(RHMirror, 2, 2) = entry.hmirror ? -1 : 1;
-
-                    matd_t *RVFlip = matd_create(3,3);
-                    MATD_EL(RVFlip, 0, 0) = 1;
-                    MATD_EL(RVFlip, 1, 1) = entry.vflip ? -1 : 1;
-                    MATD_EL(RVFlip, 2, 2) = entry.vflip ? -1 : 1;
-
-                    det->H = matd_op("M*M*M*M", quad->H, R, RHMirror, RVFlip);
-
-                    matd_destroy(R);
-                    matd_destroy(RHMirror);
-                    matd_destroy(RVFlip);
+                    // STM32IPL: the factors live on the stack, only det->H is allocated.
+                    MATF_DECLARE(R, 3, 3);
+                    matf_identity(&R);
+                    MATF_EL(&R, 0, 0) = c;
+                    MATF_EL(&R, 0, 1) = -s;
+                    MATF_EL(&R, 1, 0) = s;
+                    MATF_EL(&R, 1, 1) = c;
+                    MATF_EL(&R, 2, 2) = 1;
+
+                    MATF_DECLARE(RHMirror, 3, 3);
+                    matf_identity(&RHMirror);
+                    MATF_EL(&RHMirror, 0, 0) = entry.hmirror ? -1 : 1;
+                    MATF_EL(&RHMirror, 1, 1) = 1;
+                    MATF_EL(&RHMirror, 2, 2) = entry.hmirror ? -1 : 1;
+
+                    MATF_DECLARE(RVFlip, 3, 3);
+                    matf_identity(&RVFlip);
+                    MATF_EL(&RVFlip, 0, 0) = 1;
+                    MATF_EL(&RVFlip, 1, 1) = entry.vflip ? -1 : 1;
+                    MATF_EL(&RVFlip, 2, 2) = entry.vflip ? -1 : 1;
+
+                    matf_t QH, DH;
+                    matf_from_matd(&QH, quad->H);
+                    det->H = matd_create(3,3);
+                    matf_from_matd(&DH, det->H);
+                    matf_multiply(&QH, &R, &DH);
+                    matf_multiply(&DH, &RHMirror, &DH);
+                    matf_multiply(&DH, &RVFlip, &DH);
 
                     homography_project(det->H, 0, 0, &det->c[0], &det->c[1]);
 
@@ -9188,8 +9261,9 @@ void apriltag_detections_destroy(zarray_t *detections)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
-                          float fx, float fy, float cx, float cy)
+bool imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
+                          float fx, float fy, float cx, float cy,
+                          int decimate, uint32_t max_memory, uint32_t max_detections) // STM32IPL: decimate, max_memory, max_detections added.
 {
     // Frame Buffer Memory Usage...
     // -> GRAYSCALE Input Image = w*h*1
@@ -9199,8 +9273,24 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
     size_t resolution = roi->w * roi->h;
     size_t fb_alloc_need = resolution * (1 + 1 + 2 + 1); // read above...
     umm_init_x(((fb_avail() - fb_alloc_need) / resolution) * resolution);
+#else // STM32IPL
+    // The quads are searched in the decimated image (wd*hd = w*h/(decimate*decimate) pixels)...
+    // -> GRAYSCALE Decimated Image = wd*hd*1 (decimate > 1 only)
+    // -> GRAYSCALE Threhsolded Image = wd*hd*1 (+wd*hd/4 for the tiles)
+    // -> UnionFind = wd*hd*sizeof(struct ufrec)
+    // -> Hash table = the rest of max_memory, up to wd*hd*0.8 (wd*hd*0.2 at least)
+    size_t resolution = (roi->w / decimate) * (roi->h / decimate);
+    size_t fb_alloc_fixed = (roi->w * roi->h) + (resolution * ((decimate > 1) + 1)) + (resolution / 4) +
+                            ((resolution + 1) * sizeof(struct ufrec)) + (16 * FB_ALLOC_ALIGNMENT);
+    size_t fb_alloc_need = fb_alloc_fixed + (resolution / 5);
+
+    if ((max_memory && (max_memory < fb_alloc_need)) || (fb_avail() < fb_alloc_need)) {
+        return false;
+    }
 #endif // STM32IPL
     apriltag_detector_t *td = apriltag_detector_create();
+    td->quad_decimate = decimate; // STM32IPL
+    td->max_clustermap_size = max_memory ? (max_memory - fb_alloc_fixed) : 0; // STM32IPL
 
     if (families & TAG16H5) {
         apriltag_detector_add_family(td, (apriltag_family_t *) &tag16h5);
@@ -9262,6 +9352,15 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
             }
             break;
         }
+        case IMAGE_BPP_RGB888: { // STM32IPL
+            for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+                rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(ptr, y);
+                for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
+                    *(grayscale_image++) = COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
+                }
+            }
+            break;
+        }
         default: {
             memset(grayscale_image, 0, roi->w * roi->h);
             break;
@@ -9271,7 +9370,11 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
     zarray_t *detections = apriltag_detector_detect(td, &im);
     list_init(out, sizeof(find_apriltags_list_lnk_data_t));
 
-    for (int i = 0, j = zarray_size(detections); i < j; i++) {
+    // STM32IPL: max_detections added (0 means no limit).
+    int j = zarray_size(detections);
+    if (max_detections && ((uint32_t) j > max_detections)) j = max_detections;
+
+    for (int i = 0; i < j; i++) {
         apriltag_detection_t *det;
         zarray_get(detections, i, &det);
 
@@ -9347,6 +9450,7 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
 #ifndef STM32IPL
     fb_free(); // umm_init_x();
 #endif // STM32IPL
+    return true; // STM32IPL
 }
 
 #ifdef IMLIB_ENABLE_FIND_RECTS
@@ -9367,6 +9471,7 @@ void imlib_find_rects(list_t *out, image_t *ptr, rectangle_t *roi, uint32_t thre
     img.w = roi->w;
     img.h = roi->h;
     img.bpp = IMAGE_BPP_GRAYSCALE;
+    img.stride = 0;
     img.data = fb_alloc(image_size(&img), FB_ALLOC_NO_HINT);
     imlib_draw_image(&img, ptr, 0, 0, 1.f, 1.f, roi, -1, 256, NULL, NULL, (image_hint_t)0, NULL, NULL);// STM32IPL added cast.
 
@@ -9548,72 +9653,70 @@ void imlib_find_rects(list_t *out, image_t *ptr, rectangle_t *roi, uint32_t thre
 #endif // STM32IPL
 }
 #endif //IMLIB_ENABLE_FIND_RECTS
-#endif // STM32IPL
 
 #ifdef IMLIB_ENABLE_ROTATION_CORR
 // http://jepsonsblog.blogspot.com/2012/11/rotation-in-3d-using-opencvs.html
-void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float z_rotation,
-                         float x_translation, float y_translation,
-                         float zoom, float fov, float *corners)
+// STM32IPL: the destination to source transform of imlib_rotation_corr() is computed apart, so that it can also be
+// used to compile a dewarping map (see STM32Ipl_RotationCompileMap()); returns false if it is not invertible.
+bool imlib_rotation_corr_transform(int w, int h, float x_rotation, float y_rotation, float z_rotation,
+                                   float x_translation, float y_translation,
+                                   float zoom, float fov, float *corners, float *transform) // STM32IPL
 {
-    // Create a tmp copy of the image to pull pixels from.
-    size_t size = image_size(img);
-    void *data = fb_alloc(size, FB_ALLOC_NO_HINT);
-    memcpy(data, img->data, size);
-    memset(img->data, 0, size);
-
-#ifndef STM32IPL
-    umm_init_x(fb_avail());
-#endif // STM32IPL
-
-    int w = img->w;
-    int h = img->h;
     float z = (fast_sqrtf((w * w) + (h * h)) / 2) / tanf(fov / 2);
     float z_z = z * zoom;
 
-    matd_t *A1 = matd_create(4, 3);
-    MATD_EL(A1, 0, 0) = 1;  MATD_EL(A1, 0, 1) = 0;  MATD_EL(A1, 0, 2) = -w / 2;
-    MATD_EL(A1, 1, 0) = 0;  MATD_EL(A1, 1, 1) = 1;  MATD_EL(A1, 1, 2) = -h / 2;
-    MATD_EL(A1, 2, 0) = 0;  MATD_EL(A1, 2, 1) = 0;  MATD_EL(A1, 2, 2) = 0;
-    MATD_EL(A1, 3, 0) = 0;  MATD_EL(A1, 3, 1) = 0;  MATD_EL(A1, 3, 2) = 1; // needed for z translation
-
-    matd_t *RX = matd_create(4, 4);
-    MATD_EL(RX, 0, 0) = 1;  MATD_EL(RX, 0, 1) = 0;                  MATD_EL(RX, 0, 2) = 0;                  MATD_EL(RX, 0, 3) = 0;
-    MATD_EL(RX, 1, 0) = 0;  MATD_EL(RX, 1, 1) = +cosf(x_rotation);  MATD_EL(RX, 1, 2) = -sinf(x_rotation);  MATD_EL(RX, 1, 3) = 0;
-    MATD_EL(RX, 2, 0) = 0;  MATD_EL(RX, 2, 1) = +sinf(x_rotation);  MATD_EL(RX, 2, 2) = +cosf(x_rotation);  MATD_EL(RX, 2, 3) = 0;
-    MATD_EL(RX, 3, 0) = 0;  MATD_EL(RX, 3, 1) = 0;                  MATD_EL(RX, 3, 2) = 0;                  MATD_EL(RX, 3, 3) = 1;
-
-    matd_t *RY = matd_create(4, 4);
-    MATD_EL(RY, 0, 0) = +cosf(y_rotation);  MATD_EL(RY, 0, 1) = 0;  MATD_EL(RY, 0, 2) = -sinf(y_rotation);  MATD_EL(RY, 0, 3) = 0;
-    MATD_EL(RY, 1, 0) = 0;                  MATD_EL(RY, 1, 1) = 1;  MATD_EL(RY, 1, 2) = 0;                  MATD_EL(RY, 1, 3) = 0;
-    MATD_EL(RY, 2, 0) = +sinf(y_rotation);  MATD_EL(RY, 2, 1) = 0;  MATD_EL(RY, 2, 2) = +cosf(y_rotation);  MATD_EL(RY, 2, 3) = 0;
-    MATD_EL(RY, 3, 0) = 0;                  MATD_EL(RY, 3, 1) = 0;  MATD_EL(RY, 3, 2) = 0;                  MATD_EL(RY, 3, 3) = 1;
-
-    matd_t *RZ = matd_create(4, 4);
-    MATD_EL(RZ, 0, 0) = +cosf(z_rotation);  MATD_EL(RZ, 0, 1) = -sinf(z_rotation);  MATD_EL(RZ, 0, 2) = 0;  MATD_EL(RZ, 0, 3) = 0;
-    MATD_EL(RZ, 1, 0) = +sinf(z_rotation);  MATD_EL(RZ, 1, 1) = +cosf(z_rotation);  MATD_EL(RZ, 1, 2) = 0;  MATD_EL(RZ, 1, 3) = 0;
-    MATD_EL(RZ, 2, 0) = 0;                  MATD_EL(RZ, 2, 1) = 0;                  MATD_EL(RZ, 2, 2) = 1;  MATD_EL(RZ, 2, 3) = 0;
-    MATD_EL(RZ, 3, 0) = 0;                  MATD_EL(RZ, 3, 1) = 0;                  MATD_EL(RZ, 3, 2) = 0;  MATD_EL(RZ, 3, 3) = 1;
-
-    matd_t *R = matd_op("M*M*M", RX, RY, RZ);
-
-    matd_t *T = matd_create(4, 4);
-    MATD_EL(T, 0, 0) = 1;   MATD_EL(T, 0, 1) = 0;   MATD_EL(T, 0, 2) = 0;   MATD_EL(T, 0, 3) = x_translation;
-    MATD_EL(T, 1, 0) = 0;   MATD_EL(T, 1, 1) = 1;   MATD_EL(T, 1, 2) = 0;   MATD_EL(T, 1, 3) = y_translation;
-    MATD_EL(T, 2, 0) = 0;   MATD_EL(T, 2, 1) = 0;   MATD_EL(T, 2, 2) = 1;   MATD_EL(T, 2, 3) = z;
-    MATD_EL(T, 3, 0) = 0;   MATD_EL(T, 3, 1) = 0;   MATD_EL(T, 3, 2) = 0;   MATD_EL(T, 3, 3) = 1;
-
-    matd_t *A2 = matd_create(3, 4);
-    MATD_EL(A2, 0, 0) = z_z;    MATD_EL(A2, 0, 1) = 0;      MATD_EL(A2, 0, 2) = w / 2;   MATD_EL(A2, 0, 3) = 0;
-    MATD_EL(A2, 1, 0) = 0;      MATD_EL(A2, 1, 1) = z_z;    MATD_EL(A2, 1, 2) = h / 2;   MATD_EL(A2, 1, 3) = 0;
-    MATD_EL(A2, 2, 0) = 0;      MATD_EL(A2, 2, 1) = 0;      MATD_EL(A2, 2, 2) = 1;       MATD_EL(A2, 2, 3) = 0;
-
-    matd_t *T1 = matd_op("M*M", R, A1);
-    matd_t *T2 = matd_op("M*M", T, T1);
-    matd_t *T3 = matd_op("M*M", A2, T2);
-    matd_t *T4 = matd_inverse(T3);
-
-    if (T4 && corners) {
+    // STM32IPL: the fixed-size matrices live on the stack (see matf_t).
+    MATF_DECLARE(A1, 4, 3);
+    MATF_EL(&A1, 0, 0) = 1;  MATF_EL(&A1, 0, 1) = 0;  MATF_EL(&A1, 0, 2) = -w / 2;
+    MATF_EL(&A1, 1, 0) = 0;  MATF_EL(&A1, 1, 1) = 1;  MATF_EL(&A1, 1, 2) = -h / 2;
+    MATF_EL(&A1, 2, 0) = 0;  MATF_EL(&A1, 2, 1) = 0;  MATF_EL(&A1, 2, 2) = 0;
+    MATF_EL(&A1, 3, 0) = 0;  MATF_EL(&A1, 3, 1) = 0;  MATF_EL(&A1, 3, 2) = 1; // needed for z translation
+
+    MATF_DECLARE(RX, 4, 4);
+    MATF_EL(&RX, 0, 0) = 1;  MATF_EL(&RX, 0, 1) = 0;                  MATF_EL(&RX, 0, 2) = 0;                  MATF_EL(&RX, 0, 3) = 0;
+    MATF_EL(&RX, 1, 0) = 0;  MATF_EL(&RX, 1, 1) = +cosf(x_rotation);  MATF_EL(&RX, 1, 2) = -sinf(x_rotation);  MATF_EL(&RX, 1, 3) = 0;
+    MATF_EL(&RX, 2, 0) = 0;  MATF_EL(&RX, 2, 1) = +sinf(x_rotation);  MATF_EL(&RX, 2, 2) = +cosf(x_rotation);  MATF_EL(&RX, 2, 3) = 0;
+    MATF_EL(&RX, 3, 0) = 0;  MATF_EL(&RX, 3, 1) = 0;                  MATF_EL(&RX, 3, 2) = 0;                  MATF_EL(&RX, 3, 3) = 1;
+
+    MATF_DECLARE(RY, 4, 4);
+    MATF_EL(&RY, 0, 0) = +cosf(y_rotation);  MATF_EL(&RY, 0, 1) = 0;  MATF_EL(&RY, 0, 2) = -sinf(y_rotation);  MATF_EL(&RY, 0, 3) = 0;
+    MATF_EL(&RY, 1, 0) = 0;                  MATF_EL(&RY, 1, 1) = 1;  MATF_EL(&RY, 1, 2) = 0;                  MATF_EL(&RY, 1, 3) = 0;
+    MATF_EL(&RY, 2, 0) = +sinf(y_rotation);  MATF_EL(&RY, 2, 1) = 0;  MATF_EL(&RY, 2, 2) = +cosf(y_rotation);  MATF_EL(&RY, 2, 3) = 0;
+    MATF_EL(&RY, 3, 0) = 0;                  MATF_EL(&RY, 3, 1) = 0;  MATF_EL(&RY, 3, 2) = 0;                  MATF_EL(&RY, 3, 3) = 1;
+
+    MATF_DECLARE(RZ, 4, 4);
+    MATF_EL(&RZ, 0, 0) = +cosf(z_rotation);  MATF_EL(&RZ, 0, 1) = -sinf(z_rotation);  MATF_EL(&RZ, 0, 2) = 0;  MATF_EL(&RZ, 0, 3) = 0;
+    MATF_EL(&RZ, 1, 0) = +sinf(z_rotation);  MATF_EL(&RZ, 1, 1) = +cosf(z_rotation);  MATF_EL(&RZ, 1, 2) = 0;  MATF_EL(&RZ, 1, 3) = 0;
+    MATF_EL(&RZ, 2, 0) = 0;                  MATF_EL(&RZ, 2, 1) = 0;                  MATF_EL(&RZ, 2, 2) = 1;  MATF_EL(&RZ, 2, 3) = 0;
+    MATF_EL(&RZ, 3, 0) = 0;                  MATF_EL(&RZ, 3, 1) = 0;                  MATF_EL(&RZ, 3, 2) = 0;  MATF_EL(&RZ, 3, 3) = 1;
+
+    MATF_DECLARE(R, 4, 4);
+    matf_multiply(&RX, &RY, &R);
+    matf_multiply(&R, &RZ, &R);
+
+    MATF_DECLARE(T, 4, 4);
+    MATF_EL(&T, 0, 0) = 1;   MATF_EL(&T, 0, 1) = 0;   MATF_EL(&T, 0, 2) = 0;   MATF_EL(&T, 0, 3) = x_translation;
+    MATF_EL(&T, 1, 0) = 0;   MATF_EL(&T, 1, 1) = 1;   MATF_EL(&T, 1, 2) = 0;   MATF_EL(&T, 1, 3) = y_translation;
+    MATF_EL(&T, 2, 0) = 0;   MATF_EL(&T, 2, 1) = 0;   MATF_EL(&T, 2, 2) = 1;   MATF_EL(&T, 2, 3) = z;
+    MATF_EL(&T, 3, 0) = 0;   MATF_EL(&T, 3, 1) = 0;   MATF_EL(&T, 3, 2) = 0;   MATF_EL(&T, 3, 3) = 1;
+
+    MATF_DECLARE(A2, 3, 4);
+    MATF_EL(&A2, 0, 0) = z_z;    MATF_EL(&A2, 0, 1) = 0;      MATF_EL(&A2, 0, 2) = w / 2;   MATF_EL(&A2, 0, 3) = 0;
+    MATF_EL(&A2, 1, 0) = 0;      MATF_EL(&A2, 1, 1) = z_z;    MATF_EL(&A2, 1, 2) = h / 2;   MATF_EL(&A2, 1, 3) = 0;
+    MATF_EL(&A2, 2, 0) = 0;      MATF_EL(&A2, 2, 1) = 0;      MATF_EL(&A2, 2, 2) = 1;       MATF_EL(&A2, 2, 3) = 0;
+
+    MATF_DECLARE(T1, 4, 3);
+    MATF_DECLARE(T2, 4, 3);
+    MATF_DECLARE(T3, 3, 3);
+    matf_t T4;
+    matf_multiply(&R, &A1, &T1);
+    matf_multiply(&T, &T1, &T2);
+    matf_multiply(&A2, &T2, &T3);
+    matf_init(&T4, 3, 3, transform);
+
+    bool ok = (matf_inverse(&T3, &T4) == ARM_MATH_SUCCESS); // STM32IPL
+
+    if (ok && corners) {
         float corr[4];
         zarray_t *correspondences = zarray_create(sizeof(float[4]));
 
@@ -9648,19 +9751,41 @@ void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float
         }
 
         if (H) {
-            matd_t *T5 = matd_op("M*M", H, T4);
+            matf_t HF;
+            matf_from_matd(&HF, H);
+            matf_multiply(&HF, &T4, &T4);
             matd_destroy(H);
-            matd_destroy(T4);
-            T4 = T5;
         }
 
         zarray_destroy(correspondences);
     }
 
-    if (T4) {
-        float T4_00 = MATD_EL(T4, 0, 0), T4_01 = MATD_EL(T4, 0, 1), T4_02 = MATD_EL(T4, 0, 2);
-        float T4_10 = MATD_EL(T4, 1, 0), T4_11 = MATD_EL(T4, 1, 1), T4_12 = MATD_EL(T4, 1, 2);
-        float T4_20 = MATD_EL(T4, 2, 0), T4_21 = MATD_EL(T4, 2, 1), T4_22 = MATD_EL(T4, 2, 2);
+    return ok;
+}
+
+void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float z_rotation,
+                         float x_translation, float y_translation,
+                         float zoom, float fov, float *corners)
+{
+    // Create a tmp copy of the image to pull pixels from.
+    size_t size = image_size(img);
+    void *data = fb_alloc(size, FB_ALLOC_NO_HINT);
+    memcpy(data, img->data, size);
+    memset(img->data, 0, size);
+
+#ifndef STM32IPL
+    umm_init_x(fb_avail());
+#endif // STM32IPL
+
+    int w = img->w;
+    int h = img->h;
+    float T4[9]; // STM32IPL
+
+    if (imlib_rotation_corr_transform(w, h, x_rotation, y_rotation, z_rotation, x_translation, y_translation,
+                                      zoom, fov, corners, T4)) { // STM32IPL
+        float T4_00 = T4[0], T4_01 = T4[1], T4_02 = T4[2]; // STM32IPL
+        float T4_10 = T4[3], T4_11 = T4[4], T4_12 = T4[5]; // STM32IPL
+        float T4_20 = T4[6], T4_21 = T4[7], T4_22 = T4[8]; // STM32IPL
 
 			if ((fast_fabsf(T4_20) < MATD_EPS) && (fast_fabsf(T4_21) < MATD_EPS)) { // warp affine
             T4_00 /= T4_22;
@@ -9838,20 +9963,8 @@ void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float
             }
         }
 
-        matd_destroy(T4);
     }
 
-    matd_destroy(T3);
-    matd_destroy(T2);
-    matd_destroy(T1);
-    matd_destroy(A2);
-    matd_destroy(T);
-    matd_destroy(R);
-    matd_destroy(RZ);
-    matd_destroy(RY);
-    matd_destroy(RX);
-    matd_destroy(A1);
-
 #ifndef STM32IPL
     fb_free(); // umm_init_x();
 #endif // STM32IPL
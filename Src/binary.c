@@ -13,23 +13,33 @@
 #include "mve_binary.h"
 #endif
 #ifdef IMLIB_ENABLE_BINARY_OPS
-void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, bool zero, image_t *mask)
+// STM32IPL: lut parameter added; when not NULL, it is the bitmap of the RGB565 values selected by the thresholds
+// (invert applied), in which the RGB565 pixels (and the RGB888 ones, reduced to RGB565) are looked up.
+void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, bool zero, image_t *mask,
+                  const uint32_t *lut)
 {
     list_lnk_t *it = iterator_start_from_head(thresholds);
+#ifdef BINARY_RGB888_LEGACY
+    if (img->bpp != IMAGE_BPP_RGB565) lut = NULL; // STM32IPL
+#else
+    if ((img->bpp != IMAGE_BPP_RGB565) && (img->bpp != IMAGE_BPP_RGB888)) lut = NULL; // STM32IPL
+#endif
 #ifdef IPL_BINARY_HAS_MVE
-    if (NULL == iterator_next(it)) {
+    if ((!lut) && (NULL == iterator_next(it))) { // STM32IPL
         color_thresholds_list_lnk_data_t lnk_data;
         iterator_get(thresholds, it, &lnk_data);
         switch(img->bpp) {
             case IMAGE_BPP_GRAYSCALE:
                 mve_imlib_binary_grayscale(out, img, &lnk_data, invert, zero, mask);
                 return;
+#ifdef IMLIB_ENABLE_LAB_LUT
             case IMAGE_BPP_RGB888:
                 mve_imlib_binary_rgb888(out, img, &lnk_data, invert, zero, mask);
                 return;
             case IMAGE_BPP_RGB565:
                 mve_imlib_binary_rgb565(out, img, &lnk_data, invert, zero, mask);
                 return;
+#endif
             default:
                 break;
         }
@@ -39,7 +49,62 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
     bmp.w = img->w;
     bmp.h = img->h;
     bmp.bpp = IMAGE_BPP_BINARY;
+    bmp.stride = 0;
     bmp.data = fb_alloc0(image_size(&bmp), FB_ALLOC_NO_HINT);
+    if (lut) { // STM32IPL
+        // One lookup per pixel, the bits of the binary image being built a word at a time.
+        uint16_t *tmp = NULL;
+        if (img->bpp == IMAGE_BPP_RGB888) tmp = fb_alloc(img->w * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+        for (int y = 0, yy = img->h; y < yy; y++) {
+            uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
+            uint16_t *row_ptr = tmp;
+            if (tmp) {
+                rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    tmp[x] = COLOR_R8_G8_B8_TO_RGB565(old_row_ptr[x].r, old_row_ptr[x].g, old_row_ptr[x].b);
+                }
+            } else {
+                row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+            }
+            for (int x = 0, xx = img->w; x < xx; x += UINT32_T_BITS) {
+                uint32_t word = 0;
+                for (int i = 0, ii = IM_MIN(xx - x, (int) UINT32_T_BITS); i < ii; i++) {
+                    word |= COLOR_THRESHOLD_LUT(row_ptr[x + i], lut) << i;
+                }
+                bmp_row_ptr[x >> UINT32_T_SHIFT] = word;
+            }
+        }
+        if (tmp) fb_free();
+        it = NULL;
+    } else if (it && ((img->bpp == IMAGE_BPP_RGB565) || (img->bpp == IMAGE_BPP_RGB888))) { // STM32IPL
+        // Each row is converted to LAB once, then compared with all the thresholds.
+        size_t n = list_size(thresholds);
+        color_thresholds_list_lnk_data_t *lnk_data = fb_alloc(n * sizeof(color_thresholds_list_lnk_data_t), FB_ALLOC_NO_HINT);
+        int8_t *l_row = fb_alloc(img->w * 3, FB_ALLOC_PREFER_SPEED);
+        int8_t *a_row = l_row + img->w;
+        int8_t *b_row = a_row + img->w;
+        uint16_t *tmp = NULL;
+#ifndef BINARY_RGB888_LEGACY
+        if (img->bpp == IMAGE_BPP_RGB888) tmp = fb_alloc(img->w * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+#endif
+        for (size_t i = 0; it; it = iterator_next(it), i++) {
+            iterator_get(thresholds, it, &lnk_data[i]);
+        }
+        for (int y = 0, yy = img->h; y < yy; y++) {
+            uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
+            imlib_image_to_lab_row(img, 0, y, img->w, tmp, l_row, a_row, b_row);
+            for (size_t i = 0; i < n; i++) {
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    if (COLOR_THRESHOLD_LAB(l_row[x], a_row[x], b_row[x], &lnk_data[i], invert)) {
+                        IMAGE_SET_BINARY_PIXEL_FAST(bmp_row_ptr, x);
+                    }
+                }
+            }
+        }
+        if (tmp) fb_free();
+        fb_free(); // lab rows
+        fb_free(); // thresholds
+    }
     for (; it; it = iterator_next(it)) {
         color_thresholds_list_lnk_data_t lnk_data;
         iterator_get(thresholds, it, &lnk_data);
@@ -68,36 +133,6 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                 }
                 break;
             }
-            case IMAGE_BPP_RGB565: {
-                for (int y = 0, yy = img->h; y < yy; y++) {
-                    uint16_t *old_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                    uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
-                    for (int x = 0, xx = img->w; x < xx; x++) {
-                        if (COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(old_row_ptr, x), &lnk_data, invert)) {
-                            IMAGE_SET_BINARY_PIXEL_FAST(bmp_row_ptr, x);
-                        }
-                    }
-                }
-                break;
-            }
-            case IMAGE_BPP_RGB888: { // STM32IPL
-                for (int y = 0, yy = img->h; y < yy; y++) {
-                    rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-                    uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
-                    for (int x = 0, xx = img->w; x < xx; x++) {
-                        rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(old_row_ptr, x);
-#ifndef BINARY_RGB888_LEGACY
-                        uint16_t pixel_rgb565 = COLOR_R8_G8_B8_TO_RGB565(pixel.r,pixel.g,pixel.b);
-                        if (COLOR_THRESHOLD_RGB565(pixel_rgb565, &lnk_data, invert)) {
-#else
-                        if (COLOR_THRESHOLD_RGB888(pixel, &lnk_data, invert)) {
-#endif
-                            IMAGE_SET_BINARY_PIXEL_FAST(bmp_row_ptr, x);
-                        }
-                    }
-                }
-                break;
-            }
             default: {
                 break;
             }
@@ -111,8 +146,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                     uint32_t *old_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                     uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                     uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                    uint32_t mask_word = 0; // STM32IPL
                     for (int x = 0, xx = img->w; x < xx; x++) {
-                        int pixel = ((!mask) || image_get_mask_pixel(mask, x, y))
+                        int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                             ? IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)
                             : IMAGE_GET_BINARY_PIXEL_FAST(old_row_ptr, x);
                         IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -123,9 +159,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                     uint32_t *old_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                     uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                     uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                    uint32_t mask_word = 0; // STM32IPL
                     for (int x = 0, xx = img->w; x < xx; x++) {
                         int pixel = IMAGE_GET_BINARY_PIXEL_FAST(old_row_ptr, x);
-                        if (((!mask) || image_get_mask_pixel(mask, x, y))
+                        if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                             && IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) pixel = 0;
                         IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
                     }
@@ -140,8 +177,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint8_t *old_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
-                            int pixel = ((!mask) || image_get_mask_pixel(mask, x, y))
+                            int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 ? IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)
                                 : COLOR_GRAYSCALE_TO_BINARY(IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row_ptr, x));
                             IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -152,9 +190,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint8_t *old_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
                             int pixel = COLOR_GRAYSCALE_TO_BINARY(IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row_ptr, x));
-                            if (((!mask) || image_get_mask_pixel(mask, x, y))
+                            if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 && IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) pixel = 0;
                             IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
                         }
@@ -166,8 +205,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint8_t *old_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint8_t *out_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
-                            int pixel = ((!mask) || image_get_mask_pixel(mask, x, y))
+                            int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 ? COLOR_BINARY_TO_GRAYSCALE(IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
                                 : IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row_ptr, x);
                             IMAGE_PUT_GRAYSCALE_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -178,9 +218,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint8_t *old_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint8_t *out_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
                             int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row_ptr, x);
-                            if (((!mask) || image_get_mask_pixel(mask, x, y))
+                            if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 && IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) pixel = 0;
                             IMAGE_PUT_GRAYSCALE_PIXEL_FAST(out_row_ptr, x, pixel);
                         }
@@ -196,8 +237,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint16_t *old_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
-                            int pixel = ((!mask) || image_get_mask_pixel(mask, x, y))
+                            int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 ? IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)
                                 : COLOR_RGB565_TO_BINARY(IMAGE_GET_RGB565_PIXEL_FAST(old_row_ptr, x));
                             IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -208,9 +250,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint16_t *old_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
                             int pixel = COLOR_RGB565_TO_BINARY(IMAGE_GET_RGB565_PIXEL_FAST(old_row_ptr, x));
-                            if (((!mask) || image_get_mask_pixel(mask, x, y))
+                            if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 && IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) pixel = 0;
                             IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
                         }
@@ -222,8 +265,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint16_t *old_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint16_t *out_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
-                            int pixel = ((!mask) || image_get_mask_pixel(mask, x, y))
+                            int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 ? COLOR_BINARY_TO_RGB565(IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
                                 : IMAGE_GET_RGB565_PIXEL_FAST(old_row_ptr, x);
                             IMAGE_PUT_RGB565_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -234,9 +278,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
                         uint16_t *old_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                         uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                         uint16_t *out_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(out, y);
+                        uint32_t mask_word = 0; // STM32IPL
                         for (int x = 0, xx = img->w; x < xx; x++) {
                             int pixel = IMAGE_GET_RGB565_PIXEL_FAST(old_row_ptr, x);
-                            if (((!mask) || image_get_mask_pixel(mask, x, y))
+                            if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
                                 && IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) pixel = 0;
                             IMAGE_PUT_RGB565_PIXEL_FAST(out_row_ptr, x, pixel);
                         }
@@ -252,8 +297,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
 						rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
 						uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
 						uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+						uint32_t mask_word = 0; // STM32IPL
 						for (int x = 0, xx = img->w; x < xx; x++) {
-							int pixel = ((!mask) || image_get_mask_pixel(mask, x, y)) ?
+							int pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) ?
 											IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x) :
 											COLOR_RGB888_TO_BINARY(IMAGE_GET_RGB888_PIXEL_FAST(old_row_ptr, x));
 							IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -264,9 +310,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
 						rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
 						uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
 						uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
+						uint32_t mask_word = 0; // STM32IPL
 						for (int x = 0, xx = img->w; x < xx; x++) {
 							int pixel = COLOR_RGB888_TO_BINARY(IMAGE_GET_RGB888_PIXEL_FAST(old_row_ptr, x));
-							if (((!mask) || image_get_mask_pixel(mask, x, y))
+							if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
 									&& IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
 								pixel = 0;
 							IMAGE_PUT_BINARY_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -279,8 +326,9 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
 						rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
 						uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
 						rgb888_t *out_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(out, y);
+						uint32_t mask_word = 0; // STM32IPL
 						for (int x = 0, xx = img->w; x < xx; x++) {
-							rgb888_t pixel = ((!mask) || image_get_mask_pixel(mask, x, y)) ?
+							rgb888_t pixel = ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) ?
 											COLOR_BINARY_TO_RGB888(IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) :
 											IMAGE_GET_RGB888_PIXEL_FAST(old_row_ptr, x);
 							IMAGE_PUT_RGB888_PIXEL_FAST(out_row_ptr, x, pixel);
@@ -291,9 +339,10 @@ void imlib_binary(image_t *out, image_t *img, list_t *thresholds, bool invert, b
 						rgb888_t *old_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
 						uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
 						rgb888_t *out_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(out, y);
+						uint32_t mask_word = 0; // STM32IPL
 						for (int x = 0, xx = img->w; x < xx; x++) {
 							rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(old_row_ptr, x);
-							if (((!mask) || image_get_mask_pixel(mask, x, y))
+							if (((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))
 									&& IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x)) {
 								pixel.r = 0;
 								pixel.g = 0;
@@ -358,622 +407,425 @@ void imlib_invert(image_t *img)
     }
 }
 
-static void imlib_b_and_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+// STM32IPL: the logical operators work on the raw bytes of the lines, whatever the image format.
+#define IMLIB_B_OP_LOOP(type, expr) \
+    for (; (i + sizeof(type)) <= n; i += sizeof(type)) { \
+        type a, b; \
+        memcpy(&a, data + i, sizeof(type)); \
+        memcpy(&b, other + i, sizeof(type)); \
+        a = (expr); \
+        memcpy(data + i, &a, sizeof(type)); \
+    }
+
+#define IMLIB_B_OP_BYTES(expr) \
+    IMLIB_B_OP_LOOP(uint32_t, expr) \
+    IMLIB_B_OP_LOOP(uint8_t, expr)
+
+static uint32_t imlib_b_op_word(imlib_b_op_t op, uint32_t a, uint32_t b)
 {
-    image_t *mask = (image_t *) data;
+    switch (op) {
+        case IMLIB_B_AND: return a & b;
+        case IMLIB_B_NAND: return a & ~b;
+        case IMLIB_B_OR: return a | b;
+        case IMLIB_B_NOR: return a | ~b;
+        case IMLIB_B_XOR: return a ^ b;
+        default: return a ^ ~b;
+    }
+}
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
+// data[i] = data[i] op other[i] for n bytes, a word (a vector with MVE) at a time.
+static void imlib_b_op_bytes(uint8_t *data, const uint8_t *other, size_t n, imlib_b_op_t op)
+{
+#ifdef IPL_BINARY_HAS_MVE
+    mve_imlib_b_op(data, other, n, op);
+#else
+    size_t i = 0;
+
+    switch (op) {
+        case IMLIB_B_AND: IMLIB_B_OP_BYTES(a & b) break;
+        case IMLIB_B_NAND: IMLIB_B_OP_BYTES(a & ~b) break;
+        case IMLIB_B_OR: IMLIB_B_OP_BYTES(a | b) break;
+        case IMLIB_B_NOR: IMLIB_B_OP_BYTES(a | ~b) break;
+        case IMLIB_B_XOR: IMLIB_B_OP_BYTES(a ^ b) break;
+        default: IMLIB_B_OP_BYTES(a ^ ~b) break;
+    }
+#endif
+}
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             & IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
+typedef struct imlib_b_line_op_state {
+    imlib_b_op_t op;
+    image_t *mask;
+} imlib_b_line_op_state_t;
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             & IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
-            }
-            break;
+static void imlib_b_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+{
+    imlib_b_op_t op = ((imlib_b_line_op_state_t *) data)->op;
+    image_t *mask = ((imlib_b_line_op_state_t *) data)->mask;
+    uint8_t *row = img->data + (line * image_line_stride(img));
+
+    if (!mask) {
+        imlib_b_op_bytes(row, (uint8_t *) other, image_line_size(img), op);
+    } else if (img->bpp == IMAGE_BPP_BINARY) {
+        // The mask is applied a packed word (32 pixels) at a time.
+        uint32_t *data = (uint32_t *) row;
+        for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
+            uint32_t m = image_get_mask_word(mask, i << UINT32_T_SHIFT, line);
+            data[i] = (data[i] & ~m) | (imlib_b_op_word(op, data[i], ((uint32_t *) other)[i]) & m);
         }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             & IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
-            }
-            break;
+    } else {
+        // Every span of selected pixels is a contiguous run of bytes.
+        int pixel_size = image_line_size(img) / img->w;
+        for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) {
+            imlib_b_op_bytes(row + (sx * pixel_size), ((uint8_t *) other) + (sx * pixel_size), sn * pixel_size, op);
         }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r &= ((rgb888_t*)other)[i].r;
-					data[i].g &= ((rgb888_t*)other)[i].g;
-					data[i].b &= ((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r & pixel888_other.r;
-						pixel888.g = pixel888_data.g & pixel888_other.g;
-						pixel888.b = pixel888_data.b & pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+    }
+}
 
-        default: {
-            break;
-        }
+static void imlib_b_operation(image_t *img, const char *path, image_t *other, int scalar, image_t *mask, imlib_b_op_t op)
+{
+    // Without mask, two images whose lines are contiguous are processed as a single run of bytes.
+    if ((!path) && other && (!mask) && (!img->stride) && (!other->stride)) {
+        imlib_b_op_bytes(img->data, other->data, image_size(img), op);
+        return;
     }
+
+    imlib_b_line_op_state_t state;
+    state.op = op;
+    state.mask = mask;
+    imlib_image_operation(img, path, other, scalar, imlib_b_line_op, &state);
 }
 
 void imlib_b_and(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
 {
-    imlib_image_operation(img, path, other, scalar, imlib_b_and_line_op, mask);
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_AND); // STM32IPL
 }
 
-static void imlib_b_nand_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+void imlib_b_nand(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
 {
-    image_t *mask = (image_t *) data;
-
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ~((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             & ~IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ~((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             & ~IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_NAND); // STM32IPL
+}
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] &= ~((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             & ~IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
+void imlib_b_or(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+{
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_OR); // STM32IPL
+}
 
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r &= ~((rgb888_t*)other)[i].r;
-					data[i].g &= ~((rgb888_t*)other)[i].g;
-					data[i].b &= ~((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r & ~pixel888_other.r;
-						pixel888.g = pixel888_data.g & ~pixel888_other.g;
-						pixel888.b = pixel888_data.b & ~pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+void imlib_b_nor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+{
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_NOR); // STM32IPL
+}
 
-        default: {
-            break;
-        }
-    }
+void imlib_b_xor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+{
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_XOR); // STM32IPL
 }
 
-void imlib_b_nand(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+void imlib_b_xnor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
 {
-    imlib_image_operation(img, path, other, scalar, imlib_b_nand_line_op, mask);
+    imlib_b_operation(img, path, other, scalar, mask, IMLIB_B_XNOR); // STM32IPL
 }
 
-static void imlib_b_or_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+// STM32IPL: van Herk/Gil-Werman erosion and dilation. With the default thresholds, the erosion (dilation) of the
+// thresholded images is the minimum (maximum) of the kernel, that is separable into a horizontal and a vertical
+// pass; each pass splits the line into blocks of n = (ksize * 2) + 1 values and computes the running minimum
+// (maximum) from the start (g) and from the end (h) of each block: the result of a window is the combination of
+// the h value of its first element and of the g value of its last element, so that the cost per pixel does not
+// depend on the kernel size. The columns are processed in strips of ERODE_DILATE_STRIP_LEN columns.
+#define ERODE_DILATE_STRIP_LEN 16
+
+// Min (e_or_d == 0) or max of the windows of n values of in[0 ... len + n - 2] (values at stride distance); the
+// result of the window starting at in[i * stride] is stored to out[i * stride] (out can be in).
+static void erode_dilate_vhgw_line(uint8_t *in, int stride, int len, int n, int e_or_d, uint8_t *g, uint8_t *h,
+                                   uint8_t *out)
 {
-    image_t *mask = (image_t *) data;
+    int padded = len + n - 1;
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
+    for (int i = 0; i < padded; i += n) {
+        int end = IM_MIN(i + n, padded);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             | IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        g[i] = in[i * stride];
+        for (int j = i + 1; j < end; j++) {
+            int pixel = in[j * stride];
+            g[j] = e_or_d ? IM_MAX(g[j - 1], pixel) : IM_MIN(g[j - 1], pixel);
         }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             | IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        h[end - 1] = in[(end - 1) * stride];
+        for (int j = end - 2; j >= i; j--) {
+            int pixel = in[j * stride];
+            h[j] = e_or_d ? IM_MAX(h[j + 1], pixel) : IM_MIN(h[j + 1], pixel);
         }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             | IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r |= ((rgb888_t*)other)[i].r;
-					data[i].g |= ((rgb888_t*)other)[i].g;
-					data[i].b |= ((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r | pixel888_other.r;
-						pixel888.g = pixel888_data.g | pixel888_other.g;
-						pixel888.b = pixel888_data.b | pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+    }
 
-        default: {
-            break;
-        }
+    for (int i = 0; i < len; i++) {
+        out[i * stride] = e_or_d ? IM_MAX(h[i], g[i + n - 1]) : IM_MIN(h[i], g[i + n - 1]);
     }
 }
 
-void imlib_b_or(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+// STM32IPL: word-parallel erosion and dilation of Binary images (32 pixels per word), where the minimum
+// (maximum) is the AND (OR) of the pixels. The horizontal pass combines each line with itself shifted by 1, 2, 4...
+// pixels, so that each word covers a window twice as large at each step; the vertical pass is the van Herk/Gil-Werman
+// one, on strips of ERODE_DILATE_WORD_STRIP_LEN words (e.g. one vector of 128 bits).
+#define ERODE_DILATE_WORD_STRIP_LEN 4
+
+// out[i] = in[i] AND (OR) the word i of the line in shifted by shift pixels towards its first pixel, for the words
+// 0 ... words - 1 (out can be in); in must have (shift / 32) + 1 more readable words.
+static void erode_dilate_binary_shift_op(uint32_t *in, int words, int shift, int e_or_d, uint32_t *out)
 {
-    imlib_image_operation(img, path, other, scalar, imlib_b_or_line_op, mask);
+#ifdef IPL_BINARY_HAS_MVE
+    mve_imlib_binary_shift_op(in, words, shift, e_or_d, out);
+#else
+    int q = shift / UINT32_T_BITS;
+    int r = shift % UINT32_T_BITS;
+
+    for (int i = 0; i < words; i++) {
+        uint32_t shifted = in[i + q] >> r;
+
+        if (r) {
+            shifted |= in[i + q + 1] << (UINT32_T_BITS - r);
+        }
+
+        out[i] = e_or_d ? (in[i] | shifted) : (in[i] & shifted);
+    }
+#endif
 }
 
-static void imlib_b_nor_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+// Van Herk/Gil-Werman AND (OR) of the windows of n rows of a strip of len + n - 1 rows of
+// ERODE_DILATE_WORD_STRIP_LEN words; the result of the window starting at row i is stored to row i.
+static void erode_dilate_binary_vhgw_strip(uint32_t *strip, int len, int n, int e_or_d, uint32_t *g, uint32_t *h)
 {
-    image_t *mask = (image_t *) data;
+#ifdef IPL_BINARY_HAS_MVE
+    mve_imlib_binary_vhgw_strip(strip, len, n, e_or_d, g, h);
+#else
+    int padded = len + n - 1;
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
+    for (int i = 0; i < padded; i += n) {
+        int end = IM_MIN(i + n, padded);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ~((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             | ~IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        for (int s = 0; s < ERODE_DILATE_WORD_STRIP_LEN; s++) {
+            g[(i * ERODE_DILATE_WORD_STRIP_LEN) + s] = strip[(i * ERODE_DILATE_WORD_STRIP_LEN) + s];
+            h[((end - 1) * ERODE_DILATE_WORD_STRIP_LEN) + s] = strip[((end - 1) * ERODE_DILATE_WORD_STRIP_LEN) + s];
         }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ~((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             | ~IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
+        for (int j = i + 1; j < end; j++) {
+            for (int s = 0; s < ERODE_DILATE_WORD_STRIP_LEN; s++) {
+                int idx = (j * ERODE_DILATE_WORD_STRIP_LEN) + s;
+                g[idx] = e_or_d ? (g[idx - ERODE_DILATE_WORD_STRIP_LEN] | strip[idx])
+                                : (g[idx - ERODE_DILATE_WORD_STRIP_LEN] & strip[idx]);
             }
-            break;
         }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] |= ~((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             | ~IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
+        for (int j = end - 2; j >= i; j--) {
+            for (int s = 0; s < ERODE_DILATE_WORD_STRIP_LEN; s++) {
+                int idx = (j * ERODE_DILATE_WORD_STRIP_LEN) + s;
+                h[idx] = e_or_d ? (h[idx + ERODE_DILATE_WORD_STRIP_LEN] | strip[idx])
+                                : (h[idx + ERODE_DILATE_WORD_STRIP_LEN] & strip[idx]);
             }
-            break;
         }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r |= ~((rgb888_t*)other)[i].r;
-					data[i].g |= ~((rgb888_t*)other)[i].g;
-					data[i].b |= ~((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r | ~pixel888_other.r;
-						pixel888.g = pixel888_data.g | ~pixel888_other.g;
-						pixel888.b = pixel888_data.b | ~pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+    }
 
-        default: {
-            break;
+    for (int i = 0; i < len; i++) {
+        for (int s = 0; s < ERODE_DILATE_WORD_STRIP_LEN; s++) {
+            int idx = (i * ERODE_DILATE_WORD_STRIP_LEN) + s;
+            int last = ((i + n - 1) * ERODE_DILATE_WORD_STRIP_LEN) + s;
+            strip[idx] = e_or_d ? (h[idx] | g[last]) : (h[idx] & g[last]);
         }
     }
+#endif
 }
 
-void imlib_b_nor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+// Words of the padded line of erode_dilate_binary(), including the ones read beyond its end by the shifts.
+static int erode_dilate_binary_line_words(image_t *img, int ksize)
 {
-    imlib_image_operation(img, path, other, scalar,imlib_b_nor_line_op,  mask);
+    int n = (ksize * 2) + 1;
+    return ((img->w + (ksize * 2) + UINT32_T_BITS - 1) / UINT32_T_BITS) + (n / UINT32_T_BITS) + 1;
 }
 
-static void imlib_b_xor_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+// The borders are replicated. The horizontal pass reads img and writes dst, the vertical pass works on dst.
+static void erode_dilate_binary(image_t *img, image_t *dst, int ksize, int e_or_d)
 {
-    image_t *mask = (image_t *) data;
+    int n = (ksize * 2) + 1;
+    int words = (img->w + UINT32_T_BITS - 1) / UINT32_T_BITS;
+    int line_words = erode_dilate_binary_line_words(img, ksize);
+    int padded_words = (img->w + (ksize * 2) + UINT32_T_BITS - 1) / UINT32_T_BITS;
+    int strip_words = (img->h + (ksize * 2)) * ERODE_DILATE_WORD_STRIP_LEN;
+    uint32_t *line = fb_alloc(line_words * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+    uint32_t *strip = fb_alloc(strip_words * sizeof(uint32_t) * 3, FB_ALLOC_PREFER_SPEED);
+    uint32_t *g = strip + strip_words;
+    uint32_t *h = g + strip_words;
+    // Pixels of the last word of each line, that are kept (they are beyond the image width).
+    uint32_t last_mask = (img->w % UINT32_T_BITS) ? ((1u << (img->w % UINT32_T_BITS)) - 1) : 0xFFFFFFFF;
+
+    // Horizontal pass: the pixel x of the line is the pixel x + ksize of the padded line.
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+        uint32_t *dst_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+        int q = ksize / UINT32_T_BITS;
+        int r = ksize % UINT32_T_BITS;
+
+        memset(line, 0, line_words * sizeof(uint32_t));
+
+        for (int i = q; i < IM_MIN((words + q + 1), padded_words); i++) {
+            uint32_t word = ((i - q) < words) ? row_ptr[i - q] : 0;
+            line[i] = r ? (word << r) : word;
+
+            if (r && ((i - q - 1) >= 0) && ((i - q - 1) < words)) {
+                line[i] |= row_ptr[i - q - 1] >> (UINT32_T_BITS - r);
+            }
+        }
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
+        int first = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, 0);
+        int last = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, (img->w - 1));
+        for (int x = 0; x < ksize; x++) {
+            IMAGE_PUT_BINARY_PIXEL_FAST(line, x, first);
+            IMAGE_PUT_BINARY_PIXEL_FAST(line, (img->w + ksize + x), last);
+        }
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             ^ IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        int m = 1;
+        for (; (m * 2) <= n; m *= 2) {
+            erode_dilate_binary_shift_op(line, padded_words, m, e_or_d, line);
         }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             ^ IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        if (m < n) {
+            erode_dilate_binary_shift_op(line, padded_words, n - m, e_or_d, line);
         }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             ^ IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        // The window of the pixel x starts at the pixel x of the padded line.
+        memcpy(dst_row_ptr, line, (words - 1) * sizeof(uint32_t));
+        dst_row_ptr[words - 1] = (line[words - 1] & last_mask) | (dst_row_ptr[words - 1] & ~last_mask);
+    }
+
+    // Vertical pass.
+    for (int i0 = 0; i0 < words; i0 += ERODE_DILATE_WORD_STRIP_LEN) {
+        int strip_len = IM_MIN(ERODE_DILATE_WORD_STRIP_LEN, (words - i0));
+
+        for (int y = -ksize, yy = img->h + ksize; y < yy; y++) {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, IM_MIN(IM_MAX(y, 0), (img->h - 1)));
+            memcpy(strip + ((y + ksize) * ERODE_DILATE_WORD_STRIP_LEN), row_ptr + i0, strip_len * sizeof(uint32_t));
         }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
 
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r ^= ((rgb888_t*)other)[i].r;
-					data[i].g ^= ((rgb888_t*)other)[i].g;
-					data[i].b ^= ((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r ^ pixel888_other.r;
-						pixel888.g = pixel888_data.g ^ pixel888_other.g;
-						pixel888.b = pixel888_data.b ^ pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+        erode_dilate_binary_vhgw_strip(strip, img->h, n, e_or_d, g, h);
 
-        default: {
-            break;
+        for (int y = 0, yy = img->h; y < yy; y++) {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+            uint32_t *strip_ptr = strip + (y * ERODE_DILATE_WORD_STRIP_LEN);
+
+            for (int s = 0; s < strip_len; s++) {
+                if ((i0 + s) == (words - 1)) {
+                    row_ptr[i0 + s] = (strip_ptr[s] & last_mask) | (row_ptr[i0 + s] & ~last_mask);
+                } else {
+                    row_ptr[i0 + s] = strip_ptr[s];
+                }
+            }
         }
     }
+
+    fb_free();
+    fb_free();
 }
 
-void imlib_b_xor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
+static uint32_t imlib_erode_dilate_vhgw_space(image_t *img, int ksize)
 {
-    imlib_image_operation(img, path, other, scalar, imlib_b_xor_line_op, mask);
+    int len = IM_MAX(img->w, img->h) + (ksize * 2);
+
+    if (img->bpp == IMAGE_BPP_BINARY) {
+        return FB_ALLOC_SPACE(erode_dilate_binary_line_words(img, ksize) * sizeof(uint32_t))
+            + FB_ALLOC_SPACE((img->h + (ksize * 2)) * ERODE_DILATE_WORD_STRIP_LEN * sizeof(uint32_t) * 3);
+    }
+
+    if (img->bpp != IMAGE_BPP_GRAYSCALE) {
+        return 0;
+    }
+
+    return FB_ALLOC_SPACE(len * ERODE_DILATE_STRIP_LEN) + (FB_ALLOC_SPACE(len) * 2);
 }
 
-static void imlib_b_xnor_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
+// The borders are replicated. The horizontal pass reads img and writes dst, the vertical pass works on dst.
+static void imlib_erode_dilate_vhgw(image_t *img, image_t *dst, int ksize, int e_or_d)
 {
-    image_t *mask = (image_t *) data;
+    if (img->bpp == IMAGE_BPP_BINARY) {
+        erode_dilate_binary(img, dst, ksize, e_or_d);
+        return;
+    }
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
+    int n = (ksize * 2) + 1;
+    int len = IM_MAX(img->w, img->h) + (ksize * 2);
+    uint8_t *strip = fb_alloc(len * ERODE_DILATE_STRIP_LEN, FB_ALLOC_PREFER_SPEED);
+    uint8_t *g = fb_alloc(len, FB_ALLOC_PREFER_SPEED);
+    uint8_t *h = fb_alloc(len, FB_ALLOC_PREFER_SPEED);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_BINARY_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ~((uint32_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_BINARY_PIXEL_FAST(data, i,
-                            (IMAGE_GET_BINARY_PIXEL_FAST(data, i)
-                             ^ ~IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i)));
-                    }
-                }
-            }
-            break;
-        }
-        case IMAGE_BPP_GRAYSCALE: {
-            uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
+    // Horizontal pass.
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_GRAYSCALE_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ~((uint8_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i,
-                            (IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i)
-                             ^ ~IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        for (int x = -ksize, xx = img->w + ksize; x < xx; x++) {
+            strip[x + ksize] = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, IM_MIN(IM_MAX(x, 0), (img->w - 1)));
         }
-        case IMAGE_BPP_RGB565: {
-            uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
 
-            if(!mask) {
-                for (int i = 0, j = IMAGE_RGB565_LINE_LEN(img); i < j; i++) {
-                    data[i] ^= ~((uint16_t *) other)[i];
-                }
-            } else {
-                for (int i = 0, j = img->w; i < j; i++) {
-                    if (image_get_mask_pixel(mask, i, line)) {
-                        IMAGE_PUT_RGB565_PIXEL_FAST(data, i,
-                            (IMAGE_GET_RGB565_PIXEL_FAST(data, i)
-                             ^ ~IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i)));
-                    }
-                }
-            }
-            break;
+        erode_dilate_vhgw_line(strip, 1, img->w, n, e_or_d, g, h, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y));
+    }
+
+    // Vertical pass.
+    for (int x0 = 0, xx = img->w; x0 < xx; x0 += ERODE_DILATE_STRIP_LEN) {
+        int strip_len = IM_MIN(ERODE_DILATE_STRIP_LEN, (xx - x0));
+
+        for (int y = -ksize, yy = img->h + ksize; y < yy; y++) {
+            int row = IM_MIN(IM_MAX(y, 0), (img->h - 1));
+            memcpy(strip + ((y + ksize) * strip_len), IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, row) + x0, strip_len);
         }
-		case IMAGE_BPP_RGB888: { // STM32IPL
-			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
 
-			if (!mask) {
-				for (int i = 0, j = IMAGE_RGB888_LINE_LEN(img); i < j; i++) {
-					data[i].r ^= ~((rgb888_t*)other)[i].r;
-					data[i].g ^= ~((rgb888_t*)other)[i].g;
-					data[i].b ^= ~((rgb888_t*)other)[i].b;
-				}
-			} else {
-				rgb888_t pixel888, pixel888_data, pixel888_other;
-				for (int i = 0, j = img->w; i < j; i++) {
-					if (image_get_mask_pixel(mask, i, line)) {
-						//rgb888_t pixel888;
-						pixel888_data = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
-						pixel888_other = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
-						pixel888.r = pixel888_data.r ^ ~pixel888_other.r;
-						pixel888.g = pixel888_data.g ^ ~pixel888_other.g;
-						pixel888.b = pixel888_data.b ^ ~pixel888_other.b;
-						IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
-
-						//IMAGE_PUT_RGB888_PIXEL_FAST(data, i,
-						//		(IMAGE_GET_RGB888_PIXEL_FAST(data, i) & IMAGE_GET_RGB565_PIXEL_FAST(((rgb888_t *) other), i)));
-					}
-				}
-			}
-			break;
-		}
+        for (int s = 0; s < strip_len; s++) {
+            erode_dilate_vhgw_line(strip + s, strip_len, img->h, n, e_or_d, g, h, strip + s);
+        }
 
-        default: {
-            break;
+        for (int y = 0, yy = img->h; y < yy; y++) {
+            memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y) + x0, strip + (y * strip_len), strip_len);
         }
     }
-}
 
-void imlib_b_xnor(image_t *img, const char *path, image_t *other, int scalar, image_t *mask)
-{
-    imlib_image_operation(img, path, other, scalar, imlib_b_xnor_line_op, mask);
+    fb_free();
+    fb_free();
+    fb_free();
 }
 
-static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_d, image_t *mask)
+static void imlib_erode_dilate(image_t *img, image_t *dst, int ksize, int threshold, int e_or_d, image_t *mask)
 {
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
+
+    // STM32IPL: the default thresholds (all the kernel pixels set for the erosion, one for the dilation) of
+    // Binary and Grayscale images without mask use the van Herk/Gil-Werman minimum/maximum, when its buffers fit.
+    int n = (ksize * 2) + 1;
+    uint32_t vhgw_space = imlib_erode_dilate_vhgw_space(img, ksize);
+    if ((!mask) && (threshold == (e_or_d ? 0 : ((n * n) - 1))) && vhgw_space && (fb_avail() >= vhgw_space)) {
+        imlib_erode_dilate_vhgw(img, dst, ksize, e_or_d);
+        return;
+    }
+
+    // STM32IPL: the other paths filter dst in place, after copying the source image to it.
+    if (dst->data != img->data) {
+        image_copy_data(dst, img);
+        img = dst;
+    }
 
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
                 int acc = 0;
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
                     int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
                     IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, pixel);
 
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         continue; // Short circuit.
                     }
                     if (x > ksize && x < img->w-ksize && y >= ksize && y < img->h-ksize) { // faster
@@ -1026,18 +878,19 @@ static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_
 #ifdef IPL_BINARY_HAS_MVE
             mve_imlib_erode_dilate_grayscale(img, ksize, threshold, e_or_d, mask);
 #else
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
                 int acc = 0;
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
                     int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
 
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         continue; // Short circuit.
                     }
 
@@ -1091,18 +944,19 @@ static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
                 int acc = 0;
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
                     int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
                     IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, pixel);
 
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         continue; // Short circuit.
                     }
 
@@ -1156,7 +1010,7 @@ static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_
         }
 
 		case IMAGE_BPP_RGB888: { // STM32IPL
-			buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+			buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
 			for (int y = 0, yy = img->h; y < yy; y++) {
 				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
@@ -1165,11 +1019,12 @@ static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_
 				//int r_acc, g_acc, b_acc;
 				rgb888_t pixel888;
 
+				uint32_t mask_word = 0; // STM32IPL
 				for (int x = 0, xx = img->w; x < xx; x++) {
 					rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
 					IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, pixel);
 
-					if (mask && (!image_get_mask_pixel(mask, x, y))) {
+					if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
 						continue; // Short circuit.
 					}
 
@@ -1245,60 +1100,76 @@ static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_
     }
 }
 
-void imlib_erode(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_erode(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
     // Threshold should be equal to (((ksize*2)+1)*((ksize*2)+1))-1
     // for normal operation. E.g. for ksize==3 -> threshold==8
     // Basically you're adjusting the number of data that
     // must be set in the kernel (besides the center) for the output to be 1.
     // Erode normally requires all data to be 1.
-    imlib_erode_dilate(img, ksize, threshold, 0, mask);
+    imlib_erode_dilate(img, dst, ksize, threshold, 0, mask);
 }
 
-void imlib_dilate(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_dilate(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
     // Threshold should be equal to 0
     // for normal operation. E.g. for ksize==3 -> threshold==0
     // Basically you're adjusting the number of data that
     // must be set in the kernel (besides the center) for the output to be 1.
     // Dilate normally requires one pixel to be 1.
-    imlib_erode_dilate(img, ksize, threshold, 1, mask);
+    imlib_erode_dilate(img, dst, ksize, threshold, 1, mask);
 }
 
-void imlib_open(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_open(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
-    imlib_erode(img, ksize, (((ksize*2)+1)*((ksize*2)+1))-1 - threshold, mask);
-    imlib_dilate(img, ksize, 0 + threshold, mask);
+    imlib_erode(img, dst, ksize, (((ksize*2)+1)*((ksize*2)+1))-1 - threshold, mask);
+    imlib_dilate(dst, dst, ksize, 0 + threshold, mask);
 }
 
-void imlib_close(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_close(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
-    imlib_dilate(img, ksize, 0 + threshold, mask);
-    imlib_erode(img, ksize, (((ksize*2)+1)*((ksize*2)+1))-1 - threshold, mask);
+    imlib_dilate(img, dst, ksize, 0 + threshold, mask);
+    imlib_erode(dst, dst, ksize, (((ksize*2)+1)*((ksize*2)+1))-1 - threshold, mask);
 }
 
-void imlib_top_hat(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_top_hat(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
+    // STM32IPL: out of place, dst holds the opened image, and the difference (symmetric) is taken there.
+    if (dst->data != img->data) {
+        imlib_open(img, dst, ksize, threshold, mask);
+        imlib_difference(dst, NULL, img, 0, mask);
+        return;
+    }
+
     image_t temp;
     temp.w = img->w;
     temp.h = img->h;
     temp.bpp = img->bpp;
+    temp.stride = 0;
     temp.data = fb_alloc(image_size(img), FB_ALLOC_NO_HINT);
-    memcpy(temp.data, img->data, image_size(img));
-    imlib_open(&temp, ksize, threshold, mask);
+    image_copy_data(&temp, img); // STM32IPL
+    imlib_open(&temp, &temp, ksize, threshold, mask);
     imlib_difference(img, NULL, &temp, 0, mask);
     fb_free();
 }
 
-void imlib_black_hat(image_t *img, int ksize, int threshold, image_t *mask)
+void imlib_black_hat(image_t *img, image_t *dst, int ksize, int threshold, image_t *mask)
 {
+    // STM32IPL: out of place, dst holds the closed image, and the difference (symmetric) is taken there.
+    if (dst->data != img->data) {
+        imlib_close(img, dst, ksize, threshold, mask);
+        imlib_difference(dst, NULL, img, 0, mask);
+        return;
+    }
+
     image_t temp;
     temp.w = img->w;
     temp.h = img->h;
     temp.bpp = img->bpp;
+    temp.stride = 0;
     temp.data = fb_alloc(image_size(img), FB_ALLOC_NO_HINT);
-    memcpy(temp.data, img->data, image_size(img));
-    imlib_close(&temp, ksize, threshold, mask);
+    image_copy_data(&temp, img); // STM32IPL
+    imlib_close(&temp, &temp, ksize, threshold, mask);
     imlib_difference(img, NULL, &temp, 0, mask);
     fb_free();
 }
@@ -128,13 +128,96 @@ static float calc_roundness(float blob_a, float blob_b, float blob_c)
     return IM_DIV(roundness_min, roundness_max);
 }
 
-// STM32IPL: max_blobs parameter added.
+// STM32IPL: merges the blobs whose bounding rectangles (grown by margin) intersect; shared by imlib_find_blobs()
+// and imlib_find_blobs_rle().
+static void find_blobs_merge(list_t *out, int margin,
+                             bool (*merge_cb)(void*,find_blobs_list_lnk_data_t*,find_blobs_list_lnk_data_t*), void *merge_cb_arg,
+                             unsigned int x_hist_bins_max, unsigned int y_hist_bins_max)
+{
+    for(;;) {
+        bool merge_occured = false;
+
+        list_t out_temp;
+        list_init(&out_temp, sizeof(find_blobs_list_lnk_data_t));
+
+        while(list_size(out)) {
+            find_blobs_list_lnk_data_t lnk_blob;
+            list_pop_front(out, &lnk_blob);
+
+            for (size_t k = 0, l = list_size(out); k < l; k++) {
+                find_blobs_list_lnk_data_t tmp_blob;
+                list_pop_front(out, &tmp_blob);
+
+                rectangle_t temp;
+                temp.x = IM_MAX(IM_MIN(tmp_blob.rect.x - margin, INT16_MAX), INT16_MIN);
+                temp.y = IM_MAX(IM_MIN(tmp_blob.rect.y - margin, INT16_MAX), INT16_MIN);
+                temp.w = IM_MAX(IM_MIN(tmp_blob.rect.w + (margin * 2), INT16_MAX), 0);
+                temp.h = IM_MAX(IM_MIN(tmp_blob.rect.h + (margin * 2), INT16_MAX), 0);
+
+                if (rectangle_overlap(&(lnk_blob.rect), &temp)
+                && ((merge_cb_arg == NULL) || merge_cb(merge_cb_arg, &lnk_blob, &tmp_blob))) {
+                    // Have to merge these first before merging rects.
+                    if (x_hist_bins_max) merge_bins(lnk_blob.rect.x, lnk_blob.rect.x + lnk_blob.rect.w - 1, &lnk_blob.x_hist_bins, &lnk_blob.x_hist_bins_count,
+                                                    tmp_blob.rect.x, tmp_blob.rect.x + tmp_blob.rect.w - 1, &tmp_blob.x_hist_bins, &tmp_blob.x_hist_bins_count,
+                                                    x_hist_bins_max);
+                    if (y_hist_bins_max) merge_bins(lnk_blob.rect.y, lnk_blob.rect.y + lnk_blob.rect.h - 1, &lnk_blob.y_hist_bins, &lnk_blob.y_hist_bins_count,
+                                                    tmp_blob.rect.y, tmp_blob.rect.y + tmp_blob.rect.h - 1, &tmp_blob.y_hist_bins, &tmp_blob.y_hist_bins_count,
+                                                    y_hist_bins_max);
+                    // Merge corners...
+                    for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
+                        float z_dst = (lnk_blob.corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]) +
+                                      (lnk_blob.corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION*i]);
+                        float z_src = (tmp_blob.corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]) +
+                                      (tmp_blob.corners[i].y * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]);
+                        if (z_src < z_dst) {
+                            lnk_blob.corners[i].x = tmp_blob.corners[i].x;
+                            lnk_blob.corners[i].y = tmp_blob.corners[i].y;
+                        }
+                    }
+                    // Merge rects...
+                    rectangle_united(&(lnk_blob.rect), &(tmp_blob.rect));
+                    // Merge counters...
+                    lnk_blob.pixels += tmp_blob.pixels; // won't overflow
+                    lnk_blob.perimeter += tmp_blob.perimeter; // won't overflow
+                    lnk_blob.code |= tmp_blob.code; // won't overflow
+                    lnk_blob.count += tmp_blob.count; // won't overflow
+                    // Merge accumulators...
+                    lnk_blob.centroid_x_acc += tmp_blob.centroid_x_acc;
+                    lnk_blob.centroid_y_acc += tmp_blob.centroid_y_acc;
+                    lnk_blob.rotation_acc_x += tmp_blob.rotation_acc_x;
+                    lnk_blob.rotation_acc_y += tmp_blob.rotation_acc_y;
+                    lnk_blob.roundness_acc += tmp_blob.roundness_acc;
+                    // Compute current values...
+                    lnk_blob.centroid_x = lnk_blob.centroid_x_acc / lnk_blob.pixels;
+                    lnk_blob.centroid_y = lnk_blob.centroid_y_acc / lnk_blob.pixels;
+                    lnk_blob.rotation = fast_atan2f(lnk_blob.rotation_acc_y / lnk_blob.pixels,
+                                                    lnk_blob.rotation_acc_x / lnk_blob.pixels);
+                    lnk_blob.roundness = lnk_blob.roundness_acc / lnk_blob.pixels;
+                    merge_occured = true;
+                } else {
+                	list_push_back(out, &tmp_blob);
+                }
+            }
+            list_push_back(&out_temp, &lnk_blob);
+        }
+
+        list_copy(out, &out_temp);
+
+        if (!merge_occured) {
+            break;
+        }
+    }
+}
+
+// STM32IPL: max_blobs and lut parameters added; when not NULL, lut holds the membership bitmaps of the RGB565
+// values of each threshold (invert not applied), in which the RGB565 pixels are looked up.
 void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
                       list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
                       bool merge, int margin,
                       bool (*threshold_cb)(void*,find_blobs_list_lnk_data_t*), void *threshold_cb_arg,
                       bool (*merge_cb)(void*,find_blobs_list_lnk_data_t*,find_blobs_list_lnk_data_t*), void *merge_cb_arg,
-                      unsigned int x_hist_bins_max, unsigned int y_hist_bins_max, uint32_t max_blobs)
+                      unsigned int x_hist_bins_max, unsigned int y_hist_bins_max, uint32_t max_blobs,
+                      const uint32_t *lut)
 {
 	 int32_t max_size; // STM32IPL
 
@@ -148,6 +231,7 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
     bmp.w = ptr->w;
     bmp.h = ptr->h;
     bmp.bpp = IMAGE_BPP_BINARY;
+    bmp.stride = 0;
     bmp.data = fb_alloc0(image_size(&bmp), FB_ALLOC_NO_HINT);
 
     uint16_t *x_hist_bins = NULL;
@@ -156,6 +240,27 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
     uint16_t *y_hist_bins = NULL;
     if (y_hist_bins_max) y_hist_bins = fb_alloc(ptr->h * sizeof(uint16_t), FB_ALLOC_NO_HINT);
 
+    // STM32IPL: the RGB565 and RGB888 pixels are converted to LAB once per row and thresholded to a
+    // binary image, from which the blobs are then found as from a Binary source; this is done when the
+    // binary image and the LAB rows take at most half of the available memory, the rest is left to the lifo.
+    image_t *img = ptr;
+    image_t lab_bmp;
+    int8_t *l_row = NULL;
+    lab_bmp.w = ptr->w;
+    lab_bmp.h = ptr->h;
+    lab_bmp.bpp = IMAGE_BPP_BINARY;
+    lab_bmp.stride = 0;
+    // With the compiled thresholds, the RGB565 pixels are looked up instead, so no LAB row is needed.
+    if (lut && (ptr->bpp == IMAGE_BPP_RGB565) && ((2 * FB_ALLOC_SPACE(image_size(&lab_bmp))) <= fb_avail())) {
+        lab_bmp.data = fb_alloc(image_size(&lab_bmp), FB_ALLOC_NO_HINT);
+        img = &lab_bmp;
+    } else if (((ptr->bpp == IMAGE_BPP_RGB565) || (ptr->bpp == IMAGE_BPP_RGB888))
+    && ((2 * (FB_ALLOC_SPACE(image_size(&lab_bmp)) + FB_ALLOC_SPACE(roi->w * 3))) <= fb_avail())) {
+        lab_bmp.data = fb_alloc(image_size(&lab_bmp), FB_ALLOC_NO_HINT);
+        l_row = fb_alloc(roi->w * 3, FB_ALLOC_PREFER_SPEED);
+        img = &lab_bmp;
+    }
+
     lifo_t lifo;
     size_t lifo_len;
 
@@ -167,6 +272,10 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
     // Reserve memory to contain max_blobs objects.
     max_size = fb_avail() - max_blobs * (sizeof(list_lnk_t) + sizeof(find_blobs_list_lnk_data_t));
     if (max_size <= 0) {
+        if (l_row) fb_free(); // lab rows
+        if (img == &lab_bmp) fb_free(); // lab bitmap
+        if (y_hist_bins) fb_free();
+        if (x_hist_bins) fb_free();
         fb_free(); // bitmap
         return;
     }
@@ -182,11 +291,41 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
         color_thresholds_list_lnk_data_t lnk_data;
         iterator_get(thresholds, it, &lnk_data);
 
-        switch(ptr->bpp) {
+        if (img == &lab_bmp) { // STM32IPL
+            if (l_row) {
+                int8_t *a_row = l_row + roi->w;
+                int8_t *b_row = a_row + roi->w;
+                for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+                    uint32_t *lab_bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&lab_bmp, y);
+                    imlib_image_to_lab_row(ptr, roi->x, y, roi->w, NULL, l_row, a_row, b_row);
+                    for (int x = 0, xx = roi->w; x < xx; x++) {
+                        IMAGE_PUT_BINARY_PIXEL_FAST(lab_bmp_row_ptr, roi->x + x,
+                                                    COLOR_THRESHOLD_LAB(l_row[x], a_row[x], b_row[x], &lnk_data, false));
+                    }
+                }
+            } else {
+                const uint32_t *bits = lut + (code * COLOR_LUT_WORDS);
+                for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+                    uint32_t *lab_bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&lab_bmp, y);
+                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y) + roi->x;
+                    for (int x = 0, xx = roi->w; x < xx; x++) {
+                        IMAGE_PUT_BINARY_PIXEL_FAST(lab_bmp_row_ptr, roi->x + x, COLOR_THRESHOLD_LUT(row_ptr[x], bits));
+                    }
+                }
+            }
+            // The thresholded pixels are the ones set in the binary image.
+            lnk_data.LMin = 1;
+            lnk_data.LMax = 1;
+        }
+
+        switch(img->bpp) {
 					
             case IMAGE_BPP_BINARY: {
                 for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
-                    uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+                    if (ctx_deadline_expired()) { // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()).
+                        break;
+                    }
+                    uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                     uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                     for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
                         if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
@@ -221,7 +360,7 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
 
                             for(;;) {
                                 int left = x, right = x;
-                                uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+                                uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                                 uint32_t *bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
 
                                 while ((left > roi->x)
@@ -281,7 +420,7 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                                     if (lifo_size(&lifo) < lifo_len) {
 
                                         if (y > roi->y) {
-                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y - 1);
+                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y - 1);
                                             bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y - 1);
 
                                             bool recurse = false;
@@ -318,7 +457,7 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                                         }
 
                                         if (y < (roi->y + roi->h - 1)) {
-                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y + 1);
+                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y + 1);
                                             bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y + 1);
 
                                             bool recurse = false;
@@ -474,6 +613,9 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
             }
             case IMAGE_BPP_GRAYSCALE: {
                 for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
+                    if (ctx_deadline_expired()) { // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()).
+                        break;
+                    }
                     uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
                     uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                     for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
@@ -762,6 +904,9 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
             }
             case IMAGE_BPP_RGB565: {
                 for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
+                    if (ctx_deadline_expired()) { // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()).
+                        break;
+                    }
                     uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y);
                     uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
                     for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
@@ -1050,6 +1195,9 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
             }
             case IMAGE_BPP_RGB888: {
             	for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
+                    if (ctx_deadline_expired()) { // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()).
+                        break;
+                    }
             		rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(ptr, y);
             		uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
             		for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
@@ -1368,451 +1516,699 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
         }
 
         code += 1;
+
+        if (ctx_deadline_expired()) { // STM32IPL: the next thresholds are not searched.
+            break;
+        }
     }
 
     lifo_free(&lifo);
+    if (l_row) fb_free(); // lab rows
+    if (img == &lab_bmp) fb_free(); // lab bitmap
     if (y_hist_bins) fb_free();
     if (x_hist_bins) fb_free();
     fb_free(); // bitmap
 
     if (merge) {
-        for(;;) {
-            bool merge_occured = false;
-
-            list_t out_temp;
-            list_init(&out_temp, sizeof(find_blobs_list_lnk_data_t));
-
-            while(list_size(out)) {
-                find_blobs_list_lnk_data_t lnk_blob;
-                list_pop_front(out, &lnk_blob);
-
-                for (size_t k = 0, l = list_size(out); k < l; k++) {
-                    find_blobs_list_lnk_data_t tmp_blob;
-                    list_pop_front(out, &tmp_blob);
-
-                    rectangle_t temp;
-                    temp.x = IM_MAX(IM_MIN(tmp_blob.rect.x - margin, INT16_MAX), INT16_MIN);
-                    temp.y = IM_MAX(IM_MIN(tmp_blob.rect.y - margin, INT16_MAX), INT16_MIN);
-                    temp.w = IM_MAX(IM_MIN(tmp_blob.rect.w + (margin * 2), INT16_MAX), 0);
-                    temp.h = IM_MAX(IM_MIN(tmp_blob.rect.h + (margin * 2), INT16_MAX), 0);
-
-                    if (rectangle_overlap(&(lnk_blob.rect), &temp)
-                    && ((merge_cb_arg == NULL) || merge_cb(merge_cb_arg, &lnk_blob, &tmp_blob))) {
-                        // Have to merge these first before merging rects.
-                        if (x_hist_bins_max) merge_bins(lnk_blob.rect.x, lnk_blob.rect.x + lnk_blob.rect.w - 1, &lnk_blob.x_hist_bins, &lnk_blob.x_hist_bins_count,
-                                                        tmp_blob.rect.x, tmp_blob.rect.x + tmp_blob.rect.w - 1, &tmp_blob.x_hist_bins, &tmp_blob.x_hist_bins_count,
-                                                        x_hist_bins_max);
-                        if (y_hist_bins_max) merge_bins(lnk_blob.rect.y, lnk_blob.rect.y + lnk_blob.rect.h - 1, &lnk_blob.y_hist_bins, &lnk_blob.y_hist_bins_count,
-                                                        tmp_blob.rect.y, tmp_blob.rect.y + tmp_blob.rect.h - 1, &tmp_blob.y_hist_bins, &tmp_blob.y_hist_bins_count,
-                                                        y_hist_bins_max);
-                        // Merge corners...
-                        for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                            float z_dst = (lnk_blob.corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]) +
-                                          (lnk_blob.corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION*i]);
-                            float z_src = (tmp_blob.corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]) +
-                                          (tmp_blob.corners[i].y * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]);
-                            if (z_src < z_dst) {
-                                lnk_blob.corners[i].x = tmp_blob.corners[i].x;
-                                lnk_blob.corners[i].y = tmp_blob.corners[i].y;
-                            }
-                        }
-                        // Merge rects...
-                        rectangle_united(&(lnk_blob.rect), &(tmp_blob.rect));
-                        // Merge counters...
-                        lnk_blob.pixels += tmp_blob.pixels; // won't overflow
-                        lnk_blob.perimeter += tmp_blob.perimeter; // won't overflow
-                        lnk_blob.code |= tmp_blob.code; // won't overflow
-                        lnk_blob.count += tmp_blob.count; // won't overflow
-                        // Merge accumulators...
-                        lnk_blob.centroid_x_acc += tmp_blob.centroid_x_acc;
-                        lnk_blob.centroid_y_acc += tmp_blob.centroid_y_acc;
-                        lnk_blob.rotation_acc_x += tmp_blob.rotation_acc_x;
-                        lnk_blob.rotation_acc_y += tmp_blob.rotation_acc_y;
-                        lnk_blob.roundness_acc += tmp_blob.roundness_acc;
-                        // Compute current values...
-                        lnk_blob.centroid_x = lnk_blob.centroid_x_acc / lnk_blob.pixels;
-                        lnk_blob.centroid_y = lnk_blob.centroid_y_acc / lnk_blob.pixels;
-                        lnk_blob.rotation = fast_atan2f(lnk_blob.rotation_acc_y / lnk_blob.pixels,
-                                                        lnk_blob.rotation_acc_x / lnk_blob.pixels);
-                        lnk_blob.roundness = lnk_blob.roundness_acc / lnk_blob.pixels;
-                        merge_occured = true;
-                    } else {
-                    	list_push_back(out, &tmp_blob);
-                    }
-                }
-                list_push_back(&out_temp, &lnk_blob);
-            }
+        find_blobs_merge(out, margin, merge_cb, merge_cb_arg, x_hist_bins_max, y_hist_bins_max); // STM32IPL
+    }
+}
 
-            list_copy(out, &out_temp);
+// STM32IPL: fills a blob record from its corners and from the moments of its pixels, as imlib_find_blobs() does;
+// shared by imlib_find_blobs_rle() and the streaming blob detection.
+void imlib_find_blobs_fill(find_blobs_list_lnk_data_t *lnk_blob, const point_t *corners, int code, int blob_pixels,
+                           int blob_perimeter, int blob_cx, int blob_cy, long long blob_a, long long blob_b, long long blob_c)
+{
+    // See imlib_find_blobs() for the moments.
+    float b_mx = blob_cx / ((float) blob_pixels);
+    float b_my = blob_cy / ((float) blob_pixels);
+    int mx = fast_roundf(b_mx); // x centroid
+    int my = fast_roundf(b_my); // y centroid
+    int small_blob_a = blob_a - ((mx * blob_cx) + (mx * blob_cx)) + (blob_pixels * mx * mx);
+    int small_blob_b = blob_b - ((mx * blob_cy) + (my * blob_cx)) + (blob_pixels * mx * my);
+    int small_blob_c = blob_c - ((my * blob_cy) + (my * blob_cy)) + (blob_pixels * my * my);
+
+    memcpy(lnk_blob->corners, corners, FIND_BLOBS_CORNERS_RESOLUTION * sizeof(point_t));
+    lnk_blob->rect.x = corners[(FIND_BLOBS_CORNERS_RESOLUTION*0)/4].x; // l
+    lnk_blob->rect.y = corners[(FIND_BLOBS_CORNERS_RESOLUTION*1)/4].y; // t
+    lnk_blob->rect.w = corners[(FIND_BLOBS_CORNERS_RESOLUTION*2)/4].x - corners[(FIND_BLOBS_CORNERS_RESOLUTION*0)/4].x + 1; // r - l + 1
+    lnk_blob->rect.h = corners[(FIND_BLOBS_CORNERS_RESOLUTION*3)/4].y - corners[(FIND_BLOBS_CORNERS_RESOLUTION*1)/4].y + 1; // b - t + 1
+    lnk_blob->pixels = blob_pixels;
+    lnk_blob->perimeter = blob_perimeter;
+    lnk_blob->code = 1 << code;
+    lnk_blob->count = 1;
+    lnk_blob->centroid_x = b_mx;
+    lnk_blob->centroid_y = b_my;
+    lnk_blob->rotation = (small_blob_a != small_blob_c) ? (fast_atan2f(2 * small_blob_b, small_blob_a - small_blob_c) / 2.0f) : 0.0f;
+    lnk_blob->roundness = calc_roundness(small_blob_a, small_blob_b, small_blob_c);
+    lnk_blob->x_hist_bins_count = 0;
+    lnk_blob->x_hist_bins = NULL;
+    lnk_blob->y_hist_bins_count = 0;
+    lnk_blob->y_hist_bins = NULL;
+    // These store the current average accumulation.
+    lnk_blob->centroid_x_acc = lnk_blob->centroid_x * lnk_blob->pixels;
+    lnk_blob->centroid_y_acc = lnk_blob->centroid_y * lnk_blob->pixels;
+    lnk_blob->rotation_acc_x = cosf(lnk_blob->rotation) * lnk_blob->pixels;
+    lnk_blob->rotation_acc_y = sinf(lnk_blob->rotation) * lnk_blob->pixels;
+    lnk_blob->roundness_acc = lnk_blob->roundness * lnk_blob->pixels;
+}
 
-            if (!merge_occured) {
-                break;
-            }
+// STM32IPL: run-length connected-components engine.
+//
+// Each row of the ROI is coded once (code = 1 + index of the first threshold matched by the pixel, 0 if none) and
+// split into runs of pixels with the same code; the runs overlapping a run of the same code on the previous row are
+// joined with a union-find whose roots are the first runs of the components in raster order. The blob statistics
+// are then accumulated on the runs of each component, so only two rows are kept besides the runs, and the image is
+// read strictly in sequence.
+typedef struct blob_run {
+    int16_t l, r, y;
+    uint8_t code;
+    uint8_t done; // Set on the root once the component has been reported.
+    uint32_t parent;
+    uint32_t next; // Next run of the same component, once the components are resolved.
+    int32_t perimeter;
+} blob_run_t;
+
+typedef struct blob_runs {
+    blob_run_t *data;
+    uint32_t size;
+    uint32_t capacity;
+} blob_runs_t;
+
+#define BLOB_RUN_NONE UINT32_MAX
+
+static bool blob_runs_push(blob_runs_t *runs, int l, int r, int y, int code)
+{
+    if (runs->size == runs->capacity) {
+        uint32_t capacity = runs->capacity ? (runs->capacity * 2) : 256;
+        blob_run_t *data = xrealloc(runs->data, capacity * sizeof(blob_run_t));
+
+        if (!data) {
+            return false;
         }
+
+        runs->data = data;
+        runs->capacity = capacity;
     }
+
+    blob_run_t *run = runs->data + runs->size;
+    run->l = l;
+    run->r = r;
+    run->y = y;
+    run->code = code;
+    run->done = 0;
+    run->parent = runs->size;
+    run->next = BLOB_RUN_NONE;
+    run->perimeter = 2;
+    runs->size++;
+    return true;
 }
 
-#ifndef STM32IPL
-void imlib_flood_fill_int(image_t *out, image_t *img, int x, int y,
-                          int seed_threshold, int floating_threshold,
-                          flood_fill_call_back_t cb, void *data)
+static uint32_t blob_runs_find(blob_run_t *runs, uint32_t i)
 {
-    lifo_t lifo;
-    size_t lifo_len;
+    while (runs[i].parent != i) {
+        runs[i].parent = runs[runs[i].parent].parent;
+        i = runs[i].parent;
+    }
 
-    lifo_alloc_all(&lifo, &lifo_len, sizeof(xylr_t));
+    return i;
+}
 
-    switch(img->bpp) {
-        case IMAGE_BPP_BINARY: {
-            for(int seed_pixel = IMAGE_GET_BINARY_PIXEL(img, x, y);;) {
-                int left = x, right = x;
-                uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                uint32_t *out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
-
-                while ((left > 0)
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, left - 1))
-                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, left - 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, left - 1),
-                                      IMAGE_GET_BINARY_PIXEL_FAST(row, left), floating_threshold)) {
-                    left--;
-                }
+static void blob_runs_union(blob_run_t *runs, uint32_t a, uint32_t b)
+{
+    a = blob_runs_find(runs, a);
+    b = blob_runs_find(runs, b);
 
-                while ((right < (img->w - 1))
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, right + 1))
-                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, right + 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, right + 1),
-                                      IMAGE_GET_BINARY_PIXEL_FAST(row, right), floating_threshold)) {
-                    right++;
-                }
+    if (a < b) {
+        runs[b].parent = a;
+    } else if (b < a) {
+        runs[a].parent = b;
+    }
+}
 
-                for (int i = left; i <= right; i++) {
-                    IMAGE_SET_BINARY_PIXEL_FAST(out_row, i);
-                }
+// Number of pixels of a neighbouring row strictly inside [l, r] that are not matched by the same or by a previous
+// threshold: these are the pixels that the flood fill of imlib_find_blobs() counts as perimeter.
+int imlib_find_blobs_border(const uint8_t *codes, int l, int r, int code)
+{
+    int n = 0;
 
-                int top_left = left;
-                int bot_left = left;
-                bool break_out = false;
-                for(;;) {
-                    if (lifo_size(&lifo) < lifo_len) {
-                        uint32_t *old_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-
-                        if (y > 0) {
-                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y - 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y - 1);
-
-                            bool recurse = false;
-                            for (int i = top_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i),
-                                                      IMAGE_GET_BINARY_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                    context.b_l = bot_left;
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y - 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
+    for (int i = l + 1; i < r; i++) {
+        n += (!codes[i]) || (codes[i] > code);
+    }
 
-                        if (y < (img->h - 1)) {
-                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y + 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y + 1);
+    return n;
+}
 
-                            bool recurse = false;
-                            for (int i = bot_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i),
-                                                      IMAGE_GET_BINARY_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = top_left;
-                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y + 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
-                    }
+// Codes a row of the ROI (l_row takes 3 * roi->w bytes with the color formats, it is unused otherwise); returns
+// false when no pixel matches any threshold. When lut is not NULL, the RGB565 pixels are looked up in the membership
+// bitmaps of the thresholds (see imlib_find_blobs()) and l_row is unused with them.
+bool imlib_find_blobs_code_row(image_t *ptr, rectangle_t *roi, int y, color_thresholds_list_lnk_data_t *thr, int n,
+                               bool invert, const uint32_t *lut, int8_t *l_row, uint8_t *codes)
+{
+    bool any = false;
 
-                    if (cb) cb(img, y, left, right, data);
+    memset(codes, 0, roi->w);
 
-                    if (!lifo_size(&lifo)) {
-                        break_out = true;
-                        break;
-                    }
+    switch (ptr->bpp) {
+        case IMAGE_BPP_BINARY: {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+            int x_end = roi->x + roi->w;
+
+            for (int k = 0; k < n; k++) {
+                uint32_t m0 = COLOR_THRESHOLD_BINARY(0, &thr[k], invert) ? 0xFFFFFFFF : 0;
+                uint32_t m1 = COLOR_THRESHOLD_BINARY(1, &thr[k], invert) ? 0xFFFFFFFF : 0;
 
-                    xylr_t context;
-                    lifo_dequeue(&lifo, &context);
-                    x = context.x;
-                    y = context.y;
-                    left = context.l;
-                    right = context.r;
-                    top_left = context.t_l;
-                    bot_left = context.b_l;
+                if (!(m0 | m1)) {
+                    continue;
                 }
 
-                if (break_out) {
-                    break;
+                for (int x = roi->x & ~UINT32_T_MASK; x < x_end; x += 32) {
+                    uint32_t word = row_ptr[x >> UINT32_T_SHIFT];
+                    uint32_t match = (m1 & word) | (m0 & ~word);
+
+                    if (x < roi->x) {
+                        match &= 0xFFFFFFFF << (roi->x - x);
+                    }
+
+                    if ((x_end - x) < 32) {
+                        match &= (1U << (x_end - x)) - 1;
+                    }
+
+                    while (match) {
+                        int i = x + __builtin_ctz(match) - roi->x;
+                        if (!codes[i]) {
+                            codes[i] = k + 1;
+                            any = true;
+                        }
+                        match &= match - 1;
+                    }
                 }
             }
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            for(int seed_pixel = IMAGE_GET_GRAYSCALE_PIXEL(img, x, y);;) {
-                int left = x, right = x;
-                uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                uint32_t *out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
-
-                while ((left > 0)
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, left - 1))
-                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, left - 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, left - 1),
-                                         IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, left), floating_threshold)) {
-                    left--;
+            uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y) + roi->x;
+
+            for (int x = 0, xx = roi->w; x < xx; x++) {
+                int pixel = row_ptr[x];
+                for (int k = 0; k < n; k++) {
+                    if (COLOR_THRESHOLD_GRAYSCALE(pixel, &thr[k], invert)) {
+                        codes[x] = k + 1;
+                        any = true;
+                        break;
+                    }
                 }
-
-                while ((right < (img->w - 1))
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, right + 1))
-                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, right + 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, right + 1),
-                                         IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, right), floating_threshold)) {
-                    right++;
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB565:
+            if (lut) {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y) + roi->x;
+
+                for (int x = 0, xx = roi->w; x < xx; x++) {
+                    int pixel = row_ptr[x];
+                    for (int k = 0; k < n; k++) {
+                        if (COLOR_THRESHOLD_LUT(pixel, lut + (k * COLOR_LUT_WORDS)) ^ invert) {
+                            codes[x] = k + 1;
+                            any = true;
+                            break;
+                        }
+                    }
                 }
-
-                for (int i = left; i <= right; i++) {
-                    IMAGE_SET_BINARY_PIXEL_FAST(out_row, i);
+                break;
+            }
+            // fall through
+        case IMAGE_BPP_RGB888: {
+            int8_t *a_row = l_row + roi->w;
+            int8_t *b_row = a_row + roi->w;
+
+            imlib_image_to_lab_row(ptr, roi->x, y, roi->w, NULL, l_row, a_row, b_row);
+
+            for (int x = 0, xx = roi->w; x < xx; x++) {
+                for (int k = 0; k < n; k++) {
+                    if (COLOR_THRESHOLD_LAB(l_row[x], a_row[x], b_row[x], &thr[k], invert)) {
+                        codes[x] = k + 1;
+                        any = true;
+                        break;
+                    }
                 }
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
 
-                int top_left = left;
-                int bot_left = left;
-                bool break_out = false;
-                for(;;) {
-                    if (lifo_size(&lifo) < lifo_len) {
-                        uint8_t *old_row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-
-                        if (y > 0) {
-                            row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y - 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y - 1);
-
-                            bool recurse = false;
-                            for (int i = top_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i),
-                                                         IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                    context.b_l = bot_left;
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y - 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
+    return any;
+}
 
-                        if (y < (img->h - 1)) {
-                            row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y + 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y + 1);
+// Splits a coded row into runs, joining them with the overlapping runs of the previous row. The perimeter of the
+// runs of the previous row is completed with the pixels of this row below them.
+static bool blob_runs_add_row(blob_runs_t *runs, rectangle_t *roi, int y, const uint8_t *codes, bool any,
+                              const uint8_t *prev_codes, uint32_t prev_start, uint32_t prev_end)
+{
+    uint32_t start = runs->size;
 
-                            bool recurse = false;
-                            for (int i = bot_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i),
-                                                         IMAGE_GET_GRAYSCALE_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = top_left;
-                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y + 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
-                    }
+    for (int x = 0, xx = roi->w; any && (x < xx); ) {
+        int code = codes[x];
+
+        if (!code) {
+            x++;
+            continue;
+        }
 
-                    if (cb) cb(img, y, left, right, data);
+        int l = x;
+        while ((x < xx) && (codes[x] == code)) {
+            x++;
+        }
 
-                    if (!lifo_size(&lifo)) {
-                        break_out = true;
-                        break;
+        if (!blob_runs_push(runs, roi->x + l, roi->x + x - 1, y, code)) {
+            return false;
+        }
+
+        blob_run_t *run = runs->data + runs->size - 1;
+        run->perimeter += (y > roi->y) ? imlib_find_blobs_border(prev_codes, l, x - 1, code) : (x - l);
+    }
+
+    for (uint32_t i = prev_start; i < prev_end; i++) {
+        blob_run_t *run = runs->data + i;
+        run->perimeter += imlib_find_blobs_border(codes, run->l - roi->x, run->r - roi->x, run->code);
+    }
+
+    // The runs of both rows are sorted, so the overlaps are found in one sweep.
+    for (uint32_t i = prev_start, j = start; (i < prev_end) && (j < runs->size); ) {
+        blob_run_t *p = runs->data + i;
+        blob_run_t *c = runs->data + j;
+
+        if ((p->l <= c->r) && (c->l <= p->r) && (p->code == c->code)) {
+            blob_runs_union(runs->data, i, j);
+        }
+
+        if (p->r < c->r) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+
+    return true;
+}
+
+// Returns true when the run contains one of the pixels from which imlib_find_blobs() starts its flood fills.
+static bool blob_runs_seeded(const blob_run_t *run, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride)
+{
+    if ((run->y - roi->y) % y_stride) {
+        return false;
+    }
+
+    int x = roi->x + (run->y % x_stride);
+
+    if (x < run->l) {
+        x += ((run->l - x + x_stride - 1) / x_stride) * x_stride;
+    }
+
+    return x <= run->r;
+}
+
+// Same as imlib_find_blobs() (without the callbacks), with the blobs labeled on run-length encoded rows: the memory
+// taken scales with the number of runs (i.e. with the length of the blob edges) instead of the image size, and no
+// free memory is reserved up front. Returns false when the runs do not fit in the memory.
+// With overlapping thresholds, a pixel belongs to the first threshold that it matches; with strides greater than 1,
+// this also holds for pixels of blobs that the previous thresholds did not report. The corners tied on a row are
+// averaged in raster order instead of in the flood fill order, and the perimeter counts every edge of the runs once
+// (the flood fill counts the upper edge of a line again each time it gets back to it from the line below).
+bool imlib_find_blobs_rle(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
+                          list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
+                          bool merge, int margin, unsigned int x_hist_bins_max, unsigned int y_hist_bins_max,
+                          uint32_t max_blobs, const uint32_t *lut)
+{
+    color_thresholds_list_lnk_data_t thr[32];
+    int n = 0;
+    bool ok = true;
+
+    list_init(out, sizeof(find_blobs_list_lnk_data_t));
+
+    if (!max_blobs) {
+        return true;
+    }
+
+    for (list_lnk_t *it = iterator_start_from_head(thresholds); it && (n < 32); it = iterator_next(it)) {
+        iterator_get(thresholds, it, &thr[n++]);
+    }
+
+    uint8_t *codes = fb_alloc(roi->w * 2, FB_ALLOC_PREFER_SPEED);
+    uint8_t *prev_codes = codes + roi->w;
+
+    int8_t *l_row = NULL;
+    if (((ptr->bpp == IMAGE_BPP_RGB565) && (!lut)) || (ptr->bpp == IMAGE_BPP_RGB888)) {
+        l_row = fb_alloc(roi->w * 3, FB_ALLOC_PREFER_SPEED);
+    }
+
+    uint16_t *x_hist_bins = NULL;
+    if (x_hist_bins_max) x_hist_bins = fb_alloc((ptr->w + 1) * sizeof(uint16_t), FB_ALLOC_NO_HINT);
+
+    uint16_t *y_hist_bins = NULL;
+    if (y_hist_bins_max) y_hist_bins = fb_alloc(ptr->h * sizeof(uint16_t), FB_ALLOC_NO_HINT);
+
+    // First pass: runs and union-find.
+    blob_runs_t runs = { NULL, 0, 0 };
+    uint32_t prev_start = 0, prev_end = 0;
+
+    for (int y = roi->y, yy = roi->y + roi->h; ok && (y < yy); y++) {
+        uint8_t *tmp = prev_codes;
+        prev_codes = codes;
+        codes = tmp;
+
+        bool any = imlib_find_blobs_code_row(ptr, roi, y, thr, n, invert, lut, l_row, codes);
+        uint32_t start = runs.size;
+
+        ok = blob_runs_add_row(&runs, roi, y, codes, any, prev_codes, prev_start, prev_end);
+        prev_start = start;
+        prev_end = runs.size;
+    }
+
+    if (ok) {
+        // The last row has nothing below it.
+        for (uint32_t i = prev_start; i < prev_end; i++) {
+            runs.data[i].perimeter += runs.data[i].r - runs.data[i].l + 1;
+        }
+
+        // Second pass: every run points to its root, followed by the runs of the component in raster order.
+        for (uint32_t i = 0; i < runs.size; i++) {
+            runs.data[i].parent = runs.data[runs.data[i].parent].parent;
+        }
+
+        for (uint32_t i = runs.size; i-- > 0; ) {
+            uint32_t root = runs.data[i].parent;
+            if (root != i) {
+                runs.data[i].next = runs.data[root].next;
+                runs.data[root].next = i;
+            }
+        }
+    }
+
+    int x_max = roi->x + roi->w - 1;
+    int y_max = roi->y + roi->h - 1;
+
+    // The blobs are reported by threshold, in the raster order of the pixel from which the flood fill finds them.
+    for (int code = 1; ok && max_blobs && (code <= n); code++) {
+        for (uint32_t s = 0; max_blobs && (s < runs.size); s++) {
+            blob_run_t *seed = runs.data + s;
+
+            if ((seed->code != code) || runs.data[seed->parent].done || !blob_runs_seeded(seed, roi, x_stride, y_stride)) {
+                continue;
+            }
+
+            uint32_t root = seed->parent;
+            runs.data[root].done = 1;
+
+            float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
+            point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
+            int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
+            // These values are initialized to their maximum before we minimize.
+            for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
+                corners[i].x = (int16_t)(IM_MAX(IM_MIN(x_max * sign(cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]), x_max), 0));
+                corners[i].y = (int16_t)(IM_MAX(IM_MIN(y_max * sign(sin_table[FIND_BLOBS_ANGLE_RESOLUTION*i]), y_max), 0));
+                corners_acc[i] = (corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*i]) +
+                                 (corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION*i]);
+                corners_n[i] = 1;
+            }
+
+            int blob_pixels = 0;
+            int blob_perimeter = 0;
+            int blob_cx = 0;
+            int blob_cy = 0;
+            long long blob_a = 0;
+            long long blob_b = 0;
+            long long blob_c = 0;
+            int hist_l = x_max;
+            int hist_r = 0;
+
+            if (x_hist_bins) memset(x_hist_bins, 0, (ptr->w + 1) * sizeof(uint16_t));
+            if (y_hist_bins) memset(y_hist_bins, 0, ptr->h * sizeof(uint16_t));
+
+            for (uint32_t i = root; i != BLOB_RUN_NONE; i = runs.data[i].next) {
+                blob_run_t *run = runs.data + i;
+                int left = run->l, right = run->r, y = run->y;
+                int sum = sum_m_to_n(left, right);
+                int sum_2 = sum_2_m_to_n(left, right);
+                int cnt = right - left + 1;
+                int avg = sum / cnt;
+
+                for (int k = 0; k < FIND_BLOBS_CORNERS_RESOLUTION; k++) {
+                    int x_new = (cos_table[FIND_BLOBS_ANGLE_RESOLUTION*k] > 0) ? left :
+                                ((cos_table[FIND_BLOBS_ANGLE_RESOLUTION*k] == 0) ? avg :
+                                                                                  right);
+                    float z = (x_new * cos_table[FIND_BLOBS_ANGLE_RESOLUTION*k]) +
+                              (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION*k]);
+                    if (z < corners_acc[k]) {
+                        corners_acc[k] = z;
+                        corners[k].x = x_new;
+                        corners[k].y = y;
+                        corners_n[k] = 1;
+                    } else if (z == corners_acc[k]) {
+                        corners[k].x = cumulative_moving_average(corners[k].x, x_new, corners_n[k]);
+                        corners[k].y = cumulative_moving_average(corners[k].y, y, corners_n[k]);
+                        corners_n[k] += 1;
                     }
+                }
 
-                    xylr_t context;
-                    lifo_dequeue(&lifo, &context);
-                    x = context.x;
-                    y = context.y;
-                    left = context.l;
-                    right = context.r;
-                    top_left = context.t_l;
-                    bot_left = context.b_l;
+                blob_pixels += cnt;
+                blob_perimeter += run->perimeter;
+                blob_cx += sum;
+                blob_cy += y * cnt;
+                blob_a += sum_2;
+                blob_b += y * sum;
+                blob_c += y * y * cnt;
+
+                if (y_hist_bins) y_hist_bins[y] += cnt;
+                if (x_hist_bins) {
+                    // Differences, integrated below over the columns of the blob.
+                    x_hist_bins[left] += 1;
+                    x_hist_bins[right + 1] -= 1;
+                    hist_l = IM_MIN(hist_l, left);
+                    hist_r = IM_MAX(hist_r, right);
                 }
+            }
 
-                if (break_out) {
-                    break;
+            if (x_hist_bins) {
+                uint16_t acc = 0;
+                for (int i = hist_l; i <= hist_r; i++) {
+                    acc += x_hist_bins[i];
+                    x_hist_bins[i] = acc;
                 }
+                x_hist_bins[hist_r + 1] = 0;
             }
-            break;
+
+            find_blobs_list_lnk_data_t lnk_blob;
+            imlib_find_blobs_fill(&lnk_blob, corners, code - 1, blob_pixels, blob_perimeter,
+                                  blob_cx, blob_cy, blob_a, blob_b, blob_c);
+
+            if (((lnk_blob.rect.w * lnk_blob.rect.h) < area_threshold) || (blob_pixels < pixels_threshold)) {
+                continue;
+            }
+
+            if (x_hist_bins) {
+                bin_up(x_hist_bins, ptr->w, x_hist_bins_max, &lnk_blob.x_hist_bins, &lnk_blob.x_hist_bins_count);
+            }
+
+            if (y_hist_bins) {
+                bin_up(y_hist_bins, ptr->h, y_hist_bins_max, &lnk_blob.y_hist_bins, &lnk_blob.y_hist_bins_count);
+            }
+
+            list_push_back(out, &lnk_blob);
+            max_blobs--;
+        }
+    }
+
+    if (runs.data) xfree(runs.data);
+    if (y_hist_bins) fb_free();
+    if (x_hist_bins) fb_free();
+    if (l_row) fb_free();
+    fb_free(); // codes
+
+    if (ok && merge) {
+        find_blobs_merge(out, margin, NULL, NULL, x_hist_bins_max, y_hist_bins_max);
+    }
+
+    return ok;
+}
+
+#ifdef IMLIB_ENABLE_FLOOD_FILL
+// STM32IPL: span based flood fill. The spans already filled whose upper and lower rows are still to be scanned are
+// kept in a stack of bounded length allocated from the fb stack (instead of all the free memory). When the stack is
+// full a span is filled but not pushed, and once the stack is empty the filled region is scanned again to reach the
+// pixels next to the spans that were not pushed. The filled pixels are marked in out, which is word-packed, so the
+// rows are scanned a word at a time.
+typedef struct flood_fill_span {
+    int y, l, r;
+} flood_fill_span_t;
+
+typedef struct flood_fill_state {
+    image_t *out;
+    image_t *img;
+    image_t *mask;
+    int seed_pixel;
+    int seed_threshold;
+    int floating_threshold;
+    lifo_t lifo;
+    bool overflow;
+} flood_fill_state_t;
+
+#define FLOOD_FILL_MIN_SPANS 64
+
+static int flood_fill_spans(image_t *img)
+{
+    return IM_MAX(img->h * 2, FLOOD_FILL_MIN_SPANS);
+}
+
+uint32_t imlib_flood_fill_int_space(image_t *img)
+{
+    return FB_ALLOC_SPACE(flood_fill_spans(img) * sizeof(flood_fill_span_t));
+}
+
+static inline int flood_fill_get_pixel(image_t *img, int x, int y)
+{
+    switch(img->bpp) {
+        case IMAGE_BPP_BINARY: {
+            return IMAGE_GET_BINARY_PIXEL_FAST(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y), x);
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            return IMAGE_GET_GRAYSCALE_PIXEL_FAST(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y), x);
         }
         case IMAGE_BPP_RGB565: {
-            for(int seed_pixel = IMAGE_GET_RGB565_PIXEL(img, x, y);;) {
-                int left = x, right = x;
-                uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                uint32_t *out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y);
-
-                while ((left > 0)
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, left - 1))
-                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, left - 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, left - 1),
-                                      IMAGE_GET_RGB565_PIXEL_FAST(row, left), floating_threshold)) {
-                    left--;
-                }
+            return IMAGE_GET_RGB565_PIXEL_FAST(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), x);
+        }
+        default: {
+            return 0;
+        }
+    }
+}
 
-                while ((right < (img->w - 1))
-                && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, right + 1))
-                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, right + 1), seed_pixel, seed_threshold)
-                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, right + 1),
-                                      IMAGE_GET_RGB565_PIXEL_FAST(row, right), floating_threshold)) {
-                    right++;
-                }
+static inline bool flood_fill_bound(int bpp, int pixel0, int pixel1, int threshold)
+{
+    switch(bpp) {
+        case IMAGE_BPP_BINARY: {
+            return COLOR_BOUND_BINARY(pixel0, pixel1, threshold);
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            return COLOR_BOUND_GRAYSCALE(pixel0, pixel1, threshold);
+        }
+        case IMAGE_BPP_RGB565: {
+            return COLOR_BOUND_RGB565(pixel0, pixel1, threshold);
+        }
+        default: {
+            return false;
+        }
+    }
+}
 
-                for (int i = left; i <= right; i++) {
-                    IMAGE_SET_BINARY_PIXEL_FAST(out_row, i);
-                }
+// Returns true if the (not filled) pixel at (x, y) joins the region from its filled neighbour pixel ref.
+static inline bool flood_fill_match(flood_fill_state_t *st, int x, int y, int ref)
+{
+    int pixel = flood_fill_get_pixel(st->img, x, y);
 
-                int top_left = left;
-                int bot_left = left;
-                bool break_out = false;
-                for(;;) {
-                    if (lifo_size(&lifo) < lifo_len) {
-                        uint16_t *old_row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-
-                        if (y > 0) {
-                            row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y - 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y - 1);
-
-                            bool recurse = false;
-                            for (int i = top_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i),
-                                                      IMAGE_GET_RGB565_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                    context.b_l = bot_left;
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y - 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
+    return flood_fill_bound(st->img->bpp, pixel, st->seed_pixel, st->seed_threshold)
+        && flood_fill_bound(st->img->bpp, pixel, ref, st->floating_threshold)
+        && ((!st->mask) || image_get_mask_pixel(st->mask, x, y));
+}
 
-                        if (y < (img->h - 1)) {
-                            row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y + 1);
-                            out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y + 1);
+// Fills the span of row y grown from the pixel at x, which has already been matched, and pushes it on the stack.
+// Returns the right end of the span.
+static int flood_fill_grow(flood_fill_state_t *st, int x, int y)
+{
+    uint32_t *out_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(st->out, y);
+    int left = x, right = x;
 
-                            bool recurse = false;
-                            for (int i = bot_left; i <= right; i++) {
-                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(out_row, i))
-                                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i), seed_pixel, seed_threshold)
-                                && COLOR_BOUND_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i),
-                                                      IMAGE_GET_RGB565_PIXEL_FAST(old_row, i), floating_threshold)) {
-                                    xylr_t context;
-                                    context.x = x;
-                                    context.y = y;
-                                    context.l = left;
-                                    context.r = right;
-                                    context.t_l = top_left;
-                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                    lifo_enqueue(&lifo, &context);
-                                    x = i;
-                                    y = y + 1;
-                                    recurse = true;
-                                    break;
-                                }
-                            }
-                            if (recurse) {
-                                break;
-                            }
-                        }
-                    }
+    while ((left > 0) && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, left - 1))
+    && flood_fill_match(st, left - 1, y, flood_fill_get_pixel(st->img, left, y))) {
+        left--;
+    }
 
-                    if (cb) cb(img, y, left, right, data);
+    while ((right < (st->img->w - 1)) && (!IMAGE_GET_BINARY_PIXEL_FAST(out_row, right + 1))
+    && flood_fill_match(st, right + 1, y, flood_fill_get_pixel(st->img, right, y))) {
+        right++;
+    }
 
-                    if (!lifo_size(&lifo)) {
-                        break_out = true;
-                        break;
-                    }
+    imlib_draw_hspan(st->out, left, right, y, 1);
 
-                    xylr_t context;
-                    lifo_dequeue(&lifo, &context);
-                    x = context.x;
-                    y = context.y;
-                    left = context.l;
-                    right = context.r;
-                    top_left = context.t_l;
-                    bot_left = context.b_l;
-                }
+    if (lifo_is_not_full(&st->lifo)) {
+        flood_fill_span_t span = { .y = y, .l = left, .r = right };
+        lifo_enqueue(&st->lifo, &span);
+    } else {
+        st->overflow = true;
+    }
 
-                if (break_out) {
-                    break;
-                }
+    return right;
+}
+
+// Grows the spans of row y + dy reached from the filled pixels l to r of row y.
+static void flood_fill_scan(flood_fill_state_t *st, int y, int dy, int l, int r)
+{
+    int ny = y + dy;
+
+    if ((ny < 0) || (ny >= st->img->h)) {
+        return;
+    }
+
+    // Only the pixels not filled yet are visited.
+    for (int x = l, n; (n = image_mask_span(st->out, &x, ny, r + 1, true)); x += n) {
+        for (int i = x, ii = x + n; i < ii; i++) {
+            if (flood_fill_match(st, i, ny, flood_fill_get_pixel(st->img, i, y))) {
+                int right = flood_fill_grow(st, i, ny);
+                n = right + 1 - x;
+                break;
             }
-            break;
         }
-        default: {
-            break;
+    }
+}
+
+static void flood_fill_drain(flood_fill_state_t *st)
+{
+    while (lifo_is_not_empty(&st->lifo)) {
+        flood_fill_span_t span;
+        lifo_dequeue(&st->lifo, &span);
+        flood_fill_scan(st, span.y, -1, span.l, span.r);
+        flood_fill_scan(st, span.y, 1, span.l, span.r);
+    }
+}
+
+void imlib_flood_fill_int(image_t *out, image_t *img, int x, int y,
+                          int seed_threshold, int floating_threshold, image_t *mask)
+{
+    flood_fill_state_t st;
+
+    if ((mask && (!image_get_mask_pixel(mask, x, y)))
+    || IMAGE_GET_BINARY_PIXEL_FAST(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y), x)) {
+        return;
+    }
+
+    st.out = out;
+    st.img = img;
+    st.mask = mask;
+    st.seed_pixel = flood_fill_get_pixel(img, x, y);
+    st.seed_threshold = seed_threshold;
+    st.floating_threshold = floating_threshold;
+    st.overflow = false;
+    lifo_alloc(&st.lifo, flood_fill_spans(img), sizeof(flood_fill_span_t));
+
+    flood_fill_grow(&st, x, y);
+    flood_fill_drain(&st);
+
+    // Spans were dropped: the rows next to every filled span are scanned again until nothing is dropped.
+    while (st.overflow) {
+        st.overflow = false;
+
+        for (int yy = 0; yy < img->h; yy++) {
+            for (int xx = 0, n; (n = image_mask_span(out, &xx, yy, img->w, false)); xx += n) {
+                flood_fill_scan(&st, yy, -1, xx, xx + n - 1);
+                flood_fill_scan(&st, yy, 1, xx, xx + n - 1);
+                flood_fill_drain(&st);
+            }
         }
     }
 
-    lifo_free(&lifo);
+    lifo_free(&st.lifo);
 }
-#endif // STM32IPL
+#endif // IMLIB_ENABLE_FLOOD_FILL
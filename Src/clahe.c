@@ -329,6 +329,7 @@ void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask)
     temp.w = img->w;
     temp.h = img->h;
     temp.bpp = img->bpp;
+    temp.stride = 0;
     temp.data = fb_alloc0(pImageW * pImageH * sizeof(kz_pixel_t), FB_ALLOC_NO_HINT);
 
     switch(img->bpp) {
@@ -392,10 +393,11 @@ void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask)
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *clahe_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&temp, y + yOffset);
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x,
-                        COLOR_GRAYSCALE_TO_BINARY(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset)));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x,
+                            COLOR_GRAYSCALE_TO_BINARY(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset)));
+                    }
                 }
             }
             break;
@@ -404,10 +406,11 @@ void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask)
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *clahe_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&temp, y + yOffset);
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x,
-                        IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x,
+                            IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset));
+                    }
                 }
             }
             break;
@@ -416,13 +419,14 @@ void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask)
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *clahe_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&temp, y + yOffset);
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
-                    IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x,
-                        imlib_yuv_to_rgb(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset),
-                                         COLOR_RGB565_TO_U(pixel),
-                                         COLOR_RGB565_TO_V(pixel)));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
+                        IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x,
+                            imlib_yuv_to_rgb(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset),
+                                             COLOR_RGB565_TO_U(pixel),
+                                             COLOR_RGB565_TO_V(pixel)));
+                    }
                 }
             }
             break;
@@ -431,13 +435,13 @@ void imlib_clahe_histeq(image_t *img, float clip_limit, image_t *mask)
 			for (int y = 0, yy = img->h; y < yy; y++) {
 				uint8_t *clahe_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&temp, y + yOffset);
 				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-				for (int x = 0, xx = img->w; x < xx; x++) {
-					if (mask && (!image_get_mask_pixel(mask, x, y)))
-						continue;
-					rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
-					IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x,
-							imlib_yuv_to_rgb888(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset),
-									COLOR_RGB888_TO_U(pixel.r, pixel.g, pixel.b), COLOR_RGB888_TO_V(pixel.r, pixel.g, pixel.b)));
+				for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+					for (int x = sx, xx = sx + sn; x < xx; x++) {
+						rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
+						IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x,
+								imlib_yuv_to_rgb888(IMAGE_GET_GRAYSCALE_PIXEL_FAST(clahe_row_ptr, x + xOffset),
+										COLOR_RGB888_TO_U(pixel.r, pixel.g, pixel.b), COLOR_RGB888_TO_V(pixel.r, pixel.g, pixel.b)));
+					}
 				}
 			}
 			break;
@@ -221,12 +221,151 @@ void fifo_peek(fifo_t *ptr, void *data)
 // list //
 //////////
 
-void list_init(list_t *ptr, size_t data_len)
+// STM32IPL: list node pools.
+// Nodes are rounded up to 8 bytes, so that they keep the alignment of the heap blocks.
+#define LIST_POOL_ALIGN(x) (((x) + 7) & ~((size_t) 7))
+
+// Pool given to the lists initialized between list_pool_begin() and list_pool_end(): it is kept by the current
+// library context (see STM32Ipl_SetCtx()), so that each thread can use its own pool.
+
+/*
+ * @brief Initializes a pool of list nodes; no memory is allocated until the first node is needed.
+ * @param pool		Pool.
+ * @param data_len	Size of the data of the nodes (bytes); only the lists with this data size can use the pool.
+ * @param slab_len	Number of nodes allocated at once, when the pool is empty.
+ * @return			void.
+ */
+void list_pool_init(list_pool_t *pool, size_t data_len, size_t slab_len)
+{
+    pool->slabs = NULL;
+    pool->free_ptr = NULL;
+    pool->data_len = data_len;
+    pool->slab_len = slab_len ? slab_len : 1;
+}
+
+/*
+ * @brief Releases all the slabs of the pool at once: the nodes of the lists that use the pool are released too,
+ * so such lists must not be used anymore (they must be initialized again).
+ * @param pool		Pool.
+ * @return			void.
+ */
+void list_pool_release(list_pool_t *pool)
+{
+    while (pool->slabs) {
+        void *next = *(void **) pool->slabs;
+        xfree(pool->slabs);
+        pool->slabs = next;
+    }
+
+    pool->free_ptr = NULL;
+}
+
+/*
+ * @brief Makes the lists initialized by list_init() with the data size of the pool take their nodes from the
+ * pool, until list_pool_end() is called; so the lists built by a library function (e.g. the results of
+ * STM32Ipl_FindBlobs()) can use the pool without changing the function.
+ * @param pool		Pool.
+ * @return			void.
+ */
+void list_pool_begin(list_pool_t *pool)
+{
+    ctx_list_pool_set(pool);
+}
+
+/*
+ * @brief Stops giving the pool set with list_pool_begin() to the lists being initialized; the lists that already
+ * use it keep using it.
+ * @return			void.
+ */
+void list_pool_end(void)
+{
+    ctx_list_pool_set(NULL);
+}
+
+/*
+ * @brief Initializes a list whose nodes are taken from the given pool.
+ * @param ptr		List.
+ * @param data_len	Size of the data of the nodes (bytes); it must be the one of the pool.
+ * @param pool		Pool; if null, the nodes are allocated from the heap.
+ * @return			void.
+ */
+void list_init_pool(list_t *ptr, size_t data_len, list_pool_t *pool)
 {
     ptr->head_ptr = NULL;
     ptr->tail_ptr = NULL;
     ptr->size = 0;
     ptr->data_len = data_len;
+    ptr->pool = (pool && (pool->data_len == data_len)) ? pool : NULL;
+}
+
+/*
+ * @brief Copies the data of the nodes of the list to a contiguous buffer, in the order of the list, and releases
+ * the list (see list_free()); the list must be initialized again before being used.
+ * @param ptr		List.
+ * @param buf		Buffer, able to contain count items of the data size of the list.
+ * @param count		Maximum number of items to be copied; the exceeding nodes are released anyway.
+ * @return			Number of items copied.
+ */
+size_t list_to_buffer(list_t *ptr, void *buf, size_t count)
+{
+    size_t n = 0;
+
+    for (list_lnk_t *i = ptr->head_ptr; i && (n < count) && (n < ptr->size); i = i->next_ptr, n++) {
+        memcpy((char *) buf + (n * ptr->data_len), i->data, ptr->data_len);
+    }
+
+    list_free(ptr);
+
+    return n;
+}
+
+// Allocates a node, from the pool of the list or from the heap.
+static list_lnk_t *list_lnk_alloc(list_t *ptr)
+{
+    list_pool_t *pool = ptr->pool;
+
+    if (!pool) {
+        return (list_lnk_t *) xalloc(sizeof(list_lnk_t) + ptr->data_len);
+    }
+
+    if (!pool->free_ptr) {
+        size_t node_len = LIST_POOL_ALIGN(sizeof(list_lnk_t) + pool->data_len);
+        char *slab = (char *) xalloc(LIST_POOL_ALIGN(sizeof(void *)) + (pool->slab_len * node_len));
+
+        if (!slab) {
+            return NULL;
+        }
+
+        *(void **) slab = pool->slabs;
+        pool->slabs = slab;
+
+        for (size_t i = 0; i < pool->slab_len; i++) {
+            list_lnk_t *lnk = (list_lnk_t *) (slab + LIST_POOL_ALIGN(sizeof(void *)) + (i * node_len));
+            lnk->next_ptr = pool->free_ptr;
+            pool->free_ptr = lnk;
+        }
+    }
+
+    list_lnk_t *tmp = pool->free_ptr;
+    pool->free_ptr = tmp->next_ptr;
+
+    return tmp;
+}
+
+// Releases a node, to the pool of the list or to the heap.
+static void list_lnk_free(list_t *ptr, list_lnk_t *lnk)
+{
+    if (ptr->pool) {
+        lnk->next_ptr = ptr->pool->free_ptr;
+        ptr->pool->free_ptr = lnk;
+    } else {
+        xfree(lnk);
+    }
+}
+
+void list_init(list_t *ptr, size_t data_len)
+{
+    list_init_pool(ptr, data_len, (list_pool_t *) ctx_list_pool_get()); // STM32IPL
 }
 
 void list_copy(list_t *dst, list_t *src)
@@ -236,6 +375,15 @@ void list_copy(list_t *dst, list_t *src)
 
 void list_free(list_t *ptr)
 {
+    // STM32IPL: the nodes of a pool are given back all at once.
+    if (ptr->pool) {
+        if (ptr->size) {
+            ptr->tail_ptr->next_ptr = ptr->pool->free_ptr;
+            ptr->pool->free_ptr = ptr->head_ptr;
+        }
+        return;
+    }
+
     for (list_lnk_t *i = ptr->head_ptr; i; ) {
         list_lnk_t *j = i->next_ptr;
         xfree(i);
@@ -259,7 +407,7 @@ size_t list_size(list_t *ptr)
 
 void list_push_front(list_t *ptr, void *data)
 {
-    list_lnk_t *tmp = (list_lnk_t *) xalloc(sizeof(list_lnk_t) + ptr->data_len);
+    list_lnk_t *tmp = list_lnk_alloc(ptr); // STM32IPL
 	if (!tmp)	// STM32IPL
 		return;	// STM32IPL
 
@@ -280,7 +428,7 @@ void list_push_front(list_t *ptr, void *data)
 
 void list_push_back(list_t *ptr, void *data)
 {
-    list_lnk_t *tmp = (list_lnk_t *) xalloc(sizeof(list_lnk_t) + ptr->data_len);
+    list_lnk_t *tmp = list_lnk_alloc(ptr); // STM32IPL
 	if (!tmp)	// STM32IPL
 		return;	// STM32IPL
     memcpy(tmp->data, data, ptr->data_len);
@@ -311,7 +459,7 @@ void list_pop_front(list_t *ptr, void *data)
     }
     ptr->head_ptr = tmp->next_ptr;
     ptr->size -= 1;
-    xfree(tmp);
+    list_lnk_free(ptr, tmp); // STM32IPL
 }
 
 void list_pop_back(list_t *ptr, void *data)
@@ -325,7 +473,7 @@ void list_pop_back(list_t *ptr, void *data)
     tmp->prev_ptr->next_ptr = NULL;
     ptr->tail_ptr = tmp->prev_ptr;
     ptr->size -= 1;
-    xfree(tmp);
+    list_lnk_free(ptr, tmp); // STM32IPL
 }
 
 void list_get_front(list_t *ptr, void *data)
@@ -363,7 +511,7 @@ void list_insert(list_t *ptr, void *data, size_t index)
             index -= 1;
         }
 
-        list_lnk_t *tmp = (list_lnk_t *) xalloc(sizeof(list_lnk_t) + ptr->data_len);
+        list_lnk_t *tmp = list_lnk_alloc(ptr); // STM32IPL
 		if (!tmp)	// STM32IPL
 			return;	// STM32IPL
         memcpy(tmp->data, data, ptr->data_len);
@@ -384,7 +532,7 @@ void list_insert(list_t *ptr, void *data, size_t index)
             index -= 1;
         }
 
-        list_lnk_t *tmp = (list_lnk_t *) xalloc(sizeof(list_lnk_t) + ptr->data_len);
+        list_lnk_t *tmp = list_lnk_alloc(ptr); // STM32IPL
 		if (!tmp)	// STM32IPL
 			return;	// STM32IPL
         memcpy(tmp->data, data, ptr->data_len);
@@ -419,7 +567,7 @@ void list_remove(list_t *ptr, void *data, size_t index)
         i->prev_ptr->next_ptr = i->next_ptr;
         i->next_ptr->prev_ptr = i->prev_ptr;
         ptr->size -= 1;
-        xfree(i);
+        list_lnk_free(ptr, i); // STM32IPL
 
     } else {
 
@@ -438,7 +586,7 @@ void list_remove(list_t *ptr, void *data, size_t index)
         i->prev_ptr->next_ptr = i->next_ptr;
         i->next_ptr->prev_ptr = i->prev_ptr;
         ptr->size -= 1;
-        xfree(i);
+        list_lnk_free(ptr, i); // STM32IPL
     }
 }
 
@@ -96,15 +96,155 @@ void imlib_set_pixel(image_t *img, int x, int y, int p)
     }
 }
 
+// STM32IPL: fills the pixels x0..x1 of the line y; the span is clipped to the image once, instead of checking
+// every pixel.
+void imlib_draw_hspan(image_t *img, int x0, int x1, int y, int c)
+{
+    if ((y < 0) || (y >= img->h)) {
+        return;
+    }
+
+    x0 = IM_MAX(x0, 0);
+    x1 = IM_MIN(x1, img->w - 1);
+
+    if (x0 > x1) {
+        return;
+    }
+
+    switch(img->bpp) {
+        case IMAGE_BPP_BINARY: {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+            uint32_t value = (c & 1) ? UINT32_MAX : 0;
+            int i0 = x0 >> UINT32_T_SHIFT;
+            int i1 = x1 >> UINT32_T_SHIFT;
+            uint32_t m0 = UINT32_MAX << (x0 & UINT32_T_MASK);
+            uint32_t m1 = UINT32_MAX >> (UINT32_T_MASK - (x1 & UINT32_T_MASK));
+
+            if (i0 == i1) {
+                m0 &= m1;
+            }
+
+            row_ptr[i0] = (row_ptr[i0] & ~m0) | (value & m0);
+
+            if (i0 != i1) {
+                for (int i = i0 + 1; i < i1; i++) {
+                    row_ptr[i] = value;
+                }
+
+                row_ptr[i1] = (row_ptr[i1] & ~m1) | (value & m1);
+            }
+            break;
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            memset(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y) + x0, c, x1 - x0 + 1);
+            break;
+        }
+        case IMAGE_BPP_RGB565: {
+            uint16_t *ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y) + x0;
+#ifdef IPL_DRAW_HAS_MVE
+            span_fill_mve_rgb565(ptr, x1 - x0 + 1, c);
+#else
+            for (int n = x1 - x0 + 1; n > 0; n--) {
+                *ptr++ = c;
+            }
+#endif
+            break;
+        }
+        case IMAGE_BPP_RGB888: {
+            rgb888_t *ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y) + x0;
+#ifdef IPL_DRAW_HAS_MVE
+            span_fill_mve_rgb888((uint8_t *) ptr, x1 - x0 + 1, c);
+#else
+            rgb888_t rgb888;
+            rgb888.r = (c >> 16) & 0xFF;
+            rgb888.g = (c >> 8) & 0xFF;
+            rgb888.b = c & 0xFF;
+
+            for (int n = x1 - x0 + 1; n > 0; n--) {
+                *ptr++ = rgb888;
+            }
+#endif
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// STM32IPL: fills the pixels y0..y1 of the column x, clipped to the image once.
+void imlib_draw_vspan(image_t *img, int x, int y0, int y1, int c)
+{
+    if ((x < 0) || (x >= img->w)) {
+        return;
+    }
+
+    y0 = IM_MAX(y0, 0);
+    y1 = IM_MIN(y1, img->h - 1);
+
+    switch(img->bpp) {
+        case IMAGE_BPP_BINARY: {
+            for (int y = y0; y <= y1; y++) {
+                uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+                IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, c);
+            }
+            break;
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            for (int y = y0; y <= y1; y++) {
+                IMAGE_PUT_GRAYSCALE_PIXEL_FAST(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y), x, c);
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB565: {
+            for (int y = y0; y <= y1; y++) {
+                IMAGE_PUT_RGB565_PIXEL_FAST(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), x, c);
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB888: {
+            rgb888_t rgb888;
+            rgb888.r = (c >> 16) & 0xFF;
+            rgb888.g = (c >> 8) & 0xFF;
+            rgb888.b = c & 0xFF;
+
+            for (int y = y0; y <= y1; y++) {
+                IMAGE_PUT_RGB888_PIXEL_FAST(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y), x, rgb888);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// STM32IPL: fills the rectangle with corners (x0, y0) and (x1, y1), included, one line span at a time.
+void imlib_draw_rect_fill(image_t *img, int x0, int y0, int x1, int y1, int c)
+{
+    y0 = IM_MAX(y0, 0);
+    y1 = IM_MIN(y1, img->h - 1);
+
+    for (int y = y0; y <= y1; y++) {
+        imlib_draw_hspan(img, x0, x1, y, c);
+    }
+}
+
 // https://stackoverflow.com/questions/1201200/fast-algorithm-for-drawing-filled-circles
 static void point_fill(image_t *img, int cx, int cy, int r0, int r1, int c)
 {
+    // STM32IPL: each line of the disc is filled as a span: its half width is the integer square root of
+    // r0 * r0 - y * y, i.e. the pixels tested one by one before.
+    int r2 = r0 * r0;
+
     for (int y = r0; y <= r1; y++) {
-        for (int x = r0; x <= r1; x++) {
-            if (((x * x) + (y * y)) <= (r0 * r0)) {
-                imlib_set_pixel(img, cx + x, cy + y, c);
-            }
-        }
+        int d = r2 - (y * y);
+        int x = (int) fast_sqrtf(d);
+
+        while ((x * x) > d) x--;
+        while (((x + 1) * (x + 1)) <= d) x++;
+
+        imlib_draw_hspan(img, cx + IM_MAX(r0, -x), cx + IM_MIN(r1, x), cy + y, c);
     }
 }
 
@@ -157,38 +297,73 @@ void imlib_draw_line(image_t *img, int x0, int y0, int x1, int y1, int c, int th
 
 static void xLine(image_t *img, int x1, int x2, int y, int c)
 {
-    while (x1 <= x2) imlib_set_pixel(img, x1++, y, c);
+    imlib_draw_hspan(img, x1, x2, y, c); // STM32IPL
 }
 
 static void yLine(image_t *img, int x, int y1, int y2, int c)
 {
-    while (y1 <= y2) imlib_set_pixel(img, x, y1++, c);
+    imlib_draw_vspan(img, x, y1, y2, c); // STM32IPL
 }
 
 void imlib_draw_rectangle(image_t *img, int rx, int ry, int rw, int rh, int c, int thickness, bool fill)
 {
     if (fill) {
-
-        for (int y = ry, yy = ry + rh; y < yy; y++) {
-            for (int x = rx, xx = rx + rw; x < xx; x++) {
-                imlib_set_pixel(img, x, y, c);
-            }
-        }
-
+        imlib_draw_rect_fill(img, rx, ry, rx + rw - 1, ry + rh - 1, c); // STM32IPL
     } else if (thickness > 0) {
         int thickness0 = (thickness - 0) / 2;
         int thickness1 = (thickness - 1) / 2;
 
-        for (int i = rx - thickness0, j = rx + rw + thickness1, k = ry + rh - 1; i < j; i++) {
-            yLine(img, i, ry - thickness0, ry + thickness1, c);
-            yLine(img, i, k - thickness0, k + thickness1, c);
+        // STM32IPL: the four sides are filled as bands of line spans.
+        int k = ry + rh - 1;
+        imlib_draw_rect_fill(img, rx - thickness0, ry - thickness0, rx + rw + thickness1 - 1, ry + thickness1, c);
+        imlib_draw_rect_fill(img, rx - thickness0, k - thickness0, rx + rw + thickness1 - 1, k + thickness1, c);
+
+        k = rx + rw - 1;
+        imlib_draw_rect_fill(img, rx - thickness0, ry - thickness0, rx + thickness1, ry + rh + thickness1 - 1, c);
+        imlib_draw_rect_fill(img, k - thickness0, ry - thickness0, k + thickness1, ry + rh + thickness1 - 1, c);
+    }
+}
+
+// STM32IPL: fills a polygon by scanlines (even-odd rule): the pixel centers of each line between a pair of edge
+// crossings are filled as a span (top-left rule: the right and lower borders are excluded).
+void imlib_fill_polygon(image_t *img, const point_t *points, int n, int c)
+{
+    int y_min = points[0].y, y_max = points[0].y;
+
+    for (int i = 1; i < n; i++) {
+        y_min = IM_MIN(y_min, points[i].y);
+        y_max = IM_MAX(y_max, points[i].y);
+    }
+
+    y_min = IM_MAX(y_min, 0);
+    y_max = IM_MIN(y_max, img->h);
+
+    float *nodes = fb_alloc(n * sizeof(float), FB_ALLOC_NO_HINT);
+
+    for (int y = y_min; y < y_max; y++) {
+        int n_nodes = 0;
+
+        for (int i = 0, j = n - 1; i < n; j = i++) {
+            int yi = points[i].y, yj = points[j].y;
+
+            if (((yi <= y) && (y < yj)) || ((yj <= y) && (y < yi))) {
+                float x = points[i].x + (((float) (y - yi) * (points[j].x - points[i].x)) / (yj - yi));
+                int k = n_nodes++;
+
+                for (; (k > 0) && (nodes[k - 1] > x); k--) {
+                    nodes[k] = nodes[k - 1];
+                }
+
+                nodes[k] = x;
+            }
         }
 
-        for (int i = ry - thickness0, j = ry + rh + thickness1, k = rx + rw - 1; i < j; i++) {
-            xLine(img, rx - thickness0, rx + thickness1, i, c);
-            xLine(img, k - thickness0, k + thickness1, i, c);
+        for (int i = 0; (i + 1) < n_nodes; i += 2) {
+            imlib_draw_hspan(img, fast_ceilf(nodes[i]), fast_ceilf(nodes[i + 1]) - 1, y, c);
         }
     }
+
+    fb_free();
 }
 
 // https://stackoverflow.com/questions/27755514/circle-with-thickness-drawing-algorithm
@@ -491,6 +666,7 @@ void imlib_draw_row_setup(imlib_draw_row_data_t *data)
     temp.w = data->dst_img->w;
     temp.h = data->dst_img->h;
     temp.bpp = data->src_img_bpp;
+    temp.stride = 0;
 
     // Image Row Size should be the width of the destination image
     // but with the bpp of the source image.
@@ -2736,6 +2912,7 @@ void imlib_draw_image(image_t *dst_img, image_t *src_img, int dst_x_start, int d
         new_src_img.w = src_img_w; // same width as source image
         new_src_img.h = src_img_h; // same height as source image
         new_src_img.bpp = color_palette ? IMAGE_BPP_RGB565 : IMAGE_BPP_GRAYSCALE;
+        new_src_img.stride = 0;
         new_src_img.data = fb_alloc(image_size(&new_src_img), FB_ALLOC_NO_HINT);
         imlib_draw_image(&new_src_img, src_img, 0, 0, 1.f, 1.f, NULL, rgb_channel, 256, color_palette, NULL, (image_hint_t)0, NULL, NULL); // STM32IPL added (image_hint_t) cast.
         src_img = &new_src_img;
@@ -2761,8 +2938,9 @@ void imlib_draw_image(image_t *dst_img, image_t *src_img, int dst_x_start, int d
         new_src_img.w = src_img->w; // same width as source image
         new_src_img.h = src_img->h; // same height as source image
         new_src_img.bpp = src_img->bpp;
+        new_src_img.stride = 0;
         new_src_img.data = fb_alloc(size, FB_ALLOC_NO_HINT);
-        memcpy(new_src_img.data, src_img->data, size);
+        image_copy_data(&new_src_img, src_img); // STM32IPL
         src_img = &new_src_img;
     }
 
@@ -4775,7 +4953,37 @@ void imlib_draw_image(image_t *dst_img, image_t *src_img, int dst_x_start, int d
     if (&new_src_img == src_img) fb_free();
 }
 
+#endif // STM32IPL
+
 #ifdef IMLIB_ENABLE_FLOOD_FILL
+// STM32IPL: the fb stack needed by imlib_flood_fill().
+uint32_t imlib_flood_fill_space(image_t *img)
+{
+    image_t out = { .w = img->w, .h = img->h, .bpp = IMAGE_BPP_BINARY, .stride = 0 };
+
+    return FB_ALLOC_SPACE(image_size(&out)) + imlib_flood_fill_int_space(img);
+}
+
+int imlib_flood_fill_threshold(image_t *img, float threshold) // STM32IPL
+{
+    switch(img->bpp) {
+        case IMAGE_BPP_BINARY: {
+            return fast_floorf(threshold * COLOR_BINARY_MAX);
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            return fast_floorf(threshold * COLOR_GRAYSCALE_MAX);
+        }
+        case IMAGE_BPP_RGB565: {
+            return COLOR_R5_G6_B5_TO_RGB565(fast_floorf(threshold * COLOR_R5_MAX),
+                                            fast_floorf(threshold * COLOR_G6_MAX),
+                                            fast_floorf(threshold * COLOR_B5_MAX));
+        }
+        default: {
+            return 0;
+        }
+    }
+}
+
 void imlib_flood_fill(image_t *img, int x, int y,
                       float seed_threshold, float floating_threshold,
                       int c, bool invert, bool clear_background, image_t *mask)
@@ -4785,92 +4993,23 @@ void imlib_flood_fill(image_t *img, int x, int y,
         out.w = img->w;
         out.h = img->h;
         out.bpp = IMAGE_BPP_BINARY;
+        out.stride = 0;
         out.data = fb_alloc0(image_size(&out), FB_ALLOC_NO_HINT);
 
-        if (mask) {
-            for (int y = 0, yy = out.h; y < yy; y++) {
-                uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&out, y);
-                for (int x = 0, xx = out.w; x < xx; x++) {
-                    if (image_get_mask_pixel(mask, x, y)) IMAGE_SET_BINARY_PIXEL_FAST(row_ptr, x);
-                }
-            }
-        }
-
-        int color_seed_threshold = 0;
-        int color_floating_threshold = 0;
+        // STM32IPL: the fill is restricted to the pixels set in the mask.
+        imlib_flood_fill_int(&out, img, x, y, imlib_flood_fill_threshold(img, seed_threshold),
+                             imlib_flood_fill_threshold(img, floating_threshold), mask);
 
-        switch(img->bpp) {
-            case IMAGE_BPP_BINARY: {
-                color_seed_threshold = fast_floorf(seed_threshold * COLOR_BINARY_MAX);
-                color_floating_threshold = fast_floorf(floating_threshold * COLOR_BINARY_MAX);
-                break;
+        // STM32IPL: the filled (or not filled, if invert) pixels are drawn a span at a time.
+        for (int y = 0, yy = out.h; y < yy; y++) {
+            for (int x = 0, n; (n = image_mask_span(&out, &x, y, out.w, invert)); x += n) {
+                imlib_draw_hspan(img, x, x + n - 1, y, c);
             }
-            case IMAGE_BPP_GRAYSCALE: {
-                color_seed_threshold = fast_floorf(seed_threshold * COLOR_GRAYSCALE_MAX);
-                color_floating_threshold = fast_floorf(floating_threshold * COLOR_GRAYSCALE_MAX);
-                break;
-            }
-            case IMAGE_BPP_RGB565: {
-                color_seed_threshold = COLOR_R5_G6_B5_TO_RGB565(fast_floorf(seed_threshold * COLOR_R5_MAX),
-                                                                fast_floorf(seed_threshold * COLOR_G6_MAX),
-                                                                fast_floorf(seed_threshold * COLOR_B5_MAX));
-                color_floating_threshold = COLOR_R5_G6_B5_TO_RGB565(fast_floorf(floating_threshold * COLOR_R5_MAX),
-                                                                    fast_floorf(floating_threshold * COLOR_G6_MAX),
-                                                                    fast_floorf(floating_threshold * COLOR_B5_MAX));
-                break;
-            }
-            default: {
-                break;
-            }
-        }
-
-        imlib_flood_fill_int(&out, img, x, y, color_seed_threshold, color_floating_threshold, NULL, NULL);
 
-        switch(img->bpp) {
-            case IMAGE_BPP_BINARY: {
-                for (int y = 0, yy = out.h; y < yy; y++) {
-                    uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                    uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&out, y);
-                    for (int x = 0, xx = out.w; x < xx; x++) {
-                        if (IMAGE_GET_BINARY_PIXEL_FAST(out_row_ptr, x) ^ invert) {
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, c);
-                        } else if (clear_background) {
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, 0);
-                        }
-                    }
-                }
-                break;
-            }
-            case IMAGE_BPP_GRAYSCALE: {
-                for (int y = 0, yy = out.h; y < yy; y++) {
-                    uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                    uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&out, y);
-                    for (int x = 0, xx = out.w; x < xx; x++) {
-                        if (IMAGE_GET_BINARY_PIXEL_FAST(out_row_ptr, x) ^ invert) {
-                            IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, c);
-                        } else if (clear_background) {
-                            IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, 0);
-                        }
-                    }
+            if (clear_background) {
+                for (int x = 0, n; (n = image_mask_span(&out, &x, y, out.w, !invert)); x += n) {
+                    imlib_draw_hspan(img, x, x + n - 1, y, 0);
                 }
-                break;
-            }
-            case IMAGE_BPP_RGB565: {
-                for (int y = 0, yy = out.h; y < yy; y++) {
-                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                    uint32_t *out_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&out, y);
-                    for (int x = 0, xx = out.w; x < xx; x++) {
-                        if (IMAGE_GET_BINARY_PIXEL_FAST(out_row_ptr, x) ^ invert) {
-                            IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, c);
-                        } else if (clear_background) {
-                            IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, 0);
-                        }
-                    }
-                }
-                break;
-            }
-            default: {
-                break;
             }
         }
 
@@ -4878,4 +5017,3 @@ void imlib_flood_fill(image_t *img, int x, int y,
     }
 }
 #endif // IMLIB_ENABLE_FLOOD_FILL
-#endif // STM32IPL
@@ -19,6 +19,7 @@
 #include "draw_dewarp.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 
 struct point {
@@ -37,10 +38,23 @@ struct interpolator_ctx {
 	float a_v;
 	float b_u;
 	float b_v;
+	int32_t du_q16;
+	int32_t dv_q16;
+};
+
+struct raster_ctx {
+	draw_dewarp_pel dpel;
+	draw_dewarp_span dspan;
+	void *ctx;
 };
 
 const float rounding = 0.5;
 
+static int32_t to_q16(float v)
+{
+	return (int32_t)floorf(v * 65536.0f + 0.5f);
+}
+
 static float interpolate(float i0, float d0, float i1, float d1, float ix)
 {
 	float slope;
@@ -81,6 +95,10 @@ static void interpolator_init(struct interpolator_ctx *ictx, struct point *p1, s
 	assert(ictx->det);
 	ictx->a_u = (p2->y - p3->y) / ictx->det;
 	ictx->a_v = (p3->y - p1->y) / ictx->det;
+
+	/* u_s and v_s are affine in x: their x steps are constant over the triangle */
+	ictx->du_q16 = to_q16(ictx->a_u * (p1->u_s - p3->u_s) + ictx->a_v * (p2->u_s - p3->u_s));
+	ictx->dv_q16 = to_q16(ictx->a_u * (p1->v_s - p3->v_s) + ictx->a_v * (p2->v_s - p3->v_s));
 }
 
 static void interpolator_update(struct interpolator_ctx *ictx, int y)
@@ -93,42 +111,56 @@ static void interpolator_update(struct interpolator_ctx *ictx, int y)
 	ictx->b_v = ((p1->x - p3->x) * (y - p3->y)) / ictx->det;
 }
 
-static void draw_point(int x, int y, draw_dewarp_pel dpel, void *ctx, struct interpolator_ctx *ictx)
+static void point_uv(int x, struct interpolator_ctx *ictx, float *z_u, float *z_v)
 {
 	struct point *p1 = ictx->p1;
 	struct point *p2 = ictx->p2;
 	struct point *p3 = ictx->p3;
 	float u, v;
-	float z_u, z_v;
 
 	u = ictx->a_u * (x - p3->x) + ictx->b_u;
 	v = ictx->a_v * (x - p3->x) + ictx->b_v;
 
-	z_u = (1 - u - v) * p3->u_s + u * p1->u_s + v * p2->u_s;
-	z_v = (1 - u - v) * p3->v_s + u * p1->v_s + v * p2->v_s;
+	*z_u = (1 - u - v) * p3->u_s + u * p1->u_s + v * p2->u_s;
+	*z_v = (1 - u - v) * p3->v_s + u * p1->v_s + v * p2->v_s;
+}
+
+static void draw_point(int x, int y, struct raster_ctx *rctx, struct interpolator_ctx *ictx)
+{
+	float z_u, z_v;
 
-	dpel(ctx, x, y, z_u, z_v);
+	point_uv(x, ictx, &z_u, &z_v);
+	rctx->dpel(rctx->ctx, x, y, z_u, z_v);
 }
 
-static void scan_line_ok(struct point *p0, struct point *p1, draw_dewarp_pel dpel, void *ctx, struct interpolator_ctx *ictx)
+static void scan_line_ok(struct point *p0, struct point *p1, struct raster_ctx *rctx, struct interpolator_ctx *ictx)
 {
+	float z_u, z_v;
 	int x;
 
 	interpolator_update(ictx, p0->y);
+
+	if (rctx->dspan) {
+		/* the span start is computed as a point, then the span callback steps in fixed point */
+		point_uv(p0->x, ictx, &z_u, &z_v);
+		rctx->dspan(rctx->ctx, p0->x, p1->x, p0->y, to_q16(z_u), to_q16(z_v), ictx->du_q16, ictx->dv_q16);
+		return;
+	}
+
 	for (x = p0->x; x <= p1->x; x++) {
-		draw_point(x, p0->y, dpel, ctx, ictx);
+		draw_point(x, p0->y, rctx, ictx);
 	}
 }
 
-static void scan_line(struct point *p0, struct point *p1, draw_dewarp_pel dpel, void *ctx, struct interpolator_ctx *ictx)
+static void scan_line(struct point *p0, struct point *p1, struct raster_ctx *rctx, struct interpolator_ctx *ictx)
 {
 	if (p0->x < p1->x)
-		scan_line_ok(p0, p1, dpel, ctx, ictx);
+		scan_line_ok(p0, p1, rctx, ictx);
 	else
-		scan_line_ok(p1, p0, dpel, ctx, ictx);
+		scan_line_ok(p1, p0, rctx, ictx);
 }
 
-static void draw_triangle_fill_impl(struct point *p0, struct point *p1, struct point *p2, draw_dewarp_pel dpel, void *ctx)
+static void draw_triangle_fill_impl(struct point *p0, struct point *p1, struct point *p2, struct raster_ctx *rctx)
 {
 	struct interpolator_ctx ictx;
 	struct point ps;
@@ -144,27 +176,27 @@ static void draw_triangle_fill_impl(struct point *p0, struct point *p1, struct p
 
 	/* scan points between y0 and y1 */
 	if (p0->y == p1->y) {
-		scan_line(p0, p1, dpel, ctx, &ictx);
+		scan_line(p0, p1, rctx, &ictx);
 	} else {
 		for (y = p0->y; y <= p1->y; y++) {
 			ps.y = y;
 			ps.x = (int)(interpolate(p0->y, p0->x, p1->y, p1->x, y) + rounding);
 			pe.y = y;
 			pe.x = (int)(interpolate(p0->y, p0->x, p2->y, p2->x, y) + rounding);
-			scan_line(&ps, &pe, dpel, ctx, &ictx);
+			scan_line(&ps, &pe, rctx, &ictx);
 		}
 	}
 
 	/* scan points between y1 and y2 */
 	if (p1->y == p2->y) {
-		scan_line(p1, p2, dpel, ctx, &ictx);
+		scan_line(p1, p2, rctx, &ictx);
 	} else {
 		for (y = p1->y + 1; y <= p2->y; y++) {
 			ps.y = y;
 			ps.x = (int)(interpolate(p1->y, p1->x, p2->y, p2->x, y) + rounding);
 			pe.y = y;
 			pe.x = (int)(interpolate(p0->y, p0->x, p2->y, p2->x, y) + rounding);
-			scan_line(&ps, &pe, dpel, ctx, &ictx);
+			scan_line(&ps, &pe, rctx, &ictx);
 		}
 	}
 }
@@ -175,6 +207,26 @@ void draw_dewarp_triangle_fill(int x0, int y0, float u0_s, float v0_s, int x1, i
 	struct point p0 = point_init(x0, y0, u0_s, v0_s);
 	struct point p1 = point_init(x1, y1, u1_s, v1_s);
 	struct point p2 = point_init(x2, y2, u2_s, v2_s);
+	struct raster_ctx rctx = {
+		.dpel = dpel,
+		.dspan = NULL,
+		.ctx = ctx,
+	};
+
+	draw_triangle_fill_impl(&p0, &p1, &p2, &rctx);
+}
+
+void draw_dewarp_triangle_fill_span(int x0, int y0, float u0_s, float v0_s, int x1, int y1, float u1_s, float v1_s,
+									int x2, int y2, float u2_s, float v2_s, draw_dewarp_span dspan, void *ctx)
+{
+	struct point p0 = point_init(x0, y0, u0_s, v0_s);
+	struct point p1 = point_init(x1, y1, u1_s, v1_s);
+	struct point p2 = point_init(x2, y2, u2_s, v2_s);
+	struct raster_ctx rctx = {
+		.dpel = NULL,
+		.dspan = dspan,
+		.ctx = ctx,
+	};
 
-	draw_triangle_fill_impl(&p0, &p1, &p2, dpel, ctx);
+	draw_triangle_fill_impl(&p0, &p1, &p2, &rctx);
 }
@@ -32,9 +32,9 @@ void imlib_edge_simple(image_t *src, rectangle_t *roi, int low_thresh, int high_
     lnk_data.LMin=low_thresh;
     lnk_data.LMax=high_thresh;
     list_push_back(&thresholds, &lnk_data);
-    imlib_binary(src, src, &thresholds, false, false, NULL);
+    imlib_binary(src, src, &thresholds, false, false, NULL, NULL); // STM32IPL
     list_free(&thresholds);
-    imlib_erode(src, 1, 2, NULL);
+    imlib_erode(src, src, 1, 2, NULL);
 }
 
 void imlib_edge_canny(image_t *src, rectangle_t *roi, int low_thresh, int high_thresh)
@@ -47,8 +47,15 @@ void imlib_edge_canny(image_t *src, rectangle_t *roi, int low_thresh, int high_t
     imlib_sepconv3(src, kernel_gauss_3, 1.0f/16.0f, 0.0f);
 
     //2. Finding Image Gradients
+    // STM32IPL: the gradients of a row are collected, so that their magnitudes and directions are computed at once
+    // with fast_sqrtf_vec() and fast_atan2f_vec().
+    int n = (roi->w > 2) ? (roi->w - 2) : 0;
+    float *fvx = fb_alloc(roi->w * sizeof(float), FB_ALLOC_NO_HINT);
+    float *fvy = fb_alloc(roi->w * sizeof(float), FB_ALLOC_NO_HINT);
+    float *fg = fb_alloc(roi->w * sizeof(float), FB_ALLOC_NO_HINT);
+
     for (int gy=1, y=roi->y+1; y<roi->y+roi->h-1; y++, gy++) {
-        for (int gx=1, x=roi->x+1; x<roi->x+roi->w-1; x++, gx++) {
+        for (int j=0, x=roi->x+1; x<roi->x+roi->w-1; x++, j++) {
             int vx=0, vy=0;
             // sobel kernel in the horizontal direction
             vx  = src->data [(y-1)*w+x-1]
@@ -66,10 +73,20 @@ void imlib_edge_canny(image_t *src, rectangle_t *roi, int low_thresh, int high_t
                 - (src->data[(y+1)*w+x+0]<<1)
                 - src->data [(y+1)*w+x+1];
 
-            // Find magnitude
-            int g = (int) fast_sqrtf(vx*vx + vy*vy);
-            // Find the direction and round angle to 0, 45, 90 or 135
-            int t = (int) fast_fabsf((atan2f(vy, vx)*180.0f/M_PI));
+            fvx[j] = vx;
+            fvy[j] = abs(vy); // STM32IPL: abs(atan2(vy, vx)) == atan2(abs(vy), vx)
+            fg[j] = vx*vx + vy*vy;
+        }
+
+        // Find magnitude
+        fast_sqrtf_vec(fg, fg, n);
+        // Find the direction
+        fast_atan2f_vec(fvy, fvx, fvy, n);
+
+        for (int j=0, gx=1; j<n; j++, gx++) {
+            int g = (int) fg[j];
+            // Round angle to 0, 45, 90 or 135 (STM32IPL: fast_atan2f() gives PI in place of PI/2 when vx is 0)
+            int t = (fvx[j] == 0.0f) ? ((fvy[j] != 0.0f) ? 90 : 0) : (int) (fvy[j]*180.0f/M_PI);
             if (t < 22) {
                 t = 0;
             } else if (t < 67) {
@@ -87,6 +104,10 @@ void imlib_edge_canny(image_t *src, rectangle_t *roi, int low_thresh, int high_t
         }
     }
 
+    fb_free(); // fg
+    fb_free(); // fvy
+    fb_free(); // fvx
+
     // 3. Hysteresis Thresholding
     // 4. Non-maximum Suppression and output
     for (int gy=0, y=roi->y; y<roi->y+roi->h; y++, gy++) {
@@ -37,11 +37,12 @@ void imlib_histeq(image_t *img, image_t *mask)
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
-                    IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x,
-                        fast_floorf((s * hist[pixel - COLOR_BINARY_MIN]) + COLOR_BINARY_MIN));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
+                        IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x,
+                            fast_floorf((s * hist[pixel - COLOR_BINARY_MIN]) + COLOR_BINARY_MIN));
+                    }
                 }
             }
 
@@ -67,11 +68,12 @@ void imlib_histeq(image_t *img, image_t *mask)
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
-                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x,
-                        fast_floorf((s * hist[pixel - COLOR_GRAYSCALE_MIN]) + COLOR_GRAYSCALE_MIN));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
+                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x,
+                            fast_floorf((s * hist[pixel - COLOR_GRAYSCALE_MIN]) + COLOR_GRAYSCALE_MIN));
+                    }
                 }
             }
 
@@ -97,17 +99,18 @@ void imlib_histeq(image_t *img, image_t *mask)
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-                    int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
-                    int r = COLOR_RGB565_TO_R8(pixel);
-                    int g = COLOR_RGB565_TO_G8(pixel);
-                    int b = COLOR_RGB565_TO_B8(pixel);
-                    uint8_t y, u, v;
-                    y = (uint8_t)(((r * 9770) + (g * 19182) + (b * 3736)) >> 15); // .299*r + .587*g + .114*b
-                    u = (uint8_t)(((b << 14) - (r * 5529) - (g * 10855)) >> 15);  // -0.168736*r + -0.331264*g + 0.5*b
-                    v = (uint8_t)(((r << 14) - (g * 13682) - (b * 2664)) >> 15);  // 0.5*r + -0.418688*g + -0.081312*b
-                    IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, imlib_yuv_to_rgb(fast_floorf(s * hist[y]), u,v));
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
+                        int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
+                        int r = COLOR_RGB565_TO_R8(pixel);
+                        int g = COLOR_RGB565_TO_G8(pixel);
+                        int b = COLOR_RGB565_TO_B8(pixel);
+                        uint8_t y, u, v;
+                        y = (uint8_t)(((r * 9770) + (g * 19182) + (b * 3736)) >> 15); // .299*r + .587*g + .114*b
+                        u = (uint8_t)(((b << 14) - (r * 5529) - (g * 10855)) >> 15);  // -0.168736*r + -0.331264*g + 0.5*b
+                        v = (uint8_t)(((r << 14) - (g * 13682) - (b * 2664)) >> 15);  // 0.5*r + -0.418688*g + -0.081312*b
+                        IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, imlib_yuv_to_rgb(fast_floorf(s * hist[y]), u,v));
+                    }
                 }
             }
 
@@ -134,22 +137,23 @@ void imlib_histeq(image_t *img, image_t *mask)
 
 			for (int y = 0, yy = img->h; y < yy; y++) {
 				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-				for (int x = 0, xx = img->w; x < xx; x++) {
-					if (mask && (!image_get_mask_pixel(mask, x, y))) continue;
-					rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
+				for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, false)); sx += sn) { // STM32IPL
+					for (int x = sx, xx = sx + sn; x < xx; x++) {
+						rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
 
-					int r = pixel.r;
-					int g = pixel.g;
-					int b = pixel.b;
+						int r = pixel.r;
+						int g = pixel.g;
+						int b = pixel.b;
 
-					uint8_t y, u, v;
-					y = (uint8_t)(((r * 9770) + (g * 19182) + (b * 3736)) >> 15); // .299*r + .587*g + .114*b
-					u = (uint8_t)(((b << 14) - (r * 5529) - (g * 10855)) >> 15); // -0.168736*r + -0.331264*g + 0.5*b
-					v = (uint8_t)(((r << 14) - (g * 13682) - (b * 2664)) >> 15); // 0.5*r + -0.418688*g + -0.081312*b
+						uint8_t y, u, v;
+						y = (uint8_t)(((r * 9770) + (g * 19182) + (b * 3736)) >> 15); // .299*r + .587*g + .114*b
+						u = (uint8_t)(((b << 14) - (r * 5529) - (g * 10855)) >> 15); // -0.168736*r + -0.331264*g + 0.5*b
+						v = (uint8_t)(((r << 14) - (g * 13682) - (b * 2664)) >> 15); // 0.5*r + -0.418688*g + -0.081312*b
 
-					pixel = imlib_yuv_to_rgb888(fast_floorf(s * hist[y]), u, v);
+						pixel = imlib_yuv_to_rgb888(fast_floorf(s * hist[y]), u, v);
 
-					IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x, pixel);
+						IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x, pixel);
+					}
 				}
 			}
 
@@ -163,6 +167,67 @@ void imlib_histeq(image_t *img, image_t *mask)
     }
 }
 
+// STM32IPL: output lines of the filters. In place (dst is img), the filtered lines are kept in a ring of brows
+// line buffers and transferred to the image once no kernel reads their source line anymore; out of place, they
+// are written straight to dst, which needs neither the ring nor the transfers.
+typedef struct filter_lines {
+    image_t *dst;
+    uint8_t *ring;  // NULL out of place.
+    int brows;
+    size_t line_size;
+} filter_lines_t;
+
+static inline void filter_lines_alloc(filter_lines_t *lines, image_t *img, image_t *dst, int brows)
+{
+    lines->dst = dst;
+    lines->brows = brows;
+    lines->line_size = image_line_size(img);
+    lines->ring = (dst->data == img->data) ? fb_alloc(lines->line_size * brows, FB_ALLOC_PREFER_SPEED) : NULL;
+}
+
+// Returns the line where the output line y is written.
+static inline uint8_t *filter_lines_get(filter_lines_t *lines, int y)
+{
+    if (lines->ring) {
+        return lines->ring + ((y % lines->brows) * lines->line_size);
+    }
+
+    return lines->dst->data + (y * image_line_stride(lines->dst));
+}
+
+// Transfers the output line y (if any) to the image.
+static inline void filter_lines_put(filter_lines_t *lines, int y)
+{
+    if (lines->ring && (y >= 0)) {
+        memcpy(lines->dst->data + (y * image_line_stride(lines->dst)), filter_lines_get(lines, y), lines->line_size);
+    }
+}
+
+// Transfers the output lines from y on.
+static inline void filter_lines_flush(filter_lines_t *lines, int y)
+{
+    for (y = IM_MAX(y, 0); y < lines->dst->h; y++) {
+        filter_lines_put(lines, y);
+    }
+}
+
+static inline void filter_lines_free(filter_lines_t *lines)
+{
+    if (lines->ring) {
+        fb_free();
+    }
+}
+
+// STM32IPL: the paths without direct output filter dst in place, after copying the source image to it.
+static inline image_t *filter_in_place(image_t *img, image_t *dst)
+{
+    if (dst->data != img->data) {
+        image_copy_data(dst, img);
+    }
+
+    return dst;
+}
+
 // ksize == 0 -> 1x1 kernel
 // ksize == 1 -> 3x3 kernel
 // ...
@@ -178,27 +243,255 @@ void imlib_histeq(image_t *img, image_t *mask)
 //   much change in performance.
 //
 #ifdef IMLIB_ENABLE_MEAN
-void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset, bool invert, image_t *mask)
+// STM32IPL: running-sum mean, used when its buffers fit. The sum of the kernel rows is kept for each column and
+// updated with one row in and one row out; the kernel sum slides along the row adding one column sum and removing
+// another one, so that the cost per pixel does not depend on the kernel size. The borders are replicated as in
+// the generic path, so that the results are the same. The column sums are stored per byte for Grayscale and
+// RGB888, and per channel (R5 sums, then G6 sums, then B5 sums) for RGB565.
+
+// Returns the number of column sums per pixel, 0 when the running sums are not supported.
+static int mean_sum_channels(int bpp)
+{
+    switch (bpp) {
+        case IMAGE_BPP_GRAYSCALE:
+            return 1;
+        case IMAGE_BPP_RGB565:
+        case IMAGE_BPP_RGB888:
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+// Adds the pixels of an image row to the column sums.
+static void mean_sum_add_row(image_t *img, int y, uint16_t *col_sum)
+{
+    if (img->bpp == IMAGE_BPP_RGB565) {
+        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            int pixel = row_ptr[x];
+            col_sum[x] += COLOR_RGB565_TO_R5(pixel);
+            col_sum[xx + x] += COLOR_RGB565_TO_G6(pixel);
+            col_sum[(2 * xx) + x] += COLOR_RGB565_TO_B5(pixel);
+        }
+    } else {
+        uint8_t *row_ptr = img->data + (y * image_line_stride(img));
+
+        for (int i = 0, ii = image_line_size(img); i < ii; i++) {
+            col_sum[i] += row_ptr[i];
+        }
+    }
+}
+
+// Removes the pixels of the image row y_out from the column sums and adds the ones of the image row y_in.
+static void mean_sum_update_columns(image_t *img, int y_out, int y_in, uint16_t *col_sum)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    mve_imlib_mean_update_columns(img, img->data + (y_out * image_line_stride(img)),
+                                  img->data + (y_in * image_line_stride(img)), col_sum);
+#else
+    if (img->bpp == IMAGE_BPP_RGB565) {
+        uint16_t *out_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_out);
+        uint16_t *in_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_in);
+
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            int pixel_out = out_ptr[x], pixel_in = in_ptr[x];
+            col_sum[x] += COLOR_RGB565_TO_R5(pixel_in) - COLOR_RGB565_TO_R5(pixel_out);
+            col_sum[xx + x] += COLOR_RGB565_TO_G6(pixel_in) - COLOR_RGB565_TO_G6(pixel_out);
+            col_sum[(2 * xx) + x] += COLOR_RGB565_TO_B5(pixel_in) - COLOR_RGB565_TO_B5(pixel_out);
+        }
+    } else {
+        uint8_t *out_ptr = img->data + (y_out * image_line_stride(img));
+        uint8_t *in_ptr = img->data + (y_in * image_line_stride(img));
+
+        for (int i = 0, ii = image_line_size(img); i < ii; i++) {
+            col_sum[i] += in_ptr[i] - out_ptr[i];
+        }
+    }
+#endif
+}
+
+uint32_t imlib_mean_filter_sum_space(image_t *img, const int ksize)
+{
+    int channels = mean_sum_channels(img->bpp);
+
+    // The column sums are 16-bit wide.
+    if (!channels || ((((ksize * 2) + 1) * COLOR_R8_MAX) > UINT16_MAX)) {
+        return 0;
+    }
+
+    return FB_ALLOC_SPACE(image_line_size(img) * (ksize + 2))
+        + FB_ALLOC_SPACE(img->w * channels * sizeof(uint16_t));
+}
+
+static void imlib_mean_filter_sum(image_t *img, image_t *dst, const int ksize, bool threshold, int offset,
+                                  bool invert, image_t *mask)
+{
+    int channels = mean_sum_channels(img->bpp);
+    int32_t over32_n = 65536 / (((ksize*2)+1)*((ksize*2)+1));
+    // One more line than the generic path: the column sums still need the source line above the kernel.
+    filter_lines_t lines;
+    filter_lines_alloc(&lines, img, dst, ksize + 2);
+    uint16_t *col_sum = fb_alloc(img->w * channels * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+
+    // Distance between the sums of two consecutive pixels, and between the sums of two channels of a pixel.
+    int x_step = (img->bpp == IMAGE_BPP_RGB888) ? 3 : 1;
+    int c_step = (img->bpp == IMAGE_BPP_RGB888) ? 1 : img->w;
+
+    memset(col_sum, 0, img->w * channels * sizeof(uint16_t));
+    for (int j = -ksize; j <= ksize; j++) {
+        mean_sum_add_row(img, IM_MIN(IM_MAX(j, 0), (img->h - 1)), col_sum);
+    }
+
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        uint8_t *buf_line = filter_lines_get(&lines, y);
+        int acc[3] = {0, 0, 0};
+
+        if (y > 0) {
+            mean_sum_update_columns(img, IM_MAX(y - ksize - 1, 0), IM_MIN(y + ksize, (img->h - 1)), col_sum);
+        }
+
+        for (int c = 0; c < channels; c++) {
+            for (int k = -ksize; k <= ksize; k++) {
+                acc[c] += col_sum[(IM_MIN(IM_MAX(k, 0), (img->w - 1)) * x_step) + (c * c_step)];
+            }
+        }
+
+        uint32_t mask_word = 0; // STM32IPL
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            switch (img->bpp) {
+                case IMAGE_BPP_GRAYSCALE: {
+                    uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                    uint8_t *buf_row_ptr = buf_line;
+
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
+                        break;
+                    }
+
+                    int pixel = (int)((acc[0] * over32_n)>>16);
+
+                    if (threshold) {
+                        if (((pixel - offset) < IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)) ^ invert) {
+                            pixel = COLOR_GRAYSCALE_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_GRAYSCALE_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+                    break;
+                }
+                case IMAGE_BPP_RGB565: {
+                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                    uint16_t *buf_row_ptr = (uint16_t *) buf_line;
+
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
+                        break;
+                    }
+
+                    int r = (int)((acc[0] * over32_n)>>16);
+                    int g = (int)((acc[1] * over32_n)>>16);
+                    int b = (int)((acc[2] * over32_n)>>16);
+                    int pixel = COLOR_R5_G6_B5_TO_RGB565(r, g, b);
+
+                    if (threshold) {
+                        if (((COLOR_RGB565_TO_Y(pixel) - offset) < COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel = COLOR_RGB565_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_RGB565_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, pixel);
+                    break;
+                }
+                default: {
+                    rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                    rgb888_t *buf_row_ptr = (rgb888_t *) buf_line;
+                    rgb888_t pixel888;
+
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
+                        break;
+                    }
+
+                    // The sums follow the byte order of the pixels.
+                    ((uint8_t *) &pixel888)[0] = (uint8_t)((acc[0] * over32_n)>>16);
+                    ((uint8_t *) &pixel888)[1] = (uint8_t)((acc[1] * over32_n)>>16);
+                    ((uint8_t *) &pixel888)[2] = (uint8_t)((acc[2] * over32_n)>>16);
+
+                    if (threshold) {
+                        if (((COLOR_RGB888_TO_Y(pixel888.r, pixel888.g, pixel888.b) - offset) < COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel888.r = COLOR_R8_MAX;
+                            pixel888.g = COLOR_G8_MAX;
+                            pixel888.b = COLOR_B8_MAX;
+                        } else {
+                            pixel888.r = COLOR_R8_MIN;
+                            pixel888.g = COLOR_G8_MIN;
+                            pixel888.b = COLOR_B8_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, pixel888);
+                    break;
+                }
+            }
+
+            // Slide the kernel sums to the next pixel.
+            const uint16_t *c_in = col_sum + (IM_MIN(x + ksize + 1, (img->w - 1)) * x_step);
+            const uint16_t *c_out = col_sum + (IM_MAX(x - ksize, 0) * x_step);
+            for (int c = 0; c < channels; c++) {
+                acc[c] += c_in[c * c_step] - c_out[c * c_step];
+            }
+        }
+
+        // Transfer buffer lines...
+        filter_lines_put(&lines, y - ksize - 1);
+    }
+
+    // Copy any remaining lines from the buffer image...
+    filter_lines_flush(&lines, img->h - ksize - 1);
+
+    fb_free();
+    filter_lines_free(&lines);
+}
+
+void imlib_mean_filter(image_t *img, image_t *dst, const int ksize, bool threshold, int offset, bool invert,
+                       image_t *mask)
 {
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
 
     int32_t over32_n = 65536 / (((ksize*2)+1)*((ksize*2)+1));
 
+    // STM32IPL: Grayscale, RGB565 and RGB888 use the running sums, when their buffers fit.
+    uint32_t sum_space = imlib_mean_filter_sum_space(img, ksize);
+    if (sum_space && (fb_avail() >= sum_space)) {
+        imlib_mean_filter_sum(img, dst, ksize, threshold, offset, invert, mask);
+        return;
+    }
+
+    img = filter_in_place(img, dst);
+
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 int pixel, acc = 0;
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -254,15 +547,16 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 int pixel, acc = 0;
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -317,15 +611,16 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
         }
         case IMAGE_BPP_RGB565: {
             int pixel, r, g, b, r_acc, g_acc, b_acc;
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
 
                 r_acc = g_acc = b_acc = 0;
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -397,15 +692,16 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
             //int pixel, r, g, b, r_acc, g_acc, b_acc;
         	int r, g, b, r_acc, g_acc, b_acc;
             rgb888_t pixel888;
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
             	rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
             	rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
                 r_acc = g_acc = b_acc = 0;
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -488,28 +784,203 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
 
 #ifdef IMLIB_ENABLE_MEDIAN
 
-void imlib_median_filter(image_t *img, const int ksize, float percentile, bool threshold, int offset, bool invert, image_t *mask)
+// STM32IPL: constant-time median (Perreault-Hebert sliding histograms), used for the large kernels. A histogram
+// is kept for each column of the kernel rows and updated with one pixel in and one out per row; the kernel
+// histogram slides along the row adding one column histogram and removing another one, so that the cost per
+// pixel does not depend on the kernel size. Same bins as the generic path: 64 bins (values >> 2) for Grayscale,
+// 32/64/32 bins (R5/G6/B5) for RGB565.
+#ifndef MEDIAN_HIST_MIN_KSIZE
+#define MEDIAN_HIST_MIN_KSIZE   4       // Smallest kernel size (9x9) using the sliding histograms.
+#endif
+
+// Returns the number of histogram bins used for the given format, 0 when the sliding histograms are not supported.
+static int median_hist_bins(int bpp)
+{
+    switch (bpp) {
+        case IMAGE_BPP_GRAYSCALE:
+            return 64;
+        case IMAGE_BPP_RGB565:
+            return 32 + 64 + 32;
+        default:
+            return 0;
+    }
+}
+
+// Same selection as hist_median(), on 16-bit counters.
+static inline int hist_median_u16(const uint16_t *data, int len, const int cutoff)
+{
+    int i, sum = 0;
+
+    for (i = 0; i < len && sum < cutoff; i++) {
+        sum += data[i];
+    }
+
+    return i - 1;
+}
+
+// Adds (delta = 1) or removes (delta = -1) the pixels of an image row to the column histograms.
+static void median_hist_update_columns(image_t *img, int y, uint8_t *col_hist, int bins, int delta)
+{
+    if (img->bpp == IMAGE_BPP_GRAYSCALE) {
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+        for (int x = 0, xx = img->w; x < xx; x++, col_hist += bins) {
+            col_hist[row_ptr[x] >> 2] += delta;
+        }
+    } else {
+        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+
+        for (int x = 0, xx = img->w; x < xx; x++, col_hist += bins) {
+            int pixel = row_ptr[x];
+            col_hist[COLOR_RGB565_TO_R5(pixel)] += delta;
+            col_hist[32 + COLOR_RGB565_TO_G6(pixel)] += delta;
+            col_hist[96 + COLOR_RGB565_TO_B5(pixel)] += delta;
+        }
+    }
+}
+
+uint32_t imlib_median_filter_hist_space(image_t *img, const int ksize)
+{
+    int bins = median_hist_bins(img->bpp);
+
+    // The column counters are 8-bit wide.
+    if (!bins || (ksize < MEDIAN_HIST_MIN_KSIZE) || (((ksize * 2) + 1) > UINT8_MAX)) {
+        return 0;
+    }
+
+    return FB_ALLOC_SPACE(image_line_size(img) * (ksize + 2)) + FB_ALLOC_SPACE(img->w * bins)
+        + FB_ALLOC_SPACE(bins * sizeof(uint16_t));
+}
+
+static void imlib_median_filter_hist(image_t *img, image_t *dst, const int ksize, const int median_cutoff,
+                                     bool threshold, int offset, bool invert, image_t *mask)
+{
+    int bins = median_hist_bins(img->bpp);
+    // One more line than the generic path: the histograms still need the source line above the kernel.
+    filter_lines_t lines;
+    filter_lines_alloc(&lines, img, dst, ksize + 2);
+    uint8_t *col_hist = fb_alloc(img->w * bins, FB_ALLOC_PREFER_SPEED);
+    uint16_t *hist = fb_alloc(bins * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+
+    memset(col_hist, 0, img->w * bins);
+    for (int j = -ksize; j <= ksize; j++) {
+        median_hist_update_columns(img, IM_MIN(IM_MAX(j, 0), (img->h - 1)), col_hist, bins, 1);
+    }
+
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        if (y > 0) {
+            median_hist_update_columns(img, IM_MAX(y - ksize - 1, 0), col_hist, bins, -1);
+            median_hist_update_columns(img, IM_MIN(y + ksize, (img->h - 1)), col_hist, bins, 1);
+        }
+
+        memset(hist, 0, bins * sizeof(uint16_t));
+        for (int k = -ksize; k <= ksize; k++) {
+            const uint8_t *c = col_hist + (IM_MIN(IM_MAX(k, 0), (img->w - 1)) * bins);
+            for (int i = 0; i < bins; i++) {
+                hist[i] += c[i];
+            }
+        }
+
+        uint32_t mask_word = 0; // STM32IPL
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            if (img->bpp == IMAGE_BPP_GRAYSCALE) {
+                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                uint8_t *buf_row_ptr = filter_lines_get(&lines, y);
+
+                if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
+                } else {
+                    uint8_t pixel = hist_median_u16(hist, 64, median_cutoff);
+                    pixel <<= 2; // scale it back up
+                    if (threshold) {
+                        if (((pixel - offset) < IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)) ^ invert) {
+                            pixel = COLOR_GRAYSCALE_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_GRAYSCALE_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+                }
+            } else {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                uint16_t *buf_row_ptr = (uint16_t *) filter_lines_get(&lines, y);
+
+                if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
+                } else {
+                    uint8_t r = hist_median_u16(hist, 32, median_cutoff);
+                    uint8_t g = hist_median_u16(hist + 32, 64, median_cutoff);
+                    uint8_t b = hist_median_u16(hist + 96, 32, median_cutoff);
+
+                    int pixel = COLOR_R5_G6_B5_TO_RGB565(r, g, b);
+
+                    if (threshold) {
+                        if (((COLOR_RGB565_TO_Y(pixel) - offset) < COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel = COLOR_RGB565_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_RGB565_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, pixel);
+                }
+            }
+
+            // Slide the kernel histogram to the next pixel.
+            const uint8_t *c_in = col_hist + (IM_MIN(x + ksize + 1, (img->w - 1)) * bins);
+            const uint8_t *c_out = col_hist + (IM_MAX(x - ksize, 0) * bins);
+            for (int i = 0; i < bins; i++) {
+                hist[i] += c_in[i] - c_out[i];
+            }
+        }
+
+        // Transfer buffer lines...
+        filter_lines_put(&lines, y - ksize - 1);
+    }
+
+    // Copy any remaining lines from the buffer image...
+    filter_lines_flush(&lines, img->h - ksize - 1);
+
+    fb_free();
+    fb_free();
+    filter_lines_free(&lines);
+}
+
+void imlib_median_filter(image_t *img, image_t *dst, const int ksize, float percentile, bool threshold, int offset,
+                         bool invert, image_t *mask)
 {
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
 
     const int n = ((ksize*2)+1)*((ksize*2)+1);
     const int median_cutoff = fast_floorf(percentile * (float)n);
 
+    // STM32IPL: the large kernels use the sliding histograms, when their buffers fit.
+    uint32_t hist_space = imlib_median_filter_hist_space(img, ksize);
+    if (hist_space && (fb_avail() >= hist_space)) {
+        imlib_median_filter_hist(img, dst, ksize, median_cutoff, threshold, offset, invert, mask);
+        return;
+    }
+
+    img = filter_in_place(img, dst);
+
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             int sum = 0;
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -565,15 +1036,16 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
 #ifdef IPL_FILTER_HAS_MVE
             mve_imlib_median_filter_grayscale(img, ksize, percentile, threshold, offset, invert, mask);
 #else
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *data = fb_alloc(64, FB_ALLOC_NO_HINT);
             uint8_t pixel;
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -634,7 +1106,7 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *r_data = fb_alloc(32, FB_ALLOC_NO_HINT);
             uint8_t *g_data = fb_alloc(64, FB_ALLOC_NO_HINT);
             uint8_t *b_data = fb_alloc(32, FB_ALLOC_NO_HINT);
@@ -643,8 +1115,9 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -717,7 +1190,7 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
         }
 
         case IMAGE_BPP_RGB888: {
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *r_data = fb_alloc(64, FB_ALLOC_NO_HINT);
             uint8_t *g_data = fb_alloc(64, FB_ALLOC_NO_HINT);
             uint8_t *b_data = fb_alloc(64, FB_ALLOC_NO_HINT);
@@ -727,8 +1200,9 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
                 rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
                 rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -836,25 +1310,282 @@ uint8_t mode = 0, mcount = 0;
     return mode;
 } /* find_mode() */
 
-void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset, bool invert, image_t *mask)
+// STM32IPL: sliding-histogram mode, used for the Grayscale, RGB565 and RGB888 images. The kernel histogram
+// (16-bit counters, one set of bins per channel) slides along the row removing one column and adding another
+// one; the borders are replicated, so that the histogram is built only once per row. The mode is the most
+// frequent value (the smallest one in case of ties) and the bins are searched again only when a column removes
+// pixels of the mode and the mode does not hold the majority of the kernel anymore.
+typedef struct mode_hist {
+    uint16_t *bins;
+    int len;
+    int mode;
+    int count;      // bins[mode]
+    int last_mode;  // mode and count at the last update.
+    int last_count;
+    bool removed;   // pixels of the mode removed since the last update.
+} mode_hist_t;
+
+// Returns the number of bins of the given channel (0, 1, 2) of the given format, 0 when not supported.
+static int mode_hist_bins(int bpp, int channel)
+{
+    switch (bpp) {
+        case IMAGE_BPP_GRAYSCALE:
+            return (channel == 0) ? 256 : 0;
+        case IMAGE_BPP_RGB565:
+            return (channel == 1) ? 64 : 32;
+        case IMAGE_BPP_RGB888:
+            return 256;
+        default:
+            return 0;
+    }
+}
+
+// Returns the smallest value having the highest count.
+static int hist_mode_u16(const uint16_t *bins, int len)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    return mve_imlib_hist_mode_u16(bins, len);
+#else
+    int mode = 0;
+
+    for (int i = 0; i < len; i += 4) {
+        if (*(uint64_t *)&bins[i] == 0)
+            continue; // skip empty bins quickly
+        for (int j = i; j < (i + 4); j++) {
+            if (bins[j] > bins[mode]) {
+                mode = j;
+            }
+        }
+    }
+
+    return mode;
+#endif
+}
+
+static inline void mode_hist_remove(mode_hist_t *h, int value)
+{
+    h->bins[value]--;
+    if (value == h->mode) {
+        h->count--;
+        h->removed = true;
+    }
+}
+
+static inline void mode_hist_add(mode_hist_t *h, int value)
+{
+    int count = ++h->bins[value];
+    if ((count > h->count) || ((count == h->count) && (value < h->mode))) {
+        h->mode = value;
+        h->count = count;
+    }
+}
+
+// Searches the mode again if it may have changed; n is the number of pixels of the kernel. The bins not updated
+// since the last update cannot exceed the last count: no search is needed when the mode has been kept (or
+// replaced by a higher count), or when it holds the majority of the kernel.
+static inline void mode_hist_update(mode_hist_t *h, int n)
+{
+    if (h->removed && ((h->count < h->last_count) || ((h->count == h->last_count) && (h->mode != h->last_mode)))
+            && ((h->count * 2) <= n)) {
+        h->mode = hist_mode_u16(h->bins, h->len);
+        h->count = h->bins[h->mode];
+    }
+    h->last_mode = h->mode;
+    h->last_count = h->count;
+    h->removed = false;
+}
+
+// Removes (add = false) or adds (add = true) the pixels of column x of the kernel rows to the histograms.
+static void mode_hist_column(image_t *img, uint8_t **rows, int n, int x, mode_hist_t *h, bool add)
+{
+    switch (img->bpp) {
+        case IMAGE_BPP_GRAYSCALE: {
+            for (int j = 0; j < n; j++) {
+                int pixel = rows[j][x];
+                if (add) mode_hist_add(&h[0], pixel); else mode_hist_remove(&h[0], pixel);
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB565: {
+            for (int j = 0; j < n; j++) {
+                int pixel = ((uint16_t *) rows[j])[x];
+                if (add) {
+                    mode_hist_add(&h[0], COLOR_RGB565_TO_R5(pixel));
+                    mode_hist_add(&h[1], COLOR_RGB565_TO_G6(pixel));
+                    mode_hist_add(&h[2], COLOR_RGB565_TO_B5(pixel));
+                } else {
+                    mode_hist_remove(&h[0], COLOR_RGB565_TO_R5(pixel));
+                    mode_hist_remove(&h[1], COLOR_RGB565_TO_G6(pixel));
+                    mode_hist_remove(&h[2], COLOR_RGB565_TO_B5(pixel));
+                }
+            }
+            break;
+        }
+        default: {
+            for (int j = 0; j < n; j++) {
+                rgb888_t pixel = ((rgb888_t *) rows[j])[x];
+                if (add) {
+                    mode_hist_add(&h[0], pixel.r);
+                    mode_hist_add(&h[1], pixel.g);
+                    mode_hist_add(&h[2], pixel.b);
+                } else {
+                    mode_hist_remove(&h[0], pixel.r);
+                    mode_hist_remove(&h[1], pixel.g);
+                    mode_hist_remove(&h[2], pixel.b);
+                }
+            }
+            break;
+        }
+    }
+}
+
+static uint32_t imlib_mode_filter_hist_space(image_t *img, const int ksize)
+{
+    int n = ((ksize * 2) + 1) * ((ksize * 2) + 1);
+    int bins = mode_hist_bins(img->bpp, 0) + mode_hist_bins(img->bpp, 1) + mode_hist_bins(img->bpp, 2);
+
+    // The kernel counters are 16-bit wide.
+    if (!bins || (n > UINT16_MAX)) {
+        return 0;
+    }
+
+    return FB_ALLOC_SPACE(image_line_size(img) * (ksize + 1)) + FB_ALLOC_SPACE(bins * sizeof(uint16_t))
+        + FB_ALLOC_SPACE(((ksize * 2) + 1) * sizeof(uint8_t *));
+}
+
+static void imlib_mode_filter_hist(image_t *img, image_t *dst, const int ksize, bool threshold, int offset,
+                                   bool invert, image_t *mask)
+{
+    int n = (ksize * 2) + 1;
+    int channels = (img->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : 3;
+    int bins = mode_hist_bins(img->bpp, 0) + mode_hist_bins(img->bpp, 1) + mode_hist_bins(img->bpp, 2);
+    filter_lines_t lines;
+    filter_lines_alloc(&lines, img, dst, ksize + 1);
+    uint16_t *hist_bins = fb_alloc(bins * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+    uint8_t **rows = fb_alloc(n * sizeof(uint8_t *), FB_ALLOC_NO_HINT);
+    mode_hist_t h[3];
+
+    for (int c = 0, start = 0; c < channels; c++) {
+        h[c].bins = hist_bins + start;
+        h[c].len = mode_hist_bins(img->bpp, c);
+        start += h[c].len;
+    }
+
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        for (int j = 0; j < n; j++) {
+            rows[j] = img->data + (IM_MIN(IM_MAX(y + j - ksize, 0), (img->h - 1)) * image_line_stride(img));
+        }
+
+        memset(hist_bins, 0, bins * sizeof(uint16_t));
+        for (int c = 0; c < channels; c++) {
+            h[c].mode = 0;
+            h[c].count = 0;
+            h[c].removed = false;
+        }
+
+        for (int k = -ksize; k <= ksize; k++) {
+            mode_hist_column(img, rows, n, IM_MIN(IM_MAX(k, 0), (img->w - 1)), h, true);
+        }
+        for (int c = 0; c < channels; c++) {
+            mode_hist_update(&h[c], n * n);
+        }
+
+        uint32_t mask_word = 0; // STM32IPL
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            if (x > 0) { // Slide the kernel histogram to this pixel.
+                mode_hist_column(img, rows, n, IM_MAX(x - ksize - 1, 0), h, false);
+                mode_hist_column(img, rows, n, IM_MIN(x + ksize, (img->w - 1)), h, true);
+                for (int c = 0; c < channels; c++) {
+                    mode_hist_update(&h[c], n * n);
+                }
+            }
+
+            if (img->bpp == IMAGE_BPP_GRAYSCALE) {
+                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                uint8_t *buf_row_ptr = filter_lines_get(&lines, y);
+                uint8_t pixel = h[0].mode;
+
+                if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                    pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
+                } else if (threshold) {
+                    if (((pixel - offset) < IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)) ^ invert) {
+                        pixel = COLOR_GRAYSCALE_BINARY_MAX;
+                    } else {
+                        pixel = COLOR_GRAYSCALE_BINARY_MIN;
+                    }
+                }
+
+                IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+            } else if (img->bpp == IMAGE_BPP_RGB565) {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                uint16_t *buf_row_ptr = (uint16_t *) filter_lines_get(&lines, y);
+
+                if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
+                } else {
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, COLOR_R5_G6_B5_TO_RGB565(h[0].mode, h[1].mode, h[2].mode));
+                }
+            } else {
+                rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                rgb888_t *buf_row_ptr = (rgb888_t *) filter_lines_get(&lines, y);
+                rgb888_t pixel888;
+
+                if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                    pixel888 = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
+                } else {
+                    pixel888.r = h[0].mode;
+                    pixel888.g = h[1].mode;
+                    pixel888.b = h[2].mode;
+                }
+
+                IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, pixel888);
+            }
+        }
+
+        // Transfer buffer lines...
+        filter_lines_put(&lines, y - ksize);
+    }
+
+    // Copy any remaining lines from the buffer image...
+    filter_lines_flush(&lines, img->h - ksize);
+
+    fb_free();
+    fb_free();
+    filter_lines_free(&lines);
+}
+
+void imlib_mode_filter(image_t *img, image_t *dst, const int ksize, bool threshold, int offset, bool invert,
+                       image_t *mask)
 {
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
     const uint8_t n2 = (((ksize*2)+1)*((ksize*2)+1))/2;
+
+    // STM32IPL: the Grayscale, RGB565 and RGB888 images use the sliding histograms, when their buffers fit.
+    uint32_t hist_space = imlib_mode_filter_hist_space(img, ksize);
+    if (hist_space && (fb_avail() >= hist_space)) {
+        imlib_mode_filter_hist(img, dst, ksize, threshold, offset, invert, mask);
+        return;
+    }
+
+    img = filter_in_place(img, dst);
+
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             int bins = 0;
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -908,7 +1639,7 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *bins = fb_alloc((COLOR_GRAYSCALE_MAX-COLOR_GRAYSCALE_MIN+1), FB_ALLOC_NO_HINT);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
@@ -916,8 +1647,9 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
                 uint8_t pixel = 0, mode = 0;
                 int mcount = -1;
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -994,7 +1726,7 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *r_bins = fb_alloc((COLOR_R5_MAX-COLOR_R5_MIN+1), FB_ALLOC_NO_HINT);
             uint8_t *g_bins = fb_alloc((COLOR_G6_MAX-COLOR_G6_MIN+1), FB_ALLOC_NO_HINT);
             uint8_t *b_bins = fb_alloc((COLOR_B5_MAX-COLOR_B5_MIN+1), FB_ALLOC_NO_HINT);
@@ -1006,8 +1738,9 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
                 int r_mcount=0, g_mcount=0, b_mcount=0;
                 int pixel, r_mode, g_mode, b_mode;
                 r_mode = g_mode = b_mode = 0;
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1136,7 +1869,7 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case IMAGE_BPP_RGB888: {
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             uint8_t *r_bins = fb_alloc((COLOR_R8_MAX-COLOR_R8_MIN+1), FB_ALLOC_NO_HINT);
             uint8_t *g_bins = fb_alloc((COLOR_G8_MAX-COLOR_G8_MIN+1), FB_ALLOC_NO_HINT);
             uint8_t *b_bins = fb_alloc((COLOR_B8_MAX-COLOR_B8_MIN+1), FB_ALLOC_NO_HINT);
@@ -1150,8 +1883,9 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
                 rgb888_t pixel888;
                 int r_mode, g_mode, b_mode;
                 r_mode = g_mode = b_mode = 0;
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1287,16 +2021,273 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
         }
     }
 }
-#endif // IMLIB_ENABLE_MODE
+#endif // IMLIB_ENABLE_MODE
+
+#ifdef IMLIB_ENABLE_MIDPOINT
+// STM32IPL: separable midpoint, used for the Grayscale, RGB565 and RGB888 images. The extrema of the kernel are
+// the extrema of the extrema of its columns, so that the cost per pixel grows with the kernel size instead of its
+// area. The channels are handled separately: the bytes of the Grayscale and RGB888 lines, the R5, G6, B5 fields
+// of the RGB565 words (the extremum of the masked fields is the extremum of the channel).
+static inline int midpoint_min_rgb565(int a, int b)
+{
+    return IM_MIN(a & 0xF800, b & 0xF800) | IM_MIN(a & 0x07E0, b & 0x07E0) | IM_MIN(a & 0x001F, b & 0x001F);
+}
+
+static inline int midpoint_max_rgb565(int a, int b)
+{
+    return IM_MAX(a & 0xF800, b & 0xF800) | IM_MAX(a & 0x07E0, b & 0x07E0) | IM_MAX(a & 0x001F, b & 0x001F);
+}
+
+// Computes the extrema of the n rows for the len elements (bytes, words for RGB565) of the lines.
+static void midpoint_vertical(int bpp, uint8_t **rows, int n, int len, uint8_t *v_min, uint8_t *v_max)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    mve_imlib_midpoint_vertical(bpp, rows, n, len, v_min, v_max);
+#else
+    if (bpp == IMAGE_BPP_RGB565) {
+        uint16_t *min_ptr = (uint16_t *) v_min;
+        uint16_t *max_ptr = (uint16_t *) v_max;
+
+        memcpy(min_ptr, rows[0], len * sizeof(uint16_t));
+        memcpy(max_ptr, rows[0], len * sizeof(uint16_t));
+        for (int j = 1; j < n; j++) {
+            const uint16_t *row_ptr = (const uint16_t *) rows[j];
+            for (int i = 0; i < len; i++) {
+                min_ptr[i] = midpoint_min_rgb565(min_ptr[i], row_ptr[i]);
+                max_ptr[i] = midpoint_max_rgb565(max_ptr[i], row_ptr[i]);
+            }
+        }
+    } else {
+        memcpy(v_min, rows[0], len);
+        memcpy(v_max, rows[0], len);
+        for (int j = 1; j < n; j++) {
+            const uint8_t *row_ptr = rows[j];
+            for (int i = 0; i < len; i++) {
+                v_min[i] = IM_MIN(v_min[i], row_ptr[i]);
+                v_max[i] = IM_MAX(v_max[i], row_ptr[i]);
+            }
+        }
+    }
+#endif
+}
+
+// Computes the extrema of the taps elements in[i], in[i + step], ... (bytes, words for RGB565), for i < len.
+static void midpoint_horizontal(int bpp, const uint8_t *v_min, const uint8_t *v_max, int len, int step, int taps,
+                                uint8_t *h_min, uint8_t *h_max)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    mve_imlib_midpoint_horizontal(bpp, v_min, v_max, len, step, taps, h_min, h_max);
+#else
+    if (bpp == IMAGE_BPP_RGB565) {
+        const uint16_t *in_min = (const uint16_t *) v_min;
+        const uint16_t *in_max = (const uint16_t *) v_max;
+        uint16_t *out_min = (uint16_t *) h_min;
+        uint16_t *out_max = (uint16_t *) h_max;
+
+        for (int i = 0; i < len; i++) {
+            int min = in_min[i], max = in_max[i];
+            for (int t = 1; t < taps; t++) {
+                min = midpoint_min_rgb565(min, in_min[i + (t * step)]);
+                max = midpoint_max_rgb565(max, in_max[i + (t * step)]);
+            }
+            out_min[i] = min;
+            out_max[i] = max;
+        }
+    } else {
+        for (int i = 0; i < len; i++) {
+            int min = v_min[i], max = v_max[i];
+            for (int t = 1; t < taps; t++) {
+                min = IM_MIN(min, v_min[i + (t * step)]);
+                max = IM_MAX(max, v_max[i + (t * step)]);
+            }
+            h_min[i] = min;
+            h_max[i] = max;
+        }
+    }
+#endif
+}
+
+// Returns the size of a pixel in bytes, 0 when the separable extrema are not supported.
+static int midpoint_pixel_size(int bpp)
+{
+    switch (bpp) {
+        case IMAGE_BPP_GRAYSCALE:
+            return sizeof(uint8_t);
+        case IMAGE_BPP_RGB565:
+            return sizeof(uint16_t);
+        case IMAGE_BPP_RGB888:
+            return sizeof(rgb888_t);
+        default:
+            return 0;
+    }
+}
+
+static uint32_t imlib_midpoint_filter_sep_space(image_t *img, const int ksize)
+{
+    int pixel_size = midpoint_pixel_size(img->bpp);
+
+    if (!pixel_size) {
+        return 0;
+    }
+
+    size_t line_size = image_line_size(img);
+    size_t padded_size = (img->w + (ksize * 2)) * pixel_size;
+
+    return FB_ALLOC_SPACE(line_size * (ksize + 1)) + (2 * FB_ALLOC_SPACE(padded_size))
+        + (2 * FB_ALLOC_SPACE(line_size)) + FB_ALLOC_SPACE(((ksize * 2) + 1) * sizeof(uint8_t *));
+}
+
+static void imlib_midpoint_filter_sep(image_t *img, image_t *dst, const int ksize, const uint8_t *u8BiasTable,
+                                      bool threshold, int offset, bool invert, image_t *mask)
+{
+    int n = (ksize * 2) + 1;
+    int pixel_size = midpoint_pixel_size(img->bpp);
+    // Elements of the lines: bytes, words for RGB565; step is the distance of two pixels in elements.
+    int step = (img->bpp == IMAGE_BPP_RGB888) ? sizeof(rgb888_t) : 1;
+    int len = img->w * step;
+    size_t line_size = image_line_size(img);
+    size_t pad_size = ksize * pixel_size;
+    filter_lines_t lines;
+    filter_lines_alloc(&lines, img, dst, ksize + 1);
+    uint8_t *v_min = fb_alloc(line_size + (2 * pad_size), FB_ALLOC_PREFER_SPEED);
+    uint8_t *v_max = fb_alloc(line_size + (2 * pad_size), FB_ALLOC_PREFER_SPEED);
+    uint8_t *h_min = fb_alloc(line_size, FB_ALLOC_PREFER_SPEED);
+    uint8_t *h_max = fb_alloc(line_size, FB_ALLOC_PREFER_SPEED);
+    uint8_t **rows = fb_alloc(n * sizeof(uint8_t *), FB_ALLOC_NO_HINT);
+
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        for (int j = 0; j < n; j++) {
+            rows[j] = img->data + (IM_MIN(IM_MAX(y + j - ksize, 0), (img->h - 1)) * image_line_stride(img));
+        }
+
+        midpoint_vertical(img->bpp, rows, n, len, v_min + pad_size, v_max + pad_size);
+
+        // Replicate the border pixels.
+        for (int k = 0; k < ksize; k++) {
+            memcpy(v_min + (k * pixel_size), v_min + pad_size, pixel_size);
+            memcpy(v_max + (k * pixel_size), v_max + pad_size, pixel_size);
+            memcpy(v_min + pad_size + line_size + (k * pixel_size), v_min + pad_size + line_size - pixel_size, pixel_size);
+            memcpy(v_max + pad_size + line_size + (k * pixel_size), v_max + pad_size + line_size - pixel_size, pixel_size);
+        }
+
+        midpoint_horizontal(img->bpp, v_min, v_max, len, step, n, h_min, h_max);
+
+        switch (img->bpp) {
+            case IMAGE_BPP_GRAYSCALE: {
+                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                uint8_t *buf_row_ptr = filter_lines_get(&lines, y);
+
+                uint32_t mask_word = 0; // STM32IPL
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    int pixel = h_min[x] + u8BiasTable[h_max[x] - h_min[x]];
+
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
+                    } else if (threshold) {
+                        if (((pixel - offset) < IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)) ^ invert) {
+                            pixel = COLOR_GRAYSCALE_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_GRAYSCALE_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+                }
+                break;
+            }
+            case IMAGE_BPP_RGB565: {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                uint16_t *buf_row_ptr = (uint16_t *) filter_lines_get(&lines, y);
+                const uint16_t *min_ptr = (const uint16_t *) h_min;
+                const uint16_t *max_ptr = (const uint16_t *) h_max;
+
+                uint32_t mask_word = 0; // STM32IPL
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
+                        continue; // Short circuit.
+                    }
+
+                    int r_min = COLOR_RGB565_TO_R5(min_ptr[x]), r_max = COLOR_RGB565_TO_R5(max_ptr[x]);
+                    int g_min = COLOR_RGB565_TO_G6(min_ptr[x]), g_max = COLOR_RGB565_TO_G6(max_ptr[x]);
+                    int b_min = COLOR_RGB565_TO_B5(min_ptr[x]), b_max = COLOR_RGB565_TO_B5(max_ptr[x]);
+                    r_min += u8BiasTable[r_max-r_min];
+                    g_min += u8BiasTable[g_max-g_min];
+                    b_min += u8BiasTable[b_max-b_min];
+                    int pixel = COLOR_R5_G6_B5_TO_RGB565(r_min, g_min, b_min);
+
+                    if (threshold) {
+                        if (((COLOR_RGB565_TO_Y(pixel) - offset) < COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel = COLOR_RGB565_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_RGB565_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, pixel);
+                }
+                break;
+            }
+            default: {
+                rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                rgb888_t *buf_row_ptr = (rgb888_t *) filter_lines_get(&lines, y);
+                const rgb888_t *min_ptr = (const rgb888_t *) h_min;
+                const rgb888_t *max_ptr = (const rgb888_t *) h_max;
+
+                uint32_t mask_word = 0; // STM32IPL
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                        IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
+                        continue; // Short circuit.
+                    }
+
+                    rgb888_t pixel888;
+                    pixel888.r = min_ptr[x].r + u8BiasTable[max_ptr[x].r - min_ptr[x].r];
+                    pixel888.g = min_ptr[x].g + u8BiasTable[max_ptr[x].g - min_ptr[x].g];
+                    pixel888.b = min_ptr[x].b + u8BiasTable[max_ptr[x].b - min_ptr[x].b];
+
+                    if (threshold) {
+                        if (((COLOR_RGB888_TO_Y(pixel888.r, pixel888.g, pixel888.b ) - offset) < COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel888.r = COLOR_R8_MAX;
+                            pixel888.g = COLOR_G8_MAX;
+                            pixel888.b = COLOR_B8_MAX;
+                        } else {
+                            pixel888.r = COLOR_R8_MIN;
+                            pixel888.g = COLOR_G8_MIN;
+                            pixel888.b = COLOR_B8_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, pixel888);
+                }
+                break;
+            }
+        }
+
+        // Transfer buffer lines...
+        filter_lines_put(&lines, y - ksize);
+    }
+
+    // Copy any remaining lines from the buffer image...
+    filter_lines_flush(&lines, img->h - ksize);
+
+    fb_free();
+    fb_free();
+    fb_free();
+    fb_free();
+    fb_free();
+    filter_lines_free(&lines);
+}
 
-#ifdef IMLIB_ENABLE_MIDPOINT
-void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool threshold, int offset, bool invert, image_t *mask)
+void imlib_midpoint_filter(image_t *img, image_t *dst, const int ksize, float bias, bool threshold, int offset,
+                           bool invert, image_t *mask)
 {
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
     uint8_t *u8BiasTable;
     float max_bias = bias, min_bias = 1.0f - bias;
 
@@ -1305,16 +2296,27 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
         u8BiasTable[i] = (uint8_t)fast_floorf((float)i * bias);
     }
 
+    // STM32IPL: the Grayscale, RGB565 and RGB888 images use the separable extrema, when their buffers fit.
+    uint32_t sep_space = imlib_midpoint_filter_sep_space(img, ksize);
+    if (sep_space && (fb_avail() >= sep_space)) {
+        imlib_midpoint_filter_sep(img, dst, ksize, u8BiasTable, threshold, offset, invert, mask);
+        fb_free();
+        return;
+    }
+
+    img = filter_in_place(img, dst);
+
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1375,14 +2377,15 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1394,7 +2397,7 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                             for (int k = -ksize; k <= ksize; k++) {
                                 int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(k_row_ptr,x+k);
                                 if (pixel < min) min = pixel;
-                                else if (pixel > max) max = pixel;
+                                if (pixel > max) max = pixel;
                             }
                         }
                     } else {
@@ -1406,7 +2409,7 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(k_row_ptr,
                                     IM_MIN(IM_MAX(x + k, 0), (img->w - 1)));
                                 if (pixel < min) min = pixel;
-                                else if (pixel > max) max = pixel;
+                                if (pixel > max) max = pixel;
                             }
                         }
                     }
@@ -1442,14 +2445,15 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1466,11 +2470,11 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int g_pixel = COLOR_RGB565_TO_G6(pixel);
                                 int b_pixel = COLOR_RGB565_TO_B5(pixel);
                                 if (r_pixel < r_min) r_min = r_pixel;
-                                else if (r_pixel > r_max) r_max = r_pixel;
+                                if (r_pixel > r_max) r_max = r_pixel;
                                 if (g_pixel < g_min) g_min = g_pixel;
-                                else if (g_pixel > g_max) g_max = g_pixel;
+                                if (g_pixel > g_max) g_max = g_pixel;
                                 if (b_pixel < b_min) b_min = b_pixel;
-                                else if (b_pixel > b_max) b_max = b_pixel;
+                                if (b_pixel > b_max) b_max = b_pixel;
                             }
                         }
                     } else {
@@ -1485,11 +2489,11 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int g_pixel = COLOR_RGB565_TO_G6(pixel);
                                 int b_pixel = COLOR_RGB565_TO_B5(pixel);
                                 if (r_pixel < r_min) r_min = r_pixel;
-                                else if (r_pixel > r_max) r_max = r_pixel;
+                                if (r_pixel > r_max) r_max = r_pixel;
                                 if (g_pixel < g_min) g_min = g_pixel;
-                                else if (g_pixel > g_max) g_max = g_pixel;
+                                if (g_pixel > g_max) g_max = g_pixel;
                                 if (b_pixel < b_min) b_min = b_pixel;
-                                else if (b_pixel > b_max) b_max = b_pixel;
+                                if (b_pixel > b_max) b_max = b_pixel;
                             }
                         }
                     }
@@ -1528,14 +2532,15 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
             break;
         }
         case IMAGE_BPP_RGB888: {
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
                 rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1552,11 +2557,11 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int g_pixel = pixel888.g;
                                 int b_pixel = pixel888.b;
                                 if (r_pixel < r_min) r_min = r_pixel;
-                                else if (r_pixel > r_max) r_max = r_pixel;
+                                if (r_pixel > r_max) r_max = r_pixel;
                                 if (g_pixel < g_min) g_min = g_pixel;
-                                else if (g_pixel > g_max) g_max = g_pixel;
+                                if (g_pixel > g_max) g_max = g_pixel;
                                 if (b_pixel < b_min) b_min = b_pixel;
-                                else if (b_pixel > b_max) b_max = b_pixel;
+                                if (b_pixel > b_max) b_max = b_pixel;
                             }
                         }
                     } else {
@@ -1571,11 +2576,11 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int g_pixel = pixel888.g;
                                 int b_pixel = pixel888.b;
                                 if (r_pixel < r_min) r_min = r_pixel;
-                                else if (r_pixel > r_max) r_max = r_pixel;
+                                if (r_pixel > r_max) r_max = r_pixel;
                                 if (g_pixel < g_min) g_min = g_pixel;
-                                else if (g_pixel > g_max) g_max = g_pixel;
+                                if (g_pixel > g_max) g_max = g_pixel;
                                 if (b_pixel < b_min) b_min = b_pixel;
-                                else if (b_pixel > b_max) b_max = b_pixel;
+                                if (b_pixel > b_max) b_max = b_pixel;
                             }
                         }
                     }
@@ -1638,18 +2643,20 @@ void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, c
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
     const int32_t m_int = (int32_t)(65536.0f * m); // m is 1/kernel_weight		// STM32IPL: f added to the constant.
 
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1708,14 +2715,15 @@ void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, c
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1774,14 +2782,15 @@ void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, c
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1856,14 +2865,15 @@ void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, c
         }
 
         case IMAGE_BPP_RGB888: {
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
                 rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -1949,6 +2959,317 @@ void imlib_morph(image_t *img, const int ksize, const int *krn, const float m, c
         }
     }
 }
+// STM32IPL: separable gaussian. The 2D kernel built by STM32Ipl_Gaussian() is the outer product of a row of the
+// Pascal's triangle with itself, so it is applied as a vertical pass on the kernel rows (a single line of sums,
+// kept in internal memory) followed by an horizontal pass on the sums: each pixel costs 2 * ((ksize * 2) + 1)
+// multiply-accumulates instead of ((ksize * 2) + 1)^2. The vertical sums are stored per byte for Grayscale and
+// RGB888 (interleaved channels) and per channel for Binary and RGB565 (one plane per channel), with radius
+// replicated pixels on both sides, so that the horizontal pass does not need to clamp the coordinates.
+#define GAUSSIAN_WEIGHT_BITS    8       // The 1D weights sum is at most 2^8, so that the vertical sums fit 16 bits.
+
+// Fills the 1D weights ((radius * 2) + 1 taps) when not NULL, and returns the radius of the kernel, that is ksize
+// without the taps whose weight is zero. Up to 9 taps the weights are the row of the Pascal's triangle, so that
+// the results are the same of the 2D kernel; the larger kernels use the binomial weights normalized to
+// 2^GAUSSIAN_WEIGHT_BITS.
+static int gaussian_weights(const int ksize, uint16_t *weights)
+{
+    int k_2 = ksize * 2;
+
+    if (k_2 <= GAUSSIAN_WEIGHT_BITS) {
+        if (weights) {
+            weights[0] = 1;
+            for (int i = 0; i < k_2; i++) {
+                weights[i + 1] = (weights[i] * (k_2 - i)) / (i + 1);
+            }
+        }
+        return ksize;
+    }
+
+    // Central binomial weight, C(2k, k) / 2^2k; the other ones follow from the ratio of consecutive coefficients.
+    float p = 1.0f;
+    for (int i = 1; i <= ksize; i++) {
+        p *= (float)((2 * i) - 1) / (float)(2 * i);
+    }
+
+    int radius = 0, sum = 0;
+    for (int t = 1; t <= ksize; t++) {
+        p *= (float)(ksize - t + 1) / (float)(ksize + t);
+        int weight = fast_roundf(p * (1 << GAUSSIAN_WEIGHT_BITS));
+        if (!weight) {
+            break;
+        }
+        if (weights) {
+            weights[t] = weight;
+        }
+        sum += weight;
+        radius = t;
+    }
+
+    if (weights) {
+        // The half weights are mirrored in place; the rounding error goes to the central weight.
+        for (int t = radius; t > 0; t--) {
+            weights[radius + t] = weights[t];
+        }
+        for (int t = 1; t <= radius; t++) {
+            weights[radius - t] = weights[radius + t];
+        }
+        weights[radius] = (1 << GAUSSIAN_WEIGHT_BITS) - (2 * sum);
+    }
+
+    return radius;
+}
+
+// Layout of the vertical sums: number of sums per pixel in a plane, and number of planes.
+static int gaussian_pixel_sums(int bpp)
+{
+    return (bpp == IMAGE_BPP_RGB888) ? 3 : 1;
+}
+
+static int gaussian_planes(int bpp)
+{
+    return (bpp == IMAGE_BPP_RGB565) ? 3 : 1;
+}
+
+// Computes the vertical sums of the image row y, from the rows y - radius ... y + radius (clamped to the image).
+// The sums of the first pixel are stored at out; plane_len is the distance between two planes.
+static void gaussian_vertical(image_t *img, int y, int radius, const uint16_t *weights, uint16_t *out, int plane_len)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    if (img->bpp != IMAGE_BPP_BINARY) {
+        mve_imlib_gaussian_vertical(img, y, radius, weights, out, plane_len);
+        return;
+    }
+#endif
+    int w = img->w;
+    int len = w * gaussian_pixel_sums(img->bpp);
+
+    for (int p = 0, pp = gaussian_planes(img->bpp); p < pp; p++) {
+        memset(out + (p * plane_len), 0, len * sizeof(uint16_t));
+    }
+
+    for (int j = -radius; j <= radius; j++) {
+        int weight = weights[j + radius];
+        int yy = IM_MIN(IM_MAX(y + j, 0), (img->h - 1));
+
+        switch (img->bpp) {
+            case IMAGE_BPP_BINARY: {
+                uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, yy);
+                for (int x = 0; x < w; x++) {
+                    out[x] += weight * IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
+                }
+                break;
+            }
+            case IMAGE_BPP_RGB565: {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, yy);
+                for (int x = 0; x < w; x++) {
+                    int pixel = row_ptr[x];
+                    out[x] += weight * COLOR_RGB565_TO_R5(pixel);
+                    out[plane_len + x] += weight * COLOR_RGB565_TO_G6(pixel);
+                    out[(2 * plane_len) + x] += weight * COLOR_RGB565_TO_B5(pixel);
+                }
+                break;
+            }
+            default: {
+                uint8_t *row_ptr = img->data + (yy * image_line_stride(img));
+                for (int i = 0; i < len; i++) {
+                    out[i] += weight * row_ptr[i];
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Computes n values of the horizontal pass: out[i] is the weighted sum of in[i], in[i + step], ...,
+// in[i + (radius * 2 * step)], plus bias, shifted right by shift.
+static void gaussian_horizontal(const uint16_t *in, int n, int step, int radius, const uint16_t *weights,
+                                uint32_t bias, int shift, uint8_t *out)
+{
+#ifdef IPL_FILTER_HAS_MVE
+    mve_imlib_gaussian_horizontal(in, n, step, radius, weights, bias, shift, out);
+#else
+    for (int i = 0; i < n; i++) {
+        uint32_t acc = bias;
+        const uint16_t *ptr = in + i;
+
+        for (int t = 0, tt = (radius * 2) + 1; t < tt; t++, ptr += step) {
+            acc += weights[t] * (*ptr);
+        }
+
+        out[i] = acc >> shift;
+    }
+#endif
+}
+
+uint32_t imlib_gaussian_filter_space(image_t *img, const int ksize)
+{
+    int radius = gaussian_weights(ksize, NULL);
+    int sums = gaussian_pixel_sums(img->bpp) * gaussian_planes(img->bpp);
+
+    return FB_ALLOC_SPACE(image_line_size(img) * (radius + 1))
+        + FB_ALLOC_SPACE((img->w + (radius * 2)) * sums * sizeof(uint16_t))
+        + FB_ALLOC_SPACE(img->w * sums)
+        + FB_ALLOC_SPACE(((radius * 2) + 1) * sizeof(uint16_t));
+}
+
+void imlib_gaussian_filter(image_t *img, image_t *dst, const int ksize, bool threshold, bool unsharp, image_t *mask)
+{
+    int radius = gaussian_weights(ksize, NULL);
+    int w = img->w;
+    int pixel_sums = gaussian_pixel_sums(img->bpp);
+    int planes = gaussian_planes(img->bpp);
+    int plane_len = (w + (radius * 2)) * pixel_sums;
+
+    // Each pass divides by the sum of the 1D weights; with unsharp, the blurred value is rounded up, as the
+    // negated 2D kernel does.
+    int shift = 2 * IM_MIN(ksize * 2, GAUSSIAN_WEIGHT_BITS);
+    uint32_t bias = unsharp ? ((1 << shift) - 1) : 0;
+
+    filter_lines_t lines;
+    filter_lines_alloc(&lines, img, dst, radius + 1);
+    uint16_t *sums = fb_alloc(plane_len * planes * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+    uint8_t *blur = fb_alloc(w * pixel_sums * planes, FB_ALLOC_PREFER_SPEED);
+    uint16_t *weights = fb_alloc(((radius * 2) + 1) * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+    gaussian_weights(ksize, weights);
+
+    // The blurred Grayscale and RGB888 lines are the output lines when there is nothing else to do.
+    bool direct = ((img->bpp == IMAGE_BPP_GRAYSCALE) || (img->bpp == IMAGE_BPP_RGB888))
+        && (!threshold) && (!unsharp) && (!mask);
+
+    for (int y = 0, yy = img->h; y < yy; y++) {
+        uint8_t *buf_line = filter_lines_get(&lines, y);
+        uint8_t *blur_line = direct ? buf_line : blur;
+
+        gaussian_vertical(img, y, radius, weights, sums + (radius * pixel_sums), plane_len);
+
+        for (int p = 0; p < planes; p++) {
+            uint16_t *plane = sums + (p * plane_len);
+            uint16_t *first = plane + (radius * pixel_sums);
+            uint16_t *last = plane + ((radius + w - 1) * pixel_sums);
+
+            for (int t = 1; t <= radius; t++) {
+                for (int c = 0; c < pixel_sums; c++) {
+                    first[c - (t * pixel_sums)] = first[c];
+                    last[c + (t * pixel_sums)] = last[c];
+                }
+            }
+
+            gaussian_horizontal(plane, w * pixel_sums, pixel_sums, radius, weights, bias, shift,
+                                blur_line + (p * w * pixel_sums));
+        }
+
+        uint32_t mask_word = 0; // STM32IPL
+        for (int x = 0; (!direct) && (x < w); x++) {
+            switch (img->bpp) {
+                case IMAGE_BPP_BINARY: {
+                    uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+                    uint32_t *buf_row_ptr = (uint32_t *) buf_line;
+                    int src = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
+                    int pixel = src;
+
+                    if ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) {
+                        pixel = unsharp ? IM_MIN(IM_MAX((src * 2) - blur[x], 0), 1) : blur[x];
+
+                        if (threshold) {
+                            pixel = (pixel < src) ? COLOR_BINARY_MAX : COLOR_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, pixel);
+                    break;
+                }
+                case IMAGE_BPP_GRAYSCALE: {
+                    uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                    uint8_t *buf_row_ptr = buf_line;
+                    int src = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
+                    int pixel = src;
+
+                    if ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) {
+                        pixel = unsharp ? IM_MIN(IM_MAX((src * 2) - blur[x], 0), COLOR_GRAYSCALE_MAX) : blur[x];
+
+                        if (threshold) {
+                            pixel = (pixel < src) ? COLOR_GRAYSCALE_BINARY_MAX : COLOR_GRAYSCALE_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+                    break;
+                }
+                case IMAGE_BPP_RGB565: {
+                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                    uint16_t *buf_row_ptr = (uint16_t *) buf_line;
+                    int src = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
+                    int pixel = src;
+
+                    if ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) {
+                        int r = blur[x], g = blur[w + x], b = blur[(2 * w) + x];
+
+                        if (unsharp) {
+                            r = IM_MIN(IM_MAX((COLOR_RGB565_TO_R5(src) * 2) - r, 0), COLOR_R5_MAX);
+                            g = IM_MIN(IM_MAX((COLOR_RGB565_TO_G6(src) * 2) - g, 0), COLOR_G6_MAX);
+                            b = IM_MIN(IM_MAX((COLOR_RGB565_TO_B5(src) * 2) - b, 0), COLOR_B5_MAX);
+                        }
+
+                        pixel = COLOR_R5_G6_B5_TO_RGB565(r, g, b);
+
+                        if (threshold) {
+                            if (COLOR_RGB565_TO_Y(pixel) < COLOR_RGB565_TO_Y(src)) {
+                                pixel = COLOR_RGB565_BINARY_MAX;
+                            } else {
+                                pixel = COLOR_RGB565_BINARY_MIN;
+                            }
+                        }
+                    }
+
+                    IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, pixel);
+                    break;
+                }
+                default: {
+                    rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                    rgb888_t *buf_row_ptr = (rgb888_t *) buf_line;
+                    rgb888_t src = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x);
+                    rgb888_t pixel888 = src;
+
+                    if ((!mask) || IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) {
+                        pixel888 = ((rgb888_t *) blur)[x];
+
+                        if (unsharp) {
+                            pixel888.r = IM_MIN(IM_MAX((src.r * 2) - pixel888.r, 0), COLOR_R8_MAX);
+                            pixel888.g = IM_MIN(IM_MAX((src.g * 2) - pixel888.g, 0), COLOR_G8_MAX);
+                            pixel888.b = IM_MIN(IM_MAX((src.b * 2) - pixel888.b, 0), COLOR_B8_MAX);
+                        }
+
+                        if (threshold) {
+                            if (COLOR_RGB888_TO_Y(pixel888.r, pixel888.g, pixel888.b) < COLOR_RGB888_TO_GRAYSCALE(src)) {
+                                pixel888.r = COLOR_R8_MAX;
+                                pixel888.g = COLOR_G8_MAX;
+                                pixel888.b = COLOR_B8_MAX;
+                            } else {
+                                pixel888.r = COLOR_R8_MIN;
+                                pixel888.g = COLOR_G8_MIN;
+                                pixel888.b = COLOR_B8_MIN;
+                            }
+                        }
+                    }
+
+                    IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, pixel888);
+                    break;
+                }
+            }
+        }
+
+        // Transfer buffer lines...
+        filter_lines_put(&lines, y - radius);
+    }
+
+    // Copy any remaining lines from the buffer image...
+    filter_lines_flush(&lines, img->h - radius);
+
+    fb_free();
+    fb_free();
+    fb_free();
+    filter_lines_free(&lines);
+}
 
 #ifdef IMLIB_ENABLE_BILATERAL
 static float gaussian(float x, float sigma)
@@ -1968,10 +3289,11 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
     buf.w = img->w;
     buf.h = brows;
     buf.bpp = img->bpp;
+    buf.stride = 0;
 
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
-            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             float *gi_lut_ptr = fb_alloc((COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
             float *gi_lut = &gi_lut_ptr[1];
             float max_color = IM_DIV(1.0f, COLOR_BINARY_MAX - COLOR_BINARY_MIN);
@@ -1993,8 +3315,9 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
                 uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -2048,7 +3371,7 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             float *gi_lut_ptr = fb_alloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(float) * 2, FB_ALLOC_NO_HINT);
             float *gi_lut = &gi_lut_ptr[256]; // point to the middle
             float max_color = IM_DIV(1.0f, COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN);
@@ -2070,8 +3393,9 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
                 uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -2137,7 +3461,7 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
             break;
         }
         case IMAGE_BPP_RGB565: {
-            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             float *rb_gi_ptr = fb_alloc((COLOR_R5_MAX - COLOR_R5_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
             float *g_gi_ptr = fb_alloc((COLOR_G6_MAX - COLOR_G6_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
             float *rb_gi_lut = &rb_gi_ptr[32]; // center
@@ -2167,8 +3491,9 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
                 uint16_t *buf_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -2263,7 +3588,7 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
         }
 
         case IMAGE_BPP_RGB888: {
-            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+            buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
             float *r_gi_ptr = fb_alloc((COLOR_R8_MAX - COLOR_R8_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
             float *g_gi_ptr = fb_alloc((COLOR_G8_MAX - COLOR_G8_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
             float *b_gi_ptr = fb_alloc((COLOR_G8_MAX - COLOR_G8_MIN + 1) * sizeof(float) *2, FB_ALLOC_NO_HINT);
@@ -2301,8 +3626,9 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
                 rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
                 rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
+                uint32_t mask_word = 0; // STM32IPL
                 for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
+                    if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
                         IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
                         continue; // Short circuit.
                     }
@@ -2405,6 +3731,278 @@ void imlib_bilateral_filter(image_t *img, const int ksize, float color_sigma, fl
         }
     }
 }
+
+// STM32IPL: fixed-point bilateral filter, with range and space weights computed once in look-up tables, and an
+// optional separable approximation (horizontal pass followed by a vertical one).
+#define BILATERAL_WEIGHT_BITS 15
+#define BILATERAL_WEIGHT_ONE (1 << BILATERAL_WEIGHT_BITS)
+// Range weights of the channel differences -255 ... 255.
+#define BILATERAL_LUT_LEN ((COLOR_GRAYSCALE_MAX * 2) + 1)
+
+// Same weights as gaussian(), scaled so that the weight of a zero distance is BILATERAL_WEIGHT_ONE (the
+// normalization factor of gaussian() cancels out in the weighted averages).
+static uint16_t bilateral_weight(float x, float sigma)
+{
+    float s2 = 2.0f * sigma * sigma;
+
+    if (x == 0.0f) {
+        return BILATERAL_WEIGHT_ONE;
+    }
+
+    // Negligible weights (below exp(-16)) are zero.
+    if ((s2 == 0.0f) || (((x * x) / s2) > 16.0f)) {
+        return 0;
+    }
+
+    return fast_roundf(BILATERAL_WEIGHT_ONE * fast_expf((x * x) / -s2));
+}
+
+// Maximum value of each channel: Grayscale and RGB888 use 8-bit channels, RGB565 uses 5-6-5-bit channels.
+static int bilateral_channel_max(image_t *img, int channel)
+{
+    if (img->bpp == IMAGE_BPP_RGB565) {
+        return (channel == 1) ? COLOR_G6_MAX : COLOR_R5_MAX;
+    }
+
+    return COLOR_GRAYSCALE_MAX;
+}
+
+static int bilateral_channels(image_t *img)
+{
+    return (img->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : 3;
+}
+
+// Unpacks the line y of the image to planes of (w + (ksize * 2)) values per channel, with ksize border pixels
+// replicated on both sides.
+static void bilateral_unpack_line(image_t *img, int y, int ksize, uint8_t *planes)
+{
+    int wp = img->w + (ksize * 2);
+
+    switch (img->bpp) {
+        case IMAGE_BPP_GRAYSCALE: {
+            uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+            for (int x = -ksize, xx = img->w + ksize; x < xx; x++) {
+                planes[x + ksize] = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, IM_MIN(IM_MAX(x, 0), (img->w - 1)));
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB565: {
+            uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+            for (int x = -ksize, xx = img->w + ksize; x < xx; x++) {
+                int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, IM_MIN(IM_MAX(x, 0), (img->w - 1)));
+                planes[x + ksize] = COLOR_RGB565_TO_R5(pixel);
+                planes[wp + x + ksize] = COLOR_RGB565_TO_G6(pixel);
+                planes[(wp * 2) + x + ksize] = COLOR_RGB565_TO_B5(pixel);
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB888: {
+            rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+            for (int x = -ksize, xx = img->w + ksize; x < xx; x++) {
+                rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, IM_MIN(IM_MAX(x, 0), (img->w - 1)));
+                planes[x + ksize] = pixel.r;
+                planes[wp + x + ksize] = pixel.g;
+                planes[(wp * 2) + x + ksize] = pixel.b;
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// Weighted average of the taps_y x taps_x values starting at rows[0 ... taps_y - 1] + offset: the weight of each
+// value is its space weight times the range weight of its difference with center (lut points to the weight of
+// a zero difference).
+static inline int bilateral_value(const uint8_t **rows, int offset, int taps_y, int taps_x, int center,
+                                  const uint16_t *space, const uint16_t *lut)
+{
+    uint32_t i_acc = 0, w_acc = 0;
+
+    for (int j = 0; j < taps_y; j++) {
+        const uint8_t *k_row_ptr = rows[j] + offset;
+
+        for (int k = 0; k < taps_x; k++) {
+            int pixel = k_row_ptr[k];
+            uint32_t w = (lut[center - pixel] * (*space++)) >> BILATERAL_WEIGHT_BITS;
+            i_acc += pixel * w;
+            w_acc += w;
+        }
+    }
+
+    // The center value has always a non-zero weight.
+    return i_acc / w_acc;
+}
+
+uint32_t imlib_bilateral_filter_fast_space(image_t *img, const int ksize, bool separable)
+{
+    int n = (ksize * 2) + 1;
+
+    if ((img->bpp != IMAGE_BPP_GRAYSCALE) && (img->bpp != IMAGE_BPP_RGB565) && (img->bpp != IMAGE_BPP_RGB888)) {
+        return 0;
+    }
+
+    // The accumulators are 32-bit wide.
+    if ((!separable) && ((((uint64_t) n) * n * BILATERAL_WEIGHT_ONE * COLOR_GRAYSCALE_MAX) > UINT32_MAX)) {
+        return 0;
+    }
+
+    uint32_t line_size = (img->w + (ksize * 2)) * bilateral_channels(img);
+
+    return FB_ALLOC_SPACE(bilateral_channels(img) * BILATERAL_LUT_LEN * sizeof(uint16_t))
+        + FB_ALLOC_SPACE((separable ? n : (n * n)) * sizeof(uint16_t))
+        + FB_ALLOC_SPACE(n * sizeof(uint8_t *))
+        + FB_ALLOC_SPACE(line_size * (n + (separable ? 1 : 0)));
+}
+
+// Grayscale, RGB565 and RGB888. In separable mode the cost per pixel grows linearly with the kernel size. The
+// source lines (or their horizontal pass) are kept in a ring of (ksize * 2) + 1 lines, so that each output line
+// is written in place (or straight to dst).
+void imlib_bilateral_filter_fast(image_t *img, image_t *dst, const int ksize, float color_sigma, float space_sigma,
+                                 bool separable, bool threshold, int offset, bool invert, image_t *mask)
+{
+    int n = (ksize * 2) + 1;
+    int channels = bilateral_channels(img);
+    int wp = img->w + (ksize * 2);
+    int line_size = wp * channels;
+    uint16_t *luts = fb_alloc(channels * BILATERAL_LUT_LEN * sizeof(uint16_t), FB_ALLOC_NO_HINT);
+    uint16_t *space = fb_alloc((separable ? n : (n * n)) * sizeof(uint16_t), FB_ALLOC_NO_HINT);
+    const uint8_t **rows = fb_alloc(n * sizeof(uint8_t *), FB_ALLOC_NO_HINT);
+    uint8_t *ring = fb_alloc(line_size * (n + (separable ? 1 : 0)), FB_ALLOC_PREFER_SPEED);
+    uint8_t *line = ring + (n * line_size);
+
+    for (int c = 0; c < channels; c++) {
+        int channel_max = bilateral_channel_max(img, c);
+        float max_color = IM_DIV(1.0f, channel_max);
+        uint16_t *lut = luts + (c * BILATERAL_LUT_LEN) + COLOR_GRAYSCALE_MAX; // point to the middle
+        for (int i = 0; i <= channel_max; i++) {
+            lut[-i] = lut[i] = bilateral_weight(i * max_color, color_sigma);
+        }
+    }
+
+    // The space weights of the separable mode are the factors of the ones of the full kernel.
+    float max_space = IM_DIV(1.0f, distance(ksize, ksize));
+    for (int y = -ksize; y <= (separable ? -ksize : ksize); y++) {
+        for (int x = -ksize; x <= ksize; x++) {
+            space[(n * (y + ksize)) + (x + ksize)] = bilateral_weight((separable ? x : distance(x, y)) * max_space,
+                                                                      space_sigma);
+        }
+    }
+
+    // The pixels out of the mask keep their source value.
+    if (mask && (dst->data != img->data)) {
+        image_copy_data(dst, img);
+    }
+
+    for (int y = 0, yy = img->h, next = 0; y < yy; y++) {
+        // Loads the lines up to y + ksize.
+        for (; next <= IM_MIN((y + ksize), (img->h - 1)); next++) {
+            uint8_t *ring_ptr = ring + ((next % n) * line_size);
+
+            if (!separable) {
+                bilateral_unpack_line(img, next, ksize, ring_ptr);
+                continue;
+            }
+
+            bilateral_unpack_line(img, next, ksize, line);
+
+            for (int c = 0; c < channels; c++) {
+                const uint8_t *plane = line + (c * wp);
+                const uint16_t *lut = luts + (c * BILATERAL_LUT_LEN) + COLOR_GRAYSCALE_MAX;
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    ring_ptr[(c * wp) + x + ksize] = bilateral_value(&plane, x, 1, n, plane[x + ksize], space, lut);
+                }
+            }
+        }
+
+        for (int j = 0; j < n; j++) {
+            rows[j] = ring + ((IM_MIN(IM_MAX((y - ksize + j), 0), (img->h - 1)) % n) * line_size);
+        }
+
+        uint32_t mask_word = 0; // STM32IPL
+        for (int x = 0, xx = img->w; x < xx; x++) {
+            if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
+                continue; // Short circuit.
+            }
+
+            int value[3];
+            for (int c = 0; c < channels; c++) {
+                const uint16_t *lut = luts + (c * BILATERAL_LUT_LEN) + COLOR_GRAYSCALE_MAX;
+                int center = rows[ksize][(c * wp) + x + ksize];
+
+                if (separable) {
+                    value[c] = bilateral_value(rows, (c * wp) + x + ksize, n, 1, center, space, lut);
+                } else {
+                    value[c] = bilateral_value(rows, (c * wp) + x, n, n, center, space, lut);
+                }
+            }
+
+            switch (img->bpp) {
+                case IMAGE_BPP_GRAYSCALE: {
+                    uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+                    uint8_t *dst_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y);
+                    int pixel = value[0];
+
+                    if (threshold) {
+                        if (((pixel - offset) < IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)) ^ invert) {
+                            pixel = COLOR_GRAYSCALE_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_GRAYSCALE_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_GRAYSCALE_PIXEL_FAST(dst_row_ptr, x, pixel);
+                    break;
+                }
+                case IMAGE_BPP_RGB565: {
+                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+                    uint16_t *dst_row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y);
+                    int pixel = COLOR_R5_G6_B5_TO_RGB565(value[0], value[1], value[2]);
+
+                    if (threshold) {
+                        if (((COLOR_RGB565_TO_Y(pixel) - offset) < COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel = COLOR_RGB565_BINARY_MAX;
+                        } else {
+                            pixel = COLOR_RGB565_BINARY_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB565_PIXEL_FAST(dst_row_ptr, x, pixel);
+                    break;
+                }
+                default: {
+                    rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+                    rgb888_t *dst_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(dst, y);
+                    rgb888_t pixel888;
+                    pixel888.r = value[0];
+                    pixel888.g = value[1];
+                    pixel888.b = value[2];
+
+                    if (threshold) {
+                        if (((COLOR_RGB888_TO_Y(pixel888.r, pixel888.g, pixel888.b) - offset) < COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x))) ^ invert) {
+                            pixel888.r = COLOR_R8_MAX;
+                            pixel888.g = COLOR_G8_MAX;
+                            pixel888.b = COLOR_B8_MAX;
+                        } else {
+                            pixel888.r = COLOR_R8_MIN;
+                            pixel888.g = COLOR_G8_MIN;
+                            pixel888.b = COLOR_B8_MIN;
+                        }
+                    }
+
+                    IMAGE_PUT_RGB888_PIXEL_FAST(dst_row_ptr, x, pixel888);
+                    break;
+                }
+            }
+        }
+    }
+
+    fb_free();
+    fb_free();
+    fb_free();
+    fb_free();
+}
 #endif // IMLIB_ENABLE_BILATERAL
 
 #ifndef STM32IPL
@@ -2494,18 +4092,21 @@ void imlib_cartoon_filter(image_t *img, float seed_threshold, float floating_thr
     mean_image.w = img->w;
     mean_image.h = img->h;
     mean_image.bpp = IMAGE_BPP_BINARY;
+    mean_image.stride = 0;
     mean_image.data = fb_alloc0(image_size(&mean_image), FB_ALLOC_NO_HINT);
 
     fill_image.w = img->w;
     fill_image.h = img->h;
     fill_image.bpp = IMAGE_BPP_BINARY;
+    fill_image.stride = 0;
     fill_image.data = fb_alloc0(image_size(&fill_image), FB_ALLOC_NO_HINT);
 
     if (mask) {
         for (int y = 0, yy = fill_image.h; y < yy; y++) {
             uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&fill_image, y);
+            uint32_t mask_word = 0; // STM32IPL
             for (int x = 0, xx = fill_image.w; x < xx; x++) {
-                if (image_get_mask_pixel(mask, x, y)) IMAGE_SET_BINARY_PIXEL_FAST(row_ptr, x);
+                if (IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y)) IMAGE_SET_BINARY_PIXEL_FAST(row_ptr, x);
             }
         }
     }
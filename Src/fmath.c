@@ -10,6 +10,10 @@
  */
 #include "fmath.h"
 #include "common.h"
+#include "stm32ipl_imlib.h" // STM32IPL
+#ifdef IPL_FMATH_HAS_MVE // STM32IPL
+#include "mve_fmath.h"
+#endif // STM32IPL
 
 #define M_PI    3.14159265f
 #define M_PI_2  1.57079632f
@@ -222,3 +226,59 @@ void fast_get_min_max(float *data, size_t data_len, float *p_min, float *p_max)
     *p_min = min;
     *p_max = max;
 }
+
+// STM32IPL: array versions, see fmath.h.
+void fast_sqrtf_vec(const float *x, float *r, size_t n)
+{
+#ifdef IPL_FMATH_HAS_MVE
+    mve_fmath_sqrtf_vec(x, r, n);
+#else
+    for (size_t i = 0; i < n; i++) {
+        r[i] = fast_sqrtf(x[i]);
+    }
+#endif
+}
+
+void fast_atan2f_vec(const float *y, const float *x, float *r, size_t n)
+{
+#ifdef IPL_FMATH_HAS_MVE
+    mve_fmath_atan2f_vec(y, x, r, n);
+#else
+    for (size_t i = 0; i < n; i++) {
+        r[i] = fast_atan2f(y[i], x[i]);
+    }
+#endif
+}
+
+void fast_expf_vec(const float *x, float *r, size_t n)
+{
+#ifdef IPL_FMATH_HAS_MVE
+    mve_fmath_expf_vec(x, r, n);
+#else
+    for (size_t i = 0; i < n; i++) {
+        r[i] = fast_expf(x[i]);
+    }
+#endif
+}
+
+void fast_log2_vec(const float *x, float *r, size_t n)
+{
+#ifdef IPL_FMATH_HAS_MVE
+    mve_fmath_log2_vec(x, r, n);
+#else
+    for (size_t i = 0; i < n; i++) {
+        r[i] = fast_log2(x[i]);
+    }
+#endif
+}
+
+void fast_powf_vec(const float *a, float b, float *r, size_t n)
+{
+#ifdef IPL_FMATH_HAS_MVE
+    mve_fmath_powf_vec(a, b, r, n);
+#else
+    for (size_t i = 0; i < n; i++) {
+        r[i] = fast_powf(a[i], b);
+    }
+#endif
+}
@@ -25,6 +25,9 @@
 #define FR_OK 0
 #endif // STM32IPL
 #include "imlib.h"
+#ifdef IPL_HAAR_HAS_MVE // STM32IPL
+#include "mve_haar.h"
+#endif // STM32IPL
 // built-in cascades
 #include "cascade.h"
 
@@ -52,7 +55,9 @@ static int eval_weak_classifier(cascade_t *cascade, point_t pt, int t_idx, int w
     return cascade->alpha1_array[t_idx];
 }
 
-static int run_cascade_classifier(cascade_t* cascade, point_t pt)
+// STM32IPL: standard deviation of the window, split from run_cascade_classifier to be shared with the
+// multi-window evaluation; returns false for homogeneous windows, which are skipped.
+static bool window_std(cascade_t *cascade, point_t pt, int *std)
 {
     int win_w = cascade->window.w;
     int win_h = cascade->window.h;
@@ -64,10 +69,19 @@ static int run_cascade_classifier(cascade_t* cascade, point_t pt)
 
     // Skip homogeneous regions.
     if (v<(50*50)) {
+        return false;
+    }
+
+    *std = (int)(fast_sqrtf(i_sq*n-(i_s*i_s)));  // STM32IPL: added cast.
+    return true;
+}
+
+static int run_cascade_classifier(cascade_t* cascade, point_t pt)
+{
+    if (!window_std(cascade, pt, &cascade->std)) { // STM32IPL
         return 0;
     }
 
-    cascade->std = (int)(fast_sqrtf(i_sq*n-(i_s*i_s)));  // STM32IPL: added cast.
     for (int i=0, w_idx=0, r_idx=0, t_idx=0; i<cascade->n_stages; i++) {
         int stage_sum = 0;
         for (int j=0; j<cascade->stages_array[i]; j++, t_idx++) {
@@ -84,7 +98,50 @@ static int run_cascade_classifier(cascade_t* cascade, point_t pt)
     return 1;
 }
 
-array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *roi)
+// STM32IPL: reverses the objects from first to last (excluded).
+static void detect_objects_reverse(array_t *objects, int first, int last)
+{
+    for (last--; first < last; first++, last--) {
+        void *tmp = objects->data[first];
+        objects->data[first] = objects->data[last];
+        objects->data[last] = tmp;
+    }
+}
+
+// STM32IPL: gets the scale factor and the scanning step of the given scale, as the scanning step is reduced at
+// each scale starting from step; returns false when the scaled roi is smaller than the window.
+static bool detect_objects_scale(cascade_t *cascade, rectangle_t *roi, int step, int scale, float *factor,
+        int *scale_step)
+{
+    float f = 1.0f;
+
+    for (int i = 0; ; i++, f *= cascade->scale_factor) {
+        // Break if scaled image is smaller than feature size
+        if (((int)(roi->w/f) < cascade->window.w) || ((int)(roi->h/f) < cascade->window.h)) {
+            return false;
+        }
+
+        // Scale the scanning step
+        step = (int)(step/f);
+        step = (step == 0) ? 1 : step;
+
+        if (i == scale) {
+            *factor = f;
+            *scale_step = step;
+            return true;
+        }
+    }
+}
+
+// STM32IPL: each scale is computed from the pyramid level closest to it (not smaller), so that the
+// integral images sample a decimated image instead of skipping pixels of the full resolution one.
+// The first level is the full resolution image; roi refers to it. Only the scales from first_scale to
+// last_scale (all the ones down to the window size when last_scale < 0) are searched; the scanning
+// step is computed as for a roi of width step_w, so that a part of the image is searched as in a scan
+// of a larger roi.
+// STM32IPL: the detections are merged only when merge is true.
+static array_t *detect_objects_range(image_t *levels, const float *scales, int n_levels, cascade_t *cascade,
+        rectangle_t *roi, int step_w, int first_scale, int last_scale, bool merge)
 {
     // Integral images
     mw_image_t sum;
@@ -97,7 +154,7 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     array_alloc(&objects, xfree);
 
     // Set cascade image pointers
-    cascade->img = image;
+    cascade->img = &levels[0]; // STM32IPL
     cascade->sum = &sum;
     cascade->ssq = &ssq;
 
@@ -105,7 +162,7 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     // Viola and Jones achieved best results using a scaling factor
     // of 1.25 and a scanning factor proportional to the current scale.
     // Start with a step of 5% of the image width and reduce at each scaling step
-    cascade->step = (roi->w*50)/1000;
+    cascade->step = (step_w*50)/1000; // STM32IPL
 
     // Make sure step is less than window height + 1
     if (cascade->step > cascade->window.h) {
@@ -116,27 +173,51 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     imlib_integral_mw_alloc(&sum, roi->w, cascade->window.h+1);
     imlib_integral_mw_alloc(&ssq, roi->w, cascade->window.h+1);
 
+    // STM32IPL: count the scales.
+    int first_step = cascade->step;
+    int n_scales = 0;
+    float factor;
+    while (((last_scale < 0) || (n_scales <= last_scale))
+    && detect_objects_scale(cascade, roi, first_step, n_scales, &factor, &cascade->step)) {
+        n_scales++;
+    }
+
+    // STM32IPL: with a deadline (see STM32Ipl_SetDeadline()), the scales are searched from the coarsest one, the
+    // cheapest, so that the largest objects are found first when the search is stopped.
+    bool coarse_first = ctx_deadline_active();
+
     // Iterate over the image pyramid
-    for(float factor=1.0f; ; factor *= cascade->scale_factor) {
+    for (int i = first_scale; (i < n_scales) && (!ctx_deadline_expired()); i++) { // STM32IPL
+        int scale = coarse_first ? (n_scales - 1 - (i - first_scale)) : i; // STM32IPL
+        int scale_first = array_length(objects); // STM32IPL
+
+        // STM32IPL: set the scale factor and the scanning step.
+        detect_objects_scale(cascade, roi, first_step, scale, &factor, &cascade->step);
+
         // Set the scaled width and height
         int szw = (int)(roi->w/factor); // STM32IPL: added cast.
         int szh = (int)(roi->h/factor); // STM32IPL: added cast.
 
-        // Break if scaled image is smaller than feature size
-        if (szw < cascade->window.w || szh < cascade->window.h) {
-            break;
+        // STM32IPL: select the coarsest pyramid level that is not smaller than the scaled image.
+        int level = 0;
+        while (((level + 1) < n_levels) && (scales[level + 1] <= factor)) {
+            level++;
         }
 
+        image_t *image = &levels[level];
+        rectangle_t level_roi;
+        level_roi.x = (int)(roi->x / scales[level]);
+        level_roi.y = (int)(roi->y / scales[level]);
+        level_roi.w = IM_MAX(IM_MIN((int)(roi->w / scales[level]), image->w - level_roi.x), 1);
+        level_roi.h = IM_MAX(IM_MIN((int)(roi->h / scales[level]), image->h - level_roi.y), 1);
+        cascade->img = image;
+
         // Set the integral images scale
-        imlib_integral_mw_scale(roi, &sum, szw, szh);
-        imlib_integral_mw_scale(roi, &ssq, szw, szh);
+        imlib_integral_mw_scale(&level_roi, &sum, szw, szh);
+        imlib_integral_mw_scale(&level_roi, &ssq, szw, szh);
 
         // Compute new scaled integral images
-        imlib_integral_mw_ss(image, &sum, &ssq, roi);
-
-        // Scale the scanning step
-        cascade->step = (int)(cascade->step/factor); // STM32IPL: added cast.
-        cascade->step = (cascade->step == 0) ? 1 : cascade->step;
+        imlib_integral_mw_ss(image, &sum, &ssq, &level_roi);
 
         // Process image at the current scale
         // When filter window shifts to borders, some margin need to be kept
@@ -145,6 +226,41 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
 
         // Shift the filter window over the image.
         for (int y=0; y<y2; y+=cascade->step) {
+            // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()).
+            if (ctx_deadline_expired()) {
+                break;
+            }
+
+#ifdef IPL_HAAR_HAS_MVE // STM32IPL
+            // STM32IPL: evaluate MVE_HAAR_WINDOWS horizontally adjacent windows at once.
+            for (int x=0; x<x2; x+=cascade->step*MVE_HAAR_WINDOWS) {
+                int32_t std[MVE_HAAR_WINDOWS] = {0};
+                mve_pred16_t active = 0;
+
+                for (int k=0; (k<MVE_HAAR_WINDOWS) && ((x+k*cascade->step)<x2); k++) {
+                    point_t p = {x+k*cascade->step, y};
+                    int s;
+                    if (window_std(cascade, p, &s)) {
+                        std[k] = s;
+                        active |= 0xF << (k*4);
+                    }
+                }
+
+                if (active) {
+                    active = mve_haar_run_cascade(cascade, x, cascade->step, std, active);
+                }
+
+                for (int k=0; k<MVE_HAAR_WINDOWS; k++) {
+                    // If an object is detected, record the coordinates of the filter window
+                    if (active & (1 << (k*4))) {
+                        array_push_back(objects,
+                            rectangle_alloc(fast_roundf((x+k*cascade->step)*factor) + roi->x,
+                            fast_roundf(y*factor) + roi->y,
+                            fast_roundf(cascade->window.w*factor), fast_roundf(cascade->window.h*factor)));
+                    }
+                }
+            }
+#else
             for (int x=0; x<x2; x+=cascade->step) {
                 point_t p = {x, y};
                 // If an object is detected, record the coordinates of the filter window
@@ -154,18 +270,27 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
                         fast_roundf(cascade->window.w*factor), fast_roundf(cascade->window.h*factor)));
                 }
             }
+#endif // STM32IPL
 
             // If not last line, shift integral images
             if ((y+cascade->step) < y2) {
-                imlib_integral_mw_shift_ss(image, &sum, &ssq, roi, cascade->step);
+                imlib_integral_mw_shift_ss(image, &sum, &ssq, &level_roi, cascade->step); // STM32IPL
             }
         }
+
+        // STM32IPL: move the objects of this scale before the ones of the coarser scales, so that they are merged
+        // in the same order as without a deadline.
+        if (coarse_first) {
+            detect_objects_reverse(objects, 0, scale_first);
+            detect_objects_reverse(objects, scale_first, array_length(objects));
+            detect_objects_reverse(objects, 0, array_length(objects));
+        }
     }
 
     imlib_integral_mw_free(&ssq);
     imlib_integral_mw_free(&sum);
 
-    if (array_length(objects) > 1)   {
+    if (merge && (array_length(objects) > 1))   { // STM32IPL
         // Merge objects detected at different scales
         objects = rectangle_merge(objects);
     }
@@ -173,6 +298,36 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     return objects;
 }
 
+// STM32IPL
+array_t *imlib_detect_objects_range(image_t *levels, const float *scales, int n_levels, cascade_t *cascade,
+        rectangle_t *roi, int step_w, int first_scale, int last_scale)
+{
+    return detect_objects_range(levels, scales, n_levels, cascade, roi, step_w, first_scale, last_scale, true);
+}
+
+// STM32IPL: all the detections of a single level pyramid, not merged.
+array_t *imlib_detect_objects_raw(image_t *image, cascade_t *cascade, rectangle_t *roi)
+{
+    float scale = 1.0f;
+
+    return detect_objects_range(image, &scale, 1, cascade, roi, roi->w, 0, -1, false);
+}
+
+// STM32IPL: all the scales.
+array_t *imlib_detect_objects_pyramid(image_t *levels, const float *scales, int n_levels, cascade_t *cascade,
+        rectangle_t *roi)
+{
+    return imlib_detect_objects_range(levels, scales, n_levels, cascade, roi, roi->w, 0, -1);
+}
+
+// STM32IPL: single level pyramid.
+array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *roi)
+{
+    float scale = 1.0f;
+
+    return imlib_detect_objects_pyramid(image, &scale, 1, cascade, roi);
+}
+
 #ifdef STM32IPL_ENABLE_IMAGE_IO // STM32IPL
 #if defined(IMLIB_ENABLE_IMAGE_FILE_IO)
 int imlib_load_cascade_from_file(cascade_t *cascade, const char *path)
@@ -10,11 +10,164 @@
  */
 #include "imlib.h"
 
+#if defined(IMLIB_ENABLE_FIND_LINES) || defined(IMLIB_ENABLE_FIND_CIRCLES)
+// STM32IPL: the gradients of a row are collected, so that their directions (and magnitudes) are computed at once
+// with fast_atan2f_vec() (and fast_sqrtf_vec()).
+typedef struct hough_row {
+    int n;
+    int *x;
+    float *x_acc;
+    float *y_acc; // overwritten with the directions
+    float *mag;
+} hough_row_t;
+
+static void hough_row_alloc(hough_row_t *row, int w)
+{
+    row->n = 0;
+    row->x = fb_alloc(w * sizeof(int), FB_ALLOC_NO_HINT);
+    row->x_acc = fb_alloc(w * sizeof(float), FB_ALLOC_NO_HINT);
+    row->y_acc = fb_alloc(w * sizeof(float), FB_ALLOC_NO_HINT);
+    row->mag = fb_alloc(w * sizeof(float), FB_ALLOC_NO_HINT);
+}
+
+static void hough_row_free(void)
+{
+    fb_free(); // mag
+    fb_free(); // y_acc
+    fb_free(); // x_acc
+    fb_free(); // x
+}
+#endif // IMLIB_ENABLE_FIND_LINES || IMLIB_ENABLE_FIND_CIRCLES
+
 #ifdef IMLIB_ENABLE_FIND_LINES
+// STM32IPL: merges overlapping lines and computes their end points (shared with imlib_find_lines_edges).
+static void find_lines_merge(list_t *out, rectangle_t *roi, unsigned int theta_margin, unsigned int rho_margin)
+{
+    for (;;) { // Merge overlapping.
+        bool merge_occured = false;
+
+        list_t out_temp;
+        list_init(&out_temp, sizeof(find_lines_list_lnk_data_t));
+
+        while (list_size(out)) {
+            find_lines_list_lnk_data_t lnk_line;
+            list_pop_front(out, &lnk_line);
+
+            for (size_t k = 0, l = list_size(out); k < l; k++) {
+                find_lines_list_lnk_data_t tmp_line;
+                list_pop_front(out, &tmp_line);
+
+                int theta_0_temp = lnk_line.theta;
+                int theta_1_temp = tmp_line.theta;
+                int rho_0_temp = lnk_line.rho;
+                int rho_1_temp = tmp_line.rho;
+
+                if (rho_0_temp < 0) {
+                    rho_0_temp = -rho_0_temp;
+                    theta_0_temp += 180;
+                }
+
+                if (rho_1_temp < 0) {
+                    rho_1_temp = -rho_1_temp;
+                    theta_1_temp += 180;
+                }
+
+                int theta_diff = abs(theta_0_temp - theta_1_temp);
+                int theta_diff_2 = (theta_diff >= 180) ? (360 - theta_diff) : theta_diff;
+
+                bool theta_merge = theta_diff_2 < theta_margin;
+                bool rho_merge = abs(rho_0_temp - rho_1_temp) < rho_margin;
+
+                if (theta_merge && rho_merge) {
+                    uint32_t magnitude = lnk_line.magnitude + tmp_line.magnitude;
+                    float sin_mean = ((sin_table[theta_0_temp] * lnk_line.magnitude)
+                            + (sin_table[theta_1_temp] * tmp_line.magnitude)) / magnitude;
+                    float cos_mean = ((cos_table[theta_0_temp] * lnk_line.magnitude)
+                            + (cos_table[theta_1_temp] * tmp_line.magnitude)) / magnitude;
+
+                    // STM32IPL: fast_atan2f() does not handle x == 0 (returns +/-PI), as done when voting.
+                    float theta_mean = cos_mean ? fast_atan2f(sin_mean, cos_mean) : ((sin_mean < 0) ? 4.712389f : 1.570796f);
+                    lnk_line.theta = fast_roundf(theta_mean * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
+                    if (lnk_line.theta < 0) lnk_line.theta += 360;
+                    lnk_line.rho = fast_roundf(((rho_0_temp * lnk_line.magnitude) + (rho_1_temp * tmp_line.magnitude)) / magnitude);
+                    lnk_line.magnitude = magnitude / 2;
+
+                    if (lnk_line.theta >= 180) {
+                        lnk_line.rho = -lnk_line.rho;
+                        lnk_line.theta -= 180;
+                    }
+
+                    merge_occured = true;
+                } else {
+                    list_push_back(out, &tmp_line);
+                }
+            }
+
+            list_push_back(&out_temp, &lnk_line);
+        }
+
+        list_copy(out, &out_temp);
+
+        if (!merge_occured) {
+            break;
+        }
+    }
+
+    for (size_t i = 0, j = list_size(out); i < j; i++) {
+        find_lines_list_lnk_data_t lnk_line;
+        list_pop_front(out, &lnk_line);
+
+        if ((45 <= lnk_line.theta) && (lnk_line.theta < 135)) {
+            // y = (r - x cos(t)) / sin(t)
+            lnk_line.line.x1 = 0;
+            lnk_line.line.y1 = fast_roundf((lnk_line.rho - (lnk_line.line.x1 * cos_table[lnk_line.theta])) / sin_table[lnk_line.theta]);
+            lnk_line.line.x2 = roi->w - 1;
+            lnk_line.line.y2 = fast_roundf((lnk_line.rho - (lnk_line.line.x2 * cos_table[lnk_line.theta])) / sin_table[lnk_line.theta]);
+        } else {
+            // x = (r - y sin(t)) / cos(t);
+            lnk_line.line.y1 = 0;
+            lnk_line.line.x1 = fast_roundf((lnk_line.rho - (lnk_line.line.y1 * sin_table[lnk_line.theta])) / cos_table[lnk_line.theta]);
+            lnk_line.line.y2 = roi->h - 1;
+            lnk_line.line.x2 = fast_roundf((lnk_line.rho - (lnk_line.line.y2 * sin_table[lnk_line.theta])) / cos_table[lnk_line.theta]);
+        }
+
+        if(lb_clip_line(&lnk_line.line, 0, 0, roi->w, roi->h)) {
+            lnk_line.line.x1 += roi->x;
+            lnk_line.line.y1 += roi->y;
+            lnk_line.line.x2 += roi->x;
+            lnk_line.line.y2 += roi->y;
+
+            // Move rho too.
+            lnk_line.rho += fast_roundf((roi->x * cos_table[lnk_line.theta]) + (roi->y * sin_table[lnk_line.theta]));
+            list_push_back(out, &lnk_line);
+        }
+    }
+}
+
+// STM32IPL: votes for the lines through the edge pixels collected in a row.
+static void find_lines_vote(hough_row_t *row, rectangle_t *roi, int y, uint32_t *acc, int theta_size,
+                            int hough_divide, int r_diag_len_div)
+{
+    fast_atan2f_vec(row->y_acc, row->x_acc, row->y_acc, row->n);
+
+    for (int i = 0; i < row->n; i++) {
+        int theta = fast_roundf((row->x_acc[i] ? row->y_acc[i] : 1.570796f) * 57.295780f) % 180; // * (180 / PI)
+        if (theta < 0) theta += 180;
+        int rho = (fast_roundf(((row->x[i] - roi->x) * cos_table[theta]) +
+                    ((y - roi->y) * sin_table[theta])) / hough_divide) + r_diag_len_div;
+        int acc_index = (rho * theta_size) + ((theta / hough_divide) + 1); // add offset
+        acc[acc_index] += (int) row->mag[i];
+    }
+
+    row->n = 0;
+}
+
 void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
                       uint32_t threshold, unsigned int theta_margin, unsigned int rho_margin)
 {
     int r_diag_len, r_diag_len_div, theta_size, r_size, hough_divide = 1; // divides theta and rho accumulators
+    hough_row_t row; // STM32IPL
+    hough_row_alloc(&row, roi->w); // STM32IPL
 
     for (;;) { // shrink to fit...
         r_diag_len = fast_roundf(fast_sqrtf((roi->w * roi->w) + (roi->h * roi->h)));
@@ -85,13 +238,13 @@ void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                     if (mag < 126)
                     	continue;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 180; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 180;
-                    int rho = (fast_roundf(((x - roi->x) * cos_table[theta]) +
-                                ((y - roi->y) * sin_table[theta])) / hough_divide) + r_diag_len_div;
-                    int acc_index = (rho * theta_size) + ((theta / hough_divide) + 1); // add offset
-                    acc[acc_index] += mag;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = mag;
                 }
+
+                find_lines_vote(&row, roi, y, acc, theta_size, hough_divide, r_diag_len_div);
             }
             break;
         }
@@ -151,13 +304,13 @@ void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                     if (mag < 126)
                     	continue;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 180; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 180;
-                    int rho = (fast_roundf(((x - roi->x) * cos_table[theta]) +
-                                ((y - roi->y) * sin_table[theta])) / hough_divide) + r_diag_len_div;
-                    int acc_index = (rho * theta_size) + ((theta / hough_divide) + 1); // add offset
-                    acc[acc_index] += mag;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = mag;
                 }
+
+                find_lines_vote(&row, roi, y, acc, theta_size, hough_divide, r_diag_len_div);
             }
             break;
         }
@@ -217,13 +370,13 @@ void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                     if (mag < 126)
                     	continue;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 180; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 180;
-                    int rho = (fast_roundf(((x - roi->x) * cos_table[theta]) +
-                                ((y - roi->y) * sin_table[theta])) / hough_divide) + r_diag_len_div;
-                    int acc_index = (rho * theta_size) + ((theta / hough_divide) + 1); // add offset
-                    acc[acc_index] += mag;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = mag;
                 }
+
+                find_lines_vote(&row, roi, y, acc, theta_size, hough_divide, r_diag_len_div);
             }
             break;
         }
@@ -283,13 +436,13 @@ void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
                     if (mag < 126)
                     	continue;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 180; // * (180 / PI)	// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 180;
-                    int rho = (fast_roundf(((x - roi->x) * cos_table[theta]) +
-                                ((y - roi->y) * sin_table[theta])) / hough_divide) + r_diag_len_div;
-                    int acc_index = (rho * theta_size) + ((theta / hough_divide) + 1); // add offset
-                    acc[acc_index] += mag;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = mag;
                 }
+
+                find_lines_vote(&row, roi, y, acc, theta_size, hough_divide, r_diag_len_div);
             }
             break;
         }
@@ -327,104 +480,149 @@ void imlib_find_lines(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
     }
 
     fb_free(); // acc
+    hough_row_free(); // STM32IPL
 
-    for (;;) { // Merge overlapping.
-        bool merge_occured = false;
+    find_lines_merge(out, roi, theta_margin, rho_margin); // STM32IPL
+}
 
-        list_t out_temp;
-        list_init(&out_temp, sizeof(find_lines_list_lnk_data_t));
+// STM32IPL: normal angle (degrees, 0-179) of the edge through a pixel, estimated from the second order moments
+// of its 8-connected edge neighbours; the index is the neighbour mask (bit 0 = top-left, 1 = top, 2 = top-right,
+// 3 = left, 4 = right, 5 = bottom-left, 6 = bottom, 7 = bottom-right), 255 marks an undefined orientation.
+static const uint8_t find_lines_edges_theta[256] = {
+    255, 135,   0, 148,  45, 255,  32,   0,  90, 122, 255, 135,  58,  90,  45, 255,
+     90, 122, 255, 135,  58,  90,  45, 255,  90, 113,  90, 122,  68,  90,  58,  90,
+     45, 255,  32,   0,  45,  45,  38,  32,  58,  90,  45, 255,  52,  58,  45,  45,
+     58,  90,  45, 255,  52,  58,  45,  45,  68,  90,  58,  90,  58,  68,  52,  58,
+      0, 148,   0, 158,  32,   0,  23,   0, 255, 135,   0, 148,  45, 255,  32,   0,
+    255, 135,   0, 148,  45, 255,  32,   0,  90, 122, 255, 135,  58,  90,  45, 255,
+     32,   0,  23,   0,  38,  32,  32,  23,  45, 255,  32,   0,  45,  45,  38,  32,
+     45, 255,  32,   0,  45,  45,  38,  32,  58,  90,  45, 255,  52,  58,  45,  45,
+    135, 135, 148, 142, 255, 135,   0, 148, 122, 128, 135, 135,  90, 122, 255, 135,
+    122, 128, 135, 135,  90, 122, 255, 135, 113, 122, 122, 128,  90, 113,  90, 122,
+    255, 135,   0, 148,  45, 255,  32,   0,  90, 122, 255, 135,  58,  90,  45, 255,
+     90, 122, 255, 135,  58,  90,  45, 255,  90, 113,  90, 122,  68,  90,  58,  90,
+    148, 142, 158, 148,   0, 148,   0, 158, 135, 135, 148, 142, 255, 135,   0, 148,
+    135, 135, 148, 142, 255, 135,   0, 148, 122, 128, 135, 135,  90, 122, 255, 135,
+      0, 148,   0, 158,  32,   0,  23,   0, 255, 135,   0, 148,  45, 255,  32,   0,
+    255, 135,   0, 148,  45, 255,  32,   0,  90, 122, 255, 135,  58,  90,  45, 255
+};
+
+// STM32IPL: loads row y of the ROI as 0/1 values into row[1..w], row[0] and row[w + 1] being zero padding.
+static void find_lines_edges_row(image_t *ptr, rectangle_t *roi, int y, uint8_t *row)
+{
+    memset(row, 0, roi->w + 2);
 
-        while (list_size(out)) {
-            find_lines_list_lnk_data_t lnk_line;
-            list_pop_front(out, &lnk_line);
+    if ((y < roi->y) || (y >= (roi->y + roi->h))) {
+        return;
+    }
 
-            for (size_t k = 0, l = list_size(out); k < l; k++) {
-                find_lines_list_lnk_data_t tmp_line;
-                list_pop_front(out, &tmp_line);
+    if (ptr->bpp == IMAGE_BPP_BINARY) {
+        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+        for (int x = 0; x < roi->w; x++) {
+            row[x + 1] = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, roi->x + x);
+        }
+    } else {
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y) + roi->x;
+        for (int x = 0; x < roi->w; x++) {
+            row[x + 1] = row_ptr[x] != 0;
+        }
+    }
+}
 
-                int theta_0_temp = lnk_line.theta;
-                int theta_1_temp = tmp_line.theta;
-                int rho_0_temp = lnk_line.rho;
-                int rho_1_temp = tmp_line.rho;
+// STM32IPL: Hough transform of a precomputed edge map (Binary or Grayscale, non-zero pixels are edges).
+// Each edge pixel casts one vote per theta bin within +/- vote_margin degrees of its local edge normal,
+// rho being computed with the Q14 sin/cos tables; the uint16_t accumulator saturates and the line magnitude
+// is the number of votes. Returns false when the working memory is not enough.
+bool imlib_find_lines_edges(list_t *out, image_t *ptr, rectangle_t *roi, uint32_t threshold,
+                            unsigned int vote_margin, unsigned int theta_margin, unsigned int rho_margin)
+{
+    int r_diag_len, r_diag_len_div, theta_size, r_size, hough_divide = 1; // divides theta and rho accumulators
+    uint32_t rows_size = FB_ALLOC_SPACE(roi->w + 2);
 
-                if (rho_0_temp < 0) {
-                    rho_0_temp = -rho_0_temp;
-                    theta_0_temp += 180;
-                }
+    list_init(out, sizeof(find_lines_list_lnk_data_t));
 
-                if (rho_1_temp < 0) {
-                    rho_1_temp = -rho_1_temp;
-                    theta_1_temp += 180;
-                }
+    for (;;) { // shrink to fit...
+        r_diag_len = fast_roundf(fast_sqrtf((roi->w * roi->w) + (roi->h * roi->h)));
+        r_diag_len_div = (r_diag_len + hough_divide - 1) / hough_divide;
+        theta_size = 1 + ((180 + hough_divide - 1) / hough_divide) + 1; // left & right padding
+        r_size = (r_diag_len_div * 2) + 1; // -r_diag_len to +r_diag_len
+        if ((FB_ALLOC_SPACE(sizeof(uint16_t) * theta_size * r_size) + (3 * rows_size)) <= fb_avail()) break;
+        hough_divide = hough_divide << 1; // powers of 2...
+        if (hough_divide > 4) return false; // support 1, 2, 4
+    }
 
-                int theta_diff = abs(theta_0_temp - theta_1_temp);
-                int theta_diff_2 = (theta_diff >= 180) ? (360 - theta_diff) : theta_diff;
+    uint8_t *prev = fb_alloc(roi->w + 2, FB_ALLOC_NO_HINT);
+    uint8_t *curr = fb_alloc(roi->w + 2, FB_ALLOC_NO_HINT);
+    uint8_t *next = fb_alloc(roi->w + 2, FB_ALLOC_NO_HINT);
+    uint16_t *acc = fb_alloc0(sizeof(uint16_t) * theta_size * r_size, FB_ALLOC_NO_HINT);
 
-                bool theta_merge = theta_diff_2 < theta_margin;
-                bool rho_merge = abs(rho_0_temp - rho_1_temp) < rho_margin;
+    find_lines_edges_row(ptr, roi, roi->y - 1, prev);
+    find_lines_edges_row(ptr, roi, roi->y, curr);
 
-                if (theta_merge && rho_merge) {
-                    uint32_t magnitude = lnk_line.magnitude + tmp_line.magnitude;
-                    float sin_mean = ((sin_table[theta_0_temp] * lnk_line.magnitude)
-                            + (sin_table[theta_1_temp] * tmp_line.magnitude)) / magnitude;
-                    float cos_mean = ((cos_table[theta_0_temp] * lnk_line.magnitude)
-                            + (cos_table[theta_1_temp] * tmp_line.magnitude)) / magnitude;
+    for (int y = 0; y < roi->h; y++) {
+        find_lines_edges_row(ptr, roi, roi->y + y + 1, next);
 
-                    lnk_line.theta = fast_roundf(fast_atan2f(sin_mean, cos_mean) * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (lnk_line.theta < 0) lnk_line.theta += 360;
-                    lnk_line.rho = fast_roundf(((rho_0_temp * lnk_line.magnitude) + (rho_1_temp * tmp_line.magnitude)) / magnitude);
-                    lnk_line.magnitude = magnitude / 2;
+        for (int x = 0; x < roi->w; x++) {
+            if (!curr[x + 1]) continue;
 
-                    if (lnk_line.theta >= 180) {
-                        lnk_line.rho = -lnk_line.rho;
-                        lnk_line.theta -= 180;
-                    }
+            int theta = find_lines_edges_theta[prev[x] | (prev[x + 1] << 1) | (prev[x + 2] << 2) | (curr[x] << 3) |
+                                               (curr[x + 2] << 4) | (next[x] << 5) | (next[x + 1] << 6) |
+                                               (next[x + 2] << 7)];
+            if (theta == 255) continue;
 
-                    merge_occured = true;
-                } else {
-                    list_push_back(out, &tmp_line);
-                }
-            }
+            // 180 is a multiple of hough_divide, so aligning t aligns its wrapped value too.
+            int t = theta - (int) vote_margin;
+            t += (-t) & (hough_divide - 1);
 
-            list_push_back(&out_temp, &lnk_line);
+            for (int tt = theta + (int) vote_margin; t <= tt; t += hough_divide) {
+                int theta_t = (t < 0) ? (t + 180) : ((t >= 180) ? (t - 180) : t);
+                int rho = (((x * cos_table_q14[theta_t]) + (y * sin_table_q14[theta_t]) + (1 << 13)) >> 14) /
+                          hough_divide;
+                uint16_t *cell = acc + ((rho + r_diag_len_div) * theta_size) + ((theta_t / hough_divide) + 1);
+                if (*cell != UINT16_MAX) (*cell)++;
+            }
         }
 
-        list_copy(out, &out_temp);
-
-        if (!merge_occured) {
-            break;
-        }
+        uint8_t *tmp = prev;
+        prev = curr;
+        curr = next;
+        next = tmp;
     }
 
-    for (size_t i = 0, j = list_size(out); i < j; i++) {
-        find_lines_list_lnk_data_t lnk_line;
-        list_pop_front(out, &lnk_line);
+    for (int y = 1, yy = r_size - 1; y < yy; y++) {
+        uint16_t *row_ptr = acc + (theta_size * y);
 
-        if ((45 <= lnk_line.theta) && (lnk_line.theta < 135)) {
-            // y = (r - x cos(t)) / sin(t)
-            lnk_line.line.x1 = 0;
-            lnk_line.line.y1 = fast_roundf((lnk_line.rho - (lnk_line.line.x1 * cos_table[lnk_line.theta])) / sin_table[lnk_line.theta]);
-            lnk_line.line.x2 = roi->w - 1;
-            lnk_line.line.y2 = fast_roundf((lnk_line.rho - (lnk_line.line.x2 * cos_table[lnk_line.theta])) / sin_table[lnk_line.theta]);
-        } else {
-            // x = (r - y sin(t)) / cos(t);
-            lnk_line.line.y1 = 0;
-            lnk_line.line.x1 = fast_roundf((lnk_line.rho - (lnk_line.line.y1 * sin_table[lnk_line.theta])) / cos_table[lnk_line.theta]);
-            lnk_line.line.y2 = roi->h - 1;
-            lnk_line.line.x2 = fast_roundf((lnk_line.rho - (lnk_line.line.y2 * sin_table[lnk_line.theta])) / cos_table[lnk_line.theta]);
-        }
+        for (int x = 1, xx = theta_size - 1; x < xx; x++) {
+            if ((row_ptr[x] >= threshold)
+            &&  (row_ptr[x] >= row_ptr[x-theta_size-1])
+            &&  (row_ptr[x] >= row_ptr[x-theta_size])
+            &&  (row_ptr[x] >= row_ptr[x-theta_size+1])
+            &&  (row_ptr[x] >= row_ptr[x-1])
+            &&  (row_ptr[x] >= row_ptr[x+1])
+            &&  (row_ptr[x] >= row_ptr[x+theta_size-1])
+            &&  (row_ptr[x] >= row_ptr[x+theta_size])
+            &&  (row_ptr[x] >= row_ptr[x+theta_size+1])) {
 
-        if(lb_clip_line(&lnk_line.line, 0, 0, roi->w, roi->h)) {
-            lnk_line.line.x1 += roi->x;
-            lnk_line.line.y1 += roi->y;
-            lnk_line.line.x2 += roi->x;
-            lnk_line.line.y2 += roi->y;
+                find_lines_list_lnk_data_t lnk_line;
+                memset(&lnk_line, 0, sizeof(find_lines_list_lnk_data_t));
 
-            // Move rho too.
-            lnk_line.rho += fast_roundf((roi->x * cos_table[lnk_line.theta]) + (roi->y * sin_table[lnk_line.theta]));
-            list_push_back(out, &lnk_line);
+                lnk_line.magnitude = row_ptr[x];
+                lnk_line.theta = (x - 1) * hough_divide; // remove offset
+                lnk_line.rho = (y - r_diag_len_div) * hough_divide;
+
+                list_push_back(out, &lnk_line);
+            }
         }
     }
+
+    fb_free(); // acc
+    fb_free(); // next
+    fb_free(); // curr
+    fb_free(); // prev
+
+    find_lines_merge(out, roi, theta_margin, rho_margin);
+
+    return true;
 }
 #endif //IMLIB_ENABLE_FIND_LINES
 
@@ -531,12 +729,32 @@ void imlib_find_line_segments(list_t *out, image_t *ptr, rectangle_t *roi, unsig
 #endif // STM32IPL
 
 #ifdef IMLIB_ENABLE_FIND_CIRCLES
+// STM32IPL: stores the directions and the magnitudes of the gradients collected in a row.
+static void find_circles_store(hough_row_t *row, rectangle_t *roi, int y, uint16_t *theta_acc, uint16_t *magnitude_acc)
+{
+    fast_atan2f_vec(row->y_acc, row->x_acc, row->y_acc, row->n);
+    fast_sqrtf_vec(row->mag, row->mag, row->n);
+
+    for (int i = 0; i < row->n; i++) {
+        int theta = fast_roundf((row->x_acc[i] ? row->y_acc[i] : 1.570796f) * 57.295780f) % 360; // * (180 / PI)
+        if (theta < 0) theta += 360;
+        int index = (roi->w * (y - roi->y)) + (row->x[i] - roi->x);
+
+        theta_acc[index] = theta;
+        magnitude_acc[index] = fast_roundf(row->mag[i]);
+    }
+
+    row->n = 0;
+}
+
 void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
                         uint32_t threshold, unsigned int x_margin, unsigned int y_margin, unsigned int r_margin,
                         unsigned int r_min, unsigned int r_max, unsigned int r_step)
 {
     uint16_t *theta_acc = fb_alloc0(sizeof(uint16_t) * roi->w * roi->h, FB_ALLOC_NO_HINT);
     uint16_t *magnitude_acc = fb_alloc0(sizeof(uint16_t) * roi->w * roi->h, FB_ALLOC_NO_HINT);
+    hough_row_t row; // STM32IPL
+    hough_row_alloc(&row, roi->w); // STM32IPL
 
     switch (ptr->bpp) {
         case IMAGE_BPP_BINARY: {
@@ -591,14 +809,13 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
 
                     row_ptr -= ((ptr->w + UINT32_T_MASK) >> UINT32_T_SHIFT);
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 360;
-                    int magnitude = fast_roundf(fast_sqrtf((x_acc * x_acc) + (y_acc * y_acc)));
-                    int index = (roi->w * (y - roi->y)) + (x - roi->x);
-
-                    theta_acc[index] = theta;
-                    magnitude_acc[index] = magnitude;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = (x_acc * x_acc) + (y_acc * y_acc);
                 }
+
+                find_circles_store(&row, roi, y, theta_acc, magnitude_acc);
             }
             break;
         }
@@ -654,14 +871,13 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
 
                     row_ptr -= ptr->w;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 360;
-                    int magnitude = fast_roundf(fast_sqrtf((x_acc * x_acc) + (y_acc * y_acc)));
-                    int index = (roi->w * (y - roi->y)) + (x - roi->x);
-
-                    theta_acc[index] = theta;
-                    magnitude_acc[index] = magnitude;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = (x_acc * x_acc) + (y_acc * y_acc);
                 }
+
+                find_circles_store(&row, roi, y, theta_acc, magnitude_acc);
             }
             break;
         }
@@ -717,14 +933,13 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
 
                     row_ptr -= ptr->w;
 
-                    int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
-                    if (theta < 0) theta += 360;
-                    int magnitude = fast_roundf(fast_sqrtf((x_acc * x_acc) + (y_acc * y_acc)));
-                    int index = (roi->w * (y - roi->y)) + (x - roi->x);
-
-                    theta_acc[index] = theta;
-                    magnitude_acc[index] = magnitude;
+                    row.x[row.n] = x;
+                    row.x_acc[row.n] = x_acc;
+                    row.y_acc[row.n] = y_acc;
+                    row.mag[row.n++] = (x_acc * x_acc) + (y_acc * y_acc);
                 }
+
+                find_circles_store(&row, roi, y, theta_acc, magnitude_acc);
             }
             break;
         }
@@ -797,15 +1012,13 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
 
 					row_ptr -= ptr->w;
 
-					int theta = fast_roundf((x_acc ? fast_atan2f(y_acc, x_acc) : 1.570796f) * 57.295780f) % 360; // * (180 / PI)		// STM32IPL: f added to the constant.
-					if (theta < 0)
-						theta += 360;
-					int magnitude = fast_roundf(fast_sqrtf((x_acc * x_acc) + (y_acc * y_acc)));
-					int index = (roi->w * (y - roi->y)) + (x - roi->x);
-
-					theta_acc[index] = theta;
-					magnitude_acc[index] = magnitude;
+					row.x[row.n] = x;
+					row.x_acc[row.n] = x_acc;
+					row.y_acc[row.n] = y_acc;
+					row.mag[row.n++] = (x_acc * x_acc) + (y_acc * y_acc);
 				}
+
+				find_circles_store(&row, roi, y, theta_acc, magnitude_acc);
 			}
 			break;
 		}
@@ -814,6 +1027,8 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
         }
     }
 
+    hough_row_free(); // STM32IPL
+
     // Theta Direction (% 180)
     //
     // 0,0         X_MAX
@@ -836,7 +1051,24 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
 
     list_init(out, sizeof(find_circles_list_lnk_data_t));
 
-    for (int r = r_min, rr = r_max; r < rr; r += r_step) { // ignore r = 0/1
+    // STM32IPL: with a deadline (see STM32Ipl_SetDeadline()), a first pass with a 4 times larger step covers the
+    // whole radius range, so that circles of all sizes can be found when the search is stopped; the second pass
+    // skips the radii of the first one.
+    int r_coarse = ctx_deadline_active() ? (int)(r_step * 4) : 0;
+    size_t coarse_size = 0;
+    for (int pass = r_coarse ? 0 : 1; pass < 2; pass++) {
+    if (pass) {
+        coarse_size = list_size(out);
+    }
+    for (int r = r_min, rr = r_max; r < rr; r += pass ? r_step : r_coarse) { // ignore r = 0/1
+        if (pass && r_coarse && (!((r - r_min) % r_coarse))) { // STM32IPL
+            continue;
+        }
+
+        if (ctx_deadline_expired()) { // STM32IPL: stop at the deadline.
+            break;
+        }
+
         int a_size, b_size, hough_divide = 1; // divides a and b accumulators
         int hough_shift = 0;
         int w_size = roi->w - (2 * r);
@@ -927,10 +1159,37 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
         fb_free(); // rcos
         fb_free(); // acc
     }
+    } // STM32IPL
 
     fb_free(); // magnitude_acc
     fb_free(); // theta_acc
 
+    // STM32IPL: sort the circles of the two passes by radius, so that they are merged in the same order as
+    // without a deadline.
+    if (r_coarse) {
+        list_t coarse;
+        list_t fine;
+        list_init(&coarse, sizeof(find_circles_list_lnk_data_t));
+        list_init(&fine, sizeof(find_circles_list_lnk_data_t));
+
+        for (size_t i = 0, l = list_size(out); i < l; i++) {
+            find_circles_list_lnk_data_t lnk_data;
+            list_pop_front(out, &lnk_data);
+            list_push_back((i < coarse_size) ? &coarse : &fine, &lnk_data);
+        }
+
+        while (list_size(&coarse) || list_size(&fine)) {
+            find_circles_list_lnk_data_t c_data, f_data;
+            if (list_size(&coarse)) list_get_front(&coarse, &c_data);
+            if (list_size(&fine)) list_get_front(&fine, &f_data);
+
+            find_circles_list_lnk_data_t lnk_data;
+            list_pop_front((list_size(&coarse) && ((!list_size(&fine)) || (c_data.r < f_data.r))) ? &coarse : &fine,
+                &lnk_data);
+            list_push_back(out, &lnk_data);
+        }
+    }
+
     for (;;) { // Merge overlapping.
         bool merge_occured = false;
 
@@ -971,4 +1230,258 @@ void imlib_find_circles(list_t *out, image_t *ptr, rectangle_t *roi, unsigned in
         }
     }
 }
+
+// STM32IPL: loads row y of the ROI as grayscale values.
+static void find_circles_gray_row(image_t *ptr, rectangle_t *roi, int y, uint8_t *row)
+{
+    switch (ptr->bpp) {
+        case IMAGE_BPP_BINARY: {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+            for (int x = 0; x < roi->w; x++) {
+                row[x] = COLOR_BINARY_TO_GRAYSCALE(IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, roi->x + x));
+            }
+            break;
+        }
+        case IMAGE_BPP_GRAYSCALE: {
+            memcpy(row, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y) + roi->x, roi->w);
+            break;
+        }
+        case IMAGE_BPP_RGB565: {
+            uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y);
+            for (int x = 0; x < roi->w; x++) {
+                row[x] = COLOR_RGB565_TO_GRAYSCALE(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, roi->x + x));
+            }
+            break;
+        }
+        case IMAGE_BPP_RGB888: {
+            rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(ptr, y);
+            for (int x = 0; x < roi->w; x++) {
+                row[x] = COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, roi->x + x));
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// STM32IPL: calls cb(x, y, x_acc, y_acc) for each strided pixel of the ROI (ROI coordinates, borders excluded)
+// whose Sobel magnitude |x_acc| + |y_acc| is at least edge_threshold.
+typedef void (*find_circles_edge_cb_t)(void *arg, int x, int y, int x_acc, int y_acc);
+
+static void find_circles_edges(image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
+                               unsigned int edge_threshold, uint8_t **rows, find_circles_edge_cb_t cb, void *arg)
+{
+    for (int y = 1, yy = roi->h - 1; y < yy; y += y_stride) {
+        uint8_t *r0 = rows[0], *r1 = rows[1], *r2 = rows[2];
+
+        find_circles_gray_row(ptr, roi, roi->y + y - 1, r0);
+        find_circles_gray_row(ptr, roi, roi->y + y, r1);
+        find_circles_gray_row(ptr, roi, roi->y + y + 1, r2);
+
+        for (int x = ((roi->y + y) % x_stride) + 1, xx = roi->w - 1; x < xx; x += x_stride) {
+            int x_acc = (r0[x + 1] + (r1[x + 1] << 1) + r2[x + 1]) - (r0[x - 1] + (r1[x - 1] << 1) + r2[x - 1]);
+            int y_acc = (r2[x - 1] + (r2[x] << 1) + r2[x + 1]) - (r0[x - 1] + (r0[x] << 1) + r0[x + 1]);
+
+            if ((abs(x_acc) + abs(y_acc)) >= (int) edge_threshold) {
+                cb(arg, x, y, x_acc, y_acc);
+            }
+        }
+    }
+}
+
+typedef struct find_circles_vote_arg {
+    uint16_t *acc;
+    int w, h, a_size, hough_shift, r_min, r_max, r_step;
+} find_circles_vote_arg_t;
+
+// STM32IPL: votes along the gradient line of an edge pixel, on both sides, from r_min to r_max.
+static void find_circles_vote(void *arg, int x, int y, int x_acc, int y_acc)
+{
+    find_circles_vote_arg_t *v = (find_circles_vote_arg_t *) arg;
+    float scale = 65536.0f / fast_sqrtf((x_acc * x_acc) + (y_acc * y_acc));
+    int dx = fast_roundf(x_acc * scale), dy = fast_roundf(y_acc * scale); // Q16 unit vector
+
+    for (int s = 0; s < 2; s++, dx = -dx, dy = -dy) { // the gradient may point inside or outside the circle
+        int px = (x << 16) + (v->r_min * dx) + 0x8000, py = (y << 16) + (v->r_min * dy) + 0x8000;
+
+        for (int r = v->r_min; r < v->r_max; r += v->r_step, px += v->r_step * dx, py += v->r_step * dy) {
+            int a = px >> 16, b = py >> 16;
+            if ((a < 0) || (v->w <= a) || (b < 0) || (v->h <= b)) break; // the ray left the window
+            uint16_t *cell = v->acc + (((b >> v->hough_shift) + 1) * v->a_size) + ((a >> v->hough_shift) + 1);
+            if (*cell != UINT16_MAX) (*cell)++;
+        }
+    }
+}
+
+typedef struct find_circles_support_arg {
+    find_circles_list_lnk_data_t *circles;
+    uint16_t *hist;
+    int n, r_min, r_max, tol;
+} find_circles_support_arg_t;
+
+// STM32IPL: adds an edge pixel to the radius histogram of each candidate center its gradient line passes by.
+static void find_circles_support(void *arg, int x, int y, int x_acc, int y_acc)
+{
+    find_circles_support_arg_t *v = (find_circles_support_arg_t *) arg;
+    long long g2 = (x_acc * x_acc) + (y_acc * y_acc);
+
+    for (int i = 0; i < v->n; i++) {
+        int vx = v->circles[i].p.x - x, vy = v->circles[i].p.y - y;
+        if ((abs(vx) >= v->r_max) || (abs(vy) >= v->r_max)) continue;
+        int d2 = (vx * vx) + (vy * vy);
+        if ((d2 < (v->r_min * v->r_min)) || (d2 >= (v->r_max * v->r_max))) continue;
+        long long cross = (x_acc * vy) - (y_acc * vx); // |g| times the distance of the center from the gradient line
+        if ((cross * cross) > (g2 * v->tol * v->tol)) continue;
+        int r = fast_roundf(fast_sqrtf(d2));
+        if (r >= v->r_max) r = v->r_max - 1;
+        v->hist[(i * (v->r_max - v->r_min)) + (r - v->r_min)]++;
+    }
+}
+
+// STM32IPL: 2-1 Hough transform (gradient method). Each edge pixel (Sobel magnitude |gx| + |gy| >= edge_threshold)
+// votes along its gradient line, for distances in [r_min, r_max), into a single 2D center accumulator; the
+// radius of each center peak (votes >= threshold) is then the mode of the distances of the edge pixels whose
+// gradient line passes by it, and the circle magnitude is the number of such pixels. Overlapping circles are not
+// averaged as imlib_find_circles() does: only the best supported one is kept, and the list is sorted by
+// decreasing magnitude. Returns false when the working memory is not enough.
+bool imlib_find_circles_gradient(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride,
+                                 unsigned int y_stride, unsigned int edge_threshold, uint32_t threshold,
+                                 unsigned int x_margin, unsigned int y_margin, unsigned int r_margin,
+                                 unsigned int r_min, unsigned int r_max, unsigned int r_step)
+{
+    int a_size, b_size, hough_divide = 1, hough_shift = 0; // divides the center accumulator
+    uint32_t rows_size = 3 * FB_ALLOC_SPACE(roi->w);
+
+    list_init(out, sizeof(find_circles_list_lnk_data_t));
+
+    if (r_min >= r_max) {
+        return true;
+    }
+
+    for (;;) { // shrink to fit...
+        a_size = 1 + ((roi->w + hough_divide - 1) / hough_divide) + 1; // left & right padding
+        b_size = 1 + ((roi->h + hough_divide - 1) / hough_divide) + 1; // top & bottom padding
+        if ((FB_ALLOC_SPACE(sizeof(uint16_t) * a_size * b_size) + rows_size) <= fb_avail()) break;
+        hough_divide = hough_divide << 1; // powers of 2...
+        hough_shift++;
+        if (hough_divide > 4) return false; // support 1, 2, 4
+    }
+
+    uint8_t *rows[3];
+    for (int i = 0; i < 3; i++) {
+        rows[i] = fb_alloc(roi->w, FB_ALLOC_NO_HINT);
+    }
+
+    uint16_t *acc = fb_alloc0(sizeof(uint16_t) * a_size * b_size, FB_ALLOC_NO_HINT);
+    find_circles_vote_arg_t vote = { acc, roi->w, roi->h, a_size, hough_shift, r_min, r_max, r_step };
+
+    find_circles_edges(ptr, roi, x_stride, y_stride, edge_threshold, rows, find_circles_vote, &vote);
+
+    for (int y = 1, yy = b_size - 1; y < yy; y++) {
+        uint16_t *row_ptr = acc + (a_size * y);
+        for (int x = 1, xx = a_size - 1; x < xx; x++) {
+            uint16_t val = row_ptr[x];
+            if ((val >= threshold)
+            &&  (val >= row_ptr[x-a_size-1])
+            &&  (val >= row_ptr[x-a_size])
+            &&  (val >= row_ptr[x-a_size+1])
+            &&  (val >= row_ptr[x-1])
+            &&  (val >= row_ptr[x+1])
+            &&  (val >= row_ptr[x+a_size-1])
+            &&  (val >= row_ptr[x+a_size])
+            &&  (val >= row_ptr[x+a_size+1])) {
+
+                find_circles_list_lnk_data_t lnk_data;
+                lnk_data.magnitude = val;
+                lnk_data.p.x = ((x - 1) << hough_shift) + (hough_divide >> 1); // remove offset
+                lnk_data.p.y = ((y - 1) << hough_shift) + (hough_divide >> 1); // remove offset
+                lnk_data.r = 0;
+
+                list_push_back(out, &lnk_data);
+                if (val > row_ptr[x+1])
+                   x++; // can skip the next pixel
+            }
+        }
+    }
+
+    fb_free(); // acc
+
+    int n = list_size(out), r_size = r_max - r_min;
+    uint32_t space = FB_ALLOC_SPACE(sizeof(find_circles_list_lnk_data_t) * n) + FB_ALLOC_SPACE(sizeof(uint16_t) * n * r_size);
+
+    if (n && (space > fb_avail())) {
+        list_clear(out);
+        fb_free(); // rows[2]
+        fb_free(); // rows[1]
+        fb_free(); // rows[0]
+        return false;
+    }
+
+    if (n) {
+        find_circles_list_lnk_data_t *circles = fb_alloc(sizeof(find_circles_list_lnk_data_t) * n, FB_ALLOC_NO_HINT);
+        uint16_t *hist = fb_alloc0(sizeof(uint16_t) * n * r_size, FB_ALLOC_NO_HINT);
+        find_circles_support_arg_t support = { circles, hist, n, r_min, r_max, hough_divide + 1 };
+
+        for (int i = 0; i < n; i++) {
+            list_pop_front(out, &circles[i]);
+        }
+
+        find_circles_edges(ptr, roi, x_stride, y_stride, edge_threshold, rows, find_circles_support, &support);
+
+        for (int i = 0; i < n; i++) {
+            uint16_t *h = hist + (i * r_size);
+            int best = 0, best_r = 0;
+
+            for (int r = 0; r < r_size; r++) { // 3-bin window to be robust to rounding
+                int sum = h[r] + ((r > 0) ? h[r - 1] : 0) + ((r < (r_size - 1)) ? h[r + 1] : 0);
+                if (sum > best) {
+                    best = sum;
+                    best_r = r;
+                }
+            }
+
+            circles[i].p.x += roi->x;
+            circles[i].p.y += roi->y;
+            circles[i].r = best_r + r_min;
+            circles[i].magnitude = best;
+        }
+
+        for (;;) { // Keep the best supported circle, drop the overlapping ones.
+            int k = -1;
+
+            for (int i = 0; i < n; i++) {
+                if (circles[i].magnitude && ((k < 0) || (circles[i].magnitude > circles[k].magnitude))) {
+                    k = i;
+                }
+            }
+
+            if (k < 0) {
+                break;
+            }
+
+            list_push_back(out, &circles[k]);
+
+            for (int i = 0; i < n; i++) {
+                if ((abs(circles[i].p.x - circles[k].p.x) < x_margin)
+                &&  (abs(circles[i].p.y - circles[k].p.y) < y_margin)
+                &&  (abs(circles[i].r - circles[k].r) < r_margin)) {
+                    circles[i].magnitude = 0;
+                }
+            }
+
+            circles[k].magnitude = 0;
+        }
+
+        fb_free(); // hist
+        fb_free(); // circles
+    }
+
+    fb_free(); // rows[2]
+    fb_free(); // rows[1]
+    fb_free(); // rows[0]
+
+    return true;
+}
 #endif //IMLIB_ENABLE_FIND_CIRCLES
@@ -16,6 +16,9 @@
 // STM32IPL #include "ff_wrapper.h"
 #include "imlib.h"
 #include "common.h"
+#ifdef IPL_CONVERT_HAS_MVE
+#include "mve_convert.h" // STM32IPL
+#endif
 // STM32IPL #include "omv_boardconfig.h"
 
 /////////////////
@@ -244,6 +247,7 @@ void image_init(image_t *ptr, int w, int h, int bpp, void *data)
     ptr->w = w;
     ptr->h = h;
     ptr->bpp = bpp;
+    ptr->stride = 0;
     ptr->data = data;
 }
 
@@ -274,12 +278,51 @@ size_t image_size(image_t *ptr)
 		case IMAGE_BPP_RGB888: { // STM32IPL
 			return IMAGE_RGB888_LINE_LEN_BYTES(ptr) * ptr->h;
 		}
+		case IMAGE_BPP_YUV422: { // STM32IPL
+			return ((ptr->w + 1) / 2) * 4 * ptr->h;
+		}
+		case IMAGE_BPP_NV12: { // STM32IPL
+			return (ptr->w * ptr->h) + (((ptr->w + 1) / 2) * 2 * ((ptr->h + 1) / 2));
+		}
+		case IMAGE_BPP_BAYER_GBRG: // STM32IPL
+		case IMAGE_BPP_BAYER_GRBG:
+		case IMAGE_BPP_BAYER_RGGB: {
+			return ptr->w * ptr->h;
+		}
         default: { // JPEG
             return ptr->bpp;
         }
     }
 }
 
+// STM32IPL: size (bytes) of the pixels of a single line.
+size_t image_line_size(image_t *ptr)
+{
+    return ptr->h ? (image_size(ptr) / ptr->h) : 0;
+}
+
+// STM32IPL: distance (bytes) between the beginning of two consecutive lines.
+size_t image_line_stride(image_t *ptr)
+{
+    return ptr->stride ? (size_t)ptr->stride : image_line_size(ptr);
+}
+
+// STM32IPL: copies the pixels of src into dst (same size and format); any of them can be a view.
+void image_copy_data(image_t *dst, image_t *src)
+{
+    if (!src->stride && !dst->stride) {
+        memcpy(dst->data, src->data, image_size(src));
+    } else {
+        size_t line_size = image_line_size(src);
+        size_t src_stride = image_line_stride(src);
+        size_t dst_stride = image_line_stride(dst);
+
+        for (int y = 0; y < src->h; y++) {
+            memcpy(dst->data + (y * dst_stride), src->data + (y * src_stride), line_size);
+        }
+    }
+}
+
 bool image_get_mask_pixel(image_t *ptr, int x, int y)
 {
     if ((0 <= x) && (x < ptr->w) && (0 <= y) && (y < ptr->h)) {
@@ -305,6 +348,103 @@ bool image_get_mask_pixel(image_t *ptr, int x, int y)
     return false;
 }
 
+// STM32IPL: packed masks.
+// The canonical mask representation is the binary image row layout: one bit per pixel, where bit (x % 32) of word
+// (x / 32) is set when pixel x is selected. Masks of any format are read a word at a time, so that masked loops pay
+// one format switch every 32 pixels and can skip or take whole words of pixels at once.
+
+// Returns the packed mask word holding pixels x to x + 31 of row y (x must be a multiple of 32). The pixels outside
+// of the mask are not selected.
+uint32_t image_get_mask_word(image_t *ptr, int x, int y)
+{
+    uint32_t word = 0;
+
+    if ((0 <= x) && (x < ptr->w) && (0 <= y) && (y < ptr->h)) {
+        int n = IM_MIN(ptr->w - x, (int) UINT32_T_BITS);
+
+        switch (ptr->bpp) {
+            case IMAGE_BPP_BINARY: {
+                word = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y)[x >> UINT32_T_SHIFT];
+                if (n < UINT32_T_BITS) {
+                    word &= (1U << n) - 1;
+                }
+                break;
+            }
+            case IMAGE_BPP_GRAYSCALE: {
+                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y) + x;
+                for (int i = 0; i < n; i++) {
+                    word |= ((uint32_t) COLOR_GRAYSCALE_TO_BINARY(row_ptr[i])) << i;
+                }
+                break;
+            }
+            case IMAGE_BPP_RGB565: {
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y) + x;
+                for (int i = 0; i < n; i++) {
+                    word |= ((uint32_t) COLOR_RGB565_TO_BINARY(row_ptr[i])) << i;
+                }
+                break;
+            }
+            case IMAGE_BPP_RGB888: {
+                rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(ptr, y) + x;
+                for (int i = 0; i < n; i++) {
+                    word |= ((uint32_t) COLOR_RGB888_TO_BINARY(row_ptr[i])) << i;
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    return word;
+}
+
+// Finds the next run of selected pixels of row y, starting the search from *x and stopping at w: *x is moved to the
+// start of the run and its length is returned (0 when there are no more runs). Words with no pixel selected are
+// skipped and words with all the pixels selected are taken with a single test. A null mask selects the whole row;
+// invert selects the pixels that are not set in the mask.
+int image_mask_span(image_t *ptr, int *x, int y, int w, bool invert)
+{
+    uint32_t flip = invert ? 0xFFFFFFFFU : 0;
+    int i = *x, j;
+
+    if (!ptr) {
+        return (i < w) ? (w - i) : 0;
+    }
+
+    for (;;) {
+        if (i >= w) {
+            return 0;
+        }
+
+        uint32_t word = (image_get_mask_word(ptr, i & ~UINT32_T_MASK, y) ^ flip) >> (i & UINT32_T_MASK);
+        if (word) {
+            i += __builtin_ctz(word);
+            break;
+        }
+
+        i = (i | UINT32_T_MASK) + 1;
+    }
+
+    if (i >= w) {
+        return 0;
+    }
+
+    for (j = i; j < w;) {
+        uint32_t word = (~(image_get_mask_word(ptr, j & ~UINT32_T_MASK, y) ^ flip)) >> (j & UINT32_T_MASK);
+        if (word) {
+            j += __builtin_ctz(word);
+            break;
+        }
+
+        j = (j | UINT32_T_MASK) + 1;
+    }
+
+    *x = i;
+    return IM_MIN(j, w) - i;
+}
+
 // Gamma uncompress
 extern const float xyz_table[256];
 
@@ -499,6 +639,88 @@ int8_t imlib_rgb888_to_b(rgb888_t pixel)
 	return fast_floorf(200 * (y - z));
 }
 
+// STM32IPL: LAB companding function of t (Q16), linearly interpolated from lab_f_table (Q15).
+// The weights of the XYZ rows sum to at most 32773 (Q15), so t never exceeds 65546 and the
+// interpolation never reads beyond the last (repeated) entry of the table.
+static inline int32_t imlib_lab_f(uint32_t t)
+{
+    uint32_t i = t >> 6;
+    uint32_t frac = t & 63;
+
+    return lab_f_table[i] + (((lab_f_table[i + 1] - lab_f_table[i]) * frac) >> 6);
+}
+
+// STM32IPL: fixed point LAB conversion of the 8 bit R, G, B values; the result is within one unit of
+// the exact (floating point) sRGB to LAB conversion.
+static inline void imlib_rgb_to_lab_fixed(uint32_t r8, uint32_t g8, uint32_t b8, int8_t *l, int8_t *a, int8_t *b)
+{
+    uint32_t r_lin = xyz_lin_table[r8];
+    uint32_t g_lin = xyz_lin_table[g8];
+    uint32_t b_lin = xyz_lin_table[b8];
+
+    int32_t x = imlib_lab_f(((r_lin * IMLIB_LAB_W_XR) + (g_lin * IMLIB_LAB_W_XG) + (b_lin * IMLIB_LAB_W_XB)) >> 14);
+    int32_t y = imlib_lab_f(((r_lin * IMLIB_LAB_W_YR) + (g_lin * IMLIB_LAB_W_YG) + (b_lin * IMLIB_LAB_W_YB)) >> 14);
+    int32_t z = imlib_lab_f(((r_lin * IMLIB_LAB_W_ZR) + (g_lin * IMLIB_LAB_W_ZG) + (b_lin * IMLIB_LAB_W_ZB)) >> 14);
+
+    *l = ((116 * y) >> 15) - 16;
+    *a = (500 * (x - y)) >> 15;
+    *b = (200 * (y - z)) >> 15;
+}
+
+// STM32IPL
+// Converts a row of RGB565 pixels to L, A, B rows. With IMLIB_ENABLE_LAB_LUT, the values are the ones of
+// COLOR_RGB565_TO_L/A/B, read from the LAB table; otherwise they are computed in fixed point.
+void imlib_rgb565_to_lab_row(const uint16_t *src, int n, int8_t *l, int8_t *a, int8_t *b)
+{
+#if defined(IMLIB_ENABLE_LAB_LUT)
+    for (int i = 0; i < n; i++) {
+        const int8_t *lab = lab_table + ((src[i] >> 1) * 3);
+        l[i] = lab[0];
+        a[i] = lab[1];
+        b[i] = lab[2];
+    }
+#elif defined(IPL_CONVERT_HAS_MVE)
+    mve_convert_rgb565_to_lab(src, n, l, a, b);
+#else
+    for (int i = 0; i < n; i++) {
+        uint16_t pixel = src[i];
+        imlib_rgb_to_lab_fixed(COLOR_RGB565_TO_R8(pixel), COLOR_RGB565_TO_G8(pixel), COLOR_RGB565_TO_B8(pixel),
+                               l + i, a + i, b + i);
+    }
+#endif
+}
+
+// STM32IPL
+// Converts a row of RGB888 pixels to L, A, B rows, computed in fixed point.
+void imlib_rgb888_to_lab_row(const rgb888_t *src, int n, int8_t *l, int8_t *a, int8_t *b)
+{
+#ifdef IPL_CONVERT_HAS_MVE
+    mve_convert_rgb888_to_lab((const uint8_t *)src, n, l, a, b);
+#else
+    for (int i = 0; i < n; i++) {
+        imlib_rgb_to_lab_fixed(src[i].r, src[i].g, src[i].b, l + i, a + i, b + i);
+    }
+#endif
+}
+
+// STM32IPL
+// Converts n pixels of row y of a RGB565 or RGB888 image, starting from x, to L, A, B rows. When tmp is
+// not NULL, the RGB888 pixels are reduced to RGB565 in tmp (n pixels) before the conversion.
+void imlib_image_to_lab_row(image_t *img, int x, int y, int n, uint16_t *tmp, int8_t *l, int8_t *a, int8_t *b)
+{
+    if (img->bpp == IMAGE_BPP_RGB565) {
+        imlib_rgb565_to_lab_row(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y) + x, n, l, a, b);
+    } else if (tmp) {
+        rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y) + x;
+        for (int i = 0; i < n; i++) {
+            tmp[i] = COLOR_R8_G8_B8_TO_RGB565(row_ptr[i].r, row_ptr[i].g, row_ptr[i].b);
+        }
+        imlib_rgb565_to_lab_row(tmp, n, l, a, b);
+    } else {
+        imlib_rgb888_to_lab_row(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y) + x, n, l, a, b);
+    }
+}
+
 // STM32IPL
 rgb888_t imlib_lab_to_rgb888(uint8_t l, int8_t a, int8_t b)
 {
@@ -1184,35 +1406,14 @@ void imlib_image_operation(image_t *img, const char *path, image_t *other, int s
         if (!IM_EQUAL(img, other)) {
         	// STM32IPL mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Images not equal!"));
         }
-        switch (img->bpp) {
-            case IMAGE_BPP_BINARY: {
-                for (int i=0, ii=img->h; i<ii; i++) {
-                    op(img, i, IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(other, i), data, false);
-                }
-                break;
-            }
-            case IMAGE_BPP_GRAYSCALE: {
-                for (int i=0, ii=img->h; i<ii; i++) {
-                    op(img, i, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(other, i), data, false);
-                }
-                break;
-            }
-            case IMAGE_BPP_RGB565: {
-                for (int i=0, ii=img->h; i<ii; i++) {
-                    op(img, i, IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(other, i), data, false);
-                }
-                break;
-            }
-			case IMAGE_BPP_RGB888: { // STM32IPL
-				for (int i = 0, ii = img->h; i < ii; i++) {
-					op(img, i, IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(other, i), data, false);
-				}
-				break;
-			}
-            default: {
-                break;
-            }
+        // STM32IPL: the lines of the other image are read through the row prefetcher, that copies the next line
+        // to the internal memory while the current one is processed (when STM32IPL_ENABLE_ROW_PREFETCH is defined).
+        ipl_prefetch_t pf;
+        ipl_prefetch_init(&pf, other->data, image_line_stride(other), image_line_size(other), 0);
+        for (int i=0, ii=img->h; i<ii; i++) {
+            op(img, i, (void *) ipl_prefetch_line(&pf, i, ((i + 1) < ii) ? (i + 1) : -1), data, false);
         }
+        ipl_prefetch_deinit(&pf);
     } else {
         switch(img->bpp) {
             case IMAGE_BPP_BINARY: {
@@ -1358,8 +1559,8 @@ void imlib_zero(image_t *img, image_t *mask, bool invert)
         case IMAGE_BPP_BINARY: {
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (image_get_mask_pixel(mask, x, y) ^ invert) {
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, invert)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
                         IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, 0);
                     }
                 }
@@ -1369,8 +1570,8 @@ void imlib_zero(image_t *img, image_t *mask, bool invert)
         case IMAGE_BPP_GRAYSCALE: {
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (image_get_mask_pixel(mask, x, y) ^ invert) {
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, invert)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
                         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, 0);
                     }
                 }
@@ -1380,8 +1581,8 @@ void imlib_zero(image_t *img, image_t *mask, bool invert)
         case IMAGE_BPP_RGB565: {
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    if (image_get_mask_pixel(mask, x, y) ^ invert) {
+                for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, invert)); sx += sn) { // STM32IPL
+                    for (int x = sx, xx = sx + sn; x < xx; x++) {
                         IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, 0);
                     }
                 }
@@ -1396,8 +1597,8 @@ void imlib_zero(image_t *img, image_t *mask, bool invert)
 
 			for (int y = 0, yy = img->h; y < yy; y++) {
 				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-				for (int x = 0, xx = img->w; x < xx; x++) {
-					if (image_get_mask_pixel(mask, x, y) ^ invert) {
+				for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, y, img->w, invert)); sx += sn) { // STM32IPL
+					for (int x = sx, xx = sx + sn; x < xx; x++) {
 						IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x, pixel);
 					}
 				}
@@ -1676,8 +1877,11 @@ int imlib_image_mean(image_t *src, int *r_mean, int *g_mean, int *b_mean)
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
-            for (int i=0; i<n; i++) {
-                r_s += src->pixels[i];
+            for (int y=0; y<src->h; y++) { // STM32IPL: row-wise, so that views are supported.
+                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y);
+                for (int x=0; x<src->w; x++) {
+                    r_s += row_ptr[x];
+                }
             }
             *r_mean = r_s/n;
             *g_mean = r_s/n;
@@ -1685,11 +1889,14 @@ int imlib_image_mean(image_t *src, int *r_mean, int *g_mean, int *b_mean)
             break;
         }
         case IMAGE_BPP_RGB565: {
-            for (int i=0; i<n; i++) {
-                uint16_t p = ((uint16_t*)src->pixels)[i];
-                r_s += COLOR_RGB565_TO_R8(p);
-                g_s += COLOR_RGB565_TO_G8(p);
-                b_s += COLOR_RGB565_TO_B8(p);
+            for (int y=0; y<src->h; y++) { // STM32IPL: row-wise, so that views are supported.
+                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, y);
+                for (int x=0; x<src->w; x++) {
+                    uint16_t p = row_ptr[x];
+                    r_s += COLOR_RGB565_TO_R8(p);
+                    g_s += COLOR_RGB565_TO_G8(p);
+                    b_s += COLOR_RGB565_TO_B8(p);
+                }
             }
             *r_mean = r_s/n;
             *g_mean = g_s/n;
@@ -1698,11 +1905,14 @@ int imlib_image_mean(image_t *src, int *r_mean, int *g_mean, int *b_mean)
         }
 
         case IMAGE_BPP_RGB888: { // STM32IPL
-			for (int i = 0; i < n; i++) {
-				rgb888_t p = ((rgb888_t*)src->pixels)[i];
-				r_s += p.r;
-				g_s += p.g;
-				b_s += p.b;
+			for (int y = 0; y < src->h; y++) {
+				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, y);
+				for (int x = 0; x < src->w; x++) {
+					rgb888_t p = row_ptr[x];
+					r_s += p.r;
+					g_s += p.g;
+					b_s += p.b;
+				}
 			}
 			*r_mean = r_s / n;
 			*g_mean = g_s / n;
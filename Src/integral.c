@@ -15,6 +15,9 @@
 #ifndef STM32IPL
 #include "fb_alloc.h"
 #endif // STM32IPL
+#ifdef IPL_INTEGRAL_HAS_MVE // STM32IPL
+#include "mve_integral.h"
+#endif // IPL_INTEGRAL_HAS_MVE
 
 void imlib_integral_image_alloc(i_image_t *sum, int w, int h)
 {
@@ -39,6 +42,11 @@ void imlib_integral_image(image_t *src, i_image_t *sum)
     uint32_t *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifdef IPL_INTEGRAL_HAS_MVE // STM32IPL
+    for (int y=0; y<src->h; y++) {
+        mve_integral_row(img_data+y*src->w, 1<<16, y ? sum_data+(y-1)*src->w : NULL, sum_data+y*src->w, src->w);
+    }
+#else
     // Compute first column to avoid branching
     for (int s=0, x=0; x<src->w; x++) {
         /* sum of the current row (integer) */
@@ -54,6 +62,7 @@ void imlib_integral_image(image_t *src, i_image_t *sum)
             sum_data[y*src->w+x] = s+sum_data[(y-1)*src->w+x];
         }
     }
+#endif // IPL_INTEGRAL_HAS_MVE
 }
 
 void imlib_integral_image_scaled(image_t *src, i_image_t *sum)
@@ -69,6 +78,12 @@ void imlib_integral_image_scaled(image_t *src, i_image_t *sum)
     int x_ratio = (int)((src->w<<16)/sum->w) +1;
     int y_ratio = (int)((src->h<<16)/sum->h) +1;
 
+#ifdef IPL_INTEGRAL_HAS_MVE // STM32IPL
+    for (int y=0; y<sum->h; y++) {
+        int sy = (y*y_ratio)>>16;
+        mve_integral_row(img_data+sy*src->w, x_ratio, y ? sum_data+(y-1)*sum->w : NULL, sum_data+y*sum->w, sum->w);
+    }
+#else
     // Compute first column to avoid branching
     for (int s=0, x=0; x<sum->w; x++) {
         int sx = (x*x_ratio)>>16;
@@ -88,6 +103,7 @@ void imlib_integral_image_scaled(image_t *src, i_image_t *sum)
             sum_data[y*sum->w+x] = s+sum_data[(y-1)*sum->w+x];
         }
     }
+#endif // IPL_INTEGRAL_HAS_MVE
 }
 
 void imlib_integral_image_sq(image_t *src, i_image_t *sum)
@@ -100,6 +116,11 @@ void imlib_integral_image_sq(image_t *src, i_image_t *sum)
     uint32_t *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifdef IPL_INTEGRAL_HAS_MVE // STM32IPL
+    for (int y=0; y<src->h; y++) {
+        mve_integral_row_sq(img_data+y*src->w, 1<<16, y ? sum_data+(y-1)*src->w : NULL, sum_data+y*src->w, src->w);
+    }
+#else
     // Compute first column to avoid branching
     for (uint32_t s=0, x=0; x<src->w; x++) {
         /* sum of the current row (integer) */
@@ -115,7 +136,70 @@ void imlib_integral_image_sq(image_t *src, i_image_t *sum)
             sum_data[y*src->w+x] = s+sum_data[(y-1)*src->w+x];
         }
     }
+#endif // IPL_INTEGRAL_HAS_MVE
+}
+
+// STM32IPL
+// Computes the integral image and the squared integral image in a single read of the source image.
+void imlib_integral_image_ss(image_t *src, i_image_t *sum, i_image_t *ssq)
+{
+    uint8_t *img_data = src->data;
+    uint32_t *sum_data = sum->data;
+    uint32_t *ssq_data = ssq->data;
+
+    for (int y=0; y<src->h; y++) {
+        uint8_t *row = img_data+y*src->w;
+        uint32_t *sum_row = sum_data+y*src->w;
+        uint32_t *ssq_row = ssq_data+y*src->w;
+        uint32_t *sum_above = y ? sum_row-src->w : NULL;
+        uint32_t *ssq_above = y ? ssq_row-src->w : NULL;
+
+#ifdef IPL_INTEGRAL_HAS_MVE
+        mve_integral_row_ss(row, 1<<16, sum_above, ssq_above, sum_row, ssq_row, src->w);
+#else
+        for (uint32_t s=0, sq=0, x=0; x<src->w; x++) {
+            s += row[x];
+            sq += row[x] * row[x];
+            sum_row[x] = sum_above ? s+sum_above[x] : s;
+            ssq_row[x] = ssq_above ? sq+ssq_above[x] : sq;
+        }
+#endif // IPL_INTEGRAL_HAS_MVE
+    }
+}
+
+// STM32IPL
+// Same as imlib_integral_image_ss(), with a 64-bit squared integral image: its values do not wrap around even for
+// large images (the squared sum of a 1920x1080 image needs 42 bits). The sum of the squared pixels of a row fits
+// 32 bits, only the accumulation of the rows is done on 64 bits. The (32-bit) integral image stays exact as long
+// as the image has less than 16.8M pixels.
+void imlib_integral_image_ss64(image_t *src, i_image_t *sum, i64_image_t *ssq)
+{
+    uint8_t *img_data = src->data;
+    uint32_t *sum_data = sum->data;
+    uint64_t *ssq_data = ssq->data;
+
+    for (int y=0; y<src->h; y++) {
+        uint8_t *row = img_data+y*src->w;
+        uint32_t *sum_row = sum_data+y*src->w;
+        uint64_t *ssq_row = ssq_data+y*src->w;
+        uint32_t *sum_above = y ? sum_row-src->w : NULL;
+        uint64_t *ssq_above = y ? ssq_row-src->w : NULL;
 
+#ifdef IPL_INTEGRAL_HAS_MVE
+        mve_integral_row(row, 1<<16, sum_above, sum_row, src->w);
+        for (uint32_t sq=0, x=0; x<src->w; x++) {
+            sq += row[x] * row[x];
+            ssq_row[x] = ssq_above ? sq+ssq_above[x] : sq;
+        }
+#else
+        for (uint32_t s=0, sq=0, x=0; x<src->w; x++) {
+            s += row[x];
+            sq += row[x] * row[x];
+            sum_row[x] = sum_above ? s+sum_above[x] : s;
+            ssq_row[x] = ssq_above ? sq+ssq_above[x] : sq;
+        }
+#endif // IPL_INTEGRAL_HAS_MVE
+    }
 }
 
 uint32_t imlib_integral_lookup(i_image_t *sum, int x, int y, int w, int h)
@@ -133,3 +217,20 @@ uint32_t imlib_integral_lookup(i_image_t *sum, int x, int y, int w, int h)
     }
 #undef  PIXEL_AT
 }
+
+// STM32IPL
+uint64_t imlib_integral_lookup64(i64_image_t *sum, int x, int y, int w, int h)
+{
+#define PIXEL_AT(x,y)\
+    (sum->data[((y)-1)*sum->w+((x)-1)])
+    if (x==0 && y==0) {
+        return PIXEL_AT(w,h);
+    } else if (y==0) {
+        return PIXEL_AT(w+x, h) - PIXEL_AT(x, h);
+    } else if (x==0) {
+        return PIXEL_AT(w, h+y) - PIXEL_AT(w, y);
+    } else {
+        return PIXEL_AT(w+x, h+y) + PIXEL_AT(x, y) - PIXEL_AT(w+x, y) - PIXEL_AT(x, h+y);
+    }
+#undef  PIXEL_AT
+}
@@ -54,6 +54,13 @@
 #ifndef STM32IPL
 #include "fb_alloc.h"
 #endif // STM32IPL
+#ifdef STM32IPL
+#include "stm32ipl_kernels.h"
+
+// Pointer to the row y of an image of any format.
+#define IM_ROW_PTR(img, y) \
+    (((uint8_t *) (img)->data) + (image_line_stride(img) * (y)))
+#endif // STM32IPL
 
 #ifndef STM32IPL
 // This macro swaps two pointers.
@@ -118,6 +125,7 @@ void imlib_integral_mw(image_t *src, mw_image_t *sum)
     uint32_t* *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the first row to avoid branching
     for (int sx, s=0, x=0; x<sum->w; x++) {
         // X offset
@@ -143,6 +151,16 @@ void imlib_integral_mw(image_t *src, mw_image_t *sum)
             sum_data[y][x] = s + sum_data[y-1][x];
         }
     }
+#else
+    ipl_kernel_integral_t integral = ipl_kernel_integral(src->bpp, false);
+
+    for (int y=0; y<sum->h; y++) {
+        // Y offset
+        int sy = (y*sum->y_ratio)>>16;
+
+        integral(IM_ROW_PTR(src, sy), 0, sum->x_ratio, y ? sum_data[y-1] : NULL, sum_data[y], sum->w);
+    }
+#endif // STM32IPL
 
     sum->y_offs = sum->h;
 }
@@ -156,6 +174,7 @@ void imlib_integral_mw_sq(image_t *src, mw_image_t *sum)
     uint32_t* *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the first row to avoid branching
     for (int sx, s=0, x=0; x<sum->w; x++) {
         // X offset
@@ -181,6 +200,16 @@ void imlib_integral_mw_sq(image_t *src, mw_image_t *sum)
             sum_data[y][x] = s + sum_data[y-1][x];
         }
     }
+#else
+    ipl_kernel_integral_t integral = ipl_kernel_integral(src->bpp, true);
+
+    for (int y=0; y<sum->h; y++) {
+        // Y offset
+        int sy = (y*sum->y_ratio)>>16;
+
+        integral(IM_ROW_PTR(src, sy), 0, sum->x_ratio, y ? sum_data[y-1] : NULL, sum_data[y], sum->w);
+    }
+#endif // STM32IPL
 
     sum->y_offs = sum->h;
 }
@@ -206,6 +235,7 @@ void imlib_integral_mw_shift(image_t *src, mw_image_t *sum, int n)
     uint32_t* *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the last n lines
     for (int sy, y=(sum->h - n); y<sum->h; y++, sum->y_offs++) {
         // Y offset
@@ -221,6 +251,17 @@ void imlib_integral_mw_shift(image_t *src, mw_image_t *sum, int n)
             sum_data[y][x] = s + sum_data[y-1][x];
         }
     }
+#else
+    ipl_kernel_integral_t integral = ipl_kernel_integral(src->bpp, false);
+
+    // Compute the last n lines
+    for (int y=(sum->h - n); y<sum->h; y++, sum->y_offs++) {
+        // Y offset
+        int sy = (sum->y_offs*sum->y_ratio)>>16;
+
+        integral(IM_ROW_PTR(src, sy), 0, sum->x_ratio, sum_data[y-1], sum_data[y], sum->w);
+    }
+#endif // STM32IPL
 }
 
 void imlib_integral_mw_shift_sq(image_t *src, mw_image_t *sum, int n)
@@ -244,6 +285,7 @@ void imlib_integral_mw_shift_sq(image_t *src, mw_image_t *sum, int n)
     uint32_t* *sum_data = sum->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the last n lines
     for (int sy, y=(sum->h - n); y<sum->h; y++, sum->y_offs++) {
         // The y offset is set to the last line + 1
@@ -259,6 +301,17 @@ void imlib_integral_mw_shift_sq(image_t *src, mw_image_t *sum, int n)
             sum_data[y][x] = (s + sum_data[y-1][x]);
         }
     }
+#else
+    ipl_kernel_integral_t integral = ipl_kernel_integral(src->bpp, true);
+
+    // Compute the last n lines
+    for (int y=(sum->h - n); y<sum->h; y++, sum->y_offs++) {
+        // Y offset
+        int sy = (sum->y_offs*sum->y_ratio)>>16;
+
+        integral(IM_ROW_PTR(src, sy), 0, sum->x_ratio, sum_data[y-1], sum_data[y], sum->w);
+    }
+#endif // STM32IPL
 }
 
 void imlib_integral_mw_ss(image_t *src, mw_image_t *sum, mw_image_t *ssq, rectangle_t *roi)
@@ -272,6 +325,7 @@ void imlib_integral_mw_ss(image_t *src, mw_image_t *sum, mw_image_t *ssq, rectan
     uint32_t* *ssq_data = ssq->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the first row to avoid branching
     for (int sx, s=0, sq=0, x=0; x<sum->w; x++) {
         // X offset
@@ -303,6 +357,17 @@ void imlib_integral_mw_ss(image_t *src, mw_image_t *sum, mw_image_t *ssq, rectan
             ssq_data[y][x] = sq + ssq_data[y-1][x];
         }
     }
+#else
+    ipl_kernel_integral_ss_t integral = ipl_kernel_integral_ss(src->bpp);
+
+    for (int y=0; y<sum->h; y++) {
+        // Y offset
+        int sy = roi->y+((y*sum->y_ratio)>>16);
+
+        integral(IM_ROW_PTR(src, sy), roi->x, sum->x_ratio, y ? sum_data[y-1] : NULL, y ? ssq_data[y-1] : NULL,
+                 sum_data[y], ssq_data[y], sum->w);
+    }
+#endif // STM32IPL
 
     sum->y_offs = sum->h;
     ssq->y_offs = sum->h;
@@ -334,6 +399,7 @@ void imlib_integral_mw_shift_ss(image_t *src, mw_image_t *sum, mw_image_t *ssq,
     uint32_t* *ssq_data = ssq->data;
 #endif // STM32IPL
 
+#ifndef STM32IPL
     // Compute the last n lines
     for (int sy, y=(sum->h - n); y<sum->h; y++, sum->y_offs++, ssq->y_offs++) {
         // The y offset is set to the last line + 1
@@ -352,6 +418,18 @@ void imlib_integral_mw_shift_ss(image_t *src, mw_image_t *sum, mw_image_t *ssq,
             ssq_data[y][x] = sq + ssq_data[y-1][x];
         }
     }
+#else
+    ipl_kernel_integral_ss_t integral = ipl_kernel_integral_ss(src->bpp);
+
+    // Compute the last n lines
+    for (int y=(sum->h - n); y<sum->h; y++, sum->y_offs++, ssq->y_offs++) {
+        // Y offset
+        int sy = roi->y+((sum->y_offs*sum->y_ratio)>>16);
+
+        integral(IM_ROW_PTR(src, sy), roi->x, sum->x_ratio, sum_data[y-1], ssq_data[y-1], sum_data[y], ssq_data[y],
+                 sum->w);
+    }
+#endif // STM32IPL
 }
 
 long imlib_integral_mw_lookup(mw_image_t *sum, int x, int y, int w, int h)
@@ -33,36 +33,36 @@
  */
 size_t read_file(JFILE *file, uint8_t *buf, uint32_t sizeofbuf)
 {
-#ifdef STM32IPL_ENABLE_JPEG
-	static size_t BytesReadfile;
+#if defined(STM32IPL_ENABLE_IMAGE_IO) && defined(STM32IPL_ENABLE_JPEG)
+	uint32_t BytesReadfile = 0;
 
-	f_read(file, buf , sizeofbuf, &BytesReadfile);
+	ipl_stream_read(file, buf, sizeofbuf, &BytesReadfile);
 
 	return BytesReadfile;
-#else /* STM32IPL_ENABLE_JPEG */
+#else /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 	/* Prevent unused argument(s) compilation warning. */
 	(void)(file);
 	(void)(buf);
 	(void)(sizeofbuf);
 
  	return 0;
-#endif /* STM32IPL_ENABLE_JPEG */
+#endif /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 }
 
 size_t write_file(JFILE *file, uint8_t *buf, uint32_t sizeofbuf)
 {
-#ifdef STM32IPL_ENABLE_JPEG
-	static size_t BytesWritefile;
+#if defined(STM32IPL_ENABLE_IMAGE_IO) && defined(STM32IPL_ENABLE_JPEG)
+	uint32_t BytesWritefile = 0;
 
-	f_write(file, buf , sizeofbuf, &BytesWritefile);
+	ipl_stream_write(file, buf, sizeofbuf, &BytesWritefile);
 
 	return BytesWritefile;
-#else /* STM32IPL_ENABLE_JPEG */
+#else /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 	/* Prevent unused argument(s) compilation warning. */
 	(void)(file);
 	(void)(buf);
 	(void)(sizeofbuf);
 
 	return 0;
-#endif /* STM32IPL_ENABLE_JPEG */
+#endif /* STM32IPL_ENABLE_IMAGE_IO && STM32IPL_ENABLE_JPEG */
 }
@@ -16,6 +16,9 @@
   */
 
 #include <stdint.h>
+#include "imlib_config.h"
+
+#ifdef IMLIB_ENABLE_LAB_LUT
 const int8_t lab_table[98304] = {
     0,    0,   -1,     0,    3,   -9,     1,    8,  -21,     2,   16,  -31,
     4,   27,  -41,     6,   35,  -48,     8,   41,  -55,    11,   45,  -61,
@@ -8210,3 +8213,4 @@ const int8_t lab_table[98304] = {
    98,  -15,   56,    98,  -14,   49,    98,  -12,   41,    98,  -10,   33,
    99,   -8,   25,    99,   -6,   18,    99,   -3,   10,   100,    0,    2
 };
+#endif /* IMLIB_ENABLE_LAB_LUT */
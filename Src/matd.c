@@ -2294,3 +2294,163 @@ float matd_max(matd_t *m)
 	return d;
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////// "matf.c" // STM32IPL
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void matf_identity(matf_t *m)
+{
+	int n = m->numRows * m->numCols;
+
+	for (int i = 0; i < n; i++)
+		m->pData[i] = 0;
+
+	for (int i = 0; i < m->numRows && i < m->numCols; i++)
+		MATF_EL(m, i, i) = 1;
+}
+
+arm_status matf_multiply(const matf_t *a, const matf_t *b, matf_t *c)
+{
+	if ((a->numCols != b->numRows) || (c->numRows != a->numRows) || (c->numCols != b->numCols))
+		return ARM_MATH_SIZE_MISMATCH;
+
+	// CMSIS-DSP does not allow the destination to overlap a source.
+	if ((c->pData == a->pData) || (c->pData == b->pData)) {
+		float t_data[MATF_MAX_DIM * MATF_MAX_DIM];
+		matf_t t;
+		arm_status status;
+
+		if ((c->numRows * c->numCols) > (MATF_MAX_DIM * MATF_MAX_DIM))
+			return ARM_MATH_ARGUMENT_ERROR;
+
+		matf_init(&t, c->numRows, c->numCols, t_data);
+
+		status = arm_mat_mult_f32(a, b, &t);
+		memcpy(c->pData, t_data, c->numRows * c->numCols * sizeof(float));
+
+		return status;
+	}
+
+	return arm_mat_mult_f32(a, b, c);
+}
+
+arm_status matf_transpose(const matf_t *a, matf_t *c)
+{
+	if ((c->numRows != a->numCols) || (c->numCols != a->numRows))
+		return ARM_MATH_SIZE_MISMATCH;
+
+	if (c->pData == a->pData) {
+		float t_data[MATF_MAX_DIM * MATF_MAX_DIM];
+		matf_t t;
+		arm_status status;
+
+		if ((c->numRows * c->numCols) > (MATF_MAX_DIM * MATF_MAX_DIM))
+			return ARM_MATH_ARGUMENT_ERROR;
+
+		matf_init(&t, c->numRows, c->numCols, t_data);
+
+		status = arm_mat_trans_f32(a, &t);
+		memcpy(c->pData, t_data, c->numRows * c->numCols * sizeof(float));
+
+		return status;
+	}
+
+	return arm_mat_trans_f32(a, c);
+}
+
+arm_status matf_inverse(const matf_t *a, matf_t *c)
+{
+	float t_data[MATF_MAX_DIM * MATF_MAX_DIM];
+	matf_t t;
+
+	if ((a->numRows != a->numCols) || (c->numRows != a->numRows) || (c->numCols != a->numCols))
+		return ARM_MATH_SIZE_MISMATCH;
+
+	if (a->numRows > MATF_MAX_DIM)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	// arm_mat_inverse_f32() destroys its source, so it works on a copy.
+	matf_init(&t, a->numRows, a->numCols, t_data);
+	memcpy(t_data, a->pData, a->numRows * a->numCols * sizeof(float));
+
+	return arm_mat_inverse_f32(&t, c);
+}
+
+arm_status matf_chol(const matf_t *a, matf_t *l)
+{
+	float t_data[MATF_MAX_DIM * MATF_MAX_DIM];
+	matf_t t;
+	arm_status status;
+	int n = a->numRows;
+
+	if ((a->numRows != a->numCols) || (l->numRows != a->numRows) || (l->numCols != a->numCols))
+		return ARM_MATH_SIZE_MISMATCH;
+
+	if (n > MATF_MAX_DIM)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	// Only the lower triangle is written: the rest of the factor is zeroed here.
+	matf_init(&t, n, n, t_data);
+	memset(t_data, 0, n * n * sizeof(float));
+
+	status = arm_mat_cholesky_f32(a, &t);
+	memcpy(l->pData, t_data, n * n * sizeof(float));
+
+	return status;
+}
+
+void matf_chol_solve(const matf_t *l, const float *b, float *x)
+{
+	int n = l->numRows;
+
+	// Forward substitution, l * y = b.
+	for (int i = 0; i < n; i++) {
+		float acc = b[i];
+
+		for (int j = 0; j < i; j++)
+			acc -= MATF_EL(l, i, j) * x[j];
+
+		x[i] = acc / MATF_EL(l, i, i);
+	}
+
+	// Back substitution, l' * x = y.
+	for (int i = n - 1; i >= 0; i--) {
+		float acc = x[i];
+
+		for (int j = i + 1; j < n; j++)
+			acc -= MATF_EL(l, j, i) * x[j];
+
+		x[i] = acc / MATF_EL(l, i, i);
+	}
+}
+
+arm_status matf_solve(const matf_t *a, const float *b, float *x)
+{
+	float inv_data[MATF_MAX_DIM * MATF_MAX_DIM];
+	float y[MATF_MAX_DIM];
+	matf_t inv;
+	arm_status status;
+	int n = a->numRows;
+
+	if (n > MATF_MAX_DIM)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	matf_init(&inv, n, n, inv_data);
+	status = matf_inverse(a, &inv);
+	if (status != ARM_MATH_SUCCESS)
+		return status;
+
+	for (int i = 0; i < n; i++) {
+		float acc = 0;
+
+		for (int j = 0; j < n; j++)
+			acc += MATF_EL(&inv, i, j) * b[j];
+
+		y[i] = acc;
+	}
+
+	memcpy(x, y, n * sizeof(float));
+
+	return ARM_MATH_SUCCESS;
+}
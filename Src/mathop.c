@@ -9,6 +9,7 @@
  * Image math operations.
  */
 #include "imlib.h"
+#include "stm32ipl_kernels.h" // STM32IPL
 
 #ifdef IMLIB_ENABLE_MATH_OPS
 #ifdef IPL_MATOP_HAS_MVE
@@ -216,6 +217,7 @@ void imlib_negate(image_t *img)
 typedef struct imlib_replace_line_op_state {
     bool hmirror, vflip, transpose;
     image_t *mask;
+    ipl_kernel_copy_t copy; // STM32IPL: row copy kernel, resolved once per call (NULL if rows need the generic loops).
 } imlib_replace_line_op_state_t;
 
 static void imlib_replace_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
@@ -224,6 +226,13 @@ static void imlib_replace_line_op(image_t *img, int line, void *other, void *dat
     bool vflip = ((imlib_replace_line_op_state_t *) data)->vflip;
     bool transpose = ((imlib_replace_line_op_state_t *) data)->transpose;
     image_t *mask = ((imlib_replace_line_op_state_t *) data)->mask;
+    ipl_kernel_copy_t copy = ((imlib_replace_line_op_state_t *) data)->copy; // STM32IPL
+
+    if (copy) { // STM32IPL
+        int v_line = vflip ? (img->h - line - 1) : line;
+        copy(other, ((uint8_t *) img->data) + (image_line_stride(img) * v_line), img->w, mask, v_line);
+        return;
+    }
 
     image_t target;
     memcpy(&target, img, sizeof(image_t));
@@ -307,6 +316,7 @@ void imlib_replace(image_t *img, const char *path, image_t *other, int scalar, b
     state.vflip = vflip;
     state.mask = mask;
     state.transpose = transpose;
+    state.copy = (!hmirror && !transpose) ? ipl_kernel_copy(img->bpp, mask != NULL) : NULL; // STM32IPL
     imlib_image_operation(img, path, other, scalar, imlib_replace_line_op, &state);
 
     if (in_place) {
@@ -328,8 +338,8 @@ static void imlib_add_line_op(image_t *img, int line, void *other, void *data, b
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = dataPixel | otherPixel; //dataPixel + otherPixel;
@@ -340,9 +350,12 @@ static void imlib_add_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_grayscale(img, line, other, mask, MVE_MATOP_ADD);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = dataPixel + otherPixel;
@@ -350,12 +363,16 @@ static void imlib_add_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_rgb565(img, line, other, mask, MVE_MATOP_ADD);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int r = COLOR_RGB565_TO_R5(dataPixel) + COLOR_RGB565_TO_R5(otherPixel);
@@ -367,12 +384,16 @@ static void imlib_add_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_arith_line_op_rgb888(img, line, other, mask, MVE_MATOP_ADD);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel;
@@ -385,6 +406,7 @@ static void imlib_add_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -412,8 +434,8 @@ static void imlib_sub_line_op(image_t *img, int line, void *other, void *data, b
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = reverse ? (otherPixel - dataPixel) : (dataPixel - otherPixel);
@@ -424,9 +446,12 @@ static void imlib_sub_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_grayscale(img, line, other, mask, reverse ? MVE_MATOP_RSUB : MVE_MATOP_SUB);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = reverse ? (otherPixel - dataPixel) : (dataPixel - otherPixel);
@@ -434,12 +459,16 @@ static void imlib_sub_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_rgb565(img, line, other, mask, reverse ? MVE_MATOP_RSUB : MVE_MATOP_SUB);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int dR = COLOR_RGB565_TO_R5(dataPixel);
@@ -457,12 +486,16 @@ static void imlib_sub_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_arith_line_op_rgb888(img, line, other, mask, reverse ? MVE_MATOP_RSUB : MVE_MATOP_SUB);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel;
@@ -481,6 +514,7 @@ static void imlib_sub_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -513,8 +547,8 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
             float pScale = COLOR_BINARY_MAX - COLOR_BINARY_MIN;
             float pDiv = 1 / pScale;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = (int)(invert ? (pScale - ((pScale - dataPixel) * (pScale - otherPixel) * pDiv))
@@ -525,11 +559,14 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_mul_line_op_grayscale(img, line, other, mask, invert);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
             float pScale = COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN;
             float pDiv = 1 / pScale;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = (int)(invert ? (pScale - ((pScale - dataPixel) * (pScale - otherPixel) * pDiv))
@@ -537,9 +574,13 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_mul_line_op_rgb565(img, line, other, mask, invert);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
             float rScale = COLOR_R5_MAX - COLOR_R5_MIN;
             float gScale = COLOR_G6_MAX - COLOR_G6_MIN;
@@ -547,8 +588,8 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
             float rDiv = 1 / rScale;
             float gDiv = 1 / gScale;
             float bDiv = 1 / bScale;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int dR = COLOR_RGB565_TO_R5(dataPixel);
@@ -566,9 +607,13 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_mul_line_op_rgb888(img, line, other, mask, invert);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
 			float rScale = COLOR_R8_MAX - COLOR_R8_MIN;
 			float gScale = COLOR_G8_MAX - COLOR_G8_MIN;
@@ -576,8 +621,8 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
 			float rDiv = 1 / rScale;
 			float gDiv = 1 / gScale;
 			float bDiv = 1 / bScale;
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel888;
@@ -593,6 +638,7 @@ static void imlib_mul_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -625,8 +671,8 @@ static void imlib_div_line_op(image_t *img, int line, void *other, void *data, b
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
             int pScale = COLOR_BINARY_MAX - COLOR_BINARY_MIN;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = mod
@@ -639,10 +685,13 @@ static void imlib_div_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_div_line_op_grayscale(img, line, other, mask, invert, mod);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
             int pScale = COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = mod
@@ -652,15 +701,19 @@ static void imlib_div_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_div_line_op_rgb565(img, line, other, mask, invert, mod);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
             int rScale = COLOR_R5_MAX - COLOR_R5_MIN;
             int gScale = COLOR_G6_MAX - COLOR_G6_MIN;
             int bScale = COLOR_B5_MAX - COLOR_B5_MIN;
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int dR = COLOR_RGB565_TO_R5(dataPixel);
@@ -684,15 +737,19 @@ static void imlib_div_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_div_line_op_rgb888(img, line, other, mask, invert, mod);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
 			int rScale = COLOR_R8_MAX - COLOR_R8_MIN;
 			int gScale = COLOR_G8_MAX - COLOR_G8_MIN;
 			int bScale = COLOR_B8_MAX - COLOR_B8_MIN;
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel888;
@@ -717,6 +774,7 @@ static void imlib_div_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB565_PIXEL_FAST(data, i, pixel888);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -742,8 +800,8 @@ static void imlib_min_line_op(image_t *img, int line, void *other, void *data, b
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = IM_MIN(dataPixel, otherPixel);
@@ -753,21 +811,28 @@ static void imlib_min_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_grayscale(img, line, other, mask, MVE_MATOP_MIN);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = IM_MIN(dataPixel, otherPixel);
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_rgb565(img, line, other, mask, MVE_MATOP_MIN);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int r = IM_MIN(COLOR_RGB565_TO_R5(dataPixel), COLOR_RGB565_TO_R5(otherPixel));
@@ -776,12 +841,16 @@ static void imlib_min_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_arith_line_op_rgb888(img, line, other, mask, MVE_MATOP_MIN);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel888;
@@ -791,6 +860,7 @@ static void imlib_min_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -812,8 +882,8 @@ static void imlib_max_line_op(image_t *img, int line, void *other, void *data, b
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = IM_MAX(dataPixel, otherPixel);
@@ -823,21 +893,28 @@ static void imlib_max_line_op(image_t *img, int line, void *other, void *data, b
             break;
         }
         case IMAGE_BPP_GRAYSCALE: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_grayscale(img, line, other, mask, MVE_MATOP_MAX);
+#else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = IM_MAX(dataPixel, otherPixel);
                     IMAGE_PUT_GRAYSCALE_PIXEL_FAST(data, i, p);
                 }
             }
+#endif
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_rgb565(img, line, other, mask, MVE_MATOP_MAX);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int r = IM_MAX(COLOR_RGB565_TO_R5(dataPixel), COLOR_RGB565_TO_R5(otherPixel));
@@ -846,12 +923,16 @@ static void imlib_max_line_op(image_t *img, int line, void *other, void *data, b
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
+#ifdef IPL_MATOP_HAS_MVE
+			mve_imlib_arith_line_op_rgb888(img, line, other, mask, MVE_MATOP_MAX);
+#else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel888;
@@ -861,6 +942,7 @@ static void imlib_max_line_op(image_t *img, int line, void *other, void *data, b
 					IMAGE_PUT_RGB888_PIXEL_FAST(data, i, pixel888);
 				}
 			}
+#endif
 			break;
 		}
 
@@ -882,8 +964,8 @@ static void imlib_difference_line_op(image_t *img, int line, void *other, void *
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = dataPixel ^ otherPixel; // abs(dataPixel - otherPixel);
@@ -894,11 +976,11 @@ static void imlib_difference_line_op(image_t *img, int line, void *other, void *
         }
         case IMAGE_BPP_GRAYSCALE: {
 #ifdef IPL_MATOP_HAS_MVE
-            mve_imlib_difference_line_op_grayscale(img, line, other, mask);
+            mve_imlib_arith_line_op_grayscale(img, line, other, mask, MVE_MATOP_DIFF);
 #else
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = abs(dataPixel - otherPixel);
@@ -909,9 +991,12 @@ static void imlib_difference_line_op(image_t *img, int line, void *other, void *
             break;
         }
         case IMAGE_BPP_RGB565: {
+#ifdef IPL_MATOP_HAS_MVE
+            mve_imlib_arith_line_op_rgb565(img, line, other, mask, MVE_MATOP_DIFF);
+#else
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int r = abs(COLOR_RGB565_TO_R5(dataPixel) - COLOR_RGB565_TO_R5(otherPixel));
@@ -920,15 +1005,16 @@ static void imlib_difference_line_op(image_t *img, int line, void *other, void *
                     IMAGE_PUT_RGB565_PIXEL_FAST(data, i, COLOR_R5_G6_B5_TO_RGB565(r, g, b));
                 }
             }
+#endif
             break;
         }
 		case IMAGE_BPP_RGB888: {  // STM32IPL
 #ifdef IPL_MATOP_HAS_MVE
-            mve_imlib_difference_line_op_rgb888(img, line, other, mask);
+            mve_imlib_arith_line_op_rgb888(img, line, other, mask, MVE_MATOP_DIFF);
 #else
 			rgb888_t *data = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, line);
-			for (int i = 0, j = img->w; i < j; i++) {
-				if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+			for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+				for (int i = sx, j = sx + sn; i < j; i++) {
 					rgb888_t dataPixel = IMAGE_GET_RGB888_PIXEL_FAST(data, i);
 					rgb888_t otherPixel = IMAGE_GET_RGB888_PIXEL_FAST(((rgb888_t* ) other), i);
 					rgb888_t pixel888;
@@ -967,8 +1053,8 @@ static void imlib_blend_line_op(image_t *img, int line, void *other, void *data,
     switch(img->bpp) {
         case IMAGE_BPP_BINARY: {
             uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_BINARY_PIXEL_FAST(((uint32_t *) other), i);
                     int p = (int)((dataPixel * alpha) + (otherPixel * beta)); // STM32IPL: added cast.
@@ -979,8 +1065,8 @@ static void imlib_blend_line_op(image_t *img, int line, void *other, void *data,
         }
         case IMAGE_BPP_GRAYSCALE: {
             uint8_t *data = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(((uint8_t *) other), i);
                     int p = (int)((dataPixel * alpha) + (otherPixel * beta)); // STM32IPL: added cast.
@@ -991,8 +1077,8 @@ static void imlib_blend_line_op(image_t *img, int line, void *other, void *data,
         }
         case IMAGE_BPP_RGB565: {
             uint16_t *data = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
-            for (int i = 0, j = img->w; i < j; i++) {
-                if ((!mask) || image_get_mask_pixel(mask, i, line)) {
+            for (int sx = 0, sn; (sn = image_mask_span(mask, &sx, line, img->w, false)); sx += sn) { // STM32IPL
+                for (int i = sx, j = sx + sn; i < j; i++) {
                     int dataPixel = IMAGE_GET_RGB565_PIXEL_FAST(data, i);
                     int otherPixel = IMAGE_GET_RGB565_PIXEL_FAST(((uint16_t *) other), i);
                     int r = (int)((COLOR_RGB565_TO_R5(dataPixel) * alpha) + (COLOR_RGB565_TO_R5(otherPixel) * beta)); // STM32IPL: added cast.
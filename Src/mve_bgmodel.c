@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ * @file    mve_bgmodel.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library background model functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_BGMODEL_HAS_MVE
+#include "mve_bgmodel.h"
+
+/* The background of each group of 16 pixels is stored as the 8 even pixels followed by the 8 odd ones, with 7
+ * fractional bits: the even and odd halves match the bottom and top halves of the widened 8-bit vector, and they
+ * are narrowed back to the 8-bit background with a single bottom/top pair. */
+#define MVE_BGMODEL_FRAC 7
+
+/* Moves the background towards the frame, on the lanes of the predicate. */
+static inline int16x8_t mve_bgmodel_update(int16x8_t bg, int16x8_t pix, int method, int rate, int16_t step,
+                                           mve_pred16_t p)
+{
+  int16x8_t diff = vsubq_s16(pix, bg);
+
+  if (method == 0) {
+    /* Running average: bg += diff / 2^rate, rounded. */
+    diff = vrshlq_n_s16(diff, -rate);
+  } else {
+    /* Approximate median: bg moves by step at most. */
+    diff = vmaxq_s16(vminq_s16(diff, vdupq_n_s16(step)), vdupq_n_s16(-step));
+  }
+
+  return vaddq_m_s16(bg, bg, diff, p);
+}
+
+/*
+ * Processes n pixels (from a multiple of 16) of a row: the foreground bits (|pixel - background| > threshold) are
+ * written to fg, 16 per half-word, and the background is updated when update is true; with selective the
+ * foreground pixels do not update it. method is 0 for the running average, 1 for the approximate median.
+ */
+void mve_bgmodel_span(const uint8_t *src, int16_t *model, uint16_t *fg, int n, int method, int rate, int threshold,
+                      bool update, bool selective)
+{
+  int16_t step = (1 << MVE_BGMODEL_FRAC) >> rate;
+
+  for (int x = 0; x < n; x += 16, model += 16) {
+    mve_pred16_t p = vctp8q(n - x);
+    uint8x16_t u8x16_pix = vldrbq_z_u8(src + x, p);
+    int16x8_t s16x8_even = vldrhq_s16(model);
+    int16x8_t s16x8_odd = vldrhq_s16(model + 8);
+
+    /* Background of the 16 pixels, back in their order. */
+    uint8x16_t u8x16_bg = vshrnbq_n_u16(vuninitializedq_u8(), vreinterpretq_u16_s16(s16x8_even), MVE_BGMODEL_FRAC);
+    u8x16_bg = vshrntq_n_u16(u8x16_bg, vreinterpretq_u16_s16(s16x8_odd), MVE_BGMODEL_FRAC);
+
+    mve_pred16_t p_fg = vcmphiq_n_u8(vabdq_u8(u8x16_pix, u8x16_bg), threshold) & p;
+    *fg++ = p_fg;
+
+    if (update) {
+      mve_pred16_t p_upd = selective ? (p & ~p_fg) : p;
+      /* Byte lane predicate of the even and odd pixels, spread over the half-word lanes. */
+      mve_pred16_t p_even = (p_upd & 0x5555) * 3;
+      mve_pred16_t p_odd = ((p_upd >> 1) & 0x5555) * 3;
+      int16x8_t s16x8_pix_even = vreinterpretq_s16_u16(vshlq_n_u16(vmovlbq_u8(u8x16_pix), MVE_BGMODEL_FRAC));
+      int16x8_t s16x8_pix_odd = vreinterpretq_s16_u16(vshlq_n_u16(vmovltq_u8(u8x16_pix), MVE_BGMODEL_FRAC));
+
+      vstrhq_s16(model, mve_bgmodel_update(s16x8_even, s16x8_pix_even, method, rate, step, p_even));
+      vstrhq_s16(model + 8, mve_bgmodel_update(s16x8_odd, s16x8_pix_odd, method, rate, step, p_odd));
+    }
+  }
+}
+
+/* Adds the sum of each group of 16 pixels of a row of n pixels to the corresponding entry of sums. */
+void mve_bgmodel_block_sums(const uint8_t *src, int n, uint32_t *sums)
+{
+  for (int x = 0; x < n; x += 16) {
+    mve_pred16_t p = vctp8q(n - x);
+    *sums = vaddvaq_p_u8(*sums, vldrbq_z_u8(src + x, p), p);
+    sums++;
+  }
+}
+
+#endif /* IPL_BGMODEL_HAS_MVE */
@@ -30,6 +30,8 @@ static inline uint16x8_t _mve_color_r8_g8_b8_to_rgb565(uint16x8_t u16x8_r8, uint
           vshrq_n_u16(u16x8_b8, 3));
 }
 
+/* The LAB conversion of RGB pixels reads the LAB table. */
+#ifdef IMLIB_ENABLE_LAB_LUT
 static inline void _mve_color_rgb565_to_lab(uint16x8_t u16x8_pixel_b, uint16x8_t u16x8_pixel_t, uint8x16_t *l, int8x16_t *a, int8x16_t *b) {
   uint16x8_t l_16x8, u16x8_pixel;
   int16x8_t a_16x8, b_16x8;
@@ -89,6 +91,7 @@ static inline mve_pred16_t __mve_color_threshold_lab16( uint16x8_t l, int16x8_t
           vcmpgeq_n_s16(a, (threshold)->AMin) & vcmpleq_n_s16(a, (threshold)->AMax) &
           vcmpgeq_n_s16(b, (threshold)->BMin) & vcmpleq_n_s16(b, (threshold)->BMax));
 }
+#endif /* IMLIB_ENABLE_LAB_LUT */
 
 static inline void _mve_rgb888_u8x16_to_2_u16x8(uint8x16_t u8x16_r, uint8x16_t u8x16_g, uint8x16_t u8x16_b, uint16x8_t *u16x8_data_b, uint16x8_t *u16x8_data_t) {
   uint16x8_t u16x8_r, u16x8_g, u16x8_b;
@@ -281,6 +284,7 @@ void mve_imlib_binary_grayscale(image_t *out,
   }
 }
 
+#ifdef IMLIB_ENABLE_LAB_LUT
 /* RGB888 to binary */
 /***********************/
 static inline void mve_imlib_binary_rgb888_out_binary_fast(image_t *out,
@@ -734,6 +738,7 @@ void mve_imlib_binary_rgb565(image_t *out,
     }
   }
 }
+#endif /* IMLIB_ENABLE_LAB_LUT */
 int mve_imlib_erode_dilate_grayscale(image_t *img,
                                      int ksize,
                                      int threshold,
@@ -745,8 +750,9 @@ int mve_imlib_erode_dilate_grayscale(image_t *img,
   buf.w = img->w;
   buf.h = brows;
   buf.bpp = img->bpp;
+  buf.stride = 0;
   mve_pred16_t p_r = vctp16q(2 * ksize + 1);
-  buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+  buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
   if (!buf.data) {
     return -1;
   }
@@ -766,10 +772,11 @@ int mve_imlib_erode_dilate_grayscale(image_t *img,
     int acc = 0;
     uint8_t *k_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, IM_MAX(y - ksize, 0));
     uint16x8_t u16x8_read;
+    uint32_t mask_word = 0;
     for (int x = 0; x < img->w; x++) {
       IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
 
-      if (mask && (!image_get_mask_pixel(mask, x, y))) {
+      if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
         continue;
       }
 
@@ -822,4 +829,82 @@ int mve_imlib_erode_dilate_grayscale(image_t *img,
   fb_free();
   return 1;
 }
+
+/* out[i] = in[i] AND (OR) the word i of the line in shifted by shift pixels towards its first pixel, for the words
+ * 0 ... words - 1, 4 words at a time (out can be in); in must have (shift / 32) + 1 more readable words. */
+void mve_imlib_binary_shift_op(uint32_t *in, int words, int shift, int e_or_d, uint32_t *out)
+{
+  int q = shift / 32;
+  int r = shift % 32;
+  int32x4_t s32x4_right = vdupq_n_s32(-r);
+  int32x4_t s32x4_left = vdupq_n_s32(32 - r);
+
+  for (int i = 0; i < words; i += 4) {
+    mve_pred16_t p = vctp32q(words - i);
+    uint32x4_t u32x4_word = vldrwq_z_u32(in + i, p);
+    uint32x4_t u32x4_shifted = vshlq_u32(vldrwq_z_u32(in + i + q, p), s32x4_right);
+
+    if (r) {
+      u32x4_shifted = vorrq_u32(u32x4_shifted, vshlq_u32(vldrwq_z_u32(in + i + q + 1, p), s32x4_left));
+    }
+
+    u32x4_word = e_or_d ? vorrq_u32(u32x4_word, u32x4_shifted) : vandq_u32(u32x4_word, u32x4_shifted);
+    vstrwq_p_u32(out + i, u32x4_word, p);
+  }
+}
+
+/* Van Herk/Gil-Werman AND (OR) of the windows of n rows of a strip of len + n - 1 rows of 4 words (one vector per
+ * row); the result of the window starting at row i is stored to row i. g and h receive the running results from
+ * the start and from the end of each block of n rows. */
+void mve_imlib_binary_vhgw_strip(uint32_t *strip, int len, int n, int e_or_d, uint32_t *g, uint32_t *h)
+{
+  int padded = len + n - 1;
+
+  for (int i = 0; i < padded; i += n) {
+    int end = IM_MIN(i + n, padded);
+    uint32x4_t u32x4_acc = vldrwq_u32(strip + (i * 4));
+
+    vstrwq_u32(g + (i * 4), u32x4_acc);
+    for (int j = i + 1; j < end; j++) {
+      uint32x4_t u32x4_row = vldrwq_u32(strip + (j * 4));
+      u32x4_acc = e_or_d ? vorrq_u32(u32x4_acc, u32x4_row) : vandq_u32(u32x4_acc, u32x4_row);
+      vstrwq_u32(g + (j * 4), u32x4_acc);
+    }
+
+    u32x4_acc = vldrwq_u32(strip + ((end - 1) * 4));
+    vstrwq_u32(h + ((end - 1) * 4), u32x4_acc);
+    for (int j = end - 2; j >= i; j--) {
+      uint32x4_t u32x4_row = vldrwq_u32(strip + (j * 4));
+      u32x4_acc = e_or_d ? vorrq_u32(u32x4_acc, u32x4_row) : vandq_u32(u32x4_acc, u32x4_row);
+      vstrwq_u32(h + (j * 4), u32x4_acc);
+    }
+  }
+
+  for (int i = 0; i < len; i++) {
+    uint32x4_t u32x4_h = vldrwq_u32(h + (i * 4));
+    uint32x4_t u32x4_g = vldrwq_u32(g + ((i + n - 1) * 4));
+    vstrwq_u32(strip + (i * 4), e_or_d ? vorrq_u32(u32x4_h, u32x4_g) : vandq_u32(u32x4_h, u32x4_g));
+  }
+}
+
+#define MVE_B_OP_LOOP(expr) \
+  for (size_t i = 0; i < n; i += 16) { \
+    mve_pred16_t p = vctp8q(n - i); \
+    uint8x16_t a = vldrbq_z_u8(data + i, p); \
+    uint8x16_t b = vldrbq_z_u8(other + i, p); \
+    vstrbq_p_u8(data + i, (expr), p); \
+  }
+
+/* data[i] = data[i] op other[i] for n bytes, 16 bytes at a time. */
+void mve_imlib_b_op(uint8_t *data, const uint8_t *other, size_t n, imlib_b_op_t op)
+{
+  switch (op) {
+    case IMLIB_B_AND: MVE_B_OP_LOOP(vandq_u8(a, b)) break;
+    case IMLIB_B_NAND: MVE_B_OP_LOOP(vbicq_u8(a, b)) break;
+    case IMLIB_B_OR: MVE_B_OP_LOOP(vorrq_u8(a, b)) break;
+    case IMLIB_B_NOR: MVE_B_OP_LOOP(vornq_u8(a, b)) break;
+    case IMLIB_B_XOR: MVE_B_OP_LOOP(veorq_u8(a, b)) break;
+    default: MVE_B_OP_LOOP(veorq_u8(a, vmvnq_u8(b))) break;
+  }
+}
 #endif /* IPL_BINARY_HAS_MVE */
@@ -0,0 +1,240 @@
+/**
+ ******************************************************************************
+ * @file    mve_convert.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library color conversion functions with MVE
+ *          intrinsics
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_CONVERT_HAS_MVE
+#include "mve_convert.h"
+
+/* Gets the index of the first pixel of the i-th group of 8 pixels and the predicate of its valid pixels;
+ * in reverse mode, the groups are taken from the last one. */
+static inline int32_t _convert_group(uint32_t n, uint32_t i, bool reverse, mve_pred16_t *p)
+{
+    int32_t end = reverse ? (int32_t)(n - i) : (int32_t)n;
+    int32_t pos = reverse ? IM_MAX(end - 8, 0) : (int32_t)i;
+
+    *p = vctp16q(end - pos);
+
+    return pos;
+}
+
+/* RGB565 channels expanded to 8 bits, as COLOR_RGB565_TO_R8/G8/B8 */
+#define _RGB565_TO_R8(v, r) \
+    r = vandq_u16(vshrq_n_u16(v, 8), vdupq_n_u16(0xF8)); \
+    r = vorrq_u16(r, vshrq_n_u16(r, 5));
+
+#define _RGB565_TO_G8(v, g) \
+    g = vandq_u16(vshrq_n_u16(v, 3), vdupq_n_u16(0xFC)); \
+    g = vorrq_u16(g, vshrq_n_u16(g, 6));
+
+#define _RGB565_TO_B8(v, b) \
+    b = vandq_u16(vshlq_n_u16(v, 3), vdupq_n_u16(0xF8)); \
+    b = vorrq_u16(b, vshrq_n_u16(b, 5));
+
+/* Luminance, as COLOR_RGB888_TO_Y */
+#define _RGB888_TO_Y(r, g, b) \
+    vshrq_n_u16(vaddq_u16(vaddq_u16(vmulq_n_u16(r, 38), vmulq_n_u16(g, 75)), vmulq_n_u16(b, 15)), 7)
+
+/* RGB565 pixel, as COLOR_R8_G8_B8_TO_RGB565 */
+#define _R8_G8_B8_TO_RGB565(r, g, b) \
+    vorrq_u16(vorrq_u16(vshlq_n_u16(vandq_u16(r, vdupq_n_u16(0xF8)), 8), \
+                        vshlq_n_u16(vandq_u16(g, vdupq_n_u16(0xFC)), 3)), \
+              vshrq_n_u16(b, 3))
+
+/* RGB565 channels expanded to 8 bits, as COLOR_RGB565_TO_R8/G8/B8, in 32-bit lanes */
+#define _RGB565_TO_R8_U32(v, r) \
+    r = vandq_u32(vshrq_n_u32(v, 8), vdupq_n_u32(0xF8)); \
+    r = vorrq_u32(r, vshrq_n_u32(r, 5));
+
+#define _RGB565_TO_G8_U32(v, g) \
+    g = vandq_u32(vshrq_n_u32(v, 3), vdupq_n_u32(0xFC)); \
+    g = vorrq_u32(g, vshrq_n_u32(g, 6));
+
+#define _RGB565_TO_B8_U32(v, b) \
+    b = vandq_u32(vshlq_n_u32(v, 3), vdupq_n_u32(0xF8)); \
+    b = vorrq_u32(b, vshrq_n_u32(b, 5));
+
+/* LAB companding function of t (Q16), linearly interpolated from lab_f_table (Q15), as imlib_lab_f() */
+static inline int32x4_t _lab_f(uint32x4_t t, mve_pred16_t p)
+{
+    uint32x4_t u32x4_i = vshrq_n_u32(t, 6);
+    uint32x4_t u32x4_frac = vandq_u32(t, vdupq_n_u32(63));
+    uint32x4_t u32x4_f0 = vldrhq_gather_shifted_offset_z_u32(lab_f_table, u32x4_i, p);
+    uint32x4_t u32x4_f1 = vldrhq_gather_shifted_offset_z_u32(lab_f_table, vaddq_n_u32(u32x4_i, 1), p);
+
+    return vreinterpretq_s32_u32(vaddq_u32(u32x4_f0, vshrq_n_u32(vmulq_u32(vsubq_u32(u32x4_f1, u32x4_f0), u32x4_frac), 6)));
+}
+
+/* Fixed point LAB conversion of 4 pixels, as imlib_rgb_to_lab_fixed() */
+static inline void _rgb_to_lab(uint32x4_t r8, uint32x4_t g8, uint32x4_t b8, int8_t *l, int8_t *a, int8_t *b,
+                               mve_pred16_t p)
+{
+    uint32x4_t u32x4_r = vldrhq_gather_shifted_offset_z_u32(xyz_lin_table, r8, p);
+    uint32x4_t u32x4_g = vldrhq_gather_shifted_offset_z_u32(xyz_lin_table, g8, p);
+    uint32x4_t u32x4_b = vldrhq_gather_shifted_offset_z_u32(xyz_lin_table, b8, p);
+    uint32x4_t u32x4_t;
+    int32x4_t s32x4_x, s32x4_y, s32x4_z;
+
+    u32x4_t = vmlaq_n_u32(vmlaq_n_u32(vmulq_n_u32(u32x4_r, IMLIB_LAB_W_XR), u32x4_g, IMLIB_LAB_W_XG), u32x4_b, IMLIB_LAB_W_XB);
+    s32x4_x = _lab_f(vshrq_n_u32(u32x4_t, 14), p);
+    u32x4_t = vmlaq_n_u32(vmlaq_n_u32(vmulq_n_u32(u32x4_r, IMLIB_LAB_W_YR), u32x4_g, IMLIB_LAB_W_YG), u32x4_b, IMLIB_LAB_W_YB);
+    s32x4_y = _lab_f(vshrq_n_u32(u32x4_t, 14), p);
+    u32x4_t = vmlaq_n_u32(vmlaq_n_u32(vmulq_n_u32(u32x4_r, IMLIB_LAB_W_ZR), u32x4_g, IMLIB_LAB_W_ZG), u32x4_b, IMLIB_LAB_W_ZB);
+    s32x4_z = _lab_f(vshrq_n_u32(u32x4_t, 14), p);
+
+    vstrbq_p_s32(l, vsubq_n_s32(vshrq_n_s32(vmulq_n_s32(s32x4_y, 116), 15), 16), p);
+    vstrbq_p_s32(a, vshrq_n_s32(vmulq_n_s32(vsubq_s32(s32x4_x, s32x4_y), 500), 15), p);
+    vstrbq_p_s32(b, vshrq_n_s32(vmulq_n_s32(vsubq_s32(s32x4_y, s32x4_z), 200), 15), p);
+}
+
+void mve_convert_y8_to_rgb565(const uint8_t *src, uint16_t *dst, uint32_t n, bool reverse)
+{
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        uint16x8_t u16x8_y = vldrbq_z_u16(src + pos, p);
+
+        vstrhq_p_u16(dst + pos, _R8_G8_B8_TO_RGB565(u16x8_y, u16x8_y, u16x8_y), p);
+    }
+}
+
+void mve_convert_y8_to_rgb888(const uint8_t *src, uint8_t *dst, uint32_t n, bool reverse)
+{
+    uint16x8_t u16x8_offsets = vmulq_n_u16(vidupq_n_u16(0, 1), 3);
+
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        uint16x8_t u16x8_y = vldrbq_z_u16(src + pos, p);
+        uint8_t *out = dst + (pos * 3);
+
+        vstrbq_scatter_offset_p_u16(out, u16x8_offsets, u16x8_y, p);
+        vstrbq_scatter_offset_p_u16(out + 1, u16x8_offsets, u16x8_y, p);
+        vstrbq_scatter_offset_p_u16(out + 2, u16x8_offsets, u16x8_y, p);
+    }
+}
+
+void mve_convert_rgb565_to_y8(const uint16_t *src, uint8_t *dst, uint32_t n, bool reverse)
+{
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        uint16x8_t u16x8_pixel = vldrhq_z_u16(src + pos, p);
+        uint16x8_t u16x8_r, u16x8_g, u16x8_b;
+
+        _RGB565_TO_R8(u16x8_pixel, u16x8_r)
+        _RGB565_TO_G8(u16x8_pixel, u16x8_g)
+        _RGB565_TO_B8(u16x8_pixel, u16x8_b)
+
+        vstrbq_p_u16(dst + pos, _RGB888_TO_Y(u16x8_r, u16x8_g, u16x8_b), p);
+    }
+}
+
+void mve_convert_rgb565_to_rgb888(const uint16_t *src, uint8_t *dst, uint32_t n, bool reverse)
+{
+    uint16x8_t u16x8_offsets = vmulq_n_u16(vidupq_n_u16(0, 1), 3);
+
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        uint16x8_t u16x8_pixel = vldrhq_z_u16(src + pos, p);
+        uint16x8_t u16x8_r, u16x8_g, u16x8_b;
+        uint8_t *out = dst + (pos * 3);
+
+        _RGB565_TO_R8(u16x8_pixel, u16x8_r)
+        _RGB565_TO_G8(u16x8_pixel, u16x8_g)
+        _RGB565_TO_B8(u16x8_pixel, u16x8_b)
+
+        /* rgb888_t layout: b, g, r */
+        vstrbq_scatter_offset_p_u16(out, u16x8_offsets, u16x8_b, p);
+        vstrbq_scatter_offset_p_u16(out + 1, u16x8_offsets, u16x8_g, p);
+        vstrbq_scatter_offset_p_u16(out + 2, u16x8_offsets, u16x8_r, p);
+    }
+}
+
+void mve_convert_rgb888_to_y8(const uint8_t *src, uint8_t *dst, uint32_t n, bool reverse)
+{
+    uint16x8_t u16x8_offsets = vmulq_n_u16(vidupq_n_u16(0, 1), 3);
+
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        const uint8_t *in = src + (pos * 3);
+        uint16x8_t u16x8_b = vldrbq_gather_offset_z_u16(in, u16x8_offsets, p);
+        uint16x8_t u16x8_g = vldrbq_gather_offset_z_u16(in + 1, u16x8_offsets, p);
+        uint16x8_t u16x8_r = vldrbq_gather_offset_z_u16(in + 2, u16x8_offsets, p);
+
+        vstrbq_p_u16(dst + pos, _RGB888_TO_Y(u16x8_r, u16x8_g, u16x8_b), p);
+    }
+}
+
+void mve_convert_rgb888_to_rgb565(const uint8_t *src, uint16_t *dst, uint32_t n, bool reverse)
+{
+    uint16x8_t u16x8_offsets = vmulq_n_u16(vidupq_n_u16(0, 1), 3);
+
+    for (uint32_t i = 0; i < n; i += 8)
+    {
+        mve_pred16_t p;
+        int32_t pos = _convert_group(n, i, reverse, &p);
+        const uint8_t *in = src + (pos * 3);
+        uint16x8_t u16x8_b = vldrbq_gather_offset_z_u16(in, u16x8_offsets, p);
+        uint16x8_t u16x8_g = vldrbq_gather_offset_z_u16(in + 1, u16x8_offsets, p);
+        uint16x8_t u16x8_r = vldrbq_gather_offset_z_u16(in + 2, u16x8_offsets, p);
+
+        vstrhq_p_u16(dst + pos, _R8_G8_B8_TO_RGB565(u16x8_r, u16x8_g, u16x8_b), p);
+    }
+}
+void mve_convert_rgb565_to_lab(const uint16_t *src, uint32_t n, int8_t *l, int8_t *a, int8_t *b)
+{
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        mve_pred16_t p = vctp32q(n - i);
+        uint32x4_t u32x4_in = vldrhq_z_u32(src + i, p);
+        uint32x4_t u32x4_r, u32x4_g, u32x4_b;
+
+        _RGB565_TO_R8_U32(u32x4_in, u32x4_r)
+        _RGB565_TO_G8_U32(u32x4_in, u32x4_g)
+        _RGB565_TO_B8_U32(u32x4_in, u32x4_b)
+
+        _rgb_to_lab(u32x4_r, u32x4_g, u32x4_b, l + i, a + i, b + i, p);
+    }
+}
+
+void mve_convert_rgb888_to_lab(const uint8_t *src, uint32_t n, int8_t *l, int8_t *a, int8_t *b)
+{
+    uint32x4_t u32x4_offsets = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        mve_pred16_t p = vctp32q(n - i);
+        const uint8_t *in = src + (i * 3);
+        uint32x4_t u32x4_b = vldrbq_gather_offset_z_u32(in, u32x4_offsets, p);
+        uint32x4_t u32x4_g = vldrbq_gather_offset_z_u32(in + 1, u32x4_offsets, p);
+        uint32x4_t u32x4_r = vldrbq_gather_offset_z_u32(in + 2, u32x4_offsets, p);
+
+        _rgb_to_lab(u32x4_r, u32x4_g, u32x4_b, l + i, a + i, b + i, p);
+    }
+}
+#endif /* IPL_CONVERT_HAS_MVE */
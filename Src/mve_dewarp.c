@@ -0,0 +1,549 @@
+/**
+ ******************************************************************************
+ * @file    mve_dewarp.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library dewarping functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_DEWARP_HAS_MVE
+#include "mve_dewarp.h"
+
+/* The dense maps are processed four destination pixels at a time, one per 32-bit lane: the source coordinates are
+ * gathered from the (y, x) pairs of the map, the source pixels are gathered at the resulting offsets, and the
+ * destination pixels are stored contiguously. The border handling matches the scalar code: the bilinear neighbors
+ * are clamped to the last row and column of the source image; in addition, the source coordinates are clamped to
+ * the image (the scalar nearest neighbor code expects them to be within the image). The 12.4 fixed point maps are
+ * interpolated with integer math, which is exact and gives the same output as the scalar code; the float maps are
+ * interpolated with the same float operations of the scalar code. */
+
+/* Bilinear neighborhood of four destination pixels: offset of the top-left source pixel, offsets to its right and
+ * bottom neighbors (0 on the last column and row). */
+typedef struct
+{
+  uint32x4_t o;
+  uint32x4_t incx;
+  uint32x4_t incy;
+} mve_dewarp_quad_t;
+
+/* Offsets of the nearest source pixels of four destination pixels from a 12.4 fixed point map. */
+static inline uint32x4_t mve_dewarp_nearest_fp(const uint16_t *map, int w, int h, mve_pred16_t p)
+{
+  uint32x4_t u32x4_idx = vidupq_n_u32(0, 2);
+  uint32x4_t u32x4_x = vldrhq_gather_shifted_offset_z_u32(map + 1, u32x4_idx, p);
+  uint32x4_t u32x4_y = vldrhq_gather_shifted_offset_z_u32(map, u32x4_idx, p);
+
+  u32x4_x = vminq_u32(vshrq_n_u32(vaddq_n_u32(u32x4_x, 8), 4), vdupq_n_u32(w - 1));
+  u32x4_y = vminq_u32(vshrq_n_u32(vaddq_n_u32(u32x4_y, 8), 4), vdupq_n_u32(h - 1));
+
+  return vmlaq_n_u32(u32x4_x, u32x4_y, w);
+}
+
+/* Offsets of the nearest source pixels of four destination pixels from a float map. */
+static inline uint32x4_t mve_dewarp_nearest_float(const float *map, int w, int h, mve_pred16_t p)
+{
+  uint32x4_t u32x4_idx = vidupq_n_u32(0, 2);
+  float32x4_t f32x4_x = vldrwq_gather_shifted_offset_z_f32(map + 1, u32x4_idx, p);
+  float32x4_t f32x4_y = vldrwq_gather_shifted_offset_z_f32(map, u32x4_idx, p);
+  int32x4_t s32x4_x = vcvtq_s32_f32(vaddq_n_f32(f32x4_x, 0.5f));
+  int32x4_t s32x4_y = vcvtq_s32_f32(vaddq_n_f32(f32x4_y, 0.5f));
+
+  s32x4_x = vmaxq_s32(vminq_s32(s32x4_x, vdupq_n_s32(w - 1)), vdupq_n_s32(0));
+  s32x4_y = vmaxq_s32(vminq_s32(s32x4_y, vdupq_n_s32(h - 1)), vdupq_n_s32(0));
+
+  return vreinterpretq_u32_s32(vmlaq_n_s32(s32x4_x, s32x4_y, w));
+}
+
+/* Bilinear neighborhood of the integer source coordinates (x, y), computed as in read_*_quad(). */
+static inline void mve_dewarp_quad(int32x4_t s32x4_x, int32x4_t s32x4_y, int w, int h, mve_dewarp_quad_t *q)
+{
+  int32x4_t s32x4_zero = vdupq_n_s32(0);
+  int32x4_t s32x4_wmax = vdupq_n_s32(w - 1);
+  int32x4_t s32x4_hmax = vdupq_n_s32(h - 1);
+  int32x4_t s32x4_x0 = vmaxq_s32(vminq_s32(s32x4_x, s32x4_wmax), s32x4_zero);
+  int32x4_t s32x4_y0 = vmaxq_s32(vminq_s32(s32x4_y, s32x4_hmax), s32x4_zero);
+  int32x4_t s32x4_x1 = vmaxq_s32(vminq_s32(vaddq_n_s32(s32x4_x, 1), s32x4_wmax), s32x4_zero);
+  int32x4_t s32x4_y1 = vmaxq_s32(vminq_s32(vaddq_n_s32(s32x4_y, 1), s32x4_hmax), s32x4_zero);
+
+  q->o = vreinterpretq_u32_s32(vmlaq_n_s32(s32x4_x0, s32x4_y0, w));
+  q->incx = vreinterpretq_u32_s32(vsubq_s32(s32x4_x1, s32x4_x0));
+  q->incy = vreinterpretq_u32_s32(vmulq_n_s32(vsubq_s32(s32x4_y1, s32x4_y0), w));
+}
+
+/* Bilinear neighborhoods and fractions (1/16 units) of four destination pixels from a 12.4 fixed point map. */
+static inline void mve_dewarp_bilinear_fp(const uint16_t *map, int w, int h, mve_pred16_t p, mve_dewarp_quad_t *q,
+                                          uint32x4_t *dx, uint32x4_t *dy)
+{
+  uint32x4_t u32x4_idx = vidupq_n_u32(0, 2);
+  uint32x4_t u32x4_x = vldrhq_gather_shifted_offset_z_u32(map + 1, u32x4_idx, p);
+  uint32x4_t u32x4_y = vldrhq_gather_shifted_offset_z_u32(map, u32x4_idx, p);
+
+  *dx = vandq_u32(u32x4_x, vdupq_n_u32(0xf));
+  *dy = vandq_u32(u32x4_y, vdupq_n_u32(0xf));
+  mve_dewarp_quad(vreinterpretq_s32_u32(vshrq_n_u32(u32x4_x, 4)), vreinterpretq_s32_u32(vshrq_n_u32(u32x4_y, 4)),
+                  w, h, q);
+}
+
+/* Bilinear neighborhoods and fractions of four destination pixels from a float map. */
+static inline void mve_dewarp_bilinear_float(const float *map, int w, int h, mve_pred16_t p, mve_dewarp_quad_t *q,
+                                             float32x4_t *dx, float32x4_t *dy)
+{
+  uint32x4_t u32x4_idx = vidupq_n_u32(0, 2);
+  float32x4_t f32x4_x = vldrwq_gather_shifted_offset_z_f32(map + 1, u32x4_idx, p);
+  float32x4_t f32x4_y = vldrwq_gather_shifted_offset_z_f32(map, u32x4_idx, p);
+  int32x4_t s32x4_x = vcvtq_s32_f32(f32x4_x);
+  int32x4_t s32x4_y = vcvtq_s32_f32(f32x4_y);
+
+  *dx = vsubq_f32(f32x4_x, vcvtq_f32_s32(s32x4_x));
+  *dy = vsubq_f32(f32x4_y, vcvtq_f32_s32(s32x4_y));
+  mve_dewarp_quad(s32x4_x, s32x4_y, w, h, q);
+}
+
+/* Offsets of the nearest source pixels of four span pixels at the 16.16 fixed point locations (u, v). */
+static inline uint32x4_t mve_dewarp_nearest_span(int32x4_t u, int32x4_t v, int w, int h)
+{
+  int32x4_t s32x4_zero = vdupq_n_s32(0);
+  int32x4_t s32x4_x = vshrq_n_s32(vaddq_n_s32(u, 0x8000), 16);
+  int32x4_t s32x4_y = vshrq_n_s32(vaddq_n_s32(v, 0x8000), 16);
+
+  s32x4_x = vmaxq_s32(vminq_s32(s32x4_x, vdupq_n_s32(w - 1)), s32x4_zero);
+  s32x4_y = vmaxq_s32(vminq_s32(s32x4_y, vdupq_n_s32(h - 1)), s32x4_zero);
+
+  return vreinterpretq_u32_s32(vmlaq_n_s32(s32x4_x, s32x4_y, w));
+}
+
+/* Bilinear neighborhoods and fractions (1/256 units) of four span pixels at the 16.16 fixed point locations (u, v);
+ * the negative locations are clamped to 0. */
+static inline void mve_dewarp_bilinear_span(int32x4_t u, int32x4_t v, int w, int h, mve_dewarp_quad_t *q,
+                                            uint32x4_t *dx, uint32x4_t *dy)
+{
+  int32x4_t s32x4_zero = vdupq_n_s32(0);
+
+  u = vmaxq_s32(u, s32x4_zero);
+  v = vmaxq_s32(v, s32x4_zero);
+  *dx = vandq_u32(vshrq_n_u32(vreinterpretq_u32_s32(u), 8), vdupq_n_u32(0xff));
+  *dy = vandq_u32(vshrq_n_u32(vreinterpretq_u32_s32(v), 8), vdupq_n_u32(0xff));
+  mve_dewarp_quad(vshrq_n_s32(u, 16), vshrq_n_s32(v, 16), w, h, q);
+}
+
+/* Gathers the four 8-bit values of the bilinear neighborhoods; scale is the size of a source pixel. */
+static inline void mve_dewarp_gather_u8(const uint8_t *src, const mve_dewarp_quad_t *q, uint32_t scale,
+                                        mve_pred16_t p, uint32x4_t v[4])
+{
+  uint32x4_t u32x4_o = vmulq_n_u32(q->o, scale);
+  uint32x4_t u32x4_incx = vmulq_n_u32(q->incx, scale);
+  uint32x4_t u32x4_incy = vmulq_n_u32(q->incy, scale);
+
+  v[0] = vldrbq_gather_offset_z_u32(src, u32x4_o, p);
+  v[1] = vldrbq_gather_offset_z_u32(src, vaddq_u32(u32x4_o, u32x4_incx), p);
+  u32x4_o = vaddq_u32(u32x4_o, u32x4_incy);
+  v[2] = vldrbq_gather_offset_z_u32(src, u32x4_o, p);
+  v[3] = vldrbq_gather_offset_z_u32(src, vaddq_u32(u32x4_o, u32x4_incx), p);
+}
+
+/* Gathers the four RGB565 values of the bilinear neighborhoods. */
+static inline void mve_dewarp_gather_u16(const uint16_t *src, const mve_dewarp_quad_t *q, mve_pred16_t p,
+                                         uint32x4_t v[4])
+{
+  uint32x4_t u32x4_o = vaddq_u32(q->o, q->incy);
+
+  v[0] = vldrhq_gather_shifted_offset_z_u32(src, q->o, p);
+  v[1] = vldrhq_gather_shifted_offset_z_u32(src, vaddq_u32(q->o, q->incx), p);
+  v[2] = vldrhq_gather_shifted_offset_z_u32(src, u32x4_o, p);
+  v[3] = vldrhq_gather_shifted_offset_z_u32(src, vaddq_u32(u32x4_o, q->incx), p);
+}
+
+/* Extracts a channel of four RGB565 values. */
+static inline void mve_dewarp_channel(const uint32x4_t v[4], int shift, uint32_t mask, uint32x4_t c[4])
+{
+  for (int k = 0; k < 4; k++) {
+    c[k] = vandq_u32(vshlq_u32(v[k], vdupq_n_s32(-shift)), vdupq_n_u32(mask));
+  }
+}
+
+/* Bilinear interpolation with the fractions in 1/16 units: exact, and truncated as the scalar float code. */
+static inline uint32x4_t mve_dewarp_interp_fp(const uint32x4_t v[4], uint32x4_t dx, uint32x4_t dy)
+{
+  uint32x4_t u32x4_top = vaddq_u32(vshlq_n_u32(v[0], 4), vmulq_u32(vsubq_u32(v[1], v[0]), dx));
+  uint32x4_t u32x4_bottom = vaddq_u32(vshlq_n_u32(v[2], 4), vmulq_u32(vsubq_u32(v[3], v[2]), dx));
+  uint32x4_t u32x4_out = vaddq_u32(vshlq_n_u32(u32x4_top, 4), vmulq_u32(vsubq_u32(u32x4_bottom, u32x4_top), dy));
+
+  return vshrq_n_u32(u32x4_out, 8);
+}
+
+/* Bilinear interpolation with the fractions in 1/256 units (truncated). */
+static inline uint32x4_t mve_dewarp_interp_q8(const uint32x4_t v[4], uint32x4_t dx, uint32x4_t dy)
+{
+  uint32x4_t u32x4_top = vaddq_u32(vshlq_n_u32(v[0], 8), vmulq_u32(vsubq_u32(v[1], v[0]), dx));
+  uint32x4_t u32x4_bottom = vaddq_u32(vshlq_n_u32(v[2], 8), vmulq_u32(vsubq_u32(v[3], v[2]), dx));
+  uint32x4_t u32x4_out = vaddq_u32(vshlq_n_u32(u32x4_top, 8), vmulq_u32(vsubq_u32(u32x4_bottom, u32x4_top), dy));
+
+  return vshrq_n_u32(u32x4_out, 16);
+}
+
+/* Bilinear interpolation with the same operations of interpolate(). */
+static inline uint32x4_t mve_dewarp_interp_float(const uint32x4_t v[4], float32x4_t dx, float32x4_t dy)
+{
+  int32x4_t s32x4_v0 = vreinterpretq_s32_u32(v[0]);
+  int32x4_t s32x4_v1 = vreinterpretq_s32_u32(v[1]);
+  int32x4_t s32x4_v2 = vreinterpretq_s32_u32(v[2]);
+  int32x4_t s32x4_v3 = vreinterpretq_s32_u32(v[3]);
+  int32x4_t s32x4_a = vsubq_s32(vaddq_s32(vsubq_s32(s32x4_v3, s32x4_v2), s32x4_v0), s32x4_v1);
+  float32x4_t f32x4_out = vmulq_f32(vmulq_f32(dx, dy), vcvtq_f32_s32(s32x4_a));
+
+  f32x4_out = vaddq_f32(f32x4_out, vmulq_f32(dx, vcvtq_f32_s32(vsubq_s32(s32x4_v1, s32x4_v0))));
+  f32x4_out = vaddq_f32(f32x4_out, vmulq_f32(dy, vcvtq_f32_s32(vsubq_s32(s32x4_v2, s32x4_v0))));
+  f32x4_out = vaddq_f32(f32x4_out, vcvtq_f32_s32(s32x4_v0));
+
+  return vcvtq_u32_f32(f32x4_out);
+}
+
+/* Stores four RGB888 destination pixels from a source one. */
+static inline void mve_dewarp_copy_rgb888(const uint8_t *src, uint8_t *dst, uint32x4_t o, mve_pred16_t p)
+{
+  uint32x4_t u32x4_dst = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+
+  o = vmulq_n_u32(o, 3);
+  for (int c = 0; c < 3; c++) {
+    vstrbq_scatter_offset_p_u32(dst + c, u32x4_dst, vldrbq_gather_offset_z_u32(src + c, o, p), p);
+  }
+}
+
+/* grayscale */
+void mve_dewarp_dense_float_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_o = mve_dewarp_nearest_float(map, isrc->w, isrc->h, p);
+
+    vstrbq_p_u32(dst, vldrbq_gather_offset_z_u32(src, u32x4_o, p), p);
+  }
+}
+
+void mve_dewarp_dense_float_bilinear_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    float32x4_t f32x4_dx, f32x4_dy;
+    uint32x4_t v[4];
+
+    mve_dewarp_bilinear_float(map, isrc->w, isrc->h, p, &q, &f32x4_dx, &f32x4_dy);
+    mve_dewarp_gather_u8(src, &q, 1, p, v);
+    vstrbq_p_u32(dst, mve_dewarp_interp_float(v, f32x4_dx, f32x4_dy), p);
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_o = mve_dewarp_nearest_fp(map, isrc->w, isrc->h, p);
+
+    vstrbq_p_u32(dst, vldrbq_gather_offset_z_u32(src, u32x4_o, p), p);
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_bilinear_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v[4];
+
+    mve_dewarp_bilinear_fp(map, isrc->w, isrc->h, p, &q, &u32x4_dx, &u32x4_dy);
+    mve_dewarp_gather_u8(src, &q, 1, p, v);
+    vstrbq_p_u32(dst, mve_dewarp_interp_fp(v, u32x4_dx, u32x4_dy), p);
+  }
+}
+
+/* rgb565 */
+void mve_dewarp_dense_float_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint16_t *src = (const uint16_t *)isrc->data;
+  uint16_t *dst = (uint16_t *)idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_o = mve_dewarp_nearest_float(map, isrc->w, isrc->h, p);
+
+    vstrhq_p_u32(dst, vldrhq_gather_shifted_offset_z_u32(src, u32x4_o, p), p);
+  }
+}
+
+void mve_dewarp_dense_float_bilinear_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint16_t *src = (const uint16_t *)isrc->data;
+  uint16_t *dst = (uint16_t *)idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    float32x4_t f32x4_dx, f32x4_dy;
+    uint32x4_t v[4], c[4];
+    uint32x4_t u32x4_out;
+
+    mve_dewarp_bilinear_float(map, isrc->w, isrc->h, p, &q, &f32x4_dx, &f32x4_dy);
+    mve_dewarp_gather_u16(src, &q, p, v);
+
+    mve_dewarp_channel(v, 11, 0x1f, c);
+    u32x4_out = vshlq_n_u32(mve_dewarp_interp_float(c, f32x4_dx, f32x4_dy), 11);
+    mve_dewarp_channel(v, 5, 0x3f, c);
+    u32x4_out = vorrq_u32(u32x4_out, vshlq_n_u32(mve_dewarp_interp_float(c, f32x4_dx, f32x4_dy), 5));
+    mve_dewarp_channel(v, 0, 0x1f, c);
+    u32x4_out = vorrq_u32(u32x4_out, mve_dewarp_interp_float(c, f32x4_dx, f32x4_dy));
+
+    vstrhq_p_u32(dst, u32x4_out, p);
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint16_t *src = (const uint16_t *)isrc->data;
+  uint16_t *dst = (uint16_t *)idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_o = mve_dewarp_nearest_fp(map, isrc->w, isrc->h, p);
+
+    vstrhq_p_u32(dst, vldrhq_gather_shifted_offset_z_u32(src, u32x4_o, p), p);
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_bilinear_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint16_t *src = (const uint16_t *)isrc->data;
+  uint16_t *dst = (uint16_t *)idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v[4], c[4];
+    uint32x4_t u32x4_out;
+
+    mve_dewarp_bilinear_fp(map, isrc->w, isrc->h, p, &q, &u32x4_dx, &u32x4_dy);
+    mve_dewarp_gather_u16(src, &q, p, v);
+
+    mve_dewarp_channel(v, 11, 0x1f, c);
+    u32x4_out = vshlq_n_u32(mve_dewarp_interp_fp(c, u32x4_dx, u32x4_dy), 11);
+    mve_dewarp_channel(v, 5, 0x3f, c);
+    u32x4_out = vorrq_u32(u32x4_out, vshlq_n_u32(mve_dewarp_interp_fp(c, u32x4_dx, u32x4_dy), 5));
+    mve_dewarp_channel(v, 0, 0x1f, c);
+    u32x4_out = vorrq_u32(u32x4_out, mve_dewarp_interp_fp(c, u32x4_dx, u32x4_dy));
+
+    vstrhq_p_u32(dst, u32x4_out, p);
+  }
+}
+
+/* rgb888 */
+void mve_dewarp_dense_float_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 12) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    mve_dewarp_copy_rgb888(src, dst, mve_dewarp_nearest_float(map, isrc->w, isrc->h, p), p);
+  }
+}
+
+void mve_dewarp_dense_float_bilinear_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const float *map = mapxy->dense_float;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  uint32x4_t u32x4_dst = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 12) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    float32x4_t f32x4_dx, f32x4_dy;
+    uint32x4_t v[4];
+
+    mve_dewarp_bilinear_float(map, isrc->w, isrc->h, p, &q, &f32x4_dx, &f32x4_dy);
+    for (int c = 0; c < 3; c++) {
+      mve_dewarp_gather_u8(src + c, &q, 3, p, v);
+      vstrbq_scatter_offset_p_u32(dst + c, u32x4_dst, mve_dewarp_interp_float(v, f32x4_dx, f32x4_dy), p);
+    }
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 12) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    mve_dewarp_copy_rgb888(src, dst, mve_dewarp_nearest_fp(map, isrc->w, isrc->h, p), p);
+  }
+}
+
+void mve_dewarp_dense_fp_12_4_bilinear_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+  const uint16_t *map = mapxy->dense_fp;
+  const uint8_t *src = isrc->data;
+  uint8_t *dst = idst->data;
+  uint32x4_t u32x4_dst = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+  int n = isrc->w * isrc->h;
+
+  for (int i = 0; i < n; i += 4, map += 8, dst += 12) {
+    mve_pred16_t p = vctp32q(n - i);
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v[4];
+
+    mve_dewarp_bilinear_fp(map, isrc->w, isrc->h, p, &q, &u32x4_dx, &u32x4_dy);
+    for (int c = 0; c < 3; c++) {
+      mve_dewarp_gather_u8(src + c, &q, 3, p, v);
+      vstrbq_scatter_offset_p_u32(dst + c, u32x4_dst, mve_dewarp_interp_fp(v, u32x4_dx, u32x4_dy), p);
+    }
+  }
+}
+
+/* The spans of the sparse maps are processed four pixels at a time, stepping the 16.16 fixed point source locations
+ * of the lanes by four steps at each iteration. */
+#define MVE_DEWARP_SPAN_BEGIN                                                         \
+  int32x4_t s32x4_idx = vreinterpretq_s32_u32(vidupq_n_u32(0, 1));                   \
+  int32x4_t s32x4_u = vmlaq_n_s32(vdupq_n_s32(u), s32x4_idx, du);                    \
+  int32x4_t s32x4_v = vmlaq_n_s32(vdupq_n_s32(v), s32x4_idx, dv);                    \
+  for (int i = 0; i < n; i += 4, s32x4_u = vaddq_n_s32(s32x4_u, 4 * du),            \
+       s32x4_v = vaddq_n_s32(s32x4_v, 4 * dv)) {                                     \
+    mve_pred16_t p = vctp32q(n - i);
+
+#define MVE_DEWARP_SPAN_END }
+
+void mve_dewarp_span_nearest_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                       int32_t dv)
+{
+  MVE_DEWARP_SPAN_BEGIN
+    uint32x4_t u32x4_o = mve_dewarp_nearest_span(s32x4_u, s32x4_v, isrc->w, isrc->h);
+
+    vstrbq_p_u32(dst + i, vldrbq_gather_offset_z_u32(isrc->data, u32x4_o, p), p);
+  MVE_DEWARP_SPAN_END
+}
+
+void mve_dewarp_span_bilinear_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                        int32_t dv)
+{
+  MVE_DEWARP_SPAN_BEGIN
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v4[4];
+
+    mve_dewarp_bilinear_span(s32x4_u, s32x4_v, isrc->w, isrc->h, &q, &u32x4_dx, &u32x4_dy);
+    mve_dewarp_gather_u8(isrc->data, &q, 1, p, v4);
+    vstrbq_p_u32(dst + i, mve_dewarp_interp_q8(v4, u32x4_dx, u32x4_dy), p);
+  MVE_DEWARP_SPAN_END
+}
+
+void mve_dewarp_span_nearest_rgb565(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                    int32_t dv)
+{
+  MVE_DEWARP_SPAN_BEGIN
+    uint32x4_t u32x4_o = mve_dewarp_nearest_span(s32x4_u, s32x4_v, isrc->w, isrc->h);
+
+    vstrhq_p_u32((uint16_t *)dst + i, vldrhq_gather_shifted_offset_z_u32((const uint16_t *)isrc->data, u32x4_o, p),
+                 p);
+  MVE_DEWARP_SPAN_END
+}
+
+void mve_dewarp_span_bilinear_rgb565(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                     int32_t dv)
+{
+  MVE_DEWARP_SPAN_BEGIN
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v4[4], c[4];
+    uint32x4_t u32x4_out;
+
+    mve_dewarp_bilinear_span(s32x4_u, s32x4_v, isrc->w, isrc->h, &q, &u32x4_dx, &u32x4_dy);
+    mve_dewarp_gather_u16((const uint16_t *)isrc->data, &q, p, v4);
+
+    mve_dewarp_channel(v4, 11, 0x1f, c);
+    u32x4_out = vshlq_n_u32(mve_dewarp_interp_q8(c, u32x4_dx, u32x4_dy), 11);
+    mve_dewarp_channel(v4, 5, 0x3f, c);
+    u32x4_out = vorrq_u32(u32x4_out, vshlq_n_u32(mve_dewarp_interp_q8(c, u32x4_dx, u32x4_dy), 5));
+    mve_dewarp_channel(v4, 0, 0x1f, c);
+    u32x4_out = vorrq_u32(u32x4_out, mve_dewarp_interp_q8(c, u32x4_dx, u32x4_dy));
+
+    vstrhq_p_u32((uint16_t *)dst + i, u32x4_out, p);
+  MVE_DEWARP_SPAN_END
+}
+
+void mve_dewarp_span_nearest_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                    int32_t dv)
+{
+  MVE_DEWARP_SPAN_BEGIN
+    mve_dewarp_copy_rgb888(isrc->data, dst + (3 * i), mve_dewarp_nearest_span(s32x4_u, s32x4_v, isrc->w, isrc->h), p);
+  MVE_DEWARP_SPAN_END
+}
+
+void mve_dewarp_span_bilinear_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+                                     int32_t dv)
+{
+  uint32x4_t u32x4_dst = vmulq_n_u32(vidupq_n_u32(0, 1), 3);
+
+  MVE_DEWARP_SPAN_BEGIN
+    mve_dewarp_quad_t q;
+    uint32x4_t u32x4_dx, u32x4_dy;
+    uint32x4_t v4[4];
+
+    mve_dewarp_bilinear_span(s32x4_u, s32x4_v, isrc->w, isrc->h, &q, &u32x4_dx, &u32x4_dy);
+    for (int c = 0; c < 3; c++) {
+      mve_dewarp_gather_u8(isrc->data + c, &q, 3, p, v4);
+      vstrbq_scatter_offset_p_u32(dst + (3 * i) + c, u32x4_dst, mve_dewarp_interp_q8(v4, u32x4_dx, u32x4_dy), p);
+    }
+  MVE_DEWARP_SPAN_END
+}
+#endif /* IPL_DEWARP_HAS_MVE */
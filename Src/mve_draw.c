@@ -144,4 +144,44 @@ void point_fill_mve_rgb565(image_t *img, int cx, int cy, int r0, int r1, int c)
     r += 8;
   }
 }
+
+/* Fills n RGB565 pixels with the color c, 8 pixels per store */
+void span_fill_mve_rgb565(uint16_t *dst, int n, int c)
+{
+  uint16x8_t value = vdupq_n_u16(c);
+
+  while (n > 0) {
+    vstrhq_p_u16(dst, value, vctp16q(n));
+    dst += 8;
+    n -= 8;
+  }
+}
+
+/* Fills n RGB888 pixels with the color c (0xRRGGBB): 16 pixels are 48 bytes, i.e. three vectors holding the
+ * B, G, R pattern at different phases */
+void span_fill_mve_rgb888(uint8_t *dst, int n, int c)
+{
+  uint8_t pattern[48];
+  uint8x16_t value[3];
+  int bytes = n * 3;
+
+  for (int i = 0; i < 48; i += 3) {
+    pattern[i] = c & 0xFF;
+    pattern[i + 1] = (c >> 8) & 0xFF;
+    pattern[i + 2] = (c >> 16) & 0xFF;
+  }
+
+  value[0] = vld1q_u8(pattern);
+  value[1] = vld1q_u8(pattern + 16);
+  value[2] = vld1q_u8(pattern + 32);
+
+  for (; bytes >= 48; bytes -= 48, dst += 48) {
+    vst1q_u8(dst, value[0]);
+    vst1q_u8(dst + 16, value[1]);
+    vst1q_u8(dst + 32, value[2]);
+  }
+
+  for (int k = 0; bytes > 0; k++, bytes -= 16, dst += 16)
+    vstrbq_p_u8(dst, value[k], vctp8q(bytes));
+}
 #endif /* IPL_DRAW_HAS_MVE */
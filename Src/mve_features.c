@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file    mve_features.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library feature extraction functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_FEATURES_HAS_MVE
+#include "mve_features.h"
+
+/* Uniform LBP codes of the pixels x0 ... x1 - 1 of the line centered on rows[1] (x0 >= 1, x1 <= width - 1):
+ * the 8 neighbors of 16 pixels are compared with the centers at once, each comparison setting one bit of the
+ * code, then the codes are mapped to their histogram bin with a gather load from the 256-entry table. */
+void mve_lbp_u8(const uint8_t **rows, int x0, int x1, const uint8_t *map, uint8_t *code)
+{
+  const uint8x16_t zero = vdupq_n_u8(0);
+
+  for (int x = x0; x < x1; x += 16) {
+    mve_pred16_t p = vctp8q(x1 - x);
+    uint8x16_t c = vldrbq_z_u8(rows[1] + x, p);
+    uint8x16_t n[8];
+    uint8x16_t v = zero;
+
+    /* Clockwise from the top-left neighbor. */
+    n[0] = vldrbq_z_u8(rows[0] + x - 1, p);
+    n[1] = vldrbq_z_u8(rows[0] + x, p);
+    n[2] = vldrbq_z_u8(rows[0] + x + 1, p);
+    n[3] = vldrbq_z_u8(rows[1] + x + 1, p);
+    n[4] = vldrbq_z_u8(rows[2] + x + 1, p);
+    n[5] = vldrbq_z_u8(rows[2] + x, p);
+    n[6] = vldrbq_z_u8(rows[2] + x - 1, p);
+    n[7] = vldrbq_z_u8(rows[1] + x - 1, p);
+
+    for (int k = 0; k < 8; k++)
+      v = vorrq_u8(v, vpselq_u8(vdupq_n_u8(1 << k), zero, vcmpcsq_u8(n[k], c)));
+
+    vstrbq_p_u8(code + x, vldrbq_gather_offset_z_u8(map, v, p), p);
+  }
+}
+
+#endif /* IPL_FEATURES_HAS_MVE */
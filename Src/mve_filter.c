@@ -37,12 +37,13 @@ int mve_imlib_median_filter_grayscale(image_t *img,
   buf.w = img->w;
   buf.h = brows;
   buf.bpp = img->bpp;
+  buf.stride = 0;
 
   mve_pred16_t p_r = vctp16q(2 * ksize + 1);
 
   const int n = ((ksize * 2) + 1) * ((ksize * 2) + 1);
   const int median_cutoff = fast_floorf(percentile * (float) n);
-  buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+  buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
   uint8_t *data = fb_alloc(64, FB_ALLOC_NO_HINT);
 
   for (int y = 0, yy = img->h; y < yy; y++) {
@@ -59,8 +60,9 @@ int mve_imlib_median_filter_grayscale(image_t *img,
     u16x8_vOffset *= (uint16_t) img->w;
 
     uint8_t *k_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, IM_MAX(y - ksize, 0));
+    uint32_t mask_word = 0;
     for (int x = 0, xx = img->w; x < xx; x++) {
-      if (mask && (!image_get_mask_pixel(mask, x, y))) {
+      if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
         IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
         continue; /* Short circuit. */
       }
@@ -139,6 +141,7 @@ int mve_imlib_morph_u8(image_t *img,
   buf.w = img->w;
   buf.h = brows;
   buf.bpp = img->bpp;
+  buf.stride = 0;
   const int32_t m_int = (int32_t) (65536.0f * m); /* m is 1/kernel_weight    ## STM32IPL: f added to the constant. */
 
   int rer_val = -1;
@@ -156,13 +159,14 @@ int mve_imlib_morph_u8(image_t *img,
     }
     case IMAGE_BPP_GRAYSCALE: {
 
-      buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+      buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
       for (int y = 0, yy = img->h; y < yy; y++) {
         uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
         uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
 
+        uint32_t mask_word = 0;
         for (int x = 0, xx = img->w; x < xx; x++) {
-          if (mask && (!image_get_mask_pixel(mask, x, y))) {
+          if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
             IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x));
             continue; /* Short circuit. */
           }
@@ -267,13 +271,14 @@ int mve_imlib_morph_u8(image_t *img,
     }
 
     case IMAGE_BPP_RGB888: {
-      buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_NO_HINT);
+      buf.data = fb_alloc(IMAGE_RGB888_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
       for (int y = 0, yy = img->h; y < yy; y++) {
         rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
         rgb888_t *buf_row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(&buf, (y % brows));
 
+        uint32_t mask_word = 0;
         for (int x = 0, xx = img->w; x < xx; x++) {
-          if (mask && (!image_get_mask_pixel(mask, x, y))) {
+          if (mask && (!IMAGE_GET_MASK_PIXEL_SCAN(mask, mask_word, x, y))) {
             IMAGE_PUT_RGB888_PIXEL_FAST(buf_row_ptr, x, IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
             continue; /* Short circuit. */
           }
@@ -419,4 +424,519 @@ int mve_imlib_morph_u8(image_t *img,
 
   return rer_val;
 }
+
+/* Updates the column sums of the running-sum mean filter: the pixels of the row out_row are removed and the ones
+ * of the row in_row are added. The 8-bit channels (Grayscale, RGB888) are processed 16 columns at a time; the
+ * RGB565 pixels, whose R5, G6 and B5 sums are stored one after the other, are processed 8 at a time. */
+void mve_imlib_mean_update_columns(image_t *img, const uint8_t *out_row, const uint8_t *in_row, uint16_t *col_sum)
+{
+  if (img->bpp == IMAGE_BPP_RGB565) {
+    const uint16_t *out_ptr = (const uint16_t *) out_row;
+    const uint16_t *in_ptr = (const uint16_t *) in_row;
+    uint16_t *r_sum = col_sum;
+    uint16_t *g_sum = col_sum + img->w;
+    uint16_t *b_sum = col_sum + (2 * img->w);
+
+    for (int x = 0; x < img->w; x += 8) {
+      mve_pred16_t p = vctp16q(img->w - x);
+      uint16x8_t u16x8_out = vldrhq_z_u16(&out_ptr[x], p);
+      uint16x8_t u16x8_in = vldrhq_z_u16(&in_ptr[x], p);
+      uint16x8_t u16x8_r = vldrhq_z_u16(&r_sum[x], p);
+      uint16x8_t u16x8_g = vldrhq_z_u16(&g_sum[x], p);
+      uint16x8_t u16x8_b = vldrhq_z_u16(&b_sum[x], p);
+
+      u16x8_r = vaddq_u16(u16x8_r, vshrq_n_u16(u16x8_in, 11));
+      u16x8_r = vsubq_u16(u16x8_r, vshrq_n_u16(u16x8_out, 11));
+      u16x8_g = vaddq_u16(u16x8_g, vandq_u16(vshrq_n_u16(u16x8_in, 5), vdupq_n_u16(0x3F)));
+      u16x8_g = vsubq_u16(u16x8_g, vandq_u16(vshrq_n_u16(u16x8_out, 5), vdupq_n_u16(0x3F)));
+      u16x8_b = vaddq_u16(u16x8_b, vandq_u16(u16x8_in, vdupq_n_u16(0x1F)));
+      u16x8_b = vsubq_u16(u16x8_b, vandq_u16(u16x8_out, vdupq_n_u16(0x1F)));
+
+      vstrhq_p_u16(&r_sum[x], u16x8_r, p);
+      vstrhq_p_u16(&g_sum[x], u16x8_g, p);
+      vstrhq_p_u16(&b_sum[x], u16x8_b, p);
+    }
+  } else {
+    int len = image_line_size(img);
+    int i = 0;
+
+    for (; i <= (len - 16); i += 16) {
+      uint16x8_t u16x8_lo = vldrhq_u16(&col_sum[i]);
+      uint16x8_t u16x8_hi = vldrhq_u16(&col_sum[i + 8]);
+
+      u16x8_lo = vsubq_u16(vaddq_u16(u16x8_lo, vldrbq_u16(&in_row[i])), vldrbq_u16(&out_row[i]));
+      u16x8_hi = vsubq_u16(vaddq_u16(u16x8_hi, vldrbq_u16(&in_row[i + 8])), vldrbq_u16(&out_row[i + 8]));
+
+      vstrhq_u16(&col_sum[i], u16x8_lo);
+      vstrhq_u16(&col_sum[i + 8], u16x8_hi);
+    }
+
+    for (; i < len; i += 8) { /* remaining columns */
+      mve_pred16_t p = vctp16q(len - i);
+      uint16x8_t u16x8_sum = vldrhq_z_u16(&col_sum[i], p);
+
+      u16x8_sum = vsubq_u16(vaddq_u16(u16x8_sum, vldrbq_z_u16(&in_row[i], p)), vldrbq_z_u16(&out_row[i], p));
+      vstrhq_p_u16(&col_sum[i], u16x8_sum, p);
+    }
+  }
+}
+
+/* Vertical pass of the separable gaussian: computes the weighted sums of the rows y - radius ... y + radius
+ * (clamped to the image). The 8-bit channels (Grayscale, RGB888) are processed 16 columns at a time; the RGB565
+ * pixels are processed 8 at a time, their R5, G6 and B5 sums being stored to three planes of plane_len elements. */
+void mve_imlib_gaussian_vertical(image_t *img, int y, int radius, const uint16_t *weights, uint16_t *out, int plane_len)
+{
+  int taps = (radius * 2) + 1;
+  int stride = image_line_stride(img);
+
+  if (img->bpp == IMAGE_BPP_RGB565) {
+    for (int x = 0; x < img->w; x += 8) {
+      mve_pred16_t p = vctp16q(img->w - x);
+      uint16x8_t u16x8_r = vdupq_n_u16(0);
+      uint16x8_t u16x8_g = vdupq_n_u16(0);
+      uint16x8_t u16x8_b = vdupq_n_u16(0);
+
+      for (int t = 0; t < taps; t++) {
+        int yy = IM_MIN(IM_MAX(y - radius + t, 0), (img->h - 1));
+        uint16x8_t u16x8_pixel = vldrhq_z_u16((const uint16_t *) (img->data + (yy * stride)) + x, p);
+
+        u16x8_r = vmlaq_n_u16(u16x8_r, vshrq_n_u16(u16x8_pixel, 11), weights[t]);
+        u16x8_g = vmlaq_n_u16(u16x8_g, vandq_u16(vshrq_n_u16(u16x8_pixel, 5), vdupq_n_u16(0x3F)), weights[t]);
+        u16x8_b = vmlaq_n_u16(u16x8_b, vandq_u16(u16x8_pixel, vdupq_n_u16(0x1F)), weights[t]);
+      }
+
+      vstrhq_p_u16(&out[x], u16x8_r, p);
+      vstrhq_p_u16(&out[plane_len + x], u16x8_g, p);
+      vstrhq_p_u16(&out[(2 * plane_len) + x], u16x8_b, p);
+    }
+  } else {
+    int len = image_line_size(img);
+
+    for (int i = 0; i < len; i += 16) {
+      mve_pred16_t p_lo = vctp16q(len - i);
+      mve_pred16_t p_hi = vctp16q(IM_MAX(len - i - 8, 0));
+      uint16x8_t u16x8_lo = vdupq_n_u16(0);
+      uint16x8_t u16x8_hi = vdupq_n_u16(0);
+
+      for (int t = 0; t < taps; t++) {
+        int yy = IM_MIN(IM_MAX(y - radius + t, 0), (img->h - 1));
+        const uint8_t *row = img->data + (yy * stride) + i;
+
+        u16x8_lo = vmlaq_n_u16(u16x8_lo, vldrbq_z_u16(row, p_lo), weights[t]);
+        u16x8_hi = vmlaq_n_u16(u16x8_hi, vldrbq_z_u16(row + 8, p_hi), weights[t]);
+      }
+
+      vstrhq_p_u16(&out[i], u16x8_lo, p_lo);
+      vstrhq_p_u16(&out[i + 8], u16x8_hi, p_hi);
+    }
+  }
+}
+
+/* Horizontal pass of the separable gaussian: out[i] is the weighted sum of in[i], in[i + step], ...,
+ * in[i + (radius * 2 * step)], plus bias, shifted right by shift; 4 values at a time, with 32-bit sums. */
+void mve_imlib_gaussian_horizontal(const uint16_t *in, int n, int step, int radius, const uint16_t *weights, uint32_t bias, int shift, uint8_t *out)
+{
+  int taps = (radius * 2) + 1;
+  int32x4_t s32x4_shift = vdupq_n_s32(-shift);
+
+  for (int i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+    uint32x4_t u32x4_acc = vdupq_n_u32(bias);
+    const uint16_t *ptr = &in[i];
+
+    for (int t = 0; t < taps; t++, ptr += step) {
+      u32x4_acc = vmlaq_n_u32(u32x4_acc, vldrhq_z_u32(ptr, p), weights[t]);
+    }
+
+    vstrbq_p_u32(&out[i], vshlq_u32(u32x4_acc, s32x4_shift), p);
+  }
+}
+
+/* Result of a 3x3 or 5x5 kernel on 8 pixels of a Grayscale line, with the arithmetic of imlib_morph(): the sums
+ * of the positive and of the negative weights are accumulated separately, and their difference is saturated to
+ * zero, as the negative results are clamped anyway. */
+static inline uint16x8_t mve_edge_kernel_u16(const uint8_t **rows, int x, int n, const int *krn, uint16_t m_int,
+                                             mve_pred16_t p)
+{
+  uint16x8_t u16x8_pos = vdupq_n_u16(0);
+  uint16x8_t u16x8_neg = vdupq_n_u16(0);
+
+  for (int j = 0; j < n; j++) {
+    for (int k = 0; k < n; k++) {
+      int weight = *krn++;
+
+      if (weight > 0) {
+        u16x8_pos = vmlaq_n_u16(u16x8_pos, vldrbq_z_u16(rows[j] + x + k, p), weight);
+      } else if (weight < 0) {
+        u16x8_neg = vmlaq_n_u16(u16x8_neg, vldrbq_z_u16(rows[j] + x + k, p), -weight);
+      }
+    }
+  }
+
+  return vminq_u16(vmulhq_u16(vqsubq_u16(u16x8_pos, u16x8_neg), vdupq_n_u16(m_int)),
+                   vdupq_n_u16(COLOR_GRAYSCALE_MAX));
+}
+
+/* Same as mve_edge_kernel_u16() for a single pixel close to the left or right border (coordinates clamped). */
+static int mve_edge_kernel_pixel(const uint8_t **rows, int w, int x, int ksize, const int *krn, int32_t m_int)
+{
+  int32_t acc = 0;
+
+  for (int j = 0; j <= 2 * ksize; j++) {
+    for (int k = -ksize; k <= ksize; k++) {
+      acc += *krn++ * rows[j][IM_MIN(IM_MAX(x + k, 0), (w - 1))];
+    }
+  }
+
+  return IM_MIN(IM_MAX((acc * m_int) >> 16, 0), COLOR_GRAYSCALE_MAX);
+}
+
+/* Checks that the positive and the negative weights of a kernel each sum up to 257 at most, so that their
+ * (8-bit pixel) sums fit 16 bits. */
+static bool mve_edge_kernel_fits(const int *krn, int n)
+{
+  int pos = 0, neg = 0;
+
+  for (int i = 0; i < n * n; i++) {
+    if (krn[i] > 0) {
+      pos += krn[i];
+    } else {
+      neg -= krn[i];
+    }
+  }
+
+  return (pos * COLOR_GRAYSCALE_MAX <= UINT16_MAX) && (neg * COLOR_GRAYSCALE_MAX <= UINT16_MAX);
+}
+
+/* 3x3 and 5x5 edge kernels (Sobel, Scharr, Laplacian) of a Grayscale image, with 16-bit lanes; same result of
+ * imlib_morph() (no offset, no threshold, no mask) with the kernel krn_a. When krn_b is not NULL, the result
+ * is the saturated sum of the results of the two kernels, as STM32Ipl_Sobel() and STM32Ipl_Scharr() compute.
+ * Returns 0 on success, -1 when the image or the kernels are not supported. */
+int mve_imlib_edge_u8(image_t *img, const int ksize, const int *krn_a, const int *krn_b, const float m)
+{
+  const int32_t m_int = (int32_t)(65536.0f * m);
+  int n = (ksize * 2) + 1;
+  int brows = ksize + 1;
+  const uint8_t *rows[5];
+  image_t buf;
+
+  if ((img->bpp != IMAGE_BPP_GRAYSCALE) || (ksize < 1) || (ksize > 2) || (m_int <= 0) || (m_int > UINT16_MAX)
+      || !mve_edge_kernel_fits(krn_a, n) || (krn_b && !mve_edge_kernel_fits(krn_b, n))) {
+    return -1;
+  }
+
+  buf.w = img->w;
+  buf.h = brows;
+  buf.bpp = img->bpp;
+  buf.stride = 0;
+  buf.data = fb_alloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, FB_ALLOC_PREFER_SPEED);
+
+  for (int y = 0, yy = img->h; y < yy; y++) {
+    uint8_t *buf_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows));
+
+    for (int j = 0; j < n; j++) {
+      rows[j] = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, IM_MIN(IM_MAX(y - ksize + j, 0), (img->h - 1)));
+    }
+
+    /* inner pixels, 8 at a time */
+    for (int x = ksize; x < img->w - ksize; x += 8) {
+      mve_pred16_t p = vctp16q(img->w - ksize - x);
+      uint16x8_t u16x8_pixel = mve_edge_kernel_u16(rows, x - ksize, n, krn_a, m_int, p);
+
+      if (krn_b) {
+        u16x8_pixel = vminq_u16(vqaddq_u16(u16x8_pixel, mve_edge_kernel_u16(rows, x - ksize, n, krn_b, m_int, p)),
+                                vdupq_n_u16(COLOR_GRAYSCALE_MAX));
+      }
+
+      vstrbq_p_u16(buf_row_ptr + x, u16x8_pixel, p);
+    }
+
+    /* border pixels */
+    for (int x = 0, xx = img->w; x < xx; x++) {
+      if ((x == ksize) && (xx > 2 * ksize)) {
+        x = xx - ksize;
+      }
+
+      int pixel = mve_edge_kernel_pixel(rows, xx, x, ksize, krn_a, m_int);
+      if (krn_b) {
+        pixel = IM_MIN(pixel + mve_edge_kernel_pixel(rows, xx, x, ksize, krn_b, m_int), COLOR_GRAYSCALE_MAX);
+      }
+
+      IMAGE_PUT_GRAYSCALE_PIXEL_FAST(buf_row_ptr, x, pixel);
+    }
+
+    if (y >= ksize) { /* Transfer buffer lines... */
+      memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (y - ksize)),
+             IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, ((y - ksize) % brows)),
+             IMAGE_GRAYSCALE_LINE_LEN_BYTES(img));
+    }
+  }
+
+  /* Copy any remaining lines from the buffer image... */
+  for (int y = IM_MAX(img->h - ksize, 0), yy = img->h; y < yy; y++) {
+    memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y),
+           IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(&buf, (y % brows)),
+           IMAGE_GRAYSCALE_LINE_LEN_BYTES(img));
+  }
+
+  fb_free();
+
+  return 0;
+}
+
+/* Sobel gradients of the pixels x0 ... x1 - 1 of a Grayscale line (ksize <= x0, x1 <= w - ksize), computed from
+ * the lines rows[0] ... rows[2 * ksize] with 16-bit lanes, 8 pixels at a time; coef is the row of the Pascal's
+ * triangle. The magnitude |gx| + |gy| and the direction quantized to 0, 45, 90, 135 degrees (codes 0 ... 3) are
+ * stored when mag and dir are not NULL; the direction thresholds are tan(22.5) = 27146 / 65536 and
+ * tan(67.5) = 2 + (27146 / 65536). */
+void mve_imlib_gradient_u8(const uint8_t **rows, int x0, int x1, int ksize, const int32_t *coef, uint16_t *mag,
+                           uint8_t *dir)
+{
+  int n = (ksize * 2) + 1;
+
+  for (int x = x0; x < x1; x += 8) {
+    mve_pred16_t p = vctp16q(x1 - x);
+    int16x8_t s16x8_gx = vdupq_n_s16(0);
+    int16x8_t s16x8_gy = vdupq_n_s16(0);
+
+    for (int j = 0; j < n; j++) {
+      int16x8_t s16x8_smooth = vdupq_n_s16(0);
+      int16x8_t s16x8_deriv = vdupq_n_s16(0);
+
+      for (int k = 0; k < n; k++) {
+        int16x8_t s16x8_pixel = vreinterpretq_s16_u16(vldrbq_z_u16(rows[j] + x - ksize + k, p));
+
+        s16x8_smooth = vmlaq_n_s16(s16x8_smooth, s16x8_pixel, coef[k]);
+        if (k != ksize) {
+          s16x8_deriv = vmlaq_n_s16(s16x8_deriv, s16x8_pixel, (k < ksize) ? -coef[k] : coef[k]);
+        }
+      }
+
+      s16x8_gx = vmlaq_n_s16(s16x8_gx, s16x8_deriv, coef[j]);
+      if (j != ksize) {
+        s16x8_gy = vmlaq_n_s16(s16x8_gy, s16x8_smooth, (j < ksize) ? -coef[j] : coef[j]);
+      }
+    }
+
+    uint16x8_t u16x8_ax = vreinterpretq_u16_s16(vabsq_s16(s16x8_gx));
+    uint16x8_t u16x8_ay = vreinterpretq_u16_s16(vabsq_s16(s16x8_gy));
+
+    if (mag) {
+      vstrhq_p_u16(mag + x, vaddq_u16(u16x8_ax, u16x8_ay), p);
+    }
+
+    if (dir) {
+      uint16x8_t u16x8_t22 = vmulhq_u16(u16x8_ax, vdupq_n_u16(27146));
+      uint16x8_t u16x8_t67 = vaddq_u16(vshlq_n_u16(u16x8_ax, 1), u16x8_t22);
+      mve_pred16_t p_same = vcmpgeq_n_s16(veorq_s16(s16x8_gx, s16x8_gy), 0);
+      uint16x8_t u16x8_dir = vpselq_u16(vdupq_n_u16(1), vdupq_n_u16(3), p_same);
+
+      u16x8_dir = vpselq_u16(vdupq_n_u16(2), u16x8_dir, vcmpcsq_u16(u16x8_ay, u16x8_t67));
+      u16x8_dir = vpselq_u16(vdupq_n_u16(0), u16x8_dir, vcmpcsq_u16(u16x8_t22, u16x8_ay));
+      vstrbq_p_u16(dir + x, u16x8_dir, p);
+    }
+  }
+}
+
+/* Smallest index of the highest count of the len 16-bit bins (len multiple of 8). */
+int mve_imlib_hist_mode_u16(const uint16_t *bins, int len)
+{
+  uint16_t max = 0;
+
+  for (int i = 0; i < len; i += 8) {
+    max = vmaxvq_u16(max, vldrhq_u16(bins + i));
+  }
+
+  for (int i = 0; i < len; i += 8) {
+    mve_pred16_t p = vcmpeqq_n_u16(vldrhq_u16(bins + i), max);
+
+    if (p) { /* 2 predicate bits per lane */
+      return i + (__builtin_ctz(p) >> 1);
+    }
+  }
+
+  return 0;
+}
+
+/* Extrema of the n lines rows[0] ... rows[n - 1] for the len elements of the lines: bytes, 16 at a time, or
+ * RGB565 words, 8 at a time, whose R5, G6, B5 fields are masked to get the extrema of each channel. */
+void mve_imlib_midpoint_vertical(int bpp, uint8_t **rows, int n, int len, uint8_t *v_min, uint8_t *v_max)
+{
+  if (bpp == IMAGE_BPP_RGB565) {
+    uint16x8_t u16x8_rMask = vdupq_n_u16(0xF800);
+    uint16x8_t u16x8_gMask = vdupq_n_u16(0x07E0);
+    uint16x8_t u16x8_bMask = vdupq_n_u16(0x001F);
+
+    for (int i = 0; i < len; i += 8) {
+      mve_pred16_t p = vctp16q(len - i);
+      uint16x8_t u16x8_pixel = vldrhq_z_u16((const uint16_t *) rows[0] + i, p);
+      uint16x8_t u16x8_rMin = vandq_u16(u16x8_pixel, u16x8_rMask);
+      uint16x8_t u16x8_gMin = vandq_u16(u16x8_pixel, u16x8_gMask);
+      uint16x8_t u16x8_bMin = vandq_u16(u16x8_pixel, u16x8_bMask);
+      uint16x8_t u16x8_rMax = u16x8_rMin;
+      uint16x8_t u16x8_gMax = u16x8_gMin;
+      uint16x8_t u16x8_bMax = u16x8_bMin;
+
+      for (int j = 1; j < n; j++) {
+        u16x8_pixel = vldrhq_z_u16((const uint16_t *) rows[j] + i, p);
+        uint16x8_t u16x8_r = vandq_u16(u16x8_pixel, u16x8_rMask);
+        uint16x8_t u16x8_g = vandq_u16(u16x8_pixel, u16x8_gMask);
+        uint16x8_t u16x8_b = vandq_u16(u16x8_pixel, u16x8_bMask);
+
+        u16x8_rMin = vminq_u16(u16x8_rMin, u16x8_r);
+        u16x8_gMin = vminq_u16(u16x8_gMin, u16x8_g);
+        u16x8_bMin = vminq_u16(u16x8_bMin, u16x8_b);
+        u16x8_rMax = vmaxq_u16(u16x8_rMax, u16x8_r);
+        u16x8_gMax = vmaxq_u16(u16x8_gMax, u16x8_g);
+        u16x8_bMax = vmaxq_u16(u16x8_bMax, u16x8_b);
+      }
+
+      vstrhq_p_u16((uint16_t *) v_min + i, vorrq_u16(vorrq_u16(u16x8_rMin, u16x8_gMin), u16x8_bMin), p);
+      vstrhq_p_u16((uint16_t *) v_max + i, vorrq_u16(vorrq_u16(u16x8_rMax, u16x8_gMax), u16x8_bMax), p);
+    }
+  } else {
+    for (int i = 0; i < len; i += 16) {
+      mve_pred16_t p = vctp8q(len - i);
+      uint8x16_t u8x16_min = vldrbq_z_u8(rows[0] + i, p);
+      uint8x16_t u8x16_max = u8x16_min;
+
+      for (int j = 1; j < n; j++) {
+        uint8x16_t u8x16_pixel = vldrbq_z_u8(rows[j] + i, p);
+
+        u8x16_min = vminq_u8(u8x16_min, u8x16_pixel);
+        u8x16_max = vmaxq_u8(u8x16_max, u8x16_pixel);
+      }
+
+      vstrbq_p_u8(v_min + i, u8x16_min, p);
+      vstrbq_p_u8(v_max + i, u8x16_max, p);
+    }
+  }
+}
+
+/* Extrema of the taps elements in[i], in[i + step], ..., for i < len, with the same element layout as
+ * mve_imlib_midpoint_vertical(). */
+void mve_imlib_midpoint_horizontal(int bpp, const uint8_t *v_min, const uint8_t *v_max, int len, int step, int taps,
+                                   uint8_t *h_min, uint8_t *h_max)
+{
+  if (bpp == IMAGE_BPP_RGB565) {
+    const uint16_t *in_min = (const uint16_t *) v_min;
+    const uint16_t *in_max = (const uint16_t *) v_max;
+    uint16x8_t u16x8_rMask = vdupq_n_u16(0xF800);
+    uint16x8_t u16x8_gMask = vdupq_n_u16(0x07E0);
+    uint16x8_t u16x8_bMask = vdupq_n_u16(0x001F);
+
+    for (int i = 0; i < len; i += 8) {
+      mve_pred16_t p = vctp16q(len - i);
+      uint16x8_t u16x8_lo = vldrhq_z_u16(in_min + i, p);
+      uint16x8_t u16x8_hi = vldrhq_z_u16(in_max + i, p);
+      uint16x8_t u16x8_rMin = vandq_u16(u16x8_lo, u16x8_rMask);
+      uint16x8_t u16x8_gMin = vandq_u16(u16x8_lo, u16x8_gMask);
+      uint16x8_t u16x8_bMin = vandq_u16(u16x8_lo, u16x8_bMask);
+      uint16x8_t u16x8_rMax = vandq_u16(u16x8_hi, u16x8_rMask);
+      uint16x8_t u16x8_gMax = vandq_u16(u16x8_hi, u16x8_gMask);
+      uint16x8_t u16x8_bMax = vandq_u16(u16x8_hi, u16x8_bMask);
+
+      for (int t = 1; t < taps; t++) {
+        u16x8_lo = vldrhq_z_u16(in_min + i + (t * step), p);
+        u16x8_hi = vldrhq_z_u16(in_max + i + (t * step), p);
+        u16x8_rMin = vminq_u16(u16x8_rMin, vandq_u16(u16x8_lo, u16x8_rMask));
+        u16x8_gMin = vminq_u16(u16x8_gMin, vandq_u16(u16x8_lo, u16x8_gMask));
+        u16x8_bMin = vminq_u16(u16x8_bMin, vandq_u16(u16x8_lo, u16x8_bMask));
+        u16x8_rMax = vmaxq_u16(u16x8_rMax, vandq_u16(u16x8_hi, u16x8_rMask));
+        u16x8_gMax = vmaxq_u16(u16x8_gMax, vandq_u16(u16x8_hi, u16x8_gMask));
+        u16x8_bMax = vmaxq_u16(u16x8_bMax, vandq_u16(u16x8_hi, u16x8_bMask));
+      }
+
+      vstrhq_p_u16((uint16_t *) h_min + i, vorrq_u16(vorrq_u16(u16x8_rMin, u16x8_gMin), u16x8_bMin), p);
+      vstrhq_p_u16((uint16_t *) h_max + i, vorrq_u16(vorrq_u16(u16x8_rMax, u16x8_gMax), u16x8_bMax), p);
+    }
+  } else {
+    for (int i = 0; i < len; i += 16) {
+      mve_pred16_t p = vctp8q(len - i);
+      uint8x16_t u8x16_min = vldrbq_z_u8(v_min + i, p);
+      uint8x16_t u8x16_max = vldrbq_z_u8(v_max + i, p);
+
+      for (int t = 1; t < taps; t++) {
+        u8x16_min = vminq_u8(u8x16_min, vldrbq_z_u8(v_min + i + (t * step), p));
+        u8x16_max = vmaxq_u8(u8x16_max, vldrbq_z_u8(v_max + i + (t * step), p));
+      }
+
+      vstrbq_p_u8(h_min + i, u8x16_min, p);
+      vstrbq_p_u8(h_max + i, u8x16_max, p);
+    }
+  }
+}
+
+/* Maps a line through the look-up tables of the upper (lut_u) and lower (lut_b) rows of tiles: the four
+   look-ups are byte gathers at the tile offset plus the pixel value, the horizontal weights are Q7 and the
+   vertical blend is a rounding Q15 doubling multiply, so the result matches the scalar path bit for bit. */
+void mve_imlib_clahe_row(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *lut_u, const uint8_t *lut_b,
+                         const uint16_t *off_l, const uint16_t *off_r, const uint16_t *wx, uint16_t wy)
+{
+  int16_t wy_q15 = (int16_t)(wy << 8);
+
+  for (uint32_t i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_px = vldrbq_z_u16(src + i, p);
+    uint16x8_t u16x8_ol = vaddq_u16(vldrhq_z_u16(off_l + i, p), u16x8_px);
+    uint16x8_t u16x8_or = vaddq_u16(vldrhq_z_u16(off_r + i, p), u16x8_px);
+    uint16x8_t u16x8_wr = vldrhq_z_u16(wx + i, p);
+    uint16x8_t u16x8_wl = vsubq_u16(vdupq_n_u16(128), u16x8_wr);
+
+    uint16x8_t u16x8_top = vaddq_u16(vmulq_u16(vldrbq_gather_offset_z_u16(lut_u, u16x8_ol, p), u16x8_wl),
+                                     vmulq_u16(vldrbq_gather_offset_z_u16(lut_u, u16x8_or, p), u16x8_wr));
+    uint16x8_t u16x8_bot = vaddq_u16(vmulq_u16(vldrbq_gather_offset_z_u16(lut_b, u16x8_ol, p), u16x8_wl),
+                                     vmulq_u16(vldrbq_gather_offset_z_u16(lut_b, u16x8_or, p), u16x8_wr));
+
+    int16x8_t s16x8_top = vreinterpretq_s16_u16(u16x8_top);
+    int16x8_t s16x8_diff = vsubq_s16(vreinterpretq_s16_u16(u16x8_bot), s16x8_top);
+    int16x8_t s16x8_out = vrshrq_n_s16(vaddq_s16(s16x8_top, vqrdmulhq_n_s16(s16x8_diff, wy_q15)), 7);
+
+    vstrbq_p_u16(dst + i, vreinterpretq_u16_s16(s16x8_out), p);
+  }
+}
+
+/* Maps n bytes through a 256-entry table, 16 byte gathers at a time. */
+void mve_imlib_lut_u8(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *lut)
+{
+  for (uint32_t i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    vstrbq_p_u8(dst + i, vldrbq_gather_offset_z_u8(lut, vldrbq_z_u8(src + i, p), p), p);
+  }
+}
+
+/* Maps n RGB565 pixels through the tables of the three channels, indexed by the 5/6/5-bit channel values. */
+void mve_imlib_lut_rgb565(const uint16_t *src, uint16_t *dst, uint32_t n, const uint8_t *r_lut, const uint8_t *g_lut,
+                          const uint8_t *b_lut)
+{
+  for (uint32_t i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_px = vldrhq_z_u16(src + i, p);
+    uint16x8_t u16x8_r = vldrbq_gather_offset_z_u16(r_lut, vshrq_n_u16(u16x8_px, 11), p);
+    uint16x8_t u16x8_g = vldrbq_gather_offset_z_u16(g_lut, vandq_u16(vshrq_n_u16(u16x8_px, 5), vdupq_n_u16(0x3F)), p);
+    uint16x8_t u16x8_b = vldrbq_gather_offset_z_u16(b_lut, vandq_u16(u16x8_px, vdupq_n_u16(0x1F)), p);
+
+    vstrhq_p_u16(dst + i, vorrq_u16(vorrq_u16(vshlq_n_u16(u16x8_r, 11), vshlq_n_u16(u16x8_g, 5)), u16x8_b), p);
+  }
+}
+
+/* Table offsets of 8 consecutive bytes of RGB888 pixels (stored as b, g, r), starting at each of the 3 phases;
+   the tables are red, green and blue, 256 entries each. */
+static const uint16_t mve_lut_rgb888_offsets[3][8] = {
+  { 512, 256, 0, 512, 256, 0, 512, 256 },
+  { 256, 0, 512, 256, 0, 512, 256, 0 },
+  { 0, 512, 256, 0, 512, 256, 0, 512 }
+};
+
+/* Maps n RGB888 pixels through the tables of the three channels, 8 byte gathers at a time. */
+void mve_imlib_lut_rgb888(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *luts)
+{
+  uint32_t len = n * 3;
+
+  for (uint32_t i = 0, phase = 0; i < len; i += 8, phase = (phase + 2) % 3) {
+    mve_pred16_t p = vctp16q(len - i);
+    uint16x8_t u16x8_off = vaddq_u16(vldrbq_z_u16(src + i, p), vld1q_u16(mve_lut_rgb888_offsets[phase]));
+    vstrbq_p_u16(dst + i, vldrbq_gather_offset_z_u16(luts, u16x8_off, p), p);
+  }
+}
 #endif /* IPL_FILTER_HAS_MVE */
@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file    mve_flow.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library optical flow functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_FLOW_HAS_MVE
+#include "mve_flow.h"
+
+/* Sums of the products of the derivatives of the n window pixels (structure tensor): 8 pixels at a time,
+ * multiplied and accumulated into 64-bit scalars by the dual multiply-accumulate long instruction. */
+void mve_lk_gradient_matrix(const int16_t *ix, const int16_t *iy, int n, int64_t *gxx, int64_t *gxy, int64_t *gyy)
+{
+  int64_t xx = 0;
+  int64_t xy = 0;
+  int64_t yy = 0;
+
+  for (int k = 0; k < n; k += 8) {
+    mve_pred16_t p = vctp16q(n - k);
+    int16x8_t dx = vldrhq_z_s16(ix + k, p);
+    int16x8_t dy = vldrhq_z_s16(iy + k, p);
+
+    xx = vmlaldavaq_s16(xx, dx, dx);
+    xy = vmlaldavaq_s16(xy, dx, dy);
+    yy = vmlaldavaq_s16(yy, dy, dy);
+  }
+
+  *gxx = xx;
+  *gxy = xy;
+  *gyy = yy;
+}
+
+/* Sums of the products of the difference between the two windows (j - i) and the derivatives of i, for the
+ * n window pixels, 8 pixels at a time. */
+void mve_lk_mismatch(const int16_t *i, const int16_t *j, const int16_t *ix, const int16_t *iy, int n, int64_t *bx,
+                     int64_t *by)
+{
+  int64_t sx = 0;
+  int64_t sy = 0;
+
+  for (int k = 0; k < n; k += 8) {
+    mve_pred16_t p = vctp16q(n - k);
+    int16x8_t d = vsubq_s16(vldrhq_z_s16(j + k, p), vldrhq_z_s16(i + k, p));
+
+    sx = vmlaldavaq_s16(sx, d, vldrhq_z_s16(ix + k, p));
+    sy = vmlaldavaq_s16(sy, d, vldrhq_z_s16(iy + k, p));
+  }
+
+  *bx = sx;
+  *by = sy;
+}
+
+#endif /* IPL_FLOW_HAS_MVE */
@@ -0,0 +1,176 @@
+/**
+ ******************************************************************************
+ * @file    mve_fmath.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library fast math array functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_FMATH_HAS_MVE
+#include "mve_fmath.h"
+
+/* The arrays are processed four elements at a time, one per 32-bit lane; the last vector is predicated. Each
+ * function evaluates the same approximation of its scalar counterpart of fmath.c. MVE has no divide, square root
+ * or reciprocal estimate instructions: divisions and square roots are computed with Newton-Raphson iterations
+ * started from an estimate obtained from the bits of the operand, so the results may differ from the scalar ones
+ * in the last bits; the bit manipulations of fast_expf() and fast_powf() give the same results. */
+
+#define MVE_FMATH_PI    3.14159265f
+#define MVE_FMATH_PI_2  1.57079632f
+#define MVE_FMATH_PI_4  0.78539816f
+
+/* Reciprocal of the four lanes; the initial estimate has a relative error below 12%, which three iterations of
+ * r = r * (2 - d * r) reduce below the float precision. */
+static inline float32x4_t mve_fmath_recip(float32x4_t d)
+{
+  float32x4_t r = vreinterpretq_f32_s32(vsubq_s32(vdupq_n_s32(0x7EF311C3), vreinterpretq_s32_f32(d)));
+
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(2.0f), d, r));
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(2.0f), d, r));
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(2.0f), d, r));
+
+  return r;
+}
+
+/* Square root of the four (non negative) lanes: the reciprocal square root is refined with three iterations of
+ * r = r * (1.5 - x / 2 * r * r), then the root x * r is corrected with one Heron step on the residual x - s * s,
+ * which is exact with the fused multiply-subtract, so that the roots of perfect squares are exact. */
+static inline float32x4_t mve_fmath_sqrt(float32x4_t x)
+{
+  float32x4_t h = vmulq_n_f32(x, 0.5f);
+  float32x4_t r = vreinterpretq_f32_s32(vsubq_s32(vdupq_n_s32(0x5F3759DF), vshrq_n_s32(vreinterpretq_s32_f32(x), 1)));
+  float32x4_t s;
+
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(1.5f), h, vmulq_f32(r, r)));
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(1.5f), h, vmulq_f32(r, r)));
+  r = vmulq_f32(r, vfmsq_f32(vdupq_n_f32(1.5f), h, vmulq_f32(r, r)));
+
+  s = vmulq_f32(x, r);
+  s = vfmaq_f32(s, vfmsq_f32(x, s, s), vmulq_n_f32(r, 0.5f));
+
+  return vpselq_f32(vdupq_n_f32(0.0f), s, vcmpeqq_n_f32(x, 0.0f));
+}
+
+/* Arc tangent of min(|x|, |y|) / max(|x|, |y|), in [0, PI/4], with the polynomial and the tan(PI/8) range
+ * reduction of fast_atanf(); the angle is reflected around PI/4 when |y| > |x|. The quadrants follow
+ * fast_atan2f(): the result is in [0, 2 * PI), and +/-PI (or 0) when x is 0. */
+static inline float32x4_t mve_fmath_atan2(float32x4_t y, float32x4_t x)
+{
+  float32x4_t ax = vabsq_f32(x);
+  float32x4_t ay = vabsq_f32(y);
+  float32x4_t t = vmulq_f32(vminnmq_f32(ax, ay), mve_fmath_recip(vmaxnmq_f32(ax, ay)));
+  mve_pred16_t p_red = vcmpgtq_n_f32(t, 0.4142135623730950f);
+  float32x4_t a = vpselq_f32(vdupq_n_f32(MVE_FMATH_PI_4), vdupq_n_f32(0.0f), p_red);
+  float32x4_t z;
+
+  t = vpselq_f32(vmulq_f32(vsubq_f32(t, vdupq_n_f32(1.0f)), mve_fmath_recip(vaddq_n_f32(t, 1.0f))), t, p_red);
+  z = vmulq_f32(t, t);
+  z = vmulq_f32(vsubq_f32(vmulq_f32(vaddq_n_f32(vmulq_f32(vsubq_f32(vmulq_n_f32(z, 8.05374449538e-2f),
+                                                                  vdupq_n_f32(1.38776856032E-1f)), z),
+                                                     1.99777106478E-1f), z),
+                                    vdupq_n_f32(3.33329491539E-1f)), z);
+  a = vaddq_f32(a, vaddq_f32(vmulq_f32(z, t), t));
+  a = vpselq_f32(vsubq_f32(vdupq_n_f32(MVE_FMATH_PI_2), a), a, vcmpgtq_f32(ay, ax));
+
+  /* Quadrants. */
+  mve_pred16_t p_yneg = vcmpltq_n_f32(y, 0.0f);
+  float32x4_t r_xneg = vpselq_f32(vaddq_n_f32(a, MVE_FMATH_PI), vsubq_f32(vdupq_n_f32(MVE_FMATH_PI), a), p_yneg);
+  float32x4_t r_xpos = vpselq_f32(vsubq_f32(vdupq_n_f32(2 * MVE_FMATH_PI), a), a, p_yneg);
+  float32x4_t r = vpselq_f32(r_xneg, r_xpos, vcmpltq_n_f32(x, 0.0f));
+  float32x4_t r_x0 = vpselq_f32(vdupq_n_f32(-MVE_FMATH_PI), vdupq_n_f32(MVE_FMATH_PI), p_yneg);
+
+  r_x0 = vpselq_f32(vdupq_n_f32(0.0f), r_x0, vcmpeqq_n_f32(y, 0.0f));
+
+  return vpselq_f32(r_x0, r, vcmpeqq_n_f32(x, 0.0f));
+}
+
+/* fast_expf(): the exponent field of the double precision approximation is rebased to single precision. */
+static inline float32x4_t mve_fmath_exp(float32x4_t x)
+{
+  uint32x4_t l = vcvtq_u32_f32(vaddq_n_f32(vmulq_n_f32(x, 1512775.0f), 1072632447.0f));
+  uint32x4_t m = vandq_u32(l, vdupq_n_u32(0xFFFFF));
+  uint32x4_t e = vandq_u32(vsubq_u32(vshrq_n_u32(l, 20), vdupq_n_u32(1023 - 127)), vdupq_n_u32(0xFF));
+  uint32x4_t s = vshrq_n_u32(l, 31);
+
+  return vreinterpretq_f32_u32(vorrq_u32(vorrq_u32(vshlq_n_u32(s, 31), vshlq_n_u32(e, 23)), vshlq_n_u32(m, 3)));
+}
+
+/* fast_log2(): the exponent and the mantissa are taken from the bits of the operand. */
+static inline float32x4_t mve_fmath_log2(float32x4_t x)
+{
+  uint32x4_t i = vreinterpretq_u32_f32(x);
+  float32x4_t mx = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(i, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3f000000)));
+  float32x4_t y = vmulq_n_f32(vcvtq_f32_u32(i), 1.1920928955078125e-7f);
+
+  y = vsubq_f32(vsubq_f32(y, vdupq_n_f32(124.22551499f)), vmulq_n_f32(mx, 1.498030302f));
+
+  return vsubq_f32(y, vmulq_n_f32(mve_fmath_recip(vaddq_n_f32(mx, 0.3520887068f)), 1.72587999f));
+}
+
+/* fast_powf(): the bits of the base are scaled by the exponent. */
+static inline float32x4_t mve_fmath_pow(float32x4_t a, float b)
+{
+  float32x4_t f = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_f32(a), vdupq_n_s32(1064866805)));
+
+  return vreinterpretq_f32_s32(vcvtq_s32_f32(vaddq_n_f32(vmulq_n_f32(f, b), 1064866805.0f)));
+}
+
+void mve_fmath_sqrtf_vec(const float *x, float *r, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    vstrwq_p_f32(r + i, mve_fmath_sqrt(vldrwq_z_f32(x + i, p)), p);
+  }
+}
+
+void mve_fmath_atan2f_vec(const float *y, const float *x, float *r, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    vstrwq_p_f32(r + i, mve_fmath_atan2(vldrwq_z_f32(y + i, p), vldrwq_z_f32(x + i, p)), p);
+  }
+}
+
+void mve_fmath_expf_vec(const float *x, float *r, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    vstrwq_p_f32(r + i, mve_fmath_exp(vldrwq_z_f32(x + i, p)), p);
+  }
+}
+
+void mve_fmath_log2_vec(const float *x, float *r, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    vstrwq_p_f32(r + i, mve_fmath_log2(vldrwq_z_f32(x + i, p)), p);
+  }
+}
+
+void mve_fmath_powf_vec(const float *a, float b, float *r, size_t n)
+{
+  for (size_t i = 0; i < n; i += 4) {
+    mve_pred16_t p = vctp32q(n - i);
+
+    vstrwq_p_f32(r + i, mve_fmath_pow(vldrwq_z_f32(a + i, p), b), p);
+  }
+}
+
+#endif /* IPL_FMATH_HAS_MVE */
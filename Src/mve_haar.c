@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file    mve_haar.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library Haar cascade functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_HAAR_HAS_MVE
+#include "mve_haar.h"
+
+/* Runs the cascade on MVE_HAAR_WINDOWS windows in lockstep, lane k evaluating the window at x + k * step of the
+ * current integral image rows, normalized by std[k]. The cascade parameters are the same for all the windows, so
+ * they are read once and broadcast to the lanes, while the four corners of each rectangle are gathered from the
+ * integral image at the offsets of the windows. active holds the lanes to evaluate; the lanes whose stage sum falls
+ * below the stage threshold are removed from it, so that their lookups are no longer performed, and the evaluation
+ * ends as soon as no lane is left. Returns the lanes that passed all the stages. */
+mve_pred16_t mve_haar_run_cascade(cascade_t *cascade, int x, int step, const int32_t *std, mve_pred16_t active)
+{
+  uint32_t **rows = cascade->sum->data;
+  uint32x4_t u32x4_offset = vmulq_n_u32(vidupq_n_u32(0, 1), step);
+  int32x4_t s32x4_std = vld1q_s32(std);
+  int t_idx = 0;
+  int r_idx = 0;
+
+  for (int i = 0; i < cascade->n_stages; i++) {
+    int32x4_t s32x4_stage_sum = vdupq_n_s32(0);
+    /* stage_sum < threshold in float is stage_sum < ceil(threshold) in integer; the thresholds are mostly negative, so
+     * the ceiling is computed from the truncation instead of fast_ceilf(). */
+    float thresh = cascade->threshold * cascade->stages_thresh_array[i];
+    int32_t stage_thresh = (int32_t) thresh;
+    stage_thresh += (stage_thresh < thresh) ? 1 : 0;
+
+    for (int j = 0; j < cascade->stages_array[i]; j++, t_idx++) {
+      int32x4_t s32x4_sumw = vdupq_n_s32(0);
+      int n = cascade->num_rectangles_array[t_idx];
+
+      for (int k = 0; k < n; k++, r_idx++) {
+        const int8_t *r = cascade->rectangles_array + (r_idx << 2);
+        const uint32_t *top = rows[r[1]] + x + r[0];
+        const uint32_t *bottom = rows[r[1] + r[3]] + x + r[0];
+        uint32x4_t u32x4_sum = vldrwq_gather_shifted_offset_z_u32(bottom + r[2], u32x4_offset, active);
+        u32x4_sum = vaddq_u32(u32x4_sum, vldrwq_gather_shifted_offset_z_u32(top, u32x4_offset, active));
+        u32x4_sum = vsubq_u32(u32x4_sum, vldrwq_gather_shifted_offset_z_u32(top + r[2], u32x4_offset, active));
+        u32x4_sum = vsubq_u32(u32x4_sum, vldrwq_gather_shifted_offset_z_u32(bottom, u32x4_offset, active));
+        s32x4_sumw = vmlaq_n_s32(s32x4_sumw, vreinterpretq_s32_u32(u32x4_sum),
+                                 cascade->weights_array[r_idx] * (1 << 12));
+      }
+
+      /* The node threshold is multiplied by the standard deviation of each window. */
+      int32x4_t s32x4_thresh = vmulq_n_s32(s32x4_std, cascade->tree_thresh_array[t_idx]);
+      mve_pred16_t p = vcmpgeq_s32(s32x4_sumw, s32x4_thresh);
+      s32x4_stage_sum = vaddq_s32(s32x4_stage_sum, vpselq_s32(vdupq_n_s32(cascade->alpha2_array[t_idx]),
+                                                              vdupq_n_s32(cascade->alpha1_array[t_idx]), p));
+    }
+
+    active = vcmpgeq_m_n_s32(s32x4_stage_sum, stage_thresh, active);
+    if (!active) {
+      break;
+    }
+  }
+
+  return active;
+}
+#endif /* IPL_HAAR_HAS_MVE */
@@ -25,17 +25,13 @@
 
 static inline mve_pred16_t mve_image_get_mask_pixel_binary(image_t *ptr, int x, int y)
 {
-  mve_pred16_t pred = vctp8q(ptr->w - x);
-  if ((x&~0x1F) == 0) {
-    pred &= (mve_pred16_t)(*(uint32_t *)IMAGE_GET_BINARY_PIXEL_ADDR(ptr, x, y) & 0xFFFF);
-  } else if ((x&~0xF) == 0) {
-    pred &= (mve_pred16_t)(*(uint32_t *)IMAGE_GET_BINARY_PIXEL_ADDR(ptr, x, y) & 0xFFFF);
-  } else {
-    for (int i = x; i < IM_MIN(x + 16, ptr->w); i++) {
-      pred &= IMAGE_GET_BINARY_PIXEL(ptr, i, y) << i;
-    }
+  /* The mask is already packed: the 16 lanes starting at x are taken from the mask words holding them. */
+  int offset = x & UINT32_T_MASK;
+  uint32_t word = image_get_mask_word(ptr, x - offset, y) >> offset;
+  if (offset > 16) {
+    word |= image_get_mask_word(ptr, x - offset + UINT32_T_BITS, y) << (UINT32_T_BITS - offset);
   }
-  return pred;
+  return (mve_pred16_t)(word & 0xFFFF);
 }
 
 static inline mve_pred16_t mve_image_get_mask_pixel_grayscale(image_t *ptr, int x, int y)
@@ -132,4 +128,41 @@ mve_pred16_t mve_image_get_mask_pixel(image_t *ptr, int x, int y)
   }
     return pred;
 }
+
+/* ceil(2^32 / d) for d in [2, 255], used to divide 16-bit numerators exactly with vmulhq_u32.
+   Entries 0 and 1 are 0: the callers handle those divisors. */
+const uint32_t mve_imlib_reciprocal_u32[256] = {
+  0x00000000U, 0x00000000U, 0x80000000U, 0x55555556U, 0x40000000U, 0x33333334U, 0x2AAAAAABU, 0x24924925U,
+  0x20000000U, 0x1C71C71DU, 0x1999999AU, 0x1745D175U, 0x15555556U, 0x13B13B14U, 0x12492493U, 0x11111112U,
+  0x10000000U, 0x0F0F0F10U, 0x0E38E38FU, 0x0D79435FU, 0x0CCCCCCDU, 0x0C30C30DU, 0x0BA2E8BBU, 0x0B21642DU,
+  0x0AAAAAABU, 0x0A3D70A4U, 0x09D89D8AU, 0x097B425FU, 0x0924924AU, 0x08D3DCB1U, 0x08888889U, 0x08421085U,
+  0x08000000U, 0x07C1F07DU, 0x07878788U, 0x07507508U, 0x071C71C8U, 0x06EB3E46U, 0x06BCA1B0U, 0x06906907U,
+  0x06666667U, 0x063E7064U, 0x06186187U, 0x05F417D1U, 0x05D1745EU, 0x05B05B06U, 0x0590B217U, 0x0572620BU,
+  0x05555556U, 0x0539782AU, 0x051EB852U, 0x05050506U, 0x04EC4EC5U, 0x04D4873FU, 0x04BDA130U, 0x04A7904BU,
+  0x04924925U, 0x047DC120U, 0x0469EE59U, 0x0456C798U, 0x04444445U, 0x04325C54U, 0x04210843U, 0x04104105U,
+  0x04000000U, 0x03F03F04U, 0x03E0F83FU, 0x03D22636U, 0x03C3C3C4U, 0x03B5CC0FU, 0x03A83A84U, 0x039B0AD2U,
+  0x038E38E4U, 0x0381C0E1U, 0x03759F23U, 0x0369D037U, 0x035E50D8U, 0x03531DEDU, 0x03483484U, 0x033D91D3U,
+  0x03333334U, 0x03291620U, 0x031F3832U, 0x03159722U, 0x030C30C4U, 0x03030304U, 0x02FA0BE9U, 0x02F14991U,
+  0x02E8BA2FU, 0x02E05C0CU, 0x02D82D83U, 0x02D02D03U, 0x02C8590CU, 0x02C0B02DU, 0x02B93106U, 0x02B1DA47U,
+  0x02AAAAABU, 0x02A3A0FEU, 0x029CBC15U, 0x0295FAD5U, 0x028F5C29U, 0x0288DF0DU, 0x02828283U, 0x027C4598U,
+  0x02762763U, 0x02702703U, 0x026A43A0U, 0x02647C6AU, 0x025ED098U, 0x02593F6AU, 0x0253C826U, 0x024E6A18U,
+  0x02492493U, 0x0243F6F1U, 0x023EE090U, 0x0239E0D6U, 0x0234F72DU, 0x02302303U, 0x022B63CCU, 0x0226B903U,
+  0x02222223U, 0x021D9EAEU, 0x02192E2AU, 0x0214D022U, 0x02108422U, 0x020C49BBU, 0x02082083U, 0x02040811U,
+  0x02000000U, 0x01FC07F1U, 0x01F81F82U, 0x01F4465AU, 0x01F07C20U, 0x01ECC07CU, 0x01E9131BU, 0x01E573ADU,
+  0x01E1E1E2U, 0x01DE5D6FU, 0x01DAE608U, 0x01D77B66U, 0x01D41D42U, 0x01D0CB59U, 0x01CD8569U, 0x01CA4B31U,
+  0x01C71C72U, 0x01C3F8F1U, 0x01C0E071U, 0x01BDD2B9U, 0x01BACF92U, 0x01B7D6C4U, 0x01B4E81CU, 0x01B20365U,
+  0x01AF286CU, 0x01AC5702U, 0x01A98EF7U, 0x01A6D01BU, 0x01A41A42U, 0x01A16D40U, 0x019EC8EAU, 0x019C2D15U,
+  0x0199999AU, 0x01970E50U, 0x01948B10U, 0x01920FB5U, 0x018F9C19U, 0x018D3019U, 0x018ACB91U, 0x01886E60U,
+  0x01861862U, 0x0183C978U, 0x01818182U, 0x017F4060U, 0x017D05F5U, 0x017AD221U, 0x0178A4C9U, 0x01767DCFU,
+  0x01745D18U, 0x01724288U, 0x01702E06U, 0x016E1F77U, 0x016C16C2U, 0x016A13CEU, 0x01681682U, 0x01661EC7U,
+  0x01642C86U, 0x01623FA8U, 0x01605817U, 0x015E75BCU, 0x015C9883U, 0x015AC057U, 0x0158ED24U, 0x01571ED4U,
+  0x01555556U, 0x01539095U, 0x0151D07FU, 0x01501502U, 0x014E5E0BU, 0x014CAB89U, 0x014AFD6BU, 0x0149539FU,
+  0x0147AE15U, 0x01460CBDU, 0x01446F87U, 0x0142D663U, 0x01414142U, 0x013FB014U, 0x013E22CCU, 0x013C995BU,
+  0x013B13B2U, 0x013991C3U, 0x01381382U, 0x013698E0U, 0x013521D0U, 0x0133AE46U, 0x01323E35U, 0x0130D191U,
+  0x012F684CU, 0x012E025DU, 0x012C9FB5U, 0x012B404BU, 0x0129E413U, 0x01288B02U, 0x0127350CU, 0x0125E228U,
+  0x0124924AU, 0x01234568U, 0x0121FB79U, 0x0120B471U, 0x011F7048U, 0x011E2EF4U, 0x011CF06BU, 0x011BB4A5U,
+  0x011A7B97U, 0x01194539U, 0x01181182U, 0x0116E069U, 0x0115B1E6U, 0x011485F1U, 0x01135C82U, 0x0112358FU,
+  0x01111112U, 0x010FEF02U, 0x010ECF57U, 0x010DB20BU, 0x010C9715U, 0x010B7E6FU, 0x010A6811U, 0x010953F4U,
+  0x01084211U, 0x01073261U, 0x010624DEU, 0x01051980U, 0x01041042U, 0x0103091CU, 0x01020409U, 0x01010102U
+};
 #endif /* IPL_IMLIB_HAS_MVE */
\ No newline at end of file
@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @file    mve_integral.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library integral image functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_INTEGRAL_HAS_MVE
+#include "mve_integral.h"
+
+/* The row kernels compute one row of an integral image: the prefix sum of the (squared) pixels of the row, plus
+ * the row above when there is one (above is NULL for the first row). Pixel x of the row is read at
+ * src[(x * x_ratio) >> 16], so that the scaled and moving window integral images sample the source row with a
+ * gather load; x_ratio equal to 1 << 16 reads the row with contiguous loads. */
+
+/* Loads 4 pixels of the row, widened to 32 bits; the lanes out of the predicate are zero. */
+static inline uint32x4_t mve_integral_load(const uint8_t *src, int x, int x_ratio, mve_pred16_t p)
+{
+  if (x_ratio == (1 << 16)) {
+    return vldrbq_z_u32(src + x, p);
+  }
+
+  uint32x4_t u32x4_offs = vshrq_n_u32(vmulq_n_u32(vidupq_n_u32(x, 1), x_ratio), 16);
+  return vldrbq_gather_offset_z_u32(src, u32x4_offs, p);
+}
+
+/* Inclusive prefix sum of the 4 lanes in two log steps: the vector shifted up by one lane, then the result shifted
+ * up by two lanes, are added to it (vshlcq shifts the whole vector, zeros enter lane 0). The sum of the previous
+ * vectors of the row (carry) is then added to all the lanes. */
+static inline uint32x4_t mve_integral_scan(uint32x4_t u32x4_v, uint32_t carry)
+{
+  uint32_t in = 0;
+  u32x4_v = vaddq_u32(u32x4_v, vshlcq_u32(u32x4_v, &in, 32));
+
+  in = 0;
+  uint32x4_t u32x4_sh = vshlcq_u32(u32x4_v, &in, 32);
+  in = 0;
+  u32x4_sh = vshlcq_u32(u32x4_sh, &in, 32);
+
+  return vaddq_n_u32(vaddq_u32(u32x4_v, u32x4_sh), carry);
+}
+
+void mve_integral_row(const uint8_t *src, int x_ratio, const uint32_t *above, uint32_t *sum, int n)
+{
+  uint32_t carry = 0;
+
+  for (int x = 0; x < n; x += 4) {
+    mve_pred16_t p = vctp32q(n - x);
+    uint32x4_t u32x4_s = mve_integral_scan(mve_integral_load(src, x, x_ratio, p), carry);
+    carry = vgetq_lane_u32(u32x4_s, 3);
+
+    if (above) {
+      u32x4_s = vaddq_u32(u32x4_s, vldrwq_z_u32(above + x, p));
+    }
+    vstrwq_p_u32(sum + x, u32x4_s, p);
+  }
+}
+
+void mve_integral_row_sq(const uint8_t *src, int x_ratio, const uint32_t *above, uint32_t *ssq, int n)
+{
+  uint32_t carry = 0;
+
+  for (int x = 0; x < n; x += 4) {
+    mve_pred16_t p = vctp32q(n - x);
+    uint32x4_t u32x4_v = mve_integral_load(src, x, x_ratio, p);
+    uint32x4_t u32x4_sq = mve_integral_scan(vmulq_u32(u32x4_v, u32x4_v), carry);
+    carry = vgetq_lane_u32(u32x4_sq, 3);
+
+    if (above) {
+      u32x4_sq = vaddq_u32(u32x4_sq, vldrwq_z_u32(above + x, p));
+    }
+    vstrwq_p_u32(ssq + x, u32x4_sq, p);
+  }
+}
+
+/* Sum and squared sum rows in a single read of the source row. */
+void mve_integral_row_ss(const uint8_t *src, int x_ratio, const uint32_t *sum_above, const uint32_t *ssq_above,
+                         uint32_t *sum, uint32_t *ssq, int n)
+{
+  uint32_t carry_s = 0;
+  uint32_t carry_sq = 0;
+
+  for (int x = 0; x < n; x += 4) {
+    mve_pred16_t p = vctp32q(n - x);
+    uint32x4_t u32x4_v = mve_integral_load(src, x, x_ratio, p);
+    uint32x4_t u32x4_s = mve_integral_scan(u32x4_v, carry_s);
+    uint32x4_t u32x4_sq = mve_integral_scan(vmulq_u32(u32x4_v, u32x4_v), carry_sq);
+    carry_s = vgetq_lane_u32(u32x4_s, 3);
+    carry_sq = vgetq_lane_u32(u32x4_sq, 3);
+
+    if (sum_above) {
+      u32x4_s = vaddq_u32(u32x4_s, vldrwq_z_u32(sum_above + x, p));
+      u32x4_sq = vaddq_u32(u32x4_sq, vldrwq_z_u32(ssq_above + x, p));
+    }
+    vstrwq_p_u32(sum + x, u32x4_s, p);
+    vstrwq_p_u32(ssq + x, u32x4_sq, p);
+  }
+}
+#endif /* IPL_INTEGRAL_HAS_MVE */
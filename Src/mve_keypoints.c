@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @file    mve_keypoints.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library keypoint functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_KEYPOINTS_HAS_MVE
+#include "mve_keypoints.h"
+
+#define MVE_FAST_RING 16
+#define MVE_FAST_ARC  9
+
+/* Marks with 1 the FAST-9 corners among n consecutive pixels: each of the 16 ring positions is loaded for 16
+ * pixels at once and compared with the center +/- threshold (saturated), then the length of the current run of
+ * brighter (darker) ring pixels is counted per lane over 16 + 8 positions, so that the runs wrap around. */
+void mve_fast_row(const uint8_t *src, const int32_t *ring, int n, uint8_t threshold, uint8_t *corner)
+{
+  const uint8x16_t zero = vdupq_n_u8(0);
+  const uint8x16_t one = vdupq_n_u8(1);
+
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    const uint8_t *c = src + i;
+    uint8x16_t center = vldrbq_z_u8(c, p);
+    uint8x16_t hi = vqaddq_u8(center, vdupq_n_u8(threshold));
+    uint8x16_t lo = vqsubq_u8(center, vdupq_n_u8(threshold));
+    uint8x16_t pix[MVE_FAST_RING];
+    mve_pred16_t b[4];
+    mve_pred16_t d[4];
+    mve_pred16_t maybe;
+    uint8x16_t cntB = zero;
+    uint8x16_t cntD = zero;
+    uint8x16_t maxB = zero;
+    uint8x16_t maxD = zero;
+
+    /* An arc of 9 contains two consecutive compass points (ring positions 0, 4, 8, 12). */
+    for (int k = 0; k < 4; k++) {
+      pix[k * 4] = vldrbq_z_u8(c + ring[k * 4], p);
+      b[k] = vcmphiq_u8(pix[k * 4], hi);
+      d[k] = vcmphiq_u8(lo, pix[k * 4]);
+    }
+
+    maybe = (b[0] & b[1]) | (b[1] & b[2]) | (b[2] & b[3]) | (b[3] & b[0]) |
+            (d[0] & d[1]) | (d[1] & d[2]) | (d[2] & d[3]) | (d[3] & d[0]);
+
+    if (!(maybe & p)) {
+      vstrbq_p_u8(corner + i, zero, p);
+      continue;
+    }
+
+    for (int k = 0; k < MVE_FAST_RING; k++)
+      if (k & 3)
+        pix[k] = vldrbq_z_u8(c + ring[k], p);
+
+    for (int k = 0; k < (MVE_FAST_RING + MVE_FAST_ARC - 1); k++) {
+      uint8x16_t v = pix[k % MVE_FAST_RING];
+
+      cntB = vpselq_u8(vaddq_u8(cntB, one), zero, vcmphiq_u8(v, hi));
+      cntD = vpselq_u8(vaddq_u8(cntD, one), zero, vcmphiq_u8(lo, v));
+      maxB = vmaxq_u8(maxB, cntB);
+      maxD = vmaxq_u8(maxD, cntD);
+    }
+
+    p &= vcmpcsq_n_u8(maxB, MVE_FAST_ARC) | vcmpcsq_n_u8(maxD, MVE_FAST_ARC);
+    vstrbq_p_u8(corner + i, vpselq_u8(one, zero, p), vctp8q(n - i));
+  }
+}
+
+/* Counts the bits that differ between two descriptors of n bytes. MVE has no population count instruction,
+ * so the bits of each byte are added in pairs, nibbles and bytes with shifts and masks. */
+uint32_t mve_hamming_distance(const uint8_t *a, const uint8_t *b, int n)
+{
+  uint32_t acc = 0;
+
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    uint8x16_t x = veorq_u8(vldrbq_z_u8(a + i, p), vldrbq_z_u8(b + i, p));
+
+    x = vsubq_u8(x, vandq_u8(vshrq_n_u8(x, 1), vdupq_n_u8(0x55)));
+    x = vaddq_u8(vandq_u8(x, vdupq_n_u8(0x33)), vandq_u8(vshrq_n_u8(x, 2), vdupq_n_u8(0x33)));
+    x = vandq_u8(vaddq_u8(x, vshrq_n_u8(x, 4)), vdupq_n_u8(0x0F));
+    acc = vaddvaq_u8(acc, x);
+  }
+
+  return acc;
+}
+
+#endif /* IPL_KEYPOINTS_HAS_MVE */
@@ -0,0 +1,383 @@
+/**
+ ******************************************************************************
+ * @file    mve_pool.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library pooling functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_POOL_HAS_MVE
+#include "mve_pool.h"
+
+/* Max number of pixels of a cell whose sums fit the 16-bit lanes (255 * 257 = 65535). */
+#define MVE_POOL_MAX_CELL   257
+
+/* Elements added to the line buffers, read beyond their end by the de-interleaving loads of the last cells. */
+#define MVE_POOL_PAD        64
+
+/* Adds the len bytes of row to the 16-bit column sums (or stores them, when first is true), 8 at a time. */
+static void mve_pool_sum_u8(const uint8_t *row, int len, bool first, uint16_t *sums)
+{
+  for (int k = 0; k < len; k += 8) {
+    mve_pred16_t p = vctp16q(len - k);
+    uint16x8_t v = vldrbq_z_u16(row + k, p);
+
+    if (!first) {
+      v = vaddq_u16(v, vldrhq_z_u16(sums + k, p));
+    }
+
+    vstrhq_p_u16(sums + k, v, p);
+  }
+}
+
+/* Adds the channels of the len RGB565 pixels of row to the 16-bit column sums of the r, g and b planes (or stores
+ * them, when first is true), 8 at a time. */
+static void mve_pool_sum_rgb565(const uint16_t *row, int len, bool first, uint16_t *r, uint16_t *g, uint16_t *b)
+{
+  for (int k = 0; k < len; k += 8) {
+    mve_pred16_t p = vctp16q(len - k);
+    uint16x8_t v = vldrhq_z_u16(row + k, p);
+    uint16x8_t vr = vshrq_n_u16(v, 11);
+    uint16x8_t vg = vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(0x3F));
+    uint16x8_t vb = vandq_u16(v, vdupq_n_u16(0x1F));
+
+    if (!first) {
+      vr = vaddq_u16(vr, vldrhq_z_u16(r + k, p));
+      vg = vaddq_u16(vg, vldrhq_z_u16(g + k, p));
+      vb = vaddq_u16(vb, vldrhq_z_u16(b + k, p));
+    }
+
+    vstrhq_p_u16(r + k, vr, p);
+    vstrhq_p_u16(g + k, vg, p);
+    vstrhq_p_u16(b + k, vb, p);
+  }
+}
+
+/* Sums of the x_div consecutive column sums of each of the n cells: 2 and 4 columns are added pairwise from the
+ * de-interleaving loads, the other widths are gathered. */
+static void mve_pool_hsum_u16(const uint16_t *in, int n, int x_div, uint16_t *out)
+{
+  if (x_div == 2) {
+    for (int i = 0; i < n; i += 8) {
+      uint16x8x2_t v = vld2q_u16(in + (i * 2));
+
+      vstrhq_p_u16(out + i, vaddq_u16(v.val[0], v.val[1]), vctp16q(n - i));
+    }
+  } else if (x_div == 4) {
+    for (int i = 0; i < n; i += 8) {
+      uint16x8x4_t v = vld4q_u16(in + (i * 4));
+
+      vstrhq_p_u16(out + i, vaddq_u16(vaddq_u16(v.val[0], v.val[1]), vaddq_u16(v.val[2], v.val[3])),
+                   vctp16q(n - i));
+    }
+  } else {
+    uint16x8_t offsets = vmulq_n_u16(vidupq_n_u16(0, 1), x_div);
+
+    for (int i = 0; i < n; i += 8) {
+      mve_pred16_t p = vctp16q(n - i);
+      const uint16_t *base = in + (i * x_div);
+      uint16x8_t acc = vldrhq_gather_shifted_offset_z_u16(base, offsets, p);
+
+      for (int j = 1; j < x_div; j++) {
+        acc = vaddq_u16(acc, vldrhq_gather_shifted_offset_z_u16(base + j, offsets, p));
+      }
+
+      vstrhq_p_u16(out + i, acc, p);
+    }
+  }
+}
+
+/* Divides the 8 sums by the cell size, rounding down as the integer division: a shift when the size is a power
+ * of 2 (shift >= 0), otherwise the high half of the product by recip = ceil(2^32 / size), that is exact for
+ * 16-bit sums. */
+static inline uint16x8_t mve_pool_div(uint16x8_t s, int shift, uint32_t recip)
+{
+  if (shift >= 0) {
+    return vshlq_r_u16(s, -shift);
+  }
+
+  uint32x4_t lo = vmulhq_u32(vmovlbq_u16(s), vdupq_n_u32(recip));
+  uint32x4_t hi = vmulhq_u32(vmovltq_u16(s), vdupq_n_u32(recip));
+
+  return vmovntq_u32(vmovnbq_u32(vdupq_n_u16(0), lo), hi);
+}
+
+/* Mean of the xDiv * yDiv cells of Grayscale and RGB565 images, as imlib_mean_pool(): the rows of each cell line
+ * are summed into 16-bit column sums, whose x_div consecutive values are then added and divided by the cell size.
+ * Returns -1 (nothing done) for the other formats, for cells bigger than MVE_POOL_MAX_CELL pixels and when the line
+ * buffers do not fit the fb stack. */
+int mve_imlib_mean_pool(image_t *img_i, image_t *img_o, int x_div, int y_div)
+{
+  int n = x_div * y_div;
+  int xx = img_i->w / x_div;
+  int yy = img_i->h / y_div;
+  int x0 = (img_i->w % x_div) / 2;
+  int y0 = (img_i->h % y_div) / 2;
+  int len = xx * x_div;
+  int planes = (img_i->bpp == IMAGE_BPP_RGB565) ? 3 : 1;
+  int plane_len = len + MVE_POOL_PAD;
+  int shift = -1;
+  uint32_t recip = 0;
+
+  if (((img_i->bpp != IMAGE_BPP_GRAYSCALE) && (img_i->bpp != IMAGE_BPP_RGB565)) || (n > MVE_POOL_MAX_CELL)) {
+    return -1;
+  }
+
+  if ((xx <= 0) || (yy <= 0)) {
+    return 0;
+  }
+
+  if (fb_avail() < (FB_ALLOC_SPACE(plane_len * planes * sizeof(uint16_t))
+                    + FB_ALLOC_SPACE(xx * planes * sizeof(uint16_t)))) {
+    return -1;
+  }
+
+  if ((n & (n - 1)) == 0) {
+    for (shift = 0; (1 << shift) < n; shift++) {
+    }
+  } else {
+    recip = (uint32_t)((0x100000000ULL + n - 1) / n);
+  }
+
+  uint16_t *sums = fb_alloc(plane_len * planes * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+  uint16_t *cells = fb_alloc(xx * planes * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+
+  for (int y = 0; y < yy; y++) {
+    for (int i = 0; i < y_div; i++) {
+      int row = y0 + (y * y_div) + i;
+
+      if (planes == 1) {
+        mve_pool_sum_u8(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img_i, row) + x0, len, i == 0, sums);
+      } else {
+        mve_pool_sum_rgb565(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img_i, row) + x0, len, i == 0, sums,
+                            sums + plane_len, sums + (plane_len * 2));
+      }
+    }
+
+    for (int c = 0; c < planes; c++) {
+      mve_pool_hsum_u16(sums + (c * plane_len), xx, x_div, cells + (c * xx));
+    }
+
+    if (planes == 1) {
+      uint8_t *out = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img_o, y);
+
+      for (int k = 0; k < xx; k += 8) {
+        mve_pred16_t p = vctp16q(xx - k);
+
+        vstrbq_p_u16(out + k, mve_pool_div(vldrhq_z_u16(cells + k, p), shift, recip), p);
+      }
+    } else {
+      uint16_t *out = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img_o, y);
+
+      for (int k = 0; k < xx; k += 8) {
+        mve_pred16_t p = vctp16q(xx - k);
+        uint16x8_t r = mve_pool_div(vldrhq_z_u16(cells + k, p), shift, recip);
+        uint16x8_t g = mve_pool_div(vldrhq_z_u16(cells + xx + k, p), shift, recip);
+        uint16x8_t b = mve_pool_div(vldrhq_z_u16(cells + (xx * 2) + k, p), shift, recip);
+
+        vstrhq_p_u16(out + k, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b), p);
+      }
+    }
+  }
+
+  fb_free();
+  fb_free();
+
+  return 0;
+}
+
+/* Column extrema of the len bytes of row, merged with vmin and vmax (or stored, when first is true), 16 at a
+ * time. */
+static void mve_pool_minmax_u8(const uint8_t *row, int len, bool first, uint8_t *vmin, uint8_t *vmax)
+{
+  for (int k = 0; k < len; k += 16) {
+    mve_pred16_t p = vctp8q(len - k);
+    uint8x16_t v = vldrbq_z_u8(row + k, p);
+    uint8x16_t lo = v;
+    uint8x16_t hi = v;
+
+    if (!first) {
+      lo = vminq_u8(lo, vldrbq_z_u8(vmin + k, p));
+      hi = vmaxq_u8(hi, vldrbq_z_u8(vmax + k, p));
+    }
+
+    vstrbq_p_u8(vmin + k, lo, p);
+    vstrbq_p_u8(vmax + k, hi, p);
+  }
+}
+
+/* Column extrema of the channels of the len RGB565 pixels of row, merged with the 8-bit planes vmin[c] and vmax[c]
+ * (or stored, when first is true), 8 at a time. */
+static void mve_pool_minmax_rgb565(const uint16_t *row, int len, bool first, uint8_t **vmin, uint8_t **vmax)
+{
+  for (int k = 0; k < len; k += 8) {
+    mve_pred16_t p = vctp16q(len - k);
+    uint16x8_t v = vldrhq_z_u16(row + k, p);
+    uint16x8_t ch[3];
+
+    ch[0] = vshrq_n_u16(v, 11);
+    ch[1] = vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(0x3F));
+    ch[2] = vandq_u16(v, vdupq_n_u16(0x1F));
+
+    for (int c = 0; c < 3; c++) {
+      uint16x8_t lo = ch[c];
+      uint16x8_t hi = ch[c];
+
+      if (!first) {
+        lo = vminq_u16(lo, vldrbq_z_u16(vmin[c] + k, p));
+        hi = vmaxq_u16(hi, vldrbq_z_u16(vmax[c] + k, p));
+      }
+
+      vstrbq_p_u16(vmin[c] + k, lo, p);
+      vstrbq_p_u16(vmax[c] + k, hi, p);
+    }
+  }
+}
+
+/* Extrema of the x_div consecutive column extrema of each of the n cells: 2 and 4 columns are reduced pairwise
+ * from the de-interleaving loads, 16 cells at a time, the other widths are gathered, 8 cells at a time. */
+static void mve_pool_hminmax_u8(const uint8_t *min_in, const uint8_t *max_in, int n, int x_div, uint8_t *min_out,
+                                uint8_t *max_out)
+{
+  if (x_div == 2) {
+    for (int i = 0; i < n; i += 16) {
+      mve_pred16_t p = vctp8q(n - i);
+      uint8x16x2_t lo = vld2q_u8(min_in + (i * 2));
+      uint8x16x2_t hi = vld2q_u8(max_in + (i * 2));
+
+      vstrbq_p_u8(min_out + i, vminq_u8(lo.val[0], lo.val[1]), p);
+      vstrbq_p_u8(max_out + i, vmaxq_u8(hi.val[0], hi.val[1]), p);
+    }
+  } else if (x_div == 4) {
+    for (int i = 0; i < n; i += 16) {
+      mve_pred16_t p = vctp8q(n - i);
+      uint8x16x4_t lo = vld4q_u8(min_in + (i * 4));
+      uint8x16x4_t hi = vld4q_u8(max_in + (i * 4));
+
+      vstrbq_p_u8(min_out + i, vminq_u8(vminq_u8(lo.val[0], lo.val[1]), vminq_u8(lo.val[2], lo.val[3])), p);
+      vstrbq_p_u8(max_out + i, vmaxq_u8(vmaxq_u8(hi.val[0], hi.val[1]), vmaxq_u8(hi.val[2], hi.val[3])), p);
+    }
+  } else {
+    uint16x8_t offsets = vmulq_n_u16(vidupq_n_u16(0, 1), x_div);
+
+    for (int i = 0; i < n; i += 8) {
+      mve_pred16_t p = vctp16q(n - i);
+      int base = i * x_div;
+      uint16x8_t lo = vldrbq_gather_offset_z_u16(min_in + base, offsets, p);
+      uint16x8_t hi = vldrbq_gather_offset_z_u16(max_in + base, offsets, p);
+
+      for (int j = 1; j < x_div; j++) {
+        lo = vminq_u16(lo, vldrbq_gather_offset_z_u16(min_in + base + j, offsets, p));
+        hi = vmaxq_u16(hi, vldrbq_gather_offset_z_u16(max_in + base + j, offsets, p));
+      }
+
+      vstrbq_p_u16(min_out + i, lo, p);
+      vstrbq_p_u16(max_out + i, hi, p);
+    }
+  }
+}
+
+/* (min * (256 - bias) + max * bias) >> 8 of 8 values, that fits the 16-bit lanes since bias <= 256. */
+static inline uint16x8_t mve_pool_blend(uint16x8_t lo, uint16x8_t hi, int bias)
+{
+  return vshrq_n_u16(vaddq_u16(vmulq_n_u16(lo, 256 - bias), vmulq_n_u16(hi, bias)), 8);
+}
+
+/* Midpoint of the xDiv * yDiv cells of Grayscale and RGB565 images, as imlib_midpoint_pool(): the rows of each cell
+ * line are reduced to 8-bit column extrema, whose x_div consecutive values are then reduced and blended by bias.
+ * Returns -1 (nothing done) for the other formats, for bias greater than 256, for cells too wide for the 16-bit
+ * gather offsets and when the line buffers do not fit the fb stack. */
+int mve_imlib_midpoint_pool(image_t *img_i, image_t *img_o, int x_div, int y_div, int bias)
+{
+  int xx = img_i->w / x_div;
+  int yy = img_i->h / y_div;
+  int x0 = (img_i->w % x_div) / 2;
+  int y0 = (img_i->h % y_div) / 2;
+  int len = xx * x_div;
+  int planes = (img_i->bpp == IMAGE_BPP_RGB565) ? 3 : 1;
+  int plane_len = len + MVE_POOL_PAD;
+  uint8_t *vmin[3];
+  uint8_t *vmax[3];
+  uint8_t *hmin[3];
+  uint8_t *hmax[3];
+
+  if (((img_i->bpp != IMAGE_BPP_GRAYSCALE) && (img_i->bpp != IMAGE_BPP_RGB565)) || (bias < 0) || (bias > 256)
+      || ((x_div * 7) > UINT16_MAX)) {
+    return -1;
+  }
+
+  if ((xx <= 0) || (yy <= 0)) {
+    return 0;
+  }
+
+  if (fb_avail() < (FB_ALLOC_SPACE(plane_len * planes * 2) + FB_ALLOC_SPACE(xx * planes * 2))) {
+    return -1;
+  }
+
+  uint8_t *lines = fb_alloc(plane_len * planes * 2, FB_ALLOC_PREFER_SPEED);
+  uint8_t *cells = fb_alloc(xx * planes * 2, FB_ALLOC_PREFER_SPEED);
+
+  for (int c = 0; c < planes; c++) {
+    vmin[c] = lines + (plane_len * c * 2);
+    vmax[c] = vmin[c] + plane_len;
+    hmin[c] = cells + (xx * c * 2);
+    hmax[c] = hmin[c] + xx;
+  }
+
+  for (int y = 0; y < yy; y++) {
+    for (int i = 0; i < y_div; i++) {
+      int row = y0 + (y * y_div) + i;
+
+      if (planes == 1) {
+        mve_pool_minmax_u8(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img_i, row) + x0, len, i == 0, vmin[0], vmax[0]);
+      } else {
+        mve_pool_minmax_rgb565(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img_i, row) + x0, len, i == 0, vmin, vmax);
+      }
+    }
+
+    for (int c = 0; c < planes; c++) {
+      mve_pool_hminmax_u8(vmin[c], vmax[c], xx, x_div, hmin[c], hmax[c]);
+    }
+
+    if (planes == 1) {
+      uint8_t *out = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img_o, y);
+
+      for (int k = 0; k < xx; k += 8) {
+        mve_pred16_t p = vctp16q(xx - k);
+
+        vstrbq_p_u16(out + k, mve_pool_blend(vldrbq_z_u16(hmin[0] + k, p), vldrbq_z_u16(hmax[0] + k, p), bias), p);
+      }
+    } else {
+      uint16_t *out = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img_o, y);
+
+      for (int k = 0; k < xx; k += 8) {
+        mve_pred16_t p = vctp16q(xx - k);
+        uint16x8_t r = mve_pool_blend(vldrbq_z_u16(hmin[0] + k, p), vldrbq_z_u16(hmax[0] + k, p), bias);
+        uint16x8_t g = mve_pool_blend(vldrbq_z_u16(hmin[1] + k, p), vldrbq_z_u16(hmax[1] + k, p), bias);
+        uint16x8_t b = mve_pool_blend(vldrbq_z_u16(hmin[2] + k, p), vldrbq_z_u16(hmax[2] + k, p), bias);
+
+        vstrhq_p_u16(out + k, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b), p);
+      }
+    }
+  }
+
+  fb_free();
+  fb_free();
+
+  return 0;
+}
+
+#endif /* IPL_POOL_HAS_MVE */
@@ -84,7 +84,8 @@ void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
                                              const size_t width_out,
                                              const size_t height_out,
                                              const size_t channels,
-                                             const void *pScratch)
+                                             const void *pScratch,
+                                             const bool table_ready)
 {
     if (pScratch) {
         float32_t inv_width_scale, inv_height_scale;
@@ -98,7 +99,7 @@ void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
         /* dist from left pixel (i.e. weight for right pixel and 1 - val for left pixel) */
         float16_t *pF16WeightR = (float16_t *)(pU16OffsetR + width_out);
         /* Same for each channel */
-        for (size_t w = 0; w < width_out; w++)
+        for (size_t w = 0; (w < width_out) && !table_ready; w++)
         {
             float32_t fOffset = IM_MIN(IM_MAX(fOffset_raw, 0), width_in-1);
             *pU16OffsetL = ((uint16_t)IM_MIN(IM_MAX(fOffset, 0), width_in-1)) * channels;
@@ -224,6 +225,123 @@ void mve_resize_bilinear_iu8ou8_with_strides(const uint8_t *in_data,
     } /* else (if scratch) */
 }
 
+/* Extracts a channel (shift, mask) from 8 RGB565 pixels and converts it to float16. */
+#define _RGB565_CHANNEL_F16(pixels, shift, mask) \
+    vcvtq_f16_u16(vandq_u16(vshlq_u16(pixels, vdupq_n_s16(-(shift))), vdupq_n_u16(mask)))
+
+static inline
+uint16x8_t mve_bilinear_rgb565_kernel_channel(uint16x8_t u16x8_tl,
+                                              uint16x8_t u16x8_tr,
+                                              uint16x8_t u16x8_dl,
+                                              uint16x8_t u16x8_dr,
+                                              const float16x8_t weights[4],
+                                              const int16_t shift,
+                                              const uint16_t mask)
+{
+    float16x8_t f16x8_res;
+
+    f16x8_res = vmulq_f16(_RGB565_CHANNEL_F16(u16x8_tl, shift, mask), weights[0]);
+    f16x8_res = vfmaq_f16(f16x8_res, _RGB565_CHANNEL_F16(u16x8_tr, shift, mask), weights[1]);
+    f16x8_res = vfmaq_f16(f16x8_res, _RGB565_CHANNEL_F16(u16x8_dl, shift, mask), weights[2]);
+    f16x8_res = vfmaq_f16(f16x8_res, _RGB565_CHANNEL_F16(u16x8_dr, shift, mask), weights[3]);
+
+    /* float to uint16 + clip to the channel range, then move the channel to its position */
+    uint16x8_t u16x8_out = vminq_u16(vcvtaq_u16_f16(f16x8_res), vdupq_n_u16(mask));
+
+    return vshlq_u16(u16x8_out, vdupq_n_s16(shift));
+}
+
+void mve_resize_bilinear_rgb565_with_strides(const uint16_t *in_data,
+                                             uint16_t *out_data,
+                                             const size_t stride_in,
+                                             const size_t stride_out,
+                                             const size_t width_in,
+                                             const size_t height_in,
+                                             const size_t width_out,
+                                             const size_t height_out,
+                                             const void *pScratch,
+                                             const bool table_ready)
+{
+    float32_t inv_width_scale, inv_height_scale;
+    inv_width_scale = ((float32_t)width_in) / ((float32_t) width_out);
+    inv_height_scale = ((float32_t)height_in) / ((float32_t)height_out);
+    float32_t fOffset_raw = -0.5f + 0.5f * inv_width_scale;
+    /* Index of left pixel */
+    uint16_t *pU16OffsetL = (uint16_t *)pScratch;
+    /* Index of right pixel */
+    uint16_t *pU16OffsetR = (uint16_t *)pU16OffsetL + width_out;
+    /* dist from left pixel (i.e. weight for right pixel and 1 - val for left pixel) */
+    float16_t *pF16WeightR = (float16_t *)(pU16OffsetR + width_out);
+    for (size_t w = 0; (w < width_out) && !table_ready; w++)
+    {
+        float32_t fOffset = IM_MIN(IM_MAX(fOffset_raw, 0), width_in-1);
+        *pU16OffsetL = (uint16_t)fOffset;
+        *pU16OffsetR++ = IM_MIN(*pU16OffsetL + 1, width_in - 1);
+        pU16OffsetL++;
+        *pF16WeightR++ = fOffset - (uint16_t)fOffset; /* decimal part, alpha */
+        fOffset_raw += inv_width_scale;
+    }
+
+    uint8_t * out_data_current_ptr = (uint8_t *)out_data;
+    fOffset_raw = -0.5f + 0.5f * inv_height_scale;
+    for (size_t h = 0; h < height_out; h++)
+    {
+        float32_t Y = IM_MIN(IM_MAX(fOffset_raw, 0.0f),(float32_t)height_in-1);
+        fOffset_raw += inv_height_scale;
+        uint32_t Yi = (uint32_t)Y;
+        const uintptr_t y_step = (Yi == (height_in - 1)) ? 0 : stride_in;
+        float32_t weights_Y[2];
+        _BILINEAR_COMPUTE_WEIGHTS_Y(Y, weights_Y);
+
+        const uint16_t * in_data_ptr_0 = (const uint16_t *)((const uint8_t *)in_data + Yi * stride_in);
+        const uint16_t * in_data_ptr_1 = (const uint16_t *)((const uint8_t *)in_data_ptr_0 + y_step);
+        uint16_t * out_data_ptr = (uint16_t *)out_data_current_ptr;
+
+        pU16OffsetL = (uint16_t *)pScratch;
+        pU16OffsetR = (uint16_t *)pU16OffsetL + width_out;
+        pF16WeightR = (float16_t *)(pU16OffsetR + width_out);
+        int32_t w = (int32_t)width_out;
+        while (w > 0)
+        {
+            mve_pred16_t p = vctp16q(w);
+            /* Load weights */
+            float16x8_t fweightsR = vldrhq_z_f16(pF16WeightR, p); /* Load 8 f16 weights */
+            float16x8_t fweightsL = vsubq_f16(vdupq_n_f16(1.0), fweightsR); /* 1 - alpha */
+            float16x8_t weights[4];
+            weights[0] = vmulq_n_f16(fweightsL, (float16_t)weights_Y[0]);
+            weights[1] = vmulq_n_f16(fweightsR, (float16_t)weights_Y[0]);
+            weights[2] = vmulq_n_f16(fweightsL, (float16_t)weights_Y[1]);
+            weights[3] = vmulq_n_f16(fweightsR, (float16_t)weights_Y[1]);
+
+            /* Load the 4 neighbors of 8 output pixels, unpacked in-register channel by channel */
+            uint16x8_t u16x8_offL = vldrhq_z_u16(pU16OffsetL, p);
+            uint16x8_t u16x8_offR = vldrhq_z_u16(pU16OffsetR, p);
+            uint16x8_t u16x8_tl = vldrhq_gather_shifted_offset_z_u16(in_data_ptr_0, u16x8_offL, p);
+            uint16x8_t u16x8_tr = vldrhq_gather_shifted_offset_z_u16(in_data_ptr_0, u16x8_offR, p);
+            uint16x8_t u16x8_dl = vldrhq_gather_shifted_offset_z_u16(in_data_ptr_1, u16x8_offL, p);
+            uint16x8_t u16x8_dr = vldrhq_gather_shifted_offset_z_u16(in_data_ptr_1, u16x8_offR, p);
+
+            /* Interpolate R5, G6, B5 and repack */
+            uint16x8_t u16x8_out;
+            u16x8_out = mve_bilinear_rgb565_kernel_channel(u16x8_tl, u16x8_tr, u16x8_dl, u16x8_dr, weights, 11, 0x1F);
+            u16x8_out = vorrq_u16(u16x8_out,
+                        mve_bilinear_rgb565_kernel_channel(u16x8_tl, u16x8_tr, u16x8_dl, u16x8_dr, weights, 5, 0x3F));
+            u16x8_out = vorrq_u16(u16x8_out,
+                        mve_bilinear_rgb565_kernel_channel(u16x8_tl, u16x8_tr, u16x8_dl, u16x8_dr, weights, 0, 0x1F));
+
+            vstrhq_p_u16(out_data_ptr, u16x8_out, p);
+
+            pU16OffsetL += 8;
+            pU16OffsetR += 8;
+            pF16WeightR += 8;
+            out_data_ptr += 8;
+
+            w -= 8;
+        }
+        out_data_current_ptr += stride_out;
+    } /* For height */
+}
+
 void mve_resize_nearest_iu8ou8_with_strides(const uint8_t *in_data,
                                             uint8_t *out_data,
                                             const size_t stride_in,
@@ -233,7 +351,8 @@ void mve_resize_nearest_iu8ou8_with_strides(const uint8_t *in_data,
                                             const size_t width_out,
                                             const size_t height_out,
                                             const size_t channels,
-                                            const void *scratch)
+                                            const void *scratch,
+                                            const bool table_ready)
 {
     int32_t wRatio = (int32_t) (( width_in << 16) /  width_out) + 1;
     int32_t hRatio = (int32_t) ((height_in << 16) / height_out) + 1;
@@ -249,7 +368,7 @@ void mve_resize_nearest_iu8ou8_with_strides(const uint8_t *in_data,
         uint16_t vReadOffset = 0;
         uint32_t diff_offset_x = IPL_RESIZE_PEL_IDX_ROUNDING;
         uint32_t idx = 0;
-        for (w = 0; w < width_out; w++)
+        for (w = 0; (w < width_out) && !table_ready; w++)
         {
             for (size_t ch = 0; ch < channels; ch++)
             {
@@ -356,4 +475,71 @@ void mve_resize_nearest_iu8ou8_with_strides(const uint8_t *in_data,
         } /* switch */
     } /* else if scratch */
 }
+
+void mve_resize_area_iu8ou8_with_strides(const uint8_t *in_data,
+                                         uint8_t *out_data,
+                                         const size_t stride_in,
+                                         const size_t stride_out,
+                                         const size_t width_out,
+                                         const size_t height_out,
+                                         const size_t ratio_x,
+                                         const size_t ratio_y,
+                                         const size_t n_channels,
+                                         const void *pScratch,
+                                         const bool table_ready)
+{
+    const size_t len_in = width_out * ratio_x * n_channels;
+    const size_t len_out = width_out * n_channels;
+    const uint16_t rounding = (uint16_t)((ratio_x * ratio_y) >> 1);
+    uint16_t *pU16Acc = (uint16_t *)pScratch;
+    uint16_t *pU16Offsets = pU16Acc + len_in;
+    int16_t shift = 0;
+
+    /* ratio_x * ratio_y is a power of 2: the mean is computed with a right shift */
+    while (((size_t)1 << shift) < (ratio_x * ratio_y))
+    {
+        shift++;
+    }
+    int16x8_t s16x8_shift = vdupq_n_s16(-shift);
+
+    /* Offset of the first element of the block of each output element */
+    for (size_t e = 0; (e < len_out) && !table_ready; e++)
+    {
+        pU16Offsets[e] = (uint16_t)((e / n_channels) * ratio_x * n_channels + (e % n_channels));
+    }
+
+    for (size_t h = 0; h < height_out; h++)
+    {
+        const uint8_t *in_data_ptr = in_data + h * ratio_y * stride_in;
+        uint8_t *out_data_ptr = out_data + h * stride_out;
+
+        /* Vertical sum of ratio_y input lines */
+        for (size_t i = 0; i < len_in; i += 8)
+        {
+            mve_pred16_t p = vctp16q(len_in - i);
+            uint16x8_t u16x8_sum = vldrbq_z_u16(in_data_ptr + i, p);
+
+            for (size_t k = 1; k < ratio_y; k++)
+            {
+                u16x8_sum = vaddq_u16(u16x8_sum, vldrbq_z_u16(in_data_ptr + k * stride_in + i, p));
+            }
+            vstrhq_p_u16(pU16Acc + i, u16x8_sum, p);
+        }
+
+        /* Horizontal sum of ratio_x adjacent elements of the same channel, then rounded mean */
+        for (size_t e = 0; e < len_out; e += 8)
+        {
+            mve_pred16_t p = vctp16q(len_out - e);
+            uint16x8_t u16x8_offsets = vldrhq_z_u16(pU16Offsets + e, p);
+            uint16x8_t u16x8_sum = vdupq_n_u16(rounding);
+
+            for (size_t j = 0; j < ratio_x; j++)
+            {
+                u16x8_sum = vaddq_u16(u16x8_sum,
+                                      vldrhq_gather_shifted_offset_z_u16(pU16Acc + j * n_channels, u16x8_offsets, p));
+            }
+            vstrbq_p_u16(out_data_ptr + e, vshlq_u16(u16x8_sum, s16x8_shift), p);
+        }
+    } /* For height */
+}
 #endif /* IPL_RESIZE_HAS_MVE */
@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @file    mve_rotation.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library flip, mirror and rotation functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_ROTATION_HAS_MVE
+#include "mve_rotation.h"
+
+/* The column functions copy n pixels of a source column (srcStride bytes apart, negative to read it upwards) to a
+ * destination row: eight pixels at a time are gathered with 16-bit offsets and stored contiguously, so the stride
+ * must not exceed 65535 / 7 bytes (otherwise the scalar loop is used). The reverse functions copy n pixels of a row
+ * in reverse order, gathering the source pixels with decreasing offsets. */
+
+/* Maximum stride (bytes) supported by the gathers with 16-bit offsets of eight pixels. */
+#define MVE_ROTATION_MAX_STRIDE (UINT16_MAX / 7)
+
+/* Base address and offsets of the gather of eight pixels of a column starting at src. */
+static inline const uint8_t *mve_rotation_column_base(const uint8_t *src, int32_t srcStride, uint16x8_t *offset)
+{
+  if (srcStride >= 0) {
+    *offset = vmulq_n_u16(vidupq_n_u16(0, 1), srcStride);
+    return src;
+  }
+
+  *offset = vmulq_n_u16(vddupq_n_u16(7, 1), -srcStride);
+  return src + (7 * srcStride);
+}
+
+void mve_rotation_column_u8(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n)
+{
+  if ((srcStride <= MVE_ROTATION_MAX_STRIDE) && (srcStride >= -MVE_ROTATION_MAX_STRIDE)) {
+    uint16x8_t offset;
+
+    for (; n >= 8; n -= 8, src += 8 * srcStride, dst += 8) {
+      const uint8_t *base = mve_rotation_column_base(src, srcStride, &offset);
+
+      vstrbq_u16(dst, vldrbq_gather_offset_u16(base, offset));
+    }
+  }
+
+  for (; n > 0; n--, src += srcStride)
+    *dst++ = *src;
+}
+
+void mve_rotation_column_u16(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n)
+{
+  if ((srcStride <= MVE_ROTATION_MAX_STRIDE) && (srcStride >= -MVE_ROTATION_MAX_STRIDE)) {
+    uint16x8_t offset;
+
+    for (; n >= 8; n -= 8, src += 8 * srcStride, dst += 16) {
+      const uint8_t *base = mve_rotation_column_base(src, srcStride, &offset);
+
+      vst1q_u16((uint16_t *)dst, vldrhq_gather_offset_u16((const uint16_t *)base, offset));
+    }
+  }
+
+  for (; n > 0; n--, src += srcStride, dst += 2)
+    *(uint16_t *)dst = *(const uint16_t *)src;
+}
+
+void mve_rotation_column_rgb888(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n)
+{
+  if ((srcStride <= MVE_ROTATION_MAX_STRIDE) && (srcStride >= -MVE_ROTATION_MAX_STRIDE)) {
+    uint16x8_t dstOffset = vmulq_n_u16(vidupq_n_u16(0, 1), 3);
+    uint16x8_t offset;
+
+    for (; n >= 8; n -= 8, src += 8 * srcStride, dst += 24) {
+      const uint8_t *base = mve_rotation_column_base(src, srcStride, &offset);
+
+      vstrbq_scatter_offset_u16(dst, dstOffset, vldrbq_gather_offset_u16(base, offset));
+      vstrbq_scatter_offset_u16(dst + 1, dstOffset, vldrbq_gather_offset_u16(base + 1, offset));
+      vstrbq_scatter_offset_u16(dst + 2, dstOffset, vldrbq_gather_offset_u16(base + 2, offset));
+    }
+  }
+
+  for (; n > 0; n--, src += srcStride) {
+    *dst++ = src[0];
+    *dst++ = src[1];
+    *dst++ = src[2];
+  }
+}
+
+void mve_rotation_reverse_u8(const uint8_t *src, uint8_t *dst, int n)
+{
+  uint8x16_t offset = vddupq_n_u8(15, 1);
+
+  /* src points past the last pixel to be copied */
+  for (src += n; n >= 16; n -= 16, dst += 16) {
+    src -= 16;
+    vst1q_u8(dst, vldrbq_gather_offset_u8(src, offset));
+  }
+
+  while (n-- > 0)
+    *dst++ = *--src;
+}
+
+void mve_rotation_reverse_u16(const uint8_t *src, uint8_t *dst, int n)
+{
+  uint16x8_t offset = vddupq_n_u16(14, 2);
+
+  for (src += 2 * n; n >= 8; n -= 8, dst += 16) {
+    src -= 16;
+    vst1q_u16((uint16_t *)dst, vldrhq_gather_offset_u16((const uint16_t *)src, offset));
+  }
+
+  for (; n > 0; n--, dst += 2) {
+    src -= 2;
+    *(uint16_t *)dst = *(const uint16_t *)src;
+  }
+}
+
+void mve_rotation_reverse_rgb888(const uint8_t *src, uint8_t *dst, int n)
+{
+  /* five pixels (15 bytes) at a time: byte 3 * p + c is read from byte 3 * (4 - p) + c */
+  static const uint8_t reverse[16] = {12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2, 0};
+  uint8x16_t offset = vld1q_u8(reverse);
+  mve_pred16_t p = vctp8q(15);
+
+  for (src += 3 * n; n >= 5; n -= 5, dst += 15) {
+    src -= 15;
+    vstrbq_p_u8(dst, vldrbq_gather_offset_z_u8(src, offset, p), p);
+  }
+
+  for (; n > 0; n--) {
+    src -= 3;
+    *dst++ = src[0];
+    *dst++ = src[1];
+    *dst++ = src[2];
+  }
+}
+
+#endif /* IPL_ROTATION_HAS_MVE */
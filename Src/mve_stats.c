@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file    mve_stats.c
+ * @author  AIS Team
+ * @brief   MVE Image processing library statistics functions
+
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2025 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "imlib.h"
+
+#ifdef IPL_STATS_HAS_MVE
+#include "mve_stats.h"
+
+/* Adds the sums of one line of 8-pixel blocks to the SSIM buckets of each block: the 8 pixels of a block are
+ * loaded in one vector and reduced with one add or multiply-accumulate across the vector per bucket. The last
+ * block of the line is predicated, the missing pixels are loaded as zero and add nothing. */
+void mve_imlib_similarity_line(const uint8_t *x_row, const uint8_t *y_row, int w, int *sum_x, int *sum_y,
+                               int *sum2_x, int *sum2_y, int *sum_xy)
+{
+  for (int x = 0, b = 0; x < w; x += 8, b++) {
+    mve_pred16_t p = vctp16q(w - x);
+    uint16x8_t u16x8_x = vldrbq_z_u16(x_row + x, p);
+    uint16x8_t u16x8_y = vldrbq_z_u16(y_row + x, p);
+
+    sum_x[b] = vaddvaq_u16(sum_x[b], u16x8_x);
+    sum_y[b] = vaddvaq_u16(sum_y[b], u16x8_y);
+    sum2_x[b] = vmladavaq_u16(sum2_x[b], u16x8_x, u16x8_x);
+    sum2_y[b] = vmladavaq_u16(sum2_y[b], u16x8_y, u16x8_y);
+    sum_xy[b] = vmladavaq_u16(sum_xy[b], u16x8_x, u16x8_y);
+  }
+}
+/* Number of non zero bytes: the comparison predicate has one bit per byte, its set bits are counted. */
+uint32_t mve_imlib_count_nonzero_u8(const uint8_t *data, int n)
+{
+  uint32_t count = 0;
+
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    count += __builtin_popcount(vcmpneq_m_n_u8(vldrbq_z_u8(data + i, p), 0, p));
+  }
+
+  return count;
+}
+
+/* Index of the first non zero byte, n when there is none; vectors of zero bytes are skipped at once. */
+int mve_imlib_find_nonzero_u8(const uint8_t *data, int n)
+{
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    mve_pred16_t nz = vcmpneq_m_n_u8(vldrbq_z_u8(data + i, p), 0, p);
+    if (nz) {
+      return i + __builtin_ctz(nz);
+    }
+  }
+
+  return n;
+}
+/* Updates min and max with the ones of n bytes: the extrema are kept per lane, then reduced across the vector once. */
+void mve_imlib_min_max_u8(const uint8_t *data, int n, uint8_t *min, uint8_t *max)
+{
+  uint8x16_t u8x16_min = vdupq_n_u8(*min);
+  uint8x16_t u8x16_max = vdupq_n_u8(*max);
+
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    uint8x16_t u8x16_data = vldrbq_z_u8(data + i, p);
+    u8x16_min = vminq_m_u8(u8x16_min, u8x16_min, u8x16_data, p);
+    u8x16_max = vmaxq_m_u8(u8x16_max, u8x16_max, u8x16_data, p);
+  }
+
+  *min = vminvq_u8(*min, u8x16_min);
+  *max = vmaxvq_u8(*max, u8x16_max);
+}
+
+/* Index of the first byte equal to value, n when there is none; vectors with no such byte are skipped at once. */
+int mve_imlib_find_u8(const uint8_t *data, int n, uint8_t value)
+{
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    mve_pred16_t eq = vcmpeqq_m_n_u8(vldrbq_z_u8(data + i, p), value, p);
+    if (eq) {
+      return i + __builtin_ctz(eq);
+    }
+  }
+
+  return n;
+}
+
+/* Sum of the absolute differences of n bytes: the lanes loaded as zero beyond n add nothing. */
+uint32_t mve_imlib_sad_u8(const uint8_t *a, const uint8_t *b, int n)
+{
+  uint32_t sad = 0;
+
+  for (int i = 0; i < n; i += 16) {
+    mve_pred16_t p = vctp8q(n - i);
+    sad = vaddvaq_u8(sad, vabdq_u8(vldrbq_z_u8(a + i, p), vldrbq_z_u8(b + i, p)));
+  }
+
+  return sad;
+}
+
+/* Sum of the absolute differences of the channels of n RGB565 pixels, scaled to 8 bits (red and blue by 8, green
+ * by 4): at most 748 per pixel, so that the sum of each pixel fits its 16-bit lane. */
+uint32_t mve_imlib_sad_rgb565(const uint16_t *a, const uint16_t *b, int n)
+{
+  uint16x8_t u16x8_mask_g = vdupq_n_u16(0x3F);
+  uint16x8_t u16x8_mask_b = vdupq_n_u16(0x1F);
+  uint32_t sad = 0;
+
+  for (int i = 0; i < n; i += 8) {
+    mve_pred16_t p = vctp16q(n - i);
+    uint16x8_t u16x8_a = vldrhq_z_u16(a + i, p);
+    uint16x8_t u16x8_b = vldrhq_z_u16(b + i, p);
+    uint16x8_t u16x8_r = vabdq_u16(vshrq_n_u16(u16x8_a, 11), vshrq_n_u16(u16x8_b, 11));
+    uint16x8_t u16x8_g = vabdq_u16(vandq_u16(vshrq_n_u16(u16x8_a, 5), u16x8_mask_g),
+                                   vandq_u16(vshrq_n_u16(u16x8_b, 5), u16x8_mask_g));
+    uint16x8_t u16x8_bl = vabdq_u16(vandq_u16(u16x8_a, u16x8_mask_b), vandq_u16(u16x8_b, u16x8_mask_b));
+
+    sad = vaddvaq_u16(sad, vaddq_u16(vshlq_n_u16(vaddq_u16(u16x8_r, u16x8_bl), 3), vshlq_n_u16(u16x8_g, 2)));
+  }
+
+  return sad;
+}
+#endif /* IPL_STATS_HAS_MVE */
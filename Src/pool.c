@@ -7,10 +7,18 @@
  *
  */
 #include "imlib.h"
+#ifdef IPL_POOL_HAS_MVE // STM32IPL
+#include "mve_pool.h"
+#endif
 
 #ifdef IMLIB_ENABLE_MIDPOINT_POOLING
 void imlib_midpoint_pool(image_t *img_i, image_t *img_o, int x_div, int y_div, const int bias)
 {
+#ifdef IPL_POOL_HAS_MVE // STM32IPL: Grayscale and RGB565 cells are reduced with vector instructions.
+    if (mve_imlib_midpoint_pool(img_i, img_o, x_div, y_div, bias) == 0) {
+        return;
+    }
+#endif
     int min_bias = (256-bias);
     int max_bias = bias;
     switch(img_i->bpp)
@@ -127,6 +135,11 @@ void imlib_midpoint_pool(image_t *img_i, image_t *img_o, int x_div, int y_div, c
 #ifdef IMLIB_ENABLE_MEAN_POOLING
 void imlib_mean_pool(image_t *img_i, image_t *img_o, int x_div, int y_div)
 {
+#ifdef IPL_POOL_HAS_MVE // STM32IPL: Grayscale and RGB565 cells are summed with vector instructions.
+    if (mve_imlib_mean_pool(img_i, img_o, x_div, y_div) == 0) {
+        return;
+    }
+#endif
     int n = x_div * y_div;
     switch(img_i->bpp)
     {
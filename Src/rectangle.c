@@ -61,22 +61,23 @@ bool rectangle_subimg(image_t *img, rectangle_t *r, rectangle_t *r_out)
 
 // This isn't for actually combining the rects standardly, but, to instead
 // find the average rectangle between a bunch of overlapping rectangles.
-static void rectangle_add(rectangle_t *r1, rectangle_t *r2)
+// STM32IPL: the sums are accumulated on 32 bits, as with many detections they overflow the rectangle fields.
+static void rectangle_add(int32_t *sum, rectangle_t *r)
 {
-    r1->x += r2->x;
-    r1->y += r2->y;
-    r1->w += r2->w;
-    r1->h += r2->h;
+    sum[0] += r->x;
+    sum[1] += r->y;
+    sum[2] += r->w;
+    sum[3] += r->h;
 }
 
 // This isn't for actually combining the rects standardly, but, to instead
 // find the average rectangle between a bunch of overlapping rectangles.
-static void rectangle_div(rectangle_t *r, int c)
+static void rectangle_div(rectangle_t *r, int32_t *sum, int c) // STM32IPL
 {
-    r->x /= c;
-    r->y /= c;
-    r->w /= c;
-    r->h /= c;
+    r->x = sum[0] / c;
+    r->y = sum[1] / c;
+    r->w = sum[2] / c;
+    r->h = sum[3] / c;
 }
 
 array_t *rectangle_merge(array_t *rectangles)
@@ -93,14 +94,15 @@ array_t *rectangle_merge(array_t *rectangles)
             }
         }
         /* add the overlaping detections */
+        int32_t sum[4] = {rect->x, rect->y, rect->w, rect->h}; // STM32IPL
         int count = array_length(overlap);
         for (int i=0; i<count; i++) {
             rectangle_t *overlap_rect = (rectangle_t *) array_pop_back(overlap);
-            rectangle_add(rect, overlap_rect);
+            rectangle_add(sum, overlap_rect); // STM32IPL
             xfree(overlap_rect);
         }
         /* average the overlaping detections */
-        rectangle_div(rect, count + 1);
+        rectangle_div(rect, sum, count + 1); // STM32IPL
         array_push_back(objects, rect);
     }
     array_free(rectangles);
@@ -15,6 +15,8 @@
   ******************************************************************************
   */
 
+#include <stdint.h>
+
 const float sin_table[360] = {
      0.000000f,  0.017452f,  0.034899f,  0.052336f,  0.069756f,  0.087156f,  0.104528f,  0.121869f,
      0.139173f,  0.156434f,  0.173648f,  0.190809f,  0.207912f,  0.224951f,  0.241922f,  0.258819f,
@@ -110,3 +112,70 @@ const float cos_table[360] = {
      0.961262f,  0.965926f,  0.970296f,  0.974370f,  0.978148f,  0.981627f,  0.984808f,  0.987688f,
      0.990268f,  0.992546f,  0.994522f,  0.996195f,  0.997564f,  0.998630f,  0.999391f,  0.999848f
 };
+
+/* STM32IPL Q14 fixed-point versions of the tables above (16384 = 1.0). */
+const int16_t sin_table_q14[360] = {
+         0,    286,    572,    857,   1143,   1428,   1713,   1997,   2280,   2563,   2845,   3126,
+      3406,   3686,   3964,   4240,   4516,   4790,   5063,   5334,   5604,   5872,   6138,   6402,
+      6664,   6924,   7182,   7438,   7692,   7943,   8192,   8438,   8682,   8923,   9162,   9397,
+      9630,   9860,  10087,  10311,  10531,  10749,  10963,  11174,  11381,  11585,  11786,  11982,
+     12176,  12365,  12551,  12733,  12911,  13085,  13255,  13421,  13583,  13741,  13894,  14044,
+     14189,  14330,  14466,  14598,  14726,  14849,  14968,  15082,  15191,  15296,  15396,  15491,
+     15582,  15668,  15749,  15826,  15897,  15964,  16026,  16083,  16135,  16182,  16225,  16262,
+     16294,  16322,  16344,  16362,  16374,  16382,  16384,  16382,  16374,  16362,  16344,  16322,
+     16294,  16262,  16225,  16182,  16135,  16083,  16026,  15964,  15897,  15826,  15749,  15668,
+     15582,  15491,  15396,  15296,  15191,  15082,  14968,  14849,  14726,  14598,  14466,  14330,
+     14189,  14044,  13894,  13741,  13583,  13421,  13255,  13085,  12911,  12733,  12551,  12365,
+     12176,  11982,  11786,  11585,  11381,  11174,  10963,  10749,  10531,  10311,  10087,   9860,
+      9630,   9397,   9162,   8923,   8682,   8438,   8192,   7943,   7692,   7438,   7182,   6924,
+      6664,   6402,   6138,   5872,   5604,   5334,   5063,   4790,   4516,   4240,   3964,   3686,
+      3406,   3126,   2845,   2563,   2280,   1997,   1713,   1428,   1143,    857,    572,    286,
+         0,   -286,   -572,   -857,  -1143,  -1428,  -1713,  -1997,  -2280,  -2563,  -2845,  -3126,
+     -3406,  -3686,  -3964,  -4240,  -4516,  -4790,  -5063,  -5334,  -5604,  -5872,  -6138,  -6402,
+     -6664,  -6924,  -7182,  -7438,  -7692,  -7943,  -8192,  -8438,  -8682,  -8923,  -9162,  -9397,
+     -9630,  -9860, -10087, -10311, -10531, -10749, -10963, -11174, -11381, -11585, -11786, -11982,
+    -12176, -12365, -12551, -12733, -12911, -13085, -13255, -13421, -13583, -13741, -13894, -14044,
+    -14189, -14330, -14466, -14598, -14726, -14849, -14968, -15082, -15191, -15296, -15396, -15491,
+    -15582, -15668, -15749, -15826, -15897, -15964, -16026, -16083, -16135, -16182, -16225, -16262,
+    -16294, -16322, -16344, -16362, -16374, -16382, -16384, -16382, -16374, -16362, -16344, -16322,
+    -16294, -16262, -16225, -16182, -16135, -16083, -16026, -15964, -15897, -15826, -15749, -15668,
+    -15582, -15491, -15396, -15296, -15191, -15082, -14968, -14849, -14726, -14598, -14466, -14330,
+    -14189, -14044, -13894, -13741, -13583, -13421, -13255, -13085, -12911, -12733, -12551, -12365,
+    -12176, -11982, -11786, -11585, -11381, -11174, -10963, -10749, -10531, -10311, -10087,  -9860,
+     -9630,  -9397,  -9162,  -8923,  -8682,  -8438,  -8192,  -7943,  -7692,  -7438,  -7182,  -6924,
+     -6664,  -6402,  -6138,  -5872,  -5604,  -5334,  -5063,  -4790,  -4516,  -4240,  -3964,  -3686,
+     -3406,  -3126,  -2845,  -2563,  -2280,  -1997,  -1713,  -1428,  -1143,   -857,   -572,   -286
+};
+
+const int16_t cos_table_q14[360] = {
+     16384,  16382,  16374,  16362,  16344,  16322,  16294,  16262,  16225,  16182,  16135,  16083,
+     16026,  15964,  15897,  15826,  15749,  15668,  15582,  15491,  15396,  15296,  15191,  15082,
+     14968,  14849,  14726,  14598,  14466,  14330,  14189,  14044,  13894,  13741,  13583,  13421,
+     13255,  13085,  12911,  12733,  12551,  12365,  12176,  11982,  11786,  11585,  11381,  11174,
+     10963,  10749,  10531,  10311,  10087,   9860,   9630,   9397,   9162,   8923,   8682,   8438,
+      8192,   7943,   7692,   7438,   7182,   6924,   6664,   6402,   6138,   5872,   5604,   5334,
+      5063,   4790,   4516,   4240,   3964,   3686,   3406,   3126,   2845,   2563,   2280,   1997,
+      1713,   1428,   1143,    857,    572,    286,      0,   -286,   -572,   -857,  -1143,  -1428,
+     -1713,  -1997,  -2280,  -2563,  -2845,  -3126,  -3406,  -3686,  -3964,  -4240,  -4516,  -4790,
+     -5063,  -5334,  -5604,  -5872,  -6138,  -6402,  -6664,  -6924,  -7182,  -7438,  -7692,  -7943,
+     -8192,  -8438,  -8682,  -8923,  -9162,  -9397,  -9630,  -9860, -10087, -10311, -10531, -10749,
+    -10963, -11174, -11381, -11585, -11786, -11982, -12176, -12365, -12551, -12733, -12911, -13085,
+    -13255, -13421, -13583, -13741, -13894, -14044, -14189, -14330, -14466, -14598, -14726, -14849,
+    -14968, -15082, -15191, -15296, -15396, -15491, -15582, -15668, -15749, -15826, -15897, -15964,
+    -16026, -16083, -16135, -16182, -16225, -16262, -16294, -16322, -16344, -16362, -16374, -16382,
+    -16384, -16382, -16374, -16362, -16344, -16322, -16294, -16262, -16225, -16182, -16135, -16083,
+    -16026, -15964, -15897, -15826, -15749, -15668, -15582, -15491, -15396, -15296, -15191, -15082,
+    -14968, -14849, -14726, -14598, -14466, -14330, -14189, -14044, -13894, -13741, -13583, -13421,
+    -13255, -13085, -12911, -12733, -12551, -12365, -12176, -11982, -11786, -11585, -11381, -11174,
+    -10963, -10749, -10531, -10311, -10087,  -9860,  -9630,  -9397,  -9162,  -8923,  -8682,  -8438,
+     -8192,  -7943,  -7692,  -7438,  -7182,  -6924,  -6664,  -6402,  -6138,  -5872,  -5604,  -5334,
+     -5063,  -4790,  -4516,  -4240,  -3964,  -3686,  -3406,  -3126,  -2845,  -2563,  -2280,  -1997,
+     -1713,  -1428,  -1143,   -857,   -572,   -286,      0,    286,    572,    857,   1143,   1428,
+      1713,   1997,   2280,   2563,   2845,   3126,   3406,   3686,   3964,   4240,   4516,   4790,
+      5063,   5334,   5604,   5872,   6138,   6402,   6664,   6924,   7182,   7438,   7692,   7943,
+      8192,   8438,   8682,   8923,   9162,   9397,   9630,   9860,  10087,  10311,  10531,  10749,
+     10963,  11174,  11381,  11585,  11786,  11982,  12176,  12365,  12551,  12733,  12911,  13085,
+     13255,  13421,  13583,  13741,  13894,  14044,  14189,  14330,  14466,  14598,  14726,  14849,
+     14968,  15082,  15191,  15296,  15396,  15491,  15582,  15668,  15749,  15826,  15897,  15964,
+     16026,  16083,  16135,  16182,  16225,  16262,  16294,  16322,  16344,  16362,  16374,  16382
+};
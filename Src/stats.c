@@ -10,6 +10,9 @@
  */
 
 #include "imlib.h"
+#ifdef IPL_STATS_HAS_MVE
+#include "mve_stats.h"
+#endif
 
 #ifdef IMLIB_ENABLE_GET_SIMILARITY
 
@@ -20,6 +23,10 @@ typedef struct imlib_similatiry_line_op_state {
     int *sumBucketsOfX, *sumBucketsOfY, *sum2BucketsOfX, *sum2BucketsOfY, *sum2Buckets;
     float similarity_sum, similarity_sum_2, similarity_min, similarity_max;
     int lines_processed;
+    float *map; // STM32IPL: optional per-block SSIM map.
+#ifdef IPL_STATS_HAS_MVE
+    int8_t *l_rows; // STM32IPL: L rows of the RGB565 lines (plus A and B scratch rows).
+#endif
 } imlib_similatiry_line_op_state_t;
 
 void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, bool vflipped)
@@ -33,8 +40,8 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
             uint32_t *other_row_ptr = (uint32_t *) other;
             for (int x = 0, xx = (img->w + 7) / 8; x < xx; x++) {
                 for (int i = 0, ii = IM_MIN((img->w - (x * 8)), 8); i < ii; i++) {
-                    int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x + i);
-                    int other_pixel = IMAGE_GET_BINARY_PIXEL_FAST(other_row_ptr, x + i);
+                    int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, (x * 8) + i);
+                    int other_pixel = IMAGE_GET_BINARY_PIXEL_FAST(other_row_ptr, (x * 8) + i);
                     state->sumBucketsOfX[x] += pixel;
                     state->sumBucketsOfY[x] += other_pixel;
                     state->sum2BucketsOfX[x] += pixel * pixel;
@@ -49,10 +56,14 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
         case IMAGE_BPP_GRAYSCALE: {
             uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, line);
             uint8_t *other_row_ptr = (uint8_t *) other;
+#ifdef IPL_STATS_HAS_MVE
+            mve_imlib_similarity_line(row_ptr, other_row_ptr, img->w, state->sumBucketsOfX, state->sumBucketsOfY,
+                                      state->sum2BucketsOfX, state->sum2BucketsOfY, state->sum2Buckets);
+#else
             for (int x = 0, xx = (img->w + 7) / 8; x < xx; x++) {
                 for (int i = 0, ii = IM_MIN((img->w - (x * 8)), 8); i < ii; i++) {
-                    int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x + i);
-                    int other_pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(other_row_ptr, x + i);
+                    int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, (x * 8) + i);
+                    int other_pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(other_row_ptr, (x * 8) + i);
                     state->sumBucketsOfX[x] += pixel;
                     state->sumBucketsOfY[x] += other_pixel;
                     state->sum2BucketsOfX[x] += pixel * pixel;
@@ -60,6 +71,7 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
                     state->sum2Buckets[x] += pixel * other_pixel;
                 }
             }
+#endif
             c1 = COLOR_GRAYSCALE_MAX * 0.01f;
             c2 = COLOR_GRAYSCALE_MAX * 0.03f;
             break;
@@ -67,10 +79,20 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
         case IMAGE_BPP_RGB565: {
             uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, line);
             uint16_t *other_row_ptr = (uint16_t *) other;
+#ifdef IPL_STATS_HAS_MVE
+            // STM32IPL: the L values (0..100) of both lines are computed by rows, then summed as the grayscale ones.
+            int8_t *l_row = state->l_rows, *other_l_row = l_row + img->w;
+            int8_t *a_row = other_l_row + img->w, *b_row = a_row + img->w;
+            imlib_rgb565_to_lab_row(row_ptr, img->w, l_row, a_row, b_row);
+            imlib_rgb565_to_lab_row(other_row_ptr, img->w, other_l_row, a_row, b_row);
+            mve_imlib_similarity_line((uint8_t *) l_row, (uint8_t *) other_l_row, img->w, state->sumBucketsOfX,
+                                      state->sumBucketsOfY, state->sum2BucketsOfX, state->sum2BucketsOfY,
+                                      state->sum2Buckets);
+#else
             for (int x = 0, xx = (img->w + 7) / 8; x < xx; x++) {
                 for (int i = 0, ii = IM_MIN((img->w - (x * 8)), 8); i < ii; i++) {
-                    int pixel = COLOR_RGB565_TO_L(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x + i));
-                    int other_pixel = COLOR_RGB565_TO_L(IMAGE_GET_RGB565_PIXEL_FAST(other_row_ptr, x + i));
+                    int pixel = COLOR_RGB565_TO_L(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, (x * 8) + i));
+                    int other_pixel = COLOR_RGB565_TO_L(IMAGE_GET_RGB565_PIXEL_FAST(other_row_ptr, (x * 8) + i));
                     state->sumBucketsOfX[x] += pixel;
                     state->sumBucketsOfY[x] += other_pixel;
                     state->sum2BucketsOfX[x] += pixel * pixel;
@@ -78,6 +100,7 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
                     state->sum2Buckets[x] += pixel * other_pixel;
                 }
             }
+#endif
             c1 = COLOR_L_MAX * 0.01f;
             c2 = COLOR_L_MAX * 0.03f;
             break;
@@ -89,11 +112,11 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
             for (int x = 0, xx = (img->w + 7) / 8; x < xx; x++) {
                 for (int i = 0, ii = IM_MIN((img->w - (x * 8)), 8); i < ii; i++) {
 									// STM32IPL: changed to solve compiler error. int pixel = COLOR_RGB888_TO_L(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x + i));
-									rgb888_t pixel888 = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x + i);	// STM32IPL
+									rgb888_t pixel888 = IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, (x * 8) + i);	// STM32IPL
 									int pixel = COLOR_RGB888_TO_L(pixel888);	// STM32IPL
 									
                   // STM32IPL: changed to solve compiler error. int other_pixel = COLOR_RGB888_TO_L(IMAGE_GET_RGB888_PIXEL_FAST(other_row_ptr, x + i));
-									rgb888_t otherPixel888 = IMAGE_GET_RGB888_PIXEL_FAST(other_row_ptr, x + i);	// STM32IPL
+									rgb888_t otherPixel888 = IMAGE_GET_RGB888_PIXEL_FAST(other_row_ptr, (x * 8) + i);	// STM32IPL
 									int other_pixel = COLOR_RGB888_TO_L(otherPixel888);	// STM32IPL
 									
                     state->sumBucketsOfX[x] += pixel;
@@ -133,6 +156,10 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
             state->similarity_min = IM_MIN(state->similarity_min, ssim);
             state->similarity_max = IM_MAX(state->similarity_max, ssim);
 
+            if (state->map) { // STM32IPL
+                state->map[((state->lines_processed / 8) * xx) + x] = ssim;
+            }
+
             state->sumBucketsOfX[x] = 0;
             state->sumBucketsOfY[x] = 0;
             state->sum2BucketsOfX[x] = 0;
@@ -144,7 +171,8 @@ void imlib_similarity_line_op(image_t *img, int line, void *other, void *data, b
     state->lines_processed += 1;
 }
 
-void imlib_get_similarity(image_t *img, const char *path, image_t *other, int scalar, float *avg, float *std, float *min, float *max)
+void imlib_get_similarity(image_t *img, const char *path, image_t *other, int scalar, float *avg, float *std, float *min, float *max,
+                          float *map) // STM32IPL: map
 {
     int h_blocks = (img->w + 7) / 8;
     int v_blocks = (img->h + 7) / 8;
@@ -162,6 +190,10 @@ void imlib_get_similarity(image_t *img, const char *path, image_t *other, int sc
     state.similarity_min = FLT_MAX;
     state.similarity_max = -FLT_MAX;
     state.lines_processed = 0;
+    state.map = map; // STM32IPL
+#ifdef IPL_STATS_HAS_MVE
+    state.l_rows = (img->bpp == IMAGE_BPP_RGB565) ? fb_alloc(img->w * 4, FB_ALLOC_NO_HINT) : NULL; // STM32IPL
+#endif
 
     imlib_image_operation(img, path, other, scalar, imlib_similarity_line_op, &state);
     *avg = state.similarity_sum / blocks;
@@ -169,6 +201,11 @@ void imlib_get_similarity(image_t *img, const char *path, image_t *other, int sc
     *min = state.similarity_min;
     *max = state.similarity_max;
 
+#ifdef IPL_STATS_HAS_MVE
+    if (state.l_rows) { // STM32IPL
+        fb_free();
+    }
+#endif
     fb_free();
     fb_free();
     fb_free();
@@ -177,6 +214,154 @@ void imlib_get_similarity(image_t *img, const char *path, image_t *other, int sc
 }
 #endif //IMLIB_ENABLE_GET_SIMILARITY
 
+// STM32IPL: number of pixels set in the roi of a binary image, counted 32 pixels (a word) at a time.
+uint32_t imlib_binary_roi_ones(image_t *ptr, rectangle_t *roi)
+{
+    uint32_t ones = 0;
+    int first = roi->x >> UINT32_T_SHIFT;
+    int last = (roi->x + roi->w - 1) >> UINT32_T_SHIFT;
+    uint32_t first_mask = 0xFFFFFFFFU << (roi->x & UINT32_T_MASK);
+    uint32_t last_mask = 0xFFFFFFFFU >> (UINT32_T_MASK - ((roi->x + roi->w - 1) & UINT32_T_MASK));
+
+    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
+        for (int i = first; i <= last; i++) {
+            uint32_t word = row_ptr[i];
+            if (i == first) {
+                word &= first_mask;
+            }
+            if (i == last) {
+                word &= last_mask;
+            }
+            ones += __builtin_popcount(word);
+        }
+    }
+
+    return ones;
+}
+
+// STM32IPL: number of non zero pixels in the roi of a grayscale image.
+uint32_t imlib_grayscale_roi_nonzero(image_t *ptr, rectangle_t *roi)
+{
+    uint32_t count = 0;
+
+    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
+#ifdef IPL_STATS_HAS_MVE
+        count += mve_imlib_count_nonzero_u8(row_ptr + roi->x, roi->w);
+#else
+        for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
+            count += (row_ptr[x] != 0);
+        }
+#endif
+    }
+
+    return count;
+}
+
+// STM32IPL: x of the first pixel set in [x, xx) of a binary row, xx when there is none; words with no pixel set
+// are skipped at once.
+int imlib_binary_find_nonzero(const uint32_t *row_ptr, int x, int xx)
+{
+    while (x < xx) {
+        uint32_t word = row_ptr[x >> UINT32_T_SHIFT] & (0xFFFFFFFFU << (x & UINT32_T_MASK));
+        if (word) {
+            return IM_MIN((x & ~UINT32_T_MASK) + __builtin_ctz(word), xx);
+        }
+        x = (x | UINT32_T_MASK) + 1;
+    }
+
+    return xx;
+}
+
+// STM32IPL: x of the first non zero pixel in [x, xx) of a grayscale row, xx when there is none; runs of zero
+// pixels are skipped 4 (16 with MVE) at a time.
+int imlib_grayscale_find_nonzero(const uint8_t *row_ptr, int x, int xx)
+{
+#ifdef IPL_STATS_HAS_MVE
+    return x + mve_imlib_find_nonzero_u8(row_ptr + x, xx - x);
+#else
+    for (; (x + 4) <= xx; x += 4) {
+        uint32_t word;
+        memcpy(&word, row_ptr + x, sizeof(word));
+        if (word) {
+            break;
+        }
+    }
+
+    for (; x < xx; x++) {
+        if (row_ptr[x]) {
+            return x;
+        }
+    }
+
+    return xx;
+#endif
+}
+
+// STM32IPL: updates min and max with the ones of a grayscale row of n pixels.
+void imlib_grayscale_row_min_max(const uint8_t *row_ptr, int n, uint8_t *min, uint8_t *max)
+{
+#ifdef IPL_STATS_HAS_MVE
+    mve_imlib_min_max_u8(row_ptr, n, min, max);
+#else
+    uint8_t row_min = *min, row_max = *max;
+
+    for (int x = 0; x < n; x++) {
+        row_min = IM_MIN(row_min, row_ptr[x]);
+        row_max = IM_MAX(row_max, row_ptr[x]);
+    }
+
+    *min = row_min;
+    *max = row_max;
+#endif
+}
+
+// STM32IPL: x of the first pixel equal to value in [x, xx) of a grayscale row, xx when there is none.
+int imlib_grayscale_find_value(const uint8_t *row_ptr, int x, int xx, uint8_t value)
+{
+#ifdef IPL_STATS_HAS_MVE
+    return x + mve_imlib_find_u8(row_ptr + x, xx - x, value);
+#else
+    for (; x < xx; x++) {
+        if (row_ptr[x] == value) {
+            return x;
+        }
+    }
+
+    return xx;
+#endif
+}
+
+// STM32IPL: counts the grayscale values of the roi into counts (256 entries). Consecutive pixels go to 4 different
+// sub-histograms, so that runs of equal values do not serialize on the increment of the same counter; the
+// sub-histograms are summed at the end.
+static void imlib_grayscale_roi_counts(image_t *ptr, rectangle_t *roi, uint32_t *counts)
+{
+    uint32_t *banks = fb_alloc0(4 * 256 * sizeof(uint32_t), FB_ALLOC_NO_HINT);
+    uint32_t *c0 = banks, *c1 = banks + 256, *c2 = banks + 512, *c3 = banks + 768;
+
+    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
+        int x = roi->x, xx = roi->x + roi->w;
+        for (; (x + 4) <= xx; x += 4) {
+            c0[row_ptr[x]]++;
+            c1[row_ptr[x + 1]]++;
+            c2[row_ptr[x + 2]]++;
+            c3[row_ptr[x + 3]]++;
+        }
+        for (; x < xx; x++) {
+            c0[row_ptr[x]]++;
+        }
+    }
+
+    for (int i = 0; i < 256; i++) {
+        counts[i] = c0[i] + c1[i] + c2[i] + c3[i];
+    }
+
+    fb_free();
+}
+
 void imlib_get_histogram(histogram_t *out, image_t *ptr, rectangle_t *roi, list_t *thresholds, bool invert, image_t *other)
 {
     switch(ptr->bpp) {
@@ -189,13 +374,10 @@ void imlib_get_histogram(histogram_t *out, image_t *ptr, rectangle_t *roi, list_
             if ((!thresholds) || (!list_size(thresholds))) {
                 // Fast histogram code when no color thresholds list...
                 if (!other) {
-                    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
-                        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
-                        for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
-                            int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
-                            ((uint32_t *) out->LBins)[fast_roundf((pixel - COLOR_BINARY_MIN) * mult)]++; // needs to be roundf
-                        }
-                    }
+                    // STM32IPL: only the number of pixels set is needed.
+                    uint32_t ones = imlib_binary_roi_ones(ptr, roi);
+                    ((uint32_t *) out->LBins)[fast_roundf((0 - COLOR_BINARY_MIN) * mult)] += pixel_count - ones;
+                    ((uint32_t *) out->LBins)[fast_roundf((1 - COLOR_BINARY_MIN) * mult)] += ones;
                 } else {
                     for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
                         uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y), *other_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(other, y);
@@ -260,13 +442,13 @@ void imlib_get_histogram(histogram_t *out, image_t *ptr, rectangle_t *roi, list_
             if ((!thresholds) || (!list_size(thresholds))) {
                 // Fast histogram code when no color thresholds list...
                 if (!other) {
-                    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
-                        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
-                        for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
-                            int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
-                            ((uint32_t *) out->LBins)[fast_roundf((pixel - COLOR_GRAYSCALE_MIN) * mult)]++; // needs to be roundf
-                        }
+                    // STM32IPL: the values are counted first, then each value is mapped to its bin once.
+                    uint32_t *counts = fb_alloc(256 * sizeof(uint32_t), FB_ALLOC_NO_HINT);
+                    imlib_grayscale_roi_counts(ptr, roi, counts);
+                    for (int pixel = COLOR_GRAYSCALE_MIN; pixel <= COLOR_GRAYSCALE_MAX; pixel++) {
+                        ((uint32_t *) out->LBins)[fast_roundf((pixel - COLOR_GRAYSCALE_MIN) * mult)] += counts[pixel];
                     }
+                    fb_free();
                 } else {
                     for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
                         uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y), *other_row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(other, y);
@@ -722,7 +904,8 @@ void imlib_get_threshold(threshold_t *out, image_bpp_t bpp, histogram_t *ptr)
             out->LValue = (ostu(ptr->LBinCount, ptr->LBins) * (COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN)) / (ptr->LBinCount - 1);
             break;
         }
-        case IMAGE_BPP_RGB565: {
+        case IMAGE_BPP_RGB565:
+        case IMAGE_BPP_RGB888: { // STM32IPL
             out->LValue = (ostu(ptr->LBinCount, ptr->LBins) * (COLOR_L_MAX - COLOR_L_MIN)) / (ptr->LBinCount - 1);
             out->AValue = (ostu(ptr->ABinCount, ptr->ABins) * (COLOR_A_MAX - COLOR_A_MIN)) / (ptr->ABinCount - 1);
             out->BValue = (ostu(ptr->BBinCount, ptr->BBins) * (COLOR_B_MAX - COLOR_B_MIN)) / (ptr->BBinCount - 1);
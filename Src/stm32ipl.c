@@ -23,25 +23,107 @@
 extern "C" {
 #endif
 
+///@cond
+/* Level of the MVE extension used by this build: 0 = none, 1 = integer, 2 = integer and floating point. */
+#if defined(ARM_MATH_MVEF) || defined(ARM_MATH_MVE_FLOAT16)
+#define IPL_MVE_LEVEL		2
+#elif defined(ARM_MATH_MVEI)
+#define IPL_MVE_LEVEL		1
+#else
+#define IPL_MVE_LEVEL		0
+#endif
+
+/* Media and VFP Feature Register 1: its MVE field has the same encoding as IPL_MVE_LEVEL and reads 0 on the cores
+ * without Helium. */
+#define IPL_MVFR1			(*(volatile const uint32_t*)0xE000EF48UL)
+#define IPL_MVFR1_MVE_Pos	8
+#define IPL_MVFR1_MVE_Msk	(0xFUL << IPL_MVFR1_MVE_Pos)
+
+/* True when the MVE implementations dispatched at run time are selected. */
+#ifdef STM32IPL_ENABLE_MVE_DETECTION
+bool ipl_mve_enabled = false;
+#else
+bool ipl_mve_enabled = (IPL_MVE_LEVEL != 0);
+#endif /* STM32IPL_ENABLE_MVE_DETECTION */
+///@endcond
+
 /**
- * @brief Initializes the memory manager used by this library.
+ * @brief Initializes the memory manager used by this library, that is the default context, and makes
+ * the default context the current one (see STM32Ipl_SetCtx()). It also selects the MVE implementations
+ * of the functions dispatched at run time, if available (see STM32Ipl_MveAvailable()).
  * @param memAddr	Address of the memory buffer allocated to STM32IPL for its internal purposes.
  * @param memSize	Size of the memory buffer (bytes).
  * @return			void.
  */
 void STM32Ipl_InitLib(void *memAddr, uint32_t memSize)
 {
+	STM32Ipl_SetCtx(NULL);
 	umm_init(memAddr, memSize);
+	mem_stats_init();
 	fb_init();
+	ipl_mve_enabled = STM32Ipl_MveAvailable();
+#ifdef STM32IPL_ENABLE_TRACE
+	STM32Ipl_TraceReset();
+#endif /* STM32IPL_ENABLE_TRACE */
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+	STM32Ipl_ResetPerfCounters();
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
 }
 
 /**
- * @brief De-initializes the memory manager of this library.
+ * @brief De-initializes the memory manager of this library, that is the default context, and makes
+ * the default context the current one; the contexts created with STM32Ipl_InitCtx() are not affected.
  * @return	void.
  */
 void STM32Ipl_DeInitLib(void)
 {
+	STM32Ipl_SetCtx(NULL);
 	umm_uninit();
+	fb_init();
+}
+
+/**
+ * @brief Tells whether the MVE (Helium) implementations can run: they must be part of this build and,
+ * when STM32IPL_ENABLE_MVE_DETECTION is defined, the core must support them, as reported by its MVFR1
+ * register. Without STM32IPL_ENABLE_MVE_DETECTION, a build including MVE code assumes the core supports it.
+ * @return	true if the MVE implementations can run, false otherwise.
+ */
+bool STM32Ipl_MveAvailable(void)
+{
+#if (IPL_MVE_LEVEL != 0) && defined(STM32IPL_ENABLE_MVE_DETECTION)
+	return ((IPL_MVFR1 & IPL_MVFR1_MVE_Msk) >> IPL_MVFR1_MVE_Pos) >= IPL_MVE_LEVEL;
+#else
+	return (IPL_MVE_LEVEL != 0);
+#endif
+}
+
+/**
+ * @brief Selects the MVE or the scalar implementations of the functions dispatched at run time, e.g. to
+ * measure the scalar path on a Helium core. STM32Ipl_InitLib() selects the MVE ones when available.
+ * The functions dispatched at run time are the format-specialized row kernels (moving window integral
+ * images of the object detection), the resize functions and the Gaussian, Laplacian, Sobel and Scharr
+ * filters; the other MVE implementations are selected at build time (IPL_*_DISABLE_MVE).
+ * @param enable	true to select the MVE implementations, false to select the scalar ones.
+ * @return			stm32ipl_err_Ok on success, stm32ipl_err_NotImplemented if enable is true and the MVE
+ * implementations are not available.
+ */
+stm32ipl_err_t STM32Ipl_SetMve(bool enable)
+{
+	if (enable && !STM32Ipl_MveAvailable())
+		return stm32ipl_err_NotImplemented;
+
+	ipl_mve_enabled = enable;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Tells whether the MVE implementations of the functions dispatched at run time are selected.
+ * @return	true if the MVE implementations are selected, false if the scalar ones are.
+ */
+bool STM32Ipl_IsMveEnabled(void)
+{
+	return ipl_mve_enabled;
 }
 
 /**
@@ -59,10 +141,117 @@ void STM32Ipl_Init(image_t *img, uint32_t width, uint32_t height, image_bpp_t fo
 		img->w = width;
 		img->h = height;
 		img->bpp = format;
+		img->stride = 0;
 		img->data = data;
 	}
 }
 
+/**
+ * @brief Initializes an image structure as a view on a rectangular region of a parent image.
+ * No pixel data is copied nor allocated: the view shares the parent's data buffer, so any change
+ * made to the view's pixels affects the parent image too. The view keeps the parent's line stride,
+ * so its lines are not tightly packed in memory. The view must not be released with STM32Ipl_ReleaseData().
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param parent	Parent image; if it is not valid, an error is returned.
+ * @param roi		Region of the parent image covered by the view; it must be fully contained within
+ * the parent image, otherwise an error is returned. For Binary images, roi->x must be a multiple of 32.
+ * @param view		View image: it must point to a valid structure, otherwise an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_InitView(const image_t *parent, const rectangle_t *roi, image_t *view)
+{
+	uint8_t *data;
+	uint32_t stride;
+
+	STM32IPL_CHECK_VALID_IMAGE(parent)
+	STM32IPL_CHECK_FORMAT(parent, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(roi)
+	STM32IPL_CHECK_VALID_PTR_ARG(view)
+
+	if ((roi->x < 0) || (roi->y < 0) || (roi->w < 1) || (roi->h < 1)
+			|| ((roi->x + roi->w) > parent->w) || ((roi->y + roi->h) > parent->h))
+		return stm32ipl_err_WrongROI;
+
+	switch (parent->bpp) {
+		case IMAGE_BPP_BINARY:
+			if (roi->x & UINT32_T_MASK)
+				return stm32ipl_err_WrongROI;
+			stride = IMAGE_BINARY_LINE_STRIDE_BYTES(parent);
+			data = (uint8_t*)(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(parent, roi->y) + (roi->x >> UINT32_T_SHIFT));
+			break;
+
+		case IMAGE_BPP_GRAYSCALE:
+			stride = IMAGE_GRAYSCALE_LINE_STRIDE_BYTES(parent);
+			data = (uint8_t*)(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(parent, roi->y) + roi->x);
+			break;
+
+		case IMAGE_BPP_RGB565:
+			stride = IMAGE_RGB565_LINE_STRIDE_BYTES(parent);
+			data = (uint8_t*)(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(parent, roi->y) + roi->x);
+			break;
+
+		case IMAGE_BPP_RGB888:
+			stride = IMAGE_RGB888_LINE_STRIDE_BYTES(parent);
+			data = (uint8_t*)(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(parent, roi->y) + roi->x);
+			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
+	}
+
+	view->w = roi->w;
+	view->h = roi->h;
+	view->bpp = parent->bpp;
+	view->stride = stride;
+	view->data = data;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Initializes a Grayscale image structure as a view on the luma (Y) plane of the source image, so that
+ * the functions working on Grayscale images can process the luminance of NV12 camera frames directly, without
+ * any conversion. No pixel data is copied nor allocated: the view shares the source's data buffer and keeps
+ * its line stride. The view must not be released with STM32Ipl_ReleaseData(). The luminance of YUV422 and Bayer
+ * images is interleaved with the chrominance, so it must be extracted with STM32Ipl_Convert().
+ * The supported formats are Grayscale, NV12.
+ * @param src	Source image; if it is not valid, an error is returned.
+ * @param view	View image: it must point to a valid structure, otherwise an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_InitLumaView(const image_t *src, image_t *view)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, (stm32ipl_if_grayscale | stm32ipl_if_nv12))
+	STM32IPL_CHECK_VALID_PTR_ARG(view)
+
+	view->w = src->w;
+	view->h = src->h;
+	view->bpp = IMAGE_BPP_GRAYSCALE;
+	view->stride = src->stride;
+	view->data = src->data;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Returns the distance (bytes) between the beginning of two consecutive lines of an image.
+ * For images that are not views, it matches the size of a single line; for NV12 images, it refers to the Y plane.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888, Bayer, YUV422, NV12.
+ * @param img	Image.
+ * @return		Line stride (bytes), 0 in case of wrong/unsupported argument.
+ */
+uint32_t STM32Ipl_ImageStride(const image_t *img)
+{
+	if (!img)
+		return 0;
+
+	if (img->stride)
+		return (uint32_t)img->stride;
+
+	return STM32Ipl_DataSize(img->w, 1, (img->bpp == IMAGE_BPP_NV12) ? IMAGE_BPP_GRAYSCALE : (image_bpp_t)img->bpp);
+}
+
 /**
  * @brief Allocates a data memory buffer to contain the image pixels and consequently
  * initializes the given image structure. The size of such buffer depends on given
@@ -90,6 +279,7 @@ stm32ipl_err_t STM32Ipl_AllocData(image_t *img, uint32_t width, uint32_t height,
 	img->w = width;
 	img->h = height;
 	img->bpp = format;
+	img->stride = 0;
 	img->data = data;
 
 	return stm32ipl_err_Ok;
@@ -121,6 +311,7 @@ stm32ipl_err_t STM32Ipl_AllocDataRef(const image_t *src, image_t *dst)
 	dst->w = src->w;
 	dst->h = src->h;
 	dst->bpp = src->bpp;
+	dst->stride = 0;
 	dst->data = data;
 
 	return stm32ipl_err_Ok;
@@ -141,7 +332,7 @@ void STM32Ipl_ReleaseData(image_t *img)
 
 /**
  * @brief Returns the size of the data memory needed to store an image with the given properties.
- * The supported formats are Binary, Grayscale, RGB565, RGB888, Bayer.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888, Bayer, YUV422, NV12.
  * @param width		Image width.
  * @param height	Image height.
  * @param format	Image format.
@@ -160,10 +351,19 @@ uint32_t STM32Ipl_DataSize(uint32_t width, uint32_t height, image_bpp_t format)
 			return width * height * sizeof(uint16_t);
 
 		case IMAGE_BPP_BAYER:
+		case IMAGE_BPP_BAYER_GBRG:
+		case IMAGE_BPP_BAYER_GRBG:
+		case IMAGE_BPP_BAYER_RGGB:
 			return width * height * sizeof(uint8_t);
 
 		case IMAGE_BPP_RGB888:
 			return width * height * 3;
+
+		case IMAGE_BPP_YUV422:
+			return ((width + 1) / 2) * 4 * height;
+
+		case IMAGE_BPP_NV12:
+			return (width * height) + (((width + 1) / 2) * 2 * ((height + 1) / 2));
 	}
 
 	return 0;
@@ -171,7 +371,7 @@ uint32_t STM32Ipl_DataSize(uint32_t width, uint32_t height, image_bpp_t format)
 
 /**
  * @brief Returns the size (bytes) of the data buffer of an image.
- * The supported formats are Binary, Grayscale, RGB565, RGB888, Bayer.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888, Bayer, YUV422, NV12.
  * @param img	Image.
  * @return		Size of the image data buffer (bytes), 0 in case of wrong/unsupported argument.
  */
@@ -207,6 +407,21 @@ bool STM32Ipl_ImageFormatSupported(const image_t *img, uint32_t formats)
 			format = stm32ipl_if_rgb888;
 			break;
 
+		case IMAGE_BPP_YUV422:
+			format = stm32ipl_if_yuv422;
+			break;
+
+		case IMAGE_BPP_NV12:
+			format = stm32ipl_if_nv12;
+			break;
+
+		case IMAGE_BPP_BAYER:
+		case IMAGE_BPP_BAYER_GBRG:
+		case IMAGE_BPP_BAYER_GRBG:
+		case IMAGE_BPP_BAYER_RGGB:
+			format = stm32ipl_if_bayer;
+			break;
+
 		default:
 			return false;
 	}
@@ -248,9 +463,14 @@ stm32ipl_err_t STM32Ipl_CopyData(const image_t *src, image_t *dst)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_SAME_SIZE(src, dst)
 	STM32IPL_CHECK_SAME_FORMAT(src, dst)
+	STM32IPL_TRACE_BEGIN(CopyData)
 
-	memcpy(dst->data, src->data, STM32Ipl_ImageDataSize(dst));
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (ipl_hw_copy(src, NULL, dst, true) != stm32ipl_err_Ok)
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+	image_copy_data(dst, (image_t*)src);
 
+	STM32IPL_TRACE_END(CopyData)
 	return stm32ipl_err_Ok;
 }
 
@@ -288,11 +508,14 @@ stm32ipl_err_t STM32Ipl_Clone(const image_t *src, image_t *dst)
 		dst->w = src->w;
 		dst->h = src->h;
 		dst->bpp = src->bpp;
+		dst->stride = 0;
 		dst->data = data;
 	}
 
-	memcpy(dst->data, src->data, size);
+	STM32IPL_TRACE_BEGIN(Clone)
+	image_copy_data(dst, (image_t*)src);
 
+	STM32IPL_TRACE_END(Clone)
 	return stm32ipl_err_Ok;
 }
 
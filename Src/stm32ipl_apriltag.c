@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_apriltag.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - AprilTag detection module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IMLIB_ENABLE_APRILTAGS
+
+#define STM32IPL_APRILTAG_FAMILIES	(TAG16H5 | TAG25H7 | TAG25H9 | TAG36H10 | TAG36H11 | ARTOOLKIT)
+
+/**
+ * @brief Finds the AprilTags of the given families in the image. Returns a list of detected tags.
+ * The quads (tag candidates) can be searched in a decimated image, which reduces both the execution time
+ * and the working memory, while the tags are always decoded at full resolution; the working memory is
+ * bounded (the cluster hash table no longer takes all the free memory) and can be further limited.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param out		List of find_apriltags_list_lnk_data_t objects representing the tags found.
+ * @param roi		Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param families	Tag families to be searched: OR combination of apriltag_families_t values.
+ * @param opts		Optional detection options (decimation, memory budget, maximum number of detections,
+ * camera parameters); when not defined, the default values are used.
+ * @return			stm32ipl_err_Ok on success, stm32ipl_err_OutOfMemory if the working memory is not enough
+ * (or larger than opts->maxMemory), error otherwise.
+ * @note Without IMLIB_ENABLE_HIGH_RES_APRILTAGS, the (decimated) ROI must have less than 65536 pixels.
+ * @note The working memory is about w * h * (1 + 5 / (decimate * decimate)) bytes, plus the memory
+ * for the clusters and the detections, which is dynamically allocated.
+ */
+stm32ipl_err_t STM32Ipl_FindAprilTags(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t families,
+		const stm32ipl_apriltag_opts_t *opts)
+{
+	rectangle_t realRoi;
+	uint32_t decimate = 1;
+	uint32_t maxMemory = 0;
+	uint32_t maxDetections = 0;
+	float fx;
+	float fy;
+	float cx;
+	float cy;
+	bool ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	if ((families == 0) || (families & ~STM32IPL_APRILTAG_FAMILIES))
+		return stm32ipl_err_InvalidParameter;
+
+	if (opts) {
+		if (opts->decimate)
+			decimate = opts->decimate;
+		maxMemory = opts->maxMemory;
+		maxDetections = opts->maxDetections;
+	}
+
+	if ((realRoi.w < decimate) || (realRoi.h < decimate))
+		return stm32ipl_err_InvalidParameter;
+
+#ifndef IMLIB_ENABLE_HIGH_RES_APRILTAGS
+	if (((realRoi.w / decimate) * (realRoi.h / decimate)) >= 65536)
+		return stm32ipl_err_InvalidParameter;
+#endif /* IMLIB_ENABLE_HIGH_RES_APRILTAGS */
+
+	fx = (opts && (opts->fx != 0.0f)) ? opts->fx : ((2.8f / 3.984f) * 656);
+	fy = (opts && (opts->fy != 0.0f)) ? opts->fy : ((2.8f / 2.952f) * 488);
+	cx = (opts && (opts->cx != 0.0f)) ? opts->cx : (realRoi.w * 0.5f);
+	cy = (opts && (opts->cy != 0.0f)) ? opts->cy : (realRoi.h * 0.5f);
+
+	STM32IPL_TRACE_BEGIN(FindAprilTags)
+	ok = imlib_find_apriltags(out, (image_t*)img, &realRoi, (apriltag_families_t)families, fx, fy, cx, cy,
+			decimate, maxMemory, maxDetections);
+
+	STM32IPL_TRACE_END(FindAprilTags)
+	return ok ? stm32ipl_err_Ok : stm32ipl_err_OutOfMemory;
+}
+
+#endif /* IMLIB_ENABLE_APRILTAGS */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,478 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_benchmark.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - benchmark module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+#define IPL_HAS_DWT
+#define IPL_DEMCR				(*(volatile uint32_t*)0xE000EDFCUL)	/* Debug Exception and Monitor Control Register. */
+#define IPL_DEMCR_TRCENA		(1UL << 24)
+#define IPL_DWT_CTRL			(*(volatile uint32_t*)0xE0001000UL)	/* DWT Control Register. */
+#define IPL_DWT_CTRL_CYCCNTENA	(1UL << 0)
+#define IPL_DWT_CYCCNT			(*(volatile uint32_t*)0xE0001004UL)	/* DWT Cycle Count Register. */
+#define IPL_DWT_LAR				(*(volatile uint32_t*)0xE0001FB0UL)	/* DWT Lock Access Register (Cortex-M7 only). */
+#define IPL_DWT_LAR_KEY			0xC5ACCE55UL
+#endif
+///@endcond
+
+/**
+ * @brief Enables the cycle counter used to measure the execution time of the library functions.
+ * By default, the DWT CYCCNT counter of the Cortex-M core is used; this weak function can be
+ * re-defined by the application to use a different time base.
+ * @return	void.
+ */
+__attribute__((weak)) void STM32Ipl_CycleCounterInit(void)
+{
+#ifdef IPL_HAS_DWT
+	IPL_DEMCR |= IPL_DEMCR_TRCENA;
+#ifdef __ARM_ARCH_7EM__
+	IPL_DWT_LAR = IPL_DWT_LAR_KEY;
+#endif
+	IPL_DWT_CYCCNT = 0;
+	IPL_DWT_CTRL |= IPL_DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+/**
+ * @brief Gets the current value of the cycle counter enabled with STM32Ipl_CycleCounterInit().
+ * This weak function can be re-defined by the application to use a different time base.
+ * @return	Value of the cycle counter; zero when no cycle counter is available.
+ */
+__attribute__((weak)) uint32_t STM32Ipl_CycleCounterGet(void)
+{
+#ifdef IPL_HAS_DWT
+	return IPL_DWT_CYCCNT;
+#else
+	return 0;
+#endif
+}
+
+#ifdef STM32IPL_ENABLE_BENCHMARK
+
+///@cond
+#define IPL_BENCH_RUNS		3	/* Number of timed runs of each case; the minimum is reported. */
+#define IPL_BENCH_LINE_LEN	128	/* Max length of a line of the report. */
+
+#if defined(IPL_RESIZE_HAS_MVE) || defined(IPL_BINARY_HAS_MVE) || defined(IPL_MATOP_HAS_MVE) \
+	|| defined(IPL_FILTER_HAS_MVE) || defined(IPL_DRAW_HAS_MVE) || defined(IPL_CONVERT_HAS_MVE)
+#define IPL_BENCH_MVE		1
+#else
+#define IPL_BENCH_MVE		0
+#endif
+
+/* Benchmark case: runs the function under test on src (and dst, when used). */
+typedef struct _ipl_bench_case_t
+{
+	const char *name;
+	stm32ipl_err_t (*run)(image_t *src, image_t *dst);
+} ipl_bench_case_t;
+
+/* Benchmark image size. */
+typedef struct _ipl_bench_size_t
+{
+	const char *name;
+	uint16_t w;
+	uint16_t h;
+} ipl_bench_size_t;
+///@endcond
+
+static stm32ipl_err_t ipl_bench_Invert(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Invert(src);
+}
+
+static stm32ipl_err_t ipl_bench_GammaCorr(image_t *src, image_t *dst)
+{
+	return STM32Ipl_GammaCorr(src, 1.5f, 1.1f, 0.1f);
+}
+
+static stm32ipl_err_t ipl_bench_HistEq(image_t *src, image_t *dst)
+{
+	return STM32Ipl_HistEq(src, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_HistEqClahe(image_t *src, image_t *dst)
+{
+	return STM32Ipl_HistEqClahe(src, 2.0f, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_MeanFilter(image_t *src, image_t *dst)
+{
+	return STM32Ipl_MeanFilter(src, 1, false, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_MedianFilter(image_t *src, image_t *dst)
+{
+	return STM32Ipl_MedianFilter(src, 1, 0.5f, false, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_ModeFilter(image_t *src, image_t *dst)
+{
+	return STM32Ipl_ModeFilter(src, 1, false, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_MidpointFilter(image_t *src, image_t *dst)
+{
+	return STM32Ipl_MidpointFilter(src, 1, 0.5f, false, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_BilateralFilter(image_t *src, image_t *dst)
+{
+	return STM32Ipl_BilateralFilter(src, 1, 0.1f, 1.0f, false, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Gaussian(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Gaussian(src, 1, false, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Laplacian(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Laplacian(src, 1, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Sobel(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Sobel(src, 1, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Erode(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Erode(src, 1, 0, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Dilate(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Dilate(src, 1, 0, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_EdgeSimple(image_t *src, image_t *dst)
+{
+	return STM32Ipl_EdgeSimple(src, NULL, 50, 100);
+}
+
+static stm32ipl_err_t ipl_bench_EdgeCanny(image_t *src, image_t *dst)
+{
+	return STM32Ipl_EdgeCanny(src, NULL, 50, 100);
+}
+
+static stm32ipl_err_t ipl_bench_LensCorr(image_t *src, image_t *dst)
+{
+	return STM32Ipl_LensCorr(src, 1.8f, 1.0f, 0.0f, 0.0f);
+}
+
+static stm32ipl_err_t ipl_bench_Copy(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Copy(src, dst);
+}
+
+static stm32ipl_err_t ipl_bench_Convert(image_t *src, image_t *dst)
+{
+	/* Converts to Grayscale, or to RGB565 the Grayscale images. */
+	dst->bpp = (src->bpp == IMAGE_BPP_GRAYSCALE) ? IMAGE_BPP_RGB565 : IMAGE_BPP_GRAYSCALE;
+
+	return STM32Ipl_Convert(src, dst);
+}
+
+static stm32ipl_err_t ipl_bench_ResizeNearest(image_t *src, image_t *dst)
+{
+	dst->w = src->w / 2;
+	dst->h = src->h / 2;
+
+	return STM32Ipl_Resize(src, dst, RESIZE_NEAREST);
+}
+
+static stm32ipl_err_t ipl_bench_ResizeBilinear(image_t *src, image_t *dst)
+{
+	dst->w = src->w / 2;
+	dst->h = src->h / 2;
+
+	return STM32Ipl_Resize(src, dst, RESIZE_BILINEAR);
+}
+
+static stm32ipl_err_t ipl_bench_Downscale(image_t *src, image_t *dst)
+{
+	dst->w = src->w / 2;
+	dst->h = src->h / 2;
+
+	return STM32Ipl_Downscale(src, dst, false);
+}
+
+static stm32ipl_err_t ipl_bench_MeanPool(image_t *src, image_t *dst)
+{
+	dst->w = src->w / 2;
+	dst->h = src->h / 2;
+
+	return STM32Ipl_MeanPool(src, dst, 2, 2);
+}
+
+static stm32ipl_err_t ipl_bench_Flip(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Flip(src, dst);
+}
+
+static stm32ipl_err_t ipl_bench_Mirror(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Mirror(src, dst);
+}
+
+static stm32ipl_err_t ipl_bench_Rotation180(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Rotation180(src, dst);
+}
+
+static stm32ipl_err_t ipl_bench_Add(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Add(src, dst, 0, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Sub(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Sub(src, dst, 0, false, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Diff(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Diff(src, dst, 0, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_Max(image_t *src, image_t *dst)
+{
+	return STM32Ipl_Max(src, dst, 0, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_GetStatistics(image_t *src, image_t *dst)
+{
+	statistics_t stats;
+
+	return STM32Ipl_GetStatistics(src, &stats, NULL);
+}
+
+static stm32ipl_err_t ipl_bench_GetMean(image_t *src, image_t *dst)
+{
+	int32_t r, g, b;
+
+	return STM32Ipl_GetMean(src, &r, &g, &b);
+}
+
+static stm32ipl_err_t ipl_bench_CountNonZero(image_t *src, image_t *dst)
+{
+	uint32_t count;
+
+	return STM32Ipl_CountNonZero(src, &count, NULL);
+}
+
+/* Cases to be measured. */
+static const ipl_bench_case_t g_ipl_bench_cases[] = {
+	{ "Invert", ipl_bench_Invert },
+	{ "GammaCorr", ipl_bench_GammaCorr },
+	{ "HistEq", ipl_bench_HistEq },
+	{ "HistEqClahe", ipl_bench_HistEqClahe },
+	{ "MeanFilter", ipl_bench_MeanFilter },
+	{ "MedianFilter", ipl_bench_MedianFilter },
+	{ "ModeFilter", ipl_bench_ModeFilter },
+	{ "MidpointFilter", ipl_bench_MidpointFilter },
+	{ "BilateralFilter", ipl_bench_BilateralFilter },
+	{ "Gaussian", ipl_bench_Gaussian },
+	{ "Laplacian", ipl_bench_Laplacian },
+	{ "Sobel", ipl_bench_Sobel },
+	{ "Erode", ipl_bench_Erode },
+	{ "Dilate", ipl_bench_Dilate },
+	{ "EdgeSimple", ipl_bench_EdgeSimple },
+	{ "EdgeCanny", ipl_bench_EdgeCanny },
+	{ "LensCorr", ipl_bench_LensCorr },
+	{ "Copy", ipl_bench_Copy },
+	{ "Convert", ipl_bench_Convert },
+	{ "ResizeNearest", ipl_bench_ResizeNearest },
+	{ "ResizeBilinear", ipl_bench_ResizeBilinear },
+	{ "Downscale", ipl_bench_Downscale },
+	{ "MeanPool", ipl_bench_MeanPool },
+	{ "Flip", ipl_bench_Flip },
+	{ "Mirror", ipl_bench_Mirror },
+	{ "Rotation180", ipl_bench_Rotation180 },
+	{ "Add", ipl_bench_Add },
+	{ "Sub", ipl_bench_Sub },
+	{ "Diff", ipl_bench_Diff },
+	{ "Max", ipl_bench_Max },
+	{ "GetStatistics", ipl_bench_GetStatistics },
+	{ "GetMean", ipl_bench_GetMean },
+	{ "CountNonZero", ipl_bench_CountNonZero },
+};
+
+static const ipl_bench_size_t g_ipl_bench_sizes[] = {
+	{ "QQVGA", 160, 120 },
+	{ "QVGA", 320, 240 },
+	{ "VGA", 640, 480 }
+};
+
+static const image_bpp_t g_ipl_bench_formats[] = {
+	IMAGE_BPP_BINARY,
+	IMAGE_BPP_GRAYSCALE,
+	IMAGE_BPP_RGB565,
+	IMAGE_BPP_RGB888
+};
+
+/*
+ * @brief Returns the name of the given format.
+ * @param format	Format.
+ * @return			Name of the format.
+ */
+static const char* ipl_bench_format_name(image_bpp_t format)
+{
+	switch (format) {
+		case IMAGE_BPP_BINARY:
+			return "binary";
+
+		case IMAGE_BPP_GRAYSCALE:
+			return "grayscale";
+
+		case IMAGE_BPP_RGB565:
+			return "rgb565";
+
+		case IMAGE_BPP_RGB888:
+			return "rgb888";
+
+		default:
+			return "unknown";
+	}
+}
+
+/*
+ * @brief Fills the given buffer with pseudo-random data, always the same for the same size.
+ * @param data	Buffer.
+ * @param size	Size of the buffer (bytes).
+ * @return		void.
+ */
+static void ipl_bench_fill(uint8_t *data, uint32_t size)
+{
+	uint32_t seed = 0x12345678UL;
+
+	for (uint32_t i = 0; i < size; i++) {
+		seed = (seed * 1664525UL) + 1013904223UL;
+		data[i] = (uint8_t)(seed >> 24);
+	}
+}
+
+/*
+ * @brief Measures all the cases for the given image size and format, with the images placed
+ * in the given memory region, and writes one line of the report for each case.
+ */
+static void ipl_bench_run_cases(const ipl_bench_size_t *size, image_bpp_t format, const char *placement,
+		uint8_t *mem, uint32_t memSize, void (*out)(const char *line))
+{
+	char line[IPL_BENCH_LINE_LEN];
+	uint32_t dataSize = STM32Ipl_DataSize(size->w, size->h, format);
+	/* The destination buffer must be able to contain also the RGB565 conversion of a Grayscale image. */
+	uint32_t dstSize = STM32Ipl_DataSize(size->w, size->h, IMAGE_BPP_RGB565);
+	uint8_t *srcData = mem;
+	uint8_t *dstData;
+
+	dstSize = (dataSize > dstSize) ? dataSize : dstSize;
+	dstData = srcData + ((dataSize + 31) & ~31UL);
+
+	if ((uint32_t)(dstData - mem) + dstSize > memSize)
+		return;
+
+	for (uint32_t i = 0; i < sizeof(g_ipl_bench_cases) / sizeof(g_ipl_bench_cases[0]); i++) {
+		const ipl_bench_case_t *c = &g_ipl_bench_cases[i];
+		stm32ipl_err_t ret = stm32ipl_err_Ok;
+		uint32_t minCycles = UINT32_MAX;
+
+		/* The first run is not timed: it warms up the caches. */
+		for (uint32_t run = 0; run <= IPL_BENCH_RUNS; run++) {
+			image_t src;
+			image_t dst;
+			uint32_t cycles;
+
+			STM32Ipl_Init(&src, size->w, size->h, format, srcData);
+			STM32Ipl_Init(&dst, size->w, size->h, format, dstData);
+			ipl_bench_fill(srcData, dataSize);
+			ipl_bench_fill(dstData, dataSize);
+
+			cycles = STM32Ipl_CycleCounterGet();
+			ret = c->run(&src, &dst);
+			cycles = STM32Ipl_CycleCounterGet() - cycles;
+
+			if ((run > 0) && (cycles < minCycles))
+				minCycles = cycles;
+		}
+
+		snprintf(line, sizeof(line), "%s,%s,%s,%u,%u,%s,%d,%d,%lu\r\n", c->name, ipl_bench_format_name(format),
+				size->name, size->w, size->h, placement, IPL_BENCH_MVE && STM32Ipl_IsMveEnabled(), (int)ret,
+				(unsigned long)minCycles);
+		out(line);
+	}
+}
+
+/**
+ * @brief Measures the execution time (cycles) of the main library functions, for each supported
+ * format, for QQVGA, QVGA and VGA images and for each of the given memory regions, where the images are placed.
+ * The report is written as CSV text, one line at a time, through the given output function
+ * (i.e. to ITM or UART); the columns are: function, format, size, width, height, placement (int or ext),
+ * MVE (1 if the library is built with MVE support, 0 otherwise), status (the error code returned by the
+ * function), cycles (minimum over the timed runs). The cases whose images do not fit in the region are skipped.
+ * The library must be already initialized with STM32Ipl_InitLib(): the temporary buffers of the functions
+ * are taken from there (or from the regions assigned with STM32Ipl_InitFbStack()).
+ * To compare the MVE and the scalar implementations, run the benchmark on two builds, the second one
+ * with IPL_DISABLE_MVE_ALL defined.
+ * @param intMemAddr	Internal memory region for the images; it can be null.
+ * @param intMemSize	Size of the internal memory region (bytes).
+ * @param extMemAddr	External memory region for the images; it can be null.
+ * @param extMemSize	Size of the external memory region (bytes).
+ * @param out			Function used to write the report; if it is not valid, an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Benchmark(void *intMemAddr, uint32_t intMemSize, void *extMemAddr, uint32_t extMemSize,
+		void (*out)(const char *line))
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+
+	if (!intMemAddr && !extMemAddr)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_CycleCounterInit();
+
+	out("function,format,size,width,height,placement,mve,status,cycles\r\n");
+
+	for (uint32_t s = 0; s < sizeof(g_ipl_bench_sizes) / sizeof(g_ipl_bench_sizes[0]); s++) {
+		for (uint32_t f = 0; f < sizeof(g_ipl_bench_formats) / sizeof(g_ipl_bench_formats[0]); f++) {
+			if (intMemAddr)
+				ipl_bench_run_cases(&g_ipl_bench_sizes[s], g_ipl_bench_formats[f], "int", (uint8_t*)intMemAddr,
+						intMemSize, out);
+
+			if (extMemAddr)
+				ipl_bench_run_cases(&g_ipl_bench_sizes[s], g_ipl_bench_formats[f], "ext", (uint8_t*)extMemAddr,
+						extMemSize, out);
+		}
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+#endif /* STM32IPL_ENABLE_BENCHMARK */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,449 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_bgmodel.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - background model module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+#ifdef IPL_BGMODEL_HAS_MVE
+#include "mve_bgmodel.h"
+#endif /* IPL_BGMODEL_HAS_MVE */
+#ifdef IPL_CONVERT_HAS_MVE
+#include "mve_convert.h"
+#endif /* IPL_CONVERT_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_BG_FRAC			7	/* Fractional bits of the background. */
+#define IPL_BG_MAX_RATE		7	/* Maximum adaptation speed shift. */
+
+/* Number of background entries of a row: the rows are padded to a multiple of 16 pixels. */
+#define IPL_BG_ROW_LEN(w)	(((w) + 15) & ~(uint32_t)15)
+
+/* Number of blocks covering the given number of pixels. */
+#define IPL_BG_BLOCKS(n)	(((n) + (STM32IPL_BG_BLOCK_SIZE - 1)) / STM32IPL_BG_BLOCK_SIZE)
+
+/* Index, within its group of 16 pixels, of the background entry of pixel i of the group: the 8 even pixels come
+ * first, then the 8 odd ones, so that the MVE kernel reads them as the two halves of a widened 8-bit vector. */
+#define IPL_BG_ENTRY(i)		((((i) & 1) << 3) | ((i) >> 1))
+
+/* Gets the luminance of row y of the image: grayscale rows are returned as they are, the others are converted
+ * to the given buffer. */
+static const uint8_t* ipl_bg_luma_row(const image_t *img, uint32_t y, uint8_t *buf)
+{
+	switch (img->bpp) {
+		case IMAGE_BPP_GRAYSCALE:
+			return IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+		case IMAGE_BPP_RGB565: {
+			const uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+#ifdef IPL_CONVERT_HAS_MVE
+			mve_convert_rgb565_to_y8(row, buf, img->w, false);
+#else
+			for (uint32_t x = 0; x < img->w; x++)
+				buf[x] = COLOR_RGB565_TO_Y(row[x]);
+#endif /* IPL_CONVERT_HAS_MVE */
+			return buf;
+		}
+
+		default: {
+			const rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+#ifdef IPL_CONVERT_HAS_MVE
+			mve_convert_rgb888_to_y8((const uint8_t*)row, buf, img->w, false);
+#else
+			for (uint32_t x = 0; x < img->w; x++)
+				buf[x] = COLOR_RGB888_TO_GRAYSCALE(row[x]);
+#endif /* IPL_CONVERT_HAS_MVE */
+			return buf;
+		}
+	}
+}
+
+/* Processes n pixels (from a multiple of 16) of a row: the foreground bits are written to fg, 16 per half-word,
+ * and the background is updated when update is true (but for the foreground pixels when selective is true). */
+static void ipl_bg_span(const stm32ipl_bg_model_t *model, const uint8_t *src, int16_t *bg, uint16_t *fg, uint32_t n,
+		bool update)
+{
+#ifdef IPL_BGMODEL_HAS_MVE
+	mve_bgmodel_span(src, bg, fg, n, (model->method == stm32ipl_bg_approx_median), model->rate, model->threshold,
+			update, model->selective);
+#else
+	int32_t step = (1 << IPL_BG_FRAC) >> model->rate;
+
+	for (uint32_t x = 0; x < n; x += 16, bg += 16) {
+		uint32_t groupLen = IM_MIN(16, n - x);
+		uint16_t bits = 0;
+
+		for (uint32_t i = 0; i < groupLen; i++) {
+			int16_t *entry = bg + IPL_BG_ENTRY(i);
+			int32_t pix = src[x + i];
+			bool isFg = abs(pix - (*entry >> IPL_BG_FRAC)) > model->threshold;
+
+			if (isFg)
+				bits |= 1 << i;
+
+			if (update && !(isFg && model->selective)) {
+				int32_t diff = (pix << IPL_BG_FRAC) - *entry;
+
+				if (model->method == stm32ipl_bg_running_avg)
+					diff = model->rate ? ((diff + (1 << (model->rate - 1))) >> model->rate) : diff;
+				else
+					diff = IM_MAX(IM_MIN(diff, step), -step);
+
+				*entry += diff;
+			}
+		}
+
+		*fg++ = bits;
+	}
+#endif /* IPL_BGMODEL_HAS_MVE */
+}
+
+/* Adds the sum of each block of a row of n pixels to the corresponding entry of sums. */
+static void ipl_bg_block_sums(const uint8_t *src, uint32_t n, uint32_t *sums)
+{
+#ifdef IPL_BGMODEL_HAS_MVE
+	mve_bgmodel_block_sums(src, n, sums);
+#else
+	for (uint32_t x = 0; x < n; x++)
+		sums[x / STM32IPL_BG_BLOCK_SIZE] += src[x];
+#endif /* IPL_BGMODEL_HAS_MVE */
+}
+
+/* Checks the arguments shared by STM32Ipl_BgModelUpdate() and STM32Ipl_BgModelGetForeground(). */
+static stm32ipl_err_t ipl_bg_check(const stm32ipl_bg_model_t *model, const image_t *img, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(model)
+	STM32IPL_CHECK_VALID_PTR_ARG(model->model)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, stm32ipl_if_grayscale | STM32IPL_IF_RGB_ONLY)
+
+	if ((img->w != model->w) || (img->h != model->h))
+		return stm32ipl_err_WrongSize;
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, stm32ipl_if_binary)
+		STM32IPL_CHECK_SAME_SIZE(img, mask)
+	}
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
+/**
+ * @brief Creates a background model for motion detection, seeded with the first frame. The background luminance
+ * of each pixel is kept in fixed point and is updated by STM32Ipl_BgModelUpdate() with one of two methods: the
+ * running average, that moves the background by 1/2^rate of its difference from the frame, or the approximate
+ * median, that moves it towards the frame by 1/2^rate of a luminance level at most. When skipThreshold is not zero,
+ * the blocks of STM32IPL_BG_BLOCK_SIZE x STM32IPL_BG_BLOCK_SIZE pixels whose mean luminance differs by no more than
+ * skipThreshold from the last time they were processed, and that had no foreground pixels then, are skipped: their
+ * background is not updated and they have no foreground pixels. The model buffers are allocated by this function
+ * and must be released with STM32Ipl_BgModelRelease().
+ * The supported formats are Grayscale, RGB565, RGB888 (the luminance of the color frames is used).
+ * @param model			Background model; if it is not valid, an error is returned.
+ * @param first			First frame; if it is not valid, an error is returned. The following frames must have
+ * its size.
+ * @param method		Update method.
+ * @param rate			Adaptation speed, as a right shift: 0 is the fastest; it must be in the range [0, 7],
+ * otherwise an error is returned.
+ * @param threshold		Minimum absolute difference between a pixel and its background for the pixel to be
+ * foreground.
+ * @param skipThreshold	Maximum mean luminance change of the blocks that can be skipped; 0 to process all the blocks.
+ * @param selective		If true, the foreground pixels do not update the background, so that slowly moving objects
+ * are not absorbed into it.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BgModelInit(stm32ipl_bg_model_t *model, const image_t *first, stm32ipl_bg_method_t method,
+		uint8_t rate, uint8_t threshold, uint8_t skipThreshold, bool selective)
+{
+	uint32_t rowLen;
+	uint32_t blocksX;
+	uint32_t blocksY;
+	uint32_t *sums = NULL;
+	uint8_t *buf = NULL;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(model)
+	STM32IPL_CHECK_VALID_IMAGE(first)
+	STM32IPL_CHECK_FORMAT(first, stm32ipl_if_grayscale | STM32IPL_IF_RGB_ONLY)
+
+	if ((method != stm32ipl_bg_running_avg && method != stm32ipl_bg_approx_median) || (rate > IPL_BG_MAX_RATE))
+		return stm32ipl_err_InvalidParameter;
+
+	memset(model, 0, sizeof(stm32ipl_bg_model_t));
+
+	rowLen = IPL_BG_ROW_LEN(first->w);
+	blocksX = IPL_BG_BLOCKS(first->w);
+	blocksY = IPL_BG_BLOCKS(first->h);
+
+	model->model = xalloc0(rowLen * first->h * sizeof(int16_t));
+	if (!model->model)
+		return stm32ipl_err_OutOfMemory;
+
+	if (skipThreshold) {
+		model->blockSum = xalloc0(blocksX * blocksY * sizeof(uint16_t));
+		model->blockFg = xalloc0(blocksX * blocksY);
+		sums = fb_alloc0(blocksX * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+		if (!model->blockSum || !model->blockFg || !sums) {
+			if (sums)
+				fb_free();
+			STM32Ipl_BgModelRelease(model);
+			return stm32ipl_err_OutOfMemory;
+		}
+	}
+
+	if (first->bpp != IMAGE_BPP_GRAYSCALE) {
+		buf = fb_alloc(first->w, FB_ALLOC_PREFER_SPEED);
+		if (!buf) {
+			if (sums)
+				fb_free();
+			STM32Ipl_BgModelRelease(model);
+			return stm32ipl_err_OutOfMemory;
+		}
+	}
+
+	model->w = first->w;
+	model->h = first->h;
+	model->method = method;
+	model->rate = rate;
+	model->threshold = threshold;
+	model->skipThreshold = skipThreshold;
+	model->selective = selective;
+
+	for (uint32_t y = 0; y < first->h; y++) {
+		const uint8_t *luma = ipl_bg_luma_row(first, y, buf);
+		int16_t *bg = model->model + (y * rowLen);
+
+		for (uint32_t x = 0; x < first->w; x++)
+			bg[(x & ~15) + IPL_BG_ENTRY(x & 15)] = luma[x] << IPL_BG_FRAC;
+
+		if (sums) {
+			ipl_bg_block_sums(luma, first->w, sums);
+
+			if (((y + 1) % STM32IPL_BG_BLOCK_SIZE == 0) || (y + 1 == first->h)) {
+				uint16_t *blockSum = model->blockSum + ((y / STM32IPL_BG_BLOCK_SIZE) * blocksX);
+
+				for (uint32_t bx = 0; bx < blocksX; bx++) {
+					blockSum[bx] = sums[bx];
+					sums[bx] = 0;
+				}
+			}
+		}
+	}
+
+	if (buf)
+		fb_free();
+
+	if (sums)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Updates the background model with a new frame and gets its foreground mask in the same pass: each
+ * pixel is compared with its background before the update. The blocks skipped as unchanged (see
+ * STM32Ipl_BgModelInit()) are not updated and have no foreground pixels.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param model	Background model created with STM32Ipl_BgModelInit(); if it is not valid, an error is returned.
+ * @param img	Frame; it must have the size of the first frame, otherwise an error is returned.
+ * @param mask	Binary image receiving the foreground mask (1 for the foreground pixels); it must have the size of
+ * the frame, otherwise an error is returned; it can be null if only the model must be updated.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BgModelUpdate(stm32ipl_bg_model_t *model, const image_t *img, image_t *mask)
+{
+	stm32ipl_err_t res;
+	uint32_t rowLen;
+	uint32_t blocksX;
+	uint32_t bandRows;
+	uint32_t nAlloc = 0;
+	uint16_t *fgBuf = NULL;
+	uint8_t *band = NULL;
+	uint32_t *sums = NULL;
+	uint8_t *skip = NULL;
+
+	res = ipl_bg_check(model, img, mask);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	rowLen = IPL_BG_ROW_LEN(img->w);
+	blocksX = IPL_BG_BLOCKS(img->w);
+
+	/* The luminance of the color frames is converted by bands of one block, as the skipped blocks must be known
+	 * before processing their rows. */
+	bandRows = model->skipThreshold ? STM32IPL_BG_BLOCK_SIZE : 1;
+
+	if (!mask) {
+		fgBuf = fb_alloc(blocksX * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+		nAlloc += (fgBuf != NULL);
+	}
+
+	if (img->bpp != IMAGE_BPP_GRAYSCALE) {
+		band = fb_alloc(bandRows * img->w, FB_ALLOC_PREFER_SPEED);
+		nAlloc += (band != NULL);
+	}
+
+	if (model->skipThreshold) {
+		sums = fb_alloc(blocksX * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+		nAlloc += (sums != NULL);
+		skip = fb_alloc(blocksX, FB_ALLOC_PREFER_SPEED);
+		nAlloc += (skip != NULL);
+	}
+
+	if ((!mask && !fgBuf) || (img->bpp != IMAGE_BPP_GRAYSCALE && !band) || (model->skipThreshold && (!sums || !skip))) {
+		while (nAlloc--)
+			fb_free();
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(BgModelUpdate)
+
+	for (uint32_t y0 = 0; y0 < img->h; y0 += bandRows) {
+		uint32_t rows = IM_MIN(bandRows, img->h - y0);
+		uint32_t blockRow = (y0 / STM32IPL_BG_BLOCK_SIZE) * blocksX;
+		const uint8_t *luma[STM32IPL_BG_BLOCK_SIZE];
+
+		for (uint32_t r = 0; r < rows; r++)
+			luma[r] = ipl_bg_luma_row(img, y0 + r, band ? (band + (r * img->w)) : NULL);
+
+		if (model->skipThreshold) {
+			memset(sums, 0, blocksX * sizeof(uint32_t));
+			for (uint32_t r = 0; r < rows; r++)
+				ipl_bg_block_sums(luma[r], img->w, sums);
+
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				uint32_t blockW = IM_MIN(STM32IPL_BG_BLOCK_SIZE, img->w - (bx * STM32IPL_BG_BLOCK_SIZE));
+				uint32_t tolerance = model->skipThreshold * blockW * rows;
+				int32_t change = (int32_t)sums[bx] - model->blockSum[blockRow + bx];
+
+				skip[bx] = !model->blockFg[blockRow + bx] && ((uint32_t)abs(change) <= tolerance);
+				if (!skip[bx]) {
+					model->blockSum[blockRow + bx] = sums[bx];
+					model->blockFg[blockRow + bx] = 0;
+				}
+			}
+		}
+
+		for (uint32_t r = 0; r < rows; r++) {
+			uint32_t y = y0 + r;
+			int16_t *bg = model->model + (y * rowLen);
+			uint16_t *fg = mask ? (uint16_t*)IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(mask, y) : fgBuf;
+
+			if (!model->skipThreshold) {
+				ipl_bg_span(model, luma[r], bg, fg, img->w, true);
+				continue;
+			}
+
+			/* Processes the runs of blocks that are not skipped. */
+			for (uint32_t bx = 0; bx < blocksX;) {
+				uint32_t bEnd = bx;
+				uint32_t x;
+
+				if (skip[bx]) {
+					fg[bx++] = 0;
+					continue;
+				}
+
+				while ((bEnd < blocksX) && !skip[bEnd])
+					bEnd++;
+
+				x = bx * STM32IPL_BG_BLOCK_SIZE;
+				ipl_bg_span(model, luma[r] + x, bg + x, fg + bx,
+						IM_MIN(bEnd * STM32IPL_BG_BLOCK_SIZE, img->w) - x, true);
+
+				for (; bx < bEnd; bx++)
+					model->blockFg[blockRow + bx] |= (fg[bx] != 0);
+			}
+		}
+	}
+
+	STM32IPL_TRACE_END(BgModelUpdate)
+
+	while (nAlloc--)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gets the foreground mask of a frame without updating the background model: a pixel is foreground
+ * when its difference from the background is greater than the threshold of the model. No block is skipped.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param model	Background model created with STM32Ipl_BgModelInit(); if it is not valid, an error is returned.
+ * @param img	Frame; it must have the size of the first frame, otherwise an error is returned.
+ * @param mask	Binary image receiving the foreground mask (1 for the foreground pixels); it must have the size of
+ * the frame, otherwise an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BgModelGetForeground(const stm32ipl_bg_model_t *model, const image_t *img, image_t *mask)
+{
+	stm32ipl_err_t res;
+	uint32_t rowLen;
+	uint8_t *buf = NULL;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(mask)
+
+	res = ipl_bg_check(model, img, mask);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	if (img->bpp != IMAGE_BPP_GRAYSCALE) {
+		buf = fb_alloc(img->w, FB_ALLOC_PREFER_SPEED);
+		if (!buf)
+			return stm32ipl_err_OutOfMemory;
+	}
+
+	rowLen = IPL_BG_ROW_LEN(img->w);
+
+	STM32IPL_TRACE_BEGIN(BgModelGetForeground)
+
+	for (uint32_t y = 0; y < img->h; y++)
+		ipl_bg_span(model, ipl_bg_luma_row(img, y, buf), model->model + (y * rowLen),
+				(uint16_t*)IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(mask, y), img->w, false);
+
+	STM32IPL_TRACE_END(BgModelGetForeground)
+
+	if (buf)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the buffers of a background model created with STM32Ipl_BgModelInit().
+ * @param model	Background model.
+ * @return		void.
+ */
+void STM32Ipl_BgModelRelease(stm32ipl_bg_model_t *model)
+{
+	if (!model)
+		return;
+
+	xfree(model->model);
+	xfree(model->blockSum);
+	xfree(model->blockFg);
+
+	memset(model, 0, sizeof(stm32ipl_bg_model_t));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -55,7 +55,146 @@ stm32ipl_err_t STM32Ipl_Binary(const image_t *src, image_t *dst, const list_t *t
 		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_binary(dst, (image_t*)src, (list_t*)thresholds, invert, zero, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Binary)
+	imlib_binary(dst, (image_t*)src, (list_t*)thresholds, invert, zero, (image_t*)mask, NULL);
+
+	STM32IPL_TRACE_END(Binary)
+	return stm32ipl_err_Ok;
+}
+
+///@cond
+/* Number of RGB565 values converted to LAB at a time while compiling the thresholds. */
+#define IPL_COLOR_LUT_CHUNK	128
+///@endcond
+
+/**
+ * @brief Compiles a list of color thresholds for STM32Ipl_BinaryLut(), STM32Ipl_FindBlobsLut() and
+ * STM32Ipl_FindBlobsRleLut(): each RGB565 value is converted to LAB and compared with the thresholds once, and the
+ * outcome is kept in membership bitmaps of 8 KB each, so that the RGB565 pixels are then thresholded with lookups.
+ * The results are the same of the functions taking the list of thresholds. The compiled thresholds take
+ * (number of thresholds + 1) * 8 KB and must be released with STM32Ipl_ColorLutRelease(); they are meant to be
+ * built once and kept while the thresholds do not change.
+ * @param lut			Compiled thresholds; if it is not valid, an error is returned.
+ * @param thresholds	List of color_thresholds_list_lnk_data_t objects (1 to 32); it is copied, so it can be
+ * released once the thresholds are compiled.
+ * @param invert		Inverts the thresholding operation, as in STM32Ipl_Binary() and STM32Ipl_FindBlobs().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ColorLutInit(stm32ipl_color_lut_t *lut, const list_t *thresholds, bool invert)
+{
+	uint16_t pixels[IPL_COLOR_LUT_CHUNK];
+	int8_t l[IPL_COLOR_LUT_CHUNK];
+	int8_t a[IPL_COLOR_LUT_CHUNK];
+	int8_t b[IPL_COLOR_LUT_CHUNK];
+	color_thresholds_list_lnk_data_t thr;
+	uint32_t n;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(lut)
+
+	memset(lut, 0, sizeof(stm32ipl_color_lut_t));
+
+	if (!thresholds)
+		return stm32ipl_err_InvalidParameter;
+
+	n = list_size((list_t*)thresholds);
+	if ((n == 0) || (n > 32))
+		return stm32ipl_err_InvalidParameter;
+
+	lut->bits = xalloc0((n + 1) * COLOR_LUT_WORDS * sizeof(uint32_t));
+	if (!lut->bits)
+		return stm32ipl_err_OutOfMemory;
+
+	list_init(&lut->thresholds, sizeof(color_thresholds_list_lnk_data_t));
+	for (list_lnk_t *it = iterator_start_from_head((list_t*)thresholds); it; it = iterator_next(it)) {
+		iterator_get((list_t*)thresholds, it, &thr);
+		list_push_back(&lut->thresholds, &thr);
+	}
+
+	if (list_size(&lut->thresholds) != n) {
+		STM32Ipl_ColorLutRelease(lut);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	lut->invert = invert;
+
+	/* The values are converted by the same function used to threshold the rows. */
+	for (uint32_t base = 0; base < 65536; base += IPL_COLOR_LUT_CHUNK) {
+		uint32_t *any = lut->bits + (base >> UINT32_T_SHIFT);
+		uint32_t *match = any + COLOR_LUT_WORDS;
+
+		for (uint32_t i = 0; i < IPL_COLOR_LUT_CHUNK; i++)
+			pixels[i] = base + i;
+
+		imlib_rgb565_to_lab_row(pixels, IPL_COLOR_LUT_CHUNK, l, a, b);
+
+		for (list_lnk_t *it = iterator_start_from_head(&lut->thresholds); it; it = iterator_next(it)) {
+			iterator_get(&lut->thresholds, it, &thr);
+
+			for (uint32_t i = 0; i < IPL_COLOR_LUT_CHUNK; i++) {
+				bool in = COLOR_THRESHOLD_LAB(l[i], a[i], b[i], &thr, false);
+
+				if (in)
+					match[i >> UINT32_T_SHIFT] |= 1U << (i & UINT32_T_MASK);
+
+				if (in ^ invert)
+					any[i >> UINT32_T_SHIFT] |= 1U << (i & UINT32_T_MASK);
+			}
+
+			match += COLOR_LUT_WORDS;
+		}
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the memory of the thresholds compiled by STM32Ipl_ColorLutInit().
+ * @param lut	Compiled thresholds.
+ * @return		void.
+ */
+void STM32Ipl_ColorLutRelease(stm32ipl_color_lut_t *lut)
+{
+	if (lut) {
+		xfree(lut->bits);
+		list_free(&lut->thresholds);
+		lut->bits = NULL;
+	}
+}
+
+/**
+ * @brief Binarizes the source image as STM32Ipl_Binary() does, with the thresholds compiled by
+ * STM32Ipl_ColorLutInit(): the RGB565 pixels (and the RGB888 ones, reduced to RGB565 as STM32Ipl_Binary() does)
+ * are thresholded with one lookup each; the pixels of the other formats are compared with the thresholds.
+ * The supported formats (for source, destination and mask images) are Binary, Grayscale, RGB565, RGB888.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned.
+ * @param lut			Compiled thresholds, with their invert flag.
+ * @param zero			When true, the destination image thresholded pixels are set to 0 and pixels not in the
+ * threshold list are left untouched.
+ * @param mask 			Optional image to be used as a pixel level mask for the operation. The mask must have the same resolution
+ * as the source image. Only the source pixels that have the corresponding mask pixels set are considered.
+ * The pointer to the mask can be null: in this case all the source image pixels are considered.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BinaryLut(const image_t *src, image_t *dst, const stm32ipl_color_lut_t *lut, bool zero,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	if (!lut || !lut->bits)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(BinaryLut)
+	imlib_binary(dst, (image_t*)src, (list_t*)&lut->thresholds, lut->invert, zero, (image_t*)mask, lut->bits);
+	STM32IPL_TRACE_END(BinaryLut)
 
 	return stm32ipl_err_Ok;
 }
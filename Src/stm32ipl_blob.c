@@ -50,7 +50,8 @@ extern "C" {
  * @param maxBlobs			Maximum number of blob objects that can be found; it must be a positive number (minimum value is 1).
  * This value determines the amount of memory allocated to store the list of returned blobs, so it must be chosen with care. In case
  *  as is too high in respect to the available memory, it is possible that this function fails due to the
- * @return					stm32ipl_err_Ok on success.
+ * @return					stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the blobs found so far are returned).
  */
 stm32ipl_err_t STM32Ipl_FindBlobs(const image_t *img, list_t *out, const rectangle_t *roi, const list_t *thresholds,
 		uint8_t xStride, uint8_t yStride, uint16_t areaThreshold, uint16_t pixelsThreshold, bool merge, uint8_t margin,
@@ -68,9 +69,628 @@ stm32ipl_err_t STM32Ipl_FindBlobs(const image_t *img, list_t *out, const rectang
 	if (xStride == 0 || yStride == 0)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(FindBlobs)
+	ctx_deadline_begin();
 	imlib_find_blobs(out, (image_t*)img, &realRoi, xStride, yStride, (list_t*)thresholds, invert, areaThreshold,
 			pixelsThreshold, merge, margin,
-			NULL, NULL, NULL, NULL, 0, 0, maxBlobs);
+			NULL, NULL, NULL, NULL, 0, 0, maxBlobs, NULL);
+
+	STM32IPL_TRACE_END(FindBlobs)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Finds all blobs (connected pixel regions that pass a color threshold test) in an image, as STM32Ipl_FindBlobs()
+ * does, by labeling the run-length encoded rows of the image; the image is read once, row by row, and the memory
+ * taken grows with the number of runs (horizontal segments of the blobs) found, not with the image size.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * A pixel that passes more than one threshold belongs to the first of them. The corners of the blobs tied on
+ * the same row are averaged in raster order, so they may differ by a pixel from the ones of STM32Ipl_FindBlobs();
+ * the perimeter counts each border pixel edge once, so it may be lower than the one of STM32Ipl_FindBlobs().
+ * @param img				Image; if it is not valid, an error is returned.
+ * @param out				List of find_blobs_list_lnk_data_t objects representing the blobs found.
+ * @param roi				Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param thresholds		List of color_thresholds_list_lnk_data_t objects. It is possible to pass up to
+ * 32 threshold objects in one call.
+ * @param xStride			Number of x pixels to skip when searching for a blob; the blobs not touching any of the
+ * searched pixels are not reported, the others are pixel accurate.
+ * @param yStride			Number of y pixels to skip when searching for a blob; the blobs not touching any of the
+ * searched pixels are not reported, the others are pixel accurate.
+ * @param areaThreshold		Filter out the blobs with bounding box area lesser than areaThreshold.
+ * @param pixelsThreshold	Filter out the blobs with the pixel are lesser than pixelsThreshold.
+ * @param merge				When true, all not filtered out blobs with bounding rectangles intersecting each other are merged.
+ * @param margin			Value used to increase or decrease the size of the bounding rectangles for blobs during the intersection test.
+ * @param invert			Inverts the thresholding operation.
+ * @param maxBlobs			Maximum number of blob objects that can be found.
+ * @return					stm32ipl_err_Ok on success, stm32ipl_err_OutOfMemory when the runs do not fit in memory.
+ */
+stm32ipl_err_t STM32Ipl_FindBlobsRle(const image_t *img, list_t *out, const rectangle_t *roi, const list_t *thresholds,
+		uint8_t xStride, uint8_t yStride, uint16_t areaThreshold, uint16_t pixelsThreshold, bool merge, uint8_t margin,
+		bool invert, uint32_t maxBlobs)
+{
+	rectangle_t realRoi;
+	bool ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	if (!thresholds || !out || (list_size((list_t*)thresholds) == 0))
+		return stm32ipl_err_InvalidParameter;
+
+	if (xStride == 0 || yStride == 0)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindBlobsRle)
+	ok = imlib_find_blobs_rle(out, (image_t*)img, &realRoi, xStride, yStride, (list_t*)thresholds, invert,
+			areaThreshold, pixelsThreshold, merge, margin, 0, 0, maxBlobs, NULL);
+	STM32IPL_TRACE_END(FindBlobsRle)
+
+	return ok ? stm32ipl_err_Ok : stm32ipl_err_OutOfMemory;
+}
+
+/**
+ * @brief Finds all blobs in an image, as STM32Ipl_FindBlobs() does, with the thresholds compiled by
+ * STM32Ipl_ColorLutInit(): the RGB565 pixels are tested with one lookup per threshold instead of being converted
+ * to LAB; the blobs found are the same. The pixels of the other formats are tested as STM32Ipl_FindBlobs() does.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img				Image; if it is not valid, an error is returned.
+ * @param out				List of find_blobs_list_lnk_data_t objects representing the blobs found.
+ * @param roi				Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param lut				Compiled thresholds, with their invert flag.
+ * @param xStride			Number of x pixels to skip when searching for a blob.
+ * @param yStride			Number of y pixels to skip when searching for a blob.
+ * @param areaThreshold		Filter out the blobs with bounding box area lesser than areaThreshold.
+ * @param pixelsThreshold	Filter out the blobs with the pixel are lesser than pixelsThreshold.
+ * @param merge				When true, all not filtered out blobs with bounding rectangles intersecting each other are merged.
+ * @param margin			Value used to increase or decrease the size of the bounding rectangles for blobs during the intersection test.
+ * @param maxBlobs			Maximum number of blob objects that can be found.
+ * @return					stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with
+ * STM32Ipl_SetDeadline() passed (the blobs found so far are returned), error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindBlobsLut(const image_t *img, list_t *out, const rectangle_t *roi,
+		const stm32ipl_color_lut_t *lut, uint8_t xStride, uint8_t yStride, uint16_t areaThreshold,
+		uint16_t pixelsThreshold, bool merge, uint8_t margin, uint32_t maxBlobs)
+{
+	rectangle_t realRoi;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	if (!lut || !lut->bits || !out)
+		return stm32ipl_err_InvalidParameter;
+
+	if (xStride == 0 || yStride == 0)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindBlobsLut)
+	ctx_deadline_begin();
+	imlib_find_blobs(out, (image_t*)img, &realRoi, xStride, yStride, (list_t*)&lut->thresholds, lut->invert,
+			areaThreshold, pixelsThreshold, merge, margin, NULL, NULL, NULL, NULL, 0, 0, maxBlobs,
+			lut->bits + COLOR_LUT_WORDS);
+	STM32IPL_TRACE_END(FindBlobsLut)
+
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Finds all blobs in an image, as STM32Ipl_FindBlobsRle() does, with the thresholds compiled by
+ * STM32Ipl_ColorLutInit(): the RGB565 pixels are tested with lookups instead of being converted to LAB, and no
+ * LAB row is allocated for them; the blobs found are the same.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img				Image; if it is not valid, an error is returned.
+ * @param out				List of find_blobs_list_lnk_data_t objects representing the blobs found.
+ * @param roi				Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param lut				Compiled thresholds, with their invert flag.
+ * @param xStride			Number of x pixels to skip when searching for a blob.
+ * @param yStride			Number of y pixels to skip when searching for a blob.
+ * @param areaThreshold		Filter out the blobs with bounding box area lesser than areaThreshold.
+ * @param pixelsThreshold	Filter out the blobs with the pixel are lesser than pixelsThreshold.
+ * @param merge				When true, all not filtered out blobs with bounding rectangles intersecting each other are merged.
+ * @param margin			Value used to increase or decrease the size of the bounding rectangles for blobs during the intersection test.
+ * @param maxBlobs			Maximum number of blob objects that can be found.
+ * @return					stm32ipl_err_Ok on success, stm32ipl_err_OutOfMemory when the runs do not fit in memory.
+ */
+stm32ipl_err_t STM32Ipl_FindBlobsRleLut(const image_t *img, list_t *out, const rectangle_t *roi,
+		const stm32ipl_color_lut_t *lut, uint8_t xStride, uint8_t yStride, uint16_t areaThreshold,
+		uint16_t pixelsThreshold, bool merge, uint8_t margin, uint32_t maxBlobs)
+{
+	rectangle_t realRoi;
+	bool ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	if (!lut || !lut->bits || !out)
+		return stm32ipl_err_InvalidParameter;
+
+	if (xStride == 0 || yStride == 0)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindBlobsRleLut)
+	ok = imlib_find_blobs_rle(out, (image_t*)img, &realRoi, xStride, yStride, (list_t*)&lut->thresholds, lut->invert,
+			areaThreshold, pixelsThreshold, merge, margin, 0, 0, maxBlobs, lut->bits + COLOR_LUT_WORDS);
+	STM32IPL_TRACE_END(FindBlobsRleLut)
+
+	return ok ? stm32ipl_err_Ok : stm32ipl_err_OutOfMemory;
+}
+
+///@cond
+/* Run of pixels with the same threshold code on a row of the stream. */
+typedef struct _ipl_blob_run_t
+{
+	uint16_t l;				/* First column. */
+	uint16_t r;				/* Last column. */
+	uint8_t code;			/* 1 + index of the threshold. */
+	uint32_t blob;			/* Entry of the blob pool. */
+	int32_t perimeter;		/* Perimeter contribution, until the run is assigned to its blob. */
+} ipl_blob_run_t;
+
+/* Statistics of an open blob; the blobs joined by a row are linked by parent to the one that keeps them. */
+typedef struct _ipl_open_blob_t
+{
+	uint32_t parent;		/* Blob keeping the statistics (itself when it is a root). */
+	uint32_t next;			/* Next entry of the free list, or of the list of entries to release. */
+	uint32_t row;			/* Last row with pixels of the blob. */
+	uint8_t code;			/* 1 + index of the threshold. */
+	bool closed;			/* True when the blob has been reported (or discarded). */
+	int32_t pixels;
+	int32_t perimeter;
+	int32_t cx;
+	int32_t cy;
+	long long a;
+	long long b;
+	long long c;
+	float cornersAcc[FIND_BLOBS_CORNERS_RESOLUTION];
+	point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
+	int32_t cornersN[FIND_BLOBS_CORNERS_RESOLUTION];
+} ipl_open_blob_t;
+///@endcond
+
+#define IPL_BLOB_NONE	UINT32_MAX
+
+/* Takes an entry from the pool of the open blobs, growing the pool when it is exhausted. */
+static uint32_t ipl_blob_stream_new(stm32ipl_blob_stream_t *ctx, uint8_t code)
+{
+	ipl_open_blob_t *blobs;
+	ipl_open_blob_t *blob;
+	uint32_t id;
+	int32_t xMax = ctx->width - 1;
+	int32_t yMax = ctx->height - 1;
+
+	if (ctx->freeBlob == IPL_BLOB_NONE) {
+		uint32_t size = ctx->blobsSize ? (ctx->blobsSize * 2) : 32;
+
+		blobs = xrealloc(ctx->blobs, size * sizeof(ipl_open_blob_t));
+		if (!blobs)
+			return IPL_BLOB_NONE;
+
+		for (uint32_t i = ctx->blobsSize; i < size; i++)
+			blobs[i].next = (i + 1 < size) ? (i + 1) : IPL_BLOB_NONE;
+
+		ctx->freeBlob = ctx->blobsSize;
+		ctx->blobs = blobs;
+		ctx->blobsSize = size;
+	}
+
+	blobs = (ipl_open_blob_t*)ctx->blobs;
+	id = ctx->freeBlob;
+	blob = &blobs[id];
+	ctx->freeBlob = blob->next;
+
+	memset(blob, 0, sizeof(ipl_open_blob_t));
+	blob->parent = id;
+	blob->next = IPL_BLOB_NONE;
+	blob->code = code;
+
+	/* Same initialization of the corners as imlib_find_blobs(). */
+	for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
+		float c = cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+		float s = sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+
+		blob->corners[i].x = (c < 0) ? 0 : xMax;
+		blob->corners[i].y = (s < 0) ? 0 : yMax;
+		blob->cornersAcc[i] = (blob->corners[i].x * c) + (blob->corners[i].y * s);
+		blob->cornersN[i] = 1;
+	}
+
+	return id;
+}
+
+static uint32_t ipl_blob_stream_find(ipl_open_blob_t *blobs, uint32_t id)
+{
+	while (blobs[id].parent != id) {
+		blobs[id].parent = blobs[blobs[id].parent].parent;
+		id = blobs[id].parent;
+	}
+
+	return id;
+}
+
+/* Joins two blobs; the one absorbed is added to the list of the entries to release at the end of the row. */
+static uint32_t ipl_blob_stream_union(ipl_open_blob_t *blobs, uint32_t id0, uint32_t id1, uint32_t *release)
+{
+	ipl_open_blob_t *dst;
+	ipl_open_blob_t *src;
+
+	id0 = ipl_blob_stream_find(blobs, id0);
+	id1 = ipl_blob_stream_find(blobs, id1);
+
+	if (id0 == id1)
+		return id0;
+
+	if (id1 < id0) {
+		uint32_t tmp = id0;
+		id0 = id1;
+		id1 = tmp;
+	}
+
+	dst = &blobs[id0];
+	src = &blobs[id1];
+
+	dst->pixels += src->pixels;
+	dst->perimeter += src->perimeter;
+	dst->cx += src->cx;
+	dst->cy += src->cy;
+	dst->a += src->a;
+	dst->b += src->b;
+	dst->c += src->c;
+	dst->row = IM_MAX(dst->row, src->row);
+
+	for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
+		if (src->cornersAcc[i] < dst->cornersAcc[i]) {
+			dst->cornersAcc[i] = src->cornersAcc[i];
+			dst->corners[i] = src->corners[i];
+			dst->cornersN[i] = src->cornersN[i];
+		} else if (src->cornersAcc[i] == dst->cornersAcc[i]) {
+			int32_t n = dst->cornersN[i] + src->cornersN[i];
+
+			dst->corners[i].x = ((dst->corners[i].x * dst->cornersN[i]) + (src->corners[i].x * src->cornersN[i])) / n;
+			dst->corners[i].y = ((dst->corners[i].y * dst->cornersN[i]) + (src->corners[i].y * src->cornersN[i])) / n;
+			dst->cornersN[i] = n;
+		}
+	}
+
+	src->parent = id0;
+	src->next = *release;
+	*release = id1;
+
+	return id0;
+}
+
+/* Adds a run to the statistics of its blob, as the scanline flood fill of imlib_find_blobs() does. */
+static void ipl_blob_stream_add_run(ipl_open_blob_t *blob, const ipl_blob_run_t *run, int32_t y)
+{
+	int32_t left = run->l;
+	int32_t right = run->r;
+	int32_t cnt = right - left + 1;
+	int32_t sum = ((left + right) * cnt) / 2;
+	int32_t sum2 = ((right * (right + 1) * ((2 * right) + 1)) - ((left - 1) * left * ((2 * left) - 1))) / 6;
+	int32_t avg = sum / cnt;
+
+	for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
+		float c = cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i];
+		int32_t x = (c > 0) ? left : ((c == 0) ? avg : right);
+		float z = (x * c) + (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
+
+		if (z < blob->cornersAcc[i]) {
+			blob->cornersAcc[i] = z;
+			blob->corners[i].x = x;
+			blob->corners[i].y = y;
+			blob->cornersN[i] = 1;
+		} else if (z == blob->cornersAcc[i]) {
+			blob->corners[i].x = ((blob->corners[i].x * blob->cornersN[i]) + x) / (blob->cornersN[i] + 1);
+			blob->corners[i].y = ((blob->corners[i].y * blob->cornersN[i]) + y) / (blob->cornersN[i] + 1);
+			blob->cornersN[i]++;
+		}
+	}
+
+	blob->pixels += cnt;
+	blob->perimeter += run->perimeter;
+	blob->cx += sum;
+	blob->cy += y * cnt;
+	blob->a += sum2;
+	blob->b += y * sum;
+	blob->c += y * y * cnt;
+	blob->row = y;
+}
+
+/* Reports a blob that has no pixels on the current row, if it passes the filters. */
+static void ipl_blob_stream_close(stm32ipl_blob_stream_t *ctx, ipl_open_blob_t *blob)
+{
+	find_blobs_list_lnk_data_t lnk;
+
+	blob->closed = true;
+
+	if (!ctx->maxBlobs)
+		return;
+
+	imlib_find_blobs_fill(&lnk, blob->corners, blob->code - 1, blob->pixels, blob->perimeter, blob->cx, blob->cy,
+			blob->a, blob->b, blob->c);
+
+	if (((lnk.rect.w * lnk.rect.h) < ctx->areaThreshold) || (blob->pixels < ctx->pixelsThreshold))
+		return;
+
+	list_push_back(ctx->out, &lnk);
+	ctx->maxBlobs--;
+}
+
+/* Labels a row: its runs are joined to the overlapping runs of the previous row with the same code, and the blobs
+ * of the previous row that do not continue on it are reported. Returns false when the pool cannot grow. */
+static bool ipl_blob_stream_row(stm32ipl_blob_stream_t *ctx, image_t *chunk, int32_t row)
+{
+	ipl_open_blob_t *blobs;
+	ipl_blob_run_t *prev = (ipl_blob_run_t*)ctx->runs + ((ctx->y & 1) ? 0 : ((ctx->width + 1) / 2));
+	ipl_blob_run_t *cur = (ipl_blob_run_t*)ctx->runs + ((ctx->y & 1) ? ((ctx->width + 1) / 2) : 0);
+	uint8_t *prevCodes = ctx->codes + ((ctx->y & 1) ? 0 : ctx->width);
+	uint8_t *codes = ctx->codes + ((ctx->y & 1) ? ctx->width : 0);
+	rectangle_t roi = { 0, 0, ctx->width, chunk->h };
+	uint32_t nPrev = ctx->nRuns;
+	uint32_t nCur = 0;
+	uint32_t release = IPL_BLOB_NONE;
+	int32_t y = ctx->y;
+	bool any;
+
+	any = imlib_find_blobs_code_row(chunk, &roi, row, ctx->thresholds, ctx->nThresholds, ctx->invert, NULL, ctx->lab,
+			codes);
+
+	for (uint32_t x = 0; any && (x < ctx->width);) {
+		uint8_t code = codes[x];
+		uint32_t l = x;
+
+		if (!code) {
+			x++;
+			continue;
+		}
+
+		while ((x < ctx->width) && (codes[x] == code))
+			x++;
+
+		cur[nCur].l = l;
+		cur[nCur].r = x - 1;
+		cur[nCur].code = code;
+		cur[nCur].blob = IPL_BLOB_NONE;
+		cur[nCur].perimeter = 2 + (y ? imlib_find_blobs_border(prevCodes, l, x - 1, code) : (int32_t)(x - l));
+		nCur++;
+	}
+
+	blobs = (ipl_open_blob_t*)ctx->blobs;
+
+	/* The pixels of this row below the runs of the previous one complete their perimeter. */
+	for (uint32_t i = 0; i < nPrev; i++)
+		blobs[ipl_blob_stream_find(blobs, prev[i].blob)].perimeter += imlib_find_blobs_border(codes, prev[i].l,
+				prev[i].r, prev[i].code);
+
+	/* Both rows are sorted, so the overlaps are found in one sweep. */
+	for (uint32_t i = 0, j = 0; (i < nPrev) && (j < nCur);) {
+		if ((prev[i].l <= cur[j].r) && (cur[j].l <= prev[i].r) && (prev[i].code == cur[j].code)) {
+			if (cur[j].blob == IPL_BLOB_NONE)
+				cur[j].blob = prev[i].blob;
+			else
+				cur[j].blob = ipl_blob_stream_union(blobs, cur[j].blob, prev[i].blob, &release);
+		}
+
+		if (prev[i].r < cur[j].r)
+			i++;
+		else
+			j++;
+	}
+
+	for (uint32_t j = 0; j < nCur; j++) {
+		if (cur[j].blob == IPL_BLOB_NONE) {
+			cur[j].blob = ipl_blob_stream_new(ctx, cur[j].code);
+			if (cur[j].blob == IPL_BLOB_NONE)
+				return false;
+
+			blobs = (ipl_open_blob_t*)ctx->blobs;
+		}
+
+		cur[j].blob = ipl_blob_stream_find(blobs, cur[j].blob);
+		ipl_blob_stream_add_run(&blobs[cur[j].blob], &cur[j], y);
+	}
+
+	/* The blobs of the previous row without pixels on this one are complete. */
+	for (uint32_t i = 0; i < nPrev; i++) {
+		uint32_t id = ipl_blob_stream_find(blobs, prev[i].blob);
+
+		if ((blobs[id].row != (uint32_t)y) && !blobs[id].closed) {
+			ipl_blob_stream_close(ctx, &blobs[id]);
+			blobs[id].next = release;
+			release = id;
+		}
+	}
+
+	while (release != IPL_BLOB_NONE) {
+		uint32_t next = blobs[release].next;
+
+		blobs[release].next = ctx->freeBlob;
+		ctx->freeBlob = release;
+		release = next;
+	}
+
+	ctx->nRuns = nCur;
+	ctx->y++;
+
+	return true;
+}
+
+/**
+ * @brief Starts the streaming detection of the blobs (connected pixel regions that pass a color threshold test)
+ * of a frame, whose rows are then given to STM32Ipl_BlobStreamPushRows() as they are received, e.g. from the
+ * camera DMA half-frame interrupts. Each blob is reported to the out list as soon as the row following its last
+ * row has been received; STM32Ipl_BlobStreamEnd() reports the blobs touching the last row.
+ * The blobs reported are the ones found by STM32Ipl_FindBlobsRle() on the whole frame (with strides 1 and no merge),
+ * in the order they are completed. The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * Only the runs of the last row and the statistics of the open blobs are kept, so the memory taken grows with the
+ * number of blobs crossing a row, not with the frame size.
+ * @param ctx				Context; if it is not valid, an error is returned.
+ * @param width				Width of the frame.
+ * @param height			Height of the frame.
+ * @param format			Format of the frame.
+ * @param out				List of find_blobs_list_lnk_data_t objects the blobs are reported to; it is initialized here
+ * and must not be modified until STM32Ipl_BlobStreamEnd() is called.
+ * @param thresholds		List of color_thresholds_list_lnk_data_t objects (up to 32); it is copied, so it may be
+ * released after this call.
+ * @param areaThreshold		Filter out the blobs with bounding box area lesser than areaThreshold.
+ * @param pixelsThreshold	Filter out the blobs with the pixel are lesser than pixelsThreshold.
+ * @param invert			Inverts the thresholding operation.
+ * @param maxBlobs			Maximum number of blob objects that can be reported.
+ * @return					stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BlobStreamBegin(stm32ipl_blob_stream_t *ctx, uint32_t width, uint32_t height,
+		image_bpp_t format, list_t *out, const list_t *thresholds, uint16_t areaThreshold, uint16_t pixelsThreshold,
+		bool invert, uint32_t maxBlobs)
+{
+	uint32_t nThresholds;
+	uint32_t maxRuns;
+	uint32_t labSize;
+	uint8_t *buffer;
+	uint32_t i = 0;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	memset(ctx, 0, sizeof(stm32ipl_blob_stream_t));
+
+	if (!out || !thresholds || (width == 0) || (width > UINT16_MAX) || (height == 0))
+		return stm32ipl_err_InvalidParameter;
+
+	nThresholds = list_size((list_t*)thresholds);
+	if ((nThresholds == 0) || (nThresholds > 32))
+		return stm32ipl_err_InvalidParameter;
+
+	switch (format) {
+		case IMAGE_BPP_BINARY:
+		case IMAGE_BPP_GRAYSCALE:
+			labSize = 0;
+			break;
+
+		case IMAGE_BPP_RGB565:
+		case IMAGE_BPP_RGB888:
+			labSize = width * 3;
+			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
+	}
+
+	maxRuns = (width + 1) / 2;
+
+	/* Runs, thresholds, codes and LAB row, in one block. */
+	buffer = xalloc((2 * maxRuns * sizeof(ipl_blob_run_t)) + (nThresholds * sizeof(color_thresholds_list_lnk_data_t))
+			+ (2 * width) + labSize);
+	if (!buffer)
+		return stm32ipl_err_OutOfMemory;
+
+	ctx->runs = buffer;
+	ctx->thresholds = (color_thresholds_list_lnk_data_t*)(buffer + (2 * maxRuns * sizeof(ipl_blob_run_t)));
+	ctx->codes = (uint8_t*)(ctx->thresholds + nThresholds);
+	ctx->lab = labSize ? (int8_t*)(ctx->codes + (2 * width)) : NULL;
+
+	for (list_lnk_t *it = iterator_start_from_head((list_t*)thresholds); it; it = iterator_next(it))
+		iterator_get((list_t*)thresholds, it, &ctx->thresholds[i++]);
+
+	ctx->width = width;
+	ctx->height = height;
+	ctx->bpp = format;
+	ctx->invert = invert;
+	ctx->nThresholds = nThresholds;
+	ctx->areaThreshold = areaThreshold;
+	ctx->pixelsThreshold = pixelsThreshold;
+	ctx->maxBlobs = maxBlobs;
+	ctx->out = out;
+	ctx->freeBlob = IPL_BLOB_NONE;
+
+	list_init(out, sizeof(find_blobs_list_lnk_data_t));
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gives the next rows of the frame to the streaming blob detection started by STM32Ipl_BlobStreamBegin();
+ * the blobs completed by these rows are added to the out list.
+ * @param ctx		Context.
+ * @param data		Pixels of the rows, in the format of the frame.
+ * @param rows		Number of rows; the total number of rows given must not exceed the frame height.
+ * @param stride	Distance between the beginning of two consecutive rows (bytes); 0 means the rows are tightly packed.
+ * @return			stm32ipl_err_Ok on success, error otherwise; on error, the context must be released with
+ * STM32Ipl_BlobStreamEnd().
+ */
+stm32ipl_err_t STM32Ipl_BlobStreamPushRows(stm32ipl_blob_stream_t *ctx, const uint8_t *data, uint32_t rows,
+		uint32_t stride)
+{
+	image_t chunk;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+	STM32IPL_CHECK_VALID_PTR_ARG(data)
+
+	if (!ctx->runs || ((ctx->y + rows) > ctx->height))
+		return stm32ipl_err_InvalidParameter;
+
+	chunk.w = ctx->width;
+	chunk.h = rows;
+	chunk.bpp = ctx->bpp;
+	chunk.data = (uint8_t*)data;
+	chunk.stride = stride;
+
+	STM32IPL_TRACE_BEGIN(BlobStreamPushRows)
+
+	for (uint32_t i = 0; i < rows; i++) {
+		if (!ipl_blob_stream_row(ctx, &chunk, i)) {
+			STM32IPL_TRACE_END(BlobStreamPushRows)
+			return stm32ipl_err_OutOfMemory;
+		}
+	}
+
+	STM32IPL_TRACE_END(BlobStreamPushRows)
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Ends the streaming blob detection: the blobs touching the last row received are added to the out list
+ * and the buffers allocated by STM32Ipl_BlobStreamBegin() are released. When less rows than the frame height were
+ * given, the frame is considered to end at the last of them.
+ * @param ctx	Context.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BlobStreamEnd(stm32ipl_blob_stream_t *ctx)
+{
+	ipl_open_blob_t *blobs;
+	ipl_blob_run_t *prev;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	if (!ctx->runs)
+		return stm32ipl_err_InvalidParameter;
+
+	blobs = (ipl_open_blob_t*)ctx->blobs;
+	prev = (ipl_blob_run_t*)ctx->runs + ((ctx->y & 1) ? 0 : ((ctx->width + 1) / 2));
+
+	/* The last row has nothing below it. */
+	for (uint32_t i = 0; i < ctx->nRuns; i++)
+		blobs[ipl_blob_stream_find(blobs, prev[i].blob)].perimeter += prev[i].r - prev[i].l + 1;
+
+	for (uint32_t i = 0; i < ctx->nRuns; i++) {
+		uint32_t id = ipl_blob_stream_find(blobs, prev[i].blob);
+
+		if (!blobs[id].closed)
+			ipl_blob_stream_close(ctx, &blobs[id]);
+	}
+
+	if (ctx->blobs)
+		xfree(ctx->blobs);
+
+	xfree(ctx->runs);
+
+	memset(ctx, 0, sizeof(stm32ipl_blob_stream_t));
 
 	return stm32ipl_err_Ok;
 }
@@ -16,8 +16,12 @@
  ******************************************************************************
  */
 
+#include <string.h>
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#ifdef IPL_CONVERT_HAS_MVE
+#include "mve_convert.h"
+#endif
 
 extern const float xyz_table[256];
 
@@ -39,8 +43,8 @@ extern "C" {
 static void STM32Ipl_SimpleCopy(const uint8_t *src, uint8_t *dst, uint32_t size, bool reverse)
 {
 	if (reverse) {
-		src += size;
-		dst += size;
+		src += size - 1;
+		dst += size - 1;
 		for (uint32_t i = 0; i < size; i++)
 			*dst-- = *src--;
 	} else {
@@ -218,6 +222,9 @@ static void STM32Ipl_Y8ToBinary(const uint8_t *src, uint8_t *dst, uint32_t width
  */
 static void STM32Ipl_Y8ToRGB565(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_y8_to_rgb565(src, (uint16_t*)dst, width * height, reverse);
+#else
 	uint16_t *dstData = (uint16_t*)dst;
 	uint32_t size = width * height;
 
@@ -234,6 +241,7 @@ static void STM32Ipl_Y8ToRGB565(const uint8_t *src, uint8_t *dst, uint32_t width
 			src++;
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
@@ -249,6 +257,9 @@ static void STM32Ipl_Y8ToRGB565(const uint8_t *src, uint8_t *dst, uint32_t width
  */
 static void STM32Ipl_Y8ToRGB888(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_y8_to_rgb888(src, dst, width * height, reverse);
+#else
 	uint32_t size = width * height;
 
 	if (reverse) {
@@ -268,6 +279,7 @@ static void STM32Ipl_Y8ToRGB888(const uint8_t *src, uint8_t *dst, uint32_t width
 			*dst++ = v;
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
@@ -321,6 +333,9 @@ static void STM32Ipl_RGB565ToBinary(const uint8_t *src, uint8_t *dst, uint32_t w
  */
 static void STM32Ipl_RGB565ToY8(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_rgb565_to_y8((const uint16_t*)src, dst, width * height, reverse);
+#else
 	uint32_t size = width * height;
 	uint16_t *srcData = (uint16_t*)src;
 
@@ -337,6 +352,7 @@ static void STM32Ipl_RGB565ToY8(const uint8_t *src, uint8_t *dst, uint32_t width
 			srcData++;
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
@@ -352,6 +368,9 @@ static void STM32Ipl_RGB565ToY8(const uint8_t *src, uint8_t *dst, uint32_t width
  */
 static void STM32Ipl_RGB565ToRGB888(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_rgb565_to_rgb888((const uint16_t*)src, dst, width * height, reverse);
+#else
 	uint32_t size = width * height;
 	uint16_t *srcData = (uint16_t*)src;
 
@@ -372,6 +391,7 @@ static void STM32Ipl_RGB565ToRGB888(const uint8_t *src, uint8_t *dst, uint32_t w
 			*dst++ = COLOR_RGB565_TO_R8(v);
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
@@ -427,6 +447,9 @@ static void STM32Ipl_RGB888ToBinary(const uint8_t *src, uint8_t *dst, uint32_t w
  */
 static void STM32Ipl_RGB888ToY8(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_rgb888_to_y8(src, dst, width * height, reverse);
+#else
 	uint32_t size = width * height;
 
 	if (reverse) {
@@ -446,6 +469,7 @@ static void STM32Ipl_RGB888ToY8(const uint8_t *src, uint8_t *dst, uint32_t width
 			*dst++ = COLOR_RGB888_TO_Y(r, g, b);
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
@@ -461,6 +485,9 @@ static void STM32Ipl_RGB888ToY8(const uint8_t *src, uint8_t *dst, uint32_t width
  */
 static void STM32Ipl_RGB888ToRGB565(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, bool reverse)
 {
+#ifdef IPL_CONVERT_HAS_MVE
+	mve_convert_rgb888_to_rgb565(src, (uint16_t*)dst, width * height, reverse);
+#else
 	uint32_t size = width * height;
 	uint16_t *dstData = (uint16_t*)dst;
 
@@ -481,48 +508,42 @@ static void STM32Ipl_RGB888ToRGB565(const uint8_t *src, uint8_t *dst, uint32_t w
 			*dstData++ = COLOR_R8_G8_B8_TO_RGB565(r, g, b);
 		}
 	}
+#endif /* IPL_CONVERT_HAS_MVE */
 }
 
 /**
- * @brief Converts the source image data to the format of the destination image and stores the
- * converted data to the destination buffer. The two images must have the same resolution.
- * The destination image data buffer must be already allocated and must have the right size to
- * contain the converted image.
- * The supported formats are Binary, Grayscale, RGB565, RGB888.
- * @param src	  Source image.
- * @param dst	  Destination image.
- * @param reverse If true, the processing is executed in reverse mode (from the last to the first pixel),
+ * brief Converts the source image pixels to the destination format and stores the converted data to the destination buffer.
+ * Assuming the two given data pointers point to valid buffers containing tightly packed lines.
+ * param src	   Source image data buffer.
+ * param dst	   Destination image data buffer.
+ * param width	   Width of the two images.
+ * param height	   Height of the two images.
+ * param srcFormat Format of the source image.
+ * param dstFormat Format of the destination image.
+ * param reverse   If true, the processing is executed in reverse mode (from the last to the first pixel),
  * otherwise it is executed normally (from the first to the last pixel).
- * @return		  stm32ipl_err_Ok on success, error otherwise.
+ * return		   stm32ipl_err_Ok on success, error otherwise.
  */
-stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool reverse)
+static stm32ipl_err_t STM32Ipl_ConvertData(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height,
+		int srcFormat, int dstFormat, bool reverse)
 {
-	STM32IPL_CHECK_VALID_IMAGE(src)
-	STM32IPL_CHECK_VALID_IMAGE(dst)
-	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
-	STM32IPL_CHECK_FORMAT(dst, STM32IPL_IF_ALL)
-	STM32IPL_CHECK_SAME_SIZE(src, dst)
-
-	if (src->data == dst->data)
-		return stm32ipl_err_InvalidParameter;
-
-	switch (src->bpp) {
+	switch (srcFormat) {
 		case IMAGE_BPP_BINARY:
-			switch (dst->bpp) {
+			switch (dstFormat) {
 				case IMAGE_BPP_BINARY:
-					STM32Ipl_SimpleCopy(src->data, dst->data, STM32Ipl_ImageDataSize(dst), reverse);
+					STM32Ipl_SimpleCopy(src, dst, STM32Ipl_DataSize(width, height, (image_bpp_t)dstFormat), reverse);
 					break;
 
 				case IMAGE_BPP_GRAYSCALE:
-					STM32Ipl_BinaryToY8(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_BinaryToY8(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB565:
-					STM32Ipl_BinaryToRGB565(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_BinaryToRGB565(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB888:
-					STM32Ipl_BinaryToRGB888(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_BinaryToRGB888(src, dst, width, height, reverse);
 					break;
 
 				default:
@@ -531,21 +552,21 @@ stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool revers
 			break;
 
 		case IMAGE_BPP_GRAYSCALE:
-			switch (dst->bpp) {
+			switch (dstFormat) {
 				case IMAGE_BPP_BINARY:
-					STM32Ipl_Y8ToBinary(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_Y8ToBinary(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_GRAYSCALE:
-					STM32Ipl_SimpleCopy(src->data, dst->data, STM32Ipl_ImageDataSize(dst), reverse);
+					STM32Ipl_SimpleCopy(src, dst, STM32Ipl_DataSize(width, height, (image_bpp_t)dstFormat), reverse);
 					break;
 
 				case IMAGE_BPP_RGB565:
-					STM32Ipl_Y8ToRGB565(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_Y8ToRGB565(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB888:
-					STM32Ipl_Y8ToRGB888(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_Y8ToRGB888(src, dst, width, height, reverse);
 					break;
 
 				default:
@@ -554,21 +575,21 @@ stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool revers
 			break;
 
 		case IMAGE_BPP_RGB565: {
-			switch (dst->bpp) {
+			switch (dstFormat) {
 				case IMAGE_BPP_BINARY:
-					STM32Ipl_RGB565ToBinary(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB565ToBinary(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_GRAYSCALE:
-					STM32Ipl_RGB565ToY8(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB565ToY8(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB565:
-					STM32Ipl_SimpleCopy(src->data, dst->data, STM32Ipl_ImageDataSize(dst), reverse);
+					STM32Ipl_SimpleCopy(src, dst, STM32Ipl_DataSize(width, height, (image_bpp_t)dstFormat), reverse);
 					break;
 
 				case IMAGE_BPP_RGB888:
-					STM32Ipl_RGB565ToRGB888(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB565ToRGB888(src, dst, width, height, reverse);
 					break;
 
 				default:
@@ -578,21 +599,21 @@ stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool revers
 		}
 
 		case IMAGE_BPP_RGB888: {
-			switch (dst->bpp) {
+			switch (dstFormat) {
 				case IMAGE_BPP_BINARY:
-					STM32Ipl_RGB888ToBinary(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB888ToBinary(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_GRAYSCALE:
-					STM32Ipl_RGB888ToY8(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB888ToY8(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB565:
-					STM32Ipl_RGB888ToRGB565(src->data, dst->data, src->w, src->h, reverse);
+					STM32Ipl_RGB888ToRGB565(src, dst, width, height, reverse);
 					break;
 
 				case IMAGE_BPP_RGB888:
-					STM32Ipl_SimpleCopy(src->data, dst->data, STM32Ipl_ImageDataSize(dst), reverse);
+					STM32Ipl_SimpleCopy(src, dst, STM32Ipl_DataSize(width, height, (image_bpp_t)dstFormat), reverse);
 					break;
 
 				default:
@@ -608,12 +629,301 @@ stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool revers
 	return stm32ipl_err_Ok;
 }
 
+///@cond
+/**
+ * Converts a line of pixels from the source format to the destination format; it is used by the functions
+ * that convert the pixels on the fly, e.g. STM32Ipl_ResizeConvert().
+ * src		 Source line.
+ * dst		 Destination line.
+ * width	 Number of pixels of the line.
+ * srcFormat Format of the source line.
+ * dstFormat Format of the destination line; the two formats must be already validated by the caller.
+ */
+void ipl_convert_line(const uint8_t *src, uint8_t *dst, uint32_t width, int srcFormat, int dstFormat)
+{
+	STM32Ipl_ConvertData(src, dst, width, 1, srcFormat, dstFormat, false);
+}
+
+/**
+ * Stores the R, G, B values of the x-th pixel of a RGB565 or RGB888 line.
+ */
+static inline void ipl_sensor_put_rgb(uint8_t *dst, int dstFormat, uint32_t x, int r, int g, int b)
+{
+	if (dstFormat == IMAGE_BPP_RGB565) {
+		((uint16_t*)dst)[x] = COLOR_R8_G8_B8_TO_RGB565(r, g, b);
+	} else {
+		dst += x * 3;
+		dst[0] = b;
+		dst[1] = g;
+		dst[2] = r;
+	}
+}
+
+/**
+ * Converts the Y, U, V values (U and V centered on 128) of the x-th pixel to R, G, B, as imlib_yuv_to_rgb() does,
+ * and stores them to a RGB565 or RGB888 line.
+ */
+static inline void ipl_sensor_put_yuv(uint8_t *dst, int dstFormat, uint32_t x, int y, int u, int v)
+{
+	u -= 128;
+	v -= 128;
+
+	ipl_sensor_put_rgb(dst, dstFormat, x,
+			IM_MAX(IM_MIN(y + ((91881 * v) >> 16), COLOR_R8_MAX), COLOR_R8_MIN),
+			IM_MAX(IM_MIN(y - (((22554 * u) + (46802 * v)) >> 16), COLOR_G8_MAX), COLOR_G8_MIN),
+			IM_MAX(IM_MIN(y + ((116130 * u) >> 16), COLOR_B8_MAX), COLOR_B8_MIN));
+}
+
+/**
+ * Converts a line of a YUV422 image to a Grayscale, RGB565 or RGB888 line; the Grayscale line is made of
+ * the Y values, without any computation.
+ */
+static void ipl_yuv422_line(const uint8_t *src, uint8_t *dst, uint32_t width, int dstFormat)
+{
+	if (dstFormat == IMAGE_BPP_GRAYSCALE) {
+		for (uint32_t x = 0; x < width; x++)
+			dst[x] = src[2 * x];
+		return;
+	}
+
+	for (uint32_t x = 0; x < width; x += 2, src += 4) {
+		ipl_sensor_put_yuv(dst, dstFormat, x, src[0], src[1], src[3]);
+		if ((x + 1) < width)
+			ipl_sensor_put_yuv(dst, dstFormat, x + 1, src[2], src[1], src[3]);
+	}
+}
+
+/**
+ * Converts a line of a NV12 image, given its Y line and the corresponding U, V line, to a Grayscale, RGB565
+ * or RGB888 line; the Grayscale line is a copy of the Y line.
+ */
+static void ipl_nv12_line(const uint8_t *srcY, const uint8_t *srcUV, uint8_t *dst, uint32_t width, int dstFormat)
+{
+	if (dstFormat == IMAGE_BPP_GRAYSCALE) {
+		memcpy(dst, srcY, width);
+		return;
+	}
+
+	for (uint32_t x = 0; x < width; x++)
+		ipl_sensor_put_yuv(dst, dstFormat, x, srcY[x], srcUV[x & ~1UL], srcUV[(x & ~1UL) + 1]);
+}
+
+/**
+ * Demosaics the y-th line of a Bayer image with bilinear interpolation and stores it to a Grayscale, RGB565
+ * or RGB888 line. At the image borders, the missing neighbors are replaced by the symmetric ones, that have
+ * the same color.
+ */
+static void ipl_bayer_line(const image_t *src, int y, uint8_t *dst, int dstFormat)
+{
+	uint32_t stride = STM32Ipl_ImageStride(src);
+	int w = src->w;
+	const uint8_t *l0 = src->data + (((y > 0) ? (y - 1) : IM_MIN(1, src->h - 1)) * stride);
+	const uint8_t *l1 = src->data + (y * stride);
+	const uint8_t *l2 = src->data + ((((y + 1) < src->h) ? (y + 1) : IM_MAX(y - 1, 0)) * stride);
+	int redX;
+	int redY;
+	int redLine;
+	int colorX;
+
+	/* Position of the red pixel in the 2x2 cells of the pattern. */
+	switch (src->bpp) {
+		case IMAGE_BPP_BAYER_GBRG:
+			redX = 0;
+			redY = 1;
+			break;
+
+		case IMAGE_BPP_BAYER_GRBG:
+			redX = 1;
+			redY = 0;
+			break;
+
+		case IMAGE_BPP_BAYER_RGGB:
+			redX = 0;
+			redY = 0;
+			break;
+
+		default:
+			redX = 1;
+			redY = 1;
+			break;
+	}
+
+	/* The lines alternate G with R (red lines) and G with B (blue lines). */
+	redLine = ((y & 1) == redY);
+	colorX = redLine ? redX : (redX ^ 1);
+
+	for (int x = 0; x < w; x++) {
+		int xl = (x > 0) ? (x - 1) : IM_MIN(1, w - 1);
+		int xr = ((x + 1) < w) ? (x + 1) : IM_MAX(x - 1, 0);
+		int c = l1[x];
+		int r;
+		int g;
+		int b;
+
+		if ((x & 1) == colorX) {
+			int cross = (l0[x] + l2[x] + l1[xl] + l1[xr] + 2) >> 2;
+			int diag = (l0[xl] + l0[xr] + l2[xl] + l2[xr] + 2) >> 2;
+
+			g = cross;
+			r = redLine ? c : diag;
+			b = redLine ? diag : c;
+		} else {
+			int horiz = (l1[xl] + l1[xr] + 1) >> 1;
+			int vert = (l0[x] + l2[x] + 1) >> 1;
+
+			g = c;
+			r = redLine ? horiz : vert;
+			b = redLine ? vert : horiz;
+		}
+
+		if (dstFormat == IMAGE_BPP_GRAYSCALE)
+			dst[x] = COLOR_RGB888_TO_Y(r, g, b);
+		else
+			ipl_sensor_put_rgb(dst, dstFormat, x, r, g, b);
+	}
+}
+
+/**
+ * Converts a YUV422, NV12 or Bayer image to a Binary, Grayscale, RGB565 or RGB888 image, line by line;
+ * for Binary destination images, each line is converted to Grayscale first.
+ * src	Source image.
+ * dst	Destination image; it must have the same resolution of the source one.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t ipl_convert_sensor(const image_t *src, image_t *dst)
+{
+	uint32_t srcStride = STM32Ipl_ImageStride(src);
+	uint32_t dstStride = STM32Ipl_ImageStride(dst);
+	int lineFormat = (dst->bpp == IMAGE_BPP_BINARY) ? IMAGE_BPP_GRAYSCALE : dst->bpp;
+	/* The U, V plane of NV12 follows the Y plane and has a line (of an even number of bytes) every two lines. */
+	const uint8_t *uvData = src->data + (src->h * srcStride);
+	uint32_t uvStride = src->stride ? srcStride : (((src->w + 1) / 2) * 2);
+	uint8_t *line = NULL;
+
+	if (dst->bpp == IMAGE_BPP_BINARY) {
+		if (fb_avail() < FB_ALLOC_SPACE(src->w))
+			return stm32ipl_err_OutOfMemory;
+		line = fb_alloc(src->w, FB_ALLOC_PREFER_SPEED);
+	}
+
+	for (int y = 0; y < src->h; y++) {
+		uint8_t *out = line ? line : (dst->data + (y * dstStride));
+
+		switch (src->bpp) {
+			case IMAGE_BPP_YUV422:
+				ipl_yuv422_line(src->data + (y * srcStride), out, src->w, lineFormat);
+				break;
+
+			case IMAGE_BPP_NV12:
+				ipl_nv12_line(src->data + (y * srcStride), uvData + ((y / 2) * uvStride), out, src->w, lineFormat);
+				break;
+
+			default:
+				ipl_bayer_line(src, y, out, lineFormat);
+				break;
+		}
+
+		if (line)
+			ipl_convert_line(line, dst->data + (y * dstStride), src->w, IMAGE_BPP_GRAYSCALE, IMAGE_BPP_BINARY);
+	}
+
+	if (line)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
 /**
  * @brief Converts the source image data to the format of the destination image and stores the
  * converted data to the destination buffer. The two images must have the same resolution.
  * The destination image data buffer must be already allocated and must have the right size to
  * contain the converted image.
- * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888; the source image can also be YUV422, NV12 or
+ * Bayer (the missing colors are interpolated bilinearly); for such formats, the Grayscale conversion takes
+ * the luminance as it is, with YUV422 and NV12, and the reverse mode is not supported.
+ * @param src	  Source image.
+ * @param dst	  Destination image.
+ * @param reverse If true, the processing is executed in reverse mode (from the last to the first pixel),
+ * otherwise it is executed normally (from the first to the last pixel). When any of the two images is a view,
+ * the lines are converted one by one (from the last to the first line in reverse mode).
+ * @return		  stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ConvertRev(const image_t *src, image_t *dst, bool reverse)
+{
+	ipl_prefetch_t pf;
+	uint32_t srcStride;
+	uint32_t dstStride;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, (STM32IPL_IF_ALL | STM32IPL_IF_SENSOR))
+	STM32IPL_CHECK_FORMAT(dst, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+
+	if (src->data == dst->data)
+		return stm32ipl_err_InvalidParameter;
+
+	if (STM32Ipl_ImageFormatSupported(src, STM32IPL_IF_SENSOR)) {
+		if (reverse)
+			return stm32ipl_err_NotAllowed;
+
+		STM32IPL_TRACE_BEGIN(ConvertRev)
+		res = ipl_convert_sensor(src, dst);
+		STM32IPL_TRACE_END(ConvertRev)
+		return res;
+	}
+
+	STM32IPL_TRACE_BEGIN(ConvertRev)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	/* The DMA2D converts only non overlapping buffers, so the processing order does not matter. */
+	if (ipl_hw_convert(src, dst, true) == stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(ConvertRev)
+		return stm32ipl_err_Ok;
+	}
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	srcStride = STM32Ipl_ImageStride(src);
+	dstStride = STM32Ipl_ImageStride(dst);
+
+	/* When the row prefetch is active, the source lines are converted one at a time from the internal memory. */
+	ipl_prefetch_init(&pf, src->data, srcStride, STM32Ipl_DataSize(src->w, 1, (image_bpp_t)src->bpp),
+			reverse ? (src->h - 1) : 0);
+
+	if (!IPL_PREFETCH_ACTIVE(&pf) && !src->stride && !dst->stride) {
+		res = STM32Ipl_ConvertData(src->data, dst->data, src->w, src->h, src->bpp, dst->bpp, reverse);
+		STM32IPL_TRACE_END(ConvertRev)
+		return res;
+	}
+
+	for (int i = 0; i < src->h; i++) {
+		int y = reverse ? (src->h - 1 - i) : i;
+		int next = ((i + 1) < src->h) ? (reverse ? (y - 1) : (y + 1)) : -1;
+
+		res = STM32Ipl_ConvertData(ipl_prefetch_line(&pf, y, next), dst->data + y * dstStride, src->w, 1, src->bpp,
+				dst->bpp, reverse);
+		if (res != stm32ipl_err_Ok) {
+			ipl_prefetch_deinit(&pf);
+			STM32IPL_TRACE_END(ConvertRev)
+			return res;
+		}
+	}
+
+	ipl_prefetch_deinit(&pf);
+
+	STM32IPL_TRACE_END(ConvertRev)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Converts the source image data to the format of the destination image and stores the
+ * converted data to the destination buffer. The two images must have the same resolution.
+ * The destination image data buffer must be already allocated and must have the right size to
+ * contain the converted image.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888; the source image can also be YUV422, NV12 or
+ * Bayer (see STM32Ipl_ConvertRev()).
  * @param src	  Source image; if it is not valid, an error is returned.
  * @param dst	  Destination image; if it is not valid, an error is returned.
  * @return		  stm32ipl_err_Ok on success, error otherwise.
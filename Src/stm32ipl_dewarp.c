@@ -20,20 +20,29 @@
 
 #include "stm32ipl_imlib_int.h"
 #include "draw_dewarp.h"
+#ifdef IPL_DEWARP_HAS_MVE
+#include "mve_dewarp.h"
+#endif /* IPL_DEWARP_HAS_MVE */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define IMAGE_BPP_NB (IMAGE_BPP_JPEG + 1)
-#define MAPXY_TYPE_NB (MAPXY_SPARSE_FLOAT + 1)
+#define MAPXY_TYPE_NB (MAPXY_COMPILED + 1)
 #define DEWARP_ALGO_NB (DEWARP_BILINEAR + 1)
 
 typedef void (*dewarp_fct)(const image_t *, image_t *, const mapxy_t *);
 
-struct dpel_ctx {
+typedef void (*dewarp_compiled_fct)(const uint8_t *, uint32_t, const mapxy_compiled_t *, uint8_t *, const rectangle_t *);
+
+typedef void (*dewarp_span_fct)(const image_t *, uint8_t *, int, int32_t, int32_t, int32_t, int32_t);
+
+struct dspan_ctx {
 	const image_t *isrc;
 	image_t *idst;
+	dewarp_span_fct span;
+	int pel_size;
 };
 
 static int coord_to_map_idx(int r, int c, int idx, int w, int elem_nb)
@@ -41,6 +50,34 @@ static int coord_to_map_idx(int r, int c, int idx, int w, int elem_nb)
 	return (r * w + c) * elem_nb + idx;
 }
 
+/* Bilinear interpolation with the x and y fractions dx, dy in 1/16 units. */
+static inline uint32_t interpolate_q4(uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3, uint32_t dx, uint32_t dy)
+{
+	uint32_t top = (v0 << 4) + (v1 - v0) * dx;
+	uint32_t bottom = (v2 << 4) + (v3 - v2) * dx;
+
+	return ((top << 4) + (bottom - top) * dy + 128) >> 8;
+}
+
+/* Clips the span x0..x1 of the row y to the destination image, moving its start location (u, v) accordingly.
+ * Returns the number of pixels of the clipped span. */
+static int clip_span(const image_t *idst, int *x0, int x1, int y, int32_t *u, int32_t *v, int32_t du, int32_t dv)
+{
+	if (y < 0 || y >= idst->h || x1 < 0 || *x0 >= idst->w)
+		return 0;
+
+	if (*x0 < 0) {
+		*u -= *x0 * du;
+		*v -= *x0 * dv;
+		*x0 = 0;
+	}
+
+	x1 = x1 < idst->w ? x1 : idst->w - 1;
+
+	return x1 - *x0 + 1;
+}
+
+#ifndef IPL_DEWARP_HAS_MVE
 static uint8_t clamp(uint8_t v, uint8_t max)
 {
 	return v <= max ? v : max;
@@ -171,92 +208,141 @@ static void bilinear_rgb888(uint8_t *src, int x, int y, float dx, float dy, int
 	*b = interpolate(blue, dx, dy);
 }
 
-static void dpel_nearest_rgb888(void *ctx, int c, int r, float u_s, float v_s)
+/* Nearest source coordinate of the 16.16 fixed point location u, clamped to 0..max. */
+static inline int span_nearest(int32_t u, int max)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	int x = (int)(u_s + 0.5);
-	int y = (int)(v_s + 0.5);
-	uint8_t *src;
-	uint8_t *dst;
+	int i = (u + 0x8000) >> 16;
 
-	src = dctx->isrc->data + coord_to_map_idx(y, x, 0, dctx->isrc->w, 3);
-	dst = dctx->idst->data + coord_to_map_idx(r, c, 0, dctx->idst->w, 3);
-	*dst++ = *src++;
-	*dst++ = *src++;
-	*dst++ = *src++;
+	return i < 0 ? 0 : (i > max ? max : i);
 }
 
-static void dpel_bilinear_rgb888(void *ctx, int c, int r, float u_s, float v_s)
+/* Integer part and 8-bit fraction of the 16.16 fixed point location u (the upper clamp is done by read_*_quad()). */
+static inline int span_bilinear(int32_t u, uint32_t *f)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	uint8_t red, green, blue;
-	int x = (int)u_s;
-	int y = (int)v_s;
-	float dx = u_s - x;
-	float dy = v_s - y;
-	uint8_t *dst;
+	if (u < 0) {
+		*f = 0;
+		return 0;
+	}
 
-	bilinear_rgb888(dctx->isrc->data, x, y, dx, dy, dctx->isrc->w, dctx->isrc->h, &red, &green, &blue);
-	dst = dctx->idst->data + coord_to_map_idx(r, c, 0, dctx->idst->w, 3);
-	*dst++ = red;
-	*dst++ = green;
-	*dst++ = blue;
+	*f = (u >> 8) & 0xff;
+
+	return u >> 16;
 }
 
-static void dpel_nearest_rgb565(void *ctx, int c, int r, float u_s, float v_s)
+/* Bilinear interpolation with the x and y fractions fx, fy in 1/256 units (truncated). */
+static inline uint8_t interpolate_q8(const uint8_t value[4], uint32_t fx, uint32_t fy)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	uint16_t *src = (uint16_t *) dctx->isrc->data;
-	uint16_t *dst = (uint16_t *) dctx->idst->data;
-	int x = (int)(u_s + 0.5);
-	int y = (int)(v_s + 0.5);
+	uint32_t top = (value[0] << 8) + (value[1] - value[0]) * fx;
+	uint32_t bottom = (value[2] << 8) + (value[3] - value[2]) * fx;
 
-	dst[coord_to_map_idx(r, c, 0, dctx->idst->w, 1)] = src[coord_to_map_idx(y, x, 0, dctx->isrc->w, 1)];
+	return ((top << 8) + (bottom - top) * fy) >> 16;
 }
 
-static void dpel_bilinear_rgb565(void *ctx, int c, int r, float u_s, float v_s)
+static void span_nearest_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+								   int32_t dv)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	uint16_t *src = (uint16_t *) dctx->isrc->data;
-	uint16_t *dst = (uint16_t *) dctx->idst->data;
-	int x = (int)u_s;
-	int y = (int)v_s;
-	float dx = u_s - x;
-	float dy = v_s - y;
+	const uint8_t *src = isrc->data;
 
-	dst[coord_to_map_idx(r, c, 0, dctx->idst->w, 1)] = bilinear_rgb565(src, x, y, dx, dy, dctx->isrc->w, dctx->isrc->h);
+	for (; n > 0; n--, u += du, v += dv)
+		*dst++ = src[coord_to_map_idx(span_nearest(v, isrc->h - 1), span_nearest(u, isrc->w - 1), 0, isrc->w, 1)];
 }
 
-static void dpel_nearest_grayscale(void *ctx, int c, int r, float u_s, float v_s)
+static void span_bilinear_grayscale(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+									int32_t dv)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	uint8_t *src = (uint8_t *) dctx->isrc->data;
-	uint8_t *dst = (uint8_t *) dctx->idst->data;
-	int x = (int)(u_s + 0.5);
-	int y = (int)(v_s + 0.5);
+	uint8_t value[4];
+	uint32_t fx, fy;
+	int x, y;
+
+	for (; n > 0; n--, u += du, v += dv) {
+		x = span_bilinear(u, &fx);
+		y = span_bilinear(v, &fy);
+		read_grayscale_quad(isrc->data, x, y, isrc->w, isrc->h, value);
+		*dst++ = interpolate_q8(value, fx, fy);
+	}
+}
+
+static void span_nearest_rgb565(const image_t *isrc, uint8_t *dst_in, int n, int32_t u, int32_t v, int32_t du,
+								int32_t dv)
+{
+	const uint16_t *src = (const uint16_t *)isrc->data;
+	uint16_t *dst = (uint16_t *)dst_in;
+
+	for (; n > 0; n--, u += du, v += dv)
+		*dst++ = src[coord_to_map_idx(span_nearest(v, isrc->h - 1), span_nearest(u, isrc->w - 1), 0, isrc->w, 1)];
+}
+
+static void span_bilinear_rgb565(const image_t *isrc, uint8_t *dst_in, int n, int32_t u, int32_t v, int32_t du,
+								 int32_t dv)
+{
+	uint16_t *dst = (uint16_t *)dst_in;
+	uint8_t red[4], green[4], blue[4];
+	uint32_t fx, fy;
+	int x, y;
+
+	for (; n > 0; n--, u += du, v += dv) {
+		x = span_bilinear(u, &fx);
+		y = span_bilinear(v, &fy);
+		read_rgb565_quad((uint16_t *)isrc->data, x, y, isrc->w, isrc->h, red, green, blue);
+		*dst++ = (interpolate_q8(red, fx, fy) << 11) + (interpolate_q8(green, fx, fy) << 5) +
+				 interpolate_q8(blue, fx, fy);
+	}
+}
+
+static void span_nearest_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+								int32_t dv)
+{
+	const uint8_t *src;
+
+	for (; n > 0; n--, u += du, v += dv) {
+		src = isrc->data + coord_to_map_idx(span_nearest(v, isrc->h - 1), span_nearest(u, isrc->w - 1), 0,
+											isrc->w, 3);
+		*dst++ = *src++;
+		*dst++ = *src++;
+		*dst++ = *src++;
+	}
+}
+
+static void span_bilinear_rgb888(const image_t *isrc, uint8_t *dst, int n, int32_t u, int32_t v, int32_t du,
+								 int32_t dv)
+{
+	uint8_t red[4], green[4], blue[4];
+	uint32_t fx, fy;
+	int x, y;
 
-	dst[coord_to_map_idx(r, c, 0, dctx->idst->w, 1)] = src[coord_to_map_idx(y, x, 0, dctx->isrc->w, 1)];
+	for (; n > 0; n--, u += du, v += dv) {
+		x = span_bilinear(u, &fx);
+		y = span_bilinear(v, &fy);
+		read_rgb888_quad(isrc->data, x, y, isrc->w, isrc->h, red, green, blue);
+		*dst++ = interpolate_q8(red, fx, fy);
+		*dst++ = interpolate_q8(green, fx, fy);
+		*dst++ = interpolate_q8(blue, fx, fy);
+	}
 }
 
-static void dpel_bilinear_grayscale(void *ctx, int c, int r, float u_s, float v_s)
+#define SPAN_FCT(name) name
+#else
+#define SPAN_FCT(name) mve_dewarp_##name
+#endif /* IPL_DEWARP_HAS_MVE */
+
+static void dspan(void *ctx, int x0, int x1, int y, int32_t u, int32_t v, int32_t du, int32_t dv)
 {
-	struct dpel_ctx *dctx = (struct dpel_ctx *) ctx;
-	uint8_t *src = (uint8_t *) dctx->isrc->data;
-	uint8_t *dst = (uint8_t *) dctx->idst->data;
-	int x = (int)u_s;
-	int y = (int)v_s;
-	float dx = u_s - x;
-	float dy = v_s - y;
+	struct dspan_ctx *dctx = (struct dspan_ctx *) ctx;
+	int n = clip_span(dctx->idst, &x0, x1, y, &u, &v, du, dv);
 
-	dst[coord_to_map_idx(r, c, 0, dctx->idst->w, 1)] = bilinear_grayscale(src, x, y, dx, dy, dctx->isrc->w, dctx->isrc->h);
+	if (n > 0)
+		dctx->span(dctx->isrc, dctx->idst->data + coord_to_map_idx(y, x0, 0, dctx->idst->w, dctx->pel_size), n,
+				   u, v, du, dv);
 }
 
 static void dewarping_sparse_float_triangle(const image_t *isrc, image_t *idst, const mapxy_t *mapxy, const int idx[3],
-										    draw_dewarp_pel dpel)
+										    dewarp_span_fct span)
 {
-	struct dpel_ctx ctx = {
+	struct dspan_ctx ctx = {
 		.isrc = isrc,
-		.idst = idst
+		.idst = idst,
+		.span = span,
+		.pel_size = (isrc->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((isrc->bpp == IMAGE_BPP_RGB565) ? 2 : 3)
 	};
 	float u[3];
 	float v[3];
@@ -271,10 +357,11 @@ static void dewarping_sparse_float_triangle(const image_t *isrc, image_t *idst,
 		v[i] = mapxy->sparse_float.uv[coord_to_map_idx(0, idx[i], 1, 0, 2)];
 	}
 
-	draw_dewarp_triangle_fill(x[0], y[0], u[0], v[0], x[1], y[1], u[1], v[1], x[2], y[2], u[2], v[2], dpel, &ctx);
+	draw_dewarp_triangle_fill_span(x[0], y[0], u[0], v[0], x[1], y[1], u[1], v[1], x[2], y[2], u[2], v[2], dspan, &ctx);
 }
 
 /* rgb888 */
+#ifndef IPL_DEWARP_HAS_MVE
 static void dewarping_dense_float_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	uint8_t *src = isrc->data;
@@ -361,13 +448,15 @@ static void dewarping_dense_fp_12_4_bilinear_rgb888(const image_t *isrc, image_t
 	}
 }
 
+#endif /* IPL_DEWARP_HAS_MVE */
+
 static void dewarping_sparse_float_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	const int *tri_idx = mapxy->sparse_float.tri_idx;
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_nearest_rgb888);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_nearest_rgb888));
 		idx += 3;
 	}
 }
@@ -378,12 +467,13 @@ static void dewarping_sparse_float_bilinear_rgb888(const image_t *isrc, image_t
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_bilinear_rgb888);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_bilinear_rgb888));
 		idx += 3;
 	}
 }
 
 /* rgb565 */
+#ifndef IPL_DEWARP_HAS_MVE
 static void dewarping_dense_float_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	uint16_t *src = (uint16_t *)isrc->data;
@@ -458,13 +548,15 @@ static void dewarping_dense_fp_12_4_bilinear_rgb565(const image_t *isrc, image_t
 	}
 }
 
+#endif /* IPL_DEWARP_HAS_MVE */
+
 static void dewarping_sparse_float_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	const int *tri_idx = mapxy->sparse_float.tri_idx;
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_nearest_rgb565);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_nearest_rgb565));
 		idx += 3;
 	}
 }
@@ -475,12 +567,13 @@ static void dewarping_sparse_float_bilinear_rgb565(const image_t *isrc, image_t
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_bilinear_rgb565);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_bilinear_rgb565));
 		idx += 3;
 	}
 }
 
 /* grayscale */
+#ifndef IPL_DEWARP_HAS_MVE
 static void dewarping_dense_float_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	uint8_t *src = (uint8_t *)isrc->data;
@@ -555,13 +648,15 @@ static void dewarping_dense_fp_12_4_bilinear_grayscale(const image_t *isrc, imag
 	}
 }
 
+#endif /* IPL_DEWARP_HAS_MVE */
+
 static void dewarping_sparse_float_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
 {
 	const int *tri_idx = mapxy->sparse_float.tri_idx;
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_nearest_grayscale);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_nearest_grayscale));
 		idx += 3;
 	}
 }
@@ -572,11 +667,272 @@ static void dewarping_sparse_float_bilinear_grayscale(const image_t *isrc, image
 	int idx = 0;
 
 	while (tri_idx[idx] >= 0) {
-		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], dpel_bilinear_grayscale);
+		dewarping_sparse_float_triangle(isrc, idst, mapxy, &tri_idx[idx], SPAN_FCT(span_bilinear_grayscale));
 		idx += 3;
 	}
 }
 
+/* compiled */
+static void compiled_nearest_grayscale(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	int x, y;
+
+	(void)stride;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+
+		for (x = 0; x < r->w; x++, i++) {
+			uint32_t o = offset[i];
+
+			if (o != MAPXY_COMPILED_SKIP)
+				dst[i] = src[o];
+		}
+	}
+}
+
+static void compiled_bilinear_grayscale(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	const uint8_t *weight = map->weight;
+	int x, y;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+
+		for (x = 0; x < r->w; x++, i++) {
+			uint32_t o = offset[i];
+			uint32_t dx = weight[i] & 0xf;
+			uint32_t dy = weight[i] >> 4;
+			const uint8_t *p0, *p1;
+
+			if (o == MAPXY_COMPILED_SKIP)
+				continue;
+
+			/* A zero fraction also means that the next pixel may be out of the image. */
+			p0 = src + o;
+			p1 = dy ? p0 + stride : p0;
+			dst[i] = interpolate_q4(p0[0], p0[dx ? 1 : 0], p1[0], p1[dx ? 1 : 0], dx, dy);
+		}
+	}
+}
+
+static void compiled_nearest_rgb565(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	uint16_t *dst16 = (uint16_t *)dst;
+	int x, y;
+
+	(void)stride;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+
+		for (x = 0; x < r->w; x++, i++) {
+			uint32_t o = offset[i];
+
+			if (o != MAPXY_COMPILED_SKIP)
+				dst16[i] = *(const uint16_t *)(src + o);
+		}
+	}
+}
+
+static void compiled_bilinear_rgb565(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	const uint8_t *weight = map->weight;
+	uint16_t *dst16 = (uint16_t *)dst;
+	int x, y;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+
+		for (x = 0; x < r->w; x++, i++) {
+			uint32_t o = offset[i];
+			uint32_t dx = weight[i] & 0xf;
+			uint32_t dy = weight[i] >> 4;
+			const uint16_t *p0, *p1;
+			uint32_t v0, v1, v2, v3;
+			uint32_t cr, cg, cb;
+
+			if (o == MAPXY_COMPILED_SKIP)
+				continue;
+
+			p0 = (const uint16_t *)(src + o);
+			p1 = dy ? (const uint16_t *)(src + o + stride) : p0;
+			v0 = p0[0];
+			v1 = p0[dx ? 1 : 0];
+			v2 = p1[0];
+			v3 = p1[dx ? 1 : 0];
+
+			cr = interpolate_q4(v0 >> 11, v1 >> 11, v2 >> 11, v3 >> 11, dx, dy);
+			cg = interpolate_q4((v0 >> 5) & 0x3f, (v1 >> 5) & 0x3f, (v2 >> 5) & 0x3f, (v3 >> 5) & 0x3f, dx, dy);
+			cb = interpolate_q4(v0 & 0x1f, v1 & 0x1f, v2 & 0x1f, v3 & 0x1f, dx, dy);
+
+			dst16[i] = (cr << 11) | (cg << 5) | cb;
+		}
+	}
+}
+
+static void compiled_nearest_rgb888(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	int x, y;
+
+	(void)stride;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+		uint8_t *d = dst + i * 3;
+
+		for (x = 0; x < r->w; x++, i++, d += 3) {
+			uint32_t o = offset[i];
+
+			if (o != MAPXY_COMPILED_SKIP) {
+				d[0] = src[o];
+				d[1] = src[o + 1];
+				d[2] = src[o + 2];
+			}
+		}
+	}
+}
+
+static void compiled_bilinear_rgb888(const uint8_t *src, uint32_t stride, const mapxy_compiled_t *map, uint8_t *dst,
+		const rectangle_t *r)
+{
+	const uint32_t *offset = map->offset;
+	const uint8_t *weight = map->weight;
+	int x, y;
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		int i = y * map->w + r->x;
+		uint8_t *d = dst + i * 3;
+
+		for (x = 0; x < r->w; x++, i++, d += 3) {
+			uint32_t o = offset[i];
+			uint32_t dx = weight[i] & 0xf;
+			uint32_t dy = weight[i] >> 4;
+			uint32_t nx = dx ? 3 : 0;
+			const uint8_t *p0, *p1;
+
+			if (o == MAPXY_COMPILED_SKIP)
+				continue;
+
+			p0 = src + o;
+			p1 = dy ? p0 + stride : p0;
+			d[0] = interpolate_q4(p0[0], p0[nx], p1[0], p1[nx], dx, dy);
+			d[1] = interpolate_q4(p0[1], p0[nx + 1], p1[1], p1[nx + 1], dx, dy);
+			d[2] = interpolate_q4(p0[2], p0[nx + 2], p1[2], p1[nx + 2], dx, dy);
+		}
+	}
+}
+
+/* Gets the destination block idx of a tiled compiled map. */
+static void compiled_get_block(const mapxy_compiled_t *map, int idx, rectangle_t *r)
+{
+	int nbx = (map->w + map->blockW - 1) / map->blockW;
+
+	r->x = (idx % nbx) * map->blockW;
+	r->y = (idx / nbx) * map->blockH;
+	r->w = IM_MIN(map->blockW, map->w - r->x);
+	r->h = IM_MIN(map->blockH, map->h - r->y);
+}
+
+/* Starts the copy of the source box of a block to the given buffer. */
+static void compiled_load_block(const image_t *isrc, const rectangle_t *box, uint8_t *buffer, int bpp)
+{
+	uint32_t stride = isrc->w * bpp;
+
+	if (box->w && box->h)
+		STM32Ipl_BlockCopyStart(buffer, box->w * bpp, isrc->data + (box->y * stride) + (box->x * bpp), stride,
+								box->w * bpp, box->h);
+}
+
+/* Applies a compiled map. When the map is tiled, the destination is produced block by block, reading the source
+ * from a copy of the block's source box in the fast memory; with two buffers, the copy of the next box is started
+ * before remapping the current block, so a DMA based STM32Ipl_BlockCopyStart() overlaps with the computation. */
+static void dewarping_compiled(const image_t *isrc, image_t *idst, const mapxy_compiled_t *map, dewarp_compiled_fct fct)
+{
+	int bpp = (map->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((map->bpp == IMAGE_BPP_RGB565) ? 2 : 3);
+	uint8_t *buffers[2];
+	uint32_t nBuffers;
+	int nBlocks;
+	int i;
+
+	if (!map->blockW) {
+		rectangle_t r = { 0, 0, map->w, map->h };
+
+		fct(isrc->data, isrc->w * bpp, map, idst->data, &r);
+		return;
+	}
+
+	nBuffers = (fb_avail() >= (2 * map->blockSize)) ? 2 : 1;
+	buffers[0] = fb_alloc(nBuffers * map->blockSize, FB_ALLOC_PREFER_SPEED);
+	buffers[1] = buffers[0] + ((nBuffers - 1) * map->blockSize);
+
+	nBlocks = ((map->w + map->blockW - 1) / map->blockW) * ((map->h + map->blockH - 1) / map->blockH);
+
+	compiled_load_block(isrc, &map->blockSrc[0], buffers[0], bpp);
+
+	for (i = 0; i < nBlocks; i++) {
+		uint32_t cur = i & (nBuffers - 1);
+		uint32_t next = (i + 1) & (nBuffers - 1);
+		rectangle_t r;
+
+		STM32Ipl_BlockCopyWait();
+
+		if ((nBuffers == 2) && ((i + 1) < nBlocks))
+			compiled_load_block(isrc, &map->blockSrc[i + 1], buffers[next], bpp);
+
+		compiled_get_block(map, i, &r);
+		fct(buffers[cur], map->blockSrc[i].w * bpp, map, idst->data, &r);
+
+		/* With a single buffer, the next box is loaded after the current block has been remapped. */
+		if ((nBuffers == 1) && ((i + 1) < nBlocks))
+			compiled_load_block(isrc, &map->blockSrc[i + 1], buffers[0], bpp);
+	}
+
+	STM32Ipl_BlockCopyWait();
+
+	fb_free();
+}
+
+static void dewarping_compiled_nearest_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_nearest_grayscale);
+}
+
+static void dewarping_compiled_bilinear_grayscale(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_bilinear_grayscale);
+}
+
+static void dewarping_compiled_nearest_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_nearest_rgb565);
+}
+
+static void dewarping_compiled_bilinear_rgb565(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_bilinear_rgb565);
+}
+
+static void dewarping_compiled_nearest_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_nearest_rgb888);
+}
+
+static void dewarping_compiled_bilinear_rgb888(const image_t *isrc, image_t *idst, const mapxy_t *mapxy)
+{
+	dewarping_compiled(isrc, idst, mapxy->compiled, compiled_bilinear_rgb888);
+}
+
 static stm32ipl_err_t dewarping_check_params_mapxy(const mapxy_t *mapxy)
 {
 	switch (mapxy->type) {
@@ -592,6 +948,14 @@ static stm32ipl_err_t dewarping_check_params_mapxy(const mapxy_t *mapxy)
 		else
 			return stm32ipl_err_InvalidParameter;
 		break;
+	case MAPXY_COMPILED:
+		if (mapxy->compiled && mapxy->compiled->offset &&
+			(mapxy->compiled->algo == DEWARP_NEAREST || mapxy->compiled->weight) &&
+			(!mapxy->compiled->blockW || mapxy->compiled->blockSrc))
+			return stm32ipl_err_Ok;
+		else
+			return stm32ipl_err_InvalidParameter;
+		break;
 	default:
 		return stm32ipl_err_InvalidParameter;
 	}
@@ -599,47 +963,696 @@ static stm32ipl_err_t dewarping_check_params_mapxy(const mapxy_t *mapxy)
 
 static stm32ipl_err_t dewarping_check_params(const image_t *src, image_t *dst, const mapxy_t *mapxy, dewarping_algo_t algo)
 {
+	stm32ipl_err_t ret;
+
 	/* check null pointer first */
 	if (!src || !dst || !mapxy || !src->data || !dst->data)
 		return stm32ipl_err_InvalidParameter;
 
-	/* check src and dst compat */
-	if (src->w != dst->w || src->h != dst->h || src->bpp != dst->bpp || src->data == dst->data)
+	/* check src and dst compat (different sizes or formats are handled by dewarping_fused()) */
+	if (!dst->w || !dst->h || src->data == dst->data)
 		return stm32ipl_err_InvalidParameter;
 
 	if (algo != DEWARP_NEAREST && algo != DEWARP_BILINEAR)
 		return stm32ipl_err_InvalidParameter;
 
-	return dewarping_check_params_mapxy(mapxy);
+	if ((uint32_t)src->bpp >= IMAGE_BPP_NB || (uint32_t)dst->bpp >= IMAGE_BPP_NB)
+		return stm32ipl_err_UnsupportedFormat;
+
+	/* views are not supported */
+	if (src->stride || dst->stride)
+		return stm32ipl_err_NotAllowed;
+
+	ret = dewarping_check_params_mapxy(mapxy);
+	if (ret)
+		return ret;
+
+	/* a compiled map is bound to the size, the format and the algorithm it was compiled for */
+	if (mapxy->type == MAPXY_COMPILED && (mapxy->compiled->w != src->w || mapxy->compiled->h != src->h ||
+		mapxy->compiled->bpp != (image_bpp_t)src->bpp || mapxy->compiled->algo != algo))
+		return stm32ipl_err_InvalidParameter;
+
+	return stm32ipl_err_Ok;
 }
 
 static dewarp_fct dewarp_fct_implementations[IMAGE_BPP_NB][MAPXY_TYPE_NB][DEWARP_ALGO_NB] = {
 	// IMAGE_BPP_BINARY => unsupported
-	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
+	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
 	// IMAGE_BPP_GRAYSCALE
 	{
+#ifdef IPL_DEWARP_HAS_MVE
+		{mve_dewarp_dense_float_nearest_grayscale, mve_dewarp_dense_float_bilinear_grayscale },
+		{mve_dewarp_dense_fp_12_4_nearest_grayscale, mve_dewarp_dense_fp_12_4_bilinear_grayscale },
+#else
 		{dewarping_dense_float_nearest_grayscale, dewarping_dense_float_bilinear_grayscale },
 		{dewarping_dense_fp_12_4_nearest_grayscale, dewarping_dense_fp_12_4_bilinear_grayscale },
+#endif /* IPL_DEWARP_HAS_MVE */
 		{dewarping_sparse_float_nearest_grayscale, dewarping_sparse_float_bilinear_grayscale },
+		{dewarping_compiled_nearest_grayscale, dewarping_compiled_bilinear_grayscale },
 	},
 	// IMAGE_BPP_RGB565
 	{
+#ifdef IPL_DEWARP_HAS_MVE
+		{mve_dewarp_dense_float_nearest_rgb565, mve_dewarp_dense_float_bilinear_rgb565 },
+		{mve_dewarp_dense_fp_12_4_nearest_rgb565, mve_dewarp_dense_fp_12_4_bilinear_rgb565 },
+#else
 		{dewarping_dense_float_nearest_rgb565, dewarping_dense_float_bilinear_rgb565 },
 		{dewarping_dense_fp_12_4_nearest_rgb565, dewarping_dense_fp_12_4_bilinear_rgb565 },
+#endif /* IPL_DEWARP_HAS_MVE */
 		{dewarping_sparse_float_nearest_rgb565, dewarping_sparse_float_bilinear_rgb565 },
+		{dewarping_compiled_nearest_rgb565, dewarping_compiled_bilinear_rgb565 },
 	},
 	// IMAGE_BPP_BAYER => unsupported
-	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
+	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
 	// IMAGE_BPP_RGB888
 	{
+#ifdef IPL_DEWARP_HAS_MVE
+		{mve_dewarp_dense_float_nearest_rgb888, mve_dewarp_dense_float_bilinear_rgb888 },
+		{mve_dewarp_dense_fp_12_4_nearest_rgb888, mve_dewarp_dense_fp_12_4_bilinear_rgb888 },
+#else
 		{dewarping_dense_float_nearest_rgb888, dewarping_dense_float_bilinear_rgb888 },
 		{dewarping_dense_fp_12_4_nearest_rgb888, dewarping_dense_fp_12_4_bilinear_rgb888 },
+#endif /* IPL_DEWARP_HAS_MVE */
 		{dewarping_sparse_float_nearest_rgb888, dewarping_sparse_float_bilinear_rgb888 },
+		{dewarping_compiled_nearest_rgb888, dewarping_compiled_bilinear_rgb888 },
 	},
 	// IMAGE_BPP_JPEG => unsupported
-	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
+	{{NULL, NULL }, {NULL, NULL }, {NULL, NULL }, {NULL, NULL }},
 };
 
+/* Gets the byte offset and the bilinear weights of the source location (xq, yq), in 1/16 pixel units. The location is
+ * clamped to the image, and the fraction is zeroed on the last column (row), so the next pixel is never read out of
+ * the image. */
+static uint32_t compile_location(int w, int h, int bpp, dewarping_algo_t algo, int xq, int yq, uint8_t *weight)
+{
+	int x, y, dx, dy;
+
+	xq = xq < 0 ? 0 : xq;
+	yq = yq < 0 ? 0 : yq;
+
+	if (algo == DEWARP_NEAREST) {
+		x = (xq + 8) >> 4;
+		y = (yq + 8) >> 4;
+		dx = 0;
+		dy = 0;
+	} else {
+		x = xq >> 4;
+		y = yq >> 4;
+		dx = xq & 0xf;
+		dy = yq & 0xf;
+	}
+
+	if (x >= w - 1) {
+		x = w - 1;
+		dx = 0;
+	}
+
+	if (y >= h - 1) {
+		y = h - 1;
+		dy = 0;
+	}
+
+	*weight = (uint8_t)(dx | (dy << 4));
+
+	return (uint32_t)coord_to_map_idx(y, x, 0, w, bpp);
+}
+
+/* Sets the compiled entry idx from the source location (xq, yq), in 1/16 pixel units. */
+static void compile_entry(mapxy_compiled_t *map, int idx, int xq, int yq)
+{
+	int bpp = (map->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((map->bpp == IMAGE_BPP_RGB565) ? 2 : 3);
+	uint8_t weight;
+
+	map->offset[idx] = compile_location(map->w, map->h, bpp, map->algo, xq, yq, &weight);
+	if (map->weight)
+		map->weight[idx] = weight;
+}
+
+static int compile_float_to_q4(float v, dewarping_algo_t algo)
+{
+	return (algo == DEWARP_NEAREST) ? (int)(v + 0.5f) * 16 : (int)(v * 16.0f + 0.5f);
+}
+
+static void dpel_compile(void *ctx, int c, int r, float u_s, float v_s)
+{
+	mapxy_compiled_t *map = (mapxy_compiled_t *) ctx;
+
+	if (c >= 0 && c < map->w && r >= 0 && r < map->h)
+		compile_entry(map, coord_to_map_idx(r, c, 0, map->w, 1), compile_float_to_q4(u_s, map->algo),
+					  compile_float_to_q4(v_s, map->algo));
+}
+
+static void compile_map(const mapxy_t *mapxy, mapxy_compiled_t *map)
+{
+	int n = map->w * map->h;
+	int i;
+
+	switch (mapxy->type) {
+	case MAPXY_DENSE_FLOAT:
+		for (i = 0; i < n; i++)
+			compile_entry(map, i, compile_float_to_q4(mapxy->dense_float[coord_to_map_idx(0, i, 1, 0, 2)], map->algo),
+						  compile_float_to_q4(mapxy->dense_float[coord_to_map_idx(0, i, 0, 0, 2)], map->algo));
+		break;
+	case MAPXY_DENSE_FIXED_POINT_12_4:
+		for (i = 0; i < n; i++)
+			compile_entry(map, i, mapxy->dense_fp[coord_to_map_idx(0, i, 1, 0, 2)],
+						  mapxy->dense_fp[coord_to_map_idx(0, i, 0, 0, 2)]);
+		break;
+	case MAPXY_SPARSE_FLOAT: {
+		const int *tri_idx = mapxy->sparse_float.tri_idx;
+		int idx = 0;
+
+		for (i = 0; i < n; i++)
+			map->offset[i] = MAPXY_COMPILED_SKIP;
+
+		while (tri_idx[idx] >= 0) {
+			float u[3];
+			float v[3];
+			int x[3];
+			int y[3];
+
+			for (i = 0; i < 3; i++) {
+				x[i] = mapxy->sparse_float.vertices[coord_to_map_idx(0, tri_idx[idx + i], 0, 0, 2)];
+				y[i] = mapxy->sparse_float.vertices[coord_to_map_idx(0, tri_idx[idx + i], 1, 0, 2)];
+				u[i] = mapxy->sparse_float.uv[coord_to_map_idx(0, tri_idx[idx + i], 0, 0, 2)];
+				v[i] = mapxy->sparse_float.uv[coord_to_map_idx(0, tri_idx[idx + i], 1, 0, 2)];
+			}
+
+			draw_dewarp_triangle_fill(x[0], y[0], u[0], v[0], x[1], y[1], u[1], v[1], x[2], y[2], u[2], v[2],
+									  dpel_compile, map);
+			idx += 3;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* Computes the source box of each block of a tiled compiled map (the pixels read by the block, including the
+ * bilinear neighbors) and makes the block offsets relative to the box, whose stride is the box width. */
+static void compile_blocks(mapxy_compiled_t *map)
+{
+	int bpp = (map->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((map->bpp == IMAGE_BPP_RGB565) ? 2 : 3);
+	int nBlocks = ((map->w + map->blockW - 1) / map->blockW) * ((map->h + map->blockH - 1) / map->blockH);
+	int k, x, y;
+
+	map->blockSize = 0;
+
+	for (k = 0; k < nBlocks; k++) {
+		rectangle_t *box = &map->blockSrc[k];
+		int x0 = map->w, y0 = map->h, x1 = -1, y1 = -1;
+		rectangle_t r;
+
+		compiled_get_block(map, k, &r);
+
+		for (y = r.y; y < r.y + r.h; y++) {
+			for (x = r.x; x < r.x + r.w; x++) {
+				int i = y * map->w + x;
+				uint32_t o = map->offset[i];
+				uint32_t sx, sy;
+
+				if (o == MAPXY_COMPILED_SKIP)
+					continue;
+
+				sx = (o / bpp) % map->w;
+				sy = (o / bpp) / map->w;
+				x0 = IM_MIN(x0, (int)sx);
+				y0 = IM_MIN(y0, (int)sy);
+				x1 = IM_MAX(x1, (int)sx + ((map->weight && (map->weight[i] & 0xf)) ? 1 : 0));
+				y1 = IM_MAX(y1, (int)sy + ((map->weight && (map->weight[i] >> 4)) ? 1 : 0));
+			}
+		}
+
+		if (x1 < 0) {
+			/* all the pixels of the block are skipped */
+			box->x = 0;
+			box->y = 0;
+			box->w = 0;
+			box->h = 0;
+			continue;
+		}
+
+		box->x = x0;
+		box->y = y0;
+		box->w = x1 - x0 + 1;
+		box->h = y1 - y0 + 1;
+		map->blockSize = IM_MAX(map->blockSize, (uint32_t)(box->w * box->h * bpp));
+
+		for (y = r.y; y < r.y + r.h; y++) {
+			for (x = r.x; x < r.x + r.w; x++) {
+				int i = y * map->w + x;
+				uint32_t o = map->offset[i];
+
+				if (o != MAPXY_COMPILED_SKIP)
+					map->offset[i] = (((o / bpp) / map->w - y0) * box->w + ((o / bpp) % map->w - x0)) * bpp;
+			}
+		}
+	}
+}
+
+/* Checks the parameters of a compiled map and allocates its data buffers. */
+static stm32ipl_err_t compile_alloc(uint32_t width, uint32_t height, image_bpp_t srcFmt, dewarping_algo_t algo,
+		uint16_t blockW, uint16_t blockH, mapxy_compiled_t *compiled)
+{
+	uint32_t n = width * height;
+	uint32_t nBlocks;
+
+	if (!width || !height || width > UINT16_MAX || height > UINT16_MAX)
+		return stm32ipl_err_InvalidParameter;
+
+	if (algo != DEWARP_NEAREST && algo != DEWARP_BILINEAR)
+		return stm32ipl_err_InvalidParameter;
+
+	if ((blockW == 0) != (blockH == 0))
+		return stm32ipl_err_InvalidParameter;
+
+	if (srcFmt != IMAGE_BPP_GRAYSCALE && srcFmt != IMAGE_BPP_RGB565 && srcFmt != IMAGE_BPP_RGB888)
+		return stm32ipl_err_UnsupportedFormat;
+
+	compiled->w = width;
+	compiled->h = height;
+	compiled->bpp = srcFmt;
+	compiled->algo = algo;
+	compiled->blockW = blockW;
+	compiled->blockH = blockH;
+	compiled->blockSize = 0;
+	compiled->offset = xalloc(n * sizeof(uint32_t));
+	compiled->weight = (algo == DEWARP_BILINEAR) ? xalloc(n) : NULL;
+	compiled->blockSrc = NULL;
+	if (blockW) {
+		nBlocks = ((width + blockW - 1) / blockW) * ((height + blockH - 1) / blockH);
+		compiled->blockSrc = xalloc(nBlocks * sizeof(rectangle_t));
+	}
+
+	if (!compiled->offset || (algo == DEWARP_BILINEAR && !compiled->weight) || (blockW && !compiled->blockSrc)) {
+		STM32Ipl_DewarpReleaseMap(compiled);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Compiles a dewarping map into a runtime format, to be used with STM32Ipl_Dewarp() through a mapxy of type
+ * MAPXY_COMPILED: for each destination pixel, it stores the byte offset of the source pixel and, with DEWARP_BILINEAR,
+ * the two 4-bit bilinear fractions packed in a byte (5 bytes per pixel), so the dewarping is done with integer math
+ * only and without any per pixel coordinate computation. Useful when the same map is applied to every frame
+ * (e.g. fisheye correction).
+ * The data buffers must be released with STM32Ipl_DewarpReleaseMap().
+ * @param mapxy			Mapping data to be compiled (dense or sparse); it is not needed after the compilation.
+ * @param width			Width of the images to be dewarped.
+ * @param height		Height of the images to be dewarped.
+ * @param srcFmt		Format of the images to be dewarped: Grayscale, RGB565, RGB888.
+ * @param algo			Interpolation algorithm; the compiled map can be used only with it.
+ * @param compiled		Compiled map.
+ * @return	stm32ipl_err_Ok on success, error otherwise
+ * @note The fractional part of the source locations is quantized to 1/16 pixel (that is the 12.4 fixed point
+ * precision); the source locations are clamped to the image.
+ */
+stm32ipl_err_t STM32Ipl_DewarpCompileMap(const mapxy_t *mapxy, uint32_t width, uint32_t height, image_bpp_t srcFmt,
+		dewarping_algo_t algo, mapxy_compiled_t *compiled)
+{
+	return STM32Ipl_DewarpCompileMapTiled(mapxy, width, height, srcFmt, algo, 0, 0, compiled);
+}
+
+/**
+ * @brief Compiles a dewarping map as STM32Ipl_DewarpCompileMap() does, but for a block-order traversal: the
+ * destination image is split in blocks of blockW x blockH pixels and, for each block, the bounding box of the source
+ * pixels it reads is computed at compile time. STM32Ipl_Dewarp() then produces the destination block by block, copying
+ * the source box of each block to a buffer allocated in the internal memory (when available) with
+ * STM32Ipl_BlockCopyStart() and remapping from there, so the random reads of the source image hit the fast memory
+ * instead of the external one. When there is enough memory for two boxes, the copy of the next box is started before
+ * remapping the current block, so that, if STM32Ipl_BlockCopyStart() and STM32Ipl_BlockCopyWait() are re-defined to
+ * use a DMA, the transfers overlap with the computation. The result is the same of the non-tiled compiled map.
+ * The data buffers must be released with STM32Ipl_DewarpReleaseMap().
+ * @param mapxy			Mapping data to be compiled (dense or sparse); it is not needed after the compilation.
+ * @param width			Width of the images to be dewarped.
+ * @param height		Height of the images to be dewarped.
+ * @param srcFmt		Format of the images to be dewarped: Grayscale, RGB565, RGB888.
+ * @param algo			Interpolation algorithm; the compiled map can be used only with it.
+ * @param blockW		Width of the destination blocks; 0 (together with blockH) disables the block-order traversal.
+ * @param blockH		Height of the destination blocks; 0 (together with blockW) disables the block-order traversal.
+ * @param compiled		Compiled map; its blockSize field is the size (bytes) of the largest source box, that is the
+ * minimum memory STM32Ipl_Dewarp() needs (twice this value to overlap copies and computation).
+ * @return	stm32ipl_err_Ok on success, error otherwise
+ * @note The strongly distorted areas (e.g. the fisheye borders) have larger source boxes: the block size should be
+ * chosen so that blockSize fits the internal memory.
+ */
+stm32ipl_err_t STM32Ipl_DewarpCompileMapTiled(const mapxy_t *mapxy, uint32_t width, uint32_t height,
+		image_bpp_t srcFmt, dewarping_algo_t algo, uint16_t blockW, uint16_t blockH, mapxy_compiled_t *compiled)
+{
+	stm32ipl_err_t ret;
+
+	if (!mapxy || !compiled || mapxy->type == MAPXY_COMPILED)
+		return stm32ipl_err_InvalidParameter;
+
+	ret = dewarping_check_params_mapxy(mapxy);
+	if (ret)
+		return ret;
+
+	ret = compile_alloc(width, height, srcFmt, algo, blockW, blockH, compiled);
+	if (ret)
+		return ret;
+
+	compile_map(mapxy, compiled);
+
+	if (blockW)
+		compile_blocks(compiled);
+
+	return stm32ipl_err_Ok;
+}
+
+///@cond
+/**
+ * Compiles a dewarping map whose source locations are computed by a function (e.g. from the parameters of a lens or
+ * a rotation correction), without building a dense map first.
+ * fct		Function giving the source location of each destination pixel; the pixels for which it returns false are
+ * 			left unchanged by STM32Ipl_Dewarp().
+ * arg		Argument of fct.
+ * width	Width of the images to be dewarped.
+ * height	Height of the images to be dewarped.
+ * srcFmt	Format of the images to be dewarped: Grayscale, RGB565, RGB888.
+ * algo		Interpolation algorithm.
+ * compiled	Compiled map, to be released with STM32Ipl_DewarpReleaseMap().
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t ipl_dewarp_compile_generated(ipl_dewarp_map_fct fct, void *arg, uint32_t width, uint32_t height,
+		image_bpp_t srcFmt, dewarping_algo_t algo, mapxy_compiled_t *compiled)
+{
+	int32_t xq, yq;
+	stm32ipl_err_t ret;
+	int idx = 0;
+
+	if (!fct || !compiled)
+		return stm32ipl_err_InvalidParameter;
+
+	ret = compile_alloc(width, height, srcFmt, algo, 0, 0, compiled);
+	if (ret)
+		return ret;
+
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++, idx++)
+			if (fct(arg, x, y, &xq, &yq))
+				compile_entry(compiled, idx, xq, yq);
+			else
+				compiled->offset[idx] = MAPXY_COMPILED_SKIP;
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
+/**
+ * @brief Releases the data buffers of a compiled dewarping map and resets it.
+ * @param compiled		Compiled map.
+ * @return	void
+ */
+void STM32Ipl_DewarpReleaseMap(mapxy_compiled_t *compiled)
+{
+	if (compiled) {
+		xfree(compiled->offset);
+		xfree(compiled->weight);
+		xfree(compiled->blockSrc);
+		compiled->w = 0;
+		compiled->h = 0;
+		compiled->blockW = 0;
+		compiled->blockH = 0;
+		compiled->blockSize = 0;
+		compiled->offset = NULL;
+		compiled->weight = NULL;
+		compiled->blockSrc = NULL;
+	}
+}
+
+/* Gets the distorted (source) location of the undistorted pixel (u, v), with the OpenCV camera models, clamped to the
+ * image. */
+static void calib_location(const stm32ipl_camera_calib_t *calib, float u, float v, uint32_t width, uint32_t height,
+		float *xs, float *ys)
+{
+	const float *k = calib->dist;
+	float x = (u - (calib->newCx ? calib->newCx : calib->cx)) / (calib->newFx ? calib->newFx : calib->fx);
+	float y = (v - (calib->newCy ? calib->newCy : calib->cy)) / (calib->newFy ? calib->newFy : calib->fy);
+	float r2 = (x * x) + (y * y);
+	float xd, yd;
+
+	if (calib->model == stm32ipl_calib_model_fisheye) {
+		float r = sqrtf(r2);
+		float theta = atanf(r);
+		float theta2 = theta * theta;
+		float thetaD = theta * (1.0f + theta2 * (k[0] + theta2 * (k[1] + theta2 * (k[2] + theta2 * k[3]))));
+		float scale = (r > 1e-8f) ? (thetaD / r) : 1.0f;
+
+		xd = x * scale;
+		yd = y * scale;
+	} else {
+		float radial = 1.0f + r2 * (k[0] + r2 * (k[1] + r2 * k[4]));
+
+		xd = (x * radial) + (2.0f * k[2] * x * y) + (k[3] * (r2 + 2.0f * x * x));
+		yd = (y * radial) + (k[2] * (r2 + 2.0f * y * y)) + (2.0f * k[3] * x * y);
+	}
+
+	*xs = IM_MIN(IM_MAX((calib->fx * xd) + calib->cx, 0.0f), (float)(width - 1));
+	*ys = IM_MIN(IM_MAX((calib->fy * yd) + calib->cy, 0.0f), (float)(height - 1));
+}
+
+/**
+ * @brief Generates a dewarping map from a camera calibration (OpenCV camera matrix and distortion coefficients, with
+ * the pinhole or the fisheye model), so that the maps do not need to be computed offline and stored in the flash, and
+ * the camera can be re-calibrated on the field. The map can be used as it is with STM32Ipl_Dewarp() or be compiled with
+ * STM32Ipl_DewarpCompileMap().
+ * With gridStep equal to 0, a dense 12.4 fixed point map is generated (MAPXY_DENSE_FIXED_POINT_12_4, 4 bytes per
+ * pixel); otherwise, a sparse triangle mesh (MAPXY_SPARSE_FLOAT) is generated, with a vertex every gridStep pixels
+ * (about 20 bytes per vertex), the distortion being linearly interpolated inside the triangles.
+ * The data buffers must be released with STM32Ipl_DewarpReleaseCalibMap().
+ * @param calib		Camera calibration.
+ * @param width		Width of the images to be dewarped.
+ * @param height	Height of the images to be dewarped.
+ * @param gridStep	Distance (pixels) between the vertices of the sparse mesh; 0 for a dense map.
+ * @param mapxy		Generated map; the source locations are clamped to the image.
+ * @return	stm32ipl_err_Ok on success, error otherwise
+ * @note The dense 12.4 fixed point map supports images up to 4096 x 4096 pixels.
+ */
+stm32ipl_err_t STM32Ipl_DewarpMapFromCalib(const stm32ipl_camera_calib_t *calib, uint32_t width, uint32_t height,
+		uint16_t gridStep, mapxy_t *mapxy)
+{
+	float xs, ys;
+
+	if (!calib || !mapxy || !width || !height || (calib->fx <= 0.0f) || (calib->fy <= 0.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	if (calib->model != stm32ipl_calib_model_pinhole && calib->model != stm32ipl_calib_model_fisheye)
+		return stm32ipl_err_InvalidParameter;
+
+	if (gridStep == 0) {
+		uint16_t *map;
+
+		if (width > 4096 || height > 4096)
+			return stm32ipl_err_InvalidParameter;
+
+		map = xalloc(width * height * 2 * sizeof(uint16_t));
+		if (!map)
+			return stm32ipl_err_OutOfMemory;
+
+		for (uint32_t r = 0; r < height; r++)
+			for (uint32_t c = 0; c < width; c++) {
+				calib_location(calib, c, r, width, height, &xs, &ys);
+				map[coord_to_map_idx(r, c, 0, width, 2)] = (uint16_t)(ys * 16.0f + 0.5f);
+				map[coord_to_map_idx(r, c, 1, width, 2)] = (uint16_t)(xs * 16.0f + 0.5f);
+			}
+
+		mapxy->type = MAPXY_DENSE_FIXED_POINT_12_4;
+		mapxy->dense_fp = map;
+	} else {
+		/* The last vertices are on the right (bottom) border of the last pixels, so that the whole image is covered. */
+		uint32_t nx = (width + gridStep - 1) / gridStep + 1;
+		uint32_t ny = (height + gridStep - 1) / gridStep + 1;
+		uint32_t nVertices = nx * ny;
+		uint32_t nTriangles = 2 * (nx - 1) * (ny - 1);
+		int *vertices;
+		float *uv;
+		int *triIdx;
+
+		/* a single buffer: vertices, uv, triangle indexes (with the sentinel) */
+		vertices = xalloc((nVertices * 2 * (sizeof(int) + sizeof(float))) + ((nTriangles + 1) * 3 * sizeof(int)));
+		if (!vertices)
+			return stm32ipl_err_OutOfMemory;
+
+		uv = (float *)(vertices + nVertices * 2);
+		triIdx = (int *)(uv + nVertices * 2);
+
+		for (uint32_t j = 0, i = 0; j < ny; j++)
+			for (uint32_t k = 0; k < nx; k++, i++) {
+				int x = IM_MIN(k * gridStep, width);
+				int y = IM_MIN(j * gridStep, height);
+
+				calib_location(calib, x, y, width, height, &xs, &ys);
+				vertices[coord_to_map_idx(0, i, 0, 0, 2)] = x;
+				vertices[coord_to_map_idx(0, i, 1, 0, 2)] = y;
+				uv[coord_to_map_idx(0, i, 0, 0, 2)] = xs;
+				uv[coord_to_map_idx(0, i, 1, 0, 2)] = ys;
+			}
+
+		for (uint32_t j = 0; j < ny - 1; j++)
+			for (uint32_t k = 0; k < nx - 1; k++) {
+				int i = (j * nx) + k;
+
+				*triIdx++ = i;
+				*triIdx++ = i + 1;
+				*triIdx++ = i + nx;
+				*triIdx++ = i + 1;
+				*triIdx++ = i + nx + 1;
+				*triIdx++ = i + nx;
+			}
+
+		triIdx[0] = -1;
+		triIdx[1] = -1;
+		triIdx[2] = -1;
+
+		mapxy->type = MAPXY_SPARSE_FLOAT;
+		mapxy->sparse_float.vertices = vertices;
+		mapxy->sparse_float.uv = uv;
+		mapxy->sparse_float.tri_idx = (const int *)(uv + nVertices * 2);
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the data buffers of a map generated by STM32Ipl_DewarpMapFromCalib().
+ * @param mapxy		Generated map.
+ * @return	void
+ */
+void STM32Ipl_DewarpReleaseCalibMap(mapxy_t *mapxy)
+{
+	if (mapxy) {
+		if (mapxy->type == MAPXY_DENSE_FIXED_POINT_12_4) {
+			xfree((void *)mapxy->dense_fp);
+			mapxy->dense_fp = NULL;
+		} else
+		if (mapxy->type == MAPXY_SPARSE_FLOAT) {
+			xfree((void *)mapxy->sparse_float.vertices);
+			mapxy->sparse_float.vertices = NULL;
+			mapxy->sparse_float.uv = NULL;
+			mapxy->sparse_float.tri_idx = NULL;
+		}
+	}
+}
+
+/* Gets the source location (byte offset and bilinear weights) read by the map entry idx. */
+static uint32_t fused_location(const image_t *isrc, const mapxy_t *mapxy, dewarping_algo_t algo, int bpp, int idx,
+		uint8_t *weight)
+{
+	const mapxy_compiled_t *map;
+	uint32_t o;
+
+	switch (mapxy->type) {
+	case MAPXY_DENSE_FLOAT:
+		return compile_location(isrc->w, isrc->h, bpp, algo,
+								compile_float_to_q4(mapxy->dense_float[coord_to_map_idx(0, idx, 1, 0, 2)], algo),
+								compile_float_to_q4(mapxy->dense_float[coord_to_map_idx(0, idx, 0, 0, 2)], algo),
+								weight);
+	case MAPXY_DENSE_FIXED_POINT_12_4:
+		return compile_location(isrc->w, isrc->h, bpp, algo, mapxy->dense_fp[coord_to_map_idx(0, idx, 1, 0, 2)],
+								mapxy->dense_fp[coord_to_map_idx(0, idx, 0, 0, 2)], weight);
+	default:
+		map = mapxy->compiled;
+		o = map->offset[idx];
+		*weight = map->weight ? map->weight[idx] : 0;
+
+		/* the offsets of a tiled map are relative to the source box of their block */
+		if (map->blockW && o != MAPXY_COMPILED_SKIP) {
+			int nbx = (map->w + map->blockW - 1) / map->blockW;
+			const rectangle_t *box = &map->blockSrc[((idx / map->w) / map->blockH) * nbx + (idx % map->w) / map->blockW];
+
+			o /= bpp;
+			o = (uint32_t)coord_to_map_idx(box->y + o / box->w, box->x + o % box->w, 0, map->w, bpp);
+		}
+
+		return o;
+	}
+}
+
+/* Dewarps, resizes and converts in a single pass: for each destination pixel, the map (at the source resolution) is
+ * sampled at the nearest entry, the source is interpolated at the mapped location (quantized to 1/16 pixel, as for
+ * the compiled maps) and the result is converted to the destination format. */
+static void dewarping_fused(const image_t *isrc, image_t *idst, const mapxy_t *mapxy, dewarping_algo_t algo)
+{
+	int bpp = (isrc->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((isrc->bpp == IMAGE_BPP_RGB565) ? 2 : 3);
+	uint32_t stride = isrc->w * bpp;
+	uint32_t stepX = ((uint32_t)isrc->w << 16) / idst->w;
+	uint32_t stepY = ((uint32_t)isrc->h << 16) / idst->h;
+	uint8_t *dst = idst->data;
+	int x, y;
+
+	for (y = 0; y < idst->h; y++) {
+		int row = ((y * stepY + (stepY >> 1)) >> 16) * isrc->w;
+
+		for (x = 0; x < idst->w; x++) {
+			int idx = row + ((x * stepX + (stepX >> 1)) >> 16);
+			const uint8_t *p0, *p1;
+			uint32_t r, g, b;
+			uint32_t dx, dy, nx;
+			uint8_t weight;
+			uint32_t o;
+
+			o = fused_location(isrc, mapxy, algo, bpp, idx, &weight);
+			if (o == MAPXY_COMPILED_SKIP) {
+				dst += (idst->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((idst->bpp == IMAGE_BPP_RGB565) ? 2 : 3);
+				continue;
+			}
+
+			/* A zero fraction also means that the next pixel may be out of the image. */
+			dx = weight & 0xf;
+			dy = weight >> 4;
+			nx = dx ? bpp : 0;
+			p0 = isrc->data + o;
+			p1 = dy ? p0 + stride : p0;
+
+			switch (isrc->bpp) {
+			case IMAGE_BPP_GRAYSCALE:
+				r = interpolate_q4(p0[0], p0[nx], p1[0], p1[nx], dx, dy);
+				g = r;
+				b = r;
+				break;
+			case IMAGE_BPP_RGB565: {
+				uint32_t v0 = *(const uint16_t *)p0;
+				uint32_t v1 = *(const uint16_t *)(p0 + nx);
+				uint32_t v2 = *(const uint16_t *)p1;
+				uint32_t v3 = *(const uint16_t *)(p1 + nx);
+
+				r = interpolate_q4(COLOR_RGB565_TO_R8(v0), COLOR_RGB565_TO_R8(v1), COLOR_RGB565_TO_R8(v2),
+								   COLOR_RGB565_TO_R8(v3), dx, dy);
+				g = interpolate_q4(COLOR_RGB565_TO_G8(v0), COLOR_RGB565_TO_G8(v1), COLOR_RGB565_TO_G8(v2),
+								   COLOR_RGB565_TO_G8(v3), dx, dy);
+				b = interpolate_q4(COLOR_RGB565_TO_B8(v0), COLOR_RGB565_TO_B8(v1), COLOR_RGB565_TO_B8(v2),
+								   COLOR_RGB565_TO_B8(v3), dx, dy);
+				break;
+			}
+			default:
+				b = interpolate_q4(p0[0], p0[nx], p1[0], p1[nx], dx, dy);
+				g = interpolate_q4(p0[1], p0[nx + 1], p1[1], p1[nx + 1], dx, dy);
+				r = interpolate_q4(p0[2], p0[nx + 2], p1[2], p1[nx + 2], dx, dy);
+				break;
+			}
+
+			switch (idst->bpp) {
+			case IMAGE_BPP_GRAYSCALE:
+				*dst++ = COLOR_RGB888_TO_Y(r, g, b);
+				break;
+			case IMAGE_BPP_RGB565:
+				*(uint16_t *)dst = COLOR_R8_G8_B8_TO_RGB565(r, g, b);
+				dst += 2;
+				break;
+			default:
+				*dst++ = b;
+				*dst++ = g;
+				*dst++ = r;
+				break;
+			}
+		}
+	}
+}
+
 /**
  * @brief Performs dewarping of src image
  * The supported formats are Grayscale, RGB565, RGB888.
@@ -647,7 +1660,12 @@ static dewarp_fct dewarp_fct_implementations[IMAGE_BPP_NB][MAPXY_TYPE_NB][DEWARP
  * @param dst			Destination image (dewarp image)
  * @param mapxy			mapping data to perform the dewarping
  * @param algo			perform either nearest or bilinear dewarping
- * src and dst must have the same resolution and same format.
+ * The mapping data are always defined at the resolution of src. When dst has the same resolution and format of src,
+ * each destination pixel is computed from its own map entry; otherwise, the dewarping, the resize and the color
+ * conversion are done in a single pass: each destination pixel is computed from the nearest map entry (the map is
+ * scaled to the resolution of dst), and the interpolated value is converted to the format of dst (Grayscale,
+ * RGB565, RGB888). Such a fused dewarping supports the dense and the compiled maps (a sparse map can be compiled
+ * with STM32Ipl_DewarpCompileMap()) and quantizes the source locations to 1/16 pixel as the compiled maps do.
  *
  * The general dense algorithm works as follows:
  *   For each destination pixel (x, y), we perform:
@@ -665,7 +1683,14 @@ static dewarp_fct dewarp_fct_implementations[IMAGE_BPP_NB][MAPXY_TYPE_NB][DEWARP
  *     Then, we apply the same algorithm as the dense method to compute the destination pixel value based on the
  *     interpolated source location.
  *
- * @return	stm32ipl_err_Ok on success, error otherwise
+ * The compiled algorithm (mapxy of type MAPXY_COMPILED, see STM32Ipl_DewarpCompileMap()) works as follows:
+ *   For each destination pixel, we read the precomputed source offset and bilinear weights, and compute the
+ *   destination pixel value with integer math only. The compiled map must have been compiled for the size and the
+ *   format of src and for algo. A tiled compiled map (see STM32Ipl_DewarpCompileMapTiled()) is applied block by
+ *   block, reading the source from a copy of each block's source box, allocated with fb_alloc.
+ *
+ * @return	stm32ipl_err_Ok on success, stm32ipl_err_OutOfMemory if the memory for the source box of a tiled compiled
+ * map is not available, error otherwise
  */
 stm32ipl_err_t STM32Ipl_Dewarp(const image_t *src, image_t *dst, const mapxy_t *mapxy, dewarping_algo_t algo)
 {
@@ -675,11 +1700,31 @@ stm32ipl_err_t STM32Ipl_Dewarp(const image_t *src, image_t *dst, const mapxy_t *
 	if (ret)
 		return ret;
 
-	if (dewarp_fct_implementations[src->bpp][mapxy->type][algo])
-		dewarp_fct_implementations[src->bpp][mapxy->type][algo](src, dst, mapxy);
-	else
+	if (src->w != dst->w || src->h != dst->h || src->bpp != dst->bpp) {
+		if ((src->bpp != IMAGE_BPP_GRAYSCALE && src->bpp != IMAGE_BPP_RGB565 && src->bpp != IMAGE_BPP_RGB888) ||
+			(dst->bpp != IMAGE_BPP_GRAYSCALE && dst->bpp != IMAGE_BPP_RGB565 && dst->bpp != IMAGE_BPP_RGB888))
+			return stm32ipl_err_UnsupportedFormat;
+
+		if (mapxy->type == MAPXY_SPARSE_FLOAT)
+			return stm32ipl_err_NotImplemented;
+
+		STM32IPL_TRACE_BEGIN(Dewarp)
+		dewarping_fused(src, dst, mapxy, algo);
+		STM32IPL_TRACE_END(Dewarp)
+
+		return stm32ipl_err_Ok;
+	}
+
+	if (!dewarp_fct_implementations[src->bpp][mapxy->type][algo])
 		return stm32ipl_err_NotImplemented;
 
+	if (mapxy->type == MAPXY_COMPILED && mapxy->compiled->blockW && fb_avail() < mapxy->compiled->blockSize)
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(Dewarp)
+	dewarp_fct_implementations[src->bpp][mapxy->type][algo](src, dst, mapxy);
+	STM32IPL_TRACE_END(Dewarp)
+
 	return ret;
 }
 
@@ -0,0 +1,415 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_displacement.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - displacement estimation module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_DISP_MIN_W		32		/* Minimum width of the window (arm_rfft_fast_f32()). */
+#define IPL_DISP_MIN_H		16		/* Minimum height of the window (arm_cfft_f32()). */
+#define IPL_DISP_MAX_SIZE	4096	/* Maximum size of the window (both FFTs). */
+#define IPL_DISP_EPSILON	1e-3f	/* Minimum magnitude of the cross-power coefficients that are kept. */
+
+/* Radius of the largest log-polar circle, that stays inside the window. */
+#define IPL_DISP_RMAX(disp)	((float)((IM_MIN((disp)->w, (disp)->h) / 2) - 1))
+
+/* Radius of the smallest log-polar circle: the one sampled with about one pixel per row (angle), as the smaller
+ * ones only repeat the few pixels around the center, that do not move with the rotation of the frame. */
+#define IPL_DISP_RMIN(disp)	IM_MIN((disp)->h / (2.0f * (float)M_PI), IPL_DISP_RMAX(disp) / 4.0f)
+
+/* Number of floats of a spectrum: W/2 + 1 columns of H complex coefficients. */
+#define IPL_DISP_SPECTRUM_LEN(disp)	((((disp)->w / 2) + 1) * (disp)->h * 2)
+
+/* Samples row wy of the window from the ROI of the image: each window pixel gets the mean luminance of the
+ * ROI pixels it covers (the nearest one when the ROI is smaller than the window). */
+static void ipl_disp_sample_row(const stm32ipl_displacement_t *disp, const image_t *img, const rectangle_t *roi,
+		uint32_t wy, float *dst)
+{
+	uint32_t y0 = roi->y + ((wy * roi->h) / disp->h);
+	uint32_t y1 = IM_MAX(roi->y + (((wy + 1) * roi->h) / disp->h), y0 + 1);
+
+	for (uint32_t wx = 0; wx < disp->w; wx++) {
+		uint32_t x0 = roi->x + ((wx * roi->w) / disp->w);
+		uint32_t x1 = IM_MAX(roi->x + (((wx + 1) * roi->w) / disp->w), x0 + 1);
+		uint32_t sum = 0;
+
+		for (uint32_t y = y0; y < y1; y++)
+			for (uint32_t x = x0; x < x1; x++)
+				sum += IM_TO_GS_PIXEL(img, x, y);
+
+		dst[wx] = (float)sum / ((x1 - x0) * (y1 - y0));
+	}
+}
+
+/* Samples row v (angle) of the log-polar transform of the cartesian window, centered in the window: column u
+ * is at radius rho[u], that grows exponentially from IPL_DISP_RMIN() to IPL_DISP_RMAX(). */
+static void ipl_disp_log_polar_row(const stm32ipl_displacement_t *disp, const float *cart, uint32_t v, float *dst)
+{
+	float theta = (2.0f * (float)M_PI * v) / disp->h;
+	float cosT = arm_cos_f32(theta);
+	float sinT = arm_sin_f32(theta);
+	float cx = disp->w / 2;
+	float cy = disp->h / 2;
+
+	for (uint32_t u = 0; u < disp->w; u++) {
+		float fx = cx + (disp->rho[u] * cosT);
+		float fy = cy + (disp->rho[u] * sinT);
+		uint32_t x0 = IM_MIN((uint32_t)fx, disp->w - 2u);
+		uint32_t y0 = IM_MIN((uint32_t)fy, disp->h - 2u);
+		float ax = fx - x0;
+		float ay = fy - y0;
+		const float *p = cart + (y0 * disp->w) + x0;
+		float top = p[0] + (ax * (p[1] - p[0]));
+		float bottom = p[disp->w] + (ax * (p[disp->w + 1] - p[disp->w]));
+
+		dst[u] = top + (ay * (bottom - top));
+	}
+}
+
+/* Computes the spectrum of the window sampled from the ROI of the image: the windowed rows are transformed by
+ * the real FFT, their W/2 + 1 coefficients are stored by columns, and each column is then transformed in place
+ * by the complex FFT. row and out hold W floats, cart (log-polar mode only) W * H floats. */
+static void ipl_disp_spectrum(stm32ipl_displacement_t *disp, const image_t *img, const rectangle_t *roi,
+		float *spectrum, float *row, float *out, float *cart)
+{
+	uint32_t halfW = disp->w / 2;
+
+	if (disp->logPolar)
+		for (uint32_t y = 0; y < disp->h; y++)
+			ipl_disp_sample_row(disp, img, roi, y, cart + (y * disp->w));
+
+	for (uint32_t y = 0; y < disp->h; y++) {
+		float winY = disp->logPolar ? 1.0f : disp->winY[y];
+
+		if (disp->logPolar)
+			ipl_disp_log_polar_row(disp, cart, y, row);
+		else
+			ipl_disp_sample_row(disp, img, roi, y, row);
+
+		for (uint32_t x = 0; x < disp->w; x++)
+			row[x] *= disp->winX[x] * winY;
+
+		arm_rfft_fast_f32(&disp->rowFft, row, out, 0);
+
+		/* The real coefficients at DC and at the Nyquist frequency are packed in the first two floats. */
+		spectrum[y * 2] = out[0];
+		spectrum[(y * 2) + 1] = 0.0f;
+		spectrum[((halfW * disp->h) + y) * 2] = out[1];
+		spectrum[(((halfW * disp->h) + y) * 2) + 1] = 0.0f;
+
+		for (uint32_t k = 1; k < halfW; k++) {
+			float *c = spectrum + (((k * disp->h) + y) * 2);
+
+			c[0] = out[k * 2];
+			c[1] = out[(k * 2) + 1];
+		}
+	}
+
+	for (uint32_t k = 0; k <= halfW; k++)
+		arm_cfft_f32(&disp->colFft, spectrum + (k * disp->h * 2), 0, 1);
+}
+
+/* Gets row y of the correlation surface from the cross-power spectrum whose columns are already inverted:
+ * the row is packed back in the format of arm_rfft_fast_f32() and inverted. packed and dst hold W floats. */
+static void ipl_disp_surface_row(stm32ipl_displacement_t *disp, const float *cross, uint32_t y, float *packed,
+		float *dst)
+{
+	uint32_t halfW = disp->w / 2;
+
+	packed[0] = cross[y * 2];
+	packed[1] = cross[((halfW * disp->h) + y) * 2];
+
+	for (uint32_t k = 1; k < halfW; k++) {
+		const float *c = cross + (((k * disp->h) + y) * 2);
+
+		packed[k * 2] = c[0];
+		packed[(k * 2) + 1] = c[1];
+	}
+
+	arm_rfft_fast_f32(&disp->rowFft, packed, dst, 1);
+}
+
+/* Converts the offset (window pixels, wrapped to [-size/2, size/2)) of the correlation peak to the results:
+ * the translation (ROI pixels), or the scale and the rotation (radians) in log-polar mode. */
+static void ipl_disp_result(const stm32ipl_displacement_t *disp, const rectangle_t *roi, float offX, float offY,
+		float *dx, float *dy)
+{
+	if (disp->logPolar) {
+		/* The radii of adjacent columns have a constant ratio. */
+		*dx = expf(offX * logf(disp->rho[1] / disp->rho[0]));
+		*dy = (offY * 2.0f * (float)M_PI) / disp->h;
+	} else {
+		*dx = (offX * roi->w) / disp->w;
+		*dy = (offY * roi->h) / disp->h;
+	}
+}
+///@endcond
+
+/**
+ * @brief Initializes the state of the phase correlation used by STM32Ipl_FindDisplacement(): the region of
+ * interest of the frames is sampled on a correlation window of the given size, whose FFTs are computed by
+ * CMSIS-DSP (arm_rfft_fast_f32() on the rows, arm_cfft_f32() on the columns).
+ * The state is allocated from the heap and must be released with STM32Ipl_DisplacementRelease().
+ * @param disp		State of the phase correlation; if it is not valid, an error is returned.
+ * @param w			Width of the correlation window; it must be a power of two in the range [32, 4096],
+ * otherwise an error is returned.
+ * @param h			Height of the correlation window; it must be a power of two in the range [16, 4096],
+ * otherwise an error is returned.
+ * @param logPolar	If false, the translation between the frames is estimated; if true, the rotation and
+ * the scale around the center of the region of interest are estimated, through the log-polar transform of
+ * the window.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DisplacementInit(stm32ipl_displacement_t *disp, uint16_t w, uint16_t h, bool logPolar)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(disp)
+
+	if ((w < IPL_DISP_MIN_W) || (h < IPL_DISP_MIN_H) || (w > IPL_DISP_MAX_SIZE) || (h > IPL_DISP_MAX_SIZE)
+			|| (w & (w - 1)) || (h & (h - 1)))
+		return stm32ipl_err_InvalidParameter;
+
+	memset(disp, 0, sizeof(stm32ipl_displacement_t));
+
+	if ((arm_rfft_fast_init_f32(&disp->rowFft, w) != ARM_MATH_SUCCESS)
+			|| (arm_cfft_init_f32(&disp->colFft, h) != ARM_MATH_SUCCESS))
+		return stm32ipl_err_InvalidParameter;
+
+	disp->w = w;
+	disp->h = h;
+	disp->logPolar = logPolar;
+
+	disp->spectrum = xalloc(IPL_DISP_SPECTRUM_LEN(disp) * sizeof(float));
+	disp->winX = xalloc(w * sizeof(float));
+	if (logPolar)
+		disp->rho = xalloc(w * sizeof(float));
+	else
+		disp->winY = xalloc(h * sizeof(float));
+
+	if (!disp->spectrum || !disp->winX || (logPolar ? !disp->rho : !disp->winY)) {
+		STM32Ipl_DisplacementRelease(disp);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	/* Periodic Hann windows, that remove the discontinuities at the borders of the window. In log-polar mode
+	 * the rows are periodic (the angle wraps around), so only the radius is windowed. */
+	for (uint32_t x = 0; x < w; x++)
+		disp->winX[x] = 0.5f - (0.5f * arm_cos_f32((2.0f * (float)M_PI * x) / w));
+
+	if (logPolar) {
+		float rMin = IPL_DISP_RMIN(disp);
+		float logStep = logf(IPL_DISP_RMAX(disp) / rMin) / w;
+
+		for (uint32_t u = 0; u < w; u++)
+			disp->rho[u] = rMin * expf(u * logStep);
+	} else {
+		for (uint32_t y = 0; y < h; y++)
+			disp->winY[y] = 0.5f - (0.5f * arm_cos_f32((2.0f * (float)M_PI * y) / h));
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Estimates the displacement of a frame with respect to the previous one by phase correlation: the
+ * normalized cross-power spectrum of the two windows is inverted and its peak (refined by the centroid of its
+ * 3x3 neighborhood) gives the offset. The spectrum of img is cached in the state, so that the next call can
+ * pass a null prev and only one spectrum is computed per frame.
+ * In cartesian mode, dx and dy return the translation; in log-polar mode (see STM32Ipl_DisplacementInit()),
+ * dx returns the scale and dy the rotation (radians, from the x axis towards the y axis); in this mode the region
+ * of interest should have the aspect ratio of the window. The first call without prev and without a cached
+ * spectrum only caches the spectrum of img and returns no displacement with zero response.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param disp		State created with STM32Ipl_DisplacementInit(); if it is not valid, an error is returned.
+ * @param img		Current frame; if it is not valid, an error is returned.
+ * @param prev		Optional previous frame; it must have the size of img, otherwise an error is returned;
+ * when null, the spectrum cached by the last call is used.
+ * @param roi		Optional region of interest of the frames; when defined, it must be contained in the
+ * image and have positive dimensions, otherwise an error is returned; when not defined, the whole image is
+ * considered. It is sampled on the correlation window, averaging the pixels when it is larger than the window.
+ * @param dx		Returns the horizontal translation (pixels), or the scale in log-polar mode.
+ * @param dy		Returns the vertical translation (pixels), or the rotation in log-polar mode.
+ * @param response	Returns the strength of the correlation peak, in the range [0, 1]: values near 0 mean
+ * that the displacement is not reliable.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindDisplacement(stm32ipl_displacement_t *disp, const image_t *img, const image_t *prev,
+		const rectangle_t *roi, float *dx, float *dy, float *response)
+{
+	rectangle_t realRoi;
+	uint32_t specLen;
+	uint32_t nAlloc = 0;
+	float *cross;
+	float *row;
+	float *out;
+	float *cart = NULL;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(disp)
+	STM32IPL_CHECK_VALID_PTR_ARG(disp->spectrum)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, stm32ipl_if_grayscale | STM32IPL_IF_RGB_ONLY)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_CHECK_VALID_PTR_ARG(dx)
+	STM32IPL_CHECK_VALID_PTR_ARG(dy)
+	STM32IPL_CHECK_VALID_PTR_ARG(response)
+
+	if (prev) {
+		STM32IPL_CHECK_VALID_IMAGE(prev)
+		STM32IPL_CHECK_FORMAT(prev, stm32ipl_if_grayscale | STM32IPL_IF_RGB_ONLY)
+		STM32IPL_CHECK_SAME_SIZE(img, prev)
+	}
+
+	specLen = IPL_DISP_SPECTRUM_LEN(disp);
+
+	cross = fb_alloc(specLen * sizeof(float), FB_ALLOC_PREFER_SPEED);
+	nAlloc += (cross != NULL);
+	row = fb_alloc(disp->w * sizeof(float), FB_ALLOC_PREFER_SPEED);
+	nAlloc += (row != NULL);
+	/* Three rows of the correlation surface, around the peak. */
+	out = fb_alloc(3 * disp->w * sizeof(float), FB_ALLOC_PREFER_SPEED);
+	nAlloc += (out != NULL);
+	if (disp->logPolar) {
+		cart = fb_alloc(disp->w * disp->h * sizeof(float), FB_ALLOC_PREFER_SPEED);
+		nAlloc += (cart != NULL);
+	}
+
+	if (!cross || !row || !out || (disp->logPolar && !cart)) {
+		while (nAlloc--)
+			fb_free();
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(FindDisplacement)
+
+	if (prev) {
+		ipl_disp_spectrum(disp, prev, &realRoi, disp->spectrum, row, out, cart);
+		disp->hasPrev = true;
+	}
+
+	if (!disp->hasPrev) {
+		ipl_disp_spectrum(disp, img, &realRoi, disp->spectrum, row, out, cart);
+		disp->hasPrev = true;
+		ipl_disp_result(disp, &realRoi, 0.0f, 0.0f, dx, dy);
+		*response = 0.0f;
+	} else {
+		float best = -1.0f;
+		float sum = 0.0f;
+		float sumX = 0.0f;
+		float sumY = 0.0f;
+		uint32_t px = 0;
+		uint32_t py = 0;
+		float offX;
+		float offY;
+
+		ipl_disp_spectrum(disp, img, &realRoi, cross, row, out, cart);
+
+		/* Caches the spectrum of img while replacing it with the normalized cross-power spectrum. */
+		for (uint32_t i = 0; i < specLen; i += 2) {
+			float *a = cross + i;
+			float *b = disp->spectrum + i;
+			float re = (a[0] * b[0]) + (a[1] * b[1]);
+			float im = (a[1] * b[0]) - (a[0] * b[1]);
+			float mag = fast_sqrtf((re * re) + (im * im));
+
+			b[0] = a[0];
+			b[1] = a[1];
+
+			if (mag > IPL_DISP_EPSILON) {
+				a[0] = re / mag;
+				a[1] = im / mag;
+			} else {
+				a[0] = 0.0f;
+				a[1] = 0.0f;
+			}
+		}
+
+		for (uint32_t k = 0; k <= (uint32_t)(disp->w / 2); k++)
+			arm_cfft_f32(&disp->colFft, cross + (k * disp->h * 2), 1, 1);
+
+		for (uint32_t y = 0; y < disp->h; y++) {
+			ipl_disp_surface_row(disp, cross, y, row, out);
+
+			for (uint32_t x = 0; x < disp->w; x++) {
+				if (out[x] > best) {
+					best = out[x];
+					px = x;
+					py = y;
+				}
+			}
+		}
+
+		/* Centroid of the positive part of the 3x3 neighborhood of the peak (the surface is periodic). */
+		for (int32_t j = -1; j <= 1; j++) {
+			float *surface = out + ((j + 1) * disp->w);
+
+			ipl_disp_surface_row(disp, cross, (py + disp->h + j) % disp->h, row, surface);
+
+			for (int32_t i = -1; i <= 1; i++) {
+				float v = IM_MAX(surface[(px + disp->w + i) % disp->w], 0.0f);
+
+				sum += v;
+				sumX += i * v;
+				sumY += j * v;
+			}
+		}
+
+		offX = px + ((sum > 0.0f) ? (sumX / sum) : 0.0f);
+		offY = py + ((sum > 0.0f) ? (sumY / sum) : 0.0f);
+		if (offX >= (disp->w / 2))
+			offX -= disp->w;
+		if (offY >= (disp->h / 2))
+			offY -= disp->h;
+
+		ipl_disp_result(disp, &realRoi, offX, offY, dx, dy);
+		*response = IM_MIN(sum, 1.0f);
+	}
+
+	STM32IPL_TRACE_END(FindDisplacement)
+
+	while (nAlloc--)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the buffers of a state created with STM32Ipl_DisplacementInit().
+ * @param disp	State of the phase correlation.
+ * @return		void.
+ */
+void STM32Ipl_DisplacementRelease(stm32ipl_displacement_t *disp)
+{
+	if (!disp)
+		return;
+
+	xfree(disp->spectrum);
+	xfree(disp->winX);
+	xfree(disp->winY);
+	xfree(disp->rho);
+
+	memset(disp, 0, sizeof(stm32ipl_displacement_t));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,545 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_dma2d.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - hardware (DMA2D) offload module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+#ifdef USE_STM32H747I_DISCO
+#include "stm32h7xx_hal.h"
+#include "stm32h7xx_hal_dma2d.h"
+#endif /* USE_STM32H747I_DISCO */
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+///@cond
+#define IPL_HW_MAX_PIXELS	0x3FFFU		/* Maximum number of pixels per line and maximum line offset. */
+#define IPL_HW_MAX_LINES	0xFFFFU		/* Maximum number of lines. */
+#define IPL_HW_TIMEOUT		1000U		/* Timeout of a transfer (ms). */
+#define IPL_HW_CACHE_LINE	32U			/* Size of the data cache lines (bytes). */
+
+/* Block of pixels read or written by the DMA2D. */
+typedef struct _ipl_hw_block_t
+{
+	uint8_t *addr;		/* Address of the first pixel. */
+	uint32_t w;			/* Number of pixels per line. */
+	uint32_t h;			/* Number of lines. */
+	uint32_t offset;	/* Number of pixels between the end of a line and the beginning of the next one. */
+	uint32_t size;		/* Number of bytes between the first and the last pixel, included. */
+	uint32_t inMode;	/* DMA2D input color mode. */
+	uint32_t outMode;	/* DMA2D output color mode. */
+} ipl_hw_block_t;
+
+typedef enum _ipl_hw_cache_op_t
+{
+	ipl_hw_cache_clean,
+	ipl_hw_cache_clean_invalidate,
+	ipl_hw_cache_invalidate
+} ipl_hw_cache_op_t;
+
+static DMA2D_HandleTypeDef ipl_hw_dma2d;
+static ipl_hw_block_t ipl_hw_pending;	/* Destination of the transfer in progress; its address is NULL when none. */
+ALIGN_32BYTES(static uint32_t ipl_hw_clut[256]);	/* Gray levels, used to expand the L8 pixels. */
+static bool ipl_hw_clutReady;
+
+/* Executes the given maintenance operation on the data cache lines that contain the given bytes. */
+static void ipl_hw_cache(ipl_hw_cache_op_t op, const uint8_t *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	uint32_t start = (uint32_t)addr & ~(IPL_HW_CACHE_LINE - 1);
+	int32_t len = (int32_t)((((uint32_t)addr + size + IPL_HW_CACHE_LINE - 1) & ~(IPL_HW_CACHE_LINE - 1)) - start);
+
+	if (!(SCB->CCR & SCB_CCR_DC_Msk) || !size)
+		return;
+
+	switch (op) {
+		case ipl_hw_cache_clean:
+			SCB_CleanDCache_by_Addr((uint32_t*)start, len);
+			break;
+
+		case ipl_hw_cache_clean_invalidate:
+			SCB_CleanInvalidateDCache_by_Addr((uint32_t*)start, len);
+			break;
+
+		default:
+			SCB_InvalidateDCache_by_Addr((uint32_t*)start, len);
+			break;
+	}
+#else
+	STM32IPL_UNUSED(op);
+	STM32IPL_UNUSED(addr);
+	STM32IPL_UNUSED(size);
+#endif /* __DCACHE_PRESENT */
+}
+
+/* Returns the DMA2D input and output color modes of the pixels of the given size (bytes). */
+static void ipl_hw_modes(uint32_t pixelSize, uint32_t *inMode, uint32_t *outMode)
+{
+	switch (pixelSize) {
+		case 1:
+			*inMode = DMA2D_INPUT_L8;
+			*outMode = 0xFFFFFFFF;	/* Not supported. */
+			break;
+
+		case 2:
+			*inMode = DMA2D_INPUT_RGB565;
+			*outMode = DMA2D_OUTPUT_RGB565;
+			break;
+
+		case 3:
+			*inMode = DMA2D_INPUT_RGB888;
+			*outMode = DMA2D_OUTPUT_RGB888;
+			break;
+
+		default:
+			*inMode = DMA2D_INPUT_ARGB8888;
+			*outMode = DMA2D_OUTPUT_ARGB8888;
+			break;
+	}
+}
+
+/* Size (bytes) of the pixels used to move the raw data of the given image: the Grayscale lines are moved as
+ * RGB565 pixels (two bytes at a time) and the Binary ones as ARGB8888 pixels (one word at a time). */
+static uint32_t ipl_hw_raw_size(const image_t *img)
+{
+	switch (img->bpp) {
+		case IMAGE_BPP_BINARY:
+			return 4;
+
+		case IMAGE_BPP_GRAYSCALE:
+		case IMAGE_BPP_RGB565:
+			return 2;
+
+		default:
+			return 3;
+	}
+}
+
+/*
+ * Describes the given region of the image (the whole image when roi is NULL) as a block of pixels of the
+ * given size (bytes). The Binary images can be described only as a whole.
+ * Returns false when the DMA2D cannot access the region (alignment, size or line offset).
+ */
+static bool ipl_hw_block(const image_t *img, const rectangle_t *roi, uint32_t pixelSize, ipl_hw_block_t *block)
+{
+	uint32_t stride = STM32Ipl_ImageStride(img);
+	uint32_t bpp;
+	uint32_t lineSize;
+	uint32_t x = 0;
+	uint32_t y = 0;
+	uint32_t h = img->h;
+
+	if (img->bpp == IMAGE_BPP_BINARY) {
+		if (roi)
+			return false;
+		lineSize = STM32Ipl_DataSize(img->w, 1, IMAGE_BPP_BINARY);
+		bpp = 0;
+	} else {
+		bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)img->bpp);
+		lineSize = img->w * bpp;
+		if (roi) {
+			x = roi->x;
+			y = roi->y;
+			h = roi->h;
+			lineSize = roi->w * bpp;
+		}
+	}
+
+	block->addr = img->data + (y * stride) + (x * bpp);
+
+	/* The pixels must be aligned to their size, the RGB888 ones to the byte. */
+	if ((lineSize % pixelSize) || (stride % pixelSize) || ((pixelSize != 3) && ((uint32_t)block->addr % pixelSize)))
+		return false;
+
+	block->w = lineSize / pixelSize;
+	block->h = h;
+	block->offset = (stride / pixelSize) - block->w;
+	block->size = ((h - 1) * stride) + lineSize;
+	ipl_hw_modes(pixelSize, &block->inMode, &block->outMode);
+
+	return (block->w > 0) && (block->w <= IPL_HW_MAX_PIXELS) && (block->offset <= IPL_HW_MAX_PIXELS)
+			&& (block->h > 0) && (block->h <= IPL_HW_MAX_LINES);
+}
+
+/* Returns true if the two blocks share some bytes. */
+static bool ipl_hw_overlap(const ipl_hw_block_t *b0, const ipl_hw_block_t *b1)
+{
+	return (b0->addr < (b1->addr + b1->size)) && (b1->addr < (b0->addr + b0->size));
+}
+
+/* Configures one of the DMA2D input layers. */
+static bool ipl_hw_layer(const ipl_hw_block_t *block, uint32_t layer, uint32_t alphaMode, uint32_t alpha)
+{
+	DMA2D_LayerCfgTypeDef *cfg = &ipl_hw_dma2d.LayerCfg[layer];
+
+	cfg->InputOffset = block->offset;
+	cfg->InputColorMode = block->inMode;
+	cfg->AlphaMode = alphaMode;
+	cfg->InputAlpha = alpha;
+	cfg->AlphaInverted = DMA2D_REGULAR_ALPHA;
+	cfg->RedBlueSwap = DMA2D_RB_REGULAR;
+	cfg->ChromaSubSampling = DMA2D_NO_CSS;
+
+	if (HAL_DMA2D_ConfigLayer(&ipl_hw_dma2d, layer) != HAL_OK)
+		return false;
+
+	if (block->inMode == DMA2D_INPUT_L8) {
+		DMA2D_CLUTCfgTypeDef clutCfg;
+
+		if (!ipl_hw_clutReady) {
+			for (uint32_t i = 0; i < 256; i++)
+				ipl_hw_clut[i] = 0xFF000000 | (i << 16) | (i << 8) | i;
+			ipl_hw_cache(ipl_hw_cache_clean, (const uint8_t*)ipl_hw_clut, sizeof(ipl_hw_clut));
+			ipl_hw_clutReady = true;
+		}
+
+		clutCfg.pCLUT = ipl_hw_clut;
+		clutCfg.CLUTColorMode = DMA2D_CCM_ARGB8888;
+		clutCfg.Size = 255;
+
+		if ((HAL_DMA2D_CLUTStartLoad(&ipl_hw_dma2d, &clutCfg, layer) != HAL_OK)
+				|| (HAL_DMA2D_PollForTransfer(&ipl_hw_dma2d, IPL_HW_TIMEOUT) != HAL_OK))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Starts a DMA2D transfer, after the end of the previous one, and waits for its end when wait is true.
+ * mode	DMA2D mode: DMA2D_R2M, DMA2D_M2M, DMA2D_M2M_PFC or DMA2D_M2M_BLEND.
+ * fg	Foreground block (source); not used by DMA2D_R2M.
+ * bg	Background block; used only by DMA2D_M2M_BLEND.
+ * out	Output block (destination).
+ * arg	Color (ARGB8888) with DMA2D_R2M, alpha of the foreground with DMA2D_M2M_BLEND.
+ * wait	If true, the function returns at the end of the transfer.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t ipl_hw_run(uint32_t mode, const ipl_hw_block_t *fg, const ipl_hw_block_t *bg,
+		const ipl_hw_block_t *out, uint32_t arg, bool wait)
+{
+	HAL_StatusTypeDef status;
+	uint32_t alphaMode = (mode == DMA2D_M2M_BLEND) ? DMA2D_REPLACE_ALPHA : DMA2D_NO_MODIF_ALPHA;
+
+	STM32Ipl_HwWait();
+#ifdef STM32IPL_ENABLE_HW_SCREEN_DRAWING
+	STM32Ipl_DrawScreenWait();
+#endif /* STM32IPL_ENABLE_HW_SCREEN_DRAWING */
+
+	if (fg)
+		ipl_hw_cache(ipl_hw_cache_clean, fg->addr, fg->size);
+	if (bg)
+		ipl_hw_cache(ipl_hw_cache_clean, bg->addr, bg->size);
+	ipl_hw_cache(ipl_hw_cache_clean_invalidate, out->addr, out->size);
+
+	ipl_hw_dma2d.Instance = DMA2D;
+	ipl_hw_dma2d.Init.Mode = mode;
+	ipl_hw_dma2d.Init.ColorMode = out->outMode;
+	ipl_hw_dma2d.Init.OutputOffset = out->offset;
+	ipl_hw_dma2d.Init.AlphaInverted = DMA2D_REGULAR_ALPHA;
+	ipl_hw_dma2d.Init.RedBlueSwap = DMA2D_RB_REGULAR;
+	ipl_hw_dma2d.Init.BytesSwap = DMA2D_BYTES_REGULAR;
+	ipl_hw_dma2d.Init.LineOffsetMode = DMA2D_LOM_PIXELS;
+	ipl_hw_dma2d.XferCpltCallback = NULL;
+	ipl_hw_dma2d.XferErrorCallback = NULL;
+
+	HAL_DMA2D_DeInit(&ipl_hw_dma2d);
+	if (HAL_DMA2D_Init(&ipl_hw_dma2d) != HAL_OK)
+		return stm32ipl_err_Generic;
+
+	if (fg && !ipl_hw_layer(fg, DMA2D_FOREGROUND_LAYER, alphaMode, (mode == DMA2D_M2M_BLEND) ? arg : 0xFF))
+		return stm32ipl_err_Generic;
+
+	if (bg && !ipl_hw_layer(bg, DMA2D_BACKGROUND_LAYER, DMA2D_NO_MODIF_ALPHA, 0xFF))
+		return stm32ipl_err_Generic;
+
+	if (mode == DMA2D_M2M_BLEND)
+		status = HAL_DMA2D_BlendingStart(&ipl_hw_dma2d, (uint32_t)fg->addr, (uint32_t)bg->addr, (uint32_t)out->addr,
+				out->w, out->h);
+	else
+		status = HAL_DMA2D_Start(&ipl_hw_dma2d, (mode == DMA2D_R2M) ? arg : (uint32_t)fg->addr, (uint32_t)out->addr,
+				out->w, out->h);
+
+	if (status != HAL_OK)
+		return stm32ipl_err_Generic;
+
+	ipl_hw_pending = *out;
+
+	return wait ? STM32Ipl_HwWait() : stm32ipl_err_Ok;
+}
+
+/*
+ * Converts the source image to the format of the destination one with the DMA2D (pixel format converter).
+ * The supported conversions are Grayscale to RGB565/RGB888, RGB565 to RGB888 and RGB888 to RGB565; with the
+ * same format, the pixels are copied. The two images must have the same resolution and must not overlap.
+ * return	stm32ipl_err_Ok when the conversion is done (or started, when wait is false),
+ * stm32ipl_err_NotImplemented when the DMA2D cannot execute it, error otherwise.
+ */
+stm32ipl_err_t ipl_hw_convert(const image_t *src, image_t *dst, bool wait)
+{
+	ipl_hw_block_t in;
+	ipl_hw_block_t out;
+
+	if (src->bpp == dst->bpp)
+		return ipl_hw_copy(src, NULL, dst, wait);
+
+	if (!STM32Ipl_ImageFormatSupported(src, stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888)
+			|| !STM32Ipl_ImageFormatSupported(dst, stm32ipl_if_rgb565 | stm32ipl_if_rgb888)
+			|| !ipl_hw_block(src, NULL, STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp), &in)
+			|| !ipl_hw_block(dst, NULL, STM32Ipl_DataSize(1, 1, (image_bpp_t)dst->bpp), &out)
+			|| ipl_hw_overlap(&in, &out))
+		return stm32ipl_err_NotImplemented;
+
+	return ipl_hw_run(DMA2D_M2M_PFC, &in, NULL, &out, 0, wait);
+}
+
+/*
+ * Fills the given region of the image (the whole image when roi is NULL) with the given value, already adapted
+ * to the image format (see STM32Ipl_AdaptColor()). The supported formats are Grayscale, RGB565, RGB888; the
+ * Binary images can be filled only as a whole with zero, when their lines have no padding bits.
+ * return	stm32ipl_err_Ok when the fill is done (or started, when wait is false),
+ * stm32ipl_err_NotImplemented when the DMA2D cannot execute it, error otherwise.
+ */
+stm32ipl_err_t ipl_hw_fill(image_t *img, const rectangle_t *roi, uint32_t value, bool wait)
+{
+	ipl_hw_block_t out;
+	uint32_t color;
+
+	if (!STM32Ipl_ImageFormatSupported(img, STM32IPL_IF_ALL)
+			|| ((img->bpp == IMAGE_BPP_BINARY) && (value || (img->w % 32))))
+		return stm32ipl_err_NotImplemented;
+
+	/* The zero value can be written one word at a time, when the alignment allows it. */
+	if (value || !ipl_hw_block(img, roi, 4, &out))
+		if (!ipl_hw_block(img, roi, ipl_hw_raw_size(img), &out))
+			return stm32ipl_err_NotImplemented;
+
+	/* The HAL converts the ARGB8888 color to the output color mode. */
+	switch (out.outMode) {
+		case DMA2D_OUTPUT_RGB565:
+			if (img->bpp == IMAGE_BPP_GRAYSCALE)
+				value = (value << 8) | value;
+			color = (((value >> 11) & 0x1F) << 19) | (((value >> 5) & 0x3F) << 10) | ((value & 0x1F) << 3);
+			break;
+
+		default:
+			color = value;
+			break;
+	}
+
+	return ipl_hw_run(DMA2D_R2M, NULL, NULL, &out, color, wait);
+}
+
+/*
+ * Copies the given region of the source image (the whole image when roi is NULL) to the destination image,
+ * that has the size of the region and the same format. The supported formats are Grayscale, RGB565, RGB888;
+ * the Binary images can be copied only as a whole. The two images must not overlap.
+ * return	stm32ipl_err_Ok when the copy is done (or started, when wait is false),
+ * stm32ipl_err_NotImplemented when the DMA2D cannot execute it, error otherwise.
+ */
+stm32ipl_err_t ipl_hw_copy(const image_t *src, const rectangle_t *roi, image_t *dst, bool wait)
+{
+	ipl_hw_block_t in;
+	ipl_hw_block_t out;
+	uint32_t pixelSize;
+
+	if (!STM32Ipl_ImageFormatSupported(src, STM32IPL_IF_ALL) || (src->bpp != dst->bpp))
+		return stm32ipl_err_NotImplemented;
+
+	pixelSize = ipl_hw_raw_size(src);
+
+	if (!ipl_hw_block(src, roi, pixelSize, &in) || !ipl_hw_block(dst, NULL, pixelSize, &out)
+			|| (in.w != out.w) || (in.h != out.h) || ipl_hw_overlap(&in, &out))
+		return stm32ipl_err_NotImplemented;
+
+	return ipl_hw_run(DMA2D_M2M, &in, NULL, &out, 0, wait);
+}
+
+/*
+ * Blends the second image over the first one: imgA = (imgB * alpha + imgA * (255 - alpha)) / 255.
+ * The supported formats are RGB565, RGB888. The two images must have the same size and format and must
+ * not overlap.
+ * return	stm32ipl_err_Ok when the blending is done (or started, when wait is false),
+ * stm32ipl_err_NotImplemented when the DMA2D cannot execute it, error otherwise.
+ */
+stm32ipl_err_t ipl_hw_blend(image_t *imgA, const image_t *imgB, uint8_t alpha, bool wait)
+{
+	ipl_hw_block_t fg;
+	ipl_hw_block_t bg;
+	uint32_t pixelSize;
+
+	if (!STM32Ipl_ImageFormatSupported(imgA, stm32ipl_if_rgb565 | stm32ipl_if_rgb888) || (imgA->bpp != imgB->bpp))
+		return stm32ipl_err_NotImplemented;
+
+	pixelSize = STM32Ipl_DataSize(1, 1, (image_bpp_t)imgA->bpp);
+
+	if (!ipl_hw_block(imgB, NULL, pixelSize, &fg) || !ipl_hw_block(imgA, NULL, pixelSize, &bg)
+			|| ipl_hw_overlap(&fg, &bg))
+		return stm32ipl_err_NotImplemented;
+
+	return ipl_hw_run(DMA2D_M2M_BLEND, &fg, &bg, &bg, alpha, wait);
+}
+///@endcond
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+/**
+ * @brief Waits for the end of the operation started by STM32Ipl_ConvertStart(), STM32Ipl_FillStart(),
+ * STM32Ipl_CopyDataStart() or STM32Ipl_BlendStart(); the destination image can be used once this function
+ * returns. When STM32IPL_ENABLE_HW_PIXEL_OPS is not defined, the operations are executed before the start
+ * functions return, so this function does nothing.
+ * @return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_HwWait(void)
+{
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	HAL_StatusTypeDef status;
+
+	if (!ipl_hw_pending.addr)
+		return stm32ipl_err_Ok;
+
+	status = HAL_DMA2D_PollForTransfer(&ipl_hw_dma2d, IPL_HW_TIMEOUT);
+
+	/* The CPU must read the data written by the DMA2D from the memory. */
+	ipl_hw_cache(ipl_hw_cache_invalidate, ipl_hw_pending.addr, ipl_hw_pending.size);
+	ipl_hw_pending.addr = NULL;
+
+	return (status == HAL_OK) ? stm32ipl_err_Ok : stm32ipl_err_Generic;
+#else
+	return stm32ipl_err_Ok;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+}
+
+/**
+ * @brief Starts the conversion of the source image to the format of the destination one, as STM32Ipl_Convert().
+ * When STM32IPL_ENABLE_HW_PIXEL_OPS is defined and the DMA2D can execute the conversion (Grayscale to RGB565 or
+ * RGB888, RGB565 to RGB888, RGB888 to RGB565, or same format), the function returns as soon as the transfer is
+ * started, so that the CPU can do other work meanwhile; STM32Ipl_HwWait() must be called before using the
+ * destination image or starting another operation on it. Otherwise, the conversion is executed by the CPU before
+ * returning. While the transfer is running, the source image must not be modified and the destination one must
+ * not be accessed (including the bytes that share its first and last data cache lines).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param src	Source image; if it is not valid, an error is returned.
+ * @param dst	Destination image; it must have the same resolution of the source one; if it is not valid,
+ * an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ConvertStart(const image_t *src, image_t *dst)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_FORMAT(dst, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if ((src->data != dst->data) && (ipl_hw_convert(src, dst, false) == stm32ipl_err_Ok))
+		return stm32ipl_err_Ok;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	return STM32Ipl_Convert(src, dst);
+}
+
+/**
+ * @brief Starts filling the image (or a region of it) with the given color, as STM32Ipl_Fill().
+ * When STM32IPL_ENABLE_HW_PIXEL_OPS is defined and the DMA2D can execute the fill (Grayscale, RGB565, RGB888),
+ * the function returns as soon as the transfer is started; STM32Ipl_HwWait() must be called before using the
+ * image (see STM32Ipl_ConvertStart()). Otherwise, the fill is executed by the CPU before returning.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img	Image; if it is not valid, an error is returned.
+ * @param roi	Optional region of interest of the image where the functions operates; when defined, it must be
+ * contained in the image and have positive dimensions, otherwise an error is returned; when not defined, the
+ * whole image is considered.
+ * @param color	Color used to fill the image.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FillStart(image_t *img, const rectangle_t *roi, stm32ipl_color_t color)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+
+	if (roi) {
+		STM32IPL_CHECK_VALID_ROI(img, roi)
+	}
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (ipl_hw_fill(img, roi, STM32Ipl_AdaptColor(img, color), false) == stm32ipl_err_Ok)
+		return stm32ipl_err_Ok;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	return STM32Ipl_Fill(img, roi, color);
+}
+
+/**
+ * @brief Starts copying the source image's data buffer into the destination image's data buffer, as
+ * STM32Ipl_CopyData(). When STM32IPL_ENABLE_HW_PIXEL_OPS is defined and the DMA2D can execute the copy, the
+ * function returns as soon as the transfer is started; STM32Ipl_HwWait() must be called before using the
+ * destination image (see STM32Ipl_ConvertStart()). Otherwise, the copy is executed by the CPU before returning.
+ * A region of an image can be copied by passing a view of it (see STM32Ipl_InitView()) as source image.
+ * @param src	Source image; if it is not valid, an error is returned.
+ * @param dst	Destination image; it must have the same size and format of the source one; if it is not valid,
+ * an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_CopyDataStart(const image_t *src, image_t *dst)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+	STM32IPL_CHECK_SAME_FORMAT(src, dst)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (ipl_hw_copy(src, NULL, dst, false) == stm32ipl_err_Ok)
+		return stm32ipl_err_Ok;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	return STM32Ipl_CopyData(src, dst);
+}
+
+/**
+ * @brief Starts blending an image over another one, as STM32Ipl_Blend() without mask. When
+ * STM32IPL_ENABLE_HW_PIXEL_OPS is defined and the DMA2D can execute the blending (RGB565, RGB888), the
+ * function returns as soon as the transfer is started; STM32Ipl_HwWait() must be called before using the
+ * first image (see STM32Ipl_ConvertStart()). Otherwise, the blending is executed by the CPU before returning.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param imgA	First image; it is overwritten with the result of the operation. If it is not valid, an error is returned.
+ * @param imgB	Second image; it must have same format and size as the first image, otherwise an error is returned.
+ * @param alpha	Weight of the second image, from 0 (imgA is not modified) to 255 (imgB is copied to imgA).
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BlendStart(image_t *imgA, const image_t *imgB, uint8_t alpha)
+{
+	STM32IPL_CHECK_VALID_IMAGE(imgA)
+	STM32IPL_CHECK_VALID_IMAGE(imgB)
+	STM32IPL_CHECK_SAME_SIZE(imgA, imgB)
+	STM32IPL_CHECK_SAME_FORMAT(imgA, imgB)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (ipl_hw_blend(imgA, imgB, alpha, false) == stm32ipl_err_Ok)
+		return stm32ipl_err_Ok;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	return STM32Ipl_Blend(imgA, imgB, alpha, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -101,30 +101,74 @@ static uint32_t getInputColorMode(uint32_t format)
 	};
 }
 
-/**
- * @brief Draws an image on the screen at the (x,y) coordinates using hardware acceleration (DMA2D).
- * The supported formats are Binary, Grayscale, RGB565, RGB888.
- * @param img	Image; if it is not valid, an error is returned.
- * @param x		Screen x-coordinate of the top-left corner of the image.
- * @param y		Screen y-coordinate of the top-left corner of the image.
- * @return 		stm32ipl_err_Ok on success, error otherwise.
+///@cond
+#define IPL_SCREEN_TIMEOUT	30U		/* Timeout of a transfer to the screen (ms). */
+
+static DMA2D_HandleTypeDef hlcd_dma2d;
+static const image_t *volatile ipl_screen_img;	/* Image being drawn asynchronously; NULL when none. */
+static stm32ipl_screen_callback_t ipl_screen_callback;
+
+/* Ends the asynchronous drawing in progress: the image can be modified again. */
+static void ipl_screen_done(void)
+{
+	const image_t *img = ipl_screen_img;
+	stm32ipl_screen_callback_t callback = ipl_screen_callback;
+
+	ipl_screen_img = NULL;
+	ipl_screen_callback = NULL;
+
+	if (img && callback)
+		callback(img);
+}
+
+/* DMA2D transfer complete (or error) callback, called by HAL_DMA2D_IRQHandler(). */
+static void ipl_screen_xfer_end(DMA2D_HandleTypeDef *hdma2d)
+{
+	STM32IPL_UNUSED(hdma2d);
+
+	ipl_screen_done();
+}
+
+/*
+ * Draws an image on the screen at the (x,y) coordinates with the DMA2D. When async is true, the function returns as
+ * soon as the transfer is started (the Binary images, that need a temporary conversion, are always drawn
+ * synchronously) and its end is notified by ipl_screen_xfer_end(); otherwise, it returns at the end of the transfer.
+ * In both cases, the optional callback is called at the end of the transfer.
+ * return	stm32ipl_err_Ok when the transfer is done (or started), error otherwise.
  */
-stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_t y)
+static stm32ipl_err_t ipl_screen_draw(const image_t *img, uint16_t x, uint16_t y, stm32ipl_screen_callback_t callback,
+		bool async)
 {
-	static DMA2D_HandleTypeDef hlcd_dma2d;
 	uint32_t inputLineOffset = 0;
 	uint32_t cssMode = DMA2D_NO_CSS;
 	uint32_t saveBytesSwap;
 	uint32_t bytesSwap = DMA2D_BYTES_REGULAR;
+	stm32ipl_err_t res = stm32ipl_err_Generic;
 
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	/* The DMA2D may still be executing an operation started by the library. */
+	STM32Ipl_DrawScreenWait();
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	STM32Ipl_HwWait();
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
 
 	saveBytesSwap = hlcd_dma2d.Init.BytesSwap;
 
 	uint32_t destination = STM32IPL_LCD_FB_ADDR + (y * STM32IPL_LCD_WIDTH + x) * STM32IPL_LCD_BPP;
 	uint32_t source = (uint32_t)img->data;
 
+	/* The lines of a view are not tightly packed, so the gap between them must be skipped. */
+	if (img->bpp != IMAGE_BPP_BINARY)
+		inputLineOffset = (STM32Ipl_ImageStride(img) / STM32Ipl_DataSize(1, 1, (image_bpp_t)img->bpp)) - img->w;
+	else
+		async = false;
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	/* The DMA2D reads the pixels from the memory, so the ones written by the CPU are written back first. */
+	if (async && (SCB->CCR & SCB_CCR_DC_Msk))
+		SCB_CleanDCache_by_Addr((uint32_t*)((uint32_t)img->data & ~31U),
+				(int32_t)(STM32Ipl_ImageDataSize(img) + ((uint32_t)img->data & 31U)));
+#endif /* __DCACHE_PRESENT */
+
 	hlcd_dma2d.Init.Mode = DMA2D_M2M_PFC;
 	hlcd_dma2d.Init.ColorMode = STM32IPL_LCD_PIXELFORMAT;
 	hlcd_dma2d.Init.OutputOffset = STM32IPL_LCD_WIDTH - img->w;
@@ -159,7 +203,7 @@ stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_
 				CLUTCfg.Size = 255;
 
 				HAL_DMA2D_CLUTStartLoad(&hlcd_dma2d, &CLUTCfg, DMA2D_FOREGROUND_LAYER);
-				HAL_DMA2D_PollForTransfer(&hlcd_dma2d, 30);
+				HAL_DMA2D_PollForTransfer(&hlcd_dma2d, IPL_SCREEN_TIMEOUT);
 			}
 
 			if (img->bpp == IMAGE_BPP_BINARY) {
@@ -173,13 +217,32 @@ stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_
 							*ptr++ = (IMAGE_GET_BINARY_PIXEL_FAST(row, j) ? 0xFF : 0);
 						}
 					}
-				} else
+				} else {
+					hlcd_dma2d.Init.BytesSwap = saveBytesSwap;
 					return stm32ipl_err_OutOfMemory;
+				}
 			}
 
-			if (HAL_DMA2D_Start(&hlcd_dma2d, source, destination, img->w, img->h) == HAL_OK) {
+			if (async) {
+				/* The end of the transfer is notified by the DMA2D interrupt (or detected by STM32Ipl_DrawScreenWait()). */
+				hlcd_dma2d.XferCpltCallback = ipl_screen_xfer_end;
+				hlcd_dma2d.XferErrorCallback = ipl_screen_xfer_end;
+				ipl_screen_callback = callback;
+				ipl_screen_img = img;
+
+				if (HAL_DMA2D_Start_IT(&hlcd_dma2d, source, destination, img->w, img->h) == HAL_OK) {
+					res = stm32ipl_err_Ok;
+				} else {
+					ipl_screen_img = NULL;
+					ipl_screen_callback = NULL;
+				}
+			} else if (HAL_DMA2D_Start(&hlcd_dma2d, source, destination, img->w, img->h) == HAL_OK) {
 				/* Polling for DMA transfer. */
-				HAL_DMA2D_PollForTransfer(&hlcd_dma2d, 30);
+				HAL_DMA2D_PollForTransfer(&hlcd_dma2d, IPL_SCREEN_TIMEOUT);
+				res = stm32ipl_err_Ok;
+
+				if (callback)
+					callback(img);
 			}
 
 			if (img->bpp == IMAGE_BPP_BINARY)
@@ -190,9 +253,102 @@ stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_
 	/* Restore previous BytesSwap value. */
 	hlcd_dma2d.Init.BytesSwap = saveBytesSwap;
 
+	return res;
+}
+///@endcond
+
+/**
+ * @brief Draws an image on the screen at the (x,y) coordinates using hardware acceleration (DMA2D).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img	Image; if it is not valid, an error is returned.
+ * @param x		Screen x-coordinate of the top-left corner of the image.
+ * @param y		Screen y-coordinate of the top-left corner of the image.
+ * @return 		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_t y)
+{
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(DrawScreen_DMA2D)
+
+	res = ipl_screen_draw(img, x, y, NULL, false);
+
+	STM32IPL_TRACE_END(DrawScreen_DMA2D)
+	return res;
+}
+
+/**
+ * @brief Starts drawing an image on the screen at the (x,y) coordinates using hardware acceleration (DMA2D), as
+ * STM32Ipl_DrawScreen_DMA2D(), and returns as soon as the transfer is started, so that the CPU can process the next
+ * frame while the current one is displayed. A new drawing (or a DMA2D operation started by the library) waits for
+ * the end of the previous one, so two image buffers can be used alternately: while the front buffer is drawn, the
+ * next frame is processed into the back buffer, which is then passed to this function, and the two are swapped.
+ * While the transfer is running, the image must not be modified; the end of the transfer is notified by the callback
+ * or detected by STM32Ipl_DrawScreenWait().
+ * The supported formats are Binary, Grayscale, RGB565, RGB888; the Binary images are drawn before returning, as they
+ * need a temporary conversion.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param x			Screen x-coordinate of the top-left corner of the image.
+ * @param y			Screen y-coordinate of the top-left corner of the image.
+ * @param callback	Optional function called, with the drawn image, at the end of the transfer; it is called by the
+ * DMA2D interrupt, so STM32Ipl_DrawScreenIRQHandler() must be called by DMA2D_IRQHandler() and the DMA2D interrupt
+ * must be enabled; otherwise, it is called by STM32Ipl_DrawScreenWait().
+ * @return 			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DrawScreenAsync(const image_t *img, uint16_t x, uint16_t y,
+		stm32ipl_screen_callback_t callback)
+{
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(DrawScreenAsync)
+
+	res = ipl_screen_draw(img, x, y, callback, true);
+
+	STM32IPL_TRACE_END(DrawScreenAsync)
+	return res;
+}
+
+/**
+ * @brief Waits for the end of the drawing started by STM32Ipl_DrawScreenAsync(); the image can be modified once this
+ * function returns. When the DMA2D interrupt is not used, the callback of the drawing is called by this function.
+ * @return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DrawScreenWait(void)
+{
+	uint32_t start = HAL_GetTick();
+
+	while (ipl_screen_img) {
+		/* Without the DMA2D interrupt, the end of the transfer is detected here. */
+		if (!NVIC_GetEnableIRQ(DMA2D_IRQn) || (__get_PRIMASK() & 1U)) {
+			HAL_StatusTypeDef status = HAL_DMA2D_PollForTransfer(&hlcd_dma2d, IPL_SCREEN_TIMEOUT);
+
+			ipl_screen_done();
+			return (status == HAL_OK) ? stm32ipl_err_Ok : stm32ipl_err_Generic;
+		}
+
+		if ((HAL_GetTick() - start) > IPL_SCREEN_TIMEOUT) {
+			HAL_DMA2D_Abort(&hlcd_dma2d);
+			ipl_screen_done();
+			return stm32ipl_err_Generic;
+		}
+	}
+
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Handles the DMA2D interrupt for the drawings started by STM32Ipl_DrawScreenAsync(); it must be called by
+ * DMA2D_IRQHandler() to get the end of the transfers notified by the interrupt.
+ */
+void STM32Ipl_DrawScreenIRQHandler(void)
+{
+	HAL_DMA2D_IRQHandler(&hlcd_dma2d);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -214,12 +370,71 @@ stm32ipl_err_t STM32Ipl_DrawScreen_DMA2D(const image_t *img, uint16_t x, uint16_
 	return stm32ipl_err_NotImplemented;
 }
 
+stm32ipl_err_t STM32Ipl_DrawScreenAsync(const image_t *img, uint16_t x, uint16_t y,
+		stm32ipl_screen_callback_t callback)
+{
+	/* Prevent unused argument(s) compilation warning. */
+	STM32IPL_UNUSED(img);
+	STM32IPL_UNUSED(x);
+	STM32IPL_UNUSED(y);
+	STM32IPL_UNUSED(callback);
+
+	/* Void implementation. */
+	return stm32ipl_err_NotImplemented;
+}
+
+stm32ipl_err_t STM32Ipl_DrawScreenWait(void)
+{
+	return stm32ipl_err_Ok;
+}
+
+void STM32Ipl_DrawScreenIRQHandler(void)
+{
+}
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* STM32IPL_ENABLE_HW_SCREEN_DRAWING */
 
+///@cond
+/* Fills the rectangle with corners (x0, y0) and (x1, y1), included, clipped to the image: with the DMA2D when
+ * available, otherwise one line span at a time. */
+static void ipl_draw_fill_box(image_t *img, int x0, int y0, int x1, int y1, uint32_t color)
+{
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	rectangle_t box;
+
+	x0 = IM_MAX(x0, 0);
+	y0 = IM_MAX(y0, 0);
+	x1 = IM_MIN(x1, img->w - 1);
+	y1 = IM_MIN(y1, img->h - 1);
+
+	if ((x0 > x1) || (y0 > y1))
+		return;
+
+	box.x = x0;
+	box.y = y0;
+	box.w = x1 - x0 + 1;
+	box.h = y1 - y0 + 1;
+
+	if (ipl_hw_fill(img, &box, color, true) == stm32ipl_err_Ok)
+		return;
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	imlib_draw_rect_fill(img, x0, y0, x1, y1, color);
+}
+
+/* Returns true if the box with corners (x0, y0) and (x1, y1), enlarged by margin pixels, overlaps the image. */
+static bool ipl_draw_visible(const image_t *img, int x0, int y0, int x1, int y1, int margin)
+{
+	return (IM_MAX(x0, x1) + margin >= 0) && (IM_MIN(x0, x1) - margin < img->w) && (IM_MAX(y0, y1) + margin >= 0)
+			&& (IM_MIN(y0, y1) - margin < img->h);
+}
+
+///@endcond
+
 /**
  * @brief Sets the image pixels to zero.
  * The supported formats (for image and mask) are Binary, Grayscale, RGB565, RGB888.
@@ -241,11 +456,17 @@ stm32ipl_err_t STM32Ipl_Zero(image_t *img, bool invert, const image_t *mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 
+		STM32IPL_TRACE_BEGIN(Zero)
 		imlib_zero(img, (image_t*)mask, invert);
 	} else {
+		STM32IPL_TRACE_BEGIN(Zero)
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+		if (img->stride || (ipl_hw_fill(img, NULL, 0, true) != stm32ipl_err_Ok))
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
 		memset(img->data, 0, STM32Ipl_ImageDataSize(img));
 	}
 
+	STM32IPL_TRACE_END(Zero)
 	return stm32ipl_err_Ok;
 }
 
@@ -270,20 +491,23 @@ stm32ipl_err_t STM32Ipl_Fill(image_t *img, const rectangle_t *roi, stm32ipl_colo
 
 	if (roi) {
 		STM32IPL_CHECK_VALID_ROI(img, roi)
+	}
 
-		for (uint32_t y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
-			for (uint32_t x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
-				imlib_set_pixel(img, x, y, newColor);
-			}
-		}
-	} else {
-		for (uint32_t y = 0, yy = img->h; y < yy; y++) {
-			for (uint32_t x = 0, xx = img->w; x < xx; x++) {
-				imlib_set_pixel(img, x, y, newColor);
-			}
-		}
+	STM32IPL_TRACE_BEGIN(Fill)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (ipl_hw_fill(img, roi, newColor, true) == stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(Fill)
+		return stm32ipl_err_Ok;
 	}
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	if (roi)
+		imlib_draw_rect_fill(img, roi->x, roi->y, roi->x + roi->w - 1, roi->y + roi->h - 1, newColor);
+	else
+		imlib_draw_rect_fill(img, 0, 0, img->w - 1, img->h - 1, newColor);
 
+	STM32IPL_TRACE_END(Fill)
 	return stm32ipl_err_Ok;
 }
 
@@ -325,12 +549,14 @@ stm32ipl_err_t STM32Ipl_DrawCross(image_t *img, uint16_t x, uint16_t y, uint16_t
 
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(DrawCross)
 
 	newColor = STM32Ipl_AdaptColor(img, color);
 
 	imlib_draw_line(img, x - halfSize, y, x + halfSize, y, newColor, thickness);
 	imlib_draw_line(img, x, y - halfSize, x, y + halfSize, newColor, thickness);
 
+	STM32IPL_TRACE_END(DrawCross)
 	return stm32ipl_err_Ok;
 }
 
@@ -352,8 +578,10 @@ stm32ipl_err_t STM32Ipl_DrawLine(image_t *img, const point_t *p0, const point_t
 	if (!p0 || !p1)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(DrawLine)
 	imlib_draw_line(img, p0->x, p0->y, p1->x, p1->y, STM32Ipl_AdaptColor(img, color), thickness);
 
+	STM32IPL_TRACE_END(DrawLine)
 	return stm32ipl_err_Ok;
 }
 
@@ -375,6 +603,7 @@ stm32ipl_err_t STM32Ipl_DrawPolygon(image_t *img, const point_t *point, uint32_t
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_VALID_PTR_ARG(point)
+	STM32IPL_TRACE_BEGIN(DrawPolygon)
 
 	newColor = STM32Ipl_AdaptColor(img, color);
 
@@ -383,6 +612,112 @@ stm32ipl_err_t STM32Ipl_DrawPolygon(image_t *img, const point_t *point, uint32_t
 	for (uint16_t j = 0; j < nPoints - 1; j++)
 		imlib_draw_line(img, point[j].x, point[j].y, point[j + 1].x, point[j + 1].y, newColor, thickness);
 
+	STM32IPL_TRACE_END(DrawPolygon)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Fills a polygon over an image with a color. The polygon is rasterized by lines: the pixels of each line
+ * whose centers are inside the polygon (even-odd rule) are filled as a single span, clipped to the image once.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param point		Vector of points (vertexes of the polygon); the polygon can be concave or self-intersecting.
+ * @param nPoints	Number of points; it must be at least 3.
+ * @param color		Color value with 0xRRGGBB format.
+ * @return 			stm32ipl_err_Ok on success, error otherwise.
+ * @note The lower and the right borders are not filled, so that adjacent polygons do not overlap: the outline can be
+ * drawn with STM32Ipl_DrawPolygon().
+ */
+stm32ipl_err_t STM32Ipl_FillPolygon(image_t *img, const point_t *point, uint32_t nPoints, stm32ipl_color_t color)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(point)
+
+	if (nPoints < 3)
+		return stm32ipl_err_InvalidParameter;
+
+	if (fb_avail() < (nPoints * sizeof(float)))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(FillPolygon)
+	imlib_fill_polygon(img, point, nPoints, STM32Ipl_AdaptColor(img, color));
+
+	STM32IPL_TRACE_END(FillPolygon)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Draws a list of primitives (rectangles, crosses, lines) over an image in a single call, e.g. the annotations
+ * of the detections of a frame. The primitives whose bounding box is outside the image are skipped, the color of
+ * consecutive primitives is converted once, and the rectangles are drawn as line spans clipped to the image once
+ * (the filled ones with the DMA2D when STM32IPL_ENABLE_HW_PIXEL_OPS is defined). The result is the same of drawing
+ * the primitives one by one with STM32Ipl_DrawRectangle(), STM32Ipl_DrawCross() and STM32Ipl_DrawLine().
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param items		Vector of primitives; they are drawn in order.
+ * @param nItems	Number of primitives.
+ * @return 			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DrawList(image_t *img, const stm32ipl_draw_item_t *items, uint32_t nItems)
+{
+	stm32ipl_color_t lastColor = 0;
+	uint32_t newColor;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+
+	if (nItems && !items)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(DrawList)
+
+	newColor = STM32Ipl_AdaptColor(img, lastColor);
+
+	for (uint32_t i = 0; i < nItems; i++) {
+		const stm32ipl_draw_item_t *item = &items[i];
+		int x0 = item->x0;
+		int y0 = item->y0;
+		int x1 = item->x1;
+		int y1 = item->y1;
+		int halfSize;
+
+		if (item->color != lastColor) {
+			lastColor = item->color;
+			newColor = STM32Ipl_AdaptColor(img, lastColor);
+		}
+
+		switch (item->type) {
+			case stm32ipl_draw_rectangle:
+				if (!ipl_draw_visible(img, x0, y0, x1, y1, item->thickness))
+					break;
+
+				if (item->fill)
+					ipl_draw_fill_box(img, x0, y0, x1, y1, newColor);
+				else
+					imlib_draw_rectangle(img, x0, y0, x1 - x0 + 1, y1 - y0 + 1, newColor, item->thickness, false);
+				break;
+
+			case stm32ipl_draw_cross:
+				halfSize = (uint16_t)x1 >> 1;
+				if (!ipl_draw_visible(img, x0 - halfSize, y0 - halfSize, x0 + halfSize, y0 + halfSize, item->thickness))
+					break;
+
+				imlib_draw_line(img, x0 - halfSize, y0, x0 + halfSize, y0, newColor, item->thickness);
+				imlib_draw_line(img, x0, y0 - halfSize, x0, y0 + halfSize, newColor, item->thickness);
+				break;
+
+			case stm32ipl_draw_line:
+				if (ipl_draw_visible(img, x0, y0, x1, y1, item->thickness))
+					imlib_draw_line(img, x0, y0, x1, y1, newColor, item->thickness);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	STM32IPL_TRACE_END(DrawList)
 	return stm32ipl_err_Ok;
 }
 
@@ -396,7 +731,8 @@ stm32ipl_err_t STM32Ipl_DrawPolygon(image_t *img, const point_t *point, uint32_t
  * @param height	Height of rectangle (pixels).
  * @param color		Color value with 0xRRGGBB format.
  * @param thickness	Thickness of the lines (pixels).
- * @param fill		When true, the rectangle is filled, otherwise it is not.
+ * @param fill		When true, the rectangle is filled (with the DMA2D when STM32IPL_ENABLE_HW_PIXEL_OPS is defined),
+ * otherwise it is not.
  * @return			stm32ipl_err_Ok on success, error otherwise.
  */
 stm32ipl_err_t STM32Ipl_DrawRectangle(image_t *img, uint16_t x, uint16_t y, uint16_t width, uint16_t height,
@@ -408,8 +744,13 @@ stm32ipl_err_t STM32Ipl_DrawRectangle(image_t *img, uint16_t x, uint16_t y, uint
 	if (width < 2 || height < 2)
 		return stm32ipl_err_InvalidParameter;
 
-	imlib_draw_rectangle(img, x, y, width, height, STM32Ipl_AdaptColor(img, color), thickness, fill);
+	STM32IPL_TRACE_BEGIN(DrawRectangle)
+	if (fill)
+		ipl_draw_fill_box(img, x, y, x + width - 1, y + height - 1, STM32Ipl_AdaptColor(img, color));
+	else
+		imlib_draw_rectangle(img, x, y, width, height, STM32Ipl_AdaptColor(img, color), thickness, fill);
 
+	STM32IPL_TRACE_END(DrawRectangle)
 	return stm32ipl_err_Ok;
 }
 
@@ -430,9 +771,11 @@ stm32ipl_err_t STM32Ipl_DrawCircle(image_t *img, uint16_t cx, uint16_t cy, uint1
 {
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(DrawCircle)
 
 	imlib_draw_circle(img, cx, cy, radius, STM32Ipl_AdaptColor(img, color), thickness, fill);
 
+	STM32IPL_TRACE_END(DrawCircle)
 	return stm32ipl_err_Ok;
 }
 
@@ -452,9 +795,114 @@ stm32ipl_err_t STM32Ipl_DrawEllipse(image_t *img, const ellipse_t *ellipse, stm3
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_VALID_PTR_ARG(ellipse)
+	STM32IPL_TRACE_BEGIN(DrawEllipse)
 
 	imlib_draw_ellipse(img, ellipse->center.x, ellipse->center.y, ellipse->radiusX, ellipse->radiusY, ellipse->rotation,
 			STM32Ipl_AdaptColor(img, color), thickness, fill);
 
+	STM32IPL_TRACE_END(DrawEllipse)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Fills the region connected to a seed pixel with a color (flood fill). A pixel joins the region when it is
+ * 4-connected to a pixel of the region and its value differs from the seed's one by at most seedThreshold and from
+ * the neighbor's one by at most floatingThreshold (for RGB565 images, on each of the R, G, B channels).
+ * The region is grown a line span at a time with a stack of bounded length taken from the fb stack, so that the
+ * memory used does not depend on the shape of the region.
+ * The supported formats are Binary, Grayscale, RGB565.
+ * @param img				Image; if it is not valid, an error is returned.
+ * @param seed				Seed pixel; it must be inside the image, otherwise an error is returned.
+ * @param seedThreshold		Maximum difference from the seed pixel, in the range [0, 1] of the channel range.
+ * @param floatingThreshold	Maximum difference from the neighbor pixel, in the range [0, 1] of the channel range.
+ * @param color				Color value with 0xRRGGBB format.
+ * @param invert			When true, the pixels outside the region are filled instead of the ones inside it
+ * (e.g. seeding the background fills the holes of the objects).
+ * @param clearBackground	When true, the pixels that are not filled are set to zero.
+ * @param mask				Optional image to be used as a pixel level mask for the operation. The mask must have the
+ * same resolution as the source image. The region only grows on the pixels that have the corresponding mask pixels set.
+ * The pointer to the mask can be null: in this case all the source image pixels are considered.
+ * @return					stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FloodFill(image_t *img, const point_t *seed, float seedThreshold, float floatingThreshold,
+		stm32ipl_color_t color, bool invert, bool clearBackground, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_NOT_RGB88)
+	STM32IPL_CHECK_VALID_PTR_ARG(seed)
+
+	if ((seed->x < 0) || (seed->x >= img->w) || (seed->y < 0) || (seed->y >= img->h))
+		return stm32ipl_err_InvalidParameter;
+
+	if ((seedThreshold < 0.0f) || (seedThreshold > 1.0f) || (floatingThreshold < 0.0f) || (floatingThreshold > 1.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(img, mask)
+	}
+
+	if (fb_avail() < imlib_flood_fill_space(img))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(FloodFill)
+
+	imlib_flood_fill(img, seed->x, seed->y, seedThreshold, floatingThreshold, STM32Ipl_AdaptColor(img, color), invert,
+			clearBackground, (image_t*)mask);
+
+	STM32IPL_TRACE_END(FloodFill)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gets the region connected to a seed pixel (flood fill) as a Binary image, without modifying the source image,
+ * e.g. to select a region interactively. The region is grown as by STM32Ipl_FloodFill().
+ * The supported formats are Binary, Grayscale, RGB565.
+ * @param img				Image; if it is not valid, an error is returned.
+ * @param seed				Seed pixel; it must be inside the image, otherwise an error is returned.
+ * @param seedThreshold		Maximum difference from the seed pixel, in the range [0, 1] of the channel range.
+ * @param floatingThreshold	Maximum difference from the neighbor pixel, in the range [0, 1] of the channel range.
+ * @param mask				Optional image to be used as a pixel level mask for the operation. The mask must have the
+ * same resolution as the source image. The region only grows on the pixels that have the corresponding mask pixels set.
+ * The pointer to the mask can be null: in this case all the source image pixels are considered.
+ * @param out				Binary image with the same resolution of the source image, whose pixels are set to 1 inside
+ * the region and to 0 outside it; its data buffer must be already allocated.
+ * @return					stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FloodFillMask(const image_t *img, const point_t *seed, float seedThreshold,
+		float floatingThreshold, const image_t *mask, image_t *out)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_NOT_RGB88)
+	STM32IPL_CHECK_VALID_IMAGE(out)
+	STM32IPL_CHECK_FORMAT(out, stm32ipl_if_binary)
+	STM32IPL_CHECK_SAME_SIZE(img, out)
+	STM32IPL_CHECK_VALID_PTR_ARG(seed)
+
+	if ((seed->x < 0) || (seed->x >= img->w) || (seed->y < 0) || (seed->y >= img->h))
+		return stm32ipl_err_InvalidParameter;
+
+	if ((seedThreshold < 0.0f) || (seedThreshold > 1.0f) || (floatingThreshold < 0.0f) || (floatingThreshold > 1.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(img, mask)
+	}
+
+	if (fb_avail() < imlib_flood_fill_int_space((image_t*)img))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(FloodFillMask)
+
+	for (int y = 0; y < out->h; y++)
+		memset(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(out, y), 0, IMAGE_BINARY_LINE_LEN_BYTES(out));
+
+	imlib_flood_fill_int(out, (image_t*)img, seed->x, seed->y, imlib_flood_fill_threshold((image_t*)img, seedThreshold),
+			imlib_flood_fill_threshold((image_t*)img, floatingThreshold), (image_t*)mask);
+
+	STM32IPL_TRACE_END(FloodFillMask)
 	return stm32ipl_err_Ok;
 }
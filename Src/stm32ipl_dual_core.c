@@ -0,0 +1,455 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_dual_core.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - dual-core execution module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef STM32IPL_ENABLE_DUAL_CORE
+#ifdef USE_STM32H747I_DISCO
+#include "stm32h7xx_hal.h"
+#endif /* USE_STM32H747I_DISCO */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#ifndef STM32IPL_DUAL_CORE_SHARED_ADDR
+#define STM32IPL_DUAL_CORE_SHARED_ADDR	0x38000000	/* SRAM4, accessible by both cores. */
+#endif /* STM32IPL_DUAL_CORE_SHARED_ADDR */
+
+#ifndef STM32IPL_DUAL_CORE_HSEM_ID
+#define STM32IPL_DUAL_CORE_HSEM_ID		10
+#endif /* STM32IPL_DUAL_CORE_HSEM_ID */
+
+#ifndef STM32IPL_DUAL_CORE_M4_SHARE
+#define STM32IPL_DUAL_CORE_M4_SHARE		33
+#endif /* STM32IPL_DUAL_CORE_M4_SHARE */
+
+#define IPL_DUAL_CACHE_LINE	32U		/* Size of the data cache lines of the Cortex-M7 (bytes). */
+
+/* State of the job descriptor; it is written by the core that owns the next step. */
+typedef enum _ipl_dual_state_t
+{
+	ipl_dual_state_idle = 0,	/* No job (written by the Cortex-M7). */
+	ipl_dual_state_posted,		/* Job posted to the Cortex-M4 (written by the Cortex-M7). */
+	ipl_dual_state_loaded,		/* The Cortex-M4 has read its input rows (written by the Cortex-M4). */
+	ipl_dual_state_done			/* The Cortex-M4 has completed its rows (written by the Cortex-M4). */
+} ipl_dual_state_t;
+
+/* Job descriptor shared by the two cores; the Cortex-M4 processes the rows [y0, y1) of the images. */
+typedef struct _ipl_dual_shared_t
+{
+	volatile uint32_t state;
+	volatile int32_t result;
+	int32_t y0;
+	int32_t y1;
+	stm32ipl_dual_job_t job;
+} __attribute__((aligned(IPL_DUAL_CACHE_LINE))) ipl_dual_shared_t;
+
+#define IPL_DUAL_SHARED	((ipl_dual_shared_t *)STM32IPL_DUAL_CORE_SHARED_ADDR)
+
+/* Cache maintenance of the Cortex-M7; the Cortex-M4 has no data cache. */
+static void ipl_dual_cache_clean(const void *addr, uint32_t size)
+{
+#ifdef CORE_CM7
+	SCB_CleanDCache_by_Addr((uint32_t *)addr, size);
+#else
+	(void)addr;
+	(void)size;
+#endif /* CORE_CM7 */
+}
+
+static void ipl_dual_cache_clean_invalidate(const void *addr, uint32_t size)
+{
+#ifdef CORE_CM7
+	SCB_CleanInvalidateDCache_by_Addr((uint32_t *)addr, size);
+#else
+	(void)addr;
+	(void)size;
+#endif /* CORE_CM7 */
+}
+
+static void ipl_dual_cache_invalidate(const void *addr, uint32_t size)
+{
+#ifdef CORE_CM7
+	SCB_InvalidateDCache_by_Addr((uint32_t *)addr, size);
+#else
+	(void)addr;
+	(void)size;
+#endif /* CORE_CM7 */
+}
+
+/* Reads the state written by the other core. */
+static uint32_t ipl_dual_get_state(void)
+{
+	ipl_dual_cache_invalidate(IPL_DUAL_SHARED, sizeof(ipl_dual_shared_t));
+	return IPL_DUAL_SHARED->state;
+}
+
+/* Writes the state read by the other core, after the data it refers to. */
+static void ipl_dual_set_state(ipl_dual_state_t state)
+{
+	__DSB();
+	IPL_DUAL_SHARED->state = state;
+	ipl_dual_cache_clean(IPL_DUAL_SHARED, sizeof(ipl_dual_shared_t));
+	__DSB();
+}
+
+static bool ipl_dual_is_filter(stm32ipl_dual_op_t op)
+{
+	return (op >= stm32ipl_dual_op_gaussian) && (op <= stm32ipl_dual_op_dilate);
+}
+
+/* Image modified by the operation. */
+static const image_t *ipl_dual_out(const stm32ipl_dual_job_t *job)
+{
+	return ((job->op == stm32ipl_dual_op_convert) || (job->op == stm32ipl_dual_op_binary)) ? &job->dst : &job->src;
+}
+
+/* Band made of the rows [y0, y1) of an image; the lines of the images are packed, so the band is an image too. */
+static void ipl_dual_band(const image_t *img, int y0, int y1, image_t *band)
+{
+	*band = *img;
+	band->data = img->data + (y0 * STM32Ipl_ImageStride(img));
+	band->h = y1 - y0;
+}
+
+/* Executes the conversion, the binarization or the math operation on the rows [y0, y1). */
+static stm32ipl_err_t ipl_dual_pointwise(const stm32ipl_dual_job_t *job, int y0, int y1)
+{
+	image_t src;
+	image_t other;
+	image_t dst;
+	const image_t *otherPtr = NULL;
+	stm32ipl_err_t error;
+
+	ipl_dual_band(&job->src, y0, y1, &src);
+	if (job->other.data) {
+		ipl_dual_band(&job->other, y0, y1, &other);
+		otherPtr = &other;
+	}
+
+	switch (job->op) {
+		case stm32ipl_dual_op_convert:
+			ipl_dual_band(&job->dst, y0, y1, &dst);
+			return STM32Ipl_Convert(&src, &dst);
+
+		case stm32ipl_dual_op_binary: {
+			list_t thresholds;
+
+			ipl_dual_band(&job->dst, y0, y1, &dst);
+			list_init(&thresholds, sizeof(color_thresholds_list_lnk_data_t));
+			for (uint32_t i = 0; i < job->nThresholds; i++)
+				list_push_back(&thresholds, (void *)&job->thresholds[i]);
+
+			error = STM32Ipl_Binary(&src, &dst, &thresholds, job->invert, job->zero, NULL);
+			list_free(&thresholds);
+			return error;
+		}
+
+		case stm32ipl_dual_op_add:
+			return STM32Ipl_Add(&src, otherPtr, job->scalar, NULL);
+
+		case stm32ipl_dual_op_sub:
+			return STM32Ipl_Sub(&src, otherPtr, job->scalar, job->invert, NULL);
+
+		case stm32ipl_dual_op_diff:
+			return STM32Ipl_Diff(&src, otherPtr, job->scalar, NULL);
+
+		case stm32ipl_dual_op_min:
+			return STM32Ipl_Min(&src, otherPtr, job->scalar, NULL);
+
+		case stm32ipl_dual_op_max:
+			return STM32Ipl_Max(&src, otherPtr, job->scalar, NULL);
+
+		default:
+			return stm32ipl_err_InvalidParameter;
+	}
+}
+
+/* Band of the rows [y0, y1) of a filtered image: the rows and the kSize rows around them (the halo) are copied
+ * to a temporary image, filtered there and copied back without the halo. The copy is needed because each core
+ * reads the rows of the other one as halo, while the filters work in place. */
+typedef struct _ipl_dual_filter_band_t
+{
+	image_t tmp;	/* Rows of the band, halo included. */
+	int inner;		/* First row of the band in tmp. */
+} ipl_dual_filter_band_t;
+
+static stm32ipl_err_t ipl_dual_filter_load(const stm32ipl_dual_job_t *job, int y0, int y1, ipl_dual_filter_band_t *band)
+{
+	int t0 = IM_MAX(y0 - job->kSize, 0);
+	int t1 = IM_MIN(y1 + job->kSize, job->src.h);
+	image_t rows;
+	stm32ipl_err_t error;
+
+	ipl_dual_band(&job->src, t0, t1, &rows);
+
+	error = STM32Ipl_AllocData(&band->tmp, rows.w, rows.h, (image_bpp_t)rows.bpp);
+	if (error != stm32ipl_err_Ok)
+		return error;
+
+	memcpy(band->tmp.data, rows.data, STM32Ipl_ImageDataSize(&rows));
+	band->inner = y0 - t0;
+
+	return stm32ipl_err_Ok;
+}
+
+static stm32ipl_err_t ipl_dual_filter_run(const stm32ipl_dual_job_t *job, ipl_dual_filter_band_t *band)
+{
+	image_t *img = &band->tmp;
+
+	switch (job->op) {
+		case stm32ipl_dual_op_gaussian:
+			return STM32Ipl_Gaussian(img, job->kSize, false, job->unsharp, NULL);
+
+		case stm32ipl_dual_op_mean:
+			return STM32Ipl_MeanFilter(img, job->kSize, false, 0, false, NULL);
+
+		case stm32ipl_dual_op_median:
+			return STM32Ipl_MedianFilter(img, job->kSize, job->percentile, false, 0, false, NULL);
+
+		case stm32ipl_dual_op_erode:
+			return STM32Ipl_Erode(img, job->kSize, job->threshold, NULL);
+
+		case stm32ipl_dual_op_dilate:
+			return STM32Ipl_Dilate(img, job->kSize, job->threshold, NULL);
+
+		default:
+			return stm32ipl_err_InvalidParameter;
+	}
+}
+
+static void ipl_dual_filter_store(const stm32ipl_dual_job_t *job, int y0, int y1, const ipl_dual_filter_band_t *band)
+{
+	uint32_t stride = STM32Ipl_ImageStride(&job->src);
+
+	memcpy(job->src.data + (y0 * stride), band->tmp.data + (band->inner * stride), (y1 - y0) * stride);
+}
+
+/* Executes the job on the rows [y0, y1); loaded() is called once the input rows have been read. */
+static stm32ipl_err_t ipl_dual_exec(const stm32ipl_dual_job_t *job, int y0, int y1, void (*loaded)(void))
+{
+	ipl_dual_filter_band_t band;
+	stm32ipl_err_t error;
+
+	if (!ipl_dual_is_filter(job->op)) {
+		if (loaded)
+			loaded();
+		return ipl_dual_pointwise(job, y0, y1);
+	}
+
+	error = ipl_dual_filter_load(job, y0, y1, &band);
+	if (loaded)
+		loaded();
+	if (error != stm32ipl_err_Ok)
+		return error;
+
+	error = ipl_dual_filter_run(job, &band);
+	if (error == stm32ipl_err_Ok)
+		ipl_dual_filter_store(job, y0, y1, &band);
+
+	STM32Ipl_ReleaseData(&band.tmp);
+
+	return error;
+}
+
+static void ipl_dual_set_loaded(void)
+{
+	ipl_dual_set_state(ipl_dual_state_loaded);
+}
+
+/* First row processed by the Cortex-M4; its first byte must begin a cache line, so that the two cores never write
+ * in the same cache line. Returns the image height when the rows cannot be split. */
+static int ipl_dual_split(const image_t *img)
+{
+	uint32_t stride = STM32Ipl_ImageStride(img);
+	int y = img->h - ((img->h * STM32IPL_DUAL_CORE_M4_SHARE) / 100);
+
+	for (int i = 0; (y < img->h) && (i < (int)IPL_DUAL_CACHE_LINE); y++, i++) {
+		if (!(((uintptr_t)(img->data + (y * stride))) & (IPL_DUAL_CACHE_LINE - 1)))
+			return y;
+	}
+
+	return img->h;
+}
+///@endcond
+
+/**
+ * @brief Initializes the dual-core execution; it must be called by both the Cortex-M7 and the Cortex-M4, after
+ * STM32Ipl_InitLib(): each core uses the library with its own memory buffer, which must not overlap with the one
+ * of the other core. On the Cortex-M4, it activates the notification of the hardware semaphore
+ * STM32IPL_DUAL_CORE_HSEM_ID, that signals the jobs posted by STM32Ipl_DualCoreRun().
+ * @return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DualCoreInit(void)
+{
+	__HAL_RCC_HSEM_CLK_ENABLE();
+
+#ifdef CORE_CM7
+	memset(IPL_DUAL_SHARED, 0, sizeof(ipl_dual_shared_t));
+	ipl_dual_set_state(ipl_dual_state_idle);
+#else
+	HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(STM32IPL_DUAL_CORE_HSEM_ID));
+#endif /* CORE_CM7 */
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Executes an operation on the Cortex-M7 and on the Cortex-M4 at the same time, each core processing a
+ * range of rows of the images: the Cortex-M4 processes the last STM32IPL_DUAL_CORE_M4_SHARE percent of the rows.
+ * The job is copied to the descriptor shared by the two cores (at STM32IPL_DUAL_CORE_SHARED_ADDR) and notified
+ * to the Cortex-M4 by releasing the hardware semaphore STM32IPL_DUAL_CORE_HSEM_ID; the function returns when
+ * both cores have completed their rows. The Cortex-M4 must call STM32Ipl_DualCorePoll() to execute the job.
+ * The filters copy the rows of each core (plus kSize rows above and below them) to a temporary image allocated
+ * by that core, so each core needs (rows + 2 * kSize) lines of memory.
+ * The data of the images must be placed in a memory accessible by both cores (e.g. AXI SRAM or SDRAM, not the
+ * DTCM), and be aligned to and a multiple of the cache line (32 bytes). The images must not be views.
+ * When the rows cannot be split at a cache line boundary, the Cortex-M7 processes the whole images.
+ * This function must be called by the Cortex-M7 only.
+ * @param job	Operation to be executed; if it is not valid, an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DualCoreRun(const stm32ipl_dual_job_t *job)
+{
+	ipl_dual_shared_t *shared = IPL_DUAL_SHARED;
+	const image_t *src;
+	const image_t *other;
+	const image_t *out;
+	ipl_dual_filter_band_t band;
+	bool filter;
+	uint32_t stride;
+	int split;
+	stm32ipl_err_t error;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(job)
+
+	src = &job->src;
+	other = &job->other;
+	out = ipl_dual_out(job);
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_NOT_VIEW(src)
+	STM32IPL_CHECK_VALID_IMAGE(out)
+	STM32IPL_CHECK_NOT_VIEW(out)
+	STM32IPL_CHECK_SAME_SIZE(src, out)
+
+	if (other->data) {
+		STM32IPL_CHECK_NOT_VIEW(other)
+		STM32IPL_CHECK_SAME_SIZE(src, other)
+	}
+
+	if (job->nThresholds > STM32IPL_DUAL_CORE_MAX_THRESHOLDS)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(DualCoreRun)
+
+	split = ipl_dual_split(out);
+	if (split == out->h) {
+		error = ipl_dual_exec(job, 0, out->h, NULL);
+		STM32IPL_TRACE_END(DualCoreRun)
+		return error;
+	}
+
+	/* The Cortex-M4 reads the images from the memory; the Cortex-M7 must not keep dirty lines of the images,
+	 * which could overwrite the rows written by the Cortex-M4 when evicted. */
+	stride = STM32Ipl_ImageStride(out);
+	ipl_dual_cache_clean_invalidate(src->data, STM32Ipl_ImageDataSize(src));
+	ipl_dual_cache_clean_invalidate(out->data, STM32Ipl_ImageDataSize(out));
+	if (other->data)
+		ipl_dual_cache_clean(other->data, STM32Ipl_ImageDataSize(other));
+
+	/* The filters read the rows of the other core as halo: the Cortex-M7 reads its rows before the Cortex-M4
+	 * can write them, and writes its rows after the Cortex-M4 has read them. */
+	filter = ipl_dual_is_filter(job->op);
+	if (filter) {
+		error = ipl_dual_filter_load(job, 0, split, &band);
+		if (error != stm32ipl_err_Ok) {
+			STM32IPL_TRACE_END(DualCoreRun)
+			return error;
+		}
+	}
+
+	shared->job = *job;
+	shared->y0 = split;
+	shared->y1 = out->h;
+	shared->result = stm32ipl_err_Ok;
+	ipl_dual_set_state(ipl_dual_state_posted);
+
+	HAL_HSEM_FastTake(STM32IPL_DUAL_CORE_HSEM_ID);
+	HAL_HSEM_Release(STM32IPL_DUAL_CORE_HSEM_ID, 0);
+
+	if (filter) {
+		error = ipl_dual_filter_run(job, &band);
+
+		while (ipl_dual_get_state() == ipl_dual_state_posted)
+			;
+
+		if (error == stm32ipl_err_Ok)
+			ipl_dual_filter_store(job, 0, split, &band);
+
+		STM32Ipl_ReleaseData(&band.tmp);
+	} else {
+		error = ipl_dual_pointwise(job, 0, split);
+	}
+
+	while (ipl_dual_get_state() != ipl_dual_state_done)
+		;
+
+	/* The rows of the Cortex-M4 (read as halo by the filters) may be in the cache. */
+	ipl_dual_cache_invalidate(out->data + (split * stride), (out->h - split) * stride);
+
+	if (error == stm32ipl_err_Ok)
+		error = (stm32ipl_err_t)shared->result;
+
+	ipl_dual_set_state(ipl_dual_state_idle);
+
+	STM32IPL_TRACE_END(DualCoreRun)
+	return error;
+}
+
+/**
+ * @brief Executes the rows of the job posted by STM32Ipl_DualCoreRun(), if any, then notifies its completion to
+ * the Cortex-M7 and activates again the notification of the hardware semaphore. It must be called by the
+ * Cortex-M4, e.g. in its main loop, after waking up from the semaphore interrupt (the HSEM free callback
+ * should not call it, as the job can take long).
+ * @return	true if a job has been executed, false otherwise.
+ */
+bool STM32Ipl_DualCorePoll(void)
+{
+	ipl_dual_shared_t *shared = IPL_DUAL_SHARED;
+
+	if (ipl_dual_get_state() != ipl_dual_state_posted)
+		return false;
+
+	shared->result = ipl_dual_exec(&shared->job, shared->y0, shared->y1, ipl_dual_set_loaded);
+	ipl_dual_set_state(ipl_dual_state_done);
+
+	HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(STM32IPL_DUAL_CORE_HSEM_ID));
+
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_DUAL_CORE */
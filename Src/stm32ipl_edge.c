@@ -40,32 +40,229 @@ stm32ipl_err_t STM32Ipl_EdgeSimple(image_t *img, const rectangle_t *roi, int32_t
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
 	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(EdgeSimple)
 
 	imlib_edge_simple(img, &realRoi, minTh, maxTh);
 
+	STM32IPL_TRACE_END(EdgeSimple)
 	return stm32ipl_err_Ok;
 }
 
+///@cond
+/* Values of the pixels of the ROI between the passes of the Canny edge detector. */
+#define IPL_CANNY_NONE		0	/* Not an edge. */
+#define IPL_CANNY_WEAK		128	/* Local maximum between the thresholds, not (yet) connected to a strong edge. */
+#define IPL_CANNY_SEED		254	/* Edge whose neighbours are still to be visited. */
+#define IPL_CANNY_EDGE		255	/* Edge whose neighbours have been visited. */
+
+/* Number of positions of the hysteresis stack; when it is full, the edges are marked as seeds and visited by a
+ * further scan of the ROI. */
+#define IPL_CANNY_STACK_SIZE(roi)	(2 * ((roi)->w + (roi)->h))
+
+/* Gradient of the row y of the ROI (1 <= y <= roi->h - 2); the pixels on the left and right borders get 0. */
+static void ipl_canny_gradient(const image_t *img, const rectangle_t *roi, int y, uint16_t *mag, uint8_t *dir)
+{
+	static const int32_t coef[3] = { 1, 2, 1 };
+	const uint8_t *rows[3];
+
+	for (int j = 0; j < 3; j++)
+		rows[j] = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, roi->y + y - 1 + j) + roi->x;
+
+	ipl_gradient_line(rows, roi->w, 1, roi->w - 1, 1, coef, mag, dir);
+	mag[0] = 0;
+	mag[roi->w - 1] = 0;
+}
+
+/* Non-maximum suppression of the row y of the ROI, whose gradient is in mag[1], with the gradient of the rows above
+ * and below in mag[0] and mag[2]: the local maxima along the gradient direction are classified with the thresholds. */
+static void ipl_canny_suppress(uint8_t *out, int w, uint16_t **mag, const uint8_t *dir, int32_t minTh, int32_t maxTh)
+{
+	out[0] = IPL_CANNY_NONE;
+	out[w - 1] = IPL_CANNY_NONE;
+
+	for (int x = 1; x < (w - 1); x++) {
+		int32_t m = mag[1][x];
+		int32_t a;
+		int32_t b;
+
+		if (m < minTh) {
+			out[x] = IPL_CANNY_NONE;
+			continue;
+		}
+
+		switch (dir[x]) {
+			case stm32ipl_gradient_dir_0:
+				a = mag[1][x - 1];
+				b = mag[1][x + 1];
+				break;
+
+			case stm32ipl_gradient_dir_45:
+				a = mag[0][x - 1];
+				b = mag[2][x + 1];
+				break;
+
+			case stm32ipl_gradient_dir_90:
+				a = mag[0][x];
+				b = mag[2][x];
+				break;
+
+			default:
+				a = mag[0][x + 1];
+				b = mag[2][x - 1];
+				break;
+		}
+
+		/* Strict on one side only, so that a ridge two pixels wide keeps one of them. */
+		if ((m > a) && (m >= b))
+			out[x] = (m >= maxTh) ? IPL_CANNY_SEED : IPL_CANNY_WEAK;
+		else
+			out[x] = IPL_CANNY_NONE;
+	}
+}
+
+/* Hysteresis: the weak edges connected to a strong one through other edges become edges; the others are cleared. */
+static void ipl_canny_hysteresis(image_t *img, const rectangle_t *roi, uint32_t *stack, uint32_t stackSize)
+{
+	int w = img->w;
+	const int32_t offset[8] = { -w - 1, -w, -w + 1, -1, 1, w - 1, w, w + 1 };
+	bool again;
+
+	do {
+		again = false;
+
+		for (int y = roi->y + 1; y < (roi->y + roi->h - 1); y++) {
+			uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+			for (int x = roi->x + 1; x < (roi->x + roi->w - 1); x++) {
+				uint32_t n;
+
+				if (row[x] != IPL_CANNY_SEED)
+					continue;
+
+				row[x] = IPL_CANNY_EDGE;
+				stack[0] = (y * w) + x;
+				n = 1;
+
+				while (n) {
+					uint32_t i = stack[--n];
+					uint8_t *p = img->data + i;
+
+					for (int k = 0; k < 8; k++) {
+						uint8_t *q = p + offset[k];
+
+						/* The ROI borders are IPL_CANNY_NONE, so the neighbours never leave the ROI. */
+						if ((*q != IPL_CANNY_WEAK) && (*q != IPL_CANNY_SEED))
+							continue;
+
+						if (n < stackSize) {
+							*q = IPL_CANNY_EDGE;
+							stack[n++] = i + offset[k];
+						} else {
+							*q = IPL_CANNY_SEED;
+							again |= (uint32_t)(q - img->data) < (uint32_t)((y * w) + x);
+						}
+					}
+				}
+			}
+		}
+	} while (again);
+
+	for (int y = roi->y; y < (roi->y + roi->h); y++) {
+		uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+		for (int x = roi->x; x < (roi->x + roi->w); x++)
+			row[x] = (row[x] == IPL_CANNY_EDGE) ? COLOR_GRAYSCALE_MAX : COLOR_GRAYSCALE_MIN;
+	}
+}
+///@endcond
+
 /**
  * @brief Canny edge detector. The supported format is Grayscale.
+ * The image is smoothed with a 3x3 Gaussian kernel; then, row by row, the Sobel gradient is computed (see
+ * STM32Ipl_Gradient(): its magnitude is |gx| + |gy|, its direction is quantized to four sectors with integer
+ * comparisons), and its local maxima along the gradient direction are classified with the two thresholds, keeping
+ * only three rows of gradient. Finally, the hysteresis keeps the maxima above minTh that are connected to one above
+ * maxTh, following the edges with a single stack. The edges are set to 255, the other pixels of the ROI, including
+ * its borders, to 0.
  * @param img		Image; if it is not valid, an error is returned.
  * @param roi		Optional region of interest of the source image where the functions operates;
  * when defined, it must be contained in the source image and have positive dimensions, otherwise
  * an error is returned; when not defined, the whole image is considered.
- * @param minTh 	Minimum threshold for hysteresis (values in the range [0, 255]).
- * @param maxTh 	Maximum threshold for hysteresis (values in the range [0, 255]).
+ * @param minTh 	Minimum threshold for hysteresis (the gradient magnitude is in the range [0, 2040]).
+ * @param maxTh 	Maximum threshold for hysteresis (the gradient magnitude is in the range [0, 2040]).
  * @return			stm32ipl_err_Ok on success, error otherwise.
  */
 stm32ipl_err_t STM32Ipl_EdgeCanny(image_t *img, const rectangle_t *roi, int32_t minTh, int32_t maxTh)
 {
 	rectangle_t realRoi;
+	uint16_t *magBuf;
+	uint8_t *dirBuf;
+	uint32_t *stack;
+	uint32_t stackSize;
+	int w;
+	int h;
 
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(img)
 	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
 
-	imlib_edge_canny(img, &realRoi, minTh, maxTh);
+	w = realRoi.w;
+	h = realRoi.h;
+	stackSize = IPL_CANNY_STACK_SIZE(&realRoi);
+
+	if (fb_avail() < (FB_ALLOC_SPACE(3 * w * sizeof(uint16_t)) + FB_ALLOC_SPACE(3 * w)
+			+ FB_ALLOC_SPACE(stackSize * sizeof(uint32_t))))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(EdgeCanny)
+
+	// 1. Noise reduction with a Gaussian filter.
+	imlib_sepconv3(img, kernel_gauss_3, 1.0f / 16.0f, 0.0f);
+
+	if ((w < 3) || (h < 3)) {
+		for (int y = realRoi.y; y < (realRoi.y + h); y++)
+			memset(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y) + realRoi.x, COLOR_GRAYSCALE_MIN, w);
+
+		STM32IPL_TRACE_END(EdgeCanny)
+		return stm32ipl_err_Ok;
+	}
+
+	magBuf = fb_alloc(3 * w * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+	dirBuf = fb_alloc(3 * w, FB_ALLOC_PREFER_SPEED);
+	stack = fb_alloc(stackSize * sizeof(uint32_t), FB_ALLOC_NO_HINT);
+
+	// 2. Gradient and non-maximum suppression, with three rows of gradient. The row y is overwritten once the
+	// gradient of the row y + 1, the last one that reads it, has been computed.
+	memset(magBuf, 0, w * sizeof(uint16_t));
+	ipl_canny_gradient(img, &realRoi, 1, magBuf + w, dirBuf + w);
+	memset(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, realRoi.y) + realRoi.x, IPL_CANNY_NONE, w);
+
+	for (int y = 1; y < (h - 1); y++) {
+		uint16_t *mag[3];
+
+		for (int j = 0; j < 3; j++)
+			mag[j] = magBuf + (((y - 1 + j) % 3) * w);
+
+		if (y < (h - 2))
+			ipl_canny_gradient(img, &realRoi, y + 1, mag[2], dirBuf + (((y + 1) % 3) * w));
+		else
+			memset(mag[2], 0, w * sizeof(uint16_t));
+
+		ipl_canny_suppress(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, realRoi.y + y) + realRoi.x, w, mag,
+				dirBuf + ((y % 3) * w), minTh, maxTh);
+	}
+
+	memset(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, realRoi.y + h - 1) + realRoi.x, IPL_CANNY_NONE, w);
+
+	// 3. Hysteresis.
+	ipl_canny_hysteresis(img, &realRoi, stack, stackSize);
+
+	fb_free();
+	fb_free();
+	fb_free();
 
+	STM32IPL_TRACE_END(EdgeCanny)
 	return stm32ipl_err_Ok;
 }
 
@@ -18,6 +18,9 @@
 
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#ifdef IPL_FILTER_HAS_MVE
+#include "mve_filter.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,12 +48,93 @@ stm32ipl_err_t STM32Ipl_GammaCorr(image_t *img, float gamma, float contrast, flo
 {
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(GammaCorr)
 
 	imlib_gamma_corr(img, gamma, contrast, brightness);
 
+	STM32IPL_TRACE_END(GammaCorr)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gets the size of the workspace needed by STM32Ipl_GammaCorr_WithWorkspace().
+ * @param img	Image; if it is not valid, an error is returned.
+ * @param size	Pointer to the size of the workspace (bytes); if it is not valid, an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GammaCorr_GetWorkspaceSize(const image_t *img, uint32_t *size)
+{
+	uint32_t lutSpace = 0;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(size)
+
+	/* Look-up tables, one per color channel. */
+	switch (img->bpp) {
+		case IMAGE_BPP_BINARY:
+			lutSpace = FB_ALLOC_SPACE((COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1) * sizeof(int));
+			break;
+
+		case IMAGE_BPP_GRAYSCALE:
+			lutSpace = FB_ALLOC_SPACE((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(int));
+			break;
+
+		case IMAGE_BPP_RGB565:
+			lutSpace = FB_ALLOC_SPACE((COLOR_R5_MAX - COLOR_R5_MIN + 1) * sizeof(int))
+					+ FB_ALLOC_SPACE((COLOR_G6_MAX - COLOR_G6_MIN + 1) * sizeof(int))
+					+ FB_ALLOC_SPACE((COLOR_B5_MAX - COLOR_B5_MIN + 1) * sizeof(int));
+			break;
+
+		case IMAGE_BPP_RGB888:
+			lutSpace = FB_ALLOC_SPACE((COLOR_R8_MAX - COLOR_R8_MIN + 1) * sizeof(int))
+					+ FB_ALLOC_SPACE((COLOR_G8_MAX - COLOR_G8_MIN + 1) * sizeof(int))
+					+ FB_ALLOC_SPACE((COLOR_B8_MAX - COLOR_B8_MIN + 1) * sizeof(int));
+			break;
+
+		default:
+			break;
+	}
+
+	*size = FB_WORKSPACE_OVERHEAD + lutSpace;
+
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Same as STM32Ipl_GammaCorr(), but the look-up tables are taken from the given workspace
+ * instead of being allocated at each call.
+ * @param img			Image; see STM32Ipl_GammaCorr().
+ * @param gamma			See STM32Ipl_GammaCorr().
+ * @param contrast		See STM32Ipl_GammaCorr().
+ * @param brightness	See STM32Ipl_GammaCorr().
+ * @param workspace		Workspace; if it is not valid, an error is returned.
+ * @param workspaceSize	Size of the workspace (bytes); it must be at least the size returned by
+ * STM32Ipl_GammaCorr_GetWorkspaceSize(), otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GammaCorr_WithWorkspace(image_t *img, float gamma, float contrast, float brightness,
+		void *workspace, uint32_t workspaceSize)
+{
+	uint32_t size;
+	stm32ipl_err_t ret;
+
+	ret = STM32Ipl_GammaCorr_GetWorkspaceSize(img, &size);
+	if (ret != stm32ipl_err_Ok)
+		return ret;
+
+	STM32IPL_CHECK_WORKSPACE(workspace, workspaceSize, size)
+
+	if (!fb_workspace_begin(workspace, workspaceSize))
+		return stm32ipl_err_NotAllowed;
+
+	ret = STM32Ipl_GammaCorr(img, gamma, contrast, brightness);
+
+	fb_workspace_end();
+
+	return ret;
+}
+
 /**
  * @brief Performs (in-place) a histogram equalization of an image (normalizes contrast and brightness of the image).
  * The supported formats (for image and mask) are Binary, Grayscale, RGB565, RGB888.
@@ -71,8 +155,10 @@ stm32ipl_err_t STM32Ipl_HistEq(image_t *img, const image_t *mask)
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(HistEq)
 	imlib_histeq(img, (image_t*)mask);
 
+	STM32IPL_TRACE_END(HistEq)
 	return stm32ipl_err_Ok;
 }
 
@@ -99,8 +185,679 @@ stm32ipl_err_t STM32Ipl_HistEqClahe(image_t *img, float clipLimit, const image_t
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(HistEqClahe)
 	imlib_clahe_histeq(img, clipLimit, (image_t*)mask);
 
+	STM32IPL_TRACE_END(HistEqClahe)
+	return stm32ipl_err_Ok;
+}
+
+///@cond
+/* Position of a pixel between the centers of two neighbouring tiles. */
+typedef struct _ipl_clahe_pos_t
+{
+	uint32_t tile0;		/* First tile. */
+	uint32_t tile1;		/* Second tile. */
+	uint16_t weight;	/* Weight (Q7) of the second tile. */
+} ipl_clahe_pos_t;
+///@endcond
+
+/* Locates coordinate i (in [0, size)) between the centers of two of the tiles, the tiles spanning
+ * [t * size / tiles, (t + 1) * size / tiles). Before the first center and after the last one the
+ * nearest tile is used alone. */
+static void ipl_clahe_locate(uint32_t i, uint32_t size, uint32_t tiles, ipl_clahe_pos_t *pos)
+{
+	/* Twice the coordinates, to keep the tile centers integer. */
+	uint32_t i2 = 2 * i + 1;
+	uint32_t t = 0;
+	uint32_t c0;
+	uint32_t c1;
+
+	while ((t + 1 < tiles) && (i2 >= (((t + 1) * size / tiles) + ((t + 2) * size / tiles))))
+		t++;
+
+	c0 = (t * size / tiles) + ((t + 1) * size / tiles);
+
+	if ((i2 < c0) || (t + 1 == tiles)) {
+		pos->tile0 = t;
+		pos->tile1 = t;
+		pos->weight = 0;
+		return;
+	}
+
+	c1 = ((t + 1) * size / tiles) + ((t + 2) * size / tiles);
+	pos->tile0 = t;
+	pos->tile1 = t + 1;
+	pos->weight = ((i2 - c0) * 128) / (c1 - c0);
+}
+
+/* Gets the luminance of the given row of the image; the Grayscale rows are returned as they are. */
+static const uint8_t *ipl_clahe_get_line(const image_t *img, uint32_t y, uint8_t *line)
+{
+	switch (img->bpp) {
+		case IMAGE_BPP_BINARY: {
+			uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < img->w; x++)
+				line[x] = COLOR_BINARY_TO_GRAYSCALE(IMAGE_GET_BINARY_PIXEL_FAST(row, x));
+			return line;
+		}
+
+		case IMAGE_BPP_GRAYSCALE:
+			return IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+		case IMAGE_BPP_RGB565: {
+			uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < img->w; x++)
+				line[x] = COLOR_RGB565_TO_GRAYSCALE(IMAGE_GET_RGB565_PIXEL_FAST(row, x));
+			return line;
+		}
+
+		case IMAGE_BPP_RGB888: {
+			rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < img->w; x++)
+				line[x] = COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row, x));
+			return line;
+		}
+
+		default:
+			return line;
+	}
+}
+
+/* Writes the equalized luminance back to the given row of the image, within the mask spans. */
+static void ipl_clahe_put_line(image_t *img, uint32_t y, const uint8_t *line, const image_t *mask)
+{
+	for (int sx = 0, sn; (sn = image_mask_span((image_t*)mask, &sx, y, img->w, false)); sx += sn) {
+		switch (img->bpp) {
+			case IMAGE_BPP_BINARY: {
+				uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+				for (int x = sx; x < sx + sn; x++)
+					IMAGE_PUT_BINARY_PIXEL_FAST(row, x, COLOR_GRAYSCALE_TO_BINARY(line[x]));
+				break;
+			}
+
+			case IMAGE_BPP_GRAYSCALE: {
+				uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+				if (row != line)
+					memcpy(row + sx, line + sx, sn);
+				break;
+			}
+
+			case IMAGE_BPP_RGB565: {
+				uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+				for (int x = sx; x < sx + sn; x++) {
+					int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row, x);
+					IMAGE_PUT_RGB565_PIXEL_FAST(row, x,
+							imlib_yuv_to_rgb(line[x], COLOR_RGB565_TO_U(pixel), COLOR_RGB565_TO_V(pixel)));
+				}
+				break;
+			}
+
+			case IMAGE_BPP_RGB888: {
+				rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+				for (int x = sx; x < sx + sn; x++) {
+					rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(row, x);
+					IMAGE_PUT_RGB888_PIXEL_FAST(row, x, imlib_yuv_to_rgb888(line[x],
+							COLOR_RGB888_TO_U(pixel.r, pixel.g, pixel.b), COLOR_RGB888_TO_V(pixel.r, pixel.g, pixel.b)));
+				}
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+}
+
+/* Clips the histogram of a tile, redistributes the excess over all the bins and computes the look-up table,
+ * optionally blended with the previous one. */
+static void ipl_clahe_map_tile(const stm32ipl_clahe_t *ctx, uint32_t *hist, uint32_t pixels, uint8_t *lut, bool blend)
+{
+	uint32_t cdf = 0;
+	uint32_t scale;
+
+	if (ctx->clipLimit > 0.0f) {
+		uint32_t limit = (uint32_t)(ctx->clipLimit * pixels / 256.0f);
+		uint32_t excess = 0;
+		uint32_t add;
+		uint32_t rest;
+
+		if (limit < 1)
+			limit = 1;
+
+		for (uint32_t i = 0; i < 256; i++) {
+			if (hist[i] > limit) {
+				excess += hist[i] - limit;
+				hist[i] = limit;
+			}
+		}
+
+		add = excess >> 8;
+		rest = excess & 0xFF;
+
+		for (uint32_t i = 0; i < 256; i++)
+			hist[i] += add;
+
+		if (rest) {
+			uint32_t step = 256 / rest;
+			for (uint32_t i = 0; (i < 256) && rest; i += step, rest--)
+				hist[i]++;
+		}
+	}
+
+	/* 255 / pixels in Q24, so that the mapping needs no division per bin. */
+	scale = (uint32_t)((255ULL << 24) / pixels);
+
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t value;
+
+		cdf += hist[i];
+		value = (uint32_t)((((uint64_t)cdf * scale) + (1 << 23)) >> 24);
+
+		if (blend)
+			value = ((lut[i] * ctx->smoothing) + (value * (256 - ctx->smoothing)) + 128) >> 8;
+
+		lut[i] = value;
+	}
+}
+
+/* Computes the look-up tables of all the tiles from the histograms of the given image. */
+static void ipl_clahe_map(stm32ipl_clahe_t *ctx, const image_t *img)
+{
+	uint32_t tilesX = ctx->tilesX;
+	uint32_t tilesY = ctx->tilesY;
+	bool blend = ctx->hasLuts && ctx->smoothing;
+
+	for (uint32_t ty = 0; ty < tilesY; ty++) {
+		uint32_t y0 = ty * ctx->height / tilesY;
+		uint32_t y1 = (ty + 1) * ctx->height / tilesY;
+
+		memset(ctx->hist, 0, tilesX * 256 * sizeof(uint32_t));
+
+		for (uint32_t y = y0; y < y1; y++) {
+			const uint8_t *line = ipl_clahe_get_line(img, y, ctx->line);
+
+			for (uint32_t tx = 0; tx < tilesX; tx++) {
+				uint32_t *hist = ctx->hist + (tx * 256);
+				for (uint32_t x = tx * ctx->width / tilesX, xx = (tx + 1) * ctx->width / tilesX; x < xx; x++)
+					hist[line[x]]++;
+			}
+		}
+
+		for (uint32_t tx = 0; tx < tilesX; tx++) {
+			uint32_t pixels = ((((tx + 1) * ctx->width) / tilesX) - ((tx * ctx->width) / tilesX)) * (y1 - y0);
+			ipl_clahe_map_tile(ctx, ctx->hist + (tx * 256), pixels, ctx->luts + (((ty * tilesX) + tx) * 256), blend);
+		}
+	}
+
+	ctx->hasLuts = true;
+}
+
+#ifndef IPL_FILTER_HAS_MVE
+/* Maps a line through the look-up tables of the upper (lutU) and lower (lutB) rows of tiles, interpolating
+ * bilinearly in fixed point: weights are in Q7 and the vertical blend rounds as a Q15 doubling multiply. */
+static void ipl_clahe_row(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *lutU, const uint8_t *lutB,
+		const uint16_t *offL, const uint16_t *offR, const uint16_t *weightX, uint16_t weightY)
+{
+	int32_t wy = weightY << 9;
+
+	for (uint32_t x = 0; x < n; x++) {
+		uint32_t v = src[x];
+		int32_t wx = weightX[x];
+		int32_t top = (lutU[offL[x] + v] * (128 - wx)) + (lutU[offR[x] + v] * wx);
+		int32_t bot = (lutB[offL[x] + v] * (128 - wx)) + (lutB[offR[x] + v] * wx);
+
+		top += (((bot - top) * wy) + (1 << 15)) >> 16;
+		dst[x] = (top + 64) >> 7;
+	}
+}
+#endif /* IPL_FILTER_HAS_MVE */
+
+/**
+ * @brief Initializes a context of STM32Ipl_ClaheApply(), allocating the tile look-up tables, the histograms and the
+ * interpolation tables once for all the frames of the given size.
+ * @param ctx			Context; if it is not valid, an error is returned.
+ * @param width			Width of the images to be processed; it must be at least the number of horizontal tiles.
+ * @param height		Height of the images to be processed; it must be at least the number of vertical tiles.
+ * @param tilesX		Number of tiles along the horizontal direction, in [1, STM32IPL_CLAHE_MAX_TILES].
+ * @param tilesY		Number of tiles along the vertical direction, in [1, STM32IPL_CLAHE_MAX_TILES].
+ * @param clipLimit		Clip limit, as a multiple of the mean count of the histogram bins of a tile
+ * (i.e. 2 to 4 for a moderate contrast enhancement); values less than or equal to 0 disable the clipping.
+ * @param smoothing		Weight (out of 256) of the look-up tables of the previous frame when blending them with the new
+ * ones, to damp the flickering of video streams; 0 disables the temporal smoothing.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ClaheInit(stm32ipl_clahe_t *ctx, uint32_t width, uint32_t height, uint8_t tilesX,
+		uint8_t tilesY, float clipLimit, uint8_t smoothing)
+{
+	uint32_t lutSize;
+	uint8_t *buffer;
+	ipl_clahe_pos_t pos;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	memset(ctx, 0, sizeof(stm32ipl_clahe_t));
+
+	if ((tilesX < 1) || (tilesX > STM32IPL_CLAHE_MAX_TILES) || (tilesY < 1) || (tilesY > STM32IPL_CLAHE_MAX_TILES)
+			|| (width < tilesX) || (height < tilesY))
+		return stm32ipl_err_InvalidParameter;
+
+	lutSize = tilesY * tilesX * 256;
+
+	/* Look-up tables, histograms, column tables and line buffer, in one block. */
+	buffer = xalloc(lutSize + (tilesX * 256 * sizeof(uint32_t)) + (width * 3 * sizeof(uint16_t)) + (width * 2));
+	if (!buffer)
+		return stm32ipl_err_OutOfMemory;
+
+	ctx->width = width;
+	ctx->height = height;
+	ctx->tilesX = tilesX;
+	ctx->tilesY = tilesY;
+	ctx->clipLimit = clipLimit;
+	ctx->smoothing = smoothing;
+	ctx->hasLuts = false;
+	ctx->hist = (uint32_t*)buffer;
+	ctx->offL = (uint16_t*)(ctx->hist + (tilesX * 256));
+	ctx->offR = ctx->offL + width;
+	ctx->weightX = ctx->offR + width;
+	ctx->luts = (uint8_t*)(ctx->weightX + width);
+	ctx->line = ctx->luts + lutSize;
+
+	for (uint32_t x = 0; x < width; x++) {
+		ipl_clahe_locate(x, width, tilesX, &pos);
+		ctx->offL[x] = pos.tile0 * 256;
+		ctx->offR[x] = pos.tile1 * 256;
+		ctx->weightX[x] = pos.weight;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Performs (in-place) a contrast limited adaptive histogram equalization of an image with a context
+ * initialized by STM32Ipl_ClaheInit(). The image is split into tiles, the clipped histogram of each tile is mapped to
+ * a look-up table (blended with the one of the previous frame when temporal smoothing is enabled), and each pixel
+ * is mapped by bilinear interpolation, in fixed point, of the look-up tables of the four nearest tiles.
+ * Color images are equalized on their luminance.
+ * The supported formats (for image and mask) are Binary, Grayscale, RGB565, RGB888.
+ * @param ctx			Context; if it is not valid, an error is returned.
+ * @param img			Image; if it is not valid, an error is returned. Its size must be the one given to
+ * STM32Ipl_ClaheInit(), otherwise an error is returned.
+ * @param mask 			Optional image to be used as a pixel level mask for the operation. The mask must have the same resolution
+ * as the source image. Only the source pixels that have the corresponding mask pixels set are modified.
+ * The pointer to the mask can be null: in this case all the source image pixels are modified.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ClaheApply(stm32ipl_clahe_t *ctx, image_t *img, const image_t *mask)
+{
+	uint32_t rowSize;
+	ipl_clahe_pos_t pos;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(img, mask)
+	}
+
+	if (!ctx->luts || (img->w != ctx->width) || (img->h != ctx->height))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(ClaheApply)
+
+	ipl_clahe_map(ctx, img);
+
+	rowSize = ctx->tilesX * 256;
+
+	for (uint32_t y = 0; y < ctx->height; y++) {
+		const uint8_t *src = ipl_clahe_get_line(img, y, ctx->line);
+		uint8_t *dst = ((img->bpp == IMAGE_BPP_GRAYSCALE) && !mask) ? (uint8_t*)src : ctx->line + ctx->width;
+
+		ipl_clahe_locate(y, ctx->height, ctx->tilesY, &pos);
+
+#ifdef IPL_FILTER_HAS_MVE
+		mve_imlib_clahe_row(src, dst, ctx->width, ctx->luts + (pos.tile0 * rowSize), ctx->luts + (pos.tile1 * rowSize),
+				ctx->offL, ctx->offR, ctx->weightX, pos.weight);
+#else
+		ipl_clahe_row(src, dst, ctx->width, ctx->luts + (pos.tile0 * rowSize), ctx->luts + (pos.tile1 * rowSize),
+				ctx->offL, ctx->offR, ctx->weightX, pos.weight);
+#endif /* IPL_FILTER_HAS_MVE */
+
+		ipl_clahe_put_line(img, y, dst, mask);
+	}
+
+	STM32IPL_TRACE_END(ClaheApply)
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Discards the look-up tables of the previous frame kept by the context, so that the next call to
+ * STM32Ipl_ClaheApply() does not blend with them (i.e. after a scene cut).
+ * @param ctx	Context.
+ * @return		void.
+ */
+void STM32Ipl_ClaheReset(stm32ipl_clahe_t *ctx)
+{
+	if (ctx)
+		ctx->hasLuts = false;
+}
+
+/**
+ * @brief Releases the buffers allocated by STM32Ipl_ClaheInit() and resets the context.
+ * @param ctx	Context.
+ * @return		void.
+ */
+void STM32Ipl_ClaheRelease(stm32ipl_clahe_t *ctx)
+{
+	if (!ctx)
+		return;
+
+	if (ctx->hist)
+		xfree(ctx->hist);
+
+	memset(ctx, 0, sizeof(stm32ipl_clahe_t));
+}
+
+/* Fills the table of a channel with max + 1 entries as imlib_gamma_corr() does. */
+static void ipl_lut_gamma_channel(uint8_t *table, int max, float gamma, float contrast, float brightness)
+{
+	float scale = max;
+	float div = 1 / scale;
+
+	for (int i = 0; i <= max; i++) {
+		int p = (int)(((fast_powf(i * div, gamma) * contrast) + brightness) * scale);
+		table[i] = IM_MIN(IM_MAX(p, 0), max);
+	}
+}
+
+/**
+ * @brief Builds the look-up table that STM32Ipl_GammaCorr() applies to images of the given format, so that it can
+ * be applied to any number of images by STM32Ipl_ApplyLut() without being rebuilt.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param lut			Look-up table; if it is not valid, an error is returned.
+ * @param format		Format of the images the look-up table applies to.
+ * @param gamma			See STM32Ipl_GammaCorr().
+ * @param contrast		See STM32Ipl_GammaCorr().
+ * @param brightness	See STM32Ipl_GammaCorr().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LutFromGamma(stm32ipl_lut_t *lut, image_bpp_t format, float gamma, float contrast,
+		float brightness)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(lut)
+
+	memset(lut, 0, sizeof(stm32ipl_lut_t));
+	lut->bpp = format;
+	lut->luminance = false;
+
+	gamma = IM_DIV(1.0f, gamma);
+
+	switch (format) {
+		case IMAGE_BPP_BINARY:
+			ipl_lut_gamma_channel(lut->table[0], COLOR_BINARY_MAX, gamma, contrast, brightness);
+			break;
+
+		case IMAGE_BPP_GRAYSCALE:
+			ipl_lut_gamma_channel(lut->table[0], COLOR_GRAYSCALE_MAX, gamma, contrast, brightness);
+			break;
+
+		case IMAGE_BPP_RGB565:
+			ipl_lut_gamma_channel(lut->table[0], COLOR_R5_MAX, gamma, contrast, brightness);
+			ipl_lut_gamma_channel(lut->table[1], COLOR_G6_MAX, gamma, contrast, brightness);
+			ipl_lut_gamma_channel(lut->table[2], COLOR_B5_MAX, gamma, contrast, brightness);
+			break;
+
+		case IMAGE_BPP_RGB888:
+			ipl_lut_gamma_channel(lut->table[0], COLOR_R8_MAX, gamma, contrast, brightness);
+			ipl_lut_gamma_channel(lut->table[1], COLOR_G8_MAX, gamma, contrast, brightness);
+			ipl_lut_gamma_channel(lut->table[2], COLOR_B8_MAX, gamma, contrast, brightness);
+			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Builds the look-up table that STM32Ipl_HistEq() applies to the given image (the cumulative distribution
+ * of its histogram), so that it can be applied to the image and to the following ones by STM32Ipl_ApplyLut().
+ * Color images are equalized on their luminance.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param lut	Look-up table; if it is not valid, an error is returned.
+ * @param img	Image; if it is not valid, an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LutFromHistEq(stm32ipl_lut_t *lut, const image_t *img)
+{
+	uint32_t hist[256];
+	uint32_t sum = 0;
+	uint32_t bins;
+	float s;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(lut)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+
+	memset(lut, 0, sizeof(stm32ipl_lut_t));
+	memset(hist, 0, sizeof(hist));
+	lut->bpp = (image_bpp_t)img->bpp;
+	lut->luminance = (img->bpp == IMAGE_BPP_RGB565) || (img->bpp == IMAGE_BPP_RGB888);
+	bins = (img->bpp == IMAGE_BPP_BINARY) ? (COLOR_BINARY_MAX + 1) : 256;
+
+	for (int y = 0; y < img->h; y++) {
+		switch (img->bpp) {
+			case IMAGE_BPP_BINARY: {
+				uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+				for (int x = 0; x < img->w; x++)
+					hist[IMAGE_GET_BINARY_PIXEL_FAST(row, x)]++;
+				break;
+			}
+
+			case IMAGE_BPP_GRAYSCALE: {
+				uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+				for (int x = 0; x < img->w; x++)
+					hist[row[x]]++;
+				break;
+			}
+
+			case IMAGE_BPP_RGB565: {
+				uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+				for (int x = 0; x < img->w; x++)
+					hist[COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL_FAST(row, x)) - COLOR_Y_MIN]++;
+				break;
+			}
+
+			case IMAGE_BPP_RGB888: {
+				rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+				for (int x = 0; x < img->w; x++)
+					hist[COLOR_RGB888_TO_Y(row[x].r, row[x].g, row[x].b) - COLOR_Y_MIN]++;
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	/* Same mapping as imlib_histeq(). */
+	s = (bins - 1) / ((float)(img->w * img->h));
+
+	for (uint32_t i = 0; i < bins; i++) {
+		sum += hist[i];
+		lut->table[0][i] = fast_floorf(s * sum);
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+#ifndef IPL_FILTER_HAS_MVE
+/* Maps n bytes through a table. */
+static void ipl_lut_u8(const uint8_t *src, uint8_t *dst, uint32_t n, const uint8_t *table)
+{
+	for (uint32_t i = 0; i < n; i++)
+		dst[i] = table[src[i]];
+}
+
+/* Maps n RGB565 pixels through the tables of the three channels. */
+static void ipl_lut_rgb565(const uint16_t *src, uint16_t *dst, uint32_t n, const uint8_t *rTable,
+		const uint8_t *gTable, const uint8_t *bTable)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		uint16_t pixel = src[i];
+		dst[i] = COLOR_R5_G6_B5_TO_RGB565(rTable[COLOR_RGB565_TO_R5(pixel)], gTable[COLOR_RGB565_TO_G6(pixel)],
+				bTable[COLOR_RGB565_TO_B5(pixel)]);
+	}
+}
+
+/* Maps n RGB888 pixels through the tables of the three channels (red, green, blue, 256 entries each). */
+static void ipl_lut_rgb888(const rgb888_t *src, rgb888_t *dst, uint32_t n, const uint8_t *tables)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		rgb888_t pixel = src[i];
+		dst[i].r = tables[pixel.r];
+		dst[i].g = tables[256 + pixel.g];
+		dst[i].b = tables[512 + pixel.b];
+	}
+}
+#endif /* IPL_FILTER_HAS_MVE */
+
+/* Maps the luminance of n color pixels through a table as imlib_histeq() does, keeping their chrominance. */
+static void ipl_lut_luminance(image_t *img, uint32_t y, int x0, int n, const uint8_t *table)
+{
+	for (int x = x0; x < x0 + n; x++) {
+		int r, g, b;
+		uint8_t l, u, v;
+
+		if (img->bpp == IMAGE_BPP_RGB565) {
+			int pixel = IMAGE_GET_RGB565_PIXEL_FAST(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), x);
+			r = COLOR_RGB565_TO_R8(pixel);
+			g = COLOR_RGB565_TO_G8(pixel);
+			b = COLOR_RGB565_TO_B8(pixel);
+		} else {
+			rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y), x);
+			r = pixel.r;
+			g = pixel.g;
+			b = pixel.b;
+		}
+
+		l = (uint8_t)(((r * 9770) + (g * 19182) + (b * 3736)) >> 15);
+		u = (uint8_t)(((b << 14) - (r * 5529) - (g * 10855)) >> 15);
+		v = (uint8_t)(((r << 14) - (g * 13682) - (b * 2664)) >> 15);
+
+		if (img->bpp == IMAGE_BPP_RGB565)
+			IMAGE_PUT_RGB565_PIXEL_FAST(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), x, imlib_yuv_to_rgb(table[l], u, v));
+		else
+			IMAGE_PUT_RGB888_PIXEL_FAST(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y), x,
+					imlib_yuv_to_rgb888(table[l], u, v));
+	}
+}
+
+/**
+ * @brief Applies (in-place) a look-up table built by STM32Ipl_LutFromGamma() or STM32Ipl_LutFromHistEq()
+ * to an image: Grayscale pixels and the channels of color pixels cost one table look-up each.
+ * The supported formats (for image and mask) are Binary, Grayscale, RGB565, RGB888.
+ * @param img	Image; if it is not valid, an error is returned. Its format must be the one of the look-up table,
+ * otherwise an error is returned.
+ * @param lut	Look-up table; if it is not valid, an error is returned.
+ * @param mask 	Optional image to be used as a pixel level mask for the operation. The mask must have the same resolution
+ * as the source image. Only the source pixels that have the corresponding mask pixels set are modified.
+ * The pointer to the mask can be null: in this case all the source image pixels are modified.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ApplyLut(image_t *img, const stm32ipl_lut_t *lut, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(lut)
+	STM32IPL_CHECK_SAME_FORMAT(img, lut)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(img, mask)
+	}
+
+	STM32IPL_TRACE_BEGIN(ApplyLut)
+
+	for (int y = 0; y < img->h; y++) {
+		if ((img->bpp == IMAGE_BPP_BINARY) && !mask) {
+			/* Each output bit is table[0][0] where the input bit is clear, table[0][1] where it is set. */
+			uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+			uint32_t clear = lut->table[0][0] ? 0xFFFFFFFF : 0;
+			uint32_t set = lut->table[0][1] ? 0xFFFFFFFF : 0;
+
+			int words = img->w >> UINT32_T_SHIFT;
+			int rest = img->w & UINT32_T_MASK;
+
+			for (int i = 0; i < words; i++)
+				row[i] = (clear & ~row[i]) | (set & row[i]);
+
+			if (rest) {
+				uint32_t keep = (1 << rest) - 1;
+				row[words] = (row[words] & ~keep) | (((clear & ~row[words]) | (set & row[words])) & keep);
+			}
+
+			continue;
+		}
+
+		for (int sx = 0, sn; (sn = image_mask_span((image_t*)mask, &sx, y, img->w, false)); sx += sn) {
+			if (lut->luminance) {
+				ipl_lut_luminance(img, y, sx, sn, lut->table[0]);
+				continue;
+			}
+
+			switch (img->bpp) {
+				case IMAGE_BPP_BINARY: {
+					uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+					for (int x = sx; x < sx + sn; x++)
+						IMAGE_PUT_BINARY_PIXEL_FAST(row, x, lut->table[0][IMAGE_GET_BINARY_PIXEL_FAST(row, x)]);
+					break;
+				}
+
+				case IMAGE_BPP_GRAYSCALE: {
+					uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y) + sx;
+#ifdef IPL_FILTER_HAS_MVE
+					mve_imlib_lut_u8(row, row, sn, lut->table[0]);
+#else
+					ipl_lut_u8(row, row, sn, lut->table[0]);
+#endif /* IPL_FILTER_HAS_MVE */
+					break;
+				}
+
+				case IMAGE_BPP_RGB565: {
+					uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y) + sx;
+#ifdef IPL_FILTER_HAS_MVE
+					mve_imlib_lut_rgb565(row, row, sn, lut->table[0], lut->table[1], lut->table[2]);
+#else
+					ipl_lut_rgb565(row, row, sn, lut->table[0], lut->table[1], lut->table[2]);
+#endif /* IPL_FILTER_HAS_MVE */
+					break;
+				}
+
+				case IMAGE_BPP_RGB888: {
+					rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y) + sx;
+#ifdef IPL_FILTER_HAS_MVE
+					mve_imlib_lut_rgb888((uint8_t*)row, (uint8_t*)row, sn, lut->table[0]);
+#else
+					ipl_lut_rgb888(row, row, sn, lut->table[0]);
+#endif /* IPL_FILTER_HAS_MVE */
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+	}
+
+	STM32IPL_TRACE_END(ApplyLut)
+
 	return stm32ipl_err_Ok;
 }
 
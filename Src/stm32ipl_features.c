@@ -0,0 +1,523 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_features.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - feature extraction module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+#ifdef IPL_FEATURES_HAS_MVE
+#include "mve_features.h"
+#endif /* IPL_FEATURES_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_HOG_KSIZE		1		/* Gradient kernel (3x3) used when the gradient is not provided. */
+#define IPL_HOG_CLIP		0.2f	/* Clipping of the L2-Hys block normalization. */
+#define IPL_FEAT_MAX_CELL	255		/* Maximum cell side: the LBP counts of a cell fit 16 bits. */
+
+/* Histogram bin of each LBP code: the 58 uniform codes (at most two 0/1 transitions around the circle) have their
+ * own bin, in increasing order; all the other codes share the last bin. */
+static const uint8_t ipl_lbp_uniform[256] = {
+	 0,  1,  2,  3,  4, 58,  5,  6,  7, 58, 58, 58,  8, 58,  9, 10,
+	11, 58, 58, 58, 58, 58, 58, 58, 12, 58, 58, 58, 13, 58, 14, 15,
+	16, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58,
+	17, 58, 58, 58, 58, 58, 58, 58, 18, 58, 58, 58, 19, 58, 20, 21,
+	22, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58,
+	58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58,
+	23, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58,
+	24, 58, 58, 58, 58, 58, 58, 58, 25, 58, 58, 58, 26, 58, 27, 28,
+	29, 30, 58, 31, 58, 58, 58, 32, 58, 58, 58, 58, 58, 58, 58, 33,
+	58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 34,
+	58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58,
+	58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 35,
+	36, 37, 58, 38, 58, 58, 58, 39, 58, 58, 58, 58, 58, 58, 58, 40,
+	58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 58, 41,
+	42, 43, 58, 44, 58, 58, 58, 45, 58, 58, 58, 58, 58, 58, 58, 46,
+	47, 48, 58, 49, 58, 58, 58, 50, 51, 52, 58, 53, 54, 55, 56, 57
+};
+
+/* Checks the cell grid parameters shared by the HOG and LBP features; returns the number of cells per row and
+ * per column, or false if the grid is not valid (minCells cells per side at least). */
+static bool ipl_feat_grid(uint16_t w, uint16_t h, uint16_t cellSize, uint16_t minCells, uint16_t *cellsX,
+		uint16_t *cellsY)
+{
+	if ((cellSize < 2) || (cellSize > IPL_FEAT_MAX_CELL))
+		return false;
+
+	*cellsX = w / cellSize;
+	*cellsY = h / cellSize;
+
+	return (*cellsX >= minCells) && (*cellsY >= minCells);
+}
+
+/* Checks that the window of cells (cellX, cellY, cellsW, cellsH) lies in a grid of cellsX * cellsY cells and
+ * has at least minCells cells per side. */
+static bool ipl_feat_window(uint16_t cellsX, uint16_t cellsY, uint16_t cellX, uint16_t cellY, uint16_t cellsW,
+		uint16_t cellsH, uint16_t minCells)
+{
+	return (cellsW >= minCells) && (cellsH >= minCells) && ((cellX + cellsW) <= cellsX)
+			&& ((cellY + cellsH) <= cellsY);
+}
+
+/* L2-Hys normalization of the 2x2 cells block whose top cells are top[0], top[1] and bottom cells are
+ * bottom[0], bottom[1] (STM32IPL_HOG_BINS bins each): the block is L2 normalized, clipped and normalized again,
+ * then scaled to [0, 255]. */
+static void ipl_hog_block(const uint32_t *top, const uint32_t *bottom, uint8_t *block)
+{
+	float v[STM32IPL_HOG_BLOCK_SIZE];
+	float sum = 0.0f;
+	float sumClip = 0.0f;
+	float scale;
+
+	for (int i = 0; i < (2 * STM32IPL_HOG_BINS); i++) {
+		v[i] = top[i];
+		v[(2 * STM32IPL_HOG_BINS) + i] = bottom[i];
+	}
+
+	for (int i = 0; i < STM32IPL_HOG_BLOCK_SIZE; i++)
+		sum += v[i] * v[i];
+
+	scale = 1.0f / sqrtf(sum + 1.0f);
+
+	for (int i = 0; i < STM32IPL_HOG_BLOCK_SIZE; i++) {
+		v[i] = IM_MIN(v[i] * scale, IPL_HOG_CLIP);
+		sumClip += v[i] * v[i];
+	}
+
+	scale = 255.0f / sqrtf(sumClip + 1e-6f);
+
+	for (int i = 0; i < STM32IPL_HOG_BLOCK_SIZE; i++)
+		block[i] = (uint8_t)IM_MIN((v[i] * scale) + 0.5f, 255.0f);
+}
+
+/* Uniform LBP histogram bin of the pixel x of the line centered on rows[1]; the borders are replicated. */
+static uint8_t ipl_lbp_pixel(const uint8_t **rows, int w, int x)
+{
+	int xl = IM_MAX(x - 1, 0);
+	int xr = IM_MIN(x + 1, w - 1);
+	uint8_t c = rows[1][x];
+	uint8_t code;
+
+	/* Clockwise from the top-left neighbor, as in the MVE implementation. */
+	code = (rows[0][xl] >= c);
+	code |= (rows[0][x] >= c) << 1;
+	code |= (rows[0][xr] >= c) << 2;
+	code |= (rows[1][xr] >= c) << 3;
+	code |= (rows[2][xr] >= c) << 4;
+	code |= (rows[2][x] >= c) << 5;
+	code |= (rows[2][xl] >= c) << 6;
+	code |= (rows[1][xl] >= c) << 7;
+
+	return ipl_lbp_uniform[code];
+}
+
+/* Uniform LBP histogram bins of the pixels 0 ... n - 1 of a line of width w, centered on rows[1]. On MVE
+ * targets, the pixels far enough from the borders are computed with vector arithmetic. */
+static void ipl_lbp_line(const uint8_t **rows, int w, int n, uint8_t *code)
+{
+	int v0 = n;
+	int v1 = n;
+
+#ifdef IPL_FEATURES_HAS_MVE
+	v0 = 1;
+	v1 = IM_MIN(n, w - 1);
+
+	if (v0 < v1)
+		mve_lbp_u8(rows, v0, v1, ipl_lbp_uniform, code);
+	else
+		v0 = v1 = n;
+#endif /* IPL_FEATURES_HAS_MVE */
+
+	for (int x = 0; x < v0; x++)
+		code[x] = ipl_lbp_pixel(rows, w, x);
+
+	for (int x = v1; x < n; x++)
+		code[x] = ipl_lbp_pixel(rows, w, x);
+}
+///@endcond
+
+/**
+ * @brief Initializes the HOG features computed by STM32Ipl_HogCompute() on frames of the given size: the frame
+ * is divided in square cells (the pixels beyond the last complete cell are ignored), each described by the
+ * histogram of the gradient magnitude over the STM32IPL_HOG_BINS unsigned orientation sectors of
+ * STM32Ipl_Gradient(); the cells are grouped in 2x2 blocks, overlapping by one cell, that are normalized (L2-Hys)
+ * and stored as STM32IPL_HOG_BLOCK_SIZE bytes.
+ * The blocks are allocated from the heap and must be released with STM32Ipl_HogRelease().
+ * @param hog		HOG features; if it is not valid, an error is returned.
+ * @param w			Width of the frames.
+ * @param h			Height of the frames.
+ * @param cellSize	Side of the cells (pixels), in the range [2, 255]; the frame must contain 2x2 cells at least,
+ * otherwise an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_HogInit(stm32ipl_hog_t *hog, uint16_t w, uint16_t h, uint16_t cellSize)
+{
+	uint16_t cellsX;
+	uint16_t cellsY;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(hog)
+
+	if (!ipl_feat_grid(w, h, cellSize, 2, &cellsX, &cellsY))
+		return stm32ipl_err_InvalidParameter;
+
+	memset(hog, 0, sizeof(stm32ipl_hog_t));
+
+	hog->blocks = xalloc((cellsX - 1) * (cellsY - 1) * STM32IPL_HOG_BLOCK_SIZE);
+	if (!hog->blocks)
+		return stm32ipl_err_OutOfMemory;
+
+	hog->w = w;
+	hog->h = h;
+	hog->cellSize = cellSize;
+	hog->cellsX = cellsX;
+	hog->cellsY = cellsY;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Computes the HOG features of a frame (see STM32Ipl_HogInit()), once for all the windows later extracted
+ * with STM32Ipl_HogWindow(). The gradient can be provided, when already computed with STM32Ipl_Gradient() for
+ * another purpose (e.g. the Canny edge detector); otherwise it is computed row by row with a 3x3 kernel, with the
+ * vector implementation of STM32Ipl_Gradient() on MVE targets. Only two rows of cell histograms are kept, as each
+ * row of blocks is normalized as soon as its cells are complete. The supported format is Grayscale.
+ * @param hog	HOG features created with STM32Ipl_HogInit(); if it is not valid, an error is returned.
+ * @param src	Source image; if it is not valid, an error is returned; it must have the size given to
+ * STM32Ipl_HogInit(), otherwise an error is returned.
+ * @param mag	Optional magnitude of the gradient of src, as returned by STM32Ipl_Gradient().
+ * @param dir	Optional direction of the gradient of src, as returned by STM32Ipl_Gradient(); mag and dir must be
+ * both valid or both null, otherwise an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_HogCompute(stm32ipl_hog_t *hog, const image_t *src, const uint16_t *mag, const uint8_t *dir)
+{
+	const uint8_t *rows[(IPL_HOG_KSIZE * 2) + 1];
+	int32_t coef[(IPL_HOG_KSIZE * 2) + 1] = { 1, 2, 1 };
+	uint32_t rowLen;
+	uint32_t nAlloc = 0;
+	uint32_t *prevCells;
+	uint32_t *cells;
+	uint16_t *magRow = NULL;
+	uint8_t *dirRow = NULL;
+	int cellsW;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(hog)
+	STM32IPL_CHECK_VALID_PTR_ARG(hog->blocks)
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, stm32ipl_if_grayscale)
+
+	if ((src->w != hog->w) || (src->h != hog->h) || (!mag != !dir))
+		return stm32ipl_err_InvalidParameter;
+
+	cellsW = hog->cellsX * hog->cellSize;
+	rowLen = hog->cellsX * STM32IPL_HOG_BINS;
+
+	prevCells = fb_alloc(rowLen * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+	nAlloc += (prevCells != NULL);
+	cells = fb_alloc(rowLen * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+	nAlloc += (cells != NULL);
+	if (!mag) {
+		magRow = fb_alloc(cellsW * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+		nAlloc += (magRow != NULL);
+		dirRow = fb_alloc(cellsW, FB_ALLOC_PREFER_SPEED);
+		nAlloc += (dirRow != NULL);
+	}
+
+	if (!prevCells || !cells || (!mag && (!magRow || !dirRow))) {
+		while (nAlloc--)
+			fb_free();
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(HogCompute)
+
+	memset(cells, 0, rowLen * sizeof(uint32_t));
+
+	for (int y = 0; y < (hog->cellsY * hog->cellSize); y++) {
+		const uint16_t *m;
+		const uint8_t *d;
+		uint32_t *cell = cells;
+		int cy = y / hog->cellSize;
+
+		if (mag) {
+			m = mag + (y * src->w);
+			d = dir + (y * src->w);
+		} else {
+			for (int j = 0; j < ((IPL_HOG_KSIZE * 2) + 1); j++)
+				rows[j] = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src,
+						IM_MIN(IM_MAX(y - IPL_HOG_KSIZE + j, 0), src->h - 1));
+
+			ipl_gradient_line(rows, src->w, 0, cellsW, IPL_HOG_KSIZE, coef, magRow, dirRow);
+			m = magRow;
+			d = dirRow;
+		}
+
+		for (int x = 0; x < cellsW; x += hog->cellSize, cell += STM32IPL_HOG_BINS)
+			for (int i = x; i < (x + hog->cellSize); i++)
+				cell[d[i]] += m[i];
+
+		if ((y % hog->cellSize) != (hog->cellSize - 1))
+			continue;
+
+		/* The row of cells cy is complete: the row of blocks above it can be normalized. */
+		if (cy > 0) {
+			uint8_t *block = hog->blocks + ((cy - 1) * (hog->cellsX - 1) * STM32IPL_HOG_BLOCK_SIZE);
+
+			for (int cx = 0; cx < (hog->cellsX - 1); cx++, block += STM32IPL_HOG_BLOCK_SIZE)
+				ipl_hog_block(prevCells + (cx * STM32IPL_HOG_BINS), cells + (cx * STM32IPL_HOG_BINS), block);
+		}
+
+		uint32_t *tmp = prevCells;
+		prevCells = cells;
+		cells = tmp;
+		memset(cells, 0, rowLen * sizeof(uint32_t));
+	}
+
+	STM32IPL_TRACE_END(HogCompute)
+
+	while (nAlloc--)
+		fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Extracts the HOG descriptor of a window of cells from the features computed by STM32Ipl_HogCompute():
+ * the (cellsW - 1) * (cellsH - 1) blocks of the window, row by row, are copied with no further computation, so
+ * that a sliding-window classifier can scan all the positions of the frame at the cost of a copy each.
+ * @param hog		HOG features computed by STM32Ipl_HogCompute(); if it is not valid, an error is returned.
+ * @param cellX		X coordinate of the window, in cells.
+ * @param cellY		Y coordinate of the window, in cells.
+ * @param cellsW	Width of the window, in cells.
+ * @param cellsH	Height of the window, in cells; the window must contain 2x2 cells at least and lie in the cell
+ * grid, otherwise an error is returned.
+ * @param desc		Buffer of (cellsW - 1) * (cellsH - 1) * STM32IPL_HOG_BLOCK_SIZE bytes that receives the descriptor;
+ * if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_HogWindow(const stm32ipl_hog_t *hog, uint16_t cellX, uint16_t cellY, uint16_t cellsW,
+		uint16_t cellsH, uint8_t *desc)
+{
+	uint32_t stride;
+	uint32_t len;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(hog)
+	STM32IPL_CHECK_VALID_PTR_ARG(hog->blocks)
+	STM32IPL_CHECK_VALID_PTR_ARG(desc)
+
+	if (!ipl_feat_window(hog->cellsX, hog->cellsY, cellX, cellY, cellsW, cellsH, 2))
+		return stm32ipl_err_InvalidParameter;
+
+	/* The blocks of a row of the window are contiguous. */
+	stride = (hog->cellsX - 1) * STM32IPL_HOG_BLOCK_SIZE;
+	len = (cellsW - 1) * STM32IPL_HOG_BLOCK_SIZE;
+
+	for (int y = cellY; y < (cellY + cellsH - 1); y++, desc += len)
+		memcpy(desc, hog->blocks + (y * stride) + (cellX * STM32IPL_HOG_BLOCK_SIZE), len);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the blocks of HOG features created with STM32Ipl_HogInit().
+ * @param hog	HOG features.
+ * @return		void.
+ */
+void STM32Ipl_HogRelease(stm32ipl_hog_t *hog)
+{
+	if (!hog)
+		return;
+
+	xfree(hog->blocks);
+
+	memset(hog, 0, sizeof(stm32ipl_hog_t));
+}
+
+/**
+ * @brief Initializes the LBP features computed by STM32Ipl_LbpCompute() on frames of the given size: the frame is
+ * divided in square cells (the pixels beyond the last complete cell are ignored), each described by the histogram
+ * of the uniform local binary patterns (8 neighbors at distance 1) of its pixels, in STM32IPL_LBP_BINS bins scaled
+ * to [0, 255] (a bin holding all the pixels of the cell is 255).
+ * The histograms are allocated from the heap and must be released with STM32Ipl_LbpRelease().
+ * @param lbp		LBP features; if it is not valid, an error is returned.
+ * @param w			Width of the frames.
+ * @param h			Height of the frames.
+ * @param cellSize	Side of the cells (pixels), in the range [2, 255]; the frame must contain one cell at least,
+ * otherwise an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LbpInit(stm32ipl_lbp_t *lbp, uint16_t w, uint16_t h, uint16_t cellSize)
+{
+	uint16_t cellsX;
+	uint16_t cellsY;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(lbp)
+
+	if (!ipl_feat_grid(w, h, cellSize, 1, &cellsX, &cellsY))
+		return stm32ipl_err_InvalidParameter;
+
+	memset(lbp, 0, sizeof(stm32ipl_lbp_t));
+
+	lbp->cells = xalloc(cellsX * cellsY * STM32IPL_LBP_BINS);
+	if (!lbp->cells)
+		return stm32ipl_err_OutOfMemory;
+
+	lbp->w = w;
+	lbp->h = h;
+	lbp->cellSize = cellSize;
+	lbp->cellsX = cellsX;
+	lbp->cellsY = cellsY;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Computes the LBP features of a frame (see STM32Ipl_LbpInit()), once for all the windows later extracted
+ * with STM32Ipl_LbpWindow(). Each pixel is compared with its 8 neighbors (the image borders are replicated); the
+ * resulting code is mapped to its uniform pattern bin and counted in the histogram of its cell. On MVE targets, the
+ * codes are computed 16 pixels at a time. The supported format is Grayscale.
+ * @param lbp	LBP features created with STM32Ipl_LbpInit(); if it is not valid, an error is returned.
+ * @param src	Source image; if it is not valid, an error is returned; it must have the size given to
+ * STM32Ipl_LbpInit(), otherwise an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LbpCompute(stm32ipl_lbp_t *lbp, const image_t *src)
+{
+	const uint8_t *rows[3];
+	uint32_t rowLen;
+	uint32_t cellArea;
+	uint16_t *counts;
+	uint8_t *code;
+	int cellsW;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(lbp)
+	STM32IPL_CHECK_VALID_PTR_ARG(lbp->cells)
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, stm32ipl_if_grayscale)
+
+	if ((src->w != lbp->w) || (src->h != lbp->h))
+		return stm32ipl_err_InvalidParameter;
+
+	cellsW = lbp->cellsX * lbp->cellSize;
+	rowLen = lbp->cellsX * STM32IPL_LBP_BINS;
+	cellArea = lbp->cellSize * lbp->cellSize;
+
+	counts = fb_alloc(rowLen * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+	if (!counts)
+		return stm32ipl_err_OutOfMemory;
+
+	code = fb_alloc(cellsW, FB_ALLOC_PREFER_SPEED);
+	if (!code) {
+		fb_free();
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(LbpCompute)
+
+	memset(counts, 0, rowLen * sizeof(uint16_t));
+
+	for (int y = 0; y < (lbp->cellsY * lbp->cellSize); y++) {
+		uint16_t *hist = counts;
+
+		for (int j = 0; j < 3; j++)
+			rows[j] = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, IM_MIN(IM_MAX(y - 1 + j, 0), src->h - 1));
+
+		ipl_lbp_line(rows, src->w, cellsW, code);
+
+		for (int x = 0; x < cellsW; x += lbp->cellSize, hist += STM32IPL_LBP_BINS)
+			for (int i = x; i < (x + lbp->cellSize); i++)
+				hist[code[i]]++;
+
+		if ((y % lbp->cellSize) != (lbp->cellSize - 1))
+			continue;
+
+		/* The row of cells is complete. */
+		uint8_t *cell = lbp->cells + ((y / lbp->cellSize) * rowLen);
+
+		for (uint32_t i = 0; i < rowLen; i++)
+			cell[i] = ((counts[i] * 255) + (cellArea / 2)) / cellArea;
+
+		memset(counts, 0, rowLen * sizeof(uint16_t));
+	}
+
+	STM32IPL_TRACE_END(LbpCompute)
+
+	fb_free();
+	fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Extracts the LBP descriptor of a window of cells from the features computed by STM32Ipl_LbpCompute(): the
+ * cellsW * cellsH histograms of the window, row by row, are copied with no further computation, so that a
+ * sliding-window classifier can scan all the positions of the frame at the cost of a copy each.
+ * @param lbp		LBP features computed by STM32Ipl_LbpCompute(); if it is not valid, an error is returned.
+ * @param cellX		X coordinate of the window, in cells.
+ * @param cellY		Y coordinate of the window, in cells.
+ * @param cellsW	Width of the window, in cells.
+ * @param cellsH	Height of the window, in cells; the window must contain one cell at least and lie in the cell
+ * grid, otherwise an error is returned.
+ * @param desc		Buffer of cellsW * cellsH * STM32IPL_LBP_BINS bytes that receives the descriptor; if it is not
+ * valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LbpWindow(const stm32ipl_lbp_t *lbp, uint16_t cellX, uint16_t cellY, uint16_t cellsW,
+		uint16_t cellsH, uint8_t *desc)
+{
+	uint32_t stride;
+	uint32_t len;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(lbp)
+	STM32IPL_CHECK_VALID_PTR_ARG(lbp->cells)
+	STM32IPL_CHECK_VALID_PTR_ARG(desc)
+
+	if (!ipl_feat_window(lbp->cellsX, lbp->cellsY, cellX, cellY, cellsW, cellsH, 1))
+		return stm32ipl_err_InvalidParameter;
+
+	/* The histograms of a row of the window are contiguous. */
+	stride = lbp->cellsX * STM32IPL_LBP_BINS;
+	len = cellsW * STM32IPL_LBP_BINS;
+
+	for (int y = cellY; y < (cellY + cellsH); y++, desc += len)
+		memcpy(desc, lbp->cells + (y * stride) + (cellX * STM32IPL_LBP_BINS), len);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the histograms of LBP features created with STM32Ipl_LbpInit().
+ * @param lbp	LBP features.
+ * @return		void.
+ */
+void STM32Ipl_LbpRelease(stm32ipl_lbp_t *lbp)
+{
+	if (!lbp)
+		return;
+
+	xfree(lbp->cells);
+
+	memset(lbp, 0, sizeof(stm32ipl_lbp_t));
+}
+
+#ifdef __cplusplus
+}
+#endif
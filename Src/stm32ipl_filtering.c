@@ -18,6 +18,7 @@
 
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#include "stm32ipl_kernels.h"
 #ifdef IPL_FILTER_HAS_MVE
 #include "mve_filter.h"
 #endif
@@ -26,8 +27,29 @@
 extern "C" {
 #endif
 
+///@cond
+#if defined(IPL_FILTER_HAS_MVE) && defined(STM32IPL_ENABLE_PERF_COUNTERS)
+/* Records the reason why the scalar implementation runs instead of mve_imlib_edge_u8(). */
+#define IPL_PERF_EDGE_FALLBACK(img, mask) \
+	if (!ipl_mve_enabled) { \
+		STM32IPL_PERF_SCALAR(Disabled) \
+	} else if (mask) { \
+		STM32IPL_PERF_SCALAR(Mask) \
+	} else if ((img)->bpp != IMAGE_BPP_GRAYSCALE) { \
+		STM32IPL_PERF_SCALAR(Format) \
+	} else { \
+		STM32IPL_PERF_SCALAR(Parameter) \
+	}
+#else
+#define IPL_PERF_EDGE_FALLBACK(img, mask)
+#endif /* IPL_FILTER_HAS_MVE && STM32IPL_ENABLE_PERF_COUNTERS */
+///@endcond
+
 /**
  * @brief Applies a standard mean blurring filter using a box filter to an image.
+ * With Grayscale, RGB565 and RGB888 images, running column sums are used, so that the processing time does
+ * not depend on the kernel size; they need about w * 2 (Grayscale) or w * 6 (RGB565, RGB888) bytes more, and
+ * one more line buffer; when such memory is not available, the direct method is used.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img		Image; if it is not valid, an error is returned.
  * @param kSize		Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -45,22 +67,51 @@ extern "C" {
 stm32ipl_err_t STM32Ipl_MeanFilter(image_t *img, uint8_t kSize, bool threshold, int32_t offset, bool invert,
 		const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_MeanFilterEx(img, img, kSize, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_MeanFilter(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The running sums, histograms and separable passes write the result straight to the destination image, with
+ * no line buffers and copies; the other paths copy the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_MeanFilter().
+ * @param threshold		See STM32Ipl_MeanFilter().
+ * @param offset		See STM32Ipl_MeanFilter().
+ * @param invert		See STM32Ipl_MeanFilter().
+ * @param mask			Optional mask; see STM32Ipl_MeanFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MeanFilterEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_mean_filter(img, kSize, threshold, offset, invert, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(MeanFilter)
+	imlib_mean_filter((image_t*)src, dst, kSize, threshold, offset, invert, (image_t*)mask);
 
+	STM32IPL_TRACE_END(MeanFilter)
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Applies a standard mean blurring filter using a box filter to an image.
+ * With Grayscale and RGB565 images, the kernels from 9x9 on use sliding column histograms, so that the
+ * processing time does not depend on the kernel size; they need about w * 64 (Grayscale) or w * 128 (RGB565)
+ * bytes more than the smaller kernels; when such memory is not available, the smaller kernels method is used.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img		 Image; if it is not valid, an error is returned.
  * @param kSize		 Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -81,23 +132,193 @@ stm32ipl_err_t STM32Ipl_MeanFilter(image_t *img, uint8_t kSize, bool threshold,
 stm32ipl_err_t STM32Ipl_MedianFilter(image_t *img, uint8_t kSize, float percentile, bool threshold, int32_t offset,
 		bool invert, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_MedianFilterEx(img, img, kSize, percentile, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_MedianFilter(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The running sums, histograms and separable passes write the result straight to the destination image, with
+ * no line buffers and copies; the other paths copy the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_MedianFilter().
+ * @param percentile	See STM32Ipl_MedianFilter().
+ * @param threshold		See STM32Ipl_MedianFilter().
+ * @param offset		See STM32Ipl_MedianFilter().
+ * @param invert		See STM32Ipl_MedianFilter().
+ * @param mask			Optional mask; see STM32Ipl_MedianFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MedianFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float percentile,
+		bool threshold, int32_t offset, bool invert, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
 	if ((percentile < 0.0f) || (percentile > 1.0f))
 		return stm32ipl_err_InvalidParameter;
 
-	imlib_median_filter(img, kSize, percentile, threshold, offset, invert, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(MedianFilter)
+	imlib_median_filter((image_t*)src, dst, kSize, percentile, threshold, offset, invert, (image_t*)mask);
+
+	STM32IPL_TRACE_END(MedianFilter)
+	return stm32ipl_err_Ok;
+}
+
+/*
+ * @brief Returns the space (bytes) taken on the fb stack by the ring of line buffers used by the filters.
+ * @param img		Image.
+ * @param kSize		Kernel size.
+ * @return			Space (bytes).
+ */
+static uint32_t ipl_filter_line_buffer_space(const image_t *img, uint8_t kSize)
+{
+	return FB_ALLOC_SPACE(image_line_size((image_t*)img) * (kSize + 1));
+}
+
+/**
+ * @brief Gets the size of the workspace needed by STM32Ipl_MeanFilter_WithWorkspace().
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param kSize			Kernel size; see STM32Ipl_MeanFilter().
+ * @param size		Pointer to the size of the workspace (bytes); if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MeanFilter_GetWorkspaceSize(const image_t *img, uint8_t kSize, uint32_t *size)
+{
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(size)
+
+	*size = FB_WORKSPACE_OVERHEAD + IM_MAX(ipl_filter_line_buffer_space(img, kSize),
+			imlib_mean_filter_sum_space((image_t*)img, kSize));
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Same as STM32Ipl_MeanFilter(), but the temporary buffers are taken from the given workspace
+ * instead of being allocated at each call.
+ * @param img			Image; see STM32Ipl_MeanFilter().
+ * @param kSize			Kernel size; see STM32Ipl_MeanFilter().
+ * @param threshold		See STM32Ipl_MeanFilter().
+ * @param offset		See STM32Ipl_MeanFilter().
+ * @param invert		See STM32Ipl_MeanFilter().
+ * @param mask			Optional mask; see STM32Ipl_MeanFilter().
+ * @param workspace		Workspace; if it is not valid, an error is returned.
+ * @param workspaceSize	Size of the workspace (bytes); it must be at least the size returned by
+ * STM32Ipl_MeanFilter_GetWorkspaceSize(), otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MeanFilter_WithWorkspace(image_t *img, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask, void *workspace, uint32_t workspaceSize)
+{
+	uint32_t size;
+	stm32ipl_err_t ret;
+
+	ret = STM32Ipl_MeanFilter_GetWorkspaceSize(img, kSize, &size);
+	if (ret != stm32ipl_err_Ok)
+		return ret;
+
+	STM32IPL_CHECK_WORKSPACE(workspace, workspaceSize, size)
+
+	if (!fb_workspace_begin(workspace, workspaceSize))
+		return stm32ipl_err_NotAllowed;
+
+	ret = STM32Ipl_MeanFilter(img, kSize, threshold, offset, invert, mask);
+
+	fb_workspace_end();
+
+	return ret;
+}
+
+/**
+ * @brief Gets the size of the workspace needed by STM32Ipl_MedianFilter_WithWorkspace().
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param kSize			Kernel size; see STM32Ipl_MedianFilter().
+ * @param size		Pointer to the size of the workspace (bytes); if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MedianFilter_GetWorkspaceSize(const image_t *img, uint8_t kSize, uint32_t *size)
+{
+	uint32_t histSpace = 0;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(size)
+
+	/* Histograms used to find the percentile. */
+	switch (img->bpp) {
+		case IMAGE_BPP_GRAYSCALE:
+			histSpace = FB_ALLOC_SPACE(64);
+			break;
+
+		case IMAGE_BPP_RGB565:
+			histSpace = FB_ALLOC_SPACE(32) + FB_ALLOC_SPACE(64) + FB_ALLOC_SPACE(32);
+			break;
+
+		case IMAGE_BPP_RGB888:
+			histSpace = 3 * FB_ALLOC_SPACE(64);
+			break;
+
+		default:
+			break;
+	}
+
+	/* The large kernels use the column histograms instead, when they fit. */
+	*size = FB_WORKSPACE_OVERHEAD + IM_MAX(ipl_filter_line_buffer_space(img, kSize) + histSpace,
+			imlib_median_filter_hist_space((image_t*)img, kSize));
 
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Same as STM32Ipl_MedianFilter(), but the temporary buffers are taken from the given workspace
+ * instead of being allocated at each call.
+ * @param img			Image; see STM32Ipl_MedianFilter().
+ * @param kSize			Kernel size; see STM32Ipl_MedianFilter().
+ * @param percentile	See STM32Ipl_MedianFilter().
+ * @param threshold		See STM32Ipl_MedianFilter().
+ * @param offset		See STM32Ipl_MedianFilter().
+ * @param invert		See STM32Ipl_MedianFilter().
+ * @param mask			Optional mask; see STM32Ipl_MedianFilter().
+ * @param workspace		Workspace; if it is not valid, an error is returned.
+ * @param workspaceSize	Size of the workspace (bytes); it must be at least the size returned by
+ * STM32Ipl_MedianFilter_GetWorkspaceSize(), otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MedianFilter_WithWorkspace(image_t *img, uint8_t kSize, float percentile, bool threshold,
+		int32_t offset, bool invert, const image_t *mask, void *workspace, uint32_t workspaceSize)
+{
+	uint32_t size;
+	stm32ipl_err_t ret;
+
+	ret = STM32Ipl_MedianFilter_GetWorkspaceSize(img, kSize, &size);
+	if (ret != stm32ipl_err_Ok)
+		return ret;
+
+	STM32IPL_CHECK_WORKSPACE(workspace, workspaceSize, size)
+
+	if (!fb_workspace_begin(workspace, workspaceSize))
+		return stm32ipl_err_NotAllowed;
+
+	ret = STM32Ipl_MedianFilter(img, kSize, percentile, threshold, offset, invert, mask);
+
+	fb_workspace_end();
+
+	return ret;
+}
+
 /**
  * @brief Runs the mode filter on the image by replacing each pixel with the mode of their neighbours.
  * This method works great on grayscale images. However, on RGB images it creates a lot of artifacts
@@ -119,17 +340,43 @@ stm32ipl_err_t STM32Ipl_MedianFilter(image_t *img, uint8_t kSize, float percenti
 stm32ipl_err_t STM32Ipl_ModeFilter(image_t *img, uint8_t kSize, bool threshold, int32_t offset, bool invert,
 		const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_ModeFilterEx(img, img, kSize, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_ModeFilter(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The running sums, histograms and separable passes write the result straight to the destination image, with
+ * no line buffers and copies; the other paths copy the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_ModeFilter().
+ * @param threshold		See STM32Ipl_ModeFilter().
+ * @param offset		See STM32Ipl_ModeFilter().
+ * @param invert		See STM32Ipl_ModeFilter().
+ * @param mask			Optional mask; see STM32Ipl_ModeFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ModeFilterEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, int32_t offset,
+		bool invert, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_mode_filter(img, kSize, threshold, offset, invert, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(ModeFilter)
+	imlib_mode_filter((image_t*)src, dst, kSize, threshold, offset, invert, (image_t*)mask);
 
+	STM32IPL_TRACE_END(ModeFilter)
 	return stm32ipl_err_Ok;
 }
 
@@ -154,20 +401,47 @@ stm32ipl_err_t STM32Ipl_ModeFilter(image_t *img, uint8_t kSize, bool threshold,
 stm32ipl_err_t STM32Ipl_MidpointFilter(image_t *img, uint8_t kSize, float bias, bool threshold, int32_t offset,
 bool invert, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_MidpointFilterEx(img, img, kSize, bias, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_MidpointFilter(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The running sums, histograms and separable passes write the result straight to the destination image, with
+ * no line buffers and copies; the other paths copy the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_MidpointFilter().
+ * @param bias			See STM32Ipl_MidpointFilter().
+ * @param threshold		See STM32Ipl_MidpointFilter().
+ * @param offset		See STM32Ipl_MidpointFilter().
+ * @param invert		See STM32Ipl_MidpointFilter().
+ * @param mask			Optional mask; see STM32Ipl_MidpointFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MidpointFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float bias, bool threshold,
+		int32_t offset, bool invert, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
 	if ((bias < 0.0f) || (bias > 1.0f))
 		return stm32ipl_err_InvalidParameter;
 
-	imlib_midpoint_filter(img, kSize, bias, threshold, offset, invert, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(MidpointFilter)
+	imlib_midpoint_filter((image_t*)src, dst, kSize, bias, threshold, offset, invert, (image_t*)mask);
 
+	STM32IPL_TRACE_END(MidpointFilter)
 	return stm32ipl_err_Ok;
 }
 
@@ -198,17 +472,133 @@ bool invert, const image_t *mask)
 stm32ipl_err_t STM32Ipl_BilateralFilter(image_t *img, uint8_t kSize, float colorSigma, float spaceSigma, bool threshold,
 		int32_t offset, bool invert, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_BilateralFilterEx(img, img, kSize, colorSigma, spaceSigma, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_BilateralFilter(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_BilateralFilter().
+ * @param colorSigma	See STM32Ipl_BilateralFilter().
+ * @param spaceSigma	See STM32Ipl_BilateralFilter().
+ * @param threshold		See STM32Ipl_BilateralFilter().
+ * @param offset		See STM32Ipl_BilateralFilter().
+ * @param invert		See STM32Ipl_BilateralFilter().
+ * @param mask			Optional mask; see STM32Ipl_BilateralFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BilateralFilterEx(const image_t *src, image_t *dst, uint8_t kSize, float colorSigma,
+		float spaceSigma, bool threshold, int32_t offset, bool invert, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	STM32IPL_TRACE_BEGIN(BilateralFilter)
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
+
+	imlib_bilateral_filter(dst, kSize, colorSigma, spaceSigma, threshold, offset, invert, (image_t*)mask);
+
+	STM32IPL_TRACE_END(BilateralFilter)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Applies a fast bilateral filter to the image, with the same parameters of STM32Ipl_BilateralFilter():
+ * the range and space weights are computed once in fixed-point look-up tables instead of for each pixel.
+ * In separable mode, the kernel is approximated by a horizontal pass followed by a vertical one, so that the cost
+ * per pixel grows linearly with the kernel size (instead of quadratically); it suits the large kernels, at the
+ * price of a slightly weaker edge preservation on the diagonal structures.
+ * For the Binary format, and for the non-separable kernels larger than 21x21, STM32Ipl_BilateralFilter() is used.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img 			Image; if it is not valid, an error is returned.
+ * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), etc.
+ * @param colorSigma 	Controls how closely colors are matched using the bilateral filter.
+ * Increase this to increase color blurring.
+ * @param spaceSigma 	Controls how closely pixels space-wise are blurred with each other.
+ * Increase this to increase pixel blurring.
+ * @param separable		True enables the separable approximation.
+ * @param threshold 	True enables adaptive thresholding of the image, which sets pixels
+ * to one or zero based on a pixel’s brightness in relation to the brightness of the kernel
+ * of pixels around them.
+ * @param offset  		If threshold is true and offset set to a negative value, sets more
+ * pixels to 1 as you make it more negative, while a positive value only sets the sharpest
+ * contrast changes to 1.
+ * @param invert 		If threshold is true and invert is true the binary image resulting
+ * output is inverted.
+ * @param mask 			Optional image to be used as a pixel level mask for the operation.
+ * The mask must have the same resolution as the source image. Only the source pixels that
+ * have the corresponding mask pixels set are considered.
+ * The pointer to the mask can be null: in this case all the source image pixels are considered.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BilateralFilterFast(image_t *img, uint8_t kSize, float colorSigma, float spaceSigma,
+		bool separable, bool threshold, int32_t offset, bool invert, const image_t *mask)
+{
+	return STM32Ipl_BilateralFilterFastEx(img, img, kSize, colorSigma, spaceSigma, separable, threshold, offset, invert,
+			mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_BilateralFilterFast(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The fast filter writes the result straight to the destination image; when STM32Ipl_BilateralFilter() is used,
+ * see STM32Ipl_BilateralFilterEx().
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_BilateralFilterFast().
+ * @param colorSigma	See STM32Ipl_BilateralFilterFast().
+ * @param spaceSigma	See STM32Ipl_BilateralFilterFast().
+ * @param separable		See STM32Ipl_BilateralFilterFast().
+ * @param threshold		See STM32Ipl_BilateralFilterFast().
+ * @param offset		See STM32Ipl_BilateralFilterFast().
+ * @param invert		See STM32Ipl_BilateralFilterFast().
+ * @param mask			Optional mask; see STM32Ipl_BilateralFilterFast().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BilateralFilterFastEx(const image_t *src, image_t *dst, uint8_t kSize, float colorSigma,
+		float spaceSigma, bool separable, bool threshold, int32_t offset, bool invert, const image_t *mask)
+{
+	uint32_t space;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_bilateral_filter((image_t*)img, kSize, colorSigma, spaceSigma, threshold, offset, invert, (image_t*)mask);
+	space = imlib_bilateral_filter_fast_space((image_t*)src, kSize, separable);
+	if (!space)
+		return STM32Ipl_BilateralFilterEx(src, dst, kSize, colorSigma, spaceSigma, threshold, offset, invert, mask);
+
+	if (fb_avail() < space)
+		return stm32ipl_err_OutOfMemory;
 
+	STM32IPL_TRACE_BEGIN(BilateralFilterFast)
+	imlib_bilateral_filter_fast((image_t*)src, dst, kSize, colorSigma, spaceSigma, separable, threshold, offset, invert,
+			(image_t*)mask);
+
+	STM32IPL_TRACE_END(BilateralFilterFast)
 	return stm32ipl_err_Ok;
 }
 
@@ -236,19 +626,46 @@ stm32ipl_err_t STM32Ipl_BilateralFilter(image_t *img, uint8_t kSize, float color
  */
 stm32ipl_err_t STM32Ipl_Morph(image_t *img, uint8_t kSize, const int32_t *krn, float mul, int32_t add, bool threshold,
 		int32_t offset, bool invert, const image_t *mask)
+{
+	return STM32Ipl_MorphEx(img, img, kSize, krn, mul, add, threshold, offset, invert, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Morph(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Morph().
+ * @param krn				Kernel data; see STM32Ipl_Morph().
+ * @param mul			See STM32Ipl_Morph().
+ * @param add			See STM32Ipl_Morph().
+ * @param threshold		See STM32Ipl_Morph().
+ * @param offset		See STM32Ipl_Morph().
+ * @param invert		See STM32Ipl_Morph().
+ * @param mask			Optional mask; see STM32Ipl_Morph().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MorphEx(const image_t *src, image_t *dst, uint8_t kSize, const int32_t *krn, float mul,
+		int32_t add, bool threshold, int32_t offset, bool invert, const image_t *mask)
 {
 	int n;
 	int m;
 
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(Morph)
 	n = kSize * 2 + 1;
 	m = 0;
 
@@ -262,8 +679,14 @@ stm32ipl_err_t STM32Ipl_Morph(image_t *img, uint8_t kSize, const int32_t *krn, f
 	if (mul == 0)
 		mul = 1.0f / m;
 
-	imlib_morph(img, kSize, (int*)krn, mul, add, threshold, offset, invert, (image_t*)mask);
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
 
+	/* The generic kernel has no MVE implementation. */
+	STM32IPL_PERF_SCALAR(NotBuilt)
+	imlib_morph(dst, kSize, (int*)krn, mul, add, threshold, offset, invert, (image_t*)mask);
+
+	STM32IPL_TRACE_END(Morph)
 	return stm32ipl_err_Ok;
 }
 
@@ -316,6 +739,11 @@ static stm32ipl_err_t ipl_gaussian_mve_u8(image_t *img, uint8_t kSize, int *pasc
 
 /**
  * @brief Convolves the image by a smoothing gaussian kernel.
+ * The kernel is applied as a vertical and an horizontal pass with integer weights: the binomial weights (rows of
+ * the Pascal's triangle) up to the 9x9 kernel, and the same weights normalized to 8 bits for the larger kernels;
+ * the taps whose normalized weight is zero are skipped. Besides the kSize + 1 line buffers, the passes need a line
+ * of 16-bit sums per channel and one more line; when such memory is not available, the 2D kernel is applied,
+ * that only supports kernels up to 9x9.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img		Image; if it is not valid, an error is returned.
  * @param kSize		Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -329,6 +757,27 @@ static stm32ipl_err_t ipl_gaussian_mve_u8(image_t *img, uint8_t kSize, int *pasc
  * @return			stm32ipl_err_Ok on success, error otherwise.
  */
 stm32ipl_err_t STM32Ipl_Gaussian(image_t *img, uint8_t kSize, bool threshold, bool unsharp, const image_t *mask)
+{
+	return STM32Ipl_GaussianEx(img, img, kSize, threshold, unsharp, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Gaussian(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The separable filter writes the result straight to the destination image, with no line buffers and copies;
+ * otherwise the source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Gaussian().
+ * @param threshold		See STM32Ipl_Gaussian().
+ * @param unsharp		See STM32Ipl_Gaussian().
+ * @param mask			Optional mask; see STM32Ipl_Gaussian().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GaussianEx(const image_t *src, image_t *dst, uint8_t kSize, bool threshold, bool unsharp,
+		const image_t *mask)
 {
 	int k_2;
 	int n;
@@ -337,21 +786,47 @@ stm32ipl_err_t STM32Ipl_Gaussian(image_t *img, uint8_t kSize, bool threshold, bo
 	int m;
 	stm32ipl_err_t ret = stm32ipl_err_UnsupportedMethod;
 
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	STM32IPL_TRACE_BEGIN(Gaussian)
+
+	/* The separable implementation is used when its buffers fit, otherwise the 2D kernel is applied. */
+	if (fb_avail() >= imlib_gaussian_filter_space((image_t*)src, kSize)) {
+#ifdef IPL_FILTER_HAS_MVE
+		if (src->bpp != IMAGE_BPP_BINARY) {
+			STM32IPL_PERF_MVE()
+		} else {
+			STM32IPL_PERF_SCALAR(Format)
+		}
+#else
+		STM32IPL_PERF_SCALAR(NotBuilt)
+#endif
+		imlib_gaussian_filter((image_t*)src, dst, kSize, threshold, unsharp, (image_t*)mask);
+		STM32IPL_TRACE_END(Gaussian)
+		return stm32ipl_err_Ok;
 	}
 
+	/* The 2D kernel is applied in place. */
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
+
 	k_2 = kSize * 2;
 	n = k_2 + 1;
 
 	pascal = xalloc0(n * sizeof(int));
-	if (!pascal)
+	if (!pascal) {
+		STM32IPL_TRACE_END(Gaussian)
 		return stm32ipl_err_OutOfMemory;
+	}
 
 	pascal[0] = 1;
 
@@ -362,16 +837,33 @@ stm32ipl_err_t STM32Ipl_Gaussian(image_t *img, uint8_t kSize, bool threshold, bo
 
 #ifdef IPL_FILTER_HAS_MVE
 	/* Try MVE u8 implementation */
-	ret = ipl_gaussian_mve_u8(img, kSize, pascal, threshold, unsharp, mask);
+	ret = ipl_mve_enabled ? ipl_gaussian_mve_u8(dst, kSize, pascal, threshold, unsharp, mask) :
+			stm32ipl_err_NotImplemented;
 	if (ret == stm32ipl_err_Ok) {
+		STM32IPL_PERF_MVE()
 		xfree(pascal);
+		STM32IPL_TRACE_END(Gaussian)
 		return ret;
 	}
+
+	/* The u8 kernel supports Grayscale and RGB888 images, with weights and kernel sizes that fit 8 bits. */
+	if (ret == stm32ipl_err_NotImplemented) {
+		STM32IPL_PERF_SCALAR(Disabled)
+	} else if (ret == stm32ipl_err_OutOfMemory) {
+		STM32IPL_PERF_SCALAR(Memory)
+	} else if ((dst->bpp == IMAGE_BPP_BINARY) || (dst->bpp == IMAGE_BPP_RGB565)) {
+		STM32IPL_PERF_SCALAR(Format)
+	} else {
+		STM32IPL_PERF_SCALAR(Parameter)
+	}
+#else
+	STM32IPL_PERF_SCALAR(NotBuilt)
 #endif
 
 	krn = xalloc0(n * n * sizeof(int));
 	if (!krn) {
 		xfree(pascal);
+		STM32IPL_TRACE_END(Gaussian)
 		return stm32ipl_err_OutOfMemory;
 	}
 
@@ -394,16 +886,19 @@ stm32ipl_err_t STM32Ipl_Gaussian(image_t *img, uint8_t kSize, bool threshold, bo
 		m = -m;
 	}
 
-	imlib_morph(img, kSize, krn, 1.0f / m, 0, threshold, 0, false, (image_t*)mask);
+	imlib_morph(dst, kSize, krn, 1.0f / m, 0, threshold, 0, false, (image_t*)mask);
 
 	xfree(krn);
 
+	STM32IPL_TRACE_END(Gaussian)
 	return ret;
 }
 
 /**
  * @brief Convolves the image by a edge detecting laplacian kernel.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * On MVE targets, Grayscale images are filtered with 16-bit vector arithmetic when no mask is given
+ * (3x3 and 5x5 kernels, except the 5x5 sharpening one).
  * @param img		Image; if it is not valid, an error is returned.
  * @param kSize		Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
  * @param sharpen	If true, this method will instead sharpen the image. Increase the kernel size
@@ -431,12 +926,15 @@ stm32ipl_err_t STM32Ipl_Laplacian(image_t *img, uint8_t kSize, bool sharpen, con
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(Laplacian)
 	k_2 = kSize * 2;
 	n = k_2 + 1;
 
 	pascal = xalloc0(n * sizeof(int));
-	if (!pascal)
+	if (!pascal) {
+		STM32IPL_TRACE_END(Laplacian)
 		return stm32ipl_err_OutOfMemory;
+	}
 
 	pascal[0] = 1;
 
@@ -448,6 +946,7 @@ stm32ipl_err_t STM32Ipl_Laplacian(image_t *img, uint8_t kSize, bool sharpen, con
 	krn = xalloc0(n * n * sizeof(int));
 	if (!krn) {
 		xfree(pascal);
+		STM32IPL_TRACE_END(Laplacian)
 		return stm32ipl_err_OutOfMemory;
 	}
 
@@ -470,16 +969,95 @@ stm32ipl_err_t STM32Ipl_Laplacian(image_t *img, uint8_t kSize, bool sharpen, con
 		krn[((n / 2) * n) + (n / 2)] += m;
 	}
 
+#ifdef IPL_FILTER_HAS_MVE
+	/* Try MVE 16-bit implementation (Grayscale 3x3 and 5x5 kernels). */
+	if (ipl_mve_enabled && !mask && (mve_imlib_edge_u8(img, kSize, krn, NULL, 1.0f / m) == 0)) {
+		STM32IPL_PERF_MVE()
+		xfree(krn);
+		STM32IPL_TRACE_END(Laplacian)
+		return stm32ipl_err_Ok;
+	}
+
+	IPL_PERF_EDGE_FALLBACK(img, mask)
+#else
+	STM32IPL_PERF_SCALAR(NotBuilt)
+#endif
+
 	imlib_morph(img, kSize, krn, 1.0f / m, 0, false, 0, false, (image_t*)mask);
 
 	xfree(krn);
 
+	STM32IPL_TRACE_END(Laplacian)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Same as STM32Ipl_Laplacian(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Laplacian().
+ * @param sharpen		See STM32Ipl_Laplacian().
+ * @param mask			Optional mask; see STM32Ipl_Laplacian().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LaplacianEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
+
+	return STM32Ipl_Laplacian(dst, kSize, sharpen, mask);
+}
+
+/*
+ * @brief Fills the second kernel of STM32Ipl_Sobel(), that differentiates along the horizontal direction.
+ * @param pascal	Row of the Pascal's triangle.
+ * @param n			Kernel width.
+ * @param m			Weight of the first kernel.
+ * @param sharpen	Sharpen mode.
+ * @param krn		Kernel.
+ * @return			void.
+ */
+static void ipl_sobel_kernel_y(const int *pascal, int n, int m, bool sharpen, int *krn)
+{
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			int temp = pascal[i] * pascal[j];
+			if (j < (n - 1) / 2)
+				krn[(i * n) + j] = -temp;
+			else
+				if (j > (n - 1) / 2)
+					krn[(i * n) + j] = temp;
+				else
+					krn[(i * n) + j] = 0;
+		}
+	}
+
+	if (sharpen) {
+		krn[((n / 2) * n) + (n / 2)] += m % 2 ? m / 2 : (m / 2) + 1;
+	}
+}
+
 /**
  * @brief Convolves the image by a edge detecting Sobel kernel.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * On MVE targets, Grayscale images are filtered with 16-bit vector arithmetic when no mask is given
+ * (3x3 and 5x5 kernels), and both the derivatives are computed in one pass.
  * @param img		Image; if it is not valid, an error is returned.
  * @param kSize		Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
  * @param sharpen	If true, this method will instead sharpen the image. Increase the kernel size
@@ -510,11 +1088,13 @@ stm32ipl_err_t STM32Ipl_Sobel(image_t *img, uint8_t kSize, bool sharpen, const i
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(Sobel)
 	k_2 = kSize * 2;
 	n = k_2 + 1;
 
 	pascal = xalloc(n * sizeof(int));
 	if (!pascal) {
+		STM32IPL_TRACE_END(Sobel)
 		return stm32ipl_err_OutOfMemory;
 	}
 	pascal[0] = 1;
@@ -527,6 +1107,7 @@ stm32ipl_err_t STM32Ipl_Sobel(image_t *img, uint8_t kSize, bool sharpen, const i
 	krn = xalloc(n * n * sizeof(int));
 	if (!krn) {
 		xfree(pascal);
+		STM32IPL_TRACE_END(Sobel)
 		return stm32ipl_err_OutOfMemory;
 	}
 
@@ -561,10 +1142,40 @@ stm32ipl_err_t STM32Ipl_Sobel(image_t *img, uint8_t kSize, bool sharpen, const i
 
 	mul = 1.0f / m;
 
+#ifdef IPL_FILTER_HAS_MVE
+	/* Try MVE 16-bit implementation (Grayscale 3x3 and 5x5 kernels), that applies both kernels in one pass. */
+	if (ipl_mve_enabled && !mask) {
+		int *krnY = xalloc(n * n * sizeof(int));
+
+		if (krnY) {
+			ipl_sobel_kernel_y(pascal, n, m, sharpen, krnY);
+
+			if (mve_imlib_edge_u8(img, kSize, krn, krnY, mul) == 0) {
+				STM32IPL_PERF_MVE()
+				xfree(krnY);
+				xfree(pascal);
+				xfree(krn);
+				STM32IPL_TRACE_END(Sobel)
+				return stm32ipl_err_Ok;
+			}
+
+			xfree(krnY);
+			IPL_PERF_EDGE_FALLBACK(img, mask)
+		} else {
+			STM32IPL_PERF_SCALAR(Memory)
+		}
+	} else {
+		IPL_PERF_EDGE_FALLBACK(img, mask)
+	}
+#else
+	STM32IPL_PERF_SCALAR(NotBuilt)
+#endif
+
 	sobel_x.data = xalloc(STM32Ipl_ImageDataSize(img));
 	if (!sobel_x.data) {
 		xfree(pascal);
 		xfree(krn);
+		STM32IPL_TRACE_END(Sobel)
 		return stm32ipl_err_OutOfMemory;
 	}
 
@@ -575,50 +1186,72 @@ stm32ipl_err_t STM32Ipl_Sobel(image_t *img, uint8_t kSize, bool sharpen, const i
 		xfree(pascal);
 		xfree(krn);
 		xfree(sobel_x.data);
+		STM32IPL_TRACE_END(Sobel)
 		return stm32ipl_err_OutOfMemory;
 	}
 
 	STM32Ipl_Init(&sobel_y, img->w, img->h, (image_bpp_t)img->bpp, (void*)sobel_y.data);
 
-	memcpy(sobel_x.data, img->data, STM32Ipl_ImageDataSize(img));
-	memcpy(sobel_y.data, img->data, STM32Ipl_ImageDataSize(img));
+	image_copy_data(&sobel_x, img);
+	image_copy_data(&sobel_y, img);
 
 	imlib_morph(&sobel_x, kSize, krn, mul, 0, false, 0, false, (image_t*)mask);
 
-	for (int i = 0; i < n; i++) {
-		for (int j = 0; j < n; j++) {
-			int temp = pascal[i] * pascal[j];
-			if (j < (n - 1) / 2)
-				krn[(i * n) + j] = -temp;
-			else
-				if (j > (n - 1) / 2)
-					krn[(i * n) + j] = temp;
-				else
-					krn[(i * n) + j] = 0;
-		}
-	}
-
-	if (sharpen) {
-		krn[((n / 2) * n) + (n / 2)] += m % 2 ? m / 2 : (m / 2) + 1;
-	}
+	ipl_sobel_kernel_y(pascal, n, m, sharpen, krn);
 
 	imlib_morph(&sobel_y, kSize, krn, mul, 0, false, 0, false, (image_t*)mask);
 
 	STM32Ipl_Add(&sobel_x, &sobel_y, 1, NULL);
 
-	xfree(img->data);
-	STM32Ipl_Init(img, img->w, img->h, (image_bpp_t)sobel_x.bpp, (void*)sobel_x.data);
+	/* The result is copied back, as the image buffer is owned by the caller (it can also be a view). */
+	image_copy_data(img, &sobel_x);
 
+	xfree(sobel_x.data);
 	xfree(sobel_y.data);
 	xfree(pascal);
 	xfree(krn);
 
+	STM32IPL_TRACE_END(Sobel)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Same as STM32Ipl_Sobel(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Sobel().
+ * @param sharpen		See STM32Ipl_Sobel().
+ * @param mask			Optional mask; see STM32Ipl_Sobel().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_SobelEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
+
+	return STM32Ipl_Sobel(dst, kSize, sharpen, mask);
+}
+
 /**
  * @brief Convolves the image by a edge detecting Scharr kernel.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * On MVE targets, Grayscale images are filtered with 16-bit vector arithmetic when no mask is given,
+ * and both the derivatives are computed in one pass.
  * @param img		Image; if it is not valid, an error is returned.
  * @param kSize		Kernel size; currently only kSize = 1 is allowed, corresponding to a 3x3 kernel.
  * @param sharpen	If true, this method will instead sharpen the image. Increase the kernel size
@@ -648,15 +1281,19 @@ stm32ipl_err_t STM32Ipl_Scharr(image_t *img, uint8_t kSize, bool sharpen, const
 		STM32IPL_CHECK_SAME_SIZE(img, mask)
 	}
 
+	STM32IPL_TRACE_BEGIN(Scharr)
 	k_2 = kSize * 2;
 
-	if (k_2 != 2)
+	if (k_2 != 2) {
+		STM32IPL_TRACE_END(Scharr)
 		return stm32ipl_err_NotImplemented;
+	}
 
 	n = k_2 + 1;
 
 	krn = xalloc(n * n * sizeof(int));
 	if (krn == NULL) {
+		STM32IPL_TRACE_END(Scharr)
 		return stm32ipl_err_OutOfMemory;
 	}
 
@@ -681,6 +1318,7 @@ stm32ipl_err_t STM32Ipl_Scharr(image_t *img, uint8_t kSize, bool sharpen, const
 	scharr_x.data = xalloc(STM32Ipl_ImageDataSize(img));
 	if (!scharr_x.data) {
 		xfree(krn);
+		STM32IPL_TRACE_END(Scharr)
 		return stm32ipl_err_OutOfMemory;
 	}
 	STM32Ipl_Init(&scharr_x, img->w, img->h, (image_bpp_t)img->bpp, (void*)scharr_x.data);
@@ -689,17 +1327,38 @@ stm32ipl_err_t STM32Ipl_Scharr(image_t *img, uint8_t kSize, bool sharpen, const
 	if (!scharr_y.data) {
 		xfree(krn);
 		xfree(scharr_x.data);
+		STM32IPL_TRACE_END(Scharr)
 		return stm32ipl_err_OutOfMemory;
 	}
 	STM32Ipl_Init(&scharr_y, img->w, img->h, (image_bpp_t)img->bpp, (void*)scharr_y.data);
 
-	memcpy(scharr_x.data, img->data, STM32Ipl_ImageDataSize(img));
-	memcpy(scharr_y.data, img->data, STM32Ipl_ImageDataSize(img));
+	image_copy_data(&scharr_x, img);
+	image_copy_data(&scharr_y, img);
 
 	if (sharpen) {
 		krn[((n / 2) * n) + (n / 2)] += m / 2;
 	}
 
+#ifdef IPL_FILTER_HAS_MVE
+	/* Try MVE 16-bit implementation (Grayscale images), that applies both kernels in one pass. */
+	if (ipl_mve_enabled && !mask) {
+		static const int krnY[9] = { -3, 0, 3, -10, 0, 10, -3, 0, 3 };
+
+		if (mve_imlib_edge_u8(img, kSize, krn, krnY, mul) == 0) {
+			STM32IPL_PERF_MVE()
+			xfree(scharr_x.data);
+			xfree(scharr_y.data);
+			xfree(krn);
+			STM32IPL_TRACE_END(Scharr)
+			return stm32ipl_err_Ok;
+		}
+	}
+
+	IPL_PERF_EDGE_FALLBACK(img, mask)
+#else
+	STM32IPL_PERF_SCALAR(NotBuilt)
+#endif
+
 	imlib_morph(&scharr_x, kSize, krn, mul, 0, false, 0, false, (image_t*)mask);
 
 	krn[0] = -3;
@@ -716,12 +1375,171 @@ stm32ipl_err_t STM32Ipl_Scharr(image_t *img, uint8_t kSize, bool sharpen, const
 
 	STM32Ipl_Add(&scharr_x, &scharr_y, 1, NULL);
 
-	xfree(img->data);
-	STM32Ipl_Init(img, img->w, img->h, (image_bpp_t)scharr_x.bpp, (void*)scharr_x.data);
+	/* The result is copied back, as the image buffer is owned by the caller (it can also be a view). */
+	image_copy_data(img, &scharr_x);
 
+	xfree(scharr_x.data);
 	xfree(scharr_y.data);
 	xfree(krn);
 
+	STM32IPL_TRACE_END(Scharr)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Same as STM32Ipl_Scharr(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The source image is copied to the destination image, that is then processed in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Scharr().
+ * @param sharpen		See STM32Ipl_Scharr().
+ * @param mask			Optional mask; see STM32Ipl_Scharr().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ScharrEx(const image_t *src, image_t *dst, uint8_t kSize, bool sharpen, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
+	}
+
+	if (dst->data != src->data)
+		image_copy_data(dst, (image_t*)src);
+
+	return STM32Ipl_Scharr(dst, kSize, sharpen, mask);
+}
+
+///@cond
+/* Computes the gradient at the given pixel with the separable Sobel kernel whose coefficients are given;
+ * the borders are replicated. */
+static void ipl_gradient_pixel(const uint8_t **rows, int w, int x, int ksize, const int32_t *coef, uint16_t *mag,
+		uint8_t *dir)
+{
+	int n = (ksize * 2) + 1;
+	int gx = 0;
+	int gy = 0;
+
+	for (int j = 0; j < n; j++) {
+		int smooth = 0;
+		int deriv = 0;
+
+		for (int k = 0; k < n; k++) {
+			int pixel = rows[j][IM_MIN(IM_MAX(x - ksize + k, 0), w - 1)];
+
+			smooth += pixel * coef[k];
+			if (k != ksize)
+				deriv += pixel * ((k < ksize) ? -coef[k] : coef[k]);
+		}
+
+		gx += deriv * coef[j];
+		if (j != ksize)
+			gy += smooth * ((j < ksize) ? -coef[j] : coef[j]);
+	}
+
+	int ax = abs(gx);
+	int ay = abs(gy);
+
+	if (mag)
+		mag[x] = ax + ay;
+
+	if (dir) {
+		/* tan(22.5) and tan(67.5) in Q16, as in the MVE implementation. */
+		int t22 = (ax * 27146) >> 16;
+		int t67 = (2 * ax) + t22;
+
+		if (ay <= t22)
+			dir[x] = stm32ipl_gradient_dir_0;
+		else
+			if (ay >= t67)
+				dir[x] = stm32ipl_gradient_dir_90;
+			else
+				dir[x] = ((gx ^ gy) >= 0) ? stm32ipl_gradient_dir_45 : stm32ipl_gradient_dir_135;
+	}
+}
+
+/* Gradient of the pixels x0 ... x1 - 1 of a Grayscale line of width w, whose rows rows[0] ... rows[2 * ksize] are
+ * centered on it (the borders are replicated); mag[x] and dir[x] receive the results of the pixel x, when not NULL.
+ * On MVE targets, the pixels far enough from the borders are computed with vector arithmetic. */
+void ipl_gradient_line(const uint8_t **rows, int w, int x0, int x1, int ksize, const int32_t *coef, uint16_t *mag,
+		uint8_t *dir)
+{
+	int v0 = x1;
+	int v1 = x1;
+
+#ifdef IPL_FILTER_HAS_MVE
+	v0 = IM_MAX(x0, ksize);
+	v1 = IM_MIN(x1, w - ksize);
+
+	if (v0 < v1)
+		mve_imlib_gradient_u8(rows, v0, v1, ksize, coef, mag, dir);
+	else
+		v0 = v1 = x1;
+#endif
+
+	for (int x = x0; x < v0; x++)
+		ipl_gradient_pixel(rows, w, x, ksize, coef, mag, dir);
+
+	for (int x = v1; x < x1; x++)
+		ipl_gradient_pixel(rows, w, x, ksize, coef, mag, dir);
+}
+///@endcond
+
+/**
+ * @brief Computes the gradient of the source image with the kernels of STM32Ipl_Sobel(), without modifying it:
+ * for each pixel, the magnitude (sum of the absolute values of the horizontal and vertical derivatives) and/or the
+ * direction (quantized to four sectors, see stm32ipl_gradient_dir_t), as done by the first stage of the Canny edge
+ * detector. The image borders are replicated. On MVE targets, the inner part of each row is computed with 16-bit vector
+ * arithmetic. The supported format is Grayscale.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param kSize		Kernel size; use 1 (3x3 kernel) or 2 (5x5 kernel), otherwise an error is returned.
+ * @param mag		Optional buffer of src->w * src->h elements that receives the magnitude of the gradient;
+ * the maximum value is 2040 with a 3x3 kernel, 40800 with a 5x5 kernel.
+ * @param dir		Optional buffer of src->w * src->h elements that receives the direction of the gradient
+ * (stm32ipl_gradient_dir_t values); at least one of mag and dir must be valid, otherwise an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Gradient(const image_t *src, uint8_t kSize, uint16_t *mag, uint8_t *dir)
+{
+	const uint8_t *rows[5];
+	int32_t coef[5];
+	int n;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, stm32ipl_if_grayscale)
+
+	if ((kSize < 1) || (kSize > 2) || (!mag && !dir))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(Gradient)
+
+	n = (kSize * 2) + 1;
+
+	/* Row of the Pascal's triangle. */
+	coef[0] = 1;
+	for (int i = 1; i < n; i++)
+		coef[i] = (coef[i - 1] * (n - i)) / i;
+
+	for (int y = 0; y < src->h; y++) {
+		uint16_t *magRow = mag ? (mag + (y * src->w)) : NULL;
+		uint8_t *dirRow = dir ? (dir + (y * src->w)) : NULL;
+
+		for (int j = 0; j < n; j++)
+			rows[j] = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, IM_MIN(IM_MAX(y - kSize + j, 0), src->h - 1));
+
+		ipl_gradient_line(rows, src->w, 0, src->w, kSize, coef, magRow, dirRow);
+	}
+
+	STM32IPL_TRACE_END(Gradient)
+
 	return stm32ipl_err_Ok;
 }
 
@@ -753,8 +1571,10 @@ stm32ipl_err_t STM32Ipl_MidpointPool(const image_t *src, image_t *dst, uint16_t
 	if (bias > 256)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(MidpointPool)
 	imlib_midpoint_pool((image_t*)src, dst, xDiv, yDiv, bias);
 
+	STM32IPL_TRACE_END(MidpointPool)
 	return stm32ipl_err_Ok;
 }
 
@@ -783,11 +1603,121 @@ stm32ipl_err_t STM32Ipl_MeanPool(const image_t *src, image_t *dst, uint16_t xDiv
 	if (((src->w / xDiv) != dst->w) || ((src->h / yDiv) != dst->h))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(MeanPool)
 	imlib_mean_pool((image_t*)src, dst, xDiv, yDiv);
 
+	STM32IPL_TRACE_END(MeanPool)
 	return stm32ipl_err_Ok;
 }
 
+///@cond
+/* Arguments of the filters executed on a ROI through STM32Ipl_TiledRoi(). */
+typedef struct _ipl_filter_roi_arg_t
+{
+	uint8_t kSize;
+	bool threshold;
+	bool unsharp;
+	float percentile;
+	int32_t offset;
+	bool invert;
+	const int32_t *krn;
+	float mul;
+	int32_t add;
+} ipl_filter_roi_arg_t;
+
+static stm32ipl_err_t ipl_gaussian_roi_op(image_t *tile, void *arg)
+{
+	const ipl_filter_roi_arg_t *a = (const ipl_filter_roi_arg_t*)arg;
+
+	return STM32Ipl_Gaussian(tile, a->kSize, a->threshold, a->unsharp, NULL);
+}
+
+static stm32ipl_err_t ipl_median_roi_op(image_t *tile, void *arg)
+{
+	const ipl_filter_roi_arg_t *a = (const ipl_filter_roi_arg_t*)arg;
+
+	return STM32Ipl_MedianFilter(tile, a->kSize, a->percentile, a->threshold, a->offset, a->invert, NULL);
+}
+
+static stm32ipl_err_t ipl_morph_roi_op(image_t *tile, void *arg)
+{
+	const ipl_filter_roi_arg_t *a = (const ipl_filter_roi_arg_t*)arg;
+
+	return STM32Ipl_Morph(tile, a->kSize, a->krn, a->mul, a->add, a->threshold, a->offset, a->invert, NULL);
+}
+///@endcond
+
+/**
+ * @brief Same as STM32Ipl_Gaussian() (without mask), but only the pixels of the given region of interest are
+ * processed; the pixels around it are used at its borders, so the ROI gets the same result of the whole image
+ * processing, while the other pixels are not modified (see STM32Ipl_TiledRoi()).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param roi		Region of interest; it must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param kSize		Kernel size; see STM32Ipl_Gaussian().
+ * @param threshold	See STM32Ipl_Gaussian().
+ * @param unsharp	See STM32Ipl_Gaussian().
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GaussianRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, bool threshold,
+		bool unsharp)
+{
+	ipl_filter_roi_arg_t arg = { .kSize = kSize, .threshold = threshold, .unsharp = unsharp };
+
+	return STM32Ipl_TiledRoi(img, img, roi, kSize, ipl_gaussian_roi_op, &arg);
+}
+
+/**
+ * @brief Same as STM32Ipl_MedianFilter() (without mask), but only the pixels of the given region of interest are
+ * processed; the pixels around it are used at its borders, so the ROI gets the same result of the whole image
+ * processing, while the other pixels are not modified (see STM32Ipl_TiledRoi()).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param roi			Region of interest; it must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param kSize			Kernel size; see STM32Ipl_MedianFilter().
+ * @param percentile	See STM32Ipl_MedianFilter().
+ * @param threshold		See STM32Ipl_MedianFilter().
+ * @param offset		See STM32Ipl_MedianFilter().
+ * @param invert		See STM32Ipl_MedianFilter().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MedianFilterRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, float percentile,
+		bool threshold, int32_t offset, bool invert)
+{
+	ipl_filter_roi_arg_t arg = { .kSize = kSize, .percentile = percentile, .threshold = threshold, .offset = offset,
+			.invert = invert };
+
+	return STM32Ipl_TiledRoi(img, img, roi, kSize, ipl_median_roi_op, &arg);
+}
+
+/**
+ * @brief Same as STM32Ipl_Morph() (without mask), but only the pixels of the given region of interest are
+ * processed; the pixels around it are used at its borders, so the ROI gets the same result of the whole image
+ * processing, while the other pixels are not modified (see STM32Ipl_TiledRoi()).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param roi		Region of interest; it must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param kSize		Kernel size; see STM32Ipl_Morph().
+ * @param krn		Kernel; see STM32Ipl_Morph().
+ * @param mul		See STM32Ipl_Morph().
+ * @param add		See STM32Ipl_Morph().
+ * @param threshold	See STM32Ipl_Morph().
+ * @param offset	See STM32Ipl_Morph().
+ * @param invert	See STM32Ipl_Morph().
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MorphRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, const int32_t *krn, float mul,
+		int32_t add, bool threshold, int32_t offset, bool invert)
+{
+	ipl_filter_roi_arg_t arg = { .kSize = kSize, .krn = krn, .mul = mul, .add = add, .threshold = threshold,
+			.offset = offset, .invert = invert };
+
+	return STM32Ipl_TiledRoi(img, img, roi, kSize, ipl_morph_roi_op, &arg);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -71,339 +71,225 @@ stm32ipl_err_t STM32Ipl_GetPixel(const image_t *img, uint16_t x, uint16_t y, stm
 	return stm32ipl_err_Ok;
 }
 
-/**
- * @brief Finds minimum and maximum point locations in an image. For RGB images, the Y value is considered.
- * The supported formats are Binary, Grayscale, RGB565, RGB888.
- * @param img		Image; if it is not valid, an error is returned.
- * @param outMin	List of point_t elements that represents the coordinates of the minimum values;
- * if it is not valid, an error is returned.
- * @param outMax	List of point_t elements that represents the coordinates of maximum values;
- * if it is not valid, an error is returned.
- * @param roi		Optional region of interest of the source image where the functions operates;
- * when defined, it must be contained in the source image and have positive dimensions, otherwise
- * an error is returned; when not defined, the whole image is considered.
- * @return			stm32ipl_err_Ok on success, error otherwise.
- */
-stm32ipl_err_t STM32Ipl_FindMinMaxLoc(const image_t *img, list_t *outMin, list_t *outMax, const rectangle_t *roi)
+///@cond
+/* Destination of the locations found by ipl_find_min_max_loc(): a list, or an array of the first size ones. */
+typedef struct _ipl_loc_out_t
+{
+	list_t *list;	/* List of point_t, when not null. */
+	point_t *loc;	/* Array of size point_t, used when list is null. */
+	uint32_t size;
+	uint32_t count;	/* Number of locations found, also the ones beyond size. */
+} ipl_loc_out_t;
+
+/* Returns false when the location cannot be added to the list. */
+static bool ipl_loc_add(ipl_loc_out_t *out, int x, int y)
 {
-	rectangle_t realRoi;
 	point_t p;
-	uint32_t max;
-	uint32_t min;
-	uint32_t i;
-	uint32_t j;
 
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
-	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
-
-	if (!outMin || !outMax)
-		return stm32ipl_err_InvalidParameter;
-
-	max = 0;
-	min = 0xFFFFFFFF;
-	i = 0;
-	j = 0;
+	p.x = x;
+	p.y = y;
+
+	if (out->list) {
+		size_t size = list_size(out->list);
+		list_push_back(out->list, &p);
+		if (list_size(out->list) == size)
+			return false;
+	} else
+		if (out->count < out->size) {
+			out->loc[out->count] = p;
+		}
 
-	p.x = realRoi.x;
-	p.y = realRoi.y;
+	out->count++;
 
-	list_push_front(outMin, &p);
-	list_push_front(outMax, &p);
+	return true;
+}
 
+/* Returns the values of the pixels of the ROI in row y: the Grayscale ones, or the ones of the other formats (Y for
+ * RGB images) converted into line. */
+static const uint8_t* ipl_min_max_row(const image_t *img, const rectangle_t *roi, int y, uint8_t *line)
+{
 	switch (img->bpp) {
 		case IMAGE_BPP_BINARY: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					uint32_t value = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
-					if (value < min) {
-						min = value;
-						list_clear(outMin);
-						i = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMin, &p, i);
-
-						if (outMin->size == i) {
-							list_clear(outMin);
-							list_clear(outMax);
-							return stm32ipl_err_OutOfMemory;
-						}
-
-						i++;
-					} else
-						if (value == min) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMin, &p, i);
-
-							if (outMin->size == i) {
-								list_clear(outMin);
-								list_clear(outMax);
-								return stm32ipl_err_OutOfMemory;
-							}
-
-							i++;
-						}
-
-					if (value > max) {
-						max = value;
-						list_clear(outMax);
-						j = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMax, &p, j);
-
-						if (outMax->size == j) {
-							list_clear(outMax);
-							list_clear(outMin);
-							return stm32ipl_err_OutOfMemory;
-						}
-
-						j++;
-
-					} else
-						if (value == max) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMax, &p, j);
-
-							if (outMax->size == j) {
-								list_clear(outMax);
-								list_clear(outMin);
-								return stm32ipl_err_OutOfMemory;
-							}
-
-							j++;
-
-						}
-				}
-			}
-			break;
+			uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < roi->w; x++)
+				line[x] = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, roi->x + x);
+			return line;
 		}
 
-		case IMAGE_BPP_GRAYSCALE: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					uint8_t value = IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x);
-
-					if (value < min) {
-						min = value;
-						list_clear(outMin);
-						i = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMin, &p, i);
-
-						if (outMin->size == i) {
-							list_clear(outMin);
-							list_clear(outMax);
-							return stm32ipl_err_OutOfMemory;
-						}
+		case IMAGE_BPP_RGB565: {
+			uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < roi->w; x++)
+				line[x] = COLOR_RGB565_TO_GRAYSCALE(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, roi->x + x));
+			return line;
+		}
 
-						i++;
-					} else
-						if (value == min) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMin, &p, i);
-
-							if (outMin->size == i) {
-								list_clear(outMin);
-								list_clear(outMax);
-								return stm32ipl_err_OutOfMemory;
-							}
-
-							i++;
-						}
+		case IMAGE_BPP_RGB888: {
+			rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
+			for (int x = 0; x < roi->w; x++)
+				line[x] = COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, roi->x + x));
+			return line;
+		}
 
-					if (value > max) {
-						max = value;
-						list_clear(outMax);
-						j = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMax, &p, j);
+		default:
+			return IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y) + roi->x;
+	}
+}
 
-						if (outMax->size == j) {
-							list_clear(outMax);
-							list_clear(outMin);
-							return stm32ipl_err_OutOfMemory;
-						}
+/* Finds the min and max values of the ROI (first pass, a reduction by rows), then their locations (second pass, that
+ * skips the pixels with other values a vector at a time with MVE). When all is false, the second pass stops as soon
+ * as both arrays are full. */
+static stm32ipl_err_t ipl_find_min_max_loc(const image_t *img, const rectangle_t *roi, uint8_t *min, uint8_t *max,
+		ipl_loc_out_t *minOut, ipl_loc_out_t *maxOut, bool all)
+{
+	stm32ipl_err_t error = stm32ipl_err_Ok;
+	uint8_t *line = NULL;
+	uint8_t minValue = 0xFF;
+	uint8_t maxValue = 0;
+
+	if (img->bpp != IMAGE_BPP_GRAYSCALE) {
+		if (fb_avail() < FB_ALLOC_SPACE(roi->w))
+			return stm32ipl_err_OutOfMemory;
+		line = fb_alloc(roi->w, FB_ALLOC_PREFER_SPEED);
+	}
 
-						j++;
-					} else
-						if (value == max) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMax, &p, j);
+	for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++)
+		imlib_grayscale_row_min_max(ipl_min_max_row(img, roi, y, line), roi->w, &minValue, &maxValue);
 
-							if (outMax->size == j) {
-								list_clear(outMax);
-								list_clear(outMin);
-								return stm32ipl_err_OutOfMemory;
-							}
+	for (int y = roi->y, yy = roi->y + roi->h; (y < yy) && (error == stm32ipl_err_Ok); y++) {
+		const uint8_t *row = ipl_min_max_row(img, roi, y, line);
 
-							j++;
-						}
-				}
+		for (int x = imlib_grayscale_find_value(row, 0, roi->w, minValue); x < roi->w;
+				x = imlib_grayscale_find_value(row, x + 1, roi->w, minValue)) {
+			if (!ipl_loc_add(minOut, roi->x + x, y)) {
+				error = stm32ipl_err_OutOfMemory;
+				break;
 			}
-			break;
 		}
 
-		case IMAGE_BPP_RGB565: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					uint8_t value = COLOR_RGB565_TO_GRAYSCALE(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x));
-					if (value < min) {
-						min = value;
-						list_clear(outMin);
-						i = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMin, &p, i);
-
-						if (outMin->size == i) {
-							list_clear(outMin);
-							list_clear(outMax);
-							return stm32ipl_err_OutOfMemory;
-						}
+		for (int x = imlib_grayscale_find_value(row, 0, roi->w, maxValue); (x < roi->w) && (error == stm32ipl_err_Ok);
+				x = imlib_grayscale_find_value(row, x + 1, roi->w, maxValue)) {
+			if (!ipl_loc_add(maxOut, roi->x + x, y))
+				error = stm32ipl_err_OutOfMemory;
+		}
 
-						i++;
-					} else
-						if (value == min) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMin, &p, i);
-
-							if (outMin->size == i) {
-								list_clear(outMin);
-								list_clear(outMax);
-								return stm32ipl_err_OutOfMemory;
-							}
-
-							i++;
-						}
+		if (!all && (minOut->count >= minOut->size) && (maxOut->count >= maxOut->size))
+			break;
+	}
 
-					if (value > max) {
-						max = value;
-						list_clear(outMax);
-						j = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMax, &p, j);
+	if (line)
+		fb_free();
 
-						if (outMax->size == j) {
-							list_clear(outMax);
-							list_clear(outMin);
-							return stm32ipl_err_OutOfMemory;
-						}
+	*min = minValue;
+	*max = maxValue;
 
-						j++;
-					} else
-						if (value == max) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMax, &p, j);
+	return error;
+}
+///@endcond
 
-							if (outMax->size == j) {
-								list_clear(outMax);
-								list_clear(outMin);
-								return stm32ipl_err_OutOfMemory;
-							}
+/**
+ * @brief Finds minimum and maximum point locations in an image. For RGB images, the Y value is considered.
+ * The min and max values are found first, by rows (with MVE, a vector reduction per row); then their locations
+ * are searched, skipping the pixels with other values (with MVE, a vector at a time).
+ * To get only the first locations, without a list node for each one, use STM32Ipl_FindMinMaxLocEx().
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param outMin	List of point_t elements that represents the coordinates of the minimum values, by rows;
+ * if it is not valid, an error is returned. The list is cleared first.
+ * @param outMax	List of point_t elements that represents the coordinates of maximum values, by rows;
+ * if it is not valid, an error is returned. The list is cleared first.
+ * @param roi		Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindMinMaxLoc(const image_t *img, list_t *outMin, list_t *outMax, const rectangle_t *roi)
+{
+	rectangle_t realRoi;
+	ipl_loc_out_t minOut = { outMin, NULL, 0, 0 };
+	ipl_loc_out_t maxOut = { outMax, NULL, 0, 0 };
+	uint8_t min;
+	uint8_t max;
+	stm32ipl_err_t error;
 
-							j++;
-						}
-				}
-			}
-			break;
-		}
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
 
-		case IMAGE_BPP_RGB888: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					uint8_t value = COLOR_RGB888_TO_GRAYSCALE(IMAGE_GET_RGB888_PIXEL_FAST(row_ptr, x));
-					if (value < min) {
-						min = value;
-						list_clear(outMin);
-						i = 0;
-						p.x = x;
-						p.y = y;
-						list_insert(outMin, &p, i);
+	if (!outMin || !outMax)
+		return stm32ipl_err_InvalidParameter;
 
-						if (outMin->size == i) {
-							list_clear(outMin);
-							list_clear(outMax);
-							return stm32ipl_err_OutOfMemory;
-						}
+	STM32IPL_TRACE_BEGIN(FindMinMaxLoc)
 
-						i++;
-					} else {
-						if (value == min) {
-							p.x = x;
-							p.y = y;
-							list_insert(outMin, &p, i);
-
-							if (outMin->size == i) {
-								list_clear(outMin);
-								list_clear(outMax);
-								return stm32ipl_err_OutOfMemory;
-							}
-
-							i++;
-						}
+	list_clear(outMin);
+	list_clear(outMax);
 
-						if (value > max) {
-							max = value;
-							list_clear(outMax);
-							j = 0;
-							p.x = x;
-							p.y = y;
-							list_insert(outMax, &p, j);
+	error = ipl_find_min_max_loc(img, &realRoi, &min, &max, &minOut, &maxOut, true);
+	if (error != stm32ipl_err_Ok) {
+		list_clear(outMin);
+		list_clear(outMax);
+	}
 
-							if (outMax->size == j) {
-								list_clear(outMax);
-								list_clear(outMin);
-								return stm32ipl_err_OutOfMemory;
-							}
+	STM32IPL_TRACE_END(FindMinMaxLoc)
+	return error;
+}
 
-							j++;
+/**
+ * @brief Finds minimum and maximum values of an image and the first locations (by rows) of each of them, written to
+ * arrays provided by the caller: no memory is allocated for the locations, and the search stops as soon as both
+ * arrays are full, unless the total numbers of locations are requested. For RGB images, the Y value is considered.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param min		Optional minimum value.
+ * @param max		Optional maximum value.
+ * @param minLoc	Optional array of size elements, that receives the first locations of the minimum value.
+ * @param minCount	Optional total number of locations of the minimum value; it can be larger than size.
+ * @param maxLoc	Optional array of size elements, that receives the first locations of the maximum value.
+ * @param maxCount	Optional total number of locations of the maximum value; it can be larger than size.
+ * @param size		Number of elements of the location arrays.
+ * @param roi		Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindMinMaxLocEx(const image_t *img, uint32_t *min, uint32_t *max, point_t *minLoc,
+		uint32_t *minCount, point_t *maxLoc, uint32_t *maxCount, uint32_t size, const rectangle_t *roi)
+{
+	rectangle_t realRoi;
+	ipl_loc_out_t minOut = { NULL, minLoc, minLoc ? size : 0, 0 };
+	ipl_loc_out_t maxOut = { NULL, maxLoc, maxLoc ? size : 0, 0 };
+	uint8_t minValue;
+	uint8_t maxValue;
+	stm32ipl_err_t error;
 
-						} else
-							if (value == max) {
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
 
-								p.x = x;
-								p.y = y;
-								list_insert(outMax, &p, j);
+	STM32IPL_TRACE_BEGIN(FindMinMaxLoc)
 
-								if (outMax->size == j) {
-									list_clear(outMax);
-									list_clear(outMin);
-									return stm32ipl_err_OutOfMemory;
-								}
+	error = ipl_find_min_max_loc(img, &realRoi, &minValue, &maxValue, &minOut, &maxOut, minCount || maxCount);
+	if (error == stm32ipl_err_Ok) {
+		if (min)
+			*min = minValue;
 
-								j++;
+		if (max)
+			*max = maxValue;
 
-							}
-					}
-				}
-			}
-			break;
-		}
+		if (minCount)
+			*minCount = minOut.count;
 
-		default:
-			return stm32ipl_err_InvalidParameter;
+		if (maxCount)
+			*maxCount = maxOut.count;
 	}
 
-	return stm32ipl_err_Ok;
+	STM32IPL_TRACE_END(FindMinMaxLoc)
+	return error;
 }
 
 /**
- * @brief Finds the locations of non zero pixels in an image.
+ * @brief Finds the locations of non zero pixels in an image. With Binary images, the words (32 pixels) with
+ * no pixel set are skipped at once; with Grayscale images, the runs of zero pixels are skipped 4 (16 with MVE)
+ * pixels at a time.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img		Image; if it is not valid, an error is returned.
  * @param out		List of point_t elements that represents the coordinates of the non zero pixels;
@@ -426,25 +312,27 @@ stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const re
 	if (!out)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(FindNonZeroLoc)
 	i = 0;
 
 	switch (img->bpp) {
 		case IMAGE_BPP_BINARY: {
 			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
 				uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					if (IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x) > 0) {
-						p.x = x;
-						p.y = y;
-						list_insert(out, &p, i);
-
-						if (out->size == i) {
-							list_clear(out);
-							return stm32ipl_err_OutOfMemory;
-						}
-
-						i++;
+				int xx = realRoi.x + realRoi.w;
+				for (int x = imlib_binary_find_nonzero(row_ptr, realRoi.x, xx); x < xx;
+						x = imlib_binary_find_nonzero(row_ptr, x + 1, xx)) {
+					p.x = x;
+					p.y = y;
+					list_insert(out, &p, i);
+
+					if (out->size == i) {
+						list_clear(out);
+						STM32IPL_TRACE_END(FindNonZeroLoc)
+						return stm32ipl_err_OutOfMemory;
 					}
+
+					i++;
 				}
 			}
 			break;
@@ -453,20 +341,21 @@ stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const re
 		case IMAGE_BPP_GRAYSCALE: {
 			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
 				uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					if (IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x) > 0) {
-						p.x = x;
-						p.y = y;
-
-						list_insert(out, &p, i);
-
-						if (out->size == i) {
-							list_clear(out);
-							return stm32ipl_err_OutOfMemory;
-						}
-
-						i++;
+				int xx = realRoi.x + realRoi.w;
+				for (int x = imlib_grayscale_find_nonzero(row_ptr, realRoi.x, xx); x < xx;
+						x = imlib_grayscale_find_nonzero(row_ptr, x + 1, xx)) {
+					p.x = x;
+					p.y = y;
+
+					list_insert(out, &p, i);
+
+					if (out->size == i) {
+						list_clear(out);
+						STM32IPL_TRACE_END(FindNonZeroLoc)
+						return stm32ipl_err_OutOfMemory;
 					}
+
+					i++;
 				}
 			}
 			break;
@@ -483,6 +372,7 @@ stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const re
 
 						if (out->size == i) {
 							list_clear(out);
+							STM32IPL_TRACE_END(FindNonZeroLoc)
 							return stm32ipl_err_OutOfMemory;
 						}
 
@@ -505,6 +395,7 @@ stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const re
 
 						if (out->size == i) {
 							list_clear(out);
+							STM32IPL_TRACE_END(FindNonZeroLoc)
 							return stm32ipl_err_OutOfMemory;
 						}
 
@@ -515,9 +406,11 @@ stm32ipl_err_t STM32Ipl_FindNonZeroLoc(const image_t *img, list_t *out, const re
 			break;
 		}
 		default:
+			STM32IPL_TRACE_END(FindNonZeroLoc)
 			return stm32ipl_err_InvalidParameter;
 	}
 
+	STM32IPL_TRACE_END(FindNonZeroLoc)
 	return stm32ipl_err_Ok;
 }
 
@@ -0,0 +1,430 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_frame_ring.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - camera frame ring module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef USE_STM32H747I_DISCO
+#include "stm32h7xx_hal.h"
+#endif /* USE_STM32H747I_DISCO */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_RING_CACHE_LINE	32U		/* Size of the data cache lines (bytes). */
+#define IPL_RING_NONE		0xFFFFFFFFU
+
+/* Critical section protecting the owners against the capture interrupt. */
+#ifdef USE_STM32H747I_DISCO
+#define IPL_RING_LOCK(key)		do { (key) = __get_PRIMASK(); __disable_irq(); } while (0)
+#define IPL_RING_UNLOCK(key)	__set_PRIMASK(key)
+#else
+#define IPL_RING_LOCK(key)		((key) = 0)
+#define IPL_RING_UNLOCK(key)	STM32IPL_UNUSED(key)
+#endif /* USE_STM32H747I_DISCO */
+
+typedef enum _ipl_ring_cache_op_t
+{
+	ipl_ring_cache_clean,
+	ipl_ring_cache_invalidate
+} ipl_ring_cache_op_t;
+
+/* Executes the given maintenance operation on the data cache lines that contain the given bytes. The lines only
+ * partially covered by an invalidation are cleaned too, so that the bytes of the same lines written by the CPU
+ * outside of the range are not lost. */
+static void ipl_ring_cache(ipl_ring_cache_op_t op, const uint8_t *addr, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	uint32_t begin = (uint32_t)addr;
+	uint32_t end = begin + size;
+	uint32_t start = begin & ~(IPL_RING_CACHE_LINE - 1);
+	uint32_t stop = (end + IPL_RING_CACHE_LINE - 1) & ~(IPL_RING_CACHE_LINE - 1);
+
+	if (!(SCB->CCR & SCB_CCR_DC_Msk) || !size)
+		return;
+
+	if (op == ipl_ring_cache_clean) {
+		SCB_CleanDCache_by_Addr((uint32_t*)start, (int32_t)(stop - start));
+		return;
+	}
+
+	if (start != begin) {
+		SCB_CleanInvalidateDCache_by_Addr((uint32_t*)start, IPL_RING_CACHE_LINE);
+		start += IPL_RING_CACHE_LINE;
+	}
+
+	if ((stop != end) && (stop > start)) {
+		stop -= IPL_RING_CACHE_LINE;
+		SCB_CleanInvalidateDCache_by_Addr((uint32_t*)stop, IPL_RING_CACHE_LINE);
+	}
+
+	if (stop > start)
+		SCB_InvalidateDCache_by_Addr((uint32_t*)start, (int32_t)(stop - start));
+#else
+	STM32IPL_UNUSED(op);
+	STM32IPL_UNUSED(addr);
+	STM32IPL_UNUSED(size);
+#endif /* __DCACHE_PRESENT */
+}
+
+/* Executes the given maintenance operation on the rows [begin, end) of a frame (on the whole frame, seen as a single
+ * row, when the rows are not tracked). */
+static void ipl_ring_cache_rows(const stm32ipl_frame_ring_t *ring, ipl_ring_cache_op_t op, uint32_t index,
+		uint32_t begin, uint32_t end)
+{
+	uint32_t rowSize = ring->rowSize ? ring->rowSize : ring->frameSize;
+
+	if (begin < end)
+		ipl_ring_cache(op, ring->data[index] + (begin * rowSize), (end - begin) * rowSize);
+}
+
+/* Returns the index of the frame with the given data, IPL_RING_NONE when the ring does not own it. */
+static uint32_t ipl_ring_find(const stm32ipl_frame_ring_t *ring, const uint8_t *data)
+{
+	for (uint32_t i = 0; i < ring->count; i++)
+		if (ring->data[i] == data)
+			return i;
+
+	return IPL_RING_NONE;
+}
+
+/* Returns the index of a free frame, IPL_RING_NONE when none. */
+static uint32_t ipl_ring_find_free(const stm32ipl_frame_ring_t *ring)
+{
+	for (uint32_t i = 0; i < ring->count; i++)
+		if (ring->owner[i] == stm32ipl_frame_free)
+			return i;
+
+	return IPL_RING_NONE;
+}
+
+/* Gets the rows [*begin, *end) of the given ROI; the whole frame when the ROI is NULL or the rows are not tracked. */
+static stm32ipl_err_t ipl_ring_rows(const stm32ipl_frame_ring_t *ring, const rectangle_t *roi, uint32_t *begin,
+		uint32_t *end)
+{
+	if (!roi || (ring->rowSize == 0)) {
+		*begin = 0;
+		*end = (ring->rowSize == 0) ? 1 : ring->height;
+		return stm32ipl_err_Ok;
+	}
+
+	if ((roi->y < 0) || (roi->h <= 0) || ((uint32_t)(roi->y + roi->h) > ring->height))
+		return stm32ipl_err_WrongROI;
+
+	*begin = roi->y;
+	*end = roi->y + roi->h;
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
+/**
+ * @brief Initializes a ring of camera frame buffers shared by the capture DMA, the library and the display.
+ * The buffers are not copied: each frame is wrapped in an image_t header given by STM32Ipl_FrameRingAcquire().
+ * The ring tracks the owner of each buffer and performs the data cache maintenance: the rows read or written by
+ * the CPU are invalidated once, when they are first accessed after the capture, and the rows written by the CPU
+ * are cleaned before the display reads them (or discarded when the frame is recycled to the capture).
+ * With three buffers, a frame can be captured while the previous one is processed and the one before is displayed.
+ * @param ring		Frame ring; if it is not valid, an error is returned.
+ * @param buffers	Frame buffers; each one must start on a 32-byte boundary and its size must be the size of a
+ * frame (STM32Ipl_DataSize()) rounded up to a multiple of 32 bytes.
+ * @param count		Number of buffers, from 2 to STM32IPL_FRAME_RING_MAX_FRAMES.
+ * @param width		Width of the frames.
+ * @param height	Height of the frames.
+ * @param format	Format of the frames.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FrameRingInit(stm32ipl_frame_ring_t *ring, uint8_t *const buffers[], uint32_t count,
+		uint32_t width, uint32_t height, image_bpp_t format)
+{
+	image_t img;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ring)
+	STM32IPL_CHECK_VALID_PTR_ARG(buffers)
+
+	memset(ring, 0, sizeof(stm32ipl_frame_ring_t));
+
+	if ((count < 2) || (count > STM32IPL_FRAME_RING_MAX_FRAMES) || (width == 0) || (height == 0))
+		return stm32ipl_err_InvalidParameter;
+
+	for (uint32_t i = 0; i < count; i++)
+		if (!buffers[i] || ((uintptr_t)buffers[i] & (IPL_RING_CACHE_LINE - 1)))
+			return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_Init(&img, width, height, format, buffers[0]);
+	ring->frameSize = STM32Ipl_DataSize(width, height, format);
+	if (ring->frameSize == 0)
+		return stm32ipl_err_UnsupportedFormat;
+
+	/* The rows are tracked when the frame is made of the rows only (the whole frame is handled as one row otherwise). */
+	ring->rowSize = image_line_stride(&img);
+	if ((ring->rowSize * height) != ring->frameSize)
+		ring->rowSize = 0;
+
+	ring->width = width;
+	ring->height = height;
+	ring->format = format;
+	ring->count = count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		ring->data[i] = buffers[i];
+		ring->owner[i] = stm32ipl_frame_free;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gives a free buffer to the capture, to start the capture DMA on it. Nothing is done on the data cache:
+ * the rows of the frame are invalidated when the CPU accesses them after the capture.
+ * @param ring	Frame ring.
+ * @return		Address where the DMA must write the frame, NULL when no buffer is free.
+ */
+uint8_t* STM32Ipl_FrameRingCaptureStart(stm32ipl_frame_ring_t *ring)
+{
+	uint32_t key;
+	uint32_t index;
+
+	if (!ring || !ring->count)
+		return NULL;
+
+	IPL_RING_LOCK(key);
+	index = ipl_ring_find_free(ring);
+	if (index != IPL_RING_NONE)
+		ring->owner[index] = stm32ipl_frame_capture;
+	IPL_RING_UNLOCK(key);
+
+	return (index != IPL_RING_NONE) ? ring->data[index] : NULL;
+}
+
+/**
+ * @brief Notifies the end of the capture of a frame; it can be called from the frame event interrupt.
+ * The captured frame becomes the one returned by the next STM32Ipl_FrameRingAcquire(), and the older captured frames
+ * not yet acquired are recycled. Another buffer is given to the capture; when none is free, the frame just captured
+ * is dropped and its buffer is given back to the capture.
+ * @param ring	Frame ring.
+ * @param data	Address of the buffer written by the DMA (as returned by STM32Ipl_FrameRingCaptureStart() or by
+ * this function).
+ * @return		Address where the DMA must write the next frame, NULL when data is not a buffer being captured.
+ */
+uint8_t* STM32Ipl_FrameRingCaptureDone(stm32ipl_frame_ring_t *ring, const uint8_t *data)
+{
+	uint32_t key;
+	uint32_t index;
+	uint32_t next;
+
+	if (!ring)
+		return NULL;
+
+	IPL_RING_LOCK(key);
+	index = ipl_ring_find(ring, data);
+	if ((index == IPL_RING_NONE) || (ring->owner[index] != stm32ipl_frame_capture)) {
+		IPL_RING_UNLOCK(key);
+		return NULL;
+	}
+
+	next = ipl_ring_find_free(ring);
+	if (next == IPL_RING_NONE) {
+		/* Drops the older frames not yet acquired, or this one when there is none. */
+		for (uint32_t i = 0; i < ring->count; i++)
+			if (ring->owner[i] == stm32ipl_frame_ready)
+				next = i;
+
+		if (next == IPL_RING_NONE) {
+			IPL_RING_UNLOCK(key);
+			return ring->data[index];
+		}
+	}
+
+	for (uint32_t i = 0; i < ring->count; i++)
+		if (ring->owner[i] == stm32ipl_frame_ready)
+			ring->owner[i] = stm32ipl_frame_free;
+
+	ring->owner[index] = stm32ipl_frame_ready;
+	ring->sequence[index] = ++ring->lastSequence;
+	ring->owner[next] = stm32ipl_frame_capture;
+	IPL_RING_UNLOCK(key);
+
+	return ring->data[next];
+}
+
+/**
+ * @brief Acquires the last captured frame for the processing; the frame is wrapped in an image_t header, without
+ * any copy. The rows of the given ROI are invalidated in the data cache, so that the CPU reads the data written by
+ * the DMA; the other rows must be declared with STM32Ipl_FrameRingAccess() before being accessed.
+ * @param ring	Frame ring.
+ * @param img	Image initialized to the acquired frame.
+ * @param roi	Rows that will be read (the x and w fields are not considered); NULL means the whole frame.
+ * @return		stm32ipl_err_Ok on success, stm32ipl_err_OpNotCompleted when no new frame has been captured,
+ * error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FrameRingAcquire(stm32ipl_frame_ring_t *ring, image_t *img, const rectangle_t *roi)
+{
+	uint32_t key;
+	uint32_t index = IPL_RING_NONE;
+	uint32_t begin;
+	uint32_t end;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ring)
+	STM32IPL_CHECK_VALID_PTR_ARG(img)
+
+	res = ipl_ring_rows(ring, roi, &begin, &end);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	IPL_RING_LOCK(key);
+	for (uint32_t i = 0; i < ring->count; i++)
+		if ((ring->owner[i] == stm32ipl_frame_ready)
+				&& ((index == IPL_RING_NONE) || (ring->sequence[i] > ring->sequence[index])))
+			index = i;
+
+	if (index != IPL_RING_NONE)
+		ring->owner[index] = stm32ipl_frame_cpu;
+	IPL_RING_UNLOCK(key);
+
+	if (index == IPL_RING_NONE)
+		return stm32ipl_err_OpNotCompleted;
+
+	ring->validBegin[index] = begin;
+	ring->validEnd[index] = end;
+	ring->dirtyBegin[index] = 0;
+	ring->dirtyEnd[index] = 0;
+	ipl_ring_cache_rows(ring, ipl_ring_cache_invalidate, index, begin, end);
+
+	STM32Ipl_Init(img, ring->width, ring->height, ring->format, ring->data[index]);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Declares the rows of an acquired frame that are going to be accessed by the CPU. The rows not yet accessed
+ * since the acquisition are invalidated in the data cache (with the ones between them and the accessed rows, so that
+ * the accessed rows stay contiguous); when write is true, the rows are also marked to be cleaned before the display.
+ * @param ring	Frame ring.
+ * @param img	Image returned by STM32Ipl_FrameRingAcquire().
+ * @param roi	Rows that will be accessed (the x and w fields are not considered); NULL means the whole frame.
+ * @param write	True when the rows will be written.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FrameRingAccess(stm32ipl_frame_ring_t *ring, const image_t *img, const rectangle_t *roi,
+		bool write)
+{
+	uint32_t index;
+	uint32_t begin;
+	uint32_t end;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ring)
+	STM32IPL_CHECK_VALID_PTR_ARG(img)
+
+	index = ipl_ring_find(ring, img->data);
+	if ((index == IPL_RING_NONE) || (ring->owner[index] != stm32ipl_frame_cpu))
+		return stm32ipl_err_NotAllowed;
+
+	res = ipl_ring_rows(ring, roi, &begin, &end);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	if (begin < ring->validBegin[index]) {
+		ipl_ring_cache_rows(ring, ipl_ring_cache_invalidate, index, begin, ring->validBegin[index]);
+		ring->validBegin[index] = begin;
+	}
+
+	if (end > ring->validEnd[index]) {
+		ipl_ring_cache_rows(ring, ipl_ring_cache_invalidate, index, ring->validEnd[index], end);
+		ring->validEnd[index] = end;
+	}
+
+	if (write) {
+		if (ring->dirtyBegin[index] == ring->dirtyEnd[index]) {
+			ring->dirtyBegin[index] = begin;
+			ring->dirtyEnd[index] = end;
+		} else {
+			ring->dirtyBegin[index] = IM_MIN(ring->dirtyBegin[index], begin);
+			ring->dirtyEnd[index] = IM_MAX(ring->dirtyEnd[index], end);
+		}
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases an acquired frame. When it is displayed, the rows written by the CPU are cleaned in the data
+ * cache, so that the display reads them, and the buffer is kept until STM32Ipl_FrameRingDisplayDone(); otherwise,
+ * the rows written by the CPU are discarded from the data cache and the buffer is given back to the capture.
+ * @param ring		Frame ring.
+ * @param img		Image returned by STM32Ipl_FrameRingAcquire(); it must not be used after this call.
+ * @param display	True when the frame is going to be displayed.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FrameRingRelease(stm32ipl_frame_ring_t *ring, const image_t *img, bool display)
+{
+	uint32_t key;
+	uint32_t index;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ring)
+	STM32IPL_CHECK_VALID_PTR_ARG(img)
+
+	index = ipl_ring_find(ring, img->data);
+	if ((index == IPL_RING_NONE) || (ring->owner[index] != stm32ipl_frame_cpu))
+		return stm32ipl_err_NotAllowed;
+
+	/* Dirty lines must not be evicted over the next capture, nor be missed by the display. */
+	ipl_ring_cache_rows(ring, display ? ipl_ring_cache_clean : ipl_ring_cache_invalidate, index,
+			ring->dirtyBegin[index], ring->dirtyEnd[index]);
+
+	IPL_RING_LOCK(key);
+	ring->owner[index] = display ? stm32ipl_frame_display : stm32ipl_frame_free;
+	IPL_RING_UNLOCK(key);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Notifies that the display does not read a frame anymore (e.g. another frame has been shown); the buffer
+ * is given back to the capture. It can be called from an interrupt.
+ * @param ring	Frame ring.
+ * @param data	Address of the displayed buffer.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FrameRingDisplayDone(stm32ipl_frame_ring_t *ring, const uint8_t *data)
+{
+	uint32_t key;
+	uint32_t index;
+	stm32ipl_err_t res = stm32ipl_err_NotAllowed;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ring)
+
+	IPL_RING_LOCK(key);
+	index = ipl_ring_find(ring, data);
+	if ((index != IPL_RING_NONE) && (ring->owner[index] == stm32ipl_frame_display)) {
+		ring->owner[index] = stm32ipl_frame_free;
+		res = stm32ipl_err_Ok;
+	}
+	IPL_RING_UNLOCK(key);
+
+	return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -53,11 +53,55 @@ stm32ipl_err_t STM32Ipl_FindLines(const image_t *img, list_t *out, const rectang
 	if ((xStride == 0) || (yStride == 0))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(FindLines)
 	imlib_find_lines(out, (image_t*)img, &realRoi, xStride, yStride, threshold, thetaMargin, rhoMargin);
 
+	STM32IPL_TRACE_END(FindLines)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Finds infinite lines in a precomputed edge map (e.g. the output of STM32Ipl_EdgeCanny) using
+ * a gradient-voting Hough transform: each edge pixel votes only for the angles within voteMargin degrees
+ * of its local edge normal, estimated from its 8-connected edge neighbours, so no gradient is recomputed.
+ * Rho is computed with fixed-point sin/cos tables and votes are accumulated in a 16-bit (saturating)
+ * accumulator allocated in the working memory; when the memory is not enough, the accumulator
+ * resolution is halved (up to four times), as STM32Ipl_FindLines does.
+ * The supported formats are Binary, Grayscale (non-zero pixels are edges).
+ * @param edges			Edge map; if it is not valid, an error is returned.
+ * @param out			List of find_lines_list_lnk_data_t objects representing the lines found.
+ * @param roi			Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param threshold		Only lines with a magnitude (number of votes) greater than or equal to threshold are returned.
+ * @param voteMargin	Half width (degrees) of the voted angle range around the local edge normal, in [0, 89].
+ * The local estimate has a resolution of about 15 degrees, so values between 10 and 20 are recommended.
+ * @param thetaMargin	Lines which are thetaMargin degrees apart and rhoMargin apart are merged.
+ * @param rhoMargin		Lines which are thetaMargin degrees apart and rhoMargin apart are merged.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @note Edge pixels whose neighbourhood has no dominant orientation (isolated pixels, filled areas) do not vote.
+ */
+stm32ipl_err_t STM32Ipl_FindLinesEdgeMap(const image_t *edges, list_t *out, const rectangle_t *roi,
+		uint32_t threshold, uint8_t voteMargin, uint8_t thetaMargin, uint8_t rhoMargin)
+{
+	rectangle_t realRoi;
+	bool ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(edges)
+	STM32IPL_CHECK_FORMAT(edges, STM32IPL_IF_NOT_RGB)
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_GET_REAL_ROI(edges, roi, &realRoi)
+
+	if (voteMargin >= 90)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindLinesEdgeMap)
+	ok = imlib_find_lines_edges(out, (image_t*)edges, &realRoi, threshold, voteMargin, thetaMargin, rhoMargin);
+
+	STM32IPL_TRACE_END(FindLinesEdgeMap)
+	return ok ? stm32ipl_err_Ok : stm32ipl_err_OutOfMemory;
+}
+
 /**
  * @brief Finds circles in an image using the Hough transform.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
@@ -75,7 +119,8 @@ stm32ipl_err_t STM32Ipl_FindLines(const image_t *img, list_t *out, const rectang
  * @param rMin			Controls the minimum circle radius detected. Increase this to speed up the execution.
  * @param rMax			Controls the maximum circle radius detected. Decrease this to speed up the execution.
  * @param rStep			Controls how to step the radius detection by.
- * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the circles found so far are returned; the radii are searched every 4 * rStep first), error otherwise.
  */
 stm32ipl_err_t STM32Ipl_FindCircles(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t xStride,
 		uint32_t yStride, uint32_t threshold, uint32_t xMargin, uint32_t yMargin, uint32_t rMargin, uint32_t rMin,
@@ -91,13 +136,70 @@ stm32ipl_err_t STM32Ipl_FindCircles(const image_t *img, list_t *out, const recta
 	if (xStride == 0 || yStride == 0)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(FindCircles)
+	ctx_deadline_begin();
 	rMin = STM32IPL_MAX(rMin, 2);
 	rMax = STM32IPL_MIN(rMax, STM32IPL_MIN((realRoi.w / 2), (realRoi.h / 2)));
 
 	imlib_find_circles(out, (image_t*)img, &realRoi, xStride, yStride, threshold, xMargin, yMargin, rMargin, rMin, rMax,
 			rStep);
 
-	return stm32ipl_err_Ok;
+	STM32IPL_TRACE_END(FindCircles)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Finds circles in an image using the gradient (2-1) Hough transform.
+ * Each edge pixel votes only along its gradient line, for the distances in [rMin, rMax), into a single
+ * center accumulator; the radius of each center found is then estimated from the distances of the edge
+ * pixels whose gradient line passes by it. The cost is proportional to the number of edge pixels times the
+ * number of radii, instead of STM32Ipl_FindCircles() that scans the whole image once per radius.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param out			List of find_circles_list_lnk_data_t objects representing the circles found.
+ * @param roi			Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param xStride 		Number of x pixels to skip when doing the Hough transform.
+ * @param yStride 		Number of y pixels to skip when doing the Hough transform.
+ * @param edgeThreshold	Minimum Sobel magnitude (|gx| + |gy|, up to 2040) of the pixels that vote.
+ * @param threshold		Only the centers which collect at least threshold votes are considered.
+ * @param xMargin		Circles which are xMargin, yMargin and rMargin pixels apart are merged.
+ * @param yMargin		Circles which are xMargin, yMargin and rMargin pixels apart are merged.
+ * @param rMargin		Circles which are xMargin, yMargin and rMargin pixels apart are merged.
+ * @param rMin			Minimum circle radius detected.
+ * @param rMax			Maximum circle radius detected (excluded).
+ * @param rStep			Step of the votes along the gradient line; increase it to speed up the execution.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @note Unlike STM32Ipl_FindCircles(), circles whose center is inside the ROI are found even if they
+ * are not completely contained in it; the magnitude is the number of edge pixels supporting the circle
+ * and, instead of being averaged, overlapping circles are reduced to the best supported one, so the list
+ * is sorted by decreasing magnitude.
+ */
+stm32ipl_err_t STM32Ipl_FindCirclesGradient(const image_t *img, list_t *out, const rectangle_t *roi, uint32_t xStride,
+		uint32_t yStride, uint32_t edgeThreshold, uint32_t threshold, uint32_t xMargin, uint32_t yMargin, uint32_t rMargin,
+		uint32_t rMin, uint32_t rMax, uint32_t rStep)
+{
+	rectangle_t realRoi;
+	bool ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	if (xStride == 0 || yStride == 0 || rStep == 0)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindCirclesGradient)
+	rMin = STM32IPL_MAX(rMin, 2);
+	rMax = STM32IPL_MIN(rMax, STM32IPL_MAX(realRoi.w, realRoi.h));
+
+	ok = imlib_find_circles_gradient(out, (image_t*)img, &realRoi, xStride, yStride, edgeThreshold, threshold, xMargin,
+			yMargin, rMargin, rMin, rMax, rStep);
+
+	STM32IPL_TRACE_END(FindCirclesGradient)
+	return ok ? stm32ipl_err_Ok : stm32ipl_err_OutOfMemory;
 }
 
 #ifdef __cplusplus
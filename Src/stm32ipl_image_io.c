@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include "ff.h"
+#include "stm32ipl_image_io_stream.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,10 +57,12 @@ typedef enum _ImageFileFormatType
 	iplFileFormatPPM,
 	iplFileFormatPGM,
 	iplFileFormatJPG,
+	iplFileFormatIPR,
+	iplFileFormatIPQ,
 } ImageFileFormatType;
 
 /* Returns the image file format by analyzing the file extension.
- * BMP, PPM, PGM, JPEG formats are supported.
+ * BMP, PPM, PGM, JPEG, IPR, IPQ formats are supported.
  * filename	Name of the input file.
  * return	image file format.
  */
@@ -76,7 +79,7 @@ static ImageFileFormatType getImageFileFormat(const char *filename)
 	len = strlen(filename);
 
 	/* Convert to upper case. */
-	upFilename = xalloc(len);
+	upFilename = xalloc(len + 1);
 	strcpy(upFilename, filename);
 
 	for (size_t i = 0; i < len; i++)
@@ -100,6 +103,12 @@ static ImageFileFormatType getImageFileFormat(const char *filename)
 				else
 					if ((ptr[-1] == 'M') && (ptr[-2] == 'G') && (ptr[-3] == 'P') && (ptr[-4] == '.'))
 						format = iplFileFormatPGM;
+					else
+						if ((ptr[-1] == 'R') && (ptr[-2] == 'P') && (ptr[-3] == 'I') && (ptr[-4] == '.'))
+							format = iplFileFormatIPR;
+						else
+							if ((ptr[-1] == 'Q') && (ptr[-2] == 'P') && (ptr[-3] == 'I') && (ptr[-4] == '.'))
+								format = iplFileFormatIPQ;
 	}
 
 	xfree(upFilename);
@@ -128,6 +137,222 @@ static bool grayscalePalette(uint32_t *palette, uint32_t colorUsed)
 	return true;
 }
 
+/* Size (bytes) of the buffer used to read and write the BMP and PNM files. */
+#ifndef STM32IPL_FILE_BUFFER_SIZE
+#define STM32IPL_FILE_BUFFER_SIZE	4096
+#endif /* STM32IPL_FILE_BUFFER_SIZE */
+
+/* Alignment (bytes) of the file buffer, so that the storage driver can move the data with its DMA. */
+#define FILE_BUFFER_ALIGNMENT	32
+
+/* Buffer used to read or write several lines (or bytes) of a file with a single read/write call, so that
+ * the file system moves whole sectors directly from/to the memory instead of many small unaligned transfers. */
+typedef struct _FileBuffer
+{
+	ipl_stream_t *stream;	/* Stream (file or memory). */
+	uint8_t *mem;		/* Allocated memory. */
+	uint8_t *data;		/* Buffer, aligned to FILE_BUFFER_ALIGNMENT bytes. */
+	uint32_t lineSize;	/* Size of a line (bytes); 1 for a stream of bytes. */
+	uint32_t maxLines;	/* Number of lines that fit the buffer. */
+	uint32_t nLines;	/* Number of lines of the file; 0 for a stream of bytes. */
+	uint32_t offset;	/* Offset (bytes) of the first line from the beginning of the file. */
+	bool bottomUp;		/* true if the last line of the image is the first one of the file. */
+	uint32_t first;		/* Index (in the file) of the first line in the buffer. */
+	uint32_t count;		/* Number of lines in the buffer. */
+	uint32_t pos;		/* Index of the next line to be read from the buffer (stream of bytes). */
+} FileBuffer;
+
+/* Allocates a buffer for the lines of the given file; the number of lines per chunk is reduced when the memory is
+ * not enough for STM32IPL_FILE_BUFFER_SIZE bytes.
+ * buf		Buffer to be initialized.
+ * stream	Stream to be read or written.
+ * offset	Offset (bytes) of the first line from the beginning of the file.
+ * lineSize	Size of a line (bytes); 1 for a stream of bytes.
+ * nLines	Number of lines of the file; 0 for a stream of bytes.
+ * bottomUp	true if the last line of the image is the first one of the file.
+ * return	true on success, false if the memory is not enough for a line.
+ */
+static bool openFileBuffer(FileBuffer *buf, ipl_stream_t *stream, uint32_t offset, uint32_t lineSize, uint32_t nLines,
+		bool bottomUp)
+{
+	uint32_t maxLines = (lineSize < STM32IPL_FILE_BUFFER_SIZE) ? (STM32IPL_FILE_BUFFER_SIZE / lineSize) : 1;
+
+	if (nLines && (maxLines > nLines))
+		maxLines = nLines;
+
+	do {
+		buf->mem = xalloc((maxLines * lineSize) + FILE_BUFFER_ALIGNMENT - 1);
+		if (buf->mem)
+			break;
+		maxLines >>= 1;
+	} while (maxLines);
+
+	if (!buf->mem)
+		return false;
+
+	buf->stream = stream;
+	buf->data = (uint8_t*)(((uintptr_t)buf->mem + FILE_BUFFER_ALIGNMENT - 1)
+			& ~(uintptr_t)(FILE_BUFFER_ALIGNMENT - 1));
+	buf->lineSize = lineSize;
+	buf->maxLines = maxLines;
+	buf->nLines = nLines;
+	buf->offset = offset;
+	buf->bottomUp = bottomUp;
+	buf->first = 0;
+	buf->count = 0;
+	buf->pos = 0;
+
+	return true;
+}
+
+/* Releases the memory of the buffer. */
+static void closeFileBuffer(FileBuffer *buf)
+{
+	xfree(buf->mem);
+	buf->mem = 0;
+}
+
+/* Gets the given line of the image, reading from the file the chunk of lines that contains it, when needed;
+ * the chunk is made of the lines that follow the given one in the order of the image.
+ * buf		Buffer.
+ * row		Index of the line in the image.
+ * line		Pointer to the line data, valid until the next call.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readFileLine(FileBuffer *buf, uint32_t row, const uint8_t **line)
+{
+	uint32_t index = buf->bottomUp ? (buf->nLines - 1 - row) : row;
+
+	if ((index < buf->first) || (index >= (buf->first + buf->count))) {
+		uint32_t size;
+		uint32_t bytesRead;
+
+		buf->first = buf->bottomUp ? (((index + 1) > buf->maxLines) ? (index + 1 - buf->maxLines) : 0) : index;
+		buf->count = IM_MIN(buf->maxLines, buf->nLines - buf->first);
+		size = buf->count * buf->lineSize;
+
+		if (!ipl_stream_seek(buf->stream, buf->offset + (buf->first * buf->lineSize))) {
+			buf->count = 0;
+			return stm32ipl_err_SeekingFile;
+		}
+
+		if (!ipl_stream_read(buf->stream, buf->data, size, &bytesRead) || (bytesRead != size)) {
+			buf->count = 0;
+			return stm32ipl_err_ReadingFile;
+		}
+	}
+
+	*line = buf->data + ((index - buf->first) * buf->lineSize);
+
+	return stm32ipl_err_Ok;
+}
+
+/* Reads the next byte of a stream of bytes, from the current position of the file.
+ * buf		Buffer (opened with lineSize = 1 and nLines = 0).
+ * value	Byte read.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readFileByte(FileBuffer *buf, uint8_t *value)
+{
+	if (buf->pos == buf->count) {
+		uint32_t bytesRead;
+
+		if (!ipl_stream_read(buf->stream, buf->data, buf->maxLines, &bytesRead) || !bytesRead)
+			return stm32ipl_err_ReadingFile;
+
+		buf->count = bytesRead;
+		buf->pos = 0;
+	}
+
+	*value = buf->data[buf->pos++];
+
+	return stm32ipl_err_Ok;
+}
+
+/* Reads the next bytes of a stream of bytes: the ones already in the buffer are copied, the others are read
+ * directly from the file.
+ * buf		Buffer (opened with lineSize = 1 and nLines = 0).
+ * dst		Destination of the bytes.
+ * size		Number of bytes to be read.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readFileBytes(FileBuffer *buf, uint8_t *dst, uint32_t size)
+{
+	uint32_t n = IM_MIN(buf->count - buf->pos, size);
+	uint32_t bytesRead;
+
+	memcpy(dst, buf->data + buf->pos, n);
+	buf->pos += n;
+	size -= n;
+
+	if (size && (!ipl_stream_read(buf->stream, dst + n, size, &bytesRead) || (bytesRead != size)))
+		return stm32ipl_err_ReadingFile;
+
+	return stm32ipl_err_Ok;
+}
+
+/* Writes the lines in the buffer to the file.
+ * buf		Buffer.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t flushFileBuffer(FileBuffer *buf)
+{
+	uint32_t size = buf->count * buf->lineSize;
+	uint32_t bytesWritten;
+
+	buf->count = 0;
+
+	if (!ipl_stream_write(buf->stream, buf->data, size, &bytesWritten) || (bytesWritten != size))
+		return stm32ipl_err_WritingFile;
+
+	return stm32ipl_err_Ok;
+}
+
+/* Gets the space for the next line to be written to the file; the full chunks are written with a single call.
+ * buf		Buffer.
+ * line		Pointer to the line, to be filled by the caller.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t writeFileLine(FileBuffer *buf, uint8_t **line)
+{
+	if (buf->count == buf->maxLines) {
+		stm32ipl_err_t res = flushFileBuffer(buf);
+		if (res != stm32ipl_err_Ok)
+			return res;
+	}
+
+	*line = buf->data + (buf->count++ * buf->lineSize);
+
+	return stm32ipl_err_Ok;
+}
+
+/* Writes the given bytes to a stream of bytes; the full chunks are written with a single call.
+ * buf		Buffer (opened with lineSize = 1).
+ * src		Bytes to be written.
+ * size		Number of bytes to be written.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t writeFileBytes(FileBuffer *buf, const uint8_t *src, uint32_t size)
+{
+	while (size) {
+		uint32_t n;
+
+		if (buf->count == buf->maxLines) {
+			stm32ipl_err_t res = flushFileBuffer(buf);
+			if (res != stm32ipl_err_Ok)
+				return res;
+		}
+
+		n = IM_MIN(buf->maxLines - buf->count, size);
+		memcpy(buf->data + buf->count, src, n);
+		buf->count += n;
+		src += n;
+		size -= n;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
 /* Reads BMP image file; supported files are: 1, 4, 8 bits/pixel with palette;
  * 16 bits/pixels with or without BITFIELDS; 24 bits/pixels; compressed BI_RGB and BI_BITFIELDS.
  * The generated image will be:
@@ -138,10 +363,10 @@ static bool grayscalePalette(uint32_t *palette, uint32_t colorUsed)
  * 	- RGB565 for the remaining cases.
  * img		Image read. The pixel data is allocated internally and must be released
  * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
- * fp		Pointer to the input file structure.
+ * stream	Input stream.
  * return	stm32ipl_err_Ok on success, errors otherwise.
  */
-static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
+static stm32ipl_err_t readBmp(image_t *img, ipl_stream_t *stream)
 {
 	uint32_t dataOffset; /* The offset, in bytes, from the beginning of the file to the image pixels. */
 	uint32_t infoHeaderSize; /* The number of bytes of the header. */
@@ -156,23 +381,24 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 	uint32_t bytesRead;
 	uint8_t *outData;
 	uint32_t paletteSize;
-	uint8_t *lineData;
-	uint32_t line;
-	uint8_t *ptr;
+	FileBuffer buf;
+	const uint8_t *lineData;
+	const uint8_t *ptr;
+	stm32ipl_err_t res;
 	uint32_t rMask;
 	uint32_t gMask;
 	uint32_t bMask;
 
-	if (!img || !fp)
+	if (!img || !stream)
 		return stm32ipl_err_InvalidParameter;
 
 	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
 
-	if (f_lseek(fp, 0) != FR_OK)
+	if (!ipl_stream_seek(stream, 0))
 		return stm32ipl_err_SeekingFile;
 
 	/* Read file header and info header (54 bytes). */
-	if ((f_read(fp, header, sizeof(header), (UINT*)&bytesRead) != FR_OK) || bytesRead != sizeof(header))
+	if (!ipl_stream_read(stream, header, sizeof(header), &bytesRead) || bytesRead != sizeof(header))
 		return stm32ipl_err_ReadingFile;
 
 	pHeader = (uint8_t*)header;
@@ -216,17 +442,17 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 	if ((compression == BI_BITFIELDS) && (bitCount == 16)) {
 		uint8_t mask[4];
 		/* Read the three bit masks. */
-		if ((f_read(fp, mask, sizeof(mask), (UINT*)&bytesRead) != FR_OK) || bytesRead != sizeof(mask))
+		if (!ipl_stream_read(stream, mask, sizeof(mask), &bytesRead) || bytesRead != sizeof(mask))
 			return stm32ipl_err_ReadingFile;
 
 		rMask = mask[0] + (mask[1] << 8) + (mask[2] << 16) + (mask[3] << 24);
 
-		if ((f_read(fp, mask, sizeof(mask), (UINT*)&bytesRead) != FR_OK) || bytesRead != sizeof(mask))
+		if (!ipl_stream_read(stream, mask, sizeof(mask), &bytesRead) || bytesRead != sizeof(mask))
 			return stm32ipl_err_ReadingFile;
 
 		gMask = mask[0] + (mask[1] << 8) + (mask[2] << 16) + (mask[3] << 24);
 
-		if ((f_read(fp, mask, sizeof(mask), (UINT*)&bytesRead) != FR_OK) || bytesRead != sizeof(mask))
+		if (!ipl_stream_read(stream, mask, sizeof(mask), &bytesRead) || bytesRead != sizeof(mask))
 			return stm32ipl_err_ReadingFile;
 
 		bMask = mask[0] + (mask[1] << 8) + (mask[2] << 16) + (mask[3] << 24);
@@ -244,11 +470,11 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 			paletteSize = colorUsed * sizeof(uint32_t);
 
 			/* Skip the header. */
-			if (f_lseek(fp, dataOffset - paletteSize) != FR_OK)
+			if (!ipl_stream_seek(stream, dataOffset - paletteSize))
 				return stm32ipl_err_SeekingFile;
 
 			/* Read the palette. */
-			if ((f_read(fp, palette, paletteSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != paletteSize)
+			if (!ipl_stream_read(stream, palette, paletteSize, &bytesRead) || bytesRead != paletteSize)
 				return stm32ipl_err_ReadingFile;
 
 			/* If the palette is made of black and white colors, the output image will be binary, RGB565 otherwise. */
@@ -263,37 +489,31 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 				if (!outData)
 					return stm32ipl_err_OutOfMemory;
 
-				lineData = xalloc(lineSize);
-				if (!lineData) {
+				/* The lines are read in chunks, from the first or last one. */
+				if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 					xfree(outData);
 					return stm32ipl_err_OutOfMemory;
 				}
 
-				/* Jump to the first or last line. */
-				line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-				if (f_lseek(fp, line) != FR_OK) {
-					xfree(lineData);
-					xfree(outData);
-					return stm32ipl_err_SeekingFile;
-				}
-
 				outRow = (uint32_t*)outData;
 
 				for (uint32_t i = 0; i < abs(height); i++) {
 					uint8_t value;
 					uint8_t k;
-					uint8_t *inData;
+					const uint8_t *inData;
 
 					value = 0;
 					k = 0;
-					inData = (uint8_t*)lineData;
 
-					if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-						xfree(lineData);
+					res = readFileLine(&buf, i, &lineData);
+					if (res != stm32ipl_err_Ok) {
+						closeFileBuffer(&buf);
 						xfree(outData);
-						return stm32ipl_err_ReadingFile;
+						return res;
 					}
 
+					inData = lineData;
+
 					for (uint32_t j = 0; j < width; k--, j++) {
 						if (!(j % 8)) {
 							value = (*inData++);
@@ -303,23 +523,9 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 					}
 
 					outRow += offset;
-
-					if (height > 0) {
-						line -= lineSize;
-						if (line >= dataOffset) {
-							if (f_lseek(fp, line) != FR_OK) {
-								xfree(lineData);
-								xfree(outData);
-								return stm32ipl_err_SeekingFile;
-							}
-						}
-					} else {
-						line += lineSize;
-					}
 				}
 
-				xfree(lineData);
-				lineData = 0;
+				closeFileBuffer(&buf);
 
 				STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_BINARY, outData);
 			} else {
@@ -332,29 +538,22 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 				if (!outData)
 					return stm32ipl_err_OutOfMemory;
 
-				lineData = xalloc(lineSize);
-				if (!lineData) {
+				/* The lines are read in chunks, from the first or last one. */
+				if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 					xfree(outData);
 					return stm32ipl_err_OutOfMemory;
 				}
 
-				/* Jump to the first or last line. */
-				line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-				if (f_lseek(fp, line) != FR_OK) {
-					xfree(lineData);
-					xfree(outData);
-					return stm32ipl_err_SeekingFile;
-				}
-
 				outPixel = (uint16_t*)outData;
 				for (uint32_t i = 0; i < abs(height); i++) {
 					uint8_t value = 0;
 					uint8_t k = 0;
 
-					if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-						xfree(lineData);
+					res = readFileLine(&buf, i, &lineData);
+					if (res != stm32ipl_err_Ok) {
+						closeFileBuffer(&buf);
 						xfree(outData);
-						return stm32ipl_err_ReadingFile;
+						return res;
 					}
 
 					ptr = lineData;
@@ -377,23 +576,9 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 
 						*outPixel++ = (uint16_t)COLOR_R8_G8_B8_TO_RGB565(r, g, b);
 					}
-
-					if (height > 0) {
-						line -= lineSize;
-						if (line >= dataOffset) {
-							if (f_lseek(fp, line) != FR_OK) {
-								xfree(lineData);
-								xfree(outData);
-								return stm32ipl_err_SeekingFile;
-							}
-						}
-					} else {
-						line += lineSize;
-					}
 				}
 
-				xfree(lineData);
-				lineData = 0;
+				closeFileBuffer(&buf);
 
 				STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_RGB565, outData);
 			}
@@ -408,11 +593,11 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 			paletteSize = colorUsed * sizeof(uint32_t);
 
 			/* Skip the header. */
-			if (f_lseek(fp, dataOffset - paletteSize) != FR_OK)
+			if (!ipl_stream_seek(stream, dataOffset - paletteSize))
 				return stm32ipl_err_SeekingFile;
 
 			/* Read the palette. */
-			if ((f_read(fp, palette, paletteSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != paletteSize)
+			if (!ipl_stream_read(stream, palette, paletteSize, &bytesRead) || bytesRead != paletteSize)
 				return stm32ipl_err_ReadingFile;
 
 			/* Allocate memory for pixel data (RGB565). */
@@ -420,26 +605,19 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 			if (!outData)
 				return stm32ipl_err_OutOfMemory;
 
-			lineData = xalloc(lineSize);
-			if (!lineData) {
+			/* The lines are read in chunks, from the first or last one. */
+			if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 				xfree(outData);
 				return stm32ipl_err_OutOfMemory;
 			}
 
-			/* Jump to the first or last line. */
-			line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-			if (f_lseek(fp, line) != FR_OK) {
-				xfree(lineData);
-				xfree(outData);
-				return stm32ipl_err_SeekingFile;
-			}
-
 			outPixel = (uint16_t*)outData;
 			for (uint32_t i = 0; i < abs(height); i++) {
-				if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-					xfree(lineData);
+				res = readFileLine(&buf, i, &lineData);
+				if (res != stm32ipl_err_Ok) {
+					closeFileBuffer(&buf);
 					xfree(outData);
-					return stm32ipl_err_ReadingFile;
+					return res;
 				}
 
 				ptr = lineData;
@@ -463,23 +641,9 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 					}
 					j++;
 				}
-
-				if (height > 0) {
-					line -= lineSize;
-					if (line >= dataOffset) {
-						if (f_lseek(fp, line) != FR_OK) {
-							xfree(lineData);
-							xfree(outData);
-							return stm32ipl_err_SeekingFile;
-						}
-					}
-				} else {
-					line += lineSize;
-				}
 			}
 
-			xfree(lineData);
-			lineData = 0;
+			closeFileBuffer(&buf);
 
 			STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_RGB565, outData);
 
@@ -492,11 +656,11 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 			paletteSize = colorUsed * sizeof(uint32_t);
 
 			/* Skip the header. */
-			if (f_lseek(fp, dataOffset - paletteSize) != FR_OK)
+			if (!ipl_stream_seek(stream, dataOffset - paletteSize))
 				return stm32ipl_err_SeekingFile;
 
 			/* Read the palette. */
-			if ((f_read(fp, palette, paletteSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != paletteSize)
+			if (!ipl_stream_read(stream, palette, paletteSize, &bytesRead) || bytesRead != paletteSize)
 				return stm32ipl_err_ReadingFile;
 
 			/* In case of grayscale palette, the output image will be Grayscale, RGB565 otherwise. */
@@ -509,48 +673,27 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 				if (!outData)
 					return stm32ipl_err_OutOfMemory;
 
-				lineData = xalloc(lineSize);
-				if (!lineData) {
+				/* The lines are read in chunks, from the first or last one. */
+				if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 					xfree(outData);
 					return stm32ipl_err_OutOfMemory;
 				}
 
-				/* Jump to the first or last line. */
-				line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-				if (f_lseek(fp, line) != FR_OK) {
-					xfree(lineData);
-					xfree(outData);
-					return stm32ipl_err_SeekingFile;
-				}
-
 				outPixel = (uint8_t*)outData;
 				for (uint32_t i = 0; i < abs(height); i++) {
-					if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-						xfree(lineData);
+					res = readFileLine(&buf, i, &lineData);
+					if (res != stm32ipl_err_Ok) {
+						closeFileBuffer(&buf);
 						xfree(outData);
-						return stm32ipl_err_ReadingFile;
+						return res;
 					}
 
 					ptr = lineData;
 					for (uint32_t j = 0; j < width; j++)
 						*outPixel++ = palette[*ptr++];
-
-					if (height > 0) {
-						line -= lineSize;
-						if (line >= dataOffset) {
-							if (f_lseek(fp, line) != FR_OK) {
-								xfree(lineData);
-								xfree(outData);
-								return stm32ipl_err_SeekingFile;
-							}
-						}
-					} else {
-						line += lineSize;
-					}
 				}
 
-				xfree(lineData);
-				lineData = 0;
+				closeFileBuffer(&buf);
 
 				STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_GRAYSCALE, outData);
 			} else {
@@ -563,26 +706,19 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 				if (!outData)
 					return stm32ipl_err_OutOfMemory;
 
-				lineData = xalloc(lineSize);
-				if (!lineData) {
+				/* The lines are read in chunks, from the first or last one. */
+				if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 					xfree(outData);
 					return stm32ipl_err_OutOfMemory;
 				}
 
-				/* Jump to the first or last line. */
-				line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-				if (f_lseek(fp, line) != FR_OK) {
-					xfree(lineData);
-					xfree(outData);
-					return stm32ipl_err_SeekingFile;
-				}
-
 				outPixel = (uint16_t*)outData;
 				for (uint32_t i = 0; i < abs(height); i++) {
-					if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-						xfree(lineData);
+					res = readFileLine(&buf, i, &lineData);
+					if (res != stm32ipl_err_Ok) {
+						closeFileBuffer(&buf);
 						xfree(outData);
-						return stm32ipl_err_ReadingFile;
+						return res;
 					}
 
 					ptr = lineData;
@@ -594,23 +730,9 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 
 						*outPixel++ = (uint16_t)COLOR_R8_G8_B8_TO_RGB565(r, g, b);
 					}
-
-					if (height > 0) {
-						line -= lineSize;
-						if (line >= dataOffset) {
-							if (f_lseek(fp, line) != FR_OK) {
-								xfree(lineData);
-								xfree(outData);
-								return stm32ipl_err_SeekingFile;
-							}
-						}
-					} else {
-						line += lineSize;
-					}
 				}
 
-				xfree(lineData);
-				lineData = 0;
+				closeFileBuffer(&buf);
 
 				STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_RGB565, outData);
 			}
@@ -620,41 +742,30 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 
 		case 16: {
 			uint16_t *outPixel;
-			uint16_t *inPixel;
-
-			/* Skip the header. */
-			if (f_lseek(fp, dataOffset) != FR_OK)
-				return stm32ipl_err_SeekingFile;
+			const uint16_t *inPixel;
 
 			/* Allocate memory for pixel data (RGB565). */
 			outData = xalloc(width * abs(height) * 2);
 			if (!outData)
 				return stm32ipl_err_OutOfMemory;
 
-			lineData = xalloc(lineSize);
-			if (!lineData) {
+			/* The lines are read in chunks, from the first or last one. */
+			if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 				xfree(outData);
 				return stm32ipl_err_OutOfMemory;
 			}
 
-			/* Jump to the first or last line. */
-			line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-
-			if (f_lseek(fp, line) != FR_OK) {
-				xfree(outData);
-				return stm32ipl_err_SeekingFile;
-			}
-
 			outPixel = (uint16_t*)outData;
 
 			for (uint32_t i = 0; i < abs(height); i++) {
-				if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-					xfree(lineData);
+				res = readFileLine(&buf, i, &lineData);
+				if (res != stm32ipl_err_Ok) {
+					closeFileBuffer(&buf);
 					xfree(outData);
-					return stm32ipl_err_ReadingFile;
+					return res;
 				}
 
-				inPixel = (uint16_t*)lineData;
+				inPixel = (const uint16_t*)lineData;
 
 				for (uint32_t j = 0; j < width; j++) {
 					uint16_t value = *inPixel;
@@ -669,23 +780,9 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 
 					inPixel++;
 				}
-
-				if (height > 0) {
-					line -= lineSize;
-					if (line >= dataOffset) {
-						if (f_lseek(fp, line) != FR_OK) {
-							xfree(lineData);
-							xfree(outData);
-							return stm32ipl_err_SeekingFile;
-						}
-					}
-				} else {
-					line += lineSize;
-				}
 			}
 
-			xfree(lineData);
-			lineData = 0;
+			closeFileBuffer(&buf);
 
 			STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_RGB565, outData);
 
@@ -696,59 +793,33 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
 			uint8_t *outPixel;
 			uint32_t outLineSize = width * 3;
 
-			/* Skip the header. */
-			if (f_lseek(fp, dataOffset) != FR_OK)
-				return stm32ipl_err_SeekingFile;
-
 			/* Allocate memory for pixel data (RGB888). */
 			outData = xalloc(outLineSize * abs(height));
 			if (!outData)
 				return stm32ipl_err_OutOfMemory;
 
-			lineData = xalloc(lineSize);
-			if (!lineData) {
+			/* The lines are read in chunks, from the first or last one. */
+			if (!openFileBuffer(&buf, stream, dataOffset, lineSize, abs(height), height > 0)) {
 				xfree(outData);
 				return stm32ipl_err_OutOfMemory;
 			}
 
-			/* Jump to the first or last line. */
-			line = dataOffset + ((height > 0) ? (lineSize * (height - 1)) : 0);
-
-			if (f_lseek(fp, line) != FR_OK) {
-				xfree(lineData);
-				xfree(outData);
-				return stm32ipl_err_SeekingFile;
-			}
-
 			outPixel = (uint8_t*)outData;
 
 			for (uint32_t i = 0; i < abs(height); i++) {
-				if ((f_read(fp, lineData, lineSize, (UINT*)&bytesRead) != FR_OK) || bytesRead != lineSize) {
-					xfree(lineData);
+				res = readFileLine(&buf, i, &lineData);
+				if (res != stm32ipl_err_Ok) {
+					closeFileBuffer(&buf);
 					xfree(outData);
-					return stm32ipl_err_ReadingFile;
+					return res;
 				}
 
 				memcpy(outPixel, lineData, outLineSize);
 
 				outPixel += outLineSize;
-
-				if (height > 0) {
-					line -= lineSize;
-					if (line >= dataOffset) {
-						if (f_lseek(fp, line) != FR_OK) {
-							xfree(lineData);
-							xfree(outData);
-							return stm32ipl_err_SeekingFile;
-						}
-					}
-				} else {
-					line += lineSize;
-				}
 			}
 
-			xfree(lineData);
-			lineData = 0;
+			closeFileBuffer(&buf);
 
 			STM32Ipl_Init(img, width, abs(height), IMAGE_BPP_RGB888, outData);
 
@@ -771,17 +842,16 @@ static stm32ipl_err_t readBmp(image_t *img, FIL *fp)
  * on the actual image content.
  * img		Image read; the pixel data is allocated internally and must be released
  * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
- * fp 		Pointer to the input file structure.
+ * buf 		Buffer of the input file, read as a stream of bytes from its beginning.
  * return	stm32ipl_err_Ok on success, errors otherwise.
  */
-static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
+static stm32ipl_err_t parsePnm(image_t *img, FileBuffer *buf)
 {
 	uint32_t size;
 	uint32_t width;
 	uint32_t height;
-	UINT bytesRead;
 	uint32_t number;
-	uint8_t sector[512];
+	uint8_t sector[2];
 	uint8_t number_ppm;
 	bool valid = false;
 	uint8_t *outData;
@@ -791,15 +861,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 		EAT_WHITESPACE, EAT_COMMENT, EAT_NUMBER
 	} mode = EAT_WHITESPACE;
 
-	if (!img || !fp)
-		return stm32ipl_err_InvalidParameter;
-
-	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
-
-	if (f_lseek(fp, 0) != FR_OK)
-		return stm32ipl_err_SeekingFile;
-
-	if ((f_read(fp, sector, 2, (UINT*)&bytesRead) != FR_OK) || bytesRead != 2)
+	if (readFileBytes(buf, sector, 2) != stm32ipl_err_Ok)
 		return stm32ipl_err_ReadingFile;
 
 	number = 0;
@@ -818,7 +880,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 		return stm32ipl_err_UnsupportedFormat;
 
 	do {
-		if ((f_read(fp, sector, 1, &bytesRead) != FR_OK) || bytesRead != 1)
+		if (readFileByte(buf, sector) != stm32ipl_err_Ok)
 			return stm32ipl_err_ReadingFile;
 
 		if (mode == EAT_WHITESPACE) {
@@ -852,7 +914,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 		if (valid) {
 			valid = false;
 		} else {
-			if ((f_read(fp, sector, 1, &bytesRead) != FR_OK) || bytesRead != 1)
+			if (readFileByte(buf, sector) != stm32ipl_err_Ok)
 				return stm32ipl_err_ReadingFile;
 		}
 
@@ -890,7 +952,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 		if (valid) {
 			valid = false;
 		} else {
-			if ((f_read(fp, sector, 1, &bytesRead) != FR_OK) || bytesRead != 1)
+			if (readFileByte(buf, sector) != stm32ipl_err_Ok)
 				return stm32ipl_err_ReadingFile;
 		}
 
@@ -939,7 +1001,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 						if (valid) {
 							valid = false;
 						} else {
-							if ((f_read(fp, sector, 1, &bytesRead) != FR_OK) || bytesRead != 1)
+							if (readFileByte(buf, sector) != stm32ipl_err_Ok)
 								return stm32ipl_err_ReadingFile;
 						}
 						if (mode == EAT_WHITESPACE) {
@@ -997,7 +1059,7 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 							if (valid) {
 								valid = false;
 							} else {
-								if ((f_read(fp, sector, 1, &bytesRead) != FR_OK) || bytesRead != 1)
+								if (readFileByte(buf, sector) != stm32ipl_err_Ok)
 									return stm32ipl_err_ReadingFile;
 							}
 
@@ -1047,8 +1109,10 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 			if (!outData)
 				return stm32ipl_err_OutOfMemory;
 
-			if ((f_read(fp, outData, size, &bytesRead) != FR_OK) || bytesRead != size)
+			if (readFileBytes(buf, outData, size) != stm32ipl_err_Ok) {
+				xfree(outData);
 				return stm32ipl_err_ReadingFile;
+			}
 
 			STM32Ipl_Init(img, width, height, IMAGE_BPP_GRAYSCALE, outData);
 
@@ -1064,8 +1128,10 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 			if (!outData)
 				return stm32ipl_err_OutOfMemory;
 
-			if ((f_read(fp, outData, size, &bytesRead) != FR_OK) || bytesRead != size)
+			if (readFileBytes(buf, outData, size) != stm32ipl_err_Ok) {
+				xfree(outData);
 				return stm32ipl_err_ReadingFile;
+			}
 
 			for (uint32_t i = 0; i < size; i += 3) {
 				uint8_t tmp = outData[i];
@@ -1085,129 +1151,633 @@ static stm32ipl_err_t readPnm(image_t *img, FIL *fp)
 	return stm32ipl_err_Ok;
 }
 
-#ifdef STM32IPL_ENABLE_JPEG
-/* Reads JPEG image file; the generated image will be Grayscale or RGB565 depending on the actual
- * image content; depending on the configuration file (stm32ipl_conf.h) the SW or the HW JPEG
- * decoder will be used.
+/* Reads PNM image file (see parsePnm()); the file is read in chunks of STM32IPL_FILE_BUFFER_SIZE bytes.
  * img		Image read; the pixel data is allocated internally and must be released
  * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
- * fp		Pointer to the input file structure.
+ * stream	Input stream.
  * return	stm32ipl_err_Ok on success, errors otherwise.
  */
-static stm32ipl_err_t readJpg(image_t *img, FIL *fp)
-{
-#ifdef STM32IPL_ENABLE_HW_JPEG_CODEC
-	return readJPEGHW(img, fp);
-#else
-	return readJPEGSW(img, fp);
-#endif
-}
-#endif /* STM32IPL_ENABLE_JPEG */
-
-/**
- * @brief Reads image file; supported file formats are: BMP, PPM, PGM, JPG.
- * - BMP: supported files are: 1, 4, 8 bits/pixel with palette; 16 bits/pixels
- * with or without BITFIELDS; 24 bits/pixels; compressed BI_RGB and BI_BITFIELDS.
- * The generated image will be:
- * 	* Binary in case the input file has 1 bit/pixel with black and white palette.
- * 	* Grayscale in case the input file has 8 bits/pixel with a complete grayscale
- * 	palette (equal RGB channels for all the palette items).
- * 	* RGB565 in case the input file has 16 bits/pixel (RGB555 or RGB565).
- * 	* RGB888 in case the input file has 24 bits/pixel.
- * - PPM: the generated image will be RGB888.
- * - PGM: the generated image will be Grayscale.
- * - JPEG: the generated image will be Grayscale or RGB565, depending on the actual image content.
- * Depending on the configuration file (stm32ipl_conf.h) the SW or the HW JPEG decoder will be used.
- * @param img		Image: if it is not valid, an error is returned; the given img->data is considered null.
- * The pixel data buffer is allocated internally and must be released with STM32Ipl_ReleaseData() by the caller.
- * @param filename	Name of the input file.
- * @return			stm32ipl_err_Ok on success, errors otherwise.
- */
-stm32ipl_err_t STM32Ipl_ReadImage(image_t *img, const char *filename)
+static stm32ipl_err_t readPnm(image_t *img, ipl_stream_t *stream)
 {
-	FIL fp;
-	uint32_t bytesRead = 0;
-	uint8_t magic[2];
+	FileBuffer buf;
 	stm32ipl_err_t res;
 
-	const uint8_t bmp[2] = { 0x42, 0x4D }; /* BM */
-	const uint8_t p2[2] = { 0x50, 0x32 }; /* P2 */
-	const uint8_t p3[2] = { 0x50, 0x33 }; /* P3 */
-	const uint8_t p5[2] = { 0x50, 0x35 }; /* P5 */
-	const uint8_t p6[2] = { 0x50, 0x36 }; /* P6 */
-#ifdef STM32IPL_ENABLE_JPEG
-	const uint8_t jpg[2] = { 0xFF, 0xD8 }; /* FFD8 */
-#endif /* STM32IPL_ENABLE_JPEG */
-
-	if (!img || !filename)
+	if (!img || !stream)
 		return stm32ipl_err_InvalidParameter;
 
-	if (f_open(&fp, (const TCHAR*)filename, FA_OPEN_EXISTING | FA_READ) != FR_OK)
-		return stm32ipl_err_OpeningFile;
+	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
 
-	if ((f_read(&fp, magic, 2, (UINT*)&bytesRead) != FR_OK) || bytesRead != 2) {
-		f_close(&fp);
-		return stm32ipl_err_ReadingFile;
-	}
+	if (!ipl_stream_seek(stream, 0))
+		return stm32ipl_err_SeekingFile;
 
-	if (memcmp(bmp, magic, 2) == 0)
-		res = readBmp(img, &fp);
-	else
-		if ((memcmp(p2, magic, 1) == 0)
-				&& ((memcmp(p2, magic, 2) == 0) || (memcmp(p3, magic, 2) == 0) || (memcmp(p5, magic, 2) == 0)
-						|| (memcmp(p6, magic, 2) == 0)))
-			res = readPnm(img, &fp);
-		else
-#ifdef STM32IPL_ENABLE_JPEG
-			if (memcmp(jpg, magic, 2) == 0)
-				res = readJpg(img, &fp);
-			else
-#endif /* STM32IPL_ENABLE_JPEG */
-				res = stm32ipl_err_UnsupportedFormat;
+	if (!openFileBuffer(&buf, stream, 0, 1, 0, false))
+		return stm32ipl_err_OutOfMemory;
 
-	f_close(&fp);
+	res = parsePnm(img, &buf);
+
+	closeFileBuffer(&buf);
 
 	return res;
 }
 
-/* Writes the BMP header to the file.
- * fp			Pointer to the input file structure.
- * width		Width of the image.
- * height		Height of the image.
- * dataOffset	Offset, in bytes, from the beginning of the file to the image pixels.
- * lineSize		Size of a bitmap line (in bytes).
- * bitsPP		Number of bits per pixel.
- * compression	The type of compression used (0 or BI_BITFIELDS).
- * paletteColorUsed	The number of palette items used.
- * return stm32ipl_err_Ok on success, errors otherwise.
+/* IPR and IPQ files: a 16 bytes header followed by the pixel data; all the values are little endian.
+ * - Bytes 0-3: "IPLR" (IPR, raw pixel data) or "IPLQ" (IPQ, pixel data encoded by the IPQ codec).
+ * - Bytes 4-7: width.
+ * - Bytes 8-11: height.
+ * - Byte 12: format (image_bpp_t).
+ * - Bytes 13-15: reserved (0).
+ * The raw pixel data is the data of the image as it is in memory. The IPQ codec is a lossless single pass codec
+ * derived from QOI: the pixels are scanned in the order of the image (the state is carried from a line to the next)
+ * and each one is encoded as a run of the previous pixel, an index in a table of the recently seen pixels,
+ * a small difference from the previous pixel or a literal value. The codes are:
+ * - Grayscale: 0b0ddddddd difference in [-64, 63]; 0b10aaabbb two pixels with differences in [-4, 3] (each from
+ * the previous pixel, in the same line); 0b11rrrrrr run of r + 1 pixels (r < 62); 0xFE, value.
+ * - RGB565 and RGB888: 0b00iiiiii index; 0b01rrggbb channel differences in [-2, 1]; 0b10gggggg, rrrrbbbb green
+ * difference in [-32, 31] and red and blue differences from it (from half of it for RGB565) in [-8, 7];
+ * 0b11rrrrrr run of r + 1 pixels (r < 62); 0xFE, literal pixel (2 bytes RGB565, 3 bytes RGB888 R, G, B).
+ * The differences are computed in the channel ranges (5, 6, 5 bits for RGB565), with wrap around.
  */
-static stm32ipl_err_t writeBmpHeader(FIL *fp, uint32_t width, uint32_t height, uint32_t dataOffset, uint32_t lineSize,
-		uint32_t bitsPP, uint32_t compression, uint32_t paletteColorUsed)
+#define IPL_FILE_HEADER_SIZE	16
+#define IPQ_OP_LITERAL			0xFE
+#define IPQ_OP_RUN				0xC0
+#define IPQ_MAX_RUN				62
+#define IPQ_HASH(r, g, b)		((((r) * 3) + ((g) * 5) + ((b) * 7)) & 63)
+
+/* State of the IPQ codec, carried from a line to the next. */
+typedef struct _IpqState
 {
-	FRESULT res;
-	uint8_t header[54];
-	uint32_t fileSize;
-	uint32_t imageSize;
-	UINT bytesWritten;
+	uint32_t prev;			/* Previous pixel (0xRRGGBB for RGB888). */
+	uint32_t run;			/* Number of pixels equal to the previous one, not yet encoded or decoded. */
+	uint32_t index[64];		/* Pixels recently seen, by hash (RGB565 and RGB888). */
+} IpqState;
+
+/* Decodes a line of IPQ pixels.
+ * state	Codec state.
+ * buf		Buffer of the input file (opened with lineSize = 1 and nLines = 0).
+ * dst		Decoded pixels.
+ * width	Number of pixels of the line.
+ * bpp		Format of the pixels (Grayscale, RGB565 or RGB888).
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t decodeIpqLine(IpqState *state, FileBuffer *buf, uint8_t *dst, uint32_t width, image_bpp_t bpp)
+{
+	uint32_t prev = state->prev;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
 
-	memset(&header, 0, 54);
+	for (uint32_t i = 0; (i < width) && (res == stm32ipl_err_Ok); i++) {
+		uint8_t op;
 
-	imageSize = lineSize * height;
-	fileSize = dataOffset + imageSize;
+		if (state->run == 0) {
+			res = readFileByte(buf, &op);
+			if (res != stm32ipl_err_Ok)
+				break;
 
-	/* Write header. */
+			if (op > IPQ_OP_LITERAL)
+				return stm32ipl_err_ReadingFile;
 
-	/* Signature. */
-	header[0] = 'B';
-	header[1] = 'M';
+			if ((op >= IPQ_OP_RUN) && (op < IPQ_OP_LITERAL))
+				state->run = (op & 0x3F) + 1;
+		}
 
-	/* File size. */
-	header[2] = (uint8_t)((fileSize & 0XFF));
-	header[3] = (uint8_t)((fileSize >> 8) & 0XFF);
-	header[4] = (uint8_t)((fileSize >> 16) & 0xFF);
-	header[5] = (uint8_t)((fileSize >> 24) & 0xFF);
+		if (state->run) {
+			/* The previous pixel is repeated. */
+			state->run--;
+		} else
+			if (bpp == IMAGE_BPP_GRAYSCALE) {
+				if (op < 0x80) {
+					prev = (prev + (((int8_t)(op << 1)) >> 1)) & 0xFF;
+				} else
+					if (op < IPQ_OP_RUN) {
+						if ((i + 1) >= width)
+							return stm32ipl_err_ReadingFile;
+
+						prev = (prev + ((op >> 3) & 7) - 4) & 0xFF;
+						dst[i++] = prev;
+						prev = (prev + (op & 7) - 4) & 0xFF;
+					} else {
+						uint8_t value;
 
-	/* Data offset. */
+						res = readFileByte(buf, &value);
+						prev = value;
+					}
+			} else {
+				int32_t r;
+				int32_t g;
+				int32_t b;
+				uint8_t value[3];
+
+				if (bpp == IMAGE_BPP_RGB565) {
+					r = COLOR_RGB565_TO_R5(prev);
+					g = COLOR_RGB565_TO_G6(prev);
+					b = COLOR_RGB565_TO_B5(prev);
+				} else {
+					r = (prev >> 16) & 0xFF;
+					g = (prev >> 8) & 0xFF;
+					b = prev & 0xFF;
+				}
+
+				switch (op >> 6) {
+					case 0:
+						prev = state->index[op];
+						break;
+
+					case 1:
+						r += ((op >> 4) & 3) - 2;
+						g += ((op >> 2) & 3) - 2;
+						b += (op & 3) - 2;
+						break;
+
+					case 2: {
+						int32_t dg = (op & 0x3F) - 32;
+						int32_t dc = (bpp == IMAGE_BPP_RGB565) ? (dg >> 1) : dg;
+
+						res = readFileByte(buf, value);
+						r += dc + (value[0] >> 4) - 8;
+						g += dg;
+						b += dc + (value[0] & 0xF) - 8;
+						break;
+					}
+
+					default: {
+						if (bpp == IMAGE_BPP_RGB565) {
+							res = readFileBytes(buf, value, 2);
+							prev = value[0] | (value[1] << 8);
+						} else {
+							res = readFileBytes(buf, value, 3);
+							prev = (value[0] << 16) | (value[1] << 8) | value[2];
+						}
+						break;
+					}
+				}
+
+				if ((op >> 6) == 1 || (op >> 6) == 2) {
+					if (bpp == IMAGE_BPP_RGB565)
+						prev = COLOR_R5_G6_B5_TO_RGB565(r & 0x1F, g & 0x3F, b & 0x1F);
+					else
+						prev = ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+				}
+
+				if ((op >> 6) != 0) {
+					if (bpp == IMAGE_BPP_RGB565)
+						state->index[IPQ_HASH(COLOR_RGB565_TO_R5(prev), COLOR_RGB565_TO_G6(prev),
+								COLOR_RGB565_TO_B5(prev))] = prev;
+					else
+						state->index[IPQ_HASH((prev >> 16) & 0xFF, (prev >> 8) & 0xFF, prev & 0xFF)] = prev;
+				}
+			}
+
+		switch (bpp) {
+			case IMAGE_BPP_GRAYSCALE:
+				dst[i] = prev;
+				break;
+
+			case IMAGE_BPP_RGB565:
+				((uint16_t*)dst)[i] = prev;
+				break;
+
+			default:
+				dst[(i * 3)] = prev & 0xFF;
+				dst[(i * 3) + 1] = (prev >> 8) & 0xFF;
+				dst[(i * 3) + 2] = (prev >> 16) & 0xFF;
+				break;
+		}
+	}
+
+	state->prev = prev;
+
+	return res;
+}
+
+/* Parses the header of an IPR or IPQ file (see decodeIpqLine()).
+ * header		Header (IPL_FILE_HEADER_SIZE bytes).
+ * width		Width of the image.
+ * height		Height of the image.
+ * bpp			Format of the image.
+ * compressed	true for IPQ, false for IPR.
+ * return		stm32ipl_err_Ok on success, stm32ipl_err_UnsupportedFormat otherwise.
+ */
+static stm32ipl_err_t parseIplHeader(const uint8_t *header, uint32_t *width, uint32_t *height, image_bpp_t *bpp,
+		bool *compressed)
+{
+	if (memcmp(header, "IPL", 3) != 0 || (header[3] != 'R' && header[3] != 'Q'))
+		return stm32ipl_err_UnsupportedFormat;
+
+	*compressed = (header[3] == 'Q');
+	*width = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+	*height = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+	*bpp = (image_bpp_t)header[12];
+
+	if (*width == 0 || *height == 0 || *width > 0xFFFF || *height > 0xFFFF
+			|| ((uint64_t)*width * *height * 3) > UINT32_MAX)
+		return stm32ipl_err_UnsupportedFormat;
+
+	if (*bpp != IMAGE_BPP_BINARY && *bpp != IMAGE_BPP_GRAYSCALE && *bpp != IMAGE_BPP_RGB565
+			&& *bpp != IMAGE_BPP_RGB888)
+		return stm32ipl_err_UnsupportedFormat;
+
+	if (*compressed && *bpp == IMAGE_BPP_BINARY)
+		return stm32ipl_err_UnsupportedFormat;
+
+	return stm32ipl_err_Ok;
+}
+
+/* Reads IPR or IPQ image file (see decodeIpqLine()); the generated image has the format stored in the file header.
+ * img		Image read; the pixel data is allocated internally and must be released
+ * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
+ * stream	Input stream.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readIpl(image_t *img, ipl_stream_t *stream)
+{
+	uint8_t header[IPL_FILE_HEADER_SIZE];
+	uint32_t bytesRead;
+	uint32_t width;
+	uint32_t height;
+	image_bpp_t bpp;
+	bool compressed;
+	uint8_t *outData;
+	uint32_t size;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+
+	if (!img || !stream)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
+
+	if (!ipl_stream_seek(stream, 0))
+		return stm32ipl_err_SeekingFile;
+
+	if (!ipl_stream_read(stream, header, IPL_FILE_HEADER_SIZE, &bytesRead) || (bytesRead != IPL_FILE_HEADER_SIZE))
+		return stm32ipl_err_ReadingFile;
+
+	res = parseIplHeader(header, &width, &height, &bpp, &compressed);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	size = STM32Ipl_DataSize(width, height, bpp);
+	outData = xalloc(size);
+	if (!outData)
+		return stm32ipl_err_OutOfMemory;
+
+	if (compressed) {
+		FileBuffer buf;
+		IpqState *state;
+		uint32_t lineSize = size / height;
+
+		state = xalloc0(sizeof(IpqState));
+		if (!state) {
+			xfree(outData);
+			return stm32ipl_err_OutOfMemory;
+		}
+
+		if (!openFileBuffer(&buf, stream, 0, 1, 0, false)) {
+			xfree(state);
+			xfree(outData);
+			return stm32ipl_err_OutOfMemory;
+		}
+
+		for (uint32_t y = 0; (y < height) && (res == stm32ipl_err_Ok); y++)
+			res = decodeIpqLine(state, &buf, outData + (y * lineSize), width, bpp);
+
+		closeFileBuffer(&buf);
+		xfree(state);
+	} else
+		if (!ipl_stream_read(stream, outData, size, &bytesRead) || (bytesRead != size))
+			res = stm32ipl_err_ReadingFile;
+
+	if (res != stm32ipl_err_Ok) {
+		xfree(outData);
+		return res;
+	}
+
+	STM32Ipl_Init(img, width, height, bpp, outData);
+
+	return stm32ipl_err_Ok;
+}
+
+#ifdef STM32IPL_ENABLE_JPEG
+/* Reads JPEG image file; the generated image will be Grayscale or RGB565 depending on the actual
+ * image content; depending on the configuration file (stm32ipl_conf.h) the SW or the HW JPEG
+ * decoder will be used.
+ * img		Image read; the pixel data is allocated internally and must be released
+ * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
+ * stream	Input stream.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readJpg(image_t *img, ipl_stream_t *stream)
+{
+#ifdef STM32IPL_ENABLE_HW_JPEG_CODEC
+	return readJPEGHW(img, stream);
+#else
+	return readJPEGSW(img, stream);
+#endif
+}
+#endif /* STM32IPL_ENABLE_JPEG */
+
+/* Reads an image from the given stream, whose format is determined by its first two bytes (see STM32Ipl_ReadImage()).
+ * img		Image read; the pixel data is allocated internally and must be released
+ * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
+ * stream	Input stream.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t readImage(image_t *img, ipl_stream_t *stream)
+{
+	uint32_t bytesRead = 0;
+	uint8_t magic[2];
+
+	const uint8_t bmp[2] = { 0x42, 0x4D }; /* BM */
+	const uint8_t p2[2] = { 0x50, 0x32 }; /* P2 */
+	const uint8_t p3[2] = { 0x50, 0x33 }; /* P3 */
+	const uint8_t p5[2] = { 0x50, 0x35 }; /* P5 */
+	const uint8_t p6[2] = { 0x50, 0x36 }; /* P6 */
+	const uint8_t ipl[2] = { 0x49, 0x50 }; /* IP */
+#ifdef STM32IPL_ENABLE_JPEG
+	const uint8_t jpg[2] = { 0xFF, 0xD8 }; /* FFD8 */
+#endif /* STM32IPL_ENABLE_JPEG */
+
+	if (!ipl_stream_read(stream, magic, 2, &bytesRead) || bytesRead != 2)
+		return stm32ipl_err_ReadingFile;
+
+	if (memcmp(bmp, magic, 2) == 0)
+		return readBmp(img, stream);
+
+	if ((memcmp(p2, magic, 1) == 0)
+			&& ((memcmp(p2, magic, 2) == 0) || (memcmp(p3, magic, 2) == 0) || (memcmp(p5, magic, 2) == 0)
+					|| (memcmp(p6, magic, 2) == 0)))
+		return readPnm(img, stream);
+
+	if (memcmp(ipl, magic, 2) == 0)
+		return readIpl(img, stream);
+
+#ifdef STM32IPL_ENABLE_JPEG
+	if (memcmp(jpg, magic, 2) == 0)
+		return readJpg(img, stream);
+#endif /* STM32IPL_ENABLE_JPEG */
+
+	return stm32ipl_err_UnsupportedFormat;
+}
+
+/**
+ * @brief Reads image file; supported file formats are: BMP, PPM, PGM, JPG, IPR, IPQ.
+ * - BMP: supported files are: 1, 4, 8 bits/pixel with palette; 16 bits/pixels
+ * with or without BITFIELDS; 24 bits/pixels; compressed BI_RGB and BI_BITFIELDS.
+ * The generated image will be:
+ * 	* Binary in case the input file has 1 bit/pixel with black and white palette.
+ * 	* Grayscale in case the input file has 8 bits/pixel with a complete grayscale
+ * 	palette (equal RGB channels for all the palette items).
+ * 	* RGB565 in case the input file has 16 bits/pixel (RGB555 or RGB565).
+ * 	* RGB888 in case the input file has 24 bits/pixel.
+ * - PPM: the generated image will be RGB888.
+ * - PGM: the generated image will be Grayscale.
+ * - JPEG: the generated image will be Grayscale or RGB565, depending on the actual image content.
+ * Depending on the configuration file (stm32ipl_conf.h) the SW or the HW JPEG decoder will be used.
+ * - IPR, IPQ: the generated image will have the format of the saved image.
+ * @param img		Image: if it is not valid, an error is returned; the given img->data is considered null.
+ * The pixel data buffer is allocated internally and must be released with STM32Ipl_ReleaseData() by the caller.
+ * @param filename	Name of the input file.
+ * @return			stm32ipl_err_Ok on success, errors otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ReadImage(image_t *img, const char *filename)
+{
+	FIL fp;
+	ipl_stream_t stream;
+	stm32ipl_err_t res;
+
+	if (!img || !filename)
+		return stm32ipl_err_InvalidParameter;
+
+	if (f_open(&fp, (const TCHAR*)filename, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+		return stm32ipl_err_OpeningFile;
+
+	ipl_stream_init_file(&stream, &fp);
+
+	res = readImage(img, &stream);
+
+	f_close(&fp);
+
+	return res;
+}
+
+/**
+ * @brief Decodes an image from a memory buffer that contains a whole image file; the supported file formats and the
+ * generated images are the ones of STM32Ipl_ReadImage(), which is the same function working on a memory buffer
+ * instead of a FatFs file.
+ * @param buf		Buffer with the image file; if it is not valid, an error is returned.
+ * @param len		Size of the image file (bytes).
+ * @param img		Image: if it is not valid, an error is returned; the given img->data is considered null.
+ * The pixel data buffer is allocated internally and must be released with STM32Ipl_ReleaseData() by the caller.
+ * @return			stm32ipl_err_Ok on success, errors otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DecodeFromBuffer(const uint8_t *buf, uint32_t len, image_t *img)
+{
+	ipl_stream_t stream;
+
+	if (!buf || !img)
+		return stm32ipl_err_InvalidParameter;
+
+	/* The stream is only read, so the buffer is never modified. */
+	ipl_stream_init_memory(&stream, (uint8_t*)buf, len, len);
+
+	return readImage(img, &stream);
+}
+
+/**
+ * @brief Binds the image to the pixel data of an IPR file (see STM32Ipl_WriteImage()) stored in memory, without
+ * copying it: the image data points directly into the buffer, that can be read-only memory (e.g. memory-mapped
+ * QSPI/OSPI flash or external RAM) and must stay valid while the image is used. Only the header and the size
+ * are validated and nothing is allocated, so the image must not be released with STM32Ipl_ReleaseData();
+ * the image must only be used as source (e.g. as template of STM32Ipl_FindTemplate()) when the buffer is read-only.
+ * The pixel data starts 16 bytes after the beginning of the buffer, so its alignment is the one of the buffer.
+ * @param buf		Buffer that contains the IPR file; if it is not valid, an error is returned.
+ * @param len		Size of the buffer (bytes).
+ * @param img		Image; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, stm32ipl_err_UnsupportedFormat if the buffer does not contain an
+ * IPR file, stm32ipl_err_WrongSize if it is shorter than the image, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BindImage(const uint8_t *buf, uint32_t len, image_t *img)
+{
+	uint32_t width;
+	uint32_t height;
+	image_bpp_t bpp;
+	bool compressed;
+	stm32ipl_err_t res;
+
+	if (!buf || !img)
+		return stm32ipl_err_InvalidParameter;
+
+	if (len < IPL_FILE_HEADER_SIZE)
+		return stm32ipl_err_WrongSize;
+
+	res = parseIplHeader(buf, &width, &height, &bpp, &compressed);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	if (compressed)
+		return stm32ipl_err_UnsupportedFormat;
+
+	if ((len - IPL_FILE_HEADER_SIZE) < STM32Ipl_DataSize(width, height, bpp))
+		return stm32ipl_err_WrongSize;
+
+	STM32Ipl_Init(img, width, height, bpp, (uint8_t*)buf + IPL_FILE_HEADER_SIZE);
+
+	return stm32ipl_err_Ok;
+}
+
+///@cond
+/**
+ * Computes the size of an image scaled down to fit the given size, keeping its aspect ratio; the image is never
+ * scaled up and the scaled sizes are at least one pixel.
+ * srcW		Width of the image.
+ * srcH		Height of the image.
+ * maxW		Maximum width of the scaled image (greater than zero).
+ * maxH		Maximum height of the scaled image (greater than zero).
+ * width	Width of the scaled image.
+ * height	Height of the scaled image.
+ */
+void ipl_fit_size(uint32_t srcW, uint32_t srcH, uint32_t maxW, uint32_t maxH, uint32_t *width, uint32_t *height)
+{
+	*width = srcW;
+	*height = srcH;
+
+	if ((srcW <= maxW) && (srcH <= maxH))
+		return;
+
+	if (((uint64_t)srcW * maxH) >= ((uint64_t)srcH * maxW)) {
+		*width = maxW;
+		*height = (uint32_t)((((uint64_t)srcH * maxW) + (srcW / 2)) / srcW);
+	} else {
+		*width = (uint32_t)((((uint64_t)srcW * maxH) + (srcH / 2)) / srcH);
+		*height = maxH;
+	}
+
+	*width = (*width > 0) ? *width : 1;
+	*height = (*height > 0) ? *height : 1;
+}
+///@endcond
+
+/**
+ * @brief Reads image file, scales it down to fit the given size (keeping its aspect ratio, never scaling it up)
+ * and converts it to the given format. The supported file formats are the ones of STM32Ipl_ReadImage().
+ * JPEG files decoded by the SW decoder are decoded directly at the smallest DCT scale (1/1, 1/2, 1/4, 1/8) that
+ * is not smaller than the scaled image, and each decoded line is averaged into the scaled image, so that the full
+ * size image is never allocated; the other files (and the JPEG files decoded by the HW codec) are read at full
+ * size, then resized (RESIZE_AREA) and converted with STM32Ipl_ResizeConvert().
+ * @param img		Image: if it is not valid, an error is returned; the given img->data is considered null.
+ * The pixel data buffer is allocated internally and must be released with STM32Ipl_ReleaseData() by the caller.
+ * @param filename	Name of the input file.
+ * @param maxW		Maximum width of the image read; it must be greater than zero.
+ * @param maxH		Maximum height of the image read; it must be greater than zero.
+ * @param format	Format of the image read (Grayscale, RGB565 or RGB888).
+ * @return			stm32ipl_err_Ok on success, errors otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ReadImageScaled(image_t *img, const char *filename, uint32_t maxW, uint32_t maxH,
+		image_bpp_t format)
+{
+	FIL fp;
+	ipl_stream_t stream;
+	image_t full;
+	uint32_t width;
+	uint32_t height;
+	stm32ipl_err_t res;
+
+	if (!img || !filename || !maxW || !maxH)
+		return stm32ipl_err_InvalidParameter;
+
+	if ((format != IMAGE_BPP_GRAYSCALE) && (format != IMAGE_BPP_RGB565) && (format != IMAGE_BPP_RGB888))
+		return stm32ipl_err_UnsupportedFormat;
+
+	if (f_open(&fp, (const TCHAR*)filename, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+		return stm32ipl_err_OpeningFile;
+
+	ipl_stream_init_file(&stream, &fp);
+
+#if defined(STM32IPL_ENABLE_JPEG) && !defined(STM32IPL_ENABLE_HW_JPEG_CODEC)
+	{
+		const uint8_t jpg[2] = { 0xFF, 0xD8 }; /* FFD8 */
+		uint32_t bytesRead = 0;
+		uint8_t magic[2];
+
+		if (!ipl_stream_read(&stream, magic, 2, &bytesRead) || bytesRead != 2) {
+			f_close(&fp);
+			return stm32ipl_err_ReadingFile;
+		}
+
+		if (memcmp(jpg, magic, 2) == 0) {
+			res = readJPEGSWScaled(img, &stream, maxW, maxH, format);
+			f_close(&fp);
+			return res;
+		}
+
+		if (!ipl_stream_seek(&stream, 0)) {
+			f_close(&fp);
+			return stm32ipl_err_SeekingFile;
+		}
+	}
+#endif /* STM32IPL_ENABLE_JPEG && !STM32IPL_ENABLE_HW_JPEG_CODEC */
+
+	res = readImage(&full, &stream);
+
+	f_close(&fp);
+
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	ipl_fit_size(full.w, full.h, maxW, maxH, &width, &height);
+
+	if ((width == full.w) && (height == full.h) && (full.bpp == format)) {
+		*img = full;
+		return stm32ipl_err_Ok;
+	}
+
+	res = STM32Ipl_AllocData(img, width, height, format);
+	if (res == stm32ipl_err_Ok) {
+		res = STM32Ipl_ResizeConvert(&full, NULL, img, RESIZE_AREA);
+		if (res != stm32ipl_err_Ok)
+			STM32Ipl_ReleaseData(img);
+	}
+
+	STM32Ipl_ReleaseData(&full);
+
+	return res;
+}
+
+/* Writes the BMP header to the file.
+ * stream		Output stream.
+ * width		Width of the image.
+ * height		Height of the image.
+ * dataOffset	Offset, in bytes, from the beginning of the file to the image pixels.
+ * lineSize		Size of a bitmap line (in bytes).
+ * bitsPP		Number of bits per pixel.
+ * compression	The type of compression used (0 or BI_BITFIELDS).
+ * paletteColorUsed	The number of palette items used.
+ * return stm32ipl_err_Ok on success, errors otherwise.
+ */
+static stm32ipl_err_t writeBmpHeader(ipl_stream_t *stream, uint32_t width, uint32_t height, uint32_t dataOffset,
+		uint32_t lineSize, uint32_t bitsPP, uint32_t compression, uint32_t paletteColorUsed)
+{
+	uint8_t header[54];
+	uint32_t fileSize;
+	uint32_t imageSize;
+	uint32_t bytesWritten;
+
+	memset(&header, 0, 54);
+
+	imageSize = lineSize * height;
+	fileSize = dataOffset + imageSize;
+
+	/* Write header. */
+
+	/* Signature. */
+	header[0] = 'B';
+	header[1] = 'M';
+
+	/* File size. */
+	header[2] = (uint8_t)((fileSize & 0XFF));
+	header[3] = (uint8_t)((fileSize >> 8) & 0XFF);
+	header[4] = (uint8_t)((fileSize >> 16) & 0xFF);
+	header[5] = (uint8_t)((fileSize >> 24) & 0xFF);
+
+	/* Data offset. */
 	header[10] = (uint8_t)((dataOffset & 0XFF));
 	header[11] = (uint8_t)((dataOffset >> 8) & 0XFF);
 	header[12] = (uint8_t)((dataOffset >> 16) & 0xFF);
@@ -1265,12 +1835,10 @@ static stm32ipl_err_t writeBmpHeader(FIL *fp, uint32_t width, uint32_t height, u
 	/* biClrImportant. */
 	//header[50] = 0;
 	/* Write header */
-	res = f_write(fp, header, 14, &bytesWritten);
-	if (res != FR_OK || bytesWritten != 14)
+	if (!ipl_stream_write(stream, header, 14, &bytesWritten) || bytesWritten != 14)
 		return stm32ipl_err_WritingFile;
 
-	res = f_write(fp, header + 14, 40, &bytesWritten);
-	if (res != FR_OK || bytesWritten != 40)
+	if (!ipl_stream_write(stream, header + 14, 40, &bytesWritten) || bytesWritten != 40)
 		return stm32ipl_err_WritingFile;
 
 	return stm32ipl_err_Ok;
@@ -1303,204 +1871,117 @@ static uint8_t reverse8(uint8_t val)
  * - RGB565 image is saved as 16 bits BMP with BITFIELDS.
  * - RGB888 image is saved as 24 bits BMP.
  * img		Image to be saved.
- * filename	Name of the output file.
+ * stream	Output stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t saveBmp(const image_t *img, const char *filename)
+static stm32ipl_err_t saveBmp(const image_t *img, ipl_stream_t *stream)
 {
-	FIL fp;
-	FRESULT res;
+	FileBuffer buf;
+	stm32ipl_err_t err;
 	uint32_t width;
 	uint32_t height;
 	uint32_t lineSize;
-	uint32_t padding;
-	UINT bytesWritten;
+	uint32_t dataLen;
+	uint32_t bytesWritten;
 
 	width = img->w;
 	height = img->h;
 
-	if (f_open(&fp, (const TCHAR*)filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
-		return stm32ipl_err_OpeningFile;
-
 	switch (img->bpp) {
 		case IMAGE_BPP_BINARY: {
-			uint32_t palette = 0;
+			uint32_t palette[2] = { 0, 0xFFFFFF };
 			lineSize = (((width) + 31) / 32) * 4;
+			dataLen = lineSize;
 
 			/* Header. */
-			if (stm32ipl_err_Ok != writeBmpHeader(&fp, width, height, 54 + 8, lineSize, 1, 0, 2)) {
-				f_close(&fp);
+			if (stm32ipl_err_Ok != writeBmpHeader(stream, width, height, 54 + 8, lineSize, 1, 0, 2))
 				return stm32ipl_err_WritingFile;
-			}
-
-			/* Palette. */
-			res = f_write(&fp, &palette, sizeof(palette), &bytesWritten);
-			if (res != FR_OK || bytesWritten != sizeof(palette)) {
-				f_close(&fp);
-				return stm32ipl_err_WritingFile;
-			}
-			palette = 0xFFFFFF;
-			res = f_write(&fp, &palette, sizeof(palette), &bytesWritten);
-			if (res != FR_OK || bytesWritten != sizeof(palette)) {
-				f_close(&fp);
-				return stm32ipl_err_WritingFile;
-			}
-
-			for (int32_t i = height - 1; i >= 0; i--) {
-				uint32_t offset = i * lineSize;
-				uint8_t *srcData = img->data + offset;
-
-				/* Image data. */
-				for (uint32_t j = 0; j < lineSize; j++) {
-					uint8_t dstData = reverse8(*(srcData + j));
 
-					res = f_write(&fp, &dstData, 1, &bytesWritten);
-					if (res != FR_OK || bytesWritten != 1) {
-						f_close(&fp);
-						return stm32ipl_err_WritingFile;
-					}
-				}
-			}
+			/* Palette. */
+			if (!ipl_stream_write(stream, palette, sizeof(palette), &bytesWritten) || bytesWritten != sizeof(palette))
+				return stm32ipl_err_WritingFile;
 			break;
 		}
 
 		case IMAGE_BPP_GRAYSCALE: {
+			uint32_t palette[256];
 			lineSize = (((width * 8) + 31) / 32) * 4;
-			padding = lineSize - width;
+			dataLen = width;
 
 			/* Header. */
-			if (stm32ipl_err_Ok != writeBmpHeader(&fp, width, height, 54 + 1024, lineSize, 8, 0, 256)) {
-				f_close(&fp);
+			if (stm32ipl_err_Ok != writeBmpHeader(stream, width, height, 54 + 1024, lineSize, 8, 0, 256))
 				return stm32ipl_err_WritingFile;
-			}
 
 			/* Palette. */
-			for (uint32_t i = 0; i < 256; i++) {
-				uint32_t value = (i << 16) | (i << 8) | i;
-				res = f_write(&fp, &value, sizeof(value), &bytesWritten);
-				if (res != FR_OK || bytesWritten != 4) {
-					f_close(&fp);
-					return stm32ipl_err_WritingFile;
-				}
-			}
-
-			for (int32_t i = height - 1; i >= 0; i--) {
-				uint32_t offset = i * width;
-
-				/* Image data. */
-				res = f_write(&fp, img->data + offset, width, &bytesWritten);
-				if (res != FR_OK || bytesWritten != width) {
-					f_close(&fp);
-					return stm32ipl_err_WritingFile;
-				}
+			for (uint32_t i = 0; i < 256; i++)
+				palette[i] = (i << 16) | (i << 8) | i;
 
-				/* Padding. */
-				for (uint32_t j = 0; j < padding; j++) {
-					if (1 != f_putc(0, &fp)) {
-						f_close(&fp);
-						return stm32ipl_err_WritingFile;
-					}
-				}
-			}
+			if (!ipl_stream_write(stream, palette, sizeof(palette), &bytesWritten) || bytesWritten != sizeof(palette))
+				return stm32ipl_err_WritingFile;
 			break;
 		}
 
 		case IMAGE_BPP_RGB565: {
-			uint32_t mask;
-			uint32_t dataLen = width << 1;
+			uint32_t mask[3] = { 0xF800, 0x7E0, 0x1F };
 			lineSize = (((width * 16) + 31) / 32) * 4;
-			padding = lineSize - dataLen;
+			dataLen = width << 1;
 
 			/* Header. */
-			if (stm32ipl_err_Ok != writeBmpHeader(&fp, width, height, 14 + 40 + 12, lineSize, 16, BI_BITFIELDS, 0)) {
-				f_close(&fp);
+			if (stm32ipl_err_Ok != writeBmpHeader(stream, width, height, 14 + 40 + 12, lineSize, 16, BI_BITFIELDS, 0))
 				return stm32ipl_err_WritingFile;
-			}
 
 			/* Bit masks. */
-			mask = 0xF800;
-			res = f_write(&fp, &mask, 4, &bytesWritten);
-			if (res != FR_OK || bytesWritten != 4) {
-				f_close(&fp);
-				return stm32ipl_err_WritingFile;
-			}
-			mask = 0x7E0;
-			res = f_write(&fp, &mask, 4, &bytesWritten);
-			if (res != FR_OK || bytesWritten != 4) {
-				f_close(&fp);
+			if (!ipl_stream_write(stream, mask, sizeof(mask), &bytesWritten) || bytesWritten != sizeof(mask))
 				return stm32ipl_err_WritingFile;
-			}
-			mask = 0x1F;
-			res = f_write(&fp, &mask, 4, &bytesWritten);
-			if (res != FR_OK || bytesWritten != 4) {
-				f_close(&fp);
-				return stm32ipl_err_WritingFile;
-			}
-
-			for (int32_t i = height - 1; i >= 0; i--) {
-				uint32_t offset = i * width;
-
-				/* Image data. */
-				res = f_write(&fp, ((uint16_t*)img->data) + offset, dataLen, &bytesWritten);
-				if (res != FR_OK || bytesWritten != dataLen) {
-					f_close(&fp);
-					return stm32ipl_err_WritingFile;
-				}
-
-				/* Padding. */
-				for (uint32_t j = 0; j < padding; j++) {
-					if (1 != f_putc(0, &fp)) {
-						f_close(&fp);
-						return stm32ipl_err_WritingFile;
-					}
-				}
-			}
-
 			break;
 		}
 
 		case IMAGE_BPP_RGB888: {
-			uint32_t dataLen = width * 3;
 			lineSize = (((width * 24) + 31) / 32) * 4;
-			padding = lineSize - dataLen;
+			dataLen = width * 3;
 
 			/* Header. */
-			if (stm32ipl_err_Ok != writeBmpHeader(&fp, width, height, 14 + 40, lineSize, 24, 0, 0)) {
-				f_close(&fp);
+			if (stm32ipl_err_Ok != writeBmpHeader(stream, width, height, 14 + 40, lineSize, 24, 0, 0))
 				return stm32ipl_err_WritingFile;
-			}
+			break;
+		}
 
-			for (int32_t i = height - 1; i >= 0; i--) {
-				uint8_t *data = img->data + i * dataLen;
+		default:
+			return stm32ipl_err_InvalidParameter;
+	};
 
-				/* Image data. */
-				res = f_write(&fp, data, dataLen, &bytesWritten);
-				if (res != FR_OK || bytesWritten != dataLen) {
-					f_close(&fp);
-					return stm32ipl_err_WritingFile;
-				}
+	/* The lines, from the last one, are written in chunks. */
+	if (!openFileBuffer(&buf, stream, 0, lineSize, height, false))
+		return stm32ipl_err_OutOfMemory;
 
-				/* Padding. */
-				for (uint32_t j = 0; j < padding; j++) {
-					if (1 != f_putc(0, &fp)) {
-						f_close(&fp);
-						return stm32ipl_err_WritingFile;
-					}
-				}
-			}
+	err = stm32ipl_err_Ok;
 
+	for (int32_t i = height - 1; (i >= 0) && (err == stm32ipl_err_Ok); i--) {
+		const uint8_t *srcData = img->data + (i * dataLen);
+		uint8_t *dstData;
+
+		err = writeFileLine(&buf, &dstData);
+		if (err != stm32ipl_err_Ok)
 			break;
-		}
 
-		default: {
-			f_close(&fp);
-			return stm32ipl_err_InvalidParameter;
+		/* Image data. */
+		if (img->bpp == IMAGE_BPP_BINARY) {
+			for (uint32_t j = 0; j < lineSize; j++)
+				dstData[j] = reverse8(srcData[j]);
+		} else {
+			memcpy(dstData, srcData, dataLen);
+
+			/* Padding. */
+			memset(dstData + dataLen, 0, lineSize - dataLen);
 		}
-	};
+	}
 
-	f_close(&fp);
+	if (err == stm32ipl_err_Ok)
+		err = flushFileBuffer(&buf);
 
-	return stm32ipl_err_Ok;
+	closeFileBuffer(&buf);
+
+	return err;
 }
 
 /*
@@ -1511,20 +1992,19 @@ static stm32ipl_err_t saveBmp(const image_t *img, const char *filename)
  * - RGB565 is saved as 24 bits PPM.
  * - RGB888 is saved as 24 bits PPM.
  * img		Image to be saved.
- * filename	Name of the output file.
+ * stream	Output stream.
  * format	Format of the PNM file (6 if the input image is RGB565 or RGB888, 5 if it's Grayscale).
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t savePnm(const image_t *img, const char *filename, uint8_t format)
+static stm32ipl_err_t savePnm(const image_t *img, ipl_stream_t *stream, uint8_t format)
 {
-	FIL fp;
-	FRESULT res;
+	FileBuffer buf;
+	stm32ipl_err_t err;
 	uint32_t size;
 	int32_t width;
 	int32_t height;
 	char text[64];
-	UINT bytesWritten;
-	uint32_t offset;
+	uint32_t bytesWritten;
 
 	width = img->w;
 	height = img->h;
@@ -1532,14 +2012,8 @@ static stm32ipl_err_t savePnm(const image_t *img, const char *filename, uint8_t
 	/* Write header. */
 	size = snprintf(text, sizeof(text), "P%d\n# Created by STM32IPL\n%ld %ld\n255\n", format, width, height);
 
-	if (f_open(&fp, (const TCHAR*)filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
-		return stm32ipl_err_OpeningFile;
-
-	res = f_write(&fp, text, size, &bytesWritten);
-	if (res != FR_OK || bytesWritten != size) {
-		f_close(&fp);
+	if (!ipl_stream_write(stream, text, size, &bytesWritten) || bytesWritten != size)
 		return stm32ipl_err_WritingFile;
-	}
 
 	switch (img->bpp) {
 		/* TODO: case IMAGE_BPP_BINARY */
@@ -1547,67 +2021,64 @@ static stm32ipl_err_t savePnm(const image_t *img, const char *filename, uint8_t
 		case IMAGE_BPP_GRAYSCALE: {
 			size = width * height;
 
-			res = f_write(&fp, img->data, size, &bytesWritten);
-			if (res != FR_OK || bytesWritten != size) {
-				f_close(&fp);
+			if (!ipl_stream_write(stream, img->data, size, &bytesWritten) || bytesWritten != size)
 				return stm32ipl_err_WritingFile;
-			}
 			break;
 		}
 
-		case IMAGE_BPP_RGB565: {
-			for (uint32_t i = 0; i < height; i++) {
-				offset = i * width;
+		case IMAGE_BPP_RGB565:
+		case IMAGE_BPP_RGB888: {
+			/* The lines are converted and written in chunks. */
+			if (!openFileBuffer(&buf, stream, 0, width * 3, height, false))
+				return stm32ipl_err_OutOfMemory;
 
-				for (uint32_t j = 0; j < width; j++) {
-					rgb888_t rgb888;
-					uint16_t rgb565 = *(((uint16_t*)img->data) + offset + j);
-
-					/* R and B must be swapped. */
-					rgb888.r = COLOR_RGB565_TO_B8(rgb565);
-					rgb888.g = COLOR_RGB565_TO_G8(rgb565);
-					rgb888.b = COLOR_RGB565_TO_R8(rgb565);
-
-					res = f_write(&fp, &rgb888, 3, &bytesWritten);
-					if (res != FR_OK || bytesWritten != 3) {
-						f_close(&fp);
-						return stm32ipl_err_WritingFile;
-					}
-				}
-			}
-			break;
-		}
+			err = stm32ipl_err_Ok;
 
-		case IMAGE_BPP_RGB888: {
-			uint8_t *data = img->data;
-			size = width * height;
+			for (uint32_t i = 0; (i < height) && (err == stm32ipl_err_Ok); i++) {
+				rgb888_t *rgb888;
 
-			for (uint32_t i = 0; i < size; i++) {
-				rgb888_t rgb888;
+				err = writeFileLine(&buf, (uint8_t**)&rgb888);
+				if (err != stm32ipl_err_Ok)
+					break;
 
-				/* R and B must be swapped. */
-				rgb888.r = *data++;
-				rgb888.g = *data++;
-				rgb888.b = *data++;
+				if (img->bpp == IMAGE_BPP_RGB565) {
+					const uint16_t *srcData = ((uint16_t*)img->data) + (i * width);
 
-				res = f_write(&fp, &rgb888, 3, &bytesWritten);
-				if (res != FR_OK || bytesWritten != 3) {
-					f_close(&fp);
-					return stm32ipl_err_WritingFile;
+					for (uint32_t j = 0; j < width; j++) {
+						uint16_t rgb565 = srcData[j];
+
+						/* R and B must be swapped. */
+						rgb888[j].r = COLOR_RGB565_TO_B8(rgb565);
+						rgb888[j].g = COLOR_RGB565_TO_G8(rgb565);
+						rgb888[j].b = COLOR_RGB565_TO_R8(rgb565);
+					}
+				} else {
+					const uint8_t *srcData = img->data + (i * width * 3);
+
+					for (uint32_t j = 0; j < width; j++) {
+						/* R and B must be swapped. */
+						rgb888[j].r = *srcData++;
+						rgb888[j].g = *srcData++;
+						rgb888[j].b = *srcData++;
+					}
 				}
 			}
 
+			if (err == stm32ipl_err_Ok)
+				err = flushFileBuffer(&buf);
+
+			closeFileBuffer(&buf);
+
+			if (err != stm32ipl_err_Ok)
+				return err;
+
 			break;
 		}
 
-		default: {
-			f_close(&fp);
+		default:
 			return stm32ipl_err_UnsupportedFormat;
-		}
 	}
 
-	f_close(&fp);
-
 	return stm32ipl_err_Ok;
 }
 
@@ -1619,10 +2090,10 @@ static stm32ipl_err_t savePnm(const image_t *img, const char *filename, uint8_t
  * - RGB565 is saved as 24 bits PPM.
  * - RGB888 is saved as 24 bits PPM.
  * img		Image to be saved.
- * filename	Name of the output file.
+ * stream	Output stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t savePpm(const image_t *img, const char *filename)
+static stm32ipl_err_t savePpm(const image_t *img, ipl_stream_t *stream)
 {
 	uint8_t format;
 
@@ -1641,7 +2112,7 @@ static stm32ipl_err_t savePpm(const image_t *img, const char *filename)
 			return stm32ipl_err_UnsupportedFormat;
 	}
 
-	return savePnm(img, filename, format);
+	return savePnm(img, stream, format);
 }
 
 /* Checks if the format of the input image is compatible with the PGM file extension.
@@ -1652,10 +2123,10 @@ static stm32ipl_err_t savePpm(const image_t *img, const char *filename)
  * - RGB565 is not compatible with PGM.
  * - RGB888 is not compatible with PGM.
  * img		Image to be saved.
- * filename	Name of the output file.
+ * stream	Output stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t savePgm(const image_t *img, const char *filename)
+static stm32ipl_err_t savePgm(const image_t *img, ipl_stream_t *stream)
 {
 	uint8_t format;
 
@@ -1676,7 +2147,213 @@ static stm32ipl_err_t savePgm(const image_t *img, const char *filename)
 			return stm32ipl_err_UnsupportedFormat;
 	}
 
-	return savePnm(img, filename, format);
+	return savePnm(img, stream, format);
+}
+
+/* Encodes a line of pixels with the IPQ codec (see decodeIpqLine()); the run in progress at the end of the line is
+ * kept in the state, to be continued by the next line or closed by the caller at the end of the image.
+ * state	Codec state.
+ * src		Pixels to be encoded.
+ * width	Number of pixels of the line.
+ * bpp		Format of the pixels (Grayscale, RGB565 or RGB888).
+ * dst		Encoded data; it must be able to contain (width * (bytes per pixel + 1)) + 1 bytes.
+ * return	Size of the encoded data (bytes).
+ */
+static uint32_t encodeIpqLine(IpqState *state, const uint8_t *src, uint32_t width, image_bpp_t bpp, uint8_t *dst)
+{
+	uint32_t prev = state->prev;
+	uint8_t *out = dst;
+
+	for (uint32_t i = 0; i < width; i++) {
+		uint32_t pixel;
+
+		switch (bpp) {
+			case IMAGE_BPP_GRAYSCALE:
+				pixel = src[i];
+				break;
+
+			case IMAGE_BPP_RGB565:
+				pixel = ((const uint16_t*)src)[i];
+				break;
+
+			default:
+				pixel = src[(i * 3)] | (src[(i * 3) + 1] << 8) | (src[(i * 3) + 2] << 16);
+				break;
+		}
+
+		if (pixel == prev) {
+			if (++state->run == IPQ_MAX_RUN) {
+				*out++ = IPQ_OP_RUN | (state->run - 1);
+				state->run = 0;
+			}
+			continue;
+		}
+
+		if (state->run) {
+			*out++ = IPQ_OP_RUN | (state->run - 1);
+			state->run = 0;
+		}
+
+		if (bpp == IMAGE_BPP_GRAYSCALE) {
+			int32_t d = (int8_t)(pixel - prev);
+
+			if ((d >= -4) && (d <= 3) && ((i + 1) < width) && ((int8_t)(src[i + 1] - pixel) >= -4)
+					&& ((int8_t)(src[i + 1] - pixel) <= 3)) {
+				/* Two pixels with a single code. */
+				*out++ = 0x80 | ((d + 4) << 3) | ((int8_t)(src[i + 1] - pixel) + 4);
+				pixel = src[++i];
+			} else
+				if ((d >= -64) && (d <= 63)) {
+					*out++ = d & 0x7F;
+				} else {
+					*out++ = IPQ_OP_LITERAL;
+					*out++ = pixel;
+				}
+		} else {
+			int32_t dr;
+			int32_t dg;
+			int32_t db;
+			int32_t vr;
+			int32_t vb;
+			uint32_t hash;
+
+			if (bpp == IMAGE_BPP_RGB565) {
+				hash = IPQ_HASH(COLOR_RGB565_TO_R5(pixel), COLOR_RGB565_TO_G6(pixel), COLOR_RGB565_TO_B5(pixel));
+				dr = ((COLOR_RGB565_TO_R5(pixel) - COLOR_RGB565_TO_R5(prev) + 16) & 0x1F) - 16;
+				dg = ((COLOR_RGB565_TO_G6(pixel) - COLOR_RGB565_TO_G6(prev) + 32) & 0x3F) - 32;
+				db = ((COLOR_RGB565_TO_B5(pixel) - COLOR_RGB565_TO_B5(prev) + 16) & 0x1F) - 16;
+				vr = ((dr - (dg >> 1) + 16) & 0x1F) - 16;
+				vb = ((db - (dg >> 1) + 16) & 0x1F) - 16;
+			} else {
+				hash = IPQ_HASH((pixel >> 16) & 0xFF, (pixel >> 8) & 0xFF, pixel & 0xFF);
+				dr = (int8_t)((pixel >> 16) - (prev >> 16));
+				dg = (int8_t)((pixel >> 8) - (prev >> 8));
+				db = (int8_t)(pixel - prev);
+				vr = (int8_t)(dr - dg);
+				vb = (int8_t)(db - dg);
+			}
+
+			if (state->index[hash] == pixel) {
+				*out++ = hash;
+			} else {
+				state->index[hash] = pixel;
+
+				if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1)) {
+					*out++ = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+				} else
+					if ((dg >= -32) && (dg <= 31) && (vr >= -8) && (vr <= 7) && (vb >= -8) && (vb <= 7)) {
+						*out++ = 0x80 | (dg + 32);
+						*out++ = ((vr + 8) << 4) | (vb + 8);
+					} else {
+						*out++ = IPQ_OP_LITERAL;
+						if (bpp == IMAGE_BPP_RGB565) {
+							*out++ = pixel & 0xFF;
+							*out++ = pixel >> 8;
+						} else {
+							*out++ = (pixel >> 16) & 0xFF;
+							*out++ = (pixel >> 8) & 0xFF;
+							*out++ = pixel & 0xFF;
+						}
+					}
+			}
+		}
+
+		prev = pixel;
+	}
+
+	state->prev = prev;
+
+	return out - dst;
+}
+
+/* Writes the given image to IPR (raw) or IPQ (compressed) file (see decodeIpqLine()); the supported source image
+ * formats are: Binary (IPR only), Grayscale, RGB565 and RGB888. The image is stored as it is, so it can be read
+ * back exactly with the same format. The IPR file is written with a single call; the IPQ one is written in chunks
+ * of STM32IPL_FILE_BUFFER_SIZE bytes.
+ * img			Image to be saved.
+ * stream		Output stream.
+ * compressed	true for IPQ, false for IPR.
+ * return		stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t saveIpl(const image_t *img, ipl_stream_t *stream, bool compressed)
+{
+	uint8_t header[IPL_FILE_HEADER_SIZE] = { 'I', 'P', 'L', 'R' };
+	uint32_t size = STM32Ipl_ImageDataSize(img);
+	uint32_t bytesWritten;
+	FileBuffer buf;
+	IpqState *state;
+	uint8_t *line;
+	uint32_t lineSize;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+
+	switch (img->bpp) {
+		case IMAGE_BPP_BINARY:
+			if (compressed)
+				return stm32ipl_err_UnsupportedFormat;
+			break;
+
+		case IMAGE_BPP_GRAYSCALE:
+		case IMAGE_BPP_RGB565:
+		case IMAGE_BPP_RGB888:
+			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
+	}
+
+	if (compressed)
+		header[3] = 'Q';
+
+	for (uint32_t i = 0; i < 4; i++) {
+		header[4 + i] = ((uint32_t)img->w >> (i * 8)) & 0xFF;
+		header[8 + i] = ((uint32_t)img->h >> (i * 8)) & 0xFF;
+	}
+	header[12] = img->bpp;
+
+	if (!ipl_stream_write(stream, header, IPL_FILE_HEADER_SIZE, &bytesWritten) || bytesWritten != IPL_FILE_HEADER_SIZE)
+		return stm32ipl_err_WritingFile;
+
+	if (!compressed) {
+		if (!ipl_stream_write(stream, img->data, size, &bytesWritten) || bytesWritten != size)
+			return stm32ipl_err_WritingFile;
+
+		return stm32ipl_err_Ok;
+	}
+
+	lineSize = size / img->h;
+
+	state = xalloc0(sizeof(IpqState));
+	if (!state)
+		return stm32ipl_err_OutOfMemory;
+
+	line = xalloc((img->w * ((lineSize / img->w) + 1)) + 1);
+	if (!line) {
+		xfree(state);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	if (!openFileBuffer(&buf, stream, 0, 1, 0, false)) {
+		xfree(line);
+		xfree(state);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	for (uint32_t y = 0; (y < (uint32_t)img->h) && (res == stm32ipl_err_Ok); y++)
+		res = writeFileBytes(&buf, line, encodeIpqLine(state, img->data + (y * lineSize), img->w, img->bpp, line));
+
+	if ((res == stm32ipl_err_Ok) && state->run) {
+		line[0] = IPQ_OP_RUN | (state->run - 1);
+		res = writeFileBytes(&buf, line, 1);
+	}
+
+	if (res == stm32ipl_err_Ok)
+		res = flushFileBuffer(&buf);
+
+	closeFileBuffer(&buf);
+	xfree(line);
+	xfree(state);
+
+	return res;
 }
 
 #ifdef STM32IPL_ENABLE_JPEG
@@ -1689,10 +2366,10 @@ static stm32ipl_err_t savePgm(const image_t *img, const char *filename)
  * Depending on the configuration file (stm32ipl_conf.h) the SW or the HW
  * JPEG encoder will be used.
  * img		Image to be saved.
- * filename	Name of the output file.
+ * stream	Output stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t saveJpg(const image_t *img, const char *filename)
+static stm32ipl_err_t saveJpg(const image_t *img, ipl_stream_t *stream)
 {
 	if (img->bpp == IMAGE_BPP_BINARY)
 		return stm32ipl_err_UnsupportedFormat;
@@ -1709,27 +2386,66 @@ static stm32ipl_err_t saveJpg(const image_t *img, const char *filename)
 		if (STM32Ipl_Convert(img, &tmpImg))
 			return stm32ipl_err_UnsupportedFormat;
 
-		res = saveJPEGHW(&tmpImg, filename);
+		res = saveJPEGHW(&tmpImg, stream);
 
 		STM32Ipl_ReleaseData(&tmpImg);
 
 		return res;
 	} else
-		return saveJPEGHW(img, filename);
+		return saveJPEGHW(img, stream);
 #else
-	return saveJPEGSW(img, filename);
+	return saveJPEGSW(img, stream);
 #endif
 }
 #endif /* STM32IPL_ENABLE_JPEG */
 
+/* Writes the given image to the given stream with the given file format (see STM32Ipl_WriteImage()).
+ * img		Image to be saved.
+ * format	Format of the output file.
+ * stream	Output stream.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t writeImage(const image_t *img, ImageFileFormatType format, ipl_stream_t *stream)
+{
+	switch (format) {
+		case iplFileFormatBMP:
+			return saveBmp(img, stream);
+
+		case iplFileFormatPPM:
+			return savePpm(img, stream);
+
+		case iplFileFormatPGM:
+			return savePgm(img, stream);
+
+		case iplFileFormatIPR:
+			return saveIpl(img, stream, false);
+
+		case iplFileFormatIPQ:
+			return saveIpl(img, stream, true);
+
+#ifdef STM32IPL_ENABLE_JPEG
+		case iplFileFormatJPG:
+			return saveJpg(img, stream);
+#endif /* STM32IPL_ENABLE_JPEG */
+
+		default:
+			break;
+	}
+
+	return stm32ipl_err_UnsupportedFormat;
+}
+
 /**
  * @brief Writes the given image to file; the target file format is determined
- * by the filename extension; the supported output file formats are: BMP, PPM, PGM, JPG.
+ * by the filename extension; the supported output file formats are: BMP, PPM, PGM, JPG, IPR, IPQ.
  * The supported source image formats are: Binary, Grayscale, RGB565 and RGB888:
- * - Binary can be saved to BMP only
- * - Grayscale can be saved to BMP, raw PGM or JPEG
- * - RGB565 can be saved to BMP, PPM or JPEG
- * - RGB888 can be saved to BMP, PPM or JPEG
+ * - Binary can be saved to BMP or IPR
+ * - Grayscale can be saved to BMP, raw PGM, JPEG, IPR or IPQ
+ * - RGB565 can be saved to BMP, PPM, JPEG, IPR or IPQ
+ * - RGB888 can be saved to BMP, PPM, JPEG, IPR or IPQ
+ * IPR stores the image data as it is (with a 16 bytes header), so it is the fastest format to write;
+ * IPQ stores it losslessly compressed with a fast single pass codec; both are read back exactly, with the same
+ * image format, by STM32Ipl_ReadImage().
  * Depending on the configuration file (stm32ipl_conf.h) the SW or the HW
  * JPEG encoder will be used.
  * img		Image to be saved; if it is not valid, an error is returned.
@@ -1738,6 +2454,11 @@ static stm32ipl_err_t saveJpg(const image_t *img, const char *filename)
  */
 stm32ipl_err_t STM32Ipl_WriteImage(const image_t *img, const char *filename)
 {
+	ImageFileFormatType format;
+	FIL fp;
+	ipl_stream_t stream;
+	stm32ipl_err_t res;
+
 	if (!img || !img->data || !filename)
 		return stm32ipl_err_InvalidParameter;
 
@@ -1745,26 +2466,96 @@ stm32ipl_err_t STM32Ipl_WriteImage(const image_t *img, const char *filename)
 			&& img->bpp != IMAGE_BPP_RGB888)
 		return stm32ipl_err_UnsupportedFormat;
 
-	switch (getImageFileFormat(filename)) {
-		case iplFileFormatBMP:
-			return saveBmp(img, filename);
+	if (img->stride)
+		return stm32ipl_err_NotAllowed;
 
-		case iplFileFormatPPM:
-			return savePpm(img, filename);
+	format = getImageFileFormat(filename);
+	if (format == iplFileFormatUnknown)
+		return stm32ipl_err_UnsupportedFormat;
 
-		case iplFileFormatPGM:
-			return savePgm(img, filename);
+	if (f_open(&fp, (const TCHAR*)filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+		return stm32ipl_err_OpeningFile;
 
-#ifdef STM32IPL_ENABLE_JPEG
-		case iplFileFormatJPG:
-			return saveJpg(img, filename);
-#endif /* STM32IPL_ENABLE_JPEG */
+	ipl_stream_init_file(&stream, &fp);
 
-		default:
+	res = writeImage(img, format, &stream);
+
+	f_close(&fp);
+
+	return res;
+}
+
+/**
+ * @brief Encodes the given image to a memory buffer, with the given file format; the supported source image
+ * formats and file formats are the ones of STM32Ipl_WriteImage(), which is the same function working on a
+ * memory buffer instead of a FatFs file.
+ * When the buffer is too small, the encoding is completed anyway (the exceeding bytes are dropped),
+ * stm32ipl_err_WrongSize is returned and len is set to the size needed; so the needed size can be
+ * also queried with a null buffer and zero capacity.
+ * @param img		Image to be encoded; if it is not valid, an error is returned.
+ * @param format	Format of the encoded image.
+ * @param buf		Buffer that receives the encoded image; it can be null only if cap is zero.
+ * @param cap		Capacity of the buffer (bytes).
+ * @param len		Size of the encoded image (bytes); if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_EncodeToBuffer(const image_t *img, stm32ipl_file_format_t format, uint8_t *buf, uint32_t cap,
+		uint32_t *len)
+{
+	ImageFileFormatType fileFormat;
+	ipl_stream_t stream;
+	stm32ipl_err_t res;
+
+	if (!img || !img->data || (!buf && cap) || !len)
+		return stm32ipl_err_InvalidParameter;
+
+	*len = 0;
+
+	if (img->bpp != IMAGE_BPP_BINARY && img->bpp != IMAGE_BPP_GRAYSCALE && img->bpp != IMAGE_BPP_RGB565
+			&& img->bpp != IMAGE_BPP_RGB888)
+		return stm32ipl_err_UnsupportedFormat;
+
+	if (img->stride)
+		return stm32ipl_err_NotAllowed;
+
+	switch (format) {
+		case stm32ipl_file_format_bmp:
+			fileFormat = iplFileFormatBMP;
+			break;
+
+		case stm32ipl_file_format_ppm:
+			fileFormat = iplFileFormatPPM;
+			break;
+
+		case stm32ipl_file_format_pgm:
+			fileFormat = iplFileFormatPGM;
+			break;
+
+		case stm32ipl_file_format_jpg:
+			fileFormat = iplFileFormatJPG;
+			break;
+
+		case stm32ipl_file_format_ipr:
+			fileFormat = iplFileFormatIPR;
+			break;
+
+		case stm32ipl_file_format_ipq:
+			fileFormat = iplFileFormatIPQ;
 			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
 	}
 
-	return stm32ipl_err_UnsupportedFormat;
+	ipl_stream_init_memory(&stream, buf, 0, cap);
+
+	res = writeImage(img, fileFormat, &stream);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	*len = stream.size;
+
+	return (stream.size > cap) ? stm32ipl_err_WrongSize : stm32ipl_err_Ok;
 }
 
 #ifdef __cplusplus
@@ -1797,6 +2588,42 @@ stm32ipl_err_t STM32Ipl_WriteImage(const image_t *img, const char *filename)
 	return stm32ipl_err_NotImplemented;
 }
 
+stm32ipl_err_t STM32Ipl_DecodeFromBuffer(const uint8_t *buf, uint32_t len, image_t *img)
+{
+	/* Prevent unused argument(s) compilation warning. */
+	STM32IPL_UNUSED(buf);
+	STM32IPL_UNUSED(len);
+	STM32IPL_UNUSED(img);
+
+	/* Void implementation. */
+	return stm32ipl_err_NotImplemented;
+}
+
+stm32ipl_err_t STM32Ipl_BindImage(const uint8_t *buf, uint32_t len, image_t *img)
+{
+	/* Prevent unused argument(s) compilation warning. */
+	STM32IPL_UNUSED(buf);
+	STM32IPL_UNUSED(len);
+	STM32IPL_UNUSED(img);
+
+	/* Void implementation. */
+	return stm32ipl_err_NotImplemented;
+}
+
+stm32ipl_err_t STM32Ipl_EncodeToBuffer(const image_t *img, stm32ipl_file_format_t format, uint8_t *buf, uint32_t cap,
+		uint32_t *len)
+{
+	/* Prevent unused argument(s) compilation warning. */
+	STM32IPL_UNUSED(img);
+	STM32IPL_UNUSED(format);
+	STM32IPL_UNUSED(buf);
+	STM32IPL_UNUSED(cap);
+	STM32IPL_UNUSED(len);
+
+	/* Void implementation. */
+	return stm32ipl_err_NotImplemented;
+}
+
 #ifdef __cplusplus
 }
 #endif
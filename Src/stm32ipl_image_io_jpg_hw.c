@@ -0,0 +1,748 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_image_io_jpg_hw.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - JPEG HW codec
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+///@cond
+
+#include "stm32ipl_image_io_jpg_hw.h"
+
+#ifdef STM32IPL_ENABLE_IMAGE_IO
+#ifdef STM32IPL_ENABLE_JPEG
+#ifdef STM32IPL_ENABLE_HW_JPEG_CODEC
+
+#include "stm32ipl_imlib_int.h"
+#include "jpeg_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JPEG_HW_READ_CHUNK_SIZE		4096		/* Size (bytes) of the chunks of JPEG data read from the file. */
+#define JPEG_HW_WRITE_CHUNK_SIZE	4096		/* Size (bytes) of the chunks of JPEG data written to the file. */
+#define JPEG_HW_MCU_CHUNK_SIZE		(768 * 4)	/* Size (bytes) of the chunks of decoded MCUs (multiple of any MCU size). */
+#define JPEG_HW_CACHE_LINE			32			/* Size (bytes) of the data cache lines. */
+#define JPEG_HW_TIMEOUT				1000		/* Maximum time (ms) the codec can run without making progress. */
+
+#define JPEG_HW_ALIGN(x)	(((x) + JPEG_HW_CACHE_LINE - 1) & ~(JPEG_HW_CACHE_LINE - 1))
+
+/* Converts MCUs to pixels or pixels to MCUs; same signature as the jpeg_utils conversion functions. */
+typedef uint32_t (*ConvertMCUFunction)(uint8_t *src, uint8_t *dst, uint32_t blockIndex, uint32_t dataCount,
+		uint32_t *convertedCount);
+
+/* Buffer exchanged with the JPEG codec (through its DMA channels). */
+typedef struct
+{
+	uint8_t *data;			/* Data (cache line aligned). */
+	volatile uint32_t size;	/* Number of valid bytes. */
+	volatile bool full;		/* True when the data must be consumed (by the codec for input, by the CPU for output). */
+} JpegHwBuffer;
+
+/* State of the coding in progress, shared with the JPEG callbacks (executed by the JPEG and MDMA interrupts). */
+typedef struct
+{
+	JpegHwBuffer in[2];			/* Ping-pong buffers of data to be processed by the codec. */
+	JpegHwBuffer out[2];		/* Ping-pong buffers of data produced by the codec. */
+	uint32_t outSize;			/* Size (bytes) of the output buffers. */
+	volatile uint32_t inRead;	/* Index of the input buffer being read by the codec. */
+	volatile uint32_t inOffset;	/* Number of bytes of the input buffer already read by the codec. */
+	volatile uint32_t outWrite;	/* Index of the output buffer being written by the codec. */
+	volatile bool inPaused;		/* True when the codec waits for an input buffer. */
+	volatile bool outPaused;	/* True when the codec waits for an output buffer. */
+	volatile bool infoReady;	/* True when the header of the decoded image has been parsed. */
+	volatile bool done;			/* True when the coding is complete. */
+	volatile bool error;		/* True when the codec reported an error. */
+	JPEG_ConfTypeDef info;		/* Header of the decoded image. */
+} JpegHwState;
+
+static JPEG_HandleTypeDef jpegHwHandle;
+static JpegHwState jpegHw;
+static bool jpegHwReady;
+static uint32_t jpegHwGrayWidth;	/* Width (pixels) of the frame converted by the grayscale functions. */
+
+/* Cleans the data cache lines of the given buffer, so that the codec reads the data written by the CPU. */
+static void cleanCache(const uint8_t *data, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	if (SCB->CCR & SCB_CCR_DC_Msk)
+		SCB_CleanDCache_by_Addr((uint32_t*)data, (int32_t)JPEG_HW_ALIGN(size));
+#else
+	STM32IPL_UNUSED(data);
+	STM32IPL_UNUSED(size);
+#endif /* __DCACHE_PRESENT */
+}
+
+/* Invalidates the data cache lines of the given buffer, so that the CPU reads the data written by the codec. */
+static void invalidateCache(const uint8_t *data, uint32_t size)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	if (SCB->CCR & SCB_CCR_DC_Msk)
+		SCB_InvalidateDCache_by_Addr((uint32_t*)data, (int32_t)JPEG_HW_ALIGN(size));
+#else
+	STM32IPL_UNUSED(data);
+	STM32IPL_UNUSED(size);
+#endif /* __DCACHE_PRESENT */
+}
+
+/* Gets the size (pixels) of the MCUs of the given JPEG configuration. */
+static void getMCUSize(const JPEG_ConfTypeDef *conf, uint32_t *mcuW, uint32_t *mcuH)
+{
+	*mcuW = 8;
+	*mcuH = 8;
+
+	if (conf->ColorSpace == JPEG_YCBCR_COLORSPACE) {
+		if (conf->ChromaSubsampling == JPEG_420_SUBSAMPLING) {
+			*mcuW = 16;
+			*mcuH = 16;
+		} else
+			if (conf->ChromaSubsampling == JPEG_422_SUBSAMPLING)
+				*mcuW = 16;
+	}
+}
+
+/* Copies the given grayscale MCUs (8x8 blocks) to the frame (jpegHwGrayWidth pixels wide).
+ * src				Grayscale MCUs.
+ * dst				Frame.
+ * blockIndex		Index of the first MCU to be copied.
+ * dataCount		Size (bytes) of the MCUs.
+ * convertedCount	Number of pixels copied.
+ * return			Number of MCUs copied.
+ */
+static uint32_t convertMCUToGray(uint8_t *src, uint8_t *dst, uint32_t blockIndex, uint32_t dataCount,
+		uint32_t *convertedCount)
+{
+	uint32_t mcuPerLine = jpegHwGrayWidth / 8;
+	uint32_t nMCU = dataCount / 64;
+
+	for (uint32_t i = 0; i < nMCU; i++) {
+		uint32_t index = blockIndex + i;
+		uint8_t *out = dst + (((index / mcuPerLine) * 8) * jpegHwGrayWidth) + ((index % mcuPerLine) * 8);
+
+		for (uint32_t y = 0; y < 8; y++) {
+			memcpy(out, src, 8);
+			out += jpegHwGrayWidth;
+			src += 8;
+		}
+	}
+
+	*convertedCount = nMCU * 64;
+
+	return nMCU;
+}
+
+/* Splits the given grayscale lines (jpegHwGrayWidth pixels wide, 8 lines) into MCUs (8x8 blocks).
+ * src				Frame lines.
+ * dst				Grayscale MCUs.
+ * blockIndex		Index of the first MCU of the lines (unused: the lines start at a MCU row).
+ * dataCount		Size (bytes) of the lines.
+ * convertedCount	Size (bytes) of the generated MCUs.
+ * return			Number of MCUs generated.
+ */
+static uint32_t convertGrayToMCU(uint8_t *src, uint8_t *dst, uint32_t blockIndex, uint32_t dataCount,
+		uint32_t *convertedCount)
+{
+	uint32_t mcuPerLine = jpegHwGrayWidth / 8;
+	uint32_t nMCU = (dataCount / (jpegHwGrayWidth * 8)) * mcuPerLine;
+
+	STM32IPL_UNUSED(blockIndex);
+
+	for (uint32_t i = 0; i < nMCU; i++) {
+		const uint8_t *in = src + (((i / mcuPerLine) * 8) * jpegHwGrayWidth) + ((i % mcuPerLine) * 8);
+
+		for (uint32_t y = 0; y < 8; y++) {
+			memcpy(dst, in, 8);
+			in += jpegHwGrayWidth;
+			dst += 8;
+		}
+	}
+
+	*convertedCount = nMCU * 64;
+
+	return nMCU;
+}
+
+/* Initializes the JPEG codec (once) and the coding state.
+ * buffers	Memory for the ping-pong buffers (cache line aligned).
+ * inSize	Size (bytes) of each input buffer (multiple of the cache line).
+ * outSize	Size (bytes) of each output buffer (multiple of the cache line).
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t initCodec(uint8_t *buffers, uint32_t inSize, uint32_t outSize)
+{
+	if (!jpegHwReady) {
+		jpegHwHandle.Instance = JPEG;
+		if (HAL_JPEG_Init(&jpegHwHandle) != HAL_OK)
+			return stm32ipl_err_Generic;
+
+		JPEG_InitColorTables();
+		jpegHwReady = true;
+	}
+
+	memset(&jpegHw, 0, sizeof(jpegHw));
+	jpegHw.in[0].data = buffers;
+	jpegHw.in[1].data = buffers + inSize;
+	jpegHw.out[0].data = buffers + (2 * inSize);
+	jpegHw.out[1].data = buffers + (2 * inSize) + outSize;
+	jpegHw.outSize = outSize;
+
+	return stm32ipl_err_Ok;
+}
+
+/* Waits for the codec to make progress: returns false on error or when the codec does not make progress
+ * within the timeout; tick is the time of the last progress and it is updated when progress is true.
+ */
+static bool waitCodec(bool progress, uint32_t *tick)
+{
+	if (jpegHw.error)
+		return false;
+
+	if (progress) {
+		*tick = HAL_GetTick();
+		return true;
+	}
+
+	return (HAL_GetTick() - *tick) <= JPEG_HW_TIMEOUT;
+}
+
+/* Hands the given input buffer to the codec, if the codec is waiting for it. */
+static void resumeInput(uint32_t index)
+{
+	if (jpegHw.inPaused && (index == jpegHw.inRead)) {
+		jpegHw.inPaused = false;
+		HAL_JPEG_ConfigInputBuffer(&jpegHwHandle, jpegHw.in[index].data, jpegHw.in[index].size);
+		HAL_JPEG_Resume(&jpegHwHandle, JPEG_PAUSE_RESUME_INPUT);
+	}
+}
+
+/* Releases the output buffer consumed by the CPU and restarts the codec, if it was waiting for it. */
+static void resumeOutput(uint32_t index)
+{
+	jpegHw.out[index].full = false;
+
+	if (jpegHw.outPaused) {
+		jpegHw.outPaused = false;
+		HAL_JPEG_Resume(&jpegHwHandle, JPEG_PAUSE_RESUME_OUTPUT);
+	}
+}
+
+/* Callback of the JPEG codec: the header of the decoded image has been parsed. */
+void HAL_JPEG_InfoReadyCallback(JPEG_HandleTypeDef *hjpeg, JPEG_ConfTypeDef *pInfo)
+{
+	STM32IPL_UNUSED(hjpeg);
+
+	jpegHw.info = *pInfo;
+	jpegHw.infoReady = true;
+}
+
+/* Callback of the JPEG codec: the given number of bytes of the current input buffer has been read. */
+void HAL_JPEG_GetDataCallback(JPEG_HandleTypeDef *hjpeg, uint32_t NbDecodedData)
+{
+	JpegHwBuffer *buffer = &jpegHw.in[jpegHw.inRead];
+
+	jpegHw.inOffset += NbDecodedData;
+	if (jpegHw.inOffset < buffer->size) {
+		HAL_JPEG_ConfigInputBuffer(hjpeg, buffer->data + jpegHw.inOffset, buffer->size - jpegHw.inOffset);
+		return;
+	}
+
+	buffer->full = false;
+	jpegHw.inOffset = 0;
+	jpegHw.inRead ^= 1;
+
+	buffer = &jpegHw.in[jpegHw.inRead];
+	if (buffer->full)
+		HAL_JPEG_ConfigInputBuffer(hjpeg, buffer->data, buffer->size);
+	else {
+		HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_INPUT);
+		jpegHw.inPaused = true;
+	}
+}
+
+/* Callback of the JPEG codec: the current output buffer contains the given number of bytes. */
+void HAL_JPEG_DataReadyCallback(JPEG_HandleTypeDef *hjpeg, uint8_t *pDataOut, uint32_t OutDataLength)
+{
+	STM32IPL_UNUSED(pDataOut);
+
+	jpegHw.out[jpegHw.outWrite].size = OutDataLength;
+	jpegHw.out[jpegHw.outWrite].full = true;
+	jpegHw.outWrite ^= 1;
+
+	if (jpegHw.out[jpegHw.outWrite].full) {
+		HAL_JPEG_Pause(hjpeg, JPEG_PAUSE_RESUME_OUTPUT);
+		jpegHw.outPaused = true;
+	}
+
+	HAL_JPEG_ConfigOutputBuffer(hjpeg, jpegHw.out[jpegHw.outWrite].data, jpegHw.outSize);
+}
+
+/* Callback of the JPEG codec: the decoding is complete. */
+void HAL_JPEG_DecodeCpltCallback(JPEG_HandleTypeDef *hjpeg)
+{
+	STM32IPL_UNUSED(hjpeg);
+
+	jpegHw.done = true;
+}
+
+/* Callback of the JPEG codec: the encoding is complete. */
+void HAL_JPEG_EncodeCpltCallback(JPEG_HandleTypeDef *hjpeg)
+{
+	STM32IPL_UNUSED(hjpeg);
+
+	jpegHw.done = true;
+}
+
+/* Callback of the JPEG codec: the coding failed. */
+void HAL_JPEG_ErrorCallback(JPEG_HandleTypeDef *hjpeg)
+{
+	STM32IPL_UNUSED(hjpeg);
+
+	jpegHw.error = true;
+}
+
+/* Reads JPEG image file by using the JPEG HW decoder; the generated image will be Grayscale or RGB565
+ * depending on the actual image content. The file is read in chunks, while the codec decodes the previous
+ * ones with its DMA channels and the CPU converts the decoded MCUs to pixels.
+ * img		Image read; the pixel data is allocated internally and must be released
+ * with STM32Ipl_ReleaseData(); assuming that input img->data is null.
+ * stream	Input stream.
+ * return	stm32ipl_err_Ok on success, errors otherwise.
+ */
+stm32ipl_err_t readJPEGHW(image_t *img, ipl_stream_t *stream)
+{
+	const uint32_t inSize = JPEG_HW_READ_CHUNK_SIZE;
+	const uint32_t outSize = JPEG_HW_MCU_CHUNK_SIZE;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	ConvertMCUFunction convertFn = 0;
+	uint8_t *buffers;
+	uint8_t *frame = 0;
+	uint32_t inWrite = 0;
+	uint32_t outRead = 0;
+	uint32_t mcuIndex = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t frameWidth = 0;
+	uint32_t frameHeight = 0;
+	uint32_t bpp = 0;
+	uint32_t tick;
+	bool eof = false;
+
+	if (!img || !stream)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
+
+	if (!ipl_stream_seek(stream, 0))
+		return stm32ipl_err_SeekingFile;
+
+	buffers = xalloc((2 * inSize) + (2 * outSize) + JPEG_HW_CACHE_LINE);
+	if (!buffers)
+		return stm32ipl_err_OutOfMemory;
+
+	res = initCodec((uint8_t*)JPEG_HW_ALIGN((uintptr_t)buffers), inSize, outSize);
+	if (res != stm32ipl_err_Ok) {
+		xfree(buffers);
+		return res;
+	}
+
+	/* Fills both the input buffers before starting the decoder. */
+	for (uint32_t i = 0; (i < 2) && !eof; i++) {
+		JpegHwBuffer *buffer = &jpegHw.in[i];
+		uint32_t bytesRead;
+
+		if (!ipl_stream_read(stream, buffer->data, inSize, &bytesRead)) {
+			xfree(buffers);
+			return stm32ipl_err_ReadingFile;
+		}
+
+		eof = bytesRead < inSize;
+		if (bytesRead) {
+			buffer->size = bytesRead;
+			buffer->full = true;
+			cleanCache(buffer->data, bytesRead);
+			inWrite ^= 1;
+		}
+	}
+
+	if (HAL_JPEG_Decode_DMA(&jpegHwHandle, jpegHw.in[0].data, jpegHw.in[0].size, jpegHw.out[0].data, outSize)
+			!= HAL_OK) {
+		xfree(buffers);
+		return stm32ipl_err_Generic;
+	}
+
+	tick = HAL_GetTick();
+
+	while (!jpegHw.done || jpegHw.out[outRead].full) {
+		bool progress = false;
+
+		/* Reads the next chunk of the file into the free input buffer. */
+		if (!eof && !jpegHw.in[inWrite].full) {
+			JpegHwBuffer *buffer = &jpegHw.in[inWrite];
+			uint32_t bytesRead;
+
+			if (!ipl_stream_read(stream, buffer->data, inSize, &bytesRead)) {
+				res = stm32ipl_err_ReadingFile;
+				break;
+			}
+
+			eof = bytesRead < inSize;
+			if (bytesRead) {
+				buffer->size = bytesRead;
+				cleanCache(buffer->data, bytesRead);
+				buffer->full = true;
+				resumeInput(inWrite);
+				inWrite ^= 1;
+				progress = true;
+			}
+		}
+
+		/* Allocates the image as soon as its header has been parsed; its width and height are extended to
+		 * a multiple of the MCU size, so that the conversion functions do not need to handle the borders. */
+		if (jpegHw.infoReady && !frame) {
+			JPEG_ConfTypeDef conf = jpegHw.info;
+			uint32_t mcuW;
+			uint32_t mcuH;
+			uint32_t nMCU;
+
+			if ((conf.ColorSpace != JPEG_GRAYSCALE_COLORSPACE) && (conf.ColorSpace != JPEG_YCBCR_COLORSPACE)) {
+				res = stm32ipl_err_UnsupportedFormat;
+				break;
+			}
+
+			getMCUSize(&conf, &mcuW, &mcuH);
+			width = conf.ImageWidth;
+			height = conf.ImageHeight;
+			frameWidth = ((width + mcuW - 1) / mcuW) * mcuW;
+			frameHeight = ((height + mcuH - 1) / mcuH) * mcuH;
+			conf.ImageWidth = frameWidth;
+			conf.ImageHeight = frameHeight;
+
+			if (conf.ColorSpace == JPEG_GRAYSCALE_COLORSPACE) {
+				bpp = IMAGE_BPP_GRAYSCALE;
+				jpegHwGrayWidth = frameWidth;
+				convertFn = convertMCUToGray;
+			} else {
+				JPEG_YCbCrToRGB_Convert_Function fn;
+
+				if (JPEG_GetDecodeColorConvertFunc(&conf, &fn, &nMCU) != HAL_OK) {
+					res = stm32ipl_err_UnsupportedFormat;
+					break;
+				}
+
+				bpp = IMAGE_BPP_RGB565;
+				convertFn = (ConvertMCUFunction)fn;
+			}
+
+			frame = xalloc(STM32Ipl_DataSize(frameWidth, frameHeight, (image_bpp_t)bpp));
+			if (!frame) {
+				res = stm32ipl_err_OutOfMemory;
+				break;
+			}
+
+			progress = true;
+		}
+
+		/* Converts the decoded MCUs to pixels. */
+		if (frame && jpegHw.out[outRead].full) {
+			JpegHwBuffer *buffer = &jpegHw.out[outRead];
+			uint32_t converted;
+
+			invalidateCache(buffer->data, buffer->size);
+			mcuIndex += convertFn(buffer->data, frame, mcuIndex, buffer->size, &converted);
+			resumeOutput(outRead);
+			outRead ^= 1;
+			progress = true;
+		}
+
+		if (!waitCodec(progress, &tick)) {
+			res = stm32ipl_err_Generic;
+			break;
+		}
+	}
+
+	if (res != stm32ipl_err_Ok) {
+		HAL_JPEG_Abort(&jpegHwHandle);
+		xfree(frame);
+		xfree(buffers);
+		return res;
+	}
+
+	xfree(buffers);
+
+	if (!frame)
+		return stm32ipl_err_Generic;
+
+	/* Removes the extension of the lines, if any. */
+	if ((frameWidth != width) || (frameHeight != height)) {
+		uint32_t lineSize = width * bpp;
+		uint8_t *data;
+
+		if (frameWidth != width)
+			for (uint32_t y = 1; y < height; y++)
+				memmove(frame + (y * lineSize), frame + (y * frameWidth * bpp), lineSize);
+
+		data = xrealloc(frame, STM32Ipl_DataSize(width, height, (image_bpp_t)bpp));
+		if (data)
+			frame = data;
+	}
+
+	STM32Ipl_Init(img, width, height, (image_bpp_t)bpp, frame);
+
+	return stm32ipl_err_Ok;
+}
+
+/* Converts the given MCU row of the image into MCUs by using the given conversion function; when the image width
+ * or height is not a multiple of the MCU size, the lines are first copied to the strip buffer, where they are
+ * extended by replicating the last pixel and the last line.
+ * img			Image to be encoded (Grayscale or RGB565).
+ * row			Index of the MCU row.
+ * mcuH			Height of the MCUs.
+ * frameWidth	Width of the image extended to a multiple of the MCU width.
+ * strip		Strip buffer, used only when the image has to be extended.
+ * convertFn	Function that converts the lines to MCUs.
+ * dst			Output MCUs.
+ * return		Size (bytes) of the generated MCUs.
+ */
+static uint32_t convertRowToMCU(const image_t *img, uint32_t row, uint32_t mcuH, uint32_t frameWidth,
+		uint8_t *strip, ConvertMCUFunction convertFn, uint8_t *dst)
+{
+	uint32_t bpp = img->bpp;
+	uint32_t lineSize = img->w * bpp;
+	uint32_t y0 = row * mcuH;
+	uint8_t *src;
+	uint32_t converted = 0;
+
+	if (strip) {
+		for (uint32_t y = 0; y < mcuH; y++) {
+			uint32_t srcY = ((y0 + y) < img->h) ? (y0 + y) : (img->h - 1);
+			uint8_t *line = strip + (y * frameWidth * bpp);
+
+			memcpy(line, img->data + (srcY * lineSize), lineSize);
+			for (uint32_t x = img->w; x < frameWidth; x++)
+				memcpy(line + (x * bpp), line + lineSize - bpp, bpp);
+		}
+		src = strip;
+	} else
+		src = img->data + (y0 * lineSize);
+
+	convertFn(src, dst, 0, frameWidth * mcuH * bpp, &converted);
+
+	return converted;
+}
+
+/* Encodes the given image to a JPEG stream by using the JPEG HW encoder. The CPU converts the image to MCUs and
+ * writes the encoded data to the file, while the codec encodes the previous MCUs with its DMA channels.
+ * img		Image to be encoded (supported formats are: RGB565, Grayscale).
+ * stream	Output stream.
+ * chromaSS	Chroma subsampling; 4:4:4, 4:2:2, 4:2:0 are supported.
+ * quality	Quality value used by the encoder (0-100), 100 means best quality.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t encodeJPEG(const image_t *img, ipl_stream_t *stream, uint32_t chromaSS, uint32_t quality)
+{
+	const uint32_t outSize = JPEG_HW_WRITE_CHUNK_SIZE;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	JPEG_ConfTypeDef conf;
+	ConvertMCUFunction convertFn;
+	uint8_t *buffers;
+	uint8_t *strip = 0;
+	uint32_t inSize;
+	uint32_t mcuW;
+	uint32_t mcuH;
+	uint32_t frameWidth;
+	uint32_t frameHeight;
+	uint32_t nRows;
+	uint32_t row = 0;
+	uint32_t inWrite = 0;
+	uint32_t outRead = 0;
+	uint32_t tick;
+
+	conf.ImageWidth = img->w;
+	conf.ImageHeight = img->h;
+	conf.ImageQuality = quality;
+
+	if (img->bpp == IMAGE_BPP_GRAYSCALE) {
+		conf.ColorSpace = JPEG_GRAYSCALE_COLORSPACE;
+		conf.ChromaSubsampling = JPEG_444_SUBSAMPLING;
+	} else {
+		conf.ColorSpace = JPEG_YCBCR_COLORSPACE;
+
+		switch (chromaSS) {
+			case STM32IPL_JPEG_444_SUBSAMPLING:
+				conf.ChromaSubsampling = JPEG_444_SUBSAMPLING;
+				break;
+
+			case STM32IPL_JPEG_420_SUBSAMPLING:
+				conf.ChromaSubsampling = JPEG_420_SUBSAMPLING;
+				break;
+
+			case STM32IPL_JPEG_422_SUBSAMPLING:
+				conf.ChromaSubsampling = JPEG_422_SUBSAMPLING;
+				break;
+
+			default:
+				return stm32ipl_err_UnsupportedFormat;
+		}
+	}
+
+	getMCUSize(&conf, &mcuW, &mcuH);
+	frameWidth = ((img->w + mcuW - 1) / mcuW) * mcuW;
+	frameHeight = ((img->h + mcuH - 1) / mcuH) * mcuH;
+	nRows = frameHeight / mcuH;
+
+	if (img->bpp == IMAGE_BPP_GRAYSCALE) {
+		jpegHwGrayWidth = frameWidth;
+		convertFn = convertGrayToMCU;
+		inSize = JPEG_HW_ALIGN(frameWidth * mcuH);
+	} else {
+		JPEG_ConfTypeDef frameConf = conf;
+		JPEG_RGBToYCbCr_Convert_Function fn;
+		uint32_t nMCU;
+
+		frameConf.ImageWidth = frameWidth;
+		frameConf.ImageHeight = frameHeight;
+		if (JPEG_GetEncodeColorConvertFunc(&frameConf, &fn, &nMCU) != HAL_OK)
+			return stm32ipl_err_UnsupportedFormat;
+
+		convertFn = (ConvertMCUFunction)fn;
+		inSize = JPEG_HW_ALIGN(frameWidth * mcuH * 3);
+	}
+
+	buffers = xalloc((2 * inSize) + (2 * outSize) + JPEG_HW_CACHE_LINE);
+	if (!buffers)
+		return stm32ipl_err_OutOfMemory;
+
+	if ((frameWidth != img->w) || (frameHeight != img->h)) {
+		strip = xalloc(frameWidth * mcuH * img->bpp);
+		if (!strip) {
+			xfree(buffers);
+			return stm32ipl_err_OutOfMemory;
+		}
+	}
+
+	res = initCodec((uint8_t*)JPEG_HW_ALIGN((uintptr_t)buffers), inSize, outSize);
+	if ((res == stm32ipl_err_Ok) && (HAL_JPEG_ConfigEncoding(&jpegHwHandle, &conf) != HAL_OK))
+		res = stm32ipl_err_Generic;
+
+	if (res != stm32ipl_err_Ok) {
+		xfree(strip);
+		xfree(buffers);
+		return res;
+	}
+
+	/* Fills both the input buffers before starting the encoder. */
+	for (uint32_t i = 0; (i < 2) && (row < nRows); i++) {
+		JpegHwBuffer *buffer = &jpegHw.in[i];
+
+		buffer->size = convertRowToMCU(img, row++, mcuH, frameWidth, strip, convertFn, buffer->data);
+		buffer->full = true;
+		cleanCache(buffer->data, buffer->size);
+		inWrite ^= 1;
+	}
+
+	if (HAL_JPEG_Encode_DMA(&jpegHwHandle, jpegHw.in[0].data, jpegHw.in[0].size, jpegHw.out[0].data, outSize)
+			!= HAL_OK) {
+		xfree(strip);
+		xfree(buffers);
+		return stm32ipl_err_Generic;
+	}
+
+	tick = HAL_GetTick();
+
+	while (!jpegHw.done || jpegHw.out[outRead].full) {
+		bool progress = false;
+
+		/* Converts the next MCU row into the free input buffer. */
+		if ((row < nRows) && !jpegHw.in[inWrite].full) {
+			JpegHwBuffer *buffer = &jpegHw.in[inWrite];
+
+			buffer->size = convertRowToMCU(img, row++, mcuH, frameWidth, strip, convertFn, buffer->data);
+			cleanCache(buffer->data, buffer->size);
+			buffer->full = true;
+			resumeInput(inWrite);
+			inWrite ^= 1;
+			progress = true;
+		}
+
+		/* Writes the encoded data to the file. */
+		if (jpegHw.out[outRead].full) {
+			JpegHwBuffer *buffer = &jpegHw.out[outRead];
+			uint32_t bytesWritten;
+
+			invalidateCache(buffer->data, buffer->size);
+			if (!ipl_stream_write(stream, buffer->data, buffer->size, &bytesWritten) || (bytesWritten != buffer->size)) {
+				res = stm32ipl_err_WritingFile;
+				break;
+			}
+
+			resumeOutput(outRead);
+			outRead ^= 1;
+			progress = true;
+		}
+
+		if (!waitCodec(progress, &tick)) {
+			res = stm32ipl_err_Generic;
+			break;
+		}
+	}
+
+	if (res != stm32ipl_err_Ok)
+		HAL_JPEG_Abort(&jpegHwHandle);
+
+	xfree(strip);
+	xfree(buffers);
+
+	return res;
+}
+
+/* Encodes the given image to a JPEG stream by using the JPEG HW encoder.
+ * img		Image to be encoded (supported formats are: RGB565, Grayscale).
+ * stream	Output stream.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t saveJPEGHW(const image_t *img, ipl_stream_t *stream)
+{
+	if (!img || !stream)
+		return stm32ipl_err_InvalidParameter;
+
+	if ((img->bpp != IMAGE_BPP_RGB565) && (img->bpp != IMAGE_BPP_GRAYSCALE))
+		return stm32ipl_err_UnsupportedFormat;
+
+	return encodeJPEG(img, stream, STM32IPL_JPEG_SUBSAMPLING, STM32IPL_JPEG_QUALITY);
+}
+
+///@endcond
+
+/**
+ * @brief Handles the interrupt of the JPEG codec used to read and write the JPEG files; it must be called
+ * by JPEG_IRQHandler(). The application initializes the JPEG clock, the MDMA channels (linked to the
+ * hdmain and hdmaout fields of the given handle) and their interrupts in HAL_JPEG_MspInit().
+ */
+void STM32Ipl_JpegIRQHandler(void)
+{
+	HAL_JPEG_IRQHandler(&jpegHwHandle);
+}
+
+///@cond
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_HW_JPEG_CODEC */
+#endif /* STM32IPL_ENABLE_JPEG */
+#endif /* STM32IPL_ENABLE_IMAGE_IO */
+
+///@endcond
@@ -144,10 +144,10 @@ static void ConvertLineGrayToGray(const uint8_t *src, uint8_t *dst, uint32_t wid
  * will be Grayscale or RGB565 depending on the file content.
  * img		Decoded image; the image data buffer is allocated internally; it is up to
  * the caller to release the image data when done with it with STM32Ipl_ReleaseData().
- * fp		Pointer to the file object.
+ * stream	Input stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-stm32ipl_err_t readJPEGSW(image_t *img, FIL *fp)
+stm32ipl_err_t readJPEGSW(image_t *img, ipl_stream_t *stream)
 {
 	struct jpeg_error_mgr jerr;
 	struct jpeg_decompress_struct cinfo;
@@ -158,17 +158,17 @@ stm32ipl_err_t readJPEGSW(image_t *img, FIL *fp)
 	uint32_t bpp = 0;
 	ConvertLineFunction convertFn = 0;
 
-	if (!img || !fp)
+	if (!img || !stream)
 		return stm32ipl_err_InvalidParameter;
 
 	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
 
-	if (f_lseek(fp, 0) != FR_OK)
+	if (!ipl_stream_seek(stream, 0))
 		return stm32ipl_err_SeekingFile;
 
 	cinfo.err = jpeg_std_error(&jerr);
 	jpeg_create_decompress(&cinfo);
-	jpeg_stdio_src(&cinfo, fp);
+	jpeg_stdio_src(&cinfo, stream);
 	jpeg_read_header(&cinfo, TRUE);
 	cinfo.dct_method = JDCT_FLOAT;
 	jpeg_start_decompress(&cinfo);
@@ -227,15 +227,240 @@ stm32ipl_err_t readJPEGSW(image_t *img, FIL *fp)
 	return stm32ipl_err_Ok;
 }
 
+/*
+ * Adds the pixels of a decoded line to the sums of the columns of the scaled line; each scaled column is the
+ * average of the decoded columns [x * srcW / width, (x + 1) * srcW / width).
+ * param src	Decoded line (Grayscale or RGB888 with R, G, B order).
+ * param sum	Sums of the scaled columns (comps values for each column).
+ * param srcW	Width of the decoded line.
+ * param width	Width of the scaled line.
+ * param comps	Number of components of the pixels (1 or 3).
+ * return 		void.
+ */
+static void AccumulateLine(const uint8_t *src, uint32_t *sum, uint32_t srcW, uint32_t width, uint32_t comps)
+{
+	uint32_t x = 0;
+
+	for (uint32_t i = 0; i < width; i++) {
+		uint32_t x1 = ((i + 1) * srcW) / width;
+
+		for (; x < x1; x++)
+			for (uint32_t c = 0; c < comps; c++)
+				sum[c] += *src++;
+
+		sum += comps;
+	}
+}
+
+/*
+ * Stores the averages of the given sums to a line of the scaled image and clears the sums.
+ * param sum	Sums of the scaled columns (comps values for each column).
+ * param dst	Line of the scaled image.
+ * param srcW	Width of the decoded lines.
+ * param width	Width of the scaled line.
+ * param nLines	Number of decoded lines added to the sums.
+ * param comps	Number of components of the pixels (1 or 3).
+ * param format	Format of the scaled image (Grayscale, RGB565 or RGB888).
+ * return 		void.
+ */
+static void StoreAverageLine(uint32_t *sum, uint8_t *dst, uint32_t srcW, uint32_t width, uint32_t nLines,
+		uint32_t comps, image_bpp_t format)
+{
+	uint32_t x0 = 0;
+
+	for (uint32_t i = 0; i < width; i++) {
+		uint32_t x1 = ((i + 1) * srcW) / width;
+		uint32_t n = (x1 - x0) * nLines;
+
+		if (comps == 1) {
+			dst[i] = (sum[0] + (n / 2)) / n;
+		} else {
+			uint32_t r = (sum[0] + (n / 2)) / n;
+			uint32_t g = (sum[1] + (n / 2)) / n;
+			uint32_t b = (sum[2] + (n / 2)) / n;
+
+			if (format == IMAGE_BPP_RGB565) {
+				((rgb565_t*)dst)[i] = COLOR_R8_G8_B8_TO_RGB565(r, g, b);
+			} else {
+				((rgb888_t*)dst)[i].r = r;
+				((rgb888_t*)dst)[i].g = g;
+				((rgb888_t*)dst)[i].b = b;
+			}
+		}
+
+		memset(sum, 0, comps * sizeof(uint32_t));
+		sum += comps;
+		x0 = x1;
+	}
+}
+
+/*
+ * Reads and decodes a JPEG file by using the libJPEG software decoder, scaled down to fit the given size. The
+ * file is decoded at the smallest DCT scale (1/1, 1/2, 1/4, 1/8) that is not smaller than the scaled image, then
+ * each decoded line is averaged into the scaled image, so that the full size image is never allocated.
+ * img		Decoded image; the image data buffer is allocated internally; it is up to
+ * the caller to release the image data when done with it with STM32Ipl_ReleaseData().
+ * stream	Input stream.
+ * maxW		Maximum width of the decoded image.
+ * maxH		Maximum height of the decoded image.
+ * format	Format of the decoded image (Grayscale, RGB565 or RGB888).
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t readJPEGSWScaled(image_t *img, ipl_stream_t *stream, uint32_t maxW, uint32_t maxH, image_bpp_t format)
+{
+	struct jpeg_error_mgr jerr;
+	struct jpeg_decompress_struct cinfo;
+	JSAMPROW buffer[1] = { 0 };
+	uint8_t *auxLine;
+	uint32_t *sum;
+	uint8_t *imgData;
+	uint32_t width;
+	uint32_t height;
+	uint32_t srcW;
+	uint32_t srcH;
+	uint32_t comps;
+	uint32_t denom;
+	uint32_t lineSize;
+	uint32_t y0 = 0;
+	uint32_t y = 0;
+
+	if (!img || !stream || !maxW || !maxH)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_Init(img, 0, 0, (image_bpp_t)0, 0);
+
+	if (!ipl_stream_seek(stream, 0))
+		return stm32ipl_err_SeekingFile;
+
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&cinfo);
+	jpeg_stdio_src(&cinfo, stream);
+	jpeg_read_header(&cinfo, TRUE);
+
+	if ((cinfo.jpeg_color_space == JCS_CMYK) || (cinfo.jpeg_color_space == JCS_YCCK)) {
+		jpeg_destroy_decompress(&cinfo);
+		return stm32ipl_err_UnsupportedFormat;
+	}
+
+	ipl_fit_size(cinfo.image_width, cinfo.image_height, maxW, maxH, &width, &height);
+
+	for (denom = 8; denom > 1; denom /= 2)
+		if ((((cinfo.image_width + denom - 1) / denom) >= width) && (((cinfo.image_height + denom - 1) / denom) >= height))
+			break;
+
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = denom;
+	cinfo.out_color_space = (format == IMAGE_BPP_GRAYSCALE) ? JCS_GRAYSCALE : JCS_RGB;
+	cinfo.dct_method = JDCT_FLOAT;
+	jpeg_start_decompress(&cinfo);
+
+	srcW = cinfo.output_width;
+	srcH = cinfo.output_height;
+	comps = cinfo.out_color_components;
+	width = (width < srcW) ? width : srcW;
+	height = (height < srcH) ? height : srcH;
+	lineSize = STM32Ipl_DataSize(width, 1, format);
+
+	auxLine = xalloc(srcW * comps);
+	sum = xalloc0(width * comps * sizeof(uint32_t));
+	imgData = xalloc(STM32Ipl_DataSize(width, height, format));
+	if (!auxLine || !sum || !imgData) {
+		xfree(imgData);
+		xfree(sum);
+		xfree(auxLine);
+		jpeg_abort_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	buffer[0] = auxLine;
+
+	while (cinfo.output_scanline < srcH) {
+		uint32_t y1 = ((y + 1) * srcH) / height;
+
+		jpeg_read_scanlines(&cinfo, buffer, 1);
+		AccumulateLine(auxLine, sum, srcW, width, comps);
+
+		if (cinfo.output_scanline == y1) {
+			StoreAverageLine(sum, imgData + (y * lineSize), srcW, width, y1 - y0, comps, format);
+			y0 = y1;
+			y++;
+		}
+	}
+
+	STM32Ipl_Init(img, width, height, format, imgData);
+
+	xfree(sum);
+	xfree(auxLine);
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+
+	return stm32ipl_err_Ok;
+}
+
+/*
+ * Sets the default encoding parameters, the quality and the chroma subsampling; the image size and color space
+ * must be already set. The sampling factors are set after jpeg_set_defaults(), which allocates and initializes
+ * the components.
+ * cinfo	Encoder.
+ * chromaSS	Chroma subsampling; 4:4:4, 4:2:2, 4:2:0 are supported.
+ * quality	Quality value used by the encoder (0-100), 100 means best quality.
+ * return	true on success, false if the chroma subsampling is not supported.
+ */
+static bool setEncodingParams(struct jpeg_compress_struct *cinfo, uint32_t chromaSS, uint32_t quality)
+{
+	int hFactor;
+	int vFactor;
+
+	switch (chromaSS) {
+		case STM32IPL_JPEG_444_SUBSAMPLING:
+			hFactor = 1;
+			vFactor = 1;
+			break;
+
+		case STM32IPL_JPEG_420_SUBSAMPLING:
+			hFactor = 2;
+			vFactor = 2;
+			break;
+
+		case STM32IPL_JPEG_422_SUBSAMPLING:
+			hFactor = 2;
+			vFactor = 1;
+			break;
+
+		default:
+			return false;
+	}
+
+	jpeg_set_defaults(cinfo);
+
+	cinfo->dct_method = JDCT_FLOAT;
+
+	jpeg_set_quality(cinfo, quality, TRUE);
+
+	/* The luminance is subsampled with respect to the chrominance; grayscale images are not subsampled. */
+	if (cinfo->num_components == 3) {
+		cinfo->comp_info[0].h_samp_factor = hFactor;
+		cinfo->comp_info[0].v_samp_factor = vFactor;
+		cinfo->comp_info[1].h_samp_factor = 1;
+		cinfo->comp_info[1].v_samp_factor = 1;
+		cinfo->comp_info[2].h_samp_factor = 1;
+		cinfo->comp_info[2].v_samp_factor = 1;
+	}
+
+	return true;
+}
+
 /*
  * Encodes the given image to a JPEG file by using the libJPEG software encoder.
  * img		Image to be encoded (supported formats are: RGB565, RGB888 and Grayscale).
- * fp		Pointer to the file object.
+ * stream	Output stream.
  * chromaSS	Chroma subsampling; 4:4:4, 4:2:2, 4:2:0 are supported.
  * quality	Quality value used by the encoder (0-100), 100 means best quality.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t encodeJPEG(const image_t *img, FIL *fp, uint32_t chromaSS, uint32_t quality)
+static stm32ipl_err_t encodeJPEG(const image_t *img, ipl_stream_t *stream, uint32_t chromaSS, uint32_t quality)
 {
 	struct jpeg_error_mgr jerr;
 	struct jpeg_compress_struct cinfo;
@@ -247,7 +472,7 @@ static stm32ipl_err_t encodeJPEG(const image_t *img, FIL *fp, uint32_t chromaSS,
 
 	cinfo.err = jpeg_std_error(&jerr);
 	jpeg_create_compress(&cinfo);
-	jpeg_stdio_dest(&cinfo, fp);
+	jpeg_stdio_dest(&cinfo, stream);
 
 	cinfo.image_width = img->w;
 	cinfo.image_height = img->h;
@@ -279,37 +504,9 @@ static stm32ipl_err_t encodeJPEG(const image_t *img, FIL *fp, uint32_t chromaSS,
 			return stm32ipl_err_UnsupportedFormat;
 	}
 
-	switch (chromaSS) {
-		case STM32IPL_JPEG_444_SUBSAMPLING:
-			cinfo.comp_info[0].h_samp_factor = 1;
-			cinfo.comp_info[0].v_samp_factor = 1;
-			cinfo.comp_info[1].h_samp_factor = 1;
-			cinfo.comp_info[1].v_samp_factor = 1;
-			cinfo.comp_info[2].h_samp_factor = 1;
-			cinfo.comp_info[2].v_samp_factor = 1;
-			break;
-
-		case STM32IPL_JPEG_420_SUBSAMPLING:
-			cinfo.comp_info[0].h_samp_factor = 2;
-			cinfo.comp_info[0].v_samp_factor = 2;
-			cinfo.comp_info[1].h_samp_factor = 1;
-			cinfo.comp_info[1].v_samp_factor = 1;
-			cinfo.comp_info[2].h_samp_factor = 1;
-			cinfo.comp_info[2].v_samp_factor = 1;
-			break;
-
-		case STM32IPL_JPEG_422_SUBSAMPLING:
-			cinfo.comp_info[0].h_samp_factor = 2;
-			cinfo.comp_info[0].v_samp_factor = 1;
-			cinfo.comp_info[1].h_samp_factor = 1;
-			cinfo.comp_info[1].v_samp_factor = 1;
-			cinfo.comp_info[2].h_samp_factor = 1;
-			cinfo.comp_info[2].v_samp_factor = 1;
-			break;
-
-		default:
-			jpeg_destroy_compress(&cinfo);
-			return stm32ipl_err_UnsupportedFormat;
+	if (!setEncodingParams(&cinfo, chromaSS, quality)) {
+		jpeg_destroy_compress(&cinfo);
+		return stm32ipl_err_UnsupportedFormat;
 	}
 
 	auxLine = xalloc(img->w * cinfo.input_components);
@@ -318,11 +515,6 @@ static stm32ipl_err_t encodeJPEG(const image_t *img, FIL *fp, uint32_t chromaSS,
 		return stm32ipl_err_OutOfMemory;
 	}
 
-	jpeg_set_defaults(&cinfo);
-
-	cinfo.dct_method = JDCT_FLOAT;
-
-	jpeg_set_quality(&cinfo, quality, TRUE);
 	jpeg_start_compress(&cinfo, TRUE);
 
 	buffer[0] = auxLine;
@@ -344,32 +536,266 @@ static stm32ipl_err_t encodeJPEG(const image_t *img, FIL *fp, uint32_t chromaSS,
 	return stm32ipl_err_Ok;
 }
 
-/* Encodes the given image to a JPEG file by using the libJPEG software encoder.
+/* Encodes the given image to a JPEG stream by using the libJPEG software encoder.
  * img		Image to be encoded (supported formats are: RGB565, Grayscale).
- * filename	Name of the output file.
+ * stream	Output stream.
  * return	stm32ipl_err_Ok on success, error otherwise.
  */
-stm32ipl_err_t saveJPEGSW(const image_t *img, const char *filename)
+stm32ipl_err_t saveJPEGSW(const image_t *img, ipl_stream_t *stream)
 {
-	stm32ipl_err_t res;
-	FIL fp;
-
-	if (!img || !filename)
+	if (!img || !stream)
 		return stm32ipl_err_InvalidParameter;
 
 	if ((img->bpp != IMAGE_BPP_RGB565) && (img->bpp != IMAGE_BPP_RGB888) && (img->bpp != IMAGE_BPP_GRAYSCALE))
 		return stm32ipl_err_UnsupportedFormat;
 
-	if (f_open(&fp, (const TCHAR*)filename, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
-		return stm32ipl_err_OpeningFile;
+	return encodeJPEG(img, stream, STM32IPL_JPEG_SUBSAMPLING, STM32IPL_JPEG_QUALITY);
+}
+
+/* State of the streaming JPEG encoder, referenced by stm32ipl_jpeg_stream_t.codec. */
+typedef struct _JpegStreamCodec
+{
+	struct jpeg_compress_struct cinfo;	/* Encoder. */
+	struct jpeg_error_mgr jerr;			/* Error manager. */
+	struct jpeg_destination_mgr dest;	/* Destination manager, writing to the halves of the output buffer. */
+	ConvertLineFunction convertFn;		/* Conversion of a row to the encoder input (null for Grayscale). */
+	uint8_t *auxLine;					/* Converted row. */
+} JpegStreamCodec;
+
+/* Gives the given compressed data to the output function of the streaming encoder; once the output function has
+ * failed, the following data is dropped. */
+static void outputStreamData(stm32ipl_jpeg_stream_t *ctx, const uint8_t *data, uint32_t size)
+{
+	if (!ctx->failed && size && !ctx->output(data, size, ctx->arg))
+		ctx->failed = true;
+}
+
+/* Destination manager: starts filling the first half of the output buffer. */
+static void initStreamDestination(j_compress_ptr cinfo)
+{
+	stm32ipl_jpeg_stream_t *ctx = (stm32ipl_jpeg_stream_t*)cinfo->client_data;
+
+	ctx->half = 0;
+	cinfo->dest->next_output_byte = ctx->buffer;
+	cinfo->dest->free_in_buffer = ctx->halfSize;
+}
+
+/* Destination manager: gives the full half of the output buffer to the output function, then goes on
+ * filling the other half. */
+static boolean emptyStreamBuffer(j_compress_ptr cinfo)
+{
+	stm32ipl_jpeg_stream_t *ctx = (stm32ipl_jpeg_stream_t*)cinfo->client_data;
 
-	res = encodeJPEG(img, &fp, STM32IPL_JPEG_SUBSAMPLING, STM32IPL_JPEG_QUALITY);
+	outputStreamData(ctx, ctx->buffer + (ctx->half * ctx->halfSize), ctx->halfSize);
 
-	f_close(&fp);
+	ctx->half ^= 1;
+	cinfo->dest->next_output_byte = ctx->buffer + (ctx->half * ctx->halfSize);
+	cinfo->dest->free_in_buffer = ctx->halfSize;
+
+	return TRUE;
+}
+
+/* Destination manager: gives the data left in the current half of the output buffer to the output function. */
+static void termStreamDestination(j_compress_ptr cinfo)
+{
+	stm32ipl_jpeg_stream_t *ctx = (stm32ipl_jpeg_stream_t*)cinfo->client_data;
+
+	outputStreamData(ctx, ctx->buffer + (ctx->half * ctx->halfSize), ctx->halfSize - cinfo->dest->free_in_buffer);
+}
+
+///@endcond
+
+/**
+ * @brief Starts the streaming JPEG encoding of a frame, whose rows are then given to STM32Ipl_JpegStreamPushRows()
+ * as they are received (e.g. a MCU row of 8 or 16 lines at a time from the camera DMA interrupts), so that the
+ * compressed data is produced while the frame is being captured and no buffer is needed for the whole frame nor
+ * for the whole JPEG file. The compressed data is written to the given output buffer, which is split in two halves
+ * used in turn: each time a half is full, it is given to the output function, while the encoder goes on filling the
+ * other half; the data given to the output function is not modified until the output function is called again,
+ * so it can be sent asynchronously (e.g. by DMA) in the meanwhile. STM32Ipl_JpegStreamEnd() gives the last data.
+ * The supported formats are Grayscale, RGB565 and RGB888; the chroma subsampling is STM32IPL_JPEG_SUBSAMPLING.
+ * This function is available with the LibJPEG software codec only.
+ * @param ctx		Context; if it is not valid, an error is returned.
+ * @param width		Width of the frame.
+ * @param height	Height of the frame.
+ * @param format	Format of the frame.
+ * @param quality	Quality value used by the encoder (0-100), 100 means best quality.
+ * @param buffer	Output buffer; it must not be modified until STM32Ipl_JpegStreamEnd() is called.
+ * @param size		Size of the output buffer (bytes); it must be at least 2.
+ * @param output	Function that receives the compressed data; when it returns false, the encoding fails.
+ * @param arg		Argument given to the output function.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_JpegStreamBegin(stm32ipl_jpeg_stream_t *ctx, uint32_t width, uint32_t height,
+		image_bpp_t format, uint8_t quality, uint8_t *buffer, uint32_t size, stm32ipl_jpeg_output_t output, void *arg)
+{
+	JpegStreamCodec *codec;
+	ConvertLineFunction convertFn;
+	uint32_t components;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	memset(ctx, 0, sizeof(stm32ipl_jpeg_stream_t));
+
+	if (!buffer || (size < 2) || !output || (width == 0) || (width > JPEG_MAX_DIMENSION) || (height == 0)
+			|| (height > JPEG_MAX_DIMENSION) || (quality > 100))
+		return stm32ipl_err_InvalidParameter;
+
+	switch (format) {
+		case IMAGE_BPP_GRAYSCALE:
+			convertFn = 0;
+			components = 1;
+			break;
+
+		case IMAGE_BPP_RGB565:
+			convertFn = ConvertLineRGB565ToRGB888;
+			components = 3;
+			break;
+
+		case IMAGE_BPP_RGB888:
+			convertFn = ConvertLineRGB888ToRGB888;
+			components = 3;
+			break;
+
+		default:
+			return stm32ipl_err_UnsupportedFormat;
+	}
+
+	/* Codec and converted row, in one block. */
+	codec = xalloc(sizeof(JpegStreamCodec) + (convertFn ? (width * components) : 0));
+	if (!codec)
+		return stm32ipl_err_OutOfMemory;
+
+	codec->convertFn = convertFn;
+	codec->auxLine = (uint8_t*)(codec + 1);
+
+	ctx->width = width;
+	ctx->height = height;
+	ctx->bpp = format;
+	ctx->buffer = buffer;
+	ctx->halfSize = size / 2;
+	ctx->output = output;
+	ctx->arg = arg;
+	ctx->codec = codec;
+
+	codec->cinfo.err = jpeg_std_error(&codec->jerr);
+	jpeg_create_compress(&codec->cinfo);
+
+	codec->cinfo.client_data = ctx;
+	codec->dest.init_destination = initStreamDestination;
+	codec->dest.empty_output_buffer = emptyStreamBuffer;
+	codec->dest.term_destination = termStreamDestination;
+	codec->cinfo.dest = &codec->dest;
+
+	codec->cinfo.image_width = width;
+	codec->cinfo.image_height = height;
+	codec->cinfo.input_components = components;
+	codec->cinfo.in_color_space = (components == 1) ? JCS_GRAYSCALE : JCS_RGB;
+
+	if (!setEncodingParams(&codec->cinfo, STM32IPL_JPEG_SUBSAMPLING, quality)) {
+		jpeg_destroy_compress(&codec->cinfo);
+		xfree(codec);
+		memset(ctx, 0, sizeof(stm32ipl_jpeg_stream_t));
+		return stm32ipl_err_UnsupportedFormat;
+	}
+
+	jpeg_start_compress(&codec->cinfo, TRUE);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gives the next rows of the frame to the streaming JPEG encoder started by STM32Ipl_JpegStreamBegin();
+ * the compressed data produced is given to the output function each time a half of the output buffer is full.
+ * @param ctx		Context.
+ * @param data		Pixels of the rows, in the format of the frame.
+ * @param rows		Number of rows; the total number of rows given must not exceed the frame height.
+ * @param stride	Distance between the beginning of two consecutive rows (bytes); 0 means the rows are tightly packed.
+ * @return			stm32ipl_err_Ok on success, error otherwise; on error, the context must be released with
+ * STM32Ipl_JpegStreamEnd().
+ */
+stm32ipl_err_t STM32Ipl_JpegStreamPushRows(stm32ipl_jpeg_stream_t *ctx, const uint8_t *data, uint32_t rows,
+		uint32_t stride)
+{
+	JpegStreamCodec *codec;
+	JSAMPROW row[1];
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+	STM32IPL_CHECK_VALID_PTR_ARG(data)
+
+	codec = (JpegStreamCodec*)ctx->codec;
+	if (!codec || ((ctx->y + rows) > ctx->height))
+		return stm32ipl_err_InvalidParameter;
+
+	if (ctx->failed)
+		return stm32ipl_err_WritingFile;
+
+	if (stride == 0)
+		stride = ctx->width * ((ctx->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : ((ctx->bpp == IMAGE_BPP_RGB565) ? 2 : 3));
+
+	STM32IPL_TRACE_BEGIN(JpegStreamPushRows)
+
+	for (uint32_t i = 0; (i < rows) && !ctx->failed; i++) {
+		const uint8_t *src = data + (i * stride);
+
+		if (codec->convertFn) {
+			codec->convertFn(src, codec->auxLine, ctx->width);
+			row[0] = codec->auxLine;
+		} else {
+			/* Grayscale rows are given to the encoder as they are. */
+			row[0] = (JSAMPROW)src;
+		}
+
+		jpeg_write_scanlines(&codec->cinfo, row, 1);
+		ctx->y++;
+	}
+
+	STM32IPL_TRACE_END(JpegStreamPushRows)
+
+	return ctx->failed ? stm32ipl_err_WritingFile : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Ends the streaming JPEG encoding: when all the rows of the frame were given, the encoding is completed and
+ * the last compressed data is given to the output function; then the memory allocated by STM32Ipl_JpegStreamBegin()
+ * is released. When less rows than the frame height were given, the encoding is discarded.
+ * @param ctx	Context.
+ * @return		stm32ipl_err_Ok on success, stm32ipl_err_OpNotCompleted if the frame was not complete,
+ * stm32ipl_err_WritingFile if the output function failed, other errors otherwise.
+ */
+stm32ipl_err_t STM32Ipl_JpegStreamEnd(stm32ipl_jpeg_stream_t *ctx)
+{
+	JpegStreamCodec *codec;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	codec = (JpegStreamCodec*)ctx->codec;
+	if (!codec)
+		return stm32ipl_err_InvalidParameter;
+
+	if (ctx->failed)
+		res = stm32ipl_err_WritingFile;
+	else
+		if (ctx->y < ctx->height)
+			res = stm32ipl_err_OpNotCompleted;
+		else {
+			jpeg_finish_compress(&codec->cinfo);
+			if (ctx->failed)
+				res = stm32ipl_err_WritingFile;
+		}
+
+	/* Aborts the encoding, if not completed, and releases the encoder memory. */
+	jpeg_destroy_compress(&codec->cinfo);
+	xfree(codec);
+
+	memset(ctx, 0, sizeof(stm32ipl_jpeg_stream_t));
 
 	return res;
 }
 
+///@cond
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_image_io_stream.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - image read/write streams
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl_image_io_stream.h"
+
+#ifdef STM32IPL_ENABLE_IMAGE_IO
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+static bool readFile(ipl_stream_t *stream, void *data, uint32_t size, uint32_t *count)
+{
+	UINT bytesRead;
+	bool res = (f_read(stream->fp, data, size, &bytesRead) == FR_OK);
+
+	*count = bytesRead;
+
+	return res;
+}
+
+static bool writeFile(ipl_stream_t *stream, const void *data, uint32_t size, uint32_t *count)
+{
+	UINT bytesWritten;
+	bool res = (f_write(stream->fp, data, size, &bytesWritten) == FR_OK);
+
+	*count = bytesWritten;
+
+	return res;
+}
+
+static bool seekFile(ipl_stream_t *stream, uint32_t offset)
+{
+	return (f_lseek(stream->fp, offset) == FR_OK);
+}
+
+static bool readMemory(ipl_stream_t *stream, void *data, uint32_t size, uint32_t *count)
+{
+	uint32_t n = (stream->pos < stream->size) ? stream->size - stream->pos : 0;
+
+	if (n > size)
+		n = size;
+
+	memcpy(data, stream->data + stream->pos, n);
+	stream->pos += n;
+	*count = n;
+
+	return true;
+}
+
+/* The bytes beyond the capacity are dropped, but they are counted as written, so that at the end
+ * the size of the stream tells the caller how much memory the whole output needs. */
+static bool writeMemory(ipl_stream_t *stream, const void *data, uint32_t size, uint32_t *count)
+{
+	if (stream->pos < stream->capacity) {
+		uint32_t n = stream->capacity - stream->pos;
+
+		memcpy(stream->data + stream->pos, data, (n < size) ? n : size);
+	}
+
+	stream->pos += size;
+	if (stream->pos > stream->size)
+		stream->size = stream->pos;
+
+	*count = size;
+
+	return true;
+}
+
+static bool seekMemory(ipl_stream_t *stream, uint32_t offset)
+{
+	if (offset > stream->size)
+		return false;
+
+	stream->pos = offset;
+
+	return true;
+}
+///@endcond
+
+/* Initializes a stream that reads from or writes to the given file, already opened by the caller.
+ * stream	Stream.
+ * fp		File.
+ */
+void ipl_stream_init_file(ipl_stream_t *stream, FIL *fp)
+{
+	memset(stream, 0, sizeof(*stream));
+	stream->read = readFile;
+	stream->write = writeFile;
+	stream->seek = seekFile;
+	stream->fp = fp;
+}
+
+/* Initializes a stream that reads from or writes to the given memory buffer.
+ * stream	Stream.
+ * data		Memory buffer.
+ * size		Number of valid bytes in the buffer (0 when writing).
+ * capacity	Size of the buffer (bytes).
+ */
+void ipl_stream_init_memory(ipl_stream_t *stream, uint8_t *data, uint32_t size, uint32_t capacity)
+{
+	memset(stream, 0, sizeof(*stream));
+	stream->read = readMemory;
+	stream->write = writeMemory;
+	stream->seek = seekMemory;
+	stream->data = data;
+	stream->size = size;
+	stream->capacity = capacity;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_IMAGE_IO */
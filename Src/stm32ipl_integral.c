@@ -37,7 +37,7 @@ stm32ipl_err_t STM32Ipl_IIAllocData(i_image_t *iimg, uint32_t width, uint32_t he
 {
 	uint32_t *data;
 
-	STM32IPL_CHECK_VALID_IMAGE(iimg)
+	STM32IPL_CHECK_VALID_PTR_ARG(iimg)
 
 	data = xalloc(width * height * sizeof(uint32_t));
 	if (!data) {
@@ -80,9 +80,12 @@ stm32ipl_err_t STM32Ipl_II(const image_t *src, i_image_t *dst)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_SAME_SIZE(src, dst)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(src)
+	STM32IPL_TRACE_BEGIN(II)
 
 	imlib_integral_image((image_t*)src, dst);
 
+	STM32IPL_TRACE_END(II)
 	return stm32ipl_err_Ok;
 }
 
@@ -100,12 +103,15 @@ stm32ipl_err_t STM32Ipl_IIScaled(const image_t *src, i_image_t *dst)
 	STM32IPL_CHECK_VALID_IMAGE(src)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(src)
 
 	if ((src->w < dst->w) || (src->h < dst->h))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(IIScaled)
 	imlib_integral_image_scaled((image_t*)src, dst);
 
+	STM32IPL_TRACE_END(IIScaled)
 	return stm32ipl_err_Ok;
 }
 
@@ -124,9 +130,12 @@ stm32ipl_err_t STM32Ipl_IISq(const image_t *src, i_image_t *dst)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_SAME_SIZE(src, dst)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(src)
+	STM32IPL_TRACE_BEGIN(IISq)
 
 	imlib_integral_image_sq((image_t*)src, dst);
 
+	STM32IPL_TRACE_END(IISq)
 	return stm32ipl_err_Ok;
 }
 
@@ -157,6 +166,268 @@ uint32_t STM32Ipl_IILookup(const i_image_t *iimg, uint32_t x, uint32_t y, uint32
 	return imlib_integral_lookup((i_image_t*)iimg, x, y, width, height);
 }
 
+/**
+ * @brief Calculates the integral image and the squared integral image of an image in a single pass on the source
+ * image, that is faster than STM32Ipl_II() followed by STM32Ipl_IISq().
+ * The data buffers of the destination images must be already allocated by the user.
+ * Source and destination images must have same size.
+ * The values of the squared integral image wrap around on 32 bits, so that the squared sums read with
+ * STM32Ipl_IILookup() are correct only for ROIs up to 66051 pixels; use STM32Ipl_IISumSq64() for larger ROIs.
+ * The supported format is Grayscale.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param sum		Destination integral image; if it is not valid, an error is returned.
+ * @param sumSq		Destination squared integral image; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_IISumSq(const image_t *src, i_image_t *sum, i_image_t *sumSq)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(sum)
+	STM32IPL_CHECK_VALID_IMAGE(sumSq)
+	STM32IPL_CHECK_SAME_SIZE(src, sum)
+	STM32IPL_CHECK_SAME_SIZE(src, sumSq)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(src)
+	STM32IPL_TRACE_BEGIN(IISumSq)
+
+	imlib_integral_image_ss((image_t*)src, sum, sumSq);
+
+	STM32IPL_TRACE_END(IISumSq)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Allocates a data memory buffer to contain the data of a 64-bit integral image and consequently
+ * initializes the given integral image structure. The buffer needs (width * height * 8) bytes.
+ * The caller is responsible of releasing the data memory buffer with STM32Ipl_II64ReleaseData().
+ * @param iimg		Integral image; if it is not valid, an error is returned.
+ * @param width		Integral image width.
+ * @param height	Integral image height.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_II64AllocData(i64_image_t *iimg, uint32_t width, uint32_t height)
+{
+	uint64_t *data;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(iimg)
+
+	data = xalloc(width * height * sizeof(uint64_t));
+	if (!data) {
+		iimg->w = 0;
+		iimg->h = 0;
+		iimg->data = 0;
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	iimg->w    = width;
+	iimg->h    = height;
+	iimg->data = data;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the data memory buffer of the 64-bit integral image.
+ * @param iimg		Integral image.
+ * @return			void.
+ */
+void STM32Ipl_II64ReleaseData(i64_image_t *iimg)
+{
+	if (iimg)
+		xfree(iimg->data);
+}
+
+/**
+ * @brief Same as STM32Ipl_IISumSq(), but the squared integral image has 64-bit values, so that the squared sums
+ * read with STM32Ipl_IILookup64() are correct for any ROI, also on large images (e.g. 1920x1080).
+ * The data buffers of the destination images must be already allocated by the user.
+ * Source and destination images must have same size.
+ * The supported format is Grayscale.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param sum		Destination integral image; if it is not valid, an error is returned.
+ * @param sumSq		Destination 64-bit squared integral image; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_IISumSq64(const image_t *src, i_image_t *sum, i64_image_t *sumSq)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(sum)
+	STM32IPL_CHECK_VALID_IMAGE(sumSq)
+	STM32IPL_CHECK_SAME_SIZE(src, sum)
+	STM32IPL_CHECK_SAME_SIZE(src, sumSq)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(src)
+	STM32IPL_TRACE_BEGIN(IISumSq64)
+
+	imlib_integral_image_ss64((image_t*)src, sum, sumSq);
+
+	STM32IPL_TRACE_END(IISumSq64)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Calculates the sum of the values of a particular ROI of a 64-bit integral image.
+ * @param iimg		Integral image; if it is not valid, 0 is returned.
+ * @param x			X-coordinate of the ROI.
+ * @param y			Y-coordinate of the ROI.
+ * @param width		Width of the ROI.
+ * @param height	Height of the ROI.
+ * @return			Sum of the values within the ROI.
+ */
+uint64_t STM32Ipl_IILookup64(const i64_image_t *iimg, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	rectangle_t roi;
+	rectangle_t fullRoi;
+
+	if (!iimg || !iimg->data)
+		return 0;
+
+	STM32Ipl_RectInit(&roi, x, y, width, height);
+	STM32Ipl_RectInit(&fullRoi, 0, 0, iimg->w, iimg->h);
+
+	if (!STM32Ipl_RectContain(&fullRoi, &roi))
+		return 0;
+
+	return imlib_integral_lookup64((i64_image_t*)iimg, x, y, width, height);
+}
+
+/**
+ * @brief Binarizes a Grayscale image with a threshold computed for each pixel from the mean (and, for Sauvola,
+ * the standard deviation) of the ((kSize*2)+1)x((kSize*2)+1) window around it; near the borders the window is
+ * clipped to the image. The window sums are read from a band of the integral image and of the squared
+ * integral image that slides down the image: running column sums are updated with one row in and one row out,
+ * and the window sums slide along the row, so that the processing time does not depend on the kernel size.
+ * The band needs (width * 8) bytes, instead of the (width * height * 8) bytes of the two integral images.
+ * The supported format is Grayscale.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param dst		Destination image; if it is not valid, an error is returned; it must be Binary and have the
+ * same size of the source image, otherwise an error is returned.
+ * @param kSize		Kernel size; use 1 (3x3 window), 2 (5x5 window), ..., n (((n*2)+1)x((n*2)+1) window).
+ * @param k			Sensitivity of the threshold; it must be in [0, 1), otherwise an error is returned. Typical
+ * values are 0.15 (Bradley) and 0.34 (Sauvola); greater values set less pixels.
+ * @param method	Formula of the local threshold.
+ * @param invert	False sets the pixels brighter than their local threshold (the background of dark text on
+ * paper), true sets the other ones.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_AdaptiveThreshold(const image_t *src, image_t *dst, uint8_t kSize, float k,
+		stm32ipl_adaptive_thresh_t method, bool invert)
+{
+	uint32_t *colSum;
+	uint32_t *colSumSq;
+	uint32_t bradley;
+	int32_t w;
+	int32_t h;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_FORMAT(dst, stm32ipl_if_binary)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+
+	if ((kSize == 0) || !((k >= 0.0f) && (k < 1.0f)))
+		return stm32ipl_err_InvalidParameter;
+
+	if ((method != stm32ipl_adaptive_thresh_bradley) && (method != stm32ipl_adaptive_thresh_sauvola))
+		return stm32ipl_err_InvalidParameter;
+
+	w = src->w;
+	h = src->h;
+
+	colSum = xalloc0(w * 2 * sizeof(uint32_t));
+	if (!colSum)
+		return stm32ipl_err_OutOfMemory;
+
+	colSumSq = colSum + w;
+
+	STM32IPL_TRACE_BEGIN(AdaptiveThreshold)
+
+	/* Bradley compares pixel * area with sum * (1 - k), with (1 - k) in Q16. */
+	bradley = (uint32_t)((1.0f - k) * 65536.0f + 0.5f);
+
+	/* The column sums cover the rows [y - kSize, y + kSize] clipped to the image. */
+	for (int32_t y = 0; (y < kSize) && (y < h); y++) {
+		const uint8_t *inRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y);
+		for (int32_t x = 0; x < w; x++) {
+			colSum[x] += inRow[x];
+			colSumSq[x] += inRow[x] * inRow[x];
+		}
+	}
+
+	for (int32_t y = 0; y < h; y++) {
+		const uint8_t *srcRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y);
+		uint32_t *dstRow = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+		int32_t yIn = y + kSize;
+		int32_t yOut = y - kSize - 1;
+		uint32_t rows = ((yIn < h) ? yIn : (h - 1)) - ((y > kSize) ? (y - kSize) : 0) + 1;
+		uint32_t sum = 0;
+		uint64_t sumSq = 0;
+		uint32_t word = 0;
+
+		if (yIn < h) {
+			const uint8_t *inRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, yIn);
+			for (int32_t x = 0; x < w; x++) {
+				colSum[x] += inRow[x];
+				colSumSq[x] += inRow[x] * inRow[x];
+			}
+		}
+
+		if (yOut >= 0) {
+			const uint8_t *outRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, yOut);
+			for (int32_t x = 0; x < w; x++) {
+				colSum[x] -= outRow[x];
+				colSumSq[x] -= outRow[x] * outRow[x];
+			}
+		}
+
+		/* The window sums cover the columns [x - kSize, x + kSize] clipped to the image. */
+		for (int32_t x = 0; (x < kSize) && (x < w); x++) {
+			sum += colSum[x];
+			sumSq += colSumSq[x];
+		}
+
+		for (int32_t x = 0; x < w; x++) {
+			int32_t xIn = x + kSize;
+			int32_t xOut = x - kSize - 1;
+			uint32_t area = (((xIn < w) ? xIn : (w - 1)) - ((x > kSize) ? (x - kSize) : 0) + 1) * rows;
+			uint32_t pixel = srcRow[x];
+			bool set;
+
+			if (xIn < w) {
+				sum += colSum[xIn];
+				sumSq += colSumSq[xIn];
+			}
+
+			if (xOut >= 0) {
+				sum -= colSum[xOut];
+				sumSq -= colSumSq[xOut];
+			}
+
+			if (method == stm32ipl_adaptive_thresh_bradley) {
+				set = (((uint64_t)pixel * area) << 16) > ((uint64_t)sum * bradley);
+			} else {
+				float invArea = 1.0f / area;
+				float mean = sum * invArea;
+				float var = (sumSq * invArea) - (mean * mean);
+				float stdDev = (var > 0.0f) ? fast_sqrtf(var) : 0.0f;
+				set = pixel > (mean * (1.0f + k * ((stdDev / 128.0f) - 1.0f)));
+			}
+
+			word |= (uint32_t)(set ^ invert) << (x & UINT32_T_MASK);
+
+			if (((x & UINT32_T_MASK) == UINT32_T_MASK) || (x == (w - 1))) {
+				dstRow[x >> UINT32_T_SHIFT] = word;
+				word = 0;
+			}
+		}
+	}
+
+	xfree(colSum);
+
+	STM32IPL_TRACE_END(AdaptiveThreshold)
+	return stm32ipl_err_Ok;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,249 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_kernels.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - format-specialized row kernels
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "stm32ipl_kernels.h"
+#ifdef IPL_INTEGRAL_HAS_MVE
+#include "mve_integral.h"
+#endif /* IPL_INTEGRAL_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IMAGE_BPP_NB (IMAGE_BPP_JPEG + 1)
+
+/* Generates the integral row kernel ipl_kernel_<name>_<fmt>, accumulating the value v of the luma p of each pixel;
+ * the test on the row above is taken once per row. */
+#define IPL_KERNEL_INTEGRAL(fmt, name, v) \
+static void ipl_kernel_##name##_##fmt(const void *row, int x0, int xRatio, const uint32_t *above, uint32_t *sum, \
+		int n) \
+{ \
+	const IPL_KERNEL_##fmt##_T *pix = (const IPL_KERNEL_##fmt##_T *)row; \
+	uint32_t s = 0; \
+	if (above) { \
+		for (int x = 0; x < n; x++) { \
+			uint32_t p = IPL_KERNEL_##fmt##_Y(pix, x0 + ((x * xRatio) >> 16)); \
+			s += (v); \
+			sum[x] = s + above[x]; \
+		} \
+	} else { \
+		for (int x = 0; x < n; x++) { \
+			uint32_t p = IPL_KERNEL_##fmt##_Y(pix, x0 + ((x * xRatio) >> 16)); \
+			s += (v); \
+			sum[x] = s; \
+		} \
+	} \
+}
+
+/* Generates the integral row kernel ipl_kernel_integral_ss_<fmt>, accumulating both the luma and its square. */
+#define IPL_KERNEL_INTEGRAL_SS(fmt) \
+static void ipl_kernel_integral_ss_##fmt(const void *row, int x0, int xRatio, const uint32_t *sumAbove, \
+		const uint32_t *ssqAbove, uint32_t *sum, uint32_t *ssq, int n) \
+{ \
+	const IPL_KERNEL_##fmt##_T *pix = (const IPL_KERNEL_##fmt##_T *)row; \
+	uint32_t s = 0; \
+	uint32_t sq = 0; \
+	if (sumAbove) { \
+		for (int x = 0; x < n; x++) { \
+			uint32_t p = IPL_KERNEL_##fmt##_Y(pix, x0 + ((x * xRatio) >> 16)); \
+			s += p; \
+			sq += p * p; \
+			sum[x] = s + sumAbove[x]; \
+			ssq[x] = sq + ssqAbove[x]; \
+		} \
+	} else { \
+		for (int x = 0; x < n; x++) { \
+			uint32_t p = IPL_KERNEL_##fmt##_Y(pix, x0 + ((x * xRatio) >> 16)); \
+			s += p; \
+			sq += p * p; \
+			sum[x] = s; \
+			ssq[x] = sq; \
+		} \
+	} \
+}
+
+#define IPL_KERNEL_INTEGRAL_ALL(fmt) \
+	IPL_KERNEL_INTEGRAL(fmt, integral, p) \
+	IPL_KERNEL_INTEGRAL(fmt, integral_sq, p * p) \
+	IPL_KERNEL_INTEGRAL_SS(fmt)
+
+IPL_KERNEL_INTEGRAL_ALL(BINARY)
+IPL_KERNEL_INTEGRAL_ALL(GRAYSCALE)
+IPL_KERNEL_INTEGRAL_ALL(RGB565)
+IPL_KERNEL_INTEGRAL_ALL(RGB888)
+
+/* Generates the row copy kernels of the formats having whole-byte pixels: the masked one reads the mask a packed
+ * word at a time, copying 32 pixels at once when they are all selected and only the selected ones otherwise. */
+#define IPL_KERNEL_COPY(fmt) \
+static void ipl_kernel_copy_##fmt(const void *src, void *dst, int n, image_t *mask, int y) \
+{ \
+	memcpy(dst, src, n * sizeof(IPL_KERNEL_##fmt##_T)); \
+} \
+\
+static void ipl_kernel_copy_masked_##fmt(const void *src, void *dst, int n, image_t *mask, int y) \
+{ \
+	const IPL_KERNEL_##fmt##_T *s = (const IPL_KERNEL_##fmt##_T *)src; \
+	IPL_KERNEL_##fmt##_T *d = (IPL_KERNEL_##fmt##_T *)dst; \
+	for (int x = 0; x < n; x += UINT32_T_BITS) { \
+		uint32_t m = image_get_mask_word(mask, x, y); \
+		if ((m == 0xFFFFFFFFU) && ((n - x) >= (int)UINT32_T_BITS)) { \
+			memcpy(d + x, s + x, UINT32_T_BITS * sizeof(IPL_KERNEL_##fmt##_T)); \
+			continue; \
+		} \
+		for (; m; m &= m - 1) { \
+			int i = x + __builtin_ctz(m); \
+			if (i >= n) \
+				break; \
+			d[i] = s[i]; \
+		} \
+	} \
+}
+
+IPL_KERNEL_COPY(GRAYSCALE)
+IPL_KERNEL_COPY(RGB565)
+IPL_KERNEL_COPY(RGB888)
+
+/* Binary pixels are copied a packed word at a time, through a selection mask keeping the destination pixels that
+ * are not copied (beyond n, or not set in the mask). */
+static void ipl_kernel_copy_BINARY(const void *src, void *dst, int n, image_t *mask, int y)
+{
+	const uint32_t *s = (const uint32_t*)src;
+	uint32_t *d = (uint32_t*)dst;
+	int x;
+
+	for (x = 0; (n - x) >= (int)UINT32_T_BITS; x += UINT32_T_BITS)
+		*d++ = *s++;
+
+	if (x < n) {
+		uint32_t m = (1U << (n - x)) - 1;
+		*d = (*d & ~m) | (*s & m);
+	}
+}
+
+static void ipl_kernel_copy_masked_BINARY(const void *src, void *dst, int n, image_t *mask, int y)
+{
+	const uint32_t *s = (const uint32_t*)src;
+	uint32_t *d = (uint32_t*)dst;
+
+	for (int x = 0; x < n; x += UINT32_T_BITS, s++, d++) {
+		uint32_t m = image_get_mask_word(mask, x, y);
+
+		if ((n - x) < (int)UINT32_T_BITS)
+			m &= (1U << (n - x)) - 1;
+
+		*d = (*d & ~m) | (*s & m);
+	}
+}
+
+#ifdef IPL_INTEGRAL_HAS_MVE
+/* MVE integral row kernels of grayscale images. */
+static void ipl_kernel_integral_mve(const void *row, int x0, int xRatio, const uint32_t *above, uint32_t *sum, int n)
+{
+	mve_integral_row((const uint8_t*)row + x0, xRatio, above, sum, n);
+}
+
+static void ipl_kernel_integral_sq_mve(const void *row, int x0, int xRatio, const uint32_t *above, uint32_t *sum,
+		int n)
+{
+	mve_integral_row_sq((const uint8_t*)row + x0, xRatio, above, sum, n);
+}
+
+static void ipl_kernel_integral_ss_mve(const void *row, int x0, int xRatio, const uint32_t *sumAbove,
+		const uint32_t *ssqAbove, uint32_t *sum, uint32_t *ssq, int n)
+{
+	mve_integral_row_ss((const uint8_t*)row + x0, xRatio, sumAbove, ssqAbove, sum, ssq, n);
+}
+
+#define IPL_KERNEL_INTEGRAL_MVE(fct)	fct
+#else
+#define IPL_KERNEL_INTEGRAL_MVE(fct)	NULL
+#endif /* IPL_INTEGRAL_HAS_MVE */
+
+/* Implementation index of the kernel tables: C, then MVE (NULL when not part of the build). */
+#define IPL_KERNEL_C		0
+#define IPL_KERNEL_MVE		1
+#define IPL_KERNEL_IMPL_NB	2
+
+/* Selects the MVE implementation of a table entry when it is enabled and present, the C one otherwise. */
+#define IPL_KERNEL_SELECT(entry) \
+	((ipl_mve_enabled && (entry)[IPL_KERNEL_MVE]) ? (entry)[IPL_KERNEL_MVE] : (entry)[IPL_KERNEL_C])
+
+/* Kernel tables: [format][square][implementation]. */
+static const ipl_kernel_integral_t ipl_kernel_integral_table[IMAGE_BPP_NB][2][IPL_KERNEL_IMPL_NB] = {
+	// IMAGE_BPP_BINARY
+	{{ ipl_kernel_integral_BINARY, NULL }, { ipl_kernel_integral_sq_BINARY, NULL }},
+	// IMAGE_BPP_GRAYSCALE
+	{{ ipl_kernel_integral_GRAYSCALE, IPL_KERNEL_INTEGRAL_MVE(ipl_kernel_integral_mve) },
+	 { ipl_kernel_integral_sq_GRAYSCALE, IPL_KERNEL_INTEGRAL_MVE(ipl_kernel_integral_sq_mve) }},
+	// IMAGE_BPP_RGB565
+	{{ ipl_kernel_integral_RGB565, NULL }, { ipl_kernel_integral_sq_RGB565, NULL }},
+	// IMAGE_BPP_BAYER => unsupported
+	{{ NULL, NULL }, { NULL, NULL }},
+	// IMAGE_BPP_RGB888
+	{{ ipl_kernel_integral_RGB888, NULL }, { ipl_kernel_integral_sq_RGB888, NULL }},
+	// IMAGE_BPP_JPEG => unsupported
+	{{ NULL, NULL }, { NULL, NULL }}
+};
+
+/* [format][implementation]. */
+static const ipl_kernel_integral_ss_t ipl_kernel_integral_ss_table[IMAGE_BPP_NB][IPL_KERNEL_IMPL_NB] = {
+	{ ipl_kernel_integral_ss_BINARY, NULL },
+	{ ipl_kernel_integral_ss_GRAYSCALE, IPL_KERNEL_INTEGRAL_MVE(ipl_kernel_integral_ss_mve) },
+	{ ipl_kernel_integral_ss_RGB565, NULL },
+	{ NULL, NULL },
+	{ ipl_kernel_integral_ss_RGB888, NULL },
+	{ NULL, NULL }
+};
+
+/* [format][masked]: C only. */
+static const ipl_kernel_copy_t ipl_kernel_copy_table[IMAGE_BPP_NB][2] = {
+	// IMAGE_BPP_BINARY
+	{ ipl_kernel_copy_BINARY, ipl_kernel_copy_masked_BINARY },
+	// IMAGE_BPP_GRAYSCALE
+	{ ipl_kernel_copy_GRAYSCALE, ipl_kernel_copy_masked_GRAYSCALE },
+	// IMAGE_BPP_RGB565
+	{ ipl_kernel_copy_RGB565, ipl_kernel_copy_masked_RGB565 },
+	// IMAGE_BPP_BAYER => unsupported
+	{ NULL, NULL },
+	// IMAGE_BPP_RGB888
+	{ ipl_kernel_copy_RGB888, ipl_kernel_copy_masked_RGB888 },
+	// IMAGE_BPP_JPEG => unsupported
+	{ NULL, NULL }
+};
+
+ipl_kernel_integral_t ipl_kernel_integral(int bpp, bool square)
+{
+	return ((uint32_t)bpp < IMAGE_BPP_NB) ? IPL_KERNEL_SELECT(ipl_kernel_integral_table[bpp][square ? 1 : 0]) : NULL;
+}
+
+ipl_kernel_integral_ss_t ipl_kernel_integral_ss(int bpp)
+{
+	return ((uint32_t)bpp < IMAGE_BPP_NB) ? IPL_KERNEL_SELECT(ipl_kernel_integral_ss_table[bpp]) : NULL;
+}
+
+ipl_kernel_copy_t ipl_kernel_copy(int bpp, bool masked)
+{
+	return ((uint32_t)bpp < IMAGE_BPP_NB) ? ipl_kernel_copy_table[bpp][masked ? 1 : 0] : NULL;
+}
+///@endcond
+
+#ifdef __cplusplus
+}
+#endif
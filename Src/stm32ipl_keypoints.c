@@ -0,0 +1,583 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_keypoints.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - keypoints module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+#ifdef IPL_KEYPOINTS_HAS_MVE
+#include "mve_keypoints.h"
+#endif /* IPL_KEYPOINTS_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_FAST_RING		16	/* Pixels of the Bresenham circle of radius 3. */
+#define IPL_FAST_ARC		9	/* Minimum number of contiguous brighter (darker) pixels of a corner. */
+#define IPL_FAST_RADIUS		3	/* Radius of the circle. */
+#define IPL_ORB_PATCH_RADIUS	15	/* Radius of the patch of the intensity centroid. */
+#define IPL_ORB_BORDER		19	/* Border of the described keypoints: the patch, and the test pattern rotated. */
+#define IPL_ORB_SMOOTH_K	2	/* Gaussian kernel (5x5) smoothing the level before the binary tests. */
+
+/* Offsets (x, y) of the circle pixels, clockwise from the top. */
+static const int8_t ipl_fast_ring[IPL_FAST_RING][2] = {
+	{ 0, -3 }, { 1, -3 }, { 2, -2 }, { 3, -1 }, { 3, 0 }, { 3, 1 }, { 2, 2 }, { 1, 3 },
+	{ 0, 3 }, { -1, 3 }, { -2, 2 }, { -3, 1 }, { -3, 0 }, { -3, -1 }, { -2, -2 }, { -1, -3 }
+};
+
+/* Binary tests of the descriptor: (x1, y1, x2, y2) pairs, relative to the keypoint, drawn from an isotropic
+ * Gaussian distribution (sigma = 31 / 5) clipped to [-13, 13], as in BRIEF; bit i is set when the smoothed
+ * pixel at (x1, y1) is darker than the one at (x2, y2), both rotated by the orientation of the keypoint. */
+static const int8_t ipl_orb_pattern[STM32IPL_ORB_DESC_SIZE * 8 * 4] = {
+	-9, 3, -2, -3, 13, 3, 5, 4, -3, 0, -4, 7, 10, -13, 1, -1,
+	11, 9, 12, -4, 4, 5, 9, -6, 7, -3, 13, -1, -2, 5, 9, 10,
+	4, 3, -3, 3, 0, -5, 1, -5, 1, 12, 6, 9, 7, 1, -3, 6,
+	4, 8, 9, 1, 2, -3, 4, -7, 4, -2, 8, -2, -1, -7, 3, 8,
+	-5, -13, -2, 0, 1, 12, -4, 6, 6, 8, 2, -6, 13, 10, -9, -11,
+	-4, -6, 2, -6, -5, 0, -5, 10, -6, 1, -3, -1, 6, 2, -4, 2,
+	-11, -4, 6, 2, 0, 0, -2, 1, -4, -1, -2, 2, 0, -4, -1, 1,
+	3, -9, 1, 2, 4, 0, 7, 3, -1, 1, -2, -4, -8, 0, 3, -6,
+	4, -6, -6, -2, 5, 1, -5, -1, 9, 2, 2, 1, 1, -6, 5, 1,
+	-6, -3, 0, 6, 4, -3, -4, 2, 6, 1, -8, 6, 9, 5, -9, -5,
+	-6, -6, 4, -4, 0, -3, 4, -11, -2, -2, -9, -3, -5, 1, 3, -7,
+	1, 3, -5, 6, -3, 3, -8, -2, -3, -5, 6, -4, -4, -1, 12, -3,
+	0, 8, 3, 3, 3, -3, 4, -6, 1, -2, 2, 0, -11, -8, -4, -10,
+	-3, 0, -9, -6, 3, 1, 1, 0, 8, 2, -13, 2, -9, 9, 1, 6,
+	2, -10, 7, 0, -3, 2, 1, -5, 7, -12, 13, -8, -4, -3, -6, 7,
+	4, -2, -4, 8, -1, -6, 13, 7, 1, -12, -2, -13, -4, -2, -3, -8,
+	0, -1, -6, 6, 10, -1, 12, -5, 0, 2, 1, -13, 0, -10, 0, 2,
+	7, -2, -1, 1, -2, 9, 0, 6, -12, 1, -4, -1, 0, 8, 1, -8,
+	6, 1, 5, -2, 10, 3, 2, -2, 2, 3, -4, -1, -8, -8, -1, -2,
+	-3, 3, -6, 7, 11, 6, -3, -12, -4, -6, 3, -1, 1, 11, 0, -4,
+	-10, 5, -9, 4, -11, 1, -3, -6, -4, -2, -11, 13, -7, -1, -2, 0,
+	-8, -5, -3, -5, -2, 8, -5, -3, -2, -2, -2, 2, 12, 4, -1, -13,
+	-6, -5, 8, -5, 5, -5, 7, 11, -13, 0, -4, 4, -4, -3, -2, 1,
+	13, 6, 7, -3, 13, -3, -2, -9, 1, 1, -7, -7, 0, -10, -8, -1,
+	3, -6, 2, 0, 8, 8, -1, -13, 1, -3, -12, 8, 8, 1, 4, -2,
+	-8, -6, 5, 4, -8, 9, 6, 2, 2, 4, -3, -3, 0, 13, -7, 2,
+	-2, -8, -1, 5, 1, -1, 9, 0, -6, -3, -5, -6, 8, 0, 7, 0,
+	2, 4, 0, -1, 7, 13, 7, 1, -1, -2, 8, 0, 10, 0, -1, 7,
+	2, 7, -6, -2, -12, 4, -4, -1, 1, -5, -1, 13, 9, -3, 0, 0,
+	-7, 1, 9, 6, 1, 9, 8, 4, 6, 0, -5, -10, 0, -9, 2, -3,
+	1, 0, 2, 7, 8, 5, -5, 0, -2, -9, -9, 6, -4, -5, -5, 3,
+	10, -2, -7, 5, 1, -2, -8, 8, 6, -3, -2, 4, -13, -2, -8, -7,
+	6, 2, -8, 2, 13, -8, 3, -1, 3, -1, 1, 1, -8, -9, 3, -13,
+	2, 6, 8, 8, -2, -6, -3, -8, 2, 1, -5, -8, 6, -12, 8, -3,
+	11, 10, -7, 3, 2, 3, -11, -2, -2, -4, -12, 10, -4, 1, 5, 4,
+	-1, -4, 7, -5, 3, -9, 3, 5, -6, 1, -9, 10, -7, -3, 4, -6,
+	-5, 0, 2, 4, 5, -11, 2, -4, 0, -8, 2, -8, 1, 2, -6, -10,
+	6, -1, -7, -4, 0, -1, 2, 6, -3, 1, 13, -5, -8, 7, -3, 4,
+	13, 1, 3, 1, 6, 3, 6, -10, 7, -3, -1, -8, -2, -3, -4, -2,
+	-2, 1, -8, 3, 5, -2, 3, -6, -5, -3, -1, 4, 10, -3, 5, 2,
+	1, -11, 4, 2, -10, -2, 1, 5, -6, -6, 6, -13, 0, 6, -12, 0,
+	1, 3, -4, 11, 5, 5, -4, -2, 6, 4, 7, -1, -2, 0, 3, 6,
+	-7, 4, -4, 0, 7, -6, 5, 2, -1, 2, -6, 1, 13, 0, 5, 1,
+	-13, 6, -1, 4, -3, -2, -2, 0, 2, -6, -11, 4, -9, 4, 4, -12,
+	4, -6, 5, 0, 3, -2, -13, 3, 0, -4, -1, -3, -7, -8, -2, 5,
+	-11, 8, 0, 5, -6, 0, -2, 2, 13, -13, 8, -4, 2, -13, -6, 9,
+	5, 6, -5, 9, -10, 3, -2, -7, 12, -8, 1, -3, 5, 13, -5, -5,
+	-12, -3, 0, -5, 5, -7, 6, 9, -10, 3, -4, 0, -6, 6, 0, 9,
+	-8, -8, 8, 1, -7, 5, 2, -5, 8, -11, -6, -1, 1, 3, -5, 1,
+	12, 12, 9, 3, 9, -7, 13, -2, -12, 5, -7, 9, 4, -6, -2, 4,
+	-1, 4, 7, -2, -6, 9, 10, -6, -7, 13, 6, 2, 1, -2, 0, 13,
+	10, 8, 0, -11, -1, -1, 0, -13, 5, -3, -3, 3, 5, -6, -1, -6,
+	8, -2, 1, 13, -1, -10, -9, -3, 0, 0, 1, -3, -2, -4, 7, -10,
+	-8, 7, 0, 2, 2, 2, -13, 4, 3, -10, -7, -2, -4, 9, 2, -8,
+	-13, 0, 7, -3, -1, 7, 1, -6, -4, -1, 10, -7, -1, -2, -6, -6,
+	5, -4, -5, -13, 2, 1, 2, 2, -6, 0, -7, 12, -12, -4, -3, -6,
+	-13, -3, -7, 9, 3, 11, -4, 4, -11, -1, 4, 2, -6, 4, 4, -5,
+	3, -1, 7, 4, 11, 0, 1, 8, -4, -2, -1, -6, -3, 4, 2, 7,
+	2, -4, 3, 1, 7, 2, -2, -1, -1, -9, -1, 1, -2, -9, 9, -3,
+	2, 0, -2, -3, 3, -7, -11, 10, -2, -5, 1, -9, -6, 5, 0, 7,
+	-3, -10, 0, -7, 9, 1, -6, -2, 2, 1, -10, -5, -5, 0, 8, 9,
+	1, -8, -4, 3, -1, 4, -7, -13, -3, -10, 5, -8, 8, 4, 4, 4,
+	2, -2, -6, -10, 2, -1, 1, -3, 0, 3, 3, 1, -3, -8, -4, -5,
+	4, -4, -13, 8, 1, -8, -1, 9, 7, 2, -2, 7, 3, -12, -9, 7
+};
+
+/* State of a keypoint search. */
+typedef struct _ipl_kp_search_t
+{
+	stm32ipl_keypoint_t *kps;	/* Min-heap of the best keypoints (by score). */
+	uint32_t maxKps;			/* Capacity of the heap. */
+	uint32_t nKps;				/* Number of keypoints in the heap. */
+	const image_t *level;		/* Current level. */
+	const image_t *smooth;		/* Smoothed current level; null if the keypoints are not described. */
+	uint8_t levelIdx;			/* Index of the current level. */
+	float scale;				/* Downscale factor of the current level. */
+} ipl_kp_search_t;
+
+/* True when the 16-bit mask of the circle has IPL_FAST_ARC contiguous bits set (wrapping around). */
+static bool ipl_fast_arc(uint32_t mask)
+{
+	uint32_t run;
+
+	mask |= mask << IPL_FAST_RING;
+	run = mask;
+	for (uint32_t i = 1; i < IPL_FAST_ARC; i++)
+		run &= mask >> i;
+
+	return (run & 0xFFFF) != 0;
+}
+
+/* Marks with 1 the FAST corners among n consecutive pixels. */
+static void ipl_fast_row(const uint8_t *src, const int32_t *ring, uint32_t n, uint8_t threshold, uint8_t *corner)
+{
+#ifdef IPL_KEYPOINTS_HAS_MVE
+	mve_fast_row(src, ring, n, threshold, corner);
+#else
+	for (uint32_t x = 0; x < n; x++) {
+		const uint8_t *p = src + x;
+		int32_t hi = p[0] + threshold;
+		int32_t lo = p[0] - threshold;
+		uint32_t bright = 0;
+		uint32_t dark = 0;
+
+		/* An arc of IPL_FAST_ARC contains two consecutive compass points (0, 4, 8, 12) of the circle. */
+		for (uint32_t k = 0; k < IPL_FAST_RING; k += 4) {
+			int32_t v = p[ring[k]];
+
+			bright |= (v > hi) << k;
+			dark |= (v < lo) << k;
+		}
+
+		bright &= (bright >> 4) | (bright << 12);
+		dark &= (dark >> 4) | (dark << 12);
+		if (!bright && !dark) {
+			corner[x] = 0;
+			continue;
+		}
+
+		bright = 0;
+		dark = 0;
+		for (uint32_t k = 0; k < IPL_FAST_RING; k++) {
+			int32_t v = p[ring[k]];
+
+			bright |= (v > hi) << k;
+			dark |= (v < lo) << k;
+		}
+
+		corner[x] = ipl_fast_arc(bright) || ipl_fast_arc(dark);
+	}
+#endif /* IPL_KEYPOINTS_HAS_MVE */
+}
+
+/* Gets the score of a corner: the sum of the differences (beyond the threshold) from the center of the brighter
+ * circle pixels, or of the darker ones, whichever is greater. */
+static uint16_t ipl_fast_score(const uint8_t *p, const int32_t *ring, uint8_t threshold)
+{
+	int32_t hi = p[0] + threshold;
+	int32_t lo = p[0] - threshold;
+	int32_t sumBright = 0;
+	int32_t sumDark = 0;
+
+	for (uint32_t k = 0; k < IPL_FAST_RING; k++) {
+		int32_t v = p[ring[k]];
+
+		if (v > hi)
+			sumBright += v - hi;
+		else if (v < lo)
+			sumDark += lo - v;
+	}
+
+	return (uint16_t)IM_MAX(sumBright, sumDark);
+}
+
+/* Gets the orientation of a keypoint of the level: the direction of the intensity centroid of the circular patch. */
+static float ipl_orb_angle(const image_t *img, int32_t x, int32_t y)
+{
+	int32_t m01 = 0;
+	int32_t m10 = 0;
+
+	for (int32_t dy = -IPL_ORB_PATCH_RADIUS; dy <= IPL_ORB_PATCH_RADIUS; dy++) {
+		const uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y + dy) + x;
+		int32_t rowSum = 0;
+
+		for (int32_t dx = -IPL_ORB_PATCH_RADIUS; dx <= IPL_ORB_PATCH_RADIUS; dx++) {
+			if (((dx * dx) + (dy * dy)) <= (IPL_ORB_PATCH_RADIUS * IPL_ORB_PATCH_RADIUS)) {
+				m10 += dx * row[dx];
+				rowSum += row[dx];
+			}
+		}
+
+		m01 += dy * rowSum;
+	}
+
+	return atan2f((float)m01, (float)m10);
+}
+
+/* Computes the descriptor of a keypoint of the smoothed level, with the test pattern rotated by the angle. */
+static void ipl_orb_describe(const image_t *smooth, int32_t x, int32_t y, float angle, uint8_t *desc)
+{
+	const uint8_t *center = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(smooth, y) + x;
+	int32_t stride = smooth->w;
+	float cosA = arm_cos_f32(angle);
+	float sinA = arm_sin_f32(angle);
+	const int8_t *test = ipl_orb_pattern;
+
+	for (uint32_t i = 0; i < STM32IPL_ORB_DESC_SIZE; i++) {
+		uint8_t bits = 0;
+
+		for (uint32_t j = 0; j < 8; j++, test += 4) {
+			int32_t x1 = fast_roundf((test[0] * cosA) - (test[1] * sinA));
+			int32_t y1 = fast_roundf((test[0] * sinA) + (test[1] * cosA));
+			int32_t x2 = fast_roundf((test[2] * cosA) - (test[3] * sinA));
+			int32_t y2 = fast_roundf((test[2] * sinA) + (test[3] * cosA));
+
+			bits |= (center[(y1 * stride) + x1] < center[(y2 * stride) + x2]) << j;
+		}
+
+		desc[i] = bits;
+	}
+}
+
+/* Swaps two keypoints. */
+static void ipl_kp_swap(stm32ipl_keypoint_t *a, stm32ipl_keypoint_t *b)
+{
+	stm32ipl_keypoint_t t = *a;
+
+	*a = *b;
+	*b = t;
+}
+
+/* Moves down the keypoint i of the min-heap of n keypoints to its place. */
+static void ipl_kp_sift_down(stm32ipl_keypoint_t *kps, uint32_t n, uint32_t i)
+{
+	for (;;) {
+		uint32_t min = i;
+		uint32_t l = (2 * i) + 1;
+		uint32_t r = l + 1;
+
+		if ((l < n) && (kps[l].score < kps[min].score))
+			min = l;
+		if ((r < n) && (kps[r].score < kps[min].score))
+			min = r;
+		if (min == i)
+			break;
+
+		ipl_kp_swap(&kps[i], &kps[min]);
+		i = min;
+	}
+}
+
+/* Adds a corner of the current level, when it is among the best ones found so far. */
+static void ipl_kp_add(ipl_kp_search_t *search, int32_t x, int32_t y, uint16_t score)
+{
+	bool full = (search->nKps == search->maxKps);
+	stm32ipl_keypoint_t *kp;
+
+	if (full) {
+		/* The heap is full: the corner replaces the weakest keypoint (the root), if stronger. */
+		if (score <= search->kps[0].score)
+			return;
+		kp = &search->kps[0];
+	} else {
+		kp = &search->kps[search->nKps];
+	}
+
+	kp->x = ((x + 0.5f) * search->scale) - 0.5f;
+	kp->y = ((y + 0.5f) * search->scale) - 0.5f;
+	kp->score = score;
+	kp->level = search->levelIdx;
+	kp->angle = 0.0f;
+	memset(kp->desc, 0, STM32IPL_ORB_DESC_SIZE);
+
+	if (search->smooth) {
+		kp->angle = ipl_orb_angle(search->level, x, y);
+		ipl_orb_describe(search->smooth, x, y, kp->angle, kp->desc);
+	}
+
+	if (full) {
+		ipl_kp_sift_down(search->kps, search->nKps, 0);
+	} else {
+		/* Moves the new keypoint up to its place. */
+		uint32_t i = search->nKps++;
+
+		while ((i > 0) && (search->kps[i].score < search->kps[(i - 1) / 2].score)) {
+			ipl_kp_swap(&search->kps[i], &search->kps[(i - 1) / 2]);
+			i = (i - 1) / 2;
+		}
+	}
+}
+
+/* Finds the corners of the given area of the current level: the scores of three rows are kept, so that each
+ * row is suppressed (3x3 non-maximum suppression) as soon as the following one is scored. corner holds w bytes,
+ * scores 3 * w half-words. */
+static void ipl_kp_find_level(ipl_kp_search_t *search, const rectangle_t *area, uint8_t threshold, uint8_t *corner,
+		uint16_t *scores)
+{
+	const image_t *img = search->level;
+	int32_t ring[IPL_FAST_RING];
+	int32_t x0 = area->x;
+	int32_t x1 = area->x + area->w;
+	int32_t y0 = area->y;
+	int32_t y1 = area->y + area->h;
+
+	for (uint32_t k = 0; k < IPL_FAST_RING; k++)
+		ring[k] = (ipl_fast_ring[k][1] * (int32_t)img->w) + ipl_fast_ring[k][0];
+
+	memset(scores, 0, 3 * img->w * sizeof(uint16_t));
+
+	for (int32_t y = y0; y <= y1; y++) {
+		uint16_t *cur = scores + ((y % 3) * img->w);
+		uint16_t *prev = scores + (((y + 2) % 3) * img->w);
+		uint16_t *prev2 = scores + (((y + 1) % 3) * img->w);
+
+		/* Scores row y (the row after the area is left empty). */
+		memset(cur, 0, img->w * sizeof(uint16_t));
+		if (y < y1) {
+			const uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+
+			ipl_fast_row(row + x0, ring, x1 - x0, threshold, corner);
+			for (int32_t x = x0; x < x1; x++)
+				if (corner[x - x0])
+					cur[x] = ipl_fast_score(row + x, ring, threshold);
+		}
+
+		/* Suppresses row y - 1, whose neighbors are now scored; prev2 is empty before the first row. */
+		if (y > y0) {
+			for (int32_t x = x0; x < x1; x++) {
+				uint16_t s = prev[x];
+
+				if (s && (s > prev[x - 1]) && (s > prev[x + 1])
+						&& (s > prev2[x - 1]) && (s > prev2[x]) && (s > prev2[x + 1])
+						&& (s > cur[x - 1]) && (s > cur[x]) && (s > cur[x + 1]))
+					ipl_kp_add(search, x, y - 1, s);
+			}
+		}
+	}
+}
+///@endcond
+
+/**
+ * @brief Finds the FAST-9 corners of the levels of an image pyramid and, optionally, their ORB descriptors.
+ * A pixel is a corner when 9 contiguous pixels of the circle of radius 3 around it are all brighter than the
+ * pixel plus the threshold, or all darker than the pixel minus the threshold; the corners that are not the
+ * strongest of their 3x3 neighborhood are suppressed. The descriptor is made of 256 binary tests between the
+ * pixels of the level smoothed by a 5x5 Gaussian filter, rotated by the orientation of the keypoint (the direction
+ * of the intensity centroid of the patch of radius 15 around it). The keypoints with the highest scores are
+ * returned, sorted by descending score.
+ * The supported format is Grayscale.
+ * @param pyramid	Pyramid built with STM32Ipl_PyramidBuild(); if it is not valid, an error is returned.
+ * @param roi		Optional region of interest of the first level of the pyramid; when defined, it must be
+ * contained in the first level and have positive dimensions, otherwise an error is returned; when not defined,
+ * the whole image is considered. The corners closer than 3 pixels (19 pixels when they are described) to the
+ * borders of a level are not found.
+ * @param threshold	Minimum difference between the pixels of the arc and the corner.
+ * @param describe	If true, the orientation and the descriptor of the keypoints are computed.
+ * @param kps		Array of maxKps elements receiving the keypoints; if it is not valid, an error is returned.
+ * @param maxKps	Maximum number of keypoints; it must be greater than 0, otherwise an error is returned.
+ * @param nKps		Returns the number of keypoints found.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindKeypoints(const stm32ipl_pyramid_t *pyramid, const rectangle_t *roi, uint8_t threshold,
+		bool describe, stm32ipl_keypoint_t *kps, uint32_t maxKps, uint32_t *nKps)
+{
+	const image_t *img;
+	rectangle_t realRoi;
+	ipl_kp_search_t search;
+	uint32_t border = describe ? IPL_ORB_BORDER : IPL_FAST_RADIUS;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	uint8_t *corner;
+	uint16_t *scores;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(pyramid)
+	STM32IPL_CHECK_VALID_PTR_ARG(kps)
+	STM32IPL_CHECK_VALID_PTR_ARG(nKps)
+
+	if (!pyramid->levels || !maxKps)
+		return stm32ipl_err_InvalidParameter;
+
+	img = &pyramid->level[0];
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(img)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	*nKps = 0;
+
+	corner = fb_alloc(img->w, FB_ALLOC_PREFER_SPEED);
+	if (!corner)
+		return stm32ipl_err_OutOfMemory;
+
+	scores = fb_alloc(3 * img->w * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+	if (!scores) {
+		fb_free();
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	search.kps = kps;
+	search.maxKps = maxKps;
+	search.nKps = 0;
+
+	STM32IPL_TRACE_BEGIN(FindKeypoints)
+
+	for (uint8_t i = 0; i < pyramid->levels; i++) {
+		const image_t *level = &pyramid->level[i];
+		float scale = pyramid->scale[i];
+		image_t smooth;
+		rectangle_t area;
+		int32_t x0 = IM_MAX((int32_t)(realRoi.x / scale), (int32_t)border);
+		int32_t y0 = IM_MAX((int32_t)(realRoi.y / scale), (int32_t)border);
+		int32_t x1 = IM_MIN((int32_t)((realRoi.x + realRoi.w) / scale), (int32_t)level->w - (int32_t)border);
+		int32_t y1 = IM_MIN((int32_t)((realRoi.y + realRoi.h) / scale), (int32_t)level->h - (int32_t)border);
+
+		if ((x1 <= x0) || (y1 <= y0))
+			break;
+
+		STM32Ipl_RectInit(&area, x0, y0, x1 - x0, y1 - y0);
+
+		search.level = level;
+		search.smooth = NULL;
+		search.levelIdx = i;
+		search.scale = scale;
+
+		if (describe) {
+			res = STM32Ipl_AllocData(&smooth, level->w, level->h, IMAGE_BPP_GRAYSCALE);
+			if (res == stm32ipl_err_Ok) {
+				res = STM32Ipl_GaussianEx(level, &smooth, IPL_ORB_SMOOTH_K, false, false, NULL);
+				if (res != stm32ipl_err_Ok)
+					STM32Ipl_ReleaseData(&smooth);
+			}
+			if (res != stm32ipl_err_Ok)
+				break;
+
+			search.smooth = &smooth;
+		}
+
+		ipl_kp_find_level(&search, &area, threshold, corner, scores);
+
+		if (describe)
+			STM32Ipl_ReleaseData(&smooth);
+	}
+
+	/* Sorts the min-heap by descending score, moving the weakest keypoint to the end at each step. */
+	for (uint32_t n = search.nKps; n > 1; n--) {
+		ipl_kp_swap(&kps[0], &kps[n - 1]);
+		ipl_kp_sift_down(kps, n - 1, 0);
+	}
+
+	*nKps = search.nKps;
+
+	STM32IPL_TRACE_END(FindKeypoints)
+
+	fb_free();
+	fb_free();
+
+	return res;
+}
+
+/**
+ * @brief Counts the bits that differ between two binary descriptors (Hamming distance).
+ * @param desc1	First descriptor.
+ * @param desc2	Second descriptor.
+ * @param size	Size (bytes) of the descriptors.
+ * @return		Hamming distance, 0 in case of wrong arguments.
+ */
+uint32_t STM32Ipl_HammingDistance(const uint8_t *desc1, const uint8_t *desc2, uint32_t size)
+{
+	uint32_t dist = 0;
+
+	if (!desc1 || !desc2)
+		return 0;
+
+#ifdef IPL_KEYPOINTS_HAS_MVE
+	dist = mve_hamming_distance(desc1, desc2, size);
+#else
+	for (uint32_t i = 0; i < size; i++) {
+		uint32_t x = desc1[i] ^ desc2[i];
+
+		x -= (x >> 1) & 0x55;
+		x = (x & 0x33) + ((x >> 2) & 0x33);
+		dist += (x + (x >> 4)) & 0x0F;
+	}
+#endif /* IPL_KEYPOINTS_HAS_MVE */
+
+	return dist;
+}
+
+/**
+ * @brief Matches two sets of described keypoints (see STM32Ipl_FindKeypoints()) by brute force: each query
+ * keypoint is matched to the train keypoint whose descriptor has the smallest Hamming distance, when such
+ * distance does not exceed the maximum and, if the ratio is positive, it is less than ratio times the distance
+ * of the second best train keypoint (Lowe's ratio test, which rejects the ambiguous matches).
+ * @param query			Query keypoints; if it is not valid, an error is returned.
+ * @param nQuery		Number of query keypoints; it must not exceed 65536, otherwise an error is returned.
+ * @param train			Train keypoints; if it is not valid, an error is returned.
+ * @param nTrain		Number of train keypoints; it must not exceed 65536, otherwise an error is returned.
+ * @param maxDistance	Maximum Hamming distance of a match, in the range [0, 256].
+ * @param ratio			Ratio of the ratio test, in the range (0, 1] (typically 0.8); 0 disables the test.
+ * @param matches		Array of (at least) nQuery elements receiving the matches, sorted by query index; if it
+ * is not valid, an error is returned.
+ * @param nMatches		Returns the number of matches.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_MatchKeypoints(const stm32ipl_keypoint_t *query, uint32_t nQuery,
+		const stm32ipl_keypoint_t *train, uint32_t nTrain, uint16_t maxDistance, float ratio,
+		stm32ipl_kp_match_t *matches, uint32_t *nMatches)
+{
+	uint32_t count = 0;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(query)
+	STM32IPL_CHECK_VALID_PTR_ARG(train)
+	STM32IPL_CHECK_VALID_PTR_ARG(matches)
+	STM32IPL_CHECK_VALID_PTR_ARG(nMatches)
+
+	if ((nQuery > 65536) || (nTrain > 65536) || (ratio < 0.0f) || (ratio > 1.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(MatchKeypoints)
+
+	for (uint32_t q = 0; q < nQuery; q++) {
+		uint32_t best = UINT32_MAX;
+		uint32_t second = UINT32_MAX;
+		uint32_t bestIdx = 0;
+
+		for (uint32_t t = 0; t < nTrain; t++) {
+			uint32_t dist = STM32Ipl_HammingDistance(query[q].desc, train[t].desc, STM32IPL_ORB_DESC_SIZE);
+
+			if (dist < best) {
+				second = best;
+				best = dist;
+				bestIdx = t;
+			} else if (dist < second) {
+				second = dist;
+			}
+		}
+
+		if ((best > maxDistance) || ((ratio > 0.0f) && (second != UINT32_MAX) && (best >= (ratio * second))))
+			continue;
+
+		matches[count].query = (uint16_t)q;
+		matches[count].train = (uint16_t)bestIdx;
+		matches[count].distance = (uint16_t)best;
+		count++;
+	}
+
+	*nMatches = count;
+
+	STM32IPL_TRACE_END(MatchKeypoints)
+
+	return stm32ipl_err_Ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,430 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_label.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - connected components labeling module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* Maximum number of provisional labels (they are stored in the label image during the first pass). */
+#define IPL_LABEL_MAX	UINT16_MAX
+
+/* Accumulators of the statistics of a component (the minimum coordinates are kept in the bounding box). */
+typedef struct
+{
+	uint32_t sumX;
+	uint32_t sumY;
+	int16_t maxX;
+	int16_t maxY;
+} ipl_label_acc_t;
+
+/* Sets mask[x + 1] to 1 for the foreground (non-zero) pixels of the row y and to 0 for the background ones;
+ * mask[0], mask[w + 1] and mask[w + 2] are 0, as well as the whole mask for the rows out of the image. */
+static void ipl_label_mask_row(const image_t *src, int y, uint8_t *mask)
+{
+	mask[0] = 0;
+	mask[src->w + 1] = 0;
+	mask[src->w + 2] = 0;
+
+	if ((y < 0) || (y >= src->h)) {
+		memset(mask + 1, 0, src->w);
+		return;
+	}
+
+	if (src->bpp == IMAGE_BPP_BINARY) {
+		uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(src, y);
+		for (int x = 0; x < src->w; x++)
+			mask[x + 1] = IMAGE_GET_BINARY_PIXEL_FAST(row, x);
+	} else {
+		const uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y);
+		for (int x = 0; x < src->w; x++)
+			mask[x + 1] = (row[x] != 0);
+	}
+}
+
+/* Returns the root of the provisional label l, halving its path; the parent of a label is never greater than the
+ * label itself. */
+static inline uint16_t ipl_label_find(uint16_t *parent, uint16_t l)
+{
+	while (parent[l] < l) {
+		parent[l] = parent[parent[l]];
+		l = parent[l];
+	}
+
+	return l;
+}
+
+/* Merges the sets of the provisional labels a and b and returns the root of the merged set (the smaller one). */
+static inline uint16_t ipl_label_union(uint16_t *parent, uint16_t a, uint16_t b)
+{
+	a = ipl_label_find(parent, a);
+	b = ipl_label_find(parent, b);
+
+	if (a < b) {
+		parent[b] = a;
+		return a;
+	}
+
+	parent[a] = b;
+	return b;
+}
+
+/* Adds the pixel (x, y) to the statistics of the component l, if any. */
+static inline void ipl_label_add(stm32ipl_label_stats_t *stats, ipl_label_acc_t *acc, uint32_t nStats, uint16_t l,
+		int x, int y)
+{
+	if (l <= nStats) {
+		stm32ipl_label_stats_t *s = &stats[l - 1];
+		ipl_label_acc_t *a = &acc[l - 1];
+
+		s->area++;
+		a->sumX += x;
+		a->sumY += y;
+		if (x < s->bbox.x)
+			s->bbox.x = x;
+		if (x > a->maxX)
+			a->maxX = x;
+		if (y < s->bbox.y)
+			s->bbox.y = y;
+		if (y > a->maxY)
+			a->maxY = y;
+	}
+}
+
+/* First pass of the 8-connectivity labeling, on 2x2 blocks (the foreground pixels of a block are always connected,
+ * so a single provisional label is assigned to each block, and stored in its top-left pixel). A block is connected to
+ * the block on its left and to the three blocks above it only through the pixels they have in common with its
+ * border, as in the block-based decision tree of Grana et al.; the scan is done on row masks, with no tree.
+ * Returns the number of provisional labels, or -1 when they are more than IPL_LABEL_MAX. */
+static int ipl_label_pass1_8(const image_t *src, uint16_t *labels, uint16_t *parent, uint8_t *masks)
+{
+	uint32_t stride = src->w + 3;
+	uint8_t *prev = masks;
+	uint8_t *m0 = masks + stride;
+	uint8_t *m1 = masks + (2 * stride);
+	int n = 0;
+
+	ipl_label_mask_row(src, -1, m1);
+
+	for (int y = 0; y < src->h; y += 2) {
+		uint16_t *l0 = labels + (y * src->w);
+		const uint16_t *lp = l0 - (2 * src->w);
+		uint8_t *tmp = prev;
+
+		prev = m1;
+		m1 = tmp;
+		ipl_label_mask_row(src, y, m0);
+		ipl_label_mask_row(src, y + 1, m1);
+
+		for (int x = 0; x < src->w; x += 2) {
+			const uint8_t *p = prev + x + 1;
+			const uint8_t *a = m0 + x + 1;
+			const uint8_t *c = m1 + x + 1;
+			uint16_t l = 0;
+
+			if (a[0] | a[1] | c[0] | c[1]) {
+				/* Top-left block. */
+				if (a[0] && p[-1])
+					l = lp[x - 2];
+
+				/* Top block. */
+				if ((a[0] | a[1]) && (p[0] | p[1]))
+					l = l ? ipl_label_union(parent, l, lp[x]) : lp[x];
+
+				/* Top-right block. */
+				if (a[1] && p[2])
+					l = l ? ipl_label_union(parent, l, lp[x + 2]) : lp[x + 2];
+
+				/* Left block. */
+				if ((a[0] | c[0]) && (a[-1] | c[-1]))
+					l = l ? ipl_label_union(parent, l, l0[x - 2]) : l0[x - 2];
+
+				if (!l) {
+					if (n == IPL_LABEL_MAX)
+						return -1;
+					l = ++n;
+					parent[l] = l;
+				}
+			}
+
+			l0[x] = l;
+		}
+	}
+
+	return n;
+}
+
+/* First pass of the 4-connectivity labeling, on pixels: each foreground pixel is connected to the pixel above it
+ * and to the one on its left. Returns the number of provisional labels, or -1 when they are more than
+ * IPL_LABEL_MAX. */
+static int ipl_label_pass1_4(const image_t *src, uint16_t *labels, uint16_t *parent, uint8_t *mask)
+{
+	int n = 0;
+
+	for (int y = 0; y < src->h; y++) {
+		uint16_t *l0 = labels + (y * src->w);
+		const uint16_t *lp = l0 - src->w;
+
+		ipl_label_mask_row(src, y, mask);
+
+		for (int x = 0; x < src->w; x++) {
+			uint16_t l = 0;
+
+			if (mask[x + 1]) {
+				uint16_t up = (y > 0) ? lp[x] : 0;
+				uint16_t left = (x > 0) ? l0[x - 1] : 0;
+
+				if (up && left)
+					l = (up == left) ? up : ipl_label_union(parent, up, left);
+				else
+					l = up | left;
+
+				if (!l) {
+					if (n == IPL_LABEL_MAX)
+						return -1;
+					l = ++n;
+					parent[l] = l;
+				}
+			}
+
+			l0[x] = l;
+		}
+	}
+
+	return n;
+}
+///@endcond
+
+/**
+ * @brief Allocates a data memory buffer to contain the labels of an image of the given size.
+ * The data buffer must be released with STM32Ipl_LabelsReleaseData().
+ * @param labels	Label image; if it is not valid, an error is returned.
+ * @param width		Width of the label image.
+ * @param height	Height of the label image.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LabelsAllocData(stm32ipl_labels_t *labels, uint32_t width, uint32_t height)
+{
+	uint16_t *data;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(labels)
+
+	data = xalloc(width * height * sizeof(uint16_t));
+	if (!data) {
+		labels->w = 0;
+		labels->h = 0;
+		labels->data = 0;
+		labels->count = 0;
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	labels->w = width;
+	labels->h = height;
+	labels->data = data;
+	labels->count = 0;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the data memory buffer of the label image and resets the label image structure.
+ * @param labels	Label image; if it is not valid, an error is returned.
+ * @return			void.
+ */
+void STM32Ipl_LabelsReleaseData(stm32ipl_labels_t *labels)
+{
+	if (labels) {
+		xfree(labels->data);
+		labels->w = 0;
+		labels->h = 0;
+		labels->data = 0;
+		labels->count = 0;
+	}
+}
+
+/**
+ * @brief Labels the connected components of the foreground (non-zero) pixels of the source image: each pixel of
+ * the label image is set to 0 for the background and to the label (1..count) of its component otherwise; the
+ * labels are assigned in raster order of the first pixel (4-connectivity) or 2x2 block (8-connectivity) of each
+ * component. The labeling is done with two linear
+ * passes: the first one assigns provisional labels and records their equivalences (with 8-connectivity it works on
+ * 2x2 blocks, with 4-connectivity on pixels), the second one writes the final labels and computes the statistics.
+ * The supported formats are Binary, Grayscale (e.g. a thresholded image).
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param labels		Label image, with the same size of the source image; if it is not valid, an error is
+ * returned. On success, its count field is set to the number of components.
+ * @param connectivity	Connectivity of the pixels: 4 or 8, otherwise an error is returned.
+ * @param stats			Optional array of nStats elements that receives the statistics of the components
+ * (stats[i] for the label i + 1); the components whose label is greater than nStats are not reported.
+ * @param nStats		Number of elements of stats.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_OpNotCompleted if the provisional labels exceed
+ * 65535 (the label image is not valid in such case), error otherwise.
+ * @note The working memory is about 2 * (w * h / 4) bytes with 8-connectivity, 2 * (w * h / 2) bytes with
+ * 4-connectivity (up to 128 KB), plus 12 bytes for each element of stats.
+ */
+stm32ipl_err_t STM32Ipl_LabelComponents(const image_t *src, stm32ipl_labels_t *labels, uint8_t connectivity,
+		stm32ipl_label_stats_t *stats, uint32_t nStats)
+{
+	uint32_t maxLabels;
+	uint32_t masksSize;
+	uint32_t accSize;
+	uint16_t *parent;
+	uint8_t *masks;
+	ipl_label_acc_t *acc = 0;
+	int n;
+	uint16_t count;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_NOT_RGB)
+	STM32IPL_CHECK_VALID_PTR_ARG(labels)
+	STM32IPL_CHECK_VALID_PTR_ARG(labels->data)
+
+	if ((labels->w != (uint32_t)src->w) || (labels->h != (uint32_t)src->h))
+		return stm32ipl_err_WrongSize;
+
+	if ((connectivity != 4) && (connectivity != 8))
+		return stm32ipl_err_InvalidParameter;
+
+	if (!stats)
+		nStats = 0;
+
+	/* Upper bound of the provisional labels: one every two blocks (8-connectivity) or pixels (4-connectivity)
+	 * of each row. */
+	maxLabels = ((src->w + 1) / 2) * ((connectivity == 8) ? ((src->h + 1) / 2) : src->h);
+	if (maxLabels > IPL_LABEL_MAX)
+		maxLabels = IPL_LABEL_MAX;
+	masksSize = ((connectivity == 8) ? 3 : 1) * (src->w + 3);
+	accSize = ((nStats < maxLabels) ? nStats : maxLabels) * sizeof(ipl_label_acc_t);
+
+	if (fb_avail() < (FB_ALLOC_SPACE((maxLabels + 1) * sizeof(uint16_t)) + FB_ALLOC_SPACE(masksSize)
+			+ FB_ALLOC_SPACE(accSize)))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(LabelComponents)
+
+	parent = fb_alloc((maxLabels + 1) * sizeof(uint16_t), FB_ALLOC_PREFER_SPEED);
+	masks = fb_alloc(masksSize, FB_ALLOC_PREFER_SPEED);
+	parent[0] = 0;
+
+	n = (connectivity == 8) ? ipl_label_pass1_8(src, labels->data, parent, masks) :
+			ipl_label_pass1_4(src, labels->data, parent, masks);
+	if (n < 0) {
+		fb_free(); /* masks */
+		fb_free(); /* parent */
+		labels->count = 0;
+		STM32IPL_TRACE_END(LabelComponents)
+		return stm32ipl_err_OpNotCompleted;
+	}
+
+	/* Final labels, consecutive in raster order (the parent of a label always precedes it). */
+	count = 0;
+	for (int l = 1; l <= n; l++)
+		parent[l] = (parent[l] < l) ? parent[parent[l]] : ++count;
+
+	if (nStats > count)
+		nStats = count;
+
+	if (nStats) {
+		acc = fb_alloc(nStats * sizeof(ipl_label_acc_t), FB_ALLOC_PREFER_SPEED);
+		for (uint32_t i = 0; i < nStats; i++) {
+			stats[i].area = 0;
+			stats[i].bbox.x = INT16_MAX;
+			stats[i].bbox.y = INT16_MAX;
+			acc[i].sumX = 0;
+			acc[i].sumY = 0;
+			acc[i].maxX = 0;
+			acc[i].maxY = 0;
+		}
+	}
+
+	if (connectivity == 8) {
+		uint8_t *m0 = masks;
+		uint8_t *m1 = masks + (src->w + 3);
+
+		for (int y = 0; y < src->h; y += 2) {
+			uint16_t *l0 = labels->data + (y * src->w);
+			uint16_t *l1 = l0 + src->w;
+			bool lastRow = (y + 1) >= src->h;
+
+			ipl_label_mask_row(src, y, m0);
+			ipl_label_mask_row(src, y + 1, m1);
+
+			for (int x = 0; x < src->w; x += 2) {
+				uint16_t l = parent[l0[x]];
+				bool lastCol = (x + 1) >= src->w;
+
+				l0[x] = m0[x + 1] ? l : 0;
+				if (!lastCol)
+					l0[x + 1] = m0[x + 2] ? l : 0;
+				if (!lastRow) {
+					l1[x] = m1[x + 1] ? l : 0;
+					if (!lastCol)
+						l1[x + 1] = m1[x + 2] ? l : 0;
+				}
+
+				if (l && nStats) {
+					if (m0[x + 1])
+						ipl_label_add(stats, acc, nStats, l, x, y);
+					if (m0[x + 2])
+						ipl_label_add(stats, acc, nStats, l, x + 1, y);
+					if (m1[x + 1])
+						ipl_label_add(stats, acc, nStats, l, x, y + 1);
+					if (m1[x + 2])
+						ipl_label_add(stats, acc, nStats, l, x + 1, y + 1);
+				}
+			}
+		}
+	} else {
+		for (int y = 0; y < src->h; y++) {
+			uint16_t *l0 = labels->data + (y * src->w);
+
+			for (int x = 0; x < src->w; x++) {
+				uint16_t l = parent[l0[x]];
+
+				l0[x] = l;
+				if (l && nStats)
+					ipl_label_add(stats, acc, nStats, l, x, y);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < nStats; i++) {
+		stats[i].bbox.w = acc[i].maxX - stats[i].bbox.x + 1;
+		stats[i].bbox.h = acc[i].maxY - stats[i].bbox.y + 1;
+		stats[i].cx = (float)acc[i].sumX / stats[i].area;
+		stats[i].cy = (float)acc[i].sumY / stats[i].area;
+	}
+
+	if (nStats)
+		fb_free(); /* acc */
+	fb_free(); /* masks */
+	fb_free(); /* parent */
+
+	labels->count = count;
+
+	STM32IPL_TRACE_END(LabelComponents)
+
+	return stm32ipl_err_Ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,10 +40,13 @@ stm32ipl_err_t STM32Ipl_ImageMaskRectangle(image_t *img, uint16_t x, uint16_t y,
 
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(ImageMaskRectangle)
 
 	res = STM32Ipl_AllocData(&mask, img->w, img->h, IMAGE_BPP_BINARY);
-	if (res != stm32ipl_err_Ok)
+	if (res != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(ImageMaskRectangle)
 		return res;
+	}
 
 	STM32Ipl_Fill(&mask, 0, STM32IPL_COLOR_BLACK);
 
@@ -52,6 +55,7 @@ stm32ipl_err_t STM32Ipl_ImageMaskRectangle(image_t *img, uint16_t x, uint16_t y,
 
 	STM32Ipl_ReleaseData(&mask);
 
+	STM32IPL_TRACE_END(ImageMaskRectangle)
 	return stm32ipl_err_Ok;
 }
 
@@ -71,10 +75,13 @@ stm32ipl_err_t STM32Ipl_ImageMaskCircle(image_t *img, uint16_t cx, uint16_t cy,
 
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(ImageMaskCircle)
 
 	res = STM32Ipl_AllocData(&mask, img->w, img->h, IMAGE_BPP_BINARY);
-	if (res != stm32ipl_err_Ok)
+	if (res != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(ImageMaskCircle)
 		return res;
+	}
 
 	STM32Ipl_Fill(&mask, 0, STM32IPL_COLOR_BLACK);
 
@@ -83,6 +90,7 @@ stm32ipl_err_t STM32Ipl_ImageMaskCircle(image_t *img, uint16_t cx, uint16_t cy,
 
 	STM32Ipl_ReleaseData(&mask);
 
+	STM32IPL_TRACE_END(ImageMaskCircle)
 	return stm32ipl_err_Ok;
 }
 
@@ -105,9 +113,12 @@ stm32ipl_err_t STM32Ipl_ImageMaskEllipse(image_t *img, const ellipse_t *ellipse)
 	if (ellipse->rotation > 360)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(ImageMaskEllipse)
 	res = STM32Ipl_AllocData(&mask, img->w, img->h, IMAGE_BPP_BINARY);
-	if (res != stm32ipl_err_Ok)
+	if (res != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(ImageMaskEllipse)
 		return res;
+	}
 
 	STM32Ipl_Fill(&mask, 0, STM32IPL_COLOR_BLACK);
 
@@ -118,6 +129,7 @@ stm32ipl_err_t STM32Ipl_ImageMaskEllipse(image_t *img, const ellipse_t *ellipse)
 
 	STM32Ipl_ReleaseData(&mask);
 
+	STM32IPL_TRACE_END(ImageMaskEllipse)
 	return stm32ipl_err_Ok;
 }
 
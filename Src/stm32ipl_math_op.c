@@ -18,6 +18,9 @@
 
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#ifdef IPL_MATOP_HAS_MVE
+#include "mve_matop.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,9 +56,11 @@ stm32ipl_err_t STM32Ipl_Invert(image_t *img)
 {
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(Invert)
 
 	imlib_invert(img);
 
+	STM32IPL_TRACE_END(Invert)
 	return stm32ipl_err_Ok;
 }
 
@@ -72,10 +77,12 @@ stm32ipl_err_t STM32Ipl_Invert(image_t *img)
  */
 stm32ipl_err_t STM32Ipl_And(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(And)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_and(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(And)
 	return stm32ipl_err_Ok;
 }
 
@@ -92,10 +99,12 @@ stm32ipl_err_t STM32Ipl_And(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Nand(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Nand)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_nand(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Nand)
 	return stm32ipl_err_Ok;
 }
 
@@ -112,10 +121,12 @@ stm32ipl_err_t STM32Ipl_Nand(image_t *imgA, const image_t *imgB, stm32ipl_color_
  */
 stm32ipl_err_t STM32Ipl_Or(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Or)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_or(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Or)
 	return stm32ipl_err_Ok;
 }
 
@@ -132,10 +143,12 @@ stm32ipl_err_t STM32Ipl_Or(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Nor(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Nor)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_nor(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Nor)
 	return stm32ipl_err_Ok;
 }
 
@@ -152,10 +165,12 @@ stm32ipl_err_t STM32Ipl_Nor(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Xor(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Xor)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_xor(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Xor)
 	return stm32ipl_err_Ok;
 }
 
@@ -172,10 +187,12 @@ stm32ipl_err_t STM32Ipl_Xor(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Xnor(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Xnor)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_b_xnor(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Xnor)
 	return stm32ipl_err_Ok;
 }
 
@@ -192,10 +209,12 @@ stm32ipl_err_t STM32Ipl_Xnor(image_t *imgA, const image_t *imgB, stm32ipl_color_
  */
 stm32ipl_err_t STM32Ipl_Add(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Add)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_add(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Add)
 	return stm32ipl_err_Ok;
 }
 
@@ -214,10 +233,12 @@ stm32ipl_err_t STM32Ipl_Add(image_t *imgA, const image_t *imgB, stm32ipl_color_t
 stm32ipl_err_t STM32Ipl_Sub(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, bool invert,
 		const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Sub)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_sub(imgA, NULL, (image_t*)imgB, newColor, invert, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Sub)
 	return stm32ipl_err_Ok;
 }
 
@@ -237,10 +258,12 @@ stm32ipl_err_t STM32Ipl_Sub(image_t *imgA, const image_t *imgB, stm32ipl_color_t
 stm32ipl_err_t STM32Ipl_Mul(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, bool invert,
 		const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Mul)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_mul(imgA, NULL, (image_t*)imgB, newColor, invert, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Mul)
 	return stm32ipl_err_Ok;
 }
 
@@ -260,10 +283,12 @@ stm32ipl_err_t STM32Ipl_Mul(image_t *imgA, const image_t *imgB, stm32ipl_color_t
 stm32ipl_err_t STM32Ipl_Div(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, bool invert, bool mod,
 		const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Div)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_div(imgA, NULL, (image_t*)imgB, newColor, invert, mod, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Div)
 	return stm32ipl_err_Ok;
 }
 
@@ -280,10 +305,12 @@ stm32ipl_err_t STM32Ipl_Div(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Diff(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Diff)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_difference(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Diff)
 	return stm32ipl_err_Ok;
 }
 
@@ -300,10 +327,12 @@ stm32ipl_err_t STM32Ipl_Diff(image_t *imgA, const image_t *imgB, stm32ipl_color_
  */
 stm32ipl_err_t STM32Ipl_Min(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Min)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_min(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Min)
 	return stm32ipl_err_Ok;
 }
 
@@ -320,10 +349,112 @@ stm32ipl_err_t STM32Ipl_Min(image_t *imgA, const image_t *imgB, stm32ipl_color_t
  */
 stm32ipl_err_t STM32Ipl_Max(image_t *imgA, const image_t *imgB, stm32ipl_color_t color, const image_t *mask)
 {
+	STM32IPL_TRACE_BEGIN(Max)
 	CHECK_AND_ADAPT(imgA, imgB, color, mask)
 
 	imlib_max(imgA, NULL, (image_t*)imgB, newColor, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Max)
+	return stm32ipl_err_Ok;
+}
+
+/* Blends two channel values: (b * alpha + a * (255 - alpha)) / 255, rounded to the nearest integer. */
+#define IPL_BLEND(a, b, alpha) ((((b) * (alpha)) + ((a) * (255 - (alpha))) + 127) / 255)
+
+/**
+ * @brief Blends an image over another one: imgA = (imgB * alpha + imgA * (255 - alpha)) / 255, channel by channel.
+ * The RGB565 channels are expanded to 8 bits before blending. When STM32IPL_ENABLE_HW_PIXEL_OPS is defined and mask
+ * is NULL, the RGB565 and RGB888 images are blended by the DMA2D, whose rounding may differ by one unit.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param imgA		First image; it is overwritten with the result of the operation. If it is not valid, an error is returned.
+ * @param imgB		Second image; it must have same format and size as the first image, otherwise an error is returned.
+ * @param alpha		Weight of the second image, from 0 (imgA is not modified) to 255 (imgB is copied to imgA).
+ * @param mask 		Optional image to be used as a pixel level mask for the operation. The mask must have the same resolution
+ * as the source image. Only the source pixels that have the corresponding mask pixels set are considered.
+ * The pointer to the mask can be null: in this case all the source image pixels are considered.
+ * @return			stm32ipl_err_Ok on success, error otherwise
+ */
+stm32ipl_err_t STM32Ipl_Blend(image_t *imgA, const image_t *imgB, uint8_t alpha, const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(imgA)
+	STM32IPL_CHECK_FORMAT(imgA, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_IMAGE(imgB)
+	STM32IPL_CHECK_SAME_HEADER(imgA, imgB)
+
+	if (mask) {
+		STM32IPL_CHECK_VALID_IMAGE(mask)
+		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
+		STM32IPL_CHECK_SAME_SIZE(imgA, mask)
+	}
+
+	STM32IPL_TRACE_BEGIN(Blend)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if (!mask && (ipl_hw_blend(imgA, imgB, alpha, true) == stm32ipl_err_Ok)) {
+		STM32IPL_TRACE_END(Blend)
+		return stm32ipl_err_Ok;
+	}
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
+
+	for (int y = 0; y < imgA->h; y++) {
+		switch (imgA->bpp) {
+			case IMAGE_BPP_GRAYSCALE: {
+				uint8_t *rowA = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(imgA, y);
+				uint8_t *rowB = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(imgB, y);
+
+				for (int sx = 0, sn; (sn = image_mask_span((image_t*)mask, &sx, y, imgA->w, false)); sx += sn)
+#ifdef IPL_MATOP_HAS_MVE
+					mve_matop_blend_u8(rowA + sx, rowB + sx, sn, alpha);
+#else
+					for (int x = sx; x < sx + sn; x++)
+						rowA[x] = IPL_BLEND(rowA[x], rowB[x], alpha);
+#endif
+				break;
+			}
+
+			case IMAGE_BPP_RGB565: {
+				uint16_t *rowA = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(imgA, y);
+				uint16_t *rowB = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(imgB, y);
+
+				for (int sx = 0, sn; (sn = image_mask_span((image_t*)mask, &sx, y, imgA->w, false)); sx += sn) {
+#ifdef IPL_MATOP_HAS_MVE
+					mve_matop_blend_rgb565(rowA + sx, rowB + sx, sn, alpha);
+#else
+					for (int x = sx; x < sx + sn; x++) {
+						uint16_t a = rowA[x];
+						uint16_t b = rowB[x];
+						uint32_t r = IPL_BLEND(COLOR_RGB565_TO_R8(a), COLOR_RGB565_TO_R8(b), alpha);
+						uint32_t g = IPL_BLEND(COLOR_RGB565_TO_G8(a), COLOR_RGB565_TO_G8(b), alpha);
+						uint32_t bl = IPL_BLEND(COLOR_RGB565_TO_B8(a), COLOR_RGB565_TO_B8(b), alpha);
+
+						rowA[x] = COLOR_R8_G8_B8_TO_RGB565(r, g, bl);
+					}
+#endif
+				}
+				break;
+			}
+
+			default: {
+				rgb888_t *rowA = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(imgA, y);
+				rgb888_t *rowB = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(imgB, y);
+
+				for (int sx = 0, sn; (sn = image_mask_span((image_t*)mask, &sx, y, imgA->w, false)); sx += sn) {
+#ifdef IPL_MATOP_HAS_MVE
+					mve_matop_blend_u8((uint8_t*)(rowA + sx), (const uint8_t*)(rowB + sx), sn * 3, alpha);
+#else
+					for (int x = sx; x < sx + sn; x++) {
+						rowA[x].r = IPL_BLEND(rowA[x].r, rowB[x].r, alpha);
+						rowA[x].g = IPL_BLEND(rowA[x].g, rowB[x].g, alpha);
+						rowA[x].b = IPL_BLEND(rowA[x].b, rowB[x].b, alpha);
+					}
+#endif
+				}
+				break;
+			}
+		}
+	}
+
+	STM32IPL_TRACE_END(Blend)
 	return stm32ipl_err_Ok;
 }
 
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
+#include "stm32ipl.h"
 #include "stm32ipl_mem_alloc.h"
 #include "umm_malloc.h"
 
@@ -30,19 +31,276 @@ extern "C" {
 
 ///@cond
 #define FB_ALLOC_MAX_ENTRY		64	/* Max number of entries managed with fb_alloc. */
+#define FB_ALLOC_ALIGN(p)		(((uintptr_t)(p) + (FB_ALLOC_ALIGNMENT - 1)) & ~(uintptr_t)(FB_ALLOC_ALIGNMENT - 1))
 
-static uint32_t g_fb_alloc_stack[FB_ALLOC_MAX_ENTRY];
-static uint32_t g_fb_alloc_inext = 0;
-static uint32_t g_fb_alloc_imark = 0;
+/* Memory regions the fb stack can take its buffers from. */
+typedef enum _fb_region_t
+{
+	FB_REGION_INT = 0,	/* Fast (internal) memory region. */
+	FB_REGION_EXT,		/* Large (external) memory region. */
+	FB_REGION_WS,		/* Caller-provided workspace (exclusive while it is active). */
+	FB_REGION_NUM,
+	FB_REGION_HEAP = FB_REGION_NUM	/* Buffer taken from the UMM heap (no region available). */
+} fb_region_t;
+
+/* Contiguous memory region managed as a stack: buffers are pushed and popped by moving top. */
+typedef struct _fb_region_mem_t
+{
+	uint8_t *base;
+	uint8_t *end;
+	uint8_t *top;
+} fb_region_mem_t;
+
+/* Entry of the fb stack. For region entries, ptr is the top of the region before the allocation. */
+typedef struct _fb_entry_t
+{
+	uint8_t *ptr;
+	uint32_t region;
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	uint32_t size;
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+} fb_entry_t;
+
+#ifndef STM32IPL_CTX_THREAD_LOCAL
+#define STM32IPL_CTX_THREAD_LOCAL	/* The current context is shared by all the threads. */
+#endif /* STM32IPL_CTX_THREAD_LOCAL */
+
+/* Library context: state of the allocators used by the functions called while the context is the current one. */
+struct _stm32ipl_ctx_t
+{
+	umm_heap_t heap;						/* Heap; the default context uses the default UMM heap instead. */
+	fb_region_mem_t fbRegion[FB_REGION_NUM];	/* Regions of the fb stack. */
+	fb_entry_t fbStack[FB_ALLOC_MAX_ENTRY];	/* Entries of the fb stack. */
+	uint32_t fbNext;						/* Index of the next free entry of the fb stack. */
+	uint32_t fbMark;						/* Entry index saved by fb_alloc_mark(). */
+	uint8_t *fbRegionMark[FB_REGION_NUM];	/* Region tops saved by fb_alloc_mark(). */
+	void *listPool;							/* Pool set with list_pool_begin(). */
+	uint32_t deadline;						/* Cycle counter value set by STM32Ipl_SetDeadline(). */
+	bool deadlineSet;						/* True when a deadline is set. */
+	bool deadlineHit;						/* True when the deadline passed since ctx_deadline_begin(). */
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	stm32ipl_mem_stats_t memStats;			/* Memory usage statistics. */
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+};
+
+/* Context initialized by STM32Ipl_InitLib(). */
+static stm32ipl_ctx_t g_ctx_default;
+
+/* Current context; each thread has its own when STM32IPL_CTX_THREAD_LOCAL is defined. */
+static STM32IPL_CTX_THREAD_LOCAL stm32ipl_ctx_t *g_ctx = &g_ctx_default;
+
+/* Number of regions selectable through the allocation hints. */
+#define FB_REGION_HINTED		2
+
+/* Order in which the regions are tried, depending on the allocation hint. */
+static const fb_region_t g_fb_region_order[3][FB_REGION_HINTED] = {
+	{ FB_REGION_EXT, FB_REGION_INT },	/* FB_ALLOC_NO_HINT: keep the fast memory for the hot buffers. */
+	{ FB_REGION_INT, FB_REGION_EXT },	/* FB_ALLOC_PREFER_SPEED */
+	{ FB_REGION_EXT, FB_REGION_INT }	/* FB_ALLOC_PREFER_SIZE */
+};
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+#define MEM_STATS_CALLER()	__builtin_return_address(0)
+
+/* Updates the heap usage, as seen by the UMM allocator. */
+static void mem_stats_update_heap(void)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+	uint32_t freeSize = umm_free_heap_size();
+
+	ctx->memStats.heapUsed = (ctx->memStats.heapSize > freeSize) ? (ctx->memStats.heapSize - freeSize) : 0;
+	if (ctx->memStats.heapUsed > ctx->memStats.heapPeak)
+		ctx->memStats.heapPeak = ctx->memStats.heapUsed;
+}
+
+/* Accounts an allocation request to its call site. */
+static void mem_stats_add_site(const void *caller, uint32_t size)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+	stm32ipl_mem_site_t *site = NULL;
+
+	for (uint32_t i = 0; i < ctx->memStats.siteCount; i++) {
+		if (ctx->memStats.sites[i].caller == caller) {
+			site = &ctx->memStats.sites[i];
+			break;
+		}
+	}
+
+	if (!site) {
+		if (ctx->memStats.siteCount == STM32IPL_MEM_STATS_MAX_SITES)
+			return;
+
+		site = &ctx->memStats.sites[ctx->memStats.siteCount++];
+		site->caller = caller;
+		site->count = 0;
+		site->bytes = 0;
+		site->maxBytes = 0;
+	}
+
+	site->count++;
+	site->bytes += size;
+	if (size > site->maxBytes)
+		site->maxBytes = size;
+}
+
+/* Accounts a heap allocation. */
+static void mem_stats_heap_alloc(const void *p, uint32_t size, const void *caller)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	ctx->memStats.allocCount++;
+	mem_stats_add_site(caller, size);
+
+	if (p) {
+		ctx->memStats.heapLiveBlocks++;
+		mem_stats_update_heap();
+	} else
+		ctx->memStats.failCount++;
+}
+
+/* Accounts a heap release. */
+static void mem_stats_heap_free(const void *p)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	if (p && ctx->memStats.heapLiveBlocks)
+		ctx->memStats.heapLiveBlocks--;
+
+	mem_stats_update_heap();
+}
+
+/* Accounts a push on the fb stack. */
+static void mem_stats_fb_alloc(const void *p, uint32_t size, const void *caller)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	ctx->memStats.allocCount++;
+	mem_stats_add_site(caller, size);
+
+	if (!p) {
+		ctx->memStats.failCount++;
+		return;
+	}
+
+	ctx->memStats.fbUsed += size;
+	if (ctx->memStats.fbUsed > ctx->memStats.fbPeak)
+		ctx->memStats.fbPeak = ctx->memStats.fbUsed;
+
+	ctx->memStats.fbLiveEntries++;
+	if (ctx->memStats.fbLiveEntries > ctx->memStats.fbPeakEntries)
+		ctx->memStats.fbPeakEntries = ctx->memStats.fbLiveEntries;
+
+	if (ctx->fbRegion[FB_REGION_INT].base) {
+		uint32_t used = ctx->fbRegion[FB_REGION_INT].top - ctx->fbRegion[FB_REGION_INT].base;
+		if (used > ctx->memStats.fbIntPeak)
+			ctx->memStats.fbIntPeak = used;
+	}
+
+	if (ctx->fbRegion[FB_REGION_EXT].base) {
+		uint32_t used = ctx->fbRegion[FB_REGION_EXT].top - ctx->fbRegion[FB_REGION_EXT].base;
+		if (used > ctx->memStats.fbExtPeak)
+			ctx->memStats.fbExtPeak = used;
+	}
+
+	if (ctx->fbStack[ctx->fbNext - 1].region == FB_REGION_HEAP) {
+		ctx->memStats.heapLiveBlocks++;
+		mem_stats_update_heap();
+	}
+
+	ctx->fbStack[ctx->fbNext - 1].size = size;
+}
+
+/* Accounts a pop from the fb stack. */
+static void mem_stats_fb_free(const fb_entry_t *e)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	ctx->memStats.fbUsed = (ctx->memStats.fbUsed > e->size) ? (ctx->memStats.fbUsed - e->size) : 0;
+
+	if (ctx->memStats.fbLiveEntries)
+		ctx->memStats.fbLiveEntries--;
+
+	if (e->region == FB_REGION_HEAP)
+		mem_stats_heap_free(e->ptr);
+}
+#else
+#define MEM_STATS_CALLER()	NULL
+#endif /* STM32IPL_ENABLE_MEM_STATS */
 
 /* Prototypes. */
 void* STM32Ipl_Alloc(uint32_t size);
 void* STM32Ipl_Alloc0(uint32_t size);
 void STM32Ipl_Free(void *mem);
 void* STM32Ipl_Realloc(void *mem, uint32_t size);
+void STM32Ipl_InitFbStack(void *intMemAddr, uint32_t intMemSize, void *extMemAddr, uint32_t extMemSize);
+stm32ipl_ctx_t* STM32Ipl_InitCtx(void *memAddr, uint32_t memSize);
+void STM32Ipl_DeInitCtx(stm32ipl_ctx_t *ctx);
+stm32ipl_ctx_t* STM32Ipl_SetCtx(stm32ipl_ctx_t *ctx);
+stm32ipl_ctx_t* STM32Ipl_GetCtx(void);
+#ifdef STM32IPL_ENABLE_MEM_STATS
+stm32ipl_err_t STM32Ipl_GetMemStats(stm32ipl_mem_stats_t *stats);
+void STM32Ipl_ResetMemStats(void);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
 __attribute__((weak)) void STM32Ipl_FaultHandler(const char *error);
 ///@endcond
 
+/*
+ * @brief Allocates a memory buffer from the heap.
+ * @param size		Size of the memory buffer to be allocated (bytes).
+ * @param zero		If true, the buffer is set to zero.
+ * @param caller	Address of the code requesting the buffer (used by the memory statistics only).
+ * @return			The allocated memory buffer, null in case of errors.
+ */
+static void* heap_alloc(uint32_t size, bool zero, const void *caller)
+{
+	void *mem = umm_malloc(size);
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	mem_stats_heap_alloc(mem, size, caller);
+#else
+	(void)caller;
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+	if (mem)
+		STM32Ipl_PerfAlloc(size);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
+	if (mem && zero)
+		memset(mem, 0, size);
+
+	return mem;
+}
+
+/*
+ * @brief Re-sizes a memory buffer allocated from the heap.
+ * @param mem		Pointer to the the memory buffer.
+ * @param size		Size of the memory buffer to be allocated (bytes).
+ * @param caller	Address of the code requesting the buffer (used by the memory statistics only).
+ * @return			The allocated memory buffer, null in case of errors.
+ */
+static void* heap_realloc(void *mem, uint32_t size, const void *caller)
+{
+	void *newMem = umm_realloc(mem, size);
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	if (mem && (newMem || !size)) {
+		/* The old buffer does not exist anymore. */
+		mem_stats_heap_free(mem);
+	}
+	mem_stats_heap_alloc(newMem, size, caller);
+#else
+	(void)caller;
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+	if (newMem)
+		STM32Ipl_PerfAlloc(size);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
+	return newMem;
+}
+
 /*
  * Exported functions.
  */
@@ -55,7 +313,7 @@ __attribute__((weak)) void STM32Ipl_FaultHandler(const char *error);
  */
 void* STM32Ipl_Alloc(uint32_t size)
 {
-	return xalloc(size);
+	return heap_alloc(size, false, MEM_STATS_CALLER());
 }
 
 /**
@@ -66,7 +324,7 @@ void* STM32Ipl_Alloc(uint32_t size)
  */
 void* STM32Ipl_Alloc0(uint32_t size)
 {
-	return xalloc0(size);
+	return heap_alloc(size, true, MEM_STATS_CALLER());
 }
 
 /**
@@ -88,10 +346,203 @@ void STM32Ipl_Free(void *mem)
  */
 void* STM32Ipl_Realloc(void *mem, uint32_t size)
 {
-	return xrealloc(mem, size);
+	return heap_realloc(mem, size, MEM_STATS_CALLER());
+}
+
+/**
+ * @brief Assigns dedicated memory regions to the stack-based allocator used by the library functions
+ * for their temporary buffers (line buffers, look-up tables, etc.). Such buffers are then pushed and
+ * popped in constant time instead of being taken from the heap reserved by STM32Ipl_InitLib().
+ * The buffers that must be accessed fast are taken from the internal region first, the others are taken
+ * from the external region first; when none of the two regions has enough space, the heap is used.
+ * The regions are assigned to the current context (see STM32Ipl_SetCtx()).
+ * This function must be called after STM32Ipl_InitLib(), when no temporary buffer is allocated.
+ * @param intMemAddr	Address of the internal (fast) memory region, i.e. DTCM or AXI-SRAM; it can be null.
+ * @param intMemSize	Size of the internal memory region (bytes).
+ * @param extMemAddr	Address of the external (large) memory region, i.e. SDRAM; it can be null.
+ * @param extMemSize	Size of the external memory region (bytes).
+ * @return				void.
+ */
+void STM32Ipl_InitFbStack(void *intMemAddr, uint32_t intMemSize, void *extMemAddr, uint32_t extMemSize)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	fb_init();
+
+	if (intMemAddr && intMemSize) {
+		ctx->fbRegion[FB_REGION_INT].base = (uint8_t*)intMemAddr;
+		ctx->fbRegion[FB_REGION_INT].end = (uint8_t*)intMemAddr + intMemSize;
+		ctx->fbRegion[FB_REGION_INT].top = (uint8_t*)intMemAddr;
+	}
+
+	if (extMemAddr && extMemSize) {
+		ctx->fbRegion[FB_REGION_EXT].base = (uint8_t*)extMemAddr;
+		ctx->fbRegion[FB_REGION_EXT].end = (uint8_t*)extMemAddr + extMemSize;
+		ctx->fbRegion[FB_REGION_EXT].top = (uint8_t*)extMemAddr;
+	}
+}
+
+/**
+ * @brief Creates a library context on the given memory buffer: the context descriptor takes the first bytes
+ * of the buffer, the rest becomes the heap of the context. Each context has its own heap, fb stack, list pool
+ * and memory statistics, so the library functions called by different threads do not share any allocator
+ * state when each thread works on its own context. The context is not made the current one: use STM32Ipl_SetCtx().
+ * @param memAddr	Address of the memory buffer assigned to the context.
+ * @param memSize	Size of the memory buffer (bytes).
+ * @return			The context, null if the buffer is not valid or too small.
+ */
+stm32ipl_ctx_t* STM32Ipl_InitCtx(void *memAddr, uint32_t memSize)
+{
+	stm32ipl_ctx_t *ctx;
+	stm32ipl_ctx_t *prev;
+	uint8_t *heapAddr;
+	uint8_t *end;
+
+	if (!memAddr)
+		return NULL;
+
+	ctx = (stm32ipl_ctx_t*)FB_ALLOC_ALIGN(memAddr);
+	heapAddr = (uint8_t*)FB_ALLOC_ALIGN((uint8_t*)ctx + sizeof(stm32ipl_ctx_t));
+	end = (uint8_t*)memAddr + memSize;
+
+	if (heapAddr >= end || (uint32_t)(end - heapAddr) < (4 * UMM_BLOCK_BODY_SIZE))
+		return NULL;
+
+	memset(ctx, 0, sizeof(stm32ipl_ctx_t));
+
+	prev = STM32Ipl_SetCtx(ctx);
+	umm_init(heapAddr, end - heapAddr);
+	mem_stats_init();
+	STM32Ipl_SetCtx(prev);
+
+	return ctx;
 }
 
+/**
+ * @brief De-initializes a context created with STM32Ipl_InitCtx(); its memory buffer can then be reused.
+ * If the context is the current one of the calling thread, the default context becomes the current one.
+ * @param ctx	Context; if null or the default context, nothing is done (see STM32Ipl_DeInitLib()).
+ * @return		void.
+ */
+void STM32Ipl_DeInitCtx(stm32ipl_ctx_t *ctx)
+{
+	if (!ctx || ctx == &g_ctx_default)
+		return;
+
+	if (g_ctx == ctx)
+		STM32Ipl_SetCtx(NULL);
+
+	memset(ctx, 0, sizeof(stm32ipl_ctx_t));
+}
+
+/**
+ * @brief Makes the given context the current one: the library functions called afterwards take their buffers
+ * from it. When STM32IPL_CTX_THREAD_LOCAL is defined, the current context is kept per thread (each thread starts
+ * with the default context); otherwise it is shared, and it must be switched by the scheduler when the threads
+ * using the library can preempt each other.
+ * @param ctx	Context created with STM32Ipl_InitCtx(); null selects the default context (STM32Ipl_InitLib()).
+ * @return		The previous current context.
+ */
+stm32ipl_ctx_t* STM32Ipl_SetCtx(stm32ipl_ctx_t *ctx)
+{
+	stm32ipl_ctx_t *prev = g_ctx;
+
+	g_ctx = ctx ? ctx : &g_ctx_default;
+	umm_select((g_ctx == &g_ctx_default) ? NULL : &g_ctx->heap);
+
+	return prev;
+}
+
+/**
+ * @brief Gets the current context.
+ * @return		The current context.
+ */
+stm32ipl_ctx_t* STM32Ipl_GetCtx(void)
+{
+	return g_ctx;
+}
+
+/**
+ * @brief Sets a deadline for the functions with a time budget: STM32Ipl_DetectObject(), STM32Ipl_FindTemplate(),
+ * STM32Ipl_FindBlobs(), STM32Ipl_FindCircles() and their variants. When the deadline passes, they stop and return
+ * the results found so far with stm32ipl_err_Partial; the coarse scales (STM32Ipl_DetectObject()), a coarse grid of
+ * positions (STM32Ipl_FindTemplate() with SEARCH_EX) and a coarse set of radii (STM32Ipl_FindCircles()) are then
+ * searched first. The deadline applies to all the calls of the current context (see STM32Ipl_SetCtx()) until it is
+ * removed, so that a single budget can bound a whole frame. It is checked between the steps of the search (e.g. once
+ * per row), so a function can exceed it by the time of one step. The time is measured with STM32Ipl_CycleCounterGet(),
+ * which must be enabled (see STM32Ipl_CycleCounterInit()).
+ * @param cycles	Time budget from now (cycles), less than 2^31; zero removes the deadline.
+ * @return			void.
+ */
+void STM32Ipl_SetDeadline(uint32_t cycles)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	ctx->deadline = STM32Ipl_CycleCounterGet() + cycles;
+	ctx->deadlineSet = (cycles != 0);
+}
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+/**
+ * @brief Gets the memory usage statistics collected since the initialization of the library
+ * or since the last call to STM32Ipl_ResetMemStats(). Each call site is identified by the address
+ * of the code that requested the memory, which can be resolved through the map file of the application.
+ * @param stats	Statistics; if it is not valid, an error is returned.
+ * @return		stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetMemStats(stm32ipl_mem_stats_t *stats)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	if (!stats)
+		return stm32ipl_err_InvalidParameter;
+
+	mem_stats_update_heap();
+	ctx->memStats.heapMaxFreeBlock = umm_max_free_block_size();
+
+	memcpy(stats, &ctx->memStats, sizeof(stm32ipl_mem_stats_t));
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Resets the memory usage statistics: the peaks are set to the current usage,
+ * the counters and the call sites are cleared.
+ * @return		void.
+ */
+void STM32Ipl_ResetMemStats(void)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	mem_stats_update_heap();
+
+	ctx->memStats.heapPeak = ctx->memStats.heapUsed;
+	ctx->memStats.fbPeak = ctx->memStats.fbUsed;
+	ctx->memStats.fbIntPeak = ctx->fbRegion[FB_REGION_INT].top - ctx->fbRegion[FB_REGION_INT].base;
+	ctx->memStats.fbExtPeak = ctx->fbRegion[FB_REGION_EXT].top - ctx->fbRegion[FB_REGION_EXT].base;
+	ctx->memStats.fbPeakEntries = ctx->memStats.fbLiveEntries;
+	ctx->memStats.allocCount = 0;
+	ctx->memStats.failCount = 0;
+	ctx->memStats.siteCount = 0;
+	memset(ctx->memStats.sites, 0, sizeof(ctx->memStats.sites));
+}
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
 ///@cond
+/*
+ * @brief Initializes the memory statistics; it must be called just after the heap initialization.
+ * @return		void.
+ */
+void mem_stats_init(void)
+{
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	memset(&ctx->memStats, 0, sizeof(ctx->memStats));
+	ctx->memStats.heapSize = umm_free_heap_size();
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+}
+
 __attribute__((weak)) void STM32Ipl_FaultHandler(const char *error)
 {
 	while (1)
@@ -119,7 +570,7 @@ void umm_alloc_fail(void)
  */
 void* xalloc(uint32_t size)
 {
-	return umm_malloc(size);
+	return heap_alloc(size, false, MEM_STATS_CALLER());
 }
 
 /* Not used.
@@ -137,14 +588,7 @@ void* xalloc(uint32_t size)
  */
 void* xalloc0(uint32_t size)
 {
-	void *mem = umm_malloc(size);
-
-	if (mem == NULL)
-		return NULL;
-
-	memset(mem, 0, size);
-
-	return mem;
+	return heap_alloc(size, true, MEM_STATS_CALLER());
 }
 
 /*
@@ -155,6 +599,10 @@ void* xalloc0(uint32_t size)
 void xfree(void *mem)
 {
 	umm_free(mem);
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	mem_stats_heap_free(mem);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
 }
 
 /*
@@ -166,19 +614,23 @@ void xfree(void *mem)
  */
 void* xrealloc(void *mem, uint32_t size)
 {
-	return umm_realloc(mem, size);
+	return heap_realloc(mem, size, MEM_STATS_CALLER());
 }
 
 /*
- * @brief Initialized the fb mechanism, that is a stack based memory allocator that, under the
- * hood, uses heap memory .
+ * @brief Initialized the fb mechanism, that is a stack based memory allocator. The buffers are taken from the
+ * regions assigned with STM32Ipl_InitFbStack() or, when no region is available, from the heap.
  * @return		void.
  */
 void fb_init(void)
 {
-	memset(g_fb_alloc_stack, 0, sizeof(uint32_t) * FB_ALLOC_MAX_ENTRY);
-	g_fb_alloc_inext = 0;
-	g_fb_alloc_imark = 0;
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	memset(ctx->fbStack, 0, sizeof(ctx->fbStack));
+	memset(ctx->fbRegion, 0, sizeof(ctx->fbRegion));
+	memset(ctx->fbRegionMark, 0, sizeof(ctx->fbRegionMark));
+	ctx->fbNext = 0;
+	ctx->fbMark = 0;
 }
 
 /*
@@ -190,56 +642,155 @@ void fb_alloc_fail(void)
 	STM32Ipl_FaultHandler("fb_alloc() failure");
 }
 
+/*
+ * @brief Returns the size (bytes) of the biggest buffer that can be pushed on the given region.
+ * @param region	Region.
+ * @return			Available size (bytes).
+ */
+static uint32_t fb_region_avail(fb_region_t region)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+	fb_region_mem_t *r = &ctx->fbRegion[region];
+	uint8_t *p;
+
+	if (!r->base)
+		return 0;
+
+	p = (uint8_t*)FB_ALLOC_ALIGN(r->top);
+
+	return (p < r->end) ? (uint32_t)(r->end - p) : 0;
+}
+
 /*
  * @brief Returns the size (bytes) of the biggest memory block available from the fb stack.
  * @return		void.
  */
 uint32_t fb_avail(void)
 {
-	return umm_max_free_block_size();
+	stm32ipl_ctx_t *ctx = g_ctx;
+	uint32_t avail;
+
+	if (ctx->fbRegion[FB_REGION_WS].base)
+		return fb_region_avail(FB_REGION_WS);
+
+	avail = umm_max_free_block_size();
+
+	for (uint32_t i = 0; i < FB_REGION_HINTED; i++) {
+		uint32_t regionAvail = fb_region_avail((fb_region_t)i);
+		if (regionAvail > avail)
+			avail = regionAvail;
+	}
+
+	return avail;
 }
 
 /*
  * @brief Allocates a memory buffer of size bytes from the fb stack.
  * Such buffer must be released with fb_free().
  * @param size	Size of the memory buffer to be allocated (bytes).
- * @param hints	Argument not used.
+ * @param hints	FB_ALLOC_PREFER_SPEED to get the buffer from the internal memory region first,
+ * FB_ALLOC_NO_HINT or FB_ALLOC_PREFER_SIZE to get it from the external memory region first.
+ * @param caller	Address of the code requesting the buffer (used by the memory statistics only).
  * @return		The allocated memory buffer, null in case of errors.
  */
-void* fb_alloc(uint32_t size, int hints)
+static void* fb_push(uint32_t size, int hints, const void *caller)
 {
+	static const fb_region_t wsOrder[1] = { FB_REGION_WS };
+	stm32ipl_ctx_t *ctx = g_ctx;
+	const fb_region_t *order;
+	uint32_t orderNum;
 	void *p = NULL;
 
-	if (g_fb_alloc_inext == FB_ALLOC_MAX_ENTRY) {
+	if (ctx->fbNext == FB_ALLOC_MAX_ENTRY) {
+#ifdef STM32IPL_ENABLE_MEM_STATS
+		mem_stats_fb_alloc(NULL, size, caller);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
 		fb_alloc_fail();
 		return NULL;
 	}
 
-	p = umm_malloc(size);
+	if (ctx->fbRegion[FB_REGION_WS].base) {
+		/* While a workspace is active, the buffers are taken from it only. */
+		order = wsOrder;
+		orderNum = 1;
+	} else {
+		order = g_fb_region_order[(hints == FB_ALLOC_PREFER_SPEED || hints == FB_ALLOC_PREFER_SIZE) ? hints : FB_ALLOC_NO_HINT];
+		orderNum = FB_REGION_HINTED;
+	}
+
+	for (uint32_t i = 0; i < orderNum; i++) {
+		fb_region_mem_t *r = &ctx->fbRegion[order[i]];
+
+		if (fb_region_avail(order[i]) >= size) {
+			ctx->fbStack[ctx->fbNext].ptr = r->top;
+			ctx->fbStack[ctx->fbNext].region = order[i];
+			ctx->fbNext++;
+
+			p = (void*)FB_ALLOC_ALIGN(r->top);
+			r->top = (uint8_t*)p + size;
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+			mem_stats_fb_alloc(p, size, caller);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+			STM32Ipl_PerfAlloc(size);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
+			return p;
+		}
+	}
+
+	p = (orderNum == FB_REGION_HINTED) ? umm_malloc(size) : NULL;
+	if (p) {
+		ctx->fbStack[ctx->fbNext].ptr = (uint8_t*)p;
+		ctx->fbStack[ctx->fbNext].region = FB_REGION_HEAP;
+		ctx->fbNext++;
+	}
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	mem_stats_fb_alloc(p, size, caller);
+#else
+	(void)caller;
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
 	if (p)
-		g_fb_alloc_stack[g_fb_alloc_inext++] = (uint32_t)p;
-	else
+		STM32Ipl_PerfAlloc(size);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+
+	if (!p)
 		fb_alloc_fail();
 
 	return p;
 }
 
+/*
+ * @brief Allocates a memory buffer of size bytes from the fb stack.
+ * Such buffer must be released with fb_free().
+ * @param size	Size of the memory buffer to be allocated (bytes).
+ * @param hints	FB_ALLOC_PREFER_SPEED to get the buffer from the internal memory region first,
+ * FB_ALLOC_NO_HINT or FB_ALLOC_PREFER_SIZE to get it from the external memory region first.
+ * @return		The allocated memory buffer, null in case of errors.
+ */
+void* fb_alloc(uint32_t size, int hints)
+{
+	return fb_push(size, hints, MEM_STATS_CALLER());
+}
+
 /*
  * @brief Same as fb_alloc(), but the allocated buffer is set to zero.
  * Such buffer must be released with fb_free().
  * @param size	Size of the memory buffer to be allocated (bytes).
- * @param hints	Argument not used.
+ * @param hints	See fb_alloc().
  * @return		Allocated memory buffer, null in case of errors.
  */
 void* fb_alloc0(uint32_t size, int hints)
 {
 	void *p = NULL;
 
-	p = fb_alloc(size, hints);
+	p = fb_push(size, hints, MEM_STATS_CALLER());
 	if (p)
 		memset(p, 0, size);
-	else
-		fb_alloc_fail();
 
 	return p;
 }
@@ -248,7 +799,7 @@ void* fb_alloc0(uint32_t size, int hints)
  * @brief Allocates the biggest memory buffer from the fb stack.
  * Such buffer must be released with fb_free().
  * @param size	Used to return the size of the allocated memory buffer (bytes).
- * @param hints	Argument not used.
+ * @param hints	See fb_alloc().
  * @return		The allocated memory buffer, null in case of errors.
  */
 void* fb_alloc_all(uint32_t *size, int hints)
@@ -256,7 +807,7 @@ void* fb_alloc_all(uint32_t *size, int hints)
 	uint32_t max_size = fb_avail();
 	void *p = NULL;
 
-	p = fb_alloc(max_size, hints);
+	p = fb_push(max_size, hints, MEM_STATS_CALLER());
 	*size = (p == NULL) ? 0 : max_size;
 
 	return p;
@@ -266,7 +817,7 @@ void* fb_alloc_all(uint32_t *size, int hints)
  * @brief Same as fb_alloc_all(), but the allocated buffer is set to zero.
  * Such buffer must be released with fb_free().
  * @param size	Size of the memory buffer to be allocated (bytes).
- * @param hints	Argument not used.
+ * @param hints	See fb_alloc().
  * @return		Allocated memory buffer, null in case of errors.
  */
 void* fb_alloc0_all(uint32_t *size, int hints)
@@ -274,7 +825,9 @@ void* fb_alloc0_all(uint32_t *size, int hints)
 	uint32_t max_size = fb_avail();
 	void *p = NULL;
 
-	p = fb_alloc0(max_size, hints);
+	p = fb_push(max_size, hints, MEM_STATS_CALLER());
+	if (p)
+		memset(p, 0, max_size);
 	*size = (p == NULL) ? 0 : max_size;
 
 	return p;
@@ -286,44 +839,181 @@ void* fb_alloc0_all(uint32_t *size, int hints)
  */
 void fb_free(void)
 {
-	if (g_fb_alloc_inext == 0)
+	stm32ipl_ctx_t *ctx = g_ctx;
+	fb_entry_t *e;
+
+	if (ctx->fbNext == 0)
 		return;
 
-	g_fb_alloc_inext--;
-	umm_free((void*)g_fb_alloc_stack[g_fb_alloc_inext]);
-	g_fb_alloc_stack[g_fb_alloc_inext] = 0;
+	ctx->fbNext--;
+	e = &ctx->fbStack[ctx->fbNext];
+
+	if (e->region == FB_REGION_HEAP)
+		umm_free(e->ptr);
+	else
+		ctx->fbRegion[e->region].top = e->ptr;
+
+#ifdef STM32IPL_ENABLE_MEM_STATS
+	mem_stats_fb_free(e);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+
+	e->ptr = NULL;
 }
 
 /*
  * @brief Frees all the memory buffers allocated with fb_alloc(), fb_alloc_all() or fb_alloc0_all().
- * @return		void
+ * @return		void.
  */
 void fb_free_all(void)
 {
-	uint32_t e = g_fb_alloc_inext;
+	stm32ipl_ctx_t *ctx = g_ctx;
+	uint32_t e = ctx->fbNext;
 	for (int i = 0; i < e; i++)
 		fb_free();
 }
 
+/*
+ * @brief Makes the fb stack take its buffers from the given workspace only, until fb_workspace_end() is called;
+ * the regions assigned with STM32Ipl_InitFbStack() and the heap are not used meanwhile.
+ * The buffers pushed while the workspace is active must be popped before calling fb_workspace_end().
+ * @param ws	Workspace.
+ * @param size	Size of the workspace (bytes).
+ * @return		true on success, false if the workspace is not valid or another workspace is active.
+ */
+bool fb_workspace_begin(void *ws, uint32_t size)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+	fb_region_mem_t *r = &ctx->fbRegion[FB_REGION_WS];
+
+	if (!ws || !size || r->base)
+		return false;
+
+	r->base = (uint8_t*)ws;
+	r->end = (uint8_t*)ws + size;
+	r->top = (uint8_t*)ws;
+
+	return true;
+}
+
+/*
+ * @brief Stops using the workspace set with fb_workspace_begin().
+ * @return		void.
+ */
+void fb_workspace_end(void)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	memset(&ctx->fbRegion[FB_REGION_WS], 0, sizeof(fb_region_mem_t));
+}
+
 /*
  * @brief Marks the current stack pointer.
  * @return		void.
  */
 void fb_alloc_mark(void)
 {
-	g_fb_alloc_imark = g_fb_alloc_inext;
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	ctx->fbMark = ctx->fbNext;
+
+	for (uint32_t i = 0; i < FB_REGION_NUM; i++)
+		ctx->fbRegionMark[i] = ctx->fbRegion[i].top;
 }
 
 /*
  * @brief Frees all the memory buffers allocated on the stack after the last call to fb_alloc_mark().
+ * The regions are released by resetting their top to the marked position; only the buffers taken
+ * from the heap need to be released one by one.
  * @return		void.
  */
 void fb_alloc_free_till_mark(void)
 {
-	int32_t e = g_fb_alloc_inext - g_fb_alloc_imark;
+	stm32ipl_ctx_t *ctx = g_ctx;
 
-	for (int i = 0; i < e; i++)
-		fb_free();
+	if (ctx->fbNext < ctx->fbMark)
+		return;
+
+	for (uint32_t i = ctx->fbMark; i < ctx->fbNext; i++) {
+		if (ctx->fbStack[i].region == FB_REGION_HEAP)
+			umm_free(ctx->fbStack[i].ptr);
+#ifdef STM32IPL_ENABLE_MEM_STATS
+		mem_stats_fb_free(&ctx->fbStack[i]);
+#endif /* STM32IPL_ENABLE_MEM_STATS */
+		ctx->fbStack[i].ptr = NULL;
+	}
+
+	for (uint32_t i = 0; i < FB_REGION_NUM; i++) {
+		if (ctx->fbRegion[i].base)
+			ctx->fbRegion[i].top = ctx->fbRegionMark[i];
+	}
+
+	ctx->fbNext = ctx->fbMark;
+}
+
+/*
+ * @brief Returns the list pool of the current context (see list_pool_begin()).
+ * @return		The pool, null if none.
+ */
+void* ctx_list_pool_get(void)
+{
+	return g_ctx->listPool;
+}
+
+/*
+ * @brief Sets the list pool of the current context (see list_pool_begin()).
+ * @param pool	Pool; null for none.
+ * @return		void.
+ */
+void ctx_list_pool_set(void *pool)
+{
+	g_ctx->listPool = pool;
+}
+
+/*
+ * @brief Tells if a deadline is set in the current context (see STM32Ipl_SetDeadline()); the functions with a time
+ * budget can then change the order of their search, so that the most useful results are found first.
+ * @return		true if a deadline is set, false otherwise.
+ */
+bool ctx_deadline_active(void)
+{
+	return g_ctx->deadlineSet;
+}
+
+/*
+ * @brief Tells if the deadline of the current context (see STM32Ipl_SetDeadline()) has passed; in such case, the
+ * event is recorded for ctx_deadline_end(). It is called by the functions with a time budget between the steps
+ * of their search (e.g. once per row), which then stop and keep the results found so far.
+ * @return		true if the deadline has passed, false otherwise or when no deadline is set.
+ */
+bool ctx_deadline_expired(void)
+{
+	stm32ipl_ctx_t *ctx = g_ctx;
+
+	/* The signed difference is right also when the counter wraps around. */
+	if (!ctx->deadlineSet || ((int32_t)(STM32Ipl_CycleCounterGet() - ctx->deadline) < 0))
+		return false;
+
+	ctx->deadlineHit = true;
+
+	return true;
+}
+
+/*
+ * @brief Starts a function with a time budget: clears the record of a passed deadline.
+ * @return		void.
+ */
+void ctx_deadline_begin(void)
+{
+	g_ctx->deadlineHit = false;
+}
+
+/*
+ * @brief Ends a function with a time budget.
+ * @return		true if the function stopped at the deadline since ctx_deadline_begin(), false otherwise.
+ */
+bool ctx_deadline_end(void)
+{
+	return g_ctx->deadlineHit;
 }
 ///@endcond
 
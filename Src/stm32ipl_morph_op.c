@@ -27,6 +27,10 @@ extern "C" {
  * @brief Adds pixels to the edges of segmented areas.
  * Convolving a kernel pixels across the previously segmented image and setting the center pixel of the kernel
  * if the sum of the neighbour pixels set is greater than threshold.
+ * With threshold 0 and no mask, Binary and Grayscale images are dilated with the maximum of the kernel, computed
+ * with the van Herk/Gil-Werman algorithm, whose cost per pixel does not depend on the kernel size (for Grayscale
+ * images this is the grayscale dilation, that gives the same result on the thresholded images).
+ * Binary images are processed 32 pixels at a time (128 on MVE targets).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -39,17 +43,41 @@ extern "C" {
  */
 stm32ipl_err_t STM32Ipl_Dilate(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_DilateEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Dilate(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The van Herk/Gil-Werman path writes the result straight to the destination image; the other paths copy
+ * the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Dilate().
+ * @param threshold 	See STM32Ipl_Dilate().
+ * @param mask		 	Optional mask; see STM32Ipl_Dilate().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DilateEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_dilate(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Dilate)
+	imlib_dilate((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Dilate)
 	return stm32ipl_err_Ok;
 }
 
@@ -57,6 +85,10 @@ stm32ipl_err_t STM32Ipl_Dilate(image_t *img, uint8_t kSize, uint8_t threshold, c
  * @brief Removes pixels from the edges of segmented areas.
  * Convolving a kernel pixels across the image and zeroing the center pixel of the kernel
  * if the sum of the neighbour pixels set is not greater than threshold.
+ * With threshold ((kSize * 2) + 1)^2 - 1 and no mask, Binary and Grayscale images are eroded with the minimum of the
+ * kernel, computed with the van Herk/Gil-Werman algorithm, whose cost per pixel does not depend on the kernel size
+ * (for Grayscale images this is the grayscale erosion, that gives the same result on the thresholded images).
+ * Binary images are processed 32 pixels at a time (128 on MVE targets).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -69,22 +101,48 @@ stm32ipl_err_t STM32Ipl_Dilate(image_t *img, uint8_t kSize, uint8_t threshold, c
  */
 stm32ipl_err_t STM32Ipl_Erode(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_ErodeEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Erode(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The van Herk/Gil-Werman path writes the result straight to the destination image; the other paths copy
+ * the source image to it and process it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Erode().
+ * @param threshold 	See STM32Ipl_Erode().
+ * @param mask		 	Optional mask; see STM32Ipl_Erode().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ErodeEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_erode(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Erode)
+	imlib_erode((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Erode)
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Performs erosion and dilation on an image.
+ * With threshold 0 and no mask, Binary and Grayscale images use the van Herk/Gil-Werman erosion and dilation
+ * (see STM32Ipl_Erode() and STM32Ipl_Dilate()).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize	is 		Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -97,22 +155,47 @@ stm32ipl_err_t STM32Ipl_Erode(image_t *img, uint8_t kSize, uint8_t threshold, co
  */
 stm32ipl_err_t STM32Ipl_Open(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_OpenEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Open(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The first operation writes to the destination image, the second one processes it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Open().
+ * @param threshold 	See STM32Ipl_Open().
+ * @param mask		 	Optional mask; see STM32Ipl_Open().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_OpenEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_open(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Open)
+	imlib_open((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Open)
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Performs dilation and erosion on an image in order.
+ * With threshold 0 and no mask, Binary and Grayscale images use the van Herk/Gil-Werman erosion and dilation
+ * (see STM32Ipl_Erode() and STM32Ipl_Dilate()).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -125,22 +208,47 @@ stm32ipl_err_t STM32Ipl_Open(image_t *img, uint8_t kSize, uint8_t threshold, con
  */
 stm32ipl_err_t STM32Ipl_Close(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_CloseEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_Close(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The first operation writes to the destination image, the second one processes it in place.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_Close().
+ * @param threshold 	See STM32Ipl_Close().
+ * @param mask		 	Optional mask; see STM32Ipl_Close().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_CloseEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_close(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Close)
+	imlib_close((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(Close)
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Performs the difference of an image and the opened image.
+ * With threshold 0 and no mask, Binary and Grayscale images use the van Herk/Gil-Werman erosion and dilation
+ * (see STM32Ipl_Erode() and STM32Ipl_Dilate()).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -153,22 +261,47 @@ stm32ipl_err_t STM32Ipl_Close(image_t *img, uint8_t kSize, uint8_t threshold, co
  */
 stm32ipl_err_t STM32Ipl_TopHat(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_TopHatEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_TopHat(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The opened image is computed in the destination image, so that no temporary image is needed.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_TopHat().
+ * @param threshold 	See STM32Ipl_TopHat().
+ * @param mask		 	Optional mask; see STM32Ipl_TopHat().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_TopHatEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_top_hat(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(TopHat)
+	imlib_top_hat((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(TopHat)
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Performs the difference of an image and the closed image.
+ * With threshold 0 and no mask, Binary and Grayscale images use the van Herk/Gil-Werman erosion and dilation
+ * (see STM32Ipl_Erode() and STM32Ipl_Dilate()).
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img			Image; if it is not valid, an error is returned.
  * @param kSize			Kernel size; use 1 (3x3 kernel), 2 (5x5 kernel), ..., n (((n*2)+1)x((n*2)+1) kernel).
@@ -181,20 +314,104 @@ stm32ipl_err_t STM32Ipl_TopHat(image_t *img, uint8_t kSize, uint8_t threshold, c
  */
 stm32ipl_err_t STM32Ipl_BlackHat(image_t *img, uint8_t kSize, uint8_t threshold, const image_t *mask)
 {
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	return STM32Ipl_BlackHatEx(img, img, kSize, threshold, mask);
+}
+
+/**
+ * @brief Same as STM32Ipl_BlackHat(), but the result is written to the destination image, while the source image is
+ * left unchanged.
+ * The closed image is computed in the destination image, so that no temporary image is needed.
+ * @param src			Source image; if it is not valid, an error is returned.
+ * @param dst			Destination image; if it is not valid, an error is returned; it must have the same size and
+ * format of the source image, otherwise an error is returned. It can be the source image itself (in place processing),
+ * otherwise the two images must not overlap.
+ * @param kSize			Kernel size; see STM32Ipl_BlackHat().
+ * @param threshold 	See STM32Ipl_BlackHat().
+ * @param mask		 	Optional mask; see STM32Ipl_BlackHat().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BlackHatEx(const image_t *src, image_t *dst, uint8_t kSize, uint8_t threshold,
+		const image_t *mask)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
 		STM32IPL_CHECK_FORMAT(mask, STM32IPL_IF_ALL)
-		STM32IPL_CHECK_SAME_SIZE(img, mask)
+		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_black_hat(img, kSize, threshold, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(BlackHat)
+	imlib_black_hat((image_t*)src, dst, kSize, threshold, (image_t*)mask);
 
+	STM32IPL_TRACE_END(BlackHat)
 	return stm32ipl_err_Ok;
 }
 
+///@cond
+/* Arguments of the morphological operators executed on a ROI through STM32Ipl_TiledRoi(). */
+typedef struct _ipl_morph_roi_arg_t
+{
+	uint8_t kSize;
+	uint8_t threshold;
+} ipl_morph_roi_arg_t;
+
+static stm32ipl_err_t ipl_dilate_roi_op(image_t *tile, void *arg)
+{
+	const ipl_morph_roi_arg_t *a = (const ipl_morph_roi_arg_t*)arg;
+
+	return STM32Ipl_Dilate(tile, a->kSize, a->threshold, NULL);
+}
+
+static stm32ipl_err_t ipl_erode_roi_op(image_t *tile, void *arg)
+{
+	const ipl_morph_roi_arg_t *a = (const ipl_morph_roi_arg_t*)arg;
+
+	return STM32Ipl_Erode(tile, a->kSize, a->threshold, NULL);
+}
+///@endcond
+
+/**
+ * @brief Same as STM32Ipl_Dilate() (without mask), but only the pixels of the given region of interest are
+ * processed; the pixels around it are used at its borders, so the ROI gets the same result of the whole image
+ * processing, while the other pixels are not modified (see STM32Ipl_TiledRoi()).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param roi			Region of interest; it must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param kSize			Kernel size; see STM32Ipl_Dilate().
+ * @param threshold 	See STM32Ipl_Dilate().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DilateRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, uint8_t threshold)
+{
+	ipl_morph_roi_arg_t arg = { kSize, threshold };
+
+	return STM32Ipl_TiledRoi(img, img, roi, kSize, ipl_dilate_roi_op, &arg);
+}
+
+/**
+ * @brief Same as STM32Ipl_Erode() (without mask), but only the pixels of the given region of interest are
+ * processed; the pixels around it are used at its borders, so the ROI gets the same result of the whole image
+ * processing, while the other pixels are not modified (see STM32Ipl_TiledRoi()).
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param roi			Region of interest; it must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param kSize			Kernel size; see STM32Ipl_Erode().
+ * @param threshold 	See STM32Ipl_Erode().
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ErodeRoi(image_t *img, const rectangle_t *roi, uint8_t kSize, uint8_t threshold)
+{
+	ipl_morph_roi_arg_t arg = { kSize, threshold };
+
+	return STM32Ipl_TiledRoi(img, img, roi, kSize, ipl_erode_roi_op, &arg);
+}
+
 #ifdef __cplusplus
 }
 #endif
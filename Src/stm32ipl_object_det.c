@@ -58,6 +58,108 @@ stm32ipl_err_t STM32Ipl_LoadEyeCascade(cascade_t *cascade)
 }
 #endif /* STM32IPL_ENABLE_EYE_CASCADE */
 
+/**
+ * @brief Binds the cascade to the given data, without copying it: the cascade arrays point directly into the data,
+ * that can be read-only memory (e.g. memory-mapped QSPI/OSPI flash or external RAM) and must stay valid and
+ * unchanged while the cascade is used; nothing is allocated, so the cascade does not need to be released.
+ * The data has the layout of the OpenMV binary cascade files (all the values in the native byte order):
+ * window width, window height, number of stages (int32_t each), number of features per stage (uint8_t, one per stage),
+ * stage thresholds (int16_t, one per stage), feature thresholds, alpha1, alpha2 (int16_t, one per feature each),
+ * number of rectangles per feature (int8_t, one per feature), rectangle weights (int8_t, one per rectangle),
+ * rectangles (int8_t x, y, w, h, four per rectangle).
+ * The data is validated: the sizes must be consistent with the given size and all the rectangles must be
+ * contained in the detection window, so that corrupted data cannot cause out of bounds accesses.
+ * The int16_t arrays follow the features per stage array, so they are aligned to 2 bytes only if the data address
+ * plus the number of stages is even (e.g. when the number of stages is odd, the data must start at an odd address).
+ * @param cascade 	Pointer to the cascade; if it is not valid, an error is returned.
+ * @param data		Cascade data; if it is not valid, an error is returned.
+ * @param size		Size of the data (bytes).
+ * @return			stm32ipl_err_Ok on success, stm32ipl_err_WrongSize if the data is not consistent,
+ * stm32ipl_err_NotAllowed if the int16_t arrays are not aligned, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_BindCascade(cascade_t *cascade, const void *data, uint32_t size)
+{
+	const uint8_t *p = (const uint8_t*)data;
+	int32_t header[3];
+	uint32_t nStages;
+	uint32_t nFeatures = 0;
+	uint32_t nRectangles = 0;
+	uint64_t offset;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
+	STM32IPL_CHECK_VALID_PTR_ARG(data)
+
+	if (size < sizeof(header))
+		return stm32ipl_err_WrongSize;
+
+	/* The header is copied, as it may be not aligned. */
+	memcpy(header, p, sizeof(header));
+	nStages = header[2];
+
+	if ((header[0] <= 0) || (header[0] > INT8_MAX) || (header[1] <= 0) || (header[1] > INT8_MAX) || (header[2] <= 0)
+			|| (nStages > (size - sizeof(header)) / 3))
+		return stm32ipl_err_WrongSize;
+
+	offset = sizeof(header);
+	for (uint32_t i = 0; i < nStages; i++)
+		nFeatures += p[offset + i];
+
+	offset += nStages;
+	if ((uintptr_t)(p + offset) & 1)
+		return stm32ipl_err_NotAllowed;
+
+	/* Stage thresholds, feature thresholds, alpha1, alpha2, rectangles per feature. */
+	offset += (nStages * sizeof(int16_t)) + (nFeatures * 3 * sizeof(int16_t));
+	if ((offset + nFeatures) > size)
+		return stm32ipl_err_WrongSize;
+
+	for (uint32_t i = 0; i < nFeatures; i++) {
+		int8_t n = (int8_t)p[offset + i];
+
+		if (n <= 0)
+			return stm32ipl_err_WrongSize;
+		nRectangles += n;
+	}
+
+	/* Weights and rectangles. */
+	if ((offset + nFeatures + (nRectangles * 5)) > size)
+		return stm32ipl_err_WrongSize;
+
+	for (uint32_t i = 0; i < nRectangles; i++) {
+		const int8_t *r = (const int8_t*)p + offset + nFeatures + nRectangles + (i * 4);
+
+		if ((r[0] < 0) || (r[1] < 0) || (r[2] <= 0) || (r[3] <= 0) || ((r[0] + r[2]) > header[0])
+				|| ((r[1] + r[3]) > header[1]))
+			return stm32ipl_err_WrongSize;
+	}
+
+	memset(cascade, 0, sizeof(cascade_t));
+	cascade->window.w = header[0];
+	cascade->window.h = header[1];
+	cascade->n_stages = nStages;
+	cascade->n_features = nFeatures;
+	cascade->n_rectangles = nRectangles;
+
+	offset = sizeof(header);
+	cascade->stages_array = (uint8_t*)(p + offset);
+	offset += nStages;
+	cascade->stages_thresh_array = (int16_t*)(p + offset);
+	offset += nStages * sizeof(int16_t);
+	cascade->tree_thresh_array = (int16_t*)(p + offset);
+	offset += nFeatures * sizeof(int16_t);
+	cascade->alpha1_array = (int16_t*)(p + offset);
+	offset += nFeatures * sizeof(int16_t);
+	cascade->alpha2_array = (int16_t*)(p + offset);
+	offset += nFeatures * sizeof(int16_t);
+	cascade->num_rectangles_array = (int8_t*)(p + offset);
+	offset += nFeatures;
+	cascade->weights_array = (int8_t*)(p + offset);
+	offset += nRectangles;
+	cascade->rectangles_array = (int8_t*)(p + offset);
+
+	return stm32ipl_err_Ok;
+}
+
 /**
  * @brief Detects objects, described by the given cascade. The detected object are stored in an array_t
  * structure containing the bounding boxes (rectangle_t), one for each object detected; the caller is
@@ -71,7 +173,8 @@ stm32ipl_err_t STM32Ipl_LoadEyeCascade(cascade_t *cascade)
  * @param cascade		Pointer to a cascade (must be already loaded with specific loading function).
  * @param scaleFactor	Tune the capability to detect objects at different scale (must be > 1.0f).
  * @param threshold		Tune the detection rate against the false positive rate (0.0f - 1.0f).
- * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the objects found so far are returned), error otherwise.
  */
 stm32ipl_err_t STM32Ipl_DetectObject(const image_t *img, array_t **out, const rectangle_t *roi, cascade_t *cascade,
 		float scaleFactor, float threshold)
@@ -82,15 +185,345 @@ stm32ipl_err_t STM32Ipl_DetectObject(const image_t *img, array_t **out, const re
 	STM32IPL_CHECK_FORMAT(img, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
 	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
 	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(DetectObject)
+
+	ctx_deadline_begin();
 
 	cascade->scale_factor = scaleFactor;
 	cascade->threshold = threshold;
 
 	*out = imlib_detect_objects((image_t*)img, cascade, &realRoi);
 
+	STM32IPL_TRACE_END(DetectObject)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Detects objects, described by the given cascade, as STM32Ipl_DetectObject(), but the detections are
+ * added to a contiguous vector and grouped with STM32Ipl_RectVecGroup() instead of the pairwise merge of
+ * STM32Ipl_DetectObject(): each object is the average of a group of detections whose IoU with its best one
+ * is above the given threshold, and its score is the number of detections of the group.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param out			Vector the detected objects are added to (see STM32Ipl_RectVecInit()); its previous
+ * items are grouped with the new ones.
+ * @param roi			Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param cascade		Pointer to a cascade (must be already loaded with specific loading function).
+ * @param scaleFactor	Tune the capability to detect objects at different scale (must be > 1.0f).
+ * @param threshold		Tune the detection rate against the false positive rate (0.0f - 1.0f).
+ * @param iouThreshold	IoU threshold of the grouping, in the range [0, 1].
+ * @param minNeighbors	Minimum number of detections of an object; the smaller groups are removed.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the objects found so far are returned), error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectObjectVec(const image_t *img, stm32ipl_rect_vec_t *out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold, float iouThreshold, uint32_t minNeighbors)
+{
+	rectangle_t realRoi;
+	array_t *objects;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(DetectObjectVec)
+
+	ctx_deadline_begin();
+
+	cascade->scale_factor = scaleFactor;
+	cascade->threshold = threshold;
+
+	objects = imlib_detect_objects_raw((image_t*)img, cascade, &realRoi);
+
+	res = STM32Ipl_RectVecFromArray(out, objects, 1.0f);
+	array_free(objects);
+
+	if (res == stm32ipl_err_Ok)
+		res = STM32Ipl_RectVecGroup(out, iouThreshold, minNeighbors);
+
+	if ((res == stm32ipl_err_Ok) && ctx_deadline_end())
+		res = stm32ipl_err_Partial;
+
+	STM32IPL_TRACE_END(DetectObjectVec)
+	return res;
+}
+
+/**
+ * @brief Detects objects, described by the given cascade, as STM32Ipl_DetectObject(), but each scale is
+ * computed from the coarsest level of the given pyramid that is not smaller than it, instead of from the full
+ * resolution image: the pyramid is built once per frame (see STM32Ipl_PyramidBuild()) and can be shared with
+ * other functions. The coordinates of the detected objects refer to the first level of the pyramid.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param pyramid		Pyramid; if it is not valid or empty, an error is returned.
+ * @param out			Pointer to pointer to the array structure that will contain the detected objects.
+ * It must point to a valid, but empty structure. It MUST be released by the caller.
+ * @param roi			Optional region of interest of the first level of the pyramid where the functions
+ * operates; when defined, it must be contained in the first level and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole first level is considered.
+ * @param cascade		Pointer to a cascade (must be already loaded with specific loading function).
+ * @param scaleFactor	Tune the capability to detect objects at different scale (must be > 1.0f).
+ * @param threshold		Tune the detection rate against the false positive rate (0.0f - 1.0f).
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the objects found so far are returned), error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectObjectPyramid(const stm32ipl_pyramid_t *pyramid, array_t **out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold)
+{
+	rectangle_t realRoi;
+	const image_t *img;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(pyramid)
+	if (!pyramid->levels || (pyramid->levels > STM32IPL_PYRAMID_MAX_LEVELS))
+		return stm32ipl_err_InvalidParameter;
+
+	img = &pyramid->level[0];
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(DetectObjectPyramid)
+
+	ctx_deadline_begin();
+
+	cascade->scale_factor = scaleFactor;
+	cascade->threshold = threshold;
+
+	*out = imlib_detect_objects_pyramid((image_t*)pyramid->level, pyramid->scale, pyramid->levels, cascade, &realRoi);
+
+	STM32IPL_TRACE_END(DetectObjectPyramid)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gets the size of the workspace needed by STM32Ipl_DetectObject_WithWorkspace() to store the integral images.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param roi		Optional region of interest; see STM32Ipl_DetectObject().
+ * @param cascade	Pointer to a cascade (must be already loaded with specific loading function).
+ * @param size		Pointer to the size of the workspace (bytes); if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectObject_GetWorkspaceSize(const image_t *img, const rectangle_t *roi,
+		const cascade_t *cascade, uint32_t *size)
+{
+	rectangle_t realRoi;
+	uint32_t h;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
+	STM32IPL_CHECK_VALID_PTR_ARG(size)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+
+	/* Two moving window integral images (sum and squared sum), each made of the row pointers,
+	 * the swap pointers and the rows. */
+	h = cascade->window.h + 1;
+	*size = FB_WORKSPACE_OVERHEAD
+			+ 2 * (2 * FB_ALLOC_SPACE(h * sizeof(uint32_t*)) + h * FB_ALLOC_SPACE(realRoi.w * sizeof(uint32_t)));
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Same as STM32Ipl_DetectObject(), but the integral images are taken from the given workspace
+ * instead of being allocated at each call. The array of the detected objects is still allocated
+ * from the heap and MUST be released by the caller.
+ * @param img			Image; see STM32Ipl_DetectObject().
+ * @param out			Pointer to pointer to the array structure that will contain the detected objects.
+ * @param roi			Optional region of interest; see STM32Ipl_DetectObject().
+ * @param cascade		Pointer to a cascade (must be already loaded with specific loading function).
+ * @param scaleFactor	See STM32Ipl_DetectObject().
+ * @param threshold		See STM32Ipl_DetectObject().
+ * @param workspace		Workspace; if it is not valid, an error is returned.
+ * @param workspaceSize	Size of the workspace (bytes); it must be at least the size returned by
+ * STM32Ipl_DetectObject_GetWorkspaceSize(), otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectObject_WithWorkspace(const image_t *img, array_t **out, const rectangle_t *roi,
+		cascade_t *cascade, float scaleFactor, float threshold, void *workspace, uint32_t workspaceSize)
+{
+	uint32_t size;
+	stm32ipl_err_t ret;
+
+	ret = STM32Ipl_DetectObject_GetWorkspaceSize(img, roi, cascade, &size);
+	if (ret != stm32ipl_err_Ok)
+		return ret;
+
+	STM32IPL_CHECK_WORKSPACE(workspace, workspaceSize, size)
+
+	if (!fb_workspace_begin(workspace, workspaceSize))
+		return stm32ipl_err_NotAllowed;
+
+	ret = STM32Ipl_DetectObject(img, out, roi, cascade, scaleFactor, threshold);
+
+	fb_workspace_end();
+
+	return ret;
+}
+
+/**
+ * @brief Initializes the context of STM32Ipl_DetectObjectTrack(); the next call performs a full scan.
+ * Calling it again restarts the tracking, e.g. when the scene changes.
+ * @param ctx		Context; if it is not valid, an error is returned.
+ * @param period	Number of frames between two full scans (>= 1); with 1 every frame is fully scanned.
+ * @param margin	Expansion of the search region on each side of a tracked object, relative to its size
+ * (>= 0.0f); it must cover the motion of the objects between two frames, 0.5f is a typical value.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectTrackInit(stm32ipl_detect_track_t *ctx, uint32_t period, float margin)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+
+	if ((period < 1) || !(margin >= 0.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	ctx->count = 0;
+	ctx->period = period;
+	ctx->frames = 0;
+	ctx->margin = margin;
+
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Detects objects, described by the given cascade, in a frame of a video sequence, tracking the objects
+ * detected in the previous frame: the whole roi is scanned at all the scales, as STM32Ipl_DetectObject(),
+ * every period frames, or when a tracked object is lost; in the other frames each object is searched only
+ * within its bounding box expanded by the margin and at its own scale and the two adjacent ones. Objects that
+ * enter the scene are detected at the next full scan. The detected object are stored in an array_t
+ * structure containing the bounding boxes (rectangle_t); the caller is responsible to release the array.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param ctx			Context, initialized by STM32Ipl_DetectTrackInit(); if it is not valid, an error is returned.
+ * @param img			Image; if it is not valid, an error is returned.
+ * @param out			Pointer to pointer to the array structure that will contain the detected objects.
+ * It must point to a valid, but empty structure. It MUST be released by the caller.
+ * @param roi			Optional region of interest; see STM32Ipl_DetectObject().
+ * @param cascade		Pointer to a cascade (must be already loaded with specific loading function).
+ * @param scaleFactor	Tune the capability to detect objects at different scale (must be > 1.0f).
+ * @param threshold		Tune the detection rate against the false positive rate (0.0f - 1.0f).
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the objects found so far are returned), error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DetectObjectTrack(stm32ipl_detect_track_t *ctx, const image_t *img, array_t **out,
+		const rectangle_t *roi, cascade_t *cascade, float scaleFactor, float threshold)
+{
+	rectangle_t realRoi;
+	array_t *objects = NULL;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(ctx)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_CHECK_VALID_PTR_ARG(cascade)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(DetectObjectTrack)
+
+	ctx_deadline_begin();
+
+	cascade->scale_factor = scaleFactor;
+	cascade->threshold = threshold;
+
+	if (ctx->count && (ctx->frames < ctx->period)) {
+		rectangle_t region[STM32IPL_DETECT_TRACK_MAX_OBJECTS];
+		int32_t firstScale[STM32IPL_DETECT_TRACK_MAX_OBJECTS];
+		int32_t lastScale[STM32IPL_DETECT_TRACK_MAX_OBJECTS];
+		uint32_t regions = 0;
+		float levelScale = 1.0f;
+		bool lost = false;
+
+		/* Search regions: the objects expanded by the margin, at the scale of the full scan closest to their size
+		 * and the adjacent ones; the regions that overlap are united, so that each part of the image is searched
+		 * once. */
+		for (uint32_t i = 0; (i < ctx->count) && !lost; i++) {
+			rectangle_t *obj = &ctx->object[i];
+			rectangle_t r;
+			int32_t dx = (int32_t)(obj->w * ctx->margin);
+			int32_t dy = (int32_t)(obj->h * ctx->margin);
+			float size = (float)obj->w / cascade->window.w;
+			float factor = 1.0f;
+			int32_t scale = 0;
+			int32_t first;
+			int32_t last;
+
+			/* Closest scale on a logarithmic axis: factor * sqrt(scaleFactor) >= size. */
+			while ((factor * factor * scaleFactor) < (size * size)) {
+				factor *= scaleFactor;
+				scale++;
+			}
+			first = STM32IPL_MAX(scale - 1, 0);
+			last = scale + 1;
+
+			r.x = obj->x - dx;
+			r.y = obj->y - dy;
+			r.w = obj->w + 2 * dx;
+			r.h = obj->h + 2 * dy;
+			if (!rectangle_overlap(&r, &realRoi)) {
+				lost = true;
+				continue;
+			}
+			rectangle_intersected(&r, &realRoi);
+
+			for (int32_t j = 0; j < (int32_t)regions; j++) {
+				if (rectangle_overlap(&r, &region[j])) {
+					rectangle_united(&r, &region[j]);
+					first = STM32IPL_MIN(first, firstScale[j]);
+					last = STM32IPL_MAX(last, lastScale[j]);
+					regions--;
+					region[j] = region[regions];
+					firstScale[j] = firstScale[regions];
+					lastScale[j] = lastScale[regions];
+					j = -1;
+				}
+			}
+
+			region[regions] = r;
+			firstScale[regions] = first;
+			lastScale[regions] = last;
+			regions++;
+		}
+
+		if (!lost) {
+			array_alloc(&objects, xfree);
+
+			for (uint32_t i = 0; (i < regions) && !lost; i++) {
+				array_t *found = imlib_detect_objects_range((image_t*)img, &levelScale, 1, cascade, &region[i], realRoi.w,
+						firstScale[i], lastScale[i]);
+				lost = (array_length(found) == 0);
+				while (array_length(found))
+					array_push_back(objects, array_pop_back(found));
+				array_free(found);
+			}
+
+			if (lost) {
+				array_free(objects);
+				objects = NULL;
+			} else if (array_length(objects) > 1) {
+				objects = rectangle_merge(objects);
+			}
+		}
+	}
+
+	if (!objects) {
+		objects = imlib_detect_objects((image_t*)img, cascade, &realRoi);
+		ctx->frames = 0;
+	}
+
+	ctx->count = STM32IPL_MIN((uint32_t)array_length(objects), STM32IPL_DETECT_TRACK_MAX_OBJECTS);
+	for (uint32_t i = 0; i < ctx->count; i++)
+		ctx->object[i] = *(rectangle_t*)array_at(objects, i);
+	ctx->frames++;
+
+	*out = objects;
+
+	STM32IPL_TRACE_END(DetectObjectTrack)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,301 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_optical_flow.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - optical flow module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+#ifdef IPL_FLOW_HAS_MVE
+#include "mve_flow.h"
+#endif /* IPL_FLOW_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#define IPL_LK_RADIUS		5							/* Radius of the integration window (11x11 pixels). */
+#define IPL_LK_SIZE			((IPL_LK_RADIUS * 2) + 1)	/* Side of the integration window. */
+#define IPL_LK_AREA			(IPL_LK_SIZE * IPL_LK_SIZE)	/* Pixels of the integration window. */
+#define IPL_LK_MAX_ITER		20							/* Maximum number of iterations per level. */
+#define IPL_LK_EPS			0.01f						/* Update (pixels) below which the iterations stop. */
+#define IPL_LK_MIN_EIG		0.1f						/* Minimum eigenvalue of the mean structure tensor. */
+#define IPL_LK_W_BITS		14							/* Precision of the bilinear weights. */
+#define IPL_LK_P_BITS		5							/* Fractional bits of the sampled pixels. */
+
+/* Samples the size x size patch of a Grayscale image whose top-left pixel is at (x, y), with bilinear
+ * interpolation, in fixed point with IPL_LK_P_BITS fractional bits; the pixels beyond the borders are replicated. */
+static void ipl_lk_patch(const image_t *img, float x, float y, int size, int16_t *dst)
+{
+	float fx = floorf(x);
+	float fy = floorf(y);
+	float a = x - fx;
+	float b = y - fy;
+	int x0 = (int)fx;
+	int y0 = (int)fy;
+	int w00 = (int)lroundf((1.0f - a) * (1.0f - b) * (1 << IPL_LK_W_BITS));
+	int w01 = (int)lroundf(a * (1.0f - b) * (1 << IPL_LK_W_BITS));
+	int w10 = (int)lroundf((1.0f - a) * b * (1 << IPL_LK_W_BITS));
+	int w11 = (1 << IPL_LK_W_BITS) - w00 - w01 - w10;
+	const int shift = IPL_LK_W_BITS - IPL_LK_P_BITS;
+
+	if ((x0 >= 0) && (y0 >= 0) && ((x0 + size) < img->w) && ((y0 + size) < img->h)) {
+		for (int j = 0; j < size; j++, dst += size) {
+			const uint8_t *r0 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y0 + j) + x0;
+			const uint8_t *r1 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y0 + j + 1) + x0;
+
+			for (int i = 0; i < size; i++)
+				dst[i] = ((r0[i] * w00) + (r0[i + 1] * w01) + (r1[i] * w10) + (r1[i + 1] * w11)
+						+ (1 << (shift - 1))) >> shift;
+		}
+	} else {
+		for (int j = 0; j < size; j++, dst += size) {
+			const uint8_t *r0 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, IM_MIN(IM_MAX(y0 + j, 0), img->h - 1));
+			const uint8_t *r1 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, IM_MIN(IM_MAX(y0 + j + 1, 0), img->h - 1));
+
+			for (int i = 0; i < size; i++) {
+				int xa = IM_MIN(IM_MAX(x0 + i, 0), img->w - 1);
+				int xb = IM_MIN(IM_MAX(x0 + i + 1, 0), img->w - 1);
+
+				dst[i] = ((r0[xa] * w00) + (r0[xb] * w01) + (r1[xa] * w10) + (r1[xb] * w11)
+						+ (1 << (shift - 1))) >> shift;
+			}
+		}
+	}
+}
+
+/* Splits the (IPL_LK_SIZE + 2)^2 patch into the window pixels and their Scharr derivatives, all with
+ * IPL_LK_P_BITS fractional bits (the Scharr kernel has a gain of 32 on the derivative). */
+static void ipl_lk_derivatives(const int16_t *patch, int16_t *win, int16_t *ix, int16_t *iy)
+{
+	const int stride = IPL_LK_SIZE + 2;
+
+	for (int j = 0; j < IPL_LK_SIZE; j++) {
+		const int16_t *p = patch + ((j + 1) * stride) + 1;
+
+		for (int i = 0; i < IPL_LK_SIZE; i++, p++) {
+			int dx = (3 * (p[1 - stride] - p[-1 - stride])) + (10 * (p[1] - p[-1]))
+					+ (3 * (p[1 + stride] - p[-1 + stride]));
+			int dy = (3 * (p[stride - 1] - p[-stride - 1])) + (10 * (p[stride] - p[-stride]))
+					+ (3 * (p[stride + 1] - p[-stride + 1]));
+
+			*win++ = p[0];
+			*ix++ = dx >> 5;
+			*iy++ = dy >> 5;
+		}
+	}
+}
+
+/* Structure tensor of the window: sums of the products of its derivatives. */
+static void ipl_lk_gradient_matrix(const int16_t *ix, const int16_t *iy, int64_t *gxx, int64_t *gxy, int64_t *gyy)
+{
+#ifdef IPL_FLOW_HAS_MVE
+	mve_lk_gradient_matrix(ix, iy, IPL_LK_AREA, gxx, gxy, gyy);
+#else
+	int64_t xx = 0;
+	int64_t xy = 0;
+	int64_t yy = 0;
+
+	for (int k = 0; k < IPL_LK_AREA; k++) {
+		xx += ix[k] * ix[k];
+		xy += ix[k] * iy[k];
+		yy += iy[k] * iy[k];
+	}
+
+	*gxx = xx;
+	*gxy = xy;
+	*gyy = yy;
+#endif /* IPL_FLOW_HAS_MVE */
+}
+
+/* Mismatch vector of the window: sums of the products of the difference between the windows and the derivatives. */
+static void ipl_lk_mismatch(const int16_t *win, const int16_t *cur, const int16_t *ix, const int16_t *iy,
+		int64_t *bx, int64_t *by)
+{
+#ifdef IPL_FLOW_HAS_MVE
+	mve_lk_mismatch(win, cur, ix, iy, IPL_LK_AREA, bx, by);
+#else
+	int64_t sx = 0;
+	int64_t sy = 0;
+
+	for (int k = 0; k < IPL_LK_AREA; k++) {
+		int d = cur[k] - win[k];
+
+		sx += d * ix[k];
+		sy += d * iy[k];
+	}
+
+	*bx = sx;
+	*by = sy;
+#endif /* IPL_FLOW_HAS_MVE */
+}
+
+/* Tracks one point, from the coarsest level to the finest one; returns false if it is lost. */
+static bool ipl_lk_track(const stm32ipl_pyramid_t *prevPyr, const stm32ipl_pyramid_t *currPyr,
+		const stm32ipl_point2f_t *pt, stm32ipl_point2f_t *out, int16_t *buf)
+{
+	int16_t *patch = buf;
+	int16_t *win = patch + ((IPL_LK_SIZE + 2) * (IPL_LK_SIZE + 2));
+	int16_t *ix = win + IPL_LK_AREA;
+	int16_t *iy = ix + IPL_LK_AREA;
+	int16_t *cur = iy + IPL_LK_AREA;
+	/* Displacement, in pixels of the first level. */
+	float dx = 0.0f;
+	float dy = 0.0f;
+
+	for (int l = prevPyr->levels - 1; l >= 0; l--) {
+		const image_t *prev = &prevPyr->level[l];
+		const image_t *curr = &currPyr->level[l];
+		float scale = prevPyr->scale[l];
+		/* Pixel centers of the level, with respect to the first one. */
+		float px = ((pt->x + 0.5f) / scale) - 0.5f;
+		float py = ((pt->y + 0.5f) / scale) - 0.5f;
+		float ldx = dx / scale;
+		float ldy = dy / scale;
+		int64_t gxx;
+		int64_t gxy;
+		int64_t gyy;
+		float a;
+		float b;
+		float c;
+		float det;
+		float minEig;
+
+		ipl_lk_patch(prev, px - IPL_LK_RADIUS - 1, py - IPL_LK_RADIUS - 1, IPL_LK_SIZE + 2, patch);
+		ipl_lk_derivatives(patch, win, ix, iy);
+		ipl_lk_gradient_matrix(ix, iy, &gxx, &gxy, &gyy);
+
+		a = (float)gxx;
+		b = (float)gxy;
+		c = (float)gyy;
+		det = (a * c) - (b * b);
+		minEig = ((a + c) - sqrtf(((a - c) * (a - c)) + (4.0f * b * b)))
+				/ (2.0f * IPL_LK_AREA * (1 << (2 * IPL_LK_P_BITS)));
+
+		/* Not enough texture at this level: the coarser estimate is kept, unless it is the finest level. */
+		if ((minEig < IPL_LK_MIN_EIG) || (det <= 0.0f)) {
+			if (l == 0)
+				return false;
+			continue;
+		}
+
+		for (int k = 0; k < IPL_LK_MAX_ITER; k++) {
+			float qx = px + ldx;
+			float qy = py + ldy;
+			int64_t bx;
+			int64_t by;
+			float ux;
+			float uy;
+
+			if ((qx < -IPL_LK_RADIUS) || (qy < -IPL_LK_RADIUS) || (qx >= (curr->w + IPL_LK_RADIUS))
+					|| (qy >= (curr->h + IPL_LK_RADIUS)))
+				return false;
+
+			ipl_lk_patch(curr, qx - IPL_LK_RADIUS, qy - IPL_LK_RADIUS, IPL_LK_SIZE, cur);
+			ipl_lk_mismatch(win, cur, ix, iy, &bx, &by);
+
+			/* Solution of G * u = -b; the fixed point scales of G and b cancel out. */
+			ux = ((b * by) - (c * bx)) / det;
+			uy = ((b * bx) - (a * by)) / det;
+			ldx += ux;
+			ldy += uy;
+
+			if (((ux * ux) + (uy * uy)) < (IPL_LK_EPS * IPL_LK_EPS))
+				break;
+		}
+
+		dx = ldx * scale;
+		dy = ldy * scale;
+	}
+
+	out->x = pt->x + dx;
+	out->y = pt->y + dy;
+
+	return (out->x >= 0.0f) && (out->y >= 0.0f) && (out->x <= (prevPyr->level[0].w - 1))
+			&& (out->y <= (prevPyr->level[0].h - 1));
+}
+///@endcond
+
+/**
+ * @brief Tracks sparse points between two frames with the pyramidal Lucas-Kanade method: each point is first tracked
+ * on the coarsest level of the pyramids, then its displacement is refined on the finer ones, so that the
+ * displacements larger than the integration window (11x11 pixels) are followed. On each level, the window of the
+ * previous frame is sampled with bilinear interpolation in fixed point, its Scharr derivatives give the 2x2
+ * structure tensor, and the displacement is iteratively updated by solving the 2x2 system with the mismatch between
+ * the two windows. On MVE targets, the window accumulations use the 16-bit dual multiply-accumulate long instructions.
+ * The supported format is Grayscale.
+ * @param prevPyr	Pyramid of the previous frame (see STM32Ipl_PyramidBuild()); if it is not valid, an error is
+ * returned.
+ * @param currPyr	Pyramid of the current frame; it must have the same levels (number, size, format) as prevPyr,
+ * otherwise an error is returned.
+ * @param pts		Points of the previous frame (first level coordinates); if it is not valid, an error is returned.
+ * @param n			Number of points.
+ * @param outPts	Buffer of n points that receives the positions in the current frame; it can be pts itself; if it
+ * is not valid, an error is returned.
+ * @param status	Optional buffer of n elements that receives 1 for the tracked points, 0 for the lost ones (too
+ * little texture around the point, or out of the frame); the positions of the lost points are not meaningful.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_OpticalFlowLK(const stm32ipl_pyramid_t *prevPyr, const stm32ipl_pyramid_t *currPyr,
+		const stm32ipl_point2f_t *pts, uint32_t n, stm32ipl_point2f_t *outPts, uint8_t *status)
+{
+	int16_t *buf;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(prevPyr)
+	STM32IPL_CHECK_VALID_PTR_ARG(currPyr)
+	STM32IPL_CHECK_VALID_PTR_ARG(pts)
+	STM32IPL_CHECK_VALID_PTR_ARG(outPts)
+
+	if (!prevPyr->levels || (prevPyr->levels != currPyr->levels))
+		return stm32ipl_err_InvalidParameter;
+
+	for (uint8_t l = 0; l < prevPyr->levels; l++) {
+		const image_t *prev = &prevPyr->level[l];
+		const image_t *curr = &currPyr->level[l];
+
+		STM32IPL_CHECK_VALID_IMAGE(prev)
+		STM32IPL_CHECK_VALID_IMAGE(curr)
+		STM32IPL_CHECK_FORMAT(prev, STM32IPL_IF_GRAY_ONLY)
+		STM32IPL_CHECK_SAME_HEADER(prev, curr)
+	}
+
+	/* Patch with its border, window, derivatives and window of the current frame. */
+	buf = fb_alloc((((IPL_LK_SIZE + 2) * (IPL_LK_SIZE + 2)) + (4 * IPL_LK_AREA)) * sizeof(int16_t),
+			FB_ALLOC_PREFER_SPEED);
+	if (!buf)
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(OpticalFlowLK)
+
+	for (uint32_t i = 0; i < n; i++) {
+		stm32ipl_point2f_t pt = pts[i];
+		bool found = ipl_lk_track(prevPyr, currPyr, &pt, &outPts[i], buf);
+
+		if (status)
+			status[i] = found ? 1 : 0;
+	}
+
+	STM32IPL_TRACE_END(OpticalFlowLK)
+
+	fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
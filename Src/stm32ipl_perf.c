@@ -0,0 +1,187 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_perf.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - performance counters module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* Library function running at a given nesting level. */
+typedef struct _ipl_perf_frame_t
+{
+	stm32ipl_trace_id_t id;	/* Identifier of the function. */
+	uint32_t start;			/* Value of the cycle counter when the function started. */
+} ipl_perf_frame_t;
+
+static stm32ipl_perf_counter_t ipl_perf_counters[stm32ipl_trace_Count];
+static ipl_perf_frame_t ipl_perf_stack[STM32IPL_PERF_MAX_DEPTH];
+static uint32_t ipl_perf_depth;	/* Number of running functions, also beyond STM32IPL_PERF_MAX_DEPTH. */
+
+static const char *const ipl_perf_reason_names[stm32ipl_perf_Count] = {
+	"None", "NotBuilt", "Disabled", "Format", "Mask", "Parameter", "Memory"
+};
+
+/* Returns the counters of the innermost running function, NULL when no function is tracked. */
+static stm32ipl_perf_counter_t* ipl_perf_current(void)
+{
+	if ((ipl_perf_depth == 0) || (ipl_perf_depth > STM32IPL_PERF_MAX_DEPTH))
+		return NULL;
+
+	return &ipl_perf_counters[ipl_perf_stack[ipl_perf_depth - 1].id];
+}
+///@endcond
+
+/**
+ * @brief Records the start of a library function; it is called by the STM32IPL_TRACE_BEGIN hook.
+ * @param id	Identifier of the function.
+ * @return		void.
+ */
+void STM32Ipl_PerfBegin(stm32ipl_trace_id_t id)
+{
+	if ((uint32_t)id >= stm32ipl_trace_Count)
+		return;
+
+	ipl_perf_counters[id].calls++;
+
+	if (ipl_perf_depth < STM32IPL_PERF_MAX_DEPTH) {
+		ipl_perf_stack[ipl_perf_depth].id = id;
+		ipl_perf_stack[ipl_perf_depth].start = STM32Ipl_CycleCounterGet();
+	}
+
+	ipl_perf_depth++;
+}
+
+/**
+ * @brief Records the end of a library function; it is called by the STM32IPL_TRACE_END hook.
+ * The elapsed cycles are added to the counters of the function.
+ * @param id	Identifier of the function.
+ * @return		void.
+ */
+void STM32Ipl_PerfEnd(stm32ipl_trace_id_t id)
+{
+	uint32_t now = STM32Ipl_CycleCounterGet();
+
+	if ((ipl_perf_depth == 0) || ((uint32_t)id >= stm32ipl_trace_Count))
+		return;
+
+	ipl_perf_depth--;
+
+	if (ipl_perf_depth < STM32IPL_PERF_MAX_DEPTH) {
+		ipl_perf_frame_t *frame = &ipl_perf_stack[ipl_perf_depth];
+
+		/* The unsigned difference is right also when the counter wraps around. */
+		if (frame->id == id)
+			ipl_perf_counters[id].cycles += (uint32_t)(now - frame->start);
+	}
+}
+
+/**
+ * @brief Records the implementation executed by the innermost running library function; it is called by the
+ * STM32IPL_PERF_MVE and STM32IPL_PERF_SCALAR hooks, placed where the library chooses between the MVE and
+ * the scalar implementations.
+ * @param mve		true if the MVE implementation runs, false if the scalar one runs.
+ * @param reason	Reason why the scalar implementation runs; ignored when mve is true.
+ * @return			void.
+ */
+void STM32Ipl_PerfPath(bool mve, stm32ipl_perf_reason_t reason)
+{
+	stm32ipl_perf_counter_t *counter = ipl_perf_current();
+
+	if (!counter)
+		return;
+
+	if (mve) {
+		counter->mvePaths++;
+	} else {
+		counter->scalarPaths++;
+		if ((uint32_t)reason < stm32ipl_perf_Count)
+			counter->fallbacks[reason]++;
+	}
+}
+
+/**
+ * @brief Records a memory allocation (heap or fb stack) made by the innermost running library function;
+ * it is called by the memory allocator.
+ * @param size	Size of the allocated buffer (bytes).
+ * @return		void.
+ */
+void STM32Ipl_PerfAlloc(uint32_t size)
+{
+	stm32ipl_perf_counter_t *counter = ipl_perf_current();
+
+	if (counter)
+		counter->allocBytes += size;
+}
+
+/**
+ * @brief Gets the performance counters of a library function, collected since the last call to
+ * STM32Ipl_ResetPerfCounters(). The counted functions are the ones listed by stm32ipl_trace_id_t; the cycles
+ * include the library functions called by the function, while the allocated bytes and the executed paths are
+ * accounted to the innermost running function only. A scalar path with reason stm32ipl_perf_Disabled, for instance,
+ * tells that STM32Ipl_SetMve() (or STM32Ipl_MveAvailable()) excluded the MVE implementation.
+ * The counters are global: they are not meant to be used by concurrent threads.
+ * @param id		Identifier of the function.
+ * @param counter	Counters of the function; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetPerfCounters(stm32ipl_trace_id_t id, stm32ipl_perf_counter_t *counter)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(counter)
+
+	if ((uint32_t)id >= stm32ipl_trace_Count)
+		return stm32ipl_err_InvalidParameter;
+
+	*counter = ipl_perf_counters[id];
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Resets the performance counters and enables the cycle counter. It is called by STM32Ipl_InitLib();
+ * it must not be called while a library function is running.
+ * @return	void.
+ */
+void STM32Ipl_ResetPerfCounters(void)
+{
+	STM32Ipl_CycleCounterInit();
+	memset(ipl_perf_counters, 0, sizeof(ipl_perf_counters));
+	ipl_perf_depth = 0;
+}
+
+/**
+ * @brief Gets the name of a fallback reason.
+ * @param reason	Reason.
+ * @return			Name of the reason, NULL if the reason is not valid.
+ */
+const char* STM32Ipl_PerfReasonName(stm32ipl_perf_reason_t reason)
+{
+	if ((uint32_t)reason >= stm32ipl_perf_Count)
+		return NULL;
+
+	return ipl_perf_reason_names[reason];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
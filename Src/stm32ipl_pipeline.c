@@ -0,0 +1,407 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_pipeline.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - line-buffered pipeline module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+struct _ipl_stage_ctx_t;
+
+/* Computes the output line y of a stage from its input lines y - radius ... y + radius (clamped to the image). */
+typedef void (*ipl_stage_op_t)(struct _ipl_stage_ctx_t *ctx, uint8_t **lines, uint8_t *out, int w, int y, int h);
+
+typedef struct _ipl_stage_ctx_t
+{
+	const stm32ipl_stage_t *stage;
+	ipl_stage_op_t op;
+	int radius;			/* Number of input lines needed above and below the output line. */
+	int nLines;			/* Number of lines of the ring buffer. */
+	uint8_t *ring;		/* Ring buffer holding the last nLines input lines. */
+	uint32_t *acc;		/* Vertical sums (gaussian only). */
+	int32_t coef[2 * STM32IPL_PIPELINE_MAX_KSIZE + 1];	/* Pascal's triangle row (gaussian only). */
+	int32_t mInt;		/* 1 / kernel weight in Q16 (gaussian only). */
+} ipl_stage_ctx_t;
+
+typedef struct _ipl_pipeline_t
+{
+	ipl_stage_ctx_t stage[STM32IPL_PIPELINE_MAX_STAGES];
+	uint32_t nStages;
+	image_t *dst;
+	uint8_t *outLine;	/* Output line of the last stage. */
+} ipl_pipeline_t;
+
+#define IPL_STAGE_LINE(ctx, y, w)	((ctx)->ring + (((y) % (ctx)->nLines) * (uint32_t)(w)))
+
+/* Same arithmetic of imlib_morph() with the kernel built by STM32Ipl_Gaussian(): the 2D kernel is the outer
+ * product of a row of the Pascal's triangle with itself, so it is applied as a vertical and an horizontal pass,
+ * which give the same integer sums. */
+static void ipl_stage_gaussian(ipl_stage_ctx_t *ctx, uint8_t **lines, uint8_t *out, int w, int y, int h)
+{
+	int ksize = ctx->radius;
+	int n = (ksize * 2) + 1;
+	uint32_t *acc = ctx->acc;
+
+	STM32IPL_UNUSED(y);
+	STM32IPL_UNUSED(h);
+
+	for (int x = 0; x < w; x++) {
+		uint32_t sum = 0;
+
+		for (int j = 0; j < n; j++)
+			sum += ctx->coef[j] * lines[j][x];
+
+		acc[x] = sum;
+	}
+
+	for (int x = 0; x < w; x++) {
+		int32_t sum = 0;
+		int pixel;
+
+		if (x >= ksize && x < w - ksize) {
+			for (int k = -ksize; k <= ksize; k++)
+				sum += ctx->coef[k + ksize] * (int32_t)acc[x + k];
+		} else {
+			for (int k = -ksize; k <= ksize; k++)
+				sum += ctx->coef[k + ksize] * (int32_t)acc[IM_MIN(IM_MAX(x + k, 0), (w - 1))];
+		}
+
+		pixel = (sum * ctx->mInt) >> 16;
+		if (pixel > COLOR_GRAYSCALE_MAX)
+			pixel = COLOR_GRAYSCALE_MAX;
+		else
+			if (pixel < 0)
+				pixel = 0;
+
+		out[x] = pixel;
+	}
+}
+
+/* Same result of imlib_binary() with a single grayscale threshold and a grayscale destination. */
+static void ipl_stage_binary(ipl_stage_ctx_t *ctx, uint8_t **lines, uint8_t *out, int w, int y, int h)
+{
+	const stm32ipl_stage_t *stage = ctx->stage;
+	const uint8_t *in = lines[0];
+
+	STM32IPL_UNUSED(y);
+	STM32IPL_UNUSED(h);
+
+	for (int x = 0; x < w; x++) {
+		bool set = ((stage->lMin <= in[x]) && (in[x] <= stage->lMax)) ^ stage->invert;
+		out[x] = set ? COLOR_GRAYSCALE_BINARY_MAX : COLOR_GRAYSCALE_BINARY_MIN;
+	}
+}
+
+/* Same result of the grayscale path of imlib_erode_dilate(), including its sliding sum on the inner pixels;
+ * with the default thresholds, the result is the minimum (erosion) or maximum (dilation) of the kernel. */
+static void ipl_stage_erode_dilate(ipl_stage_ctx_t *ctx, uint8_t **lines, uint8_t *out, int w, int y, int h)
+{
+	int ksize = ctx->radius;
+	int threshold = ctx->stage->threshold;
+	bool dilate = (ctx->stage->type == stm32ipl_stage_dilate);
+	bool innerLine = (y >= ksize) && (y < h - ksize);
+	const uint8_t *in = lines[ksize];
+	int n = (2 * ksize) + 1;
+	int acc = 0;
+
+	if (threshold == (dilate ? 0 : ((n * n) - 1))) {
+		for (int x = 0; x < w; x++) {
+			int pixel = dilate ? COLOR_GRAYSCALE_MIN : COLOR_GRAYSCALE_MAX;
+
+			for (int j = 0; j < n; j++) {
+				for (int k = -ksize; k <= ksize; k++) {
+					int value = lines[j][IM_MIN(IM_MAX(x + k, 0), (w - 1))];
+					pixel = dilate ? IM_MAX(pixel, value) : IM_MIN(pixel, value);
+				}
+			}
+
+			out[x] = pixel;
+		}
+		return;
+	}
+
+	for (int x = 0; x < w; x++) {
+		int pixel = in[x];
+
+		if (innerLine && x > ksize && x < w - ksize) {
+			for (int j = 0; j <= 2 * ksize; j++) {
+				acc -= (lines[j][x - ksize - 1] & 1);
+				acc += (lines[j][x + ksize] & 1);
+			}
+		} else {
+			acc = dilate ? 0 : -1;
+			for (int j = 0; j <= 2 * ksize; j++) {
+				for (int k = -ksize; k <= ksize; k++)
+					acc += (lines[j][IM_MIN(IM_MAX(x + k, 0), (w - 1))] >> 7);
+			}
+		}
+
+		if (!dilate) {
+			if (acc < threshold)
+				pixel = COLOR_GRAYSCALE_BINARY_MIN;
+		} else {
+			if (acc > threshold)
+				pixel = COLOR_GRAYSCALE_BINARY_MAX;
+		}
+
+		out[x] = pixel;
+	}
+}
+
+static void ipl_pipeline_sink(ipl_pipeline_t *pl, int y)
+{
+	image_t *dst = pl->dst;
+
+	if (dst->bpp == IMAGE_BPP_GRAYSCALE) {
+		memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y), pl->outLine, dst->w);
+	} else {
+		uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+
+		for (int x = 0, xx = dst->w; x < xx; x++)
+			IMAGE_PUT_BINARY_PIXEL_FAST(row, x, COLOR_GRAYSCALE_TO_BINARY(pl->outLine[x]));
+	}
+}
+
+/* Gets the buffer receiving the input line y of stage s (the output line of the last stage when s == nStages). */
+static uint8_t* ipl_pipeline_input_line(ipl_pipeline_t *pl, uint32_t s, int y, int w)
+{
+	if (s == pl->nStages)
+		return pl->outLine;
+
+	return IPL_STAGE_LINE(&pl->stage[s], y, w);
+}
+
+static void ipl_pipeline_push(ipl_pipeline_t *pl, uint32_t s, int line, int w, int h);
+
+/* Computes the output line y of stage s and pushes it to the next stage. */
+static void ipl_pipeline_run_stage(ipl_pipeline_t *pl, uint32_t s, int y, int w, int h)
+{
+	ipl_stage_ctx_t *ctx = &pl->stage[s];
+	uint8_t *lines[2 * STM32IPL_PIPELINE_MAX_KSIZE + 1];
+
+	for (int j = -ctx->radius; j <= ctx->radius; j++)
+		lines[j + ctx->radius] = IPL_STAGE_LINE(ctx, IM_MIN(IM_MAX(y + j, 0), (h - 1)), w);
+
+	ctx->op(ctx, lines, ipl_pipeline_input_line(pl, s + 1, y, w), w, y, h);
+
+	ipl_pipeline_push(pl, s + 1, y, w, h);
+}
+
+/* Notifies stage s that its input line has been written; the line "radius" lines above can then be computed. */
+static void ipl_pipeline_push(ipl_pipeline_t *pl, uint32_t s, int line, int w, int h)
+{
+	int y;
+
+	if (s == pl->nStages) {
+		ipl_pipeline_sink(pl, line);
+		return;
+	}
+
+	y = line - pl->stage[s].radius;
+	if (y >= 0)
+		ipl_pipeline_run_stage(pl, s, y, w, h);
+}
+
+static void ipl_pipeline_read_line(const image_t *src, int y, uint8_t *out)
+{
+	switch (src->bpp) {
+		case IMAGE_BPP_GRAYSCALE:
+			memcpy(out, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y), src->w);
+			break;
+
+		case IMAGE_BPP_RGB565: {
+			uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, y);
+			for (int x = 0, xx = src->w; x < xx; x++)
+				out[x] = COLOR_RGB565_TO_GRAYSCALE(row[x]);
+			break;
+		}
+
+		case IMAGE_BPP_RGB888: {
+			rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, y);
+			for (int x = 0, xx = src->w; x < xx; x++)
+				out[x] = COLOR_RGB888_TO_GRAYSCALE(row[x]);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+///@endcond
+
+/**
+ * @brief Gets the size of the temporary memory used by STM32Ipl_Pipeline() for the given image width and stages.
+ * Such memory is taken from the fb stack, preferring the internal memory region.
+ * @param width		Width of the images.
+ * @param stages	List of stages; see STM32Ipl_Pipeline().
+ * @param nStages	Number of stages.
+ * @return			Size of the temporary memory used (bytes).
+ */
+uint32_t STM32Ipl_Pipeline_GetBufferSize(uint32_t width, const stm32ipl_stage_t *stages, uint32_t nStages)
+{
+	uint32_t size = width;
+
+	for (uint32_t i = 0; i < nStages; i++) {
+		size += ((stages[i].type == stm32ipl_stage_binary) ? 1 : ((2 * stages[i].kSize) + 1)) * width;
+		if (stages[i].type == stm32ipl_stage_gaussian)
+			size += width * sizeof(uint32_t);
+	}
+
+	return size;
+}
+
+/**
+ * @brief Runs a sequence of operations on the source image and stores the result to the destination image,
+ * without full-frame intermediate images: the source lines are converted to grayscale one at a time and streamed
+ * through small ring buffers, each holding as many lines as needed by the kernel of the corresponding stage, so the
+ * external memory is accessed only to read the source and to write the destination once.
+ * The result is the same of calling, on a grayscale copy of the source image, the functions corresponding
+ * to each stage (STM32Ipl_Gaussian(), STM32Ipl_Binary(), STM32Ipl_Erode(), STM32Ipl_Dilate()), in the given order,
+ * and converting the final image to the destination format. For example, a Convert -> Gaussian -> Binary -> Erode
+ * chain becomes a single call, whose binary output can then be given to STM32Ipl_FindBlobs().
+ * The temporary memory used is returned by STM32Ipl_Pipeline_GetBufferSize().
+ * The supported formats are Grayscale, RGB565, RGB888 for the source image, Binary and Grayscale for the
+ * destination image. The two images must have the same resolution; the destination data buffer can be the
+ * same of the source one (in place processing), when the two images are not views.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param dst		Destination image; if it is not valid, an error is returned.
+ * @param stages	List of nStages stages, executed in the given order; the kernel size of the gaussian,
+ * erode and dilate stages must be between 1 and STM32IPL_PIPELINE_MAX_KSIZE.
+ * @param nStages	Number of stages (up to STM32IPL_PIPELINE_MAX_STAGES); when zero, the source image
+ * is only converted to the destination format.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Pipeline(const image_t *src, image_t *dst, const stm32ipl_stage_t *stages, uint32_t nStages)
+{
+	ipl_pipeline_t pl;
+	uint32_t size;
+	uint8_t *mem;
+	int w;
+	int h;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_FORMAT(dst, STM32IPL_IF_NOT_RGB)
+	STM32IPL_CHECK_SAME_SIZE(src, dst)
+
+	if ((nStages > STM32IPL_PIPELINE_MAX_STAGES) || (nStages && !stages))
+		return stm32ipl_err_InvalidParameter;
+
+	for (uint32_t i = 0; i < nStages; i++) {
+		switch (stages[i].type) {
+			case stm32ipl_stage_binary:
+				break;
+
+			case stm32ipl_stage_gaussian:
+			case stm32ipl_stage_erode:
+			case stm32ipl_stage_dilate:
+				if ((stages[i].kSize == 0) || (stages[i].kSize > STM32IPL_PIPELINE_MAX_KSIZE))
+					return stm32ipl_err_InvalidParameter;
+				break;
+
+			default:
+				return stm32ipl_err_UnsupportedMethod;
+		}
+	}
+
+	w = src->w;
+	h = src->h;
+
+	size = STM32Ipl_Pipeline_GetBufferSize(w, stages, nStages);
+	if (fb_avail() < size)
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(Pipeline)
+	mem = fb_alloc(size, FB_ALLOC_PREFER_SPEED);
+
+	pl.nStages = nStages;
+	pl.dst = dst;
+
+	/* The 32-bit buffers are placed first to keep them aligned. */
+	for (uint32_t i = 0; i < nStages; i++) {
+		ipl_stage_ctx_t *ctx = &pl.stage[i];
+		const stm32ipl_stage_t *stage = &stages[i];
+
+		ctx->stage = stage;
+		ctx->acc = NULL;
+
+		switch (stage->type) {
+			case stm32ipl_stage_gaussian: {
+				int k_2 = stage->kSize * 2;
+				int32_t m = 0;
+
+				ctx->op = ipl_stage_gaussian;
+				ctx->radius = stage->kSize;
+				ctx->acc = (uint32_t*)mem;
+				mem += w * sizeof(uint32_t);
+
+				ctx->coef[0] = 1;
+				for (int j = 0; j < k_2; j++)
+					ctx->coef[j + 1] = (ctx->coef[j] * (k_2 - j)) / (j + 1);
+
+				for (int j = 0; j <= k_2; j++)
+					for (int k = 0; k <= k_2; k++)
+						m += ctx->coef[j] * ctx->coef[k];
+
+				ctx->mInt = (int32_t)(65536.0f * (1.0f / m));
+				break;
+			}
+
+			case stm32ipl_stage_binary:
+				ctx->op = ipl_stage_binary;
+				ctx->radius = 0;
+				break;
+
+			default:
+				ctx->op = ipl_stage_erode_dilate;
+				ctx->radius = stage->kSize;
+				break;
+		}
+
+		ctx->nLines = (2 * ctx->radius) + 1;
+	}
+
+	for (uint32_t i = 0; i < nStages; i++) {
+		pl.stage[i].ring = mem;
+		mem += pl.stage[i].nLines * w;
+	}
+	pl.outLine = mem;
+
+	for (int y = 0; y < h; y++) {
+		ipl_pipeline_read_line(src, y, ipl_pipeline_input_line(&pl, 0, y, w));
+		ipl_pipeline_push(&pl, 0, y, w, h);
+	}
+
+	/* Compute the last lines of each stage, which have no more input lines below them. */
+	for (uint32_t i = 0; i < nStages; i++)
+		for (int y = IM_MAX(h - pl.stage[i].radius, 0); y < h; y++)
+			ipl_pipeline_run_stage(&pl, i, y, w, h);
+
+	fb_free();
+	STM32IPL_TRACE_END(Pipeline)
+
+	return stm32ipl_err_Ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_prefetch.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - row prefetch module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* Starts copying the given source line to the given buffer. */
+static void ipl_prefetch_start(ipl_prefetch_t *pf, uint32_t index, int line)
+{
+	STM32Ipl_BlockCopyStart(pf->buf[index], pf->lineSize, pf->base + (line * pf->stride), pf->stride, pf->lineSize, 1);
+	pf->line[index] = line;
+}
+
+/**
+ * Initializes the prefetcher of the lines of a source buffer and starts copying the first line.
+ * Two line buffers are allocated from the fb stack, preferably in the internal memory; when
+ * STM32IPL_ENABLE_ROW_PREFETCH is not defined or there is not enough memory, the prefetch is not active
+ * and ipl_prefetch_line() returns the address of the line in the source buffer.
+ * pf		Prefetcher.
+ * base		Address of the first line of the source buffer.
+ * stride	Distance (bytes) between the beginning of two consecutive lines of the source buffer.
+ * lineSize	Number of bytes to be copied for each line.
+ * first	Index of the first line that will be requested, -1 when unknown.
+ */
+void ipl_prefetch_init(ipl_prefetch_t *pf, const uint8_t *base, uint32_t stride, uint32_t lineSize, int first)
+{
+	pf->base = base;
+	pf->stride = stride;
+	pf->lineSize = lineSize;
+	pf->buf[0] = NULL;
+	pf->buf[1] = NULL;
+	pf->line[0] = -1;
+	pf->line[1] = -1;
+	pf->cur = 0;
+
+#ifdef STM32IPL_ENABLE_ROW_PREFETCH
+	if (fb_avail() >= (2 * FB_ALLOC_SPACE(lineSize))) {
+		pf->buf[0] = fb_alloc(2 * FB_ALLOC_SPACE(lineSize), FB_ALLOC_PREFER_SPEED);
+		pf->buf[1] = pf->buf[0] + FB_ALLOC_SPACE(lineSize);
+
+		if (first >= 0)
+			ipl_prefetch_start(pf, 0, first);
+	}
+#else
+	STM32IPL_UNUSED(first);
+#endif /* STM32IPL_ENABLE_ROW_PREFETCH */
+}
+
+/**
+ * Gets a line of the source buffer and starts copying the next one, that will be requested by the following call.
+ * The returned line is valid until the following call.
+ * pf		Prefetcher.
+ * line		Index of the requested line.
+ * next		Index of the line that will be requested by the following call, -1 when none.
+ * return	Address of the requested line.
+ */
+const uint8_t* ipl_prefetch_line(ipl_prefetch_t *pf, int line, int next)
+{
+	uint32_t cur;
+
+	if (!pf->buf[0])
+		return pf->base + (line * pf->stride);
+
+	STM32Ipl_BlockCopyWait();
+
+	if (pf->line[pf->cur] == line)
+		cur = pf->cur;
+	else
+	if (pf->line[pf->cur ^ 1] == line)
+		cur = pf->cur ^ 1;
+	else {
+		/* The line was not prefetched (e.g. the first call, with unknown first line). */
+		cur = pf->cur ^ 1;
+		ipl_prefetch_start(pf, cur, line);
+		STM32Ipl_BlockCopyWait();
+	}
+
+	if ((next >= 0) && (next != line) && (pf->line[cur ^ 1] != next))
+		ipl_prefetch_start(pf, cur ^ 1, next);
+
+	pf->cur = cur;
+
+	return pf->buf[cur];
+}
+
+/**
+ * Waits for the pending copies and releases the line buffers allocated by ipl_prefetch_init().
+ * pf	Prefetcher.
+ */
+void ipl_prefetch_deinit(ipl_prefetch_t *pf)
+{
+	if (!pf->buf[0])
+		return;
+
+	STM32Ipl_BlockCopyWait();
+	fb_free();
+	pf->buf[0] = NULL;
+	pf->buf[1] = NULL;
+}
+///@endcond
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,226 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_pyramid.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - image pyramid module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* Average of four channel values, rounded to the nearest integer. */
+#define IPL_PYRAMID_AVG4(a, b, c, d)	(((a) + (b) + (c) + (d) + 2) >> 2)
+
+/* Halves the source image to the destination one (of size src->w / 2 x src->h / 2): with the Nearest method each
+ * destination pixel is the top-left one of the corresponding 2x2 source block, otherwise it is the block average
+ * (that is also what the Bilinear and Area methods compute for an exact halving). */
+static void ipl_pyramid_half(const image_t *src, image_t *dst, resize_algo_t algo)
+{
+	for (int y = 0; y < dst->h; y++) {
+		switch (src->bpp) {
+			case IMAGE_BPP_GRAYSCALE: {
+				const uint8_t *row0 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, 2 * y);
+				const uint8_t *row1 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, (2 * y) + 1);
+				uint8_t *out = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y);
+
+				if (algo == RESIZE_NEAREST) {
+					for (int x = 0; x < dst->w; x++)
+						out[x] = row0[2 * x];
+				} else {
+					for (int x = 0; x < dst->w; x++, row0 += 2, row1 += 2)
+						out[x] = IPL_PYRAMID_AVG4(row0[0], row0[1], row1[0], row1[1]);
+				}
+				break;
+			}
+
+			case IMAGE_BPP_RGB565: {
+				const uint16_t *row0 = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, 2 * y);
+				const uint16_t *row1 = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, (2 * y) + 1);
+				uint16_t *out = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y);
+
+				if (algo == RESIZE_NEAREST) {
+					for (int x = 0; x < dst->w; x++)
+						out[x] = row0[2 * x];
+				} else {
+					for (int x = 0; x < dst->w; x++, row0 += 2, row1 += 2) {
+						uint32_t r = IPL_PYRAMID_AVG4(COLOR_RGB565_TO_R5(row0[0]), COLOR_RGB565_TO_R5(row0[1]),
+								COLOR_RGB565_TO_R5(row1[0]), COLOR_RGB565_TO_R5(row1[1]));
+						uint32_t g = IPL_PYRAMID_AVG4(COLOR_RGB565_TO_G6(row0[0]), COLOR_RGB565_TO_G6(row0[1]),
+								COLOR_RGB565_TO_G6(row1[0]), COLOR_RGB565_TO_G6(row1[1]));
+						uint32_t b = IPL_PYRAMID_AVG4(COLOR_RGB565_TO_B5(row0[0]), COLOR_RGB565_TO_B5(row0[1]),
+								COLOR_RGB565_TO_B5(row1[0]), COLOR_RGB565_TO_B5(row1[1]));
+
+						out[x] = COLOR_R5_G6_B5_TO_RGB565(r, g, b);
+					}
+				}
+				break;
+			}
+
+			default: {
+				const rgb888_t *row0 = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, 2 * y);
+				const rgb888_t *row1 = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, (2 * y) + 1);
+				rgb888_t *out = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(dst, y);
+
+				if (algo == RESIZE_NEAREST) {
+					for (int x = 0; x < dst->w; x++)
+						out[x] = row0[2 * x];
+				} else {
+					for (int x = 0; x < dst->w; x++, row0 += 2, row1 += 2) {
+						out[x].r = IPL_PYRAMID_AVG4(row0[0].r, row0[1].r, row1[0].r, row1[1].r);
+						out[x].g = IPL_PYRAMID_AVG4(row0[0].g, row0[1].g, row1[0].g, row1[1].g);
+						out[x].b = IPL_PYRAMID_AVG4(row0[0].b, row0[1].b, row1[0].b, row1[1].b);
+					}
+				}
+				break;
+			}
+		}
+	}
+}
+///@endcond
+
+/**
+ * @brief Builds an image pyramid from the source image: the first level is the source image itself, each of the
+ * other levels is downscaled by the given factor from the previous one, so that all the levels are computed once
+ * (e.g. once per frame) and shared by the functions that work at multiple scales, such as
+ * STM32Ipl_DetectObjectPyramid() and STM32Ipl_FindTemplatePyramid(). With a factor of 2, the levels are
+ * computed with a fast 2x decimation (2x2 block average, or top-left pixel of each block with the Nearest
+ * method); otherwise they are resized with the Area method (Nearest method when requested). The levels are
+ * not computed beyond the size of one pixel, so the pyramid may have less levels than requested.
+ * The level data buffers are allocated by this function, except the first one that refers to the source image;
+ * when the pyramid already contains levels with the same size and format (e.g. built from the previous frame),
+ * their buffers are reused. The pyramid must be initialized to zero before the first build and must be released
+ * with STM32Ipl_PyramidRelease(). The source image must not be released or modified while the pyramid is used.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param levels	Number of levels, including the source image; it must be in the range
+ * [1, STM32IPL_PYRAMID_MAX_LEVELS], otherwise an error is returned.
+ * @param scale		Downscale factor between two consecutive levels; it must be greater than 1.
+ * @param algo		Downscale method (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA); the Bilinear and Area
+ * methods average the source pixels covered by each level pixel.
+ * @param pyramid	Pyramid; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_PyramidBuild(const image_t *src, uint8_t levels, float scale, resize_algo_t algo,
+		stm32ipl_pyramid_t *pyramid)
+{
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	uint8_t oldLevels;
+	uint8_t i;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_VALID_PTR_ARG(pyramid)
+
+	if ((levels < 1) || (levels > STM32IPL_PYRAMID_MAX_LEVELS) || !(scale > 1.0f) || (algo > RESIZE_AREA)
+			|| (pyramid->levels > STM32IPL_PYRAMID_MAX_LEVELS))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(PyramidBuild)
+
+	oldLevels = pyramid->levels;
+	pyramid->level[0] = *src;
+	pyramid->scale[0] = 1.0f;
+	pyramid->algo = algo;
+
+	for (i = 1; i < levels; i++) {
+		const image_t *prev = &pyramid->level[i - 1];
+		image_t *level = &pyramid->level[i];
+		uint32_t w = (uint32_t)(prev->w / scale);
+		uint32_t h = (uint32_t)(prev->h / scale);
+
+		if (!w || !h)
+			break;
+
+		if ((i >= oldLevels) || (level->w != w) || (level->h != h) || (level->bpp != src->bpp)) {
+			if (i < oldLevels)
+				STM32Ipl_ReleaseData(level);
+
+			res = STM32Ipl_AllocData(level, w, h, (image_bpp_t)src->bpp);
+			if (res != stm32ipl_err_Ok)
+				break;
+		}
+
+		pyramid->scale[i] = pyramid->scale[i - 1] * scale;
+
+		if (scale == 2.0f)
+			ipl_pyramid_half(prev, level, algo);
+		else
+			res = STM32Ipl_Resize_Roi(prev, NULL, level, NULL, (algo == RESIZE_NEAREST) ? RESIZE_NEAREST : RESIZE_AREA);
+
+		if (res != stm32ipl_err_Ok) {
+			STM32Ipl_ReleaseData(level);
+			break;
+		}
+	}
+
+	/* Releases the levels of the previous build that are not used anymore. */
+	for (uint8_t j = i + ((res != stm32ipl_err_Ok) ? 1 : 0); j < oldLevels; j++)
+		STM32Ipl_ReleaseData(&pyramid->level[j]);
+
+	pyramid->levels = i;
+
+	if (res != stm32ipl_err_Ok)
+		STM32Ipl_PyramidRelease(pyramid);
+
+	STM32IPL_TRACE_END(PyramidBuild)
+
+	return res;
+}
+
+/**
+ * @brief Releases the data buffers of the levels allocated by STM32Ipl_PyramidBuild() and resets the pyramid.
+ * The first level, that refers to the source image, is not released.
+ * @param pyramid	Pyramid.
+ * @return			void.
+ */
+void STM32Ipl_PyramidRelease(stm32ipl_pyramid_t *pyramid)
+{
+	if (!pyramid)
+		return;
+
+	for (uint8_t i = 1; (i < pyramid->levels) && (i < STM32IPL_PYRAMID_MAX_LEVELS); i++)
+		STM32Ipl_ReleaseData(&pyramid->level[i]);
+
+	STM32Ipl_Init(&pyramid->level[0], 0, 0, (image_bpp_t)0, 0);
+	pyramid->levels = 0;
+}
+
+/**
+ * @brief Gets the level of the pyramid to be used to process the source image downscaled by the given factor,
+ * that is the coarsest level whose downscale factor is not greater than the given one.
+ * @param pyramid	Pyramid; if it is not valid, -1 is returned.
+ * @param factor	Downscale factor with respect to the source image.
+ * @return			Index of the level, -1 in case of wrong arguments.
+ */
+int32_t STM32Ipl_PyramidGetLevel(const stm32ipl_pyramid_t *pyramid, float factor)
+{
+	int32_t level = 0;
+
+	if (!pyramid || !pyramid->levels || (pyramid->levels > STM32IPL_PYRAMID_MAX_LEVELS))
+		return -1;
+
+	while (((level + 1) < pyramid->levels) && (pyramid->scale[level + 1] <= factor))
+		level++;
+
+	return level;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -258,6 +258,332 @@ stm32ipl_err_t STM32Ipl_RectMerge(array_t **rects)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Initializes a vector of scored rectangles: when a buffer is given, the items are stored in it and the
+ * vector cannot grow beyond its capacity; otherwise, the items are stored in the heap, doubling the storage when
+ * it is full, and the vector must be released with STM32Ipl_RectVecRelease().
+ * @param vec		Vector; if it is not valid, an error is returned.
+ * @param buffer	Optional buffer for the items; if null, the heap is used.
+ * @param capacity	Number of items that fit the buffer; with the heap, number of items allocated by the first push
+ * (0 for the default).
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RectVecInit(stm32ipl_rect_vec_t *vec, stm32ipl_scored_rect_t *buffer, uint32_t capacity)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(vec)
+
+	vec->item = buffer;
+	vec->count = 0;
+	vec->capacity = capacity;
+	vec->fixed = (buffer != NULL);
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Releases the storage of a vector of scored rectangles allocated in the heap; the vector is then empty
+ * and can be used again.
+ * @param vec		Vector.
+ * @return			void.
+ */
+void STM32Ipl_RectVecRelease(stm32ipl_rect_vec_t *vec)
+{
+	if (!vec)
+		return;
+
+	if (!vec->fixed) {
+		xfree(vec->item);
+		vec->item = NULL;
+		vec->capacity = 0;
+	}
+
+	vec->count = 0;
+}
+
+/**
+ * @brief Adds a scored rectangle to the end of the vector.
+ * @param vec		Vector; if it is not valid, an error is returned.
+ * @param r			Rectangle; if it is not valid, an error is returned.
+ * @param score		Score of the rectangle (e.g. confidence of a detection).
+ * @return			stm32ipl_err_Ok on success, stm32ipl_err_OutOfMemory if the vector cannot grow, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RectVecPush(stm32ipl_rect_vec_t *vec, const rectangle_t *r, float score)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(vec)
+	STM32IPL_CHECK_VALID_PTR_ARG(r)
+
+	if (vec->count == vec->capacity || !vec->item) {
+		stm32ipl_scored_rect_t *item;
+		uint32_t capacity;
+
+		if (vec->fixed)
+			return stm32ipl_err_OutOfMemory;
+
+		capacity = vec->item ? (vec->capacity * 2) : STM32IPL_MAX(vec->capacity, 16);
+		item = xrealloc(vec->item, capacity * sizeof(stm32ipl_scored_rect_t));
+		if (!item)
+			return stm32ipl_err_OutOfMemory;
+
+		vec->item = item;
+		vec->capacity = capacity;
+	}
+
+	vec->item[vec->count].rect = *r;
+	vec->item[vec->count].score = score;
+	vec->count++;
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Adds the rectangles of an array of rectangle_t (e.g. returned by STM32Ipl_DetectObject()) to the end of
+ * the vector, with the given score; the array is not modified.
+ * @param vec		Vector; if it is not valid, an error is returned.
+ * @param rects		Array of rectangle_t; if it is not valid, an error is returned.
+ * @param score		Score of the rectangles.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RectVecFromArray(stm32ipl_rect_vec_t *vec, const array_t *rects, float score)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(vec)
+	STM32IPL_CHECK_VALID_PTR_ARG(rects)
+
+	for (int i = 0; i < array_length((array_t*)rects); i++) {
+		stm32ipl_err_t res = STM32Ipl_RectVecPush(vec, (const rectangle_t*)array_at((array_t*)rects, i), score);
+		if (res != stm32ipl_err_Ok)
+			return res;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+///@cond
+/* Rectangle kept by ipl_rect_vec_suppress(), in the list sorted by x. */
+typedef struct
+{
+	rectangle_t rect;	/* Rectangle. */
+	uint32_t index;		/* Index of the rectangle in the vector. */
+} ipl_rect_vec_kept_t;
+
+/* Sum of the rectangles merged to a kept one. */
+typedef struct
+{
+	int32_t x, y, w, h;	/* Sum of the coordinates. */
+	uint32_t count;		/* Number of rectangles. */
+} ipl_rect_vec_sum_t;
+
+/* Orders the scored rectangles by decreasing score, then by position and size, so that the result does not depend
+ * on the order of the input. */
+static int ipl_rect_vec_compare(const void *a, const void *b)
+{
+	const stm32ipl_scored_rect_t *r0 = (const stm32ipl_scored_rect_t*)a;
+	const stm32ipl_scored_rect_t *r1 = (const stm32ipl_scored_rect_t*)b;
+
+	if (r0->score != r1->score)
+		return (r0->score > r1->score) ? -1 : 1;
+	if (r0->rect.y != r1->rect.y)
+		return r0->rect.y - r1->rect.y;
+	if (r0->rect.x != r1->rect.x)
+		return r0->rect.x - r1->rect.x;
+	if (r0->rect.w != r1->rect.w)
+		return r0->rect.w - r1->rect.w;
+
+	return r0->rect.h - r1->rect.h;
+}
+
+/* Returns true if the intersection over union of the two rectangles is greater than the threshold. */
+static bool ipl_rect_vec_iou_above(const rectangle_t *r0, const rectangle_t *r1, float threshold)
+{
+	int32_t w = STM32IPL_MIN(r0->x + r0->w, r1->x + r1->w) - STM32IPL_MAX(r0->x, r1->x);
+	int32_t h = STM32IPL_MIN(r0->y + r0->h, r1->y + r1->h) - STM32IPL_MAX(r0->y, r1->y);
+	float inter;
+
+	if ((w <= 0) || (h <= 0))
+		return false;
+
+	inter = (float)(w * h);
+
+	return inter > (threshold * (((float)r0->w * r0->h) + ((float)r1->w * r1->h) - inter));
+}
+
+/* Greedy suppression of the overlapping rectangles: the rectangles are sorted by decreasing score and each one is
+ * kept only if its IoU with all the rectangles already kept is not above the threshold. The kept rectangles are
+ * sorted by x, so each rectangle is compared only with the kept ones that can overlap it (binary search of the
+ * ones whose x is within the largest kept width): O(n log n) for the usual detections.
+ * When merge is true, each suppressed rectangle is added to the kept one with the highest score that suppresses it;
+ * the kept rectangle becomes the average of its group, its score the sum of the scores, and the groups made of
+ * less than minCount rectangles are removed.
+ * vec			Vector.
+ * threshold	IoU threshold.
+ * merge		true to merge the suppressed rectangles to the kept ones.
+ * minCount		Minimum number of rectangles of a group (merge only).
+ * return		stm32ipl_err_Ok on success, error otherwise.
+ */
+static stm32ipl_err_t ipl_rect_vec_suppress(stm32ipl_rect_vec_t *vec, float threshold, bool merge, uint32_t minCount)
+{
+	ipl_rect_vec_kept_t *kept;
+	ipl_rect_vec_sum_t *sum = NULL;
+	uint32_t nKept = 0;
+	int32_t maxW = 0;
+	uint32_t count = 0;
+
+	if (vec->count == 0)
+		return stm32ipl_err_Ok;
+
+	kept = xalloc(vec->count * sizeof(ipl_rect_vec_kept_t));
+	if (!kept)
+		return stm32ipl_err_OutOfMemory;
+
+	if (merge) {
+		sum = xalloc(vec->count * sizeof(ipl_rect_vec_sum_t));
+		if (!sum) {
+			xfree(kept);
+			return stm32ipl_err_OutOfMemory;
+		}
+	}
+
+	qsort(vec->item, vec->count, sizeof(stm32ipl_scored_rect_t), ipl_rect_vec_compare);
+
+	for (uint32_t i = 0; i < vec->count; i++) {
+		stm32ipl_scored_rect_t item = vec->item[i];
+		const rectangle_t *r = &item.rect;
+		uint32_t lo = 0;
+		uint32_t hi = nKept;
+		int32_t best = -1;
+
+		/* First kept rectangle whose x is greater than r->x - maxW. */
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) >> 1;
+
+			if (kept[mid].rect.x > (r->x - maxW))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+
+		for (uint32_t j = lo; (j < nKept) && (kept[j].rect.x < (r->x + r->w)); j++) {
+			if (ipl_rect_vec_iou_above(r, &kept[j].rect, threshold)) {
+				/* The kept rectangles with lower index have higher score. */
+				if ((best < 0) || (kept[j].index < kept[best].index))
+					best = j;
+				if (!merge)
+					break;
+			}
+		}
+
+		if (best >= 0) {
+			if (merge) {
+				ipl_rect_vec_sum_t *s = &sum[kept[best].index];
+
+				s->x += r->x;
+				s->y += r->y;
+				s->w += r->w;
+				s->h += r->h;
+				s->count++;
+				vec->item[kept[best].index].score += item.score;
+			}
+			continue;
+		}
+
+		/* Insert the rectangle in the kept list, sorted by x. */
+		lo = 0;
+		hi = nKept;
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) >> 1;
+
+			if (kept[mid].rect.x > r->x)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		memmove(&kept[lo + 1], &kept[lo], (nKept - lo) * sizeof(ipl_rect_vec_kept_t));
+		kept[lo].rect = *r;
+		kept[lo].index = count;
+		nKept++;
+		maxW = STM32IPL_MAX(maxW, r->w);
+
+		if (merge) {
+			sum[count].x = r->x;
+			sum[count].y = r->y;
+			sum[count].w = r->w;
+			sum[count].h = r->h;
+			sum[count].count = 1;
+		}
+
+		/* The kept rectangles are compacted at the beginning of the vector, in score order. */
+		vec->item[count++] = item;
+	}
+
+	if (merge) {
+		uint32_t n = 0;
+
+		for (uint32_t i = 0; i < count; i++) {
+			const ipl_rect_vec_sum_t *s = &sum[i];
+
+			if (s->count < minCount)
+				continue;
+
+			vec->item[n].rect.x = s->x / (int32_t)s->count;
+			vec->item[n].rect.y = s->y / (int32_t)s->count;
+			vec->item[n].rect.w = s->w / (int32_t)s->count;
+			vec->item[n].rect.h = s->h / (int32_t)s->count;
+			vec->item[n].score = vec->item[i].score;
+			n++;
+		}
+		count = n;
+
+		/* The scores have changed. */
+		qsort(vec->item, count, sizeof(stm32ipl_scored_rect_t), ipl_rect_vec_compare);
+		xfree(sum);
+	}
+
+	vec->count = count;
+	xfree(kept);
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
+/**
+ * @brief Non-maximum suppression: removes from the vector the rectangles that overlap a rectangle with higher
+ * score by more than the given intersection over union; the remaining rectangles are sorted by decreasing score.
+ * The rectangles are compared only with the kept ones that can overlap them, so the cost is O(n log n) for the
+ * usual detections, instead of the pairwise checks of STM32Ipl_RectMerge().
+ * @param vec		Vector; if it is not valid, an error is returned.
+ * @param threshold	IoU threshold, in the range [0, 1].
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RectVecNMS(stm32ipl_rect_vec_t *vec, float threshold)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(vec)
+
+	if ((threshold < 0.0f) || (threshold > 1.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	return ipl_rect_vec_suppress(vec, threshold, false, 0);
+}
+
+/**
+ * @brief Groups the overlapping rectangles of the vector, as STM32Ipl_RectVecNMS(), but each removed rectangle is
+ * merged to the rectangle with the highest score that removes it: the resulting rectangles are the average of
+ * their groups and their score is the sum of the scores of the group (the number of detections, when all the
+ * scores are 1). The groups with less than minNeighbors rectangles are removed (e.g. isolated false positives of
+ * STM32Ipl_DetectObjectVec()). The remaining rectangles are sorted by decreasing score.
+ * @param vec			Vector; if it is not valid, an error is returned.
+ * @param threshold		IoU threshold, in the range [0, 1].
+ * @param minNeighbors	Minimum number of rectangles of a group.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RectVecGroup(stm32ipl_rect_vec_t *vec, float threshold, uint32_t minNeighbors)
+{
+	STM32IPL_CHECK_VALID_PTR_ARG(vec)
+
+	if ((threshold < 0.0f) || (threshold > 1.0f))
+		return stm32ipl_err_InvalidParameter;
+
+	return ipl_rect_vec_suppress(vec, threshold, true, minNeighbors);
+}
+
 #ifdef __cplusplus
 }
 #endif
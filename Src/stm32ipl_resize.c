@@ -18,6 +18,7 @@
 
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#include "stm32ipl_kernels.h"
 #ifdef IPL_RESIZE_HAS_MVE
 /* MVE specific function definitions */
 #include "mve_resize.h"
@@ -59,6 +60,14 @@ stm32ipl_err_t STM32Ipl_Crop(const image_t *src, image_t *dst, uint32_t x, uint3
 	STM32Ipl_RectInit(&srcRoi, x, y, dstW, dstH);
 
 	STM32IPL_CHECK_VALID_ROI(src, &srcRoi)
+	STM32IPL_TRACE_BEGIN(Crop)
+
+#ifdef STM32IPL_ENABLE_HW_PIXEL_OPS
+	if ((src->bpp != IMAGE_BPP_BINARY) && (ipl_hw_copy(src, &srcRoi, dst, true) == stm32ipl_err_Ok)) {
+		STM32IPL_TRACE_END(Crop)
+		return stm32ipl_err_Ok;
+	}
+#endif /* STM32IPL_ENABLE_HW_PIXEL_OPS */
 
 	switch (src->bpp) {
 		case IMAGE_BPP_BINARY:
@@ -102,15 +111,26 @@ stm32ipl_err_t STM32Ipl_Crop(const image_t *src, image_t *dst, uint32_t x, uint3
 			break;
 
 		default:
+			STM32IPL_TRACE_END(Crop)
 			return stm32ipl_err_UnsupportedFormat;
 	}
 
+	STM32IPL_TRACE_END(Crop)
 	return stm32ipl_err_Ok;
 }
 
+///@cond
+/* Index of the source line, relative to the region of interest, sampled by the destination line y. */
+#define IPL_RESIZE_SRC_LINE(y)		(((y) * hRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16)
+
+/* Gets the source line sampled by the destination line y and starts prefetching the one sampled by the next line. */
+#define IPL_RESIZE_GET_SRC_LINE(y)	ipl_prefetch_line(&pf, IPL_RESIZE_SRC_LINE(y), \
+		(((y) + 1) < dstH) ? IPL_RESIZE_SRC_LINE((y) + 1) : -1)
+///@endcond
+
 /**
  * @brief Resizes the source image (whole or a portion of it) to the destination image with Nearest Neighbor method.
- * The two images must have same format. The destination image data buffer must be already allocated
+ * The two images must have same format, unless sink is defined. The destination image data buffer must be already allocated
  * by the user and its size must be large enough to contain the resized pixels. When specified, roi defines
  * the region of the source image to be scaled to the destination image resolution. If roi is null, the whole
  * source image is resized to the destination size. The supported formats are Binary, Grayscale, RGB565, RGB888.
@@ -120,11 +140,16 @@ stm32ipl_err_t STM32Ipl_Crop(const image_t *src, image_t *dst, uint32_t x, uint3
  * @param roi	Optional region of interest of the source image where the functions operates;
  * when defined, it must be contained in the source image and have positive dimensions, otherwise
  * an error is returned; when not defined, the whole image is considered.
+ * @param sink	Optional receiver of the destination lines; when defined, each line is sampled to its buffer and
+ * passed to it, instead of being written to the destination image, that only gives the destination size.
  * @return		stm32ipl_err_Ok on success, error otherwise.
  */
-static stm32ipl_err_t ipl_resize(const image_t *src, image_t *dst, const rectangle_t *roi)
+static stm32ipl_err_t ipl_resize(const image_t *src, image_t *dst, const rectangle_t *roi, const ipl_resize_sink_t *sink)
 {
+	ipl_prefetch_t pf;
 	rectangle_t srcRoi;
+	uint32_t bpp;
+	int32_t xOffset;
 	int32_t srcW;
 	int32_t srcH;
 	int32_t dstW;
@@ -135,7 +160,8 @@ static stm32ipl_err_t ipl_resize(const image_t *src, image_t *dst, const rectang
 	STM32IPL_CHECK_VALID_IMAGE(src)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
-	STM32IPL_CHECK_SAME_FORMAT(src, dst)
+	if (!sink && (src->bpp != dst->bpp))
+		return stm32ipl_err_InvalidParameter;
 
 	if ((dst->w < 1) || (dst->h < 1))
 		return stm32ipl_err_InvalidParameter;
@@ -162,65 +188,89 @@ static stm32ipl_err_t ipl_resize(const image_t *src, image_t *dst, const rectang
 	wRatio = (int32_t) ((srcW << 16) / dstW) + 1;
 	hRatio = (int32_t) ((srcH << 16) / dstH) + 1;
 
+	/* The source lines are read through the row prefetcher; except for the Binary format, only the pixels
+	 * of the region of interest are read, so the x-coordinates are relative to its left side. */
+	bpp = (src->bpp == IMAGE_BPP_BINARY) ? 0 : STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp);
+	xOffset = bpp ? 0 : srcRoi.x;
+	ipl_prefetch_init(&pf, src->data + (srcRoi.y * STM32Ipl_ImageStride(src)) + (srcRoi.x * bpp),
+			STM32Ipl_ImageStride(src), bpp ? (srcRoi.w * bpp) : STM32Ipl_DataSize(src->w, 1, IMAGE_BPP_BINARY),
+			IPL_RESIZE_SRC_LINE(0));
+
 	switch (src->bpp) {
 		case IMAGE_BPP_BINARY:
 			for (int32_t y = 0; y < dstH; y++) {
-				uint32_t *srcRow = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(src, ((y * hRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.y);
-				uint32_t *dstRow = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+				const uint32_t *srcRow = (const uint32_t*)IPL_RESIZE_GET_SRC_LINE(y);
+				uint32_t *dstRow = sink ? (uint32_t*)sink->line : IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
 
 				for (int32_t x = 0; x < dstW; x++)
 					IMAGE_PUT_BINARY_PIXEL_FAST(dstRow, x,
-							IMAGE_GET_BINARY_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.x));
+							IMAGE_GET_BINARY_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + xOffset));
+
+				if (sink)
+					sink->put(sink, y);
 			}
 			break;
 
 		case IMAGE_BPP_GRAYSCALE:
 			for (int32_t y = 0; y < dstH; y++) {
-				uint8_t *srcRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, ((y * hRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.y);
-				uint8_t *dstRow = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y);
+				const uint8_t *srcRow = IPL_RESIZE_GET_SRC_LINE(y);
+				uint8_t *dstRow = sink ? (uint8_t*)sink->line : IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y);
 
 				for (int32_t x = 0; x < dstW; x++)
 					IMAGE_PUT_GRAYSCALE_PIXEL_FAST(dstRow, x,
-							IMAGE_GET_GRAYSCALE_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.x));
+							IMAGE_GET_GRAYSCALE_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16)));
+
+				if (sink)
+					sink->put(sink, y);
 			}
 			break;
 
 		case IMAGE_BPP_RGB565:
 			for (int32_t y = 0; y < dstH; y++) {
-				uint16_t *srcRow = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, ((y * hRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.y);
-				uint16_t *dstRow = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y);
+				const uint16_t *srcRow = (const uint16_t*)IPL_RESIZE_GET_SRC_LINE(y);
+				uint16_t *dstRow = sink ? (uint16_t*)sink->line : IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y);
 
 				for (int32_t x = 0; x < dstW; x++)
 					IMAGE_PUT_RGB565_PIXEL_FAST(dstRow, x,
-							IMAGE_GET_RGB565_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.x));
+							IMAGE_GET_RGB565_PIXEL_FAST(srcRow, ((x * wRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16)));
+
+				if (sink)
+					sink->put(sink, y);
 			}
 			break;
 
 		case IMAGE_BPP_RGB888:
 			for (int32_t y = 0; y < dstH; y++) {
-				rgb888_t *srcRow = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, ((y * hRatio + IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.y);
-				rgb888_t *dstRow = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(dst, y);
+				const rgb888_t *srcRow = (const rgb888_t*)IPL_RESIZE_GET_SRC_LINE(y);
+				rgb888_t *dstRow = sink ? (rgb888_t*)sink->line : IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(dst, y);
 				for (int32_t x = 0; x < dstW; x++)
 					IMAGE_PUT_RGB888_PIXEL_FAST(dstRow, x,
-							IMAGE_GET_RGB888_PIXEL_FAST(srcRow, ((x * wRatio +IPL_RESIZE_PEL_IDX_ROUNDING) >> 16) + srcRoi.x));
+							IMAGE_GET_RGB888_PIXEL_FAST(srcRow, ((x * wRatio +IPL_RESIZE_PEL_IDX_ROUNDING) >> 16)));
+
+				if (sink)
+					sink->put(sink, y);
 			}
 			break;
 
 		default:
+			ipl_prefetch_deinit(&pf);
 			return stm32ipl_err_UnsupportedFormat;
 	}
 
+	ipl_prefetch_deinit(&pf);
+
 	return stm32ipl_err_Ok;
 }
 /**
- * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, Grayscale)
+ * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, RGB565, Grayscale),
+ * Area method (average of the covered source pixels, suited to downscale without aliasing)
  * The two images must have the same format. The destination image data buffer must be already allocated
  * by the user and its size must be large enough to contain the resized pixels.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * Use this function for downscale cases only.
  * @param src	Source image; it must be valid, otherwise an error is returned;
  * @param dst	Destination image; its width and height must be greater than zero; it must be valid, otherwise an error is returned;
- * @param algo	algorithm used (RESIZE_NEAREST or RESIZE_BILINEAR)
+ * @param algo	algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
  * @return		stm32ipl_err_Ok on success, error otherwise.
  */
 
@@ -232,8 +282,42 @@ stm32ipl_err_t STM32Ipl_Resize(const image_t *src,
 	return err;
 }
 
+#ifdef IPL_RESIZE_HAS_MVE
+/* Returns the size (bytes) of the elements processed by the MVE resize functions, 0 when not supported. */
+static uint8_t ipl_resize_mve_elem_size(image_bpp_t bpp, const resize_algo_t algo)
+{
+	/* area: dedicated kernels, dispatched by ipl_resize_area() */
+	if ((RESIZE_AREA == algo) || !ipl_mve_enabled)
+		return 0;
+
+	switch (bpp) {
+	case IMAGE_BPP_RGB888:
+		return 3;
+	case IMAGE_BPP_RGB565:
+		/* nearest: 5 + 6 + 5 = 16bits -> 2*8bits; bilinear: dedicated RGB565 kernel */
+		return ((RESIZE_NEAREST == algo) || (RESIZE_BILINEAR == algo)) ? 2 : 0;
+	case IMAGE_BPP_GRAYSCALE:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Returns the size (bytes) of the scratch buffer needed by the MVE resize functions. */
+static uint32_t ipl_resize_mve_scratch_size(uint32_t width_out, uint8_t size_elem, const resize_algo_t algo)
+{
+	switch (algo) {
+	case RESIZE_BILINEAR:
+		return width_out * 2 * sizeof(uint16_t) + width_out * 1 * sizeof(float16_t);
+	case RESIZE_NEAREST:
+		return width_out * size_elem * sizeof(uint8_t) + ((width_out * size_elem + 15) / 16) * sizeof(uint16_t);
+	default:
+		return 0;
+	}
+}
+
 /**
- * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, Grayscale)
+ * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, RGB565, Grayscale)
  * The two images must have the same format. The destination image data buffer must be already allocated
  * by the user and its size must be large enough to contain the resized pixels.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
@@ -245,45 +329,32 @@ stm32ipl_err_t STM32Ipl_Resize(const image_t *src,
  * @param dst_roi    Optional region of interest of the destination image where the functions operates;
  * when defined, it must be contained in the destination image and have positive dimensions, otherwise
  * an error is returned; when not defined, the whole image is considered.
- * @param algo         algorithm used (RESIZE_NEAREST or RESIZE_BILINEAR)
+ * @param algo         algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+ * @param scratch      Optional scratch buffer of (at least) ipl_resize_mve_scratch_size() bytes, 32-bit aligned;
+ * when null, the scratch buffer is allocated from the heap.
+ * @param tableReady   True when the index table in the scratch buffer has been computed by a previous call
+ * with the same ROI sizes and format, so that it is reused; ignored when scratch is null.
  * @return        stm32ipl_err_Ok on success, error otherwise.
  */
-#ifdef IPL_RESIZE_HAS_MVE
 stm32ipl_err_t ipl_resize_roi_mve(const image_t *src,
                                   const rectangle_t *src_roi,
                                   image_t *dst,
                                   const rectangle_t *dst_roi,
-                                  const resize_algo_t algo)
+                                  const resize_algo_t algo,
+                                  uint8_t *scratch,
+                                  bool tableReady)
 {
 	stm32ipl_err_t ret = stm32ipl_err_UnsupportedFormat;
-	uint8_t size_elem = 0;
+	uint8_t size_elem = ipl_resize_mve_elem_size((image_bpp_t)src->bpp, algo);
 
-	switch (src->bpp) {
-	case IMAGE_BPP_RGB888:
-		size_elem = 3;
-		ret = stm32ipl_err_Ok;
-		break;
-	case IMAGE_BPP_RGB565:
-		if (RESIZE_NEAREST == algo) {
-			/* only nearest algo supported */
-			size_elem = 2; /* 5 + 6 + 5 = 16bits -> 2*8bits*/
-			ret = stm32ipl_err_Ok;
-		}
-		break;
-	case IMAGE_BPP_GRAYSCALE:
-		size_elem = 1;
-		ret = stm32ipl_err_Ok;
-		break;
-	default:
-		break;
-	}
 	// MVE supported
-	if (stm32ipl_err_Ok != ret) {
+	if (0 == size_elem) {
 		return ret;
 	}
+	ret = stm32ipl_err_Ok;
 
-	size_t stride_in = src->w * size_elem;
-	size_t stride_out = dst->w * size_elem;
+	size_t stride_in = STM32Ipl_ImageStride(src);
+	size_t stride_out = STM32Ipl_ImageStride(dst);
 	size_t width_in = src->w;
 	size_t height_in = src->h;
 	size_t width_out = dst->w;
@@ -327,41 +398,48 @@ stm32ipl_err_t ipl_resize_roi_mve(const image_t *src,
 	if (stm32ipl_err_Ok != ret) {
 		return ret;
 	}
+	if ((RESIZE_BILINEAR != algo) && (RESIZE_NEAREST != algo)) {
+		return stm32ipl_err_UnsupportedMethod;
+	}
+	ptrScratch = scratch ? scratch : xalloc(ipl_resize_mve_scratch_size(width_out, size_elem, algo));
+	if (!ptrScratch) {
+		return stm32ipl_err_OutOfMemory;
+	}
+	tableReady = tableReady && (ptrScratch == scratch);
 	switch (algo) {
 	case RESIZE_BILINEAR:
 		/* Scratch buffer contains indexes (i.e. integer part for left and right neighbor used)
 		 * and weights (i.e. decimal part) for each output uint8_t width */
-		ptrScratch = xalloc(width_out * 2 * sizeof(uint16_t)
-							+ width_out * 1 * sizeof(float16_t));
-		if (!ptrScratch) {
-			return stm32ipl_err_OutOfMemory;
+		if (IMAGE_BPP_RGB565 == src->bpp) {
+			/* The 565 channels are unpacked, interpolated and repacked in-register */
+			mve_resize_bilinear_rgb565_with_strides((const uint16_t*)src_data, (uint16_t*)dst_data,
+													stride_in, stride_out,
+													width_in, height_in,
+													width_out, height_out,
+													ptrScratch, tableReady);
+			break;
 		}
 		mve_resize_bilinear_iu8ou8_with_strides(src_data, dst_data,
 												stride_in, stride_out,
 												width_in, height_in,
 												width_out, height_out,
-												size_elem, ptrScratch);
+												size_elem, ptrScratch, tableReady);
 		break;
 	case RESIZE_NEAREST:
 		/* Scratch buffer contains indexes split in 2: offset for each of the 16 elements on 8-bits
 		 *         and indexes to jump to next 16 element group*/
-		ptrScratch = xalloc(width_out * size_elem * sizeof(uint8_t)
-							+ ((width_out * size_elem + 15) / 16) * sizeof(uint16_t));
-		if (!ptrScratch) {
-			return stm32ipl_err_OutOfMemory;
-		}
 		mve_resize_nearest_iu8ou8_with_strides(src_data, dst_data,
 												stride_in, stride_out,
 												width_in, height_in,
 												width_out, height_out,
-												size_elem, ptrScratch);
+												size_elem, ptrScratch, tableReady);
 			break;
 	default:
 		ret = stm32ipl_err_UnsupportedMethod;
 		break;
 	}
 	/* free scratch buffer */
-	if (ptrScratch) {
+	if (ptrScratch != scratch) {
 		xfree(ptrScratch);
 		ptrScratch = NULL;
 	}
@@ -369,36 +447,377 @@ stm32ipl_err_t ipl_resize_roi_mve(const image_t *src,
 	return ret;
 }
 #endif
-/**
- * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, Grayscale)
- * The two images must have the same format. The destination image data buffer must be already allocated
- * by the user and its size must be large enough to contain the resized pixels.
- * The supported formats are Binary, Grayscale, RGB565, RGB888.
- * Use this function for downscale cases only.
- * @param src		Source image; it must be valid, otherwise an error is returned;
- * @param src_roi	Optional region of interest of the source image where the functions operates;
- * when defined, it must be contained in the source image and have positive dimensions, otherwise
- * an error is returned; when not defined, the whole image is considered.
- * @param dst		Destination image; its width and height must be greater than zero; it must be valid, otherwise an error is returned;
- * @param dst_roi	Optional region of interest of the destination image where the functions operates;
- * when defined, it must be contained in the destination image and have positive dimensions, otherwise
- * an error is returned; when not defined, the whole image is considered.
- * @param algo		algorithm used (RESIZE_NEAREST or RESIZE_BILINEAR)
- * @return			stm32ipl_err_Ok on success, error otherwise.
+
+///@cond
+/* Number of channels processed by the area resize for the given format. */
+#define IPL_RESIZE_AREA_CHANNELS(bpp)	((((bpp) == IMAGE_BPP_RGB565) || ((bpp) == IMAGE_BPP_RGB888)) ? 3 : 1)
+
+/* Max number of source pixels covered by a destination pixel along one axis (fractional ratio). */
+#define IPL_RESIZE_AREA_TAPS(srcW, dstW)	((((srcW) + (dstW) - 1) / (dstW)) + 1)
+
+/* Returns the size (bytes) of the scratch buffer needed by the area resize. */
+static uint32_t ipl_resize_area_scratch_size(uint32_t srcW, uint32_t srcH, uint32_t dstW, uint32_t dstH,
+		image_bpp_t bpp)
+{
+	uint32_t nCh = IPL_RESIZE_AREA_CHANNELS(bpp);
+	uint32_t size;
+
+	/* Unpacked source line and destination line accumulators. */
+	size = (((srcW * nCh * sizeof(uint16_t)) + 3) & ~3UL) + (dstW * nCh * sizeof(float));
+
+	/* Horizontal coverage table: first source pixel and weights of each destination pixel. */
+	if ((srcW % dstW) || (srcH % dstH))
+		size += dstW * (1 + IPL_RESIZE_AREA_TAPS(srcW, dstW)) * sizeof(float);
+
+	return size;
+}
+
+#ifdef IPL_RESIZE_HAS_MVE
+/* Returns true when the ratio between the source and destination sizes is supported by the MVE area resize. */
+static bool ipl_resize_area_mve_ratio(int srcSize, int dstSize)
+{
+	int ratio = srcSize / dstSize;
+
+	return ipl_mve_enabled && ((srcSize % dstSize) == 0) && ((ratio == 2) || (ratio == 4) || (ratio == 8));
+}
+#endif /* IPL_RESIZE_HAS_MVE */
+
+/* Unpacks w pixels of a source line, starting from x0, to nCh values per pixel. */
+static void ipl_resize_area_unpack(const image_t *src, int y, int x0, int w, uint16_t *line)
+{
+	switch (src->bpp) {
+		case IMAGE_BPP_BINARY: {
+			uint32_t *row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(src, y);
+			for (int x = 0; x < w; x++)
+				*line++ = IMAGE_GET_BINARY_PIXEL_FAST(row, x0 + x);
+			break;
+		}
+
+		case IMAGE_BPP_GRAYSCALE: {
+			uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y) + x0;
+			for (int x = 0; x < w; x++)
+				*line++ = row[x];
+			break;
+		}
+
+		case IMAGE_BPP_RGB565: {
+			uint16_t *row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, y) + x0;
+			for (int x = 0; x < w; x++) {
+				uint16_t pixel = row[x];
+				*line++ = COLOR_RGB565_TO_R5(pixel);
+				*line++ = COLOR_RGB565_TO_G6(pixel);
+				*line++ = COLOR_RGB565_TO_B5(pixel);
+			}
+			break;
+		}
+
+		case IMAGE_BPP_RGB888: {
+			rgb888_t *row = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(src, y) + x0;
+			for (int x = 0; x < w; x++) {
+				*line++ = row[x].r;
+				*line++ = row[x].g;
+				*line++ = row[x].b;
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+/* Packs the nCh values of the pixel x of a destination line. */
+static void ipl_resize_area_pack(image_t *dst, int y, int x, const uint32_t *value)
+{
+	switch (dst->bpp) {
+		case IMAGE_BPP_BINARY:
+			IMAGE_PUT_BINARY_PIXEL_FAST(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y), x, value[0]);
+			break;
+
+		case IMAGE_BPP_GRAYSCALE:
+			IMAGE_PUT_GRAYSCALE_PIXEL_FAST(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y), x, value[0]);
+			break;
+
+		case IMAGE_BPP_RGB565:
+			IMAGE_PUT_RGB565_PIXEL_FAST(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y), x,
+					COLOR_R5_G6_B5_TO_RGB565(value[0], value[1], value[2]));
+			break;
+
+		case IMAGE_BPP_RGB888: {
+			rgb888_t pixel;
+			pixel.r = value[0];
+			pixel.g = value[1];
+			pixel.b = value[2];
+			IMAGE_PUT_RGB888_PIXEL_FAST(IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(dst, y), x, pixel);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+/* Area resize with integer ratios: each destination pixel is the rounded mean of a kx * ky block of source pixels. */
+static void ipl_resize_area_int(const image_t *src, const rectangle_t *srcRoi, image_t *dst, const rectangle_t *dstRoi,
+		uint8_t *scratch, const ipl_resize_sink_t *sink)
+{
+	image_t outLine;
+	image_t *out = sink ? &outLine : dst;
+	int outX = sink ? 0 : dstRoi->x;
+	uint32_t nCh = IPL_RESIZE_AREA_CHANNELS(src->bpp);
+	uint32_t kx = srcRoi->w / dstRoi->w;
+	uint32_t ky = srcRoi->h / dstRoi->h;
+	uint32_t n = kx * ky;
+	uint16_t *line = (uint16_t*)scratch;
+	uint32_t *acc = (uint32_t*)(scratch + (((srcRoi->w * nCh * sizeof(uint16_t)) + 3) & ~3UL));
+
+	if (sink)
+		STM32Ipl_Init(&outLine, dstRoi->w, 1, (image_bpp_t)src->bpp, sink->line);
+
+	for (int y = 0; y < dstRoi->h; y++) {
+		memset(acc, 0, dstRoi->w * nCh * sizeof(uint32_t));
+
+		for (uint32_t i = 0; i < ky; i++) {
+			const uint16_t *in = line;
+			uint32_t *sum = acc;
+
+			ipl_resize_area_unpack(src, srcRoi->y + (y * ky) + i, srcRoi->x, srcRoi->w, line);
+
+			for (int x = 0; x < dstRoi->w; x++, sum += nCh)
+				for (uint32_t j = 0; j < kx; j++)
+					for (uint32_t ch = 0; ch < nCh; ch++)
+						sum[ch] += *in++;
+		}
+
+		for (int x = 0; x < dstRoi->w; x++) {
+			uint32_t *value = acc + (x * nCh);
+
+			for (uint32_t ch = 0; ch < nCh; ch++)
+				value[ch] = (value[ch] + (n >> 1)) / n;
+
+			ipl_resize_area_pack(out, sink ? 0 : (dstRoi->y + y), outX + x, value);
+		}
+
+		if (sink)
+			sink->put(sink, y);
+	}
+}
+
+/* Area resize with fractional ratios: each destination pixel is the mean of the source pixels it covers,
+ * weighted by the covered area. When tableReady is true, the horizontal coverage table already in the scratch
+ * buffer (computed for the same ROI sizes) is reused. */
+static void ipl_resize_area_frac(const image_t *src, const rectangle_t *srcRoi, image_t *dst, const rectangle_t *dstRoi,
+		uint8_t *scratch, bool tableReady, const ipl_resize_sink_t *sink)
+{
+	image_t outLine;
+	image_t *out = sink ? &outLine : dst;
+	int outX = sink ? 0 : dstRoi->x;
+	uint32_t nCh = IPL_RESIZE_AREA_CHANNELS(src->bpp);
+	uint32_t taps = IPL_RESIZE_AREA_TAPS(srcRoi->w, dstRoi->w);
+	float sx = (float)srcRoi->w / dstRoi->w;
+	float sy = (float)srcRoi->h / dstRoi->h;
+	float norm = 1.0f / (sx * sy);
+	uint32_t maxValue[3];
+	uint16_t *line = (uint16_t*)scratch;
+	float *acc = (float*)(scratch + (((srcRoi->w * nCh * sizeof(uint16_t)) + 3) & ~3UL));
+	uint32_t *first = (uint32_t*)(acc + (dstRoi->w * nCh));
+	float *weights = (float*)(first + dstRoi->w);
+
+	if (sink)
+		STM32Ipl_Init(&outLine, dstRoi->w, 1, (image_bpp_t)src->bpp, sink->line);
+
+	switch (src->bpp) {
+		case IMAGE_BPP_BINARY:
+			maxValue[0] = COLOR_BINARY_MAX;
+			break;
+		case IMAGE_BPP_RGB565:
+			maxValue[0] = COLOR_R5_MAX;
+			maxValue[1] = COLOR_G6_MAX;
+			maxValue[2] = COLOR_B5_MAX;
+			break;
+		default:
+			maxValue[0] = maxValue[1] = maxValue[2] = 255;
+			break;
+	}
+
+	/* Coverage of the source pixels by each destination pixel along x. */
+	for (int x = 0; (x < dstRoi->w) && !tableReady; x++) {
+		float f0 = x * sx;
+		float f1 = IM_MIN(f0 + sx, (float)srcRoi->w);
+		int i0 = (int)f0;
+
+		first[x] = i0;
+		for (uint32_t k = 0; k < taps; k++) {
+			int i = i0 + k;
+			float w = IM_MIN(f1, (float)(i + 1)) - IM_MAX(f0, (float)i);
+			weights[(x * taps) + k] = (i < srcRoi->w) ? IM_MAX(w, 0.0f) : 0.0f;
+		}
+	}
+
+	for (int y = 0; y < dstRoi->h; y++) {
+		float f0 = y * sy;
+		float f1 = IM_MIN(f0 + sy, (float)srcRoi->h);
+
+		memset(acc, 0, dstRoi->w * nCh * sizeof(float));
+
+		for (int i = (int)f0; (i < srcRoi->h) && (i < f1); i++) {
+			float wy = IM_MIN(f1, (float)(i + 1)) - IM_MAX(f0, (float)i);
+
+			ipl_resize_area_unpack(src, srcRoi->y + i, srcRoi->x, srcRoi->w, line);
+
+			for (int x = 0; x < dstRoi->w; x++) {
+				const uint16_t *in = line + (first[x] * nCh);
+				const float *wx = weights + (x * taps);
+				float *sum = acc + (x * nCh);
+
+				for (uint32_t k = 0; (k < taps) && ((first[x] + k) < (uint32_t)srcRoi->w); k++, in += nCh)
+					for (uint32_t ch = 0; ch < nCh; ch++)
+						sum[ch] += wy * wx[k] * in[ch];
+			}
+		}
+
+		for (int x = 0; x < dstRoi->w; x++) {
+			uint32_t value[3];
+
+			for (uint32_t ch = 0; ch < nCh; ch++)
+				value[ch] = IM_MIN((uint32_t)((acc[(x * nCh) + ch] * norm) + 0.5f), maxValue[ch]);
+
+			ipl_resize_area_pack(out, sink ? 0 : (dstRoi->y + y), outX + x, value);
+		}
+
+		if (sink)
+			sink->put(sink, y);
+	}
+}
+
+/* Implements the RESIZE_AREA method of STM32Ipl_Resize_Roi(). When sink is defined, each destination line is computed
+ * in its buffer and passed to it, instead of being written to the destination image. When tableReady is true, the
+ * horizontal table in the given scratch buffer has been computed by a previous call with the same ROI sizes and
+ * format, so that it is reused. */
+static stm32ipl_err_t ipl_resize_area(const image_t *src, const rectangle_t *src_roi, image_t *dst,
+		const rectangle_t *dst_roi, uint8_t *scratch, bool tableReady, const ipl_resize_sink_t *sink)
+{
+	rectangle_t srcRoi;
+	rectangle_t dstRoi;
+	uint8_t *ptrScratch;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+
+	if (!sink && (src->bpp != dst->bpp))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_RectInit(&srcRoi, 0, 0, src->w, src->h);
+	STM32Ipl_RectInit(&dstRoi, 0, 0, dst->w, dst->h);
+
+	if (src_roi) {
+		if ((src_roi->w < 1) || (src_roi->h < 1) || !STM32Ipl_RectContain(&srcRoi, src_roi))
+			return stm32ipl_err_WrongROI;
+		STM32Ipl_RectCopy(src_roi, &srcRoi);
+	}
+
+	if (dst_roi) {
+		if ((dst_roi->w < 1) || (dst_roi->h < 1) || !STM32Ipl_RectContain(&dstRoi, dst_roi))
+			return stm32ipl_err_WrongROI;
+		STM32Ipl_RectCopy(dst_roi, &dstRoi);
+	}
+
+	if ((dstRoi.w < 1) || (dstRoi.h < 1))
+		return stm32ipl_err_InvalidParameter;
+
+#ifdef IPL_RESIZE_HAS_MVE
+	/* 2x, 4x, 8x reductions of 8-bit channel data. */
+	if (!sink && ((src->bpp == IMAGE_BPP_GRAYSCALE) || (src->bpp == IMAGE_BPP_RGB888))
+			&& ipl_resize_area_mve_ratio(srcRoi.w, dstRoi.w) && ipl_resize_area_mve_ratio(srcRoi.h, dstRoi.h)
+			&& ((srcRoi.w * STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp)) <= UINT16_MAX)) {
+		uint32_t bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp);
+		uint32_t srcStride = STM32Ipl_ImageStride(src);
+		uint32_t dstStride = STM32Ipl_ImageStride(dst);
+
+		ptrScratch = scratch ? scratch : xalloc(ipl_resize_area_scratch_size(srcRoi.w, srcRoi.h, dstRoi.w,
+				dstRoi.h, (image_bpp_t)src->bpp));
+		if (!ptrScratch)
+			return stm32ipl_err_OutOfMemory;
+
+		mve_resize_area_iu8ou8_with_strides(src->data + (srcRoi.y * srcStride) + (srcRoi.x * bpp),
+				dst->data + (dstRoi.y * dstStride) + (dstRoi.x * bpp), srcStride, dstStride, dstRoi.w, dstRoi.h,
+				srcRoi.w / dstRoi.w, srcRoi.h / dstRoi.h, bpp, ptrScratch, tableReady && (ptrScratch == scratch));
+
+		if (ptrScratch != scratch)
+			xfree(ptrScratch);
+
+		STM32IPL_PERF_MVE()
+		return stm32ipl_err_Ok;
+	}
+
+	if (!ipl_mve_enabled) {
+		STM32IPL_PERF_SCALAR(Disabled)
+	} else if ((src->bpp != IMAGE_BPP_GRAYSCALE) && (src->bpp != IMAGE_BPP_RGB888)) {
+		STM32IPL_PERF_SCALAR(Format)
+	} else {
+		STM32IPL_PERF_SCALAR(Parameter)
+	}
+#else
+	STM32IPL_PERF_SCALAR(NotBuilt)
+#endif /* IPL_RESIZE_HAS_MVE */
+
+	ptrScratch = scratch ? scratch : xalloc(ipl_resize_area_scratch_size(srcRoi.w, srcRoi.h, dstRoi.w, dstRoi.h,
+			(image_bpp_t)src->bpp));
+	if (!ptrScratch)
+		return stm32ipl_err_OutOfMemory;
+
+	if ((srcRoi.w % dstRoi.w) || (srcRoi.h % dstRoi.h))
+		ipl_resize_area_frac(src, &srcRoi, dst, &dstRoi, ptrScratch, tableReady && (ptrScratch == scratch), sink);
+	else
+		ipl_resize_area_int(src, &srcRoi, dst, &dstRoi, ptrScratch, sink);
+
+	if (ptrScratch != scratch)
+		xfree(ptrScratch);
+
+	return stm32ipl_err_Ok;
+}
+///@endcond
+
+/*
+ * @brief Implements STM32Ipl_Resize_Roi() using the given scratch buffer, if any; when tableReady is true,
+ * the horizontal table in the scratch buffer has been computed by a previous call with the same ROI sizes,
+ * format and method, so that it is reused.
  */
-stm32ipl_err_t STM32Ipl_Resize_Roi(const image_t *src,
-                                   const rectangle_t *src_roi,
-                                   image_t *dst,
-                                   const rectangle_t *dst_roi,
-                                   const resize_algo_t algo)
+static stm32ipl_err_t ipl_resize_roi(const image_t *src,
+                                     const rectangle_t *src_roi,
+                                     image_t *dst,
+                                     const rectangle_t *dst_roi,
+                                     const resize_algo_t algo,
+                                     uint8_t *scratch,
+                                     bool tableReady)
 {
 	stm32ipl_err_t ret = stm32ipl_err_UnsupportedFormat;
 
 #ifdef IPL_RESIZE_HAS_MVE
-	ret = ipl_resize_roi_mve(src, src_roi, dst, dst_roi, algo);
+	ret = ipl_resize_roi_mve(src, src_roi, dst, dst_roi, algo, scratch, tableReady);
 	if (ret == stm32ipl_err_Ok) {
+		STM32IPL_PERF_MVE()
 		return ret;
 	}
+
+	/* The area method records its own path. */
+	if (RESIZE_AREA != algo) {
+		if (!ipl_mve_enabled) {
+			STM32IPL_PERF_SCALAR(Disabled)
+		} else if (ret == stm32ipl_err_OutOfMemory) {
+			STM32IPL_PERF_SCALAR(Memory)
+		} else if (ret == stm32ipl_err_UnsupportedFormat) {
+			STM32IPL_PERF_SCALAR(Format)
+		} else {
+			STM32IPL_PERF_SCALAR(Parameter)
+		}
+	}
+#else
+	(void)scratch;
+	if (RESIZE_AREA != algo) {
+		STM32IPL_PERF_SCALAR(NotBuilt)
+	}
 #endif
 
 	switch (algo) {
@@ -413,9 +832,12 @@ stm32ipl_err_t STM32Ipl_Resize_Roi(const image_t *src,
 			}
 		}
 		if (stm32ipl_err_Ok == ret) {
-			ret = ipl_resize(src, dst, src_roi);
+			ret = ipl_resize(src, dst, src_roi, NULL);
 		}
 
+		break;
+	case RESIZE_AREA:
+		ret = ipl_resize_area(src, src_roi, dst, dst_roi, scratch, tableReady, NULL);
 		break;
 	default:
 		ret = stm32ipl_err_UnsupportedMethod;
@@ -423,6 +845,316 @@ stm32ipl_err_t STM32Ipl_Resize_Roi(const image_t *src,
 	}
 	return ret;
 }
+/**
+ * @brief Resizes the source image to the destination image with Nearest Neighbor method, Bilinear method for (RGB888, RGB565, Grayscale),
+ * Area method (average of the covered source pixels, suited to downscale without aliasing)
+ * The two images must have the same format. The destination image data buffer must be already allocated
+ * by the user and its size must be large enough to contain the resized pixels.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * Use this function for downscale cases only.
+ * @param src		Source image; it must be valid, otherwise an error is returned;
+ * @param src_roi	Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param dst		Destination image; its width and height must be greater than zero; it must be valid, otherwise an error is returned;
+ * @param dst_roi	Optional region of interest of the destination image where the functions operates;
+ * when defined, it must be contained in the destination image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param algo		algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Resize_Roi(const image_t *src,
+                                   const rectangle_t *src_roi,
+                                   image_t *dst,
+                                   const rectangle_t *dst_roi,
+                                   const resize_algo_t algo)
+{
+	stm32ipl_err_t err;
+
+	STM32IPL_TRACE_BEGIN(Resize_Roi)
+	err = ipl_resize_roi(src, src_roi, dst, dst_roi, algo, NULL, false);
+	STM32IPL_TRACE_END(Resize_Roi)
+
+	return err;
+}
+
+/**
+ * @brief Gets the size of the workspace needed by STM32Ipl_Resize_Roi_WithWorkspace() for the given images and ROIs.
+ * The size is zero when the resize does not need any scratch buffer.
+ * @param src		Source image; it must be valid, otherwise an error is returned;
+ * @param src_roi	Optional region of interest of the source image; see STM32Ipl_Resize_Roi().
+ * @param dst		Destination image; it must be valid, otherwise an error is returned;
+ * @param dst_roi	Optional region of interest of the destination image; see STM32Ipl_Resize_Roi().
+ * @param algo		algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+ * @param size		Pointer to the size of the workspace (bytes); if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Resize_Roi_GetWorkspaceSize(const image_t *src,
+                                                    const rectangle_t *src_roi,
+                                                    const image_t *dst,
+                                                    const rectangle_t *dst_roi,
+                                                    const resize_algo_t algo,
+                                                    uint32_t *size)
+{
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_VALID_PTR_ARG(size)
+
+	*size = 0;
+
+	if (RESIZE_AREA == algo) {
+		rectangle_t srcRoi;
+		rectangle_t dstRoi;
+
+		STM32Ipl_RectInit(&srcRoi, 0, 0, src->w, src->h);
+		STM32Ipl_RectInit(&dstRoi, 0, 0, dst->w, dst->h);
+		if (src_roi)
+			STM32Ipl_RectCopy(src_roi, &srcRoi);
+		if (dst_roi)
+			STM32Ipl_RectCopy(dst_roi, &dstRoi);
+
+		if ((srcRoi.w > 0) && (srcRoi.h > 0) && (dstRoi.w > 0) && (dstRoi.h > 0))
+			*size = ipl_resize_area_scratch_size(srcRoi.w, srcRoi.h, dstRoi.w, dstRoi.h, (image_bpp_t)src->bpp);
+
+		return stm32ipl_err_Ok;
+	}
+
+#ifdef IPL_RESIZE_HAS_MVE
+	uint8_t size_elem = ipl_resize_mve_elem_size((image_bpp_t)src->bpp, algo);
+	if (size_elem) {
+		*size = ipl_resize_mve_scratch_size(dst_roi ? dst_roi->w : dst->w, size_elem, algo);
+	}
+#else
+	(void)src_roi;
+	(void)dst_roi;
+	(void)algo;
+#endif
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Same as STM32Ipl_Resize_Roi(), but the scratch buffers are taken from the given workspace
+ * instead of being allocated at each call.
+ * @param src			Source image; see STM32Ipl_Resize_Roi().
+ * @param src_roi		Optional region of interest of the source image; see STM32Ipl_Resize_Roi().
+ * @param dst			Destination image; see STM32Ipl_Resize_Roi().
+ * @param dst_roi		Optional region of interest of the destination image; see STM32Ipl_Resize_Roi().
+ * @param algo			algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+ * @param workspace		Workspace, 32-bit aligned; it can be null only when the needed size is zero.
+ * @param workspaceSize	Size of the workspace (bytes); it must be at least the size returned by
+ * STM32Ipl_Resize_Roi_GetWorkspaceSize(), otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Resize_Roi_WithWorkspace(const image_t *src,
+                                                 const rectangle_t *src_roi,
+                                                 image_t *dst,
+                                                 const rectangle_t *dst_roi,
+                                                 const resize_algo_t algo,
+                                                 void *workspace,
+                                                 uint32_t workspaceSize)
+{
+	uint32_t size;
+	stm32ipl_err_t ret;
+
+	ret = STM32Ipl_Resize_Roi_GetWorkspaceSize(src, src_roi, dst, dst_roi, algo, &size);
+	if (ret != stm32ipl_err_Ok)
+		return ret;
+
+	STM32IPL_CHECK_WORKSPACE(workspace, workspaceSize, size)
+
+	if ((uintptr_t)workspace & 3)
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(Resize_Roi)
+	ret = ipl_resize_roi(src, src_roi, dst, dst_roi, algo, size ? (uint8_t*)workspace : NULL, false);
+	STM32IPL_TRACE_END(Resize_Roi)
+
+	return ret;
+}
+
+/**
+ * @brief Resizes several regions of the source image, each one to the whole corresponding destination image
+ * (e.g. the objects found by STM32Ipl_DetectObject() or STM32Ipl_FindBlobs() to the input size of a classifier).
+ * The result is the same as calling STM32Ipl_Resize_Roi() for each region, but the arguments are validated
+ * once, a single scratch buffer, large enough for all the regions, is allocated from the heap and, when
+ * consecutive regions have the same size and so have their destination images, the horizontal index/weight
+ * table computed for the first one is reused by the others. The processing stops at the first error.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param src		Source image; it must be valid, otherwise an error is returned.
+ * @param rois		Array of n regions of interest of the source image; each one must be contained in the source
+ * image and have positive dimensions, otherwise an error is returned.
+ * @param n			Number of regions (and destination images); it must be greater than zero.
+ * @param dsts		Array of n destination images, with the same format of the source image; each one must be
+ * valid and have positive dimensions, otherwise an error is returned.
+ * @param algo		algorithm used (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ResizeRoiBatch(const image_t *src, const rectangle_t *rois, uint32_t n, image_t *dsts,
+		const resize_algo_t algo)
+{
+	rectangle_t srcRect;
+	uint32_t scratchSize = 0;
+	uint8_t *scratch = NULL;
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(rois)
+	STM32IPL_CHECK_VALID_PTR_ARG(dsts)
+
+	if (!n || (algo > RESIZE_AREA))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_RectInit(&srcRect, 0, 0, src->w, src->h);
+
+	/* The scratch buffer is sized for the most demanding region. */
+	for (uint32_t i = 0; i < n; i++) {
+		const image_t *dst = &dsts[i];
+		uint32_t size;
+
+		STM32IPL_CHECK_VALID_IMAGE(dst)
+		if ((dst->bpp != src->bpp) || (dst->w < 1) || (dst->h < 1))
+			return stm32ipl_err_InvalidParameter;
+
+		if ((rois[i].w < 1) || (rois[i].h < 1) || !STM32Ipl_RectContain(&srcRect, &rois[i]))
+			return stm32ipl_err_WrongROI;
+
+		res = STM32Ipl_Resize_Roi_GetWorkspaceSize(src, &rois[i], dst, NULL, algo, &size);
+		if (res != stm32ipl_err_Ok)
+			return res;
+
+		scratchSize = IM_MAX(scratchSize, size);
+	}
+
+	if (scratchSize) {
+		scratch = xalloc(scratchSize);
+		if (!scratch)
+			return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(ResizeRoiBatch)
+
+	for (uint32_t i = 0; (i < n) && (res == stm32ipl_err_Ok); i++) {
+		/* The table depends only on the sizes, the format and the method, that are the same for all the regions. */
+		bool tableReady = (i > 0) && (rois[i].w == rois[i - 1].w) && (rois[i].h == rois[i - 1].h)
+				&& (dsts[i].w == dsts[i - 1].w) && (dsts[i].h == dsts[i - 1].h);
+
+		res = ipl_resize_roi(src, &rois[i], &dsts[i], NULL, algo, scratch, tableReady);
+	}
+
+	STM32IPL_TRACE_END(ResizeRoiBatch)
+
+	if (scratch)
+		xfree(scratch);
+
+	return res;
+}
+
+///@cond
+/**
+ * Resizes the source image (whole or a portion of it) to the given size and passes the resized lines, in the
+ * source format, to the given sink, one at a time and in order, so that they can be processed on the fly.
+ * src		Source image.
+ * roi		Optional region of interest of the source image; when not defined, the whole image is considered.
+ * width	Width of the resized lines.
+ * height	Number of resized lines.
+ * algo		Resize method (RESIZE_NEAREST or RESIZE_AREA).
+ * sink		Receiver of the resized lines; its buffer must be (at least) a resized line in the source format.
+ * return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t ipl_resize_lines(const image_t *src, const rectangle_t *roi, uint16_t width, uint16_t height, int algo,
+		const ipl_resize_sink_t *sink)
+{
+	image_t dst;
+
+	/* Header giving the size of the resized image; its data are never written. */
+	STM32Ipl_Init(&dst, width, height, (image_bpp_t)src->bpp, sink->line);
+
+	switch (algo) {
+		case RESIZE_NEAREST:
+			return ipl_resize(src, &dst, roi, sink);
+
+		case RESIZE_AREA:
+			return ipl_resize_area(src, roi, &dst, NULL, NULL, false, sink);
+
+		default:
+			return stm32ipl_err_UnsupportedMethod;
+	}
+}
+
+/* Converts the resized line y to the destination image of STM32Ipl_ResizeConvert(). */
+static void ipl_resize_convert_put(const ipl_resize_sink_t *sink, int y)
+{
+	image_t *dst = (image_t*)sink->arg;
+
+	ipl_convert_line(sink->line, dst->data + (y * STM32Ipl_ImageStride(dst)), dst->w, sink->format, dst->bpp);
+}
+///@endcond
+
+/**
+ * @brief Resizes the source image (whole or a portion of it) to the destination image and converts its pixels
+ * to the format of the destination image in a single pass, without intermediate image. Each destination line is
+ * sampled to a line buffer in the source format, allocated in the internal memory (when available), and then
+ * converted to the destination line. When the two images have the same format, it is the same as
+ * STM32Ipl_Resize_Roi() without destination region of interest.
+ * The destination image data buffer must be already allocated by the user and its size must be large enough
+ * to contain the resized pixels. The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param src		Source image; it must be valid, otherwise an error is returned.
+ * @param srcRoi	Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param dst		Destination image; its width and height must be greater than zero and its data buffer must be
+ * different from the source one; it must be valid, otherwise an error is returned.
+ * @param algo		algorithm used (RESIZE_NEAREST or RESIZE_AREA; RESIZE_BILINEAR only when the two images have
+ * the same format).
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_ResizeConvert(const image_t *src, const rectangle_t *srcRoi, image_t *dst,
+		const resize_algo_t algo)
+{
+	ipl_resize_sink_t sink;
+	uint32_t lineSize;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_FORMAT(dst, STM32IPL_IF_ALL)
+
+	if ((dst->w < 1) || (dst->h < 1) || (src->data == dst->data))
+		return stm32ipl_err_InvalidParameter;
+
+	if (src->bpp == dst->bpp) {
+		STM32IPL_TRACE_BEGIN(ResizeConvert)
+		res = ipl_resize_roi(src, srcRoi, dst, NULL, algo, NULL, false);
+		STM32IPL_TRACE_END(ResizeConvert)
+		return res;
+	}
+
+	if ((RESIZE_NEAREST != algo) && (RESIZE_AREA != algo))
+		return stm32ipl_err_UnsupportedMethod;
+
+	lineSize = STM32Ipl_DataSize(dst->w, 1, (image_bpp_t)src->bpp);
+	if (fb_avail() < FB_ALLOC_SPACE(lineSize))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(ResizeConvert)
+
+	sink.line = fb_alloc(lineSize, FB_ALLOC_PREFER_SPEED);
+	sink.format = src->bpp;
+	sink.put = ipl_resize_convert_put;
+	sink.arg = dst;
+
+	res = ipl_resize_lines(src, srcRoi, dst->w, dst->h, algo, &sink);
+
+	fb_free();
+
+	STM32IPL_TRACE_END(ResizeConvert)
+
+	return res;
+}
+
 /**
  * @brief Resizes (downscale only) the source image to the destination image with Nearest Neighbor method.
  * The two images must have the same format. The destination image data buffer must be already allocated
@@ -450,6 +1182,7 @@ stm32ipl_err_t STM32Ipl_Downscale(const image_t *src, image_t *dst, bool reverse
 	if ((dst->w < 1) || (dst->h < 1))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(Downscale)
 	dstW = dst->w;
 	dstH = dst->h;
 
@@ -504,6 +1237,7 @@ stm32ipl_err_t STM32Ipl_Downscale(const image_t *src, image_t *dst, bool reverse
 				break;
 
 			default:
+				STM32IPL_TRACE_END(Downscale)
 				return stm32ipl_err_UnsupportedFormat;
 		}
 	} else {
@@ -554,10 +1288,12 @@ stm32ipl_err_t STM32Ipl_Downscale(const image_t *src, image_t *dst, bool reverse
 				break;
 
 			default:
+				STM32IPL_TRACE_END(Downscale)
 				return stm32ipl_err_UnsupportedFormat;
 		}
 	}
 
+	STM32IPL_TRACE_END(Downscale)
 	return stm32ipl_err_Ok;
 }
 
@@ -18,11 +18,201 @@
 
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
+#include "matd.h"
+#ifdef IPL_ROTATION_HAS_MVE
+#include "mve_rotation.h"
+#endif /* IPL_ROTATION_HAS_MVE */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+///@cond
+/* Size (pixels) of the square blocks in which the transposed images are processed, so that both the source and the
+ * destination lines touched by a block stay in the data cache. */
+#define IPL_ROTATION_BLOCK	32
+
+/* Copies n pixels of a source column (srcStride bytes apart, negative to read it upwards) to a destination row. */
+static void ipl_rotation_column(const uint8_t *src, int32_t srcStride, uint8_t *dst, int n, uint32_t bpp)
+{
+#ifdef IPL_ROTATION_HAS_MVE
+	if (bpp == 1)
+		mve_rotation_column_u8(src, srcStride, dst, n);
+	else
+	if (bpp == 2)
+		mve_rotation_column_u16(src, srcStride, dst, n);
+	else
+		mve_rotation_column_rgb888(src, srcStride, dst, n);
+#else
+	if (bpp == 1) {
+		for (; n > 0; n--, src += srcStride)
+			*dst++ = *src;
+	} else
+	if (bpp == 2) {
+		for (; n > 0; n--, src += srcStride, dst += 2)
+			*(uint16_t*)dst = *(const uint16_t*)src;
+	} else {
+		for (; n > 0; n--, src += srcStride) {
+			*dst++ = src[0];
+			*dst++ = src[1];
+			*dst++ = src[2];
+		}
+	}
+#endif /* IPL_ROTATION_HAS_MVE */
+}
+
+/* Copies n pixels of a source row to a destination row in reverse order. */
+static void ipl_rotation_reverse(const uint8_t *src, uint8_t *dst, int n, uint32_t bpp)
+{
+#ifdef IPL_ROTATION_HAS_MVE
+	if (bpp == 1)
+		mve_rotation_reverse_u8(src, dst, n);
+	else
+	if (bpp == 2)
+		mve_rotation_reverse_u16(src, dst, n);
+	else
+		mve_rotation_reverse_rgb888(src, dst, n);
+#else
+	src += n * bpp;
+
+	if (bpp == 1) {
+		while (n-- > 0)
+			*dst++ = *--src;
+	} else
+	if (bpp == 2) {
+		for (; n > 0; n--, dst += 2) {
+			src -= 2;
+			*(uint16_t*)dst = *(const uint16_t*)src;
+		}
+	} else {
+		for (; n > 0; n--) {
+			src -= 3;
+			*dst++ = src[0];
+			*dst++ = src[1];
+			*dst++ = src[2];
+		}
+	}
+#endif /* IPL_ROTATION_HAS_MVE */
+}
+
+/* Mirrors, flips and transposes src into dst (whose header has already the final resolution). Without transposition,
+ * each destination line is a (reversed) copy of a source line; with transposition, each destination line is a source
+ * column, and the image is processed in square blocks, as reading a whole column would touch every source line. */
+static void ipl_replace(const image_t *src, image_t *dst, bool mirror, bool flip, bool transpose)
+{
+	uint32_t bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp);
+	int32_t srcStride = STM32Ipl_ImageStride(src);
+	int32_t dstStride = STM32Ipl_ImageStride(dst);
+	int w = src->w;
+	int h = src->h;
+
+	if (!transpose) {
+		for (int y = 0; y < h; y++) {
+			const uint8_t *srcRow = src->data + ((flip ? (h - 1 - y) : y) * srcStride);
+			uint8_t *dstRow = dst->data + (y * dstStride);
+
+			if (mirror)
+				ipl_rotation_reverse(srcRow, dstRow, w, bpp);
+			else
+				memcpy(dstRow, srcRow, w * bpp);
+		}
+
+		return;
+	}
+
+	/* The destination line y is the source column (mirror ? w - 1 - y : y), read upwards when flip is set. */
+	for (int by = 0; by < w; by += IPL_ROTATION_BLOCK) {
+		int ey = IM_MIN(by + IPL_ROTATION_BLOCK, w);
+
+		for (int bx = 0; bx < h; bx += IPL_ROTATION_BLOCK) {
+			int n = IM_MIN(IPL_ROTATION_BLOCK, h - bx);
+			int ys = flip ? (h - 1 - bx) : bx;
+
+			for (int y = by; y < ey; y++) {
+				int xs = mirror ? (w - 1 - y) : y;
+
+				ipl_rotation_column(src->data + (ys * srcStride) + (xs * bpp), flip ? -srcStride : srcStride,
+						dst->data + (y * dstStride) + (bx * bpp), n, bpp);
+			}
+		}
+	}
+}
+/* Parameters of a compiled lens correction (see imlib_lens_corr()). */
+typedef struct
+{
+	int w;
+	int h;
+	int halfW;
+	int halfH;
+	int rightAdj;
+	int leftAdj;
+	int downAdj;
+	int upAdj;
+	const float *table;	/* Scale factor of the distance from the center, for each integer distance. */
+	bool nearest;
+} ipl_lens_corr_map_t;
+
+/* Parameters of a compiled rotation correction (see imlib_rotation_corr()). */
+typedef struct
+{
+	int w;
+	int h;
+	float t[9];			/* Destination to source transform. */
+	bool affine;
+	bool nearest;
+} ipl_rotation_corr_map_t;
+
+/* Converts the source location (sx, sy) to 1/16 pixel units; returns false if its nearest pixel is out of the image. */
+static bool ipl_map_location(float sx, float sy, int w, int h, bool nearest, int32_t *xq, int32_t *yq)
+{
+	int x = fast_roundf(sx);
+	int y = fast_roundf(sy);
+
+	if ((x < 0) || (x >= w) || (y < 0) || (y >= h))
+		return false;
+
+	*xq = nearest ? (x * 16) : fast_roundf(sx * 16);
+	*yq = nearest ? (y * 16) : fast_roundf(sy * 16);
+
+	return true;
+}
+
+/* Source location of the lens correction; the four quadrants mirror the distances from the center of the top-left
+ * one, as imlib_lens_corr() does, so that the nearest neighbor result is the same. */
+static bool ipl_lens_corr_location(void *arg, int x, int y, int32_t *xq, int32_t *yq)
+{
+	const ipl_lens_corr_map_t *map = (const ipl_lens_corr_map_t*)arg;
+	int nx = (x < map->halfW) ? (x - map->halfW) : (map->w - 1 - x - map->halfW);
+	int ny = (y < map->halfH) ? (y - map->halfH) : (map->h - 1 - y - map->halfH);
+	float scale = map->table[(int)fast_sqrtf((nx * nx) + (ny * ny))];
+	float sx = map->nearest ? fast_roundf(scale * nx) : (scale * nx);
+	float sy = map->nearest ? fast_roundf(scale * ny) : (scale * ny);
+
+	sx = (x < map->halfW) ? (map->rightAdj + sx) : (map->leftAdj - sx);
+	sy = (y < map->halfH) ? (map->downAdj + sy) : (map->upAdj - sy);
+
+	return ipl_map_location(sx, sy, map->w, map->h, map->nearest, xq, yq);
+}
+
+/* Source location of the rotation correction. */
+static bool ipl_rotation_corr_location(void *arg, int x, int y, int32_t *xq, int32_t *yq)
+{
+	const ipl_rotation_corr_map_t *map = (const ipl_rotation_corr_map_t*)arg;
+	const float *t = map->t;
+	float sx = (t[0] * x) + (t[1] * y) + t[2];
+	float sy = (t[3] * x) + (t[4] * y) + t[5];
+
+	if (!map->affine) {
+		float sz = (t[6] * x) + (t[7] * y) + t[8];
+
+		sx /= sz;
+		sy /= sz;
+	}
+
+	return ipl_map_location(sx, sy, map->w, map->h, map->nearest, xq, yq);
+}
+///@endcond
+
 /**
  * @brief Corrects (in-place) perspective issues in an image by doing a 3D rotation.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
@@ -44,6 +234,8 @@ extern "C" {
  * 						(image_width-1, 0), the third corner to (image_width-1, image_height-1), and the fourth corner to (0, image_height-1).
  * 						The 3D rotation is then applied after the image is re-mapped. *
  * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @note When the same correction is applied to every frame, STM32Ipl_RotationCompileMap() and STM32Ipl_Dewarp() are
+ * faster.
  */
 stm32ipl_err_t STM32Ipl_Rotation(image_t *img, float rotationX, float rotationY, float rotationZ, float translationX,
 		float translationY, float zoom, float fov, const float *corners)
@@ -54,16 +246,75 @@ stm32ipl_err_t STM32Ipl_Rotation(image_t *img, float rotationX, float rotationY,
 	if ((fov <= 0) || (fov >= 180) || (zoom <= 0))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(Rotation)
 	imlib_rotation_corr(img, rotationX, rotationY, rotationZ, translationX, translationY, zoom, fov, (float*)corners);
 
+	STM32IPL_TRACE_END(Rotation)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Compiles the 3D rotation correction of STM32Ipl_Rotation() into a dewarping map, to be used with
+ * STM32Ipl_Dewarp() through a mapxy of type MAPXY_COMPILED: the transform is computed once, instead of at every frame,
+ * and the per pixel projection is replaced by the compiled offsets. With DEWARP_NEAREST, the result is the same
+ * of STM32Ipl_Rotation() (but not in-place); with DEWARP_BILINEAR, the source is interpolated (1/16 pixel precision).
+ * The destination pixels whose source is out of the image are left unchanged by STM32Ipl_Dewarp(), while
+ * STM32Ipl_Rotation() zeroes them: as they are the same for every frame, it is enough to zero the destination
+ * image once.
+ * The data buffers must be released with STM32Ipl_DewarpReleaseMap().
+ * @param width			Width of the images to be corrected.
+ * @param height		Height of the images to be corrected.
+ * @param format		Format of the images to be corrected: Grayscale, RGB565, RGB888.
+ * @param rotationX		Rotation around the X axis (see STM32Ipl_Rotation()).
+ * @param rotationY		Rotation around the Y axis (see STM32Ipl_Rotation()).
+ * @param rotationZ		Rotation around the Z axis (see STM32Ipl_Rotation()).
+ * @param translationX	Horizontal translation after rotation (see STM32Ipl_Rotation()).
+ * @param translationY	Vertical translation after rotation (see STM32Ipl_Rotation()).
+ * @param zoom			Zoom ratio (1.0f by default).
+ * @param fov			FOV; it must be > 0 and < 180 (see STM32Ipl_Rotation()).
+ * @param corners		Optional array of 8 float values, the four corners of the 4-point correspondence homography
+ * 						(see STM32Ipl_Rotation()).
+ * @param algo			Interpolation algorithm; the compiled map can be used only with it.
+ * @param compiled		Compiled map.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_InvalidParameter if the transform is not invertible,
+ * 						error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_RotationCompileMap(uint32_t width, uint32_t height, image_bpp_t format, float rotationX,
+		float rotationY, float rotationZ, float translationX, float translationY, float zoom, float fov,
+		const float *corners, dewarping_algo_t algo, mapxy_compiled_t *compiled)
+{
+	ipl_rotation_corr_map_t map;
+
+	if ((fov <= 0) || (fov >= 180) || (zoom <= 0) || !width || !height || (width > UINT16_MAX)
+			|| (height > UINT16_MAX))
+		return stm32ipl_err_InvalidParameter;
+
+	if (!imlib_rotation_corr_transform(width, height, rotationX, rotationY, rotationZ, translationX, translationY, zoom,
+			fov, (float*)corners, map.t))
+		return stm32ipl_err_InvalidParameter;
+
+	map.w = width;
+	map.h = height;
+	map.nearest = (algo == DEWARP_NEAREST);
+	map.affine = (fast_fabsf(map.t[6]) < MATD_EPS) && (fast_fabsf(map.t[7]) < MATD_EPS);
+	if (map.affine) {
+		for (int i = 0; i < 6; i++)
+			map.t[i] /= map.t[8];
+	}
+
+	return ipl_dewarp_compile_generated(ipl_rotation_corr_location, &map, width, height, format, algo, compiled);
+}
+
 /**
  * @brief Transforms the source image into the destination image by using the given transformation parameters.
- * The two images must have same format and size. The destination image must be valid and its data memory
- * already allocated by the caller. The supported formats (for source, destination and mask images) are
- * Binary, Grayscale, RGB565, RGB888.
+ * The two images must have same format and size; when transposing, the destination image can also have the
+ * transposed size (the header of the destination image is anyway set to the transposed size). The destination image
+ * must be valid and its data memory already allocated by the caller. The supported formats (for source, destination
+ * and mask images) are Binary, Grayscale, RGB565, RGB888.
+ * Without mask, Grayscale, RGB565 and RGB888 images are processed line by line (or, when transposing, in blocks of
+ * 32x32 pixels, to limit the cache misses on the images stored in the external memory).
+ * Binary rows are word aligned, so, when transposing a Binary image, the data memory of the destination image must be
+ * large enough for the transposed image, otherwise an error is returned.
  * @param src		Source image; if it is not valid, an error is returned.
  * @param dst		Destination image; if it is not valid, an error is returned.
  * @param mirror	True to horizontally mirror the replacing image.
@@ -77,11 +328,22 @@ stm32ipl_err_t STM32Ipl_Rotation(image_t *img, float rotationX, float rotationY,
 stm32ipl_err_t STM32Ipl_Replace(const image_t *src, image_t *dst, bool mirror, bool flip, bool transpose,
 		const image_t *mask)
 {
+	bool transposed;
+
 	STM32IPL_CHECK_VALID_IMAGE(src)
 	STM32IPL_CHECK_VALID_IMAGE(dst)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_SAME_FORMAT(src, dst)
-	STM32IPL_CHECK_SAME_SIZE(src, dst)
+
+	/* The destination can already have the transposed size. */
+	transposed = transpose && (src->w != src->h) && (dst->w == src->h) && (dst->h == src->w);
+	if (!transposed) {
+		STM32IPL_CHECK_SAME_SIZE(src, dst)
+	}
+
+	/* Binary rows are word aligned: the transposed image may need more memory than the source one. */
+	if (transpose && (STM32Ipl_DataSize(src->h, src->w, (image_bpp_t)dst->bpp) > STM32Ipl_DataSize(dst->w, dst->h, (image_bpp_t)dst->bpp)))
+		return stm32ipl_err_InvalidParameter;
 
 	if (mask) {
 		STM32IPL_CHECK_VALID_IMAGE(mask)
@@ -89,8 +351,23 @@ stm32ipl_err_t STM32Ipl_Replace(const image_t *src, image_t *dst, bool mirror, b
 		STM32IPL_CHECK_SAME_SIZE(src, mask)
 	}
 
-	imlib_replace((image_t*)src, NULL, dst, 0, mirror, flip, transpose, (image_t*)mask);
+	STM32IPL_TRACE_BEGIN(Replace)
+
+	if (mask || (src->bpp == IMAGE_BPP_BINARY) || (src->data == dst->data)) {
+		if (transposed) {
+			dst->w = src->w;
+			dst->h = src->h;
+		}
+
+		/* imlib_replace() replaces the first image with the second one and transposes the header of the first one. */
+		imlib_replace(dst, NULL, (image_t*)src, 0, mirror, flip, transpose, (image_t*)mask);
+	} else {
+		dst->w = transpose ? src->h : src->w;
+		dst->h = transpose ? src->w : src->h;
+		ipl_replace(src, dst, mirror, flip, transpose);
+	}
 
+	STM32IPL_TRACE_END(Replace)
 	return stm32ipl_err_Ok;
 }
 
@@ -138,7 +415,8 @@ stm32ipl_err_t STM32Ipl_FlipMirror(const image_t *src, image_t *dst)
 
 /**
  * @brief Rotates (clockwise) the source image by 90 degrees into the destination image.
- * The two images must have same format and resolution.
+ * The two images must have same format and either the same or the rotated resolution; the header of the
+ * destination image is set to the rotated resolution.
  * The destination image must be valid and its data memory already allocated by the caller.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param src	Source image; if it is not valid, an error is returned.
@@ -166,7 +444,8 @@ stm32ipl_err_t STM32Ipl_Rotation180(const image_t *src, image_t *dst)
 
 /**
  * @brief Rotates (clockwise) the source image by 270 degrees into the destination image.
- * The two images must have same format and resolution.
+ * The two images must have same format and either the same or the rotated resolution; the header of the
+ * destination image is set to the rotated resolution.
  * The destination image must be valid and its data memory already allocated by the caller.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param src	Source image; if it is not valid, an error is returned.
@@ -188,6 +467,8 @@ stm32ipl_err_t STM32Ipl_Rotation270(const image_t *src, image_t *dst)
  * @param yCorr		Pixel offset from center; it can be negative or positive.
  * @return 			stm32ipl_err_Ok on success, error otherwise.
  * @note 			Image's width and height must be even numbers.
+ * @note When the same correction is applied to every frame, STM32Ipl_LensCorrCompileMap() and STM32Ipl_Dewarp() are
+ * faster.
  */
 stm32ipl_err_t STM32Ipl_LensCorr(image_t *img, float strength, float zoom, float xCorr, float yCorr)
 {
@@ -197,11 +478,82 @@ stm32ipl_err_t STM32Ipl_LensCorr(image_t *img, float strength, float zoom, float
 	if ((strength <= 0) || (zoom <= 0) || ((img->w % 2) != 0) || ((img->h % 2) != 0))
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(LensCorr)
 	imlib_lens_corr(img, strength, zoom, xCorr, yCorr);
 
+	STM32IPL_TRACE_END(LensCorr)
 	return stm32ipl_err_Ok;
 }
 
+/**
+ * @brief Compiles the lens correction of STM32Ipl_LensCorr() into a dewarping map, to be used with STM32Ipl_Dewarp()
+ * through a mapxy of type MAPXY_COMPILED: the radial mapping is computed once, instead of per pixel at every frame.
+ * With DEWARP_NEAREST, the result is the same of STM32Ipl_LensCorr() (but not in-place); with DEWARP_BILINEAR, the
+ * source is interpolated (1/16 pixel precision).
+ * The destination pixels whose source is out of the image are left unchanged by STM32Ipl_Dewarp(), while
+ * STM32Ipl_LensCorr() zeroes them: as they are the same for every frame, it is enough to zero the destination
+ * image once.
+ * The data buffers must be released with STM32Ipl_DewarpReleaseMap().
+ * @param width		Width of the images to be corrected; it must be an even number.
+ * @param height	Height of the images to be corrected; it must be an even number.
+ * @param format	Format of the images to be corrected: Grayscale, RGB565, RGB888.
+ * @param strength	Defines how much to un-fisheye the image (see STM32Ipl_LensCorr()).
+ * @param zoom		Amount to zoom in on the image by. The value must be > 0.
+ * @param xCorr		Pixel offset from center; it can be negative or positive.
+ * @param yCorr		Pixel offset from center; it can be negative or positive.
+ * @param algo		Interpolation algorithm; the compiled map can be used only with it.
+ * @param compiled	Compiled map.
+ * @return 			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_LensCorrCompileMap(uint32_t width, uint32_t height, image_bpp_t format, float strength,
+		float zoom, float xCorr, float yCorr, dewarping_algo_t algo, mapxy_compiled_t *compiled)
+{
+	ipl_lens_corr_map_t map;
+	float maxDiameter;
+	float diameterScale;
+	float invZoom;
+	int maxRadius;
+	float *table;
+	stm32ipl_err_t ret;
+
+	if ((strength <= 0) || (zoom <= 0) || !width || !height || ((width % 2) != 0) || ((height % 2) != 0)
+			|| (width > UINT16_MAX) || (height > UINT16_MAX))
+		return stm32ipl_err_InvalidParameter;
+
+	/* Same table of imlib_lens_corr(). */
+	maxDiameter = fast_sqrtf((width * width) + (height * height));
+	diameterScale = strength / maxDiameter;
+	maxRadius = fast_ceilf(maxDiameter / 2) + 1;
+	invZoom = 1 / zoom;
+
+	table = xalloc(maxRadius * sizeof(float));
+	if (!table)
+		return stm32ipl_err_OutOfMemory;
+
+	for (int i = 1; i < maxRadius; i++) {
+		float r = diameterScale * i;
+		table[i] = (fast_atanf(r) / r) * invZoom;
+	}
+	table[0] = invZoom;
+
+	map.w = width;
+	map.h = height;
+	map.halfW = width / 2;
+	map.halfH = height / 2;
+	map.rightAdj = map.halfW + (int)(width * xCorr);
+	map.leftAdj = width - 1 - map.halfW + (int)(width * xCorr);
+	map.downAdj = map.halfH + (int)(height * yCorr);
+	map.upAdj = height - 1 - map.halfH + (int)(height * yCorr);
+	map.table = table;
+	map.nearest = (algo == DEWARP_NEAREST);
+
+	ret = ipl_dewarp_compile_generated(ipl_lens_corr_location, &map, width, height, format, algo, compiled);
+
+	xfree(table);
+
+	return ret;
+}
+
 #ifdef __cplusplus
 }
 #endif
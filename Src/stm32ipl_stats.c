@@ -129,6 +129,7 @@ stm32ipl_err_t STM32Ipl_GetHistogram(const image_t *img, histogram_t *out, const
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_VALID_PTR_ARG(out)
 	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_TRACE_BEGIN(GetHistogram)
 
 	STM32Ipl_HistInit(out);
 
@@ -154,16 +155,22 @@ stm32ipl_err_t STM32Ipl_GetHistogram(const image_t *img, histogram_t *out, const
 		}
 
 		default: {
+			STM32IPL_TRACE_END(GetHistogram)
 			return stm32ipl_err_InvalidParameter;
 		}
 	}
 
-	STM32Ipl_HistAllocData(out, lCount, aCount, bCount);
+	if (STM32Ipl_HistAllocData(out, lCount, aCount, bCount) != stm32ipl_err_Ok) {
+		list_free(&thresholds);
+		STM32IPL_TRACE_END(GetHistogram)
+		return stm32ipl_err_OutOfMemory;
+	}
 
 	imlib_get_histogram(out, (image_t*)img, &realRoi, &thresholds, invert, other);
 
 	list_free(&thresholds);
 
+	STM32IPL_TRACE_END(GetHistogram)
 	return stm32ipl_err_Ok;
 }
 
@@ -187,6 +194,7 @@ stm32ipl_err_t STM32Ipl_GetPercentile(const histogram_t *hist, image_bpp_t forma
 		return stm32ipl_err_InvalidParameter;
 
 	img.bpp = format;
+	img.stride = 0;
 
 	STM32IPL_CHECK_FORMAT(&img, STM32IPL_IF_ALL)
 
@@ -217,6 +225,7 @@ stm32ipl_err_t STM32Ipl_GetThreshold(const histogram_t *hist, image_bpp_t format
 		return stm32ipl_err_InvalidParameter;
 
 	img.bpp = format;
+	img.stride = 0;
 
 	STM32IPL_CHECK_FORMAT(&img, STM32IPL_IF_ALL)
 
@@ -244,25 +253,66 @@ stm32ipl_err_t STM32Ipl_GetThreshold(const histogram_t *hist, image_bpp_t format
 stm32ipl_err_t STM32Ipl_GetSimilarity(const image_t *img, const image_t *other, stm32ipl_color_t color, float *avg,
 		float *std, float *min, float *max)
 {
-	uint32_t newColor = 0;
-
-	STM32IPL_CHECK_VALID_IMAGE(img)
-	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_VALID_PTR_ARG(avg)
 	STM32IPL_CHECK_VALID_PTR_ARG(std)
 	STM32IPL_CHECK_VALID_PTR_ARG(min)
 	STM32IPL_CHECK_VALID_PTR_ARG(max)
 
+	return STM32Ipl_GetSimilarityEx(img, other, color, avg, std, min, max, NULL);
+}
+
+/**
+ * @brief Same as STM32Ipl_GetSimilarity(), but it can also return the SSIM of each 8x8 pixel block, so that the
+ * regions that did not change can be told apart from the ones that did; the statistics are optional.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		First image; if it is not valid, an error is returned.
+ * @param other		Second image (optional); see STM32Ipl_GetSimilarity().
+ * @param color 	See STM32Ipl_GetSimilarity().
+ * @param avg		Optional average similarity among the image blocks.
+ * @param std		Optional standard deviation among the image blocks.
+ * @param min		Optional minimum value among the image blocks.
+ * @param max		Optional maximum value among the image blocks.
+ * @param map		Optional per-block similarity; it must have ((width + 7) / 8) * ((height + 7) / 8) elements,
+ * the blocks are stored by rows, the right and bottom ones can be smaller than 8x8 pixels.
+ * @return	stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetSimilarityEx(const image_t *img, const image_t *other, stm32ipl_color_t color, float *avg,
+		float *std, float *min, float *max, float *map)
+{
+	uint32_t newColor = 0;
+	float avgValue;
+	float stdValue;
+	float minValue;
+	float maxValue;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+
 	/* Alternatively use the other image or the color value to be added to the source image. */
 	if (other) {
 		STM32IPL_CHECK_VALID_IMAGE(other)
 		STM32IPL_CHECK_SAME_HEADER(img, other)
 	} else {
-		newColor = STM32Ipl_AdaptColor(img, newColor);
+		newColor = STM32Ipl_AdaptColor(img, color);
 	}
 
-	imlib_get_similarity((image_t*)img, NULL, (image_t*)other, newColor, avg, std, min, max);
+	STM32IPL_TRACE_BEGIN(GetSimilarity)
+	imlib_get_similarity((image_t*)img, NULL, (image_t*)other, newColor, &avgValue, &stdValue, &minValue, &maxValue,
+			map);
+
+	if (avg)
+		*avg = avgValue;
 
+	if (std)
+		*std = stdValue;
+
+	if (min)
+		*min = minValue;
+
+	if (max)
+		*max = maxValue;
+
+	STM32IPL_TRACE_END(GetSimilarity)
 	return stm32ipl_err_Ok;
 }
 
@@ -286,15 +336,159 @@ stm32ipl_err_t STM32Ipl_GetStatistics(const image_t *img, statistics_t *out, con
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
 	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_TRACE_BEGIN(GetStatistics)
 
 	error = STM32Ipl_GetHistogram(img, &hist, roi);
-	if (error != stm32ipl_err_Ok)
+	if (error != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(GetStatistics)
 		return error;
+	}
 
 	imlib_get_statistics(out, (image_bpp_t)img->bpp, &hist);
 
 	STM32Ipl_HistReleaseData(&hist);
 
+	STM32IPL_TRACE_END(GetStatistics)
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Gets the LAB histogram, the statistics and the Otsu thresholds of an image scanning the image only once:
+ * the statistics and the thresholds are derived from the histogram. The results are the same as those of
+ * STM32Ipl_GetHistogram(), STM32Ipl_GetStatistics() and STM32Ipl_GetThreshold(), called in sequence.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param hist		Optional resulting LAB histogram; when given, this function allocates its memory buffers and it is
+ * up to the caller to release them with STM32Ipl_HistReleaseData().
+ * @param stats		Optional resulting statistics for each histogram channel.
+ * @param threshold	Optional resulting Otsu thresholds for each histogram channel.
+ * @param roi		Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetHistogramStatistics(const image_t *img, histogram_t *hist, statistics_t *stats,
+		threshold_t *threshold, const rectangle_t *roi)
+{
+	histogram_t localHist;
+	histogram_t *h = hist ? hist : &localHist;
+	stm32ipl_err_t error;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
+	STM32IPL_TRACE_BEGIN(GetHistogramStatistics)
+
+	error = STM32Ipl_GetHistogram(img, h, roi);
+	if (error != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(GetHistogramStatistics)
+		return error;
+	}
+
+	if (stats)
+		imlib_get_statistics(stats, (image_bpp_t)img->bpp, h);
+
+	if (threshold)
+		imlib_get_threshold(threshold, (image_bpp_t)img->bpp, h);
+
+	if (!hist)
+		STM32Ipl_HistReleaseData(&localHist);
+
+	STM32IPL_TRACE_END(GetHistogramStatistics)
+	return stm32ipl_err_Ok;
+}
+
+/* Largest ROI (pixels) whose sum of squared values surely fits 32 bits, so that it can be read from the squared
+ * integral image: the wrap-around of its values cancels out in the lookup. */
+#define STM32IPL_ROI_STATS_MAX_SQ_AREA	(UINT32_MAX / (COLOR_GRAYSCALE_MAX * COLOR_GRAYSCALE_MAX))
+
+/* Sum of the squared pixel values of a ROI, computed directly on the image. */
+static uint64_t stm32ipl_roi_sum_sq(const image_t *img, const rectangle_t *roi)
+{
+	uint64_t sumSq = 0;
+
+	for (int y = roi->y; y < roi->y + roi->h; y++) {
+		uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+		uint32_t rowSq = 0;
+		for (int x = roi->x; x < roi->x + roi->w; x++)
+			rowSq += row[x] * row[x];
+		sumSq += rowSq;
+	}
+
+	return sumSq;
+}
+
+/**
+ * @brief Gets sum, mean and variance of the pixels of many regions of interest of an image. The integral image
+ * and the squared integral image are computed once, in a single pass on the image, then the results of each
+ * region are read with four lookups, whatever its size: this is much faster than calling STM32Ipl_GetStatistics()
+ * for each region.
+ * The two integral images are allocated and released by this function and need (2 * width * height * 4) bytes.
+ * The supported format is Grayscale.
+ * @param img		Image; if it is not valid, an error is returned.
+ * @param rois		Regions of interest; each of them must be contained in the image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param n			Number of regions of interest.
+ * @param out		Resulting statistics, one for each region of interest; if it is not valid, an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetRoiStatsBatch(const image_t *img, const rectangle_t *rois, uint32_t n,
+		stm32ipl_roi_stats_t *out)
+{
+	rectangle_t fullRoi;
+	i_image_t ii;
+	i_image_t iiSq;
+	stm32ipl_err_t error;
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(img)
+	STM32IPL_CHECK_VALID_PTR_ARG(rois)
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+
+	STM32Ipl_RectInit(&fullRoi, 0, 0, img->w, img->h);
+	for (uint32_t i = 0; i < n; i++) {
+		if ((rois[i].w <= 0) || (rois[i].h <= 0) || !STM32Ipl_RectContain(&fullRoi, &rois[i]))
+			return stm32ipl_err_InvalidParameter;
+	}
+
+	STM32IPL_TRACE_BEGIN(GetRoiStatsBatch)
+
+	error = STM32Ipl_IIAllocData(&ii, img->w, img->h);
+	if (error != stm32ipl_err_Ok) {
+		STM32IPL_TRACE_END(GetRoiStatsBatch)
+		return error;
+	}
+
+	error = STM32Ipl_IIAllocData(&iiSq, img->w, img->h);
+	if (error != stm32ipl_err_Ok) {
+		STM32Ipl_IIReleaseData(&ii);
+		STM32IPL_TRACE_END(GetRoiStatsBatch)
+		return error;
+	}
+
+	imlib_integral_image_ss((image_t*)img, &ii, &iiSq);
+
+	for (uint32_t i = 0; i < n; i++) {
+		const rectangle_t *roi = &rois[i];
+		uint32_t area = roi->w * roi->h;
+		uint32_t sum = imlib_integral_lookup(&ii, roi->x, roi->y, roi->w, roi->h);
+		uint64_t sumSq;
+
+		if (area <= STM32IPL_ROI_STATS_MAX_SQ_AREA)
+			sumSq = imlib_integral_lookup(&iiSq, roi->x, roi->y, roi->w, roi->h);
+		else
+			sumSq = stm32ipl_roi_sum_sq(img, roi);
+
+		/* variance = (area * sumSq - sum^2) / area^2, exact up to the final division. */
+		out[i].sum = sum;
+		out[i].mean = (float)sum / area;
+		out[i].variance = (float)(((uint64_t)area * sumSq) - ((uint64_t)sum * sum)) / ((float)area * area);
+	}
+
+	STM32Ipl_IIReleaseData(&iiSq);
+	STM32Ipl_IIReleaseData(&ii);
+
+	STM32IPL_TRACE_END(GetRoiStatsBatch)
 	return stm32ipl_err_Ok;
 }
 
@@ -336,11 +530,15 @@ stm32ipl_err_t STM32Ipl_GetRegressionImage(const image_t *img, find_lines_list_l
 	if (list_size((list_t*)thresholds) == 0)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(GetRegressionImage)
 	res = imlib_get_regression(out, (image_t*)img, &realRoi, xStride, yStride, (list_t*)thresholds, invert,
 			areaThreshold, pixelsThreshold, robust);
-	if (res)
+	if (res) {
+		STM32IPL_TRACE_END(GetRegressionImage)
 		return stm32ipl_err_Ok;
+	}
 
+	STM32IPL_TRACE_END(GetRegressionImage)
 	return stm32ipl_err_OpNotCompleted;
 }
 
@@ -361,8 +559,10 @@ stm32ipl_err_t STM32Ipl_GetMean(const image_t *img, int32_t *outR, int32_t *outG
 	if (!outR || !outG || !outB)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(GetMean)
 	imlib_image_mean((image_t*)img, (int*)outR, (int*)outG, (int*)outB);
 
+	STM32IPL_TRACE_END(GetMean)
 	return stm32ipl_err_Ok;
 }
 
@@ -378,14 +578,17 @@ stm32ipl_err_t STM32Ipl_GetStdDev(const image_t *src, int32_t *out)
 	STM32IPL_CHECK_VALID_IMAGE(src)
 	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_GRAY_ONLY)
 	STM32IPL_CHECK_VALID_PTR_ARG(out)
+	STM32IPL_TRACE_BEGIN(GetStdDev)
 
 	*out = imlib_image_std((image_t*)src);
 
+	STM32IPL_TRACE_END(GetStdDev)
 	return stm32ipl_err_Ok;
 }
 
 /**
- * @brief Counts the number of non zero pixels in an image.
+ * @brief Counts the number of non zero pixels in an image. Binary images are counted a word (32 pixels) at a time;
+ * with MVE, Grayscale images are counted 16 pixels at a time.
  * The supported formats are Binary, Grayscale, RGB565, RGB888.
  * @param img		Image; if it is not valid, an error is returned.
  * @param out		Number of non zero pixel; if it is not valid, an error is returned.
@@ -406,32 +609,17 @@ stm32ipl_err_t STM32Ipl_CountNonZero(const image_t *img, uint32_t *out, const re
 	if (!out)
 		return stm32ipl_err_InvalidParameter;
 
+	STM32IPL_TRACE_BEGIN(CountNonZero)
 	nonZero = 0;
 
 	switch (img->bpp) {
-		case IMAGE_BPP_BINARY: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					if (IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x) > 0) {
-						nonZero++;
-					}
-				}
-			}
+		case IMAGE_BPP_BINARY:
+			nonZero = imlib_binary_roi_ones((image_t*)img, &realRoi);
 			break;
-		}
 
-		case IMAGE_BPP_GRAYSCALE: {
-			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
-				uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-				for (int x = realRoi.x, xx = realRoi.x + realRoi.w; x < xx; x++) {
-					if (IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x) > 0) {
-						nonZero++;
-					}
-				}
-			}
+		case IMAGE_BPP_GRAYSCALE:
+			nonZero = imlib_grayscale_roi_nonzero((image_t*)img, &realRoi);
 			break;
-		}
 
 		case IMAGE_BPP_RGB565: {
 			for (int y = realRoi.y, yy = realRoi.y + realRoi.h; y < yy; y++) {
@@ -458,11 +646,13 @@ stm32ipl_err_t STM32Ipl_CountNonZero(const image_t *img, uint32_t *out, const re
 		}
 
 		default:
+			STM32IPL_TRACE_END(CountNonZero)
 			return stm32ipl_err_InvalidParameter;
 	}
 
 	*out = nonZero;
 
+	STM32IPL_TRACE_END(CountNonZero)
 	return stm32ipl_err_Ok;
 
 }
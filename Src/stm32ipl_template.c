@@ -23,6 +23,309 @@
 extern "C" {
 #endif
 
+///@cond
+#define IPL_TEMPLATE_MIN_SIZE	16	/* Minimum size of the downscaled template used by the coarse search. */
+#define IPL_TEMPLATE_TOP_K		4	/* Number of candidates refined at each level of the coarse-to-fine search. */
+#define IPL_TEMPLATE_MAX_AREA	65536	/* Maximum template area of the coarse-to-fine search (32-bit sums). */
+
+/* Candidate position of the coarse-to-fine search. */
+typedef struct _ipl_template_cand_t
+{
+	int32_t x;		/* Top-left corner of the template. */
+	int32_t y;
+	float corr;		/* Normalized Cross Correlation. */
+	bool valid;
+} ipl_template_cand_t;
+
+/* Gets the region of the pyramid level corresponding to the given region of the first level. */
+static void ipl_template_level_roi(const stm32ipl_pyramid_t *pyramid, uint32_t level, const rectangle_t *roi,
+		rectangle_t *levelRoi)
+{
+	const image_t *img = &pyramid->level[level];
+	float scale = pyramid->scale[level];
+
+	levelRoi->x = IM_MIN((int)(roi->x / scale), img->w - 1);
+	levelRoi->y = IM_MIN((int)(roi->y / scale), img->h - 1);
+	levelRoi->w = IM_MIN((int)(roi->w / scale), img->w - levelRoi->x);
+	levelRoi->h = IM_MIN((int)(roi->h / scale), img->h - levelRoi->y);
+}
+
+/* Allocates the template downscaled to the given pyramid level (the template itself for the first level);
+ * when the level is not the first one and the data pointer is not NULL, it must be released with fb_free(). */
+static stm32ipl_err_t ipl_template_level_alloc(const stm32ipl_pyramid_t *pyramid, uint32_t level,
+		const image_t *template, image_t *levelTemplate)
+{
+	uint32_t w;
+	uint32_t h;
+
+	if (!level) {
+		*levelTemplate = *template;
+		return stm32ipl_err_Ok;
+	}
+
+	w = (uint32_t)(template->w / pyramid->scale[level]);
+	h = (uint32_t)(template->h / pyramid->scale[level]);
+	if (fb_avail() < FB_ALLOC_SPACE(w * h)) {
+		STM32Ipl_Init(levelTemplate, 0, 0, (image_bpp_t)0, 0);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32Ipl_Init(levelTemplate, w, h, IMAGE_BPP_GRAYSCALE, fb_alloc(w * h, FB_ALLOC_PREFER_SPEED));
+
+	/* The Area method matches the 2x2 block average of the levels built with a scale factor of 2. */
+	return STM32Ipl_Resize_Roi(template, NULL, levelTemplate, NULL,
+			(pyramid->algo == RESIZE_NEAREST) ? RESIZE_NEAREST : RESIZE_AREA);
+}
+
+/* Inserts a position in the list of the best candidates, sorted by decreasing correlation; a position closer
+ * than dist to a better candidate is discarded, so that the list collects distinct optima. */
+static void ipl_template_cand_insert(ipl_template_cand_t *cands, int32_t x, int32_t y, float corr, int32_t dist)
+{
+	int32_t i;
+	int32_t j;
+
+	for (i = 0; (i < IPL_TEMPLATE_TOP_K) && cands[i].valid; i++) {
+		if ((abs(cands[i].x - x) <= dist) && (abs(cands[i].y - y) <= dist)) {
+			if (corr <= cands[i].corr)
+				return;
+
+			/* The new position replaces the near candidate. */
+			for (j = i; j < (IPL_TEMPLATE_TOP_K - 1); j++)
+				cands[j] = cands[j + 1];
+			cands[IPL_TEMPLATE_TOP_K - 1].valid = false;
+			break;
+		}
+	}
+
+	for (i = 0; (i < IPL_TEMPLATE_TOP_K) && cands[i].valid && (cands[i].corr >= corr); i++)
+		;
+
+	if (i == IPL_TEMPLATE_TOP_K)
+		return;
+
+	for (j = IPL_TEMPLATE_TOP_K - 1; j > i; j--)
+		cands[j] = cands[j - 1];
+
+	cands[i].x = x;
+	cands[i].y = y;
+	cands[i].corr = corr;
+	cands[i].valid = true;
+}
+
+/* Computes the Normalized Cross Correlation of the template at the positions (every step pixels) where it fits
+ * in the area of the image, and inserts them in the list of the best candidates. The sums of the image patches
+ * are read from the integral images of the area, so only the correlation requires a pass on the template. */
+static stm32ipl_err_t ipl_template_search(const image_t *img, const rectangle_t *area, const image_t *template,
+		int32_t step, int32_t dist, ipl_template_cand_t *cands)
+{
+	int32_t tw = template->w;
+	int32_t th = template->h;
+	int32_t n = tw * th;
+	int32_t iw = area->w + 1;
+	uint32_t space = FB_ALLOC_SPACE(iw * (area->h + 1) * sizeof(uint32_t));
+	uint32_t tSum = 0;
+	uint32_t tSumSq = 0;
+	uint32_t *sum;
+	uint32_t *sumSq;
+	float tDen;
+
+	if (fb_avail() < (2 * space))
+		return stm32ipl_err_OutOfMemory;
+
+	sum = fb_alloc(iw * (area->h + 1) * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+	sumSq = fb_alloc(iw * (area->h + 1) * sizeof(uint32_t), FB_ALLOC_PREFER_SPEED);
+
+	/* Integral images with a leading row and column of zeros; the sums wrap around, but the sums of the
+	 * patches are exact as their values fit in 32 bits (see IPL_TEMPLATE_MAX_AREA). */
+	memset(sum, 0, iw * sizeof(uint32_t));
+	memset(sumSq, 0, iw * sizeof(uint32_t));
+	for (int32_t y = 0; y < area->h; y++) {
+		const uint8_t *src = img->data + ((area->y + y) * img->w) + area->x;
+		uint32_t *s = sum + ((y + 1) * iw);
+		uint32_t *sq = sumSq + ((y + 1) * iw);
+		uint32_t rowSum = 0;
+		uint32_t rowSumSq = 0;
+
+		s[0] = 0;
+		sq[0] = 0;
+		for (int32_t x = 0; x < area->w; x++) {
+			rowSum += src[x];
+			rowSumSq += src[x] * src[x];
+			s[x + 1] = s[x + 1 - iw] + rowSum;
+			sq[x + 1] = sq[x + 1 - iw] + rowSumSq;
+		}
+	}
+
+	for (int32_t i = 0; i < n; i++) {
+		tSum += template->data[i];
+		tSumSq += template->data[i] * template->data[i];
+	}
+	tDen = (float)(((int64_t)n * tSumSq) - ((int64_t)tSum * tSum));
+
+	for (int32_t v = 0; v <= (area->h - th); v += step) {
+		/* The search stops at the deadline (see STM32Ipl_SetDeadline()). */
+		if (ctx_deadline_expired())
+			break;
+
+		for (int32_t u = 0; u <= (area->w - tw); u += step) {
+			const uint32_t *s0 = sum + (v * iw) + u;
+			const uint32_t *s1 = sum + ((v + th) * iw) + u;
+			const uint32_t *sq0 = sumSq + (v * iw) + u;
+			const uint32_t *sq1 = sumSq + ((v + th) * iw) + u;
+			uint32_t fSum = s1[tw] - s1[0] - s0[tw] + s0[0];
+			uint32_t fSumSq = sq1[tw] - sq1[0] - sq0[tw] + sq0[0];
+			float fDen = (float)(((int64_t)n * fSumSq) - ((int64_t)fSum * fSum));
+			uint64_t dot = 0;
+			float corr = 0.0f;
+
+			for (int32_t y = 0; y < th; y++) {
+				const uint8_t *f = img->data + ((area->y + v + y) * img->w) + area->x + u;
+				const uint8_t *t = template->data + (y * tw);
+				uint32_t rowDot = 0;
+
+				for (int32_t x = 0; x < tw; x++)
+					rowDot += f[x] * t[x];
+
+				dot += rowDot;
+			}
+
+			if ((fDen > 0.0f) && (tDen > 0.0f))
+				corr = (float)(((int64_t)n * (int64_t)dot) - ((int64_t)fSum * tSum)) / (fast_sqrtf(fDen) * fast_sqrtf(tDen));
+
+			ipl_template_cand_insert(cands, area->x + u, area->y + v, corr, dist);
+		}
+	}
+
+	fb_free();
+	fb_free();
+
+	return stm32ipl_err_Ok;
+}
+
+/* Gets the window of the pyramid level, around the position predicted by the coarser level, where the template
+ * is searched; the window is contained in the level region of interest and contains the template. */
+static bool ipl_template_window(const image_t *img, const rectangle_t *levelRoi, const image_t *template, int32_t px,
+		int32_t py, int32_t margin, rectangle_t *win)
+{
+	int32_t x0 = IM_MAX(px - margin, levelRoi->x);
+	int32_t y0 = IM_MAX(py - margin, levelRoi->y);
+	int32_t x1 = IM_MIN(px + template->w + margin, levelRoi->x + levelRoi->w);
+	int32_t y1 = IM_MIN(py + template->h + margin, levelRoi->y + levelRoi->h);
+
+	x0 = IM_MAX(IM_MIN(x0, x1 - template->w), 0);
+	y0 = IM_MAX(IM_MIN(y0, y1 - template->h), 0);
+	x1 = IM_MIN(IM_MAX(x1, x0 + template->w), img->w);
+	y1 = IM_MIN(IM_MAX(y1, y0 + template->h), img->h);
+	if (((x1 - x0) < template->w) || ((y1 - y0) < template->h))
+		return false;
+
+	STM32Ipl_RectInit(win, x0, y0, x1 - x0, y1 - y0);
+
+	return true;
+}
+
+/* Coarse-to-fine search of the template in the first level of the pyramid: the template is downscaled to the
+ * coarsest level where it is still at least IPL_TEMPLATE_MIN_SIZE pixels wide and searched exhaustively there;
+ * the IPL_TEMPLATE_TOP_K best distinct positions are then refined at each finer level, searching only around
+ * the positions predicted by the coarser one. When the deadline passes (see STM32Ipl_SetDeadline()), the best
+ * position of the last level completely refined is returned, scaled to the first level. */
+static stm32ipl_err_t ipl_template_match_pyramid(const stm32ipl_pyramid_t *pyramid, const image_t *template,
+		const rectangle_t *roi, uint32_t step, rectangle_t *rect, float *corr)
+{
+	ipl_template_cand_t cands[IPL_TEMPLATE_TOP_K];
+	ipl_template_cand_t next[IPL_TEMPLATE_TOP_K];
+	rectangle_t levelRoi;
+	image_t levelTemplate;
+	uint32_t top = 0;
+	uint32_t candLevel;
+	int32_t margin;
+	stm32ipl_err_t res;
+
+	if ((template->w * template->h) > IPL_TEMPLATE_MAX_AREA)
+		return stm32ipl_err_InvalidParameter;
+
+	/* Coarsest level where the downscaled template is big enough and fits in the region of interest. */
+	for (uint32_t level = pyramid->levels - 1; level > 0; level--) {
+		uint32_t w = (uint32_t)(template->w / pyramid->scale[level]);
+		uint32_t h = (uint32_t)(template->h / pyramid->scale[level]);
+
+		ipl_template_level_roi(pyramid, level, roi, &levelRoi);
+		if ((w >= IPL_TEMPLATE_MIN_SIZE) && (h >= IPL_TEMPLATE_MIN_SIZE) && (levelRoi.w >= (int)w)
+				&& (levelRoi.h >= (int)h)) {
+			top = level;
+			break;
+		}
+	}
+
+	if (!top)
+		STM32Ipl_RectCopy((rectangle_t*)roi, &levelRoi);
+
+	memset(cands, 0, sizeof(cands));
+
+	res = ipl_template_level_alloc(pyramid, top, template, &levelTemplate);
+	if (res == stm32ipl_err_Ok)
+		res = ipl_template_search(&pyramid->level[top], &levelRoi, &levelTemplate, IM_MAX(step, 1),
+				IM_MIN(levelTemplate.w, levelTemplate.h) / 4, cands);
+	if (top && levelTemplate.data)
+		fb_free();
+
+	candLevel = top;
+
+	/* The margin covers the step of the coarse search and the rounding of the predicted position. */
+	margin = IM_MAX(step, 1);
+
+	for (int32_t level = top - 1; (level >= 0) && (res == stm32ipl_err_Ok) && !ctx_deadline_end(); level--) {
+		float ratio = pyramid->scale[level + 1] / pyramid->scale[level];
+
+		res = ipl_template_level_alloc(pyramid, level, template, &levelTemplate);
+		if (res == stm32ipl_err_Ok) {
+			if (level)
+				ipl_template_level_roi(pyramid, level, roi, &levelRoi);
+			else
+				STM32Ipl_RectCopy((rectangle_t*)roi, &levelRoi);
+
+			memset(next, 0, sizeof(next));
+
+			for (uint32_t i = 0; (i < IPL_TEMPLATE_TOP_K) && cands[i].valid && (res == stm32ipl_err_Ok); i++) {
+				rectangle_t win;
+
+				if (ipl_template_window(&pyramid->level[level], &levelRoi, &levelTemplate,
+						(int32_t)((cands[i].x * ratio) + 0.5f), (int32_t)((cands[i].y * ratio) + 0.5f),
+						(int32_t)((ratio * (margin + 1)) + 0.5f), &win))
+					res = ipl_template_search(&pyramid->level[level], &win, &levelTemplate, 1,
+							IM_MIN(levelTemplate.w, levelTemplate.h) / 4, next);
+			}
+
+			/* The candidates of a level whose search has been stopped are discarded. */
+			if (!ctx_deadline_end()) {
+				memcpy(cands, next, sizeof(cands));
+				candLevel = level;
+			}
+		}
+		if (level && levelTemplate.data)
+			fb_free();
+
+		margin = 1;
+	}
+
+	if (res == stm32ipl_err_Ok) {
+		if (cands[0].valid) {
+			float ratio = pyramid->scale[candLevel] / pyramid->scale[0];
+			int32_t x = IM_MIN((int32_t)((cands[0].x * ratio) + 0.5f), pyramid->level[0].w - template->w);
+			int32_t y = IM_MIN((int32_t)((cands[0].y * ratio) + 0.5f), pyramid->level[0].h - template->h);
+
+			STM32Ipl_RectInit(rect, x, y, template->w, template->h);
+			*corr = cands[0].corr;
+		} else {
+			STM32Ipl_RectInit(rect, 0, 0, 0, 0);
+			*corr = 0.0f;
+		}
+	}
+
+	return res;
+}
+///@endcond
+
 /**
  * @brief Finds the rectangular region in an image that best correlates with a template images, using
  * the Normalized Cross Correlation.
@@ -35,15 +338,19 @@ extern "C" {
  * @param threshold		Floating point number in the range [0, 1]; a higher value prevents false
  * positives while lowering the detection rate; a lower value does the opposite.
  * @param step			Number of pixels to skip past while looking for the template. Skipping pixels
- * considerably speeds the execution up. This only affects the algorithm in SEARCH_EX mode.
- * @param searchType	The type of search; it can be either SEARCH_DS or SEARCH_EX: SEARCH_DS searches
+ * considerably speeds the execution up. This only affects the algorithm in SEARCH_EX mode and the coarse
+ * search in SEARCH_PYR mode.
+ * @param searchType	The type of search; it can be SEARCH_DS, SEARCH_EX or SEARCH_PYR: SEARCH_DS searches
  * for the template using a faster algorithm than SEARCH_EX, but it may not find the template if it is
  * near the edges of the image; SEARCH_EX does an exhaustive search for the image, but it can be much
- * slower than SEARCH_DS.
+ * slower than SEARCH_DS; SEARCH_PYR builds a temporary 2x pyramid of the image and runs the coarse-to-fine
+ * search of STM32Ipl_FindTemplatePyramid(), which usually finds the same position of SEARCH_EX at a fraction
+ * of its cost (the template area must not exceed 65536 pixels).
  * @param templateRect	Returns the region corresponding to the template found. If no template has found,
  * its values are set to zero.
  * @param correlation	Returns the correlation value between the input template and the template found.
- * @return				stm32ipl_err_Ok on success, error otherwise.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the best region found so far is returned), error otherwise.
  */
 stm32ipl_err_t STM32Ipl_FindTemplate(const image_t *img, const image_t *template, const rectangle_t *roi,
 		float threshold, uint32_t step, template_match_t searchType, rectangle_t *templateRect, float *correlation)
@@ -55,18 +362,46 @@ stm32ipl_err_t STM32Ipl_FindTemplate(const image_t *img, const image_t *template
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
 	STM32IPL_CHECK_VALID_IMAGE(template)
 	STM32IPL_CHECK_FORMAT(template, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(img)
+	STM32IPL_CHECK_NOT_VIEW(template)
 	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
 	STM32IPL_CHECK_VALID_PTR_ARG(templateRect)
 	STM32IPL_CHECK_VALID_PTR_ARG(correlation)
+	STM32IPL_TRACE_BEGIN(FindTemplate)
+
+	ctx_deadline_begin();
 
 	/* Make sure that ROI is bigger than or equal to the template size. */
-	if ((realRoi.w < template->w || realRoi.h < template->h))
+	if ((realRoi.w < template->w || realRoi.h < template->h)) {
+		STM32IPL_TRACE_END(FindTemplate)
 		return stm32ipl_err_InvalidParameter;
+	}
+
+	if (searchType == SEARCH_PYR) {
+		stm32ipl_pyramid_t pyramid;
+		uint8_t levels = 1;
+		stm32ipl_err_t res;
 
-	if (searchType == SEARCH_DS)
+		/* Halve the image until the template reaches the minimum size used by the coarse search. */
+		while ((levels < STM32IPL_PYRAMID_MAX_LEVELS) && ((template->w >> levels) >= IPL_TEMPLATE_MIN_SIZE)
+				&& ((template->h >> levels) >= IPL_TEMPLATE_MIN_SIZE))
+			levels++;
+
+		memset(&pyramid, 0, sizeof(pyramid));
+		res = STM32Ipl_PyramidBuild(img, levels, 2.0f, RESIZE_AREA, &pyramid);
+		if (res == stm32ipl_err_Ok)
+			res = ipl_template_match_pyramid(&pyramid, template, &realRoi, step, templateRect, &corr);
+		STM32Ipl_PyramidRelease(&pyramid);
+
+		if (res != stm32ipl_err_Ok) {
+			STM32IPL_TRACE_END(FindTemplate)
+			return res;
+		}
+	} else if (searchType == SEARCH_DS) {
 		corr = imlib_template_match_ds((image_t*)img, (image_t*)template, templateRect);
-	else
+	} else {
 		corr = imlib_template_match_ex((image_t*)img, (image_t*)template, &realRoi, step, templateRect);
+	}
 
 	if (corr < threshold) {
 		templateRect->x = 0;
@@ -77,7 +412,83 @@ stm32ipl_err_t STM32Ipl_FindTemplate(const image_t *img, const image_t *template
 
 	*correlation = corr;
 
-	return stm32ipl_err_Ok;
+	STM32IPL_TRACE_END(FindTemplate)
+	return ctx_deadline_end() ? stm32ipl_err_Partial : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Finds the rectangular region in the first level of the pyramid that best correlates with a template
+ * image, using the Normalized Cross Correlation and a coarse-to-fine search: the template is downscaled to the
+ * coarsest level where it is still at least 16x16 pixels wide and exhaustively searched there; the 4 best
+ * distinct positions found are then refined at each finer level, searching only around the positions predicted
+ * by the coarser one. The sums of the image patches needed by the correlation are computed with integral
+ * images of the searched areas. The levels are shared with the other functions that use the pyramid (see
+ * STM32Ipl_PyramidBuild()); the downscaled templates and the integral images are allocated in the internal
+ * memory (when available).
+ * The result may differ from the one of an exhaustive search on the full resolution image when the template
+ * details are lost in the coarse levels. The first level of the pyramid is searched exhaustively when the
+ * template is too small to be downscaled. The template area must not exceed 65536 pixels.
+ * The supported format is Grayscale.
+ * @param pyramid		Pyramid; its first level must not be a view; if it is not valid, an error is returned.
+ * @param template		Template image to be found; if it is not valid, an error is returned.
+ * @param roi			Optional region of interest of the first level of the pyramid where the functions operates;
+ * when defined, it must be contained in the first level and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole first level is considered.
+ * @param threshold		Floating point number in the range [0, 1]; a higher value prevents false
+ * positives while lowering the detection rate; a lower value does the opposite.
+ * @param step			Number of pixels to skip past while searching the template in the coarsest level.
+ * @param templateRect	Returns the region corresponding to the template found. If no template has found,
+ * its values are set to zero.
+ * @param correlation	Returns the correlation value between the input template and the template found.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_Partial when the deadline set with STM32Ipl_SetDeadline()
+ * passed (the best region found so far is returned), error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_FindTemplatePyramid(const stm32ipl_pyramid_t *pyramid, const image_t *template,
+		const rectangle_t *roi, float threshold, uint32_t step, rectangle_t *templateRect, float *correlation)
+{
+	rectangle_t realRoi;
+	rectangle_t rect;
+	const image_t *img;
+	float corr = 0.0f;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(pyramid)
+	if (!pyramid->levels || (pyramid->levels > STM32IPL_PYRAMID_MAX_LEVELS))
+		return stm32ipl_err_InvalidParameter;
+
+	img = &pyramid->level[0];
+
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_VALID_IMAGE(template)
+	STM32IPL_CHECK_FORMAT(template, STM32IPL_IF_GRAY_ONLY)
+	STM32IPL_CHECK_NOT_VIEW(img)
+	STM32IPL_CHECK_NOT_VIEW(template)
+	STM32IPL_GET_REAL_ROI(img, roi, &realRoi)
+	STM32IPL_CHECK_VALID_PTR_ARG(templateRect)
+	STM32IPL_CHECK_VALID_PTR_ARG(correlation)
+
+	/* Make sure that ROI is bigger than or equal to the template size. */
+	if ((realRoi.w < template->w) || (realRoi.h < template->h))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(FindTemplatePyramid)
+
+	ctx_deadline_begin();
+	res = ipl_template_match_pyramid(pyramid, template, &realRoi, step, &rect, &corr);
+	if (res == stm32ipl_err_Ok) {
+		if (corr < threshold)
+			STM32Ipl_RectInit(&rect, 0, 0, 0, 0);
+
+		STM32Ipl_RectCopy(&rect, templateRect);
+		*correlation = corr;
+
+		if (ctx_deadline_end())
+			res = stm32ipl_err_Partial;
+	}
+
+	STM32IPL_TRACE_END(FindTemplatePyramid)
+	return res;
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,258 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_tensor.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - neural network input module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* State of STM32Ipl_PrepareTensor() shared with the line sink. */
+typedef struct _ipl_tensor_ctx_t
+{
+	const stm32ipl_tensor_t *tensor;
+	uint8_t *out;			/* Tensor data. */
+	uint8_t *chLine;		/* Resized line converted to RGB888 or Grayscale. */
+	const uint8_t *lut;		/* Normalized/quantized value of each channel value, for each tensor channel. */
+	uint32_t elemSize;		/* Size (bytes) of the tensor elements. */
+	uint32_t pixStep;		/* Distance (elements) between two consecutive pixels of a channel. */
+	uint32_t chStep;		/* Distance (elements) between two consecutive channels of a pixel. */
+	uint8_t chOffset[3];	/* Offset of each tensor channel in the pixels of chLine. */
+	int ox;					/* Position of the resized image in the tensor. */
+	int oy;
+	int rw;					/* Width of the resized image. */
+} ipl_tensor_ctx_t;
+
+/* Fills n pixels of the tensor row, starting from x, with the padding value. */
+static void ipl_tensor_pad(const ipl_tensor_ctx_t *ctx, int row, int x, int n)
+{
+	const stm32ipl_tensor_t *tensor = ctx->tensor;
+
+	for (uint32_t c = 0; c < tensor->channels; c++) {
+		uint32_t index = (((row * tensor->w) + x) * ctx->pixStep) + (c * ctx->chStep);
+		const uint8_t *lut = ctx->lut + (c * 256 * ctx->elemSize);
+
+		if (ctx->elemSize == 1) {
+			uint8_t value = lut[tensor->padValue];
+			uint8_t *out = ctx->out + index;
+
+			for (int i = 0; i < n; i++, out += ctx->pixStep)
+				*out = value;
+		} else {
+			float value = ((const float*)lut)[tensor->padValue];
+			float *out = (float*)ctx->out + index;
+
+			for (int i = 0; i < n; i++, out += ctx->pixStep)
+				*out = value;
+		}
+	}
+}
+
+/* Normalizes the resized line y and stores it to the tensor, together with the horizontal padding. */
+static void ipl_tensor_put(const ipl_resize_sink_t *sink, int y)
+{
+	const ipl_tensor_ctx_t *ctx = (const ipl_tensor_ctx_t*)sink->arg;
+	const stm32ipl_tensor_t *tensor = ctx->tensor;
+	int chFormat = (tensor->channels == 3) ? IMAGE_BPP_RGB888 : IMAGE_BPP_GRAYSCALE;
+	const uint8_t *in = sink->line;
+	int row = ctx->oy + y;
+
+	if (sink->format != chFormat) {
+		ipl_convert_line(sink->line, ctx->chLine, ctx->rw, sink->format, chFormat);
+		in = ctx->chLine;
+	}
+
+	for (uint32_t c = 0; c < tensor->channels; c++) {
+		uint32_t index = (((row * tensor->w) + ctx->ox) * ctx->pixStep) + (c * ctx->chStep);
+		const uint8_t *lut = ctx->lut + (c * 256 * ctx->elemSize);
+		const uint8_t *value = in + ctx->chOffset[c];
+
+		if (ctx->elemSize == 1) {
+			uint8_t *out = ctx->out + index;
+
+			for (int x = 0; x < ctx->rw; x++, value += tensor->channels, out += ctx->pixStep)
+				*out = lut[*value];
+		} else {
+			float *out = (float*)ctx->out + index;
+
+			for (int x = 0; x < ctx->rw; x++, value += tensor->channels, out += ctx->pixStep)
+				*out = ((const float*)lut)[*value];
+		}
+	}
+
+	if (ctx->ox > 0)
+		ipl_tensor_pad(ctx, row, 0, ctx->ox);
+
+	if ((ctx->ox + ctx->rw) < tensor->w)
+		ipl_tensor_pad(ctx, row, ctx->ox + ctx->rw, tensor->w - ctx->ox - ctx->rw);
+}
+
+/* Fills the lookup table with the normalized/quantized value of each channel value, for each tensor channel. */
+static void ipl_tensor_init_lut(const stm32ipl_tensor_t *tensor, uint8_t *lut)
+{
+	for (uint32_t c = 0; c < tensor->channels; c++) {
+		for (uint32_t v = 0; v < 256; v++) {
+			float value = (v - tensor->mean[c]) * tensor->scale[c];
+			int32_t q;
+
+			switch (tensor->type) {
+				case stm32ipl_tensor_uint8:
+					q = (int32_t)lroundf(value / tensor->qScale) + tensor->qZeroPoint;
+					*lut++ = (uint8_t)IM_MAX(IM_MIN(q, UINT8_MAX), 0);
+					break;
+
+				case stm32ipl_tensor_int8:
+					q = (int32_t)lroundf(value / tensor->qScale) + tensor->qZeroPoint;
+					*lut++ = (uint8_t)(int8_t)IM_MAX(IM_MIN(q, INT8_MAX), INT8_MIN);
+					break;
+
+				default:
+					*(float*)lut = value;
+					lut += sizeof(float);
+					break;
+			}
+		}
+	}
+}
+///@endcond
+
+/**
+ * @brief Prepares the input tensor of a neural network from the source image (whole or a portion of it) in a
+ * single pass: each line is resized to the tensor size, converted to the tensor channels (R, G, B or luminance),
+ * normalized with the per-channel mean and scale, quantized when needed and stored with the tensor layout.
+ * The normalization and quantization are computed once per channel value, so that each element costs a table
+ * lookup. With letterbox, the source region is resized keeping its aspect ratio and centered in the tensor; the
+ * borders are filled with the padding value. The needed line buffers are allocated in the internal memory (when
+ * available); with the Bilinear method, the resized image is first stored to a temporary image.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param roi		Optional region of interest of the source image where the functions operates;
+ * when defined, it must be contained in the source image and have positive dimensions, otherwise
+ * an error is returned; when not defined, the whole image is considered.
+ * @param tensor	Description of the tensor; if it is not valid, an error is returned.
+ * @param out		Tensor data buffer, of (at least) w * h * channels elements; if it is not valid,
+ * an error is returned.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_PrepareTensor(const image_t *src, const rectangle_t *roi, const stm32ipl_tensor_t *tensor,
+		void *out)
+{
+	ipl_tensor_ctx_t ctx;
+	ipl_resize_sink_t sink;
+	rectangle_t srcRoi;
+	image_t tmp;
+	uint32_t lutSize;
+	uint32_t lineSize;
+	uint32_t size;
+	int rh;
+	stm32ipl_err_t res;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_VALID_PTR_ARG(tensor)
+	STM32IPL_CHECK_VALID_PTR_ARG(out)
+
+	if (!tensor->w || !tensor->h || ((tensor->channels != 1) && (tensor->channels != 3))
+			|| (tensor->type > stm32ipl_tensor_float32) || (tensor->layout > stm32ipl_tensor_chw)
+			|| ((tensor->type != stm32ipl_tensor_float32) && !(tensor->qScale > 0.0f)))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32Ipl_RectInit(&srcRoi, 0, 0, src->w, src->h);
+
+	if (roi) {
+		if ((roi->w < 1) || (roi->h < 1) || !STM32Ipl_RectContain(&srcRoi, roi))
+			return stm32ipl_err_WrongROI;
+		STM32Ipl_RectCopy(roi, &srcRoi);
+	}
+
+	ctx.tensor = tensor;
+	ctx.out = out;
+	ctx.elemSize = (tensor->type == stm32ipl_tensor_float32) ? sizeof(float) : 1;
+	ctx.pixStep = (tensor->layout == stm32ipl_tensor_hwc) ? tensor->channels : 1;
+	ctx.chStep = (tensor->layout == stm32ipl_tensor_hwc) ? 1 : (tensor->w * tensor->h);
+
+	/* The channels of the RGB888 pixels are stored in B, G, R order. */
+	ctx.chOffset[0] = (tensor->channels == 1) ? 0 : (tensor->swapRB ? 0 : 2);
+	ctx.chOffset[1] = 1;
+	ctx.chOffset[2] = tensor->swapRB ? 2 : 0;
+
+	if (tensor->letterbox) {
+		float f = IM_MIN((float)tensor->w / srcRoi.w, (float)tensor->h / srcRoi.h);
+
+		ctx.rw = IM_MAX(IM_MIN((int)((srcRoi.w * f) + 0.5f), tensor->w), 1);
+		rh = IM_MAX(IM_MIN((int)((srcRoi.h * f) + 0.5f), tensor->h), 1);
+	} else {
+		ctx.rw = tensor->w;
+		rh = tensor->h;
+	}
+	ctx.ox = (tensor->w - ctx.rw) / 2;
+	ctx.oy = (tensor->h - rh) / 2;
+
+	lutSize = tensor->channels * 256 * ctx.elemSize;
+	lineSize = (STM32Ipl_DataSize(ctx.rw, 1, (image_bpp_t)src->bpp) + 3) & ~3UL;
+	size = lutSize + lineSize + (ctx.rw * tensor->channels);
+	if (fb_avail() < FB_ALLOC_SPACE(size))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(PrepareTensor)
+
+	ctx.lut = fb_alloc(size, FB_ALLOC_PREFER_SPEED);
+	ctx.chLine = (uint8_t*)ctx.lut + lutSize + lineSize;
+
+	ipl_tensor_init_lut(tensor, (uint8_t*)ctx.lut);
+
+	sink.line = (uint8_t*)ctx.lut + lutSize;
+	sink.format = src->bpp;
+	sink.put = ipl_tensor_put;
+	sink.arg = &ctx;
+
+	if (tensor->algo == RESIZE_BILINEAR) {
+		/* The bilinear method resizes whole images: the resized image is then streamed line by line. */
+		res = STM32Ipl_AllocData(&tmp, ctx.rw, rh, (image_bpp_t)src->bpp);
+		if (res == stm32ipl_err_Ok) {
+			res = STM32Ipl_Resize_Roi(src, &srcRoi, &tmp, NULL, RESIZE_BILINEAR);
+			if (res == stm32ipl_err_Ok)
+				res = ipl_resize_lines(&tmp, NULL, ctx.rw, rh, RESIZE_NEAREST, &sink);
+
+			STM32Ipl_ReleaseData(&tmp);
+		}
+	} else {
+		res = ipl_resize_lines(src, &srcRoi, ctx.rw, rh, tensor->algo, &sink);
+	}
+
+	if (res == stm32ipl_err_Ok) {
+		for (int y = 0; y < ctx.oy; y++)
+			ipl_tensor_pad(&ctx, y, 0, tensor->w);
+
+		for (int y = ctx.oy + rh; y < tensor->h; y++)
+			ipl_tensor_pad(&ctx, y, 0, tensor->w);
+	}
+
+	fb_free();
+
+	STM32IPL_TRACE_END(PrepareTensor)
+
+	return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,816 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_tile.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - tiled execution module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include "stm32ipl.h"
+#include "stm32ipl_imlib_int.h"
+#ifdef IPL_STATS_HAS_MVE
+#include "mve_stats.h"
+#endif /* IPL_STATS_HAS_MVE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+/* Position of a tile in the image and of its inner part (without halo) in the tile. */
+typedef struct _ipl_tile_t
+{
+	int x;		/* Top-left corner of the tile, halo included, in the image. */
+	int y;
+	int w;		/* Size of the tile, halo included. */
+	int h;
+	int innerX;	/* Top-left corner of the inner part in the tile. */
+	int innerY;
+	int innerW;	/* Size of the inner part. */
+	int innerH;
+} ipl_tile_t;
+
+static void ipl_tile_get(const image_t *img, uint16_t tileW, uint16_t tileH, uint8_t halo, uint32_t index,
+		ipl_tile_t *tile)
+{
+	uint32_t nX = (img->w + tileW - 1) / tileW;
+	int x = (index % nX) * tileW;
+	int y = (index / nX) * tileH;
+	int x0 = IM_MAX(x - halo, 0);
+	int y0 = IM_MAX(y - halo, 0);
+
+	tile->innerW = IM_MIN(tileW, img->w - x);
+	tile->innerH = IM_MIN(tileH, img->h - y);
+	tile->x = x0;
+	tile->y = y0;
+	tile->w = IM_MIN(x + tile->innerW + halo, img->w) - x0;
+	tile->h = IM_MIN(y + tile->innerH + halo, img->h) - y0;
+	tile->innerX = x - x0;
+	tile->innerY = y - y0;
+}
+
+/* Starts copying the tile (halo included) from the source image to the given buffer. */
+static void ipl_tile_load(const image_t *src, const ipl_tile_t *tile, uint8_t *buffer, uint32_t bpp)
+{
+	uint32_t stride = STM32Ipl_ImageStride(src);
+
+	STM32Ipl_BlockCopyStart(buffer, tile->w * bpp, src->data + (tile->y * stride) + (tile->x * bpp), stride,
+			tile->w * bpp, tile->h);
+}
+
+/* Starts copying the inner part of the tile from the given buffer to the destination image. */
+static void ipl_tile_store(image_t *dst, const ipl_tile_t *tile, const uint8_t *buffer, uint32_t bpp)
+{
+	uint32_t stride = STM32Ipl_ImageStride(dst);
+	uint32_t x = tile->x + tile->innerX;
+	uint32_t y = tile->y + tile->innerY;
+
+	STM32Ipl_BlockCopyStart(dst->data + (y * stride) + (x * bpp), stride,
+			buffer + (((tile->innerY * tile->w) + tile->innerX) * bpp), tile->w * bpp, tile->innerW * bpp,
+			tile->innerH);
+}
+
+/* Gets the number of tile buffers that fit the memory (two for double buffering, zero if not even one fits)
+ * and the size of each one. */
+static uint32_t ipl_tiled_buffers(const image_t *src, uint16_t tileW, uint16_t tileH, uint8_t halo, uint32_t *size)
+{
+	*size = STM32Ipl_Tiled_GetBufferSize(src, tileW, tileH, halo) / 2;
+
+	if (fb_avail() >= (2 * *size))
+		return 2;
+
+	if (fb_avail() >= *size)
+		return 1;
+
+	return 0;
+}
+
+/* Tells if the output of the given tile may change: a tile within reach tiles from it changed. */
+static bool ipl_tiled_dirty(const stm32ipl_dirty_tiles_t *tracker, uint32_t index, uint32_t reach)
+{
+	int tx = index % tracker->tilesX;
+	int ty = index / tracker->tilesX;
+	int x0 = IM_MAX(tx - (int)reach, 0);
+	int y0 = IM_MAX(ty - (int)reach, 0);
+	int x1 = IM_MIN(tx + (int)reach, tracker->tilesX - 1);
+	int y1 = IM_MIN(ty + (int)reach, tracker->tilesY - 1);
+
+	for (int y = y0; y <= y1; y++)
+		for (int x = x0; x <= x1; x++)
+			if (tracker->dirty[(y * tracker->tilesX) + x])
+				return true;
+
+	return false;
+}
+
+/* Gets the first tile, from index on, to be processed: any tile when there is no tracker, otherwise the first
+ * one whose output may change; nTiles when there is none. */
+static uint32_t ipl_tiled_next(const stm32ipl_dirty_tiles_t *tracker, uint32_t reach, uint32_t index,
+		uint32_t nTiles)
+{
+	if (tracker)
+		while ((index < nTiles) && !ipl_tiled_dirty(tracker, index, reach))
+			index++;
+
+	return index;
+}
+
+/* Executes the operation on the tiles of the image: all of them, or only the ones whose output may change when
+ * the tracker is given (the tiles are then its tiles). The copies of the next tile to be processed are started
+ * before processing the current one when there are two buffers. */
+static stm32ipl_err_t ipl_tiled_run(const image_t *src, image_t *dst, uint16_t tileW, uint16_t tileH, uint8_t halo,
+		stm32ipl_tile_op_t op, void *arg, uint32_t size, uint32_t nBuffers, const stm32ipl_dirty_tiles_t *tracker)
+{
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	ipl_tile_t tiles[2];
+	uint8_t *buffers[2];
+	uint32_t nTiles;
+	uint32_t reach;
+	uint32_t bpp;
+	uint32_t i;
+
+	buffers[0] = fb_alloc(nBuffers * size, FB_ALLOC_PREFER_SPEED);
+	buffers[1] = buffers[0] + ((nBuffers - 1) * size);
+
+	bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp);
+	nTiles = ((src->w + tileW - 1) / tileW) * ((src->h + tileH - 1) / tileH);
+
+	/* The output of a tile depends on the source pixels within halo from it. */
+	reach = (halo + tileW - 1) / tileW;
+
+	i = ipl_tiled_next(tracker, reach, 0, nTiles);
+	if (i < nTiles) {
+		ipl_tile_get(src, tileW, tileH, halo, i, &tiles[0]);
+		ipl_tile_load(src, &tiles[0], buffers[0], bpp);
+	}
+
+	for (uint32_t k = 0; i < nTiles; k++) {
+		uint32_t cur = k & (nBuffers - 1);
+		uint32_t next = (k + 1) & (nBuffers - 1);
+		uint32_t nextIndex = ipl_tiled_next(tracker, reach, i + 1, nTiles);
+		image_t tile;
+
+		/* Waits for the current tile and for the store of the previous one, that used the other buffer. */
+		STM32Ipl_BlockCopyWait();
+
+		if ((nBuffers == 2) && (nextIndex < nTiles)) {
+			ipl_tile_get(src, tileW, tileH, halo, nextIndex, &tiles[next]);
+			ipl_tile_load(src, &tiles[next], buffers[next], bpp);
+		}
+
+		STM32Ipl_Init(&tile, tiles[cur].w, tiles[cur].h, (image_bpp_t)src->bpp, buffers[cur]);
+		res = op(&tile, arg);
+		if (res != stm32ipl_err_Ok)
+			break;
+
+		ipl_tile_store(dst, &tiles[cur], buffers[cur], bpp);
+
+		/* With a single buffer, the next tile is loaded after the store of the current one. */
+		if ((nBuffers == 1) && (nextIndex < nTiles)) {
+			ipl_tile_get(src, tileW, tileH, halo, nextIndex, &tiles[0]);
+			ipl_tile_load(src, &tiles[0], buffers[0], bpp);
+		}
+
+		i = nextIndex;
+	}
+
+	STM32Ipl_BlockCopyWait();
+
+	fb_free();
+
+	return res;
+}
+///@endcond
+
+/**
+ * @brief Starts copying a block of lines between two memory buffers; it is used to move the tiles processed by
+ * STM32Ipl_Tiled() between the image and the internal memory and, when STM32IPL_ENABLE_ROW_PREFETCH is defined,
+ * to prefetch the source lines of the row-streaming functions. The copies must be executed in the same order
+ * they are started. This weak function performs the copy with the CPU before returning; it can be re-defined
+ * by the application to start a DMA transfer (e.g. MDMA block transfer on STM32H7), so that the copy of the
+ * next tile or line overlaps with the processing of the current one; in such case, the cache maintenance
+ * of the buffers is up to the application.
+ * @param dst		Destination buffer.
+ * @param dstStride	Distance (bytes) between the beginning of two consecutive lines of the destination buffer.
+ * @param src		Source buffer.
+ * @param srcStride	Distance (bytes) between the beginning of two consecutive lines of the source buffer.
+ * @param lineSize	Number of bytes to be copied for each line.
+ * @param lines		Number of lines to be copied.
+ * @return			void.
+ */
+__attribute__((weak)) void STM32Ipl_BlockCopyStart(uint8_t *dst, uint32_t dstStride, const uint8_t *src,
+		uint32_t srcStride, uint32_t lineSize, uint32_t lines)
+{
+	for (uint32_t i = 0; i < lines; i++, dst += dstStride, src += srcStride)
+		memcpy(dst, src, lineSize);
+}
+
+/**
+ * @brief Waits for the completion of all the copies started with STM32Ipl_BlockCopyStart().
+ * This weak function does nothing, as the default STM32Ipl_BlockCopyStart() is synchronous;
+ * it must be re-defined by the application together with STM32Ipl_BlockCopyStart().
+ * @return	void.
+ */
+__attribute__((weak)) void STM32Ipl_BlockCopyWait(void)
+{
+}
+
+/**
+ * @brief Gets the size of the temporary memory used by STM32Ipl_Tiled() to process the tiles with
+ * double buffering, i.e. the memory needed for two tiles, halo included.
+ * @param img	Image; if it is not valid, zero is returned.
+ * @param tileW	Width of the tiles (halo excluded).
+ * @param tileH	Height of the tiles (halo excluded).
+ * @param halo	Number of pixels added on each side of the tiles.
+ * @return		Size of the temporary memory (bytes), zero in case of wrong/unsupported argument.
+ */
+uint32_t STM32Ipl_Tiled_GetBufferSize(const image_t *img, uint16_t tileW, uint16_t tileH, uint8_t halo)
+{
+	uint32_t w;
+	uint32_t h;
+
+	if (!img || !tileW || !tileH || !STM32Ipl_ImageFormatSupported(img,
+			(stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888)))
+		return 0;
+
+	w = IM_MIN(tileW + (2 * halo), img->w);
+	h = IM_MIN(tileH + (2 * halo), img->h);
+
+	return 2 * STM32Ipl_DataSize(w, h, (image_bpp_t)img->bpp);
+}
+
+/**
+ * @brief Executes an image processing operation tile by tile, so that it works on the fast internal memory
+ * even when the images are stored in the external one. Each tile, together with a halo of the given number of
+ * pixels on each side, is copied from the source image to a buffer allocated in the internal memory (when
+ * available), processed there by the given operation and its inner part (without halo) is copied to the
+ * destination image. When there is enough memory for two tiles, the copies of the next tile are started before
+ * processing the current one, so that, if STM32Ipl_BlockCopyStart() and STM32Ipl_BlockCopyWait() are
+ * re-defined to use a DMA, the transfers overlap with the computation.
+ * For operations whose output pixels depend only on the source pixels within a distance (radius) not greater
+ * than halo, e.g. STM32Ipl_MeanFilter(), STM32Ipl_Gaussian(), STM32Ipl_Morph(), STM32Ipl_Sobel(),
+ * STM32Ipl_Erode() and STM32Ipl_Dilate() with halo equal to kSize, or pixel-wise operations with zero halo,
+ * the result is the same of executing the operation on the whole image. The operation must not change the
+ * format and the resolution of the tile; the temporary memory it needs is allocated after the tile buffers.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param dst		Destination image; it must have the same format and resolution of the source one and
+ * a different data buffer; if it is not valid, an error is returned.
+ * @param tileW		Width of the tiles (halo excluded); it must be greater than zero.
+ * @param tileH		Height of the tiles (halo excluded); it must be greater than zero.
+ * @param halo		Number of pixels added on each side of the tiles.
+ * @param op		Operation executed on each tile; when it returns an error, the processing is stopped
+ * and the error is returned.
+ * @param arg		Argument passed to the operation.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_Tiled(const image_t *src, image_t *dst, uint16_t tileW, uint16_t tileH, uint8_t halo,
+		stm32ipl_tile_op_t op, void *arg)
+{
+	stm32ipl_err_t res;
+	uint32_t nBuffers;
+	uint32_t size;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+	STM32IPL_CHECK_VALID_PTR_ARG(op)
+
+	if (!tileW || !tileH || (src->data == dst->data))
+		return stm32ipl_err_InvalidParameter;
+
+	nBuffers = ipl_tiled_buffers(src, tileW, tileH, halo, &size);
+	if (!nBuffers)
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(Tiled)
+
+	res = ipl_tiled_run(src, dst, tileW, tileH, halo, op, arg, size, nBuffers, NULL);
+
+	STM32IPL_TRACE_END(Tiled)
+
+	return res;
+}
+
+///@cond
+/* Copies the binary pixels [x, x + w) of h rows from src to dst, the two buffers having the pixels at the same
+ * position within their words; the other pixels of dst are kept. */
+static void ipl_tile_store_binary(uint32_t *dst, uint32_t dstWords, const uint32_t *src, uint32_t srcWords, int x,
+		int w, int h)
+{
+	int first = x >> UINT32_T_SHIFT;
+	int last = (x + w - 1) >> UINT32_T_SHIFT;
+	uint32_t firstMask = 0xFFFFFFFFU << (x & UINT32_T_MASK);
+	uint32_t lastMask = 0xFFFFFFFFU >> (UINT32_T_MASK - ((x + w - 1) & UINT32_T_MASK));
+
+	for (int y = 0; y < h; y++, dst += dstWords, src += srcWords) {
+		for (int i = first; i <= last; i++) {
+			uint32_t m = 0xFFFFFFFFU;
+
+			if (i == first)
+				m &= firstMask;
+
+			if (i == last)
+				m &= lastMask;
+
+			dst[i] = (dst[i] & ~m) | (src[i] & m);
+		}
+	}
+}
+///@endcond
+
+/**
+ * @brief Executes an image processing operation on a region of interest only: the ROI, together with a halo of
+ * the given number of pixels on each side (within the image), is copied to a buffer allocated in the internal
+ * memory (when available), processed there by the given operation, and the ROI is copied to the destination image,
+ * whose other pixels are not modified. For operations whose output pixels depend only on the source pixels within a
+ * distance (radius) not greater than halo (see STM32Ipl_Tiled()), the ROI gets the same result of executing the
+ * operation on the whole image, the pixels around the ROI being used at its borders, at the cost of the ROI only.
+ * Pixel-wise operations need no halo and can also be executed directly on a view of the ROI (STM32Ipl_InitView()).
+ * The operation must not change the format and the resolution of the buffer; the temporary memory it needs is
+ * allocated after the buffer. With Binary images, the buffer starts at a multiple of 32 pixels.
+ * The supported formats are Binary, Grayscale, RGB565, RGB888.
+ * @param src		Source image; if it is not valid, an error is returned.
+ * @param dst		Destination image; it must have the same format and resolution of the source one, and it can be
+ * the source image itself; if it is not valid, an error is returned.
+ * @param roi		Region of interest; it must be contained in the source image and have positive dimensions,
+ * otherwise an error is returned.
+ * @param halo		Number of pixels added on each side of the ROI.
+ * @param op		Operation executed on the buffer.
+ * @param arg		Argument passed to the operation.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_TiledRoi(const image_t *src, image_t *dst, const rectangle_t *roi, uint8_t halo,
+		stm32ipl_tile_op_t op, void *arg)
+{
+	stm32ipl_err_t res;
+	ipl_tile_t tile;
+	image_t buffer;
+	uint32_t srcStride;
+	uint32_t dstStride;
+	uint32_t lineSize;
+	uint32_t bpp;
+	int x1;
+	int y1;
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, (stm32ipl_if_binary | stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+	STM32IPL_CHECK_VALID_PTR_ARG(roi)
+	STM32IPL_CHECK_VALID_PTR_ARG(op)
+	STM32IPL_CHECK_VALID_ROI(src, roi)
+
+	if ((roi->w <= 0) || (roi->h <= 0))
+		return stm32ipl_err_WrongROI;
+
+	/* ROI grown by the halo; the Binary buffer keeps the pixels at the same position within the words. */
+	tile.x = IM_MAX(roi->x - halo, 0);
+	tile.y = IM_MAX(roi->y - halo, 0);
+	if (src->bpp == IMAGE_BPP_BINARY)
+		tile.x &= ~UINT32_T_MASK;
+
+	x1 = IM_MIN(roi->x + roi->w + halo, src->w);
+	y1 = IM_MIN(roi->y + roi->h + halo, src->h);
+	tile.w = x1 - tile.x;
+	tile.h = y1 - tile.y;
+	tile.innerX = roi->x - tile.x;
+	tile.innerY = roi->y - tile.y;
+	tile.innerW = roi->w;
+	tile.innerH = roi->h;
+
+	lineSize = STM32Ipl_DataSize(tile.w, 1, (image_bpp_t)src->bpp);
+	if (fb_avail() < (lineSize * tile.h))
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(TiledRoi)
+
+	STM32Ipl_Init(&buffer, tile.w, tile.h, (image_bpp_t)src->bpp, fb_alloc(lineSize * tile.h, FB_ALLOC_PREFER_SPEED));
+
+	srcStride = STM32Ipl_ImageStride(src);
+	dstStride = STM32Ipl_ImageStride(dst);
+
+	if (src->bpp == IMAGE_BPP_BINARY) {
+		STM32Ipl_BlockCopyStart(buffer.data, lineSize, src->data + (tile.y * srcStride) + (tile.x / 8), srcStride,
+				lineSize, tile.h);
+		STM32Ipl_BlockCopyWait();
+
+		res = op(&buffer, arg);
+		if (res == stm32ipl_err_Ok)
+			ipl_tile_store_binary((uint32_t*)(dst->data + (roi->y * dstStride) + (tile.x / 8)),
+					dstStride / sizeof(uint32_t), (const uint32_t*)(buffer.data + (tile.innerY * lineSize)),
+					lineSize / sizeof(uint32_t), tile.innerX, tile.innerW, tile.innerH);
+	} else {
+		bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)src->bpp);
+		ipl_tile_load(src, &tile, buffer.data, bpp);
+		STM32Ipl_BlockCopyWait();
+
+		res = op(&buffer, arg);
+		if (res == stm32ipl_err_Ok) {
+			ipl_tile_store(dst, &tile, buffer.data, bpp);
+			STM32Ipl_BlockCopyWait();
+		}
+	}
+
+	fb_free();
+
+	STM32IPL_TRACE_END(TiledRoi)
+
+	return res;
+}
+
+///@cond
+/* Sum of the absolute differences of n pixels; the channels of RGB565 pixels are scaled to 8 bits. */
+static uint32_t ipl_dirty_sad(const uint8_t *a, const uint8_t *b, uint32_t n, int bpp)
+{
+	uint32_t sad = 0;
+
+	if (bpp == IMAGE_BPP_RGB565) {
+#ifdef IPL_STATS_HAS_MVE
+		sad = mve_imlib_sad_rgb565((const uint16_t*)a, (const uint16_t*)b, n);
+#else
+		const uint16_t *a16 = (const uint16_t*)a;
+		const uint16_t *b16 = (const uint16_t*)b;
+
+		for (uint32_t i = 0; i < n; i++) {
+			uint32_t dr = abs((int)COLOR_RGB565_TO_R5(a16[i]) - (int)COLOR_RGB565_TO_R5(b16[i]));
+			uint32_t dg = abs((int)COLOR_RGB565_TO_G6(a16[i]) - (int)COLOR_RGB565_TO_G6(b16[i]));
+			uint32_t db = abs((int)COLOR_RGB565_TO_B5(a16[i]) - (int)COLOR_RGB565_TO_B5(b16[i]));
+
+			sad += ((dr + db) << 3) + (dg << 2);
+		}
+#endif /* IPL_STATS_HAS_MVE */
+	} else {
+		n *= (bpp == IMAGE_BPP_RGB888) ? 3 : 1;
+#ifdef IPL_STATS_HAS_MVE
+		sad = mve_imlib_sad_u8(a, b, n);
+#else
+		for (uint32_t i = 0; i < n; i++)
+			sad += abs((int)a[i] - (int)b[i]);
+#endif /* IPL_STATS_HAS_MVE */
+	}
+
+	return sad;
+}
+
+/* Gets the region of the image covered by the given tile. */
+static void ipl_dirty_rect(const stm32ipl_dirty_tiles_t *tracker, uint32_t tx, uint32_t ty, rectangle_t *r)
+{
+	r->x = tx * tracker->tileSize;
+	r->y = ty * tracker->tileSize;
+	r->w = IM_MIN(tracker->tileSize, tracker->ref.w - r->x);
+	r->h = IM_MIN(tracker->tileSize, tracker->ref.h - r->y);
+}
+
+/* Copies the given tile of the image to the reference frame. */
+static void ipl_dirty_copy(stm32ipl_dirty_tiles_t *tracker, const image_t *img, uint32_t tx, uint32_t ty)
+{
+	uint32_t bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)img->bpp);
+	uint32_t srcStride = STM32Ipl_ImageStride(img);
+	uint32_t refStride = STM32Ipl_ImageStride(&tracker->ref);
+	rectangle_t r;
+
+	ipl_dirty_rect(tracker, tx, ty, &r);
+
+	for (int y = r.y; y < (r.y + r.h); y++)
+		memcpy(tracker->ref.data + (y * refStride) + (r.x * bpp), img->data + (y * srcStride) + (r.x * bpp),
+				r.w * bpp);
+}
+
+/* Marks the tiles whose mean absolute difference from the reference frame is greater than the threshold;
+ * the differences of a row of tiles are accumulated a line at a time. */
+static void ipl_dirty_update_sad(stm32ipl_dirty_tiles_t *tracker, const image_t *img, uint32_t *sad)
+{
+	uint32_t bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)img->bpp);
+	uint32_t srcStride = STM32Ipl_ImageStride(img);
+	uint32_t refStride = STM32Ipl_ImageStride(&tracker->ref);
+	uint32_t channels = (img->bpp == IMAGE_BPP_GRAYSCALE) ? 1 : 3;
+
+	for (uint32_t ty = 0; ty < tracker->tilesY; ty++) {
+		rectangle_t r;
+
+		ipl_dirty_rect(tracker, 0, ty, &r);
+		memset(sad, 0, tracker->tilesX * sizeof(uint32_t));
+
+		for (int y = r.y; y < (r.y + r.h); y++) {
+			const uint8_t *srcRow = img->data + (y * srcStride);
+			const uint8_t *refRow = tracker->ref.data + (y * refStride);
+
+			for (uint32_t tx = 0, x = 0; tx < tracker->tilesX; tx++, x += tracker->tileSize)
+				sad[tx] += ipl_dirty_sad(srcRow + (x * bpp), refRow + (x * bpp),
+						IM_MIN(tracker->tileSize, img->w - x), img->bpp);
+		}
+
+		for (uint32_t tx = 0; tx < tracker->tilesX; tx++) {
+			ipl_dirty_rect(tracker, tx, ty, &r);
+			tracker->dirty[(ty * tracker->tilesX) + tx] = (sad[tx] > (tracker->threshold * r.w * r.h * channels));
+		}
+	}
+}
+
+/* Marks the tiles with an 8x8 block whose SSIM with the reference frame is lower than the threshold. */
+static void ipl_dirty_update_ssim(stm32ipl_dirty_tiles_t *tracker, const image_t *img, float *map)
+{
+	uint32_t blocksX = (img->w + 7) / 8;
+	uint32_t blocksY = (img->h + 7) / 8;
+	uint32_t blocks = tracker->tileSize / 8;
+	float avg;
+	float std;
+	float min;
+	float max;
+
+	imlib_get_similarity((image_t*)img, NULL, &tracker->ref, 0, &avg, &std, &min, &max, map);
+
+	for (uint32_t ty = 0; ty < tracker->tilesY; ty++) {
+		for (uint32_t tx = 0; tx < tracker->tilesX; tx++) {
+			uint32_t bx1 = IM_MIN((tx + 1) * blocks, blocksX);
+			uint32_t by1 = IM_MIN((ty + 1) * blocks, blocksY);
+			bool changed = false;
+
+			for (uint32_t by = ty * blocks; (by < by1) && !changed; by++)
+				for (uint32_t bx = tx * blocks; (bx < bx1) && !changed; bx++)
+					changed = (map[(by * blocksX) + bx] < tracker->threshold);
+
+			tracker->dirty[(ty * tracker->tilesX) + tx] = changed;
+		}
+	}
+}
+///@endcond
+
+/**
+ * @brief Creates a dirty tile tracker, that tells which tiles of each frame of a video stream changed, so that
+ * the processing of the tiles that did not change can be skipped (see STM32Ipl_DirtyTiled()). The frame is divided
+ * in square tiles of the given size (the right and bottom ones can be smaller); STM32Ipl_DirtyTilesUpdate()
+ * compares each tile with a reference frame, that keeps each tile as it was the last time it changed, so that a slow
+ * change accumulates until it is detected. The buffers are allocated by this function and must be released with
+ * STM32Ipl_DirtyTilesRelease().
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param tracker	Tracker; if it is not valid, an error is returned.
+ * @param width		Width of the frames.
+ * @param height	Height of the frames.
+ * @param format	Format of the frames.
+ * @param tileSize	Size (pixels) of the tiles, e.g. 16 or 32; it must be a positive multiple of 8, otherwise an
+ * error is returned.
+ * @param metric	Metric of the change of a tile: stm32ipl_dirty_sad is the cheapest, stm32ipl_dirty_ssim is less
+ * sensitive to the changes of brightness and to the noise.
+ * @param threshold	With stm32ipl_dirty_sad, minimum mean absolute difference of the pixel values (in the range
+ * [0, 255], for each channel of the color pixels) of a changed tile; with stm32ipl_dirty_ssim, a tile changed if
+ * the SSIM of one of its 8x8 blocks is lower than threshold (in the range [-1, 1]).
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DirtyTilesInit(stm32ipl_dirty_tiles_t *tracker, uint32_t width, uint32_t height,
+		image_bpp_t format, uint16_t tileSize, stm32ipl_dirty_metric_t metric, float threshold)
+{
+	stm32ipl_err_t res;
+	image_t *ref;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker)
+
+	if (!width || !height || !tileSize || (tileSize & 7)
+			|| ((metric != stm32ipl_dirty_sad) && (metric != stm32ipl_dirty_ssim)))
+		return stm32ipl_err_InvalidParameter;
+
+	memset(tracker, 0, sizeof(stm32ipl_dirty_tiles_t));
+
+	ref = &tracker->ref;
+	STM32Ipl_Init(ref, width, height, format, NULL);
+	STM32IPL_CHECK_FORMAT(ref, (stm32ipl_if_grayscale | stm32ipl_if_rgb565 | stm32ipl_if_rgb888))
+
+	tracker->tileSize = tileSize;
+	tracker->tilesX = (width + tileSize - 1) / tileSize;
+	tracker->tilesY = (height + tileSize - 1) / tileSize;
+	tracker->metric = metric;
+	tracker->threshold = threshold;
+
+	res = STM32Ipl_AllocData(ref, width, height, format);
+	if (res != stm32ipl_err_Ok)
+		return res;
+
+	tracker->dirty = xalloc0(tracker->tilesX * tracker->tilesY);
+	if (!tracker->dirty) {
+		STM32Ipl_DirtyTilesRelease(tracker);
+		return stm32ipl_err_OutOfMemory;
+	}
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Finds the tiles of a new frame that changed from the reference frame and copies them to it. All the tiles
+ * of the first frame, and of the first one after STM32Ipl_DirtyTilesReset(), are changed. The result is kept in
+ * the tracker until the next frame, and can be used by any number of STM32Ipl_DirtyTiled() and
+ * STM32Ipl_DirtyTilesForEach() calls. The whole frame is read, at a small fraction of the cost of most operations.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param tracker	Tracker, initialized by STM32Ipl_DirtyTilesInit(); if it is not valid, an error is returned.
+ * @param img		New frame; it must have the format and the size given to STM32Ipl_DirtyTilesInit(),
+ * otherwise an error is returned.
+ * @param count		Optional number of tiles that changed.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DirtyTilesUpdate(stm32ipl_dirty_tiles_t *tracker, const image_t *img, uint32_t *count)
+{
+	const image_t *ref;
+	uint32_t nTiles;
+	uint32_t size = 0;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker)
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker->dirty)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+
+	ref = &tracker->ref;
+	STM32IPL_CHECK_SAME_HEADER(img, ref)
+
+	nTiles = tracker->tilesX * tracker->tilesY;
+
+	if (tracker->valid) {
+		if (tracker->metric == stm32ipl_dirty_sad)
+			size = tracker->tilesX * sizeof(uint32_t);
+		else
+			size = ((img->w + 7) / 8) * ((img->h + 7) / 8) * sizeof(float);
+
+		if (fb_avail() < size)
+			return stm32ipl_err_OutOfMemory;
+	}
+
+	STM32IPL_TRACE_BEGIN(DirtyTilesUpdate)
+
+	if (!tracker->valid) {
+		memset(tracker->dirty, 1, nTiles);
+		tracker->valid = true;
+	} else {
+		void *buffer = fb_alloc(size, FB_ALLOC_PREFER_SPEED);
+
+		if (tracker->metric == stm32ipl_dirty_sad)
+			ipl_dirty_update_sad(tracker, img, (uint32_t*)buffer);
+		else
+			ipl_dirty_update_ssim(tracker, img, (float*)buffer);
+
+		fb_free();
+	}
+
+	tracker->count = 0;
+	for (uint32_t i = 0; i < nTiles; i++) {
+		if (tracker->dirty[i]) {
+			ipl_dirty_copy(tracker, img, i % tracker->tilesX, i / tracker->tilesX);
+			tracker->count++;
+		}
+	}
+
+	if (count)
+		*count = tracker->count;
+
+	STM32IPL_TRACE_END(DirtyTilesUpdate)
+
+	return stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Makes all the tiles of the next frame changed, e.g. when the parameters of the operations change, so that
+ * the outputs kept by STM32Ipl_DirtyTiled() are computed again.
+ * @param tracker	Tracker, initialized by STM32Ipl_DirtyTilesInit().
+ * @return			void.
+ */
+void STM32Ipl_DirtyTilesReset(stm32ipl_dirty_tiles_t *tracker)
+{
+	if (tracker)
+		tracker->valid = false;
+}
+
+/**
+ * @brief Executes an image processing operation, as STM32Ipl_Tiled() with the tiles of the tracker, but only on the
+ * tiles whose output may have changed since the last frame: the tiles that changed and the ones within halo pixels
+ * from them. The destination image keeps the output of the other tiles, so it must be the same image at each frame
+ * and must not be modified by the application; all the tiles are processed until the first frame is given to
+ * STM32Ipl_DirtyTilesUpdate(). The operation can be any operation supported by STM32Ipl_Tiled(), e.g. a filter
+ * (STM32Ipl_Gaussian(), STM32Ipl_Sobel(), ...), a morphological operation or a binarization that keeps the format;
+ * STM32Ipl_EdgeCanny() runs with a halo too, but its hysteresis does not follow the weak edges beyond the halo.
+ * When the destination image is the source of another STM32Ipl_DirtyTiled() call, the halo of the latter must
+ * include the one of the former (e.g. their sum), as its source changes around the changed tiles too.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param tracker	Tracker, updated with the source frame by STM32Ipl_DirtyTilesUpdate(); if it is not valid,
+ * an error is returned.
+ * @param src		Source image; it must have the format and the size of the tracker, otherwise an error is
+ * returned.
+ * @param dst		Destination image, kept across the frames; it must have the same format and resolution of the
+ * source one and a different data buffer; if it is not valid, an error is returned.
+ * @param halo		Number of pixels added on each side of the tiles, as in STM32Ipl_Tiled().
+ * @param op		Operation executed on each tile to be processed; when it returns an error, the processing is
+ * stopped and the error is returned.
+ * @param arg		Argument passed to the operation.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DirtyTiled(const stm32ipl_dirty_tiles_t *tracker, const image_t *src, image_t *dst,
+		uint8_t halo, stm32ipl_tile_op_t op, void *arg)
+{
+	stm32ipl_err_t res;
+	const image_t *ref;
+	uint32_t nBuffers;
+	uint32_t size;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker)
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker->dirty)
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_SAME_HEADER(src, dst)
+	STM32IPL_CHECK_VALID_PTR_ARG(op)
+
+	ref = &tracker->ref;
+	STM32IPL_CHECK_SAME_HEADER(src, ref)
+
+	if (src->data == dst->data)
+		return stm32ipl_err_InvalidParameter;
+
+	nBuffers = ipl_tiled_buffers(src, tracker->tileSize, tracker->tileSize, halo, &size);
+	if (!nBuffers)
+		return stm32ipl_err_OutOfMemory;
+
+	STM32IPL_TRACE_BEGIN(DirtyTiled)
+
+	res = ipl_tiled_run(src, dst, tracker->tileSize, tracker->tileSize, halo, op, arg, size, nBuffers,
+			tracker->valid ? tracker : NULL);
+
+	STM32IPL_TRACE_END(DirtyTiled)
+
+	return res;
+}
+
+/**
+ * @brief Calls the given function on each tile that changed in the last frame (all of them until the first frame is
+ * given to STM32Ipl_DirtyTilesUpdate()), e.g. to update the statistics of the tiles (STM32Ipl_GetHistogram(),
+ * STM32Ipl_GetStatistics(), STM32Ipl_CountNonZero(), ...) kept by the application for each tile index, so that the
+ * statistics of the frame are combined from the ones of the tiles without computing again the ones that did not
+ * change. Each tile is given as a view of the image, without any copy.
+ * The supported formats are Grayscale, RGB565, RGB888.
+ * @param tracker	Tracker, updated with the frame by STM32Ipl_DirtyTilesUpdate(); if it is not valid, an error is
+ * returned.
+ * @param img		Image; it must have the format and the size of the tracker, otherwise an error is returned.
+ * @param visit		Function called on each changed tile; when it returns an error, the processing is stopped and
+ * the error is returned.
+ * @param arg		Argument passed to the function.
+ * @return			stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_DirtyTilesForEach(const stm32ipl_dirty_tiles_t *tracker, const image_t *img,
+		stm32ipl_tile_visit_t visit, void *arg)
+{
+	stm32ipl_err_t res = stm32ipl_err_Ok;
+	const image_t *ref;
+	uint32_t nTiles;
+
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker)
+	STM32IPL_CHECK_VALID_PTR_ARG(tracker->dirty)
+	STM32IPL_CHECK_VALID_IMAGE(img)
+	STM32IPL_CHECK_VALID_PTR_ARG(visit)
+
+	ref = &tracker->ref;
+	STM32IPL_CHECK_SAME_HEADER(img, ref)
+
+	STM32IPL_TRACE_BEGIN(DirtyTilesForEach)
+
+	nTiles = tracker->tilesX * tracker->tilesY;
+
+	for (uint32_t i = 0; (i < nTiles) && (res == stm32ipl_err_Ok); i++) {
+		if (!tracker->valid || tracker->dirty[i]) {
+			rectangle_t r;
+			image_t view;
+
+			ipl_dirty_rect(tracker, i % tracker->tilesX, i / tracker->tilesX, &r);
+			res = STM32Ipl_InitView(img, &r, &view);
+			if (res == stm32ipl_err_Ok)
+				res = visit(&view, i, arg);
+		}
+	}
+
+	STM32IPL_TRACE_END(DirtyTilesForEach)
+
+	return res;
+}
+
+/**
+ * @brief Releases the buffers of a dirty tile tracker.
+ * @param tracker	Tracker, initialized by STM32Ipl_DirtyTilesInit().
+ * @return			void.
+ */
+void STM32Ipl_DirtyTilesRelease(stm32ipl_dirty_tiles_t *tracker)
+{
+	if (tracker) {
+		STM32Ipl_ReleaseData(&tracker->ref);
+		xfree(tracker->dirty);
+		memset(tracker, 0, sizeof(stm32ipl_dirty_tiles_t));
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,203 @@
+/**
+ ******************************************************************************
+ * @file   stm32ipl_trace.c
+ * @author SRA AI Application Team
+ * @brief  STM32 Image Processing Library - tracing module
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include "stm32ipl.h"
+
+#if defined(STM32IPL_ENABLE_TRACE) || defined(STM32IPL_ENABLE_PERF_COUNTERS)
+
+#if defined(STM32IPL_ENABLE_TRACE) && (STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_SYSVIEW)
+#include "SEGGER_SYSVIEW.h"
+#endif /* STM32IPL_ENABLE_TRACE && STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_SYSVIEW */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+///@cond
+#ifdef STM32IPL_ENABLE_TRACE
+#if STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING
+#if (STM32IPL_TRACE_RING_SIZE == 0) || ((STM32IPL_TRACE_RING_SIZE & (STM32IPL_TRACE_RING_SIZE - 1)) != 0)
+#error "STM32IPL_TRACE_RING_SIZE must be a power of 2"
+#endif
+
+static stm32ipl_trace_event_t ipl_trace_ring[STM32IPL_TRACE_RING_SIZE];
+static volatile uint32_t ipl_trace_head;	/* Number of events written since the last reset. */
+static volatile uint32_t ipl_trace_tail;	/* Number of events read or overwritten since the last reset. */
+
+static void ipl_trace_record(stm32ipl_trace_id_t id, uint16_t end)
+{
+	uint32_t head = ipl_trace_head;
+	stm32ipl_trace_event_t *event = &ipl_trace_ring[head & (STM32IPL_TRACE_RING_SIZE - 1)];
+
+	event->cycles = STM32Ipl_CycleCounterGet();
+	event->id = (uint16_t)id;
+	event->end = end;
+
+	head++;
+	ipl_trace_head = head;
+
+	/* When the buffer is full, the oldest event is overwritten. */
+	if ((head - ipl_trace_tail) > STM32IPL_TRACE_RING_SIZE)
+		ipl_trace_tail = head - STM32IPL_TRACE_RING_SIZE;
+}
+
+#elif STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_ITM
+#ifndef STM32IPL_TRACE_ITM_PORT
+#define STM32IPL_TRACE_ITM_PORT	1
+#endif /* STM32IPL_TRACE_ITM_PORT */
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) || defined(__ARM_ARCH_8_1M_MAIN__)
+#define IPL_HAS_ITM
+#define IPL_ITM_STIM(port)		(*(volatile uint32_t*)(0xE0000000UL + 4 * (port)))	/* ITM Stimulus Port Register. */
+#define IPL_ITM_TER				(*(volatile uint32_t*)0xE0000E00UL)	/* ITM Trace Enable Register. */
+#define IPL_ITM_TCR				(*(volatile uint32_t*)0xE0000E80UL)	/* ITM Trace Control Register. */
+#define IPL_ITM_TCR_ITMENA		(1UL << 0)
+#endif
+
+/* The written word holds the function identifier in bits [14:0] and the end flag in bit 15. */
+static void ipl_trace_record(stm32ipl_trace_id_t id, uint16_t end)
+{
+#ifdef IPL_HAS_ITM
+	if ((IPL_ITM_TCR & IPL_ITM_TCR_ITMENA) && (IPL_ITM_TER & (1UL << STM32IPL_TRACE_ITM_PORT))) {
+		while (IPL_ITM_STIM(STM32IPL_TRACE_ITM_PORT) == 0)
+			;
+		IPL_ITM_STIM(STM32IPL_TRACE_ITM_PORT) = (uint32_t)id | ((uint32_t)end << 15);
+	}
+#else
+	STM32IPL_UNUSED(id);
+	STM32IPL_UNUSED(end);
+#endif /* IPL_HAS_ITM */
+}
+
+#elif STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_SYSVIEW
+static void ipl_trace_record(stm32ipl_trace_id_t id, uint16_t end)
+{
+	if (end)
+		SEGGER_SYSVIEW_OnUserStop((unsigned)id);
+	else
+		SEGGER_SYSVIEW_OnUserStart((unsigned)id);
+}
+
+#else
+#error "STM32IPL_TRACE_BACKEND is not valid"
+#endif /* STM32IPL_TRACE_BACKEND */
+#endif /* STM32IPL_ENABLE_TRACE */
+
+static const char *const ipl_trace_names[stm32ipl_trace_Count] = {
+#define IPL_TRACE_NAME(name)	"STM32Ipl_" #name,
+	STM32IPL_TRACE_IDS(IPL_TRACE_NAME)
+#undef IPL_TRACE_NAME
+};
+///@endcond
+
+/**
+ * @brief Records the start of a library function; it is called by the STM32IPL_TRACE_BEGIN hook.
+ * It also updates the performance counters, when STM32IPL_ENABLE_PERF_COUNTERS is defined.
+ * @param id	Identifier of the function.
+ * @return		void.
+ */
+void STM32Ipl_TraceBegin(stm32ipl_trace_id_t id)
+{
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+	STM32Ipl_PerfBegin(id);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+#ifdef STM32IPL_ENABLE_TRACE
+	ipl_trace_record(id, 0);
+#endif /* STM32IPL_ENABLE_TRACE */
+}
+
+/**
+ * @brief Records the end of a library function; it is called by the STM32IPL_TRACE_END hook.
+ * It also updates the performance counters, when STM32IPL_ENABLE_PERF_COUNTERS is defined.
+ * @param id	Identifier of the function.
+ * @return		void.
+ */
+void STM32Ipl_TraceEnd(stm32ipl_trace_id_t id)
+{
+#ifdef STM32IPL_ENABLE_TRACE
+	ipl_trace_record(id, 1);
+#endif /* STM32IPL_ENABLE_TRACE */
+#ifdef STM32IPL_ENABLE_PERF_COUNTERS
+	STM32Ipl_PerfEnd(id);
+#endif /* STM32IPL_ENABLE_PERF_COUNTERS */
+}
+
+#ifdef STM32IPL_ENABLE_TRACE
+/**
+ * @brief Resets the tracing: with the ring buffer backend, the cycle counter is enabled and the
+ * buffered events are discarded. It is called by STM32Ipl_InitLib().
+ * @return	void.
+ */
+void STM32Ipl_TraceReset(void)
+{
+#if STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING
+	STM32Ipl_CycleCounterInit();
+	ipl_trace_head = 0;
+	ipl_trace_tail = 0;
+#endif /* STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING */
+}
+#endif /* STM32IPL_ENABLE_TRACE */
+
+/**
+ * @brief Gets the name of a traced function.
+ * @param id	Identifier of the function.
+ * @return		Name of the function, NULL if the identifier is not valid.
+ */
+const char* STM32Ipl_TraceName(stm32ipl_trace_id_t id)
+{
+	if ((uint32_t)id >= stm32ipl_trace_Count)
+		return NULL;
+
+	return ipl_trace_names[id];
+}
+
+#if defined(STM32IPL_ENABLE_TRACE) && (STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING)
+/**
+ * @brief Reads the oldest events stored in the trace ring buffer, in chronological order, and removes
+ * them from the buffer. When the buffer is full, the newest events overwrite the oldest ones, so the last
+ * STM32IPL_TRACE_RING_SIZE events are always available, e.g. to inspect the calls of a slow frame.
+ * The elapsed time of a function is the difference between the cycles of its end and start events.
+ * @param events	Array that receives the events; if it is not valid, no event is read.
+ * @param maxEvents	Number of elements of the events array.
+ * @return			Number of events read.
+ */
+uint32_t STM32Ipl_TraceRead(stm32ipl_trace_event_t *events, uint32_t maxEvents)
+{
+	uint32_t count;
+
+	if (!events)
+		return 0;
+
+	count = ipl_trace_head - ipl_trace_tail;
+	if (count > maxEvents)
+		count = maxEvents;
+
+	for (uint32_t i = 0; i < count; i++)
+		events[i] = ipl_trace_ring[(ipl_trace_tail + i) & (STM32IPL_TRACE_RING_SIZE - 1)];
+
+	ipl_trace_tail += count;
+
+	return count;
+}
+#endif /* STM32IPL_ENABLE_TRACE && STM32IPL_TRACE_BACKEND == STM32IPL_TRACE_RING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32IPL_ENABLE_TRACE || STM32IPL_ENABLE_PERF_COUNTERS */
@@ -24,11 +24,265 @@
 #include "stm32ipl.h"
 #include "stm32ipl_imlib_int.h"
 #include "matd.h"
+#ifdef IPL_DEWARP_HAS_MVE
+#include "mve_dewarp.h"
+#endif /* IPL_DEWARP_HAS_MVE */
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+///@cond
+/* Length of the spans (pixels) along which the projective divide is replaced by a linear interpolation. */
+#define IPL_WARP_SPAN_LEN	16
+
+/* Limit of the source coordinates (pixels) converted to 16.16 fixed point. */
+#define IPL_WARP_COORD_MAX	16384.0f
+
+typedef void (*ipl_warp_span_t)(const image_t *, uint8_t *, int, int32_t, int32_t, int32_t, int32_t);
+
+#ifndef IPL_DEWARP_HAS_MVE
+/* Bilinear interpolation with the x and y fractions fx, fy in 1/256 units (truncated). */
+static inline uint32_t ipl_warp_interpolate(uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3, uint32_t fx,
+		uint32_t fy)
+{
+	uint32_t top = (v0 << 8) + (v1 - v0) * fx;
+	uint32_t bottom = (v2 << 8) + (v3 - v2) * fx;
+
+	return ((top << 8) + (bottom - top) * fy) >> 16;
+}
+
+/* The span functions read the source pixels at the 16.16 fixed point locations (u + i * du, v + i * dv), that are
+ * inside the image: the next pixel (row) is clamped on the last column (row) by the bilinear ones. */
+static void ipl_warp_span_nearest_grayscale(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	for (; n > 0; n--, u += du, v += dv)
+		*dst++ = src->data[(((v + 0x8000) >> 16) * src->w) + ((u + 0x8000) >> 16)];
+}
+
+static void ipl_warp_span_bilinear_grayscale(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	for (; n > 0; n--, u += du, v += dv) {
+		int32_t x = u >> 16;
+		int32_t y = v >> 16;
+		const uint8_t *p0 = src->data + (y * src->w) + x;
+		const uint8_t *p1 = (y < (src->h - 1)) ? p0 + src->w : p0;
+		uint32_t nx = (x < (src->w - 1)) ? 1 : 0;
+
+		*dst++ = ipl_warp_interpolate(p0[0], p0[nx], p1[0], p1[nx], (u >> 8) & 0xff, (v >> 8) & 0xff);
+	}
+}
+
+static void ipl_warp_span_nearest_rgb565(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	const uint16_t *data = (const uint16_t*)src->data;
+	uint16_t *out = (uint16_t*)dst;
+
+	for (; n > 0; n--, u += du, v += dv)
+		*out++ = data[(((v + 0x8000) >> 16) * src->w) + ((u + 0x8000) >> 16)];
+}
+
+static void ipl_warp_span_bilinear_rgb565(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	uint16_t *out = (uint16_t*)dst;
+
+	for (; n > 0; n--, u += du, v += dv) {
+		int32_t x = u >> 16;
+		int32_t y = v >> 16;
+		const uint16_t *p0 = ((const uint16_t*)src->data) + (y * src->w) + x;
+		const uint16_t *p1 = (y < (src->h - 1)) ? p0 + src->w : p0;
+		uint32_t nx = (x < (src->w - 1)) ? 1 : 0;
+		uint32_t fx = (u >> 8) & 0xff;
+		uint32_t fy = (v >> 8) & 0xff;
+		uint32_t v0 = p0[0];
+		uint32_t v1 = p0[nx];
+		uint32_t v2 = p1[0];
+		uint32_t v3 = p1[nx];
+		uint32_t r = ipl_warp_interpolate(v0 >> 11, v1 >> 11, v2 >> 11, v3 >> 11, fx, fy);
+		uint32_t g = ipl_warp_interpolate((v0 >> 5) & 0x3f, (v1 >> 5) & 0x3f, (v2 >> 5) & 0x3f, (v3 >> 5) & 0x3f,
+				fx, fy);
+		uint32_t b = ipl_warp_interpolate(v0 & 0x1f, v1 & 0x1f, v2 & 0x1f, v3 & 0x1f, fx, fy);
+
+		*out++ = (r << 11) | (g << 5) | b;
+	}
+}
+
+static void ipl_warp_span_nearest_rgb888(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	for (; n > 0; n--, u += du, v += dv) {
+		const uint8_t *p = src->data + ((((v + 0x8000) >> 16) * src->w) + ((u + 0x8000) >> 16)) * 3;
+
+		*dst++ = p[0];
+		*dst++ = p[1];
+		*dst++ = p[2];
+	}
+}
+
+static void ipl_warp_span_bilinear_rgb888(const image_t *src, uint8_t *dst, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	for (; n > 0; n--, u += du, v += dv) {
+		int32_t x = u >> 16;
+		int32_t y = v >> 16;
+		const uint8_t *p0 = src->data + ((y * src->w) + x) * 3;
+		const uint8_t *p1 = (y < (src->h - 1)) ? p0 + (src->w * 3) : p0;
+		uint32_t nx = (x < (src->w - 1)) ? 3 : 0;
+		uint32_t fx = (u >> 8) & 0xff;
+		uint32_t fy = (v >> 8) & 0xff;
+
+		for (uint32_t c = 0; c < 3; c++)
+			*dst++ = ipl_warp_interpolate(p0[c], p0[nx + c], p1[c], p1[nx + c], fx, fy);
+	}
+}
+
+#define IPL_WARP_SPAN_FCT(name) ipl_warp_span_##name
+#else
+#define IPL_WARP_SPAN_FCT(name) mve_dewarp_span_##name
+#endif /* IPL_DEWARP_HAS_MVE */
+
+static void ipl_warp_span_nearest_binary(const image_t *src, uint32_t *row, int x, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv)
+{
+	for (; n > 0; n--, x++, u += du, v += dv) {
+		uint32_t *ptr = ((uint32_t*)src->data) + (((src->w + UINT32_T_MASK) >> UINT32_T_SHIFT) * ((v + 0x8000) >> 16));
+		IMAGE_PUT_BINARY_PIXEL_FAST(row, x, IMAGE_GET_BINARY_PIXEL_FAST(ptr, (u + 0x8000) >> 16));
+	}
+}
+
+/* Returns true if the 16.16 fixed point location (u, v) is read inside the source image. */
+static inline bool ipl_warp_inside(const image_t *src, int32_t u, int32_t v, bool bilinear)
+{
+	if (!bilinear) {
+		u += 0x8000;
+		v += 0x8000;
+	}
+
+	return (u >= 0) && (v >= 0) && ((u >> 16) < src->w) && ((v >> 16) < src->h);
+}
+
+/* Gets the source location of the destination pixel (x, y) in 16.16 fixed point; returns false if it is not defined
+ * (e.g. behind the camera for a perspective transformation). */
+static bool ipl_warp_locate(const float *T, float x, float y, int32_t *u, int32_t *v)
+{
+	float z = (T[6] * x) + (T[7] * y) + T[8];
+	float fu;
+	float fv;
+
+	if (z < MATD_EPS)
+		return false;
+
+	fu = ((T[0] * x) + (T[1] * y) + T[2]) / z;
+	fv = ((T[3] * x) + (T[4] * y) + T[5]) / z;
+
+	if ((fast_fabsf(fu) > IPL_WARP_COORD_MAX) || (fast_fabsf(fv) > IPL_WARP_COORD_MAX))
+		return false;
+
+	*u = (int32_t)(fu * 65536.0f);
+	*v = (int32_t)(fv * 65536.0f);
+
+	return true;
+}
+
+/* Processes a span of n destination pixels, starting at x, whose source locations are linearly interpolated:
+ * the pixels at the ends of the span mapped outside the source image are zeroed (the inner ones are inside too,
+ * as the source locations lie on a segment). */
+static void ipl_warp_span(const image_t *src, image_t *dst, uint8_t *row, int x, int n, int32_t u, int32_t v,
+		int32_t du, int32_t dv, bool bilinear, ipl_warp_span_t span)
+{
+	uint32_t bpp = STM32Ipl_DataSize(1, 1, (image_bpp_t)dst->bpp);
+	uint32_t *binRow = (uint32_t*)row;
+
+	while ((n > 0) && !ipl_warp_inside(src, u, v, bilinear)) {
+		if (dst->bpp == IMAGE_BPP_BINARY)
+			IMAGE_CLEAR_BINARY_PIXEL_FAST(binRow, x);
+		else
+			memset(row + (x * bpp), 0, bpp);
+		x++;
+		n--;
+		u += du;
+		v += dv;
+	}
+
+	while ((n > 0) && !ipl_warp_inside(src, u + ((n - 1) * du), v + ((n - 1) * dv), bilinear)) {
+		n--;
+		if (dst->bpp == IMAGE_BPP_BINARY)
+			IMAGE_CLEAR_BINARY_PIXEL_FAST(binRow, x + n);
+		else
+			memset(row + ((x + n) * bpp), 0, bpp);
+	}
+
+	if (n > 0) {
+		if (dst->bpp == IMAGE_BPP_BINARY)
+			ipl_warp_span_nearest_binary(src, binRow, x, n, u, v, du, dv);
+		else
+			span(src, row + (x * bpp), n, u, v, du, dv);
+	}
+}
+
+/* Warps src to dst with the transformation T (3x3, row major), that maps the destination pixels to the source ones.
+ * The source locations are computed incrementally in fixed point: the exact location (with the projective divide)
+ * is computed at the ends of spans of IPL_WARP_SPAN_LEN pixels (of the whole row for an affine transformation) and
+ * linearly interpolated in between. */
+static void ipl_warp(const image_t *src, image_t *dst, const float *T, dewarping_algo_t algo)
+{
+	bool affine = (fast_fabsf(T[6]) < MATD_EPS) && (fast_fabsf(T[7]) < MATD_EPS);
+	bool bilinear = (algo == DEWARP_BILINEAR) && (src->bpp != IMAGE_BPP_BINARY);
+	int spanLen = affine ? dst->w : IPL_WARP_SPAN_LEN;
+	uint32_t stride = STM32Ipl_ImageStride(dst);
+	ipl_warp_span_t span;
+
+	switch (src->bpp) {
+		case IMAGE_BPP_GRAYSCALE:
+			span = bilinear ? IPL_WARP_SPAN_FCT(bilinear_grayscale) : IPL_WARP_SPAN_FCT(nearest_grayscale);
+			break;
+		case IMAGE_BPP_RGB565:
+			span = bilinear ? IPL_WARP_SPAN_FCT(bilinear_rgb565) : IPL_WARP_SPAN_FCT(nearest_rgb565);
+			break;
+		case IMAGE_BPP_RGB888:
+			span = bilinear ? IPL_WARP_SPAN_FCT(bilinear_rgb888) : IPL_WARP_SPAN_FCT(nearest_rgb888);
+			break;
+		default:
+			span = NULL;
+			break;
+	}
+
+	for (int y = 0; y < dst->h; y++) {
+		uint8_t *row = dst->data + (y * stride);
+
+		for (int x = 0; x < dst->w; x += spanLen) {
+			int n = IM_MIN(spanLen, dst->w - x);
+			int32_t u0, v0, u1, v1;
+
+			if (ipl_warp_locate(T, x, y, &u0, &v0) && ipl_warp_locate(T, x + n, y, &u1, &v1)) {
+				ipl_warp_span(src, dst, row, x, n, u0, v0, (u1 - u0) / n, (v1 - v0) / n, bilinear, span);
+			} else {
+				/* the span crosses the horizon: the pixels are processed one by one */
+				for (int i = x; i < (x + n); i++) {
+					if (!ipl_warp_locate(T, i, y, &u0, &v0))
+						u0 = v0 = INT32_MIN;
+					ipl_warp_span(src, dst, row, i, 1, u0, v0, 0, 0, bilinear, span);
+				}
+			}
+		}
+	}
+}
+
+/* Inverts the 3x3 transformation T (row major), in place; returns false if it is not invertible. */
+static bool ipl_warp_invert(float *T)
+{
+	matf_t M;
+
+	matf_init(&M, 3, 3, T);
+
+	return (matf_inverse(&M, &M) == ARM_MATH_SUCCESS);
+}
+///@endcond
+
 /**
  * @brief Calculates the affine transformation matrix from three pairs of corresponding
  * source and destination points.
@@ -39,21 +293,20 @@ extern "C" {
  * @param affine	Vector of six numbers representing the 2×3 affine transformation matrix;
  * it must be valid, otherwise an error is returned. The first 3 elements correspond to the
  * the first line of the matrix, while the last 3 elements correspond to the second line.
- * @return			stm32ipl_err_Ok on success, error otherwise.
+ * @return			stm32ipl_err_Ok on success, error otherwise (also when the source points are collinear).
  */
 stm32ipl_err_t STM32Ipl_GetAffineTransform(const point_t *src, const point_t *dst, float *affine)
 {
 	float a[6 * 6];
 	float b[6];
-	matd_t *A;
-	matd_t *B;
-	matd_t *M;
+	matf_t A;
 
 	if (!src || !dst || !affine)
 		return stm32ipl_err_InvalidParameter;
 
-	A = matd_create(6, 6);
-	B = matd_create(6, 1);
+	/* The source points must not be collinear. */
+	if (((src[1].x - src[0].x) * (src[2].y - src[0].y)) == ((src[2].x - src[0].x) * (src[1].y - src[0].y)))
+		return stm32ipl_err_InvalidParameter;
 
 	for (uint8_t i = 0; i < 3; i++) {
 		uint8_t j;
@@ -69,32 +322,20 @@ stm32ipl_err_t STM32Ipl_GetAffineTransform(const point_t *src, const point_t *ds
 		b[i * 2 + 1] = dst[i].y;
 	}
 
-	for (int i = 0; i < 6; i++)
-		for (int j = 0; j < 6; j++) {
-			MATD_EL(A, i, j)= a[i * 6 + j];
-		}
-
-	for (int i = 0; i < 6; i++)
-		for (int j = 0; j < 1; j++) {
-			MATD_EL(B, i, j)= b[i];
-		}
-
-	M = matd_solve(A, B);
+	matf_init(&A, 6, 6, a);
 
-	for (int i = 0; i < 6; i++) {
-		affine[i] = MATD_EL(M, i, 0);
-	}
-
-	matd_destroy(M);
-	matd_destroy(B);
-	matd_destroy(A);
+	if (matf_solve(&A, b, affine) != ARM_MATH_SUCCESS)
+		return stm32ipl_err_InvalidParameter;
 
 	return stm32ipl_err_Ok;
 }
 
 /**
  * @brief Applies an affine transformation matrix to an image. The content of the provided image
- * is overwritten with the result of the transformation.
+ * is overwritten with the result of the transformation; the pixels mapped outside the image are zeroed.
+ * The source locations are computed incrementally in fixed point (see STM32Ipl_WarpPerspective()), with nearest
+ * neighbor sampling; for bilinear sampling, pass the affine matrix to STM32Ipl_WarpPerspective() with (0, 0, 1)
+ * as third row.
  * The supported formats are (Binary, Grayscale, RGB565, RGB888).
  * @param img		Image; it must be valid, otherwise an error is returned.
  * @param affine	Vector of six numbers representing the 2×3 affine transformation matrix;
@@ -105,12 +346,8 @@ stm32ipl_err_t STM32Ipl_GetAffineTransform(const point_t *src, const point_t *ds
 stm32ipl_err_t STM32Ipl_WarpAffine(image_t *img, const float *affine)
 {
 	stm32ipl_err_t res;
-	uint32_t h;
-	uint32_t w;
-	float p[9];
+	float T[9];
 	image_t aux;
-	matd_t *T3;
-	matd_t *T4;
 
 	STM32IPL_CHECK_VALID_IMAGE(img)
 	STM32IPL_CHECK_FORMAT(img, STM32IPL_IF_ALL)
@@ -118,220 +355,138 @@ stm32ipl_err_t STM32Ipl_WarpAffine(image_t *img, const float *affine)
 	if (!affine)
 		return stm32ipl_err_InvalidParameter;
 
-	h = img->h;
-	w = img->w;
+	STM32IPL_TRACE_BEGIN(WarpAffine)
 
 	/* Create a temporary copy of the image to pull pixels from. */
 	STM32Ipl_Init(&aux, 0, 0, (image_bpp_t)0, 0);
 	res = STM32Ipl_Clone(img, &aux);
-	if (res)
+	if (res) {
+		STM32IPL_TRACE_END(WarpAffine)
 		return res;
-
-	/* Clear the image. */
-	memset(img->data, 0, STM32Ipl_ImageDataSize(img));
+	}
 
 	for (uint8_t i = 0; i < 6; i++) {
-		p[i] = affine[i];
+		T[i] = affine[i];
 	}
 
-	p[6] = 0;
-	p[7] = 0;
-	p[8] = 1;
-
-	T3 = matd_create_data(3, 3, p);
-	T4 = matd_inverse(T3);
-
-	if (T4) {
-		float T4_00 = MATD_EL(T4, 0, 0), T4_01 = MATD_EL(T4, 0, 1), T4_02 = MATD_EL(T4, 0, 2);
-		float T4_10 = MATD_EL(T4, 1, 0), T4_11 = MATD_EL(T4, 1, 1), T4_12 = MATD_EL(T4, 1, 2);
-		float T4_20 = MATD_EL(T4, 2, 0), T4_21 = MATD_EL(T4, 2, 1), T4_22 = MATD_EL(T4, 2, 2);
-
-		if ((fast_fabsf(T4_20) < MATD_EPS) && (fast_fabsf(T4_21) < MATD_EPS)) { /* Warp affine. */
-			T4_00 /= T4_22;
-			T4_01 /= T4_22;
-			T4_02 /= T4_22;
-			T4_10 /= T4_22;
-			T4_11 /= T4_22;
-			T4_12 /= T4_22;
-
-			switch (img->bpp) {
-				case IMAGE_BPP_BINARY: {
-					uint32_t *tmp = (uint32_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							int32_t sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-							int32_t sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY);
-								uint32_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
-				case IMAGE_BPP_GRAYSCALE: {
-					uint8_t *tmp = (uint8_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							int32_t sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-							int32_t sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint8_t *ptr = tmp + (w * sourceY);
-								uint8_t pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
-				case IMAGE_BPP_RGB565: {
-					uint16_t *tmp = (uint16_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							int32_t sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-							int32_t sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint16_t *ptr = tmp + (w * sourceY);
-								uint16_t pixel = IMAGE_GET_RGB565_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
+	T[6] = 0;
+	T[7] = 0;
+	T[8] = 1;
 
-				case IMAGE_BPP_RGB888: {
-					rgb888_t *tmp = (rgb888_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							int32_t sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-							int32_t sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								rgb888_t *ptr = tmp + (w * sourceY);
-								rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
+	if (ipl_warp_invert(T)) {
+		ipl_warp(&aux, img, T, DEWARP_NEAREST);
+	} else {
+		/* Clear the image. */
+		memset(img->data, 0, STM32Ipl_ImageDataSize(img));
+	}
 
-				default: {
-					break;
-				}
-			}
-		} else { /* Warp perspective. */
-			switch (img->bpp) {
-				case IMAGE_BPP_BINARY: {
-					uint32_t *tmp = (uint32_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							float xxx = T4_00 * x + T4_01 * y + T4_02;
-							float yyy = T4_10 * x + T4_11 * y + T4_12;
-							float zzz = T4_20 * x + T4_21 * y + T4_22;
-							int32_t sourceX = fast_roundf(xxx / zzz);
-							int32_t sourceY = fast_roundf(yyy / zzz);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY);
-								uint32_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
-				case IMAGE_BPP_GRAYSCALE: {
-					uint8_t *tmp = (uint8_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							float xxx = T4_00 * x + T4_01 * y + T4_02;
-							float yyy = T4_10 * x + T4_11 * y + T4_12;
-							float zzz = T4_20 * x + T4_21 * y + T4_22;
-							int32_t sourceX = fast_roundf(xxx / zzz);
-							int32_t sourceY = fast_roundf(yyy / zzz);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint8_t *ptr = tmp + (w * sourceY);
-								uint8_t pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
-				case IMAGE_BPP_RGB565: {
-					uint16_t *tmp = (uint16_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							float xxx = T4_00 * x + T4_01 * y + T4_02;
-							float yyy = T4_10 * x + T4_11 * y + T4_12;
-							float zzz = T4_20 * x + T4_21 * y + T4_22;
-							int32_t sourceX = fast_roundf(xxx / zzz);
-							int32_t sourceY = fast_roundf(yyy / zzz);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								uint16_t *ptr = tmp + (w * sourceY);
-								uint16_t pixel = IMAGE_GET_RGB565_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
+	STM32Ipl_ReleaseData(&aux);
 
-				case IMAGE_BPP_RGB888: {
-					rgb888_t *tmp = (rgb888_t*)(aux.data);
-
-					for (uint32_t y = 0, yy = h; y < yy; y++) {
-						rgb888_t *row_ptr = IMAGE_COMPUTE_RGB888_PIXEL_ROW_PTR(img, y);
-						for (uint32_t x = 0, xx = w; x < xx; x++) {
-							float xxx = T4_00 * x + T4_01 * y + T4_02;
-							float yyy = T4_10 * x + T4_11 * y + T4_12;
-							float zzz = T4_20 * x + T4_21 * y + T4_22;
-							int32_t sourceX = fast_roundf(xxx / zzz);
-							int32_t sourceY = fast_roundf(yyy / zzz);
-
-							if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-								rgb888_t *ptr = tmp + (w * sourceY);
-								rgb888_t pixel = IMAGE_GET_RGB888_PIXEL_FAST(ptr, sourceX);
-								IMAGE_PUT_RGB888_PIXEL_FAST(row_ptr, x, pixel);
-							}
-						}
-					}
-					break;
-				}
+	STM32IPL_TRACE_END(WarpAffine)
+	return stm32ipl_err_Ok;
+}
 
-				default: {
-					break;
-				}
-			}
+/**
+ * @brief Calculates the perspective transformation matrix (homography) from four pairs of corresponding
+ * source and destination points.
+ * @param src 			Vector of four source points (e.g. the corners of a tag found by STM32Ipl_FindAprilTags());
+ * it must be valid, otherwise an error is returned.
+ * @param dst			Vector of four destination points (e.g. the corners of the rectified image);
+ * it must be valid, otherwise an error is returned.
+ * @param homography	Vector of nine numbers representing the 3×3 perspective transformation matrix (row major);
+ * it must be valid, otherwise an error is returned.
+ * @return				stm32ipl_err_Ok on success, stm32ipl_err_InvalidParameter if three of the points are
+ * aligned, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_GetPerspectiveTransform(const point_t *src, const point_t *dst, float *homography)
+{
+	matd_plu_t *plu;
+	matd_t *A;
+	matd_t *B;
+	matd_t *M;
+	bool singular;
+
+	if (!src || !dst || !homography)
+		return stm32ipl_err_InvalidParameter;
+
+	A = matd_create(8, 8);
+	B = matd_create(8, 1);
+
+	for (int i = 0; i < 4; i++) {
+		float x = src[i].x;
+		float y = src[i].y;
+		float X = dst[i].x;
+		float Y = dst[i].y;
+		float a[16] = {x, y, 1, 0, 0, 0, -x * X, -y * X, 0, 0, 0, x, y, 1, -x * Y, -y * Y};
+
+		for (int j = 0; j < 8; j++) {
+			MATD_EL(A, i * 2, j) = a[j];
+			MATD_EL(A, (i * 2) + 1, j) = a[8 + j];
 		}
+
+		MATD_EL(B, i * 2, 0) = X;
+		MATD_EL(B, (i * 2) + 1, 0) = Y;
 	}
 
-	matd_destroy(T4);
-	matd_destroy(T3);
+	plu = matd_plu(A);
+	singular = plu->singular;
+	M = matd_plu_solve(plu, B);
 
-	STM32Ipl_ReleaseData(&aux);
+	for (int i = 0; i < 8; i++) {
+		homography[i] = MATD_EL(M, i, 0);
+	}
+
+	homography[8] = 1;
+
+	matd_destroy(M);
+	matd_plu_destroy(plu);
+	matd_destroy(B);
+	matd_destroy(A);
+
+	return singular ? stm32ipl_err_InvalidParameter : stm32ipl_err_Ok;
+}
+
+/**
+ * @brief Applies a perspective transformation matrix (homography) to an image: each destination pixel (x, y) is
+ * read from the source image at the location obtained by applying the inverse transformation to (x, y); the pixels
+ * mapped outside the source image are zeroed. The source locations are computed incrementally in 16.16 fixed point:
+ * the projective divide is done only at the ends of spans of 16 pixels, the depth term being linearly interpolated
+ * along the span, and for an affine transformation (third row equal to (0, 0, 1)) only once per row.
+ * Typical use is the rectification of a region found by STM32Ipl_FindAprilTags() or STM32Ipl_FindTemplate():
+ * the homography mapping its corners to the corners of dst is obtained with STM32Ipl_GetPerspectiveTransform().
+ * The supported formats are Binary (only nearest sampling), Grayscale, RGB565, RGB888.
+ * @param src			Source image; it must be valid, otherwise an error is returned; views are not supported.
+ * @param dst			Destination image; it must have the same format of src and a different data buffer; it can
+ * have a different resolution; if it is not valid, an error is returned.
+ * @param homography	Vector of nine numbers representing the 3×3 transformation matrix (row major), mapping
+ * the source points to the destination ones; it must be valid and invertible, otherwise an error is returned.
+ * @param algo			Sampling algorithm: DEWARP_NEAREST or DEWARP_BILINEAR.
+ * @return				stm32ipl_err_Ok on success, error otherwise.
+ */
+stm32ipl_err_t STM32Ipl_WarpPerspective(const image_t *src, image_t *dst, const float *homography,
+		dewarping_algo_t algo)
+{
+	float T[9];
+
+	STM32IPL_CHECK_VALID_IMAGE(src)
+	STM32IPL_CHECK_VALID_IMAGE(dst)
+	STM32IPL_CHECK_FORMAT(src, STM32IPL_IF_ALL)
+	STM32IPL_CHECK_SAME_FORMAT(src, dst)
+	STM32IPL_CHECK_NOT_VIEW(src)
+
+	if (!homography || (src->data == dst->data) || ((algo != DEWARP_NEAREST) && (algo != DEWARP_BILINEAR)))
+		return stm32ipl_err_InvalidParameter;
+
+	for (uint8_t i = 0; i < 9; i++) {
+		T[i] = homography[i];
+	}
+
+	if (!ipl_warp_invert(T))
+		return stm32ipl_err_InvalidParameter;
+
+	STM32IPL_TRACE_BEGIN(WarpPerspective)
+	ipl_warp(src, dst, T, algo);
+	STM32IPL_TRACE_END(WarpPerspective)
 
 	return stm32ipl_err_Ok;
 }
@@ -348,57 +503,17 @@ stm32ipl_err_t STM32Ipl_WarpAffine(image_t *img, const float *affine)
  */
 stm32ipl_err_t STM32Ipl_WarpAffinePoints(point_t *points, uint32_t nPoints, const float *affine)
 {
-	float p[9];
-	matd_t *T4;
-
 	if (!points || !affine)
 		return stm32ipl_err_InvalidParameter;
 
-	for (uint8_t i = 0; i < 6; i++) {
-		p[i] = affine[i];
-	}
-	p[6] = 0;
-	p[7] = 0;
-	p[8] = 1;
-
-	T4 = matd_create_data(3, 3, p);
-
-	if (T4) {
-		float T4_00 = MATD_EL(T4, 0, 0), T4_01 = MATD_EL(T4, 0, 1), T4_02 = MATD_EL(T4, 0, 2);
-		float T4_10 = MATD_EL(T4, 1, 0), T4_11 = MATD_EL(T4, 1, 1), T4_12 = MATD_EL(T4, 1, 2);
-		float T4_20 = MATD_EL(T4, 2, 0), T4_21 = MATD_EL(T4, 2, 1), T4_22 = MATD_EL(T4, 2, 2);
-
-		if ((fast_fabsf(T4_20) < MATD_EPS) && (fast_fabsf(T4_21) < MATD_EPS)) { /* Warp affine. */
-			T4_00 /= T4_22;
-			T4_01 /= T4_22;
-			T4_02 /= T4_22;
-			T4_10 /= T4_22;
-			T4_11 /= T4_22;
-			T4_12 /= T4_22;
-
-			for (uint32_t idx = 0; idx < nPoints; idx++) {
-				point_t *point = &(points[idx]);
-				int32_t sourceX = fast_roundf(T4_00 * point->x + T4_01 * point->y + T4_02);
-				int32_t sourceY = fast_roundf(T4_10 * point->x + T4_11 * point->y + T4_12);
-				point->x = (int16_t)sourceX;
-				point->y = (int16_t)sourceY;
-			}
-		} else { /* Warp perspective. */
-			for (uint32_t idx = 0; idx < nPoints; idx++) {
-				point_t *point = &(points[idx]);
-				float xxx = T4_00 * point->x + T4_01 * point->y + T4_02;
-				float yyy = T4_10 * point->x + T4_11 * point->y + T4_12;
-				float zzz = T4_20 * point->x + T4_21 * point->y + T4_22;
-				int32_t sourceX = fast_roundf(xxx / zzz);
-				int32_t sourceY = fast_roundf(yyy / zzz);
-
-				point->x = (int16_t)sourceX;
-				point->y = (int16_t)sourceY;
-			}
-		}
-	}
+	for (uint32_t idx = 0; idx < nPoints; idx++) {
+		point_t *point = &(points[idx]);
+		int32_t sourceX = fast_roundf(affine[0] * point->x + affine[1] * point->y + affine[2]);
+		int32_t sourceY = fast_roundf(affine[3] * point->x + affine[4] * point->y + affine[5]);
 
-	matd_destroy(T4);
+		point->x = (int16_t)sourceX;
+		point->y = (int16_t)sourceY;
+	}
 
 	return stm32ipl_err_Ok;
 }
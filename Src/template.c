@@ -188,6 +188,11 @@ float imlib_template_match_ds(image_t *f, image_t *t, rectangle_t *r)
         // Set the new search center to the block with highest correlation
         cx = px;
         cy = py;
+
+        // STM32IPL: stop at the deadline (see STM32Ipl_SetDeadline()), once the first pattern has been searched.
+        if (ctx_deadline_expired()) {
+            break;
+        }
     }
 
     r->x = cx;
@@ -230,8 +235,7 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
     imlib_integral_image_alloc(&sum, f->w, f->h);
     imlib_integral_image_alloc(&sumsq, f->w, f->h);
 
-    imlib_integral_image(f, &sum);
-    imlib_integral_image_sq(f, &sumsq);
+    imlib_integral_image_ss(f, &sum, &sumsq); // STM32IPL
 
     // Normalized sum of squares of the template
     int t_mean = 0;
@@ -242,8 +246,22 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
         den_b += c*c;
     }
 
-    for (int v=roi->y; v<=(roi->y+roi->h-t->h); v+=step) {
-    for (int u=roi->x; u<=(roi->x+roi->w-t->w); u+=step) {
+    // STM32IPL: with a deadline (see STM32Ipl_SetDeadline()), a first pass with a 4 times larger step covers the
+    // whole roi, so that the best position found so far is searched over all of it when the search is stopped;
+    // the second pass skips the positions of the first one.
+    int coarse_step = ctx_deadline_active() ? (step * 4) : 0;
+    for (int pass = coarse_step ? 0 : 1; pass < 2; pass++) {
+    int pass_step = pass ? step : coarse_step;
+    for (int v=roi->y; v<=(roi->y+roi->h-t->h); v+=pass_step) {
+    // STM32IPL: stop at the deadline.
+    if (ctx_deadline_expired()) {
+        break;
+    }
+    for (int u=roi->x; u<=(roi->x+roi->w-t->w); u+=pass_step) {
+        if (pass && coarse_step && (!((v - roi->y) % coarse_step)) && (!((u - roi->x) % coarse_step))) { // STM32IPL
+            continue;
+        }
+
         int num = 0;
         // The mean of the current patch
         uint32_t f_sum = imlib_integral_lookup(&sum, u, v, t->w, t->h);
@@ -273,6 +291,7 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
         }
     }
     }
+    } // STM32IPL
 
     imlib_integral_image_free(&sum);
     imlib_integral_image_free(&sumsq);
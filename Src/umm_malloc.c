@@ -78,8 +78,13 @@ UMM_H_ATTPACKPRE typedef struct umm_block_t {
 
 /* ------------------------------------------------------------------------- */
 
-umm_block *umm_heap = NULL;
-uint16_t umm_numblocks = 0;
+/* STM32IPL: the heap state is held by the instance selected with umm_select(). */
+static umm_heap_t umm_default_heap;
+static UMM_THREAD_LOCAL umm_heap_t *umm_cur_heap = &umm_default_heap;
+
+#define umm_heap      ((umm_block *)umm_cur_heap->blocks)
+#define umm_numblocks (umm_cur_heap->numblocks)
+#define ummHeapInfo   (umm_cur_heap->info)
 
 #define UMM_NUMBLOCKS  (umm_numblocks)
 #define UMM_BLOCK_LAST (UMM_NUMBLOCKS - 1)
@@ -132,7 +137,6 @@ uint16_t umm_numblocks = 0;
  * ----------------------------------------------------------------------------
  */
 
-UMM_HEAP_INFO ummHeapInfo;
 
 void *umm_info( void *ptr, bool force ) {
   if(umm_heap == NULL) {
@@ -421,16 +425,24 @@ static uint16_t umm_assimilate_down( uint16_t c, uint16_t freemask ) {
 }
 
 /* ------------------------------------------------------------------------- */
+/* STM32IPL: selects the heap used by the following calls; null selects the default heap. */
+umm_heap_t *umm_select( umm_heap_t *heap )
+{
+	umm_heap_t *prev = umm_cur_heap;
+
+	umm_cur_heap = heap ? heap : &umm_default_heap;
+
+	return prev;
+}
+
 void umm_uninit( void )
 {
-	umm_heap = NULL;
-	umm_numblocks = 0;
-	memset( &ummHeapInfo, 0, sizeof( ummHeapInfo ) );
+	memset( umm_cur_heap, 0, sizeof( umm_heap_t ) );
 }
 
 void umm_init( void *UMM_MALLOC_CFG_HEAP_ADDR, uint32_t UMM_MALLOC_CFG_HEAP_SIZE ) {
   /* init heap pointer and size, and memset it to 0 */
-  umm_heap = (umm_block *)UMM_MALLOC_CFG_HEAP_ADDR;
+  umm_cur_heap->blocks = UMM_MALLOC_CFG_HEAP_ADDR;
   umm_numblocks = (UMM_MALLOC_CFG_HEAP_SIZE / sizeof(umm_block));
   memset(umm_heap, 0x00, UMM_MALLOC_CFG_HEAP_SIZE);
 
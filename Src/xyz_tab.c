@@ -15,6 +15,8 @@
   ******************************************************************************
   */
 
+#include <stdint.h>
+
 const float xyz_table[256] = {
      0.000000f,  0.030353f,  0.060705f,  0.091058f,  0.121411f,  0.151763f,  0.182116f,  0.212469f,
      0.242822f,  0.273174f,  0.303527f,  0.334654f,  0.367651f,  0.402472f,  0.439144f,  0.477695f,
@@ -49,3 +51,120 @@ const float xyz_table[256] = {
     87.136712f, 87.962240f, 88.792312f, 89.626935f, 90.466117f, 91.309865f, 92.158186f, 93.011086f,
     93.868573f, 94.730654f, 95.597335f, 96.468625f, 97.344529f, 98.225055f, 99.110210f, 100.000000f
 };
+
+// STM32IPL: linear value of the 8 bit sRGB channel values (Q15), i.e. xyz_table / 100.
+const uint16_t xyz_lin_table[256] = {
+        0,    10,    20,    30,    40,    50,    60,    70,    80,    90,    99,   110,
+      120,   132,   144,   157,   170,   184,   198,   213,   229,   246,   263,   281,
+      299,   319,   338,   359,   381,   403,   425,   449,   473,   498,   524,   551,
+      578,   606,   635,   665,   695,   727,   759,   792,   825,   860,   895,   931,
+      969,  1006,  1045,  1085,  1125,  1167,  1209,  1252,  1296,  1341,  1386,  1433,
+     1481,  1529,  1578,  1629,  1680,  1732,  1785,  1839,  1894,  1950,  2007,  2065,
+     2123,  2183,  2244,  2306,  2368,  2432,  2496,  2562,  2629,  2696,  2765,  2834,
+     2905,  2977,  3049,  3123,  3198,  3273,  3350,  3428,  3507,  3587,  3668,  3750,
+     3833,  3917,  4002,  4089,  4176,  4264,  4354,  4444,  4536,  4629,  4723,  4818,
+     4914,  5011,  5109,  5209,  5309,  5411,  5514,  5618,  5723,  5829,  5936,  6045,
+     6155,  6265,  6377,  6490,  6605,  6720,  6837,  6954,  7073,  7193,  7315,  7437,
+     7561,  7686,  7812,  7939,  8068,  8197,  8328,  8460,  8593,  8728,  8864,  9001,
+     9139,  9278,  9419,  9561,  9704,  9848,  9994, 10141, 10289, 10438, 10589, 10741,
+    10894, 11048, 11204, 11361, 11519, 11679, 11839, 12001, 12165, 12329, 12495, 12663,
+    12831, 13001, 13172, 13344, 13518, 13693, 13870, 14047, 14226, 14407, 14588, 14771,
+    14956, 15141, 15328, 15517, 15706, 15897, 16090, 16284, 16479, 16675, 16873, 17072,
+    17273, 17474, 17678, 17882, 18088, 18296, 18504, 18715, 18926, 19139, 19353, 19569,
+    19786, 20005, 20225, 20446, 20669, 20893, 21118, 21345, 21574, 21803, 22035, 22267,
+    22501, 22737, 22974, 23212, 23452, 23693, 23936, 24180, 24425, 24672, 24921, 25171,
+    25422, 25675, 25929, 26185, 26442, 26701, 26961, 27223, 27486, 27750, 28016, 28284,
+    28553, 28823, 29095, 29369, 29644, 29920, 30198, 30478, 30759, 31041, 31325, 31611,
+    31898, 32186, 32476, 32768
+};
+
+// STM32IPL: LAB companding function f(t) (Q15) of t = k / 1024, for k = 0...1024; the last entry is repeated
+// so that the linear interpolation between consecutive entries does not need a bound check.
+const uint16_t lab_f_table[1026] = {
+     4520,  4769,  5018,  5267,  5516,  5766,  6015,  6264,  6513,  6762,  7004,  7230,
+     7443,  7644,  7835,  8018,  8192,  8359,  8520,  8675,  8825,  8969,  9109,  9245,
+     9377,  9506,  9631,  9753,  9872,  9988, 10102, 10213, 10321, 10428, 10532, 10634,
+    10735, 10833, 10930, 11025, 11118, 11210, 11301, 11390, 11477, 11563, 11648, 11732,
+    11815, 11896, 11977, 12056, 12134, 12212, 12288, 12363, 12438, 12511, 12584, 12656,
+    12727, 12798, 12867, 12936, 13004, 13071, 13138, 13204, 13269, 13334, 13398, 13462,
+    13525, 13587, 13649, 13710, 13771, 13831, 13890, 13950, 14008, 14066, 14124, 14181,
+    14238, 14294, 14350, 14405, 14460, 14515, 14569, 14623, 14676, 14729, 14782, 14834,
+    14886, 14937, 14989, 15039, 15090, 15140, 15190, 15239, 15288, 15337, 15386, 15434,
+    15482, 15530, 15577, 15624, 15671, 15717, 15763, 15809, 15855, 15901, 15946, 15991,
+    16035, 16080, 16124, 16168, 16212, 16255, 16298, 16341, 16384, 16427, 16469, 16511,
+    16553, 16595, 16636, 16677, 16718, 16759, 16800, 16840, 16881, 16921, 16961, 17001,
+    17040, 17079, 17119, 17158, 17196, 17235, 17274, 17312, 17350, 17388, 17426, 17463,
+    17501, 17538, 17575, 17612, 17649, 17686, 17722, 17759, 17795, 17831, 17867, 17903,
+    17939, 17974, 18009, 18045, 18080, 18115, 18150, 18184, 18219, 18253, 18288, 18322,
+    18356, 18390, 18424, 18457, 18491, 18524, 18558, 18591, 18624, 18657, 18690, 18722,
+    18755, 18788, 18820, 18852, 18884, 18916, 18948, 18980, 19012, 19044, 19075, 19107,
+    19138, 19169, 19200, 19231, 19262, 19293, 19324, 19354, 19385, 19415, 19446, 19476,
+    19506, 19536, 19566, 19596, 19626, 19655, 19685, 19714, 19744, 19773, 19802, 19832,
+    19861, 19890, 19919, 19947, 19976, 20005, 20033, 20062, 20090, 20119, 20147, 20175,
+    20203, 20231, 20259, 20287, 20315, 20343, 20370, 20398, 20425, 20453, 20480, 20507,
+    20534, 20562, 20589, 20616, 20643, 20669, 20696, 20723, 20750, 20776, 20803, 20829,
+    20855, 20882, 20908, 20934, 20960, 20986, 21012, 21038, 21064, 21090, 21115, 21141,
+    21167, 21192, 21218, 21243, 21268, 21294, 21319, 21344, 21369, 21394, 21419, 21444,
+    21469, 21494, 21519, 21543, 21568, 21593, 21617, 21642, 21666, 21690, 21715, 21739,
+    21763, 21787, 21812, 21836, 21860, 21883, 21907, 21931, 21955, 21979, 22002, 22026,
+    22050, 22073, 22097, 22120, 22143, 22167, 22190, 22213, 22237, 22260, 22283, 22306,
+    22329, 22352, 22375, 22397, 22420, 22443, 22466, 22488, 22511, 22534, 22556, 22579,
+    22601, 22624, 22646, 22668, 22690, 22713, 22735, 22757, 22779, 22801, 22823, 22845,
+    22867, 22889, 22911, 22933, 22954, 22976, 22998, 23019, 23041, 23062, 23084, 23105,
+    23127, 23148, 23170, 23191, 23212, 23233, 23255, 23276, 23297, 23318, 23339, 23360,
+    23381, 23402, 23423, 23444, 23465, 23485, 23506, 23527, 23547, 23568, 23589, 23609,
+    23630, 23650, 23671, 23691, 23712, 23732, 23752, 23773, 23793, 23813, 23833, 23853,
+    23873, 23894, 23914, 23934, 23954, 23973, 23993, 24013, 24033, 24053, 24073, 24092,
+    24112, 24132, 24152, 24171, 24191, 24210, 24230, 24249, 24269, 24288, 24308, 24327,
+    24346, 24366, 24385, 24404, 24423, 24443, 24462, 24481, 24500, 24519, 24538, 24557,
+    24576, 24595, 24614, 24633, 24652, 24670, 24689, 24708, 24727, 24745, 24764, 24783,
+    24801, 24820, 24839, 24857, 24876, 24894, 24913, 24931, 24950, 24968, 24986, 25005,
+    25023, 25041, 25059, 25078, 25096, 25114, 25132, 25150, 25168, 25186, 25205, 25223,
+    25241, 25259, 25276, 25294, 25312, 25330, 25348, 25366, 25384, 25401, 25419, 25437,
+    25454, 25472, 25490, 25507, 25525, 25543, 25560, 25578, 25595, 25613, 25630, 25647,
+    25665, 25682, 25700, 25717, 25734, 25751, 25769, 25786, 25803, 25820, 25838, 25855,
+    25872, 25889, 25906, 25923, 25940, 25957, 25974, 25991, 26008, 26025, 26042, 26059,
+    26076, 26092, 26109, 26126, 26143, 26159, 26176, 26193, 26210, 26226, 26243, 26260,
+    26276, 26293, 26309, 26326, 26342, 26359, 26375, 26392, 26408, 26425, 26441, 26457,
+    26474, 26490, 26506, 26523, 26539, 26555, 26571, 26588, 26604, 26620, 26636, 26652,
+    26668, 26684, 26701, 26717, 26733, 26749, 26765, 26781, 26797, 26813, 26828, 26844,
+    26860, 26876, 26892, 26908, 26924, 26939, 26955, 26971, 26987, 27002, 27018, 27034,
+    27049, 27065, 27081, 27096, 27112, 27127, 27143, 27159, 27174, 27190, 27205, 27220,
+    27236, 27251, 27267, 27282, 27298, 27313, 27328, 27344, 27359, 27374, 27389, 27405,
+    27420, 27435, 27450, 27466, 27481, 27496, 27511, 27526, 27541, 27556, 27571, 27587,
+    27602, 27617, 27632, 27647, 27662, 27677, 27691, 27706, 27721, 27736, 27751, 27766,
+    27781, 27796, 27810, 27825, 27840, 27855, 27870, 27884, 27899, 27914, 27928, 27943,
+    27958, 27972, 27987, 28002, 28016, 28031, 28045, 28060, 28074, 28089, 28104, 28118,
+    28132, 28147, 28161, 28176, 28190, 28205, 28219, 28233, 28248, 28262, 28276, 28291,
+    28305, 28319, 28334, 28348, 28362, 28376, 28391, 28405, 28419, 28433, 28447, 28461,
+    28476, 28490, 28504, 28518, 28532, 28546, 28560, 28574, 28588, 28602, 28616, 28630,
+    28644, 28658, 28672, 28686, 28700, 28714, 28728, 28741, 28755, 28769, 28783, 28797,
+    28811, 28824, 28838, 28852, 28866, 28879, 28893, 28907, 28921, 28934, 28948, 28962,
+    28975, 28989, 29003, 29016, 29030, 29043, 29057, 29070, 29084, 29098, 29111, 29125,
+    29138, 29152, 29165, 29178, 29192, 29205, 29219, 29232, 29246, 29259, 29272, 29286,
+    29299, 29312, 29326, 29339, 29352, 29366, 29379, 29392, 29405, 29419, 29432, 29445,
+    29458, 29471, 29485, 29498, 29511, 29524, 29537, 29550, 29564, 29577, 29590, 29603,
+    29616, 29629, 29642, 29655, 29668, 29681, 29694, 29707, 29720, 29733, 29746, 29759,
+    29772, 29785, 29798, 29810, 29823, 29836, 29849, 29862, 29875, 29888, 29900, 29913,
+    29926, 29939, 29952, 29964, 29977, 29990, 30003, 30015, 30028, 30041, 30053, 30066,
+    30079, 30091, 30104, 30117, 30129, 30142, 30154, 30167, 30180, 30192, 30205, 30217,
+    30230, 30242, 30255, 30267, 30280, 30292, 30305, 30317, 30330, 30342, 30355, 30367,
+    30379, 30392, 30404, 30417, 30429, 30441, 30454, 30466, 30478, 30491, 30503, 30515,
+    30528, 30540, 30552, 30564, 30577, 30589, 30601, 30613, 30626, 30638, 30650, 30662,
+    30674, 30687, 30699, 30711, 30723, 30735, 30747, 30759, 30771, 30784, 30796, 30808,
+    30820, 30832, 30844, 30856, 30868, 30880, 30892, 30904, 30916, 30928, 30940, 30952,
+    30964, 30976, 30988, 31000, 31012, 31023, 31035, 31047, 31059, 31071, 31083, 31095,
+    31107, 31118, 31130, 31142, 31154, 31166, 31177, 31189, 31201, 31213, 31224, 31236,
+    31248, 31260, 31271, 31283, 31295, 31306, 31318, 31330, 31341, 31353, 31365, 31376,
+    31388, 31400, 31411, 31423, 31434, 31446, 31458, 31469, 31481, 31492, 31504, 31515,
+    31527, 31538, 31550, 31561, 31573, 31584, 31596, 31607, 31619, 31630, 31642, 31653,
+    31665, 31676, 31687, 31699, 31710, 31722, 31733, 31744, 31756, 31767, 31778, 31790,
+    31801, 31812, 31824, 31835, 31846, 31858, 31869, 31880, 31891, 31903, 31914, 31925,
+    31936, 31948, 31959, 31970, 31981, 31992, 32004, 32015, 32026, 32037, 32048, 32059,
+    32071, 32082, 32093, 32104, 32115, 32126, 32137, 32148, 32159, 32171, 32182, 32193,
+    32204, 32215, 32226, 32237, 32248, 32259, 32270, 32281, 32292, 32303, 32314, 32325,
+    32336, 32347, 32358, 32368, 32379, 32390, 32401, 32412, 32423, 32434, 32445, 32456,
+    32467, 32477, 32488, 32499, 32510, 32521, 32532, 32542, 32553, 32564, 32575, 32586,
+    32596, 32607, 32618, 32629, 32639, 32650, 32661, 32672, 32682, 32693, 32704, 32715,
+    32725, 32736, 32747, 32757, 32768, 32768
+};